@@ -19,6 +19,9 @@ HLSEnableNSManagedObjectValidation();
 // Enable preloading
 HLSEnableApplicationPreloading();
 
+// Enable label localization in nibs
+HLSEnableUILabelDynamicLocalization();
+
 @interface CoconutKit_demoAppDelegate ()
 
 @property (nonatomic, retain) CoconutKit_demoApplication *application;
@@ -51,6 +54,9 @@ HLSEnableApplicationPreloading();
     self.application = [[[CoconutKit_demoApplication alloc] init] autorelease];
     self.window.rootViewController = [self.application rootViewController];
     
+    // Live performance figures
+    [HLSPerformanceHUD sharedPerformanceHUD].visible = YES;
+    
     return YES;
 }
 
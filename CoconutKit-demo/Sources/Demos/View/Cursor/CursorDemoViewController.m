@@ -157,15 +157,24 @@ static NSArray *s_folders = nil;
 - (UIView *)cursor:(HLSCursor *)cursor viewAtIndex:(NSUInteger)index selected:(BOOL)selected
 {
     if (cursor == self.foldersCursor || (cursor == self.mixedFoldersCursor && index % 2 == 0)) {
+        // Views are tagged so that they can be recycled when the cursor is reloaded
         if (selected) {
-            CursorSelectedFolderView *view = [CursorSelectedFolderView view];
+            CursorSelectedFolderView *view = (CursorSelectedFolderView *)[cursor dequeueReusableElementViewWithIdentifier:@"selectedFolder"];
+            if (! view) {
+                view = [CursorSelectedFolderView view];
+                view.tag_hls = @"selectedFolder";
+            }
             view.nameLabel.text = [s_folders objectAtIndex:index];
             return view;
         }
         else {
-            CursorFolderView *view = [CursorFolderView view];
+            CursorFolderView *view = (CursorFolderView *)[cursor dequeueReusableElementViewWithIdentifier:@"folder"];
+            if (! view) {
+                view = [CursorFolderView view];
+                view.tag_hls = @"folder";
+            }
             view.nameLabel.text = [s_folders objectAtIndex:index];
-            return view;        
+            return view;
         }
     }
     else {
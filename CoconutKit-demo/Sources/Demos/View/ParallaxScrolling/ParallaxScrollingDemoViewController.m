@@ -119,7 +119,8 @@
                                                       self.mountainsScrollView, 
                                                       self.grassScrollView, 
                                                       nil]
-                                             bounces:self.bouncesSwitch.on];
+                                             bounces:self.bouncesSwitch.on
+                                                mode:HLSScrollViewSynchronizationModeDisplayFrame];
 }
 
 @end
@@ -8,8 +8,7 @@
 
 @interface TableSearchDisplayDemoViewController : HLSTableSearchDisplayViewController {
 @private
-    NSArray *m_devices;
-    NSArray *m_filteredDevices;
+    
 }
 
 @end
@@ -21,15 +21,6 @@ typedef enum {
     ScopeButtonIndexEnumSize = ScopeButtonIndexEnumEnd - ScopeButtonIndexEnumBegin
 } ScopeButtonIndex;
 
-@interface TableSearchDisplayDemoViewController ()
-
-@property (nonatomic, retain) NSArray *devices;
-@property (nonatomic, retain) NSArray *filteredDevices;
-
-- (void)filterDevices;
-
-@end
-
 @implementation TableSearchDisplayDemoViewController
 
 #pragma mark Object creation and destruction
@@ -69,24 +60,12 @@ typedef enum {
         [devices addObject:[DeviceInfo deviceInfoWithName:@"Apple iPad" type:DeviceTypeTablet]];
         [devices addObject:[DeviceInfo deviceInfoWithName:@"Samsung Galaxy Tab" type:DeviceTypeTablet]];
         
-        self.devices = [NSArray arrayWithArray:devices];
+        // Filtering is performed by HLSTableSearchDisplayViewController
+        self.searchableObjects = [NSArray arrayWithArray:devices];
     }
     return self;
 }
 
-- (void)dealloc
-{
-    self.devices = nil;
-    self.filteredDevices = nil;
-    [super dealloc];
-}
-
-#pragma mark Accessors and mutators
-
-@synthesize devices = m_devices;
-
-@synthesize filteredDevices = m_filteredDevices;
-
 #pragma mark UISearchDisplayDelegate protocol implementation
 
 - (void)searchDisplayControllerWillBeginSearch:(UISearchDisplayController *)controller
@@ -97,37 +76,15 @@ typedef enum {
     self.searchBar.selectedScopeButtonIndex = ScopeButtonIndexAll;
 }
 
-- (BOOL)searchDisplayController:(UISearchDisplayController *)controller shouldReloadTableForSearchString:(NSString *)searchString
-{
-    [super searchDisplayController:controller shouldReloadTableForSearchString:searchString];
-    
-    // Refresh the results
-    [self filterDevices];
-    
-    // Trigger a search result table view reload
-    return YES;
-}
-
-- (BOOL)searchDisplayController:(UISearchDisplayController *)controller shouldReloadTableForSearchScope:(NSInteger)searchOption
-{
-    [super searchDisplayController:controller shouldReloadTableForSearchScope:searchOption];
-    
-    // Refresh the results
-    [self filterDevices];
-    
-    // Trigger a search result table view reload
-    return YES;
-}
-
 #pragma mark UITableViewDataSource protocol implementation
 
 - (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section
 {
     if (tableView == self.searchResultsTableView) {
-        return [self.filteredDevices count];
+        return [self.filteredObjects count];
     }
     else {
-        return [self.devices count];
+        return [self.searchableObjects count];
     }
 }
 
@@ -135,10 +92,10 @@ typedef enum {
 {   
     DeviceInfo *device = nil;
     if (tableView == self.searchResultsTableView) {
-        device = [self.filteredDevices objectAtIndex:indexPath.row];
+        device = [self.filteredObjects objectAtIndex:indexPath.row];
     }
     else {
-        device = [self.devices objectAtIndex:indexPath.row];
+        device = [self.searchableObjects objectAtIndex:indexPath.row];
     }
     
     HLSTableViewCell *cell = [HLSTableViewCell cellForTableView:tableView];
@@ -171,12 +128,12 @@ typedef enum {
     }
 }
 
-#pragma mark Creating the search filter
+#pragma mark Filtering
 
-- (void)filterDevices
+- (BOOL)object:(id)object matchesSearchText:(NSString *)searchText scopeButtonIndex:(NSInteger)scopeButtonIndex
 {
     DeviceType deviceType;
-    switch (self.searchBar.selectedScopeButtonIndex) {            
+    switch (scopeButtonIndex) {
         case ScopeButtonIndexMusicPlayers: {
             deviceType = DeviceTypeMusicPlayer;
             break;
@@ -199,28 +156,15 @@ typedef enum {
         }
     }
     
-    NSString *pattern = self.searchBar.text;
-    NSMutableArray *filteredDevices = [NSMutableArray array];
-    for (DeviceInfo *device in self.devices) {
-        // Try to locate the pattern in the name (if any)
-        if ([pattern length] != 0) {
-            NSRange prefixRange = [device.name rangeOfString:pattern
-                                                     options:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch];
-            if (prefixRange.length == 0) {
-                continue;
-            }        
-        }
-        
-        // Check against device type (if any)
-        if (deviceType != DeviceTypeAll && device.type != deviceType) {
-            continue;
-        }
-        
-        // All checks successful; matches the filter criteria
-        [filteredDevices addObject:device];
+    // Check against device type (if any)
+    DeviceInfo *device = (DeviceInfo *)object;
+    if (deviceType != DeviceTypeAll && device.type != deviceType) {
+        return NO;
     }
     
-    self.filteredDevices = [NSArray arrayWithArray:filteredDevices];
+    // Try to locate the pattern in the name
+    NSRange range = [device.name rangeOfString:searchText options:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch];
+    return range.length != 0;
 }
 
 #pragma mark Localization
@@ -85,6 +85,11 @@
 
 @implementation CustomTransitionFallFromTop
 
++ (void)load
+{
+    [HLSTransition registerTransitionClass:self];
+}
+
 + (NSArray *)layerAnimationStepsWithAppearingView:(UIView *)appearingView
                                  disappearingView:(UIView *)disappearingView
                                            inView:(UIView *)view
@@ -147,6 +152,11 @@
 
 @implementation CustomTransitionRotateVerticallyCounterclockwise
 
++ (void)load
+{
+    [HLSTransition registerTransitionClass:self];
+}
+
 + (NSArray *)layerAnimationStepsWithAppearingView:(UIView *)appearingView
                                  disappearingView:(UIView *)disappearingView
                                            inView:(UIView *)view
@@ -167,6 +177,11 @@
 
 @implementation CustomTransitionRotateVerticallyClockwise
 
++ (void)load
+{
+    [HLSTransition registerTransitionClass:self];
+}
+
 + (NSArray *)layerAnimationStepsWithAppearingView:(UIView *)appearingView
                                  disappearingView:(UIView *)disappearingView
                                            inView:(UIView *)view
@@ -187,6 +202,11 @@
 
 @implementation CustomTransitionRotateHorizontallyCounterclockwise
 
++ (void)load
+{
+    [HLSTransition registerTransitionClass:self];
+}
+
 + (NSArray *)layerAnimationStepsWithAppearingView:(UIView *)appearingView
                                  disappearingView:(UIView *)disappearingView
                                            inView:(UIView *)view
@@ -207,6 +227,11 @@
 
 @implementation CustomTransitionRotateHorizontallyClockwise
 
++ (void)load
+{
+    [HLSTransition registerTransitionClass:self];
+}
+
 + (NSArray *)layerAnimationStepsWithAppearingView:(UIView *)appearingView
                                  disappearingView:(UIView *)disappearingView
                                            inView:(UIView *)view
@@ -227,6 +252,11 @@
 
 @implementation CustomTransitionFadeInBlur
 
++ (void)load
+{
+    [HLSTransition registerTransitionClass:self];
+}
+
 + (NSArray *)layerAnimationStepsWithAppearingView:(UIView *)appearingView
                                  disappearingView:(UIView *)disappearingView
                                            inView:(UIView *)view
@@ -0,0 +1,11 @@
+//
+//  HLSTimingCurveTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface HLSTimingCurveTestCase : GHTestCase
+
+@end
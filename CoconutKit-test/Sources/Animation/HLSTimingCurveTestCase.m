@@ -0,0 +1,81 @@
+//
+//  HLSTimingCurveTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTimingCurveTestCase.h"
+
+@implementation HLSTimingCurveTestCase
+
+#pragma mark Tests
+
+- (void)testSpring
+{
+    // An underdamped spring overshoots its final value
+    HLSTimingCurve *springTimingCurve = [HLSTimingCurve springTimingCurveWithDampingRatio:0.3f frequency:2.f];
+    GHAssertTrue(floateq([springTimingCurve progressAtTime:0.f], 0.f), nil);
+    
+    BOOL overshooting = NO;
+    for (NSUInteger i = 0; i <= 100; ++i) {
+        if (floatgt([springTimingCurve progressAtTime:i / 100.f], 1.f)) {
+            overshooting = YES;
+            break;
+        }
+    }
+    GHAssertTrue(overshooting, nil);
+    
+    // A critically damped spring never does
+    HLSTimingCurve *criticallyDampedSpringTimingCurve = [HLSTimingCurve springTimingCurveWithDampingRatio:1.f frequency:2.f];
+    for (NSUInteger i = 0; i <= 100; ++i) {
+        GHAssertTrue(floatle([criticallyDampedSpringTimingCurve progressAtTime:i / 100.f], 1.f), nil);
+    }
+    
+    // Invalid parameters
+    GHAssertNil([HLSTimingCurve springTimingCurveWithDampingRatio:0.f frequency:2.f], nil);
+    GHAssertNil([HLSTimingCurve springTimingCurveWithDampingRatio:0.5f frequency:0.f], nil);
+}
+
+- (void)testDecay
+{
+    HLSTimingCurve *decayTimingCurve = [HLSTimingCurve decayTimingCurveWithDecelerationRate:4.f];
+    GHAssertTrue(floateq([decayTimingCurve progressAtTime:0.f], 0.f), nil);
+    GHAssertTrue(floateq([decayTimingCurve progressAtTime:1.f], 1.f), nil);
+    
+    // Faster at the beginning
+    GHAssertTrue(floatgt([decayTimingCurve progressAtTime:0.5f], 0.5f), nil);
+}
+
+- (void)testReverse
+{
+    HLSTimingCurve *decayTimingCurve = [HLSTimingCurve decayTimingCurveWithDecelerationRate:4.f];
+    HLSTimingCurve *reverseDecayTimingCurve = [decayTimingCurve reverseTimingCurve];
+    for (NSUInteger i = 0; i <= 10; ++i) {
+        CGFloat time = i / 10.f;
+        GHAssertTrue(floateq([reverseDecayTimingCurve progressAtTime:time], 1.f - [decayTimingCurve progressAtTime:1.f - time]), nil);
+    }
+    
+    HLSTimingCurve *reverseReverseDecayTimingCurve = [reverseDecayTimingCurve reverseTimingCurve];
+    GHAssertTrue(floateq([reverseReverseDecayTimingCurve progressAtTime:0.3f], [decayTimingCurve progressAtTime:0.3f]), nil);
+}
+
+- (void)testProgressValues
+{
+    HLSTimingCurve *springTimingCurve = [HLSTimingCurve springTimingCurveWithDampingRatio:0.3f frequency:2.f];
+    NSArray *progressValues = [springTimingCurve progressValuesWithNumberOfSamples:11];
+    GHAssertEquals([progressValues count], (NSUInteger)11, nil);
+    GHAssertTrue(floateq([[progressValues objectAtIndex:0] floatValue], 0.f), nil);
+    GHAssertTrue(floateq([[progressValues lastObject] floatValue], 1.f), nil);
+    GHAssertTrue(floateq([[progressValues objectAtIndex:5] floatValue], [springTimingCurve progressAtTime:0.5f]), nil);
+    
+    // Values are cached per set of parameters
+    HLSTimingCurve *otherSpringTimingCurve = [HLSTimingCurve springTimingCurveWithDampingRatio:0.3f frequency:2.f];
+    GHAssertEquals([otherSpringTimingCurve progressValuesWithNumberOfSamples:11], progressValues, nil);
+    GHAssertNotEquals([otherSpringTimingCurve progressValuesWithNumberOfSamples:12], progressValues, nil);
+    
+    GHAssertNil([springTimingCurve progressValuesWithNumberOfSamples:1], nil);
+}
+
+@end
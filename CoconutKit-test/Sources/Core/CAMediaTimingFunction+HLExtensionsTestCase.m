@@ -30,6 +30,35 @@
         GHAssertTrue(floateq(inverseEaseInValues[0], easeOutValues[0]), nil);
         GHAssertTrue(floateq(inverseEaseInValues[1], easeOutValues[1]), nil);
     }
+    
+    // Inverse functions are cached
+    CAMediaTimingFunction *easeInTimingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseIn];
+    GHAssertEquals([easeInTimingFunction inverseFunction], [easeInTimingFunction inverseFunction], nil);
+    GHAssertEquals([[easeInTimingFunction inverseFunction] inverseFunction], easeInTimingFunction, nil);
+}
+
+- (void)testValueForNormalizedTime
+{
+    CAMediaTimingFunction *linearTimingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear];
+    GHAssertTrue(fabsf([linearTimingFunction valueForNormalizedTime:0.3f] - 0.3f) < 1e-5f, nil);
+    GHAssertTrue(fabsf([linearTimingFunction valueForNormalizedTime:-1.f]) < 1e-5f, nil);
+    GHAssertTrue(fabsf([linearTimingFunction valueForNormalizedTime:2.f] - 1.f) < 1e-5f, nil);
+    
+    // Ease in ease out is symmetric around (0.5, 0.5)
+    CAMediaTimingFunction *easeInEaseOutTimingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
+    GHAssertTrue(fabsf([easeInEaseOutTimingFunction valueForNormalizedTime:0.5f] - 0.5f) < 1e-4f, nil);
+    GHAssertTrue(fabsf([easeInEaseOutTimingFunction valueForNormalizedTime:0.2f] + [easeInEaseOutTimingFunction valueForNormalizedTime:0.8f] - 1.f) < 1e-4f, nil);
+    
+    // Ease in is below the diagonal and monotonic
+    CAMediaTimingFunction *easeInTimingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseIn];
+    CGFloat previousValue = 0.f;
+    for (NSUInteger i = 1; i < 100; ++i) {
+        CGFloat normalizedTime = i / 100.f;
+        CGFloat value = [easeInTimingFunction valueForNormalizedTime:normalizedTime];
+        GHAssertTrue(value < normalizedTime, nil);
+        GHAssertTrue(value >= previousValue, nil);
+        previousValue = value;
+    }
 }
 
 @end
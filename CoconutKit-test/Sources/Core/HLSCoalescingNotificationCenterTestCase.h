@@ -0,0 +1,15 @@
+//
+//  HLSCoalescingNotificationCenterTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 27.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface HLSCoalescingNotificationCenterTestCase : GHTestCase {
+@private
+    NSMutableArray *m_notifications;
+    NSMutableArray *m_throttledNotifications;
+}
+
+@end
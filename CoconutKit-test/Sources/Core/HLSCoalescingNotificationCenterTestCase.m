@@ -0,0 +1,144 @@
+//
+//  HLSCoalescingNotificationCenterTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 27.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSCoalescingNotificationCenterTestCase.h"
+
+static NSString * const kTestNotification = @"HLSCoalescingNotificationCenterTestCaseNotification";
+
+@interface HLSCoalescingNotificationCenterTestCase ()
+
+@property (nonatomic, retain) NSMutableArray *notifications;
+@property (nonatomic, retain) NSMutableArray *throttledNotifications;
+
+- (void)notificationReceived:(NSNotification *)notification;
+- (void)throttledNotificationReceived:(NSNotification *)notification;
+
+@end
+
+@implementation HLSCoalescingNotificationCenterTestCase
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.notifications = nil;
+    self.throttledNotifications = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize notifications = m_notifications;
+
+@synthesize throttledNotifications = m_throttledNotifications;
+
+#pragma mark Test setup and tear down
+
+- (BOOL)shouldRunOnMainThread
+{
+    return YES;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    
+    self.notifications = [NSMutableArray array];
+    self.throttledNotifications = [NSMutableArray array];
+    [[NSNotificationCenter defaultCenter] addObserver:self 
+                                             selector:@selector(notificationReceived:) 
+                                                 name:kTestNotification 
+                                               object:nil];
+}
+
+- (void)tearDown
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:kTestNotification object:nil];
+    [[HLSCoalescingNotificationCenter defaultCenter] removeObserver:self];
+    [[HLSCoalescingNotificationCenter defaultCenter] setUserInfoReducer:nil forNotificationName:kTestNotification];
+    
+    [super tearDown];
+}
+
+#pragma mark Tests
+
+- (void)testCoalescing
+{
+    HLSCoalescingNotificationCenter *center = [HLSCoalescingNotificationCenter defaultCenter];
+    NSObject *object1 = [[[NSObject alloc] init] autorelease];
+    NSObject *object2 = [[[NSObject alloc] init] autorelease];
+    
+    [center postNotificationName:kTestNotification object:object1 userInfo:[NSDictionary dictionaryWithObject:@"A" forKey:@"key1"]];
+    [center postNotificationName:kTestNotification object:object2];
+    [center postNotificationName:kTestNotification object:object1 userInfo:[NSDictionary dictionaryWithObject:@"B" forKey:@"key2"]];
+    GHAssertEquals([self.notifications count], 0U, @"Not sent before the next frame");
+    
+    [center flush];
+    GHAssertEquals([self.notifications count], 2U, @"One notification per (name, object) pair");
+    
+    NSNotification *notification1 = [self.notifications objectAtIndex:0];
+    GHAssertEquals(notification1.object, (id)object1, nil);
+    GHAssertEqualStrings([notification1.userInfo objectForKey:@"key1"], @"A", nil);
+    GHAssertEqualStrings([notification1.userInfo objectForKey:@"key2"], @"B", nil);
+    GHAssertEquals([[self.notifications objectAtIndex:1] object], (id)object2, nil);
+}
+
+- (void)testReducer
+{
+    HLSCoalescingNotificationCenter *center = [HLSCoalescingNotificationCenter defaultCenter];
+    [center setUserInfoReducer:^(NSDictionary *accumulatedUserInfo, NSDictionary *userInfo) {
+        NSInteger count = [[accumulatedUserInfo objectForKey:@"count"] integerValue] + [[userInfo objectForKey:@"count"] integerValue];
+        return [NSDictionary dictionaryWithObject:[NSNumber numberWithInteger:count] forKey:@"count"];
+    } forNotificationName:kTestNotification];
+    
+    NSDictionary *userInfo = [NSDictionary dictionaryWithObject:[NSNumber numberWithInteger:1] forKey:@"count"];
+    for (NSUInteger i = 0; i < 5; ++i) {
+        [center postNotificationName:kTestNotification object:self userInfo:userInfo];
+    }
+    [center flush];
+    
+    GHAssertEquals([self.notifications count], 1U, nil);
+    GHAssertEquals([[[[self.notifications objectAtIndex:0] userInfo] objectForKey:@"count"] integerValue], 5, nil);
+}
+
+- (void)testMinimumInterval
+{
+    HLSCoalescingNotificationCenter *center = [HLSCoalescingNotificationCenter defaultCenter];
+    [center addObserver:self 
+               selector:@selector(throttledNotificationReceived:) 
+                   name:kTestNotification 
+                 object:nil 
+        minimumInterval:60.];
+    
+    [center postNotificationName:kTestNotification object:self];
+    [center flush];
+    GHAssertEquals([self.throttledNotifications count], 1U, @"First notification delivered immediately");
+    
+    [center postNotificationName:kTestNotification object:self];
+    [center flush];
+    GHAssertEquals([self.notifications count], 2U, nil);
+    GHAssertEquals([self.throttledNotifications count], 1U, @"Held back until the interval has elapsed");
+    
+    [center removeObserver:self];
+    [center flush];
+}
+
+#pragma mark Notification callbacks
+
+- (void)notificationReceived:(NSNotification *)notification
+{
+    [self.notifications addObject:notification];
+}
+
+- (void)throttledNotificationReceived:(NSNotification *)notification
+{
+    [self.throttledNotifications addObject:notification];
+}
+
+@end
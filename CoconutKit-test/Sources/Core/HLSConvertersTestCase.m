@@ -0,0 +1,45 @@
+//
+//  HLSConvertersTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 14.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSConvertersTestCase.h"
+
+@implementation HLSConvertersTestCase
+
+#pragma mark Tests
+
+- (void)testDateFromString
+{
+    NSDate *expectedDate = [NSDate dateWithTimeIntervalSince1970:1350228725.];
+    
+    // Fixed formats
+    GHAssertEqualObjects([HLSConverters dateFromString:@"2012-10-14T17:32:05+0200" usingFormatString:@"yyyy-MM-dd'T'HH:mm:ssZ"], 
+                         expectedDate, @"ISO 8601");
+    GHAssertEqualObjects([HLSConverters dateFromString:@"2012-10-14T12:02:05-0330" usingFormatString:@"yyyy-MM-dd'T'HH:mm:ssZZZ"], 
+                         expectedDate, @"ISO 8601");
+    GHAssertEqualObjects([HLSConverters dateFromString:@"2012-10-14T17:32:05+02:00" usingFormatString:@"yyyy-MM-dd'T'HH:mm:ssZZZZZ"], 
+                         expectedDate, @"ISO 8601");
+    GHAssertEqualObjects([HLSConverters dateFromString:@"2012-10-14T15:32:05Z" usingFormatString:@"yyyy-MM-dd'T'HH:mm:ssZZZZZ"], 
+                         expectedDate, @"ISO 8601");
+    GHAssertEqualObjects([HLSConverters dateFromString:@"Sun, 14 Oct 2012 15:32:05 GMT" usingFormatString:@"EEE, dd MMM yyyy HH:mm:ss zzz"], 
+                         expectedDate, @"RFC 1123");
+    GHAssertEqualObjects([HLSConverters dateFromString:@"2000-02-29T00:00:00+0000" usingFormatString:@"yyyy-MM-dd'T'HH:mm:ssZ"], 
+                         [NSDate dateWithTimeIntervalSince1970:951782400.], @"Leap day");
+    
+    // Invalid dates
+    GHAssertNil([HLSConverters dateFromString:@"2012-13-14T15:32:05+0000" usingFormatString:@"yyyy-MM-dd'T'HH:mm:ssZ"], @"Invalid month");
+    GHAssertNil([HLSConverters dateFromString:@"Not a date" usingFormatString:@"yyyy-MM-dd'T'HH:mm:ssZ"], @"Invalid string");
+    GHAssertNil([HLSConverters dateFromString:nil usingFormatString:@"yyyy-MM-dd'T'HH:mm:ssZ"], @"Missing string");
+    
+    // Other formats use a date formatter
+    NSDateFormatter *dateFormatter = [[[NSDateFormatter alloc] init] autorelease];
+    [dateFormatter setDateFormat:@"dd.MM.yyyy"];
+    GHAssertEqualObjects([HLSConverters dateFromString:@"14.10.2012" usingFormatString:@"dd.MM.yyyy"], 
+                         [dateFormatter dateFromString:@"14.10.2012"], @"Formatter");
+}
+
+@end
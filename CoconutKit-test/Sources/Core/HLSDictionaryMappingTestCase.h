@@ -0,0 +1,14 @@
+//
+//  HLSDictionaryMappingTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 21.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface HLSDictionaryMappingTestCase : GHTestCase {
+@private
+    
+}
+
+@end
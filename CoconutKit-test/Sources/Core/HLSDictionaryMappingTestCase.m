@@ -0,0 +1,47 @@
+//
+//  HLSDictionaryMappingTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 21.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSDictionaryMappingTestCase.h"
+
+@implementation HLSDictionaryMappingTestCase
+
+#pragma mark Tests
+
+- (void)testConversion
+{
+    HLSDictionaryMapping *mapping = [HLSDictionaryMapping dictionaryMapping];
+    [mapping addRuleForSourceKey:@"name" destinationKey:@"title" valueType:HLSDictionaryMappingValueTypeString formatString:nil];
+    [mapping addRuleForSourceKey:@"count" destinationKey:@"count" valueType:HLSDictionaryMappingValueTypeUnsignedInt formatString:nil];
+    [mapping addRuleForSourceKey:@"date" destinationKey:@"creationDate" valueType:HLSDictionaryMappingValueTypeDate 
+                    formatString:@"yyyy-MM-dd'T'HH:mm:ssZ"];
+    
+    NSArray *dictionaries = [NSArray arrayWithObjects:[NSDictionary dictionaryWithObjectsAndKeys:@"First", @"name",
+                                                       @"12", @"count",
+                                                       @"2012-10-14T15:32:05+0000", @"date",
+                                                       @"Ignored", @"other",
+                                                       nil],
+                             [NSDictionary dictionaryWithObjectsAndKeys:@"Second", @"name",
+                              @"Not a number", @"count",
+                              nil],
+                             nil];
+    NSArray *convertedDictionaries = [mapping dictionariesByConvertingDictionaries:dictionaries];
+    GHAssertEquals([convertedDictionaries count], (NSUInteger)2, @"Count");
+    
+    NSDictionary *convertedDictionary1 = [convertedDictionaries objectAtIndex:0];
+    GHAssertEquals([convertedDictionary1 count], (NSUInteger)3, @"Keys");
+    GHAssertEqualStrings([convertedDictionary1 objectForKey:@"title"], @"First", @"String");
+    GHAssertEquals([[convertedDictionary1 objectForKey:@"count"] unsignedIntValue], 12U, @"Number");
+    GHAssertEqualObjects([convertedDictionary1 objectForKey:@"creationDate"], [NSDate dateWithTimeIntervalSince1970:1350228725.], @"Date");
+    
+    // Missing values and values which cannot be converted are omitted
+    NSDictionary *convertedDictionary2 = [convertedDictionaries objectAtIndex:1];
+    GHAssertEquals([convertedDictionary2 count], (NSUInteger)1, @"Keys");
+    GHAssertEqualStrings([convertedDictionary2 objectForKey:@"title"], @"Second", @"String");
+}
+
+@end
@@ -0,0 +1,14 @@
+//
+//  HLSDigestTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 24.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface HLSDigestTestCase : GHTestCase {
+@private
+    
+}
+
+@end
@@ -0,0 +1,60 @@
+//
+//  HLSDigestTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 24.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSDigestTestCase.h"
+
+@implementation HLSDigestTestCase
+
+#pragma mark Tests
+
+- (void)testIncrementalDigest
+{
+    HLSDigest *digest = [HLSDigest digestWithAlgorithm:HLSDigestAlgorithmSHA1];
+    [digest updateWithString:@"Hello"];
+    [digest updateWithData:[@", " dataUsingEncoding:NSUTF8StringEncoding]];
+    [digest updateWithBytes:"World!" length:6];
+    GHAssertFalse(digest.finalized, nil);
+    GHAssertEqualStrings([digest finalHexDigest], @"0a0a9f2a6772942557ab5355d76af442f8f65e01", @"sha1");
+    GHAssertTrue(digest.finalized, nil);
+    GHAssertEquals([[digest finalDigestData] length], (NSUInteger)20, nil);
+    
+    // Strings longer than the conversion buffer, with multibyte characters
+    NSString *longString = [@"" stringByPaddingToLength:100000 withString:@"é" startingAtIndex:0];
+    GHAssertEqualStrings([HLSDigest hexDigestForString:longString algorithm:HLSDigestAlgorithmSHA256],
+                         @"a5e9d89256f66adf101c4a92bf240ff33594e8c32a289edfd51c9f16a330db19", @"sha256");
+}
+
+- (void)testFileAndStreamDigests
+{
+    NSMutableData *data = [NSMutableData data];
+    NSData *helloData = [@"Hello, World!" dataUsingEncoding:NSUTF8StringEncoding];
+    for (NSUInteger i = 0; i < 10000; ++i) {
+        [data appendData:helloData];
+    }
+    
+    NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"HLSDigestTestCase.dat"];
+    HLSFileManager *fileManager = [HLSFileManager defaultManager];
+    GHAssertTrue([fileManager createFileAtPath:filePath contents:data error:NULL], nil);
+    
+    NSError *error = nil;
+    GHAssertEqualStrings([HLSDigest hexDigestForFileAtPath:filePath algorithm:HLSDigestAlgorithmMD5 fileManager:nil error:&error],
+                         @"fff0390ad7ed2225f0a5809d063210c1", @"md5");
+    GHAssertNil(error, nil);
+    
+    HLSDigest *streamDigest = [HLSDigest digestWithAlgorithm:HLSDigestAlgorithmMD5];
+    GHAssertTrue([streamDigest updateWithInputStream:[NSInputStream inputStreamWithFileAtPath:filePath] error:NULL], nil);
+    GHAssertEqualStrings([streamDigest finalHexDigest], @"fff0390ad7ed2225f0a5809d063210c1", @"md5");
+    
+    [fileManager removeItemAtPath:filePath error:NULL];
+    
+    NSString *missingFilePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"HLSDigestTestCase-missing.dat"];
+    GHAssertNil([HLSDigest hexDigestForFileAtPath:missingFilePath algorithm:HLSDigestAlgorithmMD5 fileManager:nil error:&error], nil);
+    GHAssertNotNil(error, nil);
+}
+
+@end
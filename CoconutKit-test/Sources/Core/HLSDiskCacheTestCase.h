@@ -0,0 +1,14 @@
+//
+//  HLSDiskCacheTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 03.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface HLSDiskCacheTestCase : GHTestCase {
+@private
+    
+}
+
+@end
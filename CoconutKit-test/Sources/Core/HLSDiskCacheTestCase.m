@@ -0,0 +1,74 @@
+//
+//  HLSDiskCacheTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 03.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSDiskCacheTestCase.h"
+
+@interface HLSDiskCacheTestCase ()
+
+- (NSString *)stringForKey:(NSString *)key inDiskCache:(HLSDiskCache *)diskCache;
+
+@end
+
+@implementation HLSDiskCacheTestCase
+
+#pragma mark Tests
+
+- (void)testEviction
+{
+    HLSMemoryFileManager *fileManager = [[[HLSMemoryFileManager alloc] init] autorelease];
+    HLSDiskCache *diskCache = [[[HLSDiskCache alloc] initWithDirectoryPath:@"/cache" fileManager:fileManager] autorelease];
+    diskCache.totalCostLimit = 10;
+    
+    [diskCache setData:[@"aaaa" dataUsingEncoding:NSUTF8StringEncoding] forKey:@"a"];
+    [diskCache setData:[@"bbbb" dataUsingEncoding:NSUTF8StringEncoding] forKey:@"b"];
+    GHAssertEqualStrings([self stringForKey:@"a" inDiskCache:diskCache], @"aaaa", @"Stored data");
+    GHAssertEquals([diskCache totalCost], 8ULL, @"Total cost");
+    
+    // b is now the least recently used entry and gets evicted
+    [diskCache setData:[@"cccc" dataUsingEncoding:NSUTF8StringEncoding] forKey:@"c"];
+    GHAssertNil([self stringForKey:@"b" inDiskCache:diskCache], @"Evicted entry");
+    GHAssertEqualStrings([self stringForKey:@"c" inDiskCache:diskCache], @"cccc", @"Stored data");
+    GHAssertEquals([diskCache totalCost], 8ULL, @"Total cost");
+    
+    // Entries too large are not stored
+    [diskCache setData:[@"0123456789A" dataUsingEncoding:NSUTF8StringEncoding] forKey:@"large"];
+    GHAssertNil([self stringForKey:@"large" inDiskCache:diskCache], @"Large entry");
+    
+    // A new cache on the same directory finds existing entries
+    HLSDiskCache *otherDiskCache = [[[HLSDiskCache alloc] initWithDirectoryPath:@"/cache" fileManager:fileManager] autorelease];
+    GHAssertEqualStrings([self stringForKey:@"a" inDiskCache:otherDiskCache], @"aaaa", @"Existing entry");
+    GHAssertEquals([otherDiskCache totalCost], 8ULL, @"Total cost");
+    
+    [diskCache removeAllData];
+    GHAssertEquals([diskCache totalCost], 0ULL, @"Empty cache");
+    GHAssertNil([self stringForKey:@"c" inDiskCache:diskCache], @"Removed entry");
+}
+
+#pragma mark Helpers
+
+- (NSString *)stringForKey:(NSString *)key inDiskCache:(HLSDiskCache *)diskCache
+{
+    dispatch_queue_t completionQueue = dispatch_queue_create("ch.hortis.CoconutKit-test.HLSDiskCacheTestCase", NULL);
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    __block NSString *string = nil;
+    [diskCache dataForKey:key completionQueue:completionQueue completionBlock:^(NSData *data) {
+        if (data) {
+            string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        }
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    
+    dispatch_release(semaphore);
+    dispatch_release(completionQueue);
+    
+    return [string autorelease];
+}
+
+@end
@@ -106,6 +106,33 @@
     // The userInfo was deep-copied. Must check some of its information to assert the copy went well
     GHAssertEqualStrings([error2Copy localizedDescription], [self.error2 localizedDescription], @"Incorrect description");
     GHAssertEqualStrings([error2Copy localizedFailureReason], @"Localized failure reason", @"Incorrect failure reason");
+    
+    // Updating the copy must not alter the original error
+    HLSError *error2MutableCopy = [[self.error2 copy] autorelease];
+    [error2MutableCopy setLocalizedDescription:@"Other localized description"];
+    GHAssertEqualStrings([self.error2 localizedDescription], @"Localized description", @"Incorrect description");
+    GHAssertEqualStrings([error2MutableCopy localizedDescription], @"Other localized description", @"Incorrect description");
+}
+
+- (void)testUserInfo
+{
+    HLSError *error = [HLSError errorWithDomain:@"ch.hortis.CoconutKit-test" code:1014 localizedDescription:@"Localized description"];
+    [error setObject:@"Additional information" forKey:@"AdditionalInfo"];
+    
+    // Built once until the next update
+    NSDictionary *userInfo = [error userInfo];
+    GHAssertEquals([userInfo count], 2U, @"Incorrect user information");
+    GHAssertEqualStrings([userInfo objectForKey:NSLocalizedDescriptionKey], @"Localized description", @"Incorrect description");
+    GHAssertEquals([error userInfo], userInfo, @"User information must be cached");
+    
+    [error setUnderlyingError:self.error1];
+    GHAssertEquals([[error userInfo] count], 3U, @"Incorrect user information");
+    GHAssertEquals([[error userInfo] objectForKey:NSUnderlyingErrorKey], self.error1, @"Incorrect underlying error");
+    GHAssertEquals([userInfo count], 2U, @"Previous user information must not be altered");
+    
+    [error setObject:nil forKey:NSUnderlyingErrorKey];
+    GHAssertNil([error underlyingError], @"Underlying error must have been removed");
+    GHAssertEquals([[error customUserInfo] count], 1U, @"Incorrect custom user information");
 }
 
 @end
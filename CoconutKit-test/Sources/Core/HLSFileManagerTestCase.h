@@ -0,0 +1,14 @@
+//
+//  HLSFileManagerTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 30.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface HLSFileManagerTestCase : GHTestCase {
+@private
+    
+}
+
+@end
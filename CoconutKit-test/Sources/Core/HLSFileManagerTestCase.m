@@ -0,0 +1,318 @@
+//
+//  HLSFileManagerTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 30.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFileManagerTestCase.h"
+
+@implementation HLSFileManagerTestCase
+
+#pragma mark Tests
+
+- (void)testAsynchronousOperationsOrdering
+{
+    HLSFileManager *fileManager = [HLSFileManager defaultManager];
+    NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"HLSFileManagerTestCase.dat"];
+    [fileManager removeItemAtPath:filePath error:NULL];
+    
+    // Completion blocks are called on a private queue, the test waits for them
+    dispatch_queue_t completionQueue = dispatch_queue_create("ch.hortis.CoconutKit-test.HLSFileManagerTestCase", NULL);
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    
+    // Successive writes are performed in order, and the read waits for them
+    __block BOOL firstWriteSucceeded = NO;
+    __block BOOL secondWriteSucceeded = NO;
+    __block NSData *readData = nil;
+    [fileManager createFileAtPath:filePath 
+                         contents:[@"First" dataUsingEncoding:NSUTF8StringEncoding] 
+                  completionQueue:completionQueue 
+                  completionBlock:^(BOOL success, NSError *error) {
+                      firstWriteSucceeded = success;
+                      dispatch_semaphore_signal(semaphore);
+                  }];
+    [fileManager createFileAtPath:filePath 
+                         contents:[@"Second" dataUsingEncoding:NSUTF8StringEncoding] 
+                  completionQueue:completionQueue 
+                  completionBlock:^(BOOL success, NSError *error) {
+                      secondWriteSucceeded = success;
+                      dispatch_semaphore_signal(semaphore);
+                  }];
+    [fileManager contentsOfFileAtPath:filePath completionQueue:completionQueue completionBlock:^(NSData *data, NSError *error) {
+        readData = [data retain];
+        dispatch_semaphore_signal(semaphore);
+    }];
+    
+    for (NSUInteger i = 0; i < 3; ++i) {
+        dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    }
+    
+    GHAssertTrue(firstWriteSucceeded, @"First write");
+    GHAssertTrue(secondWriteSucceeded, @"Second write");
+    GHAssertEqualStrings([[[NSString alloc] initWithData:readData encoding:NSUTF8StringEncoding] autorelease], @"Second", 
+                         @"The read must occur after the pending writes");
+    [readData release];
+    
+    // Existence and removal
+    __block BOOL exists = NO;
+    [fileManager fileExistsAtPath:filePath completionQueue:completionQueue completionBlock:^(BOOL fileExists, BOOL isDirectory) {
+        exists = fileExists;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    GHAssertTrue(exists, @"The file must exist");
+    
+    __block BOOL removed = NO;
+    [fileManager removeItemAtPath:filePath completionQueue:completionQueue completionBlock:^(BOOL success, NSError *error) {
+        removed = success;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+    GHAssertTrue(removed, @"The file must have been removed");
+    GHAssertFalse([fileManager fileExistsAtPath:filePath], @"The file must not exist anymore");
+    
+    dispatch_release(semaphore);
+    dispatch_release(completionQueue);
+}
+
+- (void)testFileHandles
+{
+    HLSFileManager *fileManager = [HLSFileManager defaultManager];
+    NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"HLSFileManagerTestCase-handles.dat"];
+    
+    // Write by pieces, then append
+    id<HLSFileHandle> writingFileHandle = [fileManager fileHandleForWritingAtPath:filePath error:NULL];
+    GHAssertNotNil(writingFileHandle, @"Writing handle");
+    GHAssertTrue([writingFileHandle writeData:[@"Hello, " dataUsingEncoding:NSUTF8StringEncoding] error:NULL], @"First piece");
+    GHAssertTrue([writingFileHandle writeData:[@"World" dataUsingEncoding:NSUTF8StringEncoding] error:NULL], @"Second piece");
+    [writingFileHandle close];
+    
+    id<HLSFileHandle> appendingFileHandle = [fileManager fileHandleForAppendingAtPath:filePath error:NULL];
+    GHAssertNotNil(appendingFileHandle, @"Appending handle");
+    GHAssertTrue([appendingFileHandle writeData:[@"!" dataUsingEncoding:NSUTF8StringEncoding] error:NULL], @"Appended piece");
+    [appendingFileHandle close];
+    
+    // Ranged reads
+    id<HLSFileHandle> readingFileHandle = [fileManager fileHandleForReadingAtPath:filePath error:NULL];
+    GHAssertNotNil(readingFileHandle, @"Reading handle");
+    GHAssertEquals([readingFileHandle length], 13ULL, @"Length");
+    NSData *data = [readingFileHandle readDataOfLength:5 atOffset:7 error:NULL];
+    GHAssertEqualStrings([[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] autorelease], @"World", @"Ranged read");
+    data = [readingFileHandle readDataOfLength:100 atOffset:12 error:NULL];
+    GHAssertEquals([data length], (NSUInteger)1, @"Read at the end of the file");
+    data = [readingFileHandle readDataOfLength:100 atOffset:20 error:NULL];
+    GHAssertEquals([data length], (NSUInteger)0, @"Read beyond the end of the file");
+    [readingFileHandle close];
+    
+    [fileManager removeItemAtPath:filePath error:NULL];
+    
+    NSError *error = nil;
+    GHAssertNil([fileManager fileHandleForReadingAtPath:filePath error:&error], @"Missing file");
+    GHAssertNotNil(error, @"Error expected");
+}
+
+- (void)testMemoryFileManager
+{
+    HLSMemoryFileManager *fileManager = [[[HLSMemoryFileManager alloc] init] autorelease];
+    
+    NSError *error = nil;
+    GHAssertFalse([fileManager createFileAtPath:@"/missing/file.txt" contents:[NSData data] error:&error], @"Missing parent directory");
+    GHAssertNotNil(error, @"Error expected");
+    
+    GHAssertTrue([fileManager createDirectoryAtPath:@"/folder/subfolder" withIntermediateDirectories:YES error:NULL], @"Intermediate directories");
+    GHAssertTrue([fileManager createFileAtPath:@"/folder/subfolder/file.txt" 
+                                      contents:[@"Hello" dataUsingEncoding:NSUTF8StringEncoding] 
+                                         error:NULL], @"File creation");
+    
+    BOOL isDirectory = NO;
+    GHAssertTrue([fileManager fileExistsAtPath:@"/folder/subfolder" isDirectory:&isDirectory], @"Directory existence");
+    GHAssertTrue(isDirectory, @"Directory expected");
+    GHAssertTrue([fileManager fileExistsAtPath:@"/folder/subfolder/file.txt" isDirectory:&isDirectory], @"File existence");
+    GHAssertFalse(isDirectory, @"File expected");
+    
+    // Copies are deep
+    GHAssertTrue([fileManager copyItemAtPath:@"/folder" toPath:@"/copy" error:NULL], @"Copy");
+    GHAssertTrue([fileManager createFileAtPath:@"/folder/subfolder/file.txt" 
+                                      contents:[@"Bye" dataUsingEncoding:NSUTF8StringEncoding] 
+                                         error:NULL], @"File replacement");
+    NSString *copiedString = [[[NSString alloc] initWithData:[fileManager contentsOfFileAtPath:@"/copy/subfolder/file.txt" error:NULL] 
+                                                    encoding:NSUTF8StringEncoding] autorelease];
+    GHAssertEqualStrings(copiedString, @"Hello", @"The copy must not be affected");
+    
+    GHAssertFalse([fileManager moveItemAtPath:@"/folder" toPath:@"/folder/subfolder/folder" error:NULL], @"Move into itself");
+    GHAssertTrue([fileManager moveItemAtPath:@"/folder" toPath:@"/moved" error:NULL], @"Move");
+    GHAssertFalse([fileManager fileExistsAtPath:@"/folder"], @"The source must not exist anymore");
+    GHAssertEquals([[fileManager contentsOfDirectoryAtPath:@"/" error:NULL] count], (NSUInteger)2, @"Root contents");
+    
+    GHAssertTrue([fileManager removeItemAtPath:@"/moved" error:NULL], @"Removal");
+    GHAssertFalse([fileManager fileExistsAtPath:@"/moved/subfolder/file.txt"], @"Removal must be recursive");
+    
+    // File handles
+    id<HLSFileHandle> writingFileHandle = [fileManager fileHandleForWritingAtPath:@"/handle.dat" error:NULL];
+    GHAssertTrue([writingFileHandle writeData:[@"01234" dataUsingEncoding:NSUTF8StringEncoding] error:NULL], @"Write");
+    [writingFileHandle close];
+    id<HLSFileHandle> readingFileHandle = [fileManager fileHandleForReadingAtPath:@"/handle.dat" error:NULL];
+    GHAssertEquals([readingFileHandle length], 5ULL, @"Length");
+    GHAssertEquals([[readingFileHandle readDataOfLength:10 atOffset:3 error:NULL] length], (NSUInteger)2, @"Read past the end");
+    [readingFileHandle close];
+}
+
+- (void)testCachingFileManager
+{
+    HLSMemoryFileManager *memoryFileManager = [[[HLSMemoryFileManager alloc] init] autorelease];
+    HLSCachingFileManager *fileManager = [[[HLSCachingFileManager alloc] initWithFileManager:memoryFileManager costLimit:10] autorelease];
+    
+    [fileManager createFileAtPath:@"/a.txt" contents:[@"aaaa" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    [fileManager createFileAtPath:@"/b.txt" contents:[@"bbbb" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    [fileManager createFileAtPath:@"/c.txt" contents:[@"cccc" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    
+    [fileManager contentsOfFileAtPath:@"/a.txt" error:NULL];
+    [fileManager contentsOfFileAtPath:@"/b.txt" error:NULL];
+    GHAssertEquals(fileManager.totalCost, (NSUInteger)8, @"Two files cached");
+    
+    // Changes made behind the cache are not seen
+    [memoryFileManager createFileAtPath:@"/a.txt" contents:[@"AAAA" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    NSString *aString = [[[NSString alloc] initWithData:[fileManager contentsOfFileAtPath:@"/a.txt" error:NULL] 
+                                               encoding:NSUTF8StringEncoding] autorelease];
+    GHAssertEqualStrings(aString, @"aaaa", @"Cached contents expected");
+    
+    // b is now the least recently used file and gets evicted
+    [fileManager contentsOfFileAtPath:@"/c.txt" error:NULL];
+    GHAssertEquals(fileManager.totalCost, (NSUInteger)8, @"Cost limit");
+    [memoryFileManager createFileAtPath:@"/b.txt" contents:[@"BBBB" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    NSString *bString = [[[NSString alloc] initWithData:[fileManager contentsOfFileAtPath:@"/b.txt" error:NULL] 
+                                               encoding:NSUTF8StringEncoding] autorelease];
+    GHAssertEqualStrings(bString, @"BBBB", @"Evicted contents must be read again");
+    
+    // Existence is cached, and invalidated by changes made through the cache
+    GHAssertFalse([fileManager fileExistsAtPath:@"/folder/d.txt"], @"Missing file");
+    [memoryFileManager createDirectoryAtPath:@"/folder" withIntermediateDirectories:NO error:NULL];
+    [memoryFileManager createFileAtPath:@"/folder/d.txt" contents:[NSData data] error:NULL];
+    GHAssertFalse([fileManager fileExistsAtPath:@"/folder/d.txt"], @"Cached existence expected");
+    [fileManager removeItemAtPath:@"/folder" error:NULL];
+    GHAssertFalse([fileManager fileExistsAtPath:@"/folder"], @"Removed directory");
+    [fileManager createDirectoryAtPath:@"/folder/subfolder" withIntermediateDirectories:YES error:NULL];
+    GHAssertTrue([fileManager fileExistsAtPath:@"/folder"], @"Parent directories must be invalidated");
+    
+    // Files larger than the limit are never cached
+    [fileManager clearCache];
+    [fileManager createFileAtPath:@"/large.txt" contents:[@"0123456789A" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    [fileManager contentsOfFileAtPath:@"/large.txt" error:NULL];
+    GHAssertEquals(fileManager.totalCost, (NSUInteger)0, @"Large files must not be cached");
+}
+
+- (void)testArchiveFileManager
+{
+    HLSMemoryFileManager *memoryFileManager = [[[HLSMemoryFileManager alloc] init] autorelease];
+    [memoryFileManager createDirectoryAtPath:@"/assets/images" withIntermediateDirectories:YES error:NULL];
+    [memoryFileManager createFileAtPath:@"/assets/config.txt" contents:[@"Config" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    [memoryFileManager createFileAtPath:@"/assets/images/empty.png" contents:[NSData data] error:NULL];
+    
+    NSString *archivePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"HLSFileManagerTestCase.archive"];
+    NSError *error = nil;
+    GHAssertTrue([HLSArchiveFileManager createArchiveAtPath:archivePath 
+                              withContentsOfDirectoryAtPath:@"/assets" 
+                                                fileManager:memoryFileManager 
+                                                      error:&error], @"Archive creation");
+    
+    HLSArchiveFileManager *fileManager = [[[HLSArchiveFileManager alloc] initWithArchiveAtPath:archivePath] autorelease];
+    GHAssertNotNil(fileManager, @"Archive opening");
+    
+    NSString *configString = [[[NSString alloc] initWithData:[fileManager contentsOfFileAtPath:@"/config.txt" error:NULL] 
+                                                    encoding:NSUTF8StringEncoding] autorelease];
+    GHAssertEqualStrings(configString, @"Config", @"File contents");
+    GHAssertEquals([[fileManager contentsOfFileAtPath:@"images/empty.png" error:NULL] length], (NSUInteger)0, @"Empty file");
+    
+    BOOL isDirectory = NO;
+    GHAssertTrue([fileManager fileExistsAtPath:@"/images" isDirectory:&isDirectory], @"Directory existence");
+    GHAssertTrue(isDirectory, @"Directory expected");
+    GHAssertEquals([[fileManager contentsOfDirectoryAtPath:@"/" error:NULL] count], (NSUInteger)2, @"Root contents");
+    GHAssertNil([fileManager contentsOfFileAtPath:@"/missing.txt" error:NULL], @"Missing file");
+    
+    GHAssertFalse([fileManager removeItemAtPath:@"/config.txt" error:&error], @"Read-only archive");
+    GHAssertEquals([error code], (NSInteger)NSFileWriteNoPermissionError, @"Permission error expected");
+    
+    [[HLSFileManager defaultManager] removeItemAtPath:archivePath error:NULL];
+}
+
+- (void)testDeferredWrites
+{
+    HLSStandardFileManager *fileManager = [[[HLSStandardFileManager alloc] init] autorelease];
+    fileManager.writingPolicy = HLSFileWritingPolicyDeferred;
+    fileManager.batchingInterval = 60.;
+    
+    NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"HLSFileManagerTestCase-deferred.dat"];
+    [fileManager removeItemAtPath:filePath error:NULL];
+    
+    GHAssertTrue([fileManager createFileAtPath:filePath contents:[@"First" dataUsingEncoding:NSUTF8StringEncoding] error:NULL], @"First write");
+    GHAssertTrue([fileManager createFileAtPath:filePath contents:[@"Second" dataUsingEncoding:NSUTF8StringEncoding] error:NULL], @"Second write");
+    
+    // Not written yet, but visible through the manager
+    GHAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:filePath], @"The write must have been deferred");
+    GHAssertTrue([fileManager fileExistsAtPath:filePath], @"Pending files must be visible");
+    NSString *pendingString = [[[NSString alloc] initWithData:[fileManager contentsOfFileAtPath:filePath error:NULL] 
+                                                     encoding:NSUTF8StringEncoding] autorelease];
+    GHAssertEqualStrings(pendingString, @"Second", @"Pending contents expected");
+    
+    [fileManager flushPendingWrites];
+    NSString *writtenString = [NSString stringWithContentsOfFile:filePath encoding:NSUTF8StringEncoding error:NULL];
+    GHAssertEqualStrings(writtenString, @"Second", @"Only the last write must remain");
+    
+    GHAssertTrue([fileManager createFileAtPath:filePath 
+                                      contents:[@"Third" dataUsingEncoding:NSUTF8StringEncoding] 
+                                 writingPolicy:HLSFileWritingPolicyInPlace 
+                                         error:NULL], @"In-place write");
+    GHAssertEqualStrings([NSString stringWithContentsOfFile:filePath encoding:NSUTF8StringEncoding error:NULL], @"Third", 
+                         @"In-place writes are immediate");
+    
+    [fileManager removeItemAtPath:filePath error:NULL];
+}
+
+- (void)testItemsInDirectory
+{
+    HLSFileManager *fileManager = [HLSFileManager defaultManager];
+    NSString *directoryPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"HLSFileManagerTestCase-items"];
+    [fileManager removeItemAtPath:directoryPath error:NULL];
+    [fileManager createDirectoryAtPath:[directoryPath stringByAppendingPathComponent:@"subfolder"] withIntermediateDirectories:YES error:NULL];
+    [fileManager createFileAtPath:[directoryPath stringByAppendingPathComponent:@"file.txt"] 
+                         contents:[@"12345" dataUsingEncoding:NSUTF8StringEncoding] 
+                            error:NULL];
+    [fileManager createFileAtPath:[directoryPath stringByAppendingPathComponent:@"subfolder/nested.txt"] 
+                         contents:[@"123" dataUsingEncoding:NSUTF8StringEncoding] 
+                            error:NULL];
+    
+    NSArray *items = [fileManager itemsInDirectoryAtPath:directoryPath attributes:HLSFileAttributeNone recursive:NO error:NULL];
+    GHAssertEquals([items count], (NSUInteger)2, @"Non-recursive enumeration");
+    
+    items = [fileManager itemsInDirectoryAtPath:directoryPath attributes:HLSFileAttributeAll recursive:YES error:NULL];
+    GHAssertEquals([items count], (NSUInteger)3, @"Recursive enumeration");
+    for (HLSFileItem *item in items) {
+        if ([item.path isEqualToString:@"subfolder"]) {
+            GHAssertTrue(item.directory, @"Directory expected");
+        }
+        else if ([item.path isEqualToString:@"subfolder/nested.txt"]) {
+            GHAssertFalse(item.directory, @"File expected");
+            GHAssertEquals(item.size, 3ULL, @"Size");
+            GHAssertNotNil(item.modificationDate, @"Modification date");
+        }
+    }
+    
+    GHAssertNil([fileManager itemsInDirectoryAtPath:[directoryPath stringByAppendingPathComponent:@"file.txt"] 
+                                         attributes:HLSFileAttributeNone 
+                                          recursive:NO 
+                                              error:NULL], @"Not a directory");
+    
+    // Same results with a memory file manager
+    HLSMemoryFileManager *memoryFileManager = [[[HLSMemoryFileManager alloc] init] autorelease];
+    [memoryFileManager createDirectoryAtPath:@"/subfolder" withIntermediateDirectories:NO error:NULL];
+    [memoryFileManager createFileAtPath:@"/file.txt" contents:[@"12345" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    [memoryFileManager createFileAtPath:@"/subfolder/nested.txt" contents:[@"123" dataUsingEncoding:NSUTF8StringEncoding] error:NULL];
+    GHAssertEquals([[memoryFileManager itemsInDirectoryAtPath:@"/" attributes:HLSFileAttributeSize recursive:YES error:NULL] count], 
+                   (NSUInteger)3, @"Recursive enumeration");
+    
+    [fileManager removeItemAtPath:directoryPath error:NULL];
+}
+
+@end
@@ -0,0 +1,70 @@
+//
+//  HLSImageCacheTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 14.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSImageCacheTestCase.h"
+
+@implementation HLSImageCacheTestCase
+
+#pragma mark Tests
+
+- (void)testEviction
+{
+    UIImage *image1 = [UIImage imageWithColor:[UIColor redColor]];
+    UIImage *image2 = [UIImage imageWithColor:[UIColor greenColor]];
+    UIImage *image3 = [UIImage imageWithColor:[UIColor blueColor]];
+    NSUInteger cost = [HLSImageCache costForImage:image1];
+    
+    HLSImageCache *imageCache = [[[HLSImageCache alloc] initWithTotalCostLimit:2 * cost] autorelease];
+    [imageCache setImage:image1 forKey:@"image1"];
+    [imageCache setImage:image2 forKey:@"image2"];
+    GHAssertEquals(imageCache.totalCost, 2 * cost, @"Total cost");
+    
+    // Access image1 so that image2 is the least recently used one
+    GHAssertEquals([imageCache imageForKey:@"image1"], image1, @"Cached image");
+    [imageCache setImage:image3 forKey:@"image3"];
+    GHAssertEquals(imageCache.totalCost, 2 * cost, @"Total cost");
+    GHAssertNotNil([imageCache imageForKey:@"image1"], @"Recently used image");
+    GHAssertNil([imageCache imageForKey:@"image2"], @"Least recently used image");
+    GHAssertNotNil([imageCache imageForKey:@"image3"], @"Last added image");
+    
+    imageCache.totalCostLimit = cost;
+    GHAssertEquals(imageCache.totalCost, cost, @"Total cost");
+    GHAssertNil([imageCache imageForKey:@"image1"], @"Least recently used image");
+    
+    [imageCache removeAllImages];
+    GHAssertEquals(imageCache.totalCost, (NSUInteger)0, @"Total cost");
+    GHAssertNil([imageCache imageForKey:@"image3"], @"Removed image");
+}
+
+- (void)testReplacement
+{
+    UIImage *image1 = [UIImage imageWithColor:[UIColor redColor]];
+    UIImage *image2 = [UIImage imageWithColor:[UIColor greenColor]];
+    NSUInteger cost = [HLSImageCache costForImage:image1];
+    
+    HLSImageCache *imageCache = [[[HLSImageCache alloc] initWithTotalCostLimit:10 * cost] autorelease];
+    [imageCache setImage:image1 forKey:@"image"];
+    [imageCache setImage:image2 forKey:@"image"];
+    GHAssertEquals([imageCache imageForKey:@"image"], image2, @"Replaced image");
+    GHAssertEquals(imageCache.totalCost, cost, @"Total cost");
+    
+    [imageCache setImage:nil forKey:@"image"];
+    GHAssertNil([imageCache imageForKey:@"image"], @"Removed image");
+    GHAssertEquals(imageCache.totalCost, (NSUInteger)0, @"Total cost");
+}
+
+- (void)testImageLargerThanLimit
+{
+    UIImage *image = [UIImage imageWithColor:[UIColor redColor]];
+    HLSImageCache *imageCache = [[[HLSImageCache alloc] initWithTotalCostLimit:[HLSImageCache costForImage:image] - 1] autorelease];
+    [imageCache setImage:image forKey:@"image"];
+    GHAssertNil([imageCache imageForKey:@"image"], @"Image not cached");
+    GHAssertEquals(imageCache.totalCost, (NSUInteger)0, @"Total cost");
+}
+
+@end
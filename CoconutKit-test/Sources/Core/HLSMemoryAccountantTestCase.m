@@ -0,0 +1,59 @@
+//
+//  HLSMemoryAccountantTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSMemoryAccountantTestCase.h"
+
+@implementation HLSMemoryAccountantTestCase
+
+#pragma mark Tests
+
+- (void)testPurgeOrder
+{
+    UIImage *image1 = [UIImage imageWithColor:[UIColor redColor]];
+    UIImage *image2 = [UIImage imageWithColor:[UIColor greenColor]];
+    NSUInteger cost = [HLSImageCache costForImage:image1];
+    
+    HLSImageCache *imageCache1 = [[[HLSImageCache alloc] initWithTotalCostLimit:10 * cost] autorelease];
+    [imageCache1 setImage:image1 forKey:@"image1"];
+    HLSImageCache *imageCache2 = [[[HLSImageCache alloc] initWithTotalCostLimit:10 * cost] autorelease];
+    [imageCache2 setImage:image2 forKey:@"image2"];
+    
+    // Independent from the shared accountant
+    HLSMemoryAccountant *memoryAccountant = [[[HLSMemoryAccountant alloc] init] autorelease];
+    memoryAccountant.automaticPurgeEnabled = NO;
+    [memoryAccountant registerSubsystem:imageCache2 withName:@"Image cache 2" purgePriority:20];
+    [memoryAccountant registerSubsystem:imageCache1 withName:@"Image cache 1" purgePriority:10];
+    GHAssertEquals([memoryAccountant totalMemoryFootprint], 2 * cost, @"Total footprint");
+    GHAssertFalse([memoryAccountant isManagingSubsystem:imageCache1], @"Automatic purge disabled");
+    
+    // Only the subsystem with the lowest priority needs to be purged
+    memoryAccountant.targetMemoryFootprint = cost;
+    GHAssertEquals([memoryAccountant purgeMemory], cost, @"Purged footprint");
+    GHAssertNil([imageCache1 imageForKey:@"image1"], @"Purged first");
+    GHAssertNotNil([imageCache2 imageForKey:@"image2"], @"Not purged");
+    
+    memoryAccountant.targetMemoryFootprint = 0;
+    GHAssertEquals([memoryAccountant purgeMemory], cost, @"Purged footprint");
+    GHAssertEquals([memoryAccountant totalMemoryFootprint], (NSUInteger)0, @"Total footprint");
+    
+    [memoryAccountant unregisterSubsystem:imageCache1];
+    [memoryAccountant unregisterSubsystem:imageCache2];
+}
+
+- (void)testBuiltInSubsystems
+{
+    HLSImageCache *imageCache = [[[HLSImageCache alloc] init] autorelease];
+    GHAssertTrue([[HLSMemoryAccountant sharedMemoryAccountant] isManagingSubsystem:imageCache], @"Registered image cache");
+    GHAssertTrue([[HLSMemoryAccountant sharedMemoryAccountant] isManagingSubsystem:[HLSTaskManager defaultManager]], @"Registered task manager");
+    
+    NSString *memoryFootprintReport = [[HLSMemoryAccountant sharedMemoryAccountant] memoryFootprintReport];
+    GHAssertTrue([memoryFootprintReport rangeOfString:@"Image cache"].location != NSNotFound, @"Report");
+    GHAssertTrue([memoryFootprintReport rangeOfString:@"Default task manager"].location != NSNotFound, @"Report");
+}
+
+@end
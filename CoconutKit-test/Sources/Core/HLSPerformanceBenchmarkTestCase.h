@@ -0,0 +1,25 @@
+//
+//  HLSPerformanceBenchmarkTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Benchmarks for frequently called CoconutKit methods: calendar computations, digests, converters, validation
+ * dispatch, zeroing weak reference creation and dictionary copy-on-set. Each benchmark measures the time needed by
+ * one call (median of several runs), and fails if it exceeds the baseline recorded for the class of the device the
+ * tests are run on (e.g. iPhone4, iPad2 or Simulator) by more than the allowed tolerance. Benchmarks without baseline
+ * for the current device class are only measured.
+ *
+ * Results are written as JSON to HLSPerformanceBenchmark.json in the application Documents directory when all
+ * benchmarks have been run, so that baselines can be updated from them
+ */
+@interface HLSPerformanceBenchmarkTestCase : GHTestCase {
+@private
+    NSMutableArray *m_results;
+    NSString *m_deviceClass;
+}
+
+@end
@@ -0,0 +1,328 @@
+//
+//  HLSPerformanceBenchmarkTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSPerformanceBenchmarkTestCase.h"
+
+#import "ConcreteSubclassC.h"
+
+#import <sys/sysctl.h>
+
+// Number of calls measured by each run of a benchmark
+static const NSUInteger kBenchmarkCallCount = 1000;
+
+// Number of runs of each benchmark. The median time is kept
+static const NSUInteger kBenchmarkRunCount = 5;
+
+// A benchmark fails if its time per call exceeds its baseline by more than this factor
+static const double kBenchmarkBaselineTolerance = 1.5;
+
+// Device class used for all simulators
+static NSString * const kBenchmarkSimulatorDeviceClass = @"Simulator";
+
+static NSString *HLSPerformanceBenchmarkDeviceClass(void);
+static NSDictionary *HLSPerformanceBenchmarkBaselines(void);
+
+@interface HLSPerformanceBenchmarkTestCase ()
+
+@property (nonatomic, retain) NSMutableArray *results;
+@property (nonatomic, retain) NSString *deviceClass;
+
+- (void)measureBenchmarkWithName:(NSString *)name block:(void (^)(NSUInteger index))block;
+- (void)recordResultWithName:(NSString *)name value:(double)value baseline:(NSNumber *)baseline;
+- (NSString *)resultsJSONString;
+
+@end
+
+@implementation HLSPerformanceBenchmarkTestCase
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.results = nil;
+    self.deviceClass = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize results = m_results;
+
+@synthesize deviceClass = m_deviceClass;
+
+#pragma mark Test setup and tear down
+
+- (void)setUpClass
+{
+    [super setUpClass];
+    
+    self.results = [NSMutableArray array];
+    self.deviceClass = HLSPerformanceBenchmarkDeviceClass();
+    
+    // Validation benchmarks work on objects inserted into an in-memory store
+    HLSModelManager *modelManager = [HLSModelManager inMemoryModelManagerWithModelFileName:@"CoconutKitTestData"
+                                                                                  inBundle:nil
+                                                                             configuration:nil
+                                                                                   options:nil];
+    [HLSModelManager pushModelManager:modelManager];
+}
+
+- (void)tearDownClass
+{
+    [HLSModelManager popModelManager];
+    
+    NSString *resultsJSONString = [self resultsJSONString];
+    GHTestLog(@"%@", resultsJSONString);
+    
+    NSString *documentsDirectoryPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *filePath = [documentsDirectoryPath stringByAppendingPathComponent:@"HLSPerformanceBenchmark.json"];
+    NSError *error = nil;
+    if (! [resultsJSONString writeToFile:filePath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+        HLSLoggerError(@"Could not write benchmark results to %@. Reason: %@", filePath, error);
+    }
+    else {
+        HLSLoggerInfo(@"Benchmark results written to %@", filePath);
+    }
+    
+    self.results = nil;
+    self.deviceClass = nil;
+    
+    [super tearDownClass];
+}
+
+#pragma mark Measurements
+
+// The block is called kBenchmarkCallCount times per run, with the index of the call
+- (void)measureBenchmarkWithName:(NSString *)name block:(void (^)(NSUInteger index))block
+{
+    // Warm up caches so that the first run is not penalized
+    block(0);
+    
+    NSMutableArray *runTimes = [NSMutableArray arrayWithCapacity:kBenchmarkRunCount];
+    for (NSUInteger i = 0; i < kBenchmarkRunCount; ++i) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger j = 0; j < kBenchmarkCallCount; ++j) {
+            block(j);
+        }
+        CFAbsoluteTime runTime = CFAbsoluteTimeGetCurrent() - startTime;
+        [pool drain];
+        
+        [runTimes addObject:[NSNumber numberWithDouble:runTime]];
+    }
+    
+    NSArray *sortedRunTimes = [runTimes sortedArrayUsingSelector:@selector(compare:)];
+    double callTime = [[sortedRunTimes objectAtIndex:kBenchmarkRunCount / 2] doubleValue] / kBenchmarkCallCount;
+    
+    NSNumber *baseline = [[HLSPerformanceBenchmarkBaselines() objectForKey:self.deviceClass] objectForKey:name];
+    [self recordResultWithName:name value:callTime baseline:baseline];
+    
+    if (! baseline) {
+        GHTestLog(@"No baseline for benchmark %@ on %@; measured %.9f s", name, self.deviceClass, callTime);
+        return;
+    }
+    
+    GHAssertLessThanOrEqual(callTime, [baseline doubleValue] * kBenchmarkBaselineTolerance,
+                            @"Benchmark %@ regressed on %@ (%.9f s per call, baseline %.9f s)",
+                            name, self.deviceClass, callTime, [baseline doubleValue]);
+}
+
+#pragma mark Results
+
+- (void)recordResultWithName:(NSString *)name value:(double)value baseline:(NSNumber *)baseline
+{
+    NSDictionary *result = [NSDictionary dictionaryWithObjectsAndKeys:name, @"name",
+                            [NSNumber numberWithDouble:value], @"value",
+                            baseline, @"baseline",                  // Last since can be nil
+                            nil];
+    [self.results addObject:result];
+}
+
+// Names only contain plain identifiers, no escaping is needed
+- (NSString *)resultsJSONString
+{
+    NSMutableArray *resultStrings = [NSMutableArray arrayWithCapacity:[self.results count]];
+    for (NSDictionary *result in self.results) {
+        NSNumber *baseline = [result objectForKey:@"baseline"];
+        NSString *baselineString = baseline ? [NSString stringWithFormat:@"%.9f", [baseline doubleValue]] : @"null";
+        NSString *resultString = [NSString stringWithFormat:@"{\"name\":\"%@\",\"value\":%.9f,\"baseline\":%@,\"unit\":\"s\"}",
+                                  [result objectForKey:@"name"],
+                                  [[result objectForKey:@"value"] doubleValue],
+                                  baselineString];
+        [resultStrings addObject:resultString];
+    }
+    return [NSString stringWithFormat:@"{\"deviceClass\":\"%@\",\"benchmarks\":[%@]}", self.deviceClass,
+            [resultStrings componentsJoinedByString:@","]];
+}
+
+#pragma mark Benchmarks
+
+- (void)testCalendarComputations
+{
+    NSDate *referenceDate = [NSDate dateWithTimeIntervalSinceReferenceDate:0.];
+    NSTimeZone *timeZone = [NSTimeZone timeZoneWithName:@"Europe/Zurich"];
+    
+    [self measureBenchmarkWithName:@"calendarStartDateOfUnit" block:^(NSUInteger index) {
+        NSDate *date = [referenceDate dateByAddingTimeInterval:index * 3600. * 7.];
+        [NSCalendar startDateOfUnit:NSMonthCalendarUnit containingDate:date inTimeZone:timeZone];
+    }];
+    [self measureBenchmarkWithName:@"calendarNumberOfDaysInUnit" block:^(NSUInteger index) {
+        NSDate *date = [referenceDate dateByAddingTimeInterval:index * 3600. * 7.];
+        [NSCalendar numberOfDaysInUnit:NSMonthCalendarUnit containingDate:date inTimeZone:timeZone];
+    }];
+    [self measureBenchmarkWithName:@"calendarIsDateTheSameDayAsDate" block:^(NSUInteger index) {
+        NSDate *date = [referenceDate dateByAddingTimeInterval:index * 3600. * 7.];
+        [NSCalendar isDate:date theSameDayAsDate:referenceDate inTimeZone:timeZone];
+    }];
+}
+
+- (void)testDigests
+{
+    NSMutableString *string = [NSMutableString string];
+    for (NSUInteger i = 0; i < 64; ++i) {
+        [string appendString:@"0123456789abcdef"];
+    }
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    
+    [self measureBenchmarkWithName:@"stringMD5Hash" block:^(NSUInteger index) {
+        [string md5hash];
+    }];
+    [self measureBenchmarkWithName:@"stringSHA1Hash" block:^(NSUInteger index) {
+        [string sha1hash];
+    }];
+    [self measureBenchmarkWithName:@"dataSHA1Hash" block:^(NSUInteger index) {
+        [data sha1hash];
+    }];
+}
+
+- (void)testConverters
+{
+    [self measureBenchmarkWithName:@"unsignedIntNumberFromString" block:^(NSUInteger index) {
+        HLSUnsignedIntNumberFromString(@"1234567");
+    }];
+    [self measureBenchmarkWithName:@"dateFromISO8601String" block:^(NSUInteger index) {
+        [HLSConverters dateFromString:@"2012-10-14T17:32:05+0200" usingFormatString:@"yyyy-MM-dd'T'HH:mm:ssZ"];
+    }];
+    [self measureBenchmarkWithName:@"dateFromFormattedString" block:^(NSUInteger index) {
+        [HLSConverters dateFromString:@"14.10.2012 17:32" usingFormatString:@"dd.MM.yyyy HH:mm"];
+    }];
+}
+
+- (void)testValidationDispatch
+{
+    ConcreteSubclassC *cInstance = [ConcreteSubclassC insert];
+    
+    [self measureBenchmarkWithName:@"validationCodeCheck" block:^(NSUInteger index) {
+        [cInstance checkValue:@"Hello, World!" forKey:@"codeMandatoryNotEmptyStringA" error:NULL];
+    }];
+    [self measureBenchmarkWithName:@"validationNoCheck" block:^(NSUInteger index) {
+        [cInstance checkValue:nil forKey:@"noValidationNumberB" error:NULL];
+    }];
+    
+    [HLSModelManager rollbackCurrentModelContext];
+}
+
+- (void)testZeroingWeakRefCreation
+{
+    NSObject *object = [[[NSObject alloc] init] autorelease];
+    
+    [self measureBenchmarkWithName:@"zeroingWeakRefCreation" block:^(NSUInteger index) {
+        HLSZeroingWeakRef *zeroingWeakRef = [[HLSZeroingWeakRef alloc] initWithObject:object];
+        [zeroingWeakRef release];
+    }];
+    [self measureBenchmarkWithName:@"zeroingWeakRefCreationForNewObject" block:^(NSUInteger index) {
+        NSObject *newObject = [[NSObject alloc] init];
+        HLSZeroingWeakRef *zeroingWeakRef = [[HLSZeroingWeakRef alloc] initWithObject:newObject];
+        [newObject release];
+        [zeroingWeakRef release];
+    }];
+}
+
+- (void)testDictionaryCopyOnSet
+{
+    NSMutableDictionary *mutableDictionary = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < 100; ++i) {
+        [mutableDictionary setObject:[NSNumber numberWithUnsignedInteger:i] forKey:[NSString stringWithFormat:@"Key %d", i]];
+    }
+    NSDictionary *dictionary = [NSDictionary dictionaryWithDictionary:mutableDictionary];
+    
+    [self measureBenchmarkWithName:@"dictionaryBySettingObjectForKey" block:^(NSUInteger index) {
+        [dictionary dictionaryBySettingObject:@"Value" forKey:@"Key 50"];
+    }];
+}
+
+@end
+
+#pragma mark Functions
+
+// Device model without minor version (e.g. iPhone4 for iPhone4,1), so that variants of a device share their baselines
+static NSString *HLSPerformanceBenchmarkDeviceClass(void)
+{
+#if TARGET_IPHONE_SIMULATOR
+    return kBenchmarkSimulatorDeviceClass;
+#else
+    size_t size = 0;
+    sysctlbyname("hw.machine", NULL, &size, NULL, 0);
+    char *machine = malloc(size);
+    sysctlbyname("hw.machine", machine, &size, NULL, 0);
+    NSString *model = [NSString stringWithCString:machine encoding:NSUTF8StringEncoding];
+    free(machine);
+    
+    return [[model componentsSeparatedByString:@","] objectAtIndex:0];
+#endif
+}
+
+/**
+ * Time per call (in seconds) for each benchmark, per device class. Update them from the HLSPerformanceBenchmark.json
+ * results when a change is expected to improve or degrade performance
+ */
+static NSDictionary *HLSPerformanceBenchmarkBaselines(void)
+{
+    static NSDictionary *s_baselines = nil;
+    if (! s_baselines) {
+        NSDictionary *simulatorBaselines = [NSDictionary dictionaryWithObjectsAndKeys:
+                                            [NSNumber numberWithDouble:20e-6], @"calendarStartDateOfUnit",
+                                            [NSNumber numberWithDouble:20e-6], @"calendarNumberOfDaysInUnit",
+                                            [NSNumber numberWithDouble:40e-6], @"calendarIsDateTheSameDayAsDate",
+                                            [NSNumber numberWithDouble:10e-6], @"stringMD5Hash",
+                                            [NSNumber numberWithDouble:10e-6], @"stringSHA1Hash",
+                                            [NSNumber numberWithDouble:10e-6], @"dataSHA1Hash",
+                                            [NSNumber numberWithDouble:2e-6], @"unsignedIntNumberFromString",
+                                            [NSNumber numberWithDouble:5e-6], @"dateFromISO8601String",
+                                            [NSNumber numberWithDouble:100e-6], @"dateFromFormattedString",
+                                            [NSNumber numberWithDouble:10e-6], @"validationCodeCheck",
+                                            [NSNumber numberWithDouble:5e-6], @"validationNoCheck",
+                                            [NSNumber numberWithDouble:5e-6], @"zeroingWeakRefCreation",
+                                            [NSNumber numberWithDouble:10e-6], @"zeroingWeakRefCreationForNewObject",
+                                            [NSNumber numberWithDouble:10e-6], @"dictionaryBySettingObjectForKey",
+                                            nil];
+        NSDictionary *iPhone4Baselines = [NSDictionary dictionaryWithObjectsAndKeys:
+                                          [NSNumber numberWithDouble:200e-6], @"calendarStartDateOfUnit",
+                                          [NSNumber numberWithDouble:200e-6], @"calendarNumberOfDaysInUnit",
+                                          [NSNumber numberWithDouble:400e-6], @"calendarIsDateTheSameDayAsDate",
+                                          [NSNumber numberWithDouble:100e-6], @"stringMD5Hash",
+                                          [NSNumber numberWithDouble:100e-6], @"stringSHA1Hash",
+                                          [NSNumber numberWithDouble:100e-6], @"dataSHA1Hash",
+                                          [NSNumber numberWithDouble:20e-6], @"unsignedIntNumberFromString",
+                                          [NSNumber numberWithDouble:50e-6], @"dateFromISO8601String",
+                                          [NSNumber numberWithDouble:1000e-6], @"dateFromFormattedString",
+                                          [NSNumber numberWithDouble:100e-6], @"validationCodeCheck",
+                                          [NSNumber numberWithDouble:50e-6], @"validationNoCheck",
+                                          [NSNumber numberWithDouble:50e-6], @"zeroingWeakRefCreation",
+                                          [NSNumber numberWithDouble:100e-6], @"zeroingWeakRefCreationForNewObject",
+                                          [NSNumber numberWithDouble:100e-6], @"dictionaryBySettingObjectForKey",
+                                          nil];
+        s_baselines = [[NSDictionary alloc] initWithObjectsAndKeys:simulatorBaselines, kBenchmarkSimulatorDeviceClass,
+                       iPhone4Baselines, @"iPhone3",
+                       iPhone4Baselines, @"iPhone4",
+                       iPhone4Baselines, @"iPad2",
+                       nil];
+    }
+    return s_baselines;
+}
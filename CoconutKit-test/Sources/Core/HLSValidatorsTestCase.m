@@ -59,4 +59,27 @@
     GHAssertTrue([HLSValidators validateEmailAddress:@"user%%uucp!path@somehost.edu"], @"E-mail");
 }
 
+- (void)testEmailAddressBatchValidation
+{
+    NSMutableArray *emailAddresses = [NSMutableArray array];
+    NSMutableIndexSet *expectedInvalidIndexes = [NSMutableIndexSet indexSet];
+    for (NSUInteger i = 0; i < 1000; ++i) {
+        if (i % 3 == 0) {
+            [emailAddresses addObject:[NSString stringWithFormat:@"name%u@@domain.com", i]];
+            [expectedInvalidIndexes addIndex:i];
+        }
+        else {
+            [emailAddresses addObject:[NSString stringWithFormat:@"name%u@domain.com", i]];
+        }
+    }
+    [emailAddresses addObject:[NSNull null]];
+    [expectedInvalidIndexes addIndex:1000];
+    
+    NSIndexSet *invalidIndexes = [HLSValidators indexesOfInvalidEmailAddresses:emailAddresses];
+    GHAssertTrue([invalidIndexes isEqualToIndexSet:expectedInvalidIndexes], @"Batch");
+    GHAssertEquals([[HLSValidators indexesOfInvalidEmailAddresses:[NSArray array]] count], 0U, @"Empty batch");
+    
+    GHAssertFalse([HLSValidators validateEmailAddress:@"a@bar.com\n"], @"Trailing line terminator");
+}
+
 @end
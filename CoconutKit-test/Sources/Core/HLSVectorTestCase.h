@@ -0,0 +1,14 @@
+//
+//  HLSVectorTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface HLSVectorTestCase : GHTestCase {
+@private
+    
+}
+
+@end
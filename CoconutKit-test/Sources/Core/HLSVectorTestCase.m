@@ -0,0 +1,53 @@
+//
+//  HLSVectorTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSVectorTestCase.h"
+
+@implementation HLSVectorTestCase
+
+#pragma mark Tests
+
+- (void)testOperations
+{
+    HLSVector3 vector1 = HLSVector3Make(1.f, 2.f, 3.f);
+    HLSVector3 vector2 = HLSVector3Make(3.f, 6.f, -1.f);
+    
+    HLSVector3 sum = HLSVector3Add(vector1, vector2);
+    GHAssertTrue(floateq(sum.v1, 4.f) && floateq(sum.v2, 8.f) && floateq(sum.v3, 2.f), nil);
+    
+    HLSVector3 scaledVector = HLSVector3Scale(vector1, 2.f);
+    GHAssertTrue(floateq(scaledVector.v1, 2.f) && floateq(scaledVector.v2, 4.f) && floateq(scaledVector.v3, 6.f), nil);
+    
+    HLSVector3 interpolatedVector = HLSVector3Lerp(vector1, vector2, 0.5f);
+    GHAssertTrue(floateq(interpolatedVector.v1, 2.f) && floateq(interpolatedVector.v2, 4.f) && floateq(interpolatedVector.v3, 1.f), nil);
+    
+    GHAssertTrue(floateq(HLSVector3Dot(vector1, vector2), 12.f), nil);
+    GHAssertTrue(floateq(HLSVector4Dot(HLSVector4Make(1.f, 0.f, 2.f, 1.f), HLSVector4Make(2.f, 5.f, 1.f, 3.f)), 7.f), nil);
+}
+
+- (void)testTransform
+{
+    HLSVector4 rotationParameters = HLSVector4Make(M_PI_4, 1.f, 2.f, 3.f);
+    HLSVector3 scaleParameters = HLSVector3Make(2.f, 0.5f, 3.f);
+    HLSVector3 translationParameters = HLSVector3Make(10.f, -20.f, 5.f);
+    
+    // Must give the same result as the composition of Core Animation transforms
+    CATransform3D transform = CATransform3DMakeRotation(rotationParameters.v1, rotationParameters.v2, rotationParameters.v3, rotationParameters.v4);
+    transform = CATransform3DConcat(transform, CATransform3DMakeScale(scaleParameters.v1, scaleParameters.v2, scaleParameters.v3));
+    transform = CATransform3DConcat(transform, CATransform3DMakeTranslation(translationParameters.v1, translationParameters.v2, translationParameters.v3));
+    
+    CATransform3D composedTransform = HLSTransform3DMakeRotationScaleTranslation(rotationParameters, scaleParameters, translationParameters);
+    
+    CGFloat *values = (CGFloat *)&transform;
+    CGFloat *composedValues = (CGFloat *)&composedTransform;
+    for (NSUInteger i = 0; i < 16; ++i) {
+        GHAssertTrue(fabsf(values[i] - composedValues[i]) < 1e-5f, nil);
+    }
+}
+
+@end
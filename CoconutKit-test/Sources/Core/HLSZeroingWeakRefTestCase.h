@@ -6,6 +6,9 @@
 //  Copyright (c) 2012 Hortis. All rights reserved.
 //
 
-@interface HLSZeroingWeakRefTestCase : GHTestCase
+@interface HLSZeroingWeakRefTestCase : GHTestCase {
+@private
+    NSUInteger m_nbrCleanupActions;
+}
 
 @end
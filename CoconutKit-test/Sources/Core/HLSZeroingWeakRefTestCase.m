@@ -14,6 +14,13 @@
 
 @implementation HLSZeroingWeakRefTestCase
 
+#pragma mark Cleanup actions
+
+- (void)objectWillBeZeroed
+{
+    ++m_nbrCleanupActions;
+}
+
 #pragma mark Tests
 
 - (void)testNonTollFreeBridgedObject
@@ -25,6 +32,66 @@
     GHAssertNil(zeroingWeakRef.object, @"Zeroed object reference");
 }
 
+- (void)testCleanupAction
+{
+    BasicClass *basicClass = [[BasicClass alloc] init];
+    HLSZeroingWeakRef *zeroingWeakRef1 = [[[HLSZeroingWeakRef alloc] initWithObject:basicClass] autorelease];
+    HLSZeroingWeakRef *zeroingWeakRef2 = [[[HLSZeroingWeakRef alloc] initWithObject:basicClass] autorelease];
+    [zeroingWeakRef2 addCleanupAction:@selector(objectWillBeZeroed) onTarget:self];
+    GHAssertEqualObjects([basicClass class], [BasicClass class], @"Dynamic subclass must not be visible");
+    
+    m_nbrCleanupActions = 0;
+    [basicClass release];
+    GHAssertEquals(m_nbrCleanupActions, (NSUInteger)1, @"Cleanup action must have been performed once");
+    GHAssertNil(zeroingWeakRef1.object, @"Zeroed object reference");
+    GHAssertNil(zeroingWeakRef2.object, @"Zeroed object reference");
+}
+
+- (void)testCleanupBlocks
+{
+    BasicClass *basicClass = [[BasicClass alloc] init];
+    HLSZeroingWeakRef *zeroingWeakRef = [[[HLSZeroingWeakRef alloc] initWithObject:basicClass] autorelease];
+    
+    // More blocks than can be stored inline
+    NSMutableArray *executionOrder = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 5; ++i) {
+        [zeroingWeakRef addCleanupBlock:^{
+            [executionOrder addObject:[NSNumber numberWithUnsignedInteger:i]];
+        }];
+    }
+    [zeroingWeakRef addCleanupAction:@selector(objectWillBeZeroed) onTarget:self];
+    
+    m_nbrCleanupActions = 0;
+    [basicClass release];
+    GHAssertEquals(m_nbrCleanupActions, (NSUInteger)1, @"Cleanup action must have been performed once");
+    GHAssertEquals([executionOrder count], (NSUInteger)5, @"All blocks must have been executed");
+    for (NSUInteger i = 0; i < [executionOrder count]; ++i) {
+        GHAssertEquals([[executionOrder objectAtIndex:i] unsignedIntegerValue], i, @"Blocks must be executed in order");
+    }
+    GHAssertNil(zeroingWeakRef.object, @"Zeroed object reference");
+}
+
+- (void)testManyReferences
+{
+    BasicClass *basicClass = [[BasicClass alloc] init];
+    NSMutableArray *zeroingWeakRefs = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 20; ++i) {
+        HLSZeroingWeakRef *zeroingWeakRef = [[[HLSZeroingWeakRef alloc] initWithObject:basicClass] autorelease];
+        [zeroingWeakRef addCleanupAction:@selector(objectWillBeZeroed) onTarget:self];
+        [zeroingWeakRefs addObject:zeroingWeakRef];
+    }
+    
+    // Releasing some references must not affect the others
+    [zeroingWeakRefs removeObjectsInRange:NSMakeRange(0, 5)];
+    
+    m_nbrCleanupActions = 0;
+    [basicClass release];
+    GHAssertEquals(m_nbrCleanupActions, (NSUInteger)15, @"Cleanup actions must have been performed once per reference");
+    for (HLSZeroingWeakRef *zeroingWeakRef in zeroingWeakRefs) {
+        GHAssertNil(zeroingWeakRef.object, @"Zeroed object reference");
+    }
+}
+
 - (void)testTollFreeBridgedObject
 {
     NSNumber *number = [[NSNumber alloc] initWithInt:1012];
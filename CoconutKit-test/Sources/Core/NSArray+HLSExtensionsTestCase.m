@@ -34,6 +34,81 @@
     GHAssertTrue([rightArray isEqualToArray:expectedRightArray], @"right");
 }
 
+- (void)testInPlaceRotation
+{
+    NSMutableArray *leftArray = [NSMutableArray arrayWithObjects:@"1", @"2", @"3", nil];
+    [leftArray leftRotateNumberOfObjects:2];
+    NSArray *expectedLeftArray = [NSArray arrayWithObjects:@"3", @"1", @"2", nil];
+    GHAssertTrue([leftArray isEqualToArray:expectedLeftArray], @"left");
+    
+    NSMutableArray *rightArray = [NSMutableArray arrayWithObjects:@"1", @"2", @"3", nil];
+    [rightArray rightRotateNumberOfObjects:5];
+    NSArray *expectedRightArray = [NSArray arrayWithObjects:@"2", @"3", @"1", nil];
+    GHAssertTrue([rightArray isEqualToArray:expectedRightArray], @"right");
+    
+    NSMutableArray *emptyArray = [NSMutableArray array];
+    [emptyArray leftRotateNumberOfObjects:1];
+    GHAssertEquals([emptyArray count], 0U, @"empty");
+}
+
+- (void)testRingArray
+{
+    HLSRingArray *array = [HLSRingArray arrayWithObjects:@"1", @"2", @"3", nil];
+    
+    HLSRingArray *leftArray = [array arrayByLeftRotatingNumberOfObjects:2];
+    NSArray *expectedLeftArray = [NSArray arrayWithObjects:@"3", @"1", @"2", nil];
+    GHAssertTrue([leftArray isEqualToArray:expectedLeftArray], @"left");
+    GHAssertEquals(leftArray.offset, 2U, @"left offset");
+    
+    HLSRingArray *rightArray = [leftArray arrayByRightRotatingNumberOfObjects:4];
+    NSArray *expectedRightArray = [NSArray arrayWithObjects:@"2", @"3", @"1", nil];
+    GHAssertTrue([rightArray isEqualToArray:expectedRightArray], @"right");
+    
+    NSMutableArray *enumeratedObjects = [NSMutableArray array];
+    for (NSString *object in rightArray) {
+        [enumeratedObjects addObject:object];
+    }
+    GHAssertTrue([enumeratedObjects isEqualToArray:expectedRightArray], @"enumeration");
+}
+
+- (void)testReplace
+{
+    NSArray *array = [NSArray arrayWithObjects:@"1", @"2", @"3", nil];
+    NSArray *replacedArray = [array arrayByReplacingObjectAtIndex:1 withObject:@"4"];
+    NSArray *expectedReplacedArray = [NSArray arrayWithObjects:@"1", @"4", @"3", nil];
+    GHAssertTrue([replacedArray isEqualToArray:expectedReplacedArray], @"replace");
+}
+
+- (void)testPersistentArray
+{
+    HLSPersistentArray *array = [HLSPersistentArray array];
+    GHAssertEquals([array count], 0U, @"empty");
+    
+    // Enough objects to create several trie levels
+    NSMutableArray *expectedArray = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 2000; ++i) {
+        NSNumber *object = [NSNumber numberWithUnsignedInteger:i];
+        array = (HLSPersistentArray *)[array arrayByAddingObject:object];
+        [expectedArray addObject:object];
+    }
+    GHAssertTrue([array isEqualToArray:expectedArray], @"add");
+    
+    NSUInteger index = 0;
+    for (NSNumber *object in array) {
+        GHAssertEquals([object unsignedIntegerValue], index, @"enumeration");
+        ++index;
+    }
+    GHAssertEquals(index, 2000U, @"enumeration count");
+    
+    HLSPersistentArray *replacedArray = (HLSPersistentArray *)[array arrayByReplacingObjectAtIndex:1000 withObject:@"new"];
+    GHAssertEqualStrings([replacedArray objectAtIndex:1000], @"new", @"replace in trie");
+    replacedArray = (HLSPersistentArray *)[replacedArray arrayByReplacingObjectAtIndex:1999 withObject:@"new"];
+    GHAssertEqualStrings([replacedArray objectAtIndex:1999], @"new", @"replace in tail");
+    GHAssertEquals([[array objectAtIndex:1000] unsignedIntegerValue], 1000U, @"original unchanged");
+    
+    GHAssertThrows([array objectAtIndex:2000], @"out of bounds");
+}
+
 - (void)testSafeInsert
 {
     NSMutableArray *array = [NSMutableArray array];
@@ -0,0 +1,25 @@
+//
+//  NSBundle+HLSDynamicLocalizationBenchmarkTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 16.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Benchmarks for dynamic localization. Strings tables are generated in a temporary bundle, both as .strings files and
+ * as compiled .hlsstrings files, and the following values are recorded:
+ *   - the latency of the first lookup in a table (cold, the table must be loaded) and of subsequent lookups (warm)
+ *   - the memory occupied by a loaded table
+ *   - the time needed to relocalize labels when the localization changes, whether they are displayed or not
+ * Results are written as JSON to HLSDynamicLocalizationBenchmark.json in the application Documents directory when all
+ * benchmarks have been run. The report of missing localized strings is logged as well
+ */
+@interface NSBundle_HLSDynamicLocalizationBenchmarkTestCase : GHTestCase {
+@private
+    NSMutableArray *m_results;
+    NSBundle *m_bundle;
+    BOOL m_showNonLocalizedStrings;
+}
+
+@end
@@ -0,0 +1,341 @@
+//
+//  NSBundle+HLSDynamicLocalizationBenchmarkTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 16.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "NSBundle+HLSDynamicLocalizationBenchmarkTestCase.h"
+
+#import <mach/mach.h>
+
+// Number of strings in each generated table
+static const NSUInteger kBenchmarkStringCount = 5000;
+
+// Number of warm lookups measured for each table
+static const NSUInteger kBenchmarkLookupCount = 20000;
+
+// Number of labels relocalized
+static const NSUInteger kBenchmarkLabelCount = 1000;
+
+// Names of the generated tables
+static NSString * const kBenchmarkStringsTableName = @"BenchmarkStrings";
+static NSString * const kBenchmarkCompiledTableName = @"BenchmarkCompiled";
+
+@interface NSBundle_HLSDynamicLocalizationBenchmarkTestCase ()
+
+@property (nonatomic, retain) NSMutableArray *results;
+@property (nonatomic, retain) NSBundle *bundle;
+
+- (NSString *)bundlePath;
+- (NSDictionary *)benchmarkStrings;
+- (NSData *)compiledTableDataForStrings:(NSDictionary *)strings;
+
+- (void)recordResultWithName:(NSString *)name
+                  parameters:(NSString *)parameters
+                       count:(NSUInteger)count
+                       value:(double)value
+                        unit:(NSString *)unit;
+- (NSString *)resultsJSONString;
+
+- (void)benchmarkLookupsInTable:(NSString *)tableName;
+- (void)flushLocalizationCaches;
+- (NSUInteger)residentMemorySize;
+
+@end
+
+@implementation NSBundle_HLSDynamicLocalizationBenchmarkTestCase
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.results = nil;
+    self.bundle = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize results = m_results;
+
+@synthesize bundle = m_bundle;
+
+#pragma mark Test setup and tear down
+
+- (BOOL)shouldRunOnMainThread
+{
+    // UIKit
+    return YES;
+}
+
+- (void)setUpClass
+{
+    [super setUpClass];
+    
+    self.results = [NSMutableArray array];
+    
+    // Dynamic localization is only enabled once a localization has been set
+    [NSBundle setLocalization:[NSBundle localization]];
+    
+    // Generate the tables for the current localization
+    NSString *lprojPath = [[[self bundlePath] stringByAppendingPathComponent:[NSBundle localization]] stringByAppendingPathExtension:@"lproj"];
+    [[NSFileManager defaultManager] removeItemAtPath:[self bundlePath] error:NULL];
+    [[NSFileManager defaultManager] createDirectoryAtPath:lprojPath withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    NSDictionary *strings = [self benchmarkStrings];
+    NSString *stringsTablePath = [[lprojPath stringByAppendingPathComponent:kBenchmarkStringsTableName] stringByAppendingPathExtension:@"strings"];
+    [strings writeToFile:stringsTablePath atomically:YES];
+    NSString *compiledTablePath = [[lprojPath stringByAppendingPathComponent:kBenchmarkCompiledTableName] stringByAppendingPathExtension:@"hlsstrings"];
+    [[self compiledTableDataForStrings:strings] writeToFile:compiledTablePath atomically:YES];
+    
+    self.bundle = [NSBundle bundleWithPath:[self bundlePath]];
+    
+    m_showNonLocalizedStrings = [[NSUserDefaults standardUserDefaults] boolForKey:@"NSShowNonLocalizedStrings"];
+    [NSBundle resetMissingLocalizedStrings];
+}
+
+- (void)tearDownClass
+{
+    GHTestLog(@"%@", [NSBundle missingLocalizedStringsReport]);
+    
+    NSString *resultsJSONString = [self resultsJSONString];
+    GHTestLog(@"%@", resultsJSONString);
+    
+    NSString *documentsDirectoryPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *filePath = [documentsDirectoryPath stringByAppendingPathComponent:@"HLSDynamicLocalizationBenchmark.json"];
+    NSError *error = nil;
+    if (! [resultsJSONString writeToFile:filePath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+        HLSLoggerError(@"Could not write benchmark results to %@. Reason: %@", filePath, error);
+    }
+    else {
+        HLSLoggerInfo(@"Benchmark results written to %@", filePath);
+    }
+    
+    [[NSUserDefaults standardUserDefaults] setBool:m_showNonLocalizedStrings forKey:@"NSShowNonLocalizedStrings"];
+    [[NSFileManager defaultManager] removeItemAtPath:[self bundlePath] error:NULL];
+    
+    self.results = nil;
+    self.bundle = nil;
+    
+    [super tearDownClass];
+}
+
+#pragma mark Strings tables
+
+- (NSString *)bundlePath
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"HLSDynamicLocalizationBenchmark.bundle"];
+}
+
+- (NSDictionary *)benchmarkStrings
+{
+    NSMutableDictionary *strings = [NSMutableDictionary dictionaryWithCapacity:kBenchmarkStringCount];
+    for (NSUInteger i = 0; i < kBenchmarkStringCount; ++i) {
+        [strings setObject:[NSString stringWithFormat:@"Localized string %d, long enough to be realistic", i]
+                    forKey:[NSString stringWithFormat:@"Key %d", i]];
+    }
+    return [NSDictionary dictionaryWithDictionary:strings];
+}
+
+// Same format as the one produced by the Tools/Localization/compile_strings_tables.sh script
+- (NSData *)compiledTableDataForStrings:(NSDictionary *)strings
+{
+    NSArray *keys = [[strings allKeys] sortedArrayUsingComparator:^(id obj1, id obj2) {
+        NSData *keyData1 = [obj1 dataUsingEncoding:NSUTF8StringEncoding];
+        NSData *keyData2 = [obj2 dataUsingEncoding:NSUTF8StringEncoding];
+        int result = memcmp([keyData1 bytes], [keyData2 bytes], MIN([keyData1 length], [keyData2 length]));
+        if (result == 0) {
+            result = (int)[keyData1 length] - (int)[keyData2 length];
+        }
+        return (NSComparisonResult)(result < 0 ? NSOrderedAscending : (result > 0 ? NSOrderedDescending : NSOrderedSame));
+    }];
+    
+    uint32_t header[3] = { CFSwapInt32HostToLittle(0x53534C48), CFSwapInt32HostToLittle(1), CFSwapInt32HostToLittle([keys count]) };
+    NSMutableData *indexData = [NSMutableData data];
+    NSMutableData *stringData = [NSMutableData data];
+    uint32_t dataOffset = sizeof(header) + 4 * sizeof(uint32_t) * [keys count];
+    for (NSString *key in keys) {
+        NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+        NSData *valueData = [[strings objectForKey:key] dataUsingEncoding:NSUTF8StringEncoding];
+        uint32_t entry[4] = {
+            CFSwapInt32HostToLittle(dataOffset + [stringData length]),
+            CFSwapInt32HostToLittle([keyData length]),
+            CFSwapInt32HostToLittle(dataOffset + [stringData length] + [keyData length]),
+            CFSwapInt32HostToLittle([valueData length])
+        };
+        [indexData appendBytes:entry length:sizeof(entry)];
+        [stringData appendData:keyData];
+        [stringData appendData:valueData];
+    }
+    
+    NSMutableData *data = [NSMutableData dataWithBytes:header length:sizeof(header)];
+    [data appendData:indexData];
+    [data appendData:stringData];
+    return [NSData dataWithData:data];
+}
+
+#pragma mark Results
+
+- (void)recordResultWithName:(NSString *)name
+                  parameters:(NSString *)parameters
+                       count:(NSUInteger)count
+                       value:(double)value
+                        unit:(NSString *)unit
+{
+    NSDictionary *result = [NSDictionary dictionaryWithObjectsAndKeys:name, @"name",
+                            parameters, @"parameters",
+                            [NSNumber numberWithUnsignedInteger:count], @"count",
+                            [NSNumber numberWithDouble:value], @"value",
+                            unit, @"unit",
+                            nil];
+    [self.results addObject:result];
+}
+
+// Names and parameters only contain plain identifiers, no escaping is needed
+- (NSString *)resultsJSONString
+{
+    NSMutableArray *resultStrings = [NSMutableArray arrayWithCapacity:[self.results count]];
+    for (NSDictionary *result in self.results) {
+        NSString *resultString = [NSString stringWithFormat:@"{\"name\":\"%@\",\"parameters\":\"%@\",\"count\":%@,\"value\":%.9f,\"unit\":\"%@\"}",
+                                  [result objectForKey:@"name"],
+                                  [result objectForKey:@"parameters"],
+                                  [result objectForKey:@"count"],
+                                  [[result objectForKey:@"value"] doubleValue],
+                                  [result objectForKey:@"unit"]];
+        [resultStrings addObject:resultString];
+    }
+    return [NSString stringWithFormat:@"{\"benchmarks\":[%@]}", [resultStrings componentsJoinedByString:@","]];
+}
+
+#pragma mark Helpers
+
+- (void)benchmarkLookupsInTable:(NSString *)tableName
+{
+    [self flushLocalizationCaches];
+    
+    // Cold lookup: The table must be loaded first
+    NSUInteger residentMemorySizeBefore = [self residentMemorySize];
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    NSString *localizedString = [self.bundle localizedStringForKey:@"Key 0" value:nil table:tableName];
+    CFAbsoluteTime coldLookupTime = CFAbsoluteTimeGetCurrent() - startTime;
+    NSUInteger residentMemorySizeAfter = [self residentMemorySize];
+    GHAssertEqualStrings(localizedString, @"Localized string 0, long enough to be realistic", @"Localized string");
+    
+    [self recordResultWithName:@"coldLookupTime" parameters:tableName count:kBenchmarkStringCount value:coldLookupTime unit:@"s"];
+    [self recordResultWithName:@"tableMemory"
+                    parameters:tableName
+                         count:kBenchmarkStringCount
+                         value:(residentMemorySizeAfter > residentMemorySizeBefore) ? residentMemorySizeAfter - residentMemorySizeBefore : 0
+                          unit:@"bytes"];
+    
+    // Warm lookups, spread over the table (keys are built before measuring)
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:kBenchmarkLookupCount];
+    for (NSUInteger i = 0; i < kBenchmarkLookupCount; ++i) {
+        [keys addObject:[NSString stringWithFormat:@"Key %d", (i * 7919) % kBenchmarkStringCount]];
+    }
+    
+    startTime = CFAbsoluteTimeGetCurrent();
+    for (NSString *key in keys) {
+        [self.bundle localizedStringForKey:key value:nil table:tableName];
+    }
+    CFAbsoluteTime warmLookupsTime = CFAbsoluteTimeGetCurrent() - startTime;
+    [self recordResultWithName:@"warmLookupTime"
+                    parameters:tableName
+                         count:kBenchmarkStringCount
+                         value:warmLookupsTime / kBenchmarkLookupCount
+                          unit:@"s"];
+}
+
+- (void)flushLocalizationCaches
+{
+    [[NSNotificationCenter defaultCenter] postNotificationName:UIApplicationDidReceiveMemoryWarningNotification
+                                                        object:[UIApplication sharedApplication]];
+}
+
+- (NSUInteger)residentMemorySize
+{
+    struct task_basic_info info;
+    mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
+
+#pragma mark Benchmarks
+
+- (void)testStringsTableLookups
+{
+    [[NSUserDefaults standardUserDefaults] setBool:NO forKey:@"NSShowNonLocalizedStrings"];
+    
+    [self benchmarkLookupsInTable:kBenchmarkStringsTableName];
+    [self benchmarkLookupsInTable:kBenchmarkCompiledTableName];
+}
+
+- (void)testRelocalization
+{
+    UIWindow *window = [UIApplication sharedApplication].keyWindow;
+    GHAssertNotNil(window, @"A key window is required to display labels");
+    
+    // Keys are missing from the main bundle. Do not pollute the missing localized string report with them
+    [[NSUserDefaults standardUserDefaults] setBool:NO forKey:@"NSShowNonLocalizedStrings"];
+    
+    UIView *view = [[[UIView alloc] initWithFrame:window.bounds] autorelease];
+    for (NSUInteger i = 0; i < kBenchmarkLabelCount; ++i) {
+        UILabel *label = [[[UILabel alloc] initWithFrame:CGRectMake(0.f, 0.f, 100.f, 20.f)] autorelease];
+        label.text = [NSString stringWithFormat:@"LS/Key %d", i];
+        [view addSubview:label];
+    }
+    
+    // Displayed labels are relocalized immediately
+    [window addSubview:view];
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    [[NSNotificationCenter defaultCenter] postNotificationName:HLSCurrentLocalizationDidChangeNotification object:nil];
+    [self recordResultWithName:@"relocalizationTime"
+                    parameters:@"displayed"
+                         count:kBenchmarkLabelCount
+                         value:CFAbsoluteTimeGetCurrent() - startTime
+                          unit:@"s"];
+    
+    // Other labels are relocalized when displayed again
+    [view removeFromSuperview];
+    startTime = CFAbsoluteTimeGetCurrent();
+    [[NSNotificationCenter defaultCenter] postNotificationName:HLSCurrentLocalizationDidChangeNotification object:nil];
+    [self recordResultWithName:@"relocalizationTime"
+                    parameters:@"notDisplayed"
+                         count:kBenchmarkLabelCount
+                         value:CFAbsoluteTimeGetCurrent() - startTime
+                          unit:@"s"];
+    
+    startTime = CFAbsoluteTimeGetCurrent();
+    [window addSubview:view];
+    [self recordResultWithName:@"relocalizationTime"
+                    parameters:@"displayedAgain"
+                         count:kBenchmarkLabelCount
+                         value:CFAbsoluteTimeGetCurrent() - startTime
+                          unit:@"s"];
+    [view removeFromSuperview];
+}
+
+- (void)testMissingLocalizedStrings
+{
+    [[NSUserDefaults standardUserDefaults] setBool:YES forKey:@"NSShowNonLocalizedStrings"];
+    [NSBundle resetMissingLocalizedStrings];
+    
+    for (NSUInteger i = 0; i < 10; ++i) {
+        [self.bundle localizedStringForKey:@"Missing key 1" value:nil table:kBenchmarkStringsTableName];
+    }
+    [self.bundle localizedStringForKey:@"Missing key 2" value:nil table:kBenchmarkCompiledTableName];
+    
+    NSString *report = [NSBundle missingLocalizedStringsReport];
+    GHAssertTrue([report hasPrefix:@"2 missing localized strings (11 lookups)"], @"Report header");
+    GHAssertTrue([report rangeOfString:@"\"Missing key 1\""].length != 0, @"Missing key in report");
+    GHAssertTrue([report rangeOfString:@"\"Missing key 2\""].length != 0, @"Missing key in report");
+    GHAssertTrue([report rangeOfString:@"\"Missing key 1\""].location < [report rangeOfString:@"\"Missing key 2\""].location,
+                 @"Most frequently missing string first");
+}
+
+@end
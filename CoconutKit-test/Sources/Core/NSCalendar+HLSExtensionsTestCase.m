@@ -913,4 +913,38 @@
     GHAssertTrue([self.calendar compareDaysBetweenDate:self.date2 andDate:otherDateTahiti2 inTimeZone:self.timeZoneTahiti] == NSOrderedSame, @"Day");
 }
 
+- (void)testBatchDayCalculationsInTimeZone
+{
+    NSTimeInterval timeIntervals[] = { [self.date1 timeIntervalSinceReferenceDate], [self.date2 timeIntervalSinceReferenceDate], 
+        [self.date3 timeIntervalSinceReferenceDate], [self.date4 timeIntervalSinceReferenceDate], [self.date5 timeIntervalSinceReferenceDate] };
+    
+    NSInteger dayIndicesZurich[5];
+    [self.calendar getDayIndices:dayIndicesZurich forTimeIntervalsSinceReferenceDate:timeIntervals count:5 relativeToDate:self.date1
+                      inTimeZone:self.timeZoneZurich];
+    GHAssertEquals(dayIndicesZurich[0], 0, @"Day index");
+    GHAssertEquals(dayIndicesZurich[1], 60, @"Day index");
+    GHAssertEquals(dayIndicesZurich[2], 84, @"Day index");
+    GHAssertEquals(dayIndicesZurich[3], 84, @"Day index");
+    GHAssertEquals(dayIndicesZurich[4], 85, @"Day index");
+    
+    NSInteger dayIndicesTahiti[5];
+    [self.calendar getDayIndices:dayIndicesTahiti forTimeIntervalsSinceReferenceDate:timeIntervals count:5 relativeToDate:self.date2
+                      inTimeZone:self.timeZoneTahiti];
+    GHAssertEquals(dayIndicesTahiti[0], -60, @"Day index");
+    GHAssertEquals(dayIndicesTahiti[1], 0, @"Day index");
+    GHAssertEquals(dayIndicesTahiti[2], 24, @"Day index");
+    GHAssertEquals(dayIndicesTahiti[3], 24, @"Day index");
+    GHAssertEquals(dayIndicesTahiti[4], 25, @"Day index");
+    
+    // Must be consistent with single date comparisons
+    NSComparisonResult comparisonResults[5];
+    [self.calendar getDayComparisonResults:comparisonResults forTimeIntervalsSinceReferenceDate:timeIntervals count:5 withDate:self.date3
+                                inTimeZone:self.timeZoneZurich];
+    NSArray *dates = [NSArray arrayWithObjects:self.date1, self.date2, self.date3, self.date4, self.date5, nil];
+    for (NSUInteger i = 0; i < 5; ++i) {
+        GHAssertEquals(comparisonResults[i], [self.calendar compareDaysBetweenDate:[dates objectAtIndex:i] andDate:self.date3 
+                                                                         inTimeZone:self.timeZoneZurich], @"Comparison");
+    }
+}
+
 @end
@@ -26,4 +26,19 @@
     GHAssertEqualStrings([testData sha512hash], @"374d794a95cdcfd8b35993185fef9ba368f160d8daf432d08ba9f1ed1e5abe6cc69291e0fa2fe0006a52570ef18c19def4e617c33ce52ef0a6e5fbe318cb0387", @"sha512");
 }
 
+- (void)testRawDigests
+{
+    NSData *testData = [@"Hello, World!" dataUsingEncoding:NSUTF8StringEncoding];
+    
+    NSData *digestData = [testData digestDataWithAlgorithm:HLSDigestAlgorithmMD5];
+    GHAssertEquals([digestData length], [HLSDigest digestLengthForAlgorithm:HLSDigestAlgorithmMD5], nil);
+    GHAssertEquals(((const unsigned char *)[digestData bytes])[0], (unsigned char)0x65, nil);
+    GHAssertEqualObjects([@"Hello, World!" digestDataWithAlgorithm:HLSDigestAlgorithmMD5], digestData, nil);
+    
+    unsigned char md[20];
+    [testData getDigest:md withAlgorithm:HLSDigestAlgorithmSHA1];
+    GHAssertEquals(md[0], (unsigned char)0x0a, nil);
+    GHAssertEquals(md[19], (unsigned char)0x01, nil);
+}
+
 @end
@@ -32,4 +32,30 @@
     GHAssertTrue([date1 isLaterThanOrEqualToDate:date1], @"Later date");
 }
 
+- (void)testSystemTimeZoneDescription
+{
+    [NSDate enable];
+    
+    NSTimeZone *defaultTimeZone = [[[NSTimeZone defaultTimeZone] retain] autorelease];
+    [NSTimeZone setDefaultTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:-(3 * 60 + 30) * 60]];
+    
+    // 2012-01-01 12:00:00 GMT
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1325419200.];
+    GHAssertTrue([[date description] hasSuffix:@"(system time zone: 2012-01-01 08:30:00 -0330)"], nil);
+    
+    // Descriptions can be requested concurrently
+    __block BOOL correct = YES;
+    NSString *expectedDescription = [date description];
+    dispatch_apply(1000, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        if (! [[date description] isEqualToString:expectedDescription]) {
+            correct = NO;
+        }
+        [pool drain];
+    });
+    GHAssertTrue(correct, nil);
+    
+    [NSTimeZone setDefaultTimeZone:defaultTimeZone];
+}
+
 @end
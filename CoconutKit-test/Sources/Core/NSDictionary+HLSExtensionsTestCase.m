@@ -25,6 +25,39 @@
     GHAssertEquals([dictionary2 count], 0U, @"remove many");
 }
 
+- (void)testPersistentDictionary
+{
+    HLSPersistentDictionary *dictionary = [HLSPersistentDictionary dictionary];
+    GHAssertEquals([dictionary count], 0U, @"empty");
+    
+    // Enough keys to create several trie levels
+    NSMutableDictionary *expectedDictionary = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < 2000; ++i) {
+        NSNumber *key = [NSNumber numberWithUnsignedInteger:i * 7];
+        NSString *object = [NSString stringWithFormat:@"obj%u", i];
+        dictionary = [dictionary dictionaryBySettingObject:object forKey:key];
+        [expectedDictionary setObject:object forKey:key];
+    }
+    GHAssertTrue([dictionary isEqualToDictionary:expectedDictionary], @"set");
+    
+    HLSPersistentDictionary *updatedDictionary = [dictionary dictionaryBySettingObject:@"new" forKey:[NSNumber numberWithUnsignedInteger:7]];
+    GHAssertEquals([updatedDictionary count], 2000U, @"replace count");
+    GHAssertEqualStrings([updatedDictionary objectForKey:[NSNumber numberWithUnsignedInteger:7]], @"new", @"replace");
+    GHAssertEqualStrings([dictionary objectForKey:[NSNumber numberWithUnsignedInteger:7]], @"obj1", @"original unchanged");
+    
+    for (NSUInteger i = 0; i < 2000; i += 2) {
+        NSNumber *key = [NSNumber numberWithUnsignedInteger:i * 7];
+        dictionary = [dictionary dictionaryByRemovingObjectForKey:key];
+        [expectedDictionary removeObjectForKey:key];
+    }
+    GHAssertTrue([dictionary isEqualToDictionary:expectedDictionary], @"remove");
+    GHAssertNil([dictionary objectForKey:[NSNumber numberWithUnsignedInteger:0]], @"removed key");
+    GHAssertTrue([dictionary dictionaryByRemovingObjectForKey:@"missing"] == dictionary, @"remove missing key");
+    
+    dictionary = [dictionary dictionaryByRemovingObjectsForKeys:[expectedDictionary allKeys]];
+    GHAssertEquals([dictionary count], 0U, @"remove many");
+}
+
 - (void)testSafeInsert
 {
     NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
@@ -55,4 +55,21 @@
     GHAssertEqualStrings([string urlEncodedStringUsingEncoding:NSUTF8StringEncoding], encodedStringReference, @"urlEncodedStringUsingEncoding");
 }
 
+- (void)testCachedSize
+{
+    NSString *string = @"Hello, World!";
+    UIFont *font = [UIFont systemFontOfSize:17.f];
+    UIFont *largerFont = [UIFont systemFontOfSize:34.f];
+    
+    // Measure twice to check cached results
+    for (NSUInteger i = 0; i < 2; ++i) {
+        GHAssertTrue(CGSizeEqualToSize([string cachedSizeWithFont:font], [string sizeWithFont:font]), @"Size");
+        GHAssertTrue(CGSizeEqualToSize([string cachedSizeWithFont:largerFont], [string sizeWithFont:largerFont]), @"Size for another font");
+        
+        CGSize constrainedSize = [string sizeWithFont:font constrainedToSize:CGSizeMake(50.f, FLT_MAX) lineBreakMode:UILineBreakModeWordWrap];
+        GHAssertTrue(CGSizeEqualToSize([string cachedSizeWithFont:font constrainedToSize:CGSizeMake(50.f, FLT_MAX) lineBreakMode:UILineBreakModeWordWrap], 
+                                       constrainedSize), @"Constrained size");
+    }
+}
+
 @end
@@ -0,0 +1,14 @@
+//
+//  NSURLRequest+HLSExtensionsTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 26.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface NSURLRequest_HLSExtensionsTestCase : GHTestCase {
+@private
+    
+}
+
+@end
@@ -0,0 +1,43 @@
+//
+//  NSURLRequest+HLSExtensionsTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 26.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "NSURLRequest+HLSExtensionsTestCase.h"
+
+@implementation NSURLRequest_HLSExtensionsTestCase
+
+#pragma mark Tests
+
+- (void)testQueryString
+{
+    GHAssertEqualStrings([NSURLRequest queryStringWithParameters:nil], @"", nil);
+    
+    NSDictionary *parameters = [NSDictionary dictionaryWithObjectsAndKeys:@"Hello, World!", @"text",
+                                [NSNumber numberWithInt:12], @"count",
+                                @"café & crème", @"na-me_.~", nil];
+    GHAssertEqualStrings([NSURLRequest queryStringWithParameters:parameters], 
+                         @"count=12&na-me_.~=caf%C3%A9%20%26%20cr%C3%A8me&text=Hello%2C%20World%21", nil);
+    
+    // Same encoding as -[NSString urlEncodedStringUsingEncoding:]
+    NSString *value = @"a/b?c=d#e[f]+g%h€";
+    NSDictionary *singleParameter = [NSDictionary dictionaryWithObject:value forKey:@"key"];
+    NSString *expectedQueryString = [NSString stringWithFormat:@"key=%@", [value urlEncodedStringUsingEncoding:NSUTF8StringEncoding]];
+    GHAssertEqualStrings([NSURLRequest queryStringWithParameters:singleParameter], expectedQueryString, nil);
+}
+
+- (void)testRequestWithQueryParameters
+{
+    NSDictionary *parameters = [NSDictionary dictionaryWithObject:@"a b" forKey:@"q"];
+    
+    NSURLRequest *request1 = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://www.hortis.ch/search"] queryParameters:parameters];
+    GHAssertEqualStrings([[request1 URL] absoluteString], @"http://www.hortis.ch/search?q=a%20b", nil);
+    
+    NSURLRequest *request2 = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://www.hortis.ch/search?page=2"] queryParameters:parameters];
+    GHAssertEqualStrings([[request2 URL] absoluteString], @"http://www.hortis.ch/search?page=2&q=a%20b", nil);
+}
+
+@end
@@ -0,0 +1,11 @@
+//
+//  UIImage+HLSExtensionsTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 14.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface UIImage_HLSExtensionsTestCase : GHTestCase
+
+@end
@@ -0,0 +1,43 @@
+//
+//  UIImage+HLSExtensionsTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 14.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "UIImage+HLSExtensionsTestCase.h"
+
+@implementation UIImage_HLSExtensionsTestCase
+
+#pragma mark Tests
+
+- (void)testImageScaledToSize
+{
+    UIImage *image = [UIImage imageWithColor:[UIColor redColor]];
+    UIImage *scaledImage = [image imageScaledToSize:CGSizeMake(40.f, 30.f)];
+    GHAssertEquals(CGImageGetWidth(scaledImage.CGImage), (size_t)40, @"Scaled width");
+    GHAssertEquals(CGImageGetHeight(scaledImage.CGImage), (size_t)30, @"Scaled height");
+    
+    GHAssertNil([image imageScaledToSize:CGSizeZero], @"Empty size");
+}
+
+- (void)testImagesByScalingImages
+{
+    NSMutableArray *images = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 10; ++i) {
+        UIImage *image = [[UIImage imageWithColor:[UIColor blueColor]] imageScaledToSize:CGSizeMake(10.f + i, 20.f + i)];
+        [images addObject:image];
+    }
+    
+    NSArray *scaledImages = [UIImage imagesByScalingImages:images toSize:CGSizeMake(5.f, 5.f)];
+    GHAssertEquals([scaledImages count], [images count], @"Number of scaled images");
+    for (UIImage *scaledImage in scaledImages) {
+        GHAssertEquals(CGImageGetWidth(scaledImage.CGImage), (size_t)5, @"Scaled width");
+        GHAssertEquals(CGImageGetHeight(scaledImage.CGImage), (size_t)5, @"Scaled height");
+    }
+    
+    GHAssertEquals([[UIImage imagesByScalingImages:[NSArray array] toSize:CGSizeMake(5.f, 5.f)] count], (NSUInteger)0, @"No images");
+}
+
+@end
@@ -0,0 +1,17 @@
+//
+//  HLSFetchedObjectsControllerTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface HLSFetchedObjectsControllerTestCase : GHTestCase <HLSFetchedObjectsControllerDelegate> {
+@private
+    HLSModelManager *m_modelManager;
+    NSIndexSet *m_deletedIndexes;
+    NSIndexSet *m_insertedIndexes;
+    NSIndexSet *m_updatedIndexes;
+}
+
+@end
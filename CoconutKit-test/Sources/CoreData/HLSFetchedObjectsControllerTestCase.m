@@ -0,0 +1,163 @@
+//
+//  HLSFetchedObjectsControllerTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFetchedObjectsControllerTestCase.h"
+
+#import "House.h"
+
+@interface HLSFetchedObjectsControllerTestCase ()
+
+@property (nonatomic, retain) HLSModelManager *modelManager;
+@property (nonatomic, retain) NSIndexSet *deletedIndexes;
+@property (nonatomic, retain) NSIndexSet *insertedIndexes;
+@property (nonatomic, retain) NSIndexSet *updatedIndexes;
+
+- (House *)insertHouseWithName:(NSString *)name;
+- (NSArray *)namesOfHouses:(NSArray *)houses;
+
+@end
+
+@implementation HLSFetchedObjectsControllerTestCase
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.modelManager = nil;
+    self.deletedIndexes = nil;
+    self.insertedIndexes = nil;
+    self.updatedIndexes = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize modelManager = m_modelManager;
+
+@synthesize deletedIndexes = m_deletedIndexes;
+
+@synthesize insertedIndexes = m_insertedIndexes;
+
+@synthesize updatedIndexes = m_updatedIndexes;
+
+#pragma mark Test setup and tear down
+
+- (void)setUp
+{
+    [super setUp];
+    
+    self.modelManager = [HLSModelManager inMemoryModelManagerWithModelFileName:@"CoconutKitTestData"
+                                                                      inBundle:nil
+                                                                 configuration:nil
+                                                                       options:nil];
+    self.deletedIndexes = nil;
+    self.insertedIndexes = nil;
+    self.updatedIndexes = nil;
+}
+
+- (void)tearDown
+{
+    self.modelManager = nil;
+    
+    [super tearDown];
+}
+
+#pragma mark Helpers
+
+- (House *)insertHouseWithName:(NSString *)name
+{
+    House *house = [House insertIntoManagedObjectContext:self.modelManager.managedObjectContext];
+    house.name = name;
+    return house;
+}
+
+- (NSArray *)namesOfHouses:(NSArray *)houses
+{
+    return [houses valueForKey:@"name"];
+}
+
+#pragma mark HLSFetchedObjectsControllerDelegate protocol implementation
+
+- (void)fetchedObjectsController:(HLSFetchedObjectsController *)fetchedObjectsController
+   didChangeObjectsAtDeletedIndexes:(NSIndexSet *)deletedIndexes
+                    insertedIndexes:(NSIndexSet *)insertedIndexes
+                     updatedIndexes:(NSIndexSet *)updatedIndexes
+{
+    self.deletedIndexes = deletedIndexes;
+    self.insertedIndexes = insertedIndexes;
+    self.updatedIndexes = updatedIndexes;
+}
+
+#pragma mark Tests
+
+- (void)testIncrementalChanges
+{
+    NSManagedObjectContext *managedObjectContext = self.modelManager.managedObjectContext;
+    
+    House *houseB = [self insertHouseWithName:@"B"];
+    House *houseD = [self insertHouseWithName:@"D"];
+    [self insertHouseWithName:@"F"];
+    [self insertHouseWithName:@"Other"];
+    GHAssertTrue([managedObjectContext save:NULL], @"Failed to insert test data");
+    
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"name.length == 1"];
+    NSSortDescriptor *sortDescriptor = [NSSortDescriptor sortDescriptorWithKey:@"name" ascending:YES];
+    HLSFetchedObjectsController *fetchedObjectsController = [[[HLSFetchedObjectsController alloc] initWithEntityClass:[House class]
+                                                                                                               predicate:predicate
+                                                                                                        sortDescriptors:[NSArray arrayWithObject:sortDescriptor]
+                                                                                                   managedObjectContext:managedObjectContext] autorelease];
+    fetchedObjectsController.delegate = self;
+    GHAssertEqualObjects([self namesOfHouses:fetchedObjectsController.objects], ([NSArray arrayWithObjects:@"B", @"D", @"F", nil]), @"Initial objects");
+    
+    // Insertion of a matching and of a non-matching object
+    [self insertHouseWithName:@"C"];
+    [self insertHouseWithName:@"Another"];
+    [managedObjectContext processPendingChanges];
+    GHAssertEqualObjects([self namesOfHouses:fetchedObjectsController.objects], ([NSArray arrayWithObjects:@"B", @"C", @"D", @"F", nil]), @"Insertion");
+    GHAssertEquals([self.insertedIndexes count], 1U, @"Inserted indexes");
+    GHAssertTrue([self.insertedIndexes containsIndex:1], @"Inserted index");
+    GHAssertEquals([self.deletedIndexes count], 0U, @"Deleted indexes");
+    
+    // Update in place
+    houseD.name = @"E";
+    [managedObjectContext processPendingChanges];
+    GHAssertEqualObjects([self namesOfHouses:fetchedObjectsController.objects], ([NSArray arrayWithObjects:@"B", @"C", @"E", @"F", nil]), @"Update");
+    GHAssertEquals([self.updatedIndexes count], 1U, @"Updated indexes");
+    GHAssertTrue([self.updatedIndexes containsIndex:2], @"Updated index");
+    GHAssertEquals([self.insertedIndexes count], 0U, @"Inserted indexes");
+    
+    // Move, expressed as a deletion and an insertion
+    houseB.name = @"G";
+    [managedObjectContext processPendingChanges];
+    GHAssertEqualObjects([self namesOfHouses:fetchedObjectsController.objects], ([NSArray arrayWithObjects:@"C", @"E", @"F", @"G", nil]), @"Move");
+    GHAssertTrue([self.deletedIndexes containsIndex:0], @"Deleted index");
+    GHAssertTrue([self.insertedIndexes containsIndex:3], @"Inserted index");
+    GHAssertEquals([self.updatedIndexes count], 0U, @"Updated indexes");
+    
+    // Object not matching anymore
+    houseD.name = @"Elsewhere";
+    [managedObjectContext processPendingChanges];
+    GHAssertEqualObjects([self namesOfHouses:fetchedObjectsController.objects], ([NSArray arrayWithObjects:@"C", @"F", @"G", nil]), @"No match");
+    GHAssertTrue([self.deletedIndexes containsIndex:1], @"Deleted index");
+    
+    // Deletion
+    [managedObjectContext deleteObject:houseB];
+    [managedObjectContext processPendingChanges];
+    GHAssertEqualObjects([self namesOfHouses:fetchedObjectsController.objects], ([NSArray arrayWithObjects:@"C", @"F", nil]), @"Deletion");
+    GHAssertEquals([self.deletedIndexes count], 1U, @"Deleted indexes");
+    GHAssertTrue([self.deletedIndexes containsIndex:2], @"Deleted index");
+    
+    // The incrementally maintained objects must be the ones a fetch returns
+    NSArray *fetchedHouses = [House filteredObjectsUsingPredicate:predicate
+                                           sortedUsingDescriptor:sortDescriptor
+                                          inManagedObjectContext:managedObjectContext];
+    GHAssertEqualObjects(fetchedObjectsController.objects, fetchedHouses, @"Consistency with fetch");
+}
+
+@end
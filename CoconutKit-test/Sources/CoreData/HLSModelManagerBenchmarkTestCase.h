@@ -0,0 +1,27 @@
+//
+//  HLSModelManagerBenchmarkTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Core Data throughput benchmarks for HLSModelManager and NSManagedObject+HLSExtensions. For 1'000, 10'000 and 100'000
+ * persons (each owning a bank account), the time and the memory high-water mark (increase of the resident memory size)
+ * of the following operations are recorded, using a fresh SQLite store for each object count:
+ *   - insertion and save
+ *   - fetch of all objects (from the store, faults being fired)
+ *   - validation of the same number of objects with code and model validations
+ *   - duplication of all persons (and of their accounts)
+ *   - deletion of all objects and save
+ * Results are written as JSON to HLSModelManagerBenchmark.json in the application Documents directory when all
+ * benchmarks have been run, so that results can be compared between runs to catch regressions
+ */
+@interface HLSModelManagerBenchmarkTestCase : GHTestCase {
+@private
+    NSMutableArray *m_results;
+    NSUInteger m_memoryHighWaterMark;
+}
+
+@end
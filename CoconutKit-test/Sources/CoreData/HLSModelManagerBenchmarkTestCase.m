@@ -0,0 +1,293 @@
+//
+//  HLSModelManagerBenchmarkTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSModelManagerBenchmarkTestCase.h"
+
+#import "ConcreteSubclassC.h"
+#import "Person.h"
+
+#import <mach/mach.h>
+
+// Numbers of persons used by the benchmarks
+static const NSUInteger kBenchmarkObjectCounts[] = { 1000, 10000, 100000 };
+static const NSUInteger kBenchmarkObjectCountsSize = sizeof(kBenchmarkObjectCounts) / sizeof(NSUInteger);
+
+// Objects processed between memory samples
+static const NSUInteger kBenchmarkMemorySamplingInterval = 1000;
+
+@interface HLSModelManagerBenchmarkTestCase ()
+
+@property (nonatomic, retain) NSMutableArray *results;
+
+- (NSString *)storeDirectoryPath;
+
+- (void)recordResultWithName:(NSString *)name
+                 objectCount:(NSUInteger)objectCount
+                        time:(double)time
+                      memory:(NSUInteger)memory;
+- (NSString *)resultsJSONString;
+
+- (void)measureOperationWithName:(NSString *)name
+                     objectCount:(NSUInteger)objectCount
+                           block:(void (^)(void))block;
+- (void)sampleMemory;
+- (void)drainModelContext;
+- (NSUInteger)residentMemorySize;
+
+- (void)benchmarkWithObjectCount:(NSUInteger)objectCount;
+
+@end
+
+@implementation HLSModelManagerBenchmarkTestCase
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.results = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize results = m_results;
+
+#pragma mark Test setup and tear down
+
+- (void)setUpClass
+{
+    [super setUpClass];
+    
+    self.results = [NSMutableArray array];
+}
+
+- (void)tearDownClass
+{
+    NSString *resultsJSONString = [self resultsJSONString];
+    GHTestLog(@"%@", resultsJSONString);
+    
+    NSString *documentsDirectoryPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *filePath = [documentsDirectoryPath stringByAppendingPathComponent:@"HLSModelManagerBenchmark.json"];
+    NSError *error = nil;
+    if (! [resultsJSONString writeToFile:filePath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+        HLSLoggerError(@"Could not write benchmark results to %@. Reason: %@", filePath, error);
+    }
+    else {
+        HLSLoggerInfo(@"Benchmark results written to %@", filePath);
+    }
+    
+    [[NSFileManager defaultManager] removeItemAtPath:[self storeDirectoryPath] error:NULL];
+    
+    self.results = nil;
+    
+    [super tearDownClass];
+}
+
+#pragma mark Store
+
+- (NSString *)storeDirectoryPath
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"HLSModelManagerBenchmark"];
+}
+
+#pragma mark Results
+
+- (void)recordResultWithName:(NSString *)name
+                 objectCount:(NSUInteger)objectCount
+                        time:(double)time
+                      memory:(NSUInteger)memory
+{
+    NSDictionary *result = [NSDictionary dictionaryWithObjectsAndKeys:name, @"name",
+                            [NSNumber numberWithUnsignedInteger:objectCount], @"objectCount",
+                            [NSNumber numberWithDouble:time], @"time",
+                            [NSNumber numberWithDouble:(objectCount != 0) ? objectCount / time : 0.], @"throughput",
+                            [NSNumber numberWithUnsignedInteger:memory], @"memory",
+                            nil];
+    [self.results addObject:result];
+}
+
+// Names only contain plain identifiers, no escaping is needed
+- (NSString *)resultsJSONString
+{
+    NSMutableArray *resultStrings = [NSMutableArray arrayWithCapacity:[self.results count]];
+    for (NSDictionary *result in self.results) {
+        NSString *resultString = [NSString stringWithFormat:@"{\"name\":\"%@\",\"objectCount\":%@,\"time\":%.9f,\"throughput\":%.3f,\"memory\":%@}",
+                                  [result objectForKey:@"name"],
+                                  [result objectForKey:@"objectCount"],
+                                  [[result objectForKey:@"time"] doubleValue],
+                                  [[result objectForKey:@"throughput"] doubleValue],
+                                  [result objectForKey:@"memory"]];
+        [resultStrings addObject:resultString];
+    }
+    return [NSString stringWithFormat:@"{\"benchmarks\":[%@]}", [resultStrings componentsJoinedByString:@","]];
+}
+
+#pragma mark Helpers
+
+// The block must call -sampleMemory regularly so that the memory high-water mark can be measured
+- (void)measureOperationWithName:(NSString *)name
+                     objectCount:(NSUInteger)objectCount
+                           block:(void (^)(void))block
+{
+    NSUInteger residentMemorySizeBefore = [self residentMemorySize];
+    m_memoryHighWaterMark = residentMemorySizeBefore;
+    
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    block();
+    CFAbsoluteTime time = CFAbsoluteTimeGetCurrent() - startTime;
+    
+    [self sampleMemory];
+    [self recordResultWithName:name
+                   objectCount:objectCount
+                          time:time
+                        memory:m_memoryHighWaterMark - residentMemorySizeBefore];
+}
+
+- (void)sampleMemory
+{
+    m_memoryHighWaterMark = MAX(m_memoryHighWaterMark, [self residentMemorySize]);
+}
+
+// Forget about the objects registered with the current context, so that the next operation starts from the store
+- (void)drainModelContext
+{
+    [[HLSModelManager currentModelContext] reset];
+}
+
+- (NSUInteger)residentMemorySize
+{
+    struct task_basic_info info;
+    mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
+
+#pragma mark Benchmarks
+
+- (void)benchmarkWithObjectCount:(NSUInteger)objectCount
+{
+    // Freshly create a store
+    [[NSFileManager defaultManager] removeItemAtPath:[self storeDirectoryPath] error:NULL];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[self storeDirectoryPath] withIntermediateDirectories:YES attributes:nil error:NULL];
+    HLSModelManager *modelManager = [HLSModelManager SQLiteManagerWithModelFileName:@"CoconutKitTestData"
+                                                                           inBundle:nil
+                                                                      configuration:nil
+                                                                     storeDirectory:[self storeDirectoryPath]
+                                                                            options:HLSModelManagerLightweightMigrationOptions];
+    [HLSModelManager pushModelManager:modelManager];
+    
+    // Insertion
+    [self measureOperationWithName:@"insert" objectCount:objectCount block:^{
+        for (NSUInteger i = 0; i < objectCount; ++i) {
+            Person *person = [Person insert];
+            person.firstName = [NSString stringWithFormat:@"First name %d", i];
+            person.lastName = [NSString stringWithFormat:@"Last name %d", i % 100];
+            
+            BankAccount *bankAccount = [BankAccount insert];
+            bankAccount.name = [NSString stringWithFormat:@"Account %d", i];
+            bankAccount.balanceValue = i * 10.;
+            bankAccount.owner = person;
+            
+            if (i % kBenchmarkMemorySamplingInterval == 0) {
+                [self sampleMemory];
+            }
+        }
+    }];
+    
+    // Save
+    __block BOOL saved = NO;
+    [self measureOperationWithName:@"save" objectCount:objectCount block:^{
+        saved = [HLSModelManager saveCurrentModelContext:NULL];
+    }];
+    GHAssertTrue(saved, @"Save");
+    [self drainModelContext];
+    
+    // Fetch (firing faults so that the data is loaded as well)
+    __block NSUInteger fetchedObjectCount = 0;
+    [self measureOperationWithName:@"fetch" objectCount:objectCount block:^{
+        NSSortDescriptor *sortDescriptor = [NSSortDescriptor sortDescriptorWithKey:@"lastName" ascending:YES];
+        NSArray *persons = [Person allObjectsSortedUsingDescriptor:sortDescriptor];
+        [self sampleMemory];
+        
+        for (Person *person in persons) {
+            [person firstName];
+            ++fetchedObjectCount;
+            
+            if (fetchedObjectCount % kBenchmarkMemorySamplingInterval == 0) {
+                [self sampleMemory];
+            }
+        }
+    }];
+    GHAssertEquals(fetchedObjectCount, objectCount, @"Fetch");
+    
+    // Duplication (not saved)
+    [self measureOperationWithName:@"duplicate" objectCount:objectCount block:^{
+        NSUInteger i = 0;
+        for (Person *person in [Person allObjects]) {
+            [person duplicate];
+            
+            if (++i % kBenchmarkMemorySamplingInterval == 0) {
+                [self sampleMemory];
+            }
+        }
+    }];
+    [HLSModelManager rollbackCurrentModelContext];
+    [self drainModelContext];
+    
+    // Validation (objects are inserted before measurements begin, and not saved)
+    NSMutableArray *cInstances = [NSMutableArray arrayWithCapacity:objectCount];
+    for (NSUInteger i = 0; i < objectCount; ++i) {
+        ConcreteSubclassC *cInstance = [ConcreteSubclassC insert];
+        cInstance.codeMandatoryNotEmptyStringA = @"Hello, World!";
+        cInstance.codeMandatoryStringC = @"Validated";
+        cInstance.noValidationStringA = (i % 2 == 0) ? @"Consistency check" : nil;
+        cInstance.noValidationNumberCValue = (i % 4 == 0) ? 0 : 1;
+        [cInstances addObject:cInstance];
+    }
+    [self measureOperationWithName:@"validate" objectCount:objectCount block:^{
+        NSUInteger i = 0;
+        for (ConcreteSubclassC *cInstance in cInstances) {
+            // Objects are not all valid, the result does not matter
+            [cInstance check:NULL];
+            
+            if (++i % kBenchmarkMemorySamplingInterval == 0) {
+                [self sampleMemory];
+            }
+        }
+    }];
+    [cInstances removeAllObjects];
+    [HLSModelManager rollbackCurrentModelContext];
+    [self drainModelContext];
+    
+    // Deletion of all objects (accounts are deleted with their owners)
+    __block BOOL deleted = NO;
+    [self measureOperationWithName:@"deleteAll" objectCount:objectCount block:^{
+        [Person deleteAllObjects];
+        [self sampleMemory];
+        deleted = [HLSModelManager saveCurrentModelContext:NULL];
+    }];
+    GHAssertTrue(deleted, @"Delete all");
+    GHAssertEquals([Person countOfObjectsUsingPredicate:nil], (NSUInteger)0, @"Remaining persons");
+    GHAssertEquals([BankAccount countOfObjectsUsingPredicate:nil], (NSUInteger)0, @"Remaining accounts");
+    
+    [HLSModelManager popModelManager];
+}
+
+- (void)testThroughput
+{
+    for (NSUInteger i = 0; i < kBenchmarkObjectCountsSize; ++i) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        [self benchmarkWithObjectCount:kBenchmarkObjectCounts[i]];
+        [pool drain];
+    }
+}
+
+@end
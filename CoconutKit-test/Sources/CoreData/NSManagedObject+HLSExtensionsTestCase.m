@@ -110,4 +110,65 @@
     GHAssertTrue([HLSModelManager saveCurrentModelContext:NULL], @"Invalid objects");
 }
 
+- (void)testFetchOptions
+{
+    NSSortDescriptor *sortDescriptor = [NSSortDescriptor sortDescriptorWithKey:@"firstName" ascending:YES];
+    
+    HLSFetchOptions *fetchOptions = [HLSFetchOptions fetchOptions];
+    fetchOptions.fetchLimit = 1;
+    fetchOptions.fetchOffset = 1;
+    fetchOptions.relationshipKeyPathsForPrefetching = [NSArray arrayWithObject:@"accounts"];
+    NSArray *persons = [Person filteredObjectsUsingPredicate:[NSPredicate predicateWithFormat:@"lastName == %@", @"Slowprano"]
+                                      sortedUsingDescriptors:[NSArray arrayWithObject:sortDescriptor]
+                                                fetchOptions:fetchOptions];
+    GHAssertEquals([persons count], (NSUInteger)1, @"Fetch limit");
+    GHAssertEqualStrings([[persons objectAtIndex:0] firstName], @"Tony", @"Fetch offset");
+}
+
+- (void)testQueriesInStore
+{
+    GHAssertEquals([Person countOfObjectsUsingPredicate:[NSPredicate predicateWithFormat:@"firstName == %@", @"Carmela"]], (NSUInteger)1,
+                   @"Count");
+    GHAssertTrue([BankAccount existsObjectUsingPredicate:[NSPredicate predicateWithFormat:@"name == %@", @"Dirty account"]], @"Exists");
+    GHAssertFalse([BankAccount existsObjectUsingPredicate:[NSPredicate predicateWithFormat:@"name == %@", @"Offshore account"]], @"Exists");
+    
+    // Accounts might have been duplicated by other tests, min and max are not affected
+    NSNumber *minimumBalance = [BankAccount aggregateValueUsingFunction:HLSAggregateFunctionMinimum forKey:@"balance" usingPredicate:nil];
+    GHAssertEquals([minimumBalance doubleValue], 15450039.50, @"Minimum");
+    NSNumber *maximumBalance = [BankAccount aggregateValueUsingFunction:HLSAggregateFunctionMaximum forKey:@"balance" usingPredicate:nil];
+    GHAssertEquals([maximumBalance doubleValue], 79340087., @"Maximum");
+    GHAssertNil([BankAccount aggregateValueUsingFunction:HLSAggregateFunctionSum forKey:@"unknownKey" usingPredicate:nil], @"Invalid key");
+}
+
+- (void)testBatchedDeletion
+{
+    for (NSUInteger i = 0; i < 24; ++i) {
+        House *house = [House insert];
+        house.name = [NSString stringWithFormat:@"House %d", i];
+    }
+    GHAssertTrue([HLSModelManager saveCurrentModelContext:NULL], @"Failed to insert test data");
+    
+    NSUInteger houseCount = [[House allObjects] count];
+    __block NSUInteger batchCount = 0;
+    NSError *error = nil;
+    GHAssertTrue([House deleteAllObjectsWithBatchSize:10 saving:NO progressBlock:^(NSUInteger deletedObjectCount, NSUInteger objectCount, BOOL *pStop) {
+        ++batchCount;
+        GHAssertEquals(objectCount, houseCount, @"Object count");
+        GHAssertEquals(deletedObjectCount, MIN(batchCount * 10, houseCount), @"Deleted object count");
+    } error:&error], @"Deletion");
+    GHAssertNil(error, @"Error");
+    GHAssertEquals(batchCount, (houseCount + 9) / 10, @"Batch count");
+    GHAssertEquals([[House allObjects] count], (NSUInteger)0, @"Remaining objects");
+    [[HLSModelManager currentModelContext] rollback];
+    
+    // Stop after the first batch
+    GHAssertTrue([House deleteAllObjectsWithBatchSize:10 saving:NO progressBlock:^(NSUInteger deletedObjectCount, NSUInteger objectCount, BOOL *pStop) {
+        *pStop = YES;
+    } error:NULL], @"Deletion");
+    GHAssertEquals([[House allObjects] count], houseCount - 10, @"Remaining objects");
+    [[HLSModelManager currentModelContext] rollback];
+    
+    GHAssertEquals([[House allObjects] count], houseCount, @"Objects restored");
+}
+
 @end
@@ -280,6 +280,54 @@
     [HLSModelManager rollbackCurrentModelContext];
 }
 
+- (void)testIncrementalValidation
+{
+    ConcreteClassD *dInstance = [ConcreteClassD insert];
+    dInstance.noValidationStringD = @"D";
+    
+    // Valid ConcreteSubclassC instance, completely validated when inserted
+    ConcreteSubclassC *cInstance = [ConcreteSubclassC insert];
+    cInstance.noValidationStringA = @"Consistency check";
+    cInstance.codeMandatoryNotEmptyStringA = @"Mandatory A";
+    cInstance.codeMandatoryNumberB = [NSNumber numberWithInteger:0];
+    cInstance.modelMandatoryBoundedNumberB = [NSNumber numberWithInteger:6];
+    cInstance.modelMandatoryCodeNotZeroNumberB = [NSNumber numberWithInteger:3];
+    cInstance.noValidationNumberB = [NSNumber numberWithInteger:-12];
+    cInstance.codeMandatoryStringC = @"Mandatory C";
+    cInstance.modelMandatoryBoundedPatternStringC = @"Hello, World!";
+    cInstance.noValidationNumberC = [NSNumber numberWithInteger:1012];
+    cInstance.codeMandatoryConcreteClassesD = [NSSet setWithObject:dInstance];
+    GHAssertTrue([HLSModelManager saveCurrentModelContext:NULL], @"Failed to insert test data");
+    
+    [NSManagedObject setIncrementalValidationEnabled:YES];
+    
+    // Changed field only
+    cInstance.codeMandatoryNotEmptyStringA = nil;
+    NSError *error1 = nil;
+    GHAssertFalse([HLSModelManager saveCurrentModelContext:&error1], @"Incorrect result when saving");
+    GHAssertTrue([error1 hasCode:TestValidationMandatoryValueError withinDomain:TestValidationErrorDomain], @"Incorrect error domain and code");
+    [HLSModelManager rollbackCurrentModelContext];
+    
+    // Changed field the consistency check depends on
+    cInstance.noValidationNumberC = nil;
+    NSError *error2 = nil;
+    GHAssertFalse([HLSModelManager saveCurrentModelContext:&error2], @"Incorrect result when saving");
+    GHAssertTrue([error2 hasCode:TestValidationInconsistencyError withinDomain:TestValidationErrorDomain], @"Incorrect error domain and code");
+    [HLSModelManager rollbackCurrentModelContext];
+    
+    // Valid change
+    cInstance.noValidationNumberC = [NSNumber numberWithInteger:2012];
+    NSError *error3 = nil;
+    GHAssertTrue([HLSModelManager saveCurrentModelContext:&error3], @"Incorrect result when saving");
+    GHAssertNil(error3, @"Error incorrectly returned");
+    
+    [NSManagedObject setIncrementalValidationEnabled:NO];
+    
+    [HLSModelManager deleteObjectFromCurrentModelContext:cInstance];
+    [HLSModelManager deleteObjectFromCurrentModelContext:dInstance];
+    GHAssertTrue([HLSModelManager saveCurrentModelContext:NULL], @"Failed to remove test data");
+}
+
 - (void)testDelete
 {    
     [HLSModelManager deleteObjectFromCurrentModelContext:self.lockedDInstance];
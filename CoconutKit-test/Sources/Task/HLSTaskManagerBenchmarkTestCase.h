@@ -0,0 +1,23 @@
+//
+//  HLSTaskManagerBenchmarkTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 15.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Benchmarks for HLSTaskManager. Each benchmark records one or several results, which are written as JSON to
+ * HLSTaskManagerBenchmark.json in the application Documents directory when all benchmarks have been run, so that
+ * results can be compared between runs to catch regressions
+ */
+@interface HLSTaskManagerBenchmarkTestCase : GHTestCase <HLSTaskDelegate, HLSTaskGroupDelegate> {
+@private
+    NSMutableArray *m_results;
+    NSUInteger m_nbrPendingTasks;
+    NSUInteger m_nbrProgressUpdates;
+    NSMutableArray *m_notificationLatencies;
+    BOOL m_taskGroupProcessed;
+}
+
+@end
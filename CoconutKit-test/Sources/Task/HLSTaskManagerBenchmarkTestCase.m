@@ -0,0 +1,403 @@
+//
+//  HLSTaskManagerBenchmarkTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 15.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskManagerBenchmarkTestCase.h"
+
+// Maximum time a benchmark is allowed to wait for its tasks
+static const NSTimeInterval kBenchmarkTimeoutInterval = 120.;
+
+// Return info key under which time-stamped tasks store the time at which they ended
+static NSString * const kBenchmarkEndTimeKey = @"endTime";
+
+/**
+ * Shapes of the dependency graphs used by task group benchmarks:
+ *   BenchmarkDependencyShapeNone: independent tasks
+ *   BenchmarkDependencyShapeChain: each task depends on the previous one
+ *   BenchmarkDependencyShapeFanOut: all tasks depend on the first one
+ *   BenchmarkDependencyShapeLayered: layers of 10 tasks, each task depending on all tasks of the previous layer
+ */
+typedef enum {
+    BenchmarkDependencyShapeEnumBegin = 0,
+    BenchmarkDependencyShapeNone = BenchmarkDependencyShapeEnumBegin,
+    BenchmarkDependencyShapeChain,
+    BenchmarkDependencyShapeFanOut,
+    BenchmarkDependencyShapeLayered,
+    BenchmarkDependencyShapeEnumEnd,
+    BenchmarkDependencyShapeEnumSize = BenchmarkDependencyShapeEnumEnd - BenchmarkDependencyShapeEnumBegin
+} BenchmarkDependencyShape;
+
+static NSString * const kBenchmarkDependencyShapeNames[] = {
+    @"none",
+    @"chain",
+    @"fanOut",
+    @"layered"
+};
+
+static const NSUInteger kBenchmarkLayerTaskCount = 10;
+
+@interface HLSTaskManagerBenchmarkTestCase ()
+
+@property (nonatomic, retain) NSMutableArray *results;
+@property (nonatomic, retain) NSMutableArray *notificationLatencies;
+
+- (void)recordResultWithName:(NSString *)name
+                  parameters:(NSString *)parameters
+                   taskCount:(NSUInteger)taskCount
+                       value:(double)value
+                        unit:(NSString *)unit;
+- (NSString *)resultsJSONString;
+
+- (BOOL)waitUntilPendingTasksProcessed;
+- (double)percentile:(double)percentile ofValues:(NSArray *)values;
+
+- (HLSTaskGroup *)taskGroupWithTaskCount:(NSUInteger)taskCount dependencyShape:(BenchmarkDependencyShape)dependencyShape;
+
+@end
+
+@implementation HLSTaskManagerBenchmarkTestCase
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.results = nil;
+    self.notificationLatencies = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize results = m_results;
+
+@synthesize notificationLatencies = m_notificationLatencies;
+
+#pragma mark Test setup and tear down
+
+- (BOOL)shouldRunOnMainThread
+{
+    // Task manager notifications are received on the thread which submitted the tasks, and require its run loop
+    return YES;
+}
+
+- (void)setUpClass
+{
+    [super setUpClass];
+    
+    self.results = [NSMutableArray array];
+}
+
+- (void)tearDownClass
+{
+    NSString *resultsJSONString = [self resultsJSONString];
+    GHTestLog(@"%@", resultsJSONString);
+    
+    NSString *documentsDirectoryPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *filePath = [documentsDirectoryPath stringByAppendingPathComponent:@"HLSTaskManagerBenchmark.json"];
+    NSError *error = nil;
+    if (! [resultsJSONString writeToFile:filePath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+        HLSLoggerError(@"Could not write benchmark results to %@. Reason: %@", filePath, error);
+    }
+    else {
+        HLSLoggerInfo(@"Benchmark results written to %@", filePath);
+    }
+    
+    self.results = nil;
+    
+    [super tearDownClass];
+}
+
+#pragma mark Results
+
+- (void)recordResultWithName:(NSString *)name
+                  parameters:(NSString *)parameters
+                   taskCount:(NSUInteger)taskCount
+                       value:(double)value
+                        unit:(NSString *)unit
+{
+    NSDictionary *result = [NSDictionary dictionaryWithObjectsAndKeys:name, @"name",
+                            parameters, @"parameters",
+                            [NSNumber numberWithUnsignedInteger:taskCount], @"taskCount",
+                            [NSNumber numberWithDouble:value], @"value",
+                            unit, @"unit",
+                            nil];
+    [self.results addObject:result];
+}
+
+// Names and parameters only contain plain identifiers, no escaping is needed
+- (NSString *)resultsJSONString
+{
+    NSMutableArray *resultStrings = [NSMutableArray arrayWithCapacity:[self.results count]];
+    for (NSDictionary *result in self.results) {
+        NSString *resultString = [NSString stringWithFormat:@"{\"name\":\"%@\",\"parameters\":\"%@\",\"taskCount\":%@,\"value\":%.9f,\"unit\":\"%@\"}",
+                                  [result objectForKey:@"name"],
+                                  [result objectForKey:@"parameters"],
+                                  [result objectForKey:@"taskCount"],
+                                  [[result objectForKey:@"value"] doubleValue],
+                                  [result objectForKey:@"unit"]];
+        [resultStrings addObject:resultString];
+    }
+    return [NSString stringWithFormat:@"{\"benchmarks\":[%@]}", [resultStrings componentsJoinedByString:@","]];
+}
+
+#pragma mark Helpers
+
+// Run the main run loop until all pending tasks have been processed or cancelled, and the task group (if any) has
+// been processed. Return NO on timeout
+- (BOOL)waitUntilPendingTasksProcessed
+{
+    NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:kBenchmarkTimeoutInterval];
+    while (m_nbrPendingTasks != 0 || ! m_taskGroupProcessed) {
+        if ([timeoutDate timeIntervalSinceNow] < 0.) {
+            return NO;
+        }
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    return YES;
+}
+
+// Nearest-rank percentile of an array of NSNumber objects
+- (double)percentile:(double)percentile ofValues:(NSArray *)values
+{
+    if ([values count] == 0) {
+        return 0.;
+    }
+    
+    NSArray *sortedValues = [values sortedArrayUsingSelector:@selector(compare:)];
+    NSUInteger rank = (NSUInteger)ceil(percentile / 100. * [sortedValues count]);
+    NSUInteger index = (rank == 0) ? 0 : MIN(rank - 1, [sortedValues count] - 1);
+    return [[sortedValues objectAtIndex:index] doubleValue];
+}
+
+- (HLSTaskGroup *)taskGroupWithTaskCount:(NSUInteger)taskCount dependencyShape:(BenchmarkDependencyShape)dependencyShape
+{
+    HLSTaskGroup *taskGroup = [[[HLSTaskGroup alloc] init] autorelease];
+    NSMutableArray *tasks = [NSMutableArray arrayWithCapacity:taskCount];
+    for (NSUInteger i = 0; i < taskCount; ++i) {
+        HLSBlockTask *task = [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {}];
+        [taskGroup addTask:task];
+        [tasks addObject:task];
+    }
+    
+    for (NSUInteger i = 1; i < taskCount; ++i) {
+        HLSTask *task = [tasks objectAtIndex:i];
+        switch (dependencyShape) {
+            case BenchmarkDependencyShapeChain: {
+                [taskGroup addDependencyForTask:task onTask:[tasks objectAtIndex:i - 1] strong:NO];
+                break;
+            }
+            
+            case BenchmarkDependencyShapeFanOut: {
+                [taskGroup addDependencyForTask:task onTask:[tasks objectAtIndex:0] strong:NO];
+                break;
+            }
+            
+            case BenchmarkDependencyShapeLayered: {
+                NSUInteger layer = i / kBenchmarkLayerTaskCount;
+                if (layer == 0) {
+                    break;
+                }
+                
+                for (NSUInteger j = (layer - 1) * kBenchmarkLayerTaskCount; j < layer * kBenchmarkLayerTaskCount; ++j) {
+                    [taskGroup addDependencyForTask:task onTask:[tasks objectAtIndex:j] strong:NO];
+                }
+                break;
+            }
+            
+            default: {
+                break;
+            }
+        }
+    }
+    return taskGroup;
+}
+
+#pragma mark Benchmarks
+
+- (void)testSubmitAndCancelThroughput
+{
+    static const NSUInteger s_taskCounts[] = {10, 100, 10000};
+    
+    for (NSUInteger i = 0; i < sizeof(s_taskCounts) / sizeof(NSUInteger); ++i) {
+        NSUInteger taskCount = s_taskCounts[i];
+        
+        HLSTaskManager *taskManager = [[[HLSTaskManager alloc] init] autorelease];
+        NSMutableArray *tasks = [NSMutableArray arrayWithCapacity:taskCount];
+        for (NSUInteger j = 0; j < taskCount; ++j) {
+            // Tasks run until cancelled, so that most of them are still pending when cancelled
+            HLSBlockTask *task = [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+                while (! [context isCancelled]) {
+                    [NSThread sleepForTimeInterval:0.001];
+                }
+            }];
+            [taskManager registerDelegate:self forTask:task];
+            [tasks addObject:task];
+        }
+        
+        m_nbrPendingTasks = taskCount;
+        m_taskGroupProcessed = YES;
+        
+        CFAbsoluteTime submitStartTime = CFAbsoluteTimeGetCurrent();
+        [taskManager submitTasks:tasks];
+        NSTimeInterval submitTimeInterval = CFAbsoluteTimeGetCurrent() - submitStartTime;
+        
+        CFAbsoluteTime cancelStartTime = CFAbsoluteTimeGetCurrent();
+        [taskManager cancelTasks:tasks];
+        NSTimeInterval cancelTimeInterval = CFAbsoluteTimeGetCurrent() - cancelStartTime;
+        
+        GHAssertTrue([self waitUntilPendingTasksProcessed], @"Tasks not cancelled in time");
+        [taskManager unregisterDelegate:self];
+        
+        [self recordResultWithName:@"submitThroughput" parameters:@"" taskCount:taskCount value:taskCount / submitTimeInterval unit:@"tasks/s"];
+        [self recordResultWithName:@"cancelThroughput" parameters:@"" taskCount:taskCount value:taskCount / cancelTimeInterval unit:@"tasks/s"];
+    }
+}
+
+- (void)testNotificationLatency
+{
+    static const NSUInteger s_taskCount = 100;
+    static NSString * const s_notificationDeliveryModeNames[] = {
+        @"synchronous",
+        @"asynchronous",
+        @"dispatchQueue"
+    };
+    
+    for (HLSTaskNotificationDeliveryMode mode = HLSTaskNotificationDeliveryModeEnumBegin; mode < HLSTaskNotificationDeliveryModeEnumEnd; ++mode) {
+        HLSTaskManager *taskManager = [[[HLSTaskManager alloc] init] autorelease];
+        taskManager.notificationDeliveryMode = mode;
+        
+        // Each task records the time at which it ends; the latency is measured when its end notification is received
+        NSMutableArray *tasks = [NSMutableArray arrayWithCapacity:s_taskCount];
+        for (NSUInteger i = 0; i < s_taskCount; ++i) {
+            HLSBlockTask *task = [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+                NSNumber *endTime = [NSNumber numberWithDouble:CFAbsoluteTimeGetCurrent()];
+                [context attachReturnInfo:[NSDictionary dictionaryWithObject:endTime forKey:kBenchmarkEndTimeKey]];
+            }];
+            [taskManager registerDelegate:self forTask:task];
+            [tasks addObject:task];
+        }
+        
+        self.notificationLatencies = [NSMutableArray arrayWithCapacity:s_taskCount];
+        m_nbrPendingTasks = s_taskCount;
+        m_taskGroupProcessed = YES;
+        [taskManager submitTasks:tasks];
+        GHAssertTrue([self waitUntilPendingTasksProcessed], @"Tasks not processed in time");
+        [taskManager unregisterDelegate:self];
+        
+        [self recordResultWithName:@"notificationLatencyMedian"
+                        parameters:s_notificationDeliveryModeNames[mode]
+                         taskCount:s_taskCount
+                             value:[self percentile:50. ofValues:self.notificationLatencies]
+                              unit:@"s"];
+        [self recordResultWithName:@"notificationLatencyP95"
+                        parameters:s_notificationDeliveryModeNames[mode]
+                         taskCount:s_taskCount
+                             value:[self percentile:95. ofValues:self.notificationLatencies]
+                              unit:@"s"];
+        self.notificationLatencies = nil;
+    }
+}
+
+- (void)testProgressUpdateMainThreadCost
+{
+    static const NSUInteger s_progressUpdateCount = 10000;
+    
+    HLSTaskManager *taskManager = [[[HLSTaskManager alloc] init] autorelease];
+    taskManager.metricsEnabled = YES;
+    
+    HLSBlockTask *task = [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+        for (NSUInteger i = 1; i <= s_progressUpdateCount; ++i) {
+            [context updateProgressToValue:(float)i / s_progressUpdateCount];
+        }
+    }];
+    task.tag = @"progress";
+    [taskManager registerDelegate:self forTask:task];
+    
+    m_nbrProgressUpdates = 0;
+    m_nbrPendingTasks = 1;
+    m_taskGroupProcessed = YES;
+    [taskManager submitTask:task];
+    GHAssertTrue([self waitUntilPendingTasksProcessed], @"Task not processed in time");
+    [taskManager unregisterDelegate:self];
+    
+    // The delegate dispatch time interval includes the start and end notifications, which are negligible here
+    NSTimeInterval dispatchTimeInterval = [taskManager.metrics percentile:50.
+                                                                 ofMetric:HLSTaskMetricDelegateDispatchTimeInterval
+                                                          forTasksWithTag:@"progress"];
+    GHAssertTrue(m_nbrProgressUpdates != 0, @"No progress update received");
+    [self recordResultWithName:@"progressUpdateMainThreadCost"
+                    parameters:@""
+                     taskCount:1
+                         value:dispatchTimeInterval / m_nbrProgressUpdates
+                          unit:@"s"];
+}
+
+- (void)testTaskGroupCompletionTime
+{
+    static const NSUInteger s_taskCounts[] = {10, 100, 10000};
+    
+    for (NSUInteger i = 0; i < sizeof(s_taskCounts) / sizeof(NSUInteger); ++i) {
+        NSUInteger taskCount = s_taskCounts[i];
+        for (BenchmarkDependencyShape shape = BenchmarkDependencyShapeEnumBegin; shape < BenchmarkDependencyShapeEnumEnd; ++shape) {
+            HLSTaskManager *taskManager = [[[HLSTaskManager alloc] init] autorelease];
+            HLSTaskGroup *taskGroup = [self taskGroupWithTaskCount:taskCount dependencyShape:shape];
+            [taskManager registerDelegate:self forTaskGroup:taskGroup];
+            
+            m_nbrPendingTasks = 0;
+            m_taskGroupProcessed = NO;
+            
+            CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+            [taskManager submitTaskGroup:taskGroup];
+            GHAssertTrue([self waitUntilPendingTasksProcessed], @"Task group not processed in time");
+            NSTimeInterval completionTimeInterval = CFAbsoluteTimeGetCurrent() - startTime;
+            [taskManager unregisterDelegate:self];
+            
+            [self recordResultWithName:@"taskGroupCompletionTime"
+                            parameters:kBenchmarkDependencyShapeNames[shape]
+                             taskCount:taskCount
+                                 value:completionTimeInterval
+                                  unit:@"s"];
+        }
+    }
+}
+
+#pragma mark HLSTaskDelegate protocol implementation
+
+- (void)taskProgressUpdated:(HLSTask *)task
+{
+    ++m_nbrProgressUpdates;
+}
+
+- (void)taskHasBeenProcessed:(HLSTask *)task
+{
+    NSNumber *endTime = [task.returnInfo objectForKey:kBenchmarkEndTimeKey];
+    if (endTime) {
+        [self.notificationLatencies addObject:[NSNumber numberWithDouble:CFAbsoluteTimeGetCurrent() - [endTime doubleValue]]];
+    }
+    
+    --m_nbrPendingTasks;
+}
+
+- (void)taskHasBeenCancelled:(HLSTask *)task
+{
+    --m_nbrPendingTasks;
+}
+
+#pragma mark HLSTaskGroupDelegate protocol implementation
+
+- (void)taskGroupHasBeenProcessed:(HLSTaskGroup *)taskGroup
+{
+    m_taskGroupProcessed = YES;
+}
+
+- (void)taskGroupHasBeenCancelled:(HLSTaskGroup *)taskGroup
+{
+    m_taskGroupProcessed = YES;
+}
+
+@end
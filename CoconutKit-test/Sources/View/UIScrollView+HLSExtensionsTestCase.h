@@ -0,0 +1,14 @@
+//
+//  UIScrollView+HLSExtensionsTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+@interface UIScrollView_HLSExtensionsTestCase : GHTestCase {
+@private
+    
+}
+
+@end
@@ -0,0 +1,96 @@
+//
+//  UIScrollView+HLSExtensionsTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "UIScrollView+HLSExtensionsTestCase.h"
+
+#import <objc/runtime.h>
+
+@implementation UIScrollView_HLSExtensionsTestCase
+
+#pragma mark Test setup and tear down
+
+- (BOOL)shouldRunOnMainThread
+{
+    // Display links run on the main thread
+    return YES;
+}
+
+#pragma mark Tests
+
+- (void)testSynchronization
+{
+    UIScrollView *masterScrollView = [[[UIScrollView alloc] initWithFrame:CGRectMake(0.f, 0.f, 100.f, 100.f)] autorelease];
+    masterScrollView.contentSize = CGSizeMake(100.f, 300.f);
+    
+    UIScrollView *scrollView = [[[UIScrollView alloc] initWithFrame:CGRectMake(0.f, 0.f, 100.f, 100.f)] autorelease];
+    scrollView.contentSize = CGSizeMake(100.f, 200.f);
+    
+    [masterScrollView synchronizeWithScrollViews:[NSArray arrayWithObject:scrollView] bounces:NO];
+    
+    // Only the master scroll view is given a dynamic subclass, whose existence is hidden
+    GHAssertTrue(object_getClass(masterScrollView) != [UIScrollView class], @"Master dynamic subclass");
+    GHAssertEquals([masterScrollView class], [UIScrollView class], @"Master class");
+    GHAssertEquals(object_getClass(scrollView), [UIScrollView class], @"Synchronized scroll view class");
+    
+    masterScrollView.contentOffset = CGPointMake(0.f, 100.f);
+    GHAssertEquals(scrollView.contentOffset.y, 50.f, @"Relative offset");
+    
+    // Not bouncing
+    masterScrollView.contentOffset = CGPointMake(0.f, 250.f);
+    GHAssertEquals(scrollView.contentOffset.y, 100.f, @"Clamped offset");
+    
+    // Ratios must follow size changes
+    scrollView.contentSize = CGSizeMake(100.f, 500.f);
+    masterScrollView.contentOffset = CGPointMake(0.f, 100.f);
+    GHAssertEquals(scrollView.contentOffset.y, 200.f, @"Relative offset after content size change");
+    
+    [masterScrollView removeSynchronization];
+    GHAssertEquals(object_getClass(masterScrollView), [UIScrollView class], @"Dynamic subclass removed");
+    
+    masterScrollView.contentOffset = CGPointMake(0.f, 0.f);
+    GHAssertEquals(scrollView.contentOffset.y, 200.f, @"No synchronization anymore");
+}
+
+- (void)testDisplayFrameSynchronization
+{
+    UIScrollView *masterScrollView = [[[UIScrollView alloc] initWithFrame:CGRectMake(0.f, 0.f, 100.f, 100.f)] autorelease];
+    masterScrollView.contentSize = CGSizeMake(100.f, 300.f);
+    
+    UIScrollView *scrollView1 = [[[UIScrollView alloc] initWithFrame:CGRectMake(0.f, 0.f, 100.f, 100.f)] autorelease];
+    scrollView1.contentSize = CGSizeMake(100.f, 200.f);
+    
+    UIScrollView *scrollView2 = [[[UIScrollView alloc] initWithFrame:CGRectMake(0.f, 0.f, 100.f, 100.f)] autorelease];
+    scrollView2.contentSize = CGSizeMake(100.f, 200.f);
+    
+    [masterScrollView synchronizeWithScrollViews:[NSArray arrayWithObject:scrollView1]
+                                         bounces:NO
+                                            mode:HLSScrollViewSynchronizationModeDisplayFrame];
+    [scrollView1 synchronizeWithScrollViews:[NSArray arrayWithObject:scrollView2]
+                                    bounces:NO
+                                       mode:HLSScrollViewSynchronizationModeDisplayFrameTransform];
+    
+    // Only the last offset is applied, at the next frame
+    masterScrollView.contentOffset = CGPointMake(0.f, 50.f);
+    masterScrollView.contentOffset = CGPointMake(0.f, 100.f);
+    GHAssertEquals(scrollView1.contentOffset.y, 0.f, @"Not synchronized before the next frame");
+    
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    GHAssertEquals(scrollView1.contentOffset.y, 50.f, @"Synchronized");
+    
+    // Chained synchronizations are applied during the same frame. With transforms, content offsets do not change
+    GHAssertEquals(scrollView2.contentOffset.y, 0.f, @"Content offset unchanged");
+    GHAssertTrue(CATransform3DEqualToTransform(scrollView2.layer.sublayerTransform, CATransform3DMakeTranslation(0.f, -50.f, 0.f)),
+                 @"Transform");
+    
+    [scrollView1 removeSynchronization];
+    GHAssertTrue(CATransform3DIsIdentity(scrollView2.layer.sublayerTransform), @"Transform reset");
+    
+    [masterScrollView removeSynchronization];
+}
+
+@end
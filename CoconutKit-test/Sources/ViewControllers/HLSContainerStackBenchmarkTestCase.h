@@ -0,0 +1,25 @@
+//
+//  HLSContainerStackBenchmarkTestCase.h
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 15.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Benchmarks for container transitions. View controllers are pushed and popped through a stack controller with each
+ * transition returned by +[HLSTransition availableTransitionNames], and the main thread time spent starting each
+ * transition ("commit time"), the frame durations and the memory high-water mark are recorded. Results are written
+ * as JSON to HLSContainerStackBenchmark.json in the application Documents directory when all benchmarks have been
+ * run, so that results can be compared between runs to catch regressions
+ */
+@interface HLSContainerStackBenchmarkTestCase : GHTestCase <HLSStackControllerDelegate> {
+@private
+    NSMutableArray *m_results;
+    NSMutableArray *m_frameDurations;
+    CFTimeInterval m_lastFrameTimestamp;
+    NSUInteger m_memoryHighWaterMark;
+    NSUInteger m_nbrPendingTransitions;
+}
+
+@end
@@ -0,0 +1,341 @@
+//
+//  HLSContainerStackBenchmarkTestCase.m
+//  CoconutKit-test
+//
+//  Created by Samuel Défago on 15.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSContainerStackBenchmarkTestCase.h"
+
+#import <mach/mach.h>
+
+// Maximum time a benchmark is allowed to wait for a transition to end
+static const NSTimeInterval kBenchmarkTimeoutInterval = 60.;
+
+// Number of view controllers pushed, then popped, for each transition
+static const NSUInteger kBenchmarkViewControllerCount = 5;
+
+// Transitions are shortened to keep the whole benchmark reasonably fast
+static const NSTimeInterval kBenchmarkTransitionDuration = 0.2;
+
+// Number of labels in the view of each view controller
+static const NSUInteger kBenchmarkLabelCount = 100;
+
+/**
+ * View controller whose view contains many labels, so that transitions have some work to do
+ */
+@interface HLSContainerStackBenchmarkViewController : UIViewController
+
+@end
+
+@implementation HLSContainerStackBenchmarkViewController
+
+- (void)loadView
+{
+    UIView *view = [[[UIView alloc] initWithFrame:[UIScreen mainScreen].applicationFrame] autorelease];
+    view.backgroundColor = [UIColor whiteColor];
+    view.autoresizingMask = HLSViewAutoresizingAll;
+    for (NSUInteger i = 0; i < kBenchmarkLabelCount; ++i) {
+        UILabel *label = [[[UILabel alloc] initWithFrame:CGRectMake(10.f + 150.f * (i / 20 % 2), 10.f + 20.f * (i % 20), 140.f, 20.f)] autorelease];
+        label.backgroundColor = [UIColor clearColor];
+        label.text = [NSString stringWithFormat:@"Label %d", i];
+        [view addSubview:label];
+    }
+    self.view = view;
+}
+
+@end
+
+@interface HLSContainerStackBenchmarkTestCase ()
+
+@property (nonatomic, retain) NSMutableArray *results;
+@property (nonatomic, retain) NSMutableArray *frameDurations;
+
+- (void)recordResultWithName:(NSString *)name
+                  parameters:(NSString *)parameters
+         viewControllerCount:(NSUInteger)viewControllerCount
+                       value:(double)value
+                        unit:(NSString *)unit;
+- (void)recordResultsForTransitionName:(NSString *)transitionName
+                             operation:(NSString *)operation
+                           commitTimes:(NSArray *)commitTimes;
+- (NSString *)resultsJSONString;
+
+- (void)startSampling;
+- (BOOL)waitUntilPendingTransitionsProcessed;
+- (double)percentile:(double)percentile ofValues:(NSArray *)values;
+- (NSUInteger)residentMemorySize;
+
+- (void)displayLinkFired:(CADisplayLink *)displayLink;
+
+@end
+
+@implementation HLSContainerStackBenchmarkTestCase
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.results = nil;
+    self.frameDurations = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize results = m_results;
+
+@synthesize frameDurations = m_frameDurations;
+
+#pragma mark Test setup and tear down
+
+- (BOOL)shouldRunOnMainThread
+{
+    // UIKit
+    return YES;
+}
+
+- (void)setUpClass
+{
+    [super setUpClass];
+    
+    self.results = [NSMutableArray array];
+    
+    [[HLSAnimationProfiler sharedAnimationProfiler] clear];
+    [HLSAnimationProfiler sharedAnimationProfiler].enabled = YES;
+}
+
+- (void)tearDownClass
+{
+    [HLSAnimationProfiler sharedAnimationProfiler].enabled = NO;
+    GHTestLog(@"%@", [[HLSAnimationProfiler sharedAnimationProfiler] reportForAnimationsWithTag:nil]);
+    [[HLSAnimationProfiler sharedAnimationProfiler] clear];
+    
+    NSString *resultsJSONString = [self resultsJSONString];
+    GHTestLog(@"%@", resultsJSONString);
+    
+    NSString *documentsDirectoryPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+    NSString *filePath = [documentsDirectoryPath stringByAppendingPathComponent:@"HLSContainerStackBenchmark.json"];
+    NSError *error = nil;
+    if (! [resultsJSONString writeToFile:filePath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+        HLSLoggerError(@"Could not write benchmark results to %@. Reason: %@", filePath, error);
+    }
+    else {
+        HLSLoggerInfo(@"Benchmark results written to %@", filePath);
+    }
+    
+    self.results = nil;
+    
+    [super tearDownClass];
+}
+
+#pragma mark Results
+
+- (void)recordResultWithName:(NSString *)name
+                  parameters:(NSString *)parameters
+         viewControllerCount:(NSUInteger)viewControllerCount
+                       value:(double)value
+                        unit:(NSString *)unit
+{
+    NSDictionary *result = [NSDictionary dictionaryWithObjectsAndKeys:name, @"name",
+                            parameters, @"parameters",
+                            [NSNumber numberWithUnsignedInteger:viewControllerCount], @"viewControllerCount",
+                            [NSNumber numberWithDouble:value], @"value",
+                            unit, @"unit",
+                            nil];
+    [self.results addObject:result];
+}
+
+- (void)recordResultsForTransitionName:(NSString *)transitionName
+                             operation:(NSString *)operation
+                           commitTimes:(NSArray *)commitTimes
+{
+    NSString *parameters = [NSString stringWithFormat:@"%@_%@", transitionName, operation];
+    [self recordResultWithName:@"commitTimeMedian"
+                    parameters:parameters
+           viewControllerCount:kBenchmarkViewControllerCount
+                         value:[self percentile:50. ofValues:commitTimes]
+                          unit:@"s"];
+    [self recordResultWithName:@"frameDurationMedian"
+                    parameters:parameters
+           viewControllerCount:kBenchmarkViewControllerCount
+                         value:[self percentile:50. ofValues:self.frameDurations]
+                          unit:@"s"];
+    [self recordResultWithName:@"frameDurationP95"
+                    parameters:parameters
+           viewControllerCount:kBenchmarkViewControllerCount
+                         value:[self percentile:95. ofValues:self.frameDurations]
+                          unit:@"s"];
+    [self recordResultWithName:@"frameDurationMax"
+                    parameters:parameters
+           viewControllerCount:kBenchmarkViewControllerCount
+                         value:[self percentile:100. ofValues:self.frameDurations]
+                          unit:@"s"];
+    [self recordResultWithName:@"memoryHighWaterMark"
+                    parameters:parameters
+           viewControllerCount:kBenchmarkViewControllerCount
+                         value:m_memoryHighWaterMark
+                          unit:@"bytes"];
+}
+
+// Names and parameters only contain plain identifiers, no escaping is needed
+- (NSString *)resultsJSONString
+{
+    NSMutableArray *resultStrings = [NSMutableArray arrayWithCapacity:[self.results count]];
+    for (NSDictionary *result in self.results) {
+        NSString *resultString = [NSString stringWithFormat:@"{\"name\":\"%@\",\"parameters\":\"%@\",\"viewControllerCount\":%@,\"value\":%.9f,\"unit\":\"%@\"}",
+                                  [result objectForKey:@"name"],
+                                  [result objectForKey:@"parameters"],
+                                  [result objectForKey:@"viewControllerCount"],
+                                  [[result objectForKey:@"value"] doubleValue],
+                                  [result objectForKey:@"unit"]];
+        [resultStrings addObject:resultString];
+    }
+    return [NSString stringWithFormat:@"{\"benchmarks\":[%@]}", [resultStrings componentsJoinedByString:@","]];
+}
+
+#pragma mark Helpers
+
+- (void)startSampling
+{
+    self.frameDurations = [NSMutableArray array];
+    m_lastFrameTimestamp = 0.;
+    m_memoryHighWaterMark = [self residentMemorySize];
+}
+
+// Run the main run loop until all pending transitions have ended. Return NO on timeout
+- (BOOL)waitUntilPendingTransitionsProcessed
+{
+    NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:kBenchmarkTimeoutInterval];
+    while (m_nbrPendingTransitions != 0) {
+        if ([timeoutDate timeIntervalSinceNow] < 0.) {
+            return NO;
+        }
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    return YES;
+}
+
+// Nearest-rank percentile of an array of NSNumber objects
+- (double)percentile:(double)percentile ofValues:(NSArray *)values
+{
+    if ([values count] == 0) {
+        return 0.;
+    }
+    
+    NSArray *sortedValues = [values sortedArrayUsingSelector:@selector(compare:)];
+    NSUInteger rank = (NSUInteger)ceil(percentile / 100. * [sortedValues count]);
+    NSUInteger index = (rank == 0) ? 0 : MIN(rank - 1, [sortedValues count] - 1);
+    return [[sortedValues objectAtIndex:index] doubleValue];
+}
+
+- (NSUInteger)residentMemorySize
+{
+    struct task_basic_info info;
+    mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
+
+#pragma mark Benchmarks
+
+- (void)testPushAndPopTransitions
+{
+    UIWindow *window = [UIApplication sharedApplication].keyWindow;
+    GHAssertNotNil(window, @"A key window is required to display transitions");
+    
+    // Frames are sampled while transitions are running
+    CADisplayLink *displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkFired:)];
+    [displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    
+    for (NSString *transitionName in [HLSTransition availableTransitionNames]) {
+        Class transitionClass = NSClassFromString(transitionName);
+        
+        HLSContainerStackBenchmarkViewController *rootViewController = [[[HLSContainerStackBenchmarkViewController alloc] init] autorelease];
+        HLSStackController *stackController = [[[HLSStackController alloc] initWithRootViewController:rootViewController] autorelease];
+        stackController.delegate = self;
+        
+        // The stack controller is not the child of any view controller, appearance events must be sent manually
+        stackController.view.frame = window.bounds;
+        [stackController viewWillAppear:NO];
+        [window addSubview:stackController.view];
+        [stackController viewDidAppear:NO];
+        
+        NSMutableArray *pushCommitTimes = [NSMutableArray arrayWithCapacity:kBenchmarkViewControllerCount];
+        [self startSampling];
+        for (NSUInteger i = 0; i < kBenchmarkViewControllerCount; ++i) {
+            HLSContainerStackBenchmarkViewController *viewController = [[[HLSContainerStackBenchmarkViewController alloc] init] autorelease];
+            
+            m_nbrPendingTransitions = 1;
+            CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+            [stackController pushViewController:viewController
+                            withTransitionClass:transitionClass
+                                       duration:kBenchmarkTransitionDuration
+                                       animated:YES];
+            [pushCommitTimes addObject:[NSNumber numberWithDouble:CFAbsoluteTimeGetCurrent() - startTime]];
+            GHAssertTrue([self waitUntilPendingTransitionsProcessed], @"Push with %@ not finished in time", transitionName);
+        }
+        [self recordResultsForTransitionName:transitionName operation:@"push" commitTimes:pushCommitTimes];
+        
+        NSMutableArray *popCommitTimes = [NSMutableArray arrayWithCapacity:kBenchmarkViewControllerCount];
+        [self startSampling];
+        for (NSUInteger i = 0; i < kBenchmarkViewControllerCount; ++i) {
+            m_nbrPendingTransitions = 1;
+            CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+            [stackController popViewControllerAnimated:YES];
+            [popCommitTimes addObject:[NSNumber numberWithDouble:CFAbsoluteTimeGetCurrent() - startTime]];
+            GHAssertTrue([self waitUntilPendingTransitionsProcessed], @"Pop with %@ not finished in time", transitionName);
+        }
+        [self recordResultsForTransitionName:transitionName operation:@"pop" commitTimes:popCommitTimes];
+        
+        [stackController viewWillDisappear:NO];
+        [stackController.view removeFromSuperview];
+        [stackController viewDidDisappear:NO];
+        stackController.delegate = nil;
+    }
+    
+    // The display link retains its target
+    [displayLink invalidate];
+    self.frameDurations = nil;
+}
+
+#pragma mark Display link callback
+
+- (void)displayLinkFired:(CADisplayLink *)displayLink
+{
+    if (m_nbrPendingTransitions == 0) {
+        m_lastFrameTimestamp = 0.;
+        return;
+    }
+    
+    if (! doubleeq(m_lastFrameTimestamp, 0.)) {
+        [self.frameDurations addObject:[NSNumber numberWithDouble:displayLink.timestamp - m_lastFrameTimestamp]];
+    }
+    m_lastFrameTimestamp = displayLink.timestamp;
+    
+    m_memoryHighWaterMark = MAX(m_memoryHighWaterMark, [self residentMemorySize]);
+}
+
+#pragma mark HLSStackControllerDelegate protocol implementation
+
+- (void)stackController:(HLSStackController *)stackController
+  didPushViewController:(UIViewController *)pushedViewController
+    coverViewController:(UIViewController *)coveredViewController
+               animated:(BOOL)animated
+{
+    --m_nbrPendingTransitions;
+}
+
+- (void)stackController:(HLSStackController *)stackController
+   didPopViewController:(UIViewController *)poppedViewController
+   revealViewController:(UIViewController *)revealedViewController
+               animated:(BOOL)animated
+{
+    --m_nbrPendingTransitions;
+}
+
+@end
@@ -7,6 +7,7 @@
 //
 
 HLSEnableNSManagedObjectValidation()
+HLSEnableUILabelDynamicLocalization()
 
 int main(int argc, char *argv[])
 {
@@ -0,0 +1,34 @@
+//
+//  HLSAnimation+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSAnimation.h"
+
+/**
+ * Interface meant to be used by friend classes of HLSAnimation (= classes which must have access to private implementation
+ * details)
+ */
+@interface HLSAnimation (Friend)
+
+/**
+ * Return an animation with the same settings and steps as the receiver, but animating other objects. This makes it 
+ * possible to build an animation once for placeholder objects, and to cheaply bind it to concrete objects later. The 
+ * dictionary maps the keys of objects to be replaced ([NSValue valueWithPointer:object]) to their replacement objects 
+ * (or [NSNull null] if the corresponding animations must be removed). Objects which do not appear in the dictionary 
+ * are kept as is
+ *
+ * The object animations are shared with the receiver, not copied
+ */
+- (HLSAnimation *)animationBySubstitutingObjects:(NSDictionary *)objectKeyToSubstituteObjectMap;
+
+/**
+ * Notify the delegate that an animation step has ended. Called by the animation scheduler when delivering batched
+ * notifications. Nothing happens if the animation has been cancelled or has ended in the meantime
+ */
+- (void)deliverDidFinishAnimationStep:(HLSAnimationStep *)animationStep animated:(BOOL)animated;
+
+@end
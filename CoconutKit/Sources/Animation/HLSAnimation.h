@@ -9,6 +9,7 @@
 #import "HLSAnimationStep.h"
 
 // Forward declarations
+@class HLSUserInterfaceLockToken;
 @class HLSZeroingWeakRef;
 @protocol HLSAnimationDelegate;
 
@@ -61,24 +62,41 @@
 @private
     NSArray *m_animationSteps;                                      // a copy of the HLSAnimationSteps passed at initialization time
     NSArray *m_animationStepCopies;                                 // another copy made temporarily during animation
+    NSArray *m_reverseAnimationSteps;                               // cached steps of the reverse animation
+    NSArray *m_loopAnimationSteps;                                  // cached steps of the loop animation
     NSEnumerator *m_animationStepsEnumerator;                       // enumerator over steps
     HLSAnimationStep *m_currentAnimationStep;                       // the currently played animation step
     NSString *m_tag;
     NSDictionary *m_userInfo;
     BOOL m_lockingUI;
+    HLSUserInterfaceLockToken *m_userInterfaceLockToken;            // keeps the UI locked while the animation is played (if lockingUI)
+    BOOL m_compilingLayerAnimationSteps;
+    BOOL m_automaticallyRasterizingLayers;
+    BOOL m_recyclingAnimationSteps;
     BOOL m_animated;
     NSUInteger m_repeatCount;
     NSUInteger m_currentRepeatCount;
     NSTimeInterval m_remainingTimeBeforeStart;                      // the time remaining before the start time is reached
     NSTimeInterval m_elapsedTime;                                   // the currently elapsed time (does not include pauses)
+    NSTimeInterval m_currentStepStartTime;                          // the time at which the current step was started
+    NSTimeInterval m_currentStepTime;                               // the time elapsed in the current step, driven by the animation clock
+    CFTimeInterval m_lastClockTimestamp;
+    CFTimeInterval m_plannedStepStartTime;                          // the time at which the next step should start (profiling)
+    CFTimeInterval m_pauseStartTime;
+    float m_rate;
     BOOL m_runningBeforeEnteringBackground;                         // was the animation running before the application entered background?
     BOOL m_pausedBeforeEnteringBackground;                          // was the animation paused before the application entered background?
     BOOL m_running;
     BOOL m_playing;
     BOOL m_started;
     BOOL m_cancelling;
+    BOOL m_interrupting;
     BOOL m_terminating;
     HLSZeroingWeakRef *m_delegateZeroingWeakRef;
+    HLSZeroingWeakRef *m_scrollViewZeroingWeakRef;                  // the scroll view a scroll-linked animation is bound to
+    CGPoint m_startContentOffset;
+    CGPoint m_endContentOffset;
+    BOOL m_scrollLinked;
 }
 
 /**
@@ -88,6 +106,11 @@
 + (HLSAnimation *)animationWithAnimationSteps:(NSArray *)animationSteps;
 + (HLSAnimation *)animationWithAnimationStep:(HLSAnimationStep *)animationStep;
 
+/**
+ * Return the number of animations currently running (see the running property). Must be called from the main thread
+ */
++ (NSUInteger)runningAnimationCount;
+
 /**
  * Create an animation using HLSAnimationStep objects. Those steps will be chained together when the animation
  * is played. If nil is provided, an empty animation is created (such animations still fire -animationWillStart:animated:
@@ -116,6 +139,41 @@
  */
 @property (nonatomic, assign) BOOL lockingUI;
 
+/**
+ * If set to YES, each sequence of consecutive layer animation steps is compiled into a single animation group per layer
+ * when the animation is played, the animations of each step being offset in time. Core Animation then plays the whole
+ * sequence at once, without the main thread being involved at step boundaries. The -animation:didFinishStep:animated:
+ * delegate method is still called for each step, based on timestamps. View animation steps and layer animation steps 
+ * with a zero duration are not compiled and are played as usual
+ *
+ * Default is NO
+ */
+@property (nonatomic, assign) BOOL compilingLayerAnimationSteps;
+
+/**
+ * If set to YES, complex layer trees (with many sublayers, or requiring offscreen rendering because of masks, rounded
+ * corners or shadows without a path) animated by a step are rasterized at screen scale while the step is played animated,
+ * and their original settings are restored at the end of the step. Layers which are already rasterized, whose rasterization
+ * settings are animated, or whose content changes during the step (resized views, animated sublayer transforms) are left
+ * untouched
+ *
+ * Default is NO
+ */
+@property (nonatomic, assign) BOOL automaticallyRasterizingLayers;
+
+/**
+ * An animation plays copies of its steps. If set to YES, those copies are not deallocated at the end of the animation,
+ * but recycled into a pool from which later step copies are taken (copies of the steps of an animation often played,
+ * e.g. for table view cells, are then not allocated over and over again). Only the copies played during the last run
+ * of animations which ended normally (i.e. which have not been cancelled, terminated or interrupted) are recycled
+ *
+ * If you enable this setting, you must not keep any reference to the steps received by the -animation:didFinishStep:animated:
+ * delegate method, since they might be reused later
+ *
+ * Default is NO
+ */
+@property (nonatomic, assign) BOOL recyclingAnimationSteps;
+
 /**
  * The animation delegate. Note that the animation is automatically cancelled if a delegate has been set
  * and gets deallocated while the animation is runnning
@@ -185,12 +243,81 @@
  */
 - (void)resume;
 
+/**
+ * Move a running animation played animated (paused or not) to the specified time within the current repetition (between
+ * 0 and the duration of the animation). If this time belongs to the Core Animation-based step currently played, this step
+ * is moved in time without being rebuilt, which makes this method suitable for scrubbing, especially for animations
+ * whose layer steps are compiled (see compilingLayerAnimationSteps). Otherwise the animation is replayed from the
+ * specified time. Delegate events which would have occurred prior to the new time are not received
+ */
+- (void)seekToTime:(NSTimeInterval)time;
+
+/**
+ * The rate at which the animation is played (1 for normal speed, must be > 0). Can be changed at any time, even while
+ * the animation is running. The rate is not applied to UIView-based animation steps, which are always played at normal
+ * speed
+ *
+ * Default value is 1
+ */
+@property (nonatomic, assign) float rate;
+
+/**
+ * The time elapsed within the current repetition of a running animation (0 if the animation is not running). The initial
+ * delay and pauses are not included
+ */
+@property (nonatomic, readonly, assign) NSTimeInterval currentTime;
+
+/**
+ * Bind the animation to the content offset of a scroll view, instead of playing it over time: The animation is at its
+ * beginning when the content offset is startContentOffset, at its end when it is endContentOffset, and in between
+ * proportionally to the position of the content offset along the segment joining them (offsets beyond either end are
+ * clamped). This is the way to go for parallax or collapsing header effects
+ *
+ * All layer animation steps of the animation are attached at once to their layers, in a single paused animation group
+ * per layer (which is why the animation must only be made of layer animation steps with non-zero durations). Call
+ * -updateScrollLinkedTime when the scroll view scrolls (typically from -scrollViewDidScroll:): Each call only moves
+ * the paused animations in time, i.e. a single timeOffset change per animated layer, without any animation rebuild or
+ * scroll view subclassing. The rest is left to the render server
+ *
+ * The animation is running while linked. -animationWillStart:animated: is received when the animation is linked, and
+ * -animation:didFinishStep:animated: when the content offset reaches the end of a step (except for the last one). Unlink 
+ * the animation by calling -cancel, -terminate (both restoring the end state) or -interrupt (leaving layers as they 
+ * currently appear). The animation is interrupted if the scroll view is deallocated. The scroll view is not retained. 
+ * While linked, the animation cannot be paused, resumed, or moved in time with -seekToTime:, and its rate is ignored.
+ * The UI is never locked, even if lockingUI is set to YES
+ */
+- (void)linkToScrollView:(UIScrollView *)scrollView startContentOffset:(CGPoint)startContentOffset endContentOffset:(CGPoint)endContentOffset;
+
+/**
+ * Move a scroll-linked animation in time according to the current content offset of its scroll view. Does nothing
+ * if the animation is not scroll-linked
+ */
+- (void)updateScrollLinkedTime;
+
+/**
+ * Return YES iff the animation is currently bound to a scroll view
+ */
+@property (nonatomic, readonly, assign, getter=isScrollLinked) BOOL scrollLinked;
+
 /**
  * Cancel the animation. The animation immediately reaches its end state. The delegate does not receive subsequent
  * events
  */
 - (void)cancel;
 
+/**
+ * Interrupt the animation. Unlike -cancel, the animated objects are left where they currently appear on screen, and 
+ * the steps which have not been played yet are dropped. A new animation can then be started from this state without
+ * any visual discontinuity, e.g. for retargeting an animation when the user quickly interacts again with a control
+ * before the animation triggered by a previous interaction is over. As with -cancel, the delegate does not receive
+ * subsequent events
+ *
+ * For view animation steps, the current frame and alpha are kept. For layer animation steps, all properties animated
+ * by layer animations are kept (if a sublayer camera translation was running, pursuing sublayer transform animations
+ * might not be perfectly accurate)
+ */
+- (void)interrupt;
+
 /**
  * Terminate the animation. The animation immediately reaches its end state. The delegate still receives all
  * subsequent events, but with animated = NO
@@ -252,6 +379,9 @@
  * Generate the reverse animation; all attributes are copied as is, except that all tags for the animation and
  * animation steps get and additional "reverse_" prefix. If a tag has not been filled for the receiver, the
  * corresponding tag of the reverse animation is nil
+ *
+ * The reverse animation steps are calculated once and shared by all reverse animations generated from the receiver,
+ * so that calling this method repeatedly is cheap
  */
 - (HLSAnimation *)reverseAnimation;
 
@@ -260,6 +390,8 @@
  * copied as is, except that all tags for the animation and animation steps get and additional "loop_" prefix
  * (reverse animation steps therefore begin with a "loop_reverse_" prefix). If a tag has not been filled for
  * the receiver, the corresponding tag of the reverse animation is nil
+ *
+ * As for -reverseAnimation, the loop animation steps are calculated once and shared
  */
 - (HLSAnimation *)loopAnimation;
 
@@ -8,17 +8,26 @@
 
 #import "HLSAnimation.h"
 
+#import "HLSAnimation+Friend.h"
+#import "HLSAnimationClock.h"
+#import "HLSAnimationProfiler+Friend.h"
+#import "HLSAnimationScheduler+Friend.h"
 #import "HLSAnimationStep+Friend.h"
 #import "HLSAssert.h"
 #import "HLSConverters.h"
 #import "HLSFloat.h"
 #import "HLSLayerAnimationStep.h"
+#import "HLSLayerAnimationStep+Friend.h"
+#import "HLSLayerAnimationTimelineStep.h"
 #import "HLSLogger.h"
 #import "HLSUserInterfaceLock.h"
 #import "HLSZeroingWeakRef.h"
 #import "NSArray+HLSExtensions.h"
 #import "NSString+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
+
 /**
  * HLSAnimation does not provide any safety measures against non-integral frames (which ultimately lead to blurry
  * views). The reason is that fixing such issues in an automatic way would make reverse animations difficult to
@@ -28,20 +37,32 @@
 
 static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
-@interface HLSAnimation () <HLSAnimationStepDelegate>
+// Scroll-linked animations are kept slightly before their end, so that their paused animation groups are never completed
+// (and therefore removed) by Core Animation
+static const NSTimeInterval kScrollLinkedAnimationEndMargin = 0.001;
+
+static NSUInteger s_runningAnimationCount = 0;
+
+@interface HLSAnimation () <HLSAnimationStepDelegate, HLSAnimationClockObserver>
 
 + (NSArray *)duplicateAnimationSteps:(NSArray *)animationSteps;
++ (HLSAnimation *)animationWithSharedAnimationSteps:(NSArray *)animationSteps;
 
 @property (nonatomic, retain) NSArray *animationSteps;
 @property (nonatomic, retain) NSArray *animationStepCopies;
+@property (nonatomic, retain) NSArray *reverseAnimationSteps;
+@property (nonatomic, retain) NSArray *loopAnimationSteps;
 @property (nonatomic, retain) NSEnumerator *animationStepsEnumerator;
 @property (nonatomic, retain) HLSAnimationStep *currentAnimationStep;
 @property (nonatomic, assign, getter=isRunning) BOOL running;
 @property (nonatomic, assign, getter=isPlaying) BOOL playing;
 @property (nonatomic, assign, getter=isStarted) BOOL started;
 @property (nonatomic, assign, getter=isCancelling) BOOL cancelling;
+@property (nonatomic, assign, getter=isInterrupting) BOOL interrupting;
 @property (nonatomic, assign, getter=isTerminating) BOOL terminating;
 @property (nonatomic, retain) HLSZeroingWeakRef *delegateZeroingWeakRef;
+@property (nonatomic, retain) HLSZeroingWeakRef *scrollViewZeroingWeakRef;
+@property (nonatomic, retain) HLSUserInterfaceLockToken *userInterfaceLockToken;
 
 - (void)playWithStartTime:(NSTimeInterval)startTime
               repeatCount:(NSUInteger)repeatCount
@@ -51,8 +72,9 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
 - (void)playAnimationStep:(HLSAnimationStep *)animationStep animated:(BOOL)animated;
 - (void)playNextAnimationStepAnimated:(BOOL)animated;
+- (void)recycleAnimationStepCopies;
 
-- (NSArray *)reverseAnimationSteps;
+- (void)notifyDidFinishAnimationStep:(HLSAnimationStep *)animationStep animated:(BOOL)animated;
 
 - (void)applicationDidEnterBackground:(NSNotification *)notification;
 - (void)applicationWillEnterForeground:(NSNotification *)notification;
@@ -77,6 +99,11 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     return [HLSAnimation animationWithAnimationSteps:animationSteps];
 }
 
++ (NSUInteger)runningAnimationCount
+{
+    return s_runningAnimationCount;
+}
+
 + (NSArray *)duplicateAnimationSteps:(NSArray *)animationSteps
 {
     NSMutableArray *animationStepCopies = [NSMutableArray array];
@@ -86,6 +113,15 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     return [NSArray arrayWithArray:animationStepCopies];
 }
 
++ (HLSAnimation *)animationWithSharedAnimationSteps:(NSArray *)animationSteps
+{
+    // Animation steps are never altered once assigned to an animation (they are only played through copies), and can
+    // therefore be shared between animations without being copied
+    HLSAnimation *animation = [[[HLSAnimation alloc] initWithAnimationSteps:nil] autorelease];
+    animation.animationSteps = animationSteps;
+    return animation;
+}
+
 #pragma mark Object creation and destruction
 
 - (id)initWithAnimationSteps:(NSArray *)animationSteps
@@ -99,6 +135,8 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
             self.animationSteps = [HLSAnimation duplicateAnimationSteps:animationSteps];
         }
         
+        m_rate = 1.f;
+        
         [[NSNotificationCenter defaultCenter] addObserver:self
                                                  selector:@selector(applicationDidEnterBackground:)
                                                      name:UIApplicationDidEnterBackgroundNotification
@@ -128,13 +166,19 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     
     [self cancel];
     
+    [[HLSAnimationClock sharedAnimationClock] removeObserver:self];
+    
     self.animationSteps = nil;
     self.animationStepCopies = nil;
+    self.reverseAnimationSteps = nil;
+    self.loopAnimationSteps = nil;
     self.animationStepsEnumerator = nil;
     self.currentAnimationStep = nil;
     self.tag = nil;
     self.userInfo = nil;
     self.delegateZeroingWeakRef = nil;
+    self.scrollViewZeroingWeakRef = nil;
+    self.userInterfaceLockToken = nil;
     
     [super dealloc];
 }
@@ -145,6 +189,39 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
 @synthesize animationStepCopies = m_animationStepCopies;
 
+@synthesize reverseAnimationSteps = m_reverseAnimationSteps;
+
+- (NSArray *)reverseAnimationSteps
+{
+    if (! m_reverseAnimationSteps) {
+        NSMutableArray *reverseAnimationSteps = [NSMutableArray array];
+        for (HLSAnimationStep *animationStep in [self.animationSteps reverseObjectEnumerator]) {
+            [reverseAnimationSteps addObject:[animationStep reverseAnimationStep]];
+        }
+        self.reverseAnimationSteps = [NSArray arrayWithArray:reverseAnimationSteps];
+    }
+    return m_reverseAnimationSteps;
+}
+
+@synthesize loopAnimationSteps = m_loopAnimationSteps;
+
+- (NSArray *)loopAnimationSteps
+{
+    if (! m_loopAnimationSteps) {
+        // Work on copies, the steps of the receiver and of its reverse animation are shared and must not be altered
+        NSMutableArray *loopAnimationSteps = [NSMutableArray arrayWithArray:[HLSAnimation duplicateAnimationSteps:self.animationSteps]];
+        [loopAnimationSteps addObjectsFromArray:[HLSAnimation duplicateAnimationSteps:self.reverseAnimationSteps]];
+        
+        // Add a loop_ prefix to all animation step tags
+        for (HLSAnimationStep *animationStep in loopAnimationSteps) {
+            animationStep.tag = [animationStep.tag isFilled] ? [NSString stringWithFormat:@"loop_%@", animationStep.tag] : nil;
+        }
+        
+        self.loopAnimationSteps = [NSArray arrayWithArray:loopAnimationSteps];
+    }
+    return m_loopAnimationSteps;
+}
+
 @synthesize animationStepsEnumerator = m_animationStepsEnumerator;
 
 @synthesize currentAnimationStep = m_currentAnimationStep;
@@ -155,8 +232,30 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
 @synthesize lockingUI = m_lockingUI;
 
+@synthesize compilingLayerAnimationSteps = m_compilingLayerAnimationSteps;
+
+@synthesize automaticallyRasterizingLayers = m_automaticallyRasterizingLayers;
+
+@synthesize recyclingAnimationSteps = m_recyclingAnimationSteps;
+
 @synthesize running = m_running;
 
+- (void)setRunning:(BOOL)running
+{
+    if (running == m_running) {
+        return;
+    }
+    
+    m_running = running;
+    
+    if (running) {
+        ++s_runningAnimationCount;
+    }
+    else {
+        --s_runningAnimationCount;
+    }
+}
+
 @synthesize playing = m_playing;
 
 @synthesize started = m_started;
@@ -168,10 +267,18 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
 @synthesize cancelling = m_cancelling;
 
+@synthesize interrupting = m_interrupting;
+
 @synthesize terminating = m_terminating;
 
+@synthesize userInterfaceLockToken = m_userInterfaceLockToken;
+
 @synthesize delegateZeroingWeakRef = m_delegateZeroingWeakRef;
 
+@synthesize scrollViewZeroingWeakRef = m_scrollViewZeroingWeakRef;
+
+@synthesize scrollLinked = m_scrollLinked;
+
 - (id<HLSAnimationDelegate>)delegate
 {
     return self.delegateZeroingWeakRef.object;
@@ -183,6 +290,36 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     [self.delegateZeroingWeakRef addCleanupAction:@selector(cancel) onTarget:self];
 }
 
+@synthesize rate = m_rate;
+
+- (void)setRate:(float)rate
+{
+    if (floatle(rate, 0.f)) {
+        HLSLoggerError(@"The rate must be > 0");
+        return;
+    }
+    
+    m_rate = rate;
+    
+    if (self.running) {
+        self.currentAnimationStep.rate = rate;
+    }
+}
+
+- (NSTimeInterval)currentTime
+{
+    if (! self.running) {
+        return 0.;
+    }
+    
+    if ([self.currentAnimationStep.tag isEqualToString:kDelayLayerAnimationTag]) {
+        return m_elapsedTime;
+    }
+    else {
+        return m_elapsedTime + m_currentStepTime;
+    }
+}
+
 - (NSTimeInterval)duration
 {
     NSTimeInterval duration = 0.;
@@ -271,16 +408,28 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
                 
         self.running = YES;
         self.playing = YES;
+        
+        m_plannedStepStartTime = CACurrentMediaTime();
+        
+        // The animation clock drives the time of animations played animated
+        if (animated) {
+            [[HLSAnimationClock sharedAnimationClock] addObserver:self];
+        }
     
         // Lock the UI during the animation
         if (self.lockingUI) {
-            [[HLSUserInterfaceLock sharedUserInterfaceLock] lock];
+            self.userInterfaceLockToken = [[HLSUserInterfaceLock sharedUserInterfaceLock] lockToken];
         }
     }
     
+    HLSLoggerSpanBegin(span, "HLSAnimation play");
+    
     // Animation steps carry state information. To avoid issues when playing the same animation step several times (most
     // notably when repeatCount > 1), we work on a deep copy of them
     self.animationStepCopies = [HLSAnimation duplicateAnimationSteps:self.animationSteps];
+    if (self.compilingLayerAnimationSteps) {
+        self.animationStepCopies = [HLSLayerAnimationTimelineStep animationStepsByCompilingLayerAnimationSteps:self.animationStepCopies];
+    }
         
     m_animated = animated;
     m_repeatCount = repeatCount;
@@ -306,6 +455,8 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     // if they occur during the initial delay period
     self.currentAnimationStep = delayAnimationStep;
     [self playAnimationStep:delayAnimationStep animated:animated];
+    
+    HLSLoggerSpanEnd(span);
 }
 
 - (void)playAnimationStep:(HLSAnimationStep *)animationStep animated:(BOOL)animated
@@ -315,13 +466,43 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     // animation steps instantaneously to reach the start time)
     if (doublegt(m_remainingTimeBeforeStart, animationStep.duration)) {
         m_remainingTimeBeforeStart -= animationStep.duration;
+        m_currentStepStartTime = 0.;
+        m_currentStepTime = 0.;
         [animationStep playWithDelegate:self startTime:0. animated:NO];
     }
     // Play the incomplete animation step, starting where appropriate
     else {
         NSTimeInterval remainingTimeBeforeStart = m_remainingTimeBeforeStart;
         m_remainingTimeBeforeStart = 0.;
+        m_currentStepStartTime = remainingTimeBeforeStart;
+        m_currentStepTime = remainingTimeBeforeStart;
+        m_lastClockTimestamp = CACurrentMediaTime();
+        animationStep.rate = self.rate;
+        animationStep.automaticallyRasterizingLayers = self.automaticallyRasterizingLayers;
+        
+        CFTimeInterval actualStartTime = CACurrentMediaTime();
         [animationStep playWithDelegate:self startTime:remainingTimeBeforeStart animated:animated];
+        
+        // Steps with nothing left to play end synchronously and do not take any time
+        if (animated && ! doubleeq(animationStep.duration - remainingTimeBeforeStart, 0.)) {
+            // Each step should start when the previous one should have ended
+            NSTimeInterval plannedDuration = (animationStep.duration - remainingTimeBeforeStart) * [HLSLayerAnimationStep animationDurationFactor];
+            if (animationStep.seekable) {
+                plannedDuration /= self.rate;
+            }
+            CFTimeInterval plannedStartTime = m_plannedStepStartTime;
+            m_plannedStepStartTime += plannedDuration;
+            
+            HLSAnimationProfiler *animationProfiler = [HLSAnimationProfiler sharedAnimationProfiler];
+            if (animationProfiler.enabled && ! [animationStep.tag isEqualToString:kDelayLayerAnimationTag]) {
+                [animationProfiler animation:self
+                       didStartAnimationStep:animationStep
+                            plannedStartTime:plannedStartTime
+                              plannedEndTime:m_plannedStepStartTime
+                             actualStartTime:actualStartTime
+                              commitDuration:CACurrentMediaTime() - actualStartTime];
+            }
+        }
     }
 }
 
@@ -332,8 +513,8 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
         self.animationStepsEnumerator = [self.animationStepCopies objectEnumerator];
     }
     
-    // Proceeed with the next step (if any)
-    self.currentAnimationStep = [self.animationStepsEnumerator nextObject];
+    // Proceeed with the next step (if any). Remaining steps are dropped when the animation is interrupted
+    self.currentAnimationStep = self.interrupting ? nil : [self.animationStepsEnumerator nextObject];
     if (self.currentAnimationStep) {
         [self playAnimationStep:self.currentAnimationStep animated:animated];
     }
@@ -354,25 +535,40 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
         // behavior here
         ++m_currentRepeatCount;
         
-        if ((m_repeatCount == NSUIntegerMax && (self.terminating || self.cancelling))
+        if (self.interrupting
+                || (m_repeatCount == NSUIntegerMax && (self.terminating || self.cancelling))
                 || (m_repeatCount != NSUIntegerMax && m_currentRepeatCount == m_repeatCount)) {
             // Unlock the UI
-            if (self.lockingUI) {
-                [[HLSUserInterfaceLock sharedUserInterfaceLock] unlock];
-            }
+            [self.userInterfaceLockToken unlock];
+            self.userInterfaceLockToken = nil;
             
             self.started = NO;
             self.playing = NO;
             
+            // Step end notifications still pending must be delivered before the end of the animation is
+            HLSAnimationScheduler *animationScheduler = [HLSAnimationScheduler sharedAnimationScheduler];
             if (! self.cancelling) {
+                [animationScheduler flushNotificationsForAnimation:self];
                 if ([self.delegate respondsToSelector:@selector(animationDidStop:animated:)]) {
                     [self.delegate animationDidStop:self animated:self.terminating ? NO : animated];
                 }
             }
+            else {
+                [animationScheduler discardNotificationsForAnimation:self];
+            }
+            
+            // All step end notifications have been delivered, the step copies are not needed anymore
+            if (self.recyclingAnimationSteps && ! self.cancelling && ! self.terminating && ! self.interrupting) {
+                [self recycleAnimationStepCopies];
+            }
             
             // End of the animation
+            [[HLSAnimationClock sharedAnimationClock] removeObserver:self];
+            self.scrollViewZeroingWeakRef = nil;
+            m_scrollLinked = NO;
             self.running = NO;
             self.cancelling = NO;
+            self.interrupting = NO;
             self.terminating = NO;
         }    
         // Repeat as needed
@@ -386,6 +582,15 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     }
 }
 
+- (void)recycleAnimationStepCopies
+{
+    // Timeline steps recycle the layer animation steps they play
+    for (HLSAnimationStep *animationStepCopy in self.animationStepCopies) {
+        [animationStepCopy recycle];
+    }
+    self.animationStepCopies = nil;
+}
+
 - (void)pause
 {
     if (! self.running) {
@@ -404,16 +609,230 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     }
     
     [self.currentAnimationStep pause];
+    
+    m_pauseStartTime = CACurrentMediaTime();
 }
 
 - (void)resume
 {
+    if (self.scrollLinked) {
+        HLSLoggerDebug(@"The animation is scroll-linked and cannot be resumed");
+        return;
+    }
+    
     if (! self.paused) {
         HLSLoggerDebug(@"The animation has not being paused. Nothing to resume");
         return;
     }
     
     [self.currentAnimationStep resume];
+    
+    // Pauses are not taken into account when profiling
+    NSTimeInterval pauseDuration = CACurrentMediaTime() - m_pauseStartTime;
+    m_plannedStepStartTime += pauseDuration;
+    
+    HLSAnimationProfiler *animationProfiler = [HLSAnimationProfiler sharedAnimationProfiler];
+    if (animationProfiler.enabled) {
+        [animationProfiler animation:self didResumeAfterPauseDuration:pauseDuration];
+    }
+}
+
+- (void)seekToTime:(NSTimeInterval)time
+{
+    if (! self.running || ! m_animated) {
+        HLSLoggerDebug(@"The animation is not running animated, cannot seek");
+        return;
+    }
+    
+    if (self.scrollLinked) {
+        HLSLoggerDebug(@"The animation is scroll-linked, its time is driven by the content offset of its scroll view");
+        return;
+    }
+    
+    if (self.cancelling || self.terminating) {
+        HLSLoggerDebug(@"The animation is being cancelled or terminated");
+        return;
+    }
+    
+    if (doublelt(time, 0.)) {
+        HLSLoggerWarn(@"The time cannot be negative. Fixed to 0");
+        time = 0.;
+    }
+    else if (doublegt(time, [self duration])) {
+        HLSLoggerWarn(@"The time %.2f is larger than the animation duration %.2f. Set to the duration", time, [self duration]);
+        time = [self duration];
+    }
+    
+    // If the time belongs to the current step (and to the part of it which has actually been played), simply move
+    // the step in time. Reached timeline steps are reported when the clock ticks
+    HLSAnimationStep *animationStep = self.currentAnimationStep;
+    NSTimeInterval stepTime = time - m_elapsedTime;
+    if (! [animationStep.tag isEqualToString:kDelayLayerAnimationTag] && [animationStep isSeekable]
+            && doublege(stepTime, m_currentStepStartTime) && doublelt(stepTime, animationStep.duration)) {
+        CGFloat animationDurationFactor = [HLSLayerAnimationStep animationDurationFactor];
+        [animationStep offsetAnimationByTimeInterval:(stepTime - m_currentStepTime) * animationDurationFactor];
+        
+        if ([animationStep isKindOfClass:[HLSLayerAnimationTimelineStep class]]) {
+            HLSLayerAnimationTimelineStep *timelineStep = (HLSLayerAnimationTimelineStep *)animationStep;
+            [timelineStep rewindToElapsedTime:stepTime];
+        }
+        
+        m_currentStepTime = stepTime;
+        return;
+    }
+    
+    // Otherwise replay the animation from the specified time (same strategy as when the application enters background,
+    // see -applicationDidEnterBackground:)
+    BOOL paused = self.paused;
+    NSUInteger repeatCount = m_repeatCount;
+    
+    [self cancel];
+    
+    HLSAnimation *reverseAnimation = [self reverseAnimation];
+    reverseAnimation.delegate = nil;
+    [reverseAnimation playAnimated:NO];
+    
+    [self playWithStartTime:time repeatCount:repeatCount];
+    if (paused) {
+        [self pause];
+    }
+}
+
+#pragma mark Scroll-linked animation
+
+- (void)linkToScrollView:(UIScrollView *)scrollView startContentOffset:(CGPoint)startContentOffset endContentOffset:(CGPoint)endContentOffset
+{
+    if (! scrollView) {
+        HLSLoggerError(@"Missing scroll view");
+        return;
+    }
+    
+    if (CGPointEqualToPoint(startContentOffset, endContentOffset)) {
+        HLSLoggerError(@"The start and end content offsets must be different");
+        return;
+    }
+    
+    if (self.running) {
+        HLSLoggerDebug(@"The animation is already running");
+        return;
+    }
+    
+    // All steps are played by a single timeline step, so that the whole animation can be moved in time at once
+    if ([self.animationSteps count] == 0) {
+        HLSLoggerError(@"An empty animation cannot be scroll-linked");
+        return;
+    }
+    
+    for (HLSAnimationStep *animationStep in self.animationSteps) {
+        if (! [animationStep isKindOfClass:[HLSLayerAnimationStep class]] || doubleeq(animationStep.duration, 0.)) {
+            HLSLoggerError(@"A scroll-linked animation must only be made of layer animation steps with non-zero durations");
+            return;
+        }
+    }
+    
+    HLSLoggerSpanBegin(span, "HLSAnimation link to scroll view");
+    
+    self.running = YES;
+    self.playing = YES;
+    
+    m_scrollLinked = YES;
+    m_startContentOffset = startContentOffset;
+    m_endContentOffset = endContentOffset;
+    self.scrollViewZeroingWeakRef = [[[HLSZeroingWeakRef alloc] initWithObject:scrollView] autorelease];
+    [self.scrollViewZeroingWeakRef addCleanupAction:@selector(interrupt) onTarget:self];
+    
+    // Same state as if the (only) step were played without delay. The enumerator is exhausted so that the animation ends
+    // when the step is stopped
+    HLSLayerAnimationTimelineStep *timelineStep = [[[HLSLayerAnimationTimelineStep alloc] initWithLayerAnimationSteps:[HLSAnimation duplicateAnimationSteps:self.animationSteps]] autorelease];
+    timelineStep.automaticallyRasterizingLayers = self.automaticallyRasterizingLayers;
+    self.animationStepCopies = [NSArray arrayWithObject:timelineStep];
+    self.animationStepsEnumerator = [self.animationStepCopies objectEnumerator];
+    self.currentAnimationStep = [self.animationStepsEnumerator nextObject];
+    
+    m_animated = YES;
+    m_repeatCount = 1;
+    m_currentRepeatCount = 0;
+    m_remainingTimeBeforeStart = 0.;
+    m_elapsedTime = 0.;
+    m_currentStepStartTime = 0.;
+    m_currentStepTime = 0.;
+    
+    // Paused before being committed, so that nothing moves until the content offset is applied. The animation clock is
+    // not needed since time only changes when the scroll view scrolls
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    [timelineStep playWithDelegate:self startTime:0. animated:YES];
+    [timelineStep pause];
+    [CATransaction commit];
+    
+    // Without any layer, no paused animation can be moved in time
+    if (! [timelineStep isSeekable]) {
+        HLSLoggerError(@"A scroll-linked animation must animate at least one layer");
+        [self cancel];
+        HLSLoggerSpanEnd(span);
+        return;
+    }
+    
+    if ([self.delegate respondsToSelector:@selector(animationWillStart:animated:)]) {
+        [self.delegate animationWillStart:self animated:YES];
+    }
+    self.started = YES;
+    
+    // The delegate might have ended the animation
+    if (self.scrollLinked) {
+        [self updateScrollLinkedTime];
+    }
+    
+    HLSLoggerSpanEnd(span);
+}
+
+- (void)updateScrollLinkedTime
+{
+    if (! self.scrollLinked || self.cancelling || self.terminating) {
+        return;
+    }
+    
+    UIScrollView *scrollView = self.scrollViewZeroingWeakRef.object;
+    if (! scrollView) {
+        return;
+    }
+    
+    // Project the content offset onto the segment joining the start and end offsets
+    CGPoint contentOffset = scrollView.contentOffset;
+    CGFloat dx = m_endContentOffset.x - m_startContentOffset.x;
+    CGFloat dy = m_endContentOffset.y - m_startContentOffset.y;
+    CGFloat progress = ((contentOffset.x - m_startContentOffset.x) * dx + (contentOffset.y - m_startContentOffset.y) * dy) / (dx * dx + dy * dy);
+    progress = MIN(MAX(progress, 0.f), 1.f);
+    
+    HLSLayerAnimationTimelineStep *timelineStep = (HLSLayerAnimationTimelineStep *)self.currentAnimationStep;
+    NSTimeInterval stepTime = MAX(MIN(progress * timelineStep.duration, timelineStep.duration - kScrollLinkedAnimationEndMargin), 0.);
+    if (doubleeq(stepTime, m_currentStepTime)) {
+        return;
+    }
+    
+    // Only the time offsets of the paused layers change
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    [timelineStep offsetAnimationByTimeInterval:(stepTime - m_currentStepTime) * [HLSLayerAnimationStep animationDurationFactor]];
+    [CATransaction commit];
+    
+    BOOL forward = doublegt(stepTime, m_currentStepTime);
+    m_currentStepTime = stepTime;
+    
+    // Same rules as when the clock ticks (see -animationClockDidTick:)
+    if (forward) {
+        for (HLSLayerAnimationStep *layerAnimationStep in [timelineStep reachElapsedTime:stepTime]) {
+            [self notifyDidFinishAnimationStep:layerAnimationStep animated:YES];
+            
+            // The delegate might have cancelled or terminated the animation
+            if (self.cancelling || self.terminating) {
+                break;
+            }
+        }
+    }
+    else {
+        [timelineStep rewindToElapsedTime:stepTime];
+    }
 }
 
 - (void)cancel
@@ -434,6 +853,25 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     [self.currentAnimationStep terminate];
 }
 
+- (void)interrupt
+{
+    if (! self.running) {
+        HLSLoggerDebug(@"The animation is not running, nothing to interrupt");
+        return;
+    }
+    
+    if (self.cancelling || self.terminating) {
+        HLSLoggerDebug(@"The animation is already being cancelled or terminated");
+        return;
+    }
+    
+    // Behaves like a cancellation, except that the current step is frozen and that remaining steps are not played
+    self.cancelling = YES;
+    self.interrupting = YES;
+    
+    [self.currentAnimationStep interrupt];
+}
+
 - (void)terminate
 {
     if (! self.running) {
@@ -454,6 +892,26 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
 #pragma mark Creating animations variants from an existing animation
 
+- (HLSAnimation *)animationBySubstitutingObjects:(NSDictionary *)objectKeyToSubstituteObjectMap
+{
+    NSMutableArray *animationSteps = [NSMutableArray array];
+    for (HLSAnimationStep *animationStep in self.animationSteps) {
+        [animationSteps addObject:[animationStep animationStepBySubstitutingObjects:objectKeyToSubstituteObjectMap]];
+    }
+    
+    // The steps are new objects, no need to copy them again
+    HLSAnimation *animation = [HLSAnimation animationWithSharedAnimationSteps:[NSArray arrayWithArray:animationSteps]];
+    animation.tag = self.tag;
+    animation.lockingUI = self.lockingUI;
+    animation.compilingLayerAnimationSteps = self.compilingLayerAnimationSteps;
+    animation.automaticallyRasterizingLayers = self.automaticallyRasterizingLayers;
+    animation.recyclingAnimationSteps = self.recyclingAnimationSteps;
+    animation.rate = self.rate;
+    animation.delegate = self.delegate;
+    animation.userInfo = self.userInfo;
+    return animation;
+}
+
 - (HLSAnimation *)animationWithDuration:(NSTimeInterval)duration
 {
     if (doublelt(duration, 0.f)) {
@@ -475,20 +933,15 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     return animation;
 }
 
-- (NSArray *)reverseAnimationSteps
-{
-    NSMutableArray *reverseAnimationSteps = [NSMutableArray array];
-    for (HLSAnimationStep *animationStep in [self.animationSteps reverseObjectEnumerator]) {
-        [reverseAnimationSteps addObject:[animationStep reverseAnimationStep]];
-    }
-    return [NSArray arrayWithArray:reverseAnimationSteps];
-}
-
 - (HLSAnimation *)reverseAnimation
 {
-    HLSAnimation *reverseAnimation = [HLSAnimation animationWithAnimationSteps:[self reverseAnimationSteps]];
+    HLSAnimation *reverseAnimation = [HLSAnimation animationWithSharedAnimationSteps:self.reverseAnimationSteps];
     reverseAnimation.tag = [self.tag isFilled] ? [NSString stringWithFormat:@"reverse_%@", self.tag] : nil;
     reverseAnimation.lockingUI = self.lockingUI;
+    reverseAnimation.compilingLayerAnimationSteps = self.compilingLayerAnimationSteps;
+    reverseAnimation.automaticallyRasterizingLayers = self.automaticallyRasterizingLayers;
+    reverseAnimation.recyclingAnimationSteps = self.recyclingAnimationSteps;
+    reverseAnimation.rate = self.rate;
     reverseAnimation.delegate = self.delegate;
     reverseAnimation.userInfo = self.userInfo;
     
@@ -497,17 +950,13 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
 - (HLSAnimation *)loopAnimation
 {
-    NSMutableArray *animationSteps = [NSMutableArray arrayWithArray:self.animationSteps];
-    [animationSteps addObjectsFromArray:[self reverseAnimationSteps]];
-    
-    // Add a loop_ prefix to all animation step tags
-    for (HLSAnimationStep *animationStep in animationSteps) {
-        animationStep.tag = [animationStep.tag isFilled] ? [NSString stringWithFormat:@"loop_%@", animationStep.tag] : nil;
-    }
-    
-    HLSAnimation *loopAnimation = [HLSAnimation animationWithAnimationSteps:[NSArray arrayWithArray:animationSteps]];
+    HLSAnimation *loopAnimation = [HLSAnimation animationWithSharedAnimationSteps:self.loopAnimationSteps];
     loopAnimation.tag = [self.tag isFilled] ? [NSString stringWithFormat:@"loop_%@", self.tag] : nil;
     loopAnimation.lockingUI = self.lockingUI;
+    loopAnimation.compilingLayerAnimationSteps = self.compilingLayerAnimationSteps;
+    loopAnimation.automaticallyRasterizingLayers = self.automaticallyRasterizingLayers;
+    loopAnimation.recyclingAnimationSteps = self.recyclingAnimationSteps;
+    loopAnimation.rate = self.rate;
     loopAnimation.delegate = self.delegate;
     loopAnimation.userInfo = self.userInfo;
     
@@ -518,6 +967,11 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
 - (void)animationStepDidStop:(HLSAnimationStep *)animationStep animated:(BOOL)animated finished:(BOOL)finished
 {
+    HLSAnimationProfiler *animationProfiler = [HLSAnimationProfiler sharedAnimationProfiler];
+    if (animationProfiler.enabled) {
+        [animationProfiler animation:self didStopAnimationStep:animationStep finished:finished];
+    }
+    
     // Still send all delegate notifications if terminating and if not playing animation steps instantaneously
     // when a start time has been set
     if (! self.cancelling && doubleeq(m_remainingTimeBeforeStart, 0.)) {
@@ -535,17 +989,24 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
                 self.started = YES;
             }
         }
-        else {
-            if ([self.delegate respondsToSelector:@selector(animation:didFinishStep:animated:)]) {
-                [self.delegate animation:self didFinishStep:animationStep animated:animated];
+        // Steps of a timeline whose end has not been reported yet (all steps if the timeline was not played animated)
+        else if ([animationStep isKindOfClass:[HLSLayerAnimationTimelineStep class]]) {
+            HLSLayerAnimationTimelineStep *timelineStep = (HLSLayerAnimationTimelineStep *)animationStep;
+            for (HLSLayerAnimationStep *layerAnimationStep in [timelineStep unreachedLayerAnimationSteps]) {
+                [self notifyDidFinishAnimationStep:layerAnimationStep animated:animated];
             }
         }
+        else {
+            [self notifyDidFinishAnimationStep:animationStep animated:animated];
+        }
     }
     
-    // We accumulate the effective duration of the animation which has been run until now
-    if (! self.cancelling && ! self.terminating) {
+    // We accumulate the effective duration of the animation which has been run until now (the initial delay is not
+    // part of the animation)
+    if (! self.cancelling && ! self.terminating && ! [animationStep.tag isEqualToString:kDelayLayerAnimationTag]) {
         m_elapsedTime += [self.currentAnimationStep duration];
     }
+    m_currentStepTime = 0.;
     
     // Play the next step (or the first step if the initial delay animation step has ended(), but non-animated if the
     // animation did not reach completion normally. Moreover, if some animation steps are played non-animated because
@@ -553,6 +1014,63 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     [self playNextAnimationStepAnimated:finished ? (! doubleeq(m_remainingTimeBeforeStart, 0.) ? m_animated : animated) : NO];
 }
 
+// Step ends are batched by the animation scheduler, see -deliverDidFinishAnimationStep:animated:
+- (void)notifyDidFinishAnimationStep:(HLSAnimationStep *)animationStep animated:(BOOL)animated
+{
+    [[HLSAnimationScheduler sharedAnimationScheduler] animation:self didFinishAnimationStep:animationStep animated:animated];
+}
+
+- (void)deliverDidFinishAnimationStep:(HLSAnimationStep *)animationStep animated:(BOOL)animated
+{
+    if (! self.running || self.cancelling) {
+        return;
+    }
+    
+    if ([self.delegate respondsToSelector:@selector(animation:didFinishStep:animated:)]) {
+        [self.delegate animation:self didFinishStep:animationStep animated:animated];
+    }
+}
+
+#pragma mark HLSAnimationClockObserver protocol implementation
+
+- (void)animationClockDidTick:(HLSAnimationClock *)animationClock
+{
+    // Timestamps prior to the beginning of the current step are discarded
+    CFTimeInterval timestamp = animationClock.timestamp;
+    CFTimeInterval timeInterval = timestamp - m_lastClockTimestamp;
+    if (doublele(timeInterval, 0.)) {
+        return;
+    }
+    m_lastClockTimestamp = timestamp;
+    
+    if (! self.currentAnimationStep || self.paused || self.cancelling || self.terminating) {
+        return;
+    }
+    
+    // Steps which cannot be moved in time are always played at normal speed
+    CGFloat animationDurationFactor = [HLSLayerAnimationStep animationDurationFactor];
+    float rate = [self.currentAnimationStep isSeekable] ? self.rate : 1.f;
+    m_currentStepTime = MIN(m_currentStepTime + timeInterval * rate / animationDurationFactor, self.currentAnimationStep.duration);
+    
+    // Report the end of timeline steps which have been reached (same rules as for the end of animation steps, see
+    // -animationStepDidStop:animated:finished:)
+    if ([self.currentAnimationStep isKindOfClass:[HLSLayerAnimationTimelineStep class]]) {
+        HLSLayerAnimationTimelineStep *timelineStep = (HLSLayerAnimationTimelineStep *)self.currentAnimationStep;
+        for (HLSLayerAnimationStep *layerAnimationStep in [timelineStep reachElapsedTime:m_currentStepTime]) {
+            if (! doubleeq(m_remainingTimeBeforeStart, 0.)) {
+                continue;
+            }
+            
+            [self notifyDidFinishAnimationStep:layerAnimationStep animated:YES];
+            
+            // The delegate might have cancelled or terminated the animation
+            if (self.cancelling || self.terminating) {
+                break;
+            }
+        }
+    }
+}
+
 #pragma mark NSCopying protocol implementation
 
 - (id)copyWithZone:(NSZone *)zone
@@ -572,6 +1090,10 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
     
     animationCopy.tag = self.tag;
     animationCopy.lockingUI = self.lockingUI;
+    animationCopy.compilingLayerAnimationSteps = self.compilingLayerAnimationSteps;
+    animationCopy.automaticallyRasterizingLayers = self.automaticallyRasterizingLayers;
+    animationCopy.recyclingAnimationSteps = self.recyclingAnimationSteps;
+    animationCopy.rate = self.rate;
     animationCopy.delegate = self.delegate;
     animationCopy.userInfo = self.userInfo;
     
@@ -582,6 +1104,11 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
 - (void)applicationDidEnterBackground:(NSNotification *)notification
 {
+    // Scroll-linked animations are frozen in layer time and are left alone
+    if (self.scrollLinked) {
+        return;
+    }
+    
     m_runningBeforeEnteringBackground = self.running;
     
     if (m_runningBeforeEnteringBackground) {
@@ -592,7 +1119,9 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
         //      delegate events are not received
         //   2) Rewind the animation at the beginning, without a delegate
         //   3) Play the animation from where it was cancelled when the application enters foreground
-        m_elapsedTime += [self.currentAnimationStep elapsedTime];
+        if (! [self.currentAnimationStep.tag isEqualToString:kDelayLayerAnimationTag]) {
+            m_elapsedTime += [self.currentAnimationStep isSeekable] ? m_currentStepTime : [self.currentAnimationStep elapsedTime];
+        }
         m_pausedBeforeEnteringBackground = self.paused;
         
         [self cancel];
@@ -620,12 +1149,16 @@ static NSString * const kDelayLayerAnimationTag = @"HLSDelayLayerAnimationStep";
 
 - (NSString *)description
 {
-    return [NSString stringWithFormat:@"<%@: %p; animationSteps: %@; tag: %@; lockingUI: %@; delegate: %p>",
+    return [NSString stringWithFormat:@"<%@: %p; animationSteps: %@; tag: %@; lockingUI: %@; compilingLayerAnimationSteps: %@; "
+            "automaticallyRasterizingLayers: %@; recyclingAnimationSteps: %@; delegate: %p>",
             [self class],
             self,
             self.animationSteps,
             self.tag,
             HLSStringFromBool(self.lockingUI),
+            HLSStringFromBool(self.compilingLayerAnimationSteps),
+            HLSStringFromBool(self.automaticallyRasterizingLayers),
+            HLSStringFromBool(self.recyclingAnimationSteps),
             self.delegate];
 }
 
@@ -0,0 +1,47 @@
+//
+//  HLSAnimationClock.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+// Forward declarations
+@protocol HLSAnimationClockObserver;
+
+/**
+ * Singleton class providing the time base shared by all running animations. Observers attached to the clock are
+ * all notified from a single display link callback, once per frame. The display link only runs while at least one
+ * observer is attached. Must only be used from the main thread
+ *
+ * Designated initializer: -init
+ */
+@interface HLSAnimationClock : NSObject {
+@private
+    CADisplayLink *m_displayLink;
+    NSMutableArray *m_observerValues;
+}
+
++ (HLSAnimationClock *)sharedAnimationClock;
+
+/**
+ * Attach / detach an observer. Observers are not retained and must therefore be detached before they are deallocated
+ */
+- (void)addObserver:(id<HLSAnimationClockObserver>)observer;
+- (void)removeObserver:(id<HLSAnimationClockObserver>)observer;
+
+/**
+ * The timestamp of the current frame while observers are notified, otherwise the current media time
+ */
+@property (nonatomic, readonly, assign) CFTimeInterval timestamp;
+
+@end
+
+@protocol HLSAnimationClockObserver <NSObject>
+
+/**
+ * Called once per frame for each attached observer
+ */
+- (void)animationClockDidTick:(HLSAnimationClock *)animationClock;
+
+@end
@@ -0,0 +1,122 @@
+//
+//  HLSAnimationClock.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSAnimationClock.h"
+
+#import "HLSLogger.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
+
+@interface HLSAnimationClock ()
+
+@property (nonatomic, retain) CADisplayLink *displayLink;
+@property (nonatomic, retain) NSMutableArray *observerValues;
+
+- (void)tick:(CADisplayLink *)displayLink;
+
+@end
+
+@implementation HLSAnimationClock
+
+#pragma mark Class methods
+
++ (HLSAnimationClock *)sharedAnimationClock
+{
+    static HLSAnimationClock *s_instance = nil;
+    
+    if (! s_instance) {
+        s_instance = [[HLSAnimationClock alloc] init];
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.observerValues = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self.displayLink invalidate];
+    
+    self.displayLink = nil;
+    self.observerValues = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize displayLink = m_displayLink;
+
+@synthesize observerValues = m_observerValues;
+
+- (CFTimeInterval)timestamp
+{
+    if (self.displayLink) {
+        return self.displayLink.timestamp;
+    }
+    else {
+        return CACurrentMediaTime();
+    }
+}
+
+#pragma mark Observers
+
+- (void)addObserver:(id<HLSAnimationClockObserver>)observer
+{
+    NSValue *observerValue = [NSValue valueWithNonretainedObject:observer];
+    if ([self.observerValues containsObject:observerValue]) {
+        HLSLoggerDebug(@"The observer %@ is already attached to the clock", observer);
+        return;
+    }
+    
+    [self.observerValues addObject:observerValue];
+    
+    // The display link retains its target. This is not an issue since the clock is a singleton
+    if (! self.displayLink) {
+        self.displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(tick:)];
+        [self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+}
+
+- (void)removeObserver:(id<HLSAnimationClockObserver>)observer
+{
+    NSValue *observerValue = [NSValue valueWithNonretainedObject:observer];
+    [self.observerValues removeObject:observerValue];
+    
+    if ([self.observerValues count] == 0) {
+        [self.displayLink invalidate];
+        self.displayLink = nil;
+    }
+}
+
+#pragma mark Display link callback
+
+- (void)tick:(CADisplayLink *)displayLink
+{
+    // Observers might attach or detach observers when notified. Observers which have been detached in the meantime must
+    // not be notified anymore (they might have been deallocated)
+    NSArray *observerValues = [NSArray arrayWithArray:self.observerValues];
+    for (NSValue *observerValue in observerValues) {
+        if (! [self.observerValues containsObject:observerValue]) {
+            continue;
+        }
+        
+        id<HLSAnimationClockObserver> observer = [observerValue nonretainedObjectValue];
+        [observer animationClockDidTick:self];
+    }
+}
+
+@end
@@ -0,0 +1,41 @@
+//
+//  HLSAnimationProfiler+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSAnimationProfiler.h"
+
+// Forward declarations
+@class HLSAnimation;
+@class HLSAnimationStep;
+
+/**
+ * Interface meant to be used by friend classes of HLSAnimationProfiler (= classes which must have access to private
+ * implementation details)
+ */
+@interface HLSAnimationProfiler (Friend)
+
+/**
+ * Must be called when an animation has started playing a step animated. Times are expressed using CACurrentMediaTime()
+ */
+- (void)animation:(HLSAnimation *)animation
+didStartAnimationStep:(HLSAnimationStep *)animationStep
+ plannedStartTime:(CFTimeInterval)plannedStartTime
+   plannedEndTime:(CFTimeInterval)plannedEndTime
+  actualStartTime:(CFTimeInterval)actualStartTime
+   commitDuration:(CFTimeInterval)commitDuration;
+
+/**
+ * Must be called when an animation has been resumed after a pause of the specified duration
+ */
+- (void)animation:(HLSAnimation *)animation didResumeAfterPauseDuration:(NSTimeInterval)pauseDuration;
+
+/**
+ * Must be called when the step being played by an animation has ended
+ */
+- (void)animation:(HLSAnimation *)animation didStopAnimationStep:(HLSAnimationStep *)animationStep finished:(BOOL)finished;
+
+@end
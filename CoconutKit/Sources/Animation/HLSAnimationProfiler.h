@@ -0,0 +1,80 @@
+//
+//  HLSAnimationProfiler.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Opt-in profiler for animations (HLSAnimation). When enabled, the profiler records, for each animation step played
+ * animated:
+ *   - its planned start and end times (the time at which it should have started, respectively ended, if the previous
+ *     steps had run exactly for their duration), and its actual start and end times. Pauses are not counted
+ *   - the time spent on the main thread creating and committing its animations (for layer animation steps, this is
+ *     the duration of the corresponding CATransaction)
+ *   - the number of layers (or views) it animates
+ * Records are grouped by animation tag and step tag. They can be displayed in a debug overlay while the application
+ * is running, or summarized in a report, which helps tracking the transitions responsible for frame drops. Steps
+ * played non-animated (e.g. to reach a start time) and the initial delay of an animation are not recorded
+ *
+ * The profiler must only be used from the main thread. Only the most recent records are kept (see maximumRecordCount)
+ *
+ * Designated initializer: -init (but use the +sharedAnimationProfiler singleton)
+ */
+@interface HLSAnimationProfiler : NSObject {
+@private
+    CFMutableDictionaryRef m_animationToRecordMap;          // maps an HLSAnimation object (pointer) to the record of the step being played
+    NSMutableArray *m_records;                              // completed records, oldest first
+    NSUInteger m_maximumRecordCount;
+    BOOL m_enabled;
+    UIWindow *m_overlayWindow;
+    UILabel *m_overlayLabel;
+}
+
+/**
+ * The profiler singleton
+ */
++ (HLSAnimationProfiler *)sharedAnimationProfiler;
+
+/**
+ * Set to YES to start recording. Disabling the profiler keeps the records collected so far
+ *
+ * Default value is NO
+ */
+@property (nonatomic, assign, getter=isEnabled) BOOL enabled;
+
+/**
+ * The maximum number of step records to keep. When this number is exceeded, the oldest records are discarded
+ *
+ * Default value is 1000
+ */
+@property (nonatomic, assign) NSUInteger maximumRecordCount;
+
+/**
+ * Set to YES to display the most recent records in a debug overlay at the top of the screen. The overlay does not
+ * intercept touches
+ *
+ * Default value is NO
+ */
+@property (nonatomic, assign, getter=isOverlayVisible) BOOL overlayVisible;
+
+/**
+ * The tags of the animations for which records are available (untagged animations are reported with an empty tag)
+ */
+- (NSArray *)animationTags;
+
+/**
+ * Return a report summarizing, for each step of the animations with a given tag (nil for all animations), the number
+ * of times it was played, the mean and maximum delays between planned and actual start and end times, the mean and
+ * maximum commit durations and the number of layers animated. Steps are listed in the order in which they have been
+ * played for the first time
+ */
+- (NSString *)reportForAnimationsWithTag:(NSString *)tagOrNil;
+
+/**
+ * Discard all records
+ */
+- (void)clear;
+
+@end
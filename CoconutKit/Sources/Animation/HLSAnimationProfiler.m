@@ -0,0 +1,400 @@
+//
+//  HLSAnimationProfiler.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSAnimationProfiler.h"
+
+#import "HLSAnimation.h"
+#import "HLSAnimationProfiler+Friend.h"
+#import "HLSAnimationStep+Protected.h"
+#import "HLSLayerAnimationTimelineStep.h"
+#import "HLSLogger.h"
+#import "NSString+HLSExtensions.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
+
+// Number of records displayed by the overlay
+static const NSUInteger kAnimationProfilerOverlayRecordCount = 6;
+
+#pragma mark -
+#pragma mark HLSAnimationStepRecord class
+
+/**
+ * Information collected for an animation step played animated
+ */
+@interface HLSAnimationStepRecord : NSObject {
+@private
+    NSString *m_animationTag;
+    NSString *m_animationStepTag;
+    CFTimeInterval m_plannedStartTime;
+    CFTimeInterval m_plannedEndTime;
+    CFTimeInterval m_actualStartTime;
+    CFTimeInterval m_actualEndTime;
+    CFTimeInterval m_commitDuration;
+    NSUInteger m_numberOfLayers;
+    BOOL m_finished;
+}
+
+@property (nonatomic, retain) NSString *animationTag;
+@property (nonatomic, retain) NSString *animationStepTag;
+@property (nonatomic, assign) CFTimeInterval plannedStartTime;
+@property (nonatomic, assign) CFTimeInterval plannedEndTime;
+@property (nonatomic, assign) CFTimeInterval actualStartTime;
+@property (nonatomic, assign) CFTimeInterval actualEndTime;
+@property (nonatomic, assign) CFTimeInterval commitDuration;
+@property (nonatomic, assign) NSUInteger numberOfLayers;
+@property (nonatomic, assign, getter=isFinished) BOOL finished;
+
+- (CFTimeInterval)startDelay;
+- (CFTimeInterval)endDelay;
+
+@end
+
+@implementation HLSAnimationStepRecord
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.animationTag = nil;
+    self.animationStepTag = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize animationTag = m_animationTag;
+
+@synthesize animationStepTag = m_animationStepTag;
+
+@synthesize plannedStartTime = m_plannedStartTime;
+
+@synthesize plannedEndTime = m_plannedEndTime;
+
+@synthesize actualStartTime = m_actualStartTime;
+
+@synthesize actualEndTime = m_actualEndTime;
+
+@synthesize commitDuration = m_commitDuration;
+
+@synthesize numberOfLayers = m_numberOfLayers;
+
+@synthesize finished = m_finished;
+
+- (CFTimeInterval)startDelay
+{
+    return self.actualStartTime - self.plannedStartTime;
+}
+
+- (CFTimeInterval)endDelay
+{
+    return self.actualEndTime - self.plannedEndTime;
+}
+
+#pragma mark Description
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"%@/%@: start %+.1f ms, end %+.1f ms, commit %.1f ms, %u layers%@",
+            self.animationTag,
+            self.animationStepTag,
+            [self startDelay] * 1000.,
+            [self endDelay] * 1000.,
+            self.commitDuration * 1000.,
+            self.numberOfLayers,
+            self.finished ? @"" : @" (interrupted)"];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSAnimationProfiler class
+
+@interface HLSAnimationProfiler ()
+
+@property (nonatomic, retain) NSMutableArray *records;
+@property (nonatomic, retain) UIWindow *overlayWindow;
+@property (nonatomic, retain) UILabel *overlayLabel;
+
+- (void)addRecord:(HLSAnimationStepRecord *)record;
+- (void)updateOverlay;
+
+@end
+
+@implementation HLSAnimationProfiler
+
+#pragma mark Class methods
+
++ (HLSAnimationProfiler *)sharedAnimationProfiler
+{
+    static HLSAnimationProfiler *s_instance = nil;
+    
+    if (! s_instance) {
+        s_instance = [[HLSAnimationProfiler alloc] init];
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        // Animations are not retained
+        m_animationToRecordMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        self.records = [NSMutableArray array];
+        self.maximumRecordCount = 1000;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    CFRelease(m_animationToRecordMap);
+    self.records = nil;
+    self.overlayWindow = nil;
+    self.overlayLabel = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize records = m_records;
+
+@synthesize maximumRecordCount = m_maximumRecordCount;
+
+- (void)setMaximumRecordCount:(NSUInteger)maximumRecordCount
+{
+    if (maximumRecordCount == 0) {
+        HLSLoggerError(@"The maximum record count must be > 0");
+        return;
+    }
+    
+    m_maximumRecordCount = maximumRecordCount;
+    
+    if ([self.records count] > maximumRecordCount) {
+        [self.records removeObjectsInRange:NSMakeRange(0, [self.records count] - maximumRecordCount)];
+    }
+}
+
+@synthesize enabled = m_enabled;
+
+- (void)setEnabled:(BOOL)enabled
+{
+    if (! enabled) {
+        CFDictionaryRemoveAllValues(m_animationToRecordMap);
+    }
+    m_enabled = enabled;
+}
+
+@synthesize overlayWindow = m_overlayWindow;
+
+@synthesize overlayLabel = m_overlayLabel;
+
+- (BOOL)isOverlayVisible
+{
+    return self.overlayWindow != nil;
+}
+
+- (void)setOverlayVisible:(BOOL)overlayVisible
+{
+    if (overlayVisible == self.overlayVisible) {
+        return;
+    }
+    
+    if (overlayVisible) {
+        CGRect applicationFrame = [UIScreen mainScreen].applicationFrame;
+        self.overlayWindow = [[[UIWindow alloc] initWithFrame:CGRectMake(CGRectGetMinX(applicationFrame),
+                                                                         CGRectGetMinY(applicationFrame),
+                                                                         CGRectGetWidth(applicationFrame),
+                                                                         12.f * kAnimationProfilerOverlayRecordCount + 4.f)] autorelease];
+        self.overlayWindow.windowLevel = UIWindowLevelStatusBar + 1.f;
+        self.overlayWindow.userInteractionEnabled = NO;
+        self.overlayWindow.backgroundColor = [UIColor colorWithWhite:0.f alpha:0.6f];
+        
+        self.overlayLabel = [[[UILabel alloc] initWithFrame:CGRectInset(self.overlayWindow.bounds, 2.f, 2.f)] autorelease];
+        self.overlayLabel.autoresizingMask = UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight;
+        self.overlayLabel.backgroundColor = [UIColor clearColor];
+        self.overlayLabel.textColor = [UIColor whiteColor];
+        self.overlayLabel.font = [UIFont fontWithName:@"Courier" size:10.f];
+        self.overlayLabel.numberOfLines = kAnimationProfilerOverlayRecordCount;
+        [self.overlayWindow addSubview:self.overlayLabel];
+        
+        self.overlayWindow.hidden = NO;
+        [self updateOverlay];
+    }
+    else {
+        self.overlayWindow.hidden = YES;
+        self.overlayWindow = nil;
+        self.overlayLabel = nil;
+    }
+}
+
+#pragma mark Recording
+
+- (void)animation:(HLSAnimation *)animation
+didStartAnimationStep:(HLSAnimationStep *)animationStep
+ plannedStartTime:(CFTimeInterval)plannedStartTime
+   plannedEndTime:(CFTimeInterval)plannedEndTime
+  actualStartTime:(CFTimeInterval)actualStartTime
+   commitDuration:(CFTimeInterval)commitDuration
+{
+    if (! self.enabled) {
+        return;
+    }
+    
+    // Steps compiled into a timeline are identified by the tags of the steps they are made of
+    NSString *animationStepTag = nil;
+    if ([animationStep isKindOfClass:[HLSLayerAnimationTimelineStep class]]) {
+        NSMutableArray *layerAnimationStepTags = [NSMutableArray array];
+        for (HLSAnimationStep *layerAnimationStep in ((HLSLayerAnimationTimelineStep *)animationStep).layerAnimationSteps) {
+            [layerAnimationStepTags addObject:[layerAnimationStep.tag isFilled] ? layerAnimationStep.tag : @"?"];
+        }
+        animationStepTag = [layerAnimationStepTags componentsJoinedByString:@"+"];
+    }
+    else {
+        animationStepTag = [animationStep.tag isFilled] ? animationStep.tag : @"";
+    }
+    
+    // Views are counted for steps which do not directly animate layers
+    NSUInteger numberOfLayers = [[animationStep animatedLayers] count];
+    if (numberOfLayers == 0) {
+        numberOfLayers = [[animationStep objects] count];
+    }
+    
+    HLSAnimationStepRecord *record = [[[HLSAnimationStepRecord alloc] init] autorelease];
+    record.animationTag = [animation.tag isFilled] ? animation.tag : @"";
+    record.animationStepTag = animationStepTag;
+    record.plannedStartTime = plannedStartTime;
+    record.plannedEndTime = plannedEndTime;
+    record.actualStartTime = actualStartTime;
+    record.commitDuration = commitDuration;
+    record.numberOfLayers = numberOfLayers;
+    CFDictionarySetValue(m_animationToRecordMap, animation, record);
+}
+
+- (void)animation:(HLSAnimation *)animation didResumeAfterPauseDuration:(NSTimeInterval)pauseDuration
+{
+    HLSAnimationStepRecord *record = (HLSAnimationStepRecord *)CFDictionaryGetValue(m_animationToRecordMap, animation);
+    record.plannedEndTime += pauseDuration;
+}
+
+- (void)animation:(HLSAnimation *)animation didStopAnimationStep:(HLSAnimationStep *)animationStep finished:(BOOL)finished
+{
+    HLSAnimationStepRecord *record = (HLSAnimationStepRecord *)CFDictionaryGetValue(m_animationToRecordMap, animation);
+    if (! record) {
+        return;
+    }
+    
+    record.actualEndTime = CACurrentMediaTime();
+    record.finished = finished;
+    [self addRecord:record];
+    
+    CFDictionaryRemoveValue(m_animationToRecordMap, animation);
+}
+
+- (void)addRecord:(HLSAnimationStepRecord *)record
+{
+    [self.records addObject:record];
+    if ([self.records count] > self.maximumRecordCount) {
+        [self.records removeObjectAtIndex:0];
+    }
+    
+    [self updateOverlay];
+}
+
+#pragma mark Overlay
+
+- (void)updateOverlay
+{
+    if (! self.overlayLabel) {
+        return;
+    }
+    
+    NSUInteger numberOfRecords = [self.records count];
+    NSUInteger numberOfDisplayedRecords = MIN(numberOfRecords, kAnimationProfilerOverlayRecordCount);
+    NSArray *displayedRecords = [self.records subarrayWithRange:NSMakeRange(numberOfRecords - numberOfDisplayedRecords, numberOfDisplayedRecords)];
+    self.overlayLabel.text = [[displayedRecords valueForKey:@"description"] componentsJoinedByString:@"\n"];
+}
+
+#pragma mark Reporting
+
+- (NSArray *)animationTags
+{
+    NSMutableArray *animationTags = [NSMutableArray array];
+    for (HLSAnimationStepRecord *record in self.records) {
+        if (! [animationTags containsObject:record.animationTag]) {
+            [animationTags addObject:record.animationTag];
+        }
+    }
+    return [NSArray arrayWithArray:animationTags];
+}
+
+- (NSString *)reportForAnimationsWithTag:(NSString *)tagOrNil
+{
+    // Group records by animation and step tags, in the order in which they have been played for the first time
+    NSMutableArray *keys = [NSMutableArray array];
+    NSMutableDictionary *keyToRecordsMap = [NSMutableDictionary dictionary];
+    for (HLSAnimationStepRecord *record in self.records) {
+        if (tagOrNil && ! [record.animationTag isEqualToString:tagOrNil]) {
+            continue;
+        }
+        
+        NSString *key = [NSString stringWithFormat:@"%@/%@", record.animationTag, record.animationStepTag];
+        NSMutableArray *records = [keyToRecordsMap objectForKey:key];
+        if (! records) {
+            records = [NSMutableArray array];
+            [keyToRecordsMap setObject:records forKey:key];
+            [keys addObject:key];
+        }
+        [records addObject:record];
+    }
+    
+    NSMutableString *report = [NSMutableString string];
+    [report appendString:@"animation/step: count | start delay mean / max | end delay mean / max | commit mean / max | layers max (times in ms)\n"];
+    for (NSString *key in keys) {
+        NSArray *records = [keyToRecordsMap objectForKey:key];
+        
+        CFTimeInterval totalStartDelay = 0., maximumStartDelay = -DBL_MAX;
+        CFTimeInterval totalEndDelay = 0., maximumEndDelay = -DBL_MAX;
+        CFTimeInterval totalCommitDuration = 0., maximumCommitDuration = 0.;
+        NSUInteger maximumNumberOfLayers = 0;
+        for (HLSAnimationStepRecord *record in records) {
+            totalStartDelay += [record startDelay];
+            maximumStartDelay = MAX(maximumStartDelay, [record startDelay]);
+            totalEndDelay += [record endDelay];
+            maximumEndDelay = MAX(maximumEndDelay, [record endDelay]);
+            totalCommitDuration += record.commitDuration;
+            maximumCommitDuration = MAX(maximumCommitDuration, record.commitDuration);
+            maximumNumberOfLayers = MAX(maximumNumberOfLayers, record.numberOfLayers);
+        }
+        
+        NSUInteger count = [records count];
+        [report appendFormat:@"%@: %u | %+.1f / %+.1f | %+.1f / %+.1f | %.1f / %.1f | %u\n",
+         key,
+         count,
+         totalStartDelay / count * 1000.,
+         maximumStartDelay * 1000.,
+         totalEndDelay / count * 1000.,
+         maximumEndDelay * 1000.,
+         totalCommitDuration / count * 1000.,
+         maximumCommitDuration * 1000.,
+         maximumNumberOfLayers];
+    }
+    return [NSString stringWithString:report];
+}
+
+- (void)clear
+{
+    [self.records removeAllObjects];
+    [self updateOverlay];
+}
+
+@end
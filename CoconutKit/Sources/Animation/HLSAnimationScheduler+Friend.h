@@ -0,0 +1,39 @@
+//
+//  HLSAnimationScheduler+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSAnimationScheduler.h"
+
+// Forward declarations
+@class HLSAnimation;
+@class HLSAnimationStep;
+
+/**
+ * Interface meant to be used by friend classes of HLSAnimationScheduler (= classes which must have access to private
+ * implementation details)
+ */
+@interface HLSAnimationScheduler (Friend)
+
+/**
+ * Must be called by animation steps before they create their animations. If batching is enabled, the enclosing
+ * transaction of the current run loop turn is opened if needed, so that the transactions of the steps are nested in it
+ */
+- (void)beginAnimationStepTransaction;
+
+/**
+ * Deliver the end of an animation step played animated (-[HLSAnimation deliverDidFinishAnimationStep:animated:]) at the
+ * end of the current run loop turn, or immediately if batching is disabled
+ */
+- (void)animation:(HLSAnimation *)animation didFinishAnimationStep:(HLSAnimationStep *)animationStep animated:(BOOL)animated;
+
+/**
+ * Deliver (or discard) the pending step end notifications of an animation immediately
+ */
+- (void)flushNotificationsForAnimation:(HLSAnimation *)animation;
+- (void)discardNotificationsForAnimation:(HLSAnimation *)animation;
+
+@end
@@ -0,0 +1,44 @@
+//
+//  HLSAnimationScheduler.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Singleton class batching the work of animations (HLSAnimation) started or progressing during the same run loop
+ * turn (e.g. one animation per visible table view cell):
+ *   - all animation steps started animated within a turn create their Core Animation animations in a single enclosing
+ *     transaction, committed once at the end of the turn instead of once per step
+ *   - the animation:didFinishStep:animated: delegate events of steps which ended animated within a turn are delivered
+ *     together at the end of the turn, in the order in which the steps ended. The events of an animation are always 
+ *     delivered before its other delegate events (e.g. animationDidStop:animated:), and are dropped if the animation
+ *     is cancelled in the meantime. Events of steps played non-animated are still delivered synchronously
+ *
+ * The scheduler must only be used from the main thread
+ *
+ * Designated initializer: -init (but use the +sharedAnimationScheduler singleton)
+ */
+@interface HLSAnimationScheduler : NSObject {
+@private
+    CFRunLoopObserverRef m_runLoopObserver;
+    NSMutableArray *m_pendingNotifications;                 // step end notifications not delivered yet, in order
+    BOOL m_transactionOpen;
+    BOOL m_enabled;
+}
+
+/**
+ * The scheduler singleton
+ */
++ (HLSAnimationScheduler *)sharedAnimationScheduler;
+
+/**
+ * Set to NO to create and commit the animations of each step separately, and deliver all step delegate events
+ * immediately. Pending work is performed when batching is disabled
+ *
+ * Default value is YES
+ */
+@property (nonatomic, assign, getter=isEnabled) BOOL enabled;
+
+@end
@@ -0,0 +1,199 @@
+//
+//  HLSAnimationScheduler.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSAnimationScheduler.h"
+
+#import "HLSAnimation+Friend.h"
+#import "HLSAnimationScheduler+Friend.h"
+#import "HLSLogger.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
+
+// Core Animation commits its implicit transactions from a run loop observer with order 2000000. Our observer must
+// be called just before, so that the work batched during a turn is part of the same commit
+static const CFIndex kAnimationSchedulerRunLoopObserverOrder = 1999000;
+
+static NSString * const kAnimationSchedulerAnimationKey = @"animation";
+static NSString * const kAnimationSchedulerAnimationStepKey = @"animationStep";
+static NSString * const kAnimationSchedulerAnimatedKey = @"animated";
+
+static void HLSAnimationSchedulerRunLoopObserverCallBack(CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info);
+
+@interface HLSAnimationScheduler ()
+
+@property (nonatomic, retain) NSMutableArray *pendingNotifications;
+
+- (void)flushNotificationsForAnimation:(HLSAnimation *)animation discard:(BOOL)discard;
+- (void)endTurn;
+
+@end
+
+@implementation HLSAnimationScheduler
+
+#pragma mark Class methods
+
++ (HLSAnimationScheduler *)sharedAnimationScheduler
+{
+    static HLSAnimationScheduler *s_instance = nil;
+    
+    if (! s_instance) {
+        s_instance = [[HLSAnimationScheduler alloc] init];
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.pendingNotifications = [NSMutableArray array];
+        m_enabled = YES;
+        
+        // The observer does not retain the scheduler
+        CFRunLoopObserverContext context = { 0, self, NULL, NULL, NULL };
+        m_runLoopObserver = CFRunLoopObserverCreate(kCFAllocatorDefault, kCFRunLoopBeforeWaiting | kCFRunLoopExit, true,
+                                                    kAnimationSchedulerRunLoopObserverOrder,
+                                                    HLSAnimationSchedulerRunLoopObserverCallBack, &context);
+        CFRunLoopAddObserver(CFRunLoopGetMain(), m_runLoopObserver, kCFRunLoopCommonModes);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self endTurn];
+    
+    CFRunLoopObserverInvalidate(m_runLoopObserver);
+    CFRelease(m_runLoopObserver);
+    m_runLoopObserver = NULL;
+    
+    self.pendingNotifications = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize pendingNotifications = m_pendingNotifications;
+
+@synthesize enabled = m_enabled;
+
+- (void)setEnabled:(BOOL)enabled
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (enabled == m_enabled) {
+        return;
+    }
+    
+    m_enabled = enabled;
+    
+    if (! enabled) {
+        [self endTurn];
+    }
+}
+
+#pragma mark Batching
+
+- (void)endTurn
+{
+    // Deliver notifications first. Steps started by the delegates are still part of the enclosing transaction
+    while ([self.pendingNotifications count] != 0) {
+        NSDictionary *notification = [[[self.pendingNotifications objectAtIndex:0] retain] autorelease];
+        [self.pendingNotifications removeObjectAtIndex:0];
+        
+        HLSAnimation *animation = [notification objectForKey:kAnimationSchedulerAnimationKey];
+        HLSAnimationStep *animationStep = [notification objectForKey:kAnimationSchedulerAnimationStepKey];
+        BOOL animated = [[notification objectForKey:kAnimationSchedulerAnimatedKey] boolValue];
+        [animation deliverDidFinishAnimationStep:animationStep animated:animated];
+    }
+    
+    if (m_transactionOpen) {
+        m_transactionOpen = NO;
+        [CATransaction commit];
+    }
+}
+
+- (void)flushNotificationsForAnimation:(HLSAnimation *)animation discard:(BOOL)discard
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    // Delegates might schedule or flush notifications as well. Deliver the notifications one after the other
+    NSUInteger index = 0;
+    while (index < [self.pendingNotifications count]) {
+        NSDictionary *notification = [self.pendingNotifications objectAtIndex:index];
+        if ([notification objectForKey:kAnimationSchedulerAnimationKey] != animation) {
+            ++index;
+            continue;
+        }
+        
+        [[notification retain] autorelease];
+        [self.pendingNotifications removeObjectAtIndex:index];
+        
+        if (! discard) {
+            HLSAnimationStep *animationStep = [notification objectForKey:kAnimationSchedulerAnimationStepKey];
+            BOOL animated = [[notification objectForKey:kAnimationSchedulerAnimatedKey] boolValue];
+            [animation deliverDidFinishAnimationStep:animationStep animated:animated];
+            index = 0;
+        }
+    }
+}
+
+@end
+
+@implementation HLSAnimationScheduler (Friend)
+
+- (void)beginAnimationStepTransaction
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (! m_enabled || m_transactionOpen) {
+        return;
+    }
+    
+    m_transactionOpen = YES;
+    [CATransaction begin];
+}
+
+- (void)animation:(HLSAnimation *)animation didFinishAnimationStep:(HLSAnimationStep *)animationStep animated:(BOOL)animated
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (! m_enabled || ! animated) {
+        [self flushNotificationsForAnimation:animation discard:NO];
+        [animation deliverDidFinishAnimationStep:animationStep animated:animated];
+        return;
+    }
+    
+    NSDictionary *notification = [NSDictionary dictionaryWithObjectsAndKeys:animation, kAnimationSchedulerAnimationKey,
+                                  animationStep, kAnimationSchedulerAnimationStepKey,
+                                  [NSNumber numberWithBool:animated], kAnimationSchedulerAnimatedKey, nil];
+    [self.pendingNotifications addObject:notification];
+}
+
+- (void)flushNotificationsForAnimation:(HLSAnimation *)animation
+{
+    [self flushNotificationsForAnimation:animation discard:NO];
+}
+
+- (void)discardNotificationsForAnimation:(HLSAnimation *)animation
+{
+    [self flushNotificationsForAnimation:animation discard:YES];
+}
+
+@end
+
+#pragma mark Functions
+
+static void HLSAnimationSchedulerRunLoopObserverCallBack(CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info)
+{
+    HLSAnimationScheduler *animationScheduler = (HLSAnimationScheduler *)info;
+    [animationScheduler endTurn];
+}
@@ -36,6 +36,11 @@
  */
 - (void)terminate;
 
+/**
+ * Same as -terminate, but the animated objects are left in the state they currently appear in (if running animated)
+ */
+- (void)interrupt;
+
 /**
  * The time elapsed since the animation step began animating (might be self.duration if the animation step does 
  * not support arbitrary start times). This method returns the actual running time, removing pauses (if any)
@@ -47,11 +52,51 @@
  */
 - (id)reverseAnimationStep;
 
+/**
+ * Return an animation step with the same settings as the receiver, but animating other objects. Refer to 
+ * -[HLSAnimation animationBySubstitutingObjects:] for more information
+ */
+- (id)animationStepBySubstitutingObjects:(NSDictionary *)objectKeyToSubstituteObjectMap;
+
 /**
  * Return YES iff the animation has been paused
  */
 @property (nonatomic, readonly, assign, getter=isPaused) BOOL paused;
 
+/**
+ * The rate at which the step is played (1 for the normal speed, must be > 0). Can be changed while the step is played
+ * animated. Has no effect for steps which do not provide their animated layers
+ *
+ * Default value is 1
+ */
+@property (nonatomic, assign) float rate;
+
+/**
+ * If set to YES, complex layers (see -rasterizableLayers) are rasterized at screen scale while the step is played
+ * animated. Their original rasterization settings are restored when the step ends
+ *
+ * Default value is NO
+ */
+@property (nonatomic, assign) BOOL automaticallyRasterizingLayers;
+
+/**
+ * Return YES iff the step is being played animated and can be moved in time
+ */
+@property (nonatomic, readonly, assign, getter=isSeekable) BOOL seekable;
+
+/**
+ * Move a seekable step forward in time (backward if negative) by the specified time interval, given in the layer time
+ * space. Does nothing if the step is not seekable
+ */
+- (void)offsetAnimationByTimeInterval:(NSTimeInterval)timeInterval;
+
+/**
+ * Put the step into a per-class pool from which steps are taken when steps are created, copied or reversed, instead
+ * of being allocated. Must only be called from the main thread, when the step is not used anymore by its caller and
+ * has not been made available to client code. Does nothing if the step is running
+ */
+- (void)recycle;
+
 @end
 
 @protocol HLSAnimationStepDelegate <NSObject>
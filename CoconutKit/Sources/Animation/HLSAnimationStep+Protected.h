@@ -6,7 +6,8 @@
 //  Copyright (c) 2012 Hortis. All rights reserved.
 //
 
-#import "HLSObjectAnimation.h"
+// Forward declarations
+@protocol HLSAnimationStepDelegate;
 
 /**
  * Protected interface for use by subclasses of HLSAnimationStep in their implementation, and to be included
@@ -15,16 +16,48 @@
 @interface HLSAnimationStep (Protected)
 
 /**
- * Set an animation for an object
+ * Subclasses must implement this method to return the size of the parameters they store for each animated object
+ * (e.g. sizeof(HLSLayerAnimationParameters)). Those parameters are stored by value in a buffer owned by the step,
+ * so that no object animation needs to be kept, copied or reversed when the step is
  *
- * The object animation is deeply copied to prevent further changes once assigned to a step
+ * The default implementation returns 0 (no object can then be animated)
  */
-- (void)addObjectAnimation:(HLSObjectAnimation *)objectAnimation forObject:(id)object;
++ (size_t)objectAnimationParametersSize;
 
 /**
- * Retrieve the animation for an object (nil if not match is found)
+ * Set the animation parameters for an object. The parameters are copied. If parameters had already been set for
+ * the object, they are replaced (the object keeps its original position among the objects of the step)
  */
-- (HLSObjectAnimation *)objectAnimationForObject:(id)object;
+- (void)addObjectAnimationParameters:(const void *)parameters forObject:(id)object;
+
+/**
+ * Set the same animation parameters for several objects
+ */
+- (void)addObjectAnimationParameters:(const void *)parameters forObjects:(NSArray *)objects;
+
+/**
+ * Retrieve the animation parameters for an object (NULL if no match is found). The returned pointer is valid until
+ * parameters are added to the step
+ */
+- (const void *)objectAnimationParametersForObject:(id)object;
+
+/**
+ * Subclasses must implement this method to calculate the parameters of the reverse animation of an object. The
+ * super method implementation must not be called (it raises an exception)
+ */
+- (void)reverseObjectAnimationParameters:(const void *)parameters intoParameters:(void *)reverseParameters;
+
+/**
+ * Subclasses can implement this method to describe the animation parameters of an object. The default implementation
+ * returns an empty string
+ */
+- (NSString *)descriptionForObjectAnimationParameters:(const void *)parameters;
+
+/**
+ * Called when a step is recycled so that it can be reused, in the same state as a newly created step. Subclasses
+ * must reset their own settings and state, and call the super method implementation
+ */
+- (void)prepareForReuse;
 
 /**
  * All objects changed by the animation step, returned in the order they were added to it
@@ -36,6 +69,11 @@
  */
 @property (nonatomic, assign, getter=isRunning) BOOL running;
 
+/**
+ * The delegate which the step reports events to. Only set while the step is played animated
+ */
+@property (nonatomic, retain) id<HLSAnimationStepDelegate> delegate;
+
 /**
  * Return YES iff the step is being terminated
  */
@@ -81,6 +119,28 @@
  */
 - (void)terminateAnimation;
 
+/**
+ * Subclasses can implement this method to copy the values currently displayed for the animated objects into their
+ * model values, so that they stay where they currently appear when the animation is then terminated. Called only
+ * while the step is played animated. The default implementation does nothing
+ */
+- (void)freezeAnimation;
+
+/**
+ * Subclasses can implement this method to return the layers whose Core Animations implement the step while it is
+ * being played animated. This allows the step to be played at another rate or to be moved in time. The default
+ * implementation returns an empty array, in which case the step is always played at normal speed and is not seekable
+ */
+- (NSArray *)animatedLayers;
+
+/**
+ * Subclasses can implement this method to return the layers which can be rasterized while the step is played animated
+ * (see automaticallyRasterizingLayers), i.e. layers whose content is not changed by the step. Among those, only complex
+ * layers (with many sublayers or requiring offscreen rendering) which are not already rasterized are actually rasterized.
+ * The default implementation returns an empty array
+ */
+- (NSArray *)rasterizableLayers;
+
 /**
  * The corresponding animation step to be played during the reverse animation
  *
@@ -16,12 +16,17 @@
  */
 @interface HLSAnimationStep : NSObject <NSCopying> {
 @private
-    NSMutableArray *m_objectKeys;
-    NSMutableDictionary *m_objectToObjectAnimationMap;
+    CFMutableArrayRef m_objects;                        // Animated objects (not retained), in the order they were added
+    CFMutableDictionaryRef m_objectToIndexMap;          // Maps an animated object (not retained) to its index in m_objects
+    void *m_objectAnimationParameters;                  // Object animation parameters, stored contiguously in the same order
+    NSUInteger m_objectAnimationParametersCapacity;
     NSString *m_tag;
     NSDictionary *m_userInfo;
     NSTimeInterval m_duration;
     id<HLSAnimationStepDelegate> m_delegate;
+    float m_rate;
+    BOOL m_automaticallyRasterizingLayers;
+    NSArray *m_rasterizedLayers;
     BOOL m_terminating;
 }
 
@@ -8,20 +8,45 @@
 
 #import "HLSAnimationStep.h"
 
+#import "CALayer+HLSExtensions.h"
 #import "HLSAnimationStep+Friend.h"
 #import "HLSAnimationStep+Protected.h"
 #import "HLSAssert.h"
 #import "HLSFloat.h"
 #import "HLSLogger.h"
-#import "HLSObjectAnimation+Friend.h"
 #import "NSString+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
+
+// Layers with at least this number of layers in their tree (including themselves) are rasterized when automatic
+// rasterization is enabled
+static const NSUInteger kRasterizationLayerCountThreshold = 10;
+
+// Maximum number of recycled steps kept per class
+static const NSUInteger kMaximumNumberOfRecycledAnimationSteps = 32;
+
+static NSString * const kLayerRasterizationScaleBeforeAutomaticRasterizationKey = @"HLSLayerRasterizationScaleBeforeAutomaticRasterization";
+
+static BOOL layerRequiresOffscreenRendering(CALayer *layer);
+static BOOL layerTreeIsComplex(CALayer *layer, NSUInteger *pNumberOfLayers);
+
+// Maps a step class to the array of its recycled instances. Only accessed from the main thread
+static CFMutableDictionaryRef s_classToRecycledAnimationStepsMap = NULL;
+
 @interface HLSAnimationStep ()
 
-@property (nonatomic, retain) NSMutableArray *objectKeys;
-@property (nonatomic, retain) NSMutableDictionary *objectToObjectAnimationMap;
 @property (nonatomic, retain) id<HLSAnimationStepDelegate> delegate;        // Set during animated animations to retain the delegate
 @property (nonatomic, assign, getter=isCancelling) BOOL terminating;
+@property (nonatomic, retain) NSArray *rasterizedLayers;
+
++ (id)newAnimationStep;
+
+- (void *)objectAnimationParametersAtIndex:(NSUInteger)index;
+- (void *)addObjectAnimationParametersSlotForObject:(id)object;
+
+- (void)rasterizeComplexLayers;
+- (void)restoreRasterizedLayers;
 
 @end
 
@@ -31,7 +56,76 @@
 
 + (id)animationStep
 {
-    return [[[[self class] alloc] init] autorelease];
+    return [[[self class] newAnimationStep] autorelease];
+}
+
++ (size_t)objectAnimationParametersSize
+{
+    return 0;
+}
+
+#pragma mark Recycling
+
+// Return a retained step, taken from the pool if possible
++ (id)newAnimationStep
+{
+    if ([NSThread isMainThread] && s_classToRecycledAnimationStepsMap) {
+        NSMutableArray *recycledAnimationSteps = (NSMutableArray *)CFDictionaryGetValue(s_classToRecycledAnimationStepsMap, self);
+        HLSAnimationStep *animationStep = [[recycledAnimationSteps lastObject] retain];
+        if (animationStep) {
+            [recycledAnimationSteps removeLastObject];
+            return animationStep;
+        }
+    }
+    
+    return [[self alloc] init];
+}
+
+- (void)recycle
+{
+    if (! [NSThread isMainThread]) {
+        HLSLoggerDebug(@"Steps can only be recycled from the main thread");
+        return;
+    }
+    
+    if (self.delegate) {
+        HLSLoggerDebug(@"The animation step is running and cannot be recycled");
+        return;
+    }
+    
+    if (! s_classToRecycledAnimationStepsMap) {
+        s_classToRecycledAnimationStepsMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    }
+    
+    NSMutableArray *recycledAnimationSteps = (NSMutableArray *)CFDictionaryGetValue(s_classToRecycledAnimationStepsMap, [self class]);
+    if (! recycledAnimationSteps) {
+        recycledAnimationSteps = [NSMutableArray array];
+        CFDictionarySetValue(s_classToRecycledAnimationStepsMap, [self class], recycledAnimationSteps);
+    }
+    
+    if ([recycledAnimationSteps count] >= kMaximumNumberOfRecycledAnimationSteps
+            || [recycledAnimationSteps indexOfObjectIdenticalTo:self] != NSNotFound) {
+        return;
+    }
+    
+    [self prepareForReuse];
+    [recycledAnimationSteps addObject:self];
+}
+
+- (void)prepareForReuse
+{
+    // The parameter buffer is kept so that it can be reused
+    CFArrayRemoveAllValues(m_objects);
+    CFDictionaryRemoveAllValues(m_objectToIndexMap);
+    
+    self.tag = nil;
+    self.userInfo = nil;
+    self.duration = 0.2;
+    self.automaticallyRasterizingLayers = NO;
+    self.terminating = NO;
+    self.rasterizedLayers = nil;
+    
+    m_rate = 1.f;
 }
 
 #pragma mark Object creation and destruction
@@ -39,32 +133,33 @@
 - (id)init
 {
     if ((self = [super init])) {
-        self.objectKeys = [NSMutableArray array];
-        self.objectToObjectAnimationMap = [NSMutableDictionary dictionary];
+        // Pointer identity, objects are not retained
+        m_objects = CFArrayCreateMutable(kCFAllocatorDefault, 0, NULL);
+        m_objectToIndexMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
         
         // Default animation settings (as given in UIKit documentation)
-        self.duration = 0.2;        
+        self.duration = 0.2;
+        
+        m_rate = 1.f;
     }
     return self;
 }
 
 - (void)dealloc
 {    
-    self.objectKeys = nil;
-    self.objectToObjectAnimationMap = nil;
+    CFRelease(m_objects);
+    CFRelease(m_objectToIndexMap);
+    free(m_objectAnimationParameters);
     self.tag = nil;
     self.userInfo = nil;
     self.delegate = nil;
+    self.rasterizedLayers = nil;
     
     [super dealloc];
 }
 
 #pragma mark Accessors and mutators
 
-@synthesize objectKeys = m_objectKeys;
-
-@synthesize objectToObjectAnimationMap = m_objectToObjectAnimationMap;
-
 @synthesize tag = m_tag;
 
 @synthesize userInfo = m_userInfo;
@@ -92,21 +187,68 @@
 
 @synthesize terminating = m_terminating;
 
-- (NSArray *)objects
+@synthesize rate = m_rate;
+
+- (void)setRate:(float)rate
 {
-    NSMutableArray *objects = [NSMutableArray array];
-    for (NSValue *objectKey in self.objectKeys) {
-        id object = [objectKey pointerValue];
-        [objects addObject:object];
+    if (floatle(rate, 0.f)) {
+        HLSLoggerError(@"The rate must be > 0");
+        return;
+    }
+    
+    m_rate = rate;
+    
+    // Apply to a step being played animated
+    if (self.delegate) {
+        for (CALayer *layer in [self animatedLayers]) {
+            [layer setAnimationSpeed:rate];
+        }
     }
-    return [NSArray arrayWithArray:objects];
+}
+
+@synthesize automaticallyRasterizingLayers = m_automaticallyRasterizingLayers;
+
+@synthesize rasterizedLayers = m_rasterizedLayers;
+
+- (BOOL)isSeekable
+{
+    return self.delegate && ! self.terminating && [[self animatedLayers] count] != 0;
+}
+
+- (NSArray *)objects
+{
+    return [NSArray arrayWithArray:(NSArray *)m_objects];
 }
 
 #pragma mark Animations in the step
 
-- (void)addObjectAnimation:(id)objectAnimation forObject:(id)object
+- (void *)objectAnimationParametersAtIndex:(NSUInteger)index
 {
-    if (! objectAnimation) {
+    return (char *)m_objectAnimationParameters + index * [[self class] objectAnimationParametersSize];
+}
+
+// Return the slot where the parameters of the object must be stored, appending the object if not already animated
+- (void *)addObjectAnimationParametersSlotForObject:(id)object
+{
+    const void *value = NULL;
+    if (CFDictionaryGetValueIfPresent(m_objectToIndexMap, object, &value)) {
+        return [self objectAnimationParametersAtIndex:(NSUInteger)value];
+    }
+    
+    NSUInteger index = CFArrayGetCount(m_objects);
+    if (index == m_objectAnimationParametersCapacity) {
+        m_objectAnimationParametersCapacity = MAX(2 * m_objectAnimationParametersCapacity, 4);
+        m_objectAnimationParameters = realloc(m_objectAnimationParameters,
+                                              m_objectAnimationParametersCapacity * [[self class] objectAnimationParametersSize]);
+    }
+    CFArrayAppendValue(m_objects, object);
+    CFDictionarySetValue(m_objectToIndexMap, object, (const void *)index);
+    return [self objectAnimationParametersAtIndex:index];
+}
+
+- (void)addObjectAnimationParameters:(const void *)parameters forObject:(id)object
+{
+    if (! parameters) {
         HLSLoggerDebug(@"No animation for the object");
         return;
     }
@@ -116,19 +258,35 @@
         return;
     }
     
-    NSValue *objectKey = [NSValue valueWithPointer:object];
-    [self.objectKeys addObject:objectKey];
-    [self.objectToObjectAnimationMap setObject:[[objectAnimation copy] autorelease] forKey:objectKey];
+    size_t parametersSize = [[self class] objectAnimationParametersSize];
+    if (parametersSize == 0) {
+        HLSLoggerError(@"The step does not store any object animation parameters");
+        return;
+    }
+    
+    memcpy([self addObjectAnimationParametersSlotForObject:object], parameters, parametersSize);
 }
 
-- (id)objectAnimationForObject:(id)object
+- (void)addObjectAnimationParameters:(const void *)parameters forObjects:(NSArray *)objects
 {
-    if (! object) {
-        return nil;
+    if (! parameters) {
+        HLSLoggerDebug(@"No animation for the objects");
+        return;
+    }
+    
+    for (id object in objects) {
+        [self addObjectAnimationParameters:parameters forObject:object];
+    }
+}
+
+- (const void *)objectAnimationParametersForObject:(id)object
+{
+    const void *value = NULL;
+    if (! object || ! CFDictionaryGetValueIfPresent(m_objectToIndexMap, object, &value)) {
+        return NULL;
     }
     
-    NSValue *objectKey = [NSValue valueWithPointer:object];
-    return [self.objectToObjectAnimationMap objectForKey:objectKey];
+    return [self objectAnimationParametersAtIndex:(NSUInteger)value];
 }
 
 #pragma mark Managing the animation
@@ -147,9 +305,21 @@
         self.delegate = delegate;
     }
     
+    // Rasterize layers before the animations are created, so that they start from the rasterized state
+    if (actuallyAnimated && self.automaticallyRasterizingLayers) {
+        [self rasterizeComplexLayers];
+    }
+    
     // Call the subclass implementation
     [self playAnimationWithStartTime:startTime animated:actuallyAnimated];
     
+    // Apply the rate to the animations which have just been created
+    if (actuallyAnimated && ! floateq(self.rate, 1.f)) {
+        for (CALayer *layer in [self animatedLayers]) {
+            [layer setAnimationSpeed:self.rate];
+        }
+    }
+    
     // Not animated (i.e. synchronously animated to the final position)
     if (! actuallyAnimated) {
         // Same remark as above
@@ -191,15 +361,102 @@
     
     self.terminating = YES;
     
+    // Restore the normal speed of the layers which have been animated
+    if (! floateq(self.rate, 1.f)) {
+        for (CALayer *layer in [self animatedLayers]) {
+            [layer setAnimationSpeed:1.f];
+        }
+    }
+    
     // Call the subclass implementation
     [self terminateAnimation];
-        
+    
+    [self restoreRasterizedLayers];
+    
     // Same remark as above
     if ([self.delegate respondsToSelector:@selector(animationStepDidStop:animated:finished:)]) {
         [self.delegate animationStepDidStop:self animated:NO finished:NO];
     }
 }
 
+- (void)interrupt
+{
+    if (self.terminating) {
+        HLSLoggerDebug(@"The animation step is already being terminated");
+        return;
+    }
+    
+    if (self.delegate) {
+        [self freezeAnimation];
+    }
+    
+    [self terminate];
+}
+
+- (void)offsetAnimationByTimeInterval:(NSTimeInterval)timeInterval
+{
+    if (! self.seekable) {
+        HLSLoggerDebug(@"The animation step cannot be moved in time");
+        return;
+    }
+    
+    for (CALayer *layer in [self animatedLayers]) {
+        [layer offsetAnimationsByTimeInterval:timeInterval];
+    }
+}
+
+- (void)rasterizeComplexLayers
+{
+    NSMutableArray *rasterizedLayers = [NSMutableArray array];
+    CGFloat screenScale = [UIScreen mainScreen].scale;
+    
+    // Standalone layers (not backing a view) would otherwise animate the change
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    
+    for (CALayer *layer in [self rasterizableLayers]) {
+        if (layer.shouldRasterize || [rasterizedLayers containsObject:layer]) {
+            continue;
+        }
+        
+        NSUInteger numberOfLayers = 0;
+        if (! layerTreeIsComplex(layer, &numberOfLayers)) {
+            continue;
+        }
+        
+        [layer setValue:[NSNumber numberWithFloat:layer.rasterizationScale] forKey:kLayerRasterizationScaleBeforeAutomaticRasterizationKey];
+        layer.shouldRasterize = YES;
+        layer.rasterizationScale = screenScale;
+        [rasterizedLayers addObject:layer];
+    }
+    
+    [CATransaction commit];
+    
+    // Layers are retained until their settings have been restored (steps do not retain the objects they animate)
+    self.rasterizedLayers = [NSArray arrayWithArray:rasterizedLayers];
+}
+
+- (void)restoreRasterizedLayers
+{
+    if ([self.rasterizedLayers count] == 0) {
+        return;
+    }
+    
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    
+    for (CALayer *layer in self.rasterizedLayers) {
+        NSNumber *rasterizationScaleNumber = [layer valueForKey:kLayerRasterizationScaleBeforeAutomaticRasterizationKey];
+        layer.rasterizationScale = [rasterizationScaleNumber floatValue];
+        layer.shouldRasterize = NO;
+        [layer setValue:nil forKey:kLayerRasterizationScaleBeforeAutomaticRasterizationKey];
+    }
+    
+    [CATransaction commit];
+    
+    self.rasterizedLayers = nil;
+}
+
 - (void)playAnimationAnimated:(BOOL)animated
 {
     HLSMissingMethodImplementation();
@@ -226,6 +483,19 @@
     HLSMissingMethodImplementation();
 }
 
+- (void)freezeAnimation
+{}
+
+- (NSArray *)animatedLayers
+{
+    return [NSArray array];
+}
+
+- (NSArray *)rasterizableLayers
+{
+    return [NSArray array];
+}
+
 - (NSTimeInterval)elapsedTime;
 {
     HLSMissingMethodImplementation();
@@ -234,12 +504,20 @@
 
 #pragma mark Reverse animation
 
+- (void)reverseObjectAnimationParameters:(const void *)parameters intoParameters:(void *)reverseParameters
+{
+    HLSMissingMethodImplementation();
+}
+
 - (id)reverseAnimationStep
 {
-    HLSAnimationStep *reverseAnimationStep = [[self class] animationStep];
-    for (id object in [self objects]) {
-        HLSObjectAnimation *objectAnimation = [self objectAnimationForObject:object];
-        [reverseAnimationStep addObjectAnimation:[objectAnimation reverseObjectAnimation] forObject:object];
+    // Parameters are reversed in place, without any intermediate object
+    HLSAnimationStep *reverseAnimationStep = [[[self class] newAnimationStep] autorelease];
+    NSUInteger numberOfObjects = CFArrayGetCount(m_objects);
+    for (NSUInteger i = 0; i < numberOfObjects; ++i) {
+        id object = (id)CFArrayGetValueAtIndex(m_objects, i);
+        [self reverseObjectAnimationParameters:[self objectAnimationParametersAtIndex:i]
+                                intoParameters:[reverseAnimationStep addObjectAnimationParametersSlotForObject:object]];
     }
     reverseAnimationStep.tag = [self.tag isFilled] ? [NSString stringWithFormat:@"reverse_%@", self.tag] : nil;
     reverseAnimationStep.userInfo = self.userInfo;
@@ -247,13 +525,46 @@
     return reverseAnimationStep;
 }
 
+#pragma mark Substituting objects
+
+- (id)animationStepBySubstitutingObjects:(NSDictionary *)objectKeyToSubstituteObjectMap
+{
+    HLSAnimationStep *animationStep = [[[self class] newAnimationStep] autorelease];
+    NSUInteger numberOfObjects = CFArrayGetCount(m_objects);
+    for (NSUInteger i = 0; i < numberOfObjects; ++i) {
+        id object = (id)CFArrayGetValueAtIndex(m_objects, i);
+        id substituteObject = [objectKeyToSubstituteObjectMap objectForKey:[NSValue valueWithPointer:object]];
+        if (substituteObject == [NSNull null]) {
+            continue;
+        }
+        else if (substituteObject) {
+            object = substituteObject;
+        }
+        
+        [animationStep addObjectAnimationParameters:[self objectAnimationParametersAtIndex:i] forObject:object];
+    }
+    animationStep.tag = self.tag;
+    animationStep.userInfo = self.userInfo;
+    animationStep.duration = self.duration;
+    return animationStep;
+}
+
 #pragma mark Delegate notification
 
 - (void)notifyAsynchronousAnimationStepDidStopFinished:(BOOL)finished
 {
     // If the animation is terminated, this event was already emitted when termination occurs (to avoid
     // waiting too long on this event to occur asynchronously). Do not notify again here
+    [self restoreRasterizedLayers];
+    
     if (! self.terminating) {
+        // Same remark as in -terminate
+        if (! floateq(self.rate, 1.f)) {
+            for (CALayer *layer in [self animatedLayers]) {
+                [layer setAnimationSpeed:1.f];
+            }
+        }
+        
         // This method is meant to be called in the animation stop callback, which is called for animations
         // with animated = YES
         [self.delegate animationStepDidStop:self animated:YES finished:YES];
@@ -268,11 +579,15 @@
 
 - (id)copyWithZone:(NSZone *)zone
 {
-    HLSAnimationStep *animationStepCopy = [[[self class] allocWithZone:zone] init];
-    for (id object in [self objects]) {
-        HLSObjectAnimation *objectAnimation = [self objectAnimationForObject:object];
-        HLSObjectAnimation *objectAnimationCopy = [[objectAnimation copyWithZone:zone] autorelease];
-        [animationStepCopy addObjectAnimation:objectAnimationCopy forObject:object];
+    // Parameters are stored by value and copied at once. Copies are taken from the pool, zones being ignored anyway
+    HLSAnimationStep *animationStepCopy = [[self class] newAnimationStep];
+    NSUInteger numberOfObjects = CFArrayGetCount(m_objects);
+    for (NSUInteger i = 0; i < numberOfObjects; ++i) {
+        [animationStepCopy addObjectAnimationParametersSlotForObject:(id)CFArrayGetValueAtIndex(m_objects, i)];
+    }
+    if (numberOfObjects != 0) {
+        memcpy(animationStepCopy->m_objectAnimationParameters, m_objectAnimationParameters,
+               numberOfObjects * [[self class] objectAnimationParametersSize]);
     }
     animationStepCopy.tag = self.tag;
     animationStepCopy.userInfo = self.userInfo;
@@ -282,12 +597,19 @@
 
 #pragma mark Description
 
+- (NSString *)descriptionForObjectAnimationParameters:(const void *)parameters
+{
+    return @"";
+}
+
 - (NSString *)objectAnimationsDescriptionString
 {
     NSString *objectAnimationsDescriptionString = @"{";
-    for (id object in [self objects]) {
-        HLSObjectAnimation *objectAnimation = [self objectAnimationForObject:object];
-        objectAnimationsDescriptionString = [objectAnimationsDescriptionString stringByAppendingFormat:@"\n\t%@ - %@", object, objectAnimation];        
+    NSUInteger numberOfObjects = CFArrayGetCount(m_objects);
+    for (NSUInteger i = 0; i < numberOfObjects; ++i) {
+        id object = (id)CFArrayGetValueAtIndex(m_objects, i);
+        NSString *parametersDescription = [self descriptionForObjectAnimationParameters:[self objectAnimationParametersAtIndex:i]];
+        objectAnimationsDescriptionString = [objectAnimationsDescriptionString stringByAppendingFormat:@"\n\t%@ - %@", object, parametersDescription];
     }
     return [objectAnimationsDescriptionString stringByAppendingFormat:@"\n}"];
 }
@@ -303,3 +625,29 @@
 }
 
 @end
+
+#pragma mark Static functions
+
+static BOOL layerRequiresOffscreenRendering(CALayer *layer)
+{
+    return layer.mask
+        || (layer.masksToBounds && floatgt(layer.cornerRadius, 0.f))
+        || (floatgt(layer.shadowOpacity, 0.f) && ! layer.shadowPath);
+}
+
+// Return YES as soon as the layer tree is found to be complex (large or requiring offscreen rendering). The number of layers
+// visited so far is updated during the traversal
+static BOOL layerTreeIsComplex(CALayer *layer, NSUInteger *pNumberOfLayers)
+{
+    ++(*pNumberOfLayers);
+    if (*pNumberOfLayers >= kRasterizationLayerCountThreshold || layerRequiresOffscreenRendering(layer)) {
+        return YES;
+    }
+    
+    for (CALayer *sublayer in layer.sublayers) {
+        if (layerTreeIsComplex(sublayer, pNumberOfLayers)) {
+            return YES;
+        }
+    }
+    return NO;
+}
@@ -13,33 +13,24 @@
 @interface HLSLayerAnimation (Friend)
 
 /**
- * The transform corresponding to the view animation settings
+ * The parameters of the layer animation, including the derived transforms
  */
-@property (nonatomic, readonly, assign) CATransform3D transform;
+@property (nonatomic, readonly, assign) HLSLayerAnimationParameters parameters;
 
-/**
- * The sublayer transform corresponding to the view animation settings
- */
-@property (nonatomic, readonly, assign) CATransform3D sublayerTransform;
-
-/**
- * The z-translation to apply to the camera from which sublayers are seen
- */
-@property (nonatomic, readonly, assign) CGFloat sublayerCameraTranslationZ;
+@end
 
 /**
- * The translation to apply to the layer anchor point
+ * Return the parameters of the inverse animation
  */
-@property (nonatomic, readonly, assign) HLSVector3 anchorPointTranslationParameters;
+HLSLayerAnimationParameters HLSLayerAnimationParametersReverse(HLSLayerAnimationParameters parameters);
 
 /**
- * The increment to apply to the layer opacity value
+ * Return the parameters corresponding to the specified fraction of a layer animation (0 for no change, 1 for the
+ * animation itself; values outside this range extrapolate it). Rasterization is never toggled by the returned parameters
  */
-@property (nonatomic, readonly, assign) CGFloat opacityIncrement;
+HLSLayerAnimationParameters HLSLayerAnimationParametersAtProgress(HLSLayerAnimationParameters parameters, CGFloat progress);
 
 /**
- * The increment to apply to the layer rasterization scale
+ * Return a human-readable description of layer animation parameters
  */
-@property (nonatomic, readonly, assign) CGFloat rasterizationScaleIncrement;
-
-@end
+NSString *HLSStringFromLayerAnimationParameters(HLSLayerAnimationParameters parameters);
@@ -10,6 +10,25 @@
 
 #import "HLSVector.h"
 
+/**
+ * The parameters of a layer animation, stored by value in the layer animation steps they are added to
+ */
+typedef struct {
+    HLSVector4 rotationParameters;
+    HLSVector3 scaleParameters;
+    HLSVector3 translationParameters;
+    HLSVector3 anchorPointTranslationParameters;
+    HLSVector4 sublayerRotationParameters;
+    HLSVector3 sublayerScaleParameters;
+    HLSVector3 sublayerTranslationParameters;
+    CGFloat sublayerCameraTranslationZ;
+    CGFloat opacityIncrement;
+    CGFloat rasterizationScaleIncrement;
+    BOOL togglingShouldRasterize;
+    CATransform3D transform;                            // Derived from the rotation, scale and translation parameters
+    CATransform3D sublayerTransform;                    // Derived from the sublayer rotation, scale and translation parameters
+} HLSLayerAnimationParameters;
+
 /**
  * A layer animation (HLSLayerAnimation) describes the changes applied to a layer within an animation step
  * (HLSLayerAnimationStep). An animation step is the combination of several layer animations applied
@@ -28,21 +47,16 @@
  * In general, and if you do not need to animate view frames to resize subviews during animations, you should
  * use layer animations instead of view animations since they have far more capabilities.
  *
+ * A layer animation is a lightweight builder: When added to a step, its parameters are copied by value into the step,
+ * so that the layer animation object can be released (or reused to build other steps) right afterwards
+ *
  * Designated initializer: -init (create a layer animation step with default settings)
  */
 @interface HLSLayerAnimation : HLSObjectAnimation {
 @private
-    HLSVector4 m_rotationParameters;
-    HLSVector3 m_scaleParameters;
-    HLSVector3 m_translationParameters;
-    HLSVector3 m_anchorPointTranslationParameters;
-    HLSVector4 m_sublayerRotationParameters;
-    HLSVector3 m_sublayerScaleParameters;
-    HLSVector3 m_sublayerTranslationParameters;
-    CGFloat m_sublayerCameraTranslationZ;
-    CGFloat m_opacityIncrement;
-    BOOL m_togglingShouldRasterize;
-    CGFloat m_rasterizationScaleIncrement;
+    HLSLayerAnimationParameters m_parameters;
+    BOOL m_transformValid;
+    BOOL m_sublayerTransformValid;
 }
 
 /**
@@ -9,10 +9,14 @@
 #import "HLSLayerAnimation.h"
 
 #import "HLSFloat.h"
+#import "HLSLayerAnimation+Friend.h"
 #import "HLSLogger.h"
 #import "HLSObjectAnimation+Friend.h"
 #import "NSString+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
+
 /**
  * Just a few important remarks about transforms (CATransform3D and CGAffineTransform):
  *   - transforms are applied on the right: F' = F * T, where F is a frame (this is what CGRectApplyAffineTransform
@@ -33,28 +37,9 @@
  *     must be kept separate, so that the reverse animation can be easily computed
  */
 
-@interface HLSLayerAnimation ()
-
-@property (nonatomic, assign) HLSVector4 rotationParameters;
-@property (nonatomic, assign) HLSVector3 scaleParameters;
-@property (nonatomic, assign) HLSVector3 translationParameters;
-@property (nonatomic, assign) HLSVector3 anchorPointTranslationParameters;
-@property (nonatomic, assign) HLSVector4 sublayerRotationParameters;
-@property (nonatomic, assign) HLSVector3 sublayerScaleParameters;
-@property (nonatomic, assign) HLSVector3 sublayerTranslationParameters;
-@property (nonatomic, assign) CGFloat sublayerCameraTranslationZ;
-@property (nonatomic, assign) CGFloat opacityIncrement;
-@property (nonatomic, assign) CGFloat rasterizationScaleIncrement;
-
-- (CATransform3D)rotationTransform;
-- (CATransform3D)scaleTransform;
-- (CATransform3D)translationTransform;
-
-- (CATransform3D)sublayerRotationTransform;
-- (CATransform3D)sublayerScaleTransform;
-- (CATransform3D)sublayerTranslationTransform;
-
-@end
+// Function declarations
+static HLSLayerAnimationParameters layerAnimationParametersIdentity(void);
+static HLSLayerAnimationParameters layerAnimationParametersWithTransforms(HLSLayerAnimationParameters parameters);
 
 @implementation HLSLayerAnimation
 
@@ -64,118 +49,62 @@
 {
     if ((self = [super init])) {
         // Default: No change
-        self.rotationParameters = HLSVector4Make(0.f, 1.f, 0.f, 0.f);
-        self.scaleParameters = HLSVector3Make(1.f, 1.f, 1.f);
-        self.translationParameters = HLSVector3Make(0.f, 0.f, 0.f);
-        self.anchorPointTranslationParameters = HLSVector3Make(0.f, 0.f, 0.f);
-        
-        self.sublayerRotationParameters = HLSVector4Make(0.f, 1.f, 0.f, 0.f);
-        self.sublayerScaleParameters = HLSVector3Make(1.f, 1.f, 1.f);
-        self.sublayerTranslationParameters = HLSVector3Make(0.f, 0.f, 0.f);
-        
-        self.sublayerCameraTranslationZ = 0.f;
+        m_parameters = layerAnimationParametersIdentity();
+        m_transformValid = YES;
+        m_sublayerTransformValid = YES;
     }
     return self;
 }
 
 #pragma mark Accessors and mutators
 
-@synthesize rotationParameters = m_rotationParameters;
-
-@synthesize scaleParameters = m_scaleParameters;
-
-@synthesize translationParameters = m_translationParameters;
-
-@synthesize anchorPointTranslationParameters = m_anchorPointTranslationParameters;
-
-@synthesize sublayerRotationParameters = m_sublayerRotationParameters;
-
-@synthesize sublayerScaleParameters = m_sublayerScaleParameters;
-
-@synthesize sublayerTranslationParameters = m_sublayerTranslationParameters;
-
-@synthesize sublayerCameraTranslationZ = m_sublayerCameraTranslationZ;
-
-@synthesize opacityIncrement = m_opacityIncrement;
-
-@synthesize togglingShouldRasterize = m_togglingShouldRasterize;
-
-@synthesize rasterizationScaleIncrement = m_rasterizationScaleIncrement;
-
-- (CATransform3D)transform
-{
-    CATransform3D transform = [self rotationTransform];
-    transform = CATransform3DConcat(transform, [self scaleTransform]);
-    return CATransform3DConcat(transform, [self translationTransform]);
-}
-
-- (CATransform3D)rotationTransform
-{
-    return CATransform3DMakeRotation(self.rotationParameters.v1,
-                                     self.rotationParameters.v2,
-                                     self.rotationParameters.v3,
-                                     self.rotationParameters.v4);
-}
-
-- (CATransform3D)scaleTransform
-{
-    return CATransform3DMakeScale(self.scaleParameters.v1,
-                                  self.scaleParameters.v2,
-                                  self.scaleParameters.v3);
-}
-
-- (CATransform3D)translationTransform
-{
-    return CATransform3DMakeTranslation(self.translationParameters.v1,
-                                        self.translationParameters.v2,
-                                        self.translationParameters.v3);
-}
-
-- (CATransform3D)sublayerTransform
-{
-    CATransform3D sublayerTransform = [self sublayerRotationTransform];
-    sublayerTransform = CATransform3DConcat(sublayerTransform, [self sublayerScaleTransform]);
-    sublayerTransform = CATransform3DConcat(sublayerTransform, [self sublayerTranslationTransform]);
-    return sublayerTransform;
-}
-
-- (CATransform3D)sublayerRotationTransform;
+- (BOOL)isTogglingShouldRasterize
 {
-    return CATransform3DMakeRotation(self.sublayerRotationParameters.v1,
-                                     self.sublayerRotationParameters.v2,
-                                     self.sublayerRotationParameters.v3,
-                                     self.sublayerRotationParameters.v4);
+    return m_parameters.togglingShouldRasterize;
 }
 
-- (CATransform3D)sublayerScaleTransform
+- (void)setTogglingShouldRasterize:(BOOL)togglingShouldRasterize
 {
-    return CATransform3DMakeScale(self.sublayerScaleParameters.v1,
-                                  self.sublayerScaleParameters.v2,
-                                  self.sublayerScaleParameters.v3);
+    m_parameters.togglingShouldRasterize = togglingShouldRasterize;
 }
 
-- (CATransform3D)sublayerTranslationTransform
+- (HLSLayerAnimationParameters)parameters
 {
-    return CATransform3DMakeTranslation(self.sublayerTranslationParameters.v1,
-                                        self.sublayerTranslationParameters.v2,
-                                        self.sublayerTranslationParameters.v3);
+    // Calculated once and cached, since animations are usually added to several steps (e.g. when building animations
+    // for table view cells)
+    if (! m_transformValid) {
+        m_parameters.transform = HLSTransform3DMakeRotationScaleTranslation(m_parameters.rotationParameters,
+                                                                            m_parameters.scaleParameters,
+                                                                            m_parameters.translationParameters);
+        m_transformValid = YES;
+    }
+    if (! m_sublayerTransformValid) {
+        m_parameters.sublayerTransform = HLSTransform3DMakeRotationScaleTranslation(m_parameters.sublayerRotationParameters,
+                                                                                    m_parameters.sublayerScaleParameters,
+                                                                                    m_parameters.sublayerTranslationParameters);
+        m_sublayerTransformValid = YES;
+    }
+    return m_parameters;
 }
 
 #pragma mark Convenience methods
 
 - (void)rotateByAngle:(CGFloat)angle aboutVectorWithX:(CGFloat)x y:(CGFloat)y z:(CGFloat)z
 {
-    self.rotationParameters = HLSVector4Make(angle, x, y, z);
+    m_parameters.rotationParameters = HLSVector4Make(angle, x, y, z);
+    m_transformValid = NO;
 }
 
 - (void)scaleWithXFactor:(CGFloat)xFactor yFactor:(CGFloat)yFactor zFactor:(CGFloat)zFactor
 {
-    self.scaleParameters = HLSVector3Make(xFactor, yFactor, zFactor);
+    m_parameters.scaleParameters = HLSVector3Make(xFactor, yFactor, zFactor);
+    m_transformValid = NO;
 }
 
 - (void)translateByVectorWithX:(CGFloat)x y:(CGFloat)y z:(CGFloat)z
 {
-    self.translationParameters = HLSVector3Make(x, y, z);
+    m_parameters.translationParameters = HLSVector3Make(x, y, z);
+    m_transformValid = NO;
 }
 
 - (void)rotateByAngle:(CGFloat)angle
@@ -195,7 +124,7 @@
 
 - (void)translateAnchorPointByVectorWithX:(CGFloat)x y:(CGFloat)y z:(CGFloat)z
 {
-    self.anchorPointTranslationParameters = HLSVector3Make(x, y, z);
+    m_parameters.anchorPointTranslationParameters = HLSVector3Make(x, y, z);
 }
 
 - (void)translateAnchorPointByVectorWithX:(CGFloat)x y:(CGFloat)y
@@ -206,29 +135,33 @@
 - (void)transformFromRect:(CGRect)fromRect toRect:(CGRect)toRect
 {
     // No rotation required
-    self.rotationParameters = HLSVector4Make(0.f, 1.f, 0.f, 0.f);
+    m_parameters.rotationParameters = HLSVector4Make(0.f, 1.f, 0.f, 0.f);
     
-    self.scaleParameters = HLSVector3Make(CGRectGetWidth(toRect) / CGRectGetWidth(fromRect),
-                                          CGRectGetHeight(toRect) / CGRectGetHeight(fromRect),
-                                          1.f);
-    self.translationParameters = HLSVector3Make(CGRectGetMidX(toRect) - CGRectGetMidX(fromRect),
-                                                CGRectGetMidY(toRect) - CGRectGetMidY(fromRect),
-                                                0.f);
+    m_parameters.scaleParameters = HLSVector3Make(CGRectGetWidth(toRect) / CGRectGetWidth(fromRect),
+                                                  CGRectGetHeight(toRect) / CGRectGetHeight(fromRect),
+                                                  1.f);
+    m_parameters.translationParameters = HLSVector3Make(CGRectGetMidX(toRect) - CGRectGetMidX(fromRect),
+                                                        CGRectGetMidY(toRect) - CGRectGetMidY(fromRect),
+                                                        0.f);
+    m_transformValid = NO;
 }
 
 - (void)rotateSublayersByAngle:(CGFloat)angle aboutVectorWithX:(CGFloat)x y:(CGFloat)y z:(CGFloat)z
 {
-    self.sublayerRotationParameters = HLSVector4Make(angle, x, y, z);
+    m_parameters.sublayerRotationParameters = HLSVector4Make(angle, x, y, z);
+    m_sublayerTransformValid = NO;
 }
 
 - (void)scaleSublayersWithXFactor:(CGFloat)xFactor yFactor:(CGFloat)yFactor zFactor:(CGFloat)zFactor
 {
-    self.sublayerScaleParameters = HLSVector3Make(xFactor, yFactor, zFactor);
+    m_parameters.sublayerScaleParameters = HLSVector3Make(xFactor, yFactor, zFactor);
+    m_sublayerTransformValid = NO;
 }
 
 - (void)translateSublayersByVectorWithX:(CGFloat)x y:(CGFloat)y z:(CGFloat)z
 {
-    self.sublayerTranslationParameters = HLSVector3Make(x, y, z);
+    m_parameters.sublayerTranslationParameters = HLSVector3Make(x, y, z);
+    m_sublayerTransformValid = NO;
 }
 
 - (void)rotateSublayersByAngle:(CGFloat)angle
@@ -248,7 +181,7 @@
 
 - (void)translateSublayerCameraByVectorWithZ:(CGFloat)z
 {    
-    self.sublayerCameraTranslationZ = z;
+    m_parameters.sublayerCameraTranslationZ = z;
 }
 
 - (void)addToOpacity:(CGFloat)opacityIncrement
@@ -256,58 +189,28 @@
     // Sanitize input
     if (floatlt(opacityIncrement, -1.f)) {
         HLSLoggerWarn(@"Opacity increment cannot be smaller than -1. Fixed to -1");
-        m_opacityIncrement = -1.f;
+        m_parameters.opacityIncrement = -1.f;
     }
     else if (floatgt(opacityIncrement, 1.f)) {
         HLSLoggerWarn(@"Opacity increment cannot be larger than 1. Fixed to 1");
-        m_opacityIncrement = 1.f;
+        m_parameters.opacityIncrement = 1.f;
     }
     else {
-        m_opacityIncrement = opacityIncrement;
+        m_parameters.opacityIncrement = opacityIncrement;
     }
 }
 
 - (void)addToRasterizationScale:(CGFloat)rasterizationScaleIncrement
 {
-    self.rasterizationScaleIncrement = rasterizationScaleIncrement;
+    m_parameters.rasterizationScaleIncrement = rasterizationScaleIncrement;
 }
 
 #pragma mark Reverse animation
 
 - (id)reverseObjectAnimation
 {
-    // See remarks at the beginning
     HLSLayerAnimation *reverseLayerAnimation = [super reverseObjectAnimation];
-    
-    [reverseLayerAnimation rotateByAngle:-self.rotationParameters.v1
-                        aboutVectorWithX:self.rotationParameters.v2
-                                       y:self.rotationParameters.v3
-                                       z:self.rotationParameters.v4];
-    [reverseLayerAnimation scaleWithXFactor:1.f / self.scaleParameters.v1
-                                    yFactor:1.f / self.scaleParameters.v2
-                                    zFactor:1.f / self.scaleParameters.v3];
-    [reverseLayerAnimation translateByVectorWithX:-self.translationParameters.v1
-                                                y:-self.translationParameters.v2
-                                                z:-self.translationParameters.v3];
-    [reverseLayerAnimation translateAnchorPointByVectorWithX:-self.anchorPointTranslationParameters.v1
-                                                           y:-self.anchorPointTranslationParameters.v2
-                                                           z:-self.anchorPointTranslationParameters.v3];
-    
-    [reverseLayerAnimation rotateSublayersByAngle:-self.sublayerRotationParameters.v1
-                                 aboutVectorWithX:self.sublayerRotationParameters.v2
-                                                y:self.sublayerRotationParameters.v3
-                                                z:self.sublayerRotationParameters.v4];
-    [reverseLayerAnimation scaleSublayersWithXFactor:1.f / self.sublayerScaleParameters.v1
-                                             yFactor:1.f / self.sublayerScaleParameters.v2
-                                             zFactor:1.f / self.sublayerScaleParameters.v3];
-    [reverseLayerAnimation translateSublayersByVectorWithX:-self.sublayerTranslationParameters.v1
-                                                         y:-self.sublayerTranslationParameters.v2
-                                                         z:-self.sublayerTranslationParameters.v3];
-    [reverseLayerAnimation translateSublayerCameraByVectorWithZ:-self.sublayerCameraTranslationZ];
-    
-    reverseLayerAnimation.opacityIncrement = -self.opacityIncrement;
-    reverseLayerAnimation.togglingShouldRasterize = self.togglingShouldRasterize;
-    reverseLayerAnimation.rasterizationScaleIncrement = -self.rasterizationScaleIncrement;
+    reverseLayerAnimation->m_parameters = HLSLayerAnimationParametersReverse([self parameters]);
     return reverseLayerAnimation;
 }
 
@@ -317,19 +220,11 @@
 {
     HLSLayerAnimation *layerAnimationCopy = [super copyWithZone:zone];
     
-    layerAnimationCopy.rotationParameters = self.rotationParameters;
-    layerAnimationCopy.scaleParameters = self.scaleParameters;
-    layerAnimationCopy.translationParameters = self.translationParameters;
-    layerAnimationCopy.anchorPointTranslationParameters = self.anchorPointTranslationParameters;
+    // Copy the derived transforms as well so that they are not calculated again
+    layerAnimationCopy->m_parameters = m_parameters;
+    layerAnimationCopy->m_transformValid = m_transformValid;
+    layerAnimationCopy->m_sublayerTransformValid = m_sublayerTransformValid;
     
-    layerAnimationCopy.sublayerRotationParameters = self.sublayerRotationParameters;
-    layerAnimationCopy.sublayerScaleParameters = self.sublayerScaleParameters;
-    layerAnimationCopy.sublayerTranslationParameters = self.sublayerTranslationParameters;
-    layerAnimationCopy.sublayerCameraTranslationZ = self.sublayerCameraTranslationZ;
-    
-    layerAnimationCopy.opacityIncrement = self.opacityIncrement;
-    layerAnimationCopy.togglingShouldRasterize = self.togglingShouldRasterize;
-    layerAnimationCopy.rasterizationScaleIncrement = self.rasterizationScaleIncrement;
     return layerAnimationCopy;
 }
 
@@ -337,16 +232,108 @@
 
 - (NSString *)description
 {
-    return [NSString stringWithFormat:@"<%@: %p; rotationParamers: %@; scaleParameters: %@; translationParameters: %@; "
-            "opacityIncrement: %.2f; sublayerCameraTranslationZ: %.2f; rasterizationScaleIncrement: %.2f>",
+    return [NSString stringWithFormat:@"<%@: %p; %@>",
             [self class],
             self,
-            HLSStringFromVector4(self.rotationParameters),
-            HLSStringFromVector3(self.scaleParameters),
-            HLSStringFromVector3(self.translationParameters),
-            self.opacityIncrement,
-            self.sublayerCameraTranslationZ,
-            self.rasterizationScaleIncrement];
+            HLSStringFromLayerAnimationParameters([self parameters])];
 }
 
 @end
+
+#pragma mark Functions
+
+HLSLayerAnimationParameters HLSLayerAnimationParametersReverse(HLSLayerAnimationParameters parameters)
+{
+    // See remarks at the beginning
+    HLSLayerAnimationParameters reverseParameters = layerAnimationParametersIdentity();
+    reverseParameters.rotationParameters = HLSVector4Make(-parameters.rotationParameters.v1,
+                                                          parameters.rotationParameters.v2,
+                                                          parameters.rotationParameters.v3,
+                                                          parameters.rotationParameters.v4);
+    reverseParameters.scaleParameters = HLSVector3Make(1.f / parameters.scaleParameters.v1,
+                                                       1.f / parameters.scaleParameters.v2,
+                                                       1.f / parameters.scaleParameters.v3);
+    reverseParameters.translationParameters = HLSVector3Scale(parameters.translationParameters, -1.f);
+    reverseParameters.anchorPointTranslationParameters = HLSVector3Scale(parameters.anchorPointTranslationParameters, -1.f);
+    
+    reverseParameters.sublayerRotationParameters = HLSVector4Make(-parameters.sublayerRotationParameters.v1,
+                                                                  parameters.sublayerRotationParameters.v2,
+                                                                  parameters.sublayerRotationParameters.v3,
+                                                                  parameters.sublayerRotationParameters.v4);
+    reverseParameters.sublayerScaleParameters = HLSVector3Make(1.f / parameters.sublayerScaleParameters.v1,
+                                                               1.f / parameters.sublayerScaleParameters.v2,
+                                                               1.f / parameters.sublayerScaleParameters.v3);
+    reverseParameters.sublayerTranslationParameters = HLSVector3Scale(parameters.sublayerTranslationParameters, -1.f);
+    reverseParameters.sublayerCameraTranslationZ = -parameters.sublayerCameraTranslationZ;
+    
+    reverseParameters.opacityIncrement = -parameters.opacityIncrement;
+    reverseParameters.togglingShouldRasterize = parameters.togglingShouldRasterize;
+    reverseParameters.rasterizationScaleIncrement = -parameters.rasterizationScaleIncrement;
+    return layerAnimationParametersWithTransforms(reverseParameters);
+}
+
+HLSLayerAnimationParameters HLSLayerAnimationParametersAtProgress(HLSLayerAnimationParameters parameters, CGFloat progress)
+{
+    // Rotations are interpolated by angle about the same axis, scales and translations linearly
+    HLSVector3 identityScaleParameters = HLSVector3Make(1.f, 1.f, 1.f);
+    
+    HLSLayerAnimationParameters partialParameters = layerAnimationParametersIdentity();
+    partialParameters.rotationParameters = HLSVector4Make(progress * parameters.rotationParameters.v1,
+                                                          parameters.rotationParameters.v2,
+                                                          parameters.rotationParameters.v3,
+                                                          parameters.rotationParameters.v4);
+    partialParameters.scaleParameters = HLSVector3Lerp(identityScaleParameters, parameters.scaleParameters, progress);
+    partialParameters.translationParameters = HLSVector3Scale(parameters.translationParameters, progress);
+    partialParameters.anchorPointTranslationParameters = HLSVector3Scale(parameters.anchorPointTranslationParameters, progress);
+    
+    partialParameters.sublayerRotationParameters = HLSVector4Make(progress * parameters.sublayerRotationParameters.v1,
+                                                                  parameters.sublayerRotationParameters.v2,
+                                                                  parameters.sublayerRotationParameters.v3,
+                                                                  parameters.sublayerRotationParameters.v4);
+    partialParameters.sublayerScaleParameters = HLSVector3Lerp(identityScaleParameters, parameters.sublayerScaleParameters, progress);
+    partialParameters.sublayerTranslationParameters = HLSVector3Scale(parameters.sublayerTranslationParameters, progress);
+    partialParameters.sublayerCameraTranslationZ = progress * parameters.sublayerCameraTranslationZ;
+    
+    partialParameters.opacityIncrement = progress * parameters.opacityIncrement;
+    partialParameters.rasterizationScaleIncrement = progress * parameters.rasterizationScaleIncrement;
+    return layerAnimationParametersWithTransforms(partialParameters);
+}
+
+NSString *HLSStringFromLayerAnimationParameters(HLSLayerAnimationParameters parameters)
+{
+    return [NSString stringWithFormat:@"rotationParamers: %@; scaleParameters: %@; translationParameters: %@; "
+            "opacityIncrement: %.2f; sublayerCameraTranslationZ: %.2f; rasterizationScaleIncrement: %.2f",
+            HLSStringFromVector4(parameters.rotationParameters),
+            HLSStringFromVector3(parameters.scaleParameters),
+            HLSStringFromVector3(parameters.translationParameters),
+            parameters.opacityIncrement,
+            parameters.sublayerCameraTranslationZ,
+            parameters.rasterizationScaleIncrement];
+}
+
+#pragma mark Static functions
+
+static HLSLayerAnimationParameters layerAnimationParametersIdentity(void)
+{
+    HLSLayerAnimationParameters parameters;
+    memset(&parameters, 0, sizeof(HLSLayerAnimationParameters));
+    
+    parameters.rotationParameters = HLSVector4Make(0.f, 1.f, 0.f, 0.f);
+    parameters.scaleParameters = HLSVector3Make(1.f, 1.f, 1.f);
+    parameters.sublayerRotationParameters = HLSVector4Make(0.f, 1.f, 0.f, 0.f);
+    parameters.sublayerScaleParameters = HLSVector3Make(1.f, 1.f, 1.f);
+    parameters.transform = CATransform3DIdentity;
+    parameters.sublayerTransform = CATransform3DIdentity;
+    return parameters;
+}
+
+static HLSLayerAnimationParameters layerAnimationParametersWithTransforms(HLSLayerAnimationParameters parameters)
+{
+    parameters.transform = HLSTransform3DMakeRotationScaleTranslation(parameters.rotationParameters,
+                                                                      parameters.scaleParameters,
+                                                                      parameters.translationParameters);
+    parameters.sublayerTransform = HLSTransform3DMakeRotationScaleTranslation(parameters.sublayerRotationParameters,
+                                                                              parameters.sublayerScaleParameters,
+                                                                              parameters.sublayerTranslationParameters);
+    return parameters;
+}
@@ -0,0 +1,49 @@
+//
+//  HLSLayerAnimationStep+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSLayerAnimationStep.h"
+
+/**
+ * Interface meant to be used by friend classes of HLSLayerAnimationStep (= classes which must have access to private
+ * implementation details)
+ */
+@interface HLSLayerAnimationStep (Friend)
+
+/**
+ * The factor which must be applied to Core Animation durations. Always 1 on the device. In the simulator, this factor
+ * reflects whether slow animations have been enabled
+ */
++ (CGFloat)animationDurationFactor;
+
+/**
+ * Set the model values of the properties animated by layer animation steps to the values currently displayed for the
+ * layer given as parameter
+ */
++ (void)freezeAnimationsOfLayer:(CALayer *)layer;
+
+/**
+ * Copy the values of all properties which can be animated by layer animation steps from a layer to another one, so
+ * that a layer animation step has the same effect on both layers
+ */
++ (void)copyAnimatedPropertiesOfLayer:(CALayer *)layer toLayer:(CALayer *)targetLayer;
+
+/**
+ * Set the final values resulting from the animation step on the layer given as parameter, which must be one of the
+ * objects of the animation step. If animated is YES, the method returns the CABasicAnimations which must be played to
+ * reach those values, otherwise an empty array. The duration, offset and timing function of the returned animations
+ * have not been set
+ */
+- (NSArray *)applyLayerAnimationToLayer:(CALayer *)layer animated:(BOOL)animated;
+
+/**
+ * Return the part of the step during which the specified layer is animated, as a vector whose components are the
+ * begin and end fractions of the step duration. Equal to (0, 1) except for staggered layers
+ */
+- (HLSVector2)timeRangeForLayer:(CALayer *)layer;
+
+@end
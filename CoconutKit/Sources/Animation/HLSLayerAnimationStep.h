@@ -8,6 +8,7 @@
 
 #import "HLSAnimationStep.h"
 #import "HLSLayerAnimation.h"
+#import "HLSTimingCurve.h"
 
 /**
  * A layer animation step (HLSLayerAnimationStep) is the combination of several layer animations (HLSLayerAnimation) applied
@@ -23,20 +24,22 @@
 @interface HLSLayerAnimationStep : HLSAnimationStep {
 @private
     CAMediaTimingFunction *m_timingFunction;
-    UIView *m_dummyView;
+    HLSTimingCurve *m_timingCurve;
     NSUInteger m_numberOfLayerAnimations;
-    BOOL m_numberOfStartedLayerAnimations;
+    NSUInteger m_numberOfStartedLayerAnimations;
     NSUInteger m_numberOfFinishedLayerAnimations;
     CFTimeInterval m_startTime;
     CFTimeInterval m_pauseTime;
     CFTimeInterval m_previousPauseDuration;
+    CFTimeInterval m_endTime;
+    NSMutableDictionary *m_layerKeyToTimeRangeMap;
 }
 
 /**
  * Setting a layer animation for a layer. Only one layer animation can be defined at most for a layer within an
  * animation step. The layer is not retained
  *
- * The layer animation is deeply copied to prevent further changes once assigned to a step
+ * The parameters of the layer animation are copied to prevent further changes once assigned to a step
  */
 - (void)addLayerAnimation:(HLSLayerAnimation *)layerAnimation forLayer:(CALayer *)layer;
 
@@ -45,6 +48,22 @@
  */
 - (void)addLayerAnimation:(HLSLayerAnimation *)layerAnimation forView:(UIView *)view;
 
+/**
+ * Apply the same layer animation to several layers. The parameters of the layer animation are copied by value for
+ * each layer, without any object being created, which makes it cheap to animate a large number of layers the same way.
+ * The layers are not retained
+ */
+- (void)addLayerAnimation:(HLSLayerAnimation *)layerAnimation forLayers:(NSArray *)layers;
+
+/**
+ * Same as -addLayerAnimation:forLayers:, but with the animations of the layers staggered in time. The staggering factor
+ * (between 0 and 1, excluded) is the fraction of the step duration by which the animation of the last layer is delayed
+ * compared to the first one, delays being evenly distributed in the order in which layers appear in the array. Each
+ * layer is animated during the remaining fraction of the step duration. A factor of 0 is equivalent to calling
+ * -addLayerAnimation:forLayers:
+ */
+- (void)addLayerAnimation:(HLSLayerAnimation *)layerAnimation forLayers:(NSArray *)layers staggeringFactor:(CGFloat)staggeringFactor;
+
 /**
  * The animation timing function to use
  *
@@ -52,4 +71,13 @@
  */
 @property (nonatomic, retain) CAMediaTimingFunction *timingFunction;
 
+/**
+ * A physically-based timing curve (spring, decay) to use instead of the timing function. When set, the timing function
+ * is ignored and the step is played using keyframe animations sampled from the curve, which makes it possible to get
+ * e.g. spring-like motion with a single step
+ *
+ * Default value is nil
+ */
+@property (nonatomic, retain) HLSTimingCurve *timingCurve;
+
 @end
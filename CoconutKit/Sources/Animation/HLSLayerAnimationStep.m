@@ -10,28 +10,58 @@
 
 #import "CALayer+HLSExtensions.h"
 #import "CAMediaTimingFunction+HLSExtensions.h"
+#import "HLSAnimationClock.h"
+#import "HLSAnimationScheduler+Friend.h"
+#import "HLSAnimationStep+Friend.h"
 #import "HLSAnimationStep+Protected.h"
 #import "HLSFloat.h"
 #import "HLSLayerAnimation+Friend.h"
+#import "HLSLayerAnimationStep+Friend.h"
 #import "HLSLogger.h"
 
 #if TARGET_IPHONE_SIMULATOR
 #import <dlfcn.h>
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
 #endif
 
 static NSString * const kLayerAnimationGroupKey = @"HLSLayerAnimationGroup";
-static NSString * const kDummyViewLayerAnimationKey = @"HLSDummyViewLayerAnimation";
 
 static NSString * const kLayerNonProjectedSublayerTransformKey = @"HLSNonProjectedSublayerTransform";
 static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZPositionForSublayers";
 
+// Number of keyframes per second of animation when sampling a timing curve
+static const NSTimeInterval kTimingCurveSamplesPerSecond = 60.;
+
+// The set of layer properties altered by a layer animation step
+typedef struct {
+    CGFloat opacity;
+    CATransform3D transform;
+    CGPoint anchorPoint;
+    CGFloat anchorPointZ;
+    BOOL shouldRasterize;
+    CGFloat rasterizationScale;
+    CATransform3D nonProjectedSublayerTransform;            // The sublayer transform without its perspective component
+    CGFloat sublayerCameraZPosition;
+    CATransform3D sublayerTransform;
+} HLSLayerProperties;
+
+static HLSLayerProperties layerPropertiesForLayer(CALayer *layer);
+static HLSLayerProperties layerPropertiesByApplyingLayerAnimationParameters(HLSLayerProperties layerProperties,
+                                                                            const HLSLayerAnimationParameters *pLayerAnimationParameters);
+static void applyLayerPropertiesToLayer(HLSLayerProperties layerProperties, CALayer *layer);
+
 // Remark: CoreAnimation default settings are duration = 0.25 and linear timing function, but
 //         to be consistent with UIView block-based animations we do not override the default
 //         duration received from HLSAnimationStep (0.2) and set an ease-in ease-out function
 
-@interface HLSLayerAnimationStep ()
+@interface HLSLayerAnimationStep () <HLSAnimationClockObserver>
 
-@property (nonatomic, retain) UIView *dummyView;
+@property (nonatomic, retain) NSMutableDictionary *layerKeyToTimeRangeMap;
+
+- (NSArray *)keyframeAnimationsForLayerAnimationParameters:(const HLSLayerAnimationParameters *)pLayerAnimationParameters
+                                        fromLayerProperties:(HLSLayerProperties)fromLayerProperties;
 
 - (void)animationDidStart:(CAAnimation *)animation;
 - (void)animationDidStop:(CAAnimation *)animation finished:(BOOL)finished;
@@ -45,15 +75,20 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
 - (id)init
 {
     if ((self = [super init])) {
-        self.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];        
+        self.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
+        self.layerKeyToTimeRangeMap = [NSMutableDictionary dictionary];
     }
     return self;
 }
 
 - (void)dealloc
 {
+    // Steps without layers might still be attached to the clock if they are deallocated while running
+    [[HLSAnimationClock sharedAnimationClock] removeObserver:self];
+    
     self.timingFunction = nil;
-    self.dummyView = nil;
+    self.timingCurve = nil;
+    self.layerKeyToTimeRangeMap = nil;
     
     [super dealloc];
 }
@@ -62,13 +97,95 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
 
 @synthesize timingFunction = m_timingFunction;
 
-@synthesize dummyView = m_dummyView;
+@synthesize timingCurve = m_timingCurve;
+
+@synthesize layerKeyToTimeRangeMap = m_layerKeyToTimeRangeMap;
+
+#pragma mark Class methods
+
++ (size_t)objectAnimationParametersSize
+{
+    return sizeof(HLSLayerAnimationParameters);
+}
+
++ (CGFloat)animationDurationFactor
+{
+    // For tests within the iOS simulator only: Slow down Core Animations as UIView block-based animations (when
+    // quickly pressing the shift key three times)
+    //
+    // Credits to Cédric Luthi, see http://twitter.com/0xced/statuses/232860477317869568
+#if TARGET_IPHONE_SIMULATOR
+    static CGFloat (*s_UIAnimationDragCoefficient)(void) = NULL;
+    static BOOL s_firstLoad = YES;
+    if (s_firstLoad) {
+        void *UIKitDylib = dlopen([[[NSBundle bundleForClass:[UIApplication class]] executablePath] fileSystemRepresentation], RTLD_LAZY);
+        s_UIAnimationDragCoefficient = (CGFloat (*)(void))dlsym(UIKitDylib, "UIAnimationDragCoefficient");
+        if (! s_UIAnimationDragCoefficient) {
+            HLSLoggerInfo(@"UIAnimationDragCoefficient not found. Slow animations won't be available for animations based on Core Animation");
+        }
+        
+        s_firstLoad = NO;
+    }
+    
+    if (s_UIAnimationDragCoefficient) {
+        return s_UIAnimationDragCoefficient();
+    }
+#endif
+    return 1.f;
+}
+
++ (void)freezeAnimationsOfLayer:(CALayer *)layer
+{
+    CALayer *presentationLayer = [layer presentationLayer];
+    if (! presentationLayer) {
+        return;
+    }
+    
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    
+    layer.opacity = presentationLayer.opacity;
+    layer.transform = presentationLayer.transform;
+    layer.anchorPoint = presentationLayer.anchorPoint;
+    layer.anchorPointZ = presentationLayer.anchorPointZ;
+    layer.shouldRasterize = presentationLayer.shouldRasterize;
+    layer.rasterizationScale = presentationLayer.rasterizationScale;
+    
+    // The camera position is kept at its target value, the sublayer transform without perspective component is deduced
+    // from it
+    HLSLayerProperties layerProperties = layerPropertiesForLayer(layer);
+    CATransform3D perspectiveProjectionTransform = CATransform3DIdentity;
+    if (! floateq(layerProperties.sublayerCameraZPosition, 0.f)) {
+        perspectiveProjectionTransform.m34 = -1.f / layerProperties.sublayerCameraZPosition;
+    }
+    layer.sublayerTransform = presentationLayer.sublayerTransform;
+    [layer setValue:[NSValue valueWithCATransform3D:CATransform3DConcat(presentationLayer.sublayerTransform, CATransform3DInvert(perspectiveProjectionTransform))] 
+             forKey:kLayerNonProjectedSublayerTransformKey];
+    
+    [CATransaction commit];
+}
+
++ (void)copyAnimatedPropertiesOfLayer:(CALayer *)layer toLayer:(CALayer *)targetLayer
+{
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    
+    applyLayerPropertiesToLayer(layerPropertiesForLayer(layer), targetLayer);
+    
+    [CATransaction commit];
+}
 
 #pragma mark Managing the animation
 
 - (void)addLayerAnimation:(HLSLayerAnimation *)layerAnimation forLayer:(CALayer *)layer
 {
-    [self addObjectAnimation:layerAnimation forObject:layer];
+    if (! layerAnimation) {
+        HLSLoggerDebug(@"No animation for the layer");
+        return;
+    }
+    
+    HLSLayerAnimationParameters layerAnimationParameters = [layerAnimation parameters];
+    [self addObjectAnimationParameters:&layerAnimationParameters forObject:layer];
 }
 
 - (void)addLayerAnimation:(HLSLayerAnimation *)layerAnimation forView:(UIView *)view
@@ -76,43 +193,70 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
     [self addLayerAnimation:layerAnimation forLayer:view.layer];
 }
 
+- (void)addLayerAnimation:(HLSLayerAnimation *)layerAnimation forLayers:(NSArray *)layers
+{
+    [self addLayerAnimation:layerAnimation forLayers:layers staggeringFactor:0.f];
+}
+
+- (void)addLayerAnimation:(HLSLayerAnimation *)layerAnimation forLayers:(NSArray *)layers staggeringFactor:(CGFloat)staggeringFactor
+{
+    // A factor of 1 would leave no time to animate the layers (and a zero animation duration means the default
+    // duration for Core Animation)
+    if (floatlt(staggeringFactor, 0.f) || floatge(staggeringFactor, 1.f)) {
+        HLSLoggerError(@"The staggering factor must be between 0 and 1 (excluded)");
+        return;
+    }
+    
+    if (! layerAnimation) {
+        HLSLoggerDebug(@"No animation for the layers");
+        return;
+    }
+    
+    HLSLayerAnimationParameters layerAnimationParameters = [layerAnimation parameters];
+    [self addObjectAnimationParameters:&layerAnimationParameters forObjects:layers];
+    
+    NSUInteger numberOfLayers = [layers count];
+    if (floateq(staggeringFactor, 0.f) || numberOfLayers < 2) {
+        return;
+    }
+    
+    for (NSUInteger i = 0; i < numberOfLayers; ++i) {
+        CALayer *layer = [layers objectAtIndex:i];
+        CGFloat beginFraction = staggeringFactor * i / (numberOfLayers - 1);
+        HLSVector2 timeRange = HLSVector2Make(beginFraction, beginFraction + 1.f - staggeringFactor);
+        [self.layerKeyToTimeRangeMap setObject:[NSValue valueWithBytes:&timeRange objCType:@encode(HLSVector2)]
+                                        forKey:[NSValue valueWithPointer:layer]];
+    }
+}
+
+- (HLSVector2)timeRangeForLayer:(CALayer *)layer
+{
+    NSValue *timeRangeValue = [self.layerKeyToTimeRangeMap objectForKey:[NSValue valueWithPointer:layer]];
+    if (! timeRangeValue) {
+        return HLSVector2Make(0.f, 1.f);
+    }
+    
+    HLSVector2 timeRange;
+    [timeRangeValue getValue:&timeRange];
+    return timeRange;
+}
+
 - (void)playAnimationWithStartTime:(NSTimeInterval)startTime animated:(BOOL)animated
 {
     NSAssert(doublele(startTime, self.duration), @"The start time of a step cannot be greater than its duration");
     
     NSTimeInterval duration = self.duration;
     if (animated) {
-        // This dummy view is always animated. There is no way to set a start callback for a CATransaction.
-        // Therefore, we always ensure the transaction is never empty by animating a dummy view, and we set
-        // animation callbacks for its associated animation (which, since it is part of the transaction,
-        // will be triggered when the transaction begins / ends animating)
-        self.dummyView = [[[UIView alloc] initWithFrame:CGRectZero] autorelease];
-        [[UIApplication sharedApplication].keyWindow addSubview:self.dummyView];
-        
+        // Nested in the transaction of the current run loop turn, so that all steps started together are committed at once
+        [[HLSAnimationScheduler sharedAnimationScheduler] beginAnimationStepTransaction];
         [CATransaction begin];
         
         // For tests within the iOS simulator only: Slow down Core Animations as UIView block-based animations (when
         // quickly pressing the shift key three times)
-        //
-        // Credits to Cédric Luthi, see http://twitter.com/0xced/statuses/232860477317869568
-#if TARGET_IPHONE_SIMULATOR
-        static CGFloat (*s_UIAnimationDragCoefficient)(void) = NULL;
-        static BOOL s_firstLoad = YES;
-        if (s_firstLoad) {
-            void *UIKitDylib = dlopen([[[NSBundle bundleForClass:[UIApplication class]] executablePath] fileSystemRepresentation], RTLD_LAZY);
-            s_UIAnimationDragCoefficient = (CGFloat (*)(void))dlsym(UIKitDylib, "UIAnimationDragCoefficient");
-            if (! s_UIAnimationDragCoefficient) {
-                HLSLoggerInfo(@"UIAnimationDragCoefficient not found. Slow animations won't be available for animations based on Core Animation");
-            }
-            
-            s_firstLoad = NO;
-        }
+        CGFloat animationDurationFactor = [HLSLayerAnimationStep animationDurationFactor];
+        duration *= animationDurationFactor;
+        startTime *= animationDurationFactor;
         
-        if (s_UIAnimationDragCoefficient) {
-            duration *= s_UIAnimationDragCoefficient();
-            startTime *= s_UIAnimationDragCoefficient();
-        }
-#endif
         // If we want to play an animation from somewhere in its middle, we need to reduce the duration of the enclosing
         // group or transaction accordingly, while letting the duration of the individual animations unchanged (see the
         // CAAnimationGroup creation below). The child animation is not scaled, rather cut at its end (see the CAAnimationGroup
@@ -122,173 +266,36 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
     }
     
     // Animate all layers involved in the animation step
-    for (CALayer *layer in [self objects]) {        
-        HLSLayerAnimation *layerAnimation = (HLSLayerAnimation *)[self objectAnimationForObject:layer];
-        NSAssert(layerAnimation != nil, @"Missing layer animation; data consistency failure");
-                
-        // Remark: For each property we animate, we still must set the final value manually (CoreAnimations animate properties
-        // but do not set them). Since we do not need to support delays (which are implemented at the HLSAnimation level), we
-        // can do it right here, eliminating potentially flickering animations (for more information, see HLSAnimation.m)
-        NSMutableArray *animations = [NSMutableArray array];
-        
-        // Opacity animation (opacity must always lie between 0.f and 1.f)
-        CGFloat opacity = layer.opacity + layerAnimation.opacityIncrement;
-        if (floatlt(opacity, -1.f)) {
-            HLSLoggerWarn(@"Layer animations adding to an opacity value larger than -1 for layer %@. Fixed to -1, but your animation is incorrect", layer);
-            opacity = -1.f;
-        }
-        else if (floatgt(opacity, 1.f)) {
-            HLSLoggerWarn(@"Layer animations adding to an opacity value larger than 1 for layer %@. Fixed to 1, but your animation is incorrect", layer);
-            opacity = 1.f;
-        }
-        
-        if (animated) {
-            CABasicAnimation *opacityAnimation = [CABasicAnimation animationWithKeyPath:@"opacity"];
-            [opacityAnimation setFromValue:[NSNumber numberWithFloat:layer.opacity]];
-            [opacityAnimation setToValue:[NSNumber numberWithFloat:opacity]];
-            [animations addObject:opacityAnimation];
-        }
-        layer.opacity = opacity;
-        
-        // Animate the transform. The transform has to be applied on the layer center. This requires a conversion in the coordinate system
-        // centered on the layer
-        CATransform3D translationTransform = CATransform3DMakeTranslation(-layer.transform.m41, -layer.transform.m42, 0.f);
-        CATransform3D convTransform = CATransform3DConcat(CATransform3DConcat(translationTransform, layerAnimation.transform),
-                                                          CATransform3DInvert(translationTransform));
-        CATransform3D transform = CATransform3DConcat(layer.transform, convTransform);
-        
-        if (animated) {
-            CABasicAnimation *transformAnimation = [CABasicAnimation animationWithKeyPath:@"transform"];
-            [transformAnimation setFromValue:[NSValue valueWithCATransform3D:layer.transform]];
-            [transformAnimation setToValue:[NSValue valueWithCATransform3D:transform]];
-            [animations addObject:transformAnimation];
-        }
-        layer.transform = transform;
-        
-        // Animate the anchor point
-        CGPoint anchorPoint = CGPointMake(layer.anchorPoint.x + layerAnimation.anchorPointTranslationParameters.v1,
-                                          layer.anchorPoint.y + layerAnimation.anchorPointTranslationParameters.v2);
-        CGFloat anchorPointZ = layer.anchorPointZ + layerAnimation.anchorPointTranslationParameters.v3;
-        
-        if (animated) {
-            CABasicAnimation *anchorPointAnimation = [CABasicAnimation animationWithKeyPath:@"anchorPoint"];
-            [anchorPointAnimation setFromValue:[NSValue valueWithCGPoint:layer.anchorPoint]];
-            [anchorPointAnimation setToValue:[NSValue valueWithCGPoint:anchorPoint]];
-            [animations addObject:anchorPointAnimation];
-            
-            CABasicAnimation *anchorPointZAnimation = [CABasicAnimation animationWithKeyPath:@"anchorPointZ"];
-            [anchorPointZAnimation setFromValue:[NSNumber numberWithFloat:layer.anchorPointZ]];
-            [anchorPointZAnimation setToValue:[NSNumber numberWithFloat:anchorPointZ]];
-            [animations addObject:anchorPointZAnimation];
-        }
-        layer.anchorPoint = anchorPoint;
-        layer.anchorPointZ = anchorPointZ;
-        
-        // Rasterization
-        if (layerAnimation.togglingShouldRasterize) {
-            BOOL shouldRasterize = ! layer.shouldRasterize;
-            if (animated) {
-                CABasicAnimation *shouldRasterizeAnimation = [CABasicAnimation animationWithKeyPath:@"shouldRasterize"];
-                [shouldRasterizeAnimation setFromValue:[NSNumber numberWithBool:layer.shouldRasterize]];
-                [shouldRasterizeAnimation setToValue:[NSNumber numberWithBool:shouldRasterize]];
-                [animations addObject:shouldRasterizeAnimation];
-            }
-            layer.shouldRasterize = shouldRasterize;
-        }
-        
-        // Rasterization scale
-        CGFloat rasterizationScale = layer.rasterizationScale + layerAnimation.rasterizationScaleIncrement;
-        if (animated) {
-            CABasicAnimation *rasterizationScaleAnimation = [CABasicAnimation animationWithKeyPath:@"rasterizationScale"];
-            [rasterizationScaleAnimation setFromValue:[NSNumber numberWithFloat:layer.rasterizationScale]];
-            [rasterizationScaleAnimation setToValue:[NSNumber numberWithFloat:rasterizationScale]];
-            [animations addObject:rasterizationScaleAnimation];
-        }
-        layer.rasterizationScale = rasterizationScale;
-        
-        // Get the sublayer transform without its perspective component (saved as additional layer information)
-        NSValue *nonProjectedSublayerTransformValue = [layer valueForKey:kLayerNonProjectedSublayerTransformKey];
-        CATransform3D nonProjectedSublayerTransform = CATransform3DIdentity;
-        if (nonProjectedSublayerTransformValue) {
-            nonProjectedSublayerTransform = [nonProjectedSublayerTransformValue CATransform3DValue];
-        }
-        else {
-            nonProjectedSublayerTransform = layer.sublayerTransform;
-        }
-        
-        // Get the current camera position (saved as additional layer information)
-        NSNumber *sublayerCameraZPositionNumber = [layer valueForKey:kLayerCameraZPositionForSublayersKey];
-        CGFloat sublayerCameraZPosition = 0.f;
-        if (sublayerCameraZPositionNumber) {
-            sublayerCameraZPosition = [sublayerCameraZPositionNumber floatValue];
-        }
-        else {
-            sublayerCameraZPosition = floateq(layer.sublayerTransform.m34, 0.f) ? 0.f : 1.f / layer.sublayerTransform.m34;
-        }
-        
-        // Calculate the sublayer transform (without perspective component)
-        CATransform3D sublayerTranslationTransform = CATransform3DMakeTranslation(-nonProjectedSublayerTransform.m41, -nonProjectedSublayerTransform.m42, 0.f);
-        CATransform3D sublayerConvTransform = CATransform3DConcat(CATransform3DConcat(sublayerTranslationTransform, layerAnimation.sublayerTransform),
-                                                                  CATransform3DInvert(sublayerTranslationTransform));
-        CATransform3D sublayerTransform = CATransform3DConcat(nonProjectedSublayerTransform, sublayerConvTransform);
-        
-        // Calculate the new z-position of the camera
-        sublayerCameraZPosition += layerAnimation.sublayerCameraTranslationZ;
-        
-        // Save the information relative / not relative to the perspective separately
-        [layer setValue:[NSNumber numberWithFloat:sublayerCameraZPosition] forKey:kLayerCameraZPositionForSublayersKey];
-        [layer setValue:[NSValue valueWithCATransform3D:sublayerTransform] forKey:kLayerNonProjectedSublayerTransformKey];
-        
-        // Create the perspective matrix (see http://en.wikipedia.org/wiki/3D_projection#Perspective_projection)
-        CATransform3D perspectiveProjectionTransform = CATransform3DIdentity;
-        if (! floateq(sublayerCameraZPosition, 0.f)) {
-            perspectiveProjectionTransform.m34 = -1.f / sublayerCameraZPosition;
-        }
-        
-        // Apply the perspective
-        sublayerTransform = CATransform3DConcat(sublayerTransform, perspectiveProjectionTransform);
-        
-        if (animated) {
-            CABasicAnimation *sublayerTransformAnimation = [CABasicAnimation animationWithKeyPath:@"sublayerTransform"];
-            [sublayerTransformAnimation setFromValue:[NSValue valueWithCATransform3D:layer.sublayerTransform]];
-            [sublayerTransformAnimation setToValue:[NSValue valueWithCATransform3D:sublayerTransform]];
-            [animations addObject:sublayerTransformAnimation];
-        }
-        layer.sublayerTransform = sublayerTransform;
+    for (CALayer *layer in [self objects]) {
+        NSArray *animations = [self applyLayerAnimationToLayer:layer animated:animated];
         
         // Create the animation group and attach it to the layer
         if (animated) {
             // All animations must have the expected duration, but must be offset according to the start time
-            // when played from somewhere in their middle. The timing function must also be attached to each
-            // animation
+            // when played from somewhere in their middle (animations of staggered layers are additionally
+            // offset by their delay, and display their start values until they begin). The timing function
+            // must also be attached to each animation
+            HLSVector2 timeRange = [self timeRangeForLayer:layer];
             for (CAAnimation *animation in animations) {
-                animation.duration = duration;
-                animation.timeOffset = startTime;
-                animation.timingFunction = self.timingFunction;
+                animation.beginTime = timeRange.v1 * duration - startTime;
+                animation.duration = (timeRange.v2 - timeRange.v1) * duration;
+                animation.timingFunction = self.timingCurve ? nil : self.timingFunction;
+                animation.fillMode = kCAFillModeBackwards;
             }
             
             CAAnimationGroup *animationGroup = [CAAnimationGroup animation];
-            animationGroup.animations = [NSArray arrayWithArray:animations];
+            animationGroup.animations = animations;
+            animationGroup.duration = duration - startTime;
             animationGroup.delegate = self;
             [layer addAnimation:animationGroup forKey:kLayerAnimationGroupKey];
         }
     }
     
-    // Animate the dummy view. It is also used to set a delegate (one for all animations in the transaction)
-    // which will receive the start / end animation events
-    if (animated) {
-        CABasicAnimation *dummyViewOpacityAnimation = [CABasicAnimation animationWithKeyPath:@"opacity"];
-        dummyViewOpacityAnimation.fromValue = [NSNumber numberWithFloat:self.dummyView.layer.opacity];
-        dummyViewOpacityAnimation.toValue = [NSNumber numberWithFloat:1.f - self.dummyView.layer.opacity];
-        dummyViewOpacityAnimation.delegate = self;
-        [self.dummyView.layer addAnimation:dummyViewOpacityAnimation forKey:kDummyViewLayerAnimationKey];
-    }
-        
     // Animated
     if (animated) {
         // We need to keep track of animations which have started / ended (there is no way to known when a
         // CATransaction has started or ended, and there order in which the child animations are started or
-        // ended is unspecified)
+        // ended is unspecified). The animation groups attached to the layers are their own delegates
         m_numberOfStartedLayerAnimations = 0;
         m_numberOfFinishedLayerAnimations = 0;
         
@@ -296,22 +303,146 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
         // layers are dead when the end callback is called (which can happen if the layer they are on is
         // destroyed while the animation was running), we cannot compare to self.objects anymore (otherwise
         // the application will crash). We therefore keep track of how animations are expected, but in a safe way
-        // (+ 1 for the dummy view animation)
-        m_numberOfLayerAnimations = [self.objects count] + 1;
+        m_numberOfLayerAnimations = [self.objects count];
         
         // When a start time has been defined, the animation must look like it started earlier
         m_startTime = CACurrentMediaTime() - startTime;
+        m_pauseTime = 0.;
+        m_previousPauseDuration = 0.;
+        m_endTime = duration;
+        
+        // Without any layer to animate (e.g. for steps used to create delays), no animation callback will ever be received.
+        // The end of the step is then detected using the animation clock, without inserting anything in the layer tree
+        if (m_numberOfLayerAnimations == 0) {
+            [[HLSAnimationClock sharedAnimationClock] addObserver:self];
+        }
         
         [CATransaction commit];
     }
 }
 
+- (NSArray *)applyLayerAnimationToLayer:(CALayer *)layer animated:(BOOL)animated
+{
+    const HLSLayerAnimationParameters *pLayerAnimationParameters = [self objectAnimationParametersForObject:layer];
+    NSAssert(pLayerAnimationParameters != NULL, @"Missing layer animation; data consistency failure");
+    
+    // Remark: For each property we animate, we still must set the final value manually (CoreAnimations animate properties
+    // but do not set them). Since we do not need to support delays (which are implemented at the HLSAnimation level), we
+    // can do it right here, eliminating potentially flickering animations (for more information, see HLSAnimation.m)
+    HLSLayerProperties fromLayerProperties = layerPropertiesForLayer(layer);
+    
+    // Opacity must always lie between 0.f and 1.f (fixed when calculating the final values)
+    CGFloat opacity = fromLayerProperties.opacity + pLayerAnimationParameters->opacityIncrement;
+    if (floatlt(opacity, -1.f)) {
+        HLSLoggerWarn(@"Layer animations adding to an opacity value larger than -1 for layer %@. Fixed to -1, but your animation is incorrect", layer);
+    }
+    else if (floatgt(opacity, 1.f)) {
+        HLSLoggerWarn(@"Layer animations adding to an opacity value larger than 1 for layer %@. Fixed to 1, but your animation is incorrect", layer);
+    }
+    
+    HLSLayerProperties toLayerProperties = layerPropertiesByApplyingLayerAnimationParameters(fromLayerProperties, pLayerAnimationParameters);
+    
+    NSMutableArray *animations = [NSMutableArray array];
+    if (animated) {
+        if (self.timingCurve) {
+            [animations addObjectsFromArray:[self keyframeAnimationsForLayerAnimationParameters:pLayerAnimationParameters
+                                                                            fromLayerProperties:fromLayerProperties]];
+        }
+        else {
+            CABasicAnimation *opacityAnimation = [CABasicAnimation animationWithKeyPath:@"opacity"];
+            [opacityAnimation setFromValue:[NSNumber numberWithFloat:fromLayerProperties.opacity]];
+            [opacityAnimation setToValue:[NSNumber numberWithFloat:toLayerProperties.opacity]];
+            [animations addObject:opacityAnimation];
+    
+            CABasicAnimation *transformAnimation = [CABasicAnimation animationWithKeyPath:@"transform"];
+            [transformAnimation setFromValue:[NSValue valueWithCATransform3D:fromLayerProperties.transform]];
+            [transformAnimation setToValue:[NSValue valueWithCATransform3D:toLayerProperties.transform]];
+            [animations addObject:transformAnimation];
+    
+            CABasicAnimation *anchorPointAnimation = [CABasicAnimation animationWithKeyPath:@"anchorPoint"];
+            [anchorPointAnimation setFromValue:[NSValue valueWithCGPoint:fromLayerProperties.anchorPoint]];
+            [anchorPointAnimation setToValue:[NSValue valueWithCGPoint:toLayerProperties.anchorPoint]];
+            [animations addObject:anchorPointAnimation];
+        
+            CABasicAnimation *anchorPointZAnimation = [CABasicAnimation animationWithKeyPath:@"anchorPointZ"];
+            [anchorPointZAnimation setFromValue:[NSNumber numberWithFloat:fromLayerProperties.anchorPointZ]];
+            [anchorPointZAnimation setToValue:[NSNumber numberWithFloat:toLayerProperties.anchorPointZ]];
+            [animations addObject:anchorPointZAnimation];
+            
+            CABasicAnimation *rasterizationScaleAnimation = [CABasicAnimation animationWithKeyPath:@"rasterizationScale"];
+            [rasterizationScaleAnimation setFromValue:[NSNumber numberWithFloat:fromLayerProperties.rasterizationScale]];
+            [rasterizationScaleAnimation setToValue:[NSNumber numberWithFloat:toLayerProperties.rasterizationScale]];
+            [animations addObject:rasterizationScaleAnimation];
+            
+            CABasicAnimation *sublayerTransformAnimation = [CABasicAnimation animationWithKeyPath:@"sublayerTransform"];
+            [sublayerTransformAnimation setFromValue:[NSValue valueWithCATransform3D:fromLayerProperties.sublayerTransform]];
+            [sublayerTransformAnimation setToValue:[NSValue valueWithCATransform3D:toLayerProperties.sublayerTransform]];
+            [animations addObject:sublayerTransformAnimation];
+        }
+    
+        // Rasterization is a discrete property, and is never sampled
+        if (pLayerAnimationParameters->togglingShouldRasterize) {
+            CABasicAnimation *shouldRasterizeAnimation = [CABasicAnimation animationWithKeyPath:@"shouldRasterize"];
+            [shouldRasterizeAnimation setFromValue:[NSNumber numberWithBool:fromLayerProperties.shouldRasterize]];
+            [shouldRasterizeAnimation setToValue:[NSNumber numberWithBool:toLayerProperties.shouldRasterize]];
+            [animations addObject:shouldRasterizeAnimation];
+        }
+    }
+    
+    applyLayerPropertiesToLayer(toLayerProperties, layer);
+    
+    return [NSArray arrayWithArray:animations];
+}
+    
+- (NSArray *)keyframeAnimationsForLayerAnimationParameters:(const HLSLayerAnimationParameters *)pLayerAnimationParameters
+                                        fromLayerProperties:(HLSLayerProperties)fromLayerProperties
+{
+    NSUInteger numberOfSamples = MAX(2, (NSUInteger)ceil(self.duration * kTimingCurveSamplesPerSecond) + 1);
+    NSArray *progressValues = [self.timingCurve progressValuesWithNumberOfSamples:numberOfSamples];
+    
+    NSMutableArray *opacityValues = [NSMutableArray arrayWithCapacity:numberOfSamples];
+    NSMutableArray *transformValues = [NSMutableArray arrayWithCapacity:numberOfSamples];
+    NSMutableArray *anchorPointValues = [NSMutableArray arrayWithCapacity:numberOfSamples];
+    NSMutableArray *anchorPointZValues = [NSMutableArray arrayWithCapacity:numberOfSamples];
+    NSMutableArray *rasterizationScaleValues = [NSMutableArray arrayWithCapacity:numberOfSamples];
+    NSMutableArray *sublayerTransformValues = [NSMutableArray arrayWithCapacity:numberOfSamples];
+    
+    // Each sample is obtained by applying the corresponding fraction of the layer animation to the initial state, so that
+    // transforms are interpolated using their geometric parameters. Partial parameters are value types, no object is created
+    for (NSNumber *progressNumber in progressValues) {
+        HLSLayerAnimationParameters partialLayerAnimationParameters = HLSLayerAnimationParametersAtProgress(*pLayerAnimationParameters,
+                                                                                                            [progressNumber floatValue]);
+        HLSLayerProperties layerProperties = layerPropertiesByApplyingLayerAnimationParameters(fromLayerProperties,
+                                                                                               &partialLayerAnimationParameters);
+        [opacityValues addObject:[NSNumber numberWithFloat:layerProperties.opacity]];
+        [transformValues addObject:[NSValue valueWithCATransform3D:layerProperties.transform]];
+        [anchorPointValues addObject:[NSValue valueWithCGPoint:layerProperties.anchorPoint]];
+        [anchorPointZValues addObject:[NSNumber numberWithFloat:layerProperties.anchorPointZ]];
+        [rasterizationScaleValues addObject:[NSNumber numberWithFloat:layerProperties.rasterizationScale]];
+        [sublayerTransformValues addObject:[NSValue valueWithCATransform3D:layerProperties.sublayerTransform]];
+    }
+    
+    NSDictionary *keyPathToValuesMap = [NSDictionary dictionaryWithObjectsAndKeys:opacityValues, @"opacity",
+                                        transformValues, @"transform",
+                                        anchorPointValues, @"anchorPoint",
+                                        anchorPointZValues, @"anchorPointZ",
+                                        rasterizationScaleValues, @"rasterizationScale",
+                                        sublayerTransformValues, @"sublayerTransform",
+                                        nil];
+    NSMutableArray *animations = [NSMutableArray array];
+    for (NSString *keyPath in [keyPathToValuesMap allKeys]) {
+        CAKeyframeAnimation *keyframeAnimation = [CAKeyframeAnimation animationWithKeyPath:keyPath];
+        keyframeAnimation.values = [keyPathToValuesMap objectForKey:keyPath];
+        [animations addObject:keyframeAnimation];
+    }
+    return [NSArray arrayWithArray:animations];
+}
+
 - (void)pauseAnimation
 {
     for (CALayer *layer in [self objects]) {
         [layer pauseAllAnimations];
     }
-    [self.dummyView.layer pauseAllAnimations];
     
     m_pauseTime = CACurrentMediaTime();
 }
@@ -321,7 +452,6 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
     for (CALayer *layer in [self objects]) {
         [layer resumeAllAnimations];
     }
-    [self.dummyView.layer resumeAllAnimations];
     
     m_previousPauseDuration += CACurrentMediaTime() - m_pauseTime;
     m_pauseTime = 0.;
@@ -329,7 +459,7 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
 
 - (BOOL)isAnimationPaused
 {
-    return [self.dummyView.layer isPaused];
+    return ! doubleeq(m_pauseTime, 0.);
 }
 
 - (void)terminateAnimation
@@ -340,7 +470,39 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
     for (CALayer *layer in [self objects]) {
         [layer removeAllAnimationsRecursively];
     }
-    [self.dummyView.layer removeAllAnimationsRecursively];
+    
+    // Steps without layers are detached from the clock when it ticks for the next time, which mimics the asynchronous
+    // stop callback received for steps with layers
+}
+
+- (void)freezeAnimation
+{
+    for (CALayer *layer in [self objects]) {
+        [HLSLayerAnimationStep freezeAnimationsOfLayer:layer];
+    }
+}
+
+- (NSArray *)animatedLayers
+{
+    return [self objects];
+}
+
+- (NSArray *)rasterizableLayers
+{
+    // Layers whose rasterization settings are animated are left alone. Layers whose sublayers are moved relative to them
+    // would have to be rasterized again for each frame, and cannot benefit from rasterization either
+    NSMutableArray *rasterizableLayers = [NSMutableArray array];
+    for (CALayer *layer in [self objects]) {
+        const HLSLayerAnimationParameters *pLayerAnimationParameters = [self objectAnimationParametersForObject:layer];
+        if (pLayerAnimationParameters->togglingShouldRasterize
+                || ! floateq(pLayerAnimationParameters->rasterizationScaleIncrement, 0.f)
+                || ! CATransform3DIsIdentity(pLayerAnimationParameters->sublayerTransform)
+                || ! floateq(pLayerAnimationParameters->sublayerCameraTranslationZ, 0.f)) {
+            continue;
+        }
+        [rasterizableLayers addObject:layer];
+    }
+    return [NSArray arrayWithArray:rasterizableLayers];
 }
 
 - (NSTimeInterval)elapsedTime
@@ -353,24 +515,97 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
     return CACurrentMediaTime() - m_startTime - m_previousPauseDuration - currentPauseDuration;
 }
 
+#pragma mark Recycling
+
+- (void)prepareForReuse
+{
+    [super prepareForReuse];
+    
+    self.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
+    self.timingCurve = nil;
+    [self.layerKeyToTimeRangeMap removeAllObjects];
+    
+    m_numberOfLayerAnimations = 0;
+    m_numberOfStartedLayerAnimations = 0;
+    m_numberOfFinishedLayerAnimations = 0;
+    m_startTime = 0.;
+    m_pauseTime = 0.;
+    m_previousPauseDuration = 0.;
+    m_endTime = 0.;
+}
+
 #pragma mark Reverse animation
 
+- (void)reverseObjectAnimationParameters:(const void *)parameters intoParameters:(void *)reverseParameters
+{
+    *(HLSLayerAnimationParameters *)reverseParameters = HLSLayerAnimationParametersReverse(*(const HLSLayerAnimationParameters *)parameters);
+}
+
 - (id)reverseAnimationStep
 {
     HLSLayerAnimationStep *reverseAnimationStep = [super reverseAnimationStep];
     reverseAnimationStep.timingFunction = [self.timingFunction inverseFunction];
+    reverseAnimationStep.timingCurve = [self.timingCurve reverseTimingCurve];
+    
+    // The time range of a staggered layer is mirrored
+    for (NSValue *layerKey in [self.layerKeyToTimeRangeMap allKeys]) {
+        HLSVector2 timeRange;
+        [[self.layerKeyToTimeRangeMap objectForKey:layerKey] getValue:&timeRange];
+        HLSVector2 reverseTimeRange = HLSVector2Make(1.f - timeRange.v2, 1.f - timeRange.v1);
+        [reverseAnimationStep.layerKeyToTimeRangeMap setObject:[NSValue valueWithBytes:&reverseTimeRange objCType:@encode(HLSVector2)]
+                                                        forKey:layerKey];
+    }
     return reverseAnimationStep;
 }
 
+#pragma mark Substituting objects
+
+- (id)animationStepBySubstitutingObjects:(NSDictionary *)objectKeyToSubstituteObjectMap
+{
+    HLSLayerAnimationStep *animationStep = [super animationStepBySubstitutingObjects:objectKeyToSubstituteObjectMap];
+    animationStep.timingFunction = self.timingFunction;
+    animationStep.timingCurve = self.timingCurve;
+    for (NSValue *layerKey in [self.layerKeyToTimeRangeMap allKeys]) {
+        id layer = [objectKeyToSubstituteObjectMap objectForKey:layerKey];
+        if (layer == [NSNull null]) {
+            continue;
+        }
+        
+        NSValue *substituteLayerKey = layer ? [NSValue valueWithPointer:layer] : layerKey;
+        [animationStep.layerKeyToTimeRangeMap setObject:[self.layerKeyToTimeRangeMap objectForKey:layerKey] forKey:substituteLayerKey];
+    }
+    return animationStep;
+}
+
 #pragma mark NSCopying protocol implementation
 
 - (id)copyWithZone:(NSZone *)zone
 {
     HLSLayerAnimationStep *animationStepCopy = [super copyWithZone:zone];
     animationStepCopy.timingFunction = self.timingFunction;
+    animationStepCopy.timingCurve = self.timingCurve;
+    [animationStepCopy.layerKeyToTimeRangeMap addEntriesFromDictionary:self.layerKeyToTimeRangeMap];
     return animationStepCopy;
 }
 
+#pragma mark HLSAnimationClockObserver protocol implementation
+
+- (void)animationClockDidTick:(HLSAnimationClock *)animationClock
+{
+    if (self.terminating) {
+        [[HLSAnimationClock sharedAnimationClock] removeObserver:self];
+        [self notifyAsynchronousAnimationStepDidStopFinished:NO];
+        return;
+    }
+    
+    if (self.paused || doublelt([self elapsedTime], m_endTime)) {
+        return;
+    }
+    
+    [[HLSAnimationClock sharedAnimationClock] removeObserver:self];
+    [self notifyAsynchronousAnimationStepDidStopFinished:YES];
+}
+
 #pragma mark Animation callbacks
 
 - (void)animationDidStart:(CAAnimation *)animation
@@ -386,12 +621,114 @@ static NSString * const kLayerCameraZPositionForSublayersKey = @"HLSLayerCameraZ
         NSAssert(m_numberOfStartedLayerAnimations == m_numberOfFinishedLayerAnimations,
                  @"The number of started and finished animations must be the same");
         
-        [self.dummyView removeFromSuperview];
-        self.dummyView = nil;
-        
         [self notifyAsynchronousAnimationStepDidStopFinished:finished];
     }
 }
 
+#pragma mark Description
+
+- (NSString *)descriptionForObjectAnimationParameters:(const void *)parameters
+{
+    return HLSStringFromLayerAnimationParameters(*(const HLSLayerAnimationParameters *)parameters);
+}
+
 @end
 
+#pragma mark Static functions
+
+static HLSLayerProperties layerPropertiesForLayer(CALayer *layer)
+{
+    HLSLayerProperties layerProperties;
+    layerProperties.opacity = layer.opacity;
+    layerProperties.transform = layer.transform;
+    layerProperties.anchorPoint = layer.anchorPoint;
+    layerProperties.anchorPointZ = layer.anchorPointZ;
+    layerProperties.shouldRasterize = layer.shouldRasterize;
+    layerProperties.rasterizationScale = layer.rasterizationScale;
+    layerProperties.sublayerTransform = layer.sublayerTransform;
+    
+    // Get the sublayer transform without its perspective component (saved as additional layer information)
+    NSValue *nonProjectedSublayerTransformValue = [layer valueForKey:kLayerNonProjectedSublayerTransformKey];
+    if (nonProjectedSublayerTransformValue) {
+        layerProperties.nonProjectedSublayerTransform = [nonProjectedSublayerTransformValue CATransform3DValue];
+    }
+    else {
+        layerProperties.nonProjectedSublayerTransform = layer.sublayerTransform;
+    }
+    
+    // Get the current camera position (saved as additional layer information)
+    NSNumber *sublayerCameraZPositionNumber = [layer valueForKey:kLayerCameraZPositionForSublayersKey];
+    if (sublayerCameraZPositionNumber) {
+        layerProperties.sublayerCameraZPosition = [sublayerCameraZPositionNumber floatValue];
+    }
+    else {
+        layerProperties.sublayerCameraZPosition = floateq(layer.sublayerTransform.m34, 0.f) ? 0.f : 1.f / layer.sublayerTransform.m34;
+    }
+    
+    return layerProperties;
+}
+
+static HLSLayerProperties layerPropertiesByApplyingLayerAnimationParameters(HLSLayerProperties layerProperties,
+                                                                            const HLSLayerAnimationParameters *pLayerAnimationParameters)
+{
+    HLSLayerProperties resultingLayerProperties = layerProperties;
+    
+    // Opacity (must always lie between 0.f and 1.f)
+    CGFloat opacity = layerProperties.opacity + pLayerAnimationParameters->opacityIncrement;
+    resultingLayerProperties.opacity = MAX(MIN(opacity, 1.f), -1.f);
+    
+    // The transform has to be applied on the layer center. This requires a conversion in the coordinate system
+    // centered on the layer
+    CATransform3D translationTransform = CATransform3DMakeTranslation(-layerProperties.transform.m41, -layerProperties.transform.m42, 0.f);
+    CATransform3D convTransform = CATransform3DConcat(CATransform3DConcat(translationTransform, pLayerAnimationParameters->transform),
+                                                      CATransform3DInvert(translationTransform));
+    resultingLayerProperties.transform = CATransform3DConcat(layerProperties.transform, convTransform);
+    
+    // Anchor point
+    resultingLayerProperties.anchorPoint = CGPointMake(layerProperties.anchorPoint.x + pLayerAnimationParameters->anchorPointTranslationParameters.v1,
+                                                       layerProperties.anchorPoint.y + pLayerAnimationParameters->anchorPointTranslationParameters.v2);
+    resultingLayerProperties.anchorPointZ = layerProperties.anchorPointZ + pLayerAnimationParameters->anchorPointTranslationParameters.v3;
+    
+    // Rasterization
+    if (pLayerAnimationParameters->togglingShouldRasterize) {
+        resultingLayerProperties.shouldRasterize = ! layerProperties.shouldRasterize;
+    }
+    resultingLayerProperties.rasterizationScale = layerProperties.rasterizationScale + pLayerAnimationParameters->rasterizationScaleIncrement;
+    
+    // Calculate the sublayer transform (without perspective component)
+    CATransform3D nonProjectedSublayerTransform = layerProperties.nonProjectedSublayerTransform;
+    CATransform3D sublayerTranslationTransform = CATransform3DMakeTranslation(-nonProjectedSublayerTransform.m41, -nonProjectedSublayerTransform.m42, 0.f);
+    CATransform3D sublayerConvTransform = CATransform3DConcat(CATransform3DConcat(sublayerTranslationTransform, pLayerAnimationParameters->sublayerTransform),
+                                                              CATransform3DInvert(sublayerTranslationTransform));
+    resultingLayerProperties.nonProjectedSublayerTransform = CATransform3DConcat(nonProjectedSublayerTransform, sublayerConvTransform);
+    
+    // Calculate the new z-position of the camera
+    resultingLayerProperties.sublayerCameraZPosition = layerProperties.sublayerCameraZPosition + pLayerAnimationParameters->sublayerCameraTranslationZ;
+    
+    // Create the perspective matrix (see http://en.wikipedia.org/wiki/3D_projection#Perspective_projection)
+    CATransform3D perspectiveProjectionTransform = CATransform3DIdentity;
+    if (! floateq(resultingLayerProperties.sublayerCameraZPosition, 0.f)) {
+        perspectiveProjectionTransform.m34 = -1.f / resultingLayerProperties.sublayerCameraZPosition;
+    }
+    
+    // Apply the perspective
+    resultingLayerProperties.sublayerTransform = CATransform3DConcat(resultingLayerProperties.nonProjectedSublayerTransform, 
+                                                                     perspectiveProjectionTransform);
+    
+    return resultingLayerProperties;
+}
+
+static void applyLayerPropertiesToLayer(HLSLayerProperties layerProperties, CALayer *layer)
+{
+    layer.opacity = layerProperties.opacity;
+    layer.transform = layerProperties.transform;
+    layer.anchorPoint = layerProperties.anchorPoint;
+    layer.anchorPointZ = layerProperties.anchorPointZ;
+    layer.shouldRasterize = layerProperties.shouldRasterize;
+    layer.rasterizationScale = layerProperties.rasterizationScale;
+    layer.sublayerTransform = layerProperties.sublayerTransform;
+    
+    // Save the information relative / not relative to the perspective separately
+    [layer setValue:[NSNumber numberWithFloat:layerProperties.sublayerCameraZPosition] forKey:kLayerCameraZPositionForSublayersKey];
+    [layer setValue:[NSValue valueWithCATransform3D:layerProperties.nonProjectedSublayerTransform] forKey:kLayerNonProjectedSublayerTransformKey];
+}
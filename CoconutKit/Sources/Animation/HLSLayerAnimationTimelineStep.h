@@ -0,0 +1,70 @@
+//
+//  HLSLayerAnimationTimelineStep.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSAnimationStep.h"
+#import "HLSAnimationStep+Friend.h"
+#import "HLSLayerAnimationStep.h"
+
+/**
+ * Private class used by HLSAnimation to play a sequence of consecutive layer animation steps as a single step. Instead
+ * of playing each layer animation step in turn (each with its own transaction, and waiting on its end callback before
+ * the next one can be started), all changes made to a layer during the sequence are compiled into a single animation
+ * group, in which the animations of each step are offset using their begin time. Core Animation can therefore run the
+ * whole sequence without any main thread involvement at step boundaries. The end of each layer animation step in the
+ * sequence must be detected by the client based on timestamps (see -reachElapsedTime:), except for the last one, whose
+ * end coincides with the end of the timeline step itself
+ *
+ * Designated initializer: -initWithLayerAnimationSteps:
+ */
+@interface HLSLayerAnimationTimelineStep : HLSAnimationStep {
+@private
+    NSArray *m_layerAnimationSteps;
+    NSArray *m_layers;
+    NSUInteger m_numberOfReachedLayerAnimationSteps;
+    CGFloat m_animationDurationFactor;
+    NSUInteger m_numberOfLayerAnimations;
+    NSUInteger m_numberOfFinishedLayerAnimations;
+    CFTimeInterval m_startTime;
+    CFTimeInterval m_pauseTime;
+    CFTimeInterval m_previousPauseDuration;
+}
+
+/**
+ * Return the array of animation steps obtained by replacing each sequence of at least two consecutive layer animation
+ * steps with a timeline step playing them. Layer animation steps with a zero duration do not take part in sequences
+ */
++ (NSArray *)animationStepsByCompilingLayerAnimationSteps:(NSArray *)animationSteps;
+
+/**
+ * Create a timeline step playing the specified layer animation steps (which are not copied) one after the other
+ */
+- (id)initWithLayerAnimationSteps:(NSArray *)layerAnimationSteps;
+
+/**
+ * The layer animation steps played by the timeline step
+ */
+@property (nonatomic, readonly, retain) NSArray *layerAnimationSteps;
+
+/**
+ * Return the layer animation steps (except the last one) whose end time has been reached at the specified elapsed time
+ * of the timeline step, and which had not been returned yet
+ */
+- (NSArray *)reachElapsedTime:(NSTimeInterval)elapsedTime;
+
+/**
+ * Must be called when the timeline step has been moved back in time, so that the steps which have not been reached at
+ * the specified elapsed time can be returned again by -reachElapsedTime:
+ */
+- (void)rewindToElapsedTime:(NSTimeInterval)elapsedTime;
+
+/**
+ * The layer animation steps which have not been returned by -reachElapsedTime: yet
+ */
+- (NSArray *)unreachedLayerAnimationSteps;
+
+@end
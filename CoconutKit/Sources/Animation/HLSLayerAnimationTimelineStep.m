@@ -0,0 +1,426 @@
+//
+//  HLSLayerAnimationTimelineStep.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSLayerAnimationTimelineStep.h"
+
+#import "CALayer+HLSExtensions.h"
+#import "HLSAnimationScheduler+Friend.h"
+#import "HLSAnimationStep+Friend.h"
+#import "HLSAnimationStep+Protected.h"
+#import "HLSAssert.h"
+#import "HLSFloat.h"
+#import "HLSLayerAnimationStep+Friend.h"
+#import "HLSLogger.h"
+
+static NSString * const kLayerAnimationTimelineGroupKey = @"HLSLayerAnimationTimelineGroup";
+
+@interface HLSLayerAnimationTimelineStep ()
+
+@property (nonatomic, retain) NSArray *layerAnimationSteps;
+@property (nonatomic, retain) NSArray *layers;
+
+- (NSTimeInterval)endTimeOfLayerAnimationStepAtIndex:(NSUInteger)index;
+
+- (void)animationDidStop:(CAAnimation *)animation finished:(BOOL)finished;
+
+@end
+
+@implementation HLSLayerAnimationTimelineStep
+
+#pragma mark Class methods
+
++ (NSArray *)animationStepsByCompilingLayerAnimationSteps:(NSArray *)animationSteps
+{
+    NSMutableArray *compiledAnimationSteps = [NSMutableArray array];
+    NSMutableArray *layerAnimationSteps = [NSMutableArray array];
+    
+    // A null object is used as sentinel to flush the last sequence
+    NSMutableArray *terminatedAnimationSteps = [NSMutableArray arrayWithArray:animationSteps];
+    [terminatedAnimationSteps addObject:[NSNull null]];
+    
+    for (id animationStep in terminatedAnimationSteps) {
+        // Steps with a zero duration cannot be compiled (a zero duration has a special meaning for Core Animation). Timeline
+        // steps are never compiled again
+        if ([animationStep isKindOfClass:[HLSLayerAnimationStep class]]
+                && ! doubleeq([animationStep duration], 0.)) {
+            [layerAnimationSteps addObject:animationStep];
+            continue;
+        }
+        
+        // Only compile sequences which are worth it, and for which at least one layer is animated (otherwise no end
+        // animation callback would be received)
+        BOOL hasLayers = NO;
+        for (HLSLayerAnimationStep *layerAnimationStep in layerAnimationSteps) {
+            if ([[layerAnimationStep objects] count] != 0) {
+                hasLayers = YES;
+                break;
+            }
+        }
+        
+        if ([layerAnimationSteps count] > 1 && hasLayers) {
+            HLSLayerAnimationTimelineStep *timelineStep = [[[HLSLayerAnimationTimelineStep alloc] initWithLayerAnimationSteps:layerAnimationSteps] autorelease];
+            [compiledAnimationSteps addObject:timelineStep];
+        }
+        else {
+            [compiledAnimationSteps addObjectsFromArray:layerAnimationSteps];
+        }
+        [layerAnimationSteps removeAllObjects];
+        
+        if (animationStep != [NSNull null]) {
+            [compiledAnimationSteps addObject:animationStep];
+        }
+    }
+    
+    return [NSArray arrayWithArray:compiledAnimationSteps];
+}
+
+#pragma mark Object creation and destruction
+
+- (id)initWithLayerAnimationSteps:(NSArray *)layerAnimationSteps
+{
+    if ((self = [super init])) {
+        HLSAssertObjectsInEnumerationAreKindOfClass(layerAnimationSteps, HLSLayerAnimationStep);
+        self.layerAnimationSteps = [NSArray arrayWithArray:layerAnimationSteps];
+        
+        // Collect the layers involved in the sequence, in the order they appear. Layers are not retained
+        NSMutableArray *layers = [NSMutableArray array];
+        NSTimeInterval duration = 0.;
+        for (HLSLayerAnimationStep *layerAnimationStep in self.layerAnimationSteps) {
+            for (CALayer *layer in [layerAnimationStep objects]) {
+                NSValue *layerKey = [NSValue valueWithPointer:layer];
+                if (! [layers containsObject:layerKey]) {
+                    [layers addObject:layerKey];
+                }
+            }
+            duration += layerAnimationStep.duration;
+        }
+        self.layers = [NSArray arrayWithArray:layers];
+        self.duration = duration;
+        
+        m_animationDurationFactor = 1.f;
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    self.layerAnimationSteps = nil;
+    self.layers = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize layerAnimationSteps = m_layerAnimationSteps;
+
+@synthesize layers = m_layers;
+
+- (NSArray *)unreachedLayerAnimationSteps
+{
+    NSRange range = NSMakeRange(m_numberOfReachedLayerAnimationSteps, [self.layerAnimationSteps count] - m_numberOfReachedLayerAnimationSteps);
+    return [self.layerAnimationSteps subarrayWithRange:range];
+}
+
+#pragma mark Timeline
+
+- (NSTimeInterval)endTimeOfLayerAnimationStepAtIndex:(NSUInteger)index
+{
+    NSTimeInterval endTime = 0.;
+    for (NSUInteger i = 0; i <= index; ++i) {
+        HLSLayerAnimationStep *layerAnimationStep = [self.layerAnimationSteps objectAtIndex:i];
+        endTime += layerAnimationStep.duration;
+    }
+    return endTime;
+}
+
+- (NSArray *)reachElapsedTime:(NSTimeInterval)elapsedTime
+{
+    // The end of the last step is reported when the timeline step itself ends
+    NSMutableArray *reachedLayerAnimationSteps = [NSMutableArray array];
+    while (m_numberOfReachedLayerAnimationSteps + 1 < [self.layerAnimationSteps count]
+           && doublele([self endTimeOfLayerAnimationStepAtIndex:m_numberOfReachedLayerAnimationSteps], elapsedTime)) {
+        [reachedLayerAnimationSteps addObject:[self.layerAnimationSteps objectAtIndex:m_numberOfReachedLayerAnimationSteps]];
+        ++m_numberOfReachedLayerAnimationSteps;
+    }
+    return [NSArray arrayWithArray:reachedLayerAnimationSteps];
+}
+
+- (void)rewindToElapsedTime:(NSTimeInterval)elapsedTime
+{
+    while (m_numberOfReachedLayerAnimationSteps != 0
+           && doublegt([self endTimeOfLayerAnimationStepAtIndex:m_numberOfReachedLayerAnimationSteps - 1], elapsedTime)) {
+        --m_numberOfReachedLayerAnimationSteps;
+    }
+}
+
+#pragma mark Managing the animation
+
+- (void)playAnimationWithStartTime:(NSTimeInterval)startTime animated:(BOOL)animated
+{
+    NSAssert(doublele(startTime, self.duration), @"The start time of a step cannot be greater than its duration");
+    
+    m_numberOfReachedLayerAnimationSteps = 0;
+    
+    // Apply all steps one after the other, collecting the animations for each layer
+    NSMutableDictionary *layerKeyToAnimationsMap = [NSMutableDictionary dictionary];
+    NSMutableSet *animatedLayerKeys = [NSMutableSet set];
+    
+    m_animationDurationFactor = animated ? [HLSLayerAnimationStep animationDurationFactor] : 1.f;
+    NSTimeInterval beginTime = 0.;
+    for (HLSLayerAnimationStep *layerAnimationStep in self.layerAnimationSteps) {
+        NSTimeInterval duration = layerAnimationStep.duration;
+        
+        // Steps completely elapsed at the start time are not reported
+        if (animated && doublele(beginTime + duration, startTime)) {
+            ++m_numberOfReachedLayerAnimationSteps;
+        }
+        
+        for (CALayer *layer in [layerAnimationStep objects]) {
+            NSArray *animations = [layerAnimationStep applyLayerAnimationToLayer:layer animated:animated];
+            if (! animated) {
+                continue;
+            }
+            
+            NSValue *layerKey = [NSValue valueWithPointer:layer];
+            
+            // The model value of each property is the one at the end of the whole sequence. Each animation must therefore
+            // hold its end value until the next animation of the same property begins (in a group, later animations prevail
+            // for a given property). The first animations of a layer must also display their start values until they begin
+            NSString *fillMode = [animatedLayerKeys containsObject:layerKey] ? kCAFillModeForwards : kCAFillModeBoth;
+            [animatedLayerKeys addObject:layerKey];
+            
+            // Animations are offset so that the start time corresponds to the beginning of the group (animations beginning
+            // before it get a negative begin time). Animations of staggered layers are additionally offset within their step
+            HLSVector2 timeRange = [layerAnimationStep timeRangeForLayer:layer];
+            for (CAAnimation *animation in animations) {
+                animation.beginTime = (beginTime + timeRange.v1 * duration - startTime) * m_animationDurationFactor;
+                animation.duration = (timeRange.v2 - timeRange.v1) * duration * m_animationDurationFactor;
+                animation.timingFunction = layerAnimationStep.timingCurve ? nil : layerAnimationStep.timingFunction;
+                animation.fillMode = fillMode;
+            }
+            
+            NSMutableArray *layerAnimations = [layerKeyToAnimationsMap objectForKey:layerKey];
+            if (! layerAnimations) {
+                layerAnimations = [NSMutableArray array];
+                [layerKeyToAnimationsMap setObject:layerAnimations forKey:layerKey];
+            }
+            [layerAnimations addObjectsFromArray:animations];
+        }
+        
+        beginTime += duration;
+    }
+    
+    if (! animated) {
+        return;
+    }
+    
+    // Nested in the transaction of the current run loop turn, so that all steps started together are committed at once
+    [[HLSAnimationScheduler sharedAnimationScheduler] beginAnimationStepTransaction];
+    [CATransaction begin];
+    
+    for (NSValue *layerKey in self.layers) {
+        CALayer *layer = [layerKey pointerValue];
+        
+        CAAnimationGroup *animationGroup = [CAAnimationGroup animation];
+        animationGroup.animations = [NSArray arrayWithArray:[layerKeyToAnimationsMap objectForKey:layerKey]];
+        animationGroup.duration = (self.duration - startTime) * m_animationDurationFactor;
+        animationGroup.delegate = self;
+        [layer addAnimation:animationGroup forKey:kLayerAnimationTimelineGroupKey];
+    }
+    
+    // Same remark as in HLSLayerAnimationStep.m: Layers might be dead when the end callbacks are received
+    m_numberOfFinishedLayerAnimations = 0;
+    m_numberOfLayerAnimations = [self.layers count];
+    
+    // When a start time has been defined, the animation must look like it started earlier
+    m_startTime = CACurrentMediaTime() - startTime * m_animationDurationFactor;
+    m_pauseTime = 0.;
+    m_previousPauseDuration = 0.;
+    
+    [CATransaction commit];
+}
+
+- (void)pauseAnimation
+{
+    for (NSValue *layerKey in self.layers) {
+        CALayer *layer = [layerKey pointerValue];
+        [layer pauseAllAnimations];
+    }
+    
+    m_pauseTime = CACurrentMediaTime();
+}
+
+- (void)resumeAnimation
+{
+    for (NSValue *layerKey in self.layers) {
+        CALayer *layer = [layerKey pointerValue];
+        [layer resumeAllAnimations];
+    }
+    
+    m_previousPauseDuration += CACurrentMediaTime() - m_pauseTime;
+    m_pauseTime = 0.;
+}
+
+- (BOOL)isAnimationPaused
+{
+    return ! doubleeq(m_pauseTime, 0.);
+}
+
+- (void)terminateAnimation
+{
+    // Same remark as in HLSLayerAnimationStep.m
+    for (NSValue *layerKey in self.layers) {
+        CALayer *layer = [layerKey pointerValue];
+        [layer removeAllAnimationsRecursively];
+    }
+}
+
+- (void)freezeAnimation
+{
+    for (NSValue *layerKey in self.layers) {
+        CALayer *layer = [layerKey pointerValue];
+        [HLSLayerAnimationStep freezeAnimationsOfLayer:layer];
+    }
+}
+
+- (NSArray *)animatedLayers
+{
+    NSMutableArray *animatedLayers = [NSMutableArray array];
+    for (NSValue *layerKey in self.layers) {
+        CALayer *layer = [layerKey pointerValue];
+        [animatedLayers addObject:layer];
+    }
+    return [NSArray arrayWithArray:animatedLayers];
+}
+
+- (NSArray *)rasterizableLayers
+{
+    // A layer can only be rasterized if it can be during all steps it is involved in
+    NSMutableArray *rasterizableLayers = [NSMutableArray array];
+    NSMutableSet *excludedLayerKeys = [NSMutableSet set];
+    for (HLSLayerAnimationStep *layerAnimationStep in self.layerAnimationSteps) {
+        NSArray *stepRasterizableLayers = [layerAnimationStep rasterizableLayers];
+        for (CALayer *layer in [layerAnimationStep objects]) {
+            if ([stepRasterizableLayers containsObject:layer]) {
+                if (! [rasterizableLayers containsObject:layer]) {
+                    [rasterizableLayers addObject:layer];
+                }
+            }
+            else {
+                [excludedLayerKeys addObject:[NSValue valueWithPointer:layer]];
+            }
+        }
+    }
+    
+    for (NSValue *layerKey in excludedLayerKeys) {
+        [rasterizableLayers removeObject:[layerKey pointerValue]];
+    }
+    return [NSArray arrayWithArray:rasterizableLayers];
+}
+
+- (NSTimeInterval)elapsedTime
+{
+    NSTimeInterval currentPauseDuration = 0.;
+    if (! doubleeq(m_pauseTime, 0.)) {
+        currentPauseDuration = CACurrentMediaTime() - m_pauseTime;
+    }
+    
+    return (CACurrentMediaTime() - m_startTime - m_previousPauseDuration - currentPauseDuration) / m_animationDurationFactor;
+}
+
+#pragma mark Recycling
+
+- (void)recycle
+{
+    // Timeline steps cannot be created using -init and are not recycled. The steps they play are
+    if (self.delegate) {
+        HLSLoggerDebug(@"The animation step is running and cannot be recycled");
+        return;
+    }
+    
+    for (HLSLayerAnimationStep *layerAnimationStep in self.layerAnimationSteps) {
+        [layerAnimationStep recycle];
+    }
+}
+
+#pragma mark Reverse animation
+
+- (id)reverseAnimationStep
+{
+    NSMutableArray *reverseLayerAnimationSteps = [NSMutableArray array];
+    for (HLSLayerAnimationStep *layerAnimationStep in [self.layerAnimationSteps reverseObjectEnumerator]) {
+        [reverseLayerAnimationSteps addObject:[layerAnimationStep reverseAnimationStep]];
+    }
+    
+    HLSLayerAnimationTimelineStep *reverseTimelineStep = [[[HLSLayerAnimationTimelineStep alloc] initWithLayerAnimationSteps:reverseLayerAnimationSteps] autorelease];
+    reverseTimelineStep.tag = self.tag;
+    reverseTimelineStep.userInfo = self.userInfo;
+    return reverseTimelineStep;
+}
+
+#pragma mark Substituting objects
+
+- (id)animationStepBySubstitutingObjects:(NSDictionary *)objectKeyToSubstituteObjectMap
+{
+    NSMutableArray *layerAnimationSteps = [NSMutableArray array];
+    for (HLSLayerAnimationStep *layerAnimationStep in self.layerAnimationSteps) {
+        [layerAnimationSteps addObject:[layerAnimationStep animationStepBySubstitutingObjects:objectKeyToSubstituteObjectMap]];
+    }
+    
+    HLSLayerAnimationTimelineStep *timelineStep = [[[HLSLayerAnimationTimelineStep alloc] initWithLayerAnimationSteps:layerAnimationSteps] autorelease];
+    timelineStep.tag = self.tag;
+    timelineStep.userInfo = self.userInfo;
+    return timelineStep;
+}
+
+#pragma mark NSCopying protocol implementation
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    NSMutableArray *layerAnimationStepCopies = [NSMutableArray array];
+    for (HLSLayerAnimationStep *layerAnimationStep in self.layerAnimationSteps) {
+        [layerAnimationStepCopies addObject:[[layerAnimationStep copyWithZone:zone] autorelease]];
+    }
+    
+    HLSLayerAnimationTimelineStep *timelineStepCopy = [[HLSLayerAnimationTimelineStep allocWithZone:zone] initWithLayerAnimationSteps:layerAnimationStepCopies];
+    timelineStepCopy.tag = self.tag;
+    timelineStepCopy.userInfo = self.userInfo;
+    return timelineStepCopy;
+}
+
+#pragma mark Animation callbacks
+
+- (void)animationDidStop:(CAAnimation *)animation finished:(BOOL)finished
+{
+    m_numberOfFinishedLayerAnimations++;
+    
+    if (m_numberOfFinishedLayerAnimations == m_numberOfLayerAnimations) {
+        [self notifyAsynchronousAnimationStepDidStopFinished:finished];
+    }
+}
+
+#pragma mark Description
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p; layerAnimationSteps: %@; duration: %.2f; tag: %@>",
+            [self class],
+            self,
+            self.layerAnimationSteps,
+            self.duration,
+            self.tag];
+}
+
+@end
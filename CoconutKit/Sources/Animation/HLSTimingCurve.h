@@ -0,0 +1,81 @@
+//
+//  HLSTimingCurve.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Timing curve types
+ */
+typedef enum {
+    HLSTimingCurveTypeEnumBegin = 0,
+    HLSTimingCurveTypeSpring = HLSTimingCurveTypeEnumBegin,         // Damped harmonic oscillator
+    HLSTimingCurveTypeDecay,                                        // Exponential deceleration
+    HLSTimingCurveTypeEnumEnd,
+    HLSTimingCurveTypeEnumSize = HLSTimingCurveTypeEnumEnd - HLSTimingCurveTypeEnumBegin
+} HLSTimingCurveType;
+
+/**
+ * A timing curve describes physically-based motion which cannot be expressed using a CAMediaTimingFunction (whose
+ * cubic Bézier curves cannot oscillate). It maps the normalized time of an animation step (between 0 and 1) to the
+ * corresponding animation progress (0 at the beginning, 1 at the end, and which might lie outside this range in 
+ * between, e.g. when overshooting with a spring). Layer animation steps using a timing curve (see the timingCurve
+ * property of HLSLayerAnimationStep) are played using keyframe animations whose values are sampled from the curve
+ * once when the step is played. Sampled values are cached per set of curve parameters
+ *
+ * Timing curves are immutable
+ *
+ * Designated initializer: -initWithType:parameter1:parameter2:
+ */
+@interface HLSTimingCurve : NSObject {
+@private
+    HLSTimingCurveType m_type;
+    CGFloat m_parameter1;
+    CGFloat m_parameter2;
+    BOOL m_reversed;
+}
+
+/**
+ * Create a spring timing curve, with the specified damping ratio (> 0; less than 1 for an oscillating spring, 1 for a
+ * critically damped one) and undamped frequency, given as number of oscillations during the step (> 0). Choose values
+ * for which the spring has come to rest at the end of the step (e.g. a damping ratio of 0.3 with 2 oscillations), 
+ * otherwise the motion will jump to its final value at the end of the step
+ */
++ (HLSTimingCurve *)springTimingCurveWithDampingRatio:(CGFloat)dampingRatio frequency:(CGFloat)frequency;
+
+/**
+ * Create a decay timing curve, for which the motion starts fast and decelerates exponentially. The larger the
+ * deceleration rate (> 0), the faster the motion slows down
+ */
++ (HLSTimingCurve *)decayTimingCurveWithDecelerationRate:(CGFloat)decelerationRate;
+
+/**
+ * Create a timing curve of the specified type. The parameters are interpreted according to the type (damping ratio
+ * and frequency for springs, deceleration rate for decay curves, the second parameter being ignored)
+ */
+- (id)initWithType:(HLSTimingCurveType)type parameter1:(CGFloat)parameter1 parameter2:(CGFloat)parameter2;
+
+/**
+ * The curve type
+ */
+@property (nonatomic, readonly, assign) HLSTimingCurveType type;
+
+/**
+ * Return the progress at the specified normalized time (between 0 and 1)
+ */
+- (CGFloat)progressAtTime:(CGFloat)time;
+
+/**
+ * Return the progress values (as NSNumbers) sampled at the specified number of equally spaced times (at least 2). The
+ * first value is always 0 and the last one always 1. Results are cached
+ */
+- (NSArray *)progressValuesWithNumberOfSamples:(NSUInteger)numberOfSamples;
+
+/**
+ * The timing curve to use when playing an animation backwards
+ */
+- (HLSTimingCurve *)reverseTimingCurve;
+
+@end
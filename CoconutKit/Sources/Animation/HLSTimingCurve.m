@@ -0,0 +1,183 @@
+//
+//  HLSTimingCurve.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTimingCurve.h"
+
+#import "HLSAssert.h"
+#import "HLSConverters.h"
+#import "HLSFloat.h"
+#import "HLSLogger.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
+
+@interface HLSTimingCurve ()
+
+@property (nonatomic, assign) BOOL reversed;
+
++ (NSCache *)progressValuesCache;
+
+- (CGFloat)forwardProgressAtTime:(CGFloat)time;
+
+@end
+
+@implementation HLSTimingCurve
+
+#pragma mark Class methods
+
++ (HLSTimingCurve *)springTimingCurveWithDampingRatio:(CGFloat)dampingRatio frequency:(CGFloat)frequency
+{
+    return [[[[self class] alloc] initWithType:HLSTimingCurveTypeSpring parameter1:dampingRatio parameter2:frequency] autorelease];
+}
+
++ (HLSTimingCurve *)decayTimingCurveWithDecelerationRate:(CGFloat)decelerationRate
+{
+    return [[[[self class] alloc] initWithType:HLSTimingCurveTypeDecay parameter1:decelerationRate parameter2:0.f] autorelease];
+}
+
++ (NSCache *)progressValuesCache
+{
+    static NSCache *s_progressValuesCache = nil;
+    if (! s_progressValuesCache) {
+        s_progressValuesCache = [[NSCache alloc] init];
+    }
+    return s_progressValuesCache;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)initWithType:(HLSTimingCurveType)type parameter1:(CGFloat)parameter1 parameter2:(CGFloat)parameter2
+{
+    if ((self = [super init])) {
+        if (floatle(parameter1, 0.f) || (type == HLSTimingCurveTypeSpring && floatle(parameter2, 0.f))) {
+            HLSLoggerError(@"Timing curve parameters must be > 0");
+            [self release];
+            return nil;
+        }
+        
+        m_type = type;
+        m_parameter1 = parameter1;
+        m_parameter2 = parameter2;
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize type = m_type;
+
+@synthesize reversed = m_reversed;
+
+#pragma mark Progress
+
+- (CGFloat)progressAtTime:(CGFloat)time
+{
+    // The curve of the reverse motion is obtained by a point reflection about (0.5, 0.5)
+    if (self.reversed) {
+        return 1.f - [self forwardProgressAtTime:1.f - time];
+    }
+    else {
+        return [self forwardProgressAtTime:time];
+    }
+}
+
+- (CGFloat)forwardProgressAtTime:(CGFloat)time
+{
+    switch (self.type) {
+        case HLSTimingCurveTypeSpring: {
+            // Damped harmonic oscillator released from rest at distance 1 from its equilibrium position (the progress
+            // is the distance travelled towards it)
+            CGFloat dampingRatio = m_parameter1;
+            CGFloat angularFrequency = 2.f * M_PI * m_parameter2;
+            if (floatlt(dampingRatio, 1.f)) {
+                CGFloat dampedAngularFrequency = angularFrequency * sqrtf(1.f - dampingRatio * dampingRatio);
+                return 1.f - expf(-dampingRatio * angularFrequency * time)
+                    * (cosf(dampedAngularFrequency * time) 
+                       + dampingRatio * angularFrequency / dampedAngularFrequency * sinf(dampedAngularFrequency * time));
+            }
+            else if (floateq(dampingRatio, 1.f)) {
+                return 1.f - expf(-angularFrequency * time) * (1.f + angularFrequency * time);
+            }
+            else {
+                CGFloat root1 = -angularFrequency * (dampingRatio - sqrtf(dampingRatio * dampingRatio - 1.f));
+                CGFloat root2 = -angularFrequency * (dampingRatio + sqrtf(dampingRatio * dampingRatio - 1.f));
+                return 1.f - (root2 * expf(root1 * time) - root1 * expf(root2 * time)) / (root2 - root1);
+            }
+            break;
+        }
+            
+        case HLSTimingCurveTypeDecay: {
+            // Normalized so that the motion ends exactly at the end of the step
+            CGFloat decelerationRate = m_parameter1;
+            return (1.f - expf(-decelerationRate * time)) / (1.f - expf(-decelerationRate));
+            break;
+        }
+            
+        default: {
+            HLSLoggerError(@"Unknown timing curve type");
+            return time;
+            break;
+        }
+    }
+}
+
+- (NSArray *)progressValuesWithNumberOfSamples:(NSUInteger)numberOfSamples
+{
+    if (numberOfSamples < 2) {
+        HLSLoggerError(@"At least 2 samples are required");
+        return nil;
+    }
+    
+    NSString *cacheKey = [NSString stringWithFormat:@"%d_%f_%f_%d_%u", self.type, m_parameter1, m_parameter2, self.reversed, numberOfSamples];
+    NSArray *progressValues = [[HLSTimingCurve progressValuesCache] objectForKey:cacheKey];
+    if (progressValues) {
+        return progressValues;
+    }
+    
+    NSMutableArray *mutableProgressValues = [NSMutableArray arrayWithCapacity:numberOfSamples];
+    [mutableProgressValues addObject:[NSNumber numberWithFloat:0.f]];
+    for (NSUInteger i = 1; i < numberOfSamples - 1; ++i) {
+        CGFloat time = (CGFloat)i / (numberOfSamples - 1);
+        [mutableProgressValues addObject:[NSNumber numberWithFloat:[self progressAtTime:time]]];
+    }
+    [mutableProgressValues addObject:[NSNumber numberWithFloat:1.f]];
+    
+    progressValues = [NSArray arrayWithArray:mutableProgressValues];
+    [[HLSTimingCurve progressValuesCache] setObject:progressValues forKey:cacheKey];
+    return progressValues;
+}
+
+#pragma mark Reverse curve
+
+- (HLSTimingCurve *)reverseTimingCurve
+{
+    HLSTimingCurve *reverseTimingCurve = [[[HLSTimingCurve alloc] initWithType:self.type parameter1:m_parameter1 parameter2:m_parameter2] autorelease];
+    reverseTimingCurve.reversed = ! self.reversed;
+    return reverseTimingCurve;
+}
+
+#pragma mark Description
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p; type: %d; parameter1: %.2f; parameter2: %.2f; reversed: %@>",
+            [self class],
+            self,
+            self.type,
+            m_parameter1,
+            m_parameter2,
+            HLSStringFromBool(self.reversed)];
+}
+
+@end
@@ -13,13 +13,23 @@
 @interface HLSViewAnimation (Friend)
 
 /**
- * The transform corresponding to the view animation settings
+ * The parameters of the view animation
  */
-@property (nonatomic, readonly, assign) CGAffineTransform transform;
+@property (nonatomic, readonly, assign) HLSViewAnimationParameters parameters;
+
+@end
 
 /**
- * The increment to apply to the view alpha value
+ * Return the transform corresponding to view animation parameters
  */
-@property (nonatomic, readonly, assign) CGFloat alphaIncrement;
+CGAffineTransform HLSViewAnimationParametersTransform(HLSViewAnimationParameters parameters);
 
-@end
+/**
+ * Return the parameters of the inverse animation
+ */
+HLSViewAnimationParameters HLSViewAnimationParametersReverse(HLSViewAnimationParameters parameters);
+
+/**
+ * Return a human-readable description of view animation parameters
+ */
+NSString *HLSStringFromViewAnimationParameters(HLSViewAnimationParameters parameters);
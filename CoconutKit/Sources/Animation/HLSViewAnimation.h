@@ -10,6 +10,15 @@
 
 #import "HLSVector.h"
 
+/**
+ * The parameters of a view animation, stored by value in the view animation steps they are added to
+ */
+typedef struct {
+    HLSVector2 scaleParameters;
+    HLSVector2 translationParameters;
+    CGFloat alphaIncrement;
+} HLSViewAnimationParameters;
+
 /**
  * A view animation (HLSViewAnimation) describes the changes applied to a view within an animation step 
  * (HLSViewAnimationStep). An animation step is the combination of several view animations applied
@@ -26,13 +35,14 @@
  * In general, and if you do not need to animate view frames to resize subviews during animations, you should 
  * use layer animations instead of view animations since they have far more capabilities.
  *
+ * As layer animations, view animations are lightweight builders whose parameters are copied by value into the steps
+ * they are added to
+ *
  * Designated initializer: -init (create a view animation step with default settings)
  */
 @interface HLSViewAnimation : HLSObjectAnimation {
 @private
-    HLSVector2 m_scaleParameters;
-    HLSVector2 m_translationParameters;
-    CGFloat m_alphaIncrement;
+    HLSViewAnimationParameters m_parameters;
 }
 
 /**
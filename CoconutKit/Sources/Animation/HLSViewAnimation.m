@@ -11,23 +11,16 @@
 #import "HLSFloat.h"
 #import "HLSLogger.h"
 #import "HLSObjectAnimation+Friend.h"
+#import "HLSViewAnimation+Friend.h"
 #import "NSString+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
+
 /**
  * Please read the remarks at the top of HLSLayerAnimation.m
  */
 
-@interface HLSViewAnimation ()
-
-@property (nonatomic, assign) HLSVector2 scaleParameters;
-@property (nonatomic, assign) HLSVector2 translationParameters;
-@property (nonatomic, assign) CGFloat alphaIncrement;
-
-- (CGAffineTransform)scaleTransform;
-- (CGAffineTransform)translationTransform;
-
-@end
-
 @implementation HLSViewAnimation
 
 #pragma mark Object creation and destruction
@@ -36,82 +29,62 @@
 {
     if ((self = [super init])) {
         // Default: No change
-        self.scaleParameters = HLSVector2Make(1.f, 1.f);
-        self.translationParameters = HLSVector2Make(0.f, 0.f);
+        m_parameters.scaleParameters = HLSVector2Make(1.f, 1.f);
+        m_parameters.translationParameters = HLSVector2Make(0.f, 0.f);
+        m_parameters.alphaIncrement = 0.f;
     }
     return self;
 }
 
 #pragma mark Accessors and mutators
 
-@synthesize scaleParameters = m_scaleParameters;
-
-@synthesize translationParameters = m_translationParameters;
-
-@synthesize alphaIncrement = m_alphaIncrement;
+- (HLSViewAnimationParameters)parameters
+{
+    return m_parameters;
+}
 
 - (void)addToAlpha:(CGFloat)alphaIncrement
 {
     // Sanitize input
     if (floatlt(alphaIncrement, -1.f)) {
         HLSLoggerWarn(@"Alpha increment cannot be smaller than -1. Fixed to -1");
-        m_alphaIncrement = -1.f;
+        m_parameters.alphaIncrement = -1.f;
     }
     else if (floatgt(alphaIncrement, 1.f)) {
         HLSLoggerWarn(@"Alpha variation cannot be larger than 1. Fixed to 1");
-        m_alphaIncrement = 1.f;
+        m_parameters.alphaIncrement = 1.f;
     }
     else {
-        m_alphaIncrement = alphaIncrement;
+        m_parameters.alphaIncrement = alphaIncrement;
     }
 }
 
-- (CGAffineTransform)transform
-{
-    return CGAffineTransformConcat([self scaleTransform], [self translationTransform]);
-}
-
-- (CGAffineTransform)scaleTransform
-{
-    return CGAffineTransformMakeScale(self.scaleParameters.v1, self.scaleParameters.v2);
-}
-
-- (CGAffineTransform)translationTransform
-{
-    return CGAffineTransformMakeTranslation(self.translationParameters.v1, self.translationParameters.v2);
-}
-
 #pragma mark Convenience methods
 
 - (void)scaleWithXFactor:(CGFloat)xFactor yFactor:(CGFloat)yFactor
 {
-    self.scaleParameters = HLSVector2Make(xFactor, yFactor);
+    m_parameters.scaleParameters = HLSVector2Make(xFactor, yFactor);
 }
 
 - (void)translateByVectorWithX:(CGFloat)x y:(CGFloat)y
 {
-    self.translationParameters = HLSVector2Make(x, y);
+    m_parameters.translationParameters = HLSVector2Make(x, y);
 }
 
 - (void)transformFromRect:(CGRect)fromRect toRect:(CGRect)toRect
 {
-    self.scaleParameters = HLSVector2Make(CGRectGetWidth(toRect) / CGRectGetWidth(fromRect),
-                                          CGRectGetHeight(toRect) / CGRectGetHeight(fromRect));
-    self.translationParameters = HLSVector2Make(CGRectGetMidX(toRect) - CGRectGetMidX(fromRect),
-                                                CGRectGetMidY(toRect) - CGRectGetMidY(fromRect));
+    m_parameters.scaleParameters = HLSVector2Make(CGRectGetWidth(toRect) / CGRectGetWidth(fromRect),
+                                                  CGRectGetHeight(toRect) / CGRectGetHeight(fromRect));
+    m_parameters.translationParameters = HLSVector2Make(CGRectGetMidX(toRect) - CGRectGetMidX(fromRect),
+                                                        CGRectGetMidY(toRect) - CGRectGetMidY(fromRect));
 }
 
 #pragma mark Reverse animation
 
 - (id)reverseObjectAnimation
 {
-    // See remarks at the beginning
     HLSViewAnimation *reverseViewAnimation = [super reverseObjectAnimation];
-    [reverseViewAnimation scaleWithXFactor:1.f / self.scaleParameters.v1
-                                   yFactor:1.f / self.scaleParameters.v2];
-    [reverseViewAnimation translateByVectorWithX:-self.translationParameters.v1
-                                               y:-self.translationParameters.v2];
-    reverseViewAnimation.alphaIncrement = -self.alphaIncrement;
+    reverseViewAnimation->m_parameters = HLSViewAnimationParametersReverse(m_parameters);
     return reverseViewAnimation;
 }
 
@@ -120,9 +93,7 @@
 - (id)copyWithZone:(NSZone *)zone
 {
     HLSViewAnimation *viewAnimationCopy = [super copyWithZone:zone];
-    viewAnimationCopy.scaleParameters = self.scaleParameters;
-    viewAnimationCopy.translationParameters = self.translationParameters;
-    viewAnimationCopy.alphaIncrement = self.alphaIncrement;
+    viewAnimationCopy->m_parameters = m_parameters;
     return viewAnimationCopy;
 }
 
@@ -130,12 +101,40 @@
 
 - (NSString *)description
 {
-    return [NSString stringWithFormat:@"<%@: %p; scaleParameters: %@; translationParameters: %@; alphaIncrement: %.2f>", 
+    return [NSString stringWithFormat:@"<%@: %p; %@>", 
             [self class],
             self,
-            HLSStringFromVector2(self.scaleParameters),
-            HLSStringFromVector2(self.translationParameters),
-            self.alphaIncrement];
+            HLSStringFromViewAnimationParameters(m_parameters)];
 }
 
 @end
+
+#pragma mark Functions
+
+CGAffineTransform HLSViewAnimationParametersTransform(HLSViewAnimationParameters parameters)
+{
+    CGAffineTransform scaleTransform = CGAffineTransformMakeScale(parameters.scaleParameters.v1, parameters.scaleParameters.v2);
+    CGAffineTransform translationTransform = CGAffineTransformMakeTranslation(parameters.translationParameters.v1,
+                                                                              parameters.translationParameters.v2);
+    return CGAffineTransformConcat(scaleTransform, translationTransform);
+}
+
+HLSViewAnimationParameters HLSViewAnimationParametersReverse(HLSViewAnimationParameters parameters)
+{
+    // See remarks at the beginning
+    HLSViewAnimationParameters reverseParameters;
+    reverseParameters.scaleParameters = HLSVector2Make(1.f / parameters.scaleParameters.v1,
+                                                       1.f / parameters.scaleParameters.v2);
+    reverseParameters.translationParameters = HLSVector2Make(-parameters.translationParameters.v1,
+                                                             -parameters.translationParameters.v2);
+    reverseParameters.alphaIncrement = -parameters.alphaIncrement;
+    return reverseParameters;
+}
+
+NSString *HLSStringFromViewAnimationParameters(HLSViewAnimationParameters parameters)
+{
+    return [NSString stringWithFormat:@"scaleParameters: %@; translationParameters: %@; alphaIncrement: %.2f",
+            HLSStringFromVector2(parameters.scaleParameters),
+            HLSStringFromVector2(parameters.translationParameters),
+            parameters.alphaIncrement];
+}
@@ -15,11 +15,24 @@
 #import "HLSLogger.h"
 #import "HLSViewAnimation+Friend.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryAnimation
+
+/**
+ * Values reached by a view at the end of a step
+ */
+typedef struct {
+    CGRect frame;
+    CGFloat alpha;
+} HLSViewAnimationTarget;
+
 @interface HLSViewAnimationStep ()
 
 @property (nonatomic, retain) UIView *dummyView;
 
-- (void)animationStepDidStop:(NSString *)animationID finished:(NSNumber *)finished context:(void *)context;
+- (HLSViewAnimationTarget)targetForView:(UIView *)view;
+
+- (void)animationStepDidStopFinished:(BOOL)finished;
 
 @end
 
@@ -42,6 +55,13 @@
     [super dealloc];
 }
 
+#pragma mark Class methods
+
++ (size_t)objectAnimationParametersSize
+{
+    return sizeof(HLSViewAnimationParameters);
+}
+
 #pragma mark Accessors and mutators
 
 @synthesize curve = m_curve;
@@ -52,7 +72,41 @@
 
 - (void)addViewAnimation:(HLSViewAnimation *)viewAnimation forView:(UIView *)view
 {
-    [self addObjectAnimation:viewAnimation forObject:view];
+    if (! viewAnimation) {
+        HLSLoggerDebug(@"No animation for the view");
+        return;
+    }
+    
+    HLSViewAnimationParameters viewAnimationParameters = viewAnimation.parameters;
+    [self addObjectAnimationParameters:&viewAnimationParameters forObject:view];
+}
+
+- (HLSViewAnimationTarget)targetForView:(UIView *)view
+{
+    const HLSViewAnimationParameters *pViewAnimationParameters = [self objectAnimationParametersForObject:view];
+    NSAssert(pViewAnimationParameters != NULL, @"Missing view animation; data consistency failure");
+    
+    HLSViewAnimationTarget target;
+    
+    // Alpha animation (alpha must always lie between 0.f and 1.f)
+    target.alpha = view.alpha + pViewAnimationParameters->alphaIncrement;
+    if (floatlt(target.alpha, -1.f)) {
+        HLSLoggerWarn(@"View animations adding to an alpha value larger than -1 for view %@. Fixed to -1, but your animation is incorrect", view);
+        target.alpha = -1.f;
+    }
+    else if (floatgt(target.alpha, 1.f)) {
+        HLSLoggerWarn(@"View animations adding to an alpha value larger than 1 for view %@. Fixed to 1, but your animation is incorrect", view);
+        target.alpha = 1.f;
+    }
+    
+    // Animate the frame. The transform has to be applied on the view center. This requires a conversion in the coordinate system
+    // centered on the view
+    CGAffineTransform translationTransform = CGAffineTransformMakeTranslation(-view.center.x, -view.center.y);
+    CGAffineTransform convTransform = CGAffineTransformConcat(CGAffineTransformConcat(translationTransform, HLSViewAnimationParametersTransform(*pViewAnimationParameters)),
+                                                              CGAffineTransformInvert(translationTransform));
+    target.frame = CGRectApplyAffineTransform(view.frame, convTransform);
+    
+    return target;
 }
 
 - (void)playAnimationWithStartTime:(NSTimeInterval)startTime animated:(BOOL)animated
@@ -61,6 +115,17 @@
     // tweak those animations to implement start time support, and there is sadly no way to do it at the
     // UIView block level
     
+    // Compute all target values before entering the animation block, so that the block itself is a tight loop
+    // applying them. All views are animated by a single block
+    NSArray *views = [self objects];
+    NSUInteger numberOfViews = [views count];
+    HLSViewAnimationTarget *targets = (HLSViewAnimationTarget *)malloc(numberOfViews * sizeof(HLSViewAnimationTarget));
+    NSUInteger i = 0;
+    for (UIView *view in views) {
+        targets[i] = [self targetForView:view];
+        ++i;
+    }
+    
     if (animated) {
         // This dummy view fixes an issue encountered with animation blocks: If no view is altered
         // during an animation block, the block duration is reduced to 0. To prevent this, we create
@@ -68,54 +133,44 @@
         // reduced to 0
         self.dummyView = [[[UIView alloc] initWithFrame:CGRectZero] autorelease];
         [[UIApplication sharedApplication].keyWindow addSubview:self.dummyView];
-        
-        [UIView beginAnimations:nil context:NULL];
-        
-        [UIView setAnimationDuration:self.duration];
-        [UIView setAnimationCurve:self.curve];
-        
-        // Remark: The selector names animationWillStart:context: and animationDidStop:finished:context:, though appearing
-        //         in the UIKit UIView header documentation, are reserved by Apple. Using them might lead to app rejection!
-        [UIView setAnimationDidStopSelector:@selector(animationStepDidStop:finished:context:)];
-        [UIView setAnimationDelegate:self];
     }
     
-    for (UIView *view in [self objects]) {
-        HLSViewAnimation *viewAnimation = (HLSViewAnimation *)[self objectAnimationForObject:view];
-        NSAssert(viewAnimation != nil, @"Missing view animation; data consistency failure");
+    UIView *dummyView = self.dummyView;
+    void (^animations)(void) = ^{
+        for (NSUInteger j = 0; j < numberOfViews; ++j) {
+            UIView *view = [views objectAtIndex:j];
+            view.alpha = targets[j].alpha;
+            view.frame = targets[j].frame;
         
-        // Alpha animation (alpha must always lie between 0.f and 1.f)
-        CGFloat alpha = view.alpha + viewAnimation.alphaIncrement;
-        if (floatlt(alpha, -1.f)) {
-            HLSLoggerWarn(@"View animations adding to an alpha value larger than -1 for view %@. Fixed to -1, but your animation is incorrect", view);
-            alpha = -1.f;
-        }
-        else if (floatgt(alpha, 1.f)) {
-            HLSLoggerWarn(@"View animations adding to an alpha value larger than 1 for view %@. Fixed to 1, but your animation is incorrect", view);
-            alpha = 1.f;
+            // Ensure better subview resizing in some cases (e.g. UISearchBar)
+            [view layoutIfNeeded];
         }
         
-        view.alpha = alpha;
-        
-        // Animate the frame. The transform has to be applied on the view center. This requires a conversion in the coordinate system
-        // centered on the view
-        CGAffineTransform translationTransform = CGAffineTransformMakeTranslation(-view.center.x, -view.center.y);
-        CGAffineTransform convTransform = CGAffineTransformConcat(CGAffineTransformConcat(translationTransform, viewAnimation.transform),
-                                                                  CGAffineTransformInvert(translationTransform));
-        view.frame = CGRectApplyAffineTransform(view.frame, convTransform);
-        
-        // Ensure better subview resizing in some cases (e.g. UISearchBar)
-        [view layoutIfNeeded];
-    }
-        
-    if (animated) {
         // Animate the dummy view
-        self.dummyView.alpha = 1.f - self.dummyView.alpha;
-        
-        [UIView commitAnimations];
+        dummyView.alpha = 1.f - dummyView.alpha;
+    };
+    
+    if (animated) {
+        // Unlike -beginAnimations:context: / -commitAnimations, block-based animations disable user interaction by
+        // default. Keep the previous behavior (the HLSAnimation lockingUI property is meant to control this). The
+        // animation curve options are the UIViewAnimationCurve values shifted by 16 bits
+        UIViewAnimationOptions options = UIViewAnimationOptionAllowUserInteraction | (self.curve << 16);
+        [UIView animateWithDuration:self.duration
+                              delay:0.
+                            options:options
+                         animations:animations
+                         completion:^(BOOL finished) {
+                             [self animationStepDidStopFinished:finished];
+                         }];
         
-        // The code will resume in the animationDidStop:finished:context: method
+        // The code will resume in the completion block
     }
+    else {
+        animations();
+    }
+        
+    // The animation block is executed synchronously, targets are not needed anymore
+    free(targets);
 }
 
 - (void)pauseAnimation
@@ -150,6 +205,35 @@
     [self.dummyView.layer removeAllAnimationsRecursively];
 }
 
+- (void)freezeAnimation
+{
+    // View animations change the layer position and bounds, and the opacity
+    for (UIView *view in [self objects]) {
+        CALayer *presentationLayer = [view.layer presentationLayer];
+        if (! presentationLayer) {
+            continue;
+        }
+        
+        view.center = presentationLayer.position;
+        view.bounds = presentationLayer.bounds;
+        view.alpha = presentationLayer.opacity;
+    }
+}
+
+- (NSArray *)rasterizableLayers
+{
+    // Views whose frame is resized must be redrawn during the animation and cannot benefit from rasterization
+    NSMutableArray *rasterizableLayers = [NSMutableArray array];
+    for (UIView *view in [self objects]) {
+        const HLSViewAnimationParameters *pViewAnimationParameters = [self objectAnimationParametersForObject:view];
+        CGAffineTransform transform = HLSViewAnimationParametersTransform(*pViewAnimationParameters);
+        if (floateq(transform.a, 1.f) && floateq(transform.b, 0.f) && floateq(transform.c, 0.f) && floateq(transform.d, 1.f)) {
+            [rasterizableLayers addObject:view.layer];
+        }
+    }
+    return [NSArray arrayWithArray:rasterizableLayers];
+}
+
 - (NSTimeInterval)elapsedTime
 {
     // Since start time support cannot be implemented for UIView animations (see comment in -playAnimationWithStartTime:animated),
@@ -158,8 +242,23 @@
     return self.duration;
 }
 
+#pragma mark Recycling
+
+- (void)prepareForReuse
+{
+    [super prepareForReuse];
+    
+    self.curve = UIViewAnimationCurveEaseInOut;
+    self.dummyView = nil;
+}
+
 #pragma mark Reverse animation
 
+- (void)reverseObjectAnimationParameters:(const void *)parameters intoParameters:(void *)reverseParameters
+{
+    *(HLSViewAnimationParameters *)reverseParameters = HLSViewAnimationParametersReverse(*(const HLSViewAnimationParameters *)parameters);
+}
+
 - (id)reverseAnimationStep
 {
     HLSViewAnimationStep *reverseAnimationStep = [super reverseAnimationStep];
@@ -181,6 +280,15 @@
     return reverseAnimationStep;
 }
 
+#pragma mark Substituting objects
+
+- (id)animationStepBySubstitutingObjects:(NSDictionary *)objectKeyToSubstituteObjectMap
+{
+    HLSViewAnimationStep *animationStep = [super animationStepBySubstitutingObjects:objectKeyToSubstituteObjectMap];
+    animationStep.curve = self.curve;
+    return animationStep;
+}
+
 #pragma mark NSCopying protocol implementation
 
 - (id)copyWithZone:(NSZone *)zone
@@ -190,14 +298,21 @@
     return animationStepCopy;
 }
 
-#pragma mark Animation delegate methods
+#pragma mark Animation completion
 
-- (void)animationStepDidStop:(NSString *)animationID finished:(NSNumber *)finished context:(void *)context
+- (void)animationStepDidStopFinished:(BOOL)finished
 {
     [self.dummyView removeFromSuperview];
     self.dummyView = nil;
     
-    [self notifyAsynchronousAnimationStepDidStopFinished:[finished boolValue]];
+    [self notifyAsynchronousAnimationStepDidStopFinished:finished];
+}
+
+#pragma mark Description
+
+- (NSString *)descriptionForObjectAnimationParameters:(const void *)parameters
+{
+    return HLSStringFromViewAnimationParameters(*(const HLSViewAnimationParameters *)parameters);
 }
 
 @end
@@ -6,6 +6,11 @@
 //  Copyright (c) 2012 Hortis. All rights reserved.
 //
 
+/**
+ * Block receiving an asynchronously taken snapshot, nil if no snapshot could be taken
+ */
+typedef void (^HLSLayerSnapshotCompletionBlock)(UIImage *image);
+
 @interface CALayer (HLSExtensions)
 
 /**
@@ -29,9 +34,46 @@
  */
 - (BOOL)isPaused;
 
+/**
+ * Change the speed at which animations attached to a layer (and to its sublayers) are played, without any jump in the
+ * current animation state. If the layer has been paused, the speed is applied when animations are resumed
+ */
+- (void)setAnimationSpeed:(float)animationSpeed;
+
+/**
+ * Move animations attached to a layer (and to its sublayers) forward in time by the specified time interval, given in
+ * the layer time space (backward if negative). This can be used to seek within paused animations as well
+ */
+- (void)offsetAnimationsByTimeInterval:(CFTimeInterval)timeInterval;
+
 /**
  * Return the layer and all its sublayers flattened as a UIImage
  */
 - (UIImage *)flattenedImage;
 
+/**
+ * Asynchronously take a snapshot of the layer and all its sublayers, for a region of interest given in the layer
+ * coordinate system (CGRectNull for the whole bounds). The image is created with the specified scale (0 for the device
+ * scale), a smaller scale producing a downscaled image. Only the layer rendering (-renderInContext:) occurs on the main
+ * thread, at a resolution not exceeding twice the image scale. Downscaling and image creation occur in the background.
+ *
+ * If the tile size is not CGSizeZero, the region of interest is rendered tile by tile, each tile being rendered during
+ * a separate run loop iteration of the main thread, so that the user interface is never blocked for a long time and
+ * only one tile needs to be held in memory besides the image itself. Since the layer might change between the
+ * rendering of two tiles, tiled snapshots are best suited for layers whose content remains still meanwhile.
+ *
+ * Must be called from the main thread. The completion block is called on the main thread
+ */
+- (void)flattenedImageOfRect:(CGRect)rect
+                       scale:(CGFloat)scale
+                    tileSize:(CGSize)tileSize
+             completionBlock:(HLSLayerSnapshotCompletionBlock)completionBlock;
+
+/**
+ * Return an estimate of the memory (in bytes) used by the contents of the layer and of all its sublayers: Images
+ * displayed by layers, backing stores of layers drawing their contents, and rasterization caches. Layers without
+ * contents (e.g. solid color layers) are considered to be free
+ */
+- (NSUInteger)estimatedMemoryCost;
+
 @end
@@ -8,6 +8,8 @@
 
 #import "CALayer+HLSExtensions.h"
 
+#import "HLSAssert.h"
+#import "HLSFloat.h"
 #import "HLSLogger.h"
 
 static NSString * const kLayerSpeedBeforePauseKey = @"HLSLayerSpeedBeforePause";
@@ -18,6 +20,44 @@ static NSString * const kLayerSpeedBeforePauseKey = @"HLSLayerSpeedBeforePause";
 
 @end
 
+#pragma mark -
+#pragma mark HLSLayerSnapshot class interface
+
+/**
+ * An asynchronous snapshot, rendered tile by tile on the main thread. Tiles are drawn into the final bitmap on a
+ * private serial queue, the next tile being rendered only once the previous one has been drawn
+ *
+ * Designated initializer: -initWithLayer:rect:scale:renderScale:tileSize:completionBlock:
+ */
+@interface HLSLayerSnapshot : NSObject {
+@private
+    CALayer *m_layer;
+    CGRect m_rect;
+    CGFloat m_scale;
+    CGFloat m_renderScale;
+    NSArray *m_tileRects;
+    NSUInteger m_nextTileIndex;
+    dispatch_queue_t m_queue;
+    CGContextRef m_context;                             // Only accessed from m_queue
+    HLSLayerSnapshotCompletionBlock m_completionBlock;
+}
+
+- (id)initWithLayer:(CALayer *)layer
+               rect:(CGRect)rect
+              scale:(CGFloat)scale
+        renderScale:(CGFloat)renderScale
+           tileSize:(CGSize)tileSize
+    completionBlock:(HLSLayerSnapshotCompletionBlock)completionBlock;
+
+/**
+ * Start rendering. Must be called from the main thread
+ */
+- (void)start;
+
+- (void)renderNextTile;
+
+@end
+
 @implementation CALayer (HLSExtensions)
 
 - (void)removeAllAnimationsRecursively
@@ -67,13 +107,14 @@ static NSString * const kLayerSpeedBeforePauseKey = @"HLSLayerSpeedBeforePause";
         return;        
     }
     
-    // Call order / use of temporaries is very important here! See remark above!
+    // Call order / use of temporaries is very important here! See remark above! The layer time must be pausedTime
+    // right now, whatever the speed before the pause was, which is achieved by keeping the paused time as time offset,
+    // and by beginning now in the parent time space
     CFTimeInterval pausedTime = self.timeOffset;
+    CFTimeInterval parentTime = self.superlayer ? [self.superlayer convertTime:CACurrentMediaTime() fromLayer:nil] : CACurrentMediaTime();
     self.speed = [speedBeforePauseNumber floatValue];
-    self.timeOffset = 0.;
-    self.beginTime = 0.;
-    CFTimeInterval timeIntervalSincePause = [self convertTime:CACurrentMediaTime() fromLayer:nil] - pausedTime;
-    self.beginTime = timeIntervalSincePause;
+    self.timeOffset = pausedTime;
+    self.beginTime = parentTime;
     
     [self setValue:nil forKey:kLayerSpeedBeforePauseKey];
 }
@@ -83,6 +124,28 @@ static NSString * const kLayerSpeedBeforePauseKey = @"HLSLayerSpeedBeforePause";
     return [self valueForKey:kLayerSpeedBeforePauseKey] != nil;
 }
 
+- (void)setAnimationSpeed:(float)animationSpeed
+{
+    // Paused: Applied when resumed
+    if ([self isPaused]) {
+        [self setValue:[NSNumber numberWithFloat:animationSpeed] forKey:kLayerSpeedBeforePauseKey];
+        return;
+    }
+    
+    // Same strategy as when resuming: The layer time must not change right now
+    CFTimeInterval currentTime = [self convertTime:CACurrentMediaTime() fromLayer:nil];
+    CFTimeInterval parentTime = self.superlayer ? [self.superlayer convertTime:CACurrentMediaTime() fromLayer:nil] : CACurrentMediaTime();
+    self.speed = animationSpeed;
+    self.timeOffset = currentTime;
+    self.beginTime = parentTime;
+}
+
+- (void)offsetAnimationsByTimeInterval:(CFTimeInterval)timeInterval
+{
+    // Since t' = (t - beginTime) * speed + timeOffset (see remark above), this works for paused layers as well
+    self.timeOffset += timeInterval;
+}
+
 // See http://developer.apple.com/library/ios/#qa/qa1703/_index.html
 - (UIImage *)flattenedImage
 {
@@ -115,6 +178,79 @@ static NSString * const kLayerSpeedBeforePauseKey = @"HLSLayerSpeedBeforePause";
     return image;
 }
 
+- (void)flattenedImageOfRect:(CGRect)rect
+                       scale:(CGFloat)scale
+                    tileSize:(CGSize)tileSize
+             completionBlock:(HLSLayerSnapshotCompletionBlock)completionBlock
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (! completionBlock) {
+        HLSLoggerError(@"Missing completion block");
+        return;
+    }
+    
+    rect = CGRectIsNull(rect) ? self.bounds : CGRectIntersection(rect, self.bounds);
+    if (CGRectIsEmpty(rect)) {
+        HLSLoggerWarn(@"Empty region of interest");
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completionBlock(nil);
+        });
+        return;
+    }
+    
+    CGFloat deviceScale = [UIScreen mainScreen].scale;
+    if (floatle(scale, 0.f)) {
+        scale = deviceScale;
+    }
+    
+    // Render at the device scale, but never more than twice the image scale, which suffices for good downscaling quality
+    CGFloat renderScale = MAX(scale, MIN(deviceScale, 2.f * scale));
+    
+    HLSLayerSnapshot *snapshot = [[[HLSLayerSnapshot alloc] initWithLayer:self
+                                                                     rect:rect
+                                                                    scale:scale
+                                                              renderScale:renderScale
+                                                                 tileSize:tileSize
+                                                          completionBlock:completionBlock] autorelease];
+    [snapshot start];
+}
+
+- (NSUInteger)estimatedMemoryCost
+{
+    // Size of a bitmap covering the layer bounds (4 bytes per pixel)
+    CGFloat pixelWidth = CGRectGetWidth(self.bounds) * self.contentsScale;
+    CGFloat pixelHeight = CGRectGetHeight(self.bounds) * self.contentsScale;
+    NSUInteger bitmapCost = (NSUInteger)(pixelWidth * pixelHeight * 4.f);
+    
+    NSUInteger memoryCost = 0;
+    
+    // Images (e.g. displayed by a UIImageView) are stored as layer contents. For layers drawing their contents,
+    // the contents are a private backing store object, which has the size of the layer
+    id contents = self.contents;
+    if (contents) {
+        if (CFGetTypeID((CFTypeRef)contents) == CGImageGetTypeID()) {
+            CGImageRef image = (CGImageRef)contents;
+            memoryCost += CGImageGetBytesPerRow(image) * CGImageGetHeight(image);
+        }
+        else {
+            memoryCost += bitmapCost;
+        }
+    }
+    
+    // Rasterization cache
+    if (self.shouldRasterize) {
+        CGFloat rasterizationFactor = self.rasterizationScale / self.contentsScale;
+        memoryCost += (NSUInteger)(bitmapCost * rasterizationFactor * rasterizationFactor);
+    }
+    
+    for (CALayer *sublayer in self.sublayers) {
+        memoryCost += [sublayer estimatedMemoryCost];
+    }
+    
+    return memoryCost;
+}
+
 @end
 
 @implementation CALayer (HLSExtensionsPrivate)
@@ -133,3 +269,148 @@ static NSString * const kLayerSpeedBeforePauseKey = @"HLSLayerSpeedBeforePause";
 }
 
 @end
+
+#pragma mark -
+#pragma mark HLSLayerSnapshot class implementation
+
+@implementation HLSLayerSnapshot
+
+#pragma mark Object creation and destruction
+
+- (id)initWithLayer:(CALayer *)layer
+               rect:(CGRect)rect
+              scale:(CGFloat)scale
+        renderScale:(CGFloat)renderScale
+           tileSize:(CGSize)tileSize
+    completionBlock:(HLSLayerSnapshotCompletionBlock)completionBlock
+{
+    if ((self = [super init])) {
+        m_layer = [layer retain];
+        m_rect = rect;
+        m_scale = scale;
+        m_renderScale = renderScale;
+        m_completionBlock = [completionBlock copy];
+        m_queue = dispatch_queue_create("ch.hortis.CoconutKit.HLSLayerSnapshot", NULL);
+        
+        // A single tile if no tile size has been specified
+        if (floatle(tileSize.width, 0.f) || floatle(tileSize.height, 0.f)) {
+            tileSize = rect.size;
+        }
+        
+        NSMutableArray *tileRects = [NSMutableArray array];
+        for (CGFloat y = CGRectGetMinY(rect); floatlt(y, CGRectGetMaxY(rect)); y += tileSize.height) {
+            for (CGFloat x = CGRectGetMinX(rect); floatlt(x, CGRectGetMaxX(rect)); x += tileSize.width) {
+                CGRect tileRect = CGRectIntersection(CGRectMake(x, y, tileSize.width, tileSize.height), rect);
+                [tileRects addObject:[NSValue valueWithCGRect:tileRect]];
+            }
+        }
+        m_tileRects = [[NSArray alloc] initWithArray:tileRects];
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    if (m_context) {
+        CGContextRelease(m_context);
+    }
+    dispatch_release(m_queue);
+    [m_layer release];
+    [m_tileRects release];
+    [m_completionBlock release];
+    
+    [super dealloc];
+}
+
+#pragma mark Rendering
+
+- (void)start
+{
+    // The final bitmap is allocated in the background as well
+    size_t width = (size_t)ceilf(CGRectGetWidth(m_rect) * m_scale);
+    size_t height = (size_t)ceilf(CGRectGetHeight(m_rect) * m_scale);
+    CGImageAlphaInfo alphaInfo = m_layer.opaque ? kCGImageAlphaNoneSkipFirst : kCGImageAlphaPremultipliedFirst;
+    dispatch_async(m_queue, ^{
+        CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+        m_context = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, alphaInfo | kCGBitmapByteOrder32Little);
+        CGColorSpaceRelease(colorSpace);
+        if (m_context) {
+            CGContextSetInterpolationQuality(m_context, kCGInterpolationHigh);
+        }
+    });
+    
+    [self renderNextTile];
+}
+
+- (void)renderNextTile
+{
+    // All tiles rendered. Create the image
+    if (m_nextTileIndex == [m_tileRects count]) {
+        dispatch_async(m_queue, ^{
+            UIImage *image = nil;
+            if (m_context) {
+                CGImageRef imageRef = CGBitmapContextCreateImage(m_context);
+                image = [UIImage imageWithCGImage:imageRef scale:m_scale orientation:UIImageOrientationUp];
+                CGImageRelease(imageRef);
+            }
+            
+            dispatch_async(dispatch_get_main_queue(), ^{
+                m_completionBlock(image);
+            });
+        });
+        return;
+    }
+    
+    CGRect tileRect = [[m_tileRects objectAtIndex:m_nextTileIndex] CGRectValue];
+    ++m_nextTileIndex;
+    
+    // Render the tile, in the flipped coordinate system expected by -renderInContext:. The context origin is the
+    // origin of the layer bounds
+    size_t tileWidth = (size_t)ceilf(CGRectGetWidth(tileRect) * m_renderScale);
+    size_t tileHeight = (size_t)ceilf(CGRectGetHeight(tileRect) * m_renderScale);
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef tileContext = CGBitmapContextCreate(NULL, tileWidth, tileHeight, 8, 0, colorSpace,
+                                                     kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little);
+    CGColorSpaceRelease(colorSpace);
+    if (! tileContext) {
+        HLSLoggerError(@"Could not create a tile bitmap");
+        m_nextTileIndex = [m_tileRects count];
+        [self renderNextTile];
+        return;
+    }
+    
+    CGContextTranslateCTM(tileContext, 0.f, tileHeight);
+    CGContextScaleCTM(tileContext, m_renderScale, -m_renderScale);
+    CGContextTranslateCTM(tileContext,
+                          CGRectGetMinX(m_layer.bounds) - CGRectGetMinX(tileRect),
+                          CGRectGetMinY(m_layer.bounds) - CGRectGetMinY(tileRect));
+    [m_layer renderInContext:tileContext];
+    
+    // The tile bitmap is handed over to the image, no copy is made
+    CGImageRef tileImage = CGBitmapContextCreateImage(tileContext);
+    CGContextRelease(tileContext);
+    
+    // Downscale into the final bitmap (whose coordinate system is not flipped), then render the next tile
+    dispatch_async(m_queue, ^{
+        if (m_context && tileImage) {
+            CGRect destinationRect = CGRectMake((CGRectGetMinX(tileRect) - CGRectGetMinX(m_rect)) * m_scale,
+                                                (CGRectGetMaxY(m_rect) - CGRectGetMaxY(tileRect)) * m_scale,
+                                                CGRectGetWidth(tileRect) * m_scale,
+                                                CGRectGetHeight(tileRect) * m_scale);
+            CGContextDrawImage(m_context, destinationRect, tileImage);
+        }
+        CGImageRelease(tileImage);
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self renderNextTile];
+        });
+    });
+}
+
+@end
@@ -9,10 +9,19 @@
 @interface CAMediaTimingFunction (HLSExtensions)
 
 /**
- * Return the inverse function, i.e. the one which must be played when playing an animation backwards
+ * Return the inverse function, i.e. the one which must be played when playing an animation backwards. Inverse functions
+ * are cached, the same object is therefore returned for functions with the same control points
  */
 - (CAMediaTimingFunction *)inverseFunction;
 
+/**
+ * Return the value of the function for a given normalized time (between 0 and 1, clamped otherwise), i.e. the
+ * progress of an animation played with the function at this time. The curve coefficients and a table of samples
+ * are computed the first time this method is called for a function, so that it can then be called at each frame
+ * (e.g. for animations driven by a display link or interactive transitions)
+ */
+- (CGFloat)valueForNormalizedTime:(CGFloat)normalizedTime;
+
 /**
  * Return the control points as a human-readable string
  */
@@ -8,10 +8,72 @@
 
 #import "CAMediaTimingFunction+HLSExtensions.h"
 
+#import <objc/runtime.h>
+
+// Associated object keys
+static void *s_bezierSolverKey = &s_bezierSolverKey;
+
+// Number of samples of the x(t) curve computed to find initial guesses for t
+static const NSUInteger kBezierSampleTableSize = 11;
+
+// Function declarations
+static NSValue *controlPointsValueForTimingFunction(CAMediaTimingFunction *timingFunction);
+
+#pragma mark -
+#pragma mark HLSCubicBezierSolver class interface
+
+/**
+ * Evaluates the cubic Bézier curve (0, 0), (x1, y1), (x2, y2), (1, 1) of a timing function, i.e. finds the y value
+ * corresponding to a given x (time). Since x(t) is monotonic for timing functions, t is found using Newton's method,
+ * starting from a guess interpolated from a table of samples, and falling back to bisection when the slope is too
+ * small
+ */
+@interface HLSCubicBezierSolver : NSObject {
+@private
+    CGFloat m_ax, m_bx, m_cx;
+    CGFloat m_ay, m_by, m_cy;
+    CGFloat m_samples[kBezierSampleTableSize];
+    BOOL m_linear;
+}
+
+- (id)initWithTimingFunction:(CAMediaTimingFunction *)timingFunction;
+
+- (CGFloat)valueForX:(CGFloat)x;
+
+@end
+
+#pragma mark -
+#pragma mark HLSExtensions CAMediaTimingFunction category implementation
+
+@interface CAMediaTimingFunction (HLSExtensionsPrivate)
+
++ (NSCache *)inverseFunctionsCache;
+
+@end
+
 @implementation CAMediaTimingFunction (HLSExtensions)
 
+#pragma mark Class methods
+
++ (NSCache *)inverseFunctionsCache
+{
+    static NSCache *s_inverseFunctionsCache = nil;
+    if (! s_inverseFunctionsCache) {
+        s_inverseFunctionsCache = [[NSCache alloc] init];
+    }
+    return s_inverseFunctionsCache;
+}
+
+#pragma mark Inverse function
+
 - (CAMediaTimingFunction *)inverseFunction
 {
+    NSValue *controlPointsValue = controlPointsValueForTimingFunction(self);
+    CAMediaTimingFunction *inverseFunction = [[CAMediaTimingFunction inverseFunctionsCache] objectForKey:controlPointsValue];
+    if (inverseFunction) {
+        return inverseFunction;
+    }
+    
     float values1[2];
     memset(values1, 0, sizeof(values1));
     [self getControlPointAtIndex:1 values:values1];
@@ -22,7 +84,26 @@
     
     // Flip the original curve around the y = 1 - x axis
     // Refer to the "Introduction to Animation Types and Timing Programming Guide"
-    return [CAMediaTimingFunction functionWithControlPoints:1.f - values2[0] :values1[1] :1.f - values1[0] :values2[1]];
+    inverseFunction = [CAMediaTimingFunction functionWithControlPoints:1.f - values2[0] :values1[1] :1.f - values1[0] :values2[1]];
+    
+    // The inverse of the inverse is the receiver
+    [[CAMediaTimingFunction inverseFunctionsCache] setObject:inverseFunction forKey:controlPointsValue];
+    [[CAMediaTimingFunction inverseFunctionsCache] setObject:self forKey:controlPointsValueForTimingFunction(inverseFunction)];
+    
+    return inverseFunction;
+}
+
+#pragma mark Evaluation
+
+- (CGFloat)valueForNormalizedTime:(CGFloat)normalizedTime
+{
+    HLSCubicBezierSolver *bezierSolver = objc_getAssociatedObject(self, s_bezierSolverKey);
+    if (! bezierSolver) {
+        bezierSolver = [[[HLSCubicBezierSolver alloc] initWithTimingFunction:self] autorelease];
+        objc_setAssociatedObject(self, s_bezierSolverKey, bezierSolver, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+    
+    return [bezierSolver valueForX:normalizedTime];
 }
 
 - (NSString *)controlPointsString
@@ -45,3 +126,123 @@
 }
 
 @end
+
+#pragma mark -
+#pragma mark HLSCubicBezierSolver class implementation
+
+@implementation HLSCubicBezierSolver
+
+#pragma mark Object creation and destruction
+
+- (id)initWithTimingFunction:(CAMediaTimingFunction *)timingFunction
+{
+    if ((self = [super init])) {
+        float values1[2];
+        memset(values1, 0, sizeof(values1));
+        [timingFunction getControlPointAtIndex:1 values:values1];
+        
+        float values2[2];
+        memset(values2, 0, sizeof(values2));
+        [timingFunction getControlPointAtIndex:2 values:values2];
+        
+        m_linear = (values1[0] == values1[1] && values2[0] == values2[1]);
+        
+        // Polynomial coefficients, x(t) = ((ax * t + bx) * t + cx) * t (same for y)
+        m_cx = 3.f * values1[0];
+        m_bx = 3.f * (values2[0] - values1[0]) - m_cx;
+        m_ax = 1.f - m_cx - m_bx;
+        
+        m_cy = 3.f * values1[1];
+        m_by = 3.f * (values2[1] - values1[1]) - m_cy;
+        m_ay = 1.f - m_cy - m_by;
+        
+        for (NSUInteger i = 0; i < kBezierSampleTableSize; ++i) {
+            CGFloat t = (CGFloat)i / (kBezierSampleTableSize - 1);
+            m_samples[i] = ((m_ax * t + m_bx) * t + m_cx) * t;
+        }
+    }
+    return self;
+}
+
+#pragma mark Evaluation
+
+- (CGFloat)valueForX:(CGFloat)x
+{
+    if (x <= 0.f) {
+        return 0.f;
+    }
+    else if (x >= 1.f) {
+        return 1.f;
+    }
+    
+    if (m_linear) {
+        return x;
+    }
+    
+    // Initial guess for t, interpolated between the two samples surrounding x
+    NSUInteger i = 1;
+    while (i < kBezierSampleTableSize - 1 && m_samples[i] <= x) {
+        ++i;
+    }
+    CGFloat sampleStep = 1.f / (kBezierSampleTableSize - 1);
+    CGFloat intervalStart = (i - 1) * sampleStep;
+    CGFloat sampleDelta = m_samples[i] - m_samples[i - 1];
+    CGFloat t = intervalStart;
+    if (sampleDelta > 0.f) {
+        t += (x - m_samples[i - 1]) / sampleDelta * sampleStep;
+    }
+    
+    static const CGFloat kPrecision = 1e-6f;
+    
+    // Newton's method converges quickly if the slope is not too small
+    CGFloat slope = (3.f * m_ax * t + 2.f * m_bx) * t + m_cx;
+    if (slope >= 1e-3f) {
+        for (NSUInteger iteration = 0; iteration < 4; ++iteration) {
+            CGFloat error = ((m_ax * t + m_bx) * t + m_cx) * t - x;
+            if (fabsf(error) < kPrecision) {
+                break;
+            }
+            
+            slope = (3.f * m_ax * t + 2.f * m_bx) * t + m_cx;
+            if (slope == 0.f) {
+                break;
+            }
+            t -= error / slope;
+        }
+    }
+    // Otherwise bisect within the sample interval
+    else if (slope > 0.f || sampleDelta > 0.f) {
+        CGFloat lowerT = intervalStart;
+        CGFloat upperT = intervalStart + sampleStep;
+        for (NSUInteger iteration = 0; iteration < 20; ++iteration) {
+            t = (lowerT + upperT) / 2.f;
+            CGFloat error = ((m_ax * t + m_bx) * t + m_cx) * t - x;
+            if (fabsf(error) < kPrecision) {
+                break;
+            }
+            
+            if (error > 0.f) {
+                upperT = t;
+            }
+            else {
+                lowerT = t;
+            }
+        }
+    }
+    
+    return ((m_ay * t + m_by) * t + m_cy) * t;
+}
+
+@end
+
+#pragma mark -
+#pragma mark Static functions
+
+static NSValue *controlPointsValueForTimingFunction(CAMediaTimingFunction *timingFunction)
+{
+    // Control points 0 and 3 are always (0, 0) and (1, 1)
+    float controlPoints[4];
+    [timingFunction getControlPointAtIndex:1 values:&controlPoints[0]];
+    [timingFunction getControlPointAtIndex:2 values:&controlPoints[2]];
+    return [NSValue valueWithBytes:controlPoints objCType:@encode(float[4])];
+}
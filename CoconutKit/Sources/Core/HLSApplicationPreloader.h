@@ -6,14 +6,27 @@
 //  Copyright (c) 2012 Hortis. All rights reserved.
 //
 
+/**
+ * Block executed to warm up some cache
+ */
+typedef void (^HLSWarmUpBlock)(void);
+
 /**
  * Collects the code which can be executed right after an application has started so that perceived performance can be
- * increased. For the moment only UIWebView is preloaded so that the time usually required when instantiating the first
- * web view is reduced
+ * increased. This code is organized as a pipeline of warm-up blocks, executed by decreasing priority once the
+ * -application:didFinishLaunchingWithOptions: method of the application delegate has returned:
+ *   - blocks which must run on the main thread are executed one per run loop turn, in the default run loop mode
+ *     only, so that event processing (e.g. scrolling) is never delayed by more than one block
+ *   - other blocks are executed as low-priority block tasks submitted to the default HLSTaskManager
+ *
+ * CoconutKit registers warm-ups for UIWebView (so that the time usually required when instantiating the first web 
+ * view is reduced, and the web views of the HLSWebViewPool are created), system fonts and the main bundle localization table. Applications can register their own (nibs, 
+ * Core Data stack, image decoding, etc.). The time spent in each block is measured and can be obtained as a report
  */
 @interface HLSApplicationPreloader : NSObject <UIWebViewDelegate> {
 @private
     UIApplication *_application;
+    NSMutableArray *_mainThreadWarmUps;
 }
 
 /**
@@ -22,4 +35,20 @@
  */
 + (void)enable;
 
+/**
+ * Register a block to be executed by the warm-up pipeline, either on the main thread or on a background thread.
+ * Blocks with higher priority are executed first (CoconutKit warm-ups have priority 0). Blocks registered after the
+ * pipeline has started are executed as soon as possible. Must be called from the main thread
+ */
++ (void)registerWarmUpWithName:(NSString *)name 
+                      priority:(NSInteger)priority 
+                  onMainThread:(BOOL)onMainThread 
+                         block:(HLSWarmUpBlock)block;
+
+/**
+ * Return a report listing the warm-ups executed so far and the time spent in each of them. Must be called from the
+ * main thread
+ */
++ (NSString *)warmUpReport;
+
 @end
@@ -9,8 +9,11 @@
 #import "HLSApplicationPreloader.h"
 
 #import "HLSAssert.h"
+#import "HLSBlockTask.h"
 #import "HLSLogger.h"
 #import "HLSRuntime.h"
+#import "HLSTaskManager.h"
+#import "HLSWebViewPool.h"
 
 // Keys for associated objects
 static void *s_applicationPreloaderKey = &s_applicationPreloaderKey;
@@ -20,12 +23,55 @@ static void *s_applicationPreloaderKey = &s_applicationPreloaderKey;
 // between class names and swizzled implementations
 NSDictionary *s_classNameToSwizzledApplicationDidFinishLaunchingWithOptionsImpMap = nil;
 
+// Warm-ups waiting for the pipeline to start, and warm-ups which have been executed (in completion order)
+static NSMutableArray *s_pendingWarmUps = nil;
+static NSMutableArray *s_completedWarmUps = nil;
+
+// The preloader running the pipeline (nil before it has been started)
+static HLSApplicationPreloader *s_applicationPreloader = nil;
+
 // Swizzled method implementations
 static BOOL swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOptions(id self, SEL _cmd, UIApplication *application, NSDictionary *launchOptions);
 
+#pragma mark -
+#pragma mark HLSWarmUp class interface
+
+/**
+ * A warm-up block and its execution time
+ */
+@interface HLSWarmUp : NSObject {
+@private
+    NSString *_name;
+    NSInteger _priority;
+    BOOL _onMainThread;
+    HLSWarmUpBlock _block;
+    NSTimeInterval _duration;
+}
+
+- (id)initWithName:(NSString *)name priority:(NSInteger)priority onMainThread:(BOOL)onMainThread block:(HLSWarmUpBlock)block;
+
+@property (nonatomic, readonly, retain) NSString *name;
+@property (nonatomic, readonly, assign) NSInteger priority;
+@property (nonatomic, readonly, assign) BOOL onMainThread;
+@property (nonatomic, readonly, copy) HLSWarmUpBlock block;
+@property (nonatomic, assign) NSTimeInterval duration;
+
+/**
+ * Execute the block on the current thread, and return the time spent
+ */
+- (NSTimeInterval)execute;
+
+- (NSComparisonResult)comparePriority:(HLSWarmUp *)warmUp;
+
+@end
+
+#pragma mark -
+#pragma mark HLSApplicationPreloader class interface extension
+
 @interface HLSApplicationPreloader ()
 
 @property (nonatomic, assign) UIApplication *application;           // weak ref since retained by the application
+@property (nonatomic, retain) NSMutableArray *mainThreadWarmUps;
 
 @end
 
@@ -34,9 +80,16 @@ static BOOL swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOp
 - (id)initWithApplication:(UIApplication *)application;
 
 - (void)preload;
+- (void)preloadWebView;
+- (void)scheduleWarmUps:(NSArray *)warmUps;
+- (void)executeNextMainThreadWarmUp;
+- (void)warmUpDidComplete:(HLSWarmUp *)warmUp;
 
 @end
 
+#pragma mark -
+#pragma mark HLSApplicationPreloader class implementation
+
 @implementation HLSApplicationPreloader
 
 #pragma mark Class methods
@@ -51,44 +104,93 @@ static BOOL swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOp
     
     NSMutableDictionary *classNameToSwizzledApplicationDidFinishLaunchingWithOptionsImpMap = [NSMutableDictionary dictionary];
     
-    // Loop over all classes. Find the ones which implement the UIApplicationDelegate protocol and swizzle their application:didFinishLaunchingWithOptions: method
-    // so that we can add an HLSApplicationPreloader 
+    // Loop over all classes which implement the UIApplicationDelegate protocol and swizzle their application:didFinishLaunchingWithOptions: method
+    // so that we can add an HLSApplicationPreloader. The class list is cached by HLSRuntime and must not be freed
     unsigned int numberOfClasses = 0;
-    Class *classes = objc_copyClassList(&numberOfClasses);
+    Class *classes = hls_classesConformingToProtocol(@protocol(UIApplicationDelegate), &numberOfClasses);
     for (unsigned int i = 0; i < numberOfClasses; ++i) {
         Class class = classes[i];
-        // TODO: Use hls_class_conformsToProtocol after merge with feature/url-connection
-        if (class_conformsToProtocol(class, @protocol(UIApplicationDelegate))) {
-            NSString *className = [NSString stringWithCString:class_getName(class) encoding:NSUTF8StringEncoding];
-            IMP UIApplicationDelegate__application_didFinishLaunchingWithOptions_Imp = HLSSwizzleSelector(class, 
-                                                                                                          @selector(application:didFinishLaunchingWithOptions:), 
-                                                                                                          (IMP)swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOptions);
-            
-            // If not implemented (which might happen if the application is initialized using a nib only, i.e. if the root view controller is set in
-            // the application nib), inject a method
-            if (! UIApplicationDelegate__application_didFinishLaunchingWithOptions_Imp) {
-                class_addMethod(class, 
-                                @selector(application:didFinishLaunchingWithOptions:), 
-                                (IMP)swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOptions, 
-                                "c@:@@");
-            }
-            [classNameToSwizzledApplicationDidFinishLaunchingWithOptionsImpMap setObject:[NSValue valueWithPointer:UIApplicationDelegate__application_didFinishLaunchingWithOptions_Imp]
-                                                                                  forKey:className];
+        NSString *className = [NSString stringWithCString:class_getName(class) encoding:NSUTF8StringEncoding];
+        IMP UIApplicationDelegate__application_didFinishLaunchingWithOptions_Imp = HLSSwizzleSelector(class, 
+                                                                                                      @selector(application:didFinishLaunchingWithOptions:), 
+                                                                                                      (IMP)swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOptions);
+        
+        // If not implemented (which might happen if the application is initialized using a nib only, i.e. if the root view controller is set in
+        // the application nib), inject a method
+        if (! UIApplicationDelegate__application_didFinishLaunchingWithOptions_Imp) {
+            class_addMethod(class, 
+                            @selector(application:didFinishLaunchingWithOptions:), 
+                            (IMP)swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOptions, 
+                            "c@:@@");
         }
+        [classNameToSwizzledApplicationDidFinishLaunchingWithOptionsImpMap setObject:[NSValue valueWithPointer:UIApplicationDelegate__application_didFinishLaunchingWithOptions_Imp]
+                                                                              forKey:className];
     }
-    free(classes);
     
     s_classNameToSwizzledApplicationDidFinishLaunchingWithOptionsImpMap = [[NSDictionary dictionaryWithDictionary:classNameToSwizzledApplicationDidFinishLaunchingWithOptionsImpMap] retain];
     
+    // Fonts are loaded lazily the first time they are used to draw or measure text
+    [self registerWarmUpWithName:@"Fonts" priority:0 onMainThread:YES block:^{
+        static NSString * const kSampleText = @"Sample text 0123456789";
+        [kSampleText sizeWithFont:[UIFont systemFontOfSize:[UIFont systemFontSize]]];
+        [kSampleText sizeWithFont:[UIFont boldSystemFontOfSize:[UIFont systemFontSize]]];
+        [kSampleText sizeWithFont:[UIFont italicSystemFontOfSize:[UIFont systemFontSize]]];
+    }];
+    
+    // Loading a string loads the whole table, which the bundle then caches
+    [self registerWarmUpWithName:@"Localization table" priority:0 onMainThread:NO block:^{
+        [[NSBundle mainBundle] localizedStringForKey:@"HLSApplicationPreloaderWarmUp" value:nil table:nil];
+    }];
+    
     s_enabled = YES;
 }
 
++ (void)registerWarmUpWithName:(NSString *)name
+                      priority:(NSInteger)priority 
+                  onMainThread:(BOOL)onMainThread 
+                         block:(HLSWarmUpBlock)block
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (! block) {
+        HLSLoggerError(@"Missing warm-up block");
+        return;
+    }
+    
+    HLSWarmUp *warmUp = [[[HLSWarmUp alloc] initWithName:name priority:priority onMainThread:onMainThread block:block] autorelease];
+    if (s_applicationPreloader) {
+        [s_applicationPreloader scheduleWarmUps:[NSArray arrayWithObject:warmUp]];
+    }
+    else {
+        if (! s_pendingWarmUps) {
+            s_pendingWarmUps = [[NSMutableArray alloc] init];
+        }
+        [s_pendingWarmUps addObject:warmUp];
+    }
+}
+
++ (NSString *)warmUpReport
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    NSMutableString *report = [NSMutableString stringWithString:@"Warm-ups:"];
+    NSTimeInterval totalDuration = 0.;
+    for (HLSWarmUp *warmUp in s_completedWarmUps) {
+        [report appendFormat:@"\n    %@ (%@): %.3f ms", warmUp.name, warmUp.onMainThread ? @"main thread" : @"background", 
+            warmUp.duration * 1000.];
+        totalDuration += warmUp.duration;
+    }
+    [report appendFormat:@"\n    Total: %.3f ms", totalDuration * 1000.];
+    return [NSString stringWithString:report];
+}
+
 #pragma mark Object creation and destruction
 
 - (id)initWithApplication:(UIApplication *)application
 {
     if ((self = [super init])) {
         self.application = application;
+        self.mainThreadWarmUps = [NSMutableArray array];
     }
     return self;
 }
@@ -102,7 +204,8 @@ static BOOL swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOp
 - (void)dealloc
 {
     self.application = nil;
-
+    self.mainThreadWarmUps = nil;
+    
     [super dealloc];
 }
 
@@ -110,9 +213,25 @@ static BOOL swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOp
 
 @synthesize application = _application;
 
+@synthesize mainThreadWarmUps = _mainThreadWarmUps;
+
 #pragma mark Pre-loading
 
 - (void)preload
+{
+    s_applicationPreloader = self;
+    
+    // The web view is loaded asynchronously. Only the time needed to start loading is measured
+    [HLSApplicationPreloader registerWarmUpWithName:@"UIWebView" priority:0 onMainThread:YES block:^{
+        [self preloadWebView];
+    }];
+    
+    [self scheduleWarmUps:s_pendingWarmUps];
+    [s_pendingWarmUps release];
+    s_pendingWarmUps = nil;
+}
+
+- (void)preloadWebView
 {
     // To avoid the delay which occurs when loading a UIWebView for the first time, we display one as soon as possible
     // (out of screen bounds). It seems that loading a large web view (here with the application frame size) is more 
@@ -135,7 +254,68 @@ static BOOL swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOp
         HLSLoggerWarn(@"No key window found. Cannot preload UIWebView. To fix this issue, your application delegate must "
                       "implement the -application:didFinishLaunchingWithOptions: method to set the key window, either by "
                       "calling -makeKeyAndVisible or -makeKeyWindow");
-    }    
+    }
+    
+    // Web views for later use are created during the next run loop turns
+    [[HLSWebViewPool sharedWebViewPool] fill];
+}
+
+#pragma mark Warm-up pipeline
+
+- (void)scheduleWarmUps:(NSArray *)warmUps
+{
+    NSArray *sortedWarmUps = [warmUps sortedArrayUsingSelector:@selector(comparePriority:)];
+    for (HLSWarmUp *warmUp in sortedWarmUps) {
+        if (warmUp.onMainThread) {
+            [self.mainThreadWarmUps addObject:warmUp];
+        }
+        else {
+            HLSBlockTask *task = [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+                [warmUp execute];
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    [self warmUpDidComplete:warmUp];
+                });
+            }];
+            task.priority = HLSTaskPriorityLow;
+            task.tag = @"HLSApplicationPreloader";
+            [[HLSTaskManager defaultManager] submitTask:task];
+        }
+    }
+    
+    // Keep main thread warm-ups sorted as well when some are added while others are still pending
+    [self.mainThreadWarmUps sortUsingSelector:@selector(comparePriority:)];
+    
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(executeNextMainThreadWarmUp) object:nil];
+    if ([self.mainThreadWarmUps count] != 0) {
+        [self performSelector:@selector(executeNextMainThreadWarmUp) withObject:nil afterDelay:0. inModes:[NSArray arrayWithObject:NSDefaultRunLoopMode]];
+    }
+}
+
+- (void)executeNextMainThreadWarmUp
+{
+    if ([self.mainThreadWarmUps count] == 0) {
+        return;
+    }
+    
+    // One warm-up per run loop turn, so that events are processed in between
+    HLSWarmUp *warmUp = [[[self.mainThreadWarmUps objectAtIndex:0] retain] autorelease];
+    [self.mainThreadWarmUps removeObjectAtIndex:0];
+    [warmUp execute];
+    [self warmUpDidComplete:warmUp];
+    
+    if ([self.mainThreadWarmUps count] != 0) {
+        [self performSelector:@selector(executeNextMainThreadWarmUp) withObject:nil afterDelay:0. inModes:[NSArray arrayWithObject:NSDefaultRunLoopMode]];
+    }
+}
+
+- (void)warmUpDidComplete:(HLSWarmUp *)warmUp
+{
+    if (! s_completedWarmUps) {
+        s_completedWarmUps = [[NSMutableArray alloc] init];
+    }
+    [s_completedWarmUps addObject:warmUp];
+    
+    HLSLoggerDebug(@"Warm-up %@ completed in %.3f ms", warmUp.name, warmUp.duration * 1000.);
 }
 
 #pragma mark UIWebViewDelegate protocol implementation
@@ -149,6 +329,73 @@ static BOOL swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOp
 
 @end
 
+#pragma mark -
+#pragma mark HLSWarmUp class implementation
+
+@implementation HLSWarmUp
+
+#pragma mark Object creation and destruction
+
+- (id)initWithName:(NSString *)name priority:(NSInteger)priority onMainThread:(BOOL)onMainThread block:(HLSWarmUpBlock)block
+{
+    if ((self = [super init])) {
+        _name = [name retain];
+        _priority = priority;
+        _onMainThread = onMainThread;
+        _block = [block copy];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_name release];
+    [_block release];
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize name = _name;
+
+@synthesize priority = _priority;
+
+@synthesize onMainThread = _onMainThread;
+
+@synthesize block = _block;
+
+@synthesize duration = _duration;
+
+#pragma mark Execution
+
+- (NSTimeInterval)execute
+{
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    self.block();
+    self.duration = CFAbsoluteTimeGetCurrent() - startTime;
+    return self.duration;
+}
+
+#pragma mark Sorting
+
+- (NSComparisonResult)comparePriority:(HLSWarmUp *)warmUp
+{
+    // Decreasing priority
+    if (self.priority > warmUp.priority) {
+        return NSOrderedAscending;
+    }
+    else if (self.priority < warmUp.priority) {
+        return NSOrderedDescending;
+    }
+    else {
+        return NSOrderedSame;
+    }
+}
+
+@end
+
+#pragma mark -
 #pragma mark Swizzled method implementations
 
 static BOOL swizzled_UIApplicationDelegate__application_didFinishLaunchingWithOptions(id self, SEL _cmd, UIApplication *application, NSDictionary *launchOptions)
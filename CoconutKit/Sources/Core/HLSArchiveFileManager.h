@@ -0,0 +1,56 @@
+//
+//  HLSArchiveFileManager.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 01.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFileManager.h"
+
+/**
+ * A read-only file manager whose files are all stored in a single archive file, mapped into virtual memory once. Files
+ * are found in constant time using an index, and their contents are returned without copy, as slices of the mapped
+ * archive. This avoids opening each of many small resource files separately.
+ *
+ * Paths are relative to the archive root (a leading slash is ignored). Only files are stored, directories exist as
+ * long as they contain files. All methods modifying the file hierarchy fail
+ * with an NSFileWriteNoPermissionError error.
+ *
+ * Archives are created using +createArchiveAtPath:withContentsOfDirectoryAtPath:fileManager:error:. Since the
+ * format uses a fixed byte order, an archive can be generated when building the application and shipped as is.
+ * The format is:
+ *   - a header: the magic bytes 'HLSA', the format version and the number of files (32-bit little endian integers)
+ *   - for each file, in the order of the file data: the path length (32-bit), the data offset from the beginning
+ *     of the archive, the data length (both 64-bit, little endian) and the path (UTF-8, without terminating null)
+ *   - the data of all files
+ *
+ * All methods are thread-safe
+ *
+ * Designated initializer: -initWithArchiveAtPath:
+ */
+@interface HLSArchiveFileManager : HLSFileManager {
+@private
+    NSData *m_archiveData;
+    NSDictionary *m_pathToFileRangeMap;
+    NSDictionary *m_pathToDirectoryContentsMap;
+}
+
+/**
+ * Create an archive at archivePath (overwritten if it exists) from the contents of a directory (and of all its
+ * subdirectories), read using the specified file manager (the default one if nil). The archive itself is written
+ * using the default file manager
+ *
+ * Return YES iff successful
+ */
++ (BOOL)createArchiveAtPath:(NSString *)archivePath
+withContentsOfDirectoryAtPath:(NSString *)directoryPath
+                fileManager:(HLSFileManager *)fileManager
+                      error:(NSError **)pError;
+
+/**
+ * Open the archive at the given location. Return nil if the file does not exist or is not a valid archive
+ */
+- (id)initWithArchiveAtPath:(NSString *)archivePath;
+
+@end
@@ -0,0 +1,535 @@
+//
+//  HLSArchiveFileManager.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 01.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSArchiveFileManager.h"
+
+#import <libkern/OSByteOrder.h>
+#import "HLSAssert.h"
+#import "HLSLogger.h"
+
+static const uint32_t kArchiveMagic = 'HLSA';
+static const uint32_t kArchiveVersion = 1;
+static const NSUInteger kArchiveHeaderLength = 3 * sizeof(uint32_t);
+static const NSUInteger kArchiveEntryHeaderLength = sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+// Function declarations
+static NSString *archivePathForPath(NSString *path);
+static BOOL addFilesAtPath(NSString *directoryPath, NSString *archivePath, HLSFileManager *fileManager,
+                           NSMutableArray *archivePaths, NSMutableArray *datas, NSError **pError);
+static NSError *fileError(NSInteger code, NSString *path);
+
+#pragma mark -
+#pragma mark HLSArchiveDataSlice class interface
+
+/**
+ * Immutable data pointing at a range of the archive data, which is retained
+ *
+ * Designated initializer: -initWithArchiveData:range:
+ */
+@interface HLSArchiveDataSlice : NSData {
+@private
+    NSData *m_archiveData;
+    NSRange m_range;
+}
+
+- (id)initWithArchiveData:(NSData *)archiveData range:(NSRange)range;
+
+@end
+
+#pragma mark -
+#pragma mark HLSArchiveFileHandle class interface
+
+/**
+ * Read-only handle to a file stored in an archive
+ *
+ * Designated initializer: -initWithData:
+ */
+@interface HLSArchiveFileHandle : NSObject <HLSFileHandle> {
+@private
+    NSData *m_data;
+}
+
+- (id)initWithData:(NSData *)data;
+
+@end
+
+#pragma mark -
+#pragma mark HLSArchiveFileManager class interface extension
+
+@interface HLSArchiveFileManager ()
+
+@property (nonatomic, retain) NSData *archiveData;
+@property (nonatomic, retain) NSDictionary *pathToFileRangeMap;
+@property (nonatomic, retain) NSDictionary *pathToDirectoryContentsMap;
+
+- (BOOL)loadIndex;
+
+- (BOOL)denyModificationAtPath:(NSString *)path error:(NSError **)pError;
+
+@end
+
+#pragma mark -
+#pragma mark HLSArchiveFileManager class implementation
+
+@implementation HLSArchiveFileManager
+
+#pragma mark Class methods
+
++ (BOOL)createArchiveAtPath:(NSString *)archivePath
+withContentsOfDirectoryAtPath:(NSString *)directoryPath
+                fileManager:(HLSFileManager *)fileManager
+                      error:(NSError **)pError
+{
+    if (! fileManager) {
+        fileManager = [HLSFileManager defaultManager];
+    }
+    
+    NSMutableArray *archivePaths = [NSMutableArray array];
+    NSMutableArray *datas = [NSMutableArray array];
+    if (! addFilesAtPath(directoryPath, @"", fileManager, archivePaths, datas, pError)) {
+        return NO;
+    }
+    
+    // Index
+    NSMutableData *archiveData = [NSMutableData dataWithLength:kArchiveHeaderLength];
+    OSWriteLittleInt32([archiveData mutableBytes], 0, kArchiveMagic);
+    OSWriteLittleInt32([archiveData mutableBytes], sizeof(uint32_t), kArchiveVersion);
+    OSWriteLittleInt32([archiveData mutableBytes], 2 * sizeof(uint32_t), (uint32_t)[archivePaths count]);
+    
+    uint64_t indexLength = kArchiveHeaderLength;
+    for (NSString *path in archivePaths) {
+        indexLength += kArchiveEntryHeaderLength + [path lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    }
+    
+    uint64_t offset = indexLength;
+    for (NSUInteger i = 0; i < [archivePaths count]; ++i) {
+        NSData *pathData = [[archivePaths objectAtIndex:i] dataUsingEncoding:NSUTF8StringEncoding];
+        uint64_t length = [[datas objectAtIndex:i] length];
+        
+        unsigned char entryHeader[kArchiveEntryHeaderLength];
+        OSWriteLittleInt32(entryHeader, 0, (uint32_t)[pathData length]);
+        OSWriteLittleInt64(entryHeader, sizeof(uint32_t), offset);
+        OSWriteLittleInt64(entryHeader, sizeof(uint32_t) + sizeof(uint64_t), length);
+        [archiveData appendBytes:entryHeader length:kArchiveEntryHeaderLength];
+        [archiveData appendData:pathData];
+        
+        offset += length;
+    }
+    
+    // File data
+    for (NSData *data in datas) {
+        [archiveData appendData:data];
+    }
+    
+    HLSFileManager *defaultManager = [HLSFileManager defaultManager];
+    if ([defaultManager fileExistsAtPath:archivePath] && ! [defaultManager removeItemAtPath:archivePath error:pError]) {
+        return NO;
+    }
+    return [defaultManager createFileAtPath:archivePath contents:archiveData error:pError];
+}
+
+#pragma mark Object creation and destruction
+
+- (id)initWithArchiveAtPath:(NSString *)archivePath
+{
+    if ((self = [super init])) {
+        NSError *error = nil;
+        self.archiveData = [NSData dataWithContentsOfFile:archivePath options:NSDataReadingMappedAlways error:&error];
+        if (! self.archiveData) {
+            HLSLoggerError(@"The archive %@ could not be opened. Reason: %@", archivePath, error);
+            [self release];
+            return nil;
+        }
+        
+        if (! [self loadIndex]) {
+            HLSLoggerError(@"The file %@ is not a valid archive", archivePath);
+            [self release];
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    self.archiveData = nil;
+    self.pathToFileRangeMap = nil;
+    self.pathToDirectoryContentsMap = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize archiveData = m_archiveData;
+
+@synthesize pathToFileRangeMap = m_pathToFileRangeMap;
+
+@synthesize pathToDirectoryContentsMap = m_pathToDirectoryContentsMap;
+
+#pragma mark Index
+
+- (BOOL)loadIndex
+{
+    const unsigned char *bytes = [self.archiveData bytes];
+    NSUInteger archiveLength = [self.archiveData length];
+    if (archiveLength < kArchiveHeaderLength
+            || OSReadLittleInt32(bytes, 0) != kArchiveMagic
+            || OSReadLittleInt32(bytes, sizeof(uint32_t)) != kArchiveVersion) {
+        return NO;
+    }
+    
+    uint32_t nbrFiles = OSReadLittleInt32(bytes, 2 * sizeof(uint32_t));
+    NSMutableDictionary *pathToFileRangeMap = [NSMutableDictionary dictionaryWithCapacity:nbrFiles];
+    NSMutableDictionary *pathToDirectoryContentsSetMap = [NSMutableDictionary dictionary];
+    [pathToDirectoryContentsSetMap setObject:[NSMutableSet set] forKey:@""];
+    
+    NSUInteger location = kArchiveHeaderLength;
+    for (uint32_t i = 0; i < nbrFiles; ++i) {
+        if (archiveLength - location < kArchiveEntryHeaderLength) {
+            return NO;
+        }
+        
+        uint32_t pathLength = OSReadLittleInt32(bytes, location);
+        uint64_t offset = OSReadLittleInt64(bytes, location + sizeof(uint32_t));
+        uint64_t length = OSReadLittleInt64(bytes, location + sizeof(uint32_t) + sizeof(uint64_t));
+        location += kArchiveEntryHeaderLength;
+        if (archiveLength - location < pathLength || offset > archiveLength || length > archiveLength - offset) {
+            return NO;
+        }
+        
+        NSString *path = [[[NSString alloc] initWithBytes:bytes + location length:pathLength encoding:NSUTF8StringEncoding] autorelease];
+        location += pathLength;
+        if ([path length] == 0) {
+            return NO;
+        }
+        
+        [pathToFileRangeMap setObject:[NSValue valueWithRange:NSMakeRange((NSUInteger)offset, (NSUInteger)length)] forKey:path];
+        
+        // Register the file and its parent directories in the contents of their respective parents
+        NSString *itemPath = path;
+        while ([itemPath length] != 0) {
+            NSString *parentPath = [itemPath stringByDeletingLastPathComponent];
+            NSMutableSet *contents = [pathToDirectoryContentsSetMap objectForKey:parentPath];
+            BOOL knownParent = (contents != nil);
+            if (! contents) {
+                contents = [NSMutableSet set];
+                [pathToDirectoryContentsSetMap setObject:contents forKey:parentPath];
+            }
+            [contents addObject:[itemPath lastPathComponent]];
+            
+            if (knownParent) {
+                break;
+            }
+            itemPath = parentPath;
+        }
+    }
+    
+    NSMutableDictionary *pathToDirectoryContentsMap = [NSMutableDictionary dictionaryWithCapacity:[pathToDirectoryContentsSetMap count]];
+    for (NSString *directoryPath in [pathToDirectoryContentsSetMap allKeys]) {
+        if ([pathToFileRangeMap objectForKey:directoryPath]) {
+            // A path cannot be both a file and a directory
+            return NO;
+        }
+        [pathToDirectoryContentsMap setObject:[[pathToDirectoryContentsSetMap objectForKey:directoryPath] allObjects] forKey:directoryPath];
+    }
+    
+    self.pathToFileRangeMap = [NSDictionary dictionaryWithDictionary:pathToFileRangeMap];
+    self.pathToDirectoryContentsMap = [NSDictionary dictionaryWithDictionary:pathToDirectoryContentsMap];
+    return YES;
+}
+
+- (BOOL)denyModificationAtPath:(NSString *)path error:(NSError **)pError
+{
+    if (pError) {
+        *pError = fileError(NSFileWriteNoPermissionError, path);
+    }
+    return NO;
+}
+
+#pragma mark HLSFileManagerAbstract protocol implementation
+
+- (NSData *)contentsOfFileAtPath:(NSString *)path error:(NSError **)pError
+{
+    NSValue *rangeValue = [self.pathToFileRangeMap objectForKey:archivePathForPath(path)];
+    if (! rangeValue) {
+        if (pError) {
+            *pError = fileError(NSFileReadNoSuchFileError, path);
+        }
+        return nil;
+    }
+    return [[[HLSArchiveDataSlice alloc] initWithArchiveData:self.archiveData range:[rangeValue rangeValue]] autorelease];
+}
+
+- (BOOL)createFileAtPath:(NSString *)path contents:(NSData *)contents error:(NSError **)pError
+{
+    return [self denyModificationAtPath:path error:pError];
+}
+
+- (id<HLSFileHandle>)fileHandleForReadingAtPath:(NSString *)path error:(NSError **)pError
+{
+    NSData *data = [self contentsOfFileAtPath:path error:pError];
+    if (! data) {
+        return nil;
+    }
+    return [[[HLSArchiveFileHandle alloc] initWithData:data] autorelease];
+}
+
+- (id<HLSFileHandle>)fileHandleForWritingAtPath:(NSString *)path error:(NSError **)pError
+{
+    [self denyModificationAtPath:path error:pError];
+    return nil;
+}
+
+- (id<HLSFileHandle>)fileHandleForAppendingAtPath:(NSString *)path error:(NSError **)pError
+{
+    [self denyModificationAtPath:path error:pError];
+    return nil;
+}
+
+- (BOOL)createDirectoryAtPath:(NSString *)path withIntermediateDirectories:(BOOL)withIntermediateDirectories error:(NSError **)pError
+{
+    return [self denyModificationAtPath:path error:pError];
+}
+
+- (NSArray *)contentsOfDirectoryAtPath:(NSString *)path error:(NSError **)pError
+{
+    NSArray *contents = [self.pathToDirectoryContentsMap objectForKey:archivePathForPath(path)];
+    if (! contents) {
+        if (pError) {
+            *pError = fileError(NSFileReadNoSuchFileError, path);
+        }
+        return nil;
+    }
+    return contents;
+}
+
+- (NSArray *)itemsInDirectoryAtPath:(NSString *)path 
+                         attributes:(HLSFileAttributes)attributes 
+                          recursive:(BOOL)recursive 
+                              error:(NSError **)pError
+{
+    NSString *archivePath = archivePathForPath(path);
+    if (! [self.pathToDirectoryContentsMap objectForKey:archivePath]) {
+        if (pError) {
+            *pError = fileError(NSFileReadNoSuchFileError, path);
+        }
+        return nil;
+    }
+    
+    // Everything is known from the index. Archives have no modification dates
+    NSMutableArray *items = [NSMutableArray array];
+    NSMutableArray *pendingDirectoryPaths = [NSMutableArray arrayWithObject:archivePath];
+    while ([pendingDirectoryPaths count] != 0) {
+        NSString *directoryPath = [pendingDirectoryPaths lastObject];
+        [pendingDirectoryPaths removeLastObject];
+        
+        for (NSString *name in [self.pathToDirectoryContentsMap objectForKey:directoryPath]) {
+            NSString *itemArchivePath = [directoryPath length] != 0 ? [directoryPath stringByAppendingPathComponent:name] : name;
+            NSString *itemRelativePath = [archivePath length] != 0 ? [itemArchivePath substringFromIndex:[archivePath length] + 1] : itemArchivePath;
+            
+            NSValue *rangeValue = [self.pathToFileRangeMap objectForKey:itemArchivePath];
+            unsigned long long size = (attributes & HLSFileAttributeSize) ? [rangeValue rangeValue].length : 0;
+            HLSFileItem *item = [[HLSFileItem alloc] initWithPath:itemRelativePath directory:! rangeValue size:size modificationDate:nil];
+            [items addObject:item];
+            [item release];
+            
+            if (! rangeValue && recursive) {
+                [pendingDirectoryPaths addObject:itemArchivePath];
+            }
+        }
+    }
+    return [NSArray arrayWithArray:items];
+}
+
+- (BOOL)fileExistsAtPath:(NSString *)path isDirectory:(BOOL *)pIsDirectory
+{
+    NSString *archivePath = archivePathForPath(path);
+    BOOL isDirectory = ([self.pathToDirectoryContentsMap objectForKey:archivePath] != nil);
+    if (pIsDirectory) {
+        *pIsDirectory = isDirectory;
+    }
+    return isDirectory || [self.pathToFileRangeMap objectForKey:archivePath] != nil;
+}
+
+- (BOOL)copyItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)pError
+{
+    return [self denyModificationAtPath:destinationPath error:pError];
+}
+
+- (BOOL)moveItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)pError
+{
+    return [self denyModificationAtPath:sourcePath error:pError];
+}
+
+- (BOOL)removeItemAtPath:(NSString *)path error:(NSError **)pError
+{
+    return [self denyModificationAtPath:path error:pError];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSArchiveDataSlice class implementation
+
+@implementation HLSArchiveDataSlice
+
+#pragma mark Object creation and destruction
+
+- (id)initWithArchiveData:(NSData *)archiveData range:(NSRange)range
+{
+    if ((self = [super init])) {
+        m_archiveData = [archiveData retain];
+        m_range = range;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [m_archiveData release];
+    
+    [super dealloc];
+}
+
+#pragma mark NSData primitive methods
+
+- (const void *)bytes
+{
+    return (const unsigned char *)[m_archiveData bytes] + m_range.location;
+}
+
+- (NSUInteger)length
+{
+    return m_range.length;
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSArchiveFileHandle class implementation
+
+@implementation HLSArchiveFileHandle
+
+#pragma mark Object creation and destruction
+
+- (id)initWithData:(NSData *)data
+{
+    if ((self = [super init])) {
+        m_data = [data retain];
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    [self close];
+    
+    [super dealloc];
+}
+
+#pragma mark HLSFileHandle protocol implementation
+
+- (NSData *)readDataOfLength:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)pError
+{
+    NSUInteger dataLength = [m_data length];
+    if (offset >= dataLength) {
+        return [NSData data];
+    }
+    return [m_data subdataWithRange:NSMakeRange((NSUInteger)offset, MIN(length, dataLength - (NSUInteger)offset))];
+}
+
+- (BOOL)writeData:(NSData *)data error:(NSError **)pError
+{
+    if (pError) {
+        *pError = fileError(NSFileWriteNoPermissionError, nil);
+    }
+    return NO;
+}
+
+- (unsigned long long)length
+{
+    return [m_data length];
+}
+
+- (void)close
+{
+    [m_data release];
+    m_data = nil;
+}
+
+@end
+
+#pragma mark -
+#pragma mark Static functions
+
+static NSString *archivePathForPath(NSString *path)
+{
+    // Archive paths have no leading or trailing slash, the root being the empty string
+    NSMutableArray *components = [NSMutableArray array];
+    for (NSString *component in [path pathComponents]) {
+        if ([component isEqualToString:@"/"] || [component isEqualToString:@"."]) {
+            continue;
+        }
+        [components addObject:component];
+    }
+    return [components componentsJoinedByString:@"/"];
+}
+
+static BOOL addFilesAtPath(NSString *directoryPath, NSString *archivePath, HLSFileManager *fileManager,
+                           NSMutableArray *archivePaths, NSMutableArray *datas, NSError **pError)
+{
+    NSArray *contents = [fileManager contentsOfDirectoryAtPath:directoryPath error:pError];
+    if (! contents) {
+        return NO;
+    }
+    
+    for (NSString *name in contents) {
+        NSString *itemPath = [directoryPath stringByAppendingPathComponent:name];
+        NSString *itemArchivePath = [archivePath length] != 0 ? [archivePath stringByAppendingPathComponent:name] : name;
+        
+        BOOL isDirectory = NO;
+        if (! [fileManager fileExistsAtPath:itemPath isDirectory:&isDirectory]) {
+            continue;
+        }
+        
+        if (isDirectory) {
+            if (! addFilesAtPath(itemPath, itemArchivePath, fileManager, archivePaths, datas, pError)) {
+                return NO;
+            }
+        }
+        else {
+            NSData *data = [fileManager contentsOfFileAtPath:itemPath error:pError];
+            if (! data) {
+                return NO;
+            }
+            [archivePaths addObject:itemArchivePath];
+            [datas addObject:data];
+        }
+    }
+    return YES;
+}
+
+static NSError *fileError(NSInteger code, NSString *path)
+{
+    return [NSError errorWithDomain:NSCocoaErrorDomain 
+                               code:code 
+                           userInfo:[NSDictionary dictionaryWithObject:path ?: @"" forKey:NSFilePathErrorKey]];
+}
@@ -0,0 +1,64 @@
+//
+//  HLSCachingFileManager.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 31.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import <libkern/OSAtomic.h>
+#import "HLSFileManager.h"
+
+// Forward declarations
+@class HLSCachedFileContents;
+
+/**
+ * A file manager decorating another one with two caches, so that repeated reads of small files (e.g. configuration
+ * files) do not hit the underlying storage:
+ *   - a least recently used cache of file contents, whose total size is bounded by a cost limit (in bytes). Files
+ *     larger than the limit are never cached
+ *   - a cache of -fileExistsAtPath:isDirectory: results
+ *
+ * Modifications made through the caching file manager (including writes made through its file handles) invalidate
+ * the affected entries. Modifications made directly through the underlying file manager are not seen until the
+ * cache has been cleared
+ *
+ * All methods are thread-safe
+ *
+ * Designated initializer: -initWithFileManager:costLimit:
+ */
+@interface HLSCachingFileManager : HLSFileManager {
+@private
+    HLSFileManager *m_fileManager;
+    NSUInteger m_costLimit;
+    NSUInteger m_totalCost;
+    NSMutableDictionary *m_pathToContentsMap;
+    HLSCachedFileContents *m_mostRecentlyUsedContents;
+    HLSCachedFileContents *m_leastRecentlyUsedContents;
+    NSMutableDictionary *m_pathToExistenceMap;
+    OSSpinLock m_cacheLock;
+}
+
+/**
+ * Create a caching file manager for the given file manager (mandatory), caching at most costLimit bytes of file
+ * contents
+ */
+- (id)initWithFileManager:(HLSFileManager *)fileManager costLimit:(NSUInteger)costLimit;
+
+/**
+ * The decorated file manager
+ */
+@property (nonatomic, readonly, retain) HLSFileManager *fileManager;
+
+/**
+ * The maximum total size of the cached file contents, and the current total size
+ */
+@property (nonatomic, readonly, assign) NSUInteger costLimit;
+@property (nonatomic, readonly, assign) NSUInteger totalCost;
+
+/**
+ * Discard all cached information
+ */
+- (void)clearCache;
+
+@end
@@ -0,0 +1,509 @@
+//
+//  HLSCachingFileManager.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 31.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSCachingFileManager.h"
+
+#import "HLSAssert.h"
+#import "HLSLogger.h"
+
+// Values of the existence cache
+typedef enum {
+    HLSFileExistenceEnumBegin = 0,
+    HLSFileExistenceNone = HLSFileExistenceEnumBegin,
+    HLSFileExistenceFile,
+    HLSFileExistenceDirectory,
+    HLSFileExistenceEnumEnd,
+    HLSFileExistenceEnumSize = HLSFileExistenceEnumEnd - HLSFileExistenceEnumBegin
+} HLSFileExistence;
+
+// Function declarations
+static NSString *standardizedPath(NSString *path);
+static BOOL isPathInside(NSString *path, NSString *parentPath);
+
+#pragma mark -
+#pragma mark HLSCachedFileContents class interface
+
+/**
+ * Node of the doubly linked list ordering cached contents from the most to the least recently used. The next
+ * contents are not retained, the list being owned by the path to contents map
+ */
+@interface HLSCachedFileContents : NSObject {
+@private
+    NSString *m_path;
+    NSData *m_data;
+    HLSCachedFileContents *m_previousContents;
+    HLSCachedFileContents *m_nextContents;
+}
+
+@property (nonatomic, retain) NSString *path;
+@property (nonatomic, retain) NSData *data;
+@property (nonatomic, assign) HLSCachedFileContents *previousContents;
+@property (nonatomic, assign) HLSCachedFileContents *nextContents;
+
+@end
+
+#pragma mark -
+#pragma mark HLSCachingFileHandle class interface
+
+/**
+ * Handle forwarding to a handle of the decorated file manager, and invalidating the cache for the file it writes to
+ *
+ * Designated initializer: -initWithFileHandle:path:cachingFileManager:
+ */
+@interface HLSCachingFileHandle : NSObject <HLSFileHandle> {
+@private
+    id<HLSFileHandle> m_fileHandle;
+    NSString *m_path;
+    HLSCachingFileManager *m_cachingFileManager;
+}
+
+- (id)initWithFileHandle:(id<HLSFileHandle>)fileHandle path:(NSString *)path cachingFileManager:(HLSCachingFileManager *)cachingFileManager;
+
+@end
+
+#pragma mark -
+#pragma mark HLSCachingFileManager class interface extension
+
+@interface HLSCachingFileManager ()
+
+@property (nonatomic, retain) HLSFileManager *fileManager;
+@property (nonatomic, assign) NSUInteger costLimit;
+@property (nonatomic, assign) NSUInteger totalCost;
+@property (nonatomic, retain) NSMutableDictionary *pathToContentsMap;
+@property (nonatomic, retain) NSMutableDictionary *pathToExistenceMap;
+
+- (NSData *)cachedDataForPath:(NSString *)path;
+- (void)cacheData:(NSData *)data forPath:(NSString *)path;
+- (void)unlinkContents:(HLSCachedFileContents *)contents;
+- (void)invalidatePath:(NSString *)path;
+
+@end
+
+#pragma mark -
+#pragma mark HLSCachingFileManager class implementation
+
+@implementation HLSCachingFileManager
+
+#pragma mark Object creation and destruction
+
+- (id)initWithFileManager:(HLSFileManager *)fileManager costLimit:(NSUInteger)costLimit
+{
+    if ((self = [super init])) {
+        if (! fileManager) {
+            HLSLoggerError(@"A file manager is mandatory");
+            [self release];
+            return nil;
+        }
+        
+        self.fileManager = fileManager;
+        self.costLimit = costLimit;
+        self.pathToContentsMap = [NSMutableDictionary dictionary];
+        self.pathToExistenceMap = [NSMutableDictionary dictionary];
+        m_cacheLock = OS_SPINLOCK_INIT;
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    self.fileManager = nil;
+    self.pathToContentsMap = nil;
+    self.pathToExistenceMap = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize fileManager = m_fileManager;
+
+@synthesize costLimit = m_costLimit;
+
+@synthesize totalCost = m_totalCost;
+
+@synthesize pathToContentsMap = m_pathToContentsMap;
+
+@synthesize pathToExistenceMap = m_pathToExistenceMap;
+
+#pragma mark Cache management
+
+- (NSData *)cachedDataForPath:(NSString *)path
+{
+    OSSpinLockLock(&m_cacheLock);
+    HLSCachedFileContents *contents = [self.pathToContentsMap objectForKey:path];
+    NSData *data = [[contents.data retain] autorelease];
+    if (contents && contents != m_mostRecentlyUsedContents) {
+        // Move to the front of the list
+        [self unlinkContents:contents];
+        contents.nextContents = m_mostRecentlyUsedContents;
+        m_mostRecentlyUsedContents.previousContents = contents;
+        m_mostRecentlyUsedContents = contents;
+        if (! m_leastRecentlyUsedContents) {
+            m_leastRecentlyUsedContents = contents;
+        }
+    }
+    OSSpinLockUnlock(&m_cacheLock);
+    return data;
+}
+
+- (void)cacheData:(NSData *)data forPath:(NSString *)path
+{
+    NSUInteger cost = [data length];
+    if (cost > self.costLimit) {
+        return;
+    }
+    
+    HLSCachedFileContents *contents = [[[HLSCachedFileContents alloc] init] autorelease];
+    contents.path = path;
+    contents.data = data;
+    
+    OSSpinLockLock(&m_cacheLock);
+    HLSCachedFileContents *existingContents = [self.pathToContentsMap objectForKey:path];
+    if (existingContents) {
+        [self unlinkContents:existingContents];
+        self.totalCost -= [existingContents.data length];
+        [self.pathToContentsMap removeObjectForKey:path];
+    }
+    
+    // Evict the least recently used contents until the new ones fit
+    while (m_leastRecentlyUsedContents && self.totalCost + cost > self.costLimit) {
+        HLSCachedFileContents *evictedContents = m_leastRecentlyUsedContents;
+        [self unlinkContents:evictedContents];
+        self.totalCost -= [evictedContents.data length];
+        [self.pathToContentsMap removeObjectForKey:evictedContents.path];
+    }
+    
+    [self.pathToContentsMap setObject:contents forKey:path];
+    contents.nextContents = m_mostRecentlyUsedContents;
+    m_mostRecentlyUsedContents.previousContents = contents;
+    m_mostRecentlyUsedContents = contents;
+    if (! m_leastRecentlyUsedContents) {
+        m_leastRecentlyUsedContents = contents;
+    }
+    self.totalCost += cost;
+    OSSpinLockUnlock(&m_cacheLock);
+}
+
+// Must be called with the cache lock held
+- (void)unlinkContents:(HLSCachedFileContents *)contents
+{
+    if (contents.previousContents) {
+        contents.previousContents.nextContents = contents.nextContents;
+    }
+    else {
+        m_mostRecentlyUsedContents = contents.nextContents;
+    }
+    
+    if (contents.nextContents) {
+        contents.nextContents.previousContents = contents.previousContents;
+    }
+    else {
+        m_leastRecentlyUsedContents = contents.previousContents;
+    }
+    
+    contents.previousContents = nil;
+    contents.nextContents = nil;
+}
+
+- (void)invalidatePath:(NSString *)path
+{
+    OSSpinLockLock(&m_cacheLock);
+    
+    // Contents of the file itself, or of files within the directory
+    for (NSString *cachedPath in [self.pathToContentsMap allKeys]) {
+        if (! isPathInside(cachedPath, path)) {
+            continue;
+        }
+        
+        HLSCachedFileContents *contents = [self.pathToContentsMap objectForKey:cachedPath];
+        [self unlinkContents:contents];
+        self.totalCost -= [contents.data length];
+        [self.pathToContentsMap removeObjectForKey:cachedPath];
+    }
+    
+    // Existence of the item, of the items it contains, and of its parents (which might have been created)
+    for (NSString *cachedPath in [self.pathToExistenceMap allKeys]) {
+        if (isPathInside(cachedPath, path) || isPathInside(path, cachedPath)) {
+            [self.pathToExistenceMap removeObjectForKey:cachedPath];
+        }
+    }
+    
+    OSSpinLockUnlock(&m_cacheLock);
+}
+
+- (void)clearCache
+{
+    OSSpinLockLock(&m_cacheLock);
+    for (HLSCachedFileContents *contents in [self.pathToContentsMap allValues]) {
+        contents.previousContents = nil;
+        contents.nextContents = nil;
+    }
+    [self.pathToContentsMap removeAllObjects];
+    m_mostRecentlyUsedContents = nil;
+    m_leastRecentlyUsedContents = nil;
+    self.totalCost = 0;
+    [self.pathToExistenceMap removeAllObjects];
+    OSSpinLockUnlock(&m_cacheLock);
+}
+
+#pragma mark HLSFileManagerAbstract protocol implementation
+
+- (NSData *)contentsOfFileAtPath:(NSString *)path error:(NSError **)pError
+{
+    path = standardizedPath(path);
+    NSData *data = [self cachedDataForPath:path];
+    if (data) {
+        return data;
+    }
+    
+    data = [self.fileManager contentsOfFileAtPath:path error:pError];
+    if (data) {
+        // Never cache mutable data which could be changed behind our back
+        data = [NSData dataWithData:data];
+        [self cacheData:data forPath:path];
+    }
+    return data;
+}
+
+- (BOOL)createFileAtPath:(NSString *)path contents:(NSData *)contents error:(NSError **)pError
+{
+    path = standardizedPath(path);
+    BOOL success = [self.fileManager createFileAtPath:path contents:contents error:pError];
+    [self invalidatePath:path];
+    return success;
+}
+
+- (id<HLSFileHandle>)fileHandleForReadingAtPath:(NSString *)path error:(NSError **)pError
+{
+    return [self.fileManager fileHandleForReadingAtPath:path error:pError];
+}
+
+- (id<HLSFileHandle>)fileHandleForWritingAtPath:(NSString *)path error:(NSError **)pError
+{
+    path = standardizedPath(path);
+    id<HLSFileHandle> fileHandle = [self.fileManager fileHandleForWritingAtPath:path error:pError];
+    [self invalidatePath:path];
+    if (! fileHandle) {
+        return nil;
+    }
+    return [[[HLSCachingFileHandle alloc] initWithFileHandle:fileHandle path:path cachingFileManager:self] autorelease];
+}
+
+- (id<HLSFileHandle>)fileHandleForAppendingAtPath:(NSString *)path error:(NSError **)pError
+{
+    path = standardizedPath(path);
+    id<HLSFileHandle> fileHandle = [self.fileManager fileHandleForAppendingAtPath:path error:pError];
+    [self invalidatePath:path];
+    if (! fileHandle) {
+        return nil;
+    }
+    return [[[HLSCachingFileHandle alloc] initWithFileHandle:fileHandle path:path cachingFileManager:self] autorelease];
+}
+
+- (BOOL)createDirectoryAtPath:(NSString *)path withIntermediateDirectories:(BOOL)withIntermediateDirectories error:(NSError **)pError
+{
+    path = standardizedPath(path);
+    BOOL success = [self.fileManager createDirectoryAtPath:path withIntermediateDirectories:withIntermediateDirectories error:pError];
+    [self invalidatePath:path];
+    return success;
+}
+
+- (NSArray *)contentsOfDirectoryAtPath:(NSString *)path error:(NSError **)pError
+{
+    return [self.fileManager contentsOfDirectoryAtPath:path error:pError];
+}
+
+- (NSArray *)itemsInDirectoryAtPath:(NSString *)path 
+                         attributes:(HLSFileAttributes)attributes 
+                          recursive:(BOOL)recursive 
+                              error:(NSError **)pError
+{
+    path = standardizedPath(path);
+    NSArray *items = [self.fileManager itemsInDirectoryAtPath:path attributes:attributes recursive:recursive error:pError];
+    
+    // The enumeration tells the type of each item for free, fill the existence cache
+    OSSpinLockLock(&m_cacheLock);
+    for (HLSFileItem *item in items) {
+        HLSFileExistence existence = item.directory ? HLSFileExistenceDirectory : HLSFileExistenceFile;
+        [self.pathToExistenceMap setObject:[NSNumber numberWithInt:existence] forKey:[path stringByAppendingPathComponent:item.path]];
+    }
+    OSSpinLockUnlock(&m_cacheLock);
+    
+    return items;
+}
+
+- (BOOL)fileExistsAtPath:(NSString *)path isDirectory:(BOOL *)pIsDirectory
+{
+    path = standardizedPath(path);
+    
+    OSSpinLockLock(&m_cacheLock);
+    NSNumber *existenceNumber = [[[self.pathToExistenceMap objectForKey:path] retain] autorelease];
+    OSSpinLockUnlock(&m_cacheLock);
+    
+    HLSFileExistence existence;
+    if (existenceNumber) {
+        existence = [existenceNumber intValue];
+    }
+    else {
+        BOOL isDirectory = NO;
+        if ([self.fileManager fileExistsAtPath:path isDirectory:&isDirectory]) {
+            existence = isDirectory ? HLSFileExistenceDirectory : HLSFileExistenceFile;
+        }
+        else {
+            existence = HLSFileExistenceNone;
+        }
+        
+        OSSpinLockLock(&m_cacheLock);
+        [self.pathToExistenceMap setObject:[NSNumber numberWithInt:existence] forKey:path];
+        OSSpinLockUnlock(&m_cacheLock);
+    }
+    
+    if (pIsDirectory) {
+        *pIsDirectory = (existence == HLSFileExistenceDirectory);
+    }
+    return existence != HLSFileExistenceNone;
+}
+
+- (BOOL)copyItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)pError
+{
+    destinationPath = standardizedPath(destinationPath);
+    BOOL success = [self.fileManager copyItemAtPath:sourcePath toPath:destinationPath error:pError];
+    [self invalidatePath:destinationPath];
+    return success;
+}
+
+- (BOOL)moveItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)pError
+{
+    sourcePath = standardizedPath(sourcePath);
+    destinationPath = standardizedPath(destinationPath);
+    BOOL success = [self.fileManager moveItemAtPath:sourcePath toPath:destinationPath error:pError];
+    [self invalidatePath:sourcePath];
+    [self invalidatePath:destinationPath];
+    return success;
+}
+
+- (BOOL)removeItemAtPath:(NSString *)path error:(NSError **)pError
+{
+    path = standardizedPath(path);
+    BOOL success = [self.fileManager removeItemAtPath:path error:pError];
+    [self invalidatePath:path];
+    return success;
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSCachedFileContents class implementation
+
+@implementation HLSCachedFileContents
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.path = nil;
+    self.data = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize path = m_path;
+
+@synthesize data = m_data;
+
+@synthesize previousContents = m_previousContents;
+
+@synthesize nextContents = m_nextContents;
+
+@end
+
+#pragma mark -
+#pragma mark HLSCachingFileHandle class implementation
+
+@implementation HLSCachingFileHandle
+
+#pragma mark Object creation and destruction
+
+- (id)initWithFileHandle:(id<HLSFileHandle>)fileHandle path:(NSString *)path cachingFileManager:(HLSCachingFileManager *)cachingFileManager
+{
+    if ((self = [super init])) {
+        m_fileHandle = [fileHandle retain];
+        m_path = [path retain];
+        m_cachingFileManager = [cachingFileManager retain];
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    [m_fileHandle release];
+    [m_path release];
+    [m_cachingFileManager release];
+    
+    [super dealloc];
+}
+
+#pragma mark HLSFileHandle protocol implementation
+
+- (NSData *)readDataOfLength:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)pError
+{
+    return [m_fileHandle readDataOfLength:length atOffset:offset error:pError];
+}
+
+- (BOOL)writeData:(NSData *)data error:(NSError **)pError
+{
+    BOOL success = [m_fileHandle writeData:data error:pError];
+    [m_cachingFileManager invalidatePath:m_path];
+    return success;
+}
+
+- (unsigned long long)length
+{
+    return [m_fileHandle length];
+}
+
+- (void)close
+{
+    [m_fileHandle close];
+}
+
+@end
+
+#pragma mark -
+#pragma mark Static functions
+
+static NSString *standardizedPath(NSString *path)
+{
+    // Remove trailing slashes and redundant components, so that equivalent paths share cache entries
+    return [path stringByStandardizingPath];
+}
+
+// Return YES iff path is parentPath or an item within it
+static BOOL isPathInside(NSString *path, NSString *parentPath)
+{
+    if ([path isEqualToString:parentPath]) {
+        return YES;
+    }
+    
+    NSString *prefix = [parentPath hasSuffix:@"/"] ? parentPath : [parentPath stringByAppendingString:@"/"];
+    return [path hasPrefix:prefix];
+}
@@ -0,0 +1,85 @@
+//
+//  HLSCoalescingNotificationCenter.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 27.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+// Forward declarations
+@class HLSCoalescedNotificationQueue;
+
+/**
+ * Block merging the userInfo of a notification being coalesced into the userInfo accumulated so far for the same
+ * (name, object) pair. The accumulated userInfo is nil for the first notification
+ */
+typedef NSDictionary * (^HLSNotificationUserInfoReducer)(NSDictionary *accumulatedUserInfo, NSDictionary *userInfo);
+
+/**
+ * A notification center coalescing notifications posted during a display frame. Notifications posted through it are
+ * not sent immediately, but at the beginning of the next frame, at most once per (name, object) pair. The userInfo
+ * dictionaries of coalesced notifications are merged using the reducer registered for the notification name (by
+ * default, entries of later notifications replace those of earlier ones). Notifications are then posted to the default
+ * NSNotificationCenter, in the order in which they were first posted during the frame, so that any observer can
+ * receive them.
+ *
+ * Observers which need to be notified less often (e.g. to refresh an expensive user interface) can register with
+ * the coalescing notification center itself, providing a minimum interval between two notifications. Notifications
+ * received in the meantime are coalesced further and delivered when the interval has elapsed. Such observers are not
+ * retained and must be removed before they are deallocated.
+ *
+ * Notifications can be posted from any thread, they are always delivered on the main thread. Observers must be added
+ * and removed from the main thread. A display link only runs while notifications are pending
+ *
+ * Designated initializer: -init
+ */
+@interface HLSCoalescingNotificationCenter : NSObject {
+@private
+    HLSCoalescedNotificationQueue *m_notificationQueue;
+    NSMutableDictionary *m_nameToReducerMap;
+    NSMutableArray *m_throttledObservers;
+    CADisplayLink *m_displayLink;
+}
+
+/**
+ * The shared coalescing notification center
+ */
++ (HLSCoalescingNotificationCenter *)defaultCenter;
+
+/**
+ * Set the block used to merge the userInfo of notifications with a given name. Set nil to restore the default behavior
+ */
+- (void)setUserInfoReducer:(HLSNotificationUserInfoReducer)reducer forNotificationName:(NSString *)name;
+
+/**
+ * Post a notification at the beginning of the next frame, coalescing it with other notifications with the same name
+ * and object posted until then. The object is retained until the notification has been sent
+ */
+- (void)postNotificationName:(NSString *)name object:(id)object userInfo:(NSDictionary *)userInfo;
+- (void)postNotificationName:(NSString *)name object:(id)object;
+
+/**
+ * Register an observer to be notified at most once every minimumInterval seconds of notifications with a given name
+ * and object posted through the coalescing notification center. As for NSNotificationCenter, name and object can be
+ * nil to observe notifications regardless of their name or object, and the selector must have the signature
+ * - (void)methodName:(NSNotification *)notification
+ */
+- (void)addObserver:(id)observer
+           selector:(SEL)selector
+               name:(NSString *)name
+             object:(id)object
+    minimumInterval:(NSTimeInterval)minimumInterval;
+
+/**
+ * Remove an observer, for all notifications or only for a given name and object (nil matches any name or object)
+ */
+- (void)removeObserver:(id)observer;
+- (void)removeObserver:(id)observer name:(NSString *)name object:(id)object;
+
+/**
+ * Send all pending notifications immediately, except those held back by observers with a minimum interval. Must be
+ * called from the main thread
+ */
+- (void)flush;
+
+@end
@@ -0,0 +1,549 @@
+//
+//  HLSCoalescingNotificationCenter.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 27.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSCoalescingNotificationCenter.h"
+
+#import "HLSLogger.h"
+
+// Function declarations
+static NSDictionary *reduceUserInfo(HLSNotificationUserInfoReducer reducer, NSDictionary *accumulatedUserInfo, NSDictionary *userInfo);
+
+#pragma mark -
+#pragma mark HLSCoalescedNotification class interface
+
+/**
+ * A notification being coalesced
+ *
+ * Designated initializer: -initWithName:object:
+ */
+@interface HLSCoalescedNotification : NSObject {
+@private
+    NSString *m_name;
+    id m_object;
+    NSDictionary *m_userInfo;
+}
+
+- (id)initWithName:(NSString *)name object:(id)object;
+
+@property (nonatomic, readonly, retain) NSString *name;
+@property (nonatomic, readonly, retain) id object;
+@property (nonatomic, retain) NSDictionary *userInfo;
+
+@end
+
+@interface HLSCoalescedNotification ()
+
+@property (nonatomic, retain) NSString *name;
+@property (nonatomic, retain) id object;
+
+@end
+
+#pragma mark -
+#pragma mark HLSCoalescedNotificationQueue class interface
+
+/**
+ * Notifications waiting to be sent, with at most one entry per (name, object) pair. Entries are kept in the order in
+ * which they were created, and can be located in constant time
+ *
+ * Designated initializer: -init
+ */
+@interface HLSCoalescedNotificationQueue : NSObject {
+@private
+    NSMutableArray *m_coalescedNotifications;
+    NSMutableDictionary *m_nameToObjectMapMap;          // name -> CFMutableDictionary (object pointer -> notification)
+}
+
+- (void)enqueueNotificationWithName:(NSString *)name
+                             object:(id)object
+                           userInfo:(NSDictionary *)userInfo
+                            reducer:(HLSNotificationUserInfoReducer)reducer;
+
+/**
+ * Return all pending notifications as NSNotification objects, and empty the queue
+ */
+- (NSArray *)dequeueAllNotifications;
+
+@property (nonatomic, readonly, assign, getter=isEmpty) BOOL empty;
+
+@end
+
+@interface HLSCoalescedNotificationQueue ()
+
+@property (nonatomic, retain) NSMutableArray *coalescedNotifications;
+@property (nonatomic, retain) NSMutableDictionary *nameToObjectMapMap;
+
+@end
+
+#pragma mark -
+#pragma mark HLSThrottledObserver class interface
+
+/**
+ * An observer registered with a minimum interval between notifications
+ *
+ * Designated initializer: -initWithObserver:selector:name:object:minimumInterval:
+ */
+@interface HLSThrottledObserver : NSObject {
+@private
+    id m_observer;
+    SEL m_selector;
+    NSString *m_name;
+    id m_object;
+    NSTimeInterval m_minimumInterval;
+    CFTimeInterval m_lastNotificationTimestamp;
+    HLSCoalescedNotificationQueue *m_notificationQueue;
+}
+
+- (id)initWithObserver:(id)observer
+              selector:(SEL)selector
+                  name:(NSString *)name
+                object:(id)object
+       minimumInterval:(NSTimeInterval)minimumInterval;
+
+@property (nonatomic, assign) id observer;
+@property (nonatomic, assign) SEL selector;
+@property (nonatomic, retain) NSString *name;
+@property (nonatomic, assign) id object;
+@property (nonatomic, assign) NSTimeInterval minimumInterval;
+@property (nonatomic, assign) CFTimeInterval lastNotificationTimestamp;
+@property (nonatomic, retain) HLSCoalescedNotificationQueue *notificationQueue;
+
+- (BOOL)matchesNotificationWithName:(NSString *)name object:(id)object;
+
+@end
+
+#pragma mark -
+#pragma mark HLSCoalescingNotificationCenter class interface extension
+
+@interface HLSCoalescingNotificationCenter ()
+
+@property (nonatomic, retain) HLSCoalescedNotificationQueue *notificationQueue;
+@property (nonatomic, retain) NSMutableDictionary *nameToReducerMap;
+@property (nonatomic, retain) NSMutableArray *throttledObservers;
+@property (nonatomic, retain) CADisplayLink *displayLink;
+
+- (void)enqueueNotificationWithName:(NSString *)name object:(id)object userInfo:(NSDictionary *)userInfo;
+
+- (void)startDisplayLink;
+- (void)tick:(CADisplayLink *)displayLink;
+
+@end
+
+#pragma mark -
+#pragma mark HLSCoalescedNotification class implementation
+
+@implementation HLSCoalescedNotification
+
+#pragma mark Object creation and destruction
+
+- (id)initWithName:(NSString *)name object:(id)object
+{
+    if ((self = [super init])) {
+        self.name = name;
+        self.object = object;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    self.name = nil;
+    self.object = nil;
+    self.userInfo = nil;
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize name = m_name;
+
+@synthesize object = m_object;
+
+@synthesize userInfo = m_userInfo;
+
+@end
+
+#pragma mark -
+#pragma mark HLSCoalescedNotificationQueue class implementation
+
+@implementation HLSCoalescedNotificationQueue
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.coalescedNotifications = [NSMutableArray array];
+        self.nameToObjectMapMap = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    self.coalescedNotifications = nil;
+    self.nameToObjectMapMap = nil;
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize coalescedNotifications = m_coalescedNotifications;
+
+@synthesize nameToObjectMapMap = m_nameToObjectMapMap;
+
+- (BOOL)isEmpty
+{
+    return [self.coalescedNotifications count] == 0;
+}
+
+#pragma mark Queue management
+
+- (void)enqueueNotificationWithName:(NSString *)name
+                             object:(id)object
+                           userInfo:(NSDictionary *)userInfo
+                            reducer:(HLSNotificationUserInfoReducer)reducer
+{
+    // Objects are identified by their address (nil is stored as NSNull)
+    CFMutableDictionaryRef objectMap = (CFMutableDictionaryRef)[self.nameToObjectMapMap objectForKey:name];
+    if (! objectMap) {
+        objectMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        [self.nameToObjectMapMap setObject:(id)objectMap forKey:name];
+        CFRelease(objectMap);
+    }
+    
+    const void *objectKey = object ? object : [NSNull null];
+    HLSCoalescedNotification *coalescedNotification = CFDictionaryGetValue(objectMap, objectKey);
+    if (! coalescedNotification) {
+        coalescedNotification = [[[HLSCoalescedNotification alloc] initWithName:name object:object] autorelease];
+        [self.coalescedNotifications addObject:coalescedNotification];
+        CFDictionarySetValue(objectMap, objectKey, coalescedNotification);
+    }
+    
+    coalescedNotification.userInfo = reduceUserInfo(reducer, coalescedNotification.userInfo, userInfo);
+}
+
+- (NSArray *)dequeueAllNotifications
+{
+    NSMutableArray *notifications = [NSMutableArray arrayWithCapacity:[self.coalescedNotifications count]];
+    for (HLSCoalescedNotification *coalescedNotification in self.coalescedNotifications) {
+        NSNotification *notification = [NSNotification notificationWithName:coalescedNotification.name
+                                                                      object:coalescedNotification.object
+                                                                    userInfo:coalescedNotification.userInfo];
+        [notifications addObject:notification];
+    }
+    
+    [self.coalescedNotifications removeAllObjects];
+    [self.nameToObjectMapMap removeAllObjects];
+    
+    return [NSArray arrayWithArray:notifications];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSThrottledObserver class implementation
+
+@implementation HLSThrottledObserver
+
+#pragma mark Object creation and destruction
+
+- (id)initWithObserver:(id)observer
+              selector:(SEL)selector
+                  name:(NSString *)name
+                object:(id)object
+       minimumInterval:(NSTimeInterval)minimumInterval
+{
+    if ((self = [super init])) {
+        self.observer = observer;
+        self.selector = selector;
+        self.name = name;
+        self.object = object;
+        self.minimumInterval = minimumInterval;
+        self.lastNotificationTimestamp = -minimumInterval;
+        self.notificationQueue = [[[HLSCoalescedNotificationQueue alloc] init] autorelease];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    self.observer = nil;
+    self.name = nil;
+    self.object = nil;
+    self.notificationQueue = nil;
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize observer = m_observer;
+
+@synthesize selector = m_selector;
+
+@synthesize name = m_name;
+
+@synthesize object = m_object;
+
+@synthesize minimumInterval = m_minimumInterval;
+
+@synthesize lastNotificationTimestamp = m_lastNotificationTimestamp;
+
+@synthesize notificationQueue = m_notificationQueue;
+
+#pragma mark Matching
+
+- (BOOL)matchesNotificationWithName:(NSString *)name object:(id)object
+{
+    return (! self.name || [self.name isEqualToString:name]) && (! self.object || self.object == object);
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSCoalescingNotificationCenter class implementation
+
+@implementation HLSCoalescingNotificationCenter
+
+#pragma mark Class methods
+
++ (HLSCoalescingNotificationCenter *)defaultCenter
+{
+    static HLSCoalescingNotificationCenter *s_instance = nil;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        s_instance = [[HLSCoalescingNotificationCenter alloc] init];
+    });
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.notificationQueue = [[[HLSCoalescedNotificationQueue alloc] init] autorelease];
+        self.nameToReducerMap = [NSMutableDictionary dictionary];
+        self.throttledObservers = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self.displayLink invalidate];
+    
+    self.notificationQueue = nil;
+    self.nameToReducerMap = nil;
+    self.throttledObservers = nil;
+    self.displayLink = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize notificationQueue = m_notificationQueue;
+
+@synthesize nameToReducerMap = m_nameToReducerMap;
+
+@synthesize throttledObservers = m_throttledObservers;
+
+@synthesize displayLink = m_displayLink;
+
+#pragma mark Reducers
+
+- (void)setUserInfoReducer:(HLSNotificationUserInfoReducer)reducer forNotificationName:(NSString *)name
+{
+    if (! name) {
+        HLSLoggerError(@"Missing notification name");
+        return;
+    }
+    
+    @synchronized(self) {
+        if (reducer) {
+            [self.nameToReducerMap setObject:[[reducer copy] autorelease] forKey:name];
+        }
+        else {
+            [self.nameToReducerMap removeObjectForKey:name];
+        }
+    }
+}
+
+#pragma mark Posting notifications
+
+- (void)postNotificationName:(NSString *)name object:(id)object userInfo:(NSDictionary *)userInfo
+{
+    if (! name) {
+        HLSLoggerError(@"Missing notification name");
+        return;
+    }
+    
+    if ([NSThread isMainThread]) {
+        [self enqueueNotificationWithName:name object:object userInfo:userInfo];
+    }
+    else {
+        // The block retains the name, the object and userInfo until the notification has been enqueued
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self enqueueNotificationWithName:name object:object userInfo:userInfo];
+        });
+    }
+}
+
+- (void)postNotificationName:(NSString *)name object:(id)object
+{
+    [self postNotificationName:name object:object userInfo:nil];
+}
+
+- (void)enqueueNotificationWithName:(NSString *)name object:(id)object userInfo:(NSDictionary *)userInfo
+{
+    HLSNotificationUserInfoReducer reducer = nil;
+    @synchronized(self) {
+        reducer = [[[self.nameToReducerMap objectForKey:name] retain] autorelease];
+    }
+    
+    [self.notificationQueue enqueueNotificationWithName:name object:object userInfo:userInfo reducer:reducer];
+    [self startDisplayLink];
+}
+
+- (void)flush
+{
+    NSArray *notifications = [self.notificationQueue dequeueAllNotifications];
+    
+    // Observers might add or remove observers when notified. Observers which have been removed in the meantime must
+    // not be notified anymore (they might have been deallocated)
+    NSArray *throttledObservers = [NSArray arrayWithArray:self.throttledObservers];
+    for (NSNotification *notification in notifications) {
+        [[NSNotificationCenter defaultCenter] postNotification:notification];
+        
+        for (HLSThrottledObserver *throttledObserver in throttledObservers) {
+            if (! [throttledObserver matchesNotificationWithName:notification.name object:notification.object]) {
+                continue;
+            }
+            
+            HLSNotificationUserInfoReducer reducer = nil;
+            @synchronized(self) {
+                reducer = [[[self.nameToReducerMap objectForKey:notification.name] retain] autorelease];
+            }
+            [throttledObserver.notificationQueue enqueueNotificationWithName:notification.name
+                                                                      object:notification.object
+                                                                    userInfo:notification.userInfo
+                                                                     reducer:reducer];
+        }
+    }
+    
+    CFTimeInterval timestamp = CACurrentMediaTime();
+    for (HLSThrottledObserver *throttledObserver in throttledObservers) {
+        if (throttledObserver.notificationQueue.empty
+                || timestamp - throttledObserver.lastNotificationTimestamp < throttledObserver.minimumInterval) {
+            continue;
+        }
+        
+        throttledObserver.lastNotificationTimestamp = timestamp;
+        for (NSNotification *notification in [throttledObserver.notificationQueue dequeueAllNotifications]) {
+            if (! [self.throttledObservers containsObject:throttledObserver]) {
+                break;
+            }
+            [throttledObserver.observer performSelector:throttledObserver.selector withObject:notification];
+        }
+    }
+}
+
+#pragma mark Observers
+
+- (void)addObserver:(id)observer
+           selector:(SEL)selector
+               name:(NSString *)name
+             object:(id)object
+    minimumInterval:(NSTimeInterval)minimumInterval
+{
+    if (! observer || ! selector) {
+        HLSLoggerError(@"Missing observer or selector");
+        return;
+    }
+    
+    HLSThrottledObserver *throttledObserver = [[[HLSThrottledObserver alloc] initWithObserver:observer
+                                                                                     selector:selector
+                                                                                         name:name
+                                                                                       object:object
+                                                                              minimumInterval:minimumInterval] autorelease];
+    [self.throttledObservers addObject:throttledObserver];
+}
+
+- (void)removeObserver:(id)observer
+{
+    [self removeObserver:observer name:nil object:nil];
+}
+
+- (void)removeObserver:(id)observer name:(NSString *)name object:(id)object
+{
+    for (HLSThrottledObserver *throttledObserver in [NSArray arrayWithArray:self.throttledObservers]) {
+        if (throttledObserver.observer != observer) {
+            continue;
+        }
+        
+        if ((name && ! [name isEqualToString:throttledObserver.name]) || (object && object != throttledObserver.object)) {
+            continue;
+        }
+        
+        [self.throttledObservers removeObject:throttledObserver];
+    }
+}
+
+#pragma mark Display link
+
+- (void)startDisplayLink
+{
+    // The display link retains its target. This is not an issue since the center is a singleton
+    if (! self.displayLink) {
+        self.displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(tick:)];
+        [self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+}
+
+- (void)tick:(CADisplayLink *)displayLink
+{
+    [self flush];
+    
+    // Keep the display link running while notifications are held back by observers with a minimum interval
+    BOOL pending = ! self.notificationQueue.empty;
+    for (HLSThrottledObserver *throttledObserver in self.throttledObservers) {
+        if (! throttledObserver.notificationQueue.empty) {
+            pending = YES;
+            break;
+        }
+    }
+    
+    if (! pending) {
+        [self.displayLink invalidate];
+        self.displayLink = nil;
+    }
+}
+
+@end
+
+#pragma mark -
+#pragma mark Functions
+
+static NSDictionary *reduceUserInfo(HLSNotificationUserInfoReducer reducer, NSDictionary *accumulatedUserInfo, NSDictionary *userInfo)
+{
+    if (reducer) {
+        return reducer(accumulatedUserInfo, userInfo);
+    }
+    
+    // By default, entries of later notifications replace those of earlier ones
+    if (! accumulatedUserInfo) {
+        return userInfo;
+    }
+    else if (! userInfo) {
+        return accumulatedUserInfo;
+    }
+    
+    NSMutableDictionary *mergedUserInfo = [NSMutableDictionary dictionaryWithDictionary:accumulatedUserInfo];
+    [mergedUserInfo addEntriesFromDictionary:userInfo];
+    return [NSDictionary dictionaryWithDictionary:mergedUserInfo];
+}
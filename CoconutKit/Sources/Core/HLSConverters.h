@@ -29,6 +29,14 @@ NSNumber *HLSUnsignedIntNumberFromString(NSString *string);
     
 }
 
+/**
+ * Convert a string into a date using the given format (Unicode date format patterns). The following common formats
+ * are parsed directly (and much faster than with a date formatter) when the string strictly matches them:
+ *   - yyyy-MM-dd'T'HH:mm:ssZ, yyyy-MM-dd'T'HH:mm:ssZZZ (ISO 8601, e.g. 2012-10-14T17:32:05+0200)
+ *   - yyyy-MM-dd'T'HH:mm:ssZZZZZ (ISO 8601, e.g. 2012-10-14T17:32:05+02:00 or 2012-10-14T15:32:05Z)
+ *   - EEE, dd MMM yyyy HH:mm:ss zzz (RFC 1123 with GMT or UTC time zone and English names, e.g. Sun, 14 Oct 2012 15:32:05 GMT)
+ * Other formats and strings are parsed using a date formatter for the current locale and the default time zone
+ */
 + (NSDate *)dateFromString:(NSString *)string usingFormatString:(NSString *)formatString;
 
 + (void)convertStringValueForKey:(NSString *)sourceKey 
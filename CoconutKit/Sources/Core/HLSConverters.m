@@ -10,6 +10,27 @@
 
 #import "HLSAssert.h"
 #import "HLSLogger.h"
+#import "NSDateFormatter+HLSExtensions.h"
+
+// Fixed date formats which can be parsed without a date formatter
+typedef enum {
+    HLSFixedDateFormatEnumBegin = 0,
+    HLSFixedDateFormatNone = HLSFixedDateFormatEnumBegin,
+    HLSFixedDateFormatISO8601RFC822TimeZone,            // e.g. 2012-10-14T17:32:05+0200
+    HLSFixedDateFormatISO8601ISOTimeZone,               // e.g. 2012-10-14T17:32:05+02:00 or 2012-10-14T15:32:05Z
+    HLSFixedDateFormatRFC1123,                          // e.g. Sun, 14 Oct 2012 15:32:05 GMT
+    HLSFixedDateFormatEnumEnd,
+    HLSFixedDateFormatEnumSize = HLSFixedDateFormatEnumEnd - HLSFixedDateFormatEnumBegin
+} HLSFixedDateFormat;
+
+// Function declarations
+static HLSFixedDateFormat fixedDateFormatForFormatString(NSString *formatString);
+static BOOL scanDigits(const char **pCursor, NSUInteger numberOfDigits, NSInteger *pValue);
+static BOOL scanCharacter(const char **pCursor, char character);
+static BOOL scanISO8601Date(const char *cursor, HLSFixedDateFormat fixedDateFormat, NSTimeInterval *pTimeInterval);
+static BOOL scanRFC1123Date(const char *cursor, NSTimeInterval *pTimeInterval);
+static BOOL timeIntervalSince1970ForComponents(NSInteger year, NSInteger month, NSInteger day, NSInteger hour, NSInteger minute,
+                                               NSInteger second, NSInteger timeZoneOffset, NSTimeInterval *pTimeInterval);
 
 NSString *HLSStringFromBool(BOOL yesOrNo)
 {
@@ -98,11 +119,199 @@ NSNumber *HLSUnsignedIntNumberFromString(NSString *string)
         return nil;
     }
     
-    NSNumberFormatter *formatter = [[[NSNumberFormatter alloc] init] autorelease];
-    [formatter setNumberStyle:NSNumberFormatterDecimalStyle];
+    // Plain digit strings (the most common case) are parsed directly
+    const char *cString = [string UTF8String];
+    NSUInteger length = strlen(cString);
+    if (length != 0 && length <= 19 && strspn(cString, "0123456789") == length) {
+        return [NSNumber numberWithUnsignedLongLong:strtoull(cString, NULL, 10)];
+    }
+    
+    // Number formatters are expensive to create and not thread-safe. Use one per thread
+    static NSString * const kNumberFormatterThreadLocalStorageKey = @"HLSConvertersNumberFormatter";
+    NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+    NSNumberFormatter *formatter = [threadDictionary objectForKey:kNumberFormatterThreadLocalStorageKey];
+    if (! formatter) {
+        formatter = [[[NSNumberFormatter alloc] init] autorelease];
+        [formatter setNumberStyle:NSNumberFormatterDecimalStyle];
+        [threadDictionary setObject:formatter forKey:kNumberFormatterThreadLocalStorageKey];
+    }
     return [formatter numberFromString:string];
 }
 
+#pragma mark Fixed format date parsing
+
+static HLSFixedDateFormat fixedDateFormatForFormatString(NSString *formatString)
+{
+    if ([formatString isEqualToString:@"yyyy-MM-dd'T'HH:mm:ssZ"] || [formatString isEqualToString:@"yyyy-MM-dd'T'HH:mm:ssZZZ"]) {
+        return HLSFixedDateFormatISO8601RFC822TimeZone;
+    }
+    else if ([formatString isEqualToString:@"yyyy-MM-dd'T'HH:mm:ssZZZZZ"]) {
+        return HLSFixedDateFormatISO8601ISOTimeZone;
+    }
+    else if ([formatString isEqualToString:@"EEE, dd MMM yyyy HH:mm:ss zzz"]) {
+        return HLSFixedDateFormatRFC1123;
+    }
+    else {
+        return HLSFixedDateFormatNone;
+    }
+}
+
+static BOOL scanDigits(const char **pCursor, NSUInteger numberOfDigits, NSInteger *pValue)
+{
+    NSInteger value = 0;
+    for (NSUInteger i = 0; i < numberOfDigits; ++i) {
+        char character = (*pCursor)[i];
+        if (character < '0' || character > '9') {
+            return NO;
+        }
+        value = 10 * value + (character - '0');
+    }
+    
+    *pCursor += numberOfDigits;
+    *pValue = value;
+    return YES;
+}
+
+static BOOL scanCharacter(const char **pCursor, char character)
+{
+    if (**pCursor != character) {
+        return NO;
+    }
+    
+    ++*pCursor;
+    return YES;
+}
+
+static BOOL scanISO8601Date(const char *cursor, HLSFixedDateFormat fixedDateFormat, NSTimeInterval *pTimeInterval)
+{
+    NSInteger year, month, day, hour, minute, second;
+    if (! scanDigits(&cursor, 4, &year) || ! scanCharacter(&cursor, '-')
+            || ! scanDigits(&cursor, 2, &month) || ! scanCharacter(&cursor, '-')
+            || ! scanDigits(&cursor, 2, &day) || ! scanCharacter(&cursor, 'T')
+            || ! scanDigits(&cursor, 2, &hour) || ! scanCharacter(&cursor, ':')
+            || ! scanDigits(&cursor, 2, &minute) || ! scanCharacter(&cursor, ':')
+            || ! scanDigits(&cursor, 2, &second)) {
+        return NO;
+    }
+    
+    NSInteger timeZoneOffset = 0;
+    if (fixedDateFormat == HLSFixedDateFormatISO8601ISOTimeZone && scanCharacter(&cursor, 'Z')) {
+        timeZoneOffset = 0;
+    }
+    else {
+        NSInteger sign = 0;
+        if (scanCharacter(&cursor, '+')) {
+            sign = 1;
+        }
+        else if (scanCharacter(&cursor, '-')) {
+            sign = -1;
+        }
+        else {
+            return NO;
+        }
+        
+        NSInteger timeZoneHours, timeZoneMinutes;
+        if (! scanDigits(&cursor, 2, &timeZoneHours)
+                || (fixedDateFormat == HLSFixedDateFormatISO8601ISOTimeZone && ! scanCharacter(&cursor, ':'))
+                || ! scanDigits(&cursor, 2, &timeZoneMinutes)
+                || timeZoneHours > 23 || timeZoneMinutes > 59) {
+            return NO;
+        }
+        timeZoneOffset = sign * (timeZoneHours * 3600 + timeZoneMinutes * 60);
+    }
+    
+    // Trailing characters: Let the formatter decide
+    if (*cursor != '\0') {
+        return NO;
+    }
+    
+    return timeIntervalSince1970ForComponents(year, month, day, hour, minute, second, timeZoneOffset, pTimeInterval);
+}
+
+static BOOL scanRFC1123Date(const char *cursor, NSTimeInterval *pTimeInterval)
+{
+    // The day name is not checked against the date (as a formatter does not either)
+    static const char *s_dayNames[] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
+    static const char *s_monthNames[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    
+    BOOL dayNameFound = NO;
+    for (NSUInteger i = 0; i < sizeof(s_dayNames) / sizeof(s_dayNames[0]); ++i) {
+        if (strncmp(cursor, s_dayNames[i], 3) == 0) {
+            dayNameFound = YES;
+            break;
+        }
+    }
+    if (! dayNameFound) {
+        return NO;
+    }
+    cursor += 3;
+    
+    NSInteger day;
+    if (! scanCharacter(&cursor, ',') || ! scanCharacter(&cursor, ' ')
+            || ! scanDigits(&cursor, 2, &day) || ! scanCharacter(&cursor, ' ')) {
+        return NO;
+    }
+    
+    NSInteger month = 0;
+    for (NSUInteger i = 0; i < sizeof(s_monthNames) / sizeof(s_monthNames[0]); ++i) {
+        if (strncmp(cursor, s_monthNames[i], 3) == 0) {
+            month = i + 1;
+            break;
+        }
+    }
+    if (month == 0) {
+        return NO;
+    }
+    cursor += 3;
+    
+    NSInteger year, hour, minute, second;
+    if (! scanCharacter(&cursor, ' ')
+            || ! scanDigits(&cursor, 4, &year) || ! scanCharacter(&cursor, ' ')
+            || ! scanDigits(&cursor, 2, &hour) || ! scanCharacter(&cursor, ':')
+            || ! scanDigits(&cursor, 2, &minute) || ! scanCharacter(&cursor, ':')
+            || ! scanDigits(&cursor, 2, &second) || ! scanCharacter(&cursor, ' ')) {
+        return NO;
+    }
+    
+    // Only UTC is handled. Other time zone names are left to the formatter
+    if (strcmp(cursor, "GMT") != 0 && strcmp(cursor, "UTC") != 0) {
+        return NO;
+    }
+    
+    return timeIntervalSince1970ForComponents(year, month, day, hour, minute, second, 0, pTimeInterval);
+}
+
+/**
+ * Convert Gregorian calendar date components into a time interval since 1970. The time zone offset is given in seconds
+ * (east of UTC). Return NO if components are out of range
+ */
+static BOOL timeIntervalSince1970ForComponents(NSInteger year, NSInteger month, NSInteger day, NSInteger hour, NSInteger minute,
+                                               NSInteger second, NSInteger timeZoneOffset, NSTimeInterval *pTimeInterval)
+{
+    static const NSInteger s_daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    
+    if (month < 1 || month > 12 || hour > 23 || minute > 59 || second > 59) {
+        return NO;
+    }
+    
+    BOOL leapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    NSInteger daysInMonth = (month == 2 && leapYear) ? 29 : s_daysInMonth[month - 1];
+    if (day < 1 || day > daysInMonth) {
+        return NO;
+    }
+    
+    // Number of days since 1970-01-01 (years starting in March, so that leap days come last)
+    NSInteger shiftedYear = (month <= 2) ? year - 1 : year;
+    NSInteger era = (shiftedYear >= 0 ? shiftedYear : shiftedYear - 399) / 400;
+    NSInteger yearOfEra = shiftedYear - era * 400;
+    NSInteger dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    NSInteger dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    NSInteger days = era * 146097 + dayOfEra - 719468;
+    
+    *pTimeInterval = (NSTimeInterval)days * 86400. + hour * 3600 + minute * 60 + second - timeZoneOffset;
+    return YES;
+}
+
 @implementation HLSConverters
 
 #pragma mark Class methods
@@ -113,9 +322,19 @@ NSNumber *HLSUnsignedIntNumberFromString(NSString *string)
         return nil;
     }
     
-    NSDateFormatter *formatter = [[[NSDateFormatter alloc] init] autorelease];
-    [formatter setFormatterBehavior:NSDateFormatterBehavior10_4];
-    [formatter setDateFormat:formatString];
+    // Common fixed formats are parsed directly, which is much faster than with a date formatter
+    HLSFixedDateFormat fixedDateFormat = fixedDateFormatForFormatString(formatString);
+    if (fixedDateFormat != HLSFixedDateFormatNone) {
+        const char *cString = [string UTF8String];
+        NSTimeInterval timeInterval = 0.;
+        BOOL scanned = (fixedDateFormat == HLSFixedDateFormatRFC1123) ? scanRFC1123Date(cString, &timeInterval)
+            : scanISO8601Date(cString, fixedDateFormat, &timeInterval);
+        if (scanned) {
+            return [NSDate dateWithTimeIntervalSince1970:timeInterval];
+        }
+    }
+    
+    NSDateFormatter *formatter = [NSDateFormatter cachedDateFormatterWithFormat:formatString locale:nil timeZone:nil];
     return [formatter dateFromString:string];
 }
 
@@ -0,0 +1,75 @@
+//
+//  HLSDictionaryMapping.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 21.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskGroup.h"
+
+/**
+ * Types into which string values can be converted
+ */
+typedef enum {
+    HLSDictionaryMappingValueTypeEnumBegin = 0,
+    HLSDictionaryMappingValueTypeString = HLSDictionaryMappingValueTypeEnumBegin,       // No conversion
+    HLSDictionaryMappingValueTypeUnsignedInt,                                           // NSNumber
+    HLSDictionaryMappingValueTypeDate,                                                  // NSDate, a format string is required
+    HLSDictionaryMappingValueTypeEnumEnd,
+    HLSDictionaryMappingValueTypeEnumSize = HLSDictionaryMappingValueTypeEnumEnd - HLSDictionaryMappingValueTypeEnumBegin
+} HLSDictionaryMappingValueType;
+
+// Forward declarations
+struct HLSDictionaryMappingRule;
+
+/**
+ * A dictionary mapping describes once for all how dictionaries with string values (e.g. parsed from a web service response)
+ * must be converted into dictionaries with typed values, using the same conversions as HLSConverters. Each rule maps the
+ * string value for a source key to the converted value for a destination key. Source keys with no value or whose value
+ * cannot be converted are omitted from the resulting dictionaries.
+ *
+ * Mappings are meant to convert large arrays of dictionaries: Rules are stored in a plain C array, and the date and number
+ * formatters used are cached. A mapping can be used from several threads at the same time, but rules must not be added 
+ * while dictionaries are being converted
+ *
+ * Designated initializer: -init
+ */
+@interface HLSDictionaryMapping : NSObject {
+@private
+    struct HLSDictionaryMappingRule *m_rules;
+    NSUInteger m_nbrRules;
+}
+
+/**
+ * Convenience constructor
+ */
++ (HLSDictionaryMapping *)dictionaryMapping;
+
+/**
+ * Add a rule converting the value for the source key into a value of the given type for the destination key. The format 
+ * string is only used (and mandatory) for dates (see +[HLSConverters dateFromString:usingFormatString:])
+ */
+- (void)addRuleForSourceKey:(NSString *)sourceKey
+             destinationKey:(NSString *)destinationKey
+                  valueType:(HLSDictionaryMappingValueType)valueType
+               formatString:(NSString *)formatString;
+
+/**
+ * Convert a single dictionary
+ */
+- (NSDictionary *)dictionaryByConvertingDictionary:(NSDictionary *)dictionary;
+
+/**
+ * Convert an array of dictionaries on the calling thread, in a single pass
+ */
+- (NSArray *)dictionariesByConvertingDictionaries:(NSArray *)dictionaries;
+
+/**
+ * Return a task group converting an array of dictionaries using all processor cores available (see 
+ * HLSTaskGroup+HLSParallelEnumeration.h). Once the task group has been successfully processed, the resulting 
+ * dictionaries (in the same order as the dictionaries received) can be retrieved using -[HLSTaskGroup mappedObjects]
+ */
+- (HLSTaskGroup *)taskGroupConvertingDictionaries:(NSArray *)dictionaries;
+
+@end
@@ -0,0 +1,148 @@
+//
+//  HLSDictionaryMapping.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 21.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSDictionaryMapping.h"
+
+#import "HLSConverters.h"
+#import "HLSLogger.h"
+#import "HLSTaskGroup+HLSParallelEnumeration.h"
+
+struct HLSDictionaryMappingRule {
+    NSString *sourceKey;                        // retained
+    NSString *destinationKey;                   // retained
+    HLSDictionaryMappingValueType valueType;
+    NSString *formatString;                     // retained
+};
+
+@implementation HLSDictionaryMapping
+
+#pragma mark Class methods
+
++ (HLSDictionaryMapping *)dictionaryMapping
+{
+    return [[[[self class] alloc] init] autorelease];
+}
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < m_nbrRules; ++i) {
+        [m_rules[i].sourceKey release];
+        [m_rules[i].destinationKey release];
+        [m_rules[i].formatString release];
+    }
+    free(m_rules);
+    
+    [super dealloc];
+}
+
+#pragma mark Rules
+
+- (void)addRuleForSourceKey:(NSString *)sourceKey
+             destinationKey:(NSString *)destinationKey
+                  valueType:(HLSDictionaryMappingValueType)valueType
+               formatString:(NSString *)formatString
+{
+    if (! sourceKey || ! destinationKey) {
+        HLSLoggerError(@"Missing source or destination key");
+        return;
+    }
+    
+    if (valueType == HLSDictionaryMappingValueTypeDate && ! formatString) {
+        HLSLoggerError(@"A format string is required for dates");
+        return;
+    }
+    
+    m_rules = realloc(m_rules, (m_nbrRules + 1) * sizeof(struct HLSDictionaryMappingRule));
+    m_rules[m_nbrRules].sourceKey = [sourceKey copy];
+    m_rules[m_nbrRules].destinationKey = [destinationKey copy];
+    m_rules[m_nbrRules].valueType = valueType;
+    m_rules[m_nbrRules].formatString = [formatString copy];
+    ++m_nbrRules;
+}
+
+#pragma mark Converting dictionaries
+
+- (NSDictionary *)dictionaryByConvertingDictionary:(NSDictionary *)dictionary
+{
+    NSMutableDictionary *convertedDictionary = [NSMutableDictionary dictionaryWithCapacity:m_nbrRules];
+    for (NSUInteger i = 0; i < m_nbrRules; ++i) {
+        struct HLSDictionaryMappingRule *rule = &m_rules[i];
+        NSString *stringValue = [dictionary objectForKey:rule->sourceKey];
+        if (! [stringValue isKindOfClass:[NSString class]]) {
+            continue;
+        }
+        
+        id value = nil;
+        switch (rule->valueType) {
+            case HLSDictionaryMappingValueTypeString: {
+                value = stringValue;
+                break;
+            }
+                
+            case HLSDictionaryMappingValueTypeUnsignedInt: {
+                value = HLSUnsignedIntNumberFromString(stringValue);
+                break;
+            }
+                
+            case HLSDictionaryMappingValueTypeDate: {
+                value = [HLSConverters dateFromString:stringValue usingFormatString:rule->formatString];
+                break;
+            }
+                
+            default: {
+                HLSLoggerError(@"Unknown value type");
+                break;
+            }
+        }
+        
+        if (value) {
+            [convertedDictionary setObject:value forKey:rule->destinationKey];
+        }
+    }
+    return [NSDictionary dictionaryWithDictionary:convertedDictionary];
+}
+
+- (NSArray *)dictionariesByConvertingDictionaries:(NSArray *)dictionaries
+{
+    NSMutableArray *convertedDictionaries = [NSMutableArray arrayWithCapacity:[dictionaries count]];
+    for (NSDictionary *dictionary in dictionaries) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        [convertedDictionaries addObject:[self dictionaryByConvertingDictionary:dictionary]];
+        [pool drain];
+    }
+    return [NSArray arrayWithArray:convertedDictionaries];
+}
+
+- (HLSTaskGroup *)taskGroupConvertingDictionaries:(NSArray *)dictionaries
+{
+    // The mapping must survive until the task group has been processed
+    HLSDictionaryMapping *mapping = [[self retain] autorelease];
+    return [HLSTaskGroup taskGroupMappingObjects:dictionaries usingBlock:^id (id object, NSUInteger index) {
+        return [mapping dictionaryByConvertingDictionary:object];
+    }];
+}
+
+#pragma mark Description
+
+- (NSString *)description
+{
+    NSMutableArray *ruleDescriptions = [NSMutableArray arrayWithCapacity:m_nbrRules];
+    for (NSUInteger i = 0; i < m_nbrRules; ++i) {
+        [ruleDescriptions addObject:[NSString stringWithFormat:@"%@ -> %@ (%d)", m_rules[i].sourceKey, m_rules[i].destinationKey,
+                                     m_rules[i].valueType]];
+    }
+    
+    return [NSString stringWithFormat:@"<%@: %p; rules: %@>",
+            [self class],
+            self,
+            ruleDescriptions];
+}
+
+@end
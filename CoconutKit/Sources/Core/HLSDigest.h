@@ -0,0 +1,137 @@
+//
+//  HLSDigest.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 24.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFileManager.h"
+
+/**
+ * Hash algorithms
+ */
+typedef enum {
+    HLSDigestAlgorithmEnumBegin = 0,
+    HLSDigestAlgorithmMD2 = HLSDigestAlgorithmEnumBegin,
+    HLSDigestAlgorithmMD4,
+    HLSDigestAlgorithmMD5,
+    HLSDigestAlgorithmSHA1,
+    HLSDigestAlgorithmSHA224,
+    HLSDigestAlgorithmSHA256,
+    HLSDigestAlgorithmSHA384,
+    HLSDigestAlgorithmSHA512,
+    HLSDigestAlgorithmEnumEnd,
+    HLSDigestAlgorithmEnumSize = HLSDigestAlgorithmEnumEnd - HLSDigestAlgorithmEnumBegin
+} HLSDigestAlgorithm;
+
+/**
+ * Calculate a fast non-cryptographic 64-bit hash of some bytes (xxHash64 algorithm), for the given seed. Many times
+ * faster than the cryptographic hashes, and designed to distribute keys evenly, this hash is meant to be used for 
+ * in-memory keys (e.g. cache keys). Since collisions can be forged, it must not be used when the content cannot be
+ * trusted, nor when a collision would have security implications. The hash is the same on all platforms
+ */
+uint64_t HLSFastHash(const void *bytes, NSUInteger length, uint64_t seed);
+
+// Forward declarations
+union HLSDigestContext;
+
+/**
+ * A digest calculates a hash incrementally: Data is fed in as many pieces as needed, and the hash is obtained once all
+ * data has been supplied. Unlike the hash methods of the NSData and NSString categories, which need the whole content
+ * in memory at once, digests can hash files and streams of arbitrary size using a constant amount of memory.
+ *
+ * Once the hash has been obtained, the digest is finalized and cannot be updated anymore. A digest must not be updated
+ * from several threads at the same time
+ *
+ * Designated initializer: -initWithAlgorithm:
+ */
+@interface HLSDigest : NSObject {
+@private
+    HLSDigestAlgorithm m_algorithm;
+    union HLSDigestContext *m_context;
+    NSData *m_digestData;
+}
+
+/**
+ * Convenience constructor
+ */
++ (HLSDigest *)digestWithAlgorithm:(HLSDigestAlgorithm)algorithm;
+
+/**
+ * Return the length of the hashes (in bytes) calculated by an algorithm. This is at most CC_SHA512_DIGEST_LENGTH
+ */
++ (NSUInteger)digestLengthForAlgorithm:(HLSDigestAlgorithm)algorithm;
+
+/**
+ * Calculate the hash of some bytes and write it into the buffer given as first parameter, which must be at least
+ * +digestLengthForAlgorithm: bytes long. No object is created
+ */
++ (void)getDigest:(unsigned char *)md forBytes:(const void *)bytes length:(NSUInteger)length algorithm:(HLSDigestAlgorithm)algorithm;
+
+/**
+ * Return the hash of some data or of a string (UTF-8), as raw bytes or as an hexadecimal lowercase string. These methods
+ * do not create any digest object and are meant to be used for hashing short contents at a high rate (e.g. cache keys)
+ */
++ (NSData *)digestDataForData:(NSData *)data algorithm:(HLSDigestAlgorithm)algorithm;
++ (NSString *)hexDigestForData:(NSData *)data algorithm:(HLSDigestAlgorithm)algorithm;
++ (NSData *)digestDataForString:(NSString *)string algorithm:(HLSDigestAlgorithm)algorithm;
++ (NSString *)hexDigestForString:(NSString *)string algorithm:(HLSDigestAlgorithm)algorithm;
+
+/**
+ * Return the hash (hexadecimal, lowercase) of the file at the given location, read using the specified file manager
+ * (the default one if nil). Return nil if the file could not be read
+ */
++ (NSString *)hexDigestForFileAtPath:(NSString *)path
+                           algorithm:(HLSDigestAlgorithm)algorithm
+                         fileManager:(HLSFileManager *)fileManager
+                               error:(NSError **)pError;
+
+/**
+ * Create a digest for the given algorithm
+ */
+- (id)initWithAlgorithm:(HLSDigestAlgorithm)algorithm;
+
+/**
+ * The algorithm used
+ */
+@property (nonatomic, readonly, assign) HLSDigestAlgorithm algorithm;
+
+/**
+ * Add bytes, data or a string (UTF-8) to the content being hashed. Strings are converted by pieces and never copied as
+ * a whole
+ */
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length;
+- (void)updateWithData:(NSData *)data;
+- (void)updateWithString:(NSString *)string;
+
+/**
+ * Add the content of the file at the given location, read using the specified file manager (the default one if nil).
+ * The file is hashed by pieces. Memory consumption remains constant if the file manager maps files into virtual memory,
+ * as HLSStandardFileManager does
+ *
+ * Return YES iff successful
+ */
+- (BOOL)updateWithContentsOfFileAtPath:(NSString *)path fileManager:(HLSFileManager *)fileManager error:(NSError **)pError;
+
+/**
+ * Add everything which can be read from a stream until its end. The stream is opened if needed, and closed if it was
+ * opened by this method
+ *
+ * Return YES iff successful
+ */
+- (BOOL)updateWithInputStream:(NSInputStream *)inputStream error:(NSError **)pError;
+
+/**
+ * Return the hash, as raw bytes or as an hexadecimal lowercase string. The first call finalizes the digest, which
+ * cannot be updated anymore
+ */
+- (NSData *)finalDigestData;
+- (NSString *)finalHexDigest;
+
+/**
+ * Return YES iff the hash has already been obtained
+ */
+@property (nonatomic, readonly, assign, getter=isFinalized) BOOL finalized;
+
+@end
@@ -0,0 +1,626 @@
+//
+//  HLSDigest.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 24.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSDigest.h"
+
+#import <CommonCrypto/CommonDigest.h>
+#import "HLSAssert.h"
+#import "HLSConverters.h"
+#import "HLSLogger.h"
+
+// Data is fed to CommonCrypto by chunks, whose length must fit into a CC_LONG. For mapped files, this also limits
+// the number of pages touched at once
+static const NSUInteger kDigestChunkLength = 1024 * 1024;
+
+// Buffer length used to read from streams and convert strings
+static const NSUInteger kDigestBufferLength = 64 * 1024;
+
+union HLSDigestContext {
+    CC_MD2_CTX md2;
+    CC_MD4_CTX md4;
+    CC_MD5_CTX md5;
+    CC_SHA1_CTX sha1;
+    CC_SHA256_CTX sha256;               // Also used for SHA-224
+    CC_SHA512_CTX sha512;               // Also used for SHA-384
+};
+
+// Function declarations
+static void digestInit(HLSDigestAlgorithm algorithm, union HLSDigestContext *context);
+static void digestUpdate(HLSDigestAlgorithm algorithm, union HLSDigestContext *context, const void *bytes, CC_LONG length);
+static void digestFinal(HLSDigestAlgorithm algorithm, union HLSDigestContext *context, unsigned char *md);
+static void digestUpdateByChunks(HLSDigestAlgorithm algorithm, union HLSDigestContext *context, const void *bytes, NSUInteger length);
+static BOOL digestUpdateWithString(HLSDigestAlgorithm algorithm, union HLSDigestContext *context, NSString *string);
+static CC_LONG digestLength(HLSDigestAlgorithm algorithm);
+static NSString *hexStringFromBytes(const unsigned char *bytes, NSUInteger length);
+static uint64_t fastHashRead64(const uint8_t *bytes);
+static uint32_t fastHashRead32(const uint8_t *bytes);
+static uint64_t fastHashRound(uint64_t accumulator, uint64_t input);
+static uint64_t fastHashMergeRound(uint64_t accumulator, uint64_t value);
+
+@interface HLSDigest ()
+
+@property (nonatomic, retain) NSData *digestData;
+
+@end
+
+@implementation HLSDigest
+
+#pragma mark Class methods
+
++ (HLSDigest *)digestWithAlgorithm:(HLSDigestAlgorithm)algorithm
+{
+    return [[[[self class] alloc] initWithAlgorithm:algorithm] autorelease];
+}
+
++ (NSUInteger)digestLengthForAlgorithm:(HLSDigestAlgorithm)algorithm
+{
+    return digestLength(algorithm);
+}
+
++ (void)getDigest:(unsigned char *)md forBytes:(const void *)bytes length:(NSUInteger)length algorithm:(HLSDigestAlgorithm)algorithm
+{
+    // One-shot calculations use a context on the stack, no object is created
+    union HLSDigestContext context;
+    digestInit(algorithm, &context);
+    digestUpdateByChunks(algorithm, &context, bytes, length);
+    digestFinal(algorithm, &context, md);
+}
+
++ (NSData *)digestDataForData:(NSData *)data algorithm:(HLSDigestAlgorithm)algorithm
+{
+    unsigned char md[CC_SHA512_DIGEST_LENGTH];
+    [HLSDigest getDigest:md forBytes:[data bytes] length:[data length] algorithm:algorithm];
+    return [NSData dataWithBytes:md length:digestLength(algorithm)];
+}
+
++ (NSString *)hexDigestForData:(NSData *)data algorithm:(HLSDigestAlgorithm)algorithm
+{
+    unsigned char md[CC_SHA512_DIGEST_LENGTH];
+    [HLSDigest getDigest:md forBytes:[data bytes] length:[data length] algorithm:algorithm];
+    return hexStringFromBytes(md, digestLength(algorithm));
+}
+
++ (NSData *)digestDataForString:(NSString *)string algorithm:(HLSDigestAlgorithm)algorithm
+{
+    union HLSDigestContext context;
+    digestInit(algorithm, &context);
+    digestUpdateWithString(algorithm, &context, string);
+    
+    unsigned char md[CC_SHA512_DIGEST_LENGTH];
+    digestFinal(algorithm, &context, md);
+    return [NSData dataWithBytes:md length:digestLength(algorithm)];
+}
+
++ (NSString *)hexDigestForString:(NSString *)string algorithm:(HLSDigestAlgorithm)algorithm
+{
+    union HLSDigestContext context;
+    digestInit(algorithm, &context);
+    digestUpdateWithString(algorithm, &context, string);
+    
+    unsigned char md[CC_SHA512_DIGEST_LENGTH];
+    digestFinal(algorithm, &context, md);
+    return hexStringFromBytes(md, digestLength(algorithm));
+}
+
++ (NSString *)hexDigestForFileAtPath:(NSString *)path
+                           algorithm:(HLSDigestAlgorithm)algorithm
+                         fileManager:(HLSFileManager *)fileManager
+                               error:(NSError **)pError
+{
+    HLSDigest *digest = [HLSDigest digestWithAlgorithm:algorithm];
+    if (! [digest updateWithContentsOfFileAtPath:path fileManager:fileManager error:pError]) {
+        return nil;
+    }
+    return [digest finalHexDigest];
+}
+
+#pragma mark Object creation and destruction
+
+- (id)initWithAlgorithm:(HLSDigestAlgorithm)algorithm
+{
+    if ((self = [super init])) {
+        if (algorithm < HLSDigestAlgorithmEnumBegin || algorithm >= HLSDigestAlgorithmEnumEnd) {
+            HLSLoggerError(@"Unknown digest algorithm");
+            [self release];
+            return nil;
+        }
+        
+        m_algorithm = algorithm;
+        m_context = malloc(sizeof(union HLSDigestContext));
+        digestInit(algorithm, m_context);
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    free(m_context);
+    self.digestData = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize algorithm = m_algorithm;
+
+@synthesize digestData = m_digestData;
+
+- (BOOL)isFinalized
+{
+    return self.digestData != nil;
+}
+
+#pragma mark Updating the digest
+
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length
+{
+    if (self.finalized) {
+        HLSLoggerError(@"The digest has already been finalized and cannot be updated anymore");
+        return;
+    }
+    
+    digestUpdateByChunks(m_algorithm, m_context, bytes, length);
+}
+
+- (void)updateWithData:(NSData *)data
+{
+    [self updateWithBytes:[data bytes] length:[data length]];
+}
+
+- (void)updateWithString:(NSString *)string
+{
+    if (self.finalized) {
+        HLSLoggerError(@"The digest has already been finalized and cannot be updated anymore");
+        return;
+    }
+    
+    digestUpdateWithString(m_algorithm, m_context, string);
+}
+
+- (BOOL)updateWithContentsOfFileAtPath:(NSString *)path fileManager:(HLSFileManager *)fileManager error:(NSError **)pError
+{
+    if (! fileManager) {
+        fileManager = [HLSFileManager defaultManager];
+    }
+    
+    NSData *data = [fileManager contentsOfFileAtPath:path error:pError];
+    if (! data) {
+        return NO;
+    }
+    
+    [self updateWithData:data];
+    return YES;
+}
+
+- (BOOL)updateWithInputStream:(NSInputStream *)inputStream error:(NSError **)pError
+{
+    BOOL opened = NO;
+    if ([inputStream streamStatus] == NSStreamStatusNotOpen) {
+        [inputStream open];
+        opened = YES;
+    }
+    
+    BOOL success = YES;
+    uint8_t buffer[kDigestBufferLength];
+    while (YES) {
+        NSInteger readLength = [inputStream read:buffer maxLength:sizeof(buffer)];
+        if (readLength < 0) {
+            if (pError) {
+                *pError = [inputStream streamError];
+            }
+            success = NO;
+            break;
+        }
+        else if (readLength == 0) {
+            break;
+        }
+        
+        [self updateWithBytes:buffer length:(NSUInteger)readLength];
+    }
+    
+    if (opened) {
+        [inputStream close];
+    }
+    
+    return success;
+}
+
+#pragma mark Obtaining the hash
+
+- (NSData *)finalDigestData
+{
+    if (! self.digestData) {
+        NSMutableData *digestData = [NSMutableData dataWithLength:digestLength(m_algorithm)];
+        digestFinal(m_algorithm, m_context, [digestData mutableBytes]);
+        self.digestData = [NSData dataWithData:digestData];
+    }
+    return self.digestData;
+}
+
+- (NSString *)finalHexDigest
+{
+    NSData *digestData = [self finalDigestData];
+    return hexStringFromBytes([digestData bytes], [digestData length]);
+}
+
+#pragma mark Description
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p; algorithm: %d; finalized: %@>",
+            [self class],
+            self,
+            m_algorithm,
+            HLSStringFromBool(self.finalized)];
+}
+
+@end
+
+#pragma mark Fast hash functions
+
+// xxHash64 constants
+static const uint64_t kFastHashPrime1 = 11400714785074694791ULL;
+static const uint64_t kFastHashPrime2 = 14029467366897019727ULL;
+static const uint64_t kFastHashPrime3 = 1609587929392839161ULL;
+static const uint64_t kFastHashPrime4 = 9650029242287828579ULL;
+static const uint64_t kFastHashPrime5 = 2870177450012600261ULL;
+
+#define HLSFastHashRotateLeft(x, r)         (((x) << (r)) | ((x) >> (64 - (r))))
+
+uint64_t HLSFastHash(const void *bytes, NSUInteger length, uint64_t seed)
+{
+    const uint8_t *p = (const uint8_t *)bytes;
+    const uint8_t *end = p + length;
+    uint64_t hash = 0;
+    
+    // Process 32-byte stripes with four independent accumulators
+    if (length >= 32) {
+        const uint8_t *limit = end - 32;
+        uint64_t v1 = seed + kFastHashPrime1 + kFastHashPrime2;
+        uint64_t v2 = seed + kFastHashPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kFastHashPrime1;
+        do {
+            v1 = fastHashRound(v1, fastHashRead64(p));
+            v2 = fastHashRound(v2, fastHashRead64(p + 8));
+            v3 = fastHashRound(v3, fastHashRead64(p + 16));
+            v4 = fastHashRound(v4, fastHashRead64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        
+        hash = HLSFastHashRotateLeft(v1, 1) + HLSFastHashRotateLeft(v2, 7) + HLSFastHashRotateLeft(v3, 12) + HLSFastHashRotateLeft(v4, 18);
+        hash = fastHashMergeRound(hash, v1);
+        hash = fastHashMergeRound(hash, v2);
+        hash = fastHashMergeRound(hash, v3);
+        hash = fastHashMergeRound(hash, v4);
+    }
+    else {
+        hash = seed + kFastHashPrime5;
+    }
+    
+    hash += (uint64_t)length;
+    
+    // Remaining bytes
+    while (p + 8 <= end) {
+        hash ^= fastHashRound(0, fastHashRead64(p));
+        hash = HLSFastHashRotateLeft(hash, 27) * kFastHashPrime1 + kFastHashPrime4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        hash ^= (uint64_t)fastHashRead32(p) * kFastHashPrime1;
+        hash = HLSFastHashRotateLeft(hash, 23) * kFastHashPrime2 + kFastHashPrime3;
+        p += 4;
+    }
+    while (p < end) {
+        hash ^= (*p) * kFastHashPrime5;
+        hash = HLSFastHashRotateLeft(hash, 11) * kFastHashPrime1;
+        ++p;
+    }
+    
+    // Final avalanche
+    hash ^= hash >> 33;
+    hash *= kFastHashPrime2;
+    hash ^= hash >> 29;
+    hash *= kFastHashPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// Unaligned little-endian reads
+static uint64_t fastHashRead64(const uint8_t *bytes)
+{
+    uint64_t value = 0;
+    memcpy(&value, bytes, sizeof(uint64_t));
+    return CFSwapInt64LittleToHost(value);
+}
+
+static uint32_t fastHashRead32(const uint8_t *bytes)
+{
+    uint32_t value = 0;
+    memcpy(&value, bytes, sizeof(uint32_t));
+    return CFSwapInt32LittleToHost(value);
+}
+
+static uint64_t fastHashRound(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * kFastHashPrime2;
+    accumulator = HLSFastHashRotateLeft(accumulator, 31);
+    return accumulator * kFastHashPrime1;
+}
+
+static uint64_t fastHashMergeRound(uint64_t accumulator, uint64_t value)
+{
+    accumulator ^= fastHashRound(0, value);
+    return accumulator * kFastHashPrime1 + kFastHashPrime4;
+}
+
+#pragma mark Digest functions
+
+static void digestInit(HLSDigestAlgorithm algorithm, union HLSDigestContext *context)
+{
+    switch (algorithm) {
+        case HLSDigestAlgorithmMD2: {
+            CC_MD2_Init(&context->md2);
+            break;
+        }
+            
+        case HLSDigestAlgorithmMD4: {
+            CC_MD4_Init(&context->md4);
+            break;
+        }
+            
+        case HLSDigestAlgorithmMD5: {
+            CC_MD5_Init(&context->md5);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA1: {
+            CC_SHA1_Init(&context->sha1);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA224: {
+            CC_SHA224_Init(&context->sha256);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA256: {
+            CC_SHA256_Init(&context->sha256);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA384: {
+            CC_SHA384_Init(&context->sha512);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA512: {
+            CC_SHA512_Init(&context->sha512);
+            break;
+        }
+            
+        default: {
+            HLSLoggerError(@"Unknown digest algorithm");
+            break;
+        }
+    }
+}
+
+static void digestUpdate(HLSDigestAlgorithm algorithm, union HLSDigestContext *context, const void *bytes, CC_LONG length)
+{
+    switch (algorithm) {
+        case HLSDigestAlgorithmMD2: {
+            CC_MD2_Update(&context->md2, bytes, length);
+            break;
+        }
+            
+        case HLSDigestAlgorithmMD4: {
+            CC_MD4_Update(&context->md4, bytes, length);
+            break;
+        }
+            
+        case HLSDigestAlgorithmMD5: {
+            CC_MD5_Update(&context->md5, bytes, length);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA1: {
+            CC_SHA1_Update(&context->sha1, bytes, length);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA224: {
+            CC_SHA224_Update(&context->sha256, bytes, length);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA256: {
+            CC_SHA256_Update(&context->sha256, bytes, length);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA384: {
+            CC_SHA384_Update(&context->sha512, bytes, length);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA512: {
+            CC_SHA512_Update(&context->sha512, bytes, length);
+            break;
+        }
+            
+        default: {
+            HLSLoggerError(@"Unknown digest algorithm");
+            break;
+        }
+    }
+}
+
+static void digestFinal(HLSDigestAlgorithm algorithm, union HLSDigestContext *context, unsigned char *md)
+{
+    switch (algorithm) {
+        case HLSDigestAlgorithmMD2: {
+            CC_MD2_Final(md, &context->md2);
+            break;
+        }
+            
+        case HLSDigestAlgorithmMD4: {
+            CC_MD4_Final(md, &context->md4);
+            break;
+        }
+            
+        case HLSDigestAlgorithmMD5: {
+            CC_MD5_Final(md, &context->md5);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA1: {
+            CC_SHA1_Final(md, &context->sha1);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA224: {
+            CC_SHA224_Final(md, &context->sha256);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA256: {
+            CC_SHA256_Final(md, &context->sha256);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA384: {
+            CC_SHA384_Final(md, &context->sha512);
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA512: {
+            CC_SHA512_Final(md, &context->sha512);
+            break;
+        }
+            
+        default: {
+            HLSLoggerError(@"Unknown digest algorithm");
+            break;
+        }
+    }
+}
+
+static void digestUpdateByChunks(HLSDigestAlgorithm algorithm, union HLSDigestContext *context, const void *bytes, NSUInteger length)
+{
+    const unsigned char *chunk = bytes;
+    while (length != 0) {
+        NSUInteger chunkLength = MIN(length, kDigestChunkLength);
+        digestUpdate(algorithm, context, chunk, (CC_LONG)chunkLength);
+        chunk += chunkLength;
+        length -= chunkLength;
+    }
+}
+
+static BOOL digestUpdateWithString(HLSDigestAlgorithm algorithm, union HLSDigestContext *context, NSString *string)
+{
+    // ASCII strings (e.g. most cache keys) can often be accessed directly, in which case their length in bytes is
+    // their number of characters
+    const char *asciiString = CFStringGetCStringPtr((CFStringRef)string, kCFStringEncodingUTF8);
+    if (asciiString) {
+        digestUpdateByChunks(algorithm, context, asciiString, [string length]);
+        return YES;
+    }
+    
+    // Convert by pieces into a buffer instead of creating a UTF-8 copy of the whole string. The conversion never
+    // splits a composed character sequence, and the buffer is large enough for any of them to fit
+    unsigned char buffer[kDigestBufferLength];
+    NSRange remainingRange = NSMakeRange(0, [string length]);
+    while (remainingRange.length != 0) {
+        NSUInteger usedLength = 0;
+        if (! [string getBytes:buffer
+                     maxLength:sizeof(buffer)
+                    usedLength:&usedLength
+                      encoding:NSUTF8StringEncoding
+                       options:0
+                         range:remainingRange
+                remainingRange:&remainingRange]) {
+            HLSLoggerError(@"The string could not be converted to UTF-8");
+            return NO;
+        }
+        digestUpdate(algorithm, context, buffer, (CC_LONG)usedLength);
+    }
+    return YES;
+}
+
+static CC_LONG digestLength(HLSDigestAlgorithm algorithm)
+{
+    switch (algorithm) {
+        case HLSDigestAlgorithmMD2: {
+            return CC_MD2_DIGEST_LENGTH;
+            break;
+        }
+            
+        case HLSDigestAlgorithmMD4: {
+            return CC_MD4_DIGEST_LENGTH;
+            break;
+        }
+            
+        case HLSDigestAlgorithmMD5: {
+            return CC_MD5_DIGEST_LENGTH;
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA1: {
+            return CC_SHA1_DIGEST_LENGTH;
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA224: {
+            return CC_SHA224_DIGEST_LENGTH;
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA256: {
+            return CC_SHA256_DIGEST_LENGTH;
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA384: {
+            return CC_SHA384_DIGEST_LENGTH;
+            break;
+        }
+            
+        case HLSDigestAlgorithmSHA512: {
+            return CC_SHA512_DIGEST_LENGTH;
+            break;
+        }
+            
+        default: {
+            HLSLoggerError(@"Unknown digest algorithm");
+            return 0;
+            break;
+        }
+    }
+}
+
+static NSString *hexStringFromBytes(const unsigned char *bytes, NSUInteger length)
+{
+    static const char kHexDigits[] = "0123456789abcdef";
+    
+    // Table-driven conversion into a stack buffer, from which a single string is created
+    char hexCharacters[2 * length];             // C99
+    for (NSUInteger i = 0; i < length; ++i) {
+        hexCharacters[2 * i] = kHexDigits[bytes[i] >> 4];
+        hexCharacters[2 * i + 1] = kHexDigits[bytes[i] & 0x0f];
+    }
+    
+    return [[[NSString alloc] initWithBytes:hexCharacters length:sizeof(hexCharacters) encoding:NSASCIIStringEncoding] autorelease];
+}
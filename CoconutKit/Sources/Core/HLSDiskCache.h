@@ -0,0 +1,102 @@
+//
+//  HLSDiskCache.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 03.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFileManager.h"
+
+/**
+ * Block called when data has been retrieved from a disk cache. The data is nil if none is stored for the key
+ */
+typedef void (^HLSDiskCacheCompletionBlock)(NSData *data);
+
+/**
+ * A cache storing data in files of a directory, bounded by a total number of bytes and by the age of its entries. When
+ * the byte limit is exceeded, least recently used entries are evicted first. Entries older than the age limit (since
+ * they were last stored or read) are discarded.
+ *
+ * Each entry is stored in a file whose name is the SHA-1 digest of its key. The cache keeps an index of the entries 
+ * (sizes and access dates) in memory. It is built from the contents of the directory when the cache is first used, 
+ * ordering existing entries by modification date. All file operations are performed in the background using the
+ * asynchronous methods of the file manager, in the order in which they have been requested.
+ *
+ * The directory should be used by a single disk cache. All methods can be called from any thread
+ *
+ * Designated initializer: -initWithDirectoryPath:fileManager:
+ */
+@interface HLSDiskCache : NSObject {
+@private
+    NSString *m_directoryPath;
+    HLSFileManager *m_fileManager;
+    unsigned long long m_totalCostLimit;
+    NSTimeInterval m_ageLimit;
+    NSMutableDictionary *m_fileNameToEntryMap;
+    NSMutableArray *m_fileNames;                                // Least recently used entries first
+    unsigned long long m_totalCost;
+    BOOL m_indexLoaded;
+    dispatch_queue_t m_queue;
+}
+
+/**
+ * Create a disk cache storing its entries in the specified directory (created if needed), using a file manager (the
+ * default one if nil)
+ */
+- (id)initWithDirectoryPath:(NSString *)directoryPath fileManager:(HLSFileManager *)fileManager;
+
+/**
+ * The directory in which entries are stored
+ */
+@property (nonatomic, readonly, retain) NSString *directoryPath;
+
+/**
+ * The file manager used
+ */
+@property (nonatomic, readonly, retain) HLSFileManager *fileManager;
+
+/**
+ * The maximum number of bytes occupied by the entries. Entries larger than this limit are not stored. If the limit is
+ * decreased, least recently used entries are evicted until the content of the cache fits into it
+ *
+ * The default value is 50 MB
+ */
+@property (nonatomic, assign) unsigned long long totalCostLimit;
+
+/**
+ * The maximum age of the entries (since they were last stored or read), 0 for no limit
+ *
+ * The default value is 0
+ */
+@property (nonatomic, assign) NSTimeInterval ageLimit;
+
+/**
+ * Retrieve the data stored for a key. The completion block is called on the specified queue (the main queue if NULL). 
+ * The entry is marked as most recently used
+ */
+- (void)dataForKey:(NSString *)key completionQueue:(dispatch_queue_t)completionQueue completionBlock:(HLSDiskCacheCompletionBlock)completionBlock;
+
+/**
+ * Store data for a key, replacing any data already stored for it. Least recently used entries are evicted if needed.
+ * Setting nil removes the data stored for the key
+ */
+- (void)setData:(NSData *)data forKey:(NSString *)key;
+
+/**
+ * Remove the data stored for a key
+ */
+- (void)removeDataForKey:(NSString *)key;
+
+/**
+ * Remove all entries
+ */
+- (void)removeAllData;
+
+/**
+ * The number of bytes occupied by the entries, once all operations requested so far have been applied to the index
+ * (the caller is blocked until then)
+ */
+- (unsigned long long)totalCost;
+
+@end
@@ -0,0 +1,382 @@
+//
+//  HLSDiskCache.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 03.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSDiskCache.h"
+
+#import "HLSAssert.h"
+#import "HLSDigest.h"
+#import "HLSLogger.h"
+
+static const unsigned long long kDiskCacheDefaultTotalCostLimit = 50 * 1024 * 1024;
+
+#pragma mark -
+#pragma mark HLSDiskCacheEntry class interface
+
+/**
+ * Index information about an entry stored on disk
+ */
+@interface HLSDiskCacheEntry : NSObject {
+@private
+    NSString *m_fileName;
+    unsigned long long m_size;
+    NSDate *m_accessDate;
+}
+
+@property (nonatomic, retain) NSString *fileName;
+@property (nonatomic, assign) unsigned long long size;
+@property (nonatomic, retain) NSDate *accessDate;
+
+- (NSComparisonResult)compareAccessDate:(HLSDiskCacheEntry *)entry;
+
+@end
+
+#pragma mark -
+#pragma mark HLSDiskCache class interface extension
+
+// All index manipulations occur on the private serial queue
+@interface HLSDiskCache ()
+
+@property (nonatomic, retain) NSString *directoryPath;
+@property (nonatomic, retain) HLSFileManager *fileManager;
+@property (nonatomic, retain) NSMutableDictionary *fileNameToEntryMap;
+@property (nonatomic, retain) NSMutableArray *fileNames;
+
+- (void)loadIndexIfNeeded;
+
+- (NSString *)fileNameForKey:(NSString *)key;
+- (NSString *)pathForFileName:(NSString *)fileName;
+
+- (void)touchEntry:(HLSDiskCacheEntry *)entry;
+- (BOOL)isEntryExpired:(HLSDiskCacheEntry *)entry;
+- (void)evictEntriesIfNeeded;
+- (void)removeEntryFromIndex:(HLSDiskCacheEntry *)entry;
+- (void)removeEntry:(HLSDiskCacheEntry *)entry;
+
+@end
+
+#pragma mark -
+#pragma mark HLSDiskCache class implementation
+
+@implementation HLSDiskCache
+
+#pragma mark Object creation and destruction
+
+- (id)initWithDirectoryPath:(NSString *)directoryPath fileManager:(HLSFileManager *)fileManager
+{
+    if ((self = [super init])) {
+        if ([directoryPath length] == 0) {
+            HLSLoggerError(@"A directory path is mandatory");
+            [self release];
+            return nil;
+        }
+        
+        self.directoryPath = directoryPath;
+        self.fileManager = fileManager ?: [HLSFileManager defaultManager];
+        self.fileNameToEntryMap = [NSMutableDictionary dictionary];
+        self.fileNames = [NSMutableArray array];
+        m_totalCostLimit = kDiskCacheDefaultTotalCostLimit;
+        m_queue = dispatch_queue_create("ch.hortis.CoconutKit.HLSDiskCache", NULL);
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    self.directoryPath = nil;
+    self.fileManager = nil;
+    self.fileNameToEntryMap = nil;
+    self.fileNames = nil;
+    
+    // Blocks submitted to the queue retain the cache, the queue is therefore empty
+    dispatch_release(m_queue);
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize directoryPath = m_directoryPath;
+
+@synthesize fileManager = m_fileManager;
+
+@synthesize totalCostLimit = m_totalCostLimit;
+
+- (void)setTotalCostLimit:(unsigned long long)totalCostLimit
+{
+    dispatch_async(m_queue, ^{
+        m_totalCostLimit = totalCostLimit;
+        [self evictEntriesIfNeeded];
+    });
+}
+
+@synthesize ageLimit = m_ageLimit;
+
+- (void)setAgeLimit:(NSTimeInterval)ageLimit
+{
+    dispatch_async(m_queue, ^{
+        m_ageLimit = ageLimit;
+        [self evictEntriesIfNeeded];
+    });
+}
+
+@synthesize fileNameToEntryMap = m_fileNameToEntryMap;
+
+@synthesize fileNames = m_fileNames;
+
+- (unsigned long long)totalCost
+{
+    __block unsigned long long totalCost = 0;
+    dispatch_sync(m_queue, ^{
+        [self loadIndexIfNeeded];
+        totalCost = m_totalCost;
+    });
+    return totalCost;
+}
+
+#pragma mark Accessing data
+
+- (void)dataForKey:(NSString *)key completionQueue:(dispatch_queue_t)completionQueue completionBlock:(HLSDiskCacheCompletionBlock)completionBlock
+{
+    completionQueue = completionQueue ?: dispatch_get_main_queue();
+    dispatch_async(m_queue, ^{
+        [self loadIndexIfNeeded];
+        
+        HLSDiskCacheEntry *entry = [self.fileNameToEntryMap objectForKey:[self fileNameForKey:key]];
+        if (entry && [self isEntryExpired:entry]) {
+            [self removeEntry:entry];
+            entry = nil;
+        }
+        
+        if (! entry) {
+            if (completionBlock) {
+                dispatch_async(completionQueue, ^{
+                    completionBlock(nil);
+                });
+            }
+            return;
+        }
+        
+        [self touchEntry:entry];
+        [self.fileManager contentsOfFileAtPath:[self pathForFileName:entry.fileName] completionQueue:m_queue completionBlock:^(NSData *data, NSError *error) {
+            // The file might have been removed behind the cache's back
+            if (! data && [self.fileNameToEntryMap objectForKey:entry.fileName] == entry) {
+                [self removeEntryFromIndex:entry];
+            }
+            
+            if (completionBlock) {
+                dispatch_async(completionQueue, ^{
+                    completionBlock(data);
+                });
+            }
+        }];
+    });
+}
+
+- (void)setData:(NSData *)data forKey:(NSString *)key
+{
+    if (! data) {
+        [self removeDataForKey:key];
+        return;
+    }
+    
+    // Take a snapshot of the data, which might be mutable
+    data = [NSData dataWithData:data];
+    dispatch_async(m_queue, ^{
+        [self loadIndexIfNeeded];
+        
+        NSString *fileName = [self fileNameForKey:key];
+        HLSDiskCacheEntry *existingEntry = [self.fileNameToEntryMap objectForKey:fileName];
+        if ([data length] > m_totalCostLimit) {
+            if (existingEntry) {
+                [self removeEntry:existingEntry];
+            }
+            return;
+        }
+        
+        if (existingEntry) {
+            [self removeEntryFromIndex:existingEntry];
+        }
+        
+        HLSDiskCacheEntry *entry = [[[HLSDiskCacheEntry alloc] init] autorelease];
+        entry.fileName = fileName;
+        entry.size = [data length];
+        [self touchEntry:entry];
+        m_totalCost += entry.size;
+        
+        [self.fileManager createFileAtPath:[self pathForFileName:fileName] contents:data completionQueue:m_queue completionBlock:^(BOOL success, NSError *error) {
+            if (! success) {
+                HLSLoggerError(@"The entry for key %@ could not be written. Reason: %@", key, error);
+                if ([self.fileNameToEntryMap objectForKey:fileName] == entry) {
+                    [self removeEntryFromIndex:entry];
+                }
+            }
+        }];
+        
+        [self evictEntriesIfNeeded];
+    });
+}
+
+- (void)removeDataForKey:(NSString *)key
+{
+    dispatch_async(m_queue, ^{
+        [self loadIndexIfNeeded];
+        
+        HLSDiskCacheEntry *entry = [self.fileNameToEntryMap objectForKey:[self fileNameForKey:key]];
+        if (entry) {
+            [self removeEntry:entry];
+        }
+    });
+}
+
+- (void)removeAllData
+{
+    dispatch_async(m_queue, ^{
+        [self loadIndexIfNeeded];
+        
+        for (HLSDiskCacheEntry *entry in [self.fileNameToEntryMap allValues]) {
+            [self removeEntry:entry];
+        }
+    });
+}
+
+#pragma mark Index
+
+- (void)loadIndexIfNeeded
+{
+    if (m_indexLoaded) {
+        return;
+    }
+    m_indexLoaded = YES;
+    
+    // The file manager does not provide asynchronous enumeration, but we already are on a background queue
+    NSArray *items = [self.fileManager itemsInDirectoryAtPath:self.directoryPath attributes:HLSFileAttributeAll recursive:NO error:NULL];
+    if (! items) {
+        NSError *error = nil;
+        if (! [self.fileManager createDirectoryAtPath:self.directoryPath withIntermediateDirectories:YES error:&error]) {
+            HLSLoggerError(@"The cache directory %@ could not be created. Reason: %@", self.directoryPath, error);
+        }
+        return;
+    }
+    
+    NSUInteger fileNameLength = 2 * [HLSDigest digestLengthForAlgorithm:HLSDigestAlgorithmSHA1];
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:[items count]];
+    for (HLSFileItem *item in items) {
+        if (item.directory || [item.name length] != fileNameLength) {
+            continue;
+        }
+        
+        HLSDiskCacheEntry *entry = [[[HLSDiskCacheEntry alloc] init] autorelease];
+        entry.fileName = item.name;
+        entry.size = item.size;
+        entry.accessDate = item.modificationDate ?: [NSDate date];
+        [entries addObject:entry];
+    }
+    
+    [entries sortUsingSelector:@selector(compareAccessDate:)];
+    for (HLSDiskCacheEntry *entry in entries) {
+        [self.fileNameToEntryMap setObject:entry forKey:entry.fileName];
+        [self.fileNames addObject:entry.fileName];
+        m_totalCost += entry.size;
+    }
+    
+    [self evictEntriesIfNeeded];
+}
+
+- (NSString *)fileNameForKey:(NSString *)key
+{
+    return [HLSDigest hexDigestForString:key algorithm:HLSDigestAlgorithmSHA1];
+}
+
+- (NSString *)pathForFileName:(NSString *)fileName
+{
+    return [self.directoryPath stringByAppendingPathComponent:fileName];
+}
+
+- (void)touchEntry:(HLSDiskCacheEntry *)entry
+{
+    entry.accessDate = [NSDate date];
+    
+    // Move to the end of the list (most recently used)
+    if ([self.fileNameToEntryMap objectForKey:entry.fileName]) {
+        [self.fileNames removeObject:entry.fileName];
+    }
+    else {
+        [self.fileNameToEntryMap setObject:entry forKey:entry.fileName];
+    }
+    [self.fileNames addObject:entry.fileName];
+}
+
+- (BOOL)isEntryExpired:(HLSDiskCacheEntry *)entry
+{
+    return m_ageLimit > 0. && -[entry.accessDate timeIntervalSinceNow] > m_ageLimit;
+}
+
+- (void)evictEntriesIfNeeded
+{
+    // Least recently used entries are also the oldest ones
+    while ([self.fileNames count] != 0) {
+        HLSDiskCacheEntry *entry = [self.fileNameToEntryMap objectForKey:[self.fileNames objectAtIndex:0]];
+        if (m_totalCost <= m_totalCostLimit && ! [self isEntryExpired:entry]) {
+            break;
+        }
+        [self removeEntry:entry];
+    }
+}
+
+- (void)removeEntryFromIndex:(HLSDiskCacheEntry *)entry
+{
+    m_totalCost -= entry.size;
+    [self.fileNames removeObject:entry.fileName];
+    [self.fileNameToEntryMap removeObjectForKey:entry.fileName];
+}
+
+- (void)removeEntry:(HLSDiskCacheEntry *)entry
+{
+    [self.fileManager removeItemAtPath:[self pathForFileName:entry.fileName] completionQueue:m_queue completionBlock:nil];
+    [self removeEntryFromIndex:entry];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSDiskCacheEntry class implementation
+
+@implementation HLSDiskCacheEntry
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.fileName = nil;
+    self.accessDate = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize fileName = m_fileName;
+
+@synthesize size = m_size;
+
+@synthesize accessDate = m_accessDate;
+
+#pragma mark Comparison
+
+- (NSComparisonResult)compareAccessDate:(HLSDiskCacheEntry *)entry
+{
+    return [self.accessDate compare:entry.accessDate];
+}
+
+@end
@@ -14,11 +14,23 @@
  * required, as explained in the documentation:
  *   http://developer.apple.com/library/ios/#documentation/Cocoa/Conceptual/ErrorHandlingCocoa/ErrorHandling/ErrorHandling.html
  *
+ * Standard properties are stored as is, and the userInfo dictionary is only built when it is requested (then
+ * kept until the error is updated). Errors which are created and discarded without their userInfo being
+ * accessed (e.g. during validation) therefore never build any dictionary
+ *
  * Designated initializer: -initWithDomain:Code:
  */
 @interface HLSError : NSError {
 @private
-    NSDictionary *m_internalUserInfo;
+    NSString *m_localizedDescription;
+    NSString *m_localizedFailureReason;
+    NSString *m_localizedRecoverySuggestion;
+    NSArray *m_localizedRecoveryOptions;
+    id m_recoveryAttempter;
+    NSString *m_helpAnchor;
+    NSError *m_underlyingError;
+    NSDictionary *m_customUserInfo;                 // objects for keys not stored in the ivars above
+    NSDictionary *m_userInfo;                       // built lazily, nil until needed or after an update
 }
 
 /**
@@ -10,15 +10,12 @@
 
 #import "HLSAssert.h"
 #import "HLSLogger.h"
+#import "HLSPersistentDictionary.h"
 #import "NSDictionary+HLSExtensions.h"
 
 @interface HLSError ()
 
-/**
- * We do not use the NSError userInfo dictionary since it is set at NSError creation time and cannot be updated afterwards.
- * Instead, we use our own internal dictionary
- */
-@property (nonatomic, retain) NSDictionary *internalUserInfo;
+- (void)invalidateUserInfo;
 
 @end
 
@@ -42,63 +39,145 @@
 
 - (id)initWithDomain:(NSString *)domain code:(NSInteger)code
 {
-    if ((self = [super initWithDomain:domain code:code userInfo:nil /* not used */])) {
-        self.internalUserInfo = [NSDictionary dictionary];
-    }
-    return self;
+    return [super initWithDomain:domain code:code userInfo:nil /* not used */];
 }
 
 - (void)dealloc
 {
-    self.internalUserInfo = nil;
+    [m_localizedDescription release];
+    [m_localizedFailureReason release];
+    [m_localizedRecoverySuggestion release];
+    [m_localizedRecoveryOptions release];
+    [m_recoveryAttempter release];
+    [m_helpAnchor release];
+    [m_underlyingError release];
+    [m_customUserInfo release];
+    [m_userInfo release];
     
     [super dealloc];
 }
 
 #pragma mark Accessors and mutators
 
-@synthesize internalUserInfo = m_internalUserInfo;
-
-- (NSDictionary *)userInfo
+- (NSString *)localizedDescription
 {
-    return self.internalUserInfo;
+    // Same behavior as NSError if no description has been set
+    return m_localizedDescription ? m_localizedDescription : [super localizedDescription];
 }
 
 - (void)setLocalizedDescription:(NSString *)localizedDescription
 {
-    [self setObject:localizedDescription forKey:NSLocalizedDescriptionKey];
+    if (m_localizedDescription == localizedDescription) {
+        return;
+    }
+    
+    [m_localizedDescription release];
+    m_localizedDescription = [localizedDescription retain];
+    [self invalidateUserInfo];
+}
+
+- (NSString *)localizedFailureReason
+{
+    return m_localizedFailureReason;
 }
 
 - (void)setLocalizedFailureReason:(NSString *)localizedFailureReason
 {
-    [self setObject:localizedFailureReason forKey:NSLocalizedFailureReasonErrorKey];
+    if (m_localizedFailureReason == localizedFailureReason) {
+        return;
+    }
+    
+    [m_localizedFailureReason release];
+    m_localizedFailureReason = [localizedFailureReason retain];
+    [self invalidateUserInfo];
+}
+
+- (NSString *)localizedRecoverySuggestion
+{
+    return m_localizedRecoverySuggestion;
 }
 
 - (void)setLocalizedRecoverySuggestion:(NSString *)localizedRecoverySuggestion
 {
-    [self setObject:localizedRecoverySuggestion forKey:NSLocalizedRecoverySuggestionErrorKey];
+    if (m_localizedRecoverySuggestion == localizedRecoverySuggestion) {
+        return;
+    }
+    
+    [m_localizedRecoverySuggestion release];
+    m_localizedRecoverySuggestion = [localizedRecoverySuggestion retain];
+    [self invalidateUserInfo];
+}
+
+- (NSArray *)localizedRecoveryOptions
+{
+    return m_localizedRecoveryOptions;
 }
 
 - (void)setLocalizedRecoveryOptions:(NSArray *)localizedRecoveryOptions
 {
     HLSAssertObjectsInEnumerationAreKindOfClass(localizedRecoveryOptions, NSString);
     
-    [self setObject:localizedRecoveryOptions forKey:NSLocalizedRecoveryOptionsErrorKey];
+    if (m_localizedRecoveryOptions == localizedRecoveryOptions) {
+        return;
+    }
+    
+    [m_localizedRecoveryOptions release];
+    m_localizedRecoveryOptions = [localizedRecoveryOptions retain];
+    [self invalidateUserInfo];
+}
+
+- (id)recoveryAttempter
+{
+    return m_recoveryAttempter;
 }
 
 - (void)setRecoveryAttempter:(id)recoveryAttempter
 {
-    [self setObject:recoveryAttempter forKey:NSRecoveryAttempterErrorKey];
+    if (m_recoveryAttempter == recoveryAttempter) {
+        return;
+    }
+    
+    [m_recoveryAttempter release];
+    m_recoveryAttempter = [recoveryAttempter retain];
+    [self invalidateUserInfo];
+}
+
+- (NSString *)helpAnchor
+{
+    return m_helpAnchor;
 }
 
 - (void)setHelpAnchor:(NSString *)helpAnchor
 {
-    [self setObject:helpAnchor forKey:NSHelpAnchorErrorKey];
+    if (m_helpAnchor == helpAnchor) {
+        return;
+    }
+    
+    [m_helpAnchor release];
+    m_helpAnchor = [helpAnchor retain];
+    [self invalidateUserInfo];
 }
 
 - (void)setUnderlyingError:(NSError *)underlyingError
 {
-    [self setObject:underlyingError forKey:NSUnderlyingErrorKey];
+    if (m_underlyingError == underlyingError) {
+        return;
+    }
+    
+    [m_underlyingError release];
+    m_underlyingError = [underlyingError retain];
+    [self invalidateUserInfo];
+}
+
+// Faster than the NSError (HLSExtensions) implementations, which extract the information from the userInfo
+- (NSError *)underlyingError
+{
+    return m_underlyingError;
+}
+
+- (NSDictionary *)customUserInfo
+{
+    return m_customUserInfo ? m_customUserInfo : [NSDictionary dictionary];
 }
 
 - (void)setObject:(id)object forKey:(NSString *)key
@@ -108,21 +187,97 @@
         return;
     }
     
-    if (object) {
-        self.internalUserInfo = [self.internalUserInfo dictionaryBySettingObject:object forKey:key];
+    // Reserved keys are stored in ivars
+    if ([key isEqualToString:NSLocalizedDescriptionKey]) {
+        [self setLocalizedDescription:object];
+    }
+    else if ([key isEqualToString:NSLocalizedFailureReasonErrorKey]) {
+        [self setLocalizedFailureReason:object];
+    }
+    else if ([key isEqualToString:NSLocalizedRecoverySuggestionErrorKey]) {
+        [self setLocalizedRecoverySuggestion:object];
+    }
+    else if ([key isEqualToString:NSLocalizedRecoveryOptionsErrorKey]) {
+        [self setLocalizedRecoveryOptions:object];
+    }
+    else if ([key isEqualToString:NSRecoveryAttempterErrorKey]) {
+        [self setRecoveryAttempter:object];
+    }
+    else if ([key isEqualToString:NSHelpAnchorErrorKey]) {
+        [self setHelpAnchor:object];
+    }
+    else if ([key isEqualToString:NSUnderlyingErrorKey]) {
+        [self setUnderlyingError:object];
     }
     else {
-        self.internalUserInfo = [self.internalUserInfo dictionaryByRemovingObjectForKey:key];
+        // The persistent dictionary is replaced (not modified) on each update, sharing most of its storage
+        NSDictionary *customUserInfo = m_customUserInfo ? m_customUserInfo : [HLSPersistentDictionary dictionary];
+        if (object) {
+            customUserInfo = [customUserInfo dictionaryBySettingObject:object forKey:key];
+        }
+        else {
+            customUserInfo = [customUserInfo dictionaryByRemovingObjectForKey:key];
+        }
+        
+        [m_customUserInfo release];
+        m_customUserInfo = [customUserInfo retain];
+        [self invalidateUserInfo];
+    }
+}
+
+- (NSDictionary *)userInfo
+{
+    // Built once, and kept until the next update
+    if (! m_userInfo) {
+        NSDictionary *userInfo = m_customUserInfo ? m_customUserInfo : [HLSPersistentDictionary dictionary];
+        if (m_localizedDescription) {
+            userInfo = [userInfo dictionaryBySettingObject:m_localizedDescription forKey:NSLocalizedDescriptionKey];
+        }
+        if (m_localizedFailureReason) {
+            userInfo = [userInfo dictionaryBySettingObject:m_localizedFailureReason forKey:NSLocalizedFailureReasonErrorKey];
+        }
+        if (m_localizedRecoverySuggestion) {
+            userInfo = [userInfo dictionaryBySettingObject:m_localizedRecoverySuggestion forKey:NSLocalizedRecoverySuggestionErrorKey];
+        }
+        if (m_localizedRecoveryOptions) {
+            userInfo = [userInfo dictionaryBySettingObject:m_localizedRecoveryOptions forKey:NSLocalizedRecoveryOptionsErrorKey];
+        }
+        if (m_recoveryAttempter) {
+            userInfo = [userInfo dictionaryBySettingObject:m_recoveryAttempter forKey:NSRecoveryAttempterErrorKey];
+        }
+        if (m_helpAnchor) {
+            userInfo = [userInfo dictionaryBySettingObject:m_helpAnchor forKey:NSHelpAnchorErrorKey];
+        }
+        if (m_underlyingError) {
+            userInfo = [userInfo dictionaryBySettingObject:m_underlyingError forKey:NSUnderlyingErrorKey];
+        }
+        m_userInfo = [userInfo retain];
     }
+    return m_userInfo;
+}
+
+- (void)invalidateUserInfo
+{
+    [m_userInfo release];
+    m_userInfo = nil;
 }
 
 #pragma mark NSCopying protocol implementation
 
 - (id)copyWithZone:(NSZone *)zone
 {
-    // Unlike a conventional NSError, the userInfo dictionary is here mutable. A deep copy must therefore be made
-    HLSError *errorCopy = [super copyWithZone:zone];
-    errorCopy.internalUserInfo = [NSMutableDictionary dictionaryWithDictionary:self.internalUserInfo];
+    // Unlike a conventional NSError, the userInfo can here be updated, the copy must therefore be a new object. The
+    // custom dictionary is never modified (only replaced) and can be shared, as can the userInfo if already built
+    HLSError *errorCopy = [[[self class] allocWithZone:zone] initWithDomain:self.domain code:self.code];
+    errorCopy->m_localizedDescription = [m_localizedDescription retain];
+    errorCopy->m_localizedFailureReason = [m_localizedFailureReason retain];
+    errorCopy->m_localizedRecoverySuggestion = [m_localizedRecoverySuggestion retain];
+    errorCopy->m_localizedRecoveryOptions = [m_localizedRecoveryOptions retain];
+    errorCopy->m_recoveryAttempter = [m_recoveryAttempter retain];
+    errorCopy->m_helpAnchor = [m_helpAnchor retain];
+    errorCopy->m_underlyingError = [m_underlyingError retain];
+    errorCopy->m_customUserInfo = [m_customUserInfo retain];
+    errorCopy->m_userInfo = [m_userInfo retain];
     return errorCopy;
 }
 
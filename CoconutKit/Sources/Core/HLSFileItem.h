@@ -0,0 +1,63 @@
+//
+//  HLSFileItem.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 02.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Attributes which can be retrieved when enumerating directory contents
+ */
+typedef enum {
+    HLSFileAttributeNone = 0,
+    HLSFileAttributeSize = (1 << 0),
+    HLSFileAttributeModificationDate = (1 << 1),
+    HLSFileAttributeAll = HLSFileAttributeSize | HLSFileAttributeModificationDate
+} HLSFileAttributes;
+
+/**
+ * An item found when enumerating the contents of a directory, with the attributes which have been requested. Whether
+ * the item is a directory is always known
+ *
+ * Designated initializer: -initWithPath:directory:size:modificationDate:
+ */
+@interface HLSFileItem : NSObject {
+@private
+    NSString *m_path;
+    BOOL m_directory;
+    unsigned long long m_size;
+    NSDate *m_modificationDate;
+}
+
+/**
+ * Create an item. Its path is relative to the directory being enumerated
+ */
+- (id)initWithPath:(NSString *)path directory:(BOOL)directory size:(unsigned long long)size modificationDate:(NSDate *)modificationDate;
+
+/**
+ * The path of the item, relative to the directory being enumerated
+ */
+@property (nonatomic, readonly, retain) NSString *path;
+
+/**
+ * The name of the item
+ */
+@property (nonatomic, readonly, retain) NSString *name;
+
+/**
+ * Return YES iff the item is a directory
+ */
+@property (nonatomic, readonly, assign, getter=isDirectory) BOOL directory;
+
+/**
+ * The size of the item, in bytes. 0 if not requested
+ */
+@property (nonatomic, readonly, assign) unsigned long long size;
+
+/**
+ * The date at which the item was last modified. nil if not requested or not supported by the file manager
+ */
+@property (nonatomic, readonly, retain) NSDate *modificationDate;
+
+@end
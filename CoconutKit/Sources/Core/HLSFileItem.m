@@ -0,0 +1,80 @@
+//
+//  HLSFileItem.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 02.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFileItem.h"
+
+#import "HLSAssert.h"
+#import "HLSConverters.h"
+
+@interface HLSFileItem ()
+
+@property (nonatomic, retain) NSString *path;
+@property (nonatomic, assign, getter=isDirectory) BOOL directory;
+@property (nonatomic, assign) unsigned long long size;
+@property (nonatomic, retain) NSDate *modificationDate;
+
+@end
+
+@implementation HLSFileItem
+
+#pragma mark Object creation and destruction
+
+- (id)initWithPath:(NSString *)path directory:(BOOL)directory size:(unsigned long long)size modificationDate:(NSDate *)modificationDate
+{
+    if ((self = [super init])) {
+        self.path = path;
+        self.directory = directory;
+        self.size = size;
+        self.modificationDate = modificationDate;
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    self.path = nil;
+    self.modificationDate = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize path = m_path;
+
+- (NSString *)name
+{
+    return [self.path lastPathComponent];
+}
+
+@synthesize directory = m_directory;
+
+@synthesize size = m_size;
+
+@synthesize modificationDate = m_modificationDate;
+
+#pragma mark Description
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p; path: %@; directory: %@; size: %llu; modificationDate: %@>",
+            [self class],
+            self,
+            self.path,
+            HLSStringFromBool(self.directory),
+            self.size,
+            self.modificationDate];
+}
+
+@end
@@ -6,6 +6,50 @@
 //  Copyright (c) 2012 Hortis. All rights reserved.
 //
 
+#import "HLSFileItem.h"
+
+/**
+ * Completion blocks for asynchronous file operations
+ */
+typedef void (^HLSFileManagerCompletionBlock)(BOOL success, NSError *error);
+typedef void (^HLSFileManagerDataCompletionBlock)(NSData *data, NSError *error);
+typedef void (^HLSFileManagerContentsCompletionBlock)(NSArray *contents, NSError *error);
+typedef void (^HLSFileManagerExistenceCompletionBlock)(BOOL exists, BOOL isDirectory);
+
+/**
+ * Handle to an open file, for reading or writing it by pieces with bounded memory consumption. The file is closed
+ * when -close is called or when the handle is deallocated. Handles must not be used from several threads at the same
+ * time
+ */
+@protocol HLSFileHandle <NSObject>
+
+/**
+ * Read at most length bytes starting at the given offset. The data returned is shorter than requested when the end of 
+ * the file is reached (empty if the offset is beyond the end of the file). Return nil on failure. Only available for
+ * handles opened for reading
+ */
+- (NSData *)readDataOfLength:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)pError;
+
+/**
+ * Write data after what has been written so far (at the end of the file for handles opened for appending). Only 
+ * available for handles opened for writing or appending
+ *
+ * Return YES iff successful
+ */
+- (BOOL)writeData:(NSData *)data error:(NSError **)pError;
+
+/**
+ * The current length of the file, in bytes
+ */
+- (unsigned long long)length;
+
+/**
+ * Close the file. The handle cannot be used anymore afterwards
+ */
+- (void)close;
+
+@end
+
 /**
  * Concrete subclasses of HLSFileManager must implement the set of methods declared by the following protocol
  */
@@ -24,6 +68,19 @@
  */
 - (BOOL)createFileAtPath:(NSString *)path contents:(NSData *)contents error:(NSError **)pError;
 
+/**
+ * Open the file at the given location for ranged reads. Return nil if the file cannot be opened
+ */
+- (id<HLSFileHandle>)fileHandleForReadingAtPath:(NSString *)path error:(NSError **)pError;
+
+/**
+ * Open the file at the given location to write its content by pieces, creating it if needed. When writing, any 
+ * existing content is discarded. When appending, data is written after the existing content. Return nil if the file
+ * cannot be opened
+ */
+- (id<HLSFileHandle>)fileHandleForWritingAtPath:(NSString *)path error:(NSError **)pError;
+- (id<HLSFileHandle>)fileHandleForAppendingAtPath:(NSString *)path error:(NSError **)pError;
+
 /**
  * Create a directory at the specified path (create intermediate directories if enabled, otherwise fails if the parent directory does not
  * exist)
@@ -37,6 +94,17 @@
  */
 - (NSArray *)contentsOfDirectoryAtPath:(NSString *)path error:(NSError **)pError;
 
+/**
+ * List the contents of the specified directory (and of its subdirectories if recursive is YES) as HLSFileItem objects,
+ * retrieving only the requested attributes. Implementations should read entries and attributes in bulk, so that
+ * no additional call is needed per item. HLSFileManager provides a fallback implementation built on the other
+ * methods of this protocol (without modification dates)
+ */
+- (NSArray *)itemsInDirectoryAtPath:(NSString *)path 
+                         attributes:(HLSFileAttributes)attributes 
+                          recursive:(BOOL)recursive 
+                              error:(NSError **)pError;
+
 /**
  * Return YES iff the file or folder exists at the specified path (and whether it is a directory or not; you can pass NULL if you do not
  * need this information)
@@ -81,6 +149,12 @@
  * For all methods, paths represent locations relative to the managed storage, and should be given using the standard
  * notation /path/to/some/file.txt. The / at the beginning represents the storage root
  *
+ * Each method of the HLSFileManagerAbstract protocol also has an asynchronous variant, available for all subclasses
+ * for free. Operations are performed in the background, and the completion block is called on the specified queue 
+ * (the main queue if NULL). Operations which modify a path (for copy and move operations, the destination path) are 
+ * serialized per path and per file manager, in the order in which they have been requested. Operations reading a path
+ * run concurrently, except when modifications of the same path are pending, in which case they are performed after them
+ *
  * Designated initializer: -init
  */
 @interface HLSFileManager : NSObject <HLSFileManagerAbstract>
@@ -100,4 +174,36 @@
  */
 - (BOOL)fileExistsAtPath:(NSString *)path;
 
+/**
+ * Asynchronous variants of the HLSFileManagerAbstract protocol methods
+ */
+- (void)contentsOfFileAtPath:(NSString *)path 
+             completionQueue:(dispatch_queue_t)completionQueue 
+             completionBlock:(HLSFileManagerDataCompletionBlock)completionBlock;
+- (void)createFileAtPath:(NSString *)path 
+                contents:(NSData *)contents 
+         completionQueue:(dispatch_queue_t)completionQueue 
+         completionBlock:(HLSFileManagerCompletionBlock)completionBlock;
+- (void)createDirectoryAtPath:(NSString *)path 
+  withIntermediateDirectories:(BOOL)withIntermediateDirectories 
+              completionQueue:(dispatch_queue_t)completionQueue 
+              completionBlock:(HLSFileManagerCompletionBlock)completionBlock;
+- (void)contentsOfDirectoryAtPath:(NSString *)path 
+                  completionQueue:(dispatch_queue_t)completionQueue 
+                  completionBlock:(HLSFileManagerContentsCompletionBlock)completionBlock;
+- (void)fileExistsAtPath:(NSString *)path 
+         completionQueue:(dispatch_queue_t)completionQueue 
+         completionBlock:(HLSFileManagerExistenceCompletionBlock)completionBlock;
+- (void)copyItemAtPath:(NSString *)sourcePath 
+                toPath:(NSString *)destinationPath 
+       completionQueue:(dispatch_queue_t)completionQueue 
+       completionBlock:(HLSFileManagerCompletionBlock)completionBlock;
+- (void)moveItemAtPath:(NSString *)sourcePath 
+                toPath:(NSString *)destinationPath 
+       completionQueue:(dispatch_queue_t)completionQueue 
+       completionBlock:(HLSFileManagerCompletionBlock)completionBlock;
+- (void)removeItemAtPath:(NSString *)path 
+         completionQueue:(dispatch_queue_t)completionQueue 
+         completionBlock:(HLSFileManagerCompletionBlock)completionBlock;
+
 @end
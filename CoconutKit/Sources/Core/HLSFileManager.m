@@ -8,11 +8,57 @@
 
 #import "HLSFileManager.h"
 
+#import <libkern/OSAtomic.h>
+
 // TODO: When available in CoconutKit (feature/url-connection branch), check protocol conformance (all methods from the
 //       abstract protocol must be implemented, though they have been made optional to avoid compilation warnings)
 
 static HLSFileManager *s_defaultManager = nil;
 
+// Lanes of the paths with pending modifications, for all file managers (key: file manager address and path). Lanes
+// are removed when they have no pending modification anymore
+static NSMutableDictionary *s_keyToIOLaneMap = nil;
+static OSSpinLock s_ioLanesLock = OS_SPINLOCK_INIT;
+
+#pragma mark -
+#pragma mark HLSFileManagerIOLane class interface
+
+/**
+ * Serial queue on which the operations involving a path are performed while modifications are pending
+ */
+@interface HLSFileManagerIOLane : NSObject {
+@private
+    dispatch_queue_t m_queue;
+    NSUInteger m_pendingModificationCount;
+}
+
+@property (nonatomic, readonly, assign) dispatch_queue_t queue;
+@property (nonatomic, assign) NSUInteger pendingModificationCount;
+
+@end
+
+#pragma mark -
+#pragma mark HLSFileManager class interface extension
+
+@interface HLSFileManager ()
+
+- (NSString *)ioLaneKeyForPath:(NSString *)path;
+
+- (BOOL)addItemsInDirectoryAtPath:(NSString *)path
+                     relativePath:(NSString *)relativePath
+                       attributes:(HLSFileAttributes)attributes
+                        recursive:(BOOL)recursive
+                          toItems:(NSMutableArray *)items
+                            error:(NSError **)pError;
+
+- (void)performReadingPath:(NSString *)path block:(dispatch_block_t)block;
+- (void)performModifyingPath:(NSString *)path block:(dispatch_block_t)block;
+
+@end
+
+#pragma mark -
+#pragma mark HLSFileManager class implementation
+
 @implementation HLSFileManager
 
 #pragma mark Class methods
@@ -40,4 +86,283 @@ static HLSFileManager *s_defaultManager = nil;
     return [self fileExistsAtPath:path isDirectory:NULL];
 }
 
+#pragma mark Directory enumeration
+
+- (NSArray *)itemsInDirectoryAtPath:(NSString *)path 
+                         attributes:(HLSFileAttributes)attributes 
+                          recursive:(BOOL)recursive 
+                              error:(NSError **)pError
+{
+    NSMutableArray *items = [NSMutableArray array];
+    if (! [self addItemsInDirectoryAtPath:path relativePath:nil attributes:attributes recursive:recursive toItems:items error:pError]) {
+        return nil;
+    }
+    return [NSArray arrayWithArray:items];
+}
+
+- (BOOL)addItemsInDirectoryAtPath:(NSString *)path
+                     relativePath:(NSString *)relativePath
+                       attributes:(HLSFileAttributes)attributes
+                        recursive:(BOOL)recursive
+                          toItems:(NSMutableArray *)items
+                            error:(NSError **)pError
+{
+    NSArray *contents = [self contentsOfDirectoryAtPath:path error:pError];
+    if (! contents) {
+        return NO;
+    }
+    
+    for (NSString *name in contents) {
+        NSString *itemPath = [path stringByAppendingPathComponent:name];
+        NSString *itemRelativePath = relativePath ? [relativePath stringByAppendingPathComponent:name] : name;
+        
+        BOOL isDirectory = NO;
+        if (! [self fileExistsAtPath:itemPath isDirectory:&isDirectory]) {
+            continue;
+        }
+        
+        // Without any better way, the size of a file is the length of its (usually mapped) contents
+        unsigned long long size = 0;
+        if (! isDirectory && (attributes & HLSFileAttributeSize)) {
+            size = [[self contentsOfFileAtPath:itemPath error:NULL] length];
+        }
+        
+        HLSFileItem *item = [[[HLSFileItem alloc] initWithPath:itemRelativePath directory:isDirectory size:size modificationDate:nil] autorelease];
+        [items addObject:item];
+        
+        if (isDirectory && recursive) {
+            if (! [self addItemsInDirectoryAtPath:itemPath 
+                                     relativePath:itemRelativePath 
+                                       attributes:attributes 
+                                        recursive:YES 
+                                          toItems:items 
+                                            error:pError]) {
+                return NO;
+            }
+        }
+    }
+    return YES;
+}
+
+#pragma mark Asynchronous operations
+
+- (void)contentsOfFileAtPath:(NSString *)path 
+             completionQueue:(dispatch_queue_t)completionQueue 
+             completionBlock:(HLSFileManagerDataCompletionBlock)completionBlock
+{
+    completionQueue = completionQueue ?: dispatch_get_main_queue();
+    [self performReadingPath:path block:^{
+        NSError *error = nil;
+        NSData *data = [self contentsOfFileAtPath:path error:&error];
+        if (completionBlock) {
+            dispatch_async(completionQueue, ^{
+                completionBlock(data, error);
+            });
+        }
+    }];
+}
+
+- (void)createFileAtPath:(NSString *)path 
+                contents:(NSData *)contents 
+         completionQueue:(dispatch_queue_t)completionQueue 
+         completionBlock:(HLSFileManagerCompletionBlock)completionBlock
+{
+    completionQueue = completionQueue ?: dispatch_get_main_queue();
+    [self performModifyingPath:path block:^{
+        NSError *error = nil;
+        BOOL success = [self createFileAtPath:path contents:contents error:&error];
+        if (completionBlock) {
+            dispatch_async(completionQueue, ^{
+                completionBlock(success, error);
+            });
+        }
+    }];
+}
+
+- (void)createDirectoryAtPath:(NSString *)path 
+  withIntermediateDirectories:(BOOL)withIntermediateDirectories 
+              completionQueue:(dispatch_queue_t)completionQueue 
+              completionBlock:(HLSFileManagerCompletionBlock)completionBlock
+{
+    completionQueue = completionQueue ?: dispatch_get_main_queue();
+    [self performModifyingPath:path block:^{
+        NSError *error = nil;
+        BOOL success = [self createDirectoryAtPath:path withIntermediateDirectories:withIntermediateDirectories error:&error];
+        if (completionBlock) {
+            dispatch_async(completionQueue, ^{
+                completionBlock(success, error);
+            });
+        }
+    }];
+}
+
+- (void)contentsOfDirectoryAtPath:(NSString *)path 
+                  completionQueue:(dispatch_queue_t)completionQueue 
+                  completionBlock:(HLSFileManagerContentsCompletionBlock)completionBlock
+{
+    completionQueue = completionQueue ?: dispatch_get_main_queue();
+    [self performReadingPath:path block:^{
+        NSError *error = nil;
+        NSArray *contents = [self contentsOfDirectoryAtPath:path error:&error];
+        if (completionBlock) {
+            dispatch_async(completionQueue, ^{
+                completionBlock(contents, error);
+            });
+        }
+    }];
+}
+
+- (void)fileExistsAtPath:(NSString *)path 
+         completionQueue:(dispatch_queue_t)completionQueue 
+         completionBlock:(HLSFileManagerExistenceCompletionBlock)completionBlock
+{
+    completionQueue = completionQueue ?: dispatch_get_main_queue();
+    [self performReadingPath:path block:^{
+        BOOL isDirectory = NO;
+        BOOL exists = [self fileExistsAtPath:path isDirectory:&isDirectory];
+        if (completionBlock) {
+            dispatch_async(completionQueue, ^{
+                completionBlock(exists, isDirectory);
+            });
+        }
+    }];
+}
+
+- (void)copyItemAtPath:(NSString *)sourcePath 
+                toPath:(NSString *)destinationPath 
+       completionQueue:(dispatch_queue_t)completionQueue 
+       completionBlock:(HLSFileManagerCompletionBlock)completionBlock
+{
+    completionQueue = completionQueue ?: dispatch_get_main_queue();
+    [self performModifyingPath:destinationPath block:^{
+        NSError *error = nil;
+        BOOL success = [self copyItemAtPath:sourcePath toPath:destinationPath error:&error];
+        if (completionBlock) {
+            dispatch_async(completionQueue, ^{
+                completionBlock(success, error);
+            });
+        }
+    }];
+}
+
+- (void)moveItemAtPath:(NSString *)sourcePath 
+                toPath:(NSString *)destinationPath 
+       completionQueue:(dispatch_queue_t)completionQueue 
+       completionBlock:(HLSFileManagerCompletionBlock)completionBlock
+{
+    completionQueue = completionQueue ?: dispatch_get_main_queue();
+    [self performModifyingPath:destinationPath block:^{
+        NSError *error = nil;
+        BOOL success = [self moveItemAtPath:sourcePath toPath:destinationPath error:&error];
+        if (completionBlock) {
+            dispatch_async(completionQueue, ^{
+                completionBlock(success, error);
+            });
+        }
+    }];
+}
+
+- (void)removeItemAtPath:(NSString *)path 
+         completionQueue:(dispatch_queue_t)completionQueue 
+         completionBlock:(HLSFileManagerCompletionBlock)completionBlock
+{
+    completionQueue = completionQueue ?: dispatch_get_main_queue();
+    [self performModifyingPath:path block:^{
+        NSError *error = nil;
+        BOOL success = [self removeItemAtPath:path error:&error];
+        if (completionBlock) {
+            dispatch_async(completionQueue, ^{
+                completionBlock(success, error);
+            });
+        }
+    }];
+}
+
+#pragma mark Scheduling
+
+- (NSString *)ioLaneKeyForPath:(NSString *)path
+{
+    return [NSString stringWithFormat:@"%p_%@", self, path];
+}
+
+- (void)performReadingPath:(NSString *)path block:(dispatch_block_t)block
+{
+    NSString *key = [self ioLaneKeyForPath:path];
+    
+    // Reads only need to wait if modifications of the same path are pending
+    OSSpinLockLock(&s_ioLanesLock);
+    HLSFileManagerIOLane *ioLane = [[s_keyToIOLaneMap objectForKey:key] retain];
+    OSSpinLockUnlock(&s_ioLanesLock);
+    
+    dispatch_queue_t queue = ioLane ? ioLane.queue : dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_async(queue, ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        block();
+        [pool drain];
+    });
+    
+    [ioLane release];
+}
+
+- (void)performModifyingPath:(NSString *)path block:(dispatch_block_t)block
+{
+    NSString *key = [self ioLaneKeyForPath:path];
+    
+    OSSpinLockLock(&s_ioLanesLock);
+    if (! s_keyToIOLaneMap) {
+        s_keyToIOLaneMap = [[NSMutableDictionary alloc] init];
+    }
+    HLSFileManagerIOLane *ioLane = [s_keyToIOLaneMap objectForKey:key];
+    if (! ioLane) {
+        ioLane = [[[HLSFileManagerIOLane alloc] init] autorelease];
+        [s_keyToIOLaneMap setObject:ioLane forKey:key];
+    }
+    ++ioLane.pendingModificationCount;
+    OSSpinLockUnlock(&s_ioLanesLock);
+    
+    // The lane is retained by the block until the modification has been performed
+    dispatch_async(ioLane.queue, ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        block();
+        [pool drain];
+        
+        OSSpinLockLock(&s_ioLanesLock);
+        --ioLane.pendingModificationCount;
+        if (ioLane.pendingModificationCount == 0) {
+            [s_keyToIOLaneMap removeObjectForKey:key];
+        }
+        OSSpinLockUnlock(&s_ioLanesLock);
+    });
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSFileManagerIOLane class implementation
+
+@implementation HLSFileManagerIOLane
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        m_queue = dispatch_queue_create("ch.hortis.CoconutKit.HLSFileManager.ioLane", NULL);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    dispatch_release(m_queue);
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize queue = m_queue;
+
+@synthesize pendingModificationCount = m_pendingModificationCount;
+
 @end
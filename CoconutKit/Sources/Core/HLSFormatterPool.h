@@ -0,0 +1,60 @@
+//
+//  HLSFormatterPool.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Block creating a formatter for a pool entry
+ */
+typedef NSFormatter * (^HLSFormatterPoolCreationBlock)(void);
+
+/**
+ * Formatters (in particular NSNumberFormatter and NSDateFormatter objects) are expensive to create, and applications
+ * often create one for each field they display (e.g. for each field of a form, see UITextField+HLSValidation.h). A
+ * formatter pool creates each formatter configuration once and shares it among all its users. Formatters for the 
+ * usual styles are available through convenience methods, other configurations can be pooled using a key describing
+ * them
+ *
+ * Pooled formatters are shared and must therefore not be altered once obtained. Since formatters are not thread-safe,
+ * the pool (as well as the formatters it returns) must only be used from the main thread. All formatters are discarded 
+ * when the current locale or the system time zone changes, so that new formatters are created with the new settings
+ *
+ * Designated initializer: -init (but use the +sharedFormatterPool singleton)
+ */
+@interface HLSFormatterPool : NSObject {
+@private
+    NSMutableDictionary *m_keyToFormatterMap;
+}
+
+/**
+ * The pool singleton
+ */
++ (HLSFormatterPool *)sharedFormatterPool;
+
+/**
+ * Return the formatter stored for a key. If none is found, the creation block is called and its result is stored for 
+ * the key. The key must describe the formatter configuration completely
+ */
+- (id)formatterForKey:(NSString *)key creationBlock:(HLSFormatterPoolCreationBlock)creationBlock;
+
+/**
+ * Number formatters with the given style, for the current locale
+ */
+- (NSNumberFormatter *)numberFormatterWithStyle:(NSNumberFormatterStyle)numberStyle;
+
+/**
+ * Date formatters with the given date and time styles, respectively the given format, for the current locale and the 
+ * default time zone
+ */
+- (NSDateFormatter *)dateFormatterWithDateStyle:(NSDateFormatterStyle)dateStyle timeStyle:(NSDateFormatterStyle)timeStyle;
+- (NSDateFormatter *)dateFormatterWithFormat:(NSString *)format;
+
+/**
+ * Discard all pooled formatters. Formatters still in use remain valid
+ */
+- (void)removeAllFormatters;
+
+@end
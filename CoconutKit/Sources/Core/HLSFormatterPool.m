@@ -0,0 +1,154 @@
+//
+//  HLSFormatterPool.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFormatterPool.h"
+
+#import "HLSLogger.h"
+
+@interface HLSFormatterPool ()
+
+@property (nonatomic, retain) NSMutableDictionary *keyToFormatterMap;
+
+- (void)formatterSettingsDidChange:(NSNotification *)notification;
+
+@end
+
+@implementation HLSFormatterPool
+
+#pragma mark Class methods
+
++ (HLSFormatterPool *)sharedFormatterPool
+{
+    static HLSFormatterPool *s_instance = nil;
+    
+    if (! s_instance) {
+        s_instance = [[HLSFormatterPool alloc] init];
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.keyToFormatterMap = [NSMutableDictionary dictionary];
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(formatterSettingsDidChange:)
+                                                     name:NSCurrentLocaleDidChangeNotification
+                                                   object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(formatterSettingsDidChange:)
+                                                     name:NSSystemTimeZoneDidChangeNotification
+                                                   object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:NSCurrentLocaleDidChangeNotification
+                                                  object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:NSSystemTimeZoneDidChangeNotification
+                                                  object:nil];
+    
+    self.keyToFormatterMap = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize keyToFormatterMap = m_keyToFormatterMap;
+
+#pragma mark Obtaining formatters
+
+- (id)formatterForKey:(NSString *)key creationBlock:(HLSFormatterPoolCreationBlock)creationBlock
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (! key || ! creationBlock) {
+        HLSLoggerError(@"Missing key or creation block");
+        return nil;
+    }
+    
+    NSFormatter *formatter = [self.keyToFormatterMap objectForKey:key];
+    if (! formatter) {
+        formatter = creationBlock();
+        if (! formatter) {
+            HLSLoggerError(@"No formatter has been created for the key %@", key);
+            return nil;
+        }
+        [self.keyToFormatterMap setObject:formatter forKey:key];
+    }
+    return formatter;
+}
+
+- (NSNumberFormatter *)numberFormatterWithStyle:(NSNumberFormatterStyle)numberStyle
+{
+    NSString *key = [NSString stringWithFormat:@"NSNumberFormatter|%d", numberStyle];
+    return [self formatterForKey:key creationBlock:^{
+        NSNumberFormatter *numberFormatter = [[[NSNumberFormatter alloc] init] autorelease];
+        [numberFormatter setFormatterBehavior:NSNumberFormatterBehavior10_4];
+        [numberFormatter setNumberStyle:numberStyle];
+        return (NSFormatter *)numberFormatter;
+    }];
+}
+
+- (NSDateFormatter *)dateFormatterWithDateStyle:(NSDateFormatterStyle)dateStyle timeStyle:(NSDateFormatterStyle)timeStyle
+{
+    NSString *key = [NSString stringWithFormat:@"NSDateFormatter|%d|%d", dateStyle, timeStyle];
+    return [self formatterForKey:key creationBlock:^{
+        NSDateFormatter *dateFormatter = [[[NSDateFormatter alloc] init] autorelease];
+        [dateFormatter setFormatterBehavior:NSDateFormatterBehavior10_4];
+        [dateFormatter setDateStyle:dateStyle];
+        [dateFormatter setTimeStyle:timeStyle];
+        return (NSFormatter *)dateFormatter;
+    }];
+}
+
+- (NSDateFormatter *)dateFormatterWithFormat:(NSString *)format
+{
+    if (! format) {
+        HLSLoggerError(@"Missing format");
+        return nil;
+    }
+    
+    NSString *key = [NSString stringWithFormat:@"NSDateFormatter|%@", format];
+    return [self formatterForKey:key creationBlock:^{
+        NSDateFormatter *dateFormatter = [[[NSDateFormatter alloc] init] autorelease];
+        [dateFormatter setFormatterBehavior:NSDateFormatterBehavior10_4];
+        [dateFormatter setDateFormat:format];
+        return (NSFormatter *)dateFormatter;
+    }];
+}
+
+- (void)removeAllFormatters
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    [self.keyToFormatterMap removeAllObjects];
+}
+
+#pragma mark Notification callbacks
+
+- (void)formatterSettingsDidChange:(NSNotification *)notification
+{
+    // Might be posted on any thread
+    if (! [NSThread isMainThread]) {
+        [self performSelectorOnMainThread:@selector(removeAllFormatters) withObject:nil waitUntilDone:NO];
+        return;
+    }
+    
+    [self removeAllFormatters];
+}
+
+@end
@@ -0,0 +1,130 @@
+//
+//  HLSImageCache.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 14.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSMemoryAccountant.h"
+
+/**
+ * Block loading an image, executed on a background queue. Return nil if the image could not be loaded
+ */
+typedef UIImage * (^HLSImageCacheLoadBlock)(void);
+
+/**
+ * Block called on the main thread when an image load is complete. The image is nil if it could not be loaded
+ */
+typedef void (^HLSImageCacheCompletionBlock)(UIImage *image);
+
+/**
+ * A memory cache for images, bounded by the total number of bytes occupied by the bitmaps of the images it contains. When
+ * this limit is exceeded, the least recently used images are evicted first. All images are removed when a memory warning
+ * is received (by the memory accountant when automatic purging is enabled, see HLSMemoryAccountant).
+ *
+ * The shared image cache is used by all CoconutKit classes which load or generate images (e.g. HLSSlideshow or HLSTableViewCell),
+ * so that the memory they consume for images has a single bound. Your application can use it for its own images as well, or
+ * replace it with an image cache configured differently (see +setSharedImageCache:). You can also create separate image
+ * caches if you need to.
+ *
+ * Image caches are meant to be used from the main thread only. Only the blocks loading images run on a background queue.
+ *
+ * Designated initializer: -initWithTotalCostLimit:
+ */
+@interface HLSImageCache : NSObject <HLSMemoryAccounting> {
+@private
+    NSMutableDictionary *m_keyToImageMap;
+    NSMutableArray *m_keys;                                 // Least recently used keys first
+    NSMutableDictionary *m_keyToCompletionBlocksMap;        // Completion blocks of the images currently being loaded
+    NSUInteger m_totalCostLimit;
+    NSUInteger m_totalCost;
+}
+
+/**
+ * The image cache used by CoconutKit classes. Unless you register your own, an image cache with the default limit is used
+ */
++ (HLSImageCache *)sharedImageCache;
+
+/**
+ * Register an image cache as shared image cache. Set it when your application starts, before any CoconutKit class
+ * has a chance to use the default one. Setting nil restores a cache with the default limit
+ */
++ (void)setSharedImageCache:(HLSImageCache *)imageCache;
+
+/**
+ * Return the number of bytes occupied by the bitmap of an image
+ */
++ (NSUInteger)costForImage:(UIImage *)image;
+
+/**
+ * Create an image cache whose content cannot exceed a given number of bytes
+ */
+- (id)initWithTotalCostLimit:(NSUInteger)totalCostLimit;
+
+/**
+ * The maximum number of bytes occupied by the images in the cache. Images larger than this limit are not cached. If
+ * the limit is decreased, least recently used images are evicted until the content of the cache fits into it
+ *
+ * The default value is 10 MB
+ */
+@property (nonatomic, assign) NSUInteger totalCostLimit;
+
+/**
+ * The number of bytes currently occupied by the images in the cache
+ */
+@property (nonatomic, readonly, assign) NSUInteger totalCost;
+
+/**
+ * Return the image stored for a key, nil if none. The image is marked as most recently used
+ */
+- (UIImage *)imageForKey:(NSString *)key;
+
+/**
+ * Store an image for a key, replacing any image already stored for it. Least recently used images are evicted if needed.
+ * Setting nil removes the image stored for the key
+ */
+- (void)setImage:(UIImage *)image forKey:(NSString *)key;
+
+/**
+ * Remove the image stored for a key
+ */
+- (void)removeImageForKey:(NSString *)key;
+
+/**
+ * Remove all images from the cache. Images currently being loaded are still added to the cache when their load is complete
+ */
+- (void)removeAllImages;
+
+/**
+ * Return the image with a given name (as +[UIImage imageNamed:] does), storing it in the cache. Return nil if no such
+ * image exists
+ */
+- (UIImage *)imageNamed:(NSString *)imageName;
+
+/**
+ * Return a stretchable version of the image with a given name (see -[UIImage stretchableImageWithLeftCapWidth:topCapHeight:]), 
+ * storing it in the cache under a key made of the name and of the caps. All users of the same image and caps therefore 
+ * share the same image. Return nil if no such image exists
+ */
+- (UIImage *)stretchableImageNamed:(NSString *)imageName leftCapWidth:(NSInteger)leftCapWidth topCapHeight:(NSInteger)topCapHeight;
+
+/**
+ * Provide the image for a key, loading it with the block given as parameter if it is not in the cache. The load block
+ * is executed on a background queue, and the image it returns is stored in the cache before the completion block is
+ * called on the main thread. If the image is found in the cache, the completion block is called immediately. If the
+ * same image is already being loaded, the load block is not executed, and the completion block is called when the
+ * pending load is complete
+ *
+ * The completion block can be nil (e.g. to preload images)
+ */
+- (void)loadImageForKey:(NSString *)key
+              withBlock:(HLSImageCacheLoadBlock)loadBlock
+        completionBlock:(HLSImageCacheCompletionBlock)completionBlock;
+
+/**
+ * Return YES iff the image stored for a key is currently being loaded
+ */
+- (BOOL)isLoadingImageForKey:(NSString *)key;
+
+@end
@@ -0,0 +1,302 @@
+//
+//  HLSImageCache.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 14.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSImageCache.h"
+
+#import "HLSLogger.h"
+
+static const NSUInteger kImageCacheDefaultTotalCostLimit = 10 * 1024 * 1024;
+
+static HLSImageCache *s_sharedImageCache = nil;
+
+@interface HLSImageCache ()
+
+@property (nonatomic, retain) NSMutableDictionary *keyToImageMap;
+@property (nonatomic, retain) NSMutableArray *keys;
+@property (nonatomic, retain) NSMutableDictionary *keyToCompletionBlocksMap;
+
+- (void)evictImagesIfNeeded;
+
+- (void)didLoadImage:(UIImage *)image forKey:(NSString *)key;
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification;
+
+@end
+
+@implementation HLSImageCache
+
+#pragma mark Class methods
+
++ (HLSImageCache *)sharedImageCache
+{
+    if (! s_sharedImageCache) {
+        s_sharedImageCache = [[HLSImageCache alloc] init];
+    }
+    return s_sharedImageCache;
+}
+
++ (void)setSharedImageCache:(HLSImageCache *)imageCache
+{
+    if (s_sharedImageCache == imageCache) {
+        return;
+    }
+    
+    [s_sharedImageCache release];
+    s_sharedImageCache = [imageCache retain];
+}
+
++ (NSUInteger)costForImage:(UIImage *)image
+{
+    CGImageRef imageRef = image.CGImage;
+    if (imageRef) {
+        return CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+    }
+    // Not backed by a bitmap. Assume 4 bytes per pixel
+    else {
+        return (NSUInteger)(image.size.width * image.scale * image.size.height * image.scale * 4.f);
+    }
+}
+
+#pragma mark Object creation and destruction
+
+- (id)initWithTotalCostLimit:(NSUInteger)totalCostLimit
+{
+    if ((self = [super init])) {
+        self.keyToImageMap = [NSMutableDictionary dictionary];
+        self.keys = [NSMutableArray array];
+        self.keyToCompletionBlocksMap = [NSMutableDictionary dictionary];
+        self.totalCostLimit = totalCostLimit;
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationDidReceiveMemoryWarning:)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+        
+        [[HLSMemoryAccountant sharedMemoryAccountant] registerSubsystem:self
+                                                               withName:@"Image cache"
+                                                          purgePriority:HLSMemoryPurgePriorityImageCache];
+    }
+    return self;
+}
+
+- (id)init
+{
+    return [self initWithTotalCostLimit:kImageCacheDefaultTotalCostLimit];
+}
+
+- (void)dealloc
+{
+    [[HLSMemoryAccountant sharedMemoryAccountant] unregisterSubsystem:self];
+    
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationDidReceiveMemoryWarningNotification
+                                                  object:nil];
+    
+    self.keyToImageMap = nil;
+    self.keys = nil;
+    self.keyToCompletionBlocksMap = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize keyToImageMap = m_keyToImageMap;
+
+@synthesize keys = m_keys;
+
+@synthesize keyToCompletionBlocksMap = m_keyToCompletionBlocksMap;
+
+@synthesize totalCostLimit = m_totalCostLimit;
+
+- (void)setTotalCostLimit:(NSUInteger)totalCostLimit
+{
+    m_totalCostLimit = totalCostLimit;
+    
+    [self evictImagesIfNeeded];
+}
+
+@synthesize totalCost = m_totalCost;
+
+#pragma mark Managing images
+
+- (UIImage *)imageForKey:(NSString *)key
+{
+    UIImage *image = [self.keyToImageMap objectForKey:key];
+    if (! image) {
+        return nil;
+    }
+    
+    // Mark as most recently used. The key is removed and added again, ensure it does not get deallocated in between
+    [[key retain] autorelease];
+    [self.keys removeObject:key];
+    [self.keys addObject:key];
+    
+    return image;
+}
+
+- (void)setImage:(UIImage *)image forKey:(NSString *)key
+{
+    [self removeImageForKey:key];
+    
+    if (! image) {
+        return;
+    }
+    
+    NSUInteger cost = [HLSImageCache costForImage:image];
+    if (cost > self.totalCostLimit) {
+        HLSLoggerDebug(@"The image for key %@ is larger than the cache limit and is not cached", key);
+        return;
+    }
+    
+    [self.keyToImageMap setObject:image forKey:key];
+    [self.keys addObject:key];
+    m_totalCost += cost;
+    
+    [self evictImagesIfNeeded];
+}
+
+- (void)removeImageForKey:(NSString *)key
+{
+    UIImage *image = [self.keyToImageMap objectForKey:key];
+    if (! image) {
+        return;
+    }
+    
+    m_totalCost -= [HLSImageCache costForImage:image];
+    [self.keys removeObject:key];
+    [self.keyToImageMap removeObjectForKey:key];
+}
+
+- (void)removeAllImages
+{
+    [self.keyToImageMap removeAllObjects];
+    [self.keys removeAllObjects];
+    m_totalCost = 0;
+}
+
+- (void)evictImagesIfNeeded
+{
+    while (m_totalCost > self.totalCostLimit && [self.keys count] != 0) {
+        // The array may hold the last reference to the key, which must survive its removal from the array
+        NSString *key = [[[self.keys objectAtIndex:0] retain] autorelease];
+        [self removeImageForKey:key];
+    }
+}
+
+- (UIImage *)imageNamed:(NSString *)imageName
+{
+    UIImage *image = [self imageForKey:imageName];
+    if (image) {
+        return image;
+    }
+    
+    image = [UIImage imageNamed:imageName];
+    [self setImage:image forKey:imageName];
+    return image;
+}
+
+- (UIImage *)stretchableImageNamed:(NSString *)imageName leftCapWidth:(NSInteger)leftCapWidth topCapHeight:(NSInteger)topCapHeight
+{
+    NSString *key = [NSString stringWithFormat:@"%@_%d_%d", imageName, leftCapWidth, topCapHeight];
+    UIImage *image = [self imageForKey:key];
+    if (image) {
+        return image;
+    }
+    
+    image = [[self imageNamed:imageName] stretchableImageWithLeftCapWidth:leftCapWidth topCapHeight:topCapHeight];
+    [self setImage:image forKey:key];
+    return image;
+}
+
+#pragma mark Loading images
+
+- (void)loadImageForKey:(NSString *)key
+              withBlock:(HLSImageCacheLoadBlock)loadBlock
+        completionBlock:(HLSImageCacheCompletionBlock)completionBlock
+{
+    UIImage *image = [self imageForKey:key];
+    if (image) {
+        if (completionBlock) {
+            completionBlock(image);
+        }
+        return;
+    }
+    
+    // Already being loaded. Just wait for the pending load to complete
+    NSMutableArray *completionBlocks = [self.keyToCompletionBlocksMap objectForKey:key];
+    if (completionBlocks) {
+        if (completionBlock) {
+            [completionBlocks addObject:[[completionBlock copy] autorelease]];
+        }
+        return;
+    }
+    
+    completionBlocks = [NSMutableArray array];
+    if (completionBlock) {
+        [completionBlocks addObject:[[completionBlock copy] autorelease]];
+    }
+    [self.keyToCompletionBlocksMap setObject:completionBlocks forKey:key];
+    
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        UIImage *loadedImage = loadBlock();
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self didLoadImage:loadedImage forKey:key];
+        });
+        
+        [pool drain];
+    });
+}
+
+- (BOOL)isLoadingImageForKey:(NSString *)key
+{
+    return [self.keyToCompletionBlocksMap objectForKey:key] != nil;
+}
+
+- (void)didLoadImage:(UIImage *)image forKey:(NSString *)key
+{
+    NSArray *completionBlocks = [[[self.keyToCompletionBlocksMap objectForKey:key] retain] autorelease];
+    [self.keyToCompletionBlocksMap removeObjectForKey:key];
+    
+    [self setImage:image forKey:key];
+    
+    for (HLSImageCacheCompletionBlock completionBlock in completionBlocks) {
+        completionBlock(image);
+    }
+}
+
+#pragma mark HLSMemoryAccounting protocol implementation
+
+- (NSUInteger)memoryFootprint
+{
+    return self.totalCost;
+}
+
+- (NSUInteger)purgeMemory
+{
+    NSUInteger totalCost = self.totalCost;
+    [self removeAllImages];
+    return totalCost;
+}
+
+#pragma mark Notification callbacks
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification
+{
+    // Purged by the accountant in order of priority
+    if ([[HLSMemoryAccountant sharedMemoryAccountant] isManagingSubsystem:self]) {
+        return;
+    }
+    
+    HLSLoggerInfo(@"Memory warning received; remove all images from the cache");
+    [self removeAllImages];
+}
+
+@end
@@ -6,11 +6,18 @@
 //  Copyright 2011 Hortis. All rights reserved.
 //
 
+// Forward declarations
+@protocol HLSKeyboardInformationObserver;
+
 /**
  * This class makes keyboard properties accessible at any time in a convenient way. Just access the +keyboardInformation 
  * method. If the returned object is not nil, then the keyboard is docked and visible (or soon will) and you can check its 
  * properties. The object is nil if the keyboard is floating (iPad) or invisible.
  *
+ * The class is the only object observing keyboard notifications in CoconutKit. Objects which need to respond to keyboard
+ * events can be attached to it, so that keyboard notifications are received once, however many objects need them.
+ * Must only be used from the main thread
+ *
  * Not meant to be instantiated directly. Simply use the +keyboardInformation class method.
  */
 @interface HLSKeyboardInformation : NSObject {
@@ -27,6 +34,13 @@
  */
 + (HLSKeyboardInformation *)keyboardInformation;
 
+/**
+ * Attach / detach an observer. Observers are not retained and must therefore be detached before they are deallocated.
+ * Observers are notified after the keyboard information has been updated
+ */
++ (void)addObserver:(id<HLSKeyboardInformationObserver>)observer;
++ (void)removeObserver:(id<HLSKeyboardInformationObserver>)observer;
+
 /**
  * Start frame of the keyboard before it is displayed (in the window coordinate system). Refer to the 
  * UIKeyboardFrameBeginUserInfoKey documentation for how to translate this frame into a meaningful coordinate system
@@ -51,3 +65,16 @@
 @property (nonatomic, readonly, assign) UIViewAnimationCurve animationCurve;
 
 @end
+
+@protocol HLSKeyboardInformationObserver <NSObject>
+
+@optional
+
+/**
+ * Called when the keyboard is about to be displayed, respectively hidden. When the device is rotated while the keyboard
+ * is visible, the keyboard is hidden (with the old orientation), then displayed again (with the new one)
+ */
+- (void)keyboardWillShowWithInformation:(HLSKeyboardInformation *)keyboardInformation;
+- (void)keyboardWillHide;
+
+@end
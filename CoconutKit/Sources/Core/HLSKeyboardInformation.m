@@ -25,6 +25,9 @@
 
 static HLSKeyboardInformation *s_instance = nil;
 
+// Observers (not retained)
+static CFMutableArrayRef s_observers = NULL;
+
 @implementation HLSKeyboardInformation
 
 #pragma mark Class methods
@@ -49,6 +52,38 @@ static HLSKeyboardInformation *s_instance = nil;
     return s_instance;
 }
 
++ (void)addObserver:(id<HLSKeyboardInformationObserver>)observer
+{
+    if (! observer) {
+        HLSLoggerError(@"Missing observer");
+        return;
+    }
+    
+    if (! s_observers) {
+        s_observers = CFArrayCreateMutable(kCFAllocatorDefault, 0, NULL);
+    }
+    
+    if (CFArrayContainsValue(s_observers, CFRangeMake(0, CFArrayGetCount(s_observers)), observer)) {
+        return;
+    }
+    
+    CFArrayAppendValue(s_observers, observer);
+}
+
++ (void)removeObserver:(id<HLSKeyboardInformationObserver>)observer
+{
+    if (! s_observers) {
+        return;
+    }
+    
+    CFIndex index = CFArrayGetFirstIndexOfValue(s_observers, CFRangeMake(0, CFArrayGetCount(s_observers)), observer);
+    if (index == kCFNotFound) {
+        return;
+    }
+    
+    CFArrayRemoveValueAtIndex(s_observers, index);
+}
+
 #pragma mark Object creation and destruction
 
 - (id)initWithUserInfo:(NSDictionary *)userInfo
@@ -94,7 +129,16 @@ static HLSKeyboardInformation *s_instance = nil;
 + (void)keyboardWillShow:(NSNotification *)notification
 {
     HLSLoggerDebug(@"Keyboard shown");
+    [s_instance release];
     s_instance = [[HLSKeyboardInformation alloc] initWithUserInfo:[notification userInfo]];
+    
+    // Observers might detach while being notified
+    NSArray *observers = [NSArray arrayWithArray:(NSArray *)s_observers];
+    for (id<HLSKeyboardInformationObserver> observer in observers) {
+        if ([observer respondsToSelector:@selector(keyboardWillShowWithInformation:)]) {
+            [observer keyboardWillShowWithInformation:s_instance];
+        }
+    }
 }
 
 + (void)keyboardWillHide:(NSNotification *)notification
@@ -102,6 +146,13 @@ static HLSKeyboardInformation *s_instance = nil;
     HLSLoggerDebug(@"Keyboard hidden");
     [s_instance release];
     s_instance = nil;
+    
+    NSArray *observers = [NSArray arrayWithArray:(NSArray *)s_observers];
+    for (id<HLSKeyboardInformationObserver> observer in observers) {
+        if ([observer respondsToSelector:@selector(keyboardWillHide)]) {
+            [observer keyboardWillHide];
+        }
+    }
 }
 
 @end
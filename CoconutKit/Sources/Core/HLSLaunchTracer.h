@@ -0,0 +1,39 @@
+//
+//  HLSLaunchTracer.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 29.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * An opt-in tracer measuring the time CoconutKit spends initializing itself during application launch (constructors,
+ * method swizzling in +load methods, class list scans, logger setup, etc.). Most of this work happens before main()
+ * is called, prior to any application code. The tracer is therefore enabled by setting the HLSLaunchTracingEnabled 
+ * environment variable to 1 (e.g. in the Xcode scheme arguments). When disabled, tracing costs a single test.
+ *
+ * Measurements with the same name are accumulated. The report lists them by decreasing total duration, together
+ * with the time elapsed between process start and the first measurement (values lower than the time at which main() 
+ * is called correspond to pre-main work). It is logged when the application has finished launching, and also
+ * contains the total time elapsed since process start for comparison.
+ *
+ * The tracing functions do not create any Objective-C object and can be used where no autorelease pool is available.
+ * They can also be used to trace application code
+ */
+
+/**
+ * Return YES iff tracing is enabled
+ */
+BOOL HLSLaunchTracerIsEnabled(void);
+
+/**
+ * Call HLSLaunchTracerBegin() before the code to be measured, and HLSLaunchTracerEnd() after it, passing the value
+ * returned by HLSLaunchTracerBegin() and a name (a C string literal, e.g. "HLSStandardFileManagerInstall")
+ */
+CFAbsoluteTime HLSLaunchTracerBegin(void);
+void HLSLaunchTracerEnd(const char *name, CFAbsoluteTime startTime);
+
+/**
+ * Return the report for all measurements made so far, nil if tracing is disabled
+ */
+NSString *HLSLaunchTracerReport(void);
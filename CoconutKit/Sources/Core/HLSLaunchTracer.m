@@ -0,0 +1,162 @@
+//
+//  HLSLaunchTracer.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 29.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSLaunchTracer.h"
+
+#import <libkern/OSAtomic.h>
+#import <sys/sysctl.h>
+
+// Name of the environment variable enabling tracing
+static const char * const kLaunchTracingEnabledVariableName = "HLSLaunchTracingEnabled";
+
+/**
+ * Measurements accumulated for a name
+ */
+typedef struct {
+    const char *name;
+    NSUInteger count;
+    CFAbsoluteTime firstStartTime;
+    CFAbsoluteTime totalDuration;
+} HLSLaunchTraceRecord;
+
+// Records, in the order in which names have first been measured
+static HLSLaunchTraceRecord *s_records = NULL;
+static NSUInteger s_numberOfRecords = 0;
+static OSSpinLock s_recordsLock = OS_SPINLOCK_INIT;
+
+// Function declarations
+static CFAbsoluteTime processStartTime(void);
+static int compareRecordDurations(const void *record1, const void *record2);
+
+__attribute__ ((constructor)) static void HLSLaunchTracerInstall(void)
+{
+    if (! HLSLaunchTracerIsEnabled()) {
+        return;
+    }
+    
+    // Log the report when the application has finished launching, with the whole launch duration for comparison
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidFinishLaunchingNotification 
+                                                      object:nil 
+                                                       queue:nil 
+                                                  usingBlock:^(NSNotification *notification) {
+                                                      HLSLaunchTracerEnd("(Process start to application launch)", processStartTime());
+                                                      NSLog(@"%@", HLSLaunchTracerReport());
+                                                  }];
+    [pool drain];
+}
+
+BOOL HLSLaunchTracerIsEnabled(void)
+{
+    static BOOL s_enabled = NO;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        const char *value = getenv(kLaunchTracingEnabledVariableName);
+        s_enabled = value && strcmp(value, "1") == 0;
+    });
+    return s_enabled;
+}
+
+CFAbsoluteTime HLSLaunchTracerBegin(void)
+{
+    return HLSLaunchTracerIsEnabled() ? CFAbsoluteTimeGetCurrent() : 0.;
+}
+
+void HLSLaunchTracerEnd(const char *name, CFAbsoluteTime startTime)
+{
+    if (! HLSLaunchTracerIsEnabled()) {
+        return;
+    }
+    
+    CFAbsoluteTime duration = CFAbsoluteTimeGetCurrent() - startTime;
+    
+    OSSpinLockLock(&s_recordsLock);
+    
+    HLSLaunchTraceRecord *record = NULL;
+    for (NSUInteger i = 0; i < s_numberOfRecords; ++i) {
+        if (strcmp(s_records[i].name, name) == 0) {
+            record = &s_records[i];
+            break;
+        }
+    }
+    
+    if (! record) {
+        s_records = realloc(s_records, (s_numberOfRecords + 1) * sizeof(HLSLaunchTraceRecord));
+        record = &s_records[s_numberOfRecords];
+        record->name = name;
+        record->count = 0;
+        record->firstStartTime = startTime;
+        record->totalDuration = 0.;
+        ++s_numberOfRecords;
+    }
+    
+    ++record->count;
+    record->totalDuration += duration;
+    
+    OSSpinLockUnlock(&s_recordsLock);
+}
+
+NSString *HLSLaunchTracerReport(void)
+{
+    if (! HLSLaunchTracerIsEnabled()) {
+        return nil;
+    }
+    
+    // Work on a copy, sorted by decreasing duration
+    OSSpinLockLock(&s_recordsLock);
+    NSUInteger numberOfRecords = s_numberOfRecords;
+    HLSLaunchTraceRecord *records = malloc(MAX(numberOfRecords, 1) * sizeof(HLSLaunchTraceRecord));
+    memcpy(records, s_records, numberOfRecords * sizeof(HLSLaunchTraceRecord));
+    OSSpinLockUnlock(&s_recordsLock);
+    
+    qsort(records, numberOfRecords, sizeof(HLSLaunchTraceRecord), compareRecordDurations);
+    
+    CFAbsoluteTime startTime = processStartTime();
+    NSMutableString *report = [NSMutableString stringWithString:@"CoconutKit launch trace:"];
+    CFAbsoluteTime totalDuration = 0.;
+    for (NSUInteger i = 0; i < numberOfRecords; ++i) {
+        HLSLaunchTraceRecord record = records[i];
+        [report appendFormat:@"\n    %s: %.3f ms (%u time(s), first at %.3f ms after process start)", record.name,
+            record.totalDuration * 1000., record.count, (record.firstStartTime - startTime) * 1000.];
+        totalDuration += record.totalDuration;
+    }
+    [report appendFormat:@"\n    Total: %.3f ms", totalDuration * 1000.];
+    free(records);
+    
+    return [NSString stringWithString:report];
+}
+
+#pragma mark Static functions
+
+static CFAbsoluteTime processStartTime(void)
+{
+    int mib[4] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+    struct kinfo_proc processInfo;
+    size_t size = sizeof(processInfo);
+    if (sysctl(mib, 4, &processInfo, &size, NULL, 0) != 0) {
+        return 0.;
+    }
+    
+    struct timeval startTime = processInfo.kp_proc.p_starttime;
+    return startTime.tv_sec + startTime.tv_usec / 1e6 - kCFAbsoluteTimeIntervalSince1970;
+}
+
+static int compareRecordDurations(const void *record1, const void *record2)
+{
+    CFAbsoluteTime duration1 = ((const HLSLaunchTraceRecord *)record1)->totalDuration;
+    CFAbsoluteTime duration2 = ((const HLSLaunchTraceRecord *)record2)->totalDuration;
+    if (duration1 > duration2) {
+        return -1;
+    }
+    else if (duration1 < duration2) {
+        return 1;
+    }
+    else {
+        return 0;
+    }
+}
@@ -0,0 +1,119 @@
+//
+//  HLSMemoryAccountant.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Purge priorities of the CoconutKit subsystems. Subsystems with lower priorities are purged first
+ */
+extern const NSInteger HLSMemoryPurgePriorityImageCache;                // Images (in particular those of slideshows)
+extern const NSInteger HLSMemoryPurgePriorityLocalizationCache;         // Parsed strings tables
+extern const NSInteger HLSMemoryPurgePriorityTaskManager;               // Return information cached by task managers
+extern const NSInteger HLSMemoryPurgePriorityViewMemoryCoordinator;     // Views of the child view controllers of containers
+extern const NSInteger HLSMemoryPurgePriorityZeroingWeakRefs;           // Zeroing weak references (cannot be purged)
+
+/**
+ * Protocol to be implemented by subsystems whose memory is accounted for by the memory accountant
+ */
+@protocol HLSMemoryAccounting <NSObject>
+
+/**
+ * Return an estimate of the number of bytes currently used by the subsystem
+ */
+- (NSUInteger)memoryFootprint;
+
+@optional
+
+/**
+ * Release as much memory as possible (caches, unloadable views, etc.), and return an estimate of the number of bytes
+ * which have been released. Subsystems not implementing this method are only reported
+ */
+- (NSUInteger)purgeMemory;
+
+@end
+
+/**
+ * Keeps track of the memory used by subsystems implementing the HLSMemoryAccounting protocol, so that a report of the
+ * memory used by each of them can be obtained at any time (e.g. to find out which cache should be bounded). When a
+ * memory warning is received, subsystems are purged in order of increasing priority, until their total memory
+ * footprint fits into the target memory footprint. This way, cheap-to-rebuild caches are shed before views are
+ * unloaded, and only as much as needed is released
+ *
+ * The following CoconutKit subsystems register automatically when they are first used:
+ *   - HLSImageCache objects, in particular the shared one (images loaded by CoconutKit classes, e.g. HLSSlideshow)
+ *   - the localization cache of NSBundle (HLSDynamicLocalization), i.e. the parsed strings tables
+ *   - the default HLSTaskManager (cached return information)
+ *   - the shared HLSViewMemoryCoordinator, when enabled (views of the child view controllers of containers)
+ *   - zeroing weak references (reported only)
+ * While automatic purging is enabled, these subsystems do not release their memory on their own when a memory warning
+ * is received. Other subsystems (e.g. caches of your application) can be registered as well. Task managers other than
+ * the default one are not registered automatically since they can be used from any thread
+ *
+ * Footprints are estimates, computed when a report is requested or when memory is purged. Reports must be requested
+ * and memory purged from the main thread. Subsystems can be registered and unregistered from any thread
+ *
+ * Designated initializer: -init (but use the +sharedMemoryAccountant singleton)
+ */
+@interface HLSMemoryAccountant : NSObject {
+@private
+    NSMutableArray *m_subsystemRecords;            // sorted by increasing purge priority
+    NSUInteger m_targetMemoryFootprint;
+    BOOL m_automaticPurgeEnabled;
+}
+
+/**
+ * The accountant singleton
+ */
++ (HLSMemoryAccountant *)sharedMemoryAccountant;
+
+/**
+ * Register a subsystem with a name (used in reports) and a purge priority (see the HLSMemoryPurgePriority constants
+ * for the priorities of the CoconutKit subsystems). Subsystems are not retained and must therefore be unregistered
+ * before they are deallocated. Can be called from any thread
+ */
+- (void)registerSubsystem:(id<HLSMemoryAccounting>)subsystem withName:(NSString *)name purgePriority:(NSInteger)purgePriority;
+- (void)unregisterSubsystem:(id<HLSMemoryAccounting>)subsystem;
+
+/**
+ * Return YES iff the subsystem has been registered and automatic purging is enabled, i.e. iff the subsystem must not
+ * release its memory on its own when a memory warning is received
+ */
+- (BOOL)isManagingSubsystem:(id<HLSMemoryAccounting>)subsystem;
+
+/**
+ * Set to YES to purge subsystems when a memory warning is received
+ *
+ * Default value is YES
+ */
+@property (nonatomic, assign, getter=isAutomaticPurgeEnabled) BOOL automaticPurgeEnabled;
+
+/**
+ * The total memory footprint (in bytes) of the registered subsystems which can be kept after a memory warning has
+ * been received
+ *
+ * Default value is 0 (all subsystems are purged)
+ */
+@property (nonatomic, assign) NSUInteger targetMemoryFootprint;
+
+/**
+ * Return the sum of the memory footprints of all registered subsystems. Must be called from the main thread
+ */
+- (NSUInteger)totalMemoryFootprint;
+
+/**
+ * Return a human-readable report listing the memory footprint of each registered subsystem, in purge order. Must be
+ * called from the main thread
+ */
+- (NSString *)memoryFootprintReport;
+
+/**
+ * Purge subsystems in order of increasing priority until the total memory footprint fits into the target memory
+ * footprint. Called when a memory warning is received if automatic purging is enabled, but you can call it at any
+ * time. Must be called from the main thread. Return an estimate of the number of bytes which have been released
+ */
+- (NSUInteger)purgeMemory;
+
+@end
@@ -0,0 +1,261 @@
+//
+//  HLSMemoryAccountant.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSMemoryAccountant.h"
+
+#import "HLSLogger.h"
+
+const NSInteger HLSMemoryPurgePriorityImageCache = 100;
+const NSInteger HLSMemoryPurgePriorityLocalizationCache = 200;
+const NSInteger HLSMemoryPurgePriorityTaskManager = 300;
+const NSInteger HLSMemoryPurgePriorityViewMemoryCoordinator = 400;
+const NSInteger HLSMemoryPurgePriorityZeroingWeakRefs = 1000;
+
+#pragma mark -
+#pragma mark HLSMemorySubsystemRecord class interface
+
+/**
+ * A subsystem registered with the accountant
+ */
+@interface HLSMemorySubsystemRecord : NSObject {
+@private
+    id<HLSMemoryAccounting> m_subsystem;
+    NSString *m_name;
+    NSInteger m_purgePriority;
+}
+
+@property (nonatomic, assign) id<HLSMemoryAccounting> subsystem;
+@property (nonatomic, retain) NSString *name;
+@property (nonatomic, assign) NSInteger purgePriority;
+
+@end
+
+#pragma mark -
+#pragma mark HLSMemoryAccountant class
+
+@interface HLSMemoryAccountant ()
+
+@property (nonatomic, retain) NSMutableArray *subsystemRecords;
+
+- (HLSMemorySubsystemRecord *)subsystemRecordForSubsystem:(id<HLSMemoryAccounting>)subsystem;
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification;
+
+@end
+
+@implementation HLSMemoryAccountant
+
+#pragma mark Class methods
+
++ (HLSMemoryAccountant *)sharedMemoryAccountant
+{
+    static HLSMemoryAccountant *s_instance = nil;
+    
+    @synchronized(self) {
+        if (! s_instance) {
+            s_instance = [[HLSMemoryAccountant alloc] init];
+        }
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.subsystemRecords = [NSMutableArray array];
+        self.automaticPurgeEnabled = YES;
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationDidReceiveMemoryWarning:)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationDidReceiveMemoryWarningNotification
+                                                  object:nil];
+    
+    self.subsystemRecords = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize subsystemRecords = m_subsystemRecords;
+
+@synthesize automaticPurgeEnabled = m_automaticPurgeEnabled;
+
+@synthesize targetMemoryFootprint = m_targetMemoryFootprint;
+
+#pragma mark Registering subsystems
+
+- (void)registerSubsystem:(id<HLSMemoryAccounting>)subsystem withName:(NSString *)name purgePriority:(NSInteger)purgePriority
+{
+    if (! subsystem) {
+        HLSLoggerError(@"Missing subsystem");
+        return;
+    }
+    
+    @synchronized(self) {
+        if ([self subsystemRecordForSubsystem:subsystem]) {
+            HLSLoggerWarn(@"The subsystem %@ has already been registered", name);
+            return;
+        }
+        
+        HLSMemorySubsystemRecord *subsystemRecord = [[[HLSMemorySubsystemRecord alloc] init] autorelease];
+        subsystemRecord.subsystem = subsystem;
+        subsystemRecord.name = name;
+        subsystemRecord.purgePriority = purgePriority;
+        
+        // Keep sorted by increasing priority. Subsystems with the same priority are purged in registration order
+        NSUInteger index = 0;
+        while (index < [self.subsystemRecords count]
+               && [[self.subsystemRecords objectAtIndex:index] purgePriority] <= purgePriority) {
+            ++index;
+        }
+        [self.subsystemRecords insertObject:subsystemRecord atIndex:index];
+    }
+}
+
+- (void)unregisterSubsystem:(id<HLSMemoryAccounting>)subsystem
+{
+    @synchronized(self) {
+        HLSMemorySubsystemRecord *subsystemRecord = [self subsystemRecordForSubsystem:subsystem];
+        if (! subsystemRecord) {
+            return;
+        }
+        
+        [self.subsystemRecords removeObject:subsystemRecord];
+    }
+}
+
+- (BOOL)isManagingSubsystem:(id<HLSMemoryAccounting>)subsystem
+{
+    @synchronized(self) {
+        return self.automaticPurgeEnabled && [self subsystemRecordForSubsystem:subsystem] != nil;
+    }
+}
+
+// Must be called with the lock acquired
+- (HLSMemorySubsystemRecord *)subsystemRecordForSubsystem:(id<HLSMemoryAccounting>)subsystem
+{
+    for (HLSMemorySubsystemRecord *subsystemRecord in self.subsystemRecords) {
+        if (subsystemRecord.subsystem == subsystem) {
+            return subsystemRecord;
+        }
+    }
+    return nil;
+}
+
+#pragma mark Reporting
+
+- (NSUInteger)totalMemoryFootprint
+{
+    NSUInteger totalMemoryFootprint = 0;
+    @synchronized(self) {
+        for (HLSMemorySubsystemRecord *subsystemRecord in self.subsystemRecords) {
+            totalMemoryFootprint += [subsystemRecord.subsystem memoryFootprint];
+        }
+    }
+    return totalMemoryFootprint;
+}
+
+- (NSString *)memoryFootprintReport
+{
+    NSMutableArray *lines = [NSMutableArray array];
+    NSUInteger totalMemoryFootprint = 0;
+    @synchronized(self) {
+        for (HLSMemorySubsystemRecord *subsystemRecord in self.subsystemRecords) {
+            NSUInteger memoryFootprint = [subsystemRecord.subsystem memoryFootprint];
+            totalMemoryFootprint += memoryFootprint;
+            
+            BOOL purgeable = [subsystemRecord.subsystem respondsToSelector:@selector(purgeMemory)];
+            [lines addObject:[NSString stringWithFormat:@"  %@: %.1f KB (priority %d%@)",
+                              subsystemRecord.name,
+                              memoryFootprint / 1024.,
+                              subsystemRecord.purgePriority,
+                              purgeable ? @"" : @", not purgeable"]];
+        }
+    }
+    [lines insertObject:[NSString stringWithFormat:@"Estimated memory footprint: %.1f KB", totalMemoryFootprint / 1024.] atIndex:0];
+    return [lines componentsJoinedByString:@"\n"];
+}
+
+#pragma mark Purging
+
+- (NSUInteger)purgeMemory
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    NSUInteger purgedMemoryFootprint = 0;
+    @synchronized(self) {
+        NSUInteger totalMemoryFootprint = [self totalMemoryFootprint];
+        for (HLSMemorySubsystemRecord *subsystemRecord in [NSArray arrayWithArray:self.subsystemRecords]) {
+            if (totalMemoryFootprint <= self.targetMemoryFootprint) {
+                break;
+            }
+            
+            if (! [subsystemRecord.subsystem respondsToSelector:@selector(purgeMemory)]) {
+                continue;
+            }
+            
+            NSUInteger releasedMemoryFootprint = MIN([subsystemRecord.subsystem purgeMemory], totalMemoryFootprint);
+            HLSLoggerDebug(@"Purged %@ (%u bytes)", subsystemRecord.name, releasedMemoryFootprint);
+            totalMemoryFootprint -= releasedMemoryFootprint;
+            purgedMemoryFootprint += releasedMemoryFootprint;
+        }
+    }
+    
+    HLSLoggerInfo(@"Purged an estimated %u bytes", purgedMemoryFootprint);
+    return purgedMemoryFootprint;
+}
+
+#pragma mark Notification callbacks
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification
+{
+    if (! self.automaticPurgeEnabled) {
+        return;
+    }
+    
+    HLSLoggerInfo(@"Memory warning received; purging subsystems");
+    [self purgeMemory];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSMemorySubsystemRecord class implementation
+
+@implementation HLSMemorySubsystemRecord
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.name = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize subsystem = m_subsystem;
+
+@synthesize name = m_name;
+
+@synthesize purgePriority = m_purgePriority;
+
+@end
@@ -0,0 +1,25 @@
+//
+//  HLSMemoryFileManager.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 31.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFileManager.h"
+
+/**
+ * A file manager storing a whole file hierarchy in memory, without any system call. Useful for tests or for ephemeral
+ * caches. Each instance manages its own hierarchy, initially made of an empty root directory. Errors are reported
+ * in the NSCocoaErrorDomain, with the same codes as NSFileManager.
+ *
+ * All methods are thread-safe
+ *
+ * Designated initializer: -init
+ */
+@interface HLSMemoryFileManager : HLSFileManager {
+@private
+    NSMutableDictionary *m_rootDirectory;
+}
+
+@end
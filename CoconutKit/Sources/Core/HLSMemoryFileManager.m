@@ -0,0 +1,532 @@
+//
+//  HLSMemoryFileManager.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 31.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSMemoryFileManager.h"
+
+#import "HLSAssert.h"
+
+// Directories are stored as NSMutableDictionary objects (item name -> item), files as NSMutableData objects
+
+// Function declarations
+static NSArray *pathComponents(NSString *path);
+static id copyOfItem(id item);
+static BOOL isDirectory(id item);
+static void addItems(NSDictionary *directory, NSString *relativePath, HLSFileAttributes attributes, BOOL recursive, NSMutableArray *items);
+static NSError *fileError(NSInteger code, NSString *path);
+
+#pragma mark -
+#pragma mark HLSMemoryFileHandle class interface
+
+/**
+ * Handle to a file of a memory file manager. The file data is retained, reads and writes are synchronized on the
+ * file manager
+ *
+ * Designated initializer: -initWithFileManager:data:appending:
+ */
+@interface HLSMemoryFileHandle : NSObject <HLSFileHandle> {
+@private
+    HLSMemoryFileManager *m_fileManager;
+    NSMutableData *m_data;
+    BOOL m_appending;
+}
+
+- (id)initWithFileManager:(HLSMemoryFileManager *)fileManager data:(NSMutableData *)data appending:(BOOL)appending;
+
+@end
+
+#pragma mark -
+#pragma mark HLSMemoryFileManager class interface extension
+
+@interface HLSMemoryFileManager ()
+
+@property (nonatomic, retain) NSMutableDictionary *rootDirectory;
+
+- (id)itemAtPath:(NSString *)path;
+- (NSMutableDictionary *)parentDirectoryForPath:(NSString *)path error:(NSError **)pError;
+
+- (NSMutableData *)fileDataForHandleAtPath:(NSString *)path truncate:(BOOL)truncate error:(NSError **)pError;
+
+@end
+
+#pragma mark -
+#pragma mark HLSMemoryFileManager class implementation
+
+@implementation HLSMemoryFileManager
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.rootDirectory = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    self.rootDirectory = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize rootDirectory = m_rootDirectory;
+
+#pragma mark Items
+
+- (id)itemAtPath:(NSString *)path
+{
+    id item = self.rootDirectory;
+    for (NSString *component in pathComponents(path)) {
+        if (! isDirectory(item)) {
+            return nil;
+        }
+        
+        item = [item objectForKey:component];
+        if (! item) {
+            return nil;
+        }
+    }
+    return item;
+}
+
+- (NSMutableDictionary *)parentDirectoryForPath:(NSString *)path error:(NSError **)pError
+{
+    NSArray *components = pathComponents(path);
+    if ([components count] == 0) {
+        // The root has no parent
+        if (pError) {
+            *pError = fileError(NSFileWriteNoPermissionError, path);
+        }
+        return nil;
+    }
+    
+    id parentItem = [self itemAtPath:[NSString pathWithComponents:[[NSArray arrayWithObject:@"/"] 
+                                                                    arrayByAddingObjectsFromArray:[components subarrayWithRange:NSMakeRange(0, [components count] - 1)]]]];
+    if (! isDirectory(parentItem)) {
+        if (pError) {
+            *pError = fileError(NSFileNoSuchFileError, path);
+        }
+        return nil;
+    }
+    return parentItem;
+}
+
+- (NSMutableData *)fileDataForHandleAtPath:(NSString *)path truncate:(BOOL)truncate error:(NSError **)pError
+{
+    @synchronized(self) {
+        id item = [self itemAtPath:path];
+        if (isDirectory(item)) {
+            if (pError) {
+                *pError = fileError(NSFileWriteUnknownError, path);
+            }
+            return nil;
+        }
+        
+        if (! item) {
+            NSMutableDictionary *parentDirectory = [self parentDirectoryForPath:path error:pError];
+            if (! parentDirectory) {
+                return nil;
+            }
+            
+            item = [NSMutableData data];
+            [parentDirectory setObject:item forKey:[pathComponents(path) lastObject]];
+        }
+        else if (truncate) {
+            [item setLength:0];
+        }
+        return item;
+    }
+}
+
+#pragma mark HLSFileManagerAbstract protocol implementation
+
+- (NSData *)contentsOfFileAtPath:(NSString *)path error:(NSError **)pError
+{
+    @synchronized(self) {
+        id item = [self itemAtPath:path];
+        if (! item || isDirectory(item)) {
+            if (pError) {
+                *pError = fileError(NSFileReadNoSuchFileError, path);
+            }
+            return nil;
+        }
+        return [NSData dataWithData:item];
+    }
+}
+
+- (BOOL)createFileAtPath:(NSString *)path contents:(NSData *)contents error:(NSError **)pError
+{
+    @synchronized(self) {
+        if (isDirectory([self itemAtPath:path])) {
+            if (pError) {
+                *pError = fileError(NSFileWriteFileExistsError, path);
+            }
+            return NO;
+        }
+        
+        NSMutableDictionary *parentDirectory = [self parentDirectoryForPath:path error:pError];
+        if (! parentDirectory) {
+            return NO;
+        }
+        
+        [parentDirectory setObject:[NSMutableData dataWithData:contents] forKey:[pathComponents(path) lastObject]];
+        return YES;
+    }
+}
+
+- (id<HLSFileHandle>)fileHandleForReadingAtPath:(NSString *)path error:(NSError **)pError
+{
+    @synchronized(self) {
+        id item = [self itemAtPath:path];
+        if (! item || isDirectory(item)) {
+            if (pError) {
+                *pError = fileError(NSFileReadNoSuchFileError, path);
+            }
+            return nil;
+        }
+        return [[[HLSMemoryFileHandle alloc] initWithFileManager:self data:item appending:NO] autorelease];
+    }
+}
+
+- (id<HLSFileHandle>)fileHandleForWritingAtPath:(NSString *)path error:(NSError **)pError
+{
+    NSMutableData *data = [self fileDataForHandleAtPath:path truncate:YES error:pError];
+    if (! data) {
+        return nil;
+    }
+    return [[[HLSMemoryFileHandle alloc] initWithFileManager:self data:data appending:NO] autorelease];
+}
+
+- (id<HLSFileHandle>)fileHandleForAppendingAtPath:(NSString *)path error:(NSError **)pError
+{
+    NSMutableData *data = [self fileDataForHandleAtPath:path truncate:NO error:pError];
+    if (! data) {
+        return nil;
+    }
+    return [[[HLSMemoryFileHandle alloc] initWithFileManager:self data:data appending:YES] autorelease];
+}
+
+- (BOOL)createDirectoryAtPath:(NSString *)path withIntermediateDirectories:(BOOL)withIntermediateDirectories error:(NSError **)pError
+{
+    @synchronized(self) {
+        // Same behavior as NSFileManager when the directory already exists
+        id existingItem = [self itemAtPath:path];
+        if (existingItem) {
+            if (isDirectory(existingItem) && withIntermediateDirectories) {
+                return YES;
+            }
+            
+            if (pError) {
+                *pError = fileError(NSFileWriteFileExistsError, path);
+            }
+            return NO;
+        }
+        
+        if (! withIntermediateDirectories) {
+            NSMutableDictionary *parentDirectory = [self parentDirectoryForPath:path error:pError];
+            if (! parentDirectory) {
+                return NO;
+            }
+            
+            [parentDirectory setObject:[NSMutableDictionary dictionary] forKey:[pathComponents(path) lastObject]];
+            return YES;
+        }
+        
+        NSMutableDictionary *directory = self.rootDirectory;
+        for (NSString *component in pathComponents(path)) {
+            id item = [directory objectForKey:component];
+            if (! item) {
+                item = [NSMutableDictionary dictionary];
+                [directory setObject:item forKey:component];
+            }
+            else if (! isDirectory(item)) {
+                if (pError) {
+                    *pError = fileError(NSFileWriteFileExistsError, path);
+                }
+                return NO;
+            }
+            directory = item;
+        }
+        return YES;
+    }
+}
+
+- (NSArray *)contentsOfDirectoryAtPath:(NSString *)path error:(NSError **)pError
+{
+    @synchronized(self) {
+        id item = [self itemAtPath:path];
+        if (! isDirectory(item)) {
+            if (pError) {
+                *pError = fileError(NSFileReadNoSuchFileError, path);
+            }
+            return nil;
+        }
+        return [item allKeys];
+    }
+}
+
+- (NSArray *)itemsInDirectoryAtPath:(NSString *)path 
+                         attributes:(HLSFileAttributes)attributes 
+                          recursive:(BOOL)recursive 
+                              error:(NSError **)pError
+{
+    @synchronized(self) {
+        id item = [self itemAtPath:path];
+        if (! isDirectory(item)) {
+            if (pError) {
+                *pError = fileError(NSFileReadNoSuchFileError, path);
+            }
+            return nil;
+        }
+        
+        NSMutableArray *items = [NSMutableArray array];
+        addItems(item, nil, attributes, recursive, items);
+        return [NSArray arrayWithArray:items];
+    }
+}
+
+- (BOOL)fileExistsAtPath:(NSString *)path isDirectory:(BOOL *)pIsDirectory
+{
+    @synchronized(self) {
+        id item = [self itemAtPath:path];
+        if (pIsDirectory) {
+            *pIsDirectory = isDirectory(item);
+        }
+        return item != nil;
+    }
+}
+
+- (BOOL)copyItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)pError
+{
+    @synchronized(self) {
+        id item = [self itemAtPath:sourcePath];
+        if (! item) {
+            if (pError) {
+                *pError = fileError(NSFileNoSuchFileError, sourcePath);
+            }
+            return NO;
+        }
+        
+        if ([self itemAtPath:destinationPath]) {
+            if (pError) {
+                *pError = fileError(NSFileWriteFileExistsError, destinationPath);
+            }
+            return NO;
+        }
+        
+        NSMutableDictionary *parentDirectory = [self parentDirectoryForPath:destinationPath error:pError];
+        if (! parentDirectory) {
+            return NO;
+        }
+        
+        id itemCopy = copyOfItem(item);
+        [parentDirectory setObject:itemCopy forKey:[pathComponents(destinationPath) lastObject]];
+        [itemCopy release];
+        return YES;
+    }
+}
+
+- (BOOL)moveItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)pError
+{
+    @synchronized(self) {
+        id item = [self itemAtPath:sourcePath];
+        NSMutableDictionary *sourceParentDirectory = [self parentDirectoryForPath:sourcePath error:pError];
+        if (! item || ! sourceParentDirectory) {
+            if (pError) {
+                *pError = fileError(NSFileNoSuchFileError, sourcePath);
+            }
+            return NO;
+        }
+        
+        if ([self itemAtPath:destinationPath]) {
+            if (pError) {
+                *pError = fileError(NSFileWriteFileExistsError, destinationPath);
+            }
+            return NO;
+        }
+        
+        // A directory cannot be moved into itself
+        NSArray *sourceComponents = pathComponents(sourcePath);
+        NSArray *destinationComponents = pathComponents(destinationPath);
+        if ([destinationComponents count] > [sourceComponents count]
+                && [[destinationComponents subarrayWithRange:NSMakeRange(0, [sourceComponents count])] isEqualToArray:sourceComponents]) {
+            if (pError) {
+                *pError = fileError(NSFileWriteUnknownError, destinationPath);
+            }
+            return NO;
+        }
+        
+        NSMutableDictionary *destinationParentDirectory = [self parentDirectoryForPath:destinationPath error:pError];
+        if (! destinationParentDirectory) {
+            return NO;
+        }
+        
+        [destinationParentDirectory setObject:item forKey:[destinationComponents lastObject]];
+        [sourceParentDirectory removeObjectForKey:[sourceComponents lastObject]];
+        return YES;
+    }
+}
+
+- (BOOL)removeItemAtPath:(NSString *)path error:(NSError **)pError
+{
+    @synchronized(self) {
+        NSMutableDictionary *parentDirectory = [self parentDirectoryForPath:path error:pError];
+        if (! parentDirectory) {
+            return NO;
+        }
+        
+        NSString *name = [pathComponents(path) lastObject];
+        if (! [parentDirectory objectForKey:name]) {
+            if (pError) {
+                *pError = fileError(NSFileNoSuchFileError, path);
+            }
+            return NO;
+        }
+        
+        [parentDirectory removeObjectForKey:name];
+        return YES;
+    }
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSMemoryFileHandle class implementation
+
+@implementation HLSMemoryFileHandle
+
+#pragma mark Object creation and destruction
+
+- (id)initWithFileManager:(HLSMemoryFileManager *)fileManager data:(NSMutableData *)data appending:(BOOL)appending
+{
+    if ((self = [super init])) {
+        m_fileManager = [fileManager retain];
+        m_data = [data retain];
+        m_appending = appending;
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    [self close];
+    
+    [super dealloc];
+}
+
+#pragma mark HLSFileHandle protocol implementation
+
+- (NSData *)readDataOfLength:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)pError
+{
+    @synchronized(m_fileManager) {
+        NSUInteger dataLength = [m_data length];
+        if (offset >= dataLength) {
+            return [NSData data];
+        }
+        return [m_data subdataWithRange:NSMakeRange((NSUInteger)offset, MIN(length, dataLength - (NSUInteger)offset))];
+    }
+}
+
+- (BOOL)writeData:(NSData *)data error:(NSError **)pError
+{
+    // Writing handles start with an empty file, and both kinds of handles append what they write
+    @synchronized(m_fileManager) {
+        [m_data appendData:data];
+        return YES;
+    }
+}
+
+- (unsigned long long)length
+{
+    @synchronized(m_fileManager) {
+        return [m_data length];
+    }
+}
+
+- (void)close
+{
+    [m_data release];
+    m_data = nil;
+    
+    [m_fileManager release];
+    m_fileManager = nil;
+}
+
+@end
+
+#pragma mark -
+#pragma mark Static functions
+
+static NSArray *pathComponents(NSString *path)
+{
+    // Paths are relative to the storage root, whether they begin with / or not
+    NSMutableArray *components = [NSMutableArray array];
+    for (NSString *component in [path pathComponents]) {
+        if ([component isEqualToString:@"/"] || [component isEqualToString:@"."]) {
+            continue;
+        }
+        [components addObject:component];
+    }
+    return components;
+}
+
+static id copyOfItem(id item)
+{
+    if (isDirectory(item)) {
+        NSMutableDictionary *directoryCopy = [[NSMutableDictionary alloc] initWithCapacity:[item count]];
+        for (NSString *name in [item allKeys]) {
+            id childCopy = copyOfItem([item objectForKey:name]);
+            [directoryCopy setObject:childCopy forKey:name];
+            [childCopy release];
+        }
+        return directoryCopy;
+    }
+    else {
+        return [item mutableCopy];
+    }
+}
+
+// Modification dates are not stored
+static void addItems(NSDictionary *directory, NSString *relativePath, HLSFileAttributes attributes, BOOL recursive, NSMutableArray *items)
+{
+    for (NSString *name in [directory allKeys]) {
+        id item = [directory objectForKey:name];
+        NSString *itemRelativePath = relativePath ? [relativePath stringByAppendingPathComponent:name] : name;
+        BOOL itemIsDirectory = isDirectory(item);
+        unsigned long long size = (! itemIsDirectory && (attributes & HLSFileAttributeSize)) ? [item length] : 0;
+        
+        HLSFileItem *fileItem = [[HLSFileItem alloc] initWithPath:itemRelativePath directory:itemIsDirectory size:size modificationDate:nil];
+        [items addObject:fileItem];
+        [fileItem release];
+        
+        if (itemIsDirectory && recursive) {
+            addItems(item, itemRelativePath, attributes, YES, items);
+        }
+    }
+}
+
+static BOOL isDirectory(id item)
+{
+    return [item isKindOfClass:[NSDictionary class]];
+}
+
+static NSError *fileError(NSInteger code, NSString *path)
+{
+    return [NSError errorWithDomain:NSCocoaErrorDomain 
+                               code:code 
+                           userInfo:[NSDictionary dictionaryWithObject:path ?: @"" forKey:NSFilePathErrorKey]];
+}
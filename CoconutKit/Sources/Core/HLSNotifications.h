@@ -24,13 +24,17 @@
 /**
  * Manages application-wide notification mechanisms
  *
- * This class is not thread-safe
+ * Network activity can be notified from any thread. The status bar activity indicator is updated on the main thread,
+ * at most once per frame, and is hidden only after a short delay once all network activities have ended, so that
+ * bursts of short requests do not make it flicker
  *
- * Designated initializer: -init
+ * Designated initializer: -init (but use the +sharedNotificationManager singleton)
  */
 @interface HLSNotificationManager : NSObject {
 @private
-    NSUInteger m_networkActivityCount;
+    volatile int32_t m_networkActivityCount;
+    volatile int32_t m_networkActivityIndicatorUpdateScheduled;
+    BOOL m_networkActivityIndicatorVisible;               // main thread only
 }
 
 /**
@@ -52,6 +56,11 @@
  */
 - (void)notifyEndNetworkActivity;
 
+/**
+ * The number of network activities currently running
+ */
+- (NSUInteger)networkActivityCount;
+
 @end
 
 /**
@@ -66,10 +75,10 @@
 @private
     // To be able to add conversion rules for an (object, notification name), and to be able to remove all rules defined
     // for an object, we introduce two dictionary levels:
-    //   - 1st dictionary: maps objects to a notification map
-    //   - 2nd dictionary (notification map): maps notification name to the (object, notification name) pair to
-    //                                        convert to
-    NSMutableDictionary *m_objectToNotificationMap;
+    //   - 1st dictionary: maps objects (pointer identity, not retained) to the rules defined for them
+    //   - 2nd dictionary (in the rules): maps notification name to the (object, notification name) pair to
+    //                                    convert to
+    CFMutableDictionaryRef m_objectToRulesMap;
 }
 
 + (HLSNotificationConverter *)sharedNotificationConverter;
@@ -77,8 +86,9 @@
 /**
  * Add a conversion rule. The objectFrom and objectTo objects are NOT retained, as for NSNotificationManager. This is 
  * not needed (and not desirable) since:
- *  - objectFrom: When deallocated, an object must have unregistered itself from the HLSNotificationConverter
- *                by calling removeConversionsFromObject:
+ *  - objectFrom: When deallocated, all rules defined for an object are automatically removed (except for toll-free
+ *                bridged objects, which must unregister themselves from the HLSNotificationConverter by calling
+ *                removeConversionsFromObject:). Calling removeConversionsFromObject: explicitly is still possible
  *  - objectTo: HLSNotificationConverter is meant to be used for converting notifications in object compositions,
  *              where objectFrom is a member of objectTo and is retained by it. As long as the conversion rule
  *              exists (and provided objectFrom removes all associated rules when it gets deallocated) objectTo
@@ -122,7 +132,24 @@
 
 @interface NSNotificationCenter (HLSNotificationExtensions)
 
+/**
+ * Register / unregister an observer for a notification sent by any object of a collection. One registration is made
+ * for each object
+ */
 - (void)addObserver:(id)observer selector:(SEL)selector name:(NSString *)name objectsInCollection:(id<NSFastEnumeration>)collection;
 - (void)removeObserver:(id)observer name:(NSString *)name objectsInCollection:(id<NSFastEnumeration>)collection;
 
+/**
+ * Same as above, but better suited for large collections: A single registration is made for the notification name,
+ * and the notifications received are forwarded to the observer only if their object belongs to the set of observed
+ * objects (identified by address, not retained). The cost of posting a notification therefore does not depend on the
+ * number of objects observed. Calling the add method again for the same observer, name and selector adds objects to
+ * the set
+ *
+ * Unlike the methods above, registrations are automatically removed when the observer is deallocated. The name
+ * is mandatory when adding. When removing, a nil name matches all names, and a nil collection removes all objects
+ */
+- (void)addObserver:(id)observer selector:(SEL)selector name:(NSString *)name filteringObjectsInCollection:(id<NSFastEnumeration>)collection;
+- (void)removeObserver:(id)observer name:(NSString *)name filteringObjectsInCollection:(id<NSFastEnumeration>)collection;
+
 @end
@@ -8,7 +8,17 @@
 
 #import "HLSNotifications.h"
 
+#import <libkern/OSAtomic.h>
+#import <objc/runtime.h>
 #import "HLSLogger.h"
+#import "HLSZeroingWeakRef.h"
+
+// Associated object keys
+static void *s_collectionObservationTrampolinesKey = &s_collectionObservationTrampolinesKey;
+
+// Delay between two updates of the network activity indicator (about one frame), and delay before it gets hidden
+static const NSTimeInterval kNetworkActivityIndicatorUpdateInterval = 1. / 60.;
+static const NSTimeInterval kNetworkActivityIndicatorHideDelay = 0.2;
 
 #pragma mark -
 #pragma mark NotificationSender class interface
@@ -33,13 +43,73 @@
 @end
 
 #pragma mark -
-#pragma mark HLSNotificationConverter class interface extension
+#pragma mark NotificationConversionRules class interface
 
-@interface HLSNotificationConverter ()
+/**
+ * Conversion rules defined for an object, mapping the names of the notifications it sends to the NotificationSender
+ * objects describing the notifications to convert them into. A zeroing weak reference to the object is kept so that
+ * the rules can be removed automatically when the object is deallocated
+ *
+ * Designated initializer: -init
+ */
+@interface NotificationConversionRules : NSObject {
+@private
+    NSMutableDictionary *m_notificationNameToSenderMap;
+    HLSZeroingWeakRef *m_objectZeroingWeakRef;
+}
+
+@property (nonatomic, retain) NSMutableDictionary *notificationNameToSenderMap;
+@property (nonatomic, retain) HLSZeroingWeakRef *objectZeroingWeakRef;
+
+@end
+
+#pragma mark -
+#pragma mark CollectionObservationTrampoline class interface
+
+/**
+ * Observes a notification with a single registration for any object, and forwards it to the real observer if it was
+ * sent by one of the observed objects. Objects are identified by their address and are not retained
+ *
+ * Designated initializer: -initWithObserver:selector:name:notificationCenter:
+ */
+@interface CollectionObservationTrampoline : NSObject {
+@private
+    id m_observer;
+    SEL m_selector;
+    NSString *m_name;
+    NSNotificationCenter *m_notificationCenter;
+    CFMutableSetRef m_objects;
+    OSSpinLock m_objectsLock;
+}
 
-@property (nonatomic, retain) NSMutableDictionary *objectToNotificationMap;
+- (id)initWithObserver:(id)observer selector:(SEL)selector name:(NSString *)name notificationCenter:(NSNotificationCenter *)notificationCenter;
 
-- (NSString *)buildIdentifierForObject:(id)object;
+@property (nonatomic, readonly, retain) NSString *name;
+
+- (void)addObjectsInCollection:(id<NSFastEnumeration>)collection;
+- (void)removeObjectsInCollection:(id<NSFastEnumeration>)collection;
+
+- (BOOL)hasObjects;
+
+- (void)forwardNotification:(NSNotification *)notification;
+
+@end
+
+#pragma mark -
+#pragma mark HLSNotificationManager class interface extension
+
+@interface HLSNotificationManager ()
+
+- (void)scheduleNetworkActivityIndicatorUpdate;
+- (void)updateNetworkActivityIndicator;
+- (void)hideNetworkActivityIndicator;
+
+@end
+
+#pragma mark -
+#pragma mark HLSNotificationConverter class interface extension
+
+@interface HLSNotificationConverter ()
 
 - (void)convertNotification:(NSNotification *)notification;
 
@@ -55,50 +125,92 @@
 + (HLSNotificationManager *)sharedNotificationManager
 {
     static HLSNotificationManager *s_instance = nil;
-    
-    if (! s_instance) {
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
         s_instance = [[HLSNotificationManager alloc] init];
-    }
+    });
     return s_instance;
 }
 
-#pragma mark Object creation and destruction
+#pragma mark Activity notification
 
-- (id)init
+- (void)notifyBeginNetworkActivity
 {
-    if ((self = [super init])) {
-        m_networkActivityCount = 0;
+    int32_t networkActivityCount = OSAtomicIncrement32Barrier(&m_networkActivityCount);
+    
+    HLSLoggerDebug(@"Network activity counter is now %d", networkActivityCount);
+    
+    if (networkActivityCount == 1) {
+        [self scheduleNetworkActivityIndicatorUpdate];
     }
-    return self;
 }
 
-#pragma mark Activity notification
-
-- (void)notifyBeginNetworkActivity
+- (void)notifyEndNetworkActivity
 {
-    ++m_networkActivityCount;
+    // Never decrement below zero, even if several threads end activities at the same time
+    int32_t networkActivityCount;
+    do {
+        networkActivityCount = m_networkActivityCount;
+        if (networkActivityCount == 0) {
+            HLSLoggerWarn(@"Warning: Notifying the end of a network activity which has not been started");
+            return;
+        }
+    } while (! OSAtomicCompareAndSwap32Barrier(networkActivityCount, networkActivityCount - 1, &m_networkActivityCount));
     
-    HLSLoggerDebug(@"Network activity counter is now %d", m_networkActivityCount);
+    HLSLoggerDebug(@"Network activity counter is now %d", networkActivityCount - 1);
     
-    if (m_networkActivityCount == 1) {
-        [UIApplication sharedApplication].networkActivityIndicatorVisible = YES;
+    if (networkActivityCount == 1) {
+        [self scheduleNetworkActivityIndicatorUpdate];
     }
 }
 
-- (void)notifyEndNetworkActivity
+- (NSUInteger)networkActivityCount
+{
+    return (NSUInteger)m_networkActivityCount;
+}
+
+#pragma mark Network activity indicator
+
+// Can be called from any thread. Changes received until the update is performed are coalesced
+- (void)scheduleNetworkActivityIndicatorUpdate
 {
-    if (m_networkActivityCount == 0) {
-        HLSLoggerWarn(@"Warning: Notifying the end of a network activity which has not been started");
+    if (! OSAtomicCompareAndSwap32Barrier(0, 1, &m_networkActivityIndicatorUpdateScheduled)) {
         return;
     }
     
-    --m_networkActivityCount;
-    
-    HLSLoggerDebug(@"Network activity counter is now %d", m_networkActivityCount);
+    // The manager is a singleton and does not need to be retained by the block
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kNetworkActivityIndicatorUpdateInterval * NSEC_PER_SEC)),
+                   dispatch_get_main_queue(), ^{
+                       [self updateNetworkActivityIndicator];
+                   });
+}
+
+- (void)updateNetworkActivityIndicator
+{
+    OSAtomicCompareAndSwap32Barrier(1, 0, &m_networkActivityIndicatorUpdateScheduled);
     
-    if (m_networkActivityCount == 0) {
-        [UIApplication sharedApplication].networkActivityIndicatorVisible = NO;        
+    if (m_networkActivityCount != 0) {
+        [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(hideNetworkActivityIndicator) object:nil];
+        if (! m_networkActivityIndicatorVisible) {
+            m_networkActivityIndicatorVisible = YES;
+            [UIApplication sharedApplication].networkActivityIndicatorVisible = YES;
+        }
     }
+    else if (m_networkActivityIndicatorVisible) {
+        [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(hideNetworkActivityIndicator) object:nil];
+        [self performSelector:@selector(hideNetworkActivityIndicator) withObject:nil afterDelay:kNetworkActivityIndicatorHideDelay];
+    }
+}
+
+- (void)hideNetworkActivityIndicator
+{
+    // An activity might have started in the meantime
+    if (m_networkActivityCount != 0 || ! m_networkActivityIndicatorVisible) {
+        return;
+    }
+    
+    m_networkActivityIndicatorVisible = NO;
+    [UIApplication sharedApplication].networkActivityIndicatorVisible = NO;
 }
 
 @end
@@ -134,6 +246,121 @@
 
 @end
 
+#pragma mark -
+#pragma mark NotificationConversionRules class implementation
+
+@implementation NotificationConversionRules
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.notificationNameToSenderMap = [NSMutableDictionary dictionaryWithCapacity:1];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    self.notificationNameToSenderMap = nil;
+    self.objectZeroingWeakRef = nil;
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize notificationNameToSenderMap = m_notificationNameToSenderMap;
+
+@synthesize objectZeroingWeakRef = m_objectZeroingWeakRef;
+
+@end
+
+#pragma mark -
+#pragma mark CollectionObservationTrampoline class implementation
+
+@implementation CollectionObservationTrampoline
+
+#pragma mark Object creation and destruction
+
+- (id)initWithObserver:(id)observer selector:(SEL)selector name:(NSString *)name notificationCenter:(NSNotificationCenter *)notificationCenter
+{
+    if ((self = [super init])) {
+        m_observer = observer;
+        m_selector = selector;
+        m_name = [name retain];
+        m_notificationCenter = [notificationCenter retain];
+        m_objects = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+        m_objectsLock = OS_SPINLOCK_INIT;
+        
+        [notificationCenter addObserver:self selector:@selector(forwardNotification:) name:name object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [m_notificationCenter removeObserver:self name:m_name object:nil];
+    
+    [m_name release];
+    [m_notificationCenter release];
+    CFRelease(m_objects);
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize name = m_name;
+
+#pragma mark Observed objects
+
+- (void)addObjectsInCollection:(id<NSFastEnumeration>)collection
+{
+    OSSpinLockLock(&m_objectsLock);
+    for (id object in collection) {
+        CFSetAddValue(m_objects, object);
+    }
+    OSSpinLockUnlock(&m_objectsLock);
+}
+
+- (void)removeObjectsInCollection:(id<NSFastEnumeration>)collection
+{
+    OSSpinLockLock(&m_objectsLock);
+    for (id object in collection) {
+        CFSetRemoveValue(m_objects, object);
+    }
+    OSSpinLockUnlock(&m_objectsLock);
+}
+
+- (BOOL)hasObjects
+{
+    OSSpinLockLock(&m_objectsLock);
+    BOOL hasObjects = CFSetGetCount(m_objects) != 0;
+    OSSpinLockUnlock(&m_objectsLock);
+    return hasObjects;
+}
+
+#pragma mark Notification callback
+
+- (void)forwardNotification:(NSNotification *)notification
+{
+    id object = notification.object;
+    if (! object) {
+        return;
+    }
+    
+    OSSpinLockLock(&m_objectsLock);
+    BOOL observed = CFSetContainsValue(m_objects, object);
+    OSSpinLockUnlock(&m_objectsLock);
+    
+    if (observed) {
+        [m_observer performSelector:m_selector withObject:notification];
+    }
+}
+
+@end
+
 #pragma mark -
 #pragma mark HLSNotificationConverter class implementation
 
@@ -156,21 +383,18 @@
 - (id)init
 {
     if ((self = [super init])) {
-        self.objectToNotificationMap = [NSMutableDictionary dictionary];
+        // Objects are identified by their address, and are not retained
+        m_objectToRulesMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
     }
     return self;
 }
 
 - (void)dealloc
 {
-    self.objectToNotificationMap = nil;
+    CFRelease(m_objectToRulesMap);
     [super dealloc];
 }
 
-#pragma mark Accessors and mutators
-
-@synthesize objectToNotificationMap = m_objectToNotificationMap;
-
 #pragma mark (Un)registering conversion rules
 
 - (void)convertNotificationWithName:(NSString *)notificationNameFrom
@@ -183,17 +407,32 @@
         return;
     }
     
-    // Build the emitter identifier
-    NSString *fromIdentifier = [self buildIdentifierForObject:objectFrom];
-    
-    // Get the associated notification map, or create it if it does not exist
-    NSMutableDictionary *notificationMap = [self.objectToNotificationMap objectForKey:fromIdentifier];
-    if (! notificationMap) {
-        notificationMap = [[[NSMutableDictionary alloc] initWithCapacity:1] autorelease];
-        [self.objectToNotificationMap setObject:notificationMap forKey:fromIdentifier];
+    // Get the rules associated with the object, or create them if they do not exist
+    NotificationConversionRules *rules = CFDictionaryGetValue(m_objectToRulesMap, objectFrom);
+    if (! rules) {
+        rules = [[[NotificationConversionRules alloc] init] autorelease];
+        
+        // Remove the rules automatically when the object is deallocated. Zeroing weak references cannot be made
+        // to toll-free bridged objects, for which conversions must be removed manually
+        @try {
+            rules.objectZeroingWeakRef = [[[HLSZeroingWeakRef alloc] initWithObject:objectFrom] autorelease];
+            
+            // __block variables are not retained by the block
+            __block HLSNotificationConverter *converter = self;
+            __block id object = objectFrom;
+            [rules.objectZeroingWeakRef addCleanupBlock:^{
+                [converter removeConversionsFromObject:object];
+            }];
+        }
+        @catch (NSException *exception) {
+            HLSLoggerDebug(@"Conversions from object %p will not be removed automatically when it is deallocated", objectFrom);
+        }
+        
+        CFDictionarySetValue(m_objectToRulesMap, objectFrom, rules);
     }
     
     // If the rule already exists, nothing to do
+    NSMutableDictionary *notificationMap = rules.notificationNameToSenderMap;
     if ([notificationMap objectForKey:notificationNameFrom]) {
         return;
     }
@@ -239,25 +478,23 @@
         return;
     }
     
-    // Build the emitter identifier
-    NSString *fromIdentifier = [self buildIdentifierForObject:objectFrom];
-    
     // Get all associated rules
-    NSMutableDictionary *notificationMap = [self.objectToNotificationMap objectForKey:fromIdentifier];
+    NotificationConversionRules *rules = CFDictionaryGetValue(m_objectToRulesMap, objectFrom);
     
     // If no rules, nothing to do
-    if (! notificationMap) {
+    if (! rules) {
         return;
     }
     
     // Unregister the converter completely for this object notifications
-    NSArray *notificationNames = [notificationMap allKeys];
-    for (NSString *notificationName in notificationNames) {
+    for (NSString *notificationName in [rules.notificationNameToSenderMap allKeys]) {
         [[NSNotificationCenter defaultCenter] removeObserver:self name:notificationName object:objectFrom];
     }
     
-    // Remove all rules
-    [self.objectToNotificationMap removeObjectForKey:fromIdentifier];
+    // Remove all rules. When called while the object is deallocated, its zeroing weak reference is still in use and
+    // must survive the removal
+    [[rules retain] autorelease];
+    CFDictionaryRemoveValue(m_objectToRulesMap, objectFrom);
     
     HLSLoggerDebug(@"Removed all conversions for object %p", objectFrom);
 }
@@ -269,29 +506,18 @@
     } 
 }
 
-#pragma mark Creating a unique string identifier for indexing the dictionary
-
-- (NSString *)buildIdentifierForObject:(id)object
-{
-    // Since a pointer is unique, this is guaranteed to be unique
-    return [NSString stringWithFormat:@"%p", object];
-}
-
 #pragma mark Notification conversion callback
 
 - (void)convertNotification:(NSNotification *)notification
 {
-    // Build the emitter identifier
-    NSString *fromIdentifier = [self buildIdentifierForObject:notification.object];
-    
-    // Locate the conversion rule to apply
-    NotificationSender *sender = [[self.objectToNotificationMap objectForKey:fromIdentifier] 
-                                  objectForKey:notification.name];
+    // Locate the conversion rule to apply (no object is created)
+    NotificationConversionRules *rules = CFDictionaryGetValue(m_objectToRulesMap, notification.object);
+    NotificationSender *sender = [rules.notificationNameToSenderMap objectForKey:notification.name];
     
     // We should never be trapped here if no conversion rule exists; but stay defensive anyway
     if (! sender) {
-        HLSLoggerWarn(@"Notification conversion remains registered with NSNotificationCenter for object %@ "
-                      "and notification %@, but should not be", fromIdentifier, notification.name);
+        HLSLoggerWarn(@"Notification conversion remains registered with NSNotificationCenter for object %p "
+                      "and notification %@, but should not be", notification.object, notification.name);
         return;
     }
     
@@ -351,4 +577,56 @@
     }
 }
 
+- (void)addObserver:(id)observer selector:(SEL)selector name:(NSString *)name filteringObjectsInCollection:(id<NSFastEnumeration>)collection
+{
+    if (! observer || ! selector || ! name) {
+        HLSLoggerError(@"Missing observer, selector or name");
+        return;
+    }
+    
+    // Trampolines are attached to the observer, so that they are released (and unregistered) when it is deallocated
+    NSMutableDictionary *trampolines = objc_getAssociatedObject(observer, s_collectionObservationTrampolinesKey);
+    if (! trampolines) {
+        trampolines = [NSMutableDictionary dictionary];
+        objc_setAssociatedObject(observer, s_collectionObservationTrampolinesKey, trampolines, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+    
+    NSString *trampolineKey = [NSString stringWithFormat:@"%p_%@_%@", self, name, NSStringFromSelector(selector)];
+    CollectionObservationTrampoline *trampoline = [trampolines objectForKey:trampolineKey];
+    if (! trampoline) {
+        trampoline = [[[CollectionObservationTrampoline alloc] initWithObserver:observer
+                                                                       selector:selector
+                                                                           name:name
+                                                             notificationCenter:self] autorelease];
+        [trampolines setObject:trampoline forKey:trampolineKey];
+    }
+    [trampoline addObjectsInCollection:collection];
+}
+
+- (void)removeObserver:(id)observer name:(NSString *)name filteringObjectsInCollection:(id<NSFastEnumeration>)collection
+{
+    NSMutableDictionary *trampolines = objc_getAssociatedObject(observer, s_collectionObservationTrampolinesKey);
+    NSString *trampolineKeyPrefix = [NSString stringWithFormat:@"%p_", self];
+    for (NSString *trampolineKey in [trampolines allKeys]) {
+        if (! [trampolineKey hasPrefix:trampolineKeyPrefix]) {
+            continue;
+        }
+        
+        CollectionObservationTrampoline *trampoline = [trampolines objectForKey:trampolineKey];
+        if (name && ! [trampoline.name isEqualToString:name]) {
+            continue;
+        }
+        
+        if (collection) {
+            [trampoline removeObjectsInCollection:collection];
+            if ([trampoline hasObjects]) {
+                continue;
+            }
+        }
+        
+        // Releasing the trampoline unregisters it from the notification center
+        [trampolines removeObjectForKey:trampolineKey];
+    }
+}
+
 @end
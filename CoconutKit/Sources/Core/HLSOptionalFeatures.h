@@ -9,12 +9,15 @@
 /**
  * A collection of macros to enable optional CoconutKit features you might not want in your application.
  * Simply call a macro at global scope to enable the corresponding feature. Good places are for example 
- * main.m or your application delegate .m file
+ * main.m or your application delegate .m file. Features which are not enabled swizzle nothing and cost
+ * nothing at launch
  */
 
 #import "HLSApplicationPreloader.h"
+#import "NSDate+HLSExtensions.h"
 #import "NSManagedObject+HLSValidation.h"
 #import "UIControl+HLSExclusiveTouch.h"
+#import "UILabel+HLSDynamicLocalization.h"
 
 /**
  * Enable preloading of some objects (currently only UIWebView) when the application is started. This 
@@ -78,3 +81,42 @@
         [UIControl enable];                                                                              \
     }
 #endif
+
+/**
+ * Enable localization of labels and buttons in nib files using prefixes (see UILabel+HLSDynamicLocalization.h).
+ * This swizzles several UILabel methods, you should therefore only enable it if you use this feature
+ */
+#if !__has_feature(objc_arc)
+#define HLSEnableUILabelDynamicLocalization()                                                        \
+    __attribute__ ((constructor)) void HLSEnableUILabelDynamicLocalizationConstructor(void)          \
+    {                                                                                                \
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];                                  \
+        [UILabel enable];                                                                            \
+        [pool drain];                                                                                \
+    }
+#else
+#define HLSEnableUILabelDynamicLocalization()                                                        \
+    __attribute__ ((constructor)) void HLSEnableUILabelDynamicLocalizationConstructor(void)          \
+    {                                                                                                \
+        [UILabel enable];                                                                            \
+    }
+#endif
+
+/**
+ * Add the date in the system time zone to date descriptions. Mostly useful when debugging
+ */
+#if !__has_feature(objc_arc)
+#define HLSEnableNSDateSystemTimeZoneDescription()                                                   \
+    __attribute__ ((constructor)) void HLSEnableNSDateSystemTimeZoneDescriptionConstructor(void)     \
+    {                                                                                                \
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];                                  \
+        [NSDate enable];                                                                             \
+        [pool drain];                                                                                \
+    }
+#else
+#define HLSEnableNSDateSystemTimeZoneDescription()                                                   \
+    __attribute__ ((constructor)) void HLSEnableNSDateSystemTimeZoneDescriptionConstructor(void)     \
+    {                                                                                                \
+        [NSDate enable];                                                                             \
+    }
+#endif
@@ -0,0 +1,62 @@
+//
+//  HLSPerformanceHUD.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+// Forward declarations
+@class HLSTaskManager;
+
+/**
+ * Debug overlay displaying live performance figures at the bottom of the screen, refreshed once per second:
+ *   - the number of frames displayed during the last second (FPS), and the number of frames dropped during the last
+ *     second and since the HUD was made visible
+ *   - the main thread stall time, i.e. the time the main thread was busy beyond the duration of a frame, during the
+ *     last second, and the longest such stall since the HUD was made visible
+ *   - the resident memory size of the application
+ *   - the number of HLSAnimation objects running (see +[HLSAnimation runningAnimationCount])
+ *   - the number of tasks pending in a task manager (see -[HLSTaskManager pendingTaskCount])
+ * Frames are measured using a display link, which costs almost nothing when the application is idle. The HUD can
+ * therefore be left visible in debug builds of production applications. The overlay does not intercept touches
+ *
+ * The HUD must only be used from the main thread
+ *
+ * Designated initializer: -init (but use the +sharedPerformanceHUD singleton)
+ */
+@interface HLSPerformanceHUD : NSObject {
+@private
+    HLSTaskManager *m_taskManager;
+    UIWindow *m_overlayWindow;
+    UILabel *m_overlayLabel;
+    CADisplayLink *m_displayLink;
+    CFTimeInterval m_lastFrameTimestamp;
+    CFTimeInterval m_lastUpdateTimestamp;
+    NSUInteger m_frameCount;                            // frames displayed since the last update ...
+    NSUInteger m_droppedFrameCount;                     // ... frames dropped since then ...
+    CFTimeInterval m_stallTimeInterval;                 // ... and cumulated main thread stall time
+    NSUInteger m_totalDroppedFrameCount;
+    CFTimeInterval m_longestStallTimeInterval;
+}
+
+/**
+ * The HUD singleton
+ */
++ (HLSPerformanceHUD *)sharedPerformanceHUD;
+
+/**
+ * Set to YES to display the HUD and start measurements. Counters are reset each time the HUD is made visible
+ *
+ * Default value is NO
+ */
+@property (nonatomic, assign, getter=isVisible) BOOL visible;
+
+/**
+ * The task manager whose pending tasks are counted
+ *
+ * Default value is +[HLSTaskManager defaultManager]
+ */
+@property (nonatomic, retain) HLSTaskManager *taskManager;
+
+@end
@@ -0,0 +1,216 @@
+//
+//  HLSPerformanceHUD.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSPerformanceHUD.h"
+
+#import "HLSAnimation.h"
+#import "HLSFloat.h"
+#import "HLSTaskManager.h"
+
+#import <mach/mach.h>
+
+// Time between two refreshes of the HUD
+static const CFTimeInterval kPerformanceHUDUpdateTimeInterval = 1.;
+
+// Frame duration used before the display link has reported its own
+static const CFTimeInterval kPerformanceHUDDefaultFrameDuration = 1. / 60.;
+
+static NSUInteger HLSPerformanceHUDResidentMemorySize(void);
+
+@interface HLSPerformanceHUD ()
+
+@property (nonatomic, retain) UIWindow *overlayWindow;
+@property (nonatomic, retain) UILabel *overlayLabel;
+@property (nonatomic, retain) CADisplayLink *displayLink;
+
+- (void)resetCounters;
+- (void)updateOverlay;
+
+- (void)tick:(CADisplayLink *)displayLink;
+
+@end
+
+@implementation HLSPerformanceHUD
+
+#pragma mark Class methods
+
++ (HLSPerformanceHUD *)sharedPerformanceHUD
+{
+    static HLSPerformanceHUD *s_instance = nil;
+    
+    if (! s_instance) {
+        s_instance = [[HLSPerformanceHUD alloc] init];
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.taskManager = [HLSTaskManager defaultManager];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self.displayLink invalidate];
+    
+    self.taskManager = nil;
+    self.overlayWindow = nil;
+    self.overlayLabel = nil;
+    self.displayLink = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize taskManager = m_taskManager;
+
+@synthesize overlayWindow = m_overlayWindow;
+
+@synthesize overlayLabel = m_overlayLabel;
+
+@synthesize displayLink = m_displayLink;
+
+- (BOOL)isVisible
+{
+    return self.overlayWindow != nil;
+}
+
+- (void)setVisible:(BOOL)visible
+{
+    if (visible == self.visible) {
+        return;
+    }
+    
+    if (visible) {
+        CGRect applicationFrame = [UIScreen mainScreen].applicationFrame;
+        self.overlayWindow = [[[UIWindow alloc] initWithFrame:CGRectMake(CGRectGetMinX(applicationFrame),
+                                                                         CGRectGetMaxY(applicationFrame) - 28.f,
+                                                                         CGRectGetWidth(applicationFrame),
+                                                                         28.f)] autorelease];
+        self.overlayWindow.windowLevel = UIWindowLevelStatusBar + 1.f;
+        self.overlayWindow.userInteractionEnabled = NO;
+        self.overlayWindow.backgroundColor = [UIColor colorWithWhite:0.f alpha:0.6f];
+        
+        self.overlayLabel = [[[UILabel alloc] initWithFrame:CGRectInset(self.overlayWindow.bounds, 2.f, 2.f)] autorelease];
+        self.overlayLabel.autoresizingMask = UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight;
+        self.overlayLabel.backgroundColor = [UIColor clearColor];
+        self.overlayLabel.textColor = [UIColor whiteColor];
+        self.overlayLabel.font = [UIFont fontWithName:@"Courier" size:10.f];
+        self.overlayLabel.numberOfLines = 2;
+        [self.overlayWindow addSubview:self.overlayLabel];
+        
+        self.overlayWindow.hidden = NO;
+        
+        [self resetCounters];
+        [self updateOverlay];
+        
+        // The display link retains its target. This is not an issue since the HUD is a singleton
+        self.displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(tick:)];
+        [self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+    else {
+        [self.displayLink invalidate];
+        self.displayLink = nil;
+        
+        self.overlayWindow.hidden = YES;
+        self.overlayWindow = nil;
+        self.overlayLabel = nil;
+    }
+}
+
+#pragma mark Measurements
+
+- (void)resetCounters
+{
+    m_lastFrameTimestamp = 0.;
+    m_lastUpdateTimestamp = 0.;
+    m_frameCount = 0;
+    m_droppedFrameCount = 0;
+    m_stallTimeInterval = 0.;
+    m_totalDroppedFrameCount = 0;
+    m_longestStallTimeInterval = 0.;
+}
+
+#pragma mark Overlay
+
+- (void)updateOverlay
+{
+    if (! self.overlayLabel) {
+        return;
+    }
+    
+    self.overlayLabel.text = [NSString stringWithFormat:@"FPS %3d  dropped %3d (%d)  stall %4.0f ms (max %.0f ms)\n"
+                              "mem %.1f MB  animations %d  tasks %d",
+                              m_frameCount,
+                              m_droppedFrameCount,
+                              m_totalDroppedFrameCount,
+                              m_stallTimeInterval * 1000.,
+                              m_longestStallTimeInterval * 1000.,
+                              HLSPerformanceHUDResidentMemorySize() / (1024. * 1024.),
+                              [HLSAnimation runningAnimationCount],
+                              [self.taskManager pendingTaskCount]];
+}
+
+#pragma mark Display link callback
+
+- (void)tick:(CADisplayLink *)displayLink
+{
+    CFTimeInterval timestamp = displayLink.timestamp;
+    
+    // First frame: Nothing to compare with
+    if (doubleeq(m_lastFrameTimestamp, 0.)) {
+        m_lastFrameTimestamp = timestamp;
+        m_lastUpdateTimestamp = timestamp;
+        return;
+    }
+    
+    // A frame which lasted longer than expected means that the main thread was busy and that frames were dropped
+    CFTimeInterval frameDuration = doublegt(displayLink.duration, 0.) ? displayLink.duration : kPerformanceHUDDefaultFrameDuration;
+    CFTimeInterval frameTimeInterval = timestamp - m_lastFrameTimestamp;
+    NSUInteger droppedFrameCount = (NSUInteger)MAX(round(frameTimeInterval / frameDuration) - 1., 0.);
+    if (droppedFrameCount != 0) {
+        CFTimeInterval stallTimeInterval = frameTimeInterval - frameDuration;
+        m_droppedFrameCount += droppedFrameCount;
+        m_totalDroppedFrameCount += droppedFrameCount;
+        m_stallTimeInterval += stallTimeInterval;
+        m_longestStallTimeInterval = MAX(m_longestStallTimeInterval, stallTimeInterval);
+    }
+    ++m_frameCount;
+    m_lastFrameTimestamp = timestamp;
+    
+    if (timestamp - m_lastUpdateTimestamp < kPerformanceHUDUpdateTimeInterval) {
+        return;
+    }
+    
+    [self updateOverlay];
+    
+    m_frameCount = 0;
+    m_droppedFrameCount = 0;
+    m_stallTimeInterval = 0.;
+    m_lastUpdateTimestamp = timestamp;
+}
+
+@end
+
+#pragma mark Functions
+
+static NSUInteger HLSPerformanceHUDResidentMemorySize(void)
+{
+    struct task_basic_info info;
+    mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
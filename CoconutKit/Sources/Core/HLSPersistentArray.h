@@ -0,0 +1,40 @@
+//
+//  HLSPersistentArray.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+// Forward declarations
+@class HLSPersistentArrayNode;
+
+/**
+ * An immutable array whose copies with an object appended or replaced are made in O(log n) (with a base of 32,
+ * i.e. in practically constant time) instead of O(n). Since the receiver is never modified, the returned array
+ * shares most of its storage with it (it is implemented as a trie of 32-element nodes). Use this class instead of
+ * NSArray when an array is repeatedly updated using -arrayByAddingObject: or -arrayByReplacingObjectAtIndex:withObject:
+ * (see NSArray+HLSExtensions.h), e.g.
+ *   HLSPersistentArray *array = [HLSPersistentArray array];
+ *   array = [array arrayByAddingObject:object];
+ *
+ * Accessing an object by index is slightly slower than for NSArray (O(log n) with a base of 32). Copying the array
+ * is free
+ *
+ * Designated initializer: -initWithObjects:count:
+ */
+@interface HLSPersistentArray : NSArray {
+@private
+    HLSPersistentArrayNode *m_rootNode;
+    HLSPersistentArrayNode *m_tailNode;             // the last objects, not yet inserted into the trie
+    NSUInteger m_shift;
+    NSUInteger m_count;
+}
+
+/**
+ * Return an array with an object appended, respectively replaced, in O(log n). The object must not be nil
+ */
+- (NSArray *)arrayByAddingObject:(id)object;
+- (NSArray *)arrayByReplacingObjectAtIndex:(NSUInteger)index withObject:(id)object;
+
+@end
@@ -0,0 +1,343 @@
+//
+//  HLSPersistentArray.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSPersistentArray.h"
+
+#import "NSArray+HLSExtensions.h"
+
+// Each trie level consumes this number of bits of the indices
+static const NSUInteger kIndexBitsPerLevel = 5;
+
+// Number of objects or sub-tries per node
+static const NSUInteger kNodeCapacity = 1 << kIndexBitsPerLevel;
+
+static const NSUInteger kNodeIndexMask = kNodeCapacity - 1;
+
+#pragma mark -
+#pragma mark HLSPersistentArrayNode class interface
+
+/**
+ * A trie node, whose elements are objects (leaves) or sub-tries. Nodes are never modified once they have been built
+ */
+@interface HLSPersistentArrayNode : NSObject {
+@public
+    id m_elements[32];
+    NSUInteger m_count;
+}
+
+- (HLSPersistentArrayNode *)nodeBySettingElement:(id)element atIndex:(NSUInteger)index;
+
+@end
+
+#pragma mark -
+#pragma mark HLSPersistentArray class implementation
+
+@interface HLSPersistentArray ()
+
+- (id)initWithRootNode:(HLSPersistentArrayNode *)rootNode
+              tailNode:(HLSPersistentArrayNode *)tailNode
+                 shift:(NSUInteger)shift
+                 count:(NSUInteger)count;
+
+- (NSUInteger)tailOffset;
+- (HLSPersistentArrayNode *)leafNodeForIndex:(NSUInteger)index;
+
+- (HLSPersistentArrayNode *)nodeByPushingTailNode:(HLSPersistentArrayNode *)tailNode 
+                                     intoTrieNode:(HLSPersistentArrayNode *)trieNode 
+                                            shift:(NSUInteger)shift;
+- (HLSPersistentArrayNode *)pathToNode:(HLSPersistentArrayNode *)node shift:(NSUInteger)shift;
+- (HLSPersistentArrayNode *)nodeBySettingObject:(id)object 
+                                        atIndex:(NSUInteger)index 
+                                     inTrieNode:(HLSPersistentArrayNode *)trieNode 
+                                          shift:(NSUInteger)shift;
+
+@end
+
+@implementation HLSPersistentArray
+
+#pragma mark Object creation and destruction
+
+- (id)initWithObjects:(const id [])objects count:(NSUInteger)count
+{
+    if ((self = [super init])) {
+        m_rootNode = [[HLSPersistentArrayNode alloc] init];
+        m_tailNode = [[HLSPersistentArrayNode alloc] init];
+        m_shift = kIndexBitsPerLevel;
+        
+        for (NSUInteger i = 0; i < count; ++i) {
+            if (! objects[i]) {
+                [self release];
+                @throw [NSException exceptionWithName:NSInvalidArgumentException 
+                                               reason:@"Objects must not be nil" 
+                                             userInfo:nil];
+            }
+            
+            HLSPersistentArray *array = (HLSPersistentArray *)[self arrayByAddingObject:objects[i]];
+            [array->m_rootNode retain];
+            [m_rootNode release];
+            m_rootNode = array->m_rootNode;
+            
+            [array->m_tailNode retain];
+            [m_tailNode release];
+            m_tailNode = array->m_tailNode;
+            
+            m_shift = array->m_shift;
+            m_count = array->m_count;
+        }
+    }
+    return self;
+}
+
+- (id)init
+{
+    return [self initWithObjects:NULL count:0];
+}
+
+- (id)initWithRootNode:(HLSPersistentArrayNode *)rootNode
+              tailNode:(HLSPersistentArrayNode *)tailNode
+                 shift:(NSUInteger)shift
+                 count:(NSUInteger)count
+{
+    if ((self = [super init])) {
+        m_rootNode = [rootNode retain];
+        m_tailNode = [tailNode retain];
+        m_shift = shift;
+        m_count = count;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [m_rootNode release];
+    [m_tailNode release];
+    
+    [super dealloc];
+}
+
+#pragma mark NSArray primitive methods
+
+- (NSUInteger)count
+{
+    return m_count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    if (index >= m_count) {
+        @throw [NSException exceptionWithName:NSRangeException 
+                                       reason:[NSString stringWithFormat:@"Index %u beyond bounds [0 .. %d]", index, (int)m_count - 1] 
+                                     userInfo:nil];
+    }
+    
+    HLSPersistentArrayNode *leafNode = [self leafNodeForIndex:index];
+    return leafNode->m_elements[index & kNodeIndexMask];
+}
+
+#pragma mark Trie navigation
+
+/**
+ * Index of the first object stored in the tail node
+ */
+- (NSUInteger)tailOffset
+{
+    if (m_count < kNodeCapacity) {
+        return 0;
+    }
+    
+    return ((m_count - 1) >> kIndexBitsPerLevel) << kIndexBitsPerLevel;
+}
+
+- (HLSPersistentArrayNode *)leafNodeForIndex:(NSUInteger)index
+{
+    if (index >= [self tailOffset]) {
+        return m_tailNode;
+    }
+    
+    HLSPersistentArrayNode *node = m_rootNode;
+    for (NSUInteger shift = m_shift; shift > 0; shift -= kIndexBitsPerLevel) {
+        node = node->m_elements[(index >> shift) & kNodeIndexMask];
+    }
+    return node;
+}
+
+#pragma mark Persistent updates
+
+- (NSArray *)arrayByAddingObject:(id)object
+{
+    if (! object) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException 
+                                       reason:@"Objects must not be nil" 
+                                     userInfo:nil];
+    }
+    
+    // Room left in the tail node
+    if (m_count - [self tailOffset] < kNodeCapacity) {
+        HLSPersistentArrayNode *tailNode = [m_tailNode nodeBySettingElement:object atIndex:m_tailNode->m_count];
+        return [[[HLSPersistentArray alloc] initWithRootNode:m_rootNode tailNode:tailNode shift:m_shift count:m_count + 1] autorelease];
+    }
+    
+    // The full tail node is inserted into the trie, and the object into a new tail node. If the trie is full, add a level
+    HLSPersistentArrayNode *rootNode = nil;
+    NSUInteger shift = m_shift;
+    if ((m_count >> kIndexBitsPerLevel) > (1 << m_shift)) {
+        rootNode = [[[HLSPersistentArrayNode alloc] init] autorelease];
+        rootNode = [rootNode nodeBySettingElement:m_rootNode atIndex:0];
+        rootNode = [rootNode nodeBySettingElement:[self pathToNode:m_tailNode shift:m_shift] atIndex:1];
+        shift += kIndexBitsPerLevel;
+    }
+    else {
+        rootNode = [self nodeByPushingTailNode:m_tailNode intoTrieNode:m_rootNode shift:m_shift];
+    }
+    
+    HLSPersistentArrayNode *tailNode = [[[HLSPersistentArrayNode alloc] init] autorelease];
+    tailNode = [tailNode nodeBySettingElement:object atIndex:0];
+    return [[[HLSPersistentArray alloc] initWithRootNode:rootNode tailNode:tailNode shift:shift count:m_count + 1] autorelease];
+}
+
+- (NSArray *)arrayByReplacingObjectAtIndex:(NSUInteger)index withObject:(id)object
+{
+    if (! object) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException 
+                                       reason:@"Objects must not be nil" 
+                                     userInfo:nil];
+    }
+    
+    if (index >= m_count) {
+        @throw [NSException exceptionWithName:NSRangeException 
+                                       reason:[NSString stringWithFormat:@"Index %u beyond bounds [0 .. %d]", index, (int)m_count - 1] 
+                                     userInfo:nil];
+    }
+    
+    if (index >= [self tailOffset]) {
+        HLSPersistentArrayNode *tailNode = [m_tailNode nodeBySettingElement:object atIndex:index & kNodeIndexMask];
+        return [[[HLSPersistentArray alloc] initWithRootNode:m_rootNode tailNode:tailNode shift:m_shift count:m_count] autorelease];
+    }
+    
+    HLSPersistentArrayNode *rootNode = [self nodeBySettingObject:object atIndex:index inTrieNode:m_rootNode shift:m_shift];
+    return [[[HLSPersistentArray alloc] initWithRootNode:rootNode tailNode:m_tailNode shift:m_shift count:m_count] autorelease];
+}
+
+/**
+ * Return a copy of a trie node (at the level given by shift) into which the tail node has been inserted 
+ */
+- (HLSPersistentArrayNode *)nodeByPushingTailNode:(HLSPersistentArrayNode *)tailNode 
+                                     intoTrieNode:(HLSPersistentArrayNode *)trieNode 
+                                            shift:(NSUInteger)shift
+{
+    NSUInteger index = ((m_count - 1) >> shift) & kNodeIndexMask;
+    
+    HLSPersistentArrayNode *insertedNode = nil;
+    if (shift == kIndexBitsPerLevel) {
+        insertedNode = tailNode;
+    }
+    else {
+        HLSPersistentArrayNode *childNode = (index < trieNode->m_count) ? trieNode->m_elements[index] : nil;
+        if (childNode) {
+            insertedNode = [self nodeByPushingTailNode:tailNode intoTrieNode:childNode shift:shift - kIndexBitsPerLevel];
+        }
+        else {
+            insertedNode = [self pathToNode:tailNode shift:shift - kIndexBitsPerLevel];
+        }
+    }
+    
+    return [trieNode nodeBySettingElement:insertedNode atIndex:index];
+}
+
+/**
+ * Return a chain of nodes, each containing only its child, leading from the level given by shift to a leaf node
+ */
+- (HLSPersistentArrayNode *)pathToNode:(HLSPersistentArrayNode *)node shift:(NSUInteger)shift
+{
+    if (shift == 0) {
+        return node;
+    }
+    
+    HLSPersistentArrayNode *pathNode = [[[HLSPersistentArrayNode alloc] init] autorelease];
+    return [pathNode nodeBySettingElement:[self pathToNode:node shift:shift - kIndexBitsPerLevel] atIndex:0];
+}
+
+- (HLSPersistentArrayNode *)nodeBySettingObject:(id)object 
+                                        atIndex:(NSUInteger)index 
+                                     inTrieNode:(HLSPersistentArrayNode *)trieNode 
+                                          shift:(NSUInteger)shift
+{
+    if (shift == 0) {
+        return [trieNode nodeBySettingElement:object atIndex:index & kNodeIndexMask];
+    }
+    
+    NSUInteger childIndex = (index >> shift) & kNodeIndexMask;
+    HLSPersistentArrayNode *childNode = [self nodeBySettingObject:object 
+                                                          atIndex:index 
+                                                       inTrieNode:trieNode->m_elements[childIndex] 
+                                                            shift:shift - kIndexBitsPerLevel];
+    return [trieNode nodeBySettingElement:childNode atIndex:childIndex];
+}
+
+#pragma mark NSFastEnumeration protocol implementation
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id *)stackbuf count:(NSUInteger)len
+{
+    // state->state is the index of the next object to enumerate. Leaf nodes are returned one at a time
+    NSUInteger index = state->state;
+    if (index >= m_count) {
+        return 0;
+    }
+    
+    HLSPersistentArrayNode *leafNode = [self leafNodeForIndex:index];
+    NSUInteger count = MIN(kNodeCapacity, m_count - index);
+    
+    state->itemsPtr = leafNode->m_elements;
+    state->mutationsPtr = (unsigned long *)&m_count;        // immutable, any stable address will do
+    state->state = index + count;
+    return count;
+}
+
+#pragma mark NSCopying protocol implementation
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // Immutable
+    return [self retain];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSPersistentArrayNode class implementation
+
+@implementation HLSPersistentArrayNode
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < m_count; ++i) {
+        [m_elements[i] release];
+    }
+    
+    [super dealloc];
+}
+
+#pragma mark Building updated nodes
+
+/**
+ * Return a copy of the node, with an element set at a given index (replaced or, if index is the number of elements,
+ * appended)
+ */
+- (HLSPersistentArrayNode *)nodeBySettingElement:(id)element atIndex:(NSUInteger)index
+{
+    HLSPersistentArrayNode *node = [[[HLSPersistentArrayNode alloc] init] autorelease];
+    node->m_count = MAX(m_count, index + 1);
+    for (NSUInteger i = 0; i < node->m_count; ++i) {
+        node->m_elements[i] = [((i == index) ? element : m_elements[i]) retain];
+    }
+    return node;
+}
+
+@end
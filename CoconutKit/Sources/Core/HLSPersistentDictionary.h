@@ -0,0 +1,43 @@
+//
+//  HLSPersistentDictionary.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+// Forward declarations
+@class HLSPersistentDictionaryNode;
+
+/**
+ * An immutable dictionary whose copies with an object set or removed (see NSDictionary+HLSExtensions.h) are made in
+ * O(log n) instead of O(n). Since the receiver is never modified, the returned dictionary shares most of its storage
+ * with it (it is implemented as a hash array mapped trie). Use this class instead of NSDictionary when a dictionary
+ * is repeatedly updated using -dictionaryBySettingObject:forKey: or -dictionaryByRemovingObjectForKey:, e.g.
+ *   HLSPersistentDictionary *dictionary = [HLSPersistentDictionary dictionary];
+ *   dictionary = [dictionary dictionaryBySettingObject:object forKey:key];
+ *
+ * Lookups are slightly slower than for NSDictionary (O(log n) instead of O(1)). As for NSDictionary, keys are copied,
+ * and enumerating the keys of the dictionary yields them in no specific order. Copying the dictionary is free
+ *
+ * Designated initializer: -initWithObjects:forKeys:count:
+ */
+@interface HLSPersistentDictionary : NSDictionary {
+@private
+    HLSPersistentDictionaryNode *m_rootNode;
+    NSUInteger m_count;
+}
+
+/**
+ * Return a dictionary with an object set for a key (both must not be nil), respectively with the object designated
+ * by a key removed, in O(log n)
+ */
+- (id)dictionaryBySettingObject:(id)object forKey:(id)key;
+- (id)dictionaryByRemovingObjectForKey:(id)key;
+
+/**
+ * Return a dictionary with the objects designated by the keys in an array removed, in O(k log n) for k keys
+ */
+- (id)dictionaryByRemovingObjectsForKeys:(NSArray *)keyArray;
+
+@end
@@ -0,0 +1,520 @@
+//
+//  HLSPersistentDictionary.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSPersistentDictionary.h"
+
+// Each trie level consumes this number of bits of the key hashes
+static const NSUInteger kHashBitsPerLevel = 5;
+
+// Sub-tries are replaced by collision nodes once all hash bits have been consumed
+static const NSUInteger kHashBitCount = 32;
+
+// Function declarations
+static uint32_t persistentHash(id key);
+
+#pragma mark -
+#pragma mark HLSPersistentDictionaryNode class interface
+
+/**
+ * A trie node. Bitmap nodes store up to 32 entries, one for each possible value of the hash bits consumed at their
+ * level. An entry is either a key-value pair, or a sub-trie (for which the key is nil). Collision nodes store the
+ * key-value pairs whose keys have the same hash. Nodes are never modified once they have been built
+ */
+@interface HLSPersistentDictionaryNode : NSObject {
+@private
+    uint32_t m_bitmap;                  // bitmap nodes: bit i is set iff an entry exists for the hash bits value i
+    NSUInteger m_count;
+    id *m_keys;
+    id *m_values;
+    BOOL m_collision;
+}
+
++ (HLSPersistentDictionaryNode *)nodeWithKey1:(id)key1
+                                       value1:(id)value1
+                                        hash1:(uint32_t)hash1
+                                         key2:(id)key2
+                                       value2:(id)value2
+                                        hash2:(uint32_t)hash2
+                                        shift:(NSUInteger)shift;
+
+- (id)initWithBitmap:(uint32_t)bitmap count:(NSUInteger)count collision:(BOOL)collision;
+
+- (HLSPersistentDictionaryNode *)nodeByReplacingEntryAtIndex:(NSUInteger)index withKey:(id)key value:(id)value;
+- (HLSPersistentDictionaryNode *)nodeByInsertingEntryAtIndex:(NSUInteger)index bit:(uint32_t)bit withKey:(id)key value:(id)value;
+- (HLSPersistentDictionaryNode *)nodeByRemovingEntryAtIndex:(NSUInteger)index bit:(uint32_t)bit;
+
+- (id)objectForKey:(id)key hash:(uint32_t)hash shift:(NSUInteger)shift;
+
+- (HLSPersistentDictionaryNode *)nodeBySettingObject:(id)object
+                                              forKey:(id)key
+                                                hash:(uint32_t)hash
+                                               shift:(NSUInteger)shift
+                                               added:(BOOL *)pAdded;
+- (HLSPersistentDictionaryNode *)nodeByRemovingObjectForKey:(id)key
+                                                       hash:(uint32_t)hash
+                                                      shift:(NSUInteger)shift
+                                                    removed:(BOOL *)pRemoved;
+
+- (void)addKeysToArray:(NSMutableArray *)keys;
+
+@end
+
+#pragma mark -
+#pragma mark HLSPersistentDictionary class implementation
+
+@interface HLSPersistentDictionary ()
+
+- (id)initWithRootNode:(HLSPersistentDictionaryNode *)rootNode count:(NSUInteger)count;
+
+@end
+
+@implementation HLSPersistentDictionary
+
+#pragma mark Object creation and destruction
+
+- (id)initWithObjects:(const id [])objects forKeys:(const id [])keys count:(NSUInteger)count
+{
+    if ((self = [super init])) {
+        for (NSUInteger i = 0; i < count; ++i) {
+            if (! objects[i] || ! keys[i]) {
+                [self release];
+                @throw [NSException exceptionWithName:NSInvalidArgumentException 
+                                               reason:@"Objects and keys must not be nil" 
+                                             userInfo:nil];
+            }
+            
+            BOOL added = NO;
+            HLSPersistentDictionaryNode *rootNode = m_rootNode ? m_rootNode : [[[HLSPersistentDictionaryNode alloc] initWithBitmap:0 count:0 collision:NO] autorelease];
+            HLSPersistentDictionaryNode *updatedRootNode = [rootNode nodeBySettingObject:objects[i]
+                                                                                  forKey:keys[i]
+                                                                                    hash:persistentHash(keys[i])
+                                                                                   shift:0
+                                                                                   added:&added];
+            [m_rootNode release];
+            m_rootNode = [updatedRootNode retain];
+            if (added) {
+                ++m_count;
+            }
+        }
+    }
+    return self;
+}
+
+- (id)init
+{
+    return [self initWithObjects:NULL forKeys:NULL count:0];
+}
+
+- (id)initWithRootNode:(HLSPersistentDictionaryNode *)rootNode count:(NSUInteger)count
+{
+    if ((self = [super init])) {
+        m_rootNode = [rootNode retain];
+        m_count = count;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [m_rootNode release];
+    
+    [super dealloc];
+}
+
+#pragma mark NSDictionary primitive methods
+
+- (NSUInteger)count
+{
+    return m_count;
+}
+
+- (id)objectForKey:(id)key
+{
+    if (! key) {
+        return nil;
+    }
+    
+    return [m_rootNode objectForKey:key hash:persistentHash(key) shift:0];
+}
+
+- (NSEnumerator *)keyEnumerator
+{
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:m_count];
+    [m_rootNode addKeysToArray:keys];
+    return [keys objectEnumerator];
+}
+
+#pragma mark Persistent updates
+
+- (id)dictionaryBySettingObject:(id)object forKey:(id)key
+{
+    if (! object || ! key) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException 
+                                       reason:@"Objects and keys must not be nil" 
+                                     userInfo:nil];
+    }
+    
+    BOOL added = NO;
+    HLSPersistentDictionaryNode *rootNode = m_rootNode ? m_rootNode : [[[HLSPersistentDictionaryNode alloc] initWithBitmap:0 count:0 collision:NO] autorelease];
+    HLSPersistentDictionaryNode *updatedRootNode = [rootNode nodeBySettingObject:object
+                                                                          forKey:key
+                                                                            hash:persistentHash(key)
+                                                                           shift:0
+                                                                           added:&added];
+    if (updatedRootNode == m_rootNode) {
+        return self;
+    }
+    
+    return [[[HLSPersistentDictionary alloc] initWithRootNode:updatedRootNode count:added ? m_count + 1 : m_count] autorelease];
+}
+
+- (id)dictionaryByRemovingObjectForKey:(id)key
+{
+    if (! key || ! m_rootNode) {
+        return self;
+    }
+    
+    BOOL removed = NO;
+    HLSPersistentDictionaryNode *updatedRootNode = [m_rootNode nodeByRemovingObjectForKey:key 
+                                                                                     hash:persistentHash(key) 
+                                                                                    shift:0 
+                                                                                  removed:&removed];
+    if (! removed) {
+        return self;
+    }
+    
+    return [[[HLSPersistentDictionary alloc] initWithRootNode:updatedRootNode count:m_count - 1] autorelease];
+}
+
+- (id)dictionaryByRemovingObjectsForKeys:(NSArray *)keyArray
+{
+    HLSPersistentDictionary *dictionary = self;
+    for (id key in keyArray) {
+        dictionary = [dictionary dictionaryByRemovingObjectForKey:key];
+    }
+    return dictionary;
+}
+
+#pragma mark NSCopying protocol implementation
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // Immutable
+    return [self retain];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSPersistentDictionaryNode class implementation
+
+@implementation HLSPersistentDictionaryNode
+
+#pragma mark Class methods
+
+/**
+ * Return a node containing two key-value pairs at a given level
+ */
++ (HLSPersistentDictionaryNode *)nodeWithKey1:(id)key1
+                                       value1:(id)value1
+                                        hash1:(uint32_t)hash1
+                                         key2:(id)key2
+                                       value2:(id)value2
+                                        hash2:(uint32_t)hash2
+                                        shift:(NSUInteger)shift
+{
+    if (shift >= kHashBitCount) {
+        HLSPersistentDictionaryNode *node = [[[HLSPersistentDictionaryNode alloc] initWithBitmap:0 count:2 collision:YES] autorelease];
+        node->m_keys[0] = [key1 retain];
+        node->m_values[0] = [value1 retain];
+        node->m_keys[1] = [key2 retain];
+        node->m_values[1] = [value2 retain];
+        return node;
+    }
+    
+    uint32_t fragment1 = (hash1 >> shift) & 0x1f;
+    uint32_t fragment2 = (hash2 >> shift) & 0x1f;
+    if (fragment1 == fragment2) {
+        HLSPersistentDictionaryNode *node = [[[HLSPersistentDictionaryNode alloc] initWithBitmap:(1 << fragment1) count:1 collision:NO] autorelease];
+        node->m_values[0] = [[HLSPersistentDictionaryNode nodeWithKey1:key1
+                                                                value1:value1
+                                                                 hash1:hash1
+                                                                  key2:key2
+                                                                value2:value2
+                                                                 hash2:hash2
+                                                                 shift:shift + kHashBitsPerLevel] retain];
+        return node;
+    }
+    
+    HLSPersistentDictionaryNode *node = [[[HLSPersistentDictionaryNode alloc] initWithBitmap:(1 << fragment1) | (1 << fragment2) count:2 collision:NO] autorelease];
+    NSUInteger index1 = (fragment1 < fragment2) ? 0 : 1;
+    node->m_keys[index1] = [key1 retain];
+    node->m_values[index1] = [value1 retain];
+    node->m_keys[1 - index1] = [key2 retain];
+    node->m_values[1 - index1] = [value2 retain];
+    return node;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)initWithBitmap:(uint32_t)bitmap count:(NSUInteger)count collision:(BOOL)collision
+{
+    if ((self = [super init])) {
+        m_bitmap = bitmap;
+        m_count = count;
+        m_collision = collision;
+        if (count != 0) {
+            m_keys = calloc(count, sizeof(id));
+            m_values = calloc(count, sizeof(id));
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < m_count; ++i) {
+        [m_keys[i] release];
+        [m_values[i] release];
+    }
+    free(m_keys);
+    free(m_values);
+    
+    [super dealloc];
+}
+
+#pragma mark Building updated nodes
+
+- (HLSPersistentDictionaryNode *)nodeByReplacingEntryAtIndex:(NSUInteger)index withKey:(id)key value:(id)value
+{
+    HLSPersistentDictionaryNode *node = [[[HLSPersistentDictionaryNode alloc] initWithBitmap:m_bitmap count:m_count collision:m_collision] autorelease];
+    for (NSUInteger i = 0; i < m_count; ++i) {
+        node->m_keys[i] = [((i == index) ? key : m_keys[i]) retain];
+        node->m_values[i] = [((i == index) ? value : m_values[i]) retain];
+    }
+    return node;
+}
+
+- (HLSPersistentDictionaryNode *)nodeByInsertingEntryAtIndex:(NSUInteger)index bit:(uint32_t)bit withKey:(id)key value:(id)value
+{
+    HLSPersistentDictionaryNode *node = [[[HLSPersistentDictionaryNode alloc] initWithBitmap:m_bitmap | bit count:m_count + 1 collision:m_collision] autorelease];
+    for (NSUInteger i = 0; i < m_count + 1; ++i) {
+        if (i == index) {
+            node->m_keys[i] = [key retain];
+            node->m_values[i] = [value retain];
+        }
+        else {
+            NSUInteger j = (i < index) ? i : i - 1;
+            node->m_keys[i] = [m_keys[j] retain];
+            node->m_values[i] = [m_values[j] retain];
+        }
+    }
+    return node;
+}
+
+/**
+ * Return nil if the node would be empty
+ */
+- (HLSPersistentDictionaryNode *)nodeByRemovingEntryAtIndex:(NSUInteger)index bit:(uint32_t)bit
+{
+    if (m_count == 1) {
+        return nil;
+    }
+    
+    HLSPersistentDictionaryNode *node = [[[HLSPersistentDictionaryNode alloc] initWithBitmap:m_bitmap & ~bit count:m_count - 1 collision:m_collision] autorelease];
+    for (NSUInteger i = 0; i < m_count - 1; ++i) {
+        NSUInteger j = (i < index) ? i : i + 1;
+        node->m_keys[i] = [m_keys[j] retain];
+        node->m_values[i] = [m_values[j] retain];
+    }
+    return node;
+}
+
+#pragma mark Lookup
+
+- (id)objectForKey:(id)key hash:(uint32_t)hash shift:(NSUInteger)shift
+{
+    if (m_collision) {
+        for (NSUInteger i = 0; i < m_count; ++i) {
+            if ([m_keys[i] isEqual:key]) {
+                return m_values[i];
+            }
+        }
+        return nil;
+    }
+    
+    uint32_t bit = 1 << ((hash >> shift) & 0x1f);
+    if (! (m_bitmap & bit)) {
+        return nil;
+    }
+    
+    NSUInteger index = __builtin_popcount(m_bitmap & (bit - 1));
+    
+    // Sub-trie
+    if (! m_keys[index]) {
+        return [m_values[index] objectForKey:key hash:hash shift:shift + kHashBitsPerLevel];
+    }
+    
+    return [m_keys[index] isEqual:key] ? m_values[index] : nil;
+}
+
+#pragma mark Updates
+
+- (HLSPersistentDictionaryNode *)nodeBySettingObject:(id)object
+                                              forKey:(id)key
+                                                hash:(uint32_t)hash
+                                               shift:(NSUInteger)shift
+                                               added:(BOOL *)pAdded
+{
+    if (m_collision) {
+        for (NSUInteger i = 0; i < m_count; ++i) {
+            if ([m_keys[i] isEqual:key]) {
+                if (m_values[i] == object) {
+                    return self;
+                }
+                
+                return [self nodeByReplacingEntryAtIndex:i withKey:m_keys[i] value:object];
+            }
+        }
+        
+        *pAdded = YES;
+        id keyCopy = [[key copyWithZone:nil] autorelease];
+        return [self nodeByInsertingEntryAtIndex:m_count bit:0 withKey:keyCopy value:object];
+    }
+    
+    uint32_t bit = 1 << ((hash >> shift) & 0x1f);
+    NSUInteger index = __builtin_popcount(m_bitmap & (bit - 1));
+    
+    // Free slot
+    if (! (m_bitmap & bit)) {
+        *pAdded = YES;
+        id keyCopy = [[key copyWithZone:nil] autorelease];
+        return [self nodeByInsertingEntryAtIndex:index bit:bit withKey:keyCopy value:object];
+    }
+    
+    // Sub-trie
+    id existingKey = m_keys[index];
+    if (! existingKey) {
+        HLSPersistentDictionaryNode *subNode = m_values[index];
+        HLSPersistentDictionaryNode *updatedSubNode = [subNode nodeBySettingObject:object
+                                                                            forKey:key
+                                                                              hash:hash
+                                                                             shift:shift + kHashBitsPerLevel
+                                                                             added:pAdded];
+        if (updatedSubNode == subNode) {
+            return self;
+        }
+        
+        return [self nodeByReplacingEntryAtIndex:index withKey:nil value:updatedSubNode];
+    }
+    
+    // Same key
+    if ([existingKey isEqual:key]) {
+        if (m_values[index] == object) {
+            return self;
+        }
+        
+        return [self nodeByReplacingEntryAtIndex:index withKey:existingKey value:object];
+    }
+    
+    // Different keys with the same hash bits at this level: Push both pairs one level down
+    *pAdded = YES;
+    id keyCopy = [[key copyWithZone:nil] autorelease];
+    HLSPersistentDictionaryNode *subNode = [HLSPersistentDictionaryNode nodeWithKey1:existingKey
+                                                                              value1:m_values[index]
+                                                                               hash1:persistentHash(existingKey)
+                                                                                key2:keyCopy
+                                                                              value2:object
+                                                                               hash2:hash
+                                                                               shift:shift + kHashBitsPerLevel];
+    return [self nodeByReplacingEntryAtIndex:index withKey:nil value:subNode];
+}
+
+- (HLSPersistentDictionaryNode *)nodeByRemovingObjectForKey:(id)key
+                                                       hash:(uint32_t)hash
+                                                      shift:(NSUInteger)shift
+                                                    removed:(BOOL *)pRemoved
+{
+    if (m_collision) {
+        for (NSUInteger i = 0; i < m_count; ++i) {
+            if ([m_keys[i] isEqual:key]) {
+                *pRemoved = YES;
+                return [self nodeByRemovingEntryAtIndex:i bit:0];
+            }
+        }
+        return self;
+    }
+    
+    uint32_t bit = 1 << ((hash >> shift) & 0x1f);
+    if (! (m_bitmap & bit)) {
+        return self;
+    }
+    
+    NSUInteger index = __builtin_popcount(m_bitmap & (bit - 1));
+    
+    // Sub-trie
+    id existingKey = m_keys[index];
+    if (! existingKey) {
+        HLSPersistentDictionaryNode *subNode = m_values[index];
+        HLSPersistentDictionaryNode *updatedSubNode = [subNode nodeByRemovingObjectForKey:key
+                                                                                     hash:hash
+                                                                                    shift:shift + kHashBitsPerLevel
+                                                                                  removed:pRemoved];
+        if (updatedSubNode == subNode) {
+            return self;
+        }
+        
+        if (! updatedSubNode) {
+            return [self nodeByRemovingEntryAtIndex:index bit:bit];
+        }
+        
+        // A sub-trie left with a single key-value pair is replaced with it, so that the trie does not get deeper
+        // than needed
+        if (updatedSubNode->m_count == 1 && updatedSubNode->m_keys[0]) {
+            return [self nodeByReplacingEntryAtIndex:index withKey:updatedSubNode->m_keys[0] value:updatedSubNode->m_values[0]];
+        }
+        
+        return [self nodeByReplacingEntryAtIndex:index withKey:nil value:updatedSubNode];
+    }
+    
+    if (! [existingKey isEqual:key]) {
+        return self;
+    }
+    
+    *pRemoved = YES;
+    return [self nodeByRemovingEntryAtIndex:index bit:bit];
+}
+
+#pragma mark Enumeration
+
+- (void)addKeysToArray:(NSMutableArray *)keys
+{
+    for (NSUInteger i = 0; i < m_count; ++i) {
+        if (m_keys[i]) {
+            [keys addObject:m_keys[i]];
+        }
+        else {
+            [m_values[i] addKeysToArray:keys];
+        }
+    }
+}
+
+@end
+
+#pragma mark -
+#pragma mark Static functions
+
+static uint32_t persistentHash(id key)
+{
+    NSUInteger hash = [key hash];
+#if __LP64__
+    return (uint32_t)(hash ^ (hash >> 32));
+#else
+    return (uint32_t)hash;
+#endif
+}
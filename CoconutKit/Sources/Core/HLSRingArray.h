@@ -0,0 +1,38 @@
+//
+//  HLSRingArray.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * An immutable array whose rotated copies (see NSArray+HLSExtensions.h) are made in O(1) instead of O(n). The objects
+ * are stored once in a ring buffer, which is shared by all rotated copies, each one only storing the index at which it
+ * starts. Use this class for arrays which are often rotated, e.g. the items of a carousel which rotates each time the
+ * user swipes:
+ *   HLSRingArray *items = [HLSRingArray arrayWithArray:...];
+ *   items = [items arrayByLeftRotatingNumberOfObjects:1];
+ *
+ * Copying the array is free
+ *
+ * Designated initializer: -initWithObjects:count:
+ */
+@interface HLSRingArray : NSArray {
+@private
+    NSArray *m_objects;
+    NSUInteger m_offset;
+}
+
+/**
+ * Return the array rotated left or right, in O(1)
+ */
+- (id)arrayByLeftRotatingNumberOfObjects:(NSUInteger)numberOfObjects;
+- (id)arrayByRightRotatingNumberOfObjects:(NSUInteger)numberOfObjects;
+
+/**
+ * The index (in the array the receiver was created from) of the first object of the receiver
+ */
+@property (nonatomic, readonly, assign) NSUInteger offset;
+
+@end
@@ -0,0 +1,135 @@
+//
+//  HLSRingArray.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSRingArray.h"
+
+@interface HLSRingArray ()
+
+- (id)initWithObjects:(NSArray *)objects offset:(NSUInteger)offset;
+
+@end
+
+@implementation HLSRingArray
+
+#pragma mark Object creation and destruction
+
+- (id)initWithObjects:(const id [])objects count:(NSUInteger)count
+{
+    if ((self = [super init])) {
+        m_objects = [[NSArray alloc] initWithObjects:objects count:count];
+        m_offset = 0;
+    }
+    return self;
+}
+
+- (id)init
+{
+    return [self initWithObjects:NULL count:0];
+}
+
+- (id)initWithObjects:(NSArray *)objects offset:(NSUInteger)offset
+{
+    if ((self = [super init])) {
+        m_objects = [objects retain];
+        m_offset = offset;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [m_objects release];
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize offset = m_offset;
+
+#pragma mark NSArray primitive methods
+
+- (NSUInteger)count
+{
+    return [m_objects count];
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    NSUInteger count = [m_objects count];
+    if (index >= count) {
+        @throw [NSException exceptionWithName:NSRangeException 
+                                       reason:[NSString stringWithFormat:@"Index %u beyond bounds [0 .. %d]", index, (int)count - 1] 
+                                     userInfo:nil];
+    }
+    
+    // No modulo needed since both indices are smaller than count
+    NSUInteger ringIndex = index + m_offset;
+    if (ringIndex >= count) {
+        ringIndex -= count;
+    }
+    return [m_objects objectAtIndex:ringIndex];
+}
+
+#pragma mark Rotation
+
+- (id)arrayByLeftRotatingNumberOfObjects:(NSUInteger)numberOfObjects
+{
+    NSUInteger count = [m_objects count];
+    if (count == 0 || numberOfObjects % count == 0) {
+        return self;
+    }
+    
+    NSUInteger offset = (m_offset + numberOfObjects % count) % count;
+    return [[[HLSRingArray alloc] initWithObjects:m_objects offset:offset] autorelease];
+}
+
+- (id)arrayByRightRotatingNumberOfObjects:(NSUInteger)numberOfObjects
+{
+    NSUInteger count = [m_objects count];
+    if (count == 0 || numberOfObjects % count == 0) {
+        return self;
+    }
+    
+    return [self arrayByLeftRotatingNumberOfObjects:count - numberOfObjects % count];
+}
+
+#pragma mark NSFastEnumeration protocol implementation
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id *)stackbuf count:(NSUInteger)len
+{
+    // state->state is the index of the next object to enumerate. Objects are copied in chunks which do not wrap
+    // around the end of the ring buffer
+    NSUInteger count = [m_objects count];
+    NSUInteger index = state->state;
+    if (index >= count || len == 0) {
+        return 0;
+    }
+    
+    NSUInteger ringIndex = index + m_offset;
+    if (ringIndex >= count) {
+        ringIndex -= count;
+    }
+    NSUInteger chunkLength = MIN(len, MIN(count - index, count - ringIndex));
+    [m_objects getObjects:stackbuf range:NSMakeRange(ringIndex, chunkLength)];
+    
+    state->itemsPtr = stackbuf;
+    state->mutationsPtr = (unsigned long *)&m_offset;      // immutable, any stable address will do
+    state->state = index + chunkLength;
+    return chunkLength;
+}
+
+#pragma mark NSCopying protocol implementation
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // Immutable
+    return [self retain];
+}
+
+@end
@@ -29,3 +29,59 @@ IMP HLSSwizzleClassSelector(Class clazz, SEL selector, IMP newImplementation);
  * Replace the implementation of an instance method, given its selector. Return the original implementation
  */
 IMP HLSSwizzleSelector(Class clazz, SEL selector, IMP newImplementation);
+
+/**
+ * Describes a method implementation replacement for use with the batch swizzling functions. If pOriginalImplementation
+ * is not NULL, the original implementation is stored in the variable it points to (NULL if the method does not exist)
+ */
+typedef struct {
+    SEL selector;
+    IMP newImplementation;
+    IMP *pOriginalImplementation;
+} HLSSwizzlingEntry;
+
+/**
+ * Replace the implementations of several instance (respectively class) methods of a class in a single pass. Methods
+ * are looked up in the class method list at once, the superclasses being searched only for the methods which the
+ * class itself does not implement. Methods which cannot be found are not replaced.
+ *
+ * The time spent is recorded under the subsystem name (a C string literal, e.g. "UILabel+HLSDynamicLocalization") for
+ * the report returned by HLSSwizzlingReport(). These functions do not create any autoreleased object and can be called
+ * from +load methods
+ *
+ * Return the number of methods which have been replaced
+ */
+NSUInteger HLSSwizzleSelectors(Class clazz, const HLSSwizzlingEntry *entries, NSUInteger numberOfEntries, const char *subsystemName);
+NSUInteger HLSSwizzleClassSelectors(Class clazz, const HLSSwizzlingEntry *entries, NSUInteger numberOfEntries, const char *subsystemName);
+
+/**
+ * Return a report listing, for each subsystem, the number of methods swizzled through the batch swizzling functions
+ * and the time spent doing so (e.g. to be logged once the application has finished launching)
+ */
+NSString *HLSSwizzlingReport(void);
+
+/**
+ * Return the list of all classes known to the runtime, and their number in the variable pointed to by pNumberOfClasses
+ * (if not NULL). The list is retrieved from the runtime once and cached afterwards, so that all CoconutKit components
+ * needing to scan classes share a single, expensive call to objc_copyClassList. The returned array belongs to the
+ * cache and must not be freed
+ *
+ * Remark: Since the list is a snapshot, classes loaded or created after the first call (e.g. from bundles loaded later)
+ *         are not listed
+ */
+Class *hls_classList(unsigned int *pNumberOfClasses);
+
+/**
+ * Return YES iff subclass is a strict or non-strict subclass of superclass. Unlike -[NSObject isSubclassOfClass:], this
+ * function can be safely used with any kind of class (e.g. classes which are not NSObject subclasses, or proxies)
+ */
+BOOL hls_class_isSubclassOfClass(Class subclass, Class superclass);
+
+/**
+ * Return the list of the classes declaring conformance to a protocol (as for class_conformsToProtocol, conformance
+ * declared by superclasses is not taken into account), respectively of the strict subclasses of a class, and their number in the variable pointed to by pNumberOfClasses (if not NULL). 
+ * Lists are built from the list returned by hls_classList() the first time they are requested and cached afterwards
+ * (with the same snapshot limitation). The returned arrays belong to the cache and must not be freed
+ */
+Class *hls_classesConformingToProtocol(Protocol *protocol, unsigned int *pNumberOfClasses);
+Class *hls_subclassesOfClass(Class superclass, unsigned int *pNumberOfClasses);
@@ -8,29 +8,254 @@
 
 #import "HLSRuntime.h"
 
+#import <libkern/OSAtomic.h>
+#import "HLSLaunchTracer.h"
+
+/**
+ * Time spent by a subsystem swizzling methods
+ */
+typedef struct {
+    const char *subsystemName;
+    NSUInteger numberOfSwizzledMethods;
+    CFAbsoluteTime duration;
+} HLSSwizzlingRecord;
+
+/**
+ * Filtered class list
+ */
+typedef struct {
+    Class *classes;
+    unsigned int numberOfClasses;
+} HLSClassList;
+
+// Swizzling records, in the order in which subsystems first swizzled methods
+static HLSSwizzlingRecord *s_swizzlingRecords = NULL;
+static NSUInteger s_numberOfSwizzlingRecords = 0;
+static OSSpinLock s_swizzlingRecordsLock = OS_SPINLOCK_INIT;
+
+// Filtered class list caches
+static CFMutableDictionaryRef s_protocolToClassListMap = NULL;
+static CFMutableDictionaryRef s_superclassToSubclassListMap = NULL;
+static OSSpinLock s_classListsLock = OS_SPINLOCK_INIT;
+
+// Function declarations
+static NSUInteger swizzleSelectors(Class clazz, const HLSSwizzlingEntry *entries, NSUInteger numberOfEntries);
+static void recordSwizzling(const char *subsystemName, NSUInteger numberOfSwizzledMethods, CFAbsoluteTime duration);
+static Class *filteredClassList(CFMutableDictionaryRef *pCache, const void *key, BOOL (*filter)(Class, const void *),
+                                unsigned int *pNumberOfClasses);
+static BOOL classConformsToProtocol(Class class, const void *protocol);
+static BOOL classIsStrictSubclassOfClass(Class class, const void *superclass);
+
 IMP HLSSwizzleClassSelector(Class clazz, SEL selector, IMP newImplementation)
 {
+    CFAbsoluteTime startTime = HLSLaunchTracerBegin();
+    
     // Get the original implementation we are replacing
     Class metaClass = objc_getMetaClass(class_getName(clazz));
     Method method = class_getClassMethod(metaClass, selector);
     IMP origImp = method_getImplementation(method);
-    if (! origImp) {
-        return NULL;
+    if (origImp) {
+        class_replaceMethod(metaClass, selector, newImplementation, method_getTypeEncoding(method));
     }
     
-    class_replaceMethod(metaClass, selector, newImplementation, method_getTypeEncoding(method));
+    HLSLaunchTracerEnd("HLSSwizzleClassSelector", startTime);
     return origImp;
 }
 
 IMP HLSSwizzleSelector(Class clazz, SEL selector, IMP newImplementation)
 {
+    CFAbsoluteTime startTime = HLSLaunchTracerBegin();
+    
     // Get the original implementation we are replacing
     Method method = class_getInstanceMethod(clazz, selector);
     IMP origImp = method_getImplementation(method);
-    if (! origImp) {
-        return NULL;
+    if (origImp) {
+        class_replaceMethod(clazz, selector, newImplementation, method_getTypeEncoding(method));
     }
     
-    class_replaceMethod(clazz, selector, newImplementation, method_getTypeEncoding(method));
+    HLSLaunchTracerEnd("HLSSwizzleSelector", startTime);
     return origImp;
 }
+
+NSUInteger HLSSwizzleSelectors(Class clazz, const HLSSwizzlingEntry *entries, NSUInteger numberOfEntries, const char *subsystemName)
+{
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    NSUInteger numberOfSwizzledMethods = swizzleSelectors(clazz, entries, numberOfEntries);
+    recordSwizzling(subsystemName, numberOfSwizzledMethods, CFAbsoluteTimeGetCurrent() - startTime);
+    HLSLaunchTracerEnd(subsystemName, startTime);
+    return numberOfSwizzledMethods;
+}
+
+NSUInteger HLSSwizzleClassSelectors(Class clazz, const HLSSwizzlingEntry *entries, NSUInteger numberOfEntries, const char *subsystemName)
+{
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    NSUInteger numberOfSwizzledMethods = swizzleSelectors(objc_getMetaClass(class_getName(clazz)), entries, numberOfEntries);
+    recordSwizzling(subsystemName, numberOfSwizzledMethods, CFAbsoluteTimeGetCurrent() - startTime);
+    HLSLaunchTracerEnd(subsystemName, startTime);
+    return numberOfSwizzledMethods;
+}
+
+NSString *HLSSwizzlingReport(void)
+{
+    NSMutableString *report = [NSMutableString stringWithString:@"Method swizzling:"];
+    CFAbsoluteTime totalDuration = 0.;
+    
+    OSSpinLockLock(&s_swizzlingRecordsLock);
+    for (NSUInteger i = 0; i < s_numberOfSwizzlingRecords; ++i) {
+        HLSSwizzlingRecord record = s_swizzlingRecords[i];
+        [report appendFormat:@"\n    %s: %u method(s) in %.3f ms", record.subsystemName, record.numberOfSwizzledMethods, 
+            record.duration * 1000.];
+        totalDuration += record.duration;
+    }
+    OSSpinLockUnlock(&s_swizzlingRecordsLock);
+    
+    [report appendFormat:@"\n    Total: %.3f ms", totalDuration * 1000.];
+    return [NSString stringWithString:report];
+}
+
+Class *hls_classList(unsigned int *pNumberOfClasses)
+{
+    static Class *s_classes = NULL;
+    static unsigned int s_numberOfClasses = 0;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        CFAbsoluteTime startTime = HLSLaunchTracerBegin();
+        s_classes = objc_copyClassList(&s_numberOfClasses);
+        HLSLaunchTracerEnd("objc_copyClassList", startTime);
+    });
+    
+    if (pNumberOfClasses) {
+        *pNumberOfClasses = s_numberOfClasses;
+    }
+    return s_classes;
+}
+
+BOOL hls_class_isSubclassOfClass(Class subclass, Class superclass)
+{
+    // Do not use -isSubclassOfClass: since it is an NSObject method and we might encounter other kinds of classes
+    Class class = subclass;
+    while (class && class != superclass) {
+        class = class_getSuperclass(class);
+    }
+    return class != Nil;
+}
+
+Class *hls_classesConformingToProtocol(Protocol *protocol, unsigned int *pNumberOfClasses)
+{
+    return filteredClassList(&s_protocolToClassListMap, protocol, classConformsToProtocol, pNumberOfClasses);
+}
+
+Class *hls_subclassesOfClass(Class superclass, unsigned int *pNumberOfClasses)
+{
+    return filteredClassList(&s_superclassToSubclassListMap, superclass, classIsStrictSubclassOfClass, pNumberOfClasses);
+}
+
+#pragma mark Static functions
+
+static NSUInteger swizzleSelectors(Class clazz, const HLSSwizzlingEntry *entries, NSUInteger numberOfEntries)
+{
+    // Locate all methods implemented by the class itself in a single scan of its method list
+    Method *methods = calloc(numberOfEntries, sizeof(Method));
+    unsigned int numberOfClassMethods = 0;
+    Method *classMethods = class_copyMethodList(clazz, &numberOfClassMethods);
+    for (unsigned int i = 0; i < numberOfClassMethods; ++i) {
+        SEL selector = method_getName(classMethods[i]);
+        for (NSUInteger j = 0; j < numberOfEntries; ++j) {
+            if (sel_isEqual(entries[j].selector, selector)) {
+                methods[j] = classMethods[i];
+            }
+        }
+    }
+    free(classMethods);
+    
+    NSUInteger numberOfSwizzledMethods = 0;
+    for (NSUInteger j = 0; j < numberOfEntries; ++j) {
+        // Inherited methods
+        Method method = methods[j] ?: class_getInstanceMethod(clazz, entries[j].selector);
+        IMP origImp = method_getImplementation(method);
+        if (entries[j].pOriginalImplementation) {
+            *entries[j].pOriginalImplementation = origImp;
+        }
+        if (! origImp) {
+            continue;
+        }
+        
+        class_replaceMethod(clazz, entries[j].selector, entries[j].newImplementation, method_getTypeEncoding(method));
+        ++numberOfSwizzledMethods;
+    }
+    free(methods);
+    
+    return numberOfSwizzledMethods;
+}
+
+static void recordSwizzling(const char *subsystemName, NSUInteger numberOfSwizzledMethods, CFAbsoluteTime duration)
+{
+    OSSpinLockLock(&s_swizzlingRecordsLock);
+    
+    // Accumulate if the subsystem has already swizzled other classes
+    HLSSwizzlingRecord *record = NULL;
+    for (NSUInteger i = 0; i < s_numberOfSwizzlingRecords; ++i) {
+        if (strcmp(s_swizzlingRecords[i].subsystemName, subsystemName) == 0) {
+            record = &s_swizzlingRecords[i];
+            break;
+        }
+    }
+    
+    if (! record) {
+        s_swizzlingRecords = realloc(s_swizzlingRecords, (s_numberOfSwizzlingRecords + 1) * sizeof(HLSSwizzlingRecord));
+        record = &s_swizzlingRecords[s_numberOfSwizzlingRecords];
+        record->subsystemName = subsystemName;
+        record->numberOfSwizzledMethods = 0;
+        record->duration = 0.;
+        ++s_numberOfSwizzlingRecords;
+    }
+    
+    record->numberOfSwizzledMethods += numberOfSwizzledMethods;
+    record->duration += duration;
+    
+    OSSpinLockUnlock(&s_swizzlingRecordsLock);
+}
+
+static Class *filteredClassList(CFMutableDictionaryRef *pCache, const void *key, BOOL (*filter)(Class, const void *),
+                                unsigned int *pNumberOfClasses)
+{
+    OSSpinLockLock(&s_classListsLock);
+    
+    if (! *pCache) {
+        *pCache = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    }
+    
+    HLSClassList *classList = (HLSClassList *)CFDictionaryGetValue(*pCache, key);
+    if (! classList) {
+        unsigned int numberOfClasses = 0;
+        Class *classes = hls_classList(&numberOfClasses);
+        
+        classList = malloc(sizeof(HLSClassList));
+        classList->classes = malloc(MAX(numberOfClasses, 1) * sizeof(Class));
+        classList->numberOfClasses = 0;
+        for (unsigned int i = 0; i < numberOfClasses; ++i) {
+            if ((*filter)(classes[i], key)) {
+                classList->classes[classList->numberOfClasses] = classes[i];
+                ++classList->numberOfClasses;
+            }
+        }
+        CFDictionarySetValue(*pCache, key, classList);
+    }
+    
+    OSSpinLockUnlock(&s_classListsLock);
+    
+    if (pNumberOfClasses) {
+        *pNumberOfClasses = classList->numberOfClasses;
+    }
+    return classList->classes;
+}
+
+static BOOL classConformsToProtocol(Class class, const void *protocol)
+{
+    return class_conformsToProtocol(class, (Protocol *)protocol);
+}
+
+static BOOL classIsStrictSubclassOfClass(Class class, const void *superclass)
+{
+    return class != (Class)superclass && hls_class_isSubclassOfClass(class, (Class)superclass);
+}
@@ -6,11 +6,111 @@
 //  Copyright (c) 2012 Hortis. All rights reserved.
 //
 
+#import <libkern/OSAtomic.h>
 #import "HLSFileManager.h"
 
+/**
+ * Policies for writing file contents
+ */
+typedef enum {
+    HLSFileWritingPolicyEnumBegin = 0,
+    HLSFileWritingPolicyAtomic = HLSFileWritingPolicyEnumBegin,         // Write to a temporary file which then replaces the file
+    HLSFileWritingPolicyInPlace,                                        // Overwrite the file directly (cheaper, but a crash can
+                                                                        // leave it truncated)
+    HLSFileWritingPolicyDeferred,                                       // Keep the contents in memory and write them in place
+                                                                        // later, in a batch with other deferred writes
+    HLSFileWritingPolicyEnumEnd,
+    HLSFileWritingPolicyEnumSize = HLSFileWritingPolicyEnumEnd - HLSFileWritingPolicyEnumBegin
+} HLSFileWritingPolicy;
+
+/**
+ * Hints about how the contents of a file will be accessed once read into memory
+ */
+typedef enum {
+    HLSFileAccessPatternEnumBegin = 0,
+    HLSFileAccessPatternNormal = HLSFileAccessPatternEnumBegin,         // No hint, the system defaults apply
+    HLSFileAccessPatternSequential,                                     // Read from start to end (e.g. video chunks, archives). The
+                                                                        // system reads ahead aggressively and can drop pages behind
+    HLSFileAccessPatternRandom,                                         // Read at random locations (e.g. an index). Read-ahead is
+                                                                        // disabled so that only the pages accessed are read
+    HLSFileAccessPatternWillNeed,                                       // The whole content will be read soon. It is prefetched
+                                                                        // asynchronously
+    HLSFileAccessPatternEnumEnd,
+    HLSFileAccessPatternEnumSize = HLSFileAccessPatternEnumEnd - HLSFileAccessPatternEnumBegin
+} HLSFileAccessPattern;
+
+/**
+ * Data mapped into virtual memory, as returned by -[HLSStandardFileManager contentsOfFileAtPath:accessPattern:error:]. 
+ * Pages are read from the file when they are first accessed. The mapping is removed when the object is deallocated, 
+ * or earlier by calling -unmap
+ */
+@interface HLSMappedData : NSData {
+@private
+    void *m_bytes;
+    NSUInteger m_length;
+}
+
+/**
+ * Give a hint about how a range of the data will be accessed (e.g. HLSFileAccessPatternWillNeed for the next chunk
+ * to be read). The range is extended to whole pages
+ */
+- (void)adviseAccessPattern:(HLSFileAccessPattern)accessPattern forRange:(NSRange)range;
+
+/**
+ * Remove the mapping immediately, releasing the virtual memory and the pages read without waiting for the object to be
+ * deallocated. The data is empty afterwards. Pointers previously obtained from -bytes must not be used anymore
+ */
+- (void)unmap;
+
+@end
+
 /**
  * A standard NSFileManager-based file manager
+ *
+ * Files are written atomically by default. Other policies can be set for the whole manager or for a single write.
+ * Deferred writes are collected and flushed together on a background queue, batchingInterval seconds after the
+ * first of them. Until then, their contents are returned by -contentsOfFileAtPath:error: and their files reported by
+ * -fileExistsAtPath:isDirectory:. All other operations flush pending writes first, as is also done when the application
+ * enters the background or terminates. Since no caller is waiting for them, errors on deferred writes are logged
+ *
+ * Designated initializer: -init
+ */
+@interface HLSStandardFileManager : HLSFileManager {
+@private
+    HLSFileWritingPolicy m_writingPolicy;
+    NSTimeInterval m_batchingInterval;
+    NSMutableDictionary *m_pathToPendingContentsMap;
+    OSSpinLock m_pendingContentsLock;
+    BOOL m_flushScheduled;
+    dispatch_queue_t m_flushQueue;
+}
+
+/**
+ * The policy used by -createFileAtPath:contents:error:. Default value is HLSFileWritingPolicyAtomic
+ */
+@property (nonatomic, assign) HLSFileWritingPolicy writingPolicy;
+
+/**
+ * The delay after which deferred writes are flushed. Default value is 1 second
+ */
+@property (nonatomic, assign) NSTimeInterval batchingInterval;
+
+/**
+ * Write a file using a specific policy
+ */
+- (BOOL)createFileAtPath:(NSString *)path contents:(NSData *)contents writingPolicy:(HLSFileWritingPolicy)writingPolicy error:(NSError **)pError;
+
+/**
+ * Return the contents of a file mapped into virtual memory, applying a hint about how it will be accessed. For files
+ * which have pending deferred writes, the pending contents are returned (as an NSData object). Files are otherwise 
+ * returned as HLSMappedData objects, which can be unmapped as soon as they are not needed anymore. Empty files yield
+ * empty NSData objects
+ */
+- (NSData *)contentsOfFileAtPath:(NSString *)path accessPattern:(HLSFileAccessPattern)accessPattern error:(NSError **)pError;
+
+/**
+ * Synchronously write all pending deferred writes
  */
-@interface HLSStandardFileManager : HLSFileManager
+- (void)flushPendingWrites;
 
 @end
@@ -8,54 +8,666 @@
 
 #import "HLSStandardFileManager.h"
 
+#import <fcntl.h>
+#import <fts.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import "HLSAssert.h"
+#import "HLSLaunchTracer.h"
+#import "HLSLogger.h"
+
+#pragma mark -
+#pragma mark HLSStandardFileHandle class interface
+
+/**
+ * File handle implemented using a file descriptor
+ *
+ * Designated initializer: -initWithPath:flags:error:
+ */
+@interface HLSStandardFileHandle : NSObject <HLSFileHandle> {
+@private
+    int m_fileDescriptor;
+}
+
+/**
+ * Open the file at the given path, using flags as for open(2)
+ */
+- (id)initWithPath:(NSString *)path flags:(int)flags error:(NSError **)pError;
+
+@end
+
+#pragma mark -
+#pragma mark HLSMappedData class interface extension
+
+@interface HLSMappedData ()
+
+/**
+ * Take ownership of a mapping
+ */
+- (id)initWithMappedBytes:(void *)bytes length:(NSUInteger)length;
+
+@end
+
+// Function declarations
+static void adviseAccessPattern(void *bytes, NSUInteger length, HLSFileAccessPattern accessPattern);
+
 __attribute__ ((constructor)) static void HLSStandardFileManagerInstall(void)
 {
+    CFAbsoluteTime startTime = HLSLaunchTracerBegin();
     HLSStandardFileManager *fileManager = [[[HLSStandardFileManager alloc] init] autorelease];
     [HLSFileManager setDefaultManager:fileManager];
+    HLSLaunchTracerEnd("HLSStandardFileManagerInstall", startTime);
 }
 
+#pragma mark -
+#pragma mark HLSStandardFileManager class interface extension
+
+@interface HLSStandardFileManager ()
+
+- (void)writePendingContents;
+
+- (void)applicationDidEnterBackground:(NSNotification *)notification;
+- (void)applicationWillTerminate:(NSNotification *)notification;
+
+@end
+
+#pragma mark -
+#pragma mark HLSStandardFileManager class implementation
+
 @implementation HLSStandardFileManager
 
-#pragma mark DMSFileManagerAbstract protocol implementation
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.writingPolicy = HLSFileWritingPolicyAtomic;
+        self.batchingInterval = 1.;
+        m_pathToPendingContentsMap = [[NSMutableDictionary alloc] init];
+        m_pendingContentsLock = OS_SPINLOCK_INIT;
+        m_flushQueue = dispatch_queue_create("ch.hortis.CoconutKit.HLSStandardFileManager.flush", NULL);
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationDidEnterBackground:)
+                                                     name:UIApplicationDidEnterBackgroundNotification
+                                                   object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationWillTerminate:)
+                                                     name:UIApplicationWillTerminateNotification
+                                                   object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    
+    [self flushPendingWrites];
+    
+    [m_pathToPendingContentsMap release];
+    dispatch_release(m_flushQueue);
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize writingPolicy = m_writingPolicy;
+
+- (void)setWritingPolicy:(HLSFileWritingPolicy)writingPolicy
+{
+    if (writingPolicy < HLSFileWritingPolicyEnumBegin || writingPolicy >= HLSFileWritingPolicyEnumEnd) {
+        HLSLoggerError(@"Invalid writing policy");
+        return;
+    }
+    
+    m_writingPolicy = writingPolicy;
+}
+
+@synthesize batchingInterval = m_batchingInterval;
+
+#pragma mark Writing files
+
+- (BOOL)createFileAtPath:(NSString *)path contents:(NSData *)contents writingPolicy:(HLSFileWritingPolicy)writingPolicy error:(NSError **)pError
+{
+    switch (writingPolicy) {
+        case HLSFileWritingPolicyAtomic: {
+            return [contents writeToFile:path options:NSDataWritingAtomic error:pError];
+            break;
+        }
+        
+        case HLSFileWritingPolicyInPlace: {
+            return [contents writeToFile:path options:0 error:pError];
+            break;
+        }
+        
+        case HLSFileWritingPolicyDeferred: {
+            // Take a snapshot of the contents, which might be mutable
+            NSData *pendingContents = [NSData dataWithData:contents];
+            
+            OSSpinLockLock(&m_pendingContentsLock);
+            [m_pathToPendingContentsMap setObject:pendingContents forKey:path];
+            BOOL scheduleFlush = ! m_flushScheduled;
+            m_flushScheduled = YES;
+            OSSpinLockUnlock(&m_pendingContentsLock);
+            
+            if (scheduleFlush) {
+                dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.batchingInterval * NSEC_PER_SEC)), m_flushQueue, ^{
+                    [self writePendingContents];
+                });
+            }
+            return YES;
+            break;
+        }
+        
+        default: {
+            HLSLoggerError(@"Invalid writing policy");
+            return NO;
+            break;
+        }
+    }
+}
+
+- (void)flushPendingWrites
+{
+    // Pending contents are only removed once written: Nothing to wait for if there are none
+    OSSpinLockLock(&m_pendingContentsLock);
+    BOOL hasPendingContents = ([m_pathToPendingContentsMap count] != 0);
+    OSSpinLockUnlock(&m_pendingContentsLock);
+    if (! hasPendingContents) {
+        return;
+    }
+    
+    dispatch_sync(m_flushQueue, ^{
+        [self writePendingContents];
+    });
+}
+
+// Must be called on the flush queue, so that successive batches are written in order
+- (void)writePendingContents
+{
+    OSSpinLockLock(&m_pendingContentsLock);
+    NSDictionary *pathToPendingContentsMap = [NSDictionary dictionaryWithDictionary:m_pathToPendingContentsMap];
+    m_flushScheduled = NO;
+    OSSpinLockUnlock(&m_pendingContentsLock);
+    
+    for (NSString *path in [pathToPendingContentsMap allKeys]) {
+        NSData *contents = [pathToPendingContentsMap objectForKey:path];
+        NSError *error = nil;
+        if (! [contents writeToFile:path options:0 error:&error]) {
+            HLSLoggerError(@"The deferred write to %@ failed. Reason: %@", path, error);
+        }
+        
+        // Pending contents remain visible until written, unless they have been replaced in the meantime
+        OSSpinLockLock(&m_pendingContentsLock);
+        if ([m_pathToPendingContentsMap objectForKey:path] == contents) {
+            [m_pathToPendingContentsMap removeObjectForKey:path];
+        }
+        OSSpinLockUnlock(&m_pendingContentsLock);
+    }
+}
+
+#pragma mark Reading files
+
+- (NSData *)contentsOfFileAtPath:(NSString *)path accessPattern:(HLSFileAccessPattern)accessPattern error:(NSError **)pError
+{
+    OSSpinLockLock(&m_pendingContentsLock);
+    NSData *pendingContents = [[[m_pathToPendingContentsMap objectForKey:path] retain] autorelease];
+    OSSpinLockUnlock(&m_pendingContentsLock);
+    if (pendingContents) {
+        return pendingContents;
+    }
+    
+    int fileDescriptor = open([path fileSystemRepresentation], O_RDONLY);
+    if (fileDescriptor < 0) {
+        if (pError) {
+            *pError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        }
+        return nil;
+    }
+    
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0) {
+        if (pError) {
+            *pError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        }
+        close(fileDescriptor);
+        return nil;
+    }
+    
+    // Cannot map empty files
+    if (fileStat.st_size == 0) {
+        close(fileDescriptor);
+        return [NSData data];
+    }
+    
+    NSUInteger length = (NSUInteger)fileStat.st_size;
+    
+    // Read-ahead when pages are read through the file descriptor (the unified buffer cache is shared with the mapping)
+    switch (accessPattern) {
+        case HLSFileAccessPatternSequential: {
+            fcntl(fileDescriptor, F_RDAHEAD, 1);
+            break;
+        }
+            
+        case HLSFileAccessPatternRandom: {
+            fcntl(fileDescriptor, F_RDAHEAD, 0);
+            break;
+        }
+            
+        case HLSFileAccessPatternWillNeed: {
+            struct radvisory advisory;
+            advisory.ra_offset = 0;
+            advisory.ra_count = (int)MIN(fileStat.st_size, INT_MAX);
+            fcntl(fileDescriptor, F_RDADVISE, &advisory);
+            break;
+        }
+            
+        default: {
+            break;
+        }
+    }
+    
+    // The mapping remains valid after the file descriptor has been closed
+    void *bytes = mmap(NULL, length, PROT_READ, MAP_FILE | MAP_SHARED, fileDescriptor, 0);
+    int mmapErrno = errno;
+    close(fileDescriptor);
+    if (bytes == MAP_FAILED) {
+        if (pError) {
+            *pError = [NSError errorWithDomain:NSPOSIXErrorDomain code:mmapErrno userInfo:nil];
+        }
+        return nil;
+    }
+    
+    adviseAccessPattern(bytes, length, accessPattern);
+    return [[[HLSMappedData alloc] initWithMappedBytes:bytes length:length] autorelease];
+}
+
+#pragma mark Notification callbacks
+
+- (void)applicationDidEnterBackground:(NSNotification *)notification
+{
+    [self flushPendingWrites];
+}
+
+- (void)applicationWillTerminate:(NSNotification *)notification
+{
+    [self flushPendingWrites];
+}
+
+#pragma mark HLSFileManagerAbstract protocol implementation
 
 - (NSData *)contentsOfFileAtPath:(NSString *)path error:(NSError **)pError
 {
+    OSSpinLockLock(&m_pendingContentsLock);
+    NSData *pendingContents = [[[m_pathToPendingContentsMap objectForKey:path] retain] autorelease];
+    OSSpinLockUnlock(&m_pendingContentsLock);
+    if (pendingContents) {
+        return pendingContents;
+    }
+    
     return [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:pError];
 }
 
 - (BOOL)createFileAtPath:(NSString *)path contents:(NSData *)contents error:(NSError **)pError
 {
-    return [contents writeToFile:path options:NSDataWritingAtomic error:pError];
+    return [self createFileAtPath:path contents:contents writingPolicy:self.writingPolicy error:pError];
+}
+
+- (id<HLSFileHandle>)fileHandleForReadingAtPath:(NSString *)path error:(NSError **)pError
+{
+    [self flushPendingWrites];
+    
+    return [[[HLSStandardFileHandle alloc] initWithPath:path flags:O_RDONLY error:pError] autorelease];
+}
+
+- (id<HLSFileHandle>)fileHandleForWritingAtPath:(NSString *)path error:(NSError **)pError
+{
+    [self flushPendingWrites];
+    
+    return [[[HLSStandardFileHandle alloc] initWithPath:path flags:O_WRONLY | O_CREAT | O_TRUNC error:pError] autorelease];
+}
+
+- (id<HLSFileHandle>)fileHandleForAppendingAtPath:(NSString *)path error:(NSError **)pError
+{
+    [self flushPendingWrites];
+    
+    return [[[HLSStandardFileHandle alloc] initWithPath:path flags:O_WRONLY | O_CREAT | O_APPEND error:pError] autorelease];
 }
 
 - (BOOL)createDirectoryAtPath:(NSString *)path withIntermediateDirectories:(BOOL)withIntermediateDirectories error:(NSError **)pError
 {
+    [self flushPendingWrites];
+    
     return [[NSFileManager defaultManager] createDirectoryAtPath:path withIntermediateDirectories:withIntermediateDirectories attributes:nil error:pError];
 }
 
 - (NSArray *)contentsOfDirectoryAtPath:(NSString *)path error:(NSError **)pError
 {
+    [self flushPendingWrites];
+    
     return [[NSFileManager defaultManager] contentsOfDirectoryAtPath:path error:pError];
 }
 
+- (NSArray *)itemsInDirectoryAtPath:(NSString *)path 
+                         attributes:(HLSFileAttributes)attributes 
+                          recursive:(BOOL)recursive 
+                              error:(NSError **)pError
+{
+    [self flushPendingWrites];
+    
+    // A single traversal reads entries and their attributes. When no attribute is needed, fts only stats directories
+    // (which it recognizes using the directory entry type)
+    int options = FTS_PHYSICAL | FTS_COMFOLLOW | FTS_NOCHDIR;
+    if (attributes == HLSFileAttributeNone) {
+        options |= FTS_NOSTAT;
+    }
+    
+    char *paths[] = { (char *)[path fileSystemRepresentation], NULL };
+    FTS *fts = fts_open(paths, options, NULL);
+    if (! fts) {
+        if (pError) {
+            *pError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        }
+        return nil;
+    }
+    
+    NSMutableArray *items = [NSMutableArray array];
+    size_t rootPathLength = 0;
+    FTSENT *entry = NULL;
+    while ((entry = fts_read(fts))) {
+        if (entry->fts_level == FTS_ROOTLEVEL) {
+            if (entry->fts_info == FTS_D) {
+                rootPathLength = entry->fts_pathlen;
+                continue;
+            }
+            // Post-order visit of the root: Done
+            else if (entry->fts_info == FTS_DP) {
+                continue;
+            }
+            
+            if (pError) {
+                int errorCode = (entry->fts_info == FTS_F) ? ENOTDIR : entry->fts_errno;
+                *pError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errorCode userInfo:nil];
+            }
+            fts_close(fts);
+            return nil;
+        }
+        
+        // Directories are visited twice (skip post-order visits), and unreadable entries are ignored
+        if (entry->fts_info == FTS_DP || entry->fts_info == FTS_DNR || entry->fts_info == FTS_ERR || entry->fts_info == FTS_NS) {
+            continue;
+        }
+        
+        BOOL isDirectory = (entry->fts_info == FTS_D);
+        if (isDirectory && ! recursive) {
+            fts_set(fts, entry, FTS_SKIP);
+        }
+        
+        unsigned long long size = 0;
+        NSDate *modificationDate = nil;
+        if (entry->fts_info != FTS_NSOK) {
+            if (attributes & HLSFileAttributeSize) {
+                size = entry->fts_statp->st_size;
+            }
+            if (attributes & HLSFileAttributeModificationDate) {
+                struct timespec modificationTime = entry->fts_statp->st_mtimespec;
+                modificationDate = [NSDate dateWithTimeIntervalSince1970:modificationTime.tv_sec + modificationTime.tv_nsec / 1e9];
+            }
+        }
+        
+        const char *relativePath = entry->fts_path + rootPathLength;
+        while (*relativePath == '/') {
+            ++relativePath;
+        }
+        NSString *itemPath = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:relativePath length:strlen(relativePath)];
+        HLSFileItem *item = [[HLSFileItem alloc] initWithPath:itemPath directory:isDirectory size:size modificationDate:modificationDate];
+        [items addObject:item];
+        [item release];
+    }
+    
+    fts_close(fts);
+    return [NSArray arrayWithArray:items];
+}
+
 - (BOOL)fileExistsAtPath:(NSString *)path isDirectory:(BOOL *)pIsDirectory
 {
+    OSSpinLockLock(&m_pendingContentsLock);
+    BOOL pending = ([m_pathToPendingContentsMap objectForKey:path] != nil);
+    OSSpinLockUnlock(&m_pendingContentsLock);
+    if (pending) {
+        if (pIsDirectory) {
+            *pIsDirectory = NO;
+        }
+        return YES;
+    }
+    
     return [[NSFileManager defaultManager] fileExistsAtPath:path isDirectory:pIsDirectory];
 }
 
 - (BOOL)copyItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)pError
 {
+    [self flushPendingWrites];
+    
     return [[NSFileManager defaultManager] copyItemAtPath:sourcePath toPath:destinationPath error:pError];
 }
 
 - (BOOL)moveItemAtPath:(NSString *)sourcePath toPath:(NSString *)destinationPath error:(NSError **)pError
 {
+    [self flushPendingWrites];
+    
     return [[NSFileManager defaultManager] moveItemAtPath:sourcePath toPath:destinationPath error:pError];
 }
 
 - (BOOL)removeItemAtPath:(NSString *)path error:(NSError **)pError;
 {
+    [self flushPendingWrites];
+    
     return [[NSFileManager defaultManager] removeItemAtPath:path error:pError];
 }
 
 @end
+
+#pragma mark -
+#pragma mark HLSStandardFileHandle class implementation
+
+@implementation HLSStandardFileHandle
+
+#pragma mark Object creation and destruction
+
+- (id)initWithPath:(NSString *)path flags:(int)flags error:(NSError **)pError
+{
+    if ((self = [super init])) {
+        m_fileDescriptor = open([path fileSystemRepresentation], flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (m_fileDescriptor < 0) {
+            if (pError) {
+                *pError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            }
+            [self release];
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    [self close];
+    
+    [super dealloc];
+}
+
+#pragma mark HLSFileHandle protocol implementation
+
+- (NSData *)readDataOfLength:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)pError
+{
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    NSUInteger readLength = 0;
+    while (readLength < length) {
+        ssize_t result = pread(m_fileDescriptor, (char *)[data mutableBytes] + readLength, length - readLength, offset + readLength);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            if (pError) {
+                *pError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            }
+            return nil;
+        }
+        // End of file
+        else if (result == 0) {
+            break;
+        }
+        readLength += result;
+    }
+    [data setLength:readLength];
+    return data;
+}
+
+- (BOOL)writeData:(NSData *)data error:(NSError **)pError
+{
+    const char *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger writtenLength = 0;
+    while (writtenLength < length) {
+        ssize_t result = write(m_fileDescriptor, bytes + writtenLength, length - writtenLength);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            if (pError) {
+                *pError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            }
+            return NO;
+        }
+        writtenLength += result;
+    }
+    return YES;
+}
+
+- (unsigned long long)length
+{
+    struct stat fileStat;
+    if (fstat(m_fileDescriptor, &fileStat) != 0) {
+        return 0;
+    }
+    return fileStat.st_size;
+}
+
+- (void)close
+{
+    if (m_fileDescriptor >= 0) {
+        close(m_fileDescriptor);
+        m_fileDescriptor = -1;
+    }
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSMappedData class implementation
+
+@implementation HLSMappedData
+
+#pragma mark Object creation and destruction
+
+- (id)initWithMappedBytes:(void *)bytes length:(NSUInteger)length
+{
+    if ((self = [super init])) {
+        m_bytes = bytes;
+        m_length = length;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self unmap];
+    
+    [super dealloc];
+}
+
+#pragma mark NSData primitive methods
+
+- (const void *)bytes
+{
+    return m_bytes;
+}
+
+- (NSUInteger)length
+{
+    return m_length;
+}
+
+#pragma mark Managing the mapping
+
+- (void)adviseAccessPattern:(HLSFileAccessPattern)accessPattern forRange:(NSRange)range
+{
+    if (! m_bytes) {
+        HLSLoggerWarn(@"The data has been unmapped");
+        return;
+    }
+    
+    if (NSMaxRange(range) > m_length) {
+        HLSLoggerError(@"The range %@ is out of bounds", NSStringFromRange(range));
+        return;
+    }
+    
+    // madvise requires a page-aligned address. The mapping itself is page-aligned
+    NSUInteger pageSize = (NSUInteger)getpagesize();
+    NSUInteger alignedLocation = (range.location / pageSize) * pageSize;
+    adviseAccessPattern((char *)m_bytes + alignedLocation, NSMaxRange(range) - alignedLocation, accessPattern);
+}
+
+- (void)unmap
+{
+    if (! m_bytes) {
+        return;
+    }
+    
+    munmap(m_bytes, m_length);
+    m_bytes = NULL;
+    m_length = 0;
+}
+
+@end
+
+#pragma mark Functions
+
+static void adviseAccessPattern(void *bytes, NSUInteger length, HLSFileAccessPattern accessPattern)
+{
+    int advice = MADV_NORMAL;
+    switch (accessPattern) {
+        case HLSFileAccessPatternSequential: {
+            advice = MADV_SEQUENTIAL;
+            break;
+        }
+            
+        case HLSFileAccessPatternRandom: {
+            advice = MADV_RANDOM;
+            break;
+        }
+            
+        case HLSFileAccessPatternWillNeed: {
+            advice = MADV_WILLNEED;
+            break;
+        }
+            
+        default: {
+            break;
+        }
+    }
+    
+    if (madvise(bytes, length, advice) != 0) {
+        HLSLoggerDebug(@"madvise failed (errno %d)", errno);
+    }
+}
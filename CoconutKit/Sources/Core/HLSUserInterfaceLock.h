@@ -6,14 +6,25 @@
 //  Copyright 2010 Hortis. All rights reserved.
 //
 
+// Forward declarations
+@class HLSUserInterfaceLockToken;
+
 /**
  * Singleton class for preventing / allowing user interface interaction
  *
+ * The lock counter is updated atomically and can therefore be acquired and released from any thread. User interaction
+ * is disabled as soon as the lock is acquired from the main thread (on the next main run loop turn when acquired from
+ * another thread). When the counter gets back to zero, user interaction is only enabled again at the end of the
+ * current main run loop turn. Overlapping lock intervals (e.g. animations ending and starting within the same turn)
+ * therefore yield a single interval during which the UI is locked
+ *
  * Designated initializer: -init
  */
 @interface HLSUserInterfaceLock : NSObject {
 @private
-    NSUInteger m_useCount;
+    int32_t m_useCount;
+    BOOL m_ignoringInteractionEvents;                   // main thread only
+    CFRunLoopObserverRef m_updateObserver;              // main thread only
 }
 
 + (HLSUserInterfaceLock *)sharedUserInterfaceLock;
@@ -25,4 +36,32 @@
 - (void)lock;
 - (void)unlock;
 
+/**
+ * Lock the UI and return a token keeping it locked until it is sent -unlock or deallocated, whichever comes first.
+ * Tokens make it impossible to unlock the UI more often than it was locked
+ */
+- (HLSUserInterfaceLockToken *)lockToken;
+
+@end
+
+/**
+ * A token keeping the UI locked (see -[HLSUserInterfaceLock lockToken])
+ *
+ * Tokens cannot be instantiated directly, obtain them from -[HLSUserInterfaceLock lockToken]
+ */
+@interface HLSUserInterfaceLockToken : NSObject {
+@private
+    int32_t m_locked;
+}
+
+/**
+ * Release the lock held by the token. Calling this method more than once does nothing
+ */
+- (void)unlock;
+
+/**
+ * Return YES iff the token still holds the lock
+ */
+@property (nonatomic, readonly, assign, getter=isLocked) BOOL locked;
+
 @end
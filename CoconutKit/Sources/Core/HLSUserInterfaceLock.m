@@ -8,8 +8,34 @@
 
 #import "HLSUserInterfaceLock.h"
 
+#import <libkern/OSAtomic.h>
 #import "HLSLogger.h"
 
+#pragma mark -
+#pragma mark HLSUserInterfaceLockToken class interface extension
+
+@interface HLSUserInterfaceLockToken ()
+
+- (id)initAndLock;
+
+@end
+
+#pragma mark -
+#pragma mark HLSUserInterfaceLock class implementation
+
+@interface HLSUserInterfaceLock ()
+
+- (void)scheduleUpdate;
+- (void)updateUserInterface;
+
+@end
+
+static void HLSUserInterfaceLockUpdateObserverCallback(CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info)
+{
+    HLSUserInterfaceLock *userInterfaceLock = (HLSUserInterfaceLock *)info;
+    [userInterfaceLock updateUserInterface];
+}
+
 @implementation HLSUserInterfaceLock
 
 #pragma mark Class methods
@@ -17,10 +43,12 @@
 + (HLSUserInterfaceLock *)sharedUserInterfaceLock
 {
     static HLSUserInterfaceLock *s_instance = nil;
+    static dispatch_once_t s_onceToken;
     
-    if (! s_instance) {
+    // Can be accessed from any thread
+    dispatch_once(&s_onceToken, ^{
         s_instance = [[HLSUserInterfaceLock alloc] init];
-    }
+    });
     return s_instance;
 }
 
@@ -38,28 +66,131 @@
 
 - (void)lock
 {    
-    ++m_useCount;
+    int32_t useCount = OSAtomicIncrement32Barrier(&m_useCount);
     HLSLoggerDebug(@"Acquire UI lock");
     
-    if (m_useCount == 1) {
-        [[UIApplication sharedApplication] beginIgnoringInteractionEvents];
+    if (useCount == 1) {
+        // Lock immediately if possible, so that no event is received in the meantime
+        if ([NSThread isMainThread]) {
+            [self updateUserInterface];
+        }
+        else {
+            [self performSelectorOnMainThread:@selector(scheduleUpdate) withObject:nil waitUntilDone:NO];
+        }
     }
 }
 
 - (void)unlock
 {
-    // Check that the UI was locked
-    if (m_useCount == 0) {
-        HLSLoggerDebug(@"The UI was not locked, nothing to unlock");
+    // Check that the UI was locked. The counter must never become negative, even when several threads unlock
+    // at the same time
+    int32_t useCount = 0;
+    do {
+        useCount = m_useCount;
+        if (useCount == 0) {
+            HLSLoggerDebug(@"The UI was not locked, nothing to unlock");
+            return;
+        }
+    } while (! OSAtomicCompareAndSwap32Barrier(useCount, useCount - 1, &m_useCount));
+    HLSLoggerDebug(@"Release UI lock");
+    
+    // Unlocking is deferred to the end of the run loop turn, so that the UI is not unlocked and locked again if the
+    // lock is acquired again in the meantime
+    if (useCount == 1) {
+        if ([NSThread isMainThread]) {
+            [self scheduleUpdate];
+        }
+        else {
+            [self performSelectorOnMainThread:@selector(scheduleUpdate) withObject:nil waitUntilDone:NO];
+        }
+    }
+}
+
+- (HLSUserInterfaceLockToken *)lockToken
+{
+    return [[[HLSUserInterfaceLockToken alloc] initAndLock] autorelease];
+}
+
+#pragma mark Updating user interaction status
+
+- (void)scheduleUpdate
+{
+    if (m_updateObserver) {
         return;
     }
     
-    --m_useCount;
-    HLSLoggerDebug(@"Release UI lock");
+    // The observer is called once when the main run loop is about to sleep, i.e. at the end of the current turn. All
+    // modes are observed so that the UI does not stay locked while events are tracked
+    CFRunLoopObserverContext context = { 0, self, NULL, NULL, NULL };
+    m_updateObserver = CFRunLoopObserverCreate(kCFAllocatorDefault, kCFRunLoopBeforeWaiting, false, 0,
+                                               HLSUserInterfaceLockUpdateObserverCallback, &context);
+    CFRunLoopAddObserver(CFRunLoopGetMain(), m_updateObserver, kCFRunLoopCommonModes);
+}
+
+- (void)updateUserInterface
+{
+    if (m_updateObserver) {
+        CFRunLoopObserverInvalidate(m_updateObserver);
+        CFRelease(m_updateObserver);
+        m_updateObserver = NULL;
+    }
     
-    if (m_useCount == 0) {
+    BOOL locked = (OSAtomicAdd32Barrier(0, &m_useCount) != 0);
+    if (locked == m_ignoringInteractionEvents) {
+        return;
+    }
+    
+    if (locked) {
+        [[UIApplication sharedApplication] beginIgnoringInteractionEvents];
+    }
+    else {
         [[UIApplication sharedApplication] endIgnoringInteractionEvents];
     }
+    m_ignoringInteractionEvents = locked;
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSUserInterfaceLockToken class implementation
+
+@implementation HLSUserInterfaceLockToken
+
+#pragma mark Object creation and destruction
+
+- (id)initAndLock
+{
+    if ((self = [super init])) {
+        [[HLSUserInterfaceLock sharedUserInterfaceLock] lock];
+        m_locked = 1;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self unlock];
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+- (BOOL)isLocked
+{
+    return OSAtomicAdd32Barrier(0, &m_locked) != 0;
+}
+
+#pragma mark Unlocking
+
+- (void)unlock
+{
+    // Tokens might be released from any thread
+    if (! OSAtomicCompareAndSwap32Barrier(1, 0, &m_locked)) {
+        return;
+    }
+    
+    [[HLSUserInterfaceLock sharedUserInterfaceLock] unlock];
 }
 
 @end
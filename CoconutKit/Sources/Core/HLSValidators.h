@@ -15,8 +15,16 @@
 }
 
 /**
- * Validates an e-mail address
+ * Validates an e-mail address. The regular expression used is compiled once, this method can therefore be called
+ * often. It can be called from any thread
  */
 + (BOOL)validateEmailAddress:(NSString *)emailAddress;
 
+/**
+ * Validates the e-mail addresses in an array concurrently, and return the indexes of the invalid ones (objects
+ * which are not strings are invalid). Use this method to validate large numbers of addresses (e.g. when importing
+ * contact lists). It can be called from any thread
+ */
++ (NSIndexSet *)indexesOfInvalidEmailAddresses:(NSArray *)emailAddresses;
+
 @end
@@ -10,18 +10,58 @@
 
 #import "HLSAssert.h"
 
+// Number of addresses validated by each concurrent iteration, so that the dispatch overhead remains negligible
+static const NSUInteger kEmailAddressValidationBatchSize = 256;
+
+// Function declarations
+static NSRegularExpression *emailAddressRegularExpression(void);
+
 @implementation HLSValidators
 
 + (BOOL)validateEmailAddress:(NSString *)emailAddress
 {
-    // For some obscure reason, escaping the % in the directly in the format string (using %%) does not work and crashes at runtime! But creating the
-    // regex outside and inserting it into the control string works. Are control strings in Objective-C really standard? 
-    // The following regex is the one used by Apple, e.g. in iOS mail. Thanks to Cédric Lüthi (0xced) for its extraction
-    // (method -[NSString(NSEmailAddressString) mf_isLegalEmailAddress] in /System/Library/PrivateFrameworks/MIME.framework)
-    NSString *emailRegex = @"^[[:alnum:]!#$%&'*+/=?^_`{|}~-]+((\\.?)[[:alnum:]!#$%&'*+/=?^_`{|}~-]+)*@[[:alnum:]-]+(\\.[[:alnum:]-]+)*(\\.[[:alpha:]]+)+$";
+    if (! [emailAddress isKindOfClass:[NSString class]]) {
+        return NO;
+    }
+    
+    // Same semantics as the MATCHES predicate operator: The whole string must match (with NSRegularExpression, $ also
+    // matches before a trailing line terminator)
+    NSRange range = NSMakeRange(0, [emailAddress length]);
+    NSRange matchRange = [emailAddressRegularExpression() rangeOfFirstMatchInString:emailAddress options:0 range:range];
+    return NSEqualRanges(matchRange, range);
+}
+
++ (NSIndexSet *)indexesOfInvalidEmailAddresses:(NSArray *)emailAddresses
+{
+    NSUInteger count = [emailAddresses count];
+    if (count == 0) {
+        return [NSIndexSet indexSet];
+    }
     
-    NSPredicate *emailPredicate = [NSPredicate predicateWithFormat:@"SELF MATCHES %@", emailRegex]; 
-    return [emailPredicate evaluateWithObject:emailAddress];
+    // Each slot of the result array is written by a single iteration
+    BOOL *validResults = calloc(count, sizeof(BOOL));
+    size_t nbrBatches = (count + kEmailAddressValidationBatchSize - 1) / kEmailAddressValidationBatchSize;
+    dispatch_apply(nbrBatches, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t batch) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        NSUInteger firstIndex = batch * kEmailAddressValidationBatchSize;
+        NSUInteger lastIndex = MIN(firstIndex + kEmailAddressValidationBatchSize, count);
+        for (NSUInteger i = firstIndex; i < lastIndex; ++i) {
+            validResults[i] = [HLSValidators validateEmailAddress:[emailAddresses objectAtIndex:i]];
+        }
+        
+        [pool drain];
+    });
+    
+    NSMutableIndexSet *invalidIndexes = [NSMutableIndexSet indexSet];
+    for (NSUInteger i = 0; i < count; ++i) {
+        if (! validResults[i]) {
+            [invalidIndexes addIndex:i];
+        }
+    }
+    free(validResults);
+    
+    return [[[NSIndexSet alloc] initWithIndexSet:invalidIndexes] autorelease];
 }
 
 #pragma mark Object creation and destruction
@@ -33,3 +73,22 @@
 }
 
 @end
+
+#pragma mark -
+#pragma mark Static functions
+
+/**
+ * NSRegularExpression objects are immutable and thread-safe, the expression can therefore be shared
+ */
+static NSRegularExpression *emailAddressRegularExpression(void)
+{
+    static NSRegularExpression *s_regularExpression = nil;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        // The following regex is the one used by Apple, e.g. in iOS mail. Thanks to Cédric Lüthi (0xced) for its extraction
+        // (method -[NSString(NSEmailAddressString) mf_isLegalEmailAddress] in /System/Library/PrivateFrameworks/MIME.framework)
+        NSString *emailRegex = @"^[[:alnum:]!#$%&'*+/=?^_`{|}~-]+((\\.?)[[:alnum:]!#$%&'*+/=?^_`{|}~-]+)*@[[:alnum:]-]+(\\.[[:alnum:]-]+)*(\\.[[:alpha:]]+)+$";
+        s_regularExpression = [[NSRegularExpression alloc] initWithPattern:emailRegex options:0 error:NULL];
+    });
+    return s_regularExpression;
+}
@@ -32,6 +32,32 @@ HLSVector2 HLSVector2Make(CGFloat v1, CGFloat v2);
 HLSVector3 HLSVector3Make(CGFloat v1, CGFloat v2, CGFloat v3);
 HLSVector4 HLSVector4Make(CGFloat v1, CGFloat v2, CGFloat v3, CGFloat v4);
 
+// Sum of two vectors
+HLSVector3 HLSVector3Add(HLSVector3 vector1, HLSVector3 vector2);
+HLSVector4 HLSVector4Add(HLSVector4 vector1, HLSVector4 vector2);
+
+// Multiplication of a vector by a scalar
+HLSVector3 HLSVector3Scale(HLSVector3 vector, CGFloat factor);
+HLSVector4 HLSVector4Scale(HLSVector4 vector, CGFloat factor);
+
+// Linear interpolation between two vectors (progress = 0 returns vector1, progress = 1 returns vector2)
+HLSVector3 HLSVector3Lerp(HLSVector3 vector1, HLSVector3 vector2, CGFloat progress);
+HLSVector4 HLSVector4Lerp(HLSVector4 vector1, HLSVector4 vector2, CGFloat progress);
+
+// Dot product of two vectors
+CGFloat HLSVector3Dot(HLSVector3 vector1, HLSVector3 vector2);
+CGFloat HLSVector4Dot(HLSVector4 vector1, HLSVector4 vector2);
+
+/**
+ * Return the transform R * S * T, where R is the rotation transform with parameters (angle, x, y, z), S the scale
+ * transform with factors (sx, sy, sz) and T the translation transform with parameters (tx, ty, tz) (same conventions
+ * as CATransform3DMakeRotation, CATransform3DMakeScale and CATransform3DMakeTranslation). The result is the same as
+ * calling CATransform3DConcat twice, but is obtained without any matrix multiplication
+ */
+CATransform3D HLSTransform3DMakeRotationScaleTranslation(HLSVector4 rotationParameters,
+                                                         HLSVector3 scaleParameters,
+                                                         HLSVector3 translationParameters);
+
 // Return a string representation of a vector
 NSString *HLSStringFromVector2(HLSVector2 vector2);
 NSString *HLSStringFromVector3(HLSVector3 vector3);
@@ -38,6 +38,91 @@ HLSVector4 HLSVector4Make(CGFloat v1, CGFloat v2, CGFloat v3, CGFloat v4)
     return vector;
 }
 
+HLSVector3 HLSVector3Add(HLSVector3 vector1, HLSVector3 vector2)
+{
+    return HLSVector3Make(vector1.v1 + vector2.v1,
+                          vector1.v2 + vector2.v2,
+                          vector1.v3 + vector2.v3);
+}
+
+HLSVector4 HLSVector4Add(HLSVector4 vector1, HLSVector4 vector2)
+{
+    return HLSVector4Make(vector1.v1 + vector2.v1,
+                          vector1.v2 + vector2.v2,
+                          vector1.v3 + vector2.v3,
+                          vector1.v4 + vector2.v4);
+}
+
+HLSVector3 HLSVector3Scale(HLSVector3 vector, CGFloat factor)
+{
+    return HLSVector3Make(factor * vector.v1,
+                          factor * vector.v2,
+                          factor * vector.v3);
+}
+
+HLSVector4 HLSVector4Scale(HLSVector4 vector, CGFloat factor)
+{
+    return HLSVector4Make(factor * vector.v1,
+                          factor * vector.v2,
+                          factor * vector.v3,
+                          factor * vector.v4);
+}
+
+HLSVector3 HLSVector3Lerp(HLSVector3 vector1, HLSVector3 vector2, CGFloat progress)
+{
+    return HLSVector3Make(vector1.v1 + progress * (vector2.v1 - vector1.v1),
+                          vector1.v2 + progress * (vector2.v2 - vector1.v2),
+                          vector1.v3 + progress * (vector2.v3 - vector1.v3));
+}
+
+HLSVector4 HLSVector4Lerp(HLSVector4 vector1, HLSVector4 vector2, CGFloat progress)
+{
+    return HLSVector4Make(vector1.v1 + progress * (vector2.v1 - vector1.v1),
+                          vector1.v2 + progress * (vector2.v2 - vector1.v2),
+                          vector1.v3 + progress * (vector2.v3 - vector1.v3),
+                          vector1.v4 + progress * (vector2.v4 - vector1.v4));
+}
+
+CGFloat HLSVector3Dot(HLSVector3 vector1, HLSVector3 vector2)
+{
+    return vector1.v1 * vector2.v1 + vector1.v2 * vector2.v2 + vector1.v3 * vector2.v3;
+}
+
+CGFloat HLSVector4Dot(HLSVector4 vector1, HLSVector4 vector2)
+{
+    return vector1.v1 * vector2.v1 + vector1.v2 * vector2.v2 + vector1.v3 * vector2.v3 + vector1.v4 * vector2.v4;
+}
+
+CATransform3D HLSTransform3DMakeRotationScaleTranslation(HLSVector4 rotationParameters,
+                                                         HLSVector3 scaleParameters,
+                                                         HLSVector3 translationParameters)
+{
+    CATransform3D transform = CATransform3DMakeRotation(rotationParameters.v1,
+                                                        rotationParameters.v2,
+                                                        rotationParameters.v3,
+                                                        rotationParameters.v4);
+    
+    // Multiplying by S on the right scales the columns of R. Since the last column of R * S is (0, 0, 0, 1),
+    // multiplying by T on the right only replaces its last row with the translation
+    transform.m11 *= scaleParameters.v1;
+    transform.m21 *= scaleParameters.v1;
+    transform.m31 *= scaleParameters.v1;
+    
+    transform.m12 *= scaleParameters.v2;
+    transform.m22 *= scaleParameters.v2;
+    transform.m32 *= scaleParameters.v2;
+    
+    transform.m13 *= scaleParameters.v3;
+    transform.m23 *= scaleParameters.v3;
+    transform.m33 *= scaleParameters.v3;
+    
+    transform.m41 = translationParameters.v1;
+    transform.m42 = translationParameters.v2;
+    transform.m43 = translationParameters.v3;
+    
+    return transform;
+}
+
 NSString *HLSStringFromVector2(HLSVector2 vector2)
 {
     return [NSString stringWithFormat:@"[%.2f, %.2f]", vector2.v1, vector2.v2];
@@ -0,0 +1,65 @@
+//
+//  HLSWebViewPool.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * A small pool of web views created in advance, so that the cost of instantiating a UIWebView is not paid when a web
+ * view is needed (e.g. when HLSWebViewController is displayed). The pool is refilled when the main run loop is idle
+ * (one web view per run loop turn, in the default run loop mode only so that scrolling is never interrupted), and
+ * is purged when a memory warning is received. If application preloading is enabled (see HLSApplicationPreloader.h),
+ * the pool is filled right after the application has started.
+ *
+ * Since UIWebView navigation history cannot be cleared, web views which have loaded content are not reused when
+ * returned to the pool, but returning them still triggers a refill. Cookies and caches are shared by all web views
+ * of an application (NSHTTPCookieStorage and NSURLCache), whether they come from the pool or not
+ *
+ * The pool must only be used from the main thread
+ *
+ * Designated initializer: -init (but use the +sharedWebViewPool singleton)
+ */
+@interface HLSWebViewPool : NSObject {
+@private
+    NSMutableArray *m_webViews;
+    NSUInteger m_capacity;
+    BOOL m_fillScheduled;
+}
+
+/**
+ * The pool singleton
+ */
++ (HLSWebViewPool *)sharedWebViewPool;
+
+/**
+ * The number of web views kept ready
+ *
+ * Default value is 1
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ * Return a web view from the pool, or a new one if the pool is empty. The web view has no superview, no delegate,
+ * and its frame has the size of the application frame. A refill of the pool is scheduled
+ */
+- (UIWebView *)dequeueWebView;
+
+/**
+ * Return a web view which is not needed anymore to the pool. The web view stops loading and is removed from its
+ * superview. It is kept for reuse only if it has never loaded any content (and if the pool is not full)
+ */
+- (void)recycleWebView:(UIWebView *)webView;
+
+/**
+ * Schedule the creation of web views until the pool is full
+ */
+- (void)fill;
+
+/**
+ * Release all web views kept by the pool
+ */
+- (void)purge;
+
+@end
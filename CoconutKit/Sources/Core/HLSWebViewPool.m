@@ -0,0 +1,169 @@
+//
+//  HLSWebViewPool.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSWebViewPool.h"
+
+#import "HLSLogger.h"
+
+@interface HLSWebViewPool ()
+
+@property (nonatomic, retain) NSMutableArray *webViews;
+
+- (UIWebView *)newWebView;
+- (void)fillStep;
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification;
+
+@end
+
+@implementation HLSWebViewPool
+
+#pragma mark Class methods
+
++ (HLSWebViewPool *)sharedWebViewPool
+{
+    static HLSWebViewPool *s_instance = nil;
+    
+    if (! s_instance) {
+        s_instance = [[HLSWebViewPool alloc] init];
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.webViews = [NSMutableArray array];
+        self.capacity = 1;
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationDidReceiveMemoryWarning:)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [NSObject cancelPreviousPerformRequestsWithTarget:self];
+    
+    self.webViews = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize webViews = m_webViews;
+
+@synthesize capacity = m_capacity;
+
+- (void)setCapacity:(NSUInteger)capacity
+{
+    m_capacity = capacity;
+    
+    if ([self.webViews count] > capacity) {
+        [self.webViews removeObjectsInRange:NSMakeRange(capacity, [self.webViews count] - capacity)];
+    }
+}
+
+#pragma mark Pool management
+
+- (UIWebView *)dequeueWebView
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    UIWebView *webView = nil;
+    if ([self.webViews count] != 0) {
+        webView = [[[self.webViews lastObject] retain] autorelease];
+        [self.webViews removeLastObject];
+    }
+    else {
+        HLSLoggerDebug(@"The web view pool is empty. A new web view is created");
+        webView = [[self newWebView] autorelease];
+    }
+    
+    [self fill];
+    return webView;
+}
+
+- (void)recycleWebView:(UIWebView *)webView
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (! webView) {
+        return;
+    }
+    
+    [webView stopLoading];
+    webView.delegate = nil;
+    [webView removeFromSuperview];
+    
+    // The history of a web view cannot be cleared. Only keep web views which have never loaded anything
+    if (! webView.request && [self.webViews count] < self.capacity && ! [self.webViews containsObject:webView]) {
+        [self.webViews addObject:webView];
+    }
+    
+    [self fill];
+}
+
+- (void)fill
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (m_fillScheduled || [self.webViews count] >= self.capacity) {
+        return;
+    }
+    
+    // Default mode only, so that web views are not created while the user is scrolling
+    [self performSelector:@selector(fillStep) withObject:nil afterDelay:0. inModes:[NSArray arrayWithObject:NSDefaultRunLoopMode]];
+    m_fillScheduled = YES;
+}
+
+- (void)purge
+{
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(fillStep) object:nil];
+    m_fillScheduled = NO;
+    
+    [self.webViews removeAllObjects];
+}
+
+- (UIWebView *)newWebView
+{
+    CGRect applicationFrame = [UIScreen mainScreen].applicationFrame;
+    return [[UIWebView alloc] initWithFrame:CGRectMake(0.f, 0.f, CGRectGetWidth(applicationFrame), CGRectGetHeight(applicationFrame))];
+}
+
+- (void)fillStep
+{
+    m_fillScheduled = NO;
+    
+    if ([self.webViews count] >= self.capacity) {
+        return;
+    }
+    
+    // One web view per run loop turn, so that events are processed in between
+    UIWebView *webView = [[self newWebView] autorelease];
+    [self.webViews addObject:webView];
+    
+    [self fill];
+}
+
+#pragma mark Notification callbacks
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification
+{
+    HLSLoggerInfo(@"Memory warning received. The web view pool is purged");
+    [self purge];
+}
+
+@end
@@ -6,6 +6,11 @@
 //  Copyright (c) 2012 Hortis. All rights reserved.
 //
 
+// Number of cleanup blocks which can be stored without any additional allocation
+#define HLS_ZEROING_WEAK_REF_INLINE_CLEANUP_BLOCKS      2
+
+typedef void (^HLSZeroingWeakRefCleanupBlock)(void);
+
 /**
  * A weak reference to an object, which gets automatically set to nil when the object it refers to is
  * deallocated. This is a convenient way to eliminate the crashes usually associated with dangling 
@@ -15,6 +20,11 @@
  *
  * HLSZeroingWeakRef instances must be retained by the objects which store them.
  *
+ * When running on iOS 5 and above, the runtime zeroing weak references (the ones used by ARC) are used, except
+ * for references which have been assigned cleanup blocks, actions or invocations. Those are implemented by dynamically
+ * subclassing the class of the object they point at (once per class), so that they can be notified when the object
+ * is deallocated.
+ *
  * The current implementation of HLSZeroingWeakRef is fairly basic:
  *   - zeroing weak references to toll-free bridged objects (NSString, NSURL, NSNumber, etc.) are not 
  *     supported. Attempting to initialize a zeroing weak with a toll-free bridged object results in 
@@ -28,7 +38,12 @@
 @interface HLSZeroingWeakRef : NSObject {
 @private
     id m_object;
-    NSMutableArray *m_invocations;
+    HLSZeroingWeakRefCleanupBlock m_inlineCleanupBlocks[HLS_ZEROING_WEAK_REF_INLINE_CLEANUP_BLOCKS];
+    HLSZeroingWeakRefCleanupBlock *m_cleanupBlocks;
+    NSUInteger m_nbrCleanupBlocks;
+    NSUInteger m_cleanupBlocksCapacity;
+    BOOL m_usingNativeWeakReference;
+    BOOL m_observingObjectDeallocation;
 }
 
 /**
@@ -43,15 +58,23 @@
 @property (nonatomic, readonly, assign) id object;
 
 /**
- * Optional invocations to be performed just before the weak reference is zeroed. The actions / invocations 
+ * Optional blocks to be executed just before the weak reference is zeroed. The blocks are copied, and blocks,
+ * actions and invocations are called in the order in which they have been added. Blocks are the cheapest way
+ * to perform cleanup, and should be preferred when many references to the same object exist. Objects captured
+ * by a block are retained by it, use __block variables to avoid retain cycles
+ */
+- (void)addCleanupBlock:(void (^)(void))cleanupBlock;
+
+/**
+ * Optional invocations to be performed just before the weak reference is zeroed. The blocks / actions / invocations 
  * are called in the order in which they have been added
  */
 - (void)addInvocation:(NSInvocation *)invocation;
 
 /**
  * Optional cleanup actions (with signature - (void)methodName) to be invoked on some target just before
- * the weak reference is zeroed. The target is not retained, and the actions / invocations are called in the
- * order in which they have been added
+ * the weak reference is zeroed. The target is not retained, and the blocks / actions / invocations are called in
+ * the order in which they have been added. No NSInvocation is created
  */
 - (void)addCleanupAction:(SEL)action onTarget:(id)target;
 
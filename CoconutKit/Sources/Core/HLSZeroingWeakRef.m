@@ -8,81 +8,147 @@
 
 #import "HLSZeroingWeakRef.h"
 
+#import <libkern/OSAtomic.h>
+#import <objc/message.h>
 #import <objc/runtime.h>
+#import "HLSMemoryAccountant.h"
 #import "NSObject+HLSExtensions.h"
 
+// Native zeroing weak reference support (runtime shipped with iOS 5 and above). Weakly linked so that the library
+// still runs on iOS 4
+OBJC_EXPORT id objc_storeWeak(id *location, id obj) __attribute__((weak_import));
+OBJC_EXPORT id objc_loadWeakRetained(id *location) __attribute__((weak_import));
+
+// Number of references to an object which can be stored without any additional allocation
+#define ZEROING_WEAK_REF_LIST_INLINE_CAPACITY           4
+
+// Initial capacity of the cleanup block storage when it outgrows the inline array
+#define CLEANUP_BLOCKS_INITIAL_CAPACITY                 8
+
 // Associated object keys
 static void *s_zeroingWeakRefListKey = &s_zeroingWeakRefListKey;
 
-// Static methods
+// Lookup table of the dynamic subclasses created so far. Each subclass is stored for its superclass as well as for
+// itself, so that objects which have already been subclassed can be identified
+static CFMutableDictionaryRef s_classToSubclassMap = NULL;
+static OSSpinLock s_classToSubclassMapLock = OS_SPINLOCK_INIT;
+
+// Memory accounting: live references and lists, and the number of list slots allocated outside of the lists
+static volatile int32_t s_zeroingWeakRefCount = 0;
+static volatile int32_t s_zeroingWeakRefListCount = 0;
+static volatile int32_t s_zeroingWeakRefListExternalSlotCount = 0;
+
+// Function declarations
+static BOOL isTollFreeBridgedClass(Class class);
+static BOOL supportsNativeWeakReferences(id object);
+static Class zeroingWeakRefSubclassForClass(Class class);
+static BOOL isZeroingWeakRefSubclass(Class class);
 static void subclass_dealloc(id object, SEL _cmd);
 static Class subclass_class(id object, SEL _cmd);
 
+#pragma mark -
+#pragma mark HLSZeroingWeakRefList class interface
+
+/**
+ * Unordered list of the zeroing weak references pointing at an object, which are not retained. The first
+ * references are stored inline
+ */
+@interface HLSZeroingWeakRefList : NSObject {
+@private
+    HLSZeroingWeakRef *m_inlineZeroingWeakRefs[ZEROING_WEAK_REF_LIST_INLINE_CAPACITY];
+    HLSZeroingWeakRef **m_zeroingWeakRefs;
+    NSUInteger m_count;
+    NSUInteger m_capacity;
+}
+
+@property (nonatomic, readonly, assign) NSUInteger count;
+
+- (void)addZeroingWeakRef:(HLSZeroingWeakRef *)zeroingWeakRef;
+- (void)removeZeroingWeakRef:(HLSZeroingWeakRef *)zeroingWeakRef;
+
+/**
+ * Remove and return any reference from the list, nil if empty
+ */
+- (HLSZeroingWeakRef *)popZeroingWeakRef;
+
+@end
+
+#pragma mark -
+#pragma mark HLSZeroingWeakRefMemoryAccounting class interface
+
+/**
+ * Reports the memory used by zeroing weak references (excluding their cleanup blocks) to the memory accountant
+ */
+@interface HLSZeroingWeakRefMemoryAccounting : NSObject <HLSMemoryAccounting>
+
+@end
+
+#pragma mark -
+#pragma mark HLSZeroingWeakRef class interface extension
+
 @interface HLSZeroingWeakRef ()
 
 @property (nonatomic, assign) id object;
-@property (nonatomic, retain) NSMutableArray *invocations;
+
+- (void)observeObjectDeallocation;
+- (void)executeCleanupBlocks;
 
 @end
 
+#pragma mark -
+#pragma mark HLSZeroingWeakRef class implementation
+
 @implementation HLSZeroingWeakRef
 
+#pragma mark Class methods
+
++ (void)initialize
+{
+    if (self != [HLSZeroingWeakRef class]) {
+        return;
+    }
+    
+    // Never deallocated
+    HLSZeroingWeakRefMemoryAccounting *memoryAccounting = [[HLSZeroingWeakRefMemoryAccounting alloc] init];
+    [[HLSMemoryAccountant sharedMemoryAccountant] registerSubsystem:memoryAccounting
+                                                           withName:@"Zeroing weak references"
+                                                      purgePriority:HLSMemoryPurgePriorityZeroingWeakRefs];
+}
+
 #pragma mark Object creation and destruction
 
 - (id)initWithObject:(id)object
 {
     if ((self = [super init])) {
-        self.invocations = [NSMutableArray array];
-        self.object = object;
+        OSAtomicIncrement32(&s_zeroingWeakRefCount);
+        
+        m_cleanupBlocks = m_inlineCleanupBlocks;
+        m_cleanupBlocksCapacity = HLS_ZEROING_WEAK_REF_INLINE_CLEANUP_BLOCKS;
         
         if (object) {
-            static NSString * const kSubclassPrefix = @"HLSZeroingWeakRef_";
-            
             // Access the real class, do not use [self class] here since can be faked
             Class class = object_getClass(object);
             
             // No support for Core Foundation objects (lead to infinite recursion)
             // For more information, see
             //   http://www.mikeash.com/pyblog/friday-qa-2010-01-22-toll-free-bridging-internals.html
-            if ([NSStringFromClass(class) hasPrefix:@"NSCF"] || [NSStringFromClass(class) hasPrefix: @"__NSCF"]) {
+            if (isTollFreeBridgedClass(class)) {
+                [self release];
                 @throw [NSException exceptionWithName:NSInvalidArgumentException 
                                                reason:@"Cannot create zeroing weak references to toll-free bridged objects"
                                              userInfo:nil];
             }
             
-            // Dynamically subclass the object class to override -dealloc selectively, and use this class instead.
-            // Another approach would involve swizzling -dealloc at the NSObject level, but this solution would 
-            // incur an unacceptable overhead on all NSObjects
-            NSString *className = [NSString stringWithUTF8String:class_getName(class)];
-            if (! [className hasPrefix:kSubclassPrefix]) {
-                NSString *subclassName = [kSubclassPrefix stringByAppendingString:className];
-                Class subclass = NSClassFromString(subclassName);
-                if (! subclass) {
-                    subclass = objc_allocateClassPair(class, [subclassName UTF8String], 0);
-                    NSAssert(subclass != Nil, @"Could not register subclass");
-                    class_addMethod(subclass, 
-                                    @selector(dealloc), 
-                                    (IMP)subclass_dealloc, 
-                                    method_getTypeEncoding(class_getInstanceMethod(class, @selector(dealloc))));
-                    class_addMethod(subclass, 
-                                    @selector(class), 
-                                    (IMP)subclass_class, 
-                                    method_getTypeEncoding(class_getClassMethod(class, @selector(class))));
-                    objc_registerClassPair(subclass);
-                }
-                
-                // Changes the object class
-                object_setClass(object, subclass);    
+            // Use the runtime zeroing weak references when available. Dynamic subclassing is only needed when
+            // code must be executed before the reference is zeroed, i.e. when the first cleanup block is added
+            if (supportsNativeWeakReferences(object)) {
+                m_usingNativeWeakReference = YES;
+                self.object = object;
             }
-            
-            // Attach to object a list storing all zeroing weak references pointing at it
-            NSMutableSet *zeroingWeakRefValues = objc_getAssociatedObject(object, s_zeroingWeakRefListKey);
-            if (! zeroingWeakRefValues) {
-                zeroingWeakRefValues = [NSMutableSet set];
-                objc_setAssociatedObject(object, s_zeroingWeakRefListKey, zeroingWeakRefValues, OBJC_ASSOCIATION_RETAIN);
+            else {
+                self.object = object;
+                [self observeObjectDeallocation];
             }
-            NSValue *selfValue = [NSValue valueWithPointer:self];
-            [zeroingWeakRefValues addObject:selfValue];
         }        
     }
     return self;
@@ -90,66 +156,337 @@ static Class subclass_class(id object, SEL _cmd);
 
 - (void)dealloc
 {
-    NSMutableSet *zeroingWeakRefValues = objc_getAssociatedObject(self.object, s_zeroingWeakRefListKey);
-    NSValue *selfValue = [NSValue valueWithPointer:self];
-    [zeroingWeakRefValues removeObject:selfValue];
-    
-    // No weak ref anymore. Can remove the dynamic subclass
-    if ([zeroingWeakRefValues count] == 0) {
-        Class superclass = class_getSuperclass(object_getClass(self.object));
-        object_setClass(self.object, superclass);
+    if (m_observingObjectDeallocation && m_object) {
+        HLSZeroingWeakRefList *zeroingWeakRefList = objc_getAssociatedObject(m_object, s_zeroingWeakRefListKey);
+        [zeroingWeakRefList removeZeroingWeakRef:self];
+        
+        // No weak ref anymore. Can remove the dynamic subclass (if it has not been subclassed further, e.g. by KVO)
+        if (zeroingWeakRefList.count == 0) {
+            Class class = object_getClass(m_object);
+            if (isZeroingWeakRefSubclass(class)) {
+                object_setClass(m_object, class_getSuperclass(class));
+            }
+        }
     }
     
     self.object = nil;
-    self.invocations = nil;
+    
+    for (NSUInteger i = 0; i < m_nbrCleanupBlocks; ++i) {
+        [m_cleanupBlocks[i] release];
+    }
+    if (m_cleanupBlocks != m_inlineCleanupBlocks) {
+        free(m_cleanupBlocks);
+    }
+    
+    OSAtomicDecrement32(&s_zeroingWeakRefCount);
     
     [super dealloc];
 }
 
 #pragma mark Accessors and mutators
 
-@synthesize object = m_object;
+- (id)object
+{
+    if (m_usingNativeWeakReference) {
+        // Return the object without extending its lifetime, as for the plain pointer
+        id object = objc_loadWeakRetained(&m_object);
+        [object release];
+        return object;
+    }
+    else {
+        return m_object;
+    }
+}
 
-@synthesize invocations = m_invocations;
+- (void)setObject:(id)object
+{
+    if (m_usingNativeWeakReference) {
+        objc_storeWeak(&m_object, object);
+    }
+    else {
+        m_object = object;
+    }
+}
 
 #pragma mark Optional cleanup
 
+- (void)addCleanupBlock:(void (^)(void))cleanupBlock
+{
+    if (! cleanupBlock) {
+        return;
+    }
+    
+    if (m_nbrCleanupBlocks == m_cleanupBlocksCapacity) {
+        NSUInteger capacity = MAX(2 * m_cleanupBlocksCapacity, CLEANUP_BLOCKS_INITIAL_CAPACITY);
+        HLSZeroingWeakRefCleanupBlock *cleanupBlocks = malloc(capacity * sizeof(HLSZeroingWeakRefCleanupBlock));
+        memcpy(cleanupBlocks, m_cleanupBlocks, m_nbrCleanupBlocks * sizeof(HLSZeroingWeakRefCleanupBlock));
+        if (m_cleanupBlocks != m_inlineCleanupBlocks) {
+            free(m_cleanupBlocks);
+        }
+        m_cleanupBlocks = cleanupBlocks;
+        m_cleanupBlocksCapacity = capacity;
+    }
+    m_cleanupBlocks[m_nbrCleanupBlocks] = [cleanupBlock copy];
+    ++m_nbrCleanupBlocks;
+    
+    if (! m_observingObjectDeallocation) {
+        [self observeObjectDeallocation];
+    }
+}
+
 - (void)addInvocation:(NSInvocation *)invocation
 {
-    [self.invocations addObject:invocation];
+    [self addCleanupBlock:^{
+        [invocation invoke];
+    }];
 }
 
 - (void)addCleanupAction:(SEL)action onTarget:(id)target
 {
-    NSMethodSignature *methodSignature = [[target class] instanceMethodSignatureForSelector:action];
-    NSInvocation *invocation = [NSInvocation invocationWithMethodSignature:methodSignature];
-    invocation.target = target;             // NSInvocation not set to retain its arguments here
-    invocation.selector = action;
-    [self addInvocation:invocation];
+    // __block variables are not retained by the block
+    __block id blockTarget = target;
+    [self addCleanupBlock:^{
+        ((void (*)(id, SEL))objc_msgSend)(blockTarget, action);
+    }];
+}
+
+- (void)executeCleanupBlocks
+{
+    for (NSUInteger i = 0; i < m_nbrCleanupBlocks; ++i) {
+        m_cleanupBlocks[i]();
+    }
+}
+
+#pragma mark Deallocation observation
+
+- (void)observeObjectDeallocation
+{
+    id object = self.object;
+    if (! object) {
+        return;
+    }
+    
+    // From now on, the reference is zeroed by the dynamic subclass, after the cleanup blocks have been executed. A
+    // native weak reference would already read nil at that time
+    if (m_usingNativeWeakReference) {
+        objc_storeWeak(&m_object, nil);
+        m_usingNativeWeakReference = NO;
+        m_object = object;
+    }
+    
+    // Dynamically subclass the object class to override -dealloc selectively, and use this class instead.
+    // Another approach would involve swizzling -dealloc at the NSObject level, but this solution would 
+    // incur an unacceptable overhead on all NSObjects
+    Class class = object_getClass(object);
+    if (! isZeroingWeakRefSubclass(class)) {
+        object_setClass(object, zeroingWeakRefSubclassForClass(class));
+    }
+    
+    // Attach to object a list storing all zeroing weak references pointing at it
+    HLSZeroingWeakRefList *zeroingWeakRefList = objc_getAssociatedObject(object, s_zeroingWeakRefListKey);
+    if (! zeroingWeakRefList) {
+        zeroingWeakRefList = [[[HLSZeroingWeakRefList alloc] init] autorelease];
+        objc_setAssociatedObject(object, s_zeroingWeakRefListKey, zeroingWeakRefList, OBJC_ASSOCIATION_RETAIN);
+    }
+    [zeroingWeakRefList addZeroingWeakRef:self];
+    
+    m_observingObjectDeallocation = YES;
 }
 
 @end
 
-static void subclass_dealloc(id object, SEL _cmd)
+#pragma mark -
+#pragma mark HLSZeroingWeakRefList class implementation
+
+@implementation HLSZeroingWeakRefList
+
+#pragma mark Object creation and destruction
+
+- (id)init
 {
-    // Set all weak references bound to object to nil
-    NSMutableSet *zeroingWeakRefValues = objc_getAssociatedObject(object, s_zeroingWeakRefListKey);
-    for (NSValue *zeroingWeakRefValue in zeroingWeakRefValues) {
-        HLSZeroingWeakRef *zeroingWeakRef = [zeroingWeakRefValue pointerValue];
+    if ((self = [super init])) {
+        m_zeroingWeakRefs = m_inlineZeroingWeakRefs;
+        m_capacity = ZEROING_WEAK_REF_LIST_INLINE_CAPACITY;
         
-        // Execute optional invocations
-        for (NSInvocation *invocation in zeroingWeakRef.invocations) {
-            [invocation invoke];
+        OSAtomicIncrement32(&s_zeroingWeakRefListCount);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (m_zeroingWeakRefs != m_inlineZeroingWeakRefs) {
+        free(m_zeroingWeakRefs);
+        OSAtomicAdd32(-(int32_t)m_capacity, &s_zeroingWeakRefListExternalSlotCount);
+    }
+    
+    OSAtomicDecrement32(&s_zeroingWeakRefListCount);
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize count = m_count;
+
+#pragma mark List management
+
+- (void)addZeroingWeakRef:(HLSZeroingWeakRef *)zeroingWeakRef
+{
+    if (m_count == m_capacity) {
+        NSUInteger capacity = 2 * m_capacity;
+        HLSZeroingWeakRef **zeroingWeakRefs = malloc(capacity * sizeof(HLSZeroingWeakRef *));
+        memcpy(zeroingWeakRefs, m_zeroingWeakRefs, m_count * sizeof(HLSZeroingWeakRef *));
+        if (m_zeroingWeakRefs != m_inlineZeroingWeakRefs) {
+            free(m_zeroingWeakRefs);
+            OSAtomicAdd32(-(int32_t)m_capacity, &s_zeroingWeakRefListExternalSlotCount);
+        }
+        OSAtomicAdd32((int32_t)capacity, &s_zeroingWeakRefListExternalSlotCount);
+        m_zeroingWeakRefs = zeroingWeakRefs;
+        m_capacity = capacity;
+    }
+    m_zeroingWeakRefs[m_count] = zeroingWeakRef;
+    ++m_count;
+}
+
+- (void)removeZeroingWeakRef:(HLSZeroingWeakRef *)zeroingWeakRef
+{
+    // Order does not matter: Replace with the last reference
+    for (NSUInteger i = 0; i < m_count; ++i) {
+        if (m_zeroingWeakRefs[i] == zeroingWeakRef) {
+            --m_count;
+            m_zeroingWeakRefs[i] = m_zeroingWeakRefs[m_count];
+            return;
         }
+    }
+}
+
+- (HLSZeroingWeakRef *)popZeroingWeakRef
+{
+    if (m_count == 0) {
+        return nil;
+    }
+    
+    --m_count;
+    return m_zeroingWeakRefs[m_count];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSZeroingWeakRefMemoryAccounting class implementation
+
+@implementation HLSZeroingWeakRefMemoryAccounting
+
+#pragma mark HLSMemoryAccounting protocol implementation
+
+- (NSUInteger)memoryFootprint
+{
+    return s_zeroingWeakRefCount * class_getInstanceSize([HLSZeroingWeakRef class])
+        + s_zeroingWeakRefListCount * class_getInstanceSize([HLSZeroingWeakRefList class])
+        + s_zeroingWeakRefListExternalSlotCount * sizeof(HLSZeroingWeakRef *);
+}
+
+@end
+
+#pragma mark -
+#pragma mark Static functions
+
+static BOOL isTollFreeBridgedClass(Class class)
+{
+    const char *className = class_getName(class);
+    return strncmp(className, "NSCF", 4) == 0 || strncmp(className, "__NSCF", 6) == 0;
+}
+
+static BOOL supportsNativeWeakReferences(id object)
+{
+    if (! objc_storeWeak || ! objc_loadWeakRetained) {
+        return NO;
+    }
+    
+    // Some classes forbid weak references (the runtime aborts if one is formed nonetheless)
+    static SEL s_allowsWeakReferenceSelector = NULL;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        s_allowsWeakReferenceSelector = sel_registerName("allowsWeakReference");
+    });
+    if (! [object respondsToSelector:s_allowsWeakReferenceSelector]) {
+        return NO;
+    }
+    
+    BOOL (*allowsWeakReferenceImp)(id, SEL) = (BOOL (*)(id, SEL))[object methodForSelector:s_allowsWeakReferenceSelector];
+    return (*allowsWeakReferenceImp)(object, s_allowsWeakReferenceSelector);
+}
+
+static Class zeroingWeakRefSubclassForClass(Class class)
+{
+    static NSString * const kSubclassPrefix = @"HLSZeroingWeakRef_";
+    
+    OSSpinLockLock(&s_classToSubclassMapLock);
+    
+    if (! s_classToSubclassMap) {
+        s_classToSubclassMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    }
+    
+    // The subclass name is only built when the subclass is created
+    Class subclass = (Class)CFDictionaryGetValue(s_classToSubclassMap, class);
+    if (! subclass) {
+        NSString *subclassName = [kSubclassPrefix stringByAppendingString:[NSString stringWithUTF8String:class_getName(class)]];
+        subclass = objc_allocateClassPair(class, [subclassName UTF8String], 0);
+        NSCAssert(subclass != Nil, @"Could not register subclass");
+        class_addMethod(subclass, 
+                        @selector(dealloc), 
+                        (IMP)subclass_dealloc, 
+                        method_getTypeEncoding(class_getInstanceMethod(class, @selector(dealloc))));
+        class_addMethod(subclass, 
+                        @selector(class), 
+                        (IMP)subclass_class, 
+                        method_getTypeEncoding(class_getClassMethod(class, @selector(class))));
+        objc_registerClassPair(subclass);
         
-        // Zeroing
-        zeroingWeakRef.object = nil;
+        CFDictionarySetValue(s_classToSubclassMap, class, subclass);
+        CFDictionarySetValue(s_classToSubclassMap, subclass, subclass);
     }
     
-    // Call parent implementation
+    OSSpinLockUnlock(&s_classToSubclassMapLock);
+    
+    return subclass;
+}
+
+static BOOL isZeroingWeakRefSubclass(Class class)
+{
+    OSSpinLockLock(&s_classToSubclassMapLock);
+    BOOL isSubclass = s_classToSubclassMap && CFDictionaryGetValue(s_classToSubclassMap, class) == class;
+    OSSpinLockUnlock(&s_classToSubclassMapLock);
+    return isSubclass;
+}
+
+static void subclass_dealloc(id object, SEL _cmd)
+{
+    // Locate the parent implementation first. The dynamic subclass might be removed while the cleanup blocks are
+    // executed, if they release the remaining weak references
     Class superclass = class_getSuperclass(object_getClass(object));
     void (*parent_dealloc_Imp)(id, SEL) = (void (*)(id, SEL))class_getMethodImplementation(superclass, @selector(dealloc));
     NSCAssert(parent_dealloc_Imp != NULL, @"Could not locate parent dealloc implementation");
+    
+    // Set all weak references bound to object to nil. References are removed from the list one by one since
+    // cleanup blocks might release other references
+    HLSZeroingWeakRefList *zeroingWeakRefList = objc_getAssociatedObject(object, s_zeroingWeakRefListKey);
+    HLSZeroingWeakRef *zeroingWeakRef = nil;
+    while ((zeroingWeakRef = [zeroingWeakRefList popZeroingWeakRef])) {
+        // Keep the reference alive while its cleanup blocks are executed
+        [zeroingWeakRef retain];
+        
+        // Execute optional cleanup blocks
+        [zeroingWeakRef executeCleanupBlocks];
+        
+        // Zeroing
+        zeroingWeakRef.object = nil;
+        
+        [zeroingWeakRef release];
+    }
+    
+    // Call parent implementation
     (*parent_dealloc_Imp)(object, _cmd);
 }
 
@@ -21,6 +21,12 @@
 - (NSArray *)arrayByLeftRotatingNumberOfObjects:(NSUInteger)numberOfElements;
 - (NSArray *)arrayByRightRotatingNumberOfObjects:(NSUInteger)numberOfElements;
 
+/**
+ * Return the receiver, in which the object at index has been replaced with another one (see HLSPersistentArray for
+ * arrays which can be updated efficiently this way)
+ */
+- (NSArray *)arrayByReplacingObjectAtIndex:(NSUInteger)index withObject:(id)object;
+
 /**
  * Sort an array using a single descriptor
  */
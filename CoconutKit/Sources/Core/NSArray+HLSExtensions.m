@@ -27,7 +27,7 @@
 
 - (NSArray *)arrayByLeftRotatingNumberOfObjects:(NSUInteger)numberOfObjects
 {
-    if (numberOfObjects == 0) {
+    if (numberOfObjects == 0 || [self count] == 0) {
         return self;
     }
     
@@ -37,18 +37,35 @@
 
 - (NSArray *)arrayByRightRotatingNumberOfObjects:(NSUInteger)numberOfObjects
 {
-    if (numberOfObjects == 0) {
+    if (numberOfObjects == 0 || [self count] == 0) {
         return self;
     }
     
     NSUInteger shift = numberOfObjects % [self count];
-    return [self arrayByShiftingNumberOfObjects:[self count] - shift];
+    return [self arrayByShiftingNumberOfObjects:([self count] - shift) % [self count]];
 }
 
 - (NSArray *)arrayByShiftingNumberOfObjects:(NSUInteger)numberOfObjects
 {
-    return [[self subarrayWithRange:NSMakeRange(numberOfObjects, [self count] -  numberOfObjects)] 
-            arrayByAddingObjectsFromArray:[self subarrayWithRange:NSMakeRange(0, numberOfObjects)]];
+    if (numberOfObjects == 0) {
+        return self;
+    }
+    
+    // Copy both parts directly at their final location, so that a single array is created
+    NSUInteger count = [self count];
+    id *objects = malloc(count * sizeof(id));
+    [self getObjects:objects range:NSMakeRange(numberOfObjects, count - numberOfObjects)];
+    [self getObjects:objects + count - numberOfObjects range:NSMakeRange(0, numberOfObjects)];
+    NSArray *array = [NSArray arrayWithObjects:objects count:count];
+    free(objects);
+    return array;
+}
+
+- (NSArray *)arrayByReplacingObjectAtIndex:(NSUInteger)index withObject:(id)object
+{
+    NSMutableArray *array = [NSMutableArray arrayWithArray:self];
+    [array replaceObjectAtIndex:index withObject:object];
+    return [NSArray arrayWithArray:array];
 }
 
 - (NSArray *)sortedArrayUsingDescriptor:(NSSortDescriptor *)sortDescriptor
@@ -49,6 +49,15 @@ NSString *HLSLocalizedStringFromUIKit(NSString *key);
  * (there is no public API to flush it). Instead, find the path of your image using one of the above URL... or
  * path... methods, and call -[UIImage imageWithContentsOfFile:]. You of course lose the benefits of the cache,
  * but you can still implement a basic cache mechanism yourself if you want
+ *
+ * Strings tables are parsed once per bundle, table and localization, and kept in memory until the localization
+ * changes or a memory warning is received. Localized strings can be safely retrieved from any thread. The same holds
+ * for the locations of resources returned by the URL... and path... methods above (including missing resources)
+ *
+ * To save the time and memory needed to parse large strings tables, you can compile them into a binary format using
+ * the Tools/Localization/compile_strings_tables.sh script (e.g. from a Run Script build phase added after the Copy
+ * Bundle Resources phase). Compiled tables (with .hlsstrings extension) are then memory-mapped and strings looked up
+ * directly in them, without creating any dictionary. The .strings files are still used if no compiled table is found
  */
 @interface NSBundle (HLSDynamicLocalization)
 
@@ -67,4 +76,27 @@ NSString *HLSLocalizedStringFromUIKit(NSString *key);
  */
 + (void)setLocalization:(NSString *)localization;
 
+/**
+ * Same as +setLocalization:, but the strings tables of the main bundle for the new localization are first loaded on
+ * a background queue, so that labels can be updated without loading tables on the main thread. Localized images
+ * (PNG and JPEG files) of the main bundle are decoded as well and stored in the shared HLSImageCache, with their
+ * path as key (the path returned by one of the path... methods listed above).
+ *
+ * The localization is changed on the main thread once everything has been loaded, and the completion block (which
+ * can be nil) is then called.
+ */
++ (void)setLocalization:(NSString *)localization completionBlock:(void (^)(void))completionBlock;
+
+/**
+ * When the NSShowNonLocalizedStrings default is set, a missing localized string is logged the first time it is looked
+ * up, further lookups are only counted. Return a report listing all missing localized strings looked up since the
+ * application was launched (or since the last reset), most frequently looked up first.
+ */
++ (NSString *)missingLocalizedStringsReport;
+
+/**
+ * Reset the missing localized string counters.
+ */
++ (void)resetMissingLocalizedStrings;
+
 @end
@@ -9,7 +9,12 @@
 #import "NSBundle+HLSDynamicLocalization.h"
 
 #import <objc/runtime.h>
+#import "HLSImageCache.h"
 #import "HLSLogger.h"
+#import "HLSMemoryAccountant.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryLocalization
 
 NSString * const HLSPreferredLocalizationDefaultsKey = @"HLSPreferredLocalization";
 NSString * const HLSCurrentLocalizationDidChangeNotification = @"HLSCurrentLocalizationDidChangeNotification";
@@ -44,11 +49,47 @@ NSString *HLSLocalizedStringFromUIKit(NSString *key)
     return localizedString;
 }
 
+#pragma mark -
+#pragma mark HLSLocalizationCacheMemoryAccounting class interface
+
+/**
+ * Reports the memory used by the localization cache to the memory accountant, and flushes it when memory is purged
+ */
+@interface HLSLocalizationCacheMemoryAccounting : NSObject <HLSMemoryAccounting>
+
+@end
+
+#pragma mark -
+#pragma mark NSBundle (HLSDynamicLocalization) implementation
+
 @implementation NSBundle (HLSDynamicLocalization)
 
 static NSString *currentLocalization = nil;
 
+// Parsed strings tables (or NSNull if missing), resolved .lproj names and resource locations (or NSNull if not found),
+// keyed by bundle path, localization and table or resource. Accessed from any thread, must be locked
+static NSMutableDictionary *localizationCache = nil;
+
+// Missing localized strings looked up (when NSShowNonLocalizedStrings is set), with the number of lookups. Must be locked
+static NSCountedSet *missingLocalizedStrings = nil;
+
+// Registered with the memory accountant
+static HLSLocalizationCacheMemoryAccounting *localizationCacheMemoryAccounting = nil;
+
+// Compiled strings tables (see compile_strings_tables.sh for a description of the format)
+static const uint32_t kCompiledStringsTableMagic = 0x53534C48;         // 'HLSS' read as a little-endian integer
+static const uint32_t kCompiledStringsTableVersion = 1;
+static const NSUInteger kCompiledStringsTableHeaderLength = 3 * sizeof(uint32_t);
+static const NSUInteger kCompiledStringsTableEntryLength = 4 * sizeof(uint32_t);
+
 static void setDefaultLocalization(void);
+static void applyLocalization(NSString *localization, NSDictionary *preloadedLocalizationCacheEntries);
+static void flushLocalizationCache(void);
+static NSUInteger localizationCacheMemoryFootprint(void);
+static NSUInteger estimatedMemoryFootprintOfObject(id object);
+static NSDictionary *preloadedLocalizationCacheEntriesForBundle(NSBundle *bundle, NSString *localization);
+static NSDictionary *preloadedLocalizedImagesForBundle(NSBundle *bundle, NSString *localization);
+static void recordMissingLocalizedString(NSBundle *bundle, NSString *key, NSString *tableName, NSString *localizationName);
 static void exchangeNSBundleInstanceMethod(SEL originalSelector);
 static void initialize(void);
 
@@ -87,6 +128,45 @@ static void setDefaultLocalization(void)
 }
 
 + (void)setLocalization:(NSString *)localization
+{
+    applyLocalization(localization, nil);
+}
+
++ (void)setLocalization:(NSString *)localization completionBlock:(void (^)(void))completionBlock
+{
+    initialize();
+    
+    // Nothing to preload if the default localization will be restored
+    NSString *preloadedLocalization = [[[NSBundle mainBundle] localizations] containsObject:localization] ? [[localization copy] autorelease] : nil;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        NSDictionary *localizationCacheEntries = nil;
+        NSDictionary *pathToImageMap = nil;
+        if (preloadedLocalization) {
+            localizationCacheEntries = preloadedLocalizationCacheEntriesForBundle([NSBundle mainBundle], preloadedLocalization);
+            pathToImageMap = preloadedLocalizedImagesForBundle([NSBundle mainBundle], preloadedLocalization);
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            for (NSString *path in [pathToImageMap allKeys]) {
+                [[HLSImageCache sharedImageCache] setImage:[pathToImageMap objectForKey:path] forKey:path];
+            }
+            applyLocalization(localization, localizationCacheEntries);
+            
+            if (completionBlock) {
+                completionBlock();
+            }
+        });
+        
+        [pool drain];
+    });
+}
+
+// MARK: - Localization switch
+
+// Preloaded cache entries (if any) must correspond to the localization being applied
+static void applyLocalization(NSString *localization, NSDictionary *preloadedLocalizationCacheEntries)
 {
     initialize();
     
@@ -107,37 +187,356 @@ static void setDefaultLocalization(void)
     }
     
     if (![currentLocalization isEqualToString:previousLocalization]) {
-        [[NSNotificationCenter defaultCenter] postNotificationName:HLSCurrentLocalizationDidChangeNotification object:self];
+        flushLocalizationCache();
+        if (preloadedLocalizationCacheEntries) {
+            @synchronized(localizationCache) {
+                [localizationCache addEntriesFromDictionary:preloadedLocalizationCacheEntries];
+            }
+        }
+        [[NSNotificationCenter defaultCenter] postNotificationName:HLSCurrentLocalizationDidChangeNotification object:[NSBundle class]];
     }
     
     [[NSUserDefaults standardUserDefaults] setObject:currentLocalization forKey:HLSPreferredLocalizationDefaultsKey];
     [previousLocalization release];
 }
 
-// MARK: - Localized strings
++ (NSString *)missingLocalizedStringsReport
+{
+    NSMutableString *report = [NSMutableString string];
+    @synchronized(missingLocalizedStrings) {
+        NSUInteger numberOfLookups = 0;
+        for (NSString *missingLocalizedString in missingLocalizedStrings) {
+            numberOfLookups += [missingLocalizedStrings countForObject:missingLocalizedString];
+        }
+        [report appendFormat:@"%u missing localized strings (%u lookups)\n", [missingLocalizedStrings count], numberOfLookups];
+        
+        NSArray *sortedMissingLocalizedStrings = [[missingLocalizedStrings allObjects] sortedArrayUsingComparator:^(id obj1, id obj2) {
+            NSUInteger count1 = [missingLocalizedStrings countForObject:obj1];
+            NSUInteger count2 = [missingLocalizedStrings countForObject:obj2];
+            if (count1 == count2) {
+                return [obj1 compare:obj2];
+            }
+            return (NSComparisonResult)(count1 > count2 ? NSOrderedAscending : NSOrderedDescending);
+        }];
+        for (NSString *missingLocalizedString in sortedMissingLocalizedStrings) {
+            [report appendFormat:@"%8u  %@\n", [missingLocalizedStrings countForObject:missingLocalizedString], missingLocalizedString];
+        }
+    }
+    return [NSString stringWithString:report];
+}
 
-- (NSString *)dynamic_localizedStringForKey:(NSString *)key value:(NSString *)value table:(NSString *)tableName;
++ (void)resetMissingLocalizedStrings
+{
+    @synchronized(missingLocalizedStrings) {
+        [missingLocalizedStrings removeAllObjects];
+    }
+}
+
+// MARK: - Localization cache
+
+static void flushLocalizationCache(void)
 {
-    NSString *localizationName = currentLocalization;
-    BOOL lprojFound = YES;
-    NSString *lprojPath = [[[self bundlePath] stringByAppendingPathComponent:currentLocalization] stringByAppendingPathExtension:@"lproj"];
-    if (![[NSFileManager defaultManager] fileExistsAtPath:lprojPath]) {
-        // Handle old style English.lproj / French.lproj / German.lproj ...
-        static NSLocale *enLocale = nil;
+    @synchronized(localizationCache) {
+        [localizationCache removeAllObjects];
+    }
+}
+
+// Mapped strings tables are counted with their full length, even if their pages are not all resident
+static NSUInteger localizationCacheMemoryFootprint(void)
+{
+    NSUInteger memoryFootprint = 0;
+    @synchronized(localizationCache) {
+        for (NSString *cacheKey in [localizationCache allKeys]) {
+            memoryFootprint += estimatedMemoryFootprintOfObject(cacheKey);
+            memoryFootprint += estimatedMemoryFootprintOfObject([localizationCache objectForKey:cacheKey]);
+        }
+    }
+    return memoryFootprint;
+}
+
+// Rough estimate of the memory used by the objects stored in the localization cache
+static NSUInteger estimatedMemoryFootprintOfObject(id object)
+{
+    NSUInteger memoryFootprint = class_getInstanceSize(object_getClass(object));
+    if ([object isKindOfClass:[NSString class]]) {
+        memoryFootprint += [object length] * sizeof(unichar);
+    }
+    else if ([object isKindOfClass:[NSURL class]]) {
+        memoryFootprint += [[object absoluteString] length] * sizeof(unichar);
+    }
+    else if ([object isKindOfClass:[NSData class]]) {
+        memoryFootprint += [object length];
+    }
+    else if ([object isKindOfClass:[NSDictionary class]]) {
+        for (id key in object) {
+            memoryFootprint += estimatedMemoryFootprintOfObject(key) + estimatedMemoryFootprintOfObject([object objectForKey:key]);
+        }
+    }
+    else if ([object isKindOfClass:[NSArray class]]) {
+        for (id element in object) {
+            memoryFootprint += estimatedMemoryFootprintOfObject(element);
+        }
+    }
+    return memoryFootprint;
+}
+
+static NSString *lprojNameCacheKey(NSBundle *bundle, NSString *localization)
+{
+    return [NSString stringWithFormat:@"%@|%@", [bundle bundlePath], localization];
+}
+
+static NSString *stringsTableCacheKey(NSBundle *bundle, NSString *tableName, NSString *lprojName)
+{
+    return [NSString stringWithFormat:@"%@|%@|%@.strings", [bundle bundlePath], lprojName, tableName];
+}
+
+// Return the name of the .lproj directory for a localization (nil if none)
+static NSString *loadLprojNameForBundle(NSBundle *bundle, NSString *localization)
+{
+    NSString *lprojPath = [[[bundle bundlePath] stringByAppendingPathComponent:localization] stringByAppendingPathExtension:@"lproj"];
+    if ([[NSFileManager defaultManager] fileExistsAtPath:lprojPath]) {
+        return localization;
+    }
+    
+    // Handle old style English.lproj / French.lproj / German.lproj ...
+    static NSLocale *enLocale = nil;
+    @synchronized(localizationCache) {
         if (!enLocale) {
             enLocale = [[NSLocale alloc] initWithLocaleIdentifier:@"en"];
         }
-        NSString *displayLocalizationName = [enLocale displayNameForKey:NSLocaleLanguageCode value:currentLocalization];
-        lprojPath = [[[self bundlePath] stringByAppendingPathComponent:displayLocalizationName] stringByAppendingPathExtension:@"lproj"];
-        if ([[NSFileManager defaultManager] fileExistsAtPath:lprojPath]) {
-            localizationName = displayLocalizationName;
+    }
+    NSString *displayLocalizationName = [enLocale displayNameForKey:NSLocaleLanguageCode value:localization];
+    lprojPath = [[[bundle bundlePath] stringByAppendingPathComponent:displayLocalizationName] stringByAppendingPathExtension:@"lproj"];
+    if ([[NSFileManager defaultManager] fileExistsAtPath:lprojPath]) {
+        return displayLocalizationName;
+    }
+    
+    return nil;
+}
+
+// Return the name of the .lproj directory for a localization (nil if none), and cache it
+static NSString *lprojNameForBundle(NSBundle *bundle, NSString *localization)
+{
+    NSString *cacheKey = lprojNameCacheKey(bundle, localization);
+    @synchronized(localizationCache) {
+        id lprojName = [localizationCache objectForKey:cacheKey];
+        if (lprojName) {
+            return [lprojName isKindOfClass:[NSNull class]] ? nil : [[lprojName retain] autorelease];
+        }
+        
+        lprojName = loadLprojNameForBundle(bundle, localization);
+        [localizationCache setObject:(lprojName ? lprojName : [NSNull null]) forKey:cacheKey];
+        return lprojName;
+    }
+}
+
+// Return YES iff the data is a compiled strings table whose entries all lie within the data
+static BOOL isValidCompiledStringsTable(NSData *data)
+{
+    NSUInteger length = [data length];
+    if (length < kCompiledStringsTableHeaderLength) {
+        return NO;
+    }
+    
+    const uint32_t *header = (const uint32_t *)[data bytes];
+    if (CFSwapInt32LittleToHost(header[0]) != kCompiledStringsTableMagic
+            || CFSwapInt32LittleToHost(header[1]) != kCompiledStringsTableVersion) {
+        return NO;
+    }
+    
+    uint64_t count = CFSwapInt32LittleToHost(header[2]);
+    if (kCompiledStringsTableHeaderLength + count * kCompiledStringsTableEntryLength > length) {
+        return NO;
+    }
+    
+    const uint32_t *entries = header + 3;
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint32_t *entry = entries + 4 * i;
+        if ((uint64_t)CFSwapInt32LittleToHost(entry[0]) + CFSwapInt32LittleToHost(entry[1]) > length
+                || (uint64_t)CFSwapInt32LittleToHost(entry[2]) + CFSwapInt32LittleToHost(entry[3]) > length) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+// Binary search a (valid) compiled strings table. Return nil if the key is not found
+static NSString *localizedStringFromCompiledStringsTable(NSData *data, NSString *key)
+{
+    const char *keyBytes = [key UTF8String];
+    if (!keyBytes) {
+        return nil;
+    }
+    size_t keyLength = strlen(keyBytes);
+    
+    const uint8_t *bytes = (const uint8_t *)[data bytes];
+    const uint32_t *header = (const uint32_t *)bytes;
+    const uint32_t *entries = header + 3;
+    
+    NSInteger lowerIndex = 0;
+    NSInteger upperIndex = (NSInteger)CFSwapInt32LittleToHost(header[2]) - 1;
+    while (lowerIndex <= upperIndex) {
+        NSInteger index = lowerIndex + (upperIndex - lowerIndex) / 2;
+        const uint32_t *entry = entries + 4 * index;
+        uint32_t entryKeyLength = CFSwapInt32LittleToHost(entry[1]);
+        
+        int result = memcmp(bytes + CFSwapInt32LittleToHost(entry[0]), keyBytes, MIN(entryKeyLength, keyLength));
+        if (result == 0) {
+            result = (entryKeyLength < keyLength) ? -1 : ((entryKeyLength > keyLength) ? 1 : 0);
+        }
+        
+        if (result < 0) {
+            lowerIndex = index + 1;
+        }
+        else if (result > 0) {
+            upperIndex = index - 1;
         }
         else {
-            lprojFound = NO;
+            return [[[NSString alloc] initWithBytes:bytes + CFSwapInt32LittleToHost(entry[2])
+                                             length:CFSwapInt32LittleToHost(entry[3])
+                                           encoding:NSUTF8StringEncoding] autorelease];
+        }
+    }
+    return nil;
+}
+
+// Return the strings table (a memory-mapped compiled table as NSData, or a parsed table as NSDictionary, nil if
+// none)
+static id loadStringsTableForBundle(NSBundle *bundle, NSString *tableName, NSString *lprojName)
+{
+    NSString *compiledTablePath = [bundle pathForResource:tableName ofType:@"hlsstrings" inDirectory:nil forLocalization:lprojName];
+    if (compiledTablePath) {
+        NSError *error = nil;
+        NSData *data = [NSData dataWithContentsOfFile:compiledTablePath options:NSDataReadingMappedIfSafe error:&error];
+        if (data && isValidCompiledStringsTable(data)) {
+            return data;
+        }
+        HLSLoggerError(@"The compiled strings table %@ is invalid (error: %@); using the strings table instead", compiledTablePath, error);
+    }
+    
+    NSString *tablePath = [bundle pathForResource:tableName ofType:@"strings" inDirectory:nil forLocalization:lprojName];
+    return tablePath ? [NSDictionary dictionaryWithContentsOfFile:tablePath] : nil;
+}
+
+// Return the strings table (see above), and cache it
+static id stringsTableForBundle(NSBundle *bundle, NSString *tableName, NSString *lprojName)
+{
+    NSString *cacheKey = stringsTableCacheKey(bundle, tableName, lprojName);
+    @synchronized(localizationCache) {
+        id table = [localizationCache objectForKey:cacheKey];
+        if (table) {
+            return [table isKindOfClass:[NSNull class]] ? nil : [[table retain] autorelease];
+        }
+        
+        table = loadStringsTableForBundle(bundle, tableName, lprojName);
+        [localizationCache setObject:(table ? table : [NSNull null]) forKey:cacheKey];
+        return table;
+    }
+}
+        
+// Load all strings tables of a bundle for a localization, without caching them. Return the corresponding cache entries
+static NSDictionary *preloadedLocalizationCacheEntriesForBundle(NSBundle *bundle, NSString *localization)
+{
+    NSMutableDictionary *localizationCacheEntries = [NSMutableDictionary dictionary];
+    
+    NSString *lprojName = loadLprojNameForBundle(bundle, localization);
+    [localizationCacheEntries setObject:(lprojName ? lprojName : [NSNull null]) forKey:lprojNameCacheKey(bundle, localization)];
+    if (!lprojName) {
+        return localizationCacheEntries;
+    }
+    
+    NSMutableSet *tableNames = [NSMutableSet set];
+    for (NSString *extension in [NSArray arrayWithObjects:@"strings", @"hlsstrings", nil]) {
+        for (NSString *tablePath in [bundle pathsForResourcesOfType:extension inDirectory:nil forLocalization:lprojName]) {
+            [tableNames addObject:[[tablePath lastPathComponent] stringByDeletingPathExtension]];
         }
     }
     
-    if (!currentLocalization || !lprojFound) {
+    for (NSString *tableName in tableNames) {
+        id table = loadStringsTableForBundle(bundle, tableName, lprojName);
+        [localizationCacheEntries setObject:(table ? table : [NSNull null]) forKey:stringsTableCacheKey(bundle, tableName, lprojName)];
+    }
+    return localizationCacheEntries;
+}
+
+// Load and decode the localized images of a bundle for a localization. Return them in a dictionary whose keys are their paths
+static NSDictionary *preloadedLocalizedImagesForBundle(NSBundle *bundle, NSString *localization)
+{
+    NSString *lprojName = loadLprojNameForBundle(bundle, localization);
+    if (!lprojName) {
+        return nil;
+    }
+    
+    NSMutableDictionary *pathToImageMap = [NSMutableDictionary dictionary];
+    for (NSString *extension in [NSArray arrayWithObjects:@"png", @"jpg", @"jpeg", nil]) {
+        for (NSString *imagePath in [bundle pathsForResourcesOfType:extension inDirectory:nil forLocalization:lprojName]) {
+            // High-resolution variants are automatically loaded when available
+            if ([[[imagePath lastPathComponent] stringByDeletingPathExtension] hasSuffix:@"@2x"]) {
+                continue;
+            }
+            
+            UIImage *image = [UIImage imageWithContentsOfFile:imagePath];
+            if (!image) {
+                continue;
+            }
+            
+            // Draw the image to decode it
+            UIGraphicsBeginImageContextWithOptions(image.size, NO, image.scale);
+            [image drawAtPoint:CGPointZero];
+            UIImage *decodedImage = UIGraphicsGetImageFromCurrentImageContext();
+            UIGraphicsEndImageContext();
+            
+            if (decodedImage) {
+                [pathToImageMap setObject:decodedImage forKey:imagePath];
+            }
+        }
+    }
+    return pathToImageMap;
+}
+
+// Return the location of a resource (path or URL, or array of them) for the current localization, resolving it with the
+// block provided if not found in the cache
+static id resourceLocationForBundle(NSBundle *bundle, NSString *method, NSString *name, NSString *extension, NSString *subpath,
+                                    id (^resolutionBlock)(void))
+{
+    NSString *cacheKey = [NSString stringWithFormat:@"%@|%@|%@|%@|%@|%@", [bundle bundlePath], currentLocalization, method, name,
+                          extension, subpath];
+    @synchronized(localizationCache) {
+        id location = [localizationCache objectForKey:cacheKey];
+        if (location) {
+            return [location isKindOfClass:[NSNull class]] ? nil : [[location retain] autorelease];
+        }
+    }
+    
+    // Resolved outside the lock, the file system might be slow
+    id location = resolutionBlock();
+    @synchronized(localizationCache) {
+        [localizationCache setObject:(location ? location : [NSNull null]) forKey:cacheKey];
+    }
+    return location;
+}
+
+static void recordMissingLocalizedString(NSBundle *bundle, NSString *key, NSString *tableName, NSString *localizationName)
+{
+    NSString *missingLocalizedString = [NSString stringWithFormat:@"\"%@\" in strings table \"%@\" (%@) of bundle %@", key, tableName,
+                                        localizationName, [[bundle bundlePath] lastPathComponent]];
+    @synchronized(missingLocalizedStrings) {
+        if ([missingLocalizedStrings countForObject:missingLocalizedString] == 0) {
+            HLSLoggerWarn(@"Localizable string %@ not found. Further lookups will only be counted (see +missingLocalizedStringsReport)",
+                          missingLocalizedString);
+        }
+        [missingLocalizedStrings addObject:missingLocalizedString];
+    }
+}
+
+// MARK: - Localized strings
+
+- (NSString *)dynamic_localizedStringForKey:(NSString *)key value:(NSString *)value table:(NSString *)tableName;
+{
+    NSString *localization = [[currentLocalization retain] autorelease];
+    NSString *localizationName = localization ? lprojNameForBundle(self, localization) : nil;
+    if (!localizationName) {
         return [self dynamic_localizedStringForKey:key value:value table:tableName];
     }
     
@@ -149,14 +548,19 @@ static void setDefaultLocalization(void)
         tableName = @"Localizable";
     }
     
-    NSString *tablePath = [self pathForResource:tableName ofType:@"strings" inDirectory:nil forLocalization:localizationName];
-    NSDictionary *table = [NSDictionary dictionaryWithContentsOfFile:tablePath];
+    id table = stringsTableForBundle(self, tableName, localizationName);
     
-    NSString *localizedString = [table objectForKey:key];
+    NSString *localizedString = nil;
+    if ([table isKindOfClass:[NSData class]]) {
+        localizedString = localizedStringFromCompiledStringsTable(table, key);
+    }
+    else {
+        localizedString = [table objectForKey:key];
+    }
     
     if (!localizedString) {
         if ([[NSUserDefaults standardUserDefaults] boolForKey:@"NSShowNonLocalizedStrings"]) {
-            HLSLoggerWarn(@"Localizable string \"%@\" not found in strings table \"%@\" of bundle %@", key, tableName, self);
+            recordMissingLocalizedString(self, key, tableName, localizationName);
             return [key uppercaseString];
         }
         return [value length] > 0 ? value : key;
@@ -169,7 +573,9 @@ static void setDefaultLocalization(void)
 
 - (NSURL *)dynamic_URLForResource:(NSString *)name withExtension:(NSString *)extension subdirectory:(NSString *)subpath
 {
-    return [self URLForResource:name withExtension:extension subdirectory:subpath localization:currentLocalization];
+    return resourceLocationForBundle(self, @"URL", name, extension, subpath, ^{
+        return (id)[self URLForResource:name withExtension:extension subdirectory:subpath localization:currentLocalization];
+    });
 }
 
 - (NSURL *)dynamic_URLForResource:(NSString *)name withExtension:(NSString *)extension
@@ -180,14 +586,18 @@ static void setDefaultLocalization(void)
 
 - (NSArray *)dynamic_URLsForResourcesWithExtension:(NSString *)extension subdirectory:(NSString *)subpath
 {
-    return [self URLsForResourcesWithExtension:extension subdirectory:subpath localization:currentLocalization];
+    return resourceLocationForBundle(self, @"URLs", nil, extension, subpath, ^{
+        return (id)[self URLsForResourcesWithExtension:extension subdirectory:subpath localization:currentLocalization];
+    });
 }
 
 // MARK: - Paths
 
 - (NSString *)dynamic_pathForResource:(NSString *)name ofType:(NSString *)extension inDirectory:(NSString *)subpath
 {
-    return [self pathForResource:name ofType:extension inDirectory:subpath forLocalization:currentLocalization];
+    return resourceLocationForBundle(self, @"path", name, extension, subpath, ^{
+        return (id)[self pathForResource:name ofType:extension inDirectory:subpath forLocalization:currentLocalization];
+    });
 }
 
 - (NSString *)dynamic_pathForResource:(NSString *)name ofType:(NSString *)extension
@@ -198,7 +608,9 @@ static void setDefaultLocalization(void)
 
 - (NSArray *)dynamic_pathsForResourcesOfType:(NSString *)extension inDirectory:(NSString *)subpath
 {
-    return [self pathsForResourcesOfType:extension inDirectory:subpath forLocalization:currentLocalization];
+    return resourceLocationForBundle(self, @"paths", nil, extension, subpath, ^{
+        return (id)[self pathsForResourcesOfType:extension inDirectory:subpath forLocalization:currentLocalization];
+    });
 }
 
 // MARK: - Swizzling
@@ -228,6 +640,24 @@ static void initialize(void)
     }
     initialized = YES;
     
+    localizationCache = [[NSMutableDictionary alloc] init];
+    missingLocalizedStrings = [[NSCountedSet alloc] init];
+    
+    localizationCacheMemoryAccounting = [[HLSLocalizationCacheMemoryAccounting alloc] init];
+    [[HLSMemoryAccountant sharedMemoryAccountant] registerSubsystem:localizationCacheMemoryAccounting
+                                                           withName:@"Localization cache"
+                                                      purgePriority:HLSMemoryPurgePriorityLocalizationCache];
+    
+    // Flushed by the accountant in order of priority if it manages the cache
+    [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification
+                                                      object:nil
+                                                       queue:nil
+                                                  usingBlock:^(NSNotification *notification) {
+                                                      if (! [[HLSMemoryAccountant sharedMemoryAccountant] isManagingSubsystem:localizationCacheMemoryAccounting]) {
+                                                          flushLocalizationCache();
+                                                      }
+                                                  }];
+    
     exchangeNSBundleInstanceMethod(@selector(localizedStringForKey:value:table:));
     
     exchangeNSBundleInstanceMethod(@selector(URLForResource:withExtension:));
@@ -240,3 +670,24 @@ static void initialize(void)
 }
 
 @end
+
+#pragma mark -
+#pragma mark HLSLocalizationCacheMemoryAccounting class implementation
+
+@implementation HLSLocalizationCacheMemoryAccounting
+
+#pragma mark HLSMemoryAccounting protocol implementation
+
+- (NSUInteger)memoryFootprint
+{
+    return localizationCacheMemoryFootprint();
+}
+
+- (NSUInteger)purgeMemory
+{
+    NSUInteger memoryFootprint = localizationCacheMemoryFootprint();
+    flushLocalizationCache();
+    return memoryFootprint;
+}
+
+@end
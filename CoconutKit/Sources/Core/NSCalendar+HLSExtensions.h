@@ -51,6 +51,16 @@
 + (NSComparisonResult)compareDaysBetweenDate:(NSDate *)date1 andDate:(NSDate *)date2 inTimeZone:(NSTimeZone *)timeZone;
 + (BOOL)isDate:(NSDate *)date1 theSameDayAsDate:(NSDate *)date2;
 + (BOOL)isDate:(NSDate *)date1 theSameDayAsDate:(NSDate *)date2 inTimeZone:(NSTimeZone *)timeZone;
++ (void)getDayIndices:(NSInteger *)dayIndices 
+forTimeIntervalsSinceReferenceDate:(const NSTimeInterval *)timeIntervals
+                count:(NSUInteger)count
+       relativeToDate:(NSDate *)date
+           inTimeZone:(NSTimeZone *)timeZone;
++ (void)getDayComparisonResults:(NSComparisonResult *)comparisonResults
+forTimeIntervalsSinceReferenceDate:(const NSTimeInterval *)timeIntervals
+                          count:(NSUInteger)count
+                       withDate:(NSDate *)date
+                     inTimeZone:(NSTimeZone *)timeZone;
 
 /**
  * Return the date corresponding to given components in the specified time zone. The NSCalendar time zone is ignored
@@ -181,4 +191,26 @@
  */
 - (BOOL)isDate:(NSDate *)date1 theSameDayAsDate:(NSDate *)date2 inTimeZone:(NSTimeZone *)timeZone;
 
+/**
+ * Batch versions of -compareDaysBetweenDate:andDate:inTimeZone:, meant to process a large number of dates at once (e.g.
+ * to sort events into the days of an agenda). Dates are given as a C array of time intervals since the reference date,
+ * and results are stored into the C array received as first parameter, which must have the same number of elements.
+ * The offsets from GMT of the time zone are looked up once for the whole range of dates, and days are then calculated
+ * directly. As for the other methods, the time zone of the calendar is used if the time zone parameter is nil
+ *
+ * -getDayIndices:... stores for each date the number of days between the day containing the reference date given as
+ * parameter and the day containing the date (0 for the same day, negative values for earlier days). -getDayComparisonResults:...
+ * stores the result of the comparison between the day of each date and the day of the date given as parameter
+ */
+- (void)getDayIndices:(NSInteger *)dayIndices 
+forTimeIntervalsSinceReferenceDate:(const NSTimeInterval *)timeIntervals
+                count:(NSUInteger)count
+       relativeToDate:(NSDate *)date
+           inTimeZone:(NSTimeZone *)timeZone;
+- (void)getDayComparisonResults:(NSComparisonResult *)comparisonResults
+forTimeIntervalsSinceReferenceDate:(const NSTimeInterval *)timeIntervals
+                          count:(NSUInteger)count
+                       withDate:(NSDate *)date
+                     inTimeZone:(NSTimeZone *)timeZone;
+
 @end
@@ -11,6 +11,26 @@
 #import "NSDate+HLSExtensions.h"
 #import "NSTimeZone+HLSExtensions.h"
 
+#import <libkern/OSAtomic.h>
+
+static NSString * const kCurrentCalendarThreadLocalStorageKey = @"HLSCurrentCalendar";
+static NSString * const kCurrentCalendarGenerationThreadLocalStorageKey = @"HLSCurrentCalendarGeneration";
+
+// Gregorian reform (1582-10-15), before which NSGregorianCalendar uses Julian calendar rules
+static const NSTimeInterval kGregorianReformTimeIntervalSince1970 = -12219292800.;
+
+// Incremented when the current locale or the system time zone changes, invalidating the calendars cached by all threads
+static volatile int32_t s_currentCalendarGeneration = 0;
+
+// Function declarations
+static NSCalendar *currentCalendar(void);
+static NSInteger dayNumberForDate(NSDate *date, NSInteger secondsFromGMT);
+static BOOL fastStartDayNumberOfUnit(NSCalendar *calendar, NSCalendarUnit unit, NSInteger dayNumber, NSInteger *pStartDayNumber, 
+                                     NSUInteger *pNumberOfDays);
+static NSDate *fastStartDateOfUnit(NSCalendar *calendar, NSCalendarUnit unit, NSDate *date, NSTimeZone *timeZone);
+static BOOL fastNumberOfDaysInUnit(NSCalendar *calendar, NSCalendarUnit unit, NSDate *date, NSTimeZone *timeZone, NSUInteger *pNumberOfDays);
+static void getDayNumbers(NSInteger *dayNumbers, const NSTimeInterval *timeIntervals, NSUInteger count, NSTimeZone *timeZone);
+
 /**
  * The strategy is always the same here: Since all methods available from NSCalendar use the calendar time zone, we
  * always have to convert dates from the time zone in which we want to work to the calendar time zone. In this time 
@@ -18,6 +38,12 @@
  * the result is a date, though, we need to convert it back to the time zone in which we work
  */
 
+@interface NSCalendar (HLSExtensionsPrivate)
+
++ (void)currentCalendarSettingsDidChange:(NSNotification *)notification;
+
+@end
+
 @interface NSDateComponents (HLSExtensionsPrivate)
 
 + (NSString *)stringForComponentValue:(NSInteger)componentValue;
@@ -28,164 +54,206 @@
 
 #pragma mark Class methods
 
++ (void)load
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(currentCalendarSettingsDidChange:)
+                                                 name:NSCurrentLocaleDidChangeNotification
+                                               object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(currentCalendarSettingsDidChange:)
+                                                 name:NSSystemTimeZoneDidChangeNotification
+                                               object:nil];
+    
+    [pool drain];
+}
+
 + (NSDate *)dateFromComponents:(NSDateComponents *)components
 {
-    return [[NSCalendar currentCalendar] dateFromComponents:components];
+    return [currentCalendar() dateFromComponents:components];
 }
 
 + (NSDate *)dateFromComponents:(NSDateComponents *)components inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] dateFromComponents:components inTimeZone:timeZone];
+    return [currentCalendar() dateFromComponents:components inTimeZone:timeZone];
 }
 
 + (NSDateComponents *)components:(NSUInteger)unitFlags fromDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] components:unitFlags fromDate:date];
+    return [currentCalendar() components:unitFlags fromDate:date];
 }
 
 + (NSDateComponents *)components:(NSUInteger)unitFlags fromDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] components:unitFlags fromDate:date inTimeZone:timeZone];
+    return [currentCalendar() components:unitFlags fromDate:date inTimeZone:timeZone];
 }
 
 + (NSRange)minimumRangeOfUnit:(NSCalendarUnit)unit
 {
-    return [[NSCalendar currentCalendar] minimumRangeOfUnit:unit];
+    return [currentCalendar() minimumRangeOfUnit:unit];
 }
 
 + (NSRange)maximumRangeOfUnit:(NSCalendarUnit)unit
 {
-    return [[NSCalendar currentCalendar] maximumRangeOfUnit:unit];
+    return [currentCalendar() maximumRangeOfUnit:unit];
 }
 
 + (NSUInteger)numberOfDaysInUnit:(NSCalendarUnit)unit containingDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] numberOfDaysInUnit:unit containingDate:date];
+    return [currentCalendar() numberOfDaysInUnit:unit containingDate:date];
 }
 
 + (NSUInteger)numberOfDaysInUnit:(NSCalendarUnit)unit containingDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] numberOfDaysInUnit:unit containingDate:date inTimeZone:timeZone];
+    return [currentCalendar() numberOfDaysInUnit:unit containingDate:date inTimeZone:timeZone];
 }
 
 + (NSDate *)startDateOfUnit:(NSCalendarUnit)unit containingDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] startDateOfUnit:unit containingDate:date];
+    return [currentCalendar() startDateOfUnit:unit containingDate:date];
 }
 
 + (NSDate *)startDateOfUnit:(NSCalendarUnit)unit containingDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] startDateOfUnit:unit containingDate:date inTimeZone:timeZone];
+    return [currentCalendar() startDateOfUnit:unit containingDate:date inTimeZone:timeZone];
 }
 
 + (NSDate *)endDateOfUnit:(NSCalendarUnit)unit containingDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] endDateOfUnit:unit containingDate:date];
+    return [currentCalendar() endDateOfUnit:unit containingDate:date];
 }
 
 + (NSDate *)endDateOfUnit:(NSCalendarUnit)unit containingDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] endDateOfUnit:unit containingDate:date inTimeZone:timeZone];
+    return [currentCalendar() endDateOfUnit:unit containingDate:date inTimeZone:timeZone];
 }
 
 + (NSRange)rangeOfUnit:(NSCalendarUnit)smaller inUnit:(NSCalendarUnit)larger forDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] rangeOfUnit:smaller inUnit:larger forDate:date];
+    return [currentCalendar() rangeOfUnit:smaller inUnit:larger forDate:date];
 }
 
 + (NSRange)rangeOfUnit:(NSCalendarUnit)smaller inUnit:(NSCalendarUnit)larger forDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] rangeOfUnit:smaller inUnit:larger forDate:date inTimeZone:timeZone];
+    return [currentCalendar() rangeOfUnit:smaller inUnit:larger forDate:date inTimeZone:timeZone];
 }
 
 + (NSUInteger)ordinalityOfUnit:(NSCalendarUnit)smaller inUnit:(NSCalendarUnit)larger forDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] ordinalityOfUnit:smaller inUnit:larger forDate:date];
+    return [currentCalendar() ordinalityOfUnit:smaller inUnit:larger forDate:date];
 }
 
 + (NSUInteger)ordinalityOfUnit:(NSCalendarUnit)smaller inUnit:(NSCalendarUnit)larger forDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] ordinalityOfUnit:smaller inUnit:larger forDate:date inTimeZone:timeZone];
+    return [currentCalendar() ordinalityOfUnit:smaller inUnit:larger forDate:date inTimeZone:timeZone];
 }
 
 + (BOOL)rangeOfUnit:(NSCalendarUnit)unit startDate:(NSDate **)pStartDate interval:(NSTimeInterval *)pInterval forDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] rangeOfUnit:unit startDate:pStartDate interval:pInterval forDate:date];
+    return [currentCalendar() rangeOfUnit:unit startDate:pStartDate interval:pInterval forDate:date];
 }
 
 + (BOOL)rangeOfUnit:(NSCalendarUnit)unit startDate:(NSDate **)pStartDate interval:(NSTimeInterval *)pInterval forDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] rangeOfUnit:unit startDate:pStartDate interval:pInterval forDate:date inTimeZone:timeZone];
+    return [currentCalendar() rangeOfUnit:unit startDate:pStartDate interval:pInterval forDate:date inTimeZone:timeZone];
 }
 
 + (NSDate *)dateByAddingComponents:(NSDateComponents *)components toDate:(NSDate *)date options:(NSUInteger)options
 {
-    return [[NSCalendar currentCalendar] dateByAddingComponents:components toDate:date options:options];
+    return [currentCalendar() dateByAddingComponents:components toDate:date options:options];
 }
 
 + (NSDate *)dateByAddingComponents:(NSDateComponents *)components toDate:(NSDate *)date options:(NSUInteger)options inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] dateByAddingComponents:components toDate:date options:options inTimeZone:timeZone];
+    return [currentCalendar() dateByAddingComponents:components toDate:date options:options inTimeZone:timeZone];
 }
 
 + (NSDateComponents *)components:(NSUInteger)unitFlags fromDate:(NSDate *)startDate toDate:(NSDate *)endDate options:(NSUInteger)options
 {
-    return [[NSCalendar currentCalendar] components:unitFlags fromDate:startDate toDate:endDate options:options];
+    return [currentCalendar() components:unitFlags fromDate:startDate toDate:endDate options:options];
 }
 
 + (NSDateComponents *)components:(NSUInteger)unitFlags fromDate:(NSDate *)startDate toDate:(NSDate *)endDate options:(NSUInteger)options inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] components:unitFlags fromDate:startDate toDate:endDate options:options inTimeZone:timeZone];
+    return [currentCalendar() components:unitFlags fromDate:startDate toDate:endDate options:options inTimeZone:timeZone];
 }
 
 + (NSDate *)dateAtNoonTheSameDayAsDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] dateAtNoonTheSameDayAsDate:date];
+    return [currentCalendar() dateAtNoonTheSameDayAsDate:date];
 }
 
 + (NSDate *)dateAtNoonTheSameDayAsDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] dateAtNoonTheSameDayAsDate:date inTimeZone:timeZone];
+    return [currentCalendar() dateAtNoonTheSameDayAsDate:date inTimeZone:timeZone];
 }
 
 + (NSDate *)dateAtMidnightTheSameDayAsDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] dateAtMidnightTheSameDayAsDate:date];
+    return [currentCalendar() dateAtMidnightTheSameDayAsDate:date];
 }
 
 + (NSDate *)dateAtMidnightTheSameDayAsDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] dateAtMidnightTheSameDayAsDate:date inTimeZone:timeZone];
+    return [currentCalendar() dateAtMidnightTheSameDayAsDate:date inTimeZone:timeZone];
 }
 
 + (NSDate *)dateAtHour:(NSInteger)hour minute:(NSInteger)minute second:(NSInteger)second theSameDayAsDate:(NSDate *)date
 {
-    return [[NSCalendar currentCalendar] dateAtHour:hour minute:minute second:second theSameDayAsDate:date];
+    return [currentCalendar() dateAtHour:hour minute:minute second:second theSameDayAsDate:date];
 }
 
 + (NSDate *)dateAtHour:(NSInteger)hour minute:(NSInteger)minute second:(NSInteger)second theSameDayAsDate:(NSDate *)date inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] dateAtHour:hour minute:minute second:second theSameDayAsDate:date inTimeZone:timeZone];
+    return [currentCalendar() dateAtHour:hour minute:minute second:second theSameDayAsDate:date inTimeZone:timeZone];
 }
 
 + (NSComparisonResult)compareDaysBetweenDate:(NSDate *)date1 andDate:(NSDate *)date2
 {
-    return [[NSCalendar currentCalendar] compareDaysBetweenDate:date1 andDate:date2];
+    return [currentCalendar() compareDaysBetweenDate:date1 andDate:date2];
 }
 
 + (NSComparisonResult)compareDaysBetweenDate:(NSDate *)date1 andDate:(NSDate *)date2 inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] compareDaysBetweenDate:date1 andDate:date2 inTimeZone:timeZone];
+    return [currentCalendar() compareDaysBetweenDate:date1 andDate:date2 inTimeZone:timeZone];
 }
 
 + (BOOL)isDate:(NSDate *)date1 theSameDayAsDate:(NSDate *)date2
 {
-    return [[NSCalendar currentCalendar] isDate:date1 theSameDayAsDate:date2];
+    return [currentCalendar() isDate:date1 theSameDayAsDate:date2];
 }
 
 + (BOOL)isDate:(NSDate *)date1 theSameDayAsDate:(NSDate *)date2 inTimeZone:(NSTimeZone *)timeZone
 {
-    return [[NSCalendar currentCalendar] isDate:date1 theSameDayAsDate:date2 inTimeZone:timeZone];
+    return [currentCalendar() isDate:date1 theSameDayAsDate:date2 inTimeZone:timeZone];
+}
+
++ (void)getDayIndices:(NSInteger *)dayIndices 
+forTimeIntervalsSinceReferenceDate:(const NSTimeInterval *)timeIntervals
+                count:(NSUInteger)count
+       relativeToDate:(NSDate *)date
+           inTimeZone:(NSTimeZone *)timeZone
+{
+    [currentCalendar() getDayIndices:dayIndices 
+  forTimeIntervalsSinceReferenceDate:timeIntervals 
+                               count:count 
+                      relativeToDate:date 
+                          inTimeZone:timeZone];
+}
+
++ (void)getDayComparisonResults:(NSComparisonResult *)comparisonResults
+forTimeIntervalsSinceReferenceDate:(const NSTimeInterval *)timeIntervals
+                          count:(NSUInteger)count
+                       withDate:(NSDate *)date
+                     inTimeZone:(NSTimeZone *)timeZone
+{
+    [currentCalendar() getDayComparisonResults:comparisonResults 
+            forTimeIntervalsSinceReferenceDate:timeIntervals 
+                                         count:count 
+                                      withDate:date 
+                                    inTimeZone:timeZone];
 }
 
 #pragma mark Calendrical calculations
@@ -227,6 +295,11 @@
 
 - (NSUInteger)numberOfDaysInUnit:(NSCalendarUnit)unit containingDate:(NSDate *)date
 {
+    NSUInteger numberOfDays = 0;
+    if (fastNumberOfDaysInUnit(self, unit, date, [self timeZone], &numberOfDays)) {
+        return numberOfDays;
+    }
+    
     NSTimeInterval interval = 0.;
     [self rangeOfUnit:unit
             startDate:NULL 
@@ -241,12 +314,22 @@
         return [self numberOfDaysInUnit:unit containingDate:date];
     }
     
+    NSUInteger numberOfDays = 0;
+    if (fastNumberOfDaysInUnit(self, unit, date, timeZone, &numberOfDays)) {
+        return numberOfDays;
+    }
+    
     NSDate *dateInCalendarTimeZone = [[self timeZone] dateWithSameComponentsAsDate:date fromTimeZone:timeZone];
     return [self numberOfDaysInUnit:unit containingDate:dateInCalendarTimeZone];
 }
 
 - (NSDate *)startDateOfUnit:(NSCalendarUnit)unit containingDate:(NSDate *)date
 {
+    NSDate *fastStartDateOfUnitResult = fastStartDateOfUnit(self, unit, date, [self timeZone]);
+    if (fastStartDateOfUnitResult) {
+        return fastStartDateOfUnitResult;
+    }
+    
     NSDate *startDateOfUnit = nil;
     [self rangeOfUnit:unit 
             startDate:&startDateOfUnit
@@ -261,6 +344,11 @@
         return [self startDateOfUnit:unit containingDate:date];
     }
     
+    NSDate *fastStartDateOfUnitResult = fastStartDateOfUnit(self, unit, date, timeZone);
+    if (fastStartDateOfUnitResult) {
+        return fastStartDateOfUnitResult;
+    }
+    
     NSDate *dateInCalendarTimeZone = [[self timeZone] dateWithSameComponentsAsDate:date fromTimeZone:timeZone];
     NSDate *startDateInCalendarTimeZone = [self startDateOfUnit:unit containingDate:dateInCalendarTimeZone];
     return [timeZone dateWithSameComponentsAsDate:startDateInCalendarTimeZone fromTimeZone:[self timeZone]];
@@ -369,6 +457,15 @@
         return [self dateAtHour:hour minute:minute second:second theSameDayAsDate:date];
     }
     
+    // Direct calculation if the offset from GMT does not change during the day until the time we are interested in
+    NSDate *startDateOfDay = fastStartDateOfUnit(self, NSDayCalendarUnit, date, timeZone);
+    if (startDateOfDay) {
+        NSDate *resultDate = [startDateOfDay dateByAddingTimeInterval:hour * 60 * 60 + minute * 60 + second];
+        if ([timeZone secondsFromGMTForDate:resultDate] == [timeZone secondsFromGMTForDate:startDateOfDay]) {
+            return resultDate;
+        }
+    }
+    
     NSUInteger unitFlags = NSYearCalendarUnit | NSMonthCalendarUnit | NSDayCalendarUnit;
     NSDateComponents *dateComponents = [self components:unitFlags fromDate:date inTimeZone:timeZone];
     [dateComponents setHour:hour];
@@ -388,21 +485,15 @@
         return [self compareDaysBetweenDate:date1 andDate:date2];
     }
     
-    NSUInteger unitFlags = NSYearCalendarUnit | NSMonthCalendarUnit | NSDayCalendarUnit;
-    NSDateComponents *dateComponents1 = [self components:unitFlags fromDate:date1 inTimeZone:timeZone];
-    NSDateComponents *dateComponents2 = [self components:unitFlags fromDate:date2 inTimeZone:timeZone];
-    
-    // Create comparable strings from those components
-    NSString *dateString1 = [NSString stringWithFormat:@"%d%02d%02d", 
-                             [dateComponents1 year],
-                             [dateComponents1 month],
-                             [dateComponents1 day]];
-    NSString *dateString2 = [NSString stringWithFormat:@"%d%02d%02d", 
-                             [dateComponents2 year],
-                             [dateComponents2 month],
-                             [dateComponents2 day]];
-    
-    return [dateString1 compare:dateString2];
+    // Days are the same in all calendars, their numbers can be compared directly
+    NSInteger dayNumber1 = dayNumberForDate(date1, [timeZone secondsFromGMTForDate:date1]);
+    NSInteger dayNumber2 = dayNumberForDate(date2, [timeZone secondsFromGMTForDate:date2]);
+    if (dayNumber1 != dayNumber2) {
+        return (dayNumber1 < dayNumber2) ? NSOrderedAscending : NSOrderedDescending;
+    }
+    else {
+        return NSOrderedSame;
+    }
 }
 
 - (BOOL)isDate:(NSDate *)date1 theSameDayAsDate:(NSDate *)date2
@@ -420,6 +511,51 @@
     return comparisonResult == NSOrderedSame;
 }
 
+#pragma mark Batch calendrical calculations
+
+- (void)getDayIndices:(NSInteger *)dayIndices 
+forTimeIntervalsSinceReferenceDate:(const NSTimeInterval *)timeIntervals
+                count:(NSUInteger)count
+       relativeToDate:(NSDate *)date
+           inTimeZone:(NSTimeZone *)timeZone
+{
+    if (! timeZone) {
+        timeZone = [self timeZone];
+    }
+    
+    getDayNumbers(dayIndices, timeIntervals, count, timeZone);
+    
+    NSInteger referenceDayNumber = dayNumberForDate(date, [timeZone secondsFromGMTForDate:date]);
+    for (NSUInteger i = 0; i < count; ++i) {
+        dayIndices[i] -= referenceDayNumber;
+    }
+}
+
+- (void)getDayComparisonResults:(NSComparisonResult *)comparisonResults
+forTimeIntervalsSinceReferenceDate:(const NSTimeInterval *)timeIntervals
+                          count:(NSUInteger)count
+                       withDate:(NSDate *)date
+                     inTimeZone:(NSTimeZone *)timeZone
+{
+    NSInteger *dayIndices = malloc(count * sizeof(NSInteger));
+    [self getDayIndices:dayIndices forTimeIntervalsSinceReferenceDate:timeIntervals count:count relativeToDate:date inTimeZone:timeZone];
+    for (NSUInteger i = 0; i < count; ++i) {
+        comparisonResults[i] = (dayIndices[i] > 0) - (dayIndices[i] < 0);
+    }
+    free(dayIndices);
+}
+
+@end
+
+@implementation NSCalendar (HLSExtensionsPrivate)
+
+#pragma mark Notification callbacks
+
++ (void)currentCalendarSettingsDidChange:(NSNotification *)notification
+{
+    OSAtomicIncrement32Barrier(&s_currentCalendarGeneration);
+}
+
 @end
 
 @implementation NSDateComponents (HLSExtensionsPrivate)
@@ -468,3 +604,190 @@
 
 @end
 
+#pragma mark Functions
+
+/**
+ * Return the current calendar. Since +[NSCalendar currentCalendar] returns a new object each time it is called, a calendar
+ * is cached for each thread (calendars are not thread-safe). The cached calendar is discarded when the current locale,
+ * the system time zone or the default time zone changes
+ */
+static NSCalendar *currentCalendar(void)
+{
+    NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+    NSCalendar *calendar = [threadDictionary objectForKey:kCurrentCalendarThreadLocalStorageKey];
+    int32_t generation = s_currentCalendarGeneration;
+    if (! calendar
+            || [[threadDictionary objectForKey:kCurrentCalendarGenerationThreadLocalStorageKey] intValue] != generation
+            || ! [[calendar timeZone] isEqualToTimeZone:[NSTimeZone defaultTimeZone]]) {
+        calendar = [NSCalendar currentCalendar];
+        [threadDictionary setObject:calendar forKey:kCurrentCalendarThreadLocalStorageKey];
+        [threadDictionary setObject:[NSNumber numberWithInt:generation] forKey:kCurrentCalendarGenerationThreadLocalStorageKey];
+    }
+    return calendar;
+}
+
+/**
+ * Return the number of the day (since 1970-01-01) to which a date belongs, for a given offset from GMT. Only differences
+ * between day numbers are meaningful (see getDayNumbers())
+ */
+static NSInteger dayNumberForDate(NSDate *date, NSInteger secondsFromGMT)
+{
+    return (NSInteger)floor(([date timeIntervalSince1970] + secondsFromGMT) / (24 * 60 * 60));
+}
+
+/**
+ * Direct calculation of the first day (and of the number of days) of the day, week or month containing a given day. All
+ * calendars have the same days and weeks, but months are only calculated for the Gregorian calendar. Return NO if no
+ * direct calculation is possible
+ */
+static BOOL fastStartDayNumberOfUnit(NSCalendar *calendar, NSCalendarUnit unit, NSInteger dayNumber, NSInteger *pStartDayNumber, 
+                                     NSUInteger *pNumberOfDays)
+{
+    switch (unit) {
+        case NSDayCalendarUnit: {
+            *pStartDayNumber = dayNumber;
+            *pNumberOfDays = 1;
+            return YES;
+            break;
+        }
+            
+        case NSWeekCalendarUnit: {
+            // 1970-01-01 was a Thursday (weekday 5, Sunday being 1)
+            NSInteger weekday = ((dayNumber + 4) % 7 + 7) % 7 + 1;
+            *pStartDayNumber = dayNumber - (weekday - (NSInteger)[calendar firstWeekday] + 7) % 7;
+            *pNumberOfDays = 7;
+            return YES;
+            break;
+        }
+            
+        case NSMonthCalendarUnit: {
+            if (! [[calendar calendarIdentifier] isEqualToString:NSGregorianCalendar]) {
+                return NO;
+            }
+            
+            // Gregorian calendar date from the day number (years starting in March, so that leap days come last)
+            NSInteger shiftedDayNumber = dayNumber + 719468;
+            NSInteger era = (shiftedDayNumber >= 0 ? shiftedDayNumber : shiftedDayNumber - 146096) / 146097;
+            NSInteger dayOfEra = shiftedDayNumber - era * 146097;
+            NSInteger yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+            NSInteger dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+            NSInteger shiftedMonth = (5 * dayOfYear + 2) / 153;
+            NSInteger day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+            NSInteger month = (shiftedMonth < 10) ? shiftedMonth + 3 : shiftedMonth - 9;
+            NSInteger year = yearOfEra + era * 400 + ((month <= 2) ? 1 : 0);
+            
+            static const NSUInteger s_daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+            BOOL leapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+            *pStartDayNumber = dayNumber - (day - 1);
+            *pNumberOfDays = (month == 2 && leapYear) ? 29 : s_daysInMonth[month - 1];
+            return YES;
+            break;
+        }
+            
+        default: {
+            return NO;
+            break;
+        }
+    }
+}
+
+/**
+ * Direct calculation of -startDateOfUnit:containingDate:inTimeZone:. Return nil if no direct calculation is possible, 
+ * i.e. for other units or calendars, or if the offset from GMT changes between the start of the unit and the date
+ */
+static NSDate *fastStartDateOfUnit(NSCalendar *calendar, NSCalendarUnit unit, NSDate *date, NSTimeZone *timeZone)
+{
+    if ([date timeIntervalSince1970] < kGregorianReformTimeIntervalSince1970) {
+        return nil;
+    }
+    
+    NSInteger secondsFromGMT = [timeZone secondsFromGMTForDate:date];
+    NSInteger startDayNumber = 0;
+    NSUInteger numberOfDays = 0;
+    if (! fastStartDayNumberOfUnit(calendar, unit, dayNumberForDate(date, secondsFromGMT), &startDayNumber, &numberOfDays)) {
+        return nil;
+    }
+    
+    NSDate *startDate = [NSDate dateWithTimeIntervalSince1970:(NSTimeInterval)startDayNumber * 24 * 60 * 60 - secondsFromGMT];
+    if ([timeZone secondsFromGMTForDate:startDate] != secondsFromGMT) {
+        return nil;
+    }
+    return startDate;
+}
+
+/**
+ * Direct calculation of -numberOfDaysInUnit:containingDate:inTimeZone:. Return NO if no direct calculation is possible
+ */
+static BOOL fastNumberOfDaysInUnit(NSCalendar *calendar, NSCalendarUnit unit, NSDate *date, NSTimeZone *timeZone, NSUInteger *pNumberOfDays)
+{
+    if ([date timeIntervalSince1970] < kGregorianReformTimeIntervalSince1970) {
+        return NO;
+    }
+    
+    NSInteger startDayNumber = 0;
+    return fastStartDayNumberOfUnit(calendar, unit, dayNumberForDate(date, [timeZone secondsFromGMTForDate:date]), &startDayNumber,
+                                    pNumberOfDays);
+}
+
+/**
+ * Calculate the day numbers corresponding to an array of time intervals since the reference date. The day numbers have
+ * the same origin as those returned by dayNumberForDate(). The offsets from GMT are looked up once for the time zone, 
+ * for the whole range of dates, so that each day number can be calculated directly
+ */
+static void getDayNumbers(NSInteger *dayNumbers, const NSTimeInterval *timeIntervals, NSUInteger count, NSTimeZone *timeZone)
+{
+    if (count == 0) {
+        return;
+    }
+    
+    NSTimeInterval minTimeInterval = timeIntervals[0];
+    NSTimeInterval maxTimeInterval = timeIntervals[0];
+    for (NSUInteger i = 1; i < count; ++i) {
+        minTimeInterval = MIN(minTimeInterval, timeIntervals[i]);
+        maxTimeInterval = MAX(maxTimeInterval, timeIntervals[i]);
+    }
+    
+    // Table of the offset changes between the earliest and the latest date. Offsets are constant between two
+    // consecutive transitions
+    NSUInteger nbrTransitions = 1;
+    NSUInteger capacity = 8;
+    NSTimeInterval *transitionTimeIntervals = malloc(capacity * sizeof(NSTimeInterval));
+    NSTimeInterval *offsets = malloc(capacity * sizeof(NSTimeInterval));
+    NSDate *transitionDate = [NSDate dateWithTimeIntervalSinceReferenceDate:minTimeInterval];
+    transitionTimeIntervals[0] = minTimeInterval;
+    offsets[0] = [timeZone secondsFromGMTForDate:transitionDate];
+    while ((transitionDate = [timeZone nextDaylightSavingTimeTransitionAfterDate:transitionDate])
+           && [transitionDate timeIntervalSinceReferenceDate] <= maxTimeInterval) {
+        if (nbrTransitions == capacity) {
+            capacity *= 2;
+            transitionTimeIntervals = realloc(transitionTimeIntervals, capacity * sizeof(NSTimeInterval));
+            offsets = realloc(offsets, capacity * sizeof(NSTimeInterval));
+        }
+        transitionTimeIntervals[nbrTransitions] = [transitionDate timeIntervalSinceReferenceDate];
+        offsets[nbrTransitions] = [timeZone secondsFromGMTForDate:transitionDate];
+        ++nbrTransitions;
+    }
+    
+    // The reference date is at midnight UTC. Shift day numbers so that they have the same origin as dayNumberForDate()
+    static const NSInteger kDaysBetween1970AndReferenceDate = 11323;
+    for (NSUInteger i = 0; i < count; ++i) {
+        // Binary search for the last transition before the date
+        NSTimeInterval timeInterval = timeIntervals[i];
+        NSUInteger low = 0;
+        NSUInteger high = nbrTransitions;
+        while (high - low > 1) {
+            NSUInteger middle = (low + high) / 2;
+            if (transitionTimeIntervals[middle] <= timeInterval) {
+                low = middle;
+            }
+            else {
+                high = middle;
+            }
+        }
+        
+        dayNumbers[i] = (NSInteger)floor((timeInterval + offsets[low]) / (24 * 60 * 60)) + kDaysBetween1970AndReferenceDate;
+    }
+    
+    free(transitionTimeIntervals);
+    free(offsets);
+}
@@ -6,6 +6,8 @@
 //  Copyright 2011 Hortis. All rights reserved.
 //
 
+#import "HLSDigest.h"
+
 @interface NSData (HLSExtensions)
 
 /**
@@ -48,4 +50,22 @@
  */
 - (NSString *)sha512hash;
 
+/**
+ * Calculate the hash with the given algorithm, as raw bytes (e.g. to be used as binary cache key)
+ */
+- (NSData *)digestDataWithAlgorithm:(HLSDigestAlgorithm)algorithm;
+
+/**
+ * Calculate the hash with the given algorithm and write it into a buffer, which must be at least
+ * +[HLSDigest digestLengthForAlgorithm:] bytes long
+ */
+- (void)getDigest:(unsigned char *)md withAlgorithm:(HLSDigestAlgorithm)algorithm;
+
+/**
+ * Calculate a fast non-cryptographic 64-bit hash (see HLSFastHash), as is or as a 16-character hexadecimal lowercase 
+ * string. Use it for in-memory cache keys rather than a cryptographic hash, which is far more expensive
+ */
+- (uint64_t)fastHash;
+- (NSString *)fastHexHash;
+
 @end
@@ -8,65 +8,70 @@
 
 #import "NSData+HLSExtensions.h"
 
-#import <CommonCrypto/CommonDigest.h>
-
-static NSString* digest(NSData *data, unsigned char *(*cc_digest)(const void *, CC_LONG, unsigned char *), CC_LONG digestLength)
-{
-	unsigned char md[digestLength];     // C99
-    memset(md, 0, sizeof(md));
-	cc_digest([data bytes], [data length], md);
-    
-    // Hexadecimal representation
-    NSMutableString *hexHash = [NSMutableString string];
-    for (NSUInteger i = 0; i < sizeof(md); ++i) {
-        [hexHash appendFormat:@"%02X", md[i]];
-    }
-    
-    return [hexHash lowercaseString];
-}
-
 @implementation NSData (HLSExtensions)
 
 #pragma mark Digest methods
 
 - (NSString *)md2hash
 {
-    return digest(self, CC_MD2, CC_MD2_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForData:self algorithm:HLSDigestAlgorithmMD2];
 }
 
 - (NSString *)md4hash
 {
-    return digest(self, CC_MD4, CC_MD4_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForData:self algorithm:HLSDigestAlgorithmMD4];
 }
 
 - (NSString *)md5hash
 {
-    return digest(self, CC_MD5, CC_MD5_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForData:self algorithm:HLSDigestAlgorithmMD5];
 }
 
 - (NSString *)sha1hash
 {
-    return digest(self, CC_SHA1, CC_SHA1_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForData:self algorithm:HLSDigestAlgorithmSHA1];
 }
 
 - (NSString *)sha224hash
 {
-    return digest(self, CC_SHA224, CC_SHA224_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForData:self algorithm:HLSDigestAlgorithmSHA224];
 }
 
 - (NSString *)sha256hash
 {
-    return digest(self, CC_SHA256, CC_SHA256_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForData:self algorithm:HLSDigestAlgorithmSHA256];
 }
 
 - (NSString *)sha384hash
 {
-    return digest(self, CC_SHA384, CC_SHA384_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForData:self algorithm:HLSDigestAlgorithmSHA384];
 }
 
 - (NSString *)sha512hash
 {
-    return digest(self, CC_SHA512, CC_SHA512_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForData:self algorithm:HLSDigestAlgorithmSHA512];
+}
+
+- (NSData *)digestDataWithAlgorithm:(HLSDigestAlgorithm)algorithm
+{
+    return [HLSDigest digestDataForData:self algorithm:algorithm];
+}
+
+- (void)getDigest:(unsigned char *)md withAlgorithm:(HLSDigestAlgorithm)algorithm
+{
+    [HLSDigest getDigest:md forBytes:[self bytes] length:[self length] algorithm:algorithm];
+}
+
+#pragma mark Fast hash
+
+- (uint64_t)fastHash
+{
+    return HLSFastHash([self bytes], [self length], 0);
+}
+
+- (NSString *)fastHexHash
+{
+    return [NSString stringWithFormat:@"%016llx", [self fastHash]];
 }
 
 @end
@@ -8,6 +8,13 @@
 
 @interface NSDate (HLSExtensions)
 
+/**
+ * Call this method to have date descriptions (e.g. when logging dates) also display the date in the system time zone.
+ * This swizzles -descriptionWithLocale: and is useful when debugging only. For simplicity you should use the
+ * HLSEnableNSDateSystemTimeZoneDescription convenience macro instead (see HLSOptionalFeatures.h)
+ */
++ (void)enable;
+
 /**
  * Convenience methods for date comparisons. Easier to read than -[NSDate compare:]
  */
@@ -8,14 +8,18 @@
 
 #import "NSDate+HLSExtensions.h"
 
+#import "HLSLogger.h"
 #import "HLSRuntime.h"
 #import "NSCalendar+HLSExtensions.h"
 
-static NSDateFormatter *s_dateFormatter = nil;
+#include <time.h>
 
 // Original implementation of the methods we swizzle
 static id (*s_NSDate__descriptionWithLocale_Imp)(id, SEL, id) = NULL;
 
+// Function declarations
+static NSString *stringInDefaultTimeZoneForDate(NSDate *date);
+
 // Swizzled method implementations
 static NSString *swizzled_NSDate__descriptionWithLocale_Imp(NSDate *self, SEL _cmd, id locale);
 
@@ -23,22 +27,19 @@ static NSString *swizzled_NSDate__descriptionWithLocale_Imp(NSDate *self, SEL _c
 
 #pragma mark Class methods
 
-+ (void)load
++ (void)enable
 {
+    static BOOL s_enabled = NO;
+    if (s_enabled) {
+        HLSLoggerInfo(@"Date descriptions with system time zone already enabled");
+        return;
+    }
+    
     s_NSDate__descriptionWithLocale_Imp = (id (*)(id, SEL, id))HLSSwizzleSelector(self, 
                                                                                   @selector(descriptionWithLocale:),
                                                                                   (IMP)swizzled_NSDate__descriptionWithLocale_Imp);
-}
-
-+ (void)initialize
-{
-    if (self != [NSDate class]) {
-        return;
-    }
     
-    // Create time formatter for system timezone (which is the default one if not set)
-    s_dateFormatter = [[NSDateFormatter alloc] init];
-    [s_dateFormatter setDateFormat:@"yyyy'-'MM'-'dd' 'HH':'mm':'ss' 'ZZZ"];
+    s_enabled = YES;
 }
 
 #pragma mark Convenience methods
@@ -70,5 +71,32 @@ static NSString *swizzled_NSDate__descriptionWithLocale_Imp(NSDate *self, SEL _c
 static NSString *swizzled_NSDate__descriptionWithLocale_Imp(NSDate *self, SEL _cmd, id locale)
 {
     NSString *originalString = (*s_NSDate__descriptionWithLocale_Imp)(self, _cmd, locale);
-    return [NSString stringWithFormat:@"%@ (system time zone: %@)", originalString, [s_dateFormatter stringFromDate:self]];
+    return [NSString stringWithFormat:@"%@ (system time zone: %@)", originalString, stringInDefaultTimeZoneForDate(self)];
+}
+
+#pragma mark -
+#pragma mark Static functions
+
+/**
+ * Return the date in the default time zone (which is the system time zone if not set) with the format
+ * yyyy-MM-dd HH:mm:ss ZZZ. Descriptions are requested from any thread (most notably when logging), the string is
+ * therefore built with reentrant C functions, without any formatter or lock
+ */
+static NSString *stringInDefaultTimeZoneForDate(NSDate *date)
+{
+    NSInteger secondsFromGMT = [[NSTimeZone defaultTimeZone] secondsFromGMTForDate:date];
+    time_t localTime = (time_t)floor([date timeIntervalSince1970]) + secondsFromGMT;
+    
+    struct tm components;
+    if (! gmtime_r(&localTime, &components)) {
+        return nil;
+    }
+    
+    NSInteger offsetInMinutes = labs(secondsFromGMT) / 60;
+    char string[32];
+    snprintf(string, sizeof(string), "%04d-%02d-%02d %02d:%02d:%02d %c%02ld%02ld",
+             components.tm_year + 1900, components.tm_mon + 1, components.tm_mday,
+             components.tm_hour, components.tm_min, components.tm_sec,
+             secondsFromGMT < 0 ? '-' : '+', (long)(offsetInMinutes / 60), (long)(offsetInMinutes % 60));
+    return [NSString stringWithCString:string encoding:NSASCIIStringEncoding];
 }
@@ -15,4 +15,14 @@
 + (NSArray *)orderedWeekdaySymbols;
 + (NSArray *)orderedShortWeekdaySymbols;
 
+/**
+ * Return a date formatter for the given format, locale and time zone (nil means the current locale, respectively
+ * the default time zone). Date formatters are expensive to create, and this method returns a formatter cached
+ * for the calling thread (formatters are not thread-safe). Cached formatters are discarded when the current locale 
+ * or the system time zone changes
+ *
+ * The formatter returned must not be altered, and must not be used from another thread
+ */
++ (NSDateFormatter *)cachedDateFormatterWithFormat:(NSString *)format locale:(NSLocale *)locale timeZone:(NSTimeZone *)timeZone;
+
 @end
@@ -10,8 +10,42 @@
 
 #import "NSArray+HLSExtensions.h"
 
+#import <libkern/OSAtomic.h>
+
+static NSString * const kDateFormatterCacheThreadLocalStorageKey = @"HLSDateFormatterCache";
+static NSString * const kDateFormatterCacheGenerationThreadLocalStorageKey = @"HLSDateFormatterCacheGeneration";
+
+// Incremented when the current locale or the system time zone changes, invalidating the formatters cached by all threads
+static volatile int32_t s_dateFormatterCacheGeneration = 0;
+
+@interface NSDateFormatter (HLSExtensionsPrivate)
+
++ (void)dateFormatterCacheSettingsDidChange:(NSNotification *)notification;
+
+@end
+
 @implementation NSDateFormatter (HLSExtensions)
 
+#pragma mark Class methods
+
++ (void)load
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(dateFormatterCacheSettingsDidChange:)
+                                                 name:NSCurrentLocaleDidChangeNotification
+                                               object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(dateFormatterCacheSettingsDidChange:)
+                                                 name:NSSystemTimeZoneDidChangeNotification
+                                               object:nil];
+    
+    [pool drain];
+}
+
+#pragma mark Weekdays
+
 + (NSArray *)orderedWeekdaySymbols
 {
     static NSArray *s_orderedWeekdays = nil;
@@ -38,4 +72,49 @@
     return s_orderedShortWeekdays;
 }
 
+#pragma mark Cached formatters
+
++ (NSDateFormatter *)cachedDateFormatterWithFormat:(NSString *)format locale:(NSLocale *)locale timeZone:(NSTimeZone *)timeZone
+{
+    if (! locale) {
+        locale = [NSLocale currentLocale];
+    }
+    if (! timeZone) {
+        timeZone = [NSTimeZone defaultTimeZone];
+    }
+    
+    // Discard the formatters cached by the current thread if settings have changed since they were created
+    NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+    NSMutableDictionary *dateFormatterCache = [threadDictionary objectForKey:kDateFormatterCacheThreadLocalStorageKey];
+    int32_t generation = s_dateFormatterCacheGeneration;
+    if (! dateFormatterCache || [[threadDictionary objectForKey:kDateFormatterCacheGenerationThreadLocalStorageKey] intValue] != generation) {
+        dateFormatterCache = [NSMutableDictionary dictionary];
+        [threadDictionary setObject:dateFormatterCache forKey:kDateFormatterCacheThreadLocalStorageKey];
+        [threadDictionary setObject:[NSNumber numberWithInt:generation] forKey:kDateFormatterCacheGenerationThreadLocalStorageKey];
+    }
+    
+    NSString *key = [NSString stringWithFormat:@"%@|%@|%@", format, [locale localeIdentifier], [timeZone name]];
+    NSDateFormatter *dateFormatter = [dateFormatterCache objectForKey:key];
+    if (! dateFormatter) {
+        dateFormatter = [[[NSDateFormatter alloc] init] autorelease];
+        [dateFormatter setFormatterBehavior:NSDateFormatterBehavior10_4];
+        [dateFormatter setLocale:locale];
+        [dateFormatter setTimeZone:timeZone];
+        [dateFormatter setDateFormat:format];
+        [dateFormatterCache setObject:dateFormatter forKey:key];
+    }
+    return dateFormatter;
+}
+
+@end
+
+@implementation NSDateFormatter (HLSExtensionsPrivate)
+
+#pragma mark Notification callbacks
+
++ (void)dateFormatterCacheSettingsDidChange:(NSNotification *)notification
+{
+    OSAtomicIncrement32Barrier(&s_dateFormatterCacheGeneration);
+}
+
 @end
@@ -9,7 +9,8 @@
 @interface NSDictionary (HLSExtensions)
 
 /**
- * Return the receiver, to which object has been set for key
+ * Return the receiver, to which object has been set for key. The whole receiver is copied. Use HLSPersistentDictionary
+ * for dictionaries which are often updated this way
  */
 - (id)dictionaryBySettingObject:(id)object forKey:(id)key;
 
@@ -13,6 +13,13 @@
  */
 - (void)safelyAddObject:(id)object;
 
+/**
+ * Rotate array elements left or right in place (elements disappearing at an end are moved to the other end). Same
+ * as the corresponding NSArray methods, but the receiver is updated without any copy
+ */
+- (void)leftRotateNumberOfObjects:(NSUInteger)numberOfObjects;
+- (void)rightRotateNumberOfObjects:(NSUInteger)numberOfObjects;
+
 /**
  * Sort an array using a single descriptor
  */
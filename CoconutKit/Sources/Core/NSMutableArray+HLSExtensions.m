@@ -8,6 +8,13 @@
 
 #import "NSMutableArray+HLSExtensions.h"
 
+@interface NSMutableArray (HLSExtensionsPrivate)
+
+- (void)shiftNumberOfObjects:(NSUInteger)numberOfObjects;
+- (void)reverseObjectsInRange:(NSRange)range;
+
+@end
+
 @implementation NSMutableArray (HLSExtensions)
 
 - (void)safelyAddObject:(id)object
@@ -18,6 +25,57 @@
     [self addObject:object];
 }
 
+- (void)leftRotateNumberOfObjects:(NSUInteger)numberOfObjects
+{
+    NSUInteger count = [self count];
+    if (numberOfObjects == 0 || count == 0) {
+        return;
+    }
+    
+    [self shiftNumberOfObjects:numberOfObjects % count];
+}
+
+- (void)rightRotateNumberOfObjects:(NSUInteger)numberOfObjects
+{
+    NSUInteger count = [self count];
+    if (numberOfObjects == 0 || count == 0) {
+        return;
+    }
+    
+    [self shiftNumberOfObjects:(count - numberOfObjects % count) % count];
+}
+
+/**
+ * Move the first numberOfObjects objects to the end of the array. Implemented by reversing both parts of the array,
+ * then the whole array, so that each object is moved exactly twice and no additional storage is needed
+ */
+- (void)shiftNumberOfObjects:(NSUInteger)numberOfObjects
+{
+    if (numberOfObjects == 0) {
+        return;
+    }
+    
+    NSUInteger count = [self count];
+    [self reverseObjectsInRange:NSMakeRange(0, numberOfObjects)];
+    [self reverseObjectsInRange:NSMakeRange(numberOfObjects, count - numberOfObjects)];
+    [self reverseObjectsInRange:NSMakeRange(0, count)];
+}
+
+- (void)reverseObjectsInRange:(NSRange)range
+{
+    if (range.length < 2) {
+        return;
+    }
+    
+    NSUInteger i = range.location;
+    NSUInteger j = NSMaxRange(range) - 1;
+    while (i < j) {
+        [self exchangeObjectAtIndex:i withObjectAtIndex:j];
+        ++i;
+        --j;
+    }
+}
+
 - (void)sortUsingDescriptor:(NSSortDescriptor *)sortDescriptor
 {
     NSArray *sortDescriptors = sortDescriptor ? [NSArray arrayWithObject:sortDescriptor] : nil;
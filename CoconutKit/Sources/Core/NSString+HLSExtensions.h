@@ -6,6 +6,8 @@
 //  Copyright 2010 Hortis. All rights reserved.
 //
 
+#import "HLSDigest.h"
+
 // Formatting functions
 NSString *HLSStringFromCATransform3D(CATransform3D transform);
 
@@ -21,9 +23,21 @@ NSString *HLSStringFromCATransform3D(CATransform3D transform);
  */
 - (BOOL)isFilled;
 
+/**
+ * Same as -sizeWithFont: and -sizeWithFont:constrainedToSize:lineBreakMode:, but measurements are cached. The cache
+ * is shared by all strings, and its keys include the font name and size, so that cached measurements never get stale.
+ * It is emptied when memory is low. Use these methods when the same texts are measured repeatedly (e.g. during layout)
+ */
+- (CGSize)cachedSizeWithFont:(UIFont *)font;
+- (CGSize)cachedSizeWithFont:(UIFont *)font constrainedToSize:(CGSize)size lineBreakMode:(UILineBreakMode)lineBreakMode;
+
 /**
  * Given a font, return the largest font size (smaller than font.pointSize and larger than a given minimum size) so that
- * the receiver fits within a given area on a maximum number of lines.
+ * the receiver fits within a given area on a maximum number of lines. Candidate sizes are tried by bisection, and both 
+ * text measurements (see -cachedSizeWithFont:constrainedToSize:lineBreakMode:) and results are cached
+ *
+ * The text measurement methods above can be called from any thread, e.g. to calculate font sizes of table view cells 
+ * in the background
  */
 - (CGFloat)fontSizeWithFont:(UIFont *)font 
           constrainedToSize:(CGSize)size 
@@ -76,6 +90,19 @@ NSString *HLSStringFromCATransform3D(CATransform3D transform);
  */
 - (NSString *)sha512hash;
 
+/**
+ * Calculate the hash of a string (UTF-8) with the given algorithm, as raw bytes (e.g. to be used as binary cache key)
+ */
+- (NSData *)digestDataWithAlgorithm:(HLSDigestAlgorithm)algorithm;
+
+/**
+ * Calculate a fast non-cryptographic 64-bit hash of a string (see HLSFastHash), as is or as a 16-character hexadecimal
+ * lowercase string. The hash is calculated over the UTF-16 characters of the string, directly from its internal storage
+ * when possible. Use it for in-memory cache keys rather than a cryptographic hash, which is far more expensive
+ */
+- (uint64_t)fastHash;
+- (NSString *)fastHexHash;
+
 /**
  * At Hortis, we use a convenient way to identify versions during development, for tags and for official releases:
  *   - For all versions except AppStore releases:         [lastVersionNumber+]versionNumber[+qualifier]
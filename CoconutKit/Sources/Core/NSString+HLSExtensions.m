@@ -8,26 +8,16 @@
 
 #import "NSString+HLSExtensions.h"
 
-#import <CommonCrypto/CommonDigest.h>
 #import "HLSFloat.h"
 #import "HLSLogger.h"
 
-static NSString* digest(NSString *string, unsigned char *(*cc_digest)(const void *, CC_LONG, unsigned char *), CC_LONG digestLength)
-{
-    // Hash calculation
-	unsigned char md[digestLength];     // C99
-    memset(md, 0, sizeof(md));
-    const char *utf8str = [string UTF8String];
-	cc_digest(utf8str, strlen(utf8str), md);
-    
-    // Hexadecimal representation
-    NSMutableString *hexHash = [NSMutableString string];
-    for (NSUInteger i = 0; i < sizeof(md); ++i) {
-        [hexHash appendFormat:@"%02X", md[i]];
-    }
-    
-    return [hexHash lowercaseString];
-}
+// Strings up to this length are copied on the stack when hashed
+#define kStringFastHashStackLength          256
+
+// Function declarations
+static NSCache *textSizeCache(void);
+static NSCache *fontSizeCache(void);
+static BOOL textFitsWithFont(NSString *text, UIFont *font, CGSize size, NSUInteger numberOfLines);
 
 @implementation NSString (HLSExtensions)
 
@@ -43,6 +33,31 @@ static NSString* digest(NSString *string, unsigned char *(*cc_digest)(const void
     return [[self stringByTrimmingWhitespaces] length] != 0;
 }
 
+#pragma mark Text measurement
+
+- (CGSize)cachedSizeWithFont:(UIFont *)font
+{
+    NSString *cacheKey = [NSString stringWithFormat:@"%@_%f_%@", font.fontName, font.pointSize, self];
+    NSValue *sizeValue = [textSizeCache() objectForKey:cacheKey];
+    if (! sizeValue) {
+        sizeValue = [NSValue valueWithCGSize:[self sizeWithFont:font]];
+        [textSizeCache() setObject:sizeValue forKey:cacheKey];
+    }
+    return [sizeValue CGSizeValue];
+}
+
+- (CGSize)cachedSizeWithFont:(UIFont *)font constrainedToSize:(CGSize)size lineBreakMode:(UILineBreakMode)lineBreakMode
+{
+    NSString *cacheKey = [NSString stringWithFormat:@"%@_%f_%@_%d_%@", font.fontName, font.pointSize, NSStringFromCGSize(size),
+                          lineBreakMode, self];
+    NSValue *sizeValue = [textSizeCache() objectForKey:cacheKey];
+    if (! sizeValue) {
+        sizeValue = [NSValue valueWithCGSize:[self sizeWithFont:font constrainedToSize:size lineBreakMode:lineBreakMode]];
+        [textSizeCache() setObject:sizeValue forKey:cacheKey];
+    }
+    return [sizeValue CGSizeValue];
+}
+
 #pragma mark Font size adjustment
 
 // Based on: http://stackoverflow.com/questions/4382976/multiline-uilabel-with-adjustsfontsizetofitwidth
@@ -60,37 +75,40 @@ static NSString* digest(NSString *string, unsigned char *(*cc_digest)(const void
         return font.pointSize;
     }
     
-    CGFloat height = [self sizeWithFont:font
-                      constrainedToSize:CGSizeMake(size.width, FLT_MAX)
-                          lineBreakMode:UILineBreakModeWordWrap].height;
-    
-    // Empty text
-    if (floateq(height, 0.f)) {
-        return font.pointSize;
+    NSString *cacheKey = [NSString stringWithFormat:@"%@_%f_%f_%@_%u_%@", font.fontName, font.pointSize, minFontSize, 
+                          NSStringFromCGSize(size), numberOfLines, self];
+    NSNumber *fontSizeNumber = [fontSizeCache() objectForKey:cacheKey];
+    if (fontSizeNumber) {
+        return [fontSizeNumber floatValue];
     }
     
-    CGFloat lineHeight = [self sizeWithFont:font
-                          constrainedToSize:CGSizeMake(FLT_MAX, FLT_MAX)
-                              lineBreakMode:UILineBreakModeWordWrap].height;
-    
-    // Reduce the font size so that the text fits vertically
-    UIFont *newFont = font;
-    while (floatgt(height, size.height) || floatgt(ceilf(height / lineHeight), numberOfLines)) {
-        if (floatle(newFont.pointSize, minFontSize)) {
-            return minFontSize;
+    CGFloat fontSize = font.pointSize;
+    if (! textFitsWithFont(self, font, size, numberOfLines)) {
+        // Candidate sizes are obtained by decreasing the font size by steps of 1 point, the minimum size being used as 
+        // soon as a candidate is smaller. Since text fits better as the font size decreases, find the first candidate
+        // which fits by bisection. The candidate at index 0 (the original size) does not fit, the candidate at index
+        // nbrSteps (the minimum size) is always accepted
+        NSUInteger nbrSteps = (NSUInteger)ceilf(font.pointSize - minFontSize);
+        if (nbrSteps > 1 && floatle(font.pointSize - (nbrSteps - 1), minFontSize)) {
+            --nbrSteps;
         }
         
-        newFont = [UIFont fontWithName:font.fontName size:newFont.pointSize - 1.f];
-        height = [self sizeWithFont:newFont 
-                  constrainedToSize:CGSizeMake(size.width, FLT_MAX) 
-                      lineBreakMode:UILineBreakModeWordWrap].height;
-        
-        lineHeight = [self sizeWithFont:newFont 
-                      constrainedToSize:CGSizeMake(FLT_MAX, FLT_MAX) 
-                          lineBreakMode:UILineBreakModeWordWrap].height;        
+        NSUInteger lowerIndex = 0;
+        NSUInteger upperIndex = nbrSteps;
+        while (upperIndex - lowerIndex > 1) {
+            NSUInteger index = (lowerIndex + upperIndex) / 2;
+            if (textFitsWithFont(self, [font fontWithSize:font.pointSize - index], size, numberOfLines)) {
+                upperIndex = index;
+            }
+            else {
+                lowerIndex = index;
+            }
+        }
+        fontSize = (upperIndex == nbrSteps) ? minFontSize : font.pointSize - upperIndex;
     }
     
-    return newFont.pointSize;
+    [fontSizeCache() setObject:[NSNumber numberWithFloat:fontSize] forKey:cacheKey];
+    return fontSize;
 }
 
 #pragma mark URL encoding
@@ -110,42 +128,81 @@ static NSString* digest(NSString *string, unsigned char *(*cc_digest)(const void
 
 - (NSString *)md2hash
 {
-    return digest(self, CC_MD2, CC_MD2_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForString:self algorithm:HLSDigestAlgorithmMD2];
 }
 
 - (NSString *)md4hash
 {
-    return digest(self, CC_MD4, CC_MD4_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForString:self algorithm:HLSDigestAlgorithmMD4];
 }
 
 - (NSString *)md5hash
 {
-    return digest(self, CC_MD5, CC_MD5_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForString:self algorithm:HLSDigestAlgorithmMD5];
 }
 
 - (NSString *)sha1hash
 {
-    return digest(self, CC_SHA1, CC_SHA1_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForString:self algorithm:HLSDigestAlgorithmSHA1];
 }
 
 - (NSString *)sha224hash
 {
-    return digest(self, CC_SHA224, CC_SHA224_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForString:self algorithm:HLSDigestAlgorithmSHA224];
 }
 
 - (NSString *)sha256hash
 {
-    return digest(self, CC_SHA256, CC_SHA256_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForString:self algorithm:HLSDigestAlgorithmSHA256];
 }
 
 - (NSString *)sha384hash
 {
-    return digest(self, CC_SHA384, CC_SHA384_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForString:self algorithm:HLSDigestAlgorithmSHA384];
 }
 
 - (NSString *)sha512hash
 {
-    return digest(self, CC_SHA512, CC_SHA512_DIGEST_LENGTH);
+    return [HLSDigest hexDigestForString:self algorithm:HLSDigestAlgorithmSHA512];
+}
+
+- (NSData *)digestDataWithAlgorithm:(HLSDigestAlgorithm)algorithm
+{
+    return [HLSDigest digestDataForString:self algorithm:algorithm];
+}
+
+#pragma mark Fast hash
+
+- (uint64_t)fastHash
+{
+    CFStringRef string = (CFStringRef)self;
+    CFIndex length = CFStringGetLength(string);
+    
+    // Hash the internal storage if the string stores UTF-16 characters
+    const UniChar *characters = CFStringGetCharactersPtr(string);
+    if (characters) {
+        return HLSFastHash(characters, length * sizeof(UniChar), 0);
+    }
+    
+    // Otherwise copy the characters, on the stack for short strings (i.e. most cache keys)
+    UniChar stackCharacters[kStringFastHashStackLength];
+    UniChar *copiedCharacters = (length <= kStringFastHashStackLength) ? stackCharacters : (UniChar *)malloc(length * sizeof(UniChar));
+    if (! copiedCharacters) {
+        HLSLoggerError(@"Could not allocate memory to hash a string");
+        return 0;
+    }
+    
+    CFStringGetCharacters(string, CFRangeMake(0, length), copiedCharacters);
+    uint64_t hash = HLSFastHash(copiedCharacters, length * sizeof(UniChar), 0);
+    if (copiedCharacters != stackCharacters) {
+        free(copiedCharacters);
+    }
+    return hash;
+}
+
+- (NSString *)fastHexHash
+{
+    return [NSString stringWithFormat:@"%016llx", [self fastHash]];
 }
 
 #pragma mark Version strings
@@ -163,3 +220,43 @@ static NSString* digest(NSString *string, unsigned char *(*cc_digest)(const void
 }
 
 @end
+
+#pragma mark Static functions
+
+static NSCache *textSizeCache(void)
+{
+    static NSCache *s_textSizeCache = nil;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        s_textSizeCache = [[NSCache alloc] init];
+    });
+    return s_textSizeCache;
+}
+
+static NSCache *fontSizeCache(void)
+{
+    static NSCache *s_fontSizeCache = nil;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        s_fontSizeCache = [[NSCache alloc] init];
+        [s_fontSizeCache setCountLimit:500];
+    });
+    return s_fontSizeCache;
+}
+
+static BOOL textFitsWithFont(NSString *text, UIFont *font, CGSize size, NSUInteger numberOfLines)
+{
+    CGFloat height = [text cachedSizeWithFont:font
+                            constrainedToSize:CGSizeMake(size.width, FLT_MAX)
+                                lineBreakMode:UILineBreakModeWordWrap].height;
+    
+    // Empty text
+    if (floateq(height, 0.f)) {
+        return YES;
+    }
+    
+    CGFloat lineHeight = [text cachedSizeWithFont:font
+                                constrainedToSize:CGSizeMake(FLT_MAX, FLT_MAX)
+                                    lineBreakMode:UILineBreakModeWordWrap].height;
+    return ! floatgt(height, size.height) && ! floatgt(ceilf(height / lineHeight), numberOfLines);
+}
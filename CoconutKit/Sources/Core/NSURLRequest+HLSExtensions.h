@@ -6,8 +6,26 @@
 //  Copyright (c) 2012 Hortis. All rights reserved.
 //
 
+/**
+ * Besides convenience methods for building requests, this category swizzles -initWithURL:cachePolicy:timeoutInterval: 
+ * to warn about cache policies which are not implemented
+ */
 @interface NSURLRequest (HLSExtensions)
 
-// Private class used for method swizzling
+/**
+ * Return the query string (without leading question mark) for a dictionary of parameters. Values which are not strings
+ * are converted using -description. Keys and values are percent encoded as UTF-8 (RFC 3986, same result as
+ * -[NSString urlEncodedStringUsingEncoding:]), and parameters are sorted by key so that the same parameters always 
+ * yield the same query string
+ *
+ * The whole query string is encoded into a single buffer using a lookup table, and the resulting string takes over 
+ * this buffer. Prefer this method to encoding each parameter separately when building URLs with many parameters
+ */
++ (NSString *)queryStringWithParameters:(NSDictionary *)parameters;
+
+/**
+ * Return a request for a URL, with the given parameters appended to its query string (see +queryStringWithParameters:)
+ */
++ (id)requestWithURL:(NSURL *)url queryParameters:(NSDictionary *)parameters;
 
 @end
@@ -11,6 +11,26 @@
 #import "HLSLogger.h"
 #import "HLSRuntime.h"
 
+// Characters which are not percent encoded in query strings (RFC 3986 unreserved characters)
+static const BOOL kUnreservedCharacters[256] = {
+    ['0' ... '9'] = YES,
+    ['A' ... 'Z'] = YES,
+    ['a' ... 'z'] = YES,
+    ['-'] = YES,
+    ['.'] = YES,
+    ['_'] = YES,
+    ['~'] = YES
+};
+
+// Size of the buffer on the stack into which parameters are converted to UTF-8 before being encoded. Larger parameters
+// are converted into a buffer allocated on the heap
+static const NSUInteger kQueryStringStackBufferLength = 1024;
+
+// Function declarations
+static NSString *stringFromParameterObject(id object);
+static const char *getUTF8Bytes(NSString *string, char *buffer, NSUInteger bufferLength, NSUInteger *pLength);
+static char *appendPercentEncodedBytes(char *output, const char *bytes, NSUInteger length);
+
 // Original implementation of the methods we swizzle
 static id (*s_NSURLRequest__initWithURL_cachePolicy_timeoutInterval_Imp)(id, SEL, id, NSURLRequestCachePolicy, NSTimeInterval) = NULL;
 
@@ -26,8 +46,123 @@ static id swizzled_NSURLRequest__initWithURL_cachePolicy_timeoutInterval_Imp(NSU
                                                                                                                                                    (IMP)swizzled_NSURLRequest__initWithURL_cachePolicy_timeoutInterval_Imp);
 }
 
+#pragma mark Query strings
+
++ (NSString *)queryStringWithParameters:(NSDictionary *)parameters
+{
+    NSUInteger nbrParameters = [parameters count];
+    if (nbrParameters == 0) {
+        return @"";
+    }
+    
+    NSArray *keys = [[parameters allKeys] sortedArrayUsingComparator:^(id key1, id key2) {
+        return [stringFromParameterObject(key1) compare:stringFromParameterObject(key2)];
+    }];
+    
+    // Collect keys and values as strings, and calculate an upper bound for the length of the query string and
+    // of a parameter converted to UTF-8
+    NSString *strings[2 * nbrParameters];       // C99
+    NSUInteger maxLength = 0;
+    NSUInteger maxQueryStringLength = 2 * nbrParameters - 1;            // '=' and '&' separators
+    for (NSUInteger i = 0; i < nbrParameters; ++i) {
+        id key = [keys objectAtIndex:i];
+        strings[2 * i] = stringFromParameterObject(key);
+        strings[2 * i + 1] = stringFromParameterObject([parameters objectForKey:key]);
+        
+        for (NSUInteger j = 2 * i; j <= 2 * i + 1; ++j) {
+            NSUInteger length = [strings[j] maximumLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+            maxLength = MAX(maxLength, length);
+            maxQueryStringLength += 3 * length;                         // Each byte is encoded as %XX at worst
+        }
+    }
+    
+    char stackBuffer[kQueryStringStackBufferLength];
+    char *buffer = (maxLength <= sizeof(stackBuffer)) ? stackBuffer : malloc(maxLength);
+    char *queryString = malloc(maxQueryStringLength);
+    char *output = queryString;
+    for (NSUInteger j = 0; j < 2 * nbrParameters; ++j) {
+        if (j != 0) {
+            *output++ = (j % 2 == 0) ? '&' : '=';
+        }
+        
+        NSUInteger length = 0;
+        const char *bytes = getUTF8Bytes(strings[j], buffer, maxLength, &length);
+        output = appendPercentEncodedBytes(output, bytes, length);
+    }
+    
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+    
+    // The string takes ownership of the buffer
+    return [[[NSString alloc] initWithBytesNoCopy:queryString
+                                           length:(NSUInteger)(output - queryString)
+                                         encoding:NSASCIIStringEncoding
+                                     freeWhenDone:YES] autorelease];
+}
+
+#pragma mark Creating requests
+
++ (id)requestWithURL:(NSURL *)url queryParameters:(NSDictionary *)parameters
+{
+    if ([parameters count] == 0) {
+        return [self requestWithURL:url];
+    }
+    
+    NSString *separator = [url query] ? @"&" : @"?";
+    NSString *urlString = [NSString stringWithFormat:@"%@%@%@", [url absoluteString], separator, 
+                           [self queryStringWithParameters:parameters]];
+    return [self requestWithURL:[NSURL URLWithString:urlString]];
+}
+
 @end
 
+#pragma mark Query string functions
+
+static NSString *stringFromParameterObject(id object)
+{
+    return [object isKindOfClass:[NSString class]] ? object : [object description];
+}
+
+// Return the UTF-8 bytes of a string, either directly from the string if available, or converted into the buffer
+// received as parameter
+static const char *getUTF8Bytes(NSString *string, char *buffer, NSUInteger bufferLength, NSUInteger *pLength)
+{
+    // ASCII strings can often be accessed directly, their length in bytes is then their number of characters
+    const char *asciiString = CFStringGetCStringPtr((CFStringRef)string, kCFStringEncodingUTF8);
+    if (asciiString) {
+        *pLength = [string length];
+        return asciiString;
+    }
+    
+    [string getBytes:buffer
+           maxLength:bufferLength
+          usedLength:pLength
+            encoding:NSUTF8StringEncoding
+             options:0
+               range:NSMakeRange(0, [string length])
+      remainingRange:NULL];
+    return buffer;
+}
+
+static char *appendPercentEncodedBytes(char *output, const char *bytes, NSUInteger length)
+{
+    static const char kHexDigits[] = "0123456789ABCDEF";
+    
+    for (NSUInteger i = 0; i < length; ++i) {
+        unsigned char byte = (unsigned char)bytes[i];
+        if (kUnreservedCharacters[byte]) {
+            *output++ = (char)byte;
+        }
+        else {
+            *output++ = '%';
+            *output++ = kHexDigits[byte >> 4];
+            *output++ = kHexDigits[byte & 0x0f];
+        }
+    }
+    return output;
+}
+
 #pragma mark Swizzled method implementations
 
 static id swizzled_NSURLRequest__initWithURL_cachePolicy_timeoutInterval_Imp(NSURLRequest *self, SEL _cmd, NSURL *url, NSURLRequestCachePolicy cachePolicy, NSTimeInterval timeoutInterval)
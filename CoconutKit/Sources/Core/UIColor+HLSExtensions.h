@@ -6,6 +6,40 @@
 //  Copyright 2011 Hortis. All rights reserved.
 //
 
+/**
+ * Packed 32-bit RGBA color (8 bits per component, not premultiplied). Use this value type instead of UIColor when 
+ * many colors have to be computed (e.g. for gradients or heat maps), and convert to UIColor only when needed
+ */
+typedef struct {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint8_t alpha;
+} HLSRGBAColor;
+
+/**
+ * Create a packed color from its components (0 - 255)
+ */
+HLSRGBAColor HLSRGBAColorMake(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha);
+
+/**
+ * Return YES iff two packed colors are equal
+ */
+BOOL HLSRGBAColorEqualToColor(HLSRGBAColor color1, HLSRGBAColor color2);
+
+/**
+ * Blend colors one by one, i.e. results[i] = (1 - fraction) * colors1[i] + fraction * colors2[i] for each component 
+ * (including alpha). The fraction is clamped to [0; 1]. The results array can be one of the source arrays. Vector
+ * instructions are used when available
+ */
+void HLSRGBAColorsBlend(const HLSRGBAColor *colors1, const HLSRGBAColor *colors2, CGFloat fraction, HLSRGBAColor *results, NSUInteger count);
+
+/**
+ * Invert colors (the alpha component is kept). The results array can be the source array. Vector instructions are
+ * used when available
+ */
+void HLSRGBAColorsInvert(const HLSRGBAColor *colors, HLSRGBAColor *results, NSUInteger count);
+
 @interface UIColor (HLSExtensions)
 
 /**
@@ -13,6 +47,18 @@
  */
 + (UIColor *)randomColor;
 
+/**
+ * Return the color corresponding to a packed color. Recently used colors are cached, so that no new color is created
+ * when the same packed color is converted again. This method can be called from any thread
+ */
++ (UIColor *)colorWithRGBAColor:(HLSRGBAColor)rgbaColor;
+
+/**
+ * Return the packed color corresponding to the receiver. Colors in the RGB and grayscale color spaces are supported
+ * (other colors, e.g. pattern colors, yield transparent black)
+ */
+- (HLSRGBAColor)RGBAColor;
+
 /**
  * Return the ivert color corresponding to the receiver
  */
@@ -8,6 +8,102 @@
 
 #import "UIColor+HLSExtensions.h"
 
+#import <libkern/OSAtomic.h>
+
+#if defined(__ARM_NEON__)
+#import <arm_neon.h>
+#endif
+
+// Number of entries of the cache of UIColor objects (a power of 2)
+#define kColorCacheSize                 256
+
+/**
+ * Entry of the direct-mapped cache of UIColor objects
+ */
+typedef struct {
+    uint32_t packedValue;
+    UIColor *color;                     // retained
+} HLSColorCacheEntry;
+
+static HLSColorCacheEntry s_colorCacheEntries[kColorCacheSize];
+static OSSpinLock s_colorCacheLock = OS_SPINLOCK_INIT;
+
+// Function declarations
+static uint32_t packedValueFromRGBAColor(HLSRGBAColor rgbaColor);
+static BOOL getNormalizedComponents(UIColor *color, CGFloat *pRed, CGFloat *pGreen, CGFloat *pBlue, CGFloat *pAlpha);
+static uint8_t componentFromNormalizedComponent(CGFloat normalizedComponent);
+
+#pragma mark -
+#pragma mark Packed colors
+
+HLSRGBAColor HLSRGBAColorMake(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha)
+{
+    HLSRGBAColor rgbaColor = { red, green, blue, alpha };
+    return rgbaColor;
+}
+
+BOOL HLSRGBAColorEqualToColor(HLSRGBAColor color1, HLSRGBAColor color2)
+{
+    return packedValueFromRGBAColor(color1) == packedValueFromRGBAColor(color2);
+}
+
+void HLSRGBAColorsBlend(const HLSRGBAColor *colors1, const HLSRGBAColor *colors2, CGFloat fraction, HLSRGBAColor *results, NSUInteger count)
+{
+    // Weights out of 256, so that divisions are replaced by shifts
+    uint16_t weight2 = (uint16_t)roundf(256.f * MIN(MAX(fraction, 0.f), 1.f));
+    uint16_t weight1 = 256 - weight2;
+    
+    const uint8_t *bytes1 = (const uint8_t *)colors1;
+    const uint8_t *bytes2 = (const uint8_t *)colors2;
+    uint8_t *resultBytes = (uint8_t *)results;
+    NSUInteger byteCount = 4 * count;
+    NSUInteger i = 0;
+    
+#if defined(__ARM_NEON__)
+    // 4 colors at a time. The weights are at most 256, which does not fit into 8 bits: the extreme cases are simple copies
+    if (weight2 == 0 || weight2 == 256) {
+        memmove(resultBytes, (weight2 == 0) ? bytes1 : bytes2, byteCount);
+        return;
+    }
+    
+    uint8x8_t weight1Vector = vdup_n_u8((uint8_t)weight1);
+    uint8x8_t weight2Vector = vdup_n_u8((uint8_t)weight2);
+    for (; i + 16 <= byteCount; i += 16) {
+        uint8x16_t vector1 = vld1q_u8(bytes1 + i);
+        uint8x16_t vector2 = vld1q_u8(bytes2 + i);
+        uint16x8_t lowSum = vmlal_u8(vmull_u8(vget_low_u8(vector1), weight1Vector), vget_low_u8(vector2), weight2Vector);
+        uint16x8_t highSum = vmlal_u8(vmull_u8(vget_high_u8(vector1), weight1Vector), vget_high_u8(vector2), weight2Vector);
+        vst1q_u8(resultBytes + i, vcombine_u8(vrshrn_n_u16(lowSum, 8), vrshrn_n_u16(highSum, 8)));
+    }
+#endif
+    
+    for (; i < byteCount; ++i) {
+        resultBytes[i] = (uint8_t)((bytes1[i] * weight1 + bytes2[i] * weight2 + 128) >> 8);
+    }
+}
+
+void HLSRGBAColorsInvert(const HLSRGBAColor *colors, HLSRGBAColor *results, NSUInteger count)
+{
+    NSUInteger i = 0;
+    
+#if defined(__ARM_NEON__)
+    // 4 colors at a time: The color components are flipped, the alpha is kept
+    static const uint8_t s_maskBytes[16] = { 255, 255, 255, 0, 255, 255, 255, 0, 255, 255, 255, 0, 255, 255, 255, 0 };
+    uint8x16_t mask = vld1q_u8(s_maskBytes);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u8((uint8_t *)(results + i), veorq_u8(vld1q_u8((const uint8_t *)(colors + i)), mask));
+    }
+#endif
+    
+    for (; i < count; ++i) {
+        HLSRGBAColor color = colors[i];
+        results[i] = HLSRGBAColorMake(255 - color.red, 255 - color.green, 255 - color.blue, color.alpha);
+    }
+}
+
+#pragma mark -
+#pragma mark UIColor extensions
+
 @implementation UIColor (HLSExtensions)
 
 + (UIColor *)randomColor
@@ -18,14 +114,59 @@
                            alpha:1.f];
 }
 
++ (UIColor *)colorWithRGBAColor:(HLSRGBAColor)rgbaColor
+{
+    uint32_t packedValue = packedValueFromRGBAColor(rgbaColor);
+    
+    // Fold the packed value to get the index of the cache entry
+    uint32_t index = (packedValue ^ (packedValue >> 8) ^ (packedValue >> 16) ^ (packedValue >> 24)) & (kColorCacheSize - 1);
+    HLSColorCacheEntry *pEntry = &s_colorCacheEntries[index];
+    
+    OSSpinLockLock(&s_colorCacheLock);
+    UIColor *color = (pEntry->color && pEntry->packedValue == packedValue) ? [[pEntry->color retain] autorelease] : nil;
+    OSSpinLockUnlock(&s_colorCacheLock);
+    if (color) {
+        return color;
+    }
+    
+    color = [UIColor colorWithRed:rgbaColor.red / 255.f
+                            green:rgbaColor.green / 255.f
+                             blue:rgbaColor.blue / 255.f
+                            alpha:rgbaColor.alpha / 255.f];
+    
+    // The replaced color is released outside the lock
+    OSSpinLockLock(&s_colorCacheLock);
+    UIColor *replacedColor = pEntry->color;
+    pEntry->color = [color retain];
+    pEntry->packedValue = packedValue;
+    OSSpinLockUnlock(&s_colorCacheLock);
+    [replacedColor release];
+    
+    return color;
+}
+
+- (HLSRGBAColor)RGBAColor
+{
+    CGFloat red = 0.f, green = 0.f, blue = 0.f, alpha = 0.f;
+    if (! getNormalizedComponents(self, &red, &green, &blue, &alpha)) {
+        return HLSRGBAColorMake(0, 0, 0, 0);
+    }
+    
+    return HLSRGBAColorMake(componentFromNormalizedComponent(red), 
+                            componentFromNormalizedComponent(green), 
+                            componentFromNormalizedComponent(blue), 
+                            componentFromNormalizedComponent(alpha));
+}
+
 - (UIColor *)invertedColor
 {
-    const CGFloat *components = CGColorGetComponents(self.CGColor);
+    CGFloat red = 0.f, green = 0.f, blue = 0.f, alpha = 0.f;
+    getNormalizedComponents(self, &red, &green, &blue, &alpha);
     
-    UIColor *invertedColor = [[[UIColor alloc] initWithRed:1.f - components[0]
-                                                   green:1.f - components[1]
-                                                    blue:1.f - components[2]
-                                                   alpha:components[3]] autorelease];
+    UIColor *invertedColor = [[[UIColor alloc] initWithRed:1.f - red
+                                                   green:1.f - green
+                                                    blue:1.f - blue
+                                                   alpha:alpha] autorelease];
     
     return invertedColor;
 }
@@ -49,20 +190,81 @@
 
 - (CGFloat)normalizedRedComponent
 {
-    const CGFloat *components = CGColorGetComponents(self.CGColor);
-    return components[0];
+    CGFloat red = 0.f;
+    getNormalizedComponents(self, &red, NULL, NULL, NULL);
+    return red;
 }
 
 - (CGFloat)normalizedGreenComponent
 {
-    const CGFloat *components = CGColorGetComponents(self.CGColor);
-    return components[1];
+    CGFloat green = 0.f;
+    getNormalizedComponents(self, NULL, &green, NULL, NULL);
+    return green;
 }
 
 - (CGFloat)normalizedBlueComponent
 {
-    const CGFloat *components = CGColorGetComponents(self.CGColor);
-    return components[2];
+    CGFloat blue = 0.f;
+    getNormalizedComponents(self, NULL, NULL, &blue, NULL);
+    return blue;
 }
 
 @end
+
+#pragma mark Static functions
+
+static uint32_t packedValueFromRGBAColor(HLSRGBAColor rgbaColor)
+{
+    uint32_t packedValue = 0;
+    memcpy(&packedValue, &rgbaColor, sizeof(uint32_t));
+    return packedValue;
+}
+
+// Read all components at once, whatever the color space (RGB or grayscale). Output pointers can be NULL. Return NO 
+// if the color space is not supported
+static BOOL getNormalizedComponents(UIColor *color, CGFloat *pRed, CGFloat *pGreen, CGFloat *pBlue, CGFloat *pAlpha)
+{
+    CGColorRef colorRef = color.CGColor;
+    const CGFloat *components = CGColorGetComponents(colorRef);
+    CGFloat red = 0.f, green = 0.f, blue = 0.f, alpha = 0.f;
+    BOOL supported = YES;
+    switch (CGColorSpaceGetModel(CGColorGetColorSpace(colorRef))) {
+        case kCGColorSpaceModelRGB: {
+            red = components[0];
+            green = components[1];
+            blue = components[2];
+            alpha = components[3];
+            break;
+        }
+            
+        case kCGColorSpaceModelMonochrome: {
+            red = green = blue = components[0];
+            alpha = components[1];
+            break;
+        }
+            
+        default: {
+            supported = NO;
+            break;
+        }
+    }
+    
+    if (pRed) {
+        *pRed = red;
+    }
+    if (pGreen) {
+        *pGreen = green;
+    }
+    if (pBlue) {
+        *pBlue = blue;
+    }
+    if (pAlpha) {
+        *pAlpha = alpha;
+    }
+    return supported;
+}
+
+static uint8_t componentFromNormalizedComponent(CGFloat normalizedComponent)
+{
+    return (uint8_t)roundf(255.f * MIN(MAX(normalizedComponent, 0.f), 1.f));
+}
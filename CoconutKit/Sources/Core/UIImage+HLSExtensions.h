@@ -9,19 +9,62 @@
 @interface UIImage (HLSExtensions)
 
 /**
- * Return a 1x1 px image having a given color
+ * Return a 1x1 px image having a given color. Images are cached, so that the same image (and bitmap) is returned for 
+ * equal colors. This method can be called from any thread
  */
 + (UIImage *)imageWithColor:(UIColor *)color;
 
+/**
+ * Load the image stored in a file, downsampled so that its width and height do not exceed maximumPixelSize (the image
+ * is never larger than the original one). Using ImageIO, the image is directly decoded at the target size, without
+ * the full image being decoded first, which saves a lot of time and memory for large images (e.g. photos). The 
+ * orientation stored in the file (e.g. the EXIF orientation of a photo) is applied to the pixels of the returned image.
+ * The scale of the returned image is set to the specified value (use [UIScreen mainScreen].scale for an image displayed
+ * pixel per pixel on screen)
+ *
+ * Return nil if the image cannot be loaded or if maximumPixelSize is 0. This method can be called from any thread
+ */
++ (UIImage *)imageWithContentsOfFile:(NSString *)filePath maximumPixelSize:(NSUInteger)maximumPixelSize scale:(CGFloat)scale;
+
+/**
+ * Return the dimensions in pixels of the image stored in a file, read from the file properties without loading the
+ * image. The orientation stored in the file is taken into account, i.e. the size is the one of the image in its
+ * intended orientation
+ *
+ * Return CGSizeZero if the file does not exist or is not a valid image. This method can be called from any thread
+ */
++ (CGSize)pixelSizeOfImageWithContentsOfFile:(NSString *)filePath;
+
 /**
  * Return the receiver masked with some image. Black mask pixels correspond to unmasked portions. To make parts of
- * the mask transparent, use pixels between black (opaque) and white (transparent), not an alpha
+ * the mask transparent, use pixels between black (opaque) and white (transparent), not an alpha. This method can be
+ * called from any thread
  */
 - (UIImage *)imageMaskedWithImage:(UIImage *)maskImage;
 
 /**
- * Return the image scaled to fill the specified size. The image will be stretched as needed
+ * Return the image scaled to fill the specified size. The image will be stretched as needed. When available (iOS 5 
+ * and above), vImage is used to scale the image, otherwise Core Graphics. This method can be called from any thread
  */
 - (UIImage *)imageScaledToSize:(CGSize)size;
 
+/**
+ * Scale several images at once, as -imageScaledToSize: does. Images are processed in parallel, and each processor core 
+ * reuses the same scratch buffers for all images it scales. Images which could not be scaled are replaced with NSNull
+ * in the returned array
+ *
+ * This method returns when all images have been scaled. Call it from a background queue to create thumbnails for many
+ * images (e.g. a whole photo album) without blocking the main thread
+ */
++ (NSArray *)imagesByScalingImages:(NSArray *)images toSize:(CGSize)size;
+
+/**
+ * Same as -imageScaledToSize:, but the scaled image is stored in the shared image cache (see HLSImageCache) under a key
+ * made of the cache key and of the size. If a scaled image is found in the cache for this key, it is returned without
+ * being generated again. The cache key must therefore uniquely identify the receiver (e.g. its name or path)
+ *
+ * If cacheKey is nil, this method behaves like -imageScaledToSize:
+ */
+- (UIImage *)imageScaledToSize:(CGSize)size cacheKey:(NSString *)cacheKey;
+
 @end
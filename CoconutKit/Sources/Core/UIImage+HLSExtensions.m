@@ -8,24 +8,182 @@
 
 #import "UIImage+HLSExtensions.h"
 
+#import <Accelerate/Accelerate.h>
+#import <ImageIO/ImageIO.h>
+#import "HLSAssert.h"
+#import "HLSImageCache.h"
+#import "HLSLogger.h"
+
+// Premultiplied ARGB pixels, the format vImage scaling works with
+static const CGBitmapInfo kImageBitmapInfo = kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little;
+
+/**
+ * Buffers reused when scaling several images in a row. Each buffer only grows when an image needs more room
+ */
+typedef struct {
+    void *sourceData;
+    size_t sourceCapacity;
+    void *destinationData;
+    size_t destinationCapacity;
+    void *temporaryData;
+    size_t temporaryCapacity;
+} HLSImageScratchBuffers;
+
+// Function declarations
+static BOOL reserveScratchBuffer(void **pData, size_t *pCapacity, size_t size);
+static void freeScratchBuffers(HLSImageScratchBuffers *pScratchBuffers);
+static BOOL drawImageInBitmap(CGImageRef imageRef, void *data, size_t width, size_t height, size_t bytesPerRow, CGColorSpaceRef colorSpace);
+static UIImage *imageWithBitmap(void *data, size_t width, size_t height, size_t bytesPerRow, CGColorSpaceRef colorSpace);
+static UIImage *scaledImage(UIImage *image, CGSize size, HLSImageScratchBuffers *pScratchBuffers);
+
+@interface UIImage (HLSExtensionsPrivate)
+
++ (NSCache *)colorImagesCache;
+
+@end
+
 @implementation UIImage (HLSExtensions)
 
++ (NSCache *)colorImagesCache
+{
+    // NSCache is thread-safe. Its creation must be as well, since images with color can be created from any thread
+    static NSCache *s_colorImagesCache = nil;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        s_colorImagesCache = [[NSCache alloc] init];
+        s_colorImagesCache.countLimit = 256;
+    });
+    return s_colorImagesCache;
+}
+
 + (UIImage *)imageWithColor:(UIColor *)color
 {
-    CGRect rect = CGRectMake(0.0f, 0.0f, 1.0f, 1.0f);
+    if (! color) {
+        return nil;
+    }
     
-    UIGraphicsBeginImageContext(rect.size);
+    NSCache *colorImagesCache = [self colorImagesCache];
+    UIImage *image = [colorImagesCache objectForKey:color];
+    if (image) {
+        return image;
+    }
+    
+    // Draw with Core Graphics only, so that this method can be called from any thread
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, 1, 1, 8, 4, colorSpace, kImageBitmapInfo);
+    CGColorSpaceRelease(colorSpace);
+    if (! context) {
+        return nil;
+    }
     
-    CGContextRef context = UIGraphicsGetCurrentContext();
     CGContextSetFillColorWithColor(context, color.CGColor);
-    CGContextFillRect(context, rect);
+    CGContextFillRect(context, CGRectMake(0.f, 0.f, 1.f, 1.f));
+    
+    CGImageRef imageRef = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    
+    image = [UIImage imageWithCGImage:imageRef];
+    CGImageRelease(imageRef);
+    
+    [colorImagesCache setObject:image forKey:color];
+    return image;
+}
     
-    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
++ (NSArray *)imagesByScalingImages:(NSArray *)images toSize:(CGSize)size
+{
+    HLSAssertObjectsInEnumerationAreKindOfClass(images, UIImage);
+    
+    NSUInteger numberOfImages = [images count];
+    if (numberOfImages == 0) {
+        return [NSArray array];
+    }
+    
+    // One worker per processor core, each one with its own scratch buffers
+    NSUInteger numberOfWorkers = MIN(MAX([[NSProcessInfo processInfo] activeProcessorCount], 1), numberOfImages);
+    UIImage **scaledImages = (UIImage **)calloc(numberOfImages, sizeof(UIImage *));
+    dispatch_apply(numberOfWorkers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^(size_t worker) {
+        HLSImageScratchBuffers scratchBuffers;
+        memset(&scratchBuffers, 0, sizeof(HLSImageScratchBuffers));
+        
+        for (NSUInteger i = worker; i < numberOfImages; i += numberOfWorkers) {
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            scaledImages[i] = [scaledImage([images objectAtIndex:i], size, &scratchBuffers) retain];
+            [pool drain];
+        }
+        
+        freeScratchBuffers(&scratchBuffers);
+    });
+    
+    NSMutableArray *scaledImagesArray = [NSMutableArray arrayWithCapacity:numberOfImages];
+    for (NSUInteger i = 0; i < numberOfImages; ++i) {
+        if (scaledImages[i]) {
+            [scaledImagesArray addObject:scaledImages[i]];
+            [scaledImages[i] release];
+        }
+        else {
+            [scaledImagesArray addObject:[NSNull null]];
+        }
+    }
+    free(scaledImages);
+    
+    return [NSArray arrayWithArray:scaledImagesArray];
+}
+
++ (UIImage *)imageWithContentsOfFile:(NSString *)filePath maximumPixelSize:(NSUInteger)maximumPixelSize scale:(CGFloat)scale
+{
+    if (maximumPixelSize == 0) {
+        HLSLoggerError(@"The maximum pixel size must be > 0");
+        return nil;
+    }
+    
+    CGImageSourceRef imageSource = CGImageSourceCreateWithURL((CFURLRef)[NSURL fileURLWithPath:filePath], NULL);
+    if (! imageSource) {
+        return nil;
+    }
     
-    UIGraphicsEndImageContext();
+    // Thumbnails are always created from the full image (and not from a thumbnail possibly embedded in the file, which 
+    // might be too small)
+    NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:(id)kCFBooleanTrue, (NSString *)kCGImageSourceCreateThumbnailFromImageAlways,
+                             (id)kCFBooleanTrue, (NSString *)kCGImageSourceCreateThumbnailWithTransform,
+                             [NSNumber numberWithUnsignedInteger:maximumPixelSize], (NSString *)kCGImageSourceThumbnailMaxPixelSize,
+                             nil];
+    CGImageRef imageRef = CGImageSourceCreateThumbnailAtIndex(imageSource, 0, (CFDictionaryRef)options);
+    CFRelease(imageSource);
+    if (! imageRef) {
+        return nil;
+    }
+    
+    UIImage *image = [UIImage imageWithCGImage:imageRef scale:scale orientation:UIImageOrientationUp];
+    CGImageRelease(imageRef);
     return image;
 }
 
++ (CGSize)pixelSizeOfImageWithContentsOfFile:(NSString *)filePath
+{
+    CGImageSourceRef imageSource = CGImageSourceCreateWithURL((CFURLRef)[NSURL fileURLWithPath:filePath], NULL);
+    if (! imageSource) {
+        return CGSizeZero;
+    }
+    
+    NSDictionary *properties = [(NSDictionary *)CGImageSourceCopyPropertiesAtIndex(imageSource, 0, NULL) autorelease];
+    CFRelease(imageSource);
+    
+    NSNumber *width = [properties objectForKey:(NSString *)kCGImagePropertyPixelWidth];
+    NSNumber *height = [properties objectForKey:(NSString *)kCGImagePropertyPixelHeight];
+    if (! width || ! height) {
+        return CGSizeZero;
+    }
+    
+    // EXIF orientations 5 to 8 rotate the image by 90 degrees
+    NSInteger orientation = [[properties objectForKey:(NSString *)kCGImagePropertyOrientation] integerValue];
+    if (orientation >= 5 && orientation <= 8) {
+        return CGSizeMake([height floatValue], [width floatValue]);
+    }
+    else {
+        return CGSizeMake([width floatValue], [height floatValue]);
+    }
+}
+
 - (UIImage *)imageMaskedWithImage:(UIImage *)maskImage
 {
 	CGImageRef maskImageRef = CGImageMaskCreate(CGImageGetWidth(maskImage.CGImage),
@@ -48,11 +206,159 @@
 
 - (UIImage *)imageScaledToSize:(CGSize)size
 {
-    UIGraphicsBeginImageContext(size);
-    [self drawInRect:CGRectMake(0.f, 0.f, size.width, size.height)];
-    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
-    UIGraphicsEndImageContext();
+    HLSImageScratchBuffers scratchBuffers;
+    memset(&scratchBuffers, 0, sizeof(HLSImageScratchBuffers));
+    
+    UIImage *image = scaledImage(self, size, &scratchBuffers);
+    
+    freeScratchBuffers(&scratchBuffers);
+    return image;
+}
+
+- (UIImage *)imageScaledToSize:(CGSize)size cacheKey:(NSString *)cacheKey
+{
+    if (! cacheKey) {
+        return [self imageScaledToSize:size];
+    }
+    
+    HLSImageCache *imageCache = [HLSImageCache sharedImageCache];
+    NSString *scaledImageKey = [NSString stringWithFormat:@"%@_%@", cacheKey, NSStringFromCGSize(size)];
+    UIImage *image = [imageCache imageForKey:scaledImageKey];
+    if (! image) {
+        image = [self imageScaledToSize:size];
+        [imageCache setImage:image forKey:scaledImageKey];
+    }
     return image;
 }
 
 @end
+
+
+#pragma mark Static functions
+
+// Ensure a scratch buffer can contain at least size bytes. Its content is lost if it has to grow
+static BOOL reserveScratchBuffer(void **pData, size_t *pCapacity, size_t size)
+{
+    if (size <= *pCapacity) {
+        return YES;
+    }
+    
+    free(*pData);
+    *pData = malloc(size);
+    if (! *pData) {
+        HLSLoggerError(@"Could not allocate a %lu byte buffer", (unsigned long)size);
+        *pCapacity = 0;
+        return NO;
+    }
+    *pCapacity = size;
+    return YES;
+}
+
+static void freeScratchBuffers(HLSImageScratchBuffers *pScratchBuffers)
+{
+    free(pScratchBuffers->sourceData);
+    free(pScratchBuffers->destinationData);
+    free(pScratchBuffers->temporaryData);
+    memset(pScratchBuffers, 0, sizeof(HLSImageScratchBuffers));
+}
+
+// Draw an image so that it fills a bitmap with premultiplied ARGB pixels, whatever the original image format
+static BOOL drawImageInBitmap(CGImageRef imageRef, void *data, size_t width, size_t height, size_t bytesPerRow, CGColorSpaceRef colorSpace)
+{
+    CGContextRef context = CGBitmapContextCreate(data, width, height, 8, bytesPerRow, colorSpace, kImageBitmapInfo);
+    if (! context) {
+        return NO;
+    }
+    
+    // Scratch buffers are reused. Replace their previous content instead of blending with it
+    CGContextSetBlendMode(context, kCGBlendModeCopy);
+    CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+    CGContextDrawImage(context, CGRectMake(0.f, 0.f, width, height), imageRef);
+    CGContextRelease(context);
+    return YES;
+}
+
+// Create an image from a copy of the pixels of a bitmap with premultiplied ARGB pixels (the bitmap can therefore be
+// reused afterwards)
+static UIImage *imageWithBitmap(void *data, size_t width, size_t height, size_t bytesPerRow, CGColorSpaceRef colorSpace)
+{
+    CFDataRef bitmapData = CFDataCreate(NULL, (const UInt8 *)data, bytesPerRow * height);
+    CGDataProviderRef dataProvider = CGDataProviderCreateWithCFData(bitmapData);
+    CFRelease(bitmapData);
+    
+    CGImageRef imageRef = CGImageCreate(width, height, 8, 32, bytesPerRow, colorSpace, kImageBitmapInfo, dataProvider, NULL, false,
+                                        kCGRenderingIntentDefault);
+    CGDataProviderRelease(dataProvider);
+    if (! imageRef) {
+        return nil;
+    }
+    
+    UIImage *image = [UIImage imageWithCGImage:imageRef];
+    CGImageRelease(imageRef);
+    return image;
+}
+
+static UIImage *scaledImage(UIImage *image, CGSize size, HLSImageScratchBuffers *pScratchBuffers)
+{
+    size_t width = (size_t)ceilf(size.width);
+    size_t height = (size_t)ceilf(size.height);
+    if (width == 0 || height == 0) {
+        HLSLoggerError(@"The size must not be empty");
+        return nil;
+    }
+    
+    // Core Graphics ignores the image orientation. Let UIKit apply it (UIKit image contexts can be used from any
+    // thread since iOS 4)
+    CGImageRef imageRef = image.CGImage;
+    if (! imageRef || image.imageOrientation != UIImageOrientationUp) {
+        UIGraphicsBeginImageContext(size);
+        [image drawInRect:CGRectMake(0.f, 0.f, size.width, size.height)];
+        UIImage *resultImage = UIGraphicsGetImageFromCurrentImageContext();
+        UIGraphicsEndImageContext();
+        return resultImage;
+    }
+    
+    size_t bytesPerRow = 4 * width;
+    if (! reserveScratchBuffer(&pScratchBuffers->destinationData, &pScratchBuffers->destinationCapacity, bytesPerRow * height)) {
+        return nil;
+    }
+    
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    BOOL scaled = NO;
+    
+    // vImage is available since iOS 5. It scales premultiplied pixels, the source image is therefore first drawn
+    // into a premultiplied bitmap
+    if (vImageScale_ARGB8888 != NULL) {
+        size_t sourceWidth = CGImageGetWidth(imageRef);
+        size_t sourceHeight = CGImageGetHeight(imageRef);
+        size_t sourceBytesPerRow = 4 * sourceWidth;
+        if (reserveScratchBuffer(&pScratchBuffers->sourceData, &pScratchBuffers->sourceCapacity, sourceBytesPerRow * sourceHeight)
+                && drawImageInBitmap(imageRef, pScratchBuffers->sourceData, sourceWidth, sourceHeight, sourceBytesPerRow, colorSpace)) {
+            vImage_Buffer sourceBuffer = { pScratchBuffers->sourceData, sourceHeight, sourceWidth, sourceBytesPerRow };
+            vImage_Buffer destinationBuffer = { pScratchBuffers->destinationData, height, width, bytesPerRow };
+            
+            // Provide the temporary buffer so that vImage does not allocate one for each image
+            vImage_Error temporaryBufferSize = vImageScale_ARGB8888(&sourceBuffer, &destinationBuffer, NULL,
+                                                                    kvImageHighQualityResampling | kvImageGetTempBufferSize);
+            if (temporaryBufferSize >= 0
+                    && reserveScratchBuffer(&pScratchBuffers->temporaryData, &pScratchBuffers->temporaryCapacity, (size_t)temporaryBufferSize)) {
+                vImage_Error error = vImageScale_ARGB8888(&sourceBuffer, &destinationBuffer, pScratchBuffers->temporaryData,
+                                                          kvImageHighQualityResampling);
+                if (error == kvImageNoError) {
+                    scaled = YES;
+                }
+                else {
+                    HLSLoggerWarn(@"vImage scaling failed (error %ld); use Core Graphics instead", (long)error);
+                }
+            }
+        }
+    }
+    
+    if (! scaled) {
+        scaled = drawImageInBitmap(imageRef, pScratchBuffers->destinationData, width, height, bytesPerRow, colorSpace);
+    }
+    
+    UIImage *resultImage = scaled ? imageWithBitmap(pScratchBuffers->destinationData, width, height, bytesPerRow, colorSpace) : nil;
+    CGColorSpaceRelease(colorSpace);
+    return resultImage;
+}
@@ -0,0 +1,80 @@
+//
+//  HLSFetchOptions.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 18.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Options for tuning the fetch requests made by the NSManagedObject+HLSExtensions query methods. Each property has the 
+ * same meaning as the NSFetchRequest property with the same name. Use them to load large lists lazily (batch size),
+ * to page through results (limit and offset), to prefetch relationships you know will be accessed, or to fetch only
+ * the properties you need
+ *
+ * Designated initializer: -init
+ */
+@interface HLSFetchOptions : NSObject {
+@private
+    NSUInteger m_fetchBatchSize;
+    NSUInteger m_fetchLimit;
+    NSUInteger m_fetchOffset;
+    NSArray *m_relationshipKeyPathsForPrefetching;
+    NSArray *m_propertiesToFetch;
+    BOOL m_returnsObjectsAsFaults;
+}
+
+/**
+ * Convenience constructor
+ */
++ (HLSFetchOptions *)fetchOptions;
+
+/**
+ * The number of objects loaded at a time (the returned array is a proxy loading batches as it is accessed). 0 means no
+ * batching
+ *
+ * The default value is 0
+ */
+@property (nonatomic, assign) NSUInteger fetchBatchSize;
+
+/**
+ * The maximum number of objects returned. 0 means no limit
+ *
+ * The default value is 0
+ */
+@property (nonatomic, assign) NSUInteger fetchLimit;
+
+/**
+ * The number of matching objects to skip
+ *
+ * The default value is 0
+ */
+@property (nonatomic, assign) NSUInteger fetchOffset;
+
+/**
+ * The relationship key paths (NSString objects) whose destination objects are fetched along with the returned objects
+ *
+ * The default value is nil
+ */
+@property (nonatomic, retain) NSArray *relationshipKeyPathsForPrefetching;
+
+/**
+ * The names of the properties (or NSPropertyDescription objects) to fetch. nil means all properties
+ *
+ * The default value is nil
+ */
+@property (nonatomic, retain) NSArray *propertiesToFetch;
+
+/**
+ * If set to NO, returned objects are fully populated instead of being faults
+ *
+ * The default value is YES
+ */
+@property (nonatomic, assign) BOOL returnsObjectsAsFaults;
+
+/**
+ * Apply the options to a fetch request
+ */
+- (void)applyToFetchRequest:(NSFetchRequest *)fetchRequest;
+
+@end
@@ -0,0 +1,82 @@
+//
+//  HLSFetchOptions.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 18.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFetchOptions.h"
+
+#import "HLSConverters.h"
+
+@implementation HLSFetchOptions
+
+#pragma mark Class methods
+
++ (HLSFetchOptions *)fetchOptions
+{
+    return [[[[self class] alloc] init] autorelease];
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        self.returnsObjectsAsFaults = YES;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    self.relationshipKeyPathsForPrefetching = nil;
+    self.propertiesToFetch = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize fetchBatchSize = m_fetchBatchSize;
+
+@synthesize fetchLimit = m_fetchLimit;
+
+@synthesize fetchOffset = m_fetchOffset;
+
+@synthesize relationshipKeyPathsForPrefetching = m_relationshipKeyPathsForPrefetching;
+
+@synthesize propertiesToFetch = m_propertiesToFetch;
+
+@synthesize returnsObjectsAsFaults = m_returnsObjectsAsFaults;
+
+#pragma mark Applying options
+
+- (void)applyToFetchRequest:(NSFetchRequest *)fetchRequest
+{
+    [fetchRequest setFetchBatchSize:self.fetchBatchSize];
+    [fetchRequest setFetchLimit:self.fetchLimit];
+    [fetchRequest setFetchOffset:self.fetchOffset];
+    [fetchRequest setRelationshipKeyPathsForPrefetching:self.relationshipKeyPathsForPrefetching];
+    [fetchRequest setPropertiesToFetch:self.propertiesToFetch];
+    [fetchRequest setReturnsObjectsAsFaults:self.returnsObjectsAsFaults];
+}
+
+#pragma mark Description
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p; fetchBatchSize: %d; fetchLimit: %d; fetchOffset: %d; "
+            "relationshipKeyPathsForPrefetching: %@; propertiesToFetch: %@; returnsObjectsAsFaults: %@>",
+            [self class],
+            self,
+            self.fetchBatchSize,
+            self.fetchLimit,
+            self.fetchOffset,
+            self.relationshipKeyPathsForPrefetching,
+            self.propertiesToFetch,
+            HLSStringFromBool(self.returnsObjectsAsFaults)];
+}
+
+@end
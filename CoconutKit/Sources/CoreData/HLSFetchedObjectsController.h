@@ -0,0 +1,117 @@
+//
+//  HLSFetchedObjectsController.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+// Forward declarations
+@protocol HLSFetchedObjectsControllerDelegate;
+
+/**
+ * A fetched objects controller keeps the result of a query made with the NSManagedObject+HLSExtensions query methods
+ * (the instances of an entity class matching a predicate, sorted using descriptors) up to date. Instead of refetching
+ * all objects when the context changes, the controller listens to the changes of its context and only evaluates the
+ * objects which have been inserted, updated or deleted, moving them to their new positions in the objects array.
+ *
+ * Changes are reported to the delegate as indexes of deleted, inserted and updated objects. If a table view is attached
+ * to the controller, the changes are also applied to one of its sections with a single batch of row updates (moved
+ * objects lead to a row deletion and a row insertion), for example:
+ *   - for a plain table view, populate the section with the objects of the controller
+ *   - for the table view of an HLSTableSearchDisplayViewController, attach the tableView property and set the
+ *     searchableObjects property to the objects of the controller when the delegate is notified, so that search results
+ *     are updated as well
+ *
+ * Predicates are evaluated in memory for changed objects, and must therefore not rely on features only available to
+ * fetch requests made to a SQLite store. The controller must be used from the thread its context is used on
+ *
+ * Designated initializer: -initWithEntityClass:predicate:sortDescriptors:managedObjectContext:
+ */
+@interface HLSFetchedObjectsController : NSObject {
+@private
+    Class m_entityClass;
+    NSPredicate *m_predicate;
+    NSArray *m_sortDescriptors;
+    NSManagedObjectContext *m_managedObjectContext;
+    NSArray *m_objects;
+    UITableView *m_tableView;
+    NSInteger m_section;
+    UITableViewRowAnimation m_rowAnimation;
+    id<HLSFetchedObjectsControllerDelegate> m_delegate;
+}
+
+/**
+ * Create a controller for instances of an NSManagedObject subclass matching a predicate (nil for all instances), sorted
+ * using descriptors (nil for no sorting; in this case new objects are added at the end). Without context parameter,
+ * the current HLSModelManager context is used. Objects are fetched immediately
+ */
+- (id)initWithEntityClass:(Class)entityClass
+                predicate:(NSPredicate *)predicate
+          sortDescriptors:(NSArray *)sortDescriptors
+     managedObjectContext:(NSManagedObjectContext *)managedObjectContext;
+- (id)initWithEntityClass:(Class)entityClass
+                predicate:(NSPredicate *)predicate
+          sortDescriptors:(NSArray *)sortDescriptors;
+
+/**
+ * Query parameters
+ */
+@property (nonatomic, readonly, assign) Class entityClass;
+@property (nonatomic, readonly, retain) NSPredicate *predicate;
+@property (nonatomic, readonly, retain) NSArray *sortDescriptors;
+@property (nonatomic, readonly, retain) NSManagedObjectContext *managedObjectContext;
+
+/**
+ * The objects matching the query, up to date with the changes made to the context
+ */
+@property (nonatomic, readonly, retain) NSArray *objects;
+
+/**
+ * Fetch all objects again, reloading the attached table view section. You usually never need to call this method
+ */
+- (void)reloadObjects;
+
+/**
+ * The table view whose section displays the objects. The table view is not retained
+ *
+ * The default value is nil
+ */
+@property (nonatomic, assign) UITableView *tableView;
+
+/**
+ * The section of the table view displaying the objects
+ *
+ * The default value is 0
+ */
+@property (nonatomic, assign) NSInteger section;
+
+/**
+ * The animation used when rows are inserted, deleted or reloaded
+ *
+ * The default value is UITableViewRowAnimationFade
+ */
+@property (nonatomic, assign) UITableViewRowAnimation rowAnimation;
+
+/**
+ * The controller delegate
+ */
+@property (nonatomic, assign) id<HLSFetchedObjectsControllerDelegate> delegate;
+
+@end
+
+@protocol HLSFetchedObjectsControllerDelegate <NSObject>
+
+@optional
+
+/**
+ * Called when objects have changed, after the objects property and the attached table view (if any) have been updated.
+ * Deleted and updated indexes refer to the previous objects array, inserted indexes to the new one. A moved object
+ * appears in both the deleted and inserted indexes. If all objects have been fetched again, all indexes are nil
+ */
+- (void)fetchedObjectsController:(HLSFetchedObjectsController *)fetchedObjectsController
+   didChangeObjectsAtDeletedIndexes:(NSIndexSet *)deletedIndexes
+                    insertedIndexes:(NSIndexSet *)insertedIndexes
+                     updatedIndexes:(NSIndexSet *)updatedIndexes;
+
+@end
@@ -0,0 +1,342 @@
+//
+//  HLSFetchedObjectsController.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFetchedObjectsController.h"
+
+#import "HLSLogger.h"
+#import "HLSModelManager.h"
+#import "NSManagedObject+HLSExtensions.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryCoreData
+
+// Function declarations
+static NSComparisonResult compareObjects(id object1, id object2, NSArray *sortDescriptors);
+static NSArray *indexPathsForIndexes(NSIndexSet *indexes, NSInteger section);
+
+@interface HLSFetchedObjectsController ()
+
+@property (nonatomic, assign) Class entityClass;
+@property (nonatomic, retain) NSPredicate *predicate;
+@property (nonatomic, retain) NSArray *sortDescriptors;
+@property (nonatomic, retain) NSManagedObjectContext *managedObjectContext;
+@property (nonatomic, retain) NSArray *objects;
+
+- (NSSet *)objectsOfEntityClassInSet:(NSSet *)objects;
+- (BOOL)objectMatchesPredicate:(NSManagedObject *)object;
+- (void)insertObject:(NSManagedObject *)object intoSortedObjects:(NSMutableArray *)sortedObjects;
+
+- (void)notifyChangesAtDeletedIndexes:(NSIndexSet *)deletedIndexes
+                      insertedIndexes:(NSIndexSet *)insertedIndexes
+                       updatedIndexes:(NSIndexSet *)updatedIndexes;
+
+- (void)managedObjectContextObjectsDidChange:(NSNotification *)notification;
+
+@end
+
+@implementation HLSFetchedObjectsController
+
+#pragma mark Object creation and destruction
+
+- (id)initWithEntityClass:(Class)entityClass
+                predicate:(NSPredicate *)predicate
+          sortDescriptors:(NSArray *)sortDescriptors
+     managedObjectContext:(NSManagedObjectContext *)managedObjectContext
+{
+    if ((self = [super init])) {
+        if (! [entityClass isSubclassOfClass:[NSManagedObject class]]) {
+            HLSLoggerError(@"The entity class must be an NSManagedObject subclass");
+            [self release];
+            return nil;
+        }
+        
+        if (! managedObjectContext) {
+            HLSLoggerError(@"Missing managed object context");
+            [self release];
+            return nil;
+        }
+        
+        self.entityClass = entityClass;
+        self.predicate = predicate;
+        self.sortDescriptors = sortDescriptors;
+        self.managedObjectContext = managedObjectContext;
+        self.rowAnimation = UITableViewRowAnimationFade;
+        
+        [self reloadObjects];
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(managedObjectContextObjectsDidChange:)
+                                                     name:NSManagedObjectContextObjectsDidChangeNotification
+                                                   object:managedObjectContext];
+    }
+    return self;
+}
+
+- (id)initWithEntityClass:(Class)entityClass
+                predicate:(NSPredicate *)predicate
+          sortDescriptors:(NSArray *)sortDescriptors
+{
+    return [self initWithEntityClass:entityClass
+                           predicate:predicate
+                     sortDescriptors:sortDescriptors
+                managedObjectContext:[HLSModelManager currentModelContext]];
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    
+    self.predicate = nil;
+    self.sortDescriptors = nil;
+    self.managedObjectContext = nil;
+    self.objects = nil;
+    self.delegate = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize entityClass = m_entityClass;
+
+@synthesize predicate = m_predicate;
+
+@synthesize sortDescriptors = m_sortDescriptors;
+
+@synthesize managedObjectContext = m_managedObjectContext;
+
+@synthesize objects = m_objects;
+
+@synthesize tableView = m_tableView;
+
+@synthesize section = m_section;
+
+@synthesize rowAnimation = m_rowAnimation;
+
+@synthesize delegate = m_delegate;
+
+#pragma mark Fetching objects
+
+- (void)reloadObjects
+{
+    NSArray *objects = [self.entityClass filteredObjectsUsingPredicate:self.predicate
+                                                sortedUsingDescriptors:self.sortDescriptors
+                                                inManagedObjectContext:self.managedObjectContext];
+    self.objects = objects ?: [NSArray array];
+    
+    [self.tableView reloadData];
+}
+
+- (NSSet *)objectsOfEntityClassInSet:(NSSet *)objects
+{
+    if (! objects) {
+        return [NSSet set];
+    }
+    
+    return [objects objectsPassingTest:^BOOL(id object, BOOL *stop) {
+        return [object isKindOfClass:self.entityClass];
+    }];
+}
+
+- (BOOL)objectMatchesPredicate:(NSManagedObject *)object
+{
+    return ! self.predicate || [self.predicate evaluateWithObject:object];
+}
+
+// Insert after the objects comparing equal, as a fetch would (more or less) do
+- (void)insertObject:(NSManagedObject *)object intoSortedObjects:(NSMutableArray *)sortedObjects
+{
+    NSUInteger lowerIndex = 0;
+    NSUInteger upperIndex = [sortedObjects count];
+    if ([self.sortDescriptors count] != 0) {
+        while (lowerIndex < upperIndex) {
+            NSUInteger middleIndex = lowerIndex + (upperIndex - lowerIndex) / 2;
+            if (compareObjects(object, [sortedObjects objectAtIndex:middleIndex], self.sortDescriptors) == NSOrderedAscending) {
+                upperIndex = middleIndex;
+            }
+            else {
+                lowerIndex = middleIndex + 1;
+            }
+        }
+    }
+    [sortedObjects insertObject:object atIndex:lowerIndex];
+}
+
+#pragma mark Notifying changes
+
+- (void)notifyChangesAtDeletedIndexes:(NSIndexSet *)deletedIndexes
+                      insertedIndexes:(NSIndexSet *)insertedIndexes
+                       updatedIndexes:(NSIndexSet *)updatedIndexes
+{
+    if ([self.delegate respondsToSelector:@selector(fetchedObjectsController:didChangeObjectsAtDeletedIndexes:insertedIndexes:updatedIndexes:)]) {
+        [self.delegate fetchedObjectsController:self
+               didChangeObjectsAtDeletedIndexes:deletedIndexes
+                                insertedIndexes:insertedIndexes
+                                 updatedIndexes:updatedIndexes];
+    }
+}
+
+#pragma mark Notification callbacks
+
+- (void)managedObjectContextObjectsDidChange:(NSNotification *)notification
+{
+    NSDictionary *userInfo = [notification userInfo];
+    if ([userInfo objectForKey:NSInvalidatedAllObjectsKey]) {
+        [self reloadObjects];
+        [self notifyChangesAtDeletedIndexes:nil insertedIndexes:nil updatedIndexes:nil];
+        return;
+    }
+    
+    NSMutableSet *deletedObjects = [NSMutableSet setWithSet:[self objectsOfEntityClassInSet:[userInfo objectForKey:NSDeletedObjectsKey]]];
+    [deletedObjects unionSet:[self objectsOfEntityClassInSet:[userInfo objectForKey:NSInvalidatedObjectsKey]]];
+    
+    NSMutableSet *changedObjects = [NSMutableSet setWithSet:[self objectsOfEntityClassInSet:[userInfo objectForKey:NSInsertedObjectsKey]]];
+    [changedObjects unionSet:[self objectsOfEntityClassInSet:[userInfo objectForKey:NSUpdatedObjectsKey]]];
+    [changedObjects unionSet:[self objectsOfEntityClassInSet:[userInfo objectForKey:NSRefreshedObjectsKey]]];
+    [changedObjects minusSet:deletedObjects];
+    
+    if ([deletedObjects count] == 0 && [changedObjects count] == 0) {
+        return;
+    }
+    
+    // Remove deleted and changed objects, remembering where changed objects were, as well as how many unchanged
+    // objects preceded them (objects are not retained, and indexes are stored as pointers)
+    NSArray *previousObjects = self.objects;
+    CFMutableDictionaryRef objectToPreviousIndexMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    CFMutableDictionaryRef objectToPreviousUnchangedCountMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    NSMutableIndexSet *deletedIndexes = [NSMutableIndexSet indexSet];
+    NSMutableIndexSet *removedIndexes = [NSMutableIndexSet indexSet];
+    NSUInteger unchangedCount = 0;
+    NSUInteger index = 0;
+    for (NSManagedObject *object in previousObjects) {
+        if ([deletedObjects containsObject:object]) {
+            [deletedIndexes addIndex:index];
+            [removedIndexes addIndex:index];
+        }
+        else if ([changedObjects containsObject:object]) {
+            CFDictionarySetValue(objectToPreviousIndexMap, object, (const void *)index);
+            CFDictionarySetValue(objectToPreviousUnchangedCountMap, object, (const void *)unchangedCount);
+            [removedIndexes addIndex:index];
+        }
+        else {
+            ++unchangedCount;
+        }
+        ++index;
+    }
+    
+    // Insert the changed objects which (still) match at their sorted positions
+    NSMutableArray *objects = [NSMutableArray arrayWithArray:previousObjects];
+    [objects removeObjectsAtIndexes:removedIndexes];
+    for (NSManagedObject *object in changedObjects) {
+        if ([object isDeleted] || ! [self objectMatchesPredicate:object]) {
+            continue;
+        }
+        [self insertObject:object intoSortedObjects:objects];
+    }
+    
+    // A changed object which was already present is updated in place if the unchanged objects preceding it are the same,
+    // and if it keeps its order relative to the other objects updated in place. Otherwise it moves, which is expressed
+    // as a deletion and an insertion
+    NSMutableIndexSet *insertedIndexes = [NSMutableIndexSet indexSet];
+    NSMutableIndexSet *updatedIndexes = [NSMutableIndexSet indexSet];
+    CFMutableSetRef keptObjects = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+    NSUInteger lastUpdatedIndex = NSNotFound;
+    unchangedCount = 0;
+    index = 0;
+    for (NSManagedObject *object in objects) {
+        if ([changedObjects containsObject:object]) {
+            const void *previousIndexValue = NULL;
+            if (CFDictionaryGetValueIfPresent(objectToPreviousIndexMap, object, &previousIndexValue)) {
+                NSUInteger previousIndex = (NSUInteger)previousIndexValue;
+                NSUInteger previousUnchangedCount = (NSUInteger)CFDictionaryGetValue(objectToPreviousUnchangedCountMap, object);
+                if (previousUnchangedCount == unchangedCount
+                        && (lastUpdatedIndex == NSNotFound || previousIndex > lastUpdatedIndex)) {
+                    [updatedIndexes addIndex:previousIndex];
+                    lastUpdatedIndex = previousIndex;
+                }
+                else {
+                    [deletedIndexes addIndex:previousIndex];
+                    [insertedIndexes addIndex:index];
+                }
+                CFSetAddValue(keptObjects, object);
+            }
+            else {
+                [insertedIndexes addIndex:index];
+            }
+        }
+        else {
+            ++unchangedCount;
+        }
+        ++index;
+    }
+    
+    // Changed objects which do not match anymore
+    for (NSManagedObject *object in changedObjects) {
+        const void *previousIndexValue = NULL;
+        if (! CFSetContainsValue(keptObjects, object)
+                && CFDictionaryGetValueIfPresent(objectToPreviousIndexMap, object, &previousIndexValue)) {
+            [deletedIndexes addIndex:(NSUInteger)previousIndexValue];
+        }
+    }
+    
+    CFRelease(keptObjects);
+    CFRelease(objectToPreviousIndexMap);
+    CFRelease(objectToPreviousUnchangedCountMap);
+    
+    // Keep the previous objects alive until the table view has been updated
+    [[previousObjects retain] autorelease];
+    self.objects = [NSArray arrayWithArray:objects];
+    
+    UITableView *tableView = self.tableView;
+    if (tableView) {
+        // Batch updates can only be applied to a displayed table view
+        if (! tableView.window) {
+            [tableView reloadData];
+        }
+        else {
+            [tableView beginUpdates];
+            [tableView deleteRowsAtIndexPaths:indexPathsForIndexes(deletedIndexes, self.section) withRowAnimation:self.rowAnimation];
+            [tableView insertRowsAtIndexPaths:indexPathsForIndexes(insertedIndexes, self.section) withRowAnimation:self.rowAnimation];
+            [tableView reloadRowsAtIndexPaths:indexPathsForIndexes(updatedIndexes, self.section) withRowAnimation:self.rowAnimation];
+            [tableView endUpdates];
+        }
+    }
+    
+    [self notifyChangesAtDeletedIndexes:deletedIndexes insertedIndexes:insertedIndexes updatedIndexes:updatedIndexes];
+}
+
+@end
+
+#pragma mark -
+#pragma mark Static functions
+
+static NSComparisonResult compareObjects(id object1, id object2, NSArray *sortDescriptors)
+{
+    for (NSSortDescriptor *sortDescriptor in sortDescriptors) {
+        NSComparisonResult result = [sortDescriptor compareObject:object1 toObject:object2];
+        if (result != NSOrderedSame) {
+            return result;
+        }
+    }
+    return NSOrderedSame;
+}
+
+static NSArray *indexPathsForIndexes(NSIndexSet *indexes, NSInteger section)
+{
+    NSMutableArray *indexPaths = [NSMutableArray arrayWithCapacity:[indexes count]];
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+        [indexPaths addObject:[NSIndexPath indexPathForRow:idx inSection:section]];
+    }];
+    return indexPaths;
+}
@@ -22,11 +22,18 @@
     NSFormatter *m_formatter;
     id<HLSTextFieldValidationDelegate> m_validationDelegate;
     BOOL m_checkingOnChange;
+    id m_synchronizedValue;
+    NSString *m_synchronizedText;
+    BOOL m_synchronizationScheduled;
 }
 
 /**
  * Initialize with a managed object and the field we want to validate, as well as a delegate which must receive
- * validation events. An optional formatter can be provided if needed (e.g. for date or numeric fields)
+ * validation events. An optional formatter can be provided if needed. If none is provided, a formatter shared among
+ * all validators is used for numeric and date fields (see HLSFormatterPool), and string fields are not formatted
+ *
+ * When the model object field value changes, the text field is validated and synchronized at most once per run
+ * loop iteration, and formatting is skipped if the value is the same as the one last displayed
  */
 - (id)initWithTextField:(UITextField *)textField
           managedObject:(NSManagedObject *)managedObject 
@@ -10,22 +10,37 @@
 
 #import "HLSAssert.h"
 #import "HLSError.h"
+#import "HLSFormatterPool.h"
 #import "HLSLogger.h"
 #import "NSManagedObject+HLSValidation.h"
 #import "NSObject+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryCoreData
+
 // This implementation has been swizzled in UITextField+HLSValidation.m
 extern void (*UITextField__setText_Imp)(id, SEL, id);
 
+// Validators waiting to be synchronized with their managed object (not retained: Validators remove themselves when
+// deallocated, since their text field might not exist anymore)
+static CFMutableSetRef s_pendingValidators = NULL;
+
 @interface HLSManagedTextFieldValidator ()
 
 @property (nonatomic, retain) NSManagedObject *managedObject;
 @property (nonatomic, retain) NSString *fieldName;
 @property (nonatomic, retain) NSFormatter *formatter;
 @property (nonatomic, assign) id<HLSTextFieldValidationDelegate> validationDelegate;
+@property (nonatomic, retain) id synchronizedValue;
+@property (nonatomic, retain) NSString *synchronizedText;
+
++ (NSFormatter *)defaultFormatterForAttributeDescription:(NSAttributeDescription *)attributeDescription;
 
 - (BOOL)checkValue:(id)value;
 - (void)synchronizeTextField;
+- (void)synchronizeWithManagedObject;
+
++ (void)synchronizePendingValidators;
 
 @end
 
@@ -66,7 +81,7 @@ extern void (*UITextField__setText_Imp)(id, SEL, id);
         // Binding parameters correct. Remember them
         self.managedObject = managedObject;
         self.fieldName = fieldName;
-        self.formatter = formatter;
+        self.formatter = formatter ? formatter : [HLSManagedTextFieldValidator defaultFormatterForAttributeDescription:(NSAttributeDescription *)propertyDescription];
         self.validationDelegate = validationDelegate;
         
         // Perform initial synchronization of the text field with the model object field value
@@ -85,14 +100,64 @@ extern void (*UITextField__setText_Imp)(id, SEL, id);
 {
     [self.managedObject removeObserver:self forKeyPath:self.fieldName];
     
+    if (m_synchronizationScheduled) {
+        CFSetRemoveValue(s_pendingValidators, self);
+    }
+    
     self.managedObject = nil;
     self.fieldName = nil;
     self.formatter = nil;
     self.validationDelegate = nil;
+    self.synchronizedValue = nil;
+    self.synchronizedText = nil;
     
     [super dealloc];
 }
 
+#pragma mark Default formatters
+
+// Shared formatters from the pool, so that validators do not create formatters of their own
++ (NSFormatter *)defaultFormatterForAttributeDescription:(NSAttributeDescription *)attributeDescription
+{
+    HLSFormatterPool *formatterPool = [HLSFormatterPool sharedFormatterPool];
+    switch ([attributeDescription attributeType]) {
+        case NSInteger16AttributeType:
+        case NSInteger32AttributeType:
+        case NSInteger64AttributeType: {
+            return [formatterPool numberFormatterWithStyle:NSNumberFormatterNoStyle];
+            break;
+        }
+            
+        case NSFloatAttributeType:
+        case NSDoubleAttributeType: {
+            return [formatterPool numberFormatterWithStyle:NSNumberFormatterDecimalStyle];
+            break;
+        }
+            
+        case NSDecimalAttributeType: {
+            // Decimal attributes must be set with NSDecimalNumber objects
+            return [formatterPool formatterForKey:@"HLSManagedTextFieldValidator|NSDecimalAttributeType" creationBlock:^{
+                NSNumberFormatter *numberFormatter = [[[NSNumberFormatter alloc] init] autorelease];
+                [numberFormatter setFormatterBehavior:NSNumberFormatterBehavior10_4];
+                [numberFormatter setNumberStyle:NSNumberFormatterDecimalStyle];
+                [numberFormatter setGeneratesDecimalNumbers:YES];
+                return (NSFormatter *)numberFormatter;
+            }];
+            break;
+        }
+            
+        case NSDateAttributeType: {
+            return [formatterPool dateFormatterWithDateStyle:NSDateFormatterMediumStyle timeStyle:NSDateFormatterShortStyle];
+            break;
+        }
+            
+        default: {
+            return nil;
+            break;
+        }
+    }
+}
+
 #pragma mark Accessors and mutators
 
 @synthesize managedObject = m_managedObject;
@@ -105,6 +170,10 @@ extern void (*UITextField__setText_Imp)(id, SEL, id);
 
 @synthesize checkingOnChange = m_checkingOnChange;
 
+@synthesize synchronizedValue = m_synchronizedValue;
+
+@synthesize synchronizedText = m_synchronizedText;
+
 #pragma mark UITextFieldDelegate protocol implementation
 
 - (BOOL)textField:(UITextField *)textField shouldChangeCharactersInRange:(NSRange)range replacementString:(NSString *)string
@@ -206,38 +275,96 @@ extern void (*UITextField__setText_Imp)(id, SEL, id);
     // value is namely an empty string, never nil. The value which therefore makes sense for an empty text field is always
     // an empty string, not nil
     id value = [self.managedObject valueForKey:self.fieldName];
-    NSString *text = @"";
-    if (value) {
-        if (self.formatter) {
-            NSString *formattedValue = [self.formatter stringForObjectValue:value];
-            if (formattedValue) {
-                text = formattedValue;
+    
+    // Only format the value if it has changed since it was last displayed
+    NSString *text = nil;
+    if (self.synchronizedText && (value == self.synchronizedValue || [value isEqual:self.synchronizedValue])) {
+        text = self.synchronizedText;
+    }
+    else {
+        text = @"";
+        if (value) {
+            if (self.formatter) {
+                NSString *formattedValue = [self.formatter stringForObjectValue:value];
+                if (formattedValue) {
+                    text = formattedValue;
+                }
             }
+            else {
+                text = value;
+            }            
         }
-        else {
-            text = value;
-        }            
+        
+        self.synchronizedValue = value;
+        self.synchronizedText = text;
     }
     
     // Set the value. Use the original setter to avoid triggering validation again (which is why the setter has
     // been swizzled)
-    (*UITextField__setText_Imp)(self.textField, @selector(setText:), text);
+    if (! [self.textField.text isEqualToString:text]) {
+        (*UITextField__setText_Imp)(self.textField, @selector(setText:), text);
+    }
 }
 
-#pragma mark Key-value observing
-
-- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
+// Validate and synchronize the text field with the model object field value
+- (void)synchronizeWithManagedObject
 {
+    m_synchronizationScheduled = NO;
+    
     // Every time the value of the model object field changes, we want to trigger validation to update the text field
     // accordingly
-    id newValue = [object valueForKey:keyPath];
-    [self checkValue:newValue];
+    id value = [self.managedObject valueForKey:self.fieldName];
+    [self checkValue:value];
     
     // The value might have been changed programmatically. Be sure to update the text field text in all cases to take
     // this fact into account
     [self synchronizeTextField];
 }
 
+#pragma mark Key-value observing
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
+{
+    // Coalesce changes (e.g. when a background context is merged), synchronizing at most once per run loop iteration
+    if (m_synchronizationScheduled) {
+        return;
+    }
+    m_synchronizationScheduled = YES;
+    
+    if (! s_pendingValidators) {
+        s_pendingValidators = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+    }
+    
+    // A single synchronization is scheduled for all validators
+    if (CFSetGetCount(s_pendingValidators) == 0) {
+        [HLSManagedTextFieldValidator performSelector:@selector(synchronizePendingValidators) withObject:nil afterDelay:0.];
+    }
+    CFSetAddValue(s_pendingValidators, self);
+}
+
++ (void)synchronizePendingValidators
+{
+    CFIndex count = CFSetGetCount(s_pendingValidators);
+    const void **validators = malloc(count * sizeof(void *));
+    CFSetGetValues(s_pendingValidators, validators);
+    for (CFIndex i = 0; i < count; ++i) {
+        // Might have been deallocated as a result of the synchronization of another validator
+        HLSManagedTextFieldValidator *validator = (HLSManagedTextFieldValidator *)validators[i];
+        if (! CFSetContainsValue(s_pendingValidators, validator)) {
+            continue;
+        }
+        
+        CFSetRemoveValue(s_pendingValidators, validator);
+        [validator synchronizeWithManagedObject];
+    }
+    free(validators);
+    
+    // Changes might have occurred during synchronization
+    if (CFSetGetCount(s_pendingValidators) != 0) {
+        [HLSManagedTextFieldValidator performSelector:@selector(synchronizePendingValidators) withObject:nil afterDelay:0.];
+    }
+}
+
 #pragma mark Description
 
 - (NSString *)description
@@ -0,0 +1,25 @@
+//
+//  HLSModelManager+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 19.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSModelManager.h"
+
+/**
+ * Interface meant to be used by friend classes of HLSModelManager (= classes which must have access to private implementation
+ * details)
+ */
+@interface HLSModelManager (Friend)
+
+/**
+ * Save a worker context created from a duplicate of the receiver and used on a secondary thread. If the receiver is
+ * merging background changes, they are merged into its context on the main thread before the method returns
+ *
+ * Return YES iff successful. Must not be called from the main thread
+ */
+- (BOOL)saveWorkerContext:(NSManagedObjectContext *)workerContext error:(NSError **)pError;
+
+@end
@@ -0,0 +1,50 @@
+//
+//  HLSModelManager+HLSImport.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 19.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSModelManager.h"
+#import "HLSTaskGroup.h"
+
+/**
+ * Block filling a managed object (inserted or already existing) with the content of a record. It is called on a secondary
+ * thread, with a worker model manager pushed, so that the context-free methods of NSManagedObject+HLSExtensions.h can
+ * be used (e.g. to look up related objects)
+ */
+typedef void (^HLSModelImportBlock)(NSManagedObject *managedObject, NSDictionary *record);
+
+/**
+ * Bulk import of records (e.g. parsed from JSON) into the store of a model manager. Records are split into chunks 
+ * processed one after the other on secondary threads, each in a worker context which is saved and then discarded, so 
+ * that memory use is bounded by the chunk size. Objects already existing for the records of a chunk are fetched with
+ * a single query, and updated instead of being inserted again.
+ *
+ * Changes are merged into the context of the model manager as chunks are saved (if the model manager is merging 
+ * background changes, see HLSModelManager.h).
+ */
+@interface HLSModelManager (HLSImport)
+
+/**
+ * Return a task group importing records (NSDictionary objects) as instances of an entity class. The unique key is both 
+ * the name of the attribute identifying objects and the key of the corresponding value in the records. Records for which
+ * an object with the same unique key value exists update this object, other records lead to the insertion of new objects.
+ * Records without unique key value are always inserted. The import block (mandatory) fills each object with its record.
+ * A chunk size of 0 means that a default size is used.
+ *
+ * The task group has one task per chunk. Submit it to an HLSTaskManager and use the usual HLSTaskGroupDelegate callbacks
+ * to follow progress. If a chunk fails (its error is attached to the corresponding task) or if the task group is cancelled,
+ * the remaining chunks are not imported. Chunks already imported are not rolled back. Do not add tasks or dependencies to
+ * this task group
+ *
+ * The context of the receiver must be used from the main thread
+ */
+- (HLSTaskGroup *)taskGroupImportingRecords:(NSArray *)records
+                             forEntityClass:(Class)entityClass
+                                  uniqueKey:(NSString *)uniqueKey
+                                  chunkSize:(NSUInteger)chunkSize
+                                 usingBlock:(HLSModelImportBlock)block;
+
+@end
@@ -0,0 +1,160 @@
+//
+//  HLSModelManager+HLSImport.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 19.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSModelManager+HLSImport.h"
+
+#import "HLSBlockTask.h"
+#import "HLSLogger.h"
+#import "HLSModelManager+Friend.h"
+#import "NSManagedObject+HLSExtensions.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryCoreData
+
+static const NSUInteger kModelImportDefaultChunkSize = 500;
+
+@interface HLSModelManager (HLSImportPrivate)
+
+- (void)importRecords:(NSArray *)records
+       forEntityClass:(Class)entityClass
+            uniqueKey:(NSString *)uniqueKey
+           usingBlock:(HLSModelImportBlock)block
+              context:(id<HLSBlockTaskContext>)context;
+
+@end
+
+@implementation HLSModelManager (HLSImport)
+
+- (HLSTaskGroup *)taskGroupImportingRecords:(NSArray *)records
+                             forEntityClass:(Class)entityClass
+                                  uniqueKey:(NSString *)uniqueKey
+                                  chunkSize:(NSUInteger)chunkSize
+                                 usingBlock:(HLSModelImportBlock)block
+{
+    if (! [entityClass isSubclassOfClass:[NSManagedObject class]]) {
+        HLSLoggerError(@"The entity class must be an NSManagedObject subclass");
+        return nil;
+    }
+    
+    if (! block) {
+        HLSLoggerError(@"Missing import block");
+        return nil;
+    }
+    
+    if (chunkSize == 0) {
+        chunkSize = kModelImportDefaultChunkSize;
+    }
+    
+    // Chunks are imported one after the other (strong dependencies), so that records with the same unique key value
+    // in different chunks never lead to duplicate insertions
+    HLSTaskGroup *taskGroup = [[[HLSTaskGroup alloc] init] autorelease];
+    HLSBlockTask *previousTask = nil;
+    NSUInteger nbrRecords = [records count];
+    for (NSUInteger firstIndex = 0; firstIndex < nbrRecords; firstIndex += chunkSize) {
+        NSArray *chunk = [records subarrayWithRange:NSMakeRange(firstIndex, MIN(chunkSize, nbrRecords - firstIndex))];
+        HLSBlockTask *task = [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+            [self importRecords:chunk forEntityClass:entityClass uniqueKey:uniqueKey usingBlock:block context:context];
+        }];
+        [taskGroup addTask:task];
+        if (previousTask) {
+            [taskGroup addDependencyForTask:task onTask:previousTask strong:YES];
+        }
+        previousTask = task;
+    }
+    return taskGroup;
+}
+
+@end
+
+@implementation HLSModelManager (HLSImportPrivate)
+
+- (void)importRecords:(NSArray *)records
+       forEntityClass:(Class)entityClass
+            uniqueKey:(NSString *)uniqueKey
+           usingBlock:(HLSModelImportBlock)block
+              context:(id<HLSBlockTaskContext>)context
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    
+    // The worker context is only used during the import of the chunk (and reset afterwards), which bounds memory use
+    HLSModelManager *workerModelManager = [self dequeueWorkerModelManager];
+    NSManagedObjectContext *workerContext = workerModelManager.managedObjectContext;
+    
+    // Fetch all objects already existing for the chunk at once, instead of one query per record
+    NSMutableDictionary *uniqueKeyValueToObjectMap = [NSMutableDictionary dictionary];
+    if (uniqueKey) {
+        NSMutableArray *uniqueKeyValues = [NSMutableArray array];
+        for (NSDictionary *record in records) {
+            id uniqueKeyValue = [record objectForKey:uniqueKey];
+            if (uniqueKeyValue) {
+                [uniqueKeyValues addObject:uniqueKeyValue];
+            }
+        }
+        
+        if ([uniqueKeyValues count] != 0) {
+            NSPredicate *predicate = [NSPredicate predicateWithFormat:@"%K IN %@", uniqueKey, uniqueKeyValues];
+            NSArray *existingObjects = [entityClass filteredObjectsUsingPredicate:predicate
+                                                           sortedUsingDescriptors:nil
+                                                           inManagedObjectContext:workerContext];
+            for (NSManagedObject *existingObject in existingObjects) {
+                [uniqueKeyValueToObjectMap setObject:existingObject forKey:[existingObject valueForKey:uniqueKey]];
+            }
+        }
+    }
+    
+    [HLSModelManager pushModelManager:workerModelManager];
+    
+    NSUInteger nbrRecords = [records count];
+    NSUInteger nbrImportedRecords = 0;
+    for (NSDictionary *record in records) {
+        if ([context isCancelled]) {
+            break;
+        }
+        
+        id uniqueKeyValue = uniqueKey ? [record objectForKey:uniqueKey] : nil;
+        NSManagedObject *managedObject = uniqueKeyValue ? [uniqueKeyValueToObjectMap objectForKey:uniqueKeyValue] : nil;
+        if (! managedObject) {
+            managedObject = [entityClass insertIntoManagedObjectContext:workerContext];
+            if (uniqueKeyValue) {
+                [managedObject setValue:uniqueKeyValue forKey:uniqueKey];
+                
+                // Later records with the same key in the chunk update this object
+                [uniqueKeyValueToObjectMap setObject:managedObject forKey:uniqueKeyValue];
+            }
+        }
+        block(managedObject, record);
+        
+        // Leave the last step for the save
+        ++nbrImportedRecords;
+        [context updateProgressToValue:0.9f * nbrImportedRecords / nbrRecords];
+    }
+    
+    [HLSModelManager popModelManager];
+    
+    if ([context isCancelled]) {
+        [workerContext rollback];
+        [self recycleWorkerModelManager:workerModelManager];
+        [pool drain];
+        return;
+    }
+    
+    NSError *error = nil;
+    if ([self saveWorkerContext:workerContext error:&error]) {
+        [context updateProgressToValue:1.f];
+    }
+    else {
+        HLSLoggerError(@"Could not save imported records; reason: %@", error);
+        [context attachError:error];
+        [workerContext rollback];
+    }
+    
+    [self recycleWorkerModelManager:workerModelManager];
+    [pool drain];
+}
+
+@end
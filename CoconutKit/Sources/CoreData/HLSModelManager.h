@@ -6,11 +6,54 @@
 //  Copyright 2011 Hortis. All rights reserved.
 //
 
+#import <libkern/OSAtomic.h>
+#import "HLSTask.h"
+
 // Standard option combinations
 #define HLSModelManagerLightweightMigrationOptions          [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithBool:YES], NSMigratePersistentStoresAutomaticallyOption,   \
                                                                                                        [NSNumber numberWithBool:YES], NSInferMappingModelAutomaticallyOption,         \
                                                                                                        nil]
 
+/**
+ * Performance profiles for SQLite stores, applied through NSSQLitePragmasOption:
+ *   - HLSModelManagerSQLiteProfileNone: no pragma is set, SQLite defaults are used
+ *   - HLSModelManagerSQLiteProfileFast: write-ahead logging, normal synchronization (a transaction committed just before
+ *     a power loss might be rolled back, but the store cannot be corrupted), larger page cache, memory-mapped I/O and
+ *     automatic indexes. This is the recommended profile for most applications
+ *   - HLSModelManagerSQLiteProfileDurable: same as HLSModelManagerSQLiteProfileFast, but with full synchronization,
+ *     so that committed transactions survive a power loss
+ *   - HLSModelManagerSQLiteProfileLowMemory: normal synchronization, small page cache, no memory-mapped I/O and no
+ *     automatic indexes
+ * Pragmas which are not supported by the SQLite version of the device (e.g. memory-mapped I/O before iOS 7) are ignored.
+ * Write-ahead logging is a persistent setting of the store, which is then made of several files (the store file, as well 
+ * as -wal and -shm files). Keep this in mind if you copy or remove store files
+ */
+typedef enum {
+    HLSModelManagerSQLiteProfileEnumBegin = 0,
+    HLSModelManagerSQLiteProfileNone = HLSModelManagerSQLiteProfileEnumBegin,
+    HLSModelManagerSQLiteProfileFast,
+    HLSModelManagerSQLiteProfileDurable,
+    HLSModelManagerSQLiteProfileLowMemory,
+    HLSModelManagerSQLiteProfileEnumEnd,
+    HLSModelManagerSQLiteProfileEnumSize = HLSModelManagerSQLiteProfileEnumEnd - HLSModelManagerSQLiteProfileEnumBegin
+} HLSModelManagerSQLiteProfile;
+
+/**
+ * Block executed by a background task, receiving the worker context it must use
+ */
+typedef void (^HLSModelManagerBackgroundTaskBlock)(NSManagedObjectContext *managedObjectContext);
+
+/**
+ * Block called on the main thread when a background task is complete. The error is nil iff the task has been successful
+ */
+typedef void (^HLSModelManagerBackgroundTaskCompletionBlock)(NSError *error);
+
+/**
+ * Key under which the model manager opened by a task returned by +taskOpeningModelManagerWithModelFileName:... can be
+ * found in the task returnInfo dictionary
+ */
+extern NSString * const HLSModelManagerKey;
+
 /**
  * A model manager is a lightweight wrapper around a Core Data managed object context, eliminating most of the 
  * usual boilerplate you have to write when creating stores and contexts, and providing some additional convenience 
@@ -41,6 +84,10 @@
  *   - if you need to perform database operations on another thread, duplicate the current context and push 
  *     the new instance onto the other thread model manager stack
  *
+ * For bulk operations (e.g. imports), you can also let a model manager whose context is used on the main thread run
+ * them in the background (see -performBackgroundTask:completionBlock:). Changes saved by background tasks are merged
+ * into the context of the model manager automatically.
+ *
  * Designated initializer: -initWithModelFileName:storeType:configuration:storeDirectory:options:
  */
 @interface HLSModelManager : NSObject {
@@ -48,6 +95,10 @@
     NSManagedObjectModel *_managedObjectModel;
     NSPersistentStoreCoordinator *_persistentStoreCoordinator;
     NSManagedObjectContext *_managedObjectContext;
+    dispatch_queue_t _backgroundQueue;
+    NSMutableArray *_workerContexts;                    // pool of recycled worker contexts
+    OSSpinLock _workerContextsLock;
+    BOOL _mergingBackgroundChanges;
 }
 
 /**
@@ -65,6 +116,25 @@
                                      storeDirectory:(NSString *)storeDirectory
                                             options:(NSDictionary *)options;
 
+/**
+ * Same as +SQLiteManagerWithModelFileName:inBundle:configuration:storeDirectory:options:, but applying the pragmas
+ * of a performance profile (see +SQLiteOptionsForProfile:options:)
+ */
++ (HLSModelManager *)SQLiteManagerWithModelFileName:(NSString *)modelFileName
+                                           inBundle:(NSBundle *)bundle
+                                      configuration:(NSString *)configuration
+                                     storeDirectory:(NSString *)storeDirectory
+                                            profile:(HLSModelManagerSQLiteProfile)profile
+                                            options:(NSDictionary *)options;
+
+/**
+ * Return the options given as parameter (which can be nil), with the pragmas of a performance profile added to their
+ * NSSQLitePragmasOption dictionary. Pragmas already present in the options take precedence over the ones of the profile.
+ * Use this method to apply a profile when creating a SQLite store with other methods (e.g. with
+ * +taskOpeningModelManagerWithModelFileName:inBundle:storeType:configuration:storeDirectory:options:)
+ */
++ (NSDictionary *)SQLiteOptionsForProfile:(HLSModelManagerSQLiteProfile)profile options:(NSDictionary *)options;
+
 /**
  * Create a model manager using the model file given as parameter (lookup is performed in the specified bundle,
  * or in the main bundle if nil) and saving data in-memory
@@ -147,12 +217,76 @@
               configuration:(NSString *)configuration 
              storeDirectory:(NSString *)storeDirectory
                     options:(NSDictionary *)options;
+
 /**
- * Duplicate an existing manager
+ * Return a task creating a model manager with the same parameters as -initWithModelFileName:inBundle:storeType:
+ * configuration:storeDirectory:options:, but loading the model and opening the store on a secondary thread, so that
+ * the application stays responsive while an existing store is being migrated (e.g. display a placeholder until the
+ * task has been processed). Submit the task to an HLSTaskManager from the main thread and use the usual HLSTaskDelegate
+ * callbacks to follow progress. When the task has been successfully processed, the model manager (whose context must
+ * be used from the main thread) is available in the task returnInfo under HLSModelManagerKey. Otherwise an error is
+ * attached to the task
+ *
+ * If the store needs a lightweight migration (options enabling automatic migration and mapping model inference, see
+ * HLSModelManagerLightweightMigrationOptions) and the model of the existing store is available in the model file,
+ * migration is performed explicitly with an NSMigrationManager, whose progress is reported as task progress. Otherwise 
+ * the store is opened as usual by the persistent store coordinator, and progress is only updated when it is done. 
+ * A task cannot be cancelled while the store is being opened or migrated
+ */
++ (HLSTask *)taskOpeningModelManagerWithModelFileName:(NSString *)modelFileName
+                                             inBundle:(NSBundle *)bundle
+                                            storeType:(NSString *)storeType
+                                        configuration:(NSString *)configuration
+                                       storeDirectory:(NSString *)storeDirectory
+                                              options:(NSDictionary *)options;
+
+/**
+ * Duplicate an existing manager. The duplicate has its own context, but shares the model and the persistent store
+ * coordinator of the receiver (neither the model nor the store are loaded again)
  */
 - (HLSModelManager *)duplicate;
 
+/**
+ * Return a worker model manager for short-lived work (e.g. on a secondary thread). Like a duplicate, it shares the 
+ * model and persistent store coordinator of the receiver, but its context is taken from a small pool of contexts 
+ * recycled by previous workers, so that no context needs to be created in most cases. The context must only be used
+ * by one thread at a time. When you are done, return the worker with -recycleWorkerModelManager: (after it has been 
+ * popped if you pushed it onto a model manager stack). Its context is then reset (so that no objects it contains must
+ * be used afterwards) and returned to the pool, provided it has no unsaved changes
+ *
+ * These methods can be called from any thread
+ */
+- (HLSModelManager *)dequeueWorkerModelManager;
+- (void)recycleWorkerModelManager:(HLSModelManager *)workerModelManager;
+
+/**
+ * Migrate the store of the receiver to a new location and / or type. The synchronous version blocks the calling thread
+ * until migration is complete. The task version performs migration on a secondary thread (submit it to an HLSTaskManager
+ * from the main thread, an error is attached to it if migration fails). The persistent store coordinator is locked during
+ * migration, the context of the receiver must therefore not be used until the task has been processed
+ */
 - (BOOL)migrateStoreToURL:(NSURL *)url withStoreType:(NSString *)storeType error:(NSError **)pError;
+- (HLSTask *)taskMigratingStoreToURL:(NSURL *)url withStoreType:(NSString *)storeType;
+
+/**
+ * Execute a block on a background serial queue, with a worker context sharing the persistent store coordinator of the
+ * receiver. A worker model manager is pushed during block execution, so that you can use the context-free methods of
+ * NSManagedObject+HLSExtensions.h within the block. Changes are saved when the block returns (rollback the worker
+ * context if you want to discard them), and the completion block (which can be nil) is then called on the main thread.
+ * Background tasks submitted to the same model manager are executed one after the other
+ *
+ * This method must be called from the main thread, and the context of the receiver must be used from the main thread
+ */
+- (void)performBackgroundTask:(HLSModelManagerBackgroundTaskBlock)block
+              completionBlock:(HLSModelManagerBackgroundTaskCompletionBlock)completionBlock;
+
+/**
+ * If set to YES, changes saved by background tasks are merged into the context of the receiver before their completion
+ * block is called
+ *
+ * The default value is YES
+ */
+@property (nonatomic, assign, getter=isMergingBackgroundChanges) BOOL mergingBackgroundChanges;
 
 /**
  * Access to Core Data internals
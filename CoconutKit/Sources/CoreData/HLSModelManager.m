@@ -8,18 +8,66 @@
 
 #import "HLSModelManager.h"
 
+#import "HLSBlockTask.h"
 #import "HLSError.h"
 #import "HLSFileManager.h"
 #import "HLSLogger.h"
+#import "HLSModelManager+Friend.h"
 #import "NSArray+HLSExtensions.h"
 
+#import <pthread.h>
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryCoreData
+
+NSString * const HLSModelManagerKey = @"HLSModelManager";
+
+// Maximum number of recycled worker contexts kept per model manager
+static const NSUInteger kModelManagerWorkerContextsCapacity = 4;
+
+// Share of the progress of a task opening a store which is reported during migration
+static const float kModelManagerMigrationProgressBegin = 0.1f;
+static const float kModelManagerMigrationProgressEnd = 0.9f;
+
+// Thread-specific key caching the model manager stack of the current thread (retained)
+static pthread_key_t s_modelManagerStackKey;
+
+// Function declarations
+static void releaseModelManagerStack(void *modelManagerStack);
+static BOOL removeStoreFiles(HLSFileManager *fileManager, NSString *storeFilePath, NSError **pError);
+static BOOL moveStoreFiles(HLSFileManager *fileManager, NSString *storeFilePath, NSString *destinationStoreFilePath, NSError **pError);
+static NSArray *storeFileSuffixes(void);
+
+#pragma mark -
+#pragma mark HLSStoreMigrationObserver class interface
+
+/**
+ * Report the progress of a migration manager as block task progress
+ */
+@interface HLSStoreMigrationObserver : NSObject {
+@private
+    id<HLSBlockTaskContext> _blockTaskContext;
+    float _reportedProgress;
+}
+
+- (id)initWithBlockTaskContext:(id<HLSBlockTaskContext>)blockTaskContext;
+
+@end
+
+#pragma mark -
+#pragma mark HLSModelManager class
+
 @interface HLSModelManager ()
 
 + (NSString *)standardStoreFilePathForModelFileName:(NSString *)modelFileName 
                                           storeType:(NSString *)storeType 
                                      storeDirectory:(NSString *)storeDirectory;
++ (NSURL *)standardStoreURLForModelFileName:(NSString *)modelFileName
+                                  storeType:(NSString *)storeType
+                             storeDirectory:(NSString *)storeDirectory;
 
 + (NSMutableArray *)modelManagerStackForThread:(NSThread *)thread;
++ (NSMutableArray *)modelManagerStackForCurrentThread;
 + (HLSModelManager *)currentModelManagerForThread:(NSThread *)thread;
 + (HLSModelManager *)rootModelManagerForThread:(NSThread *)thread;
 
@@ -27,12 +75,30 @@
 @property (nonatomic, retain) NSPersistentStoreCoordinator *persistentStoreCoordinator;
 @property (nonatomic, retain) NSManagedObjectContext *managedObjectContext;
 
-- (NSManagedObjectModel *)managedObjectModelFromModelFileName:(NSString *)modelFileName inBundle:(NSBundle *)bundle;
-- (NSPersistentStoreCoordinator *)persistentStoreCoordinatorForManagedObjectModel:(NSManagedObjectModel *)managedObjectModel
++ (NSString *)modelFilePathForModelFileName:(NSString *)modelFileName inBundle:(NSBundle *)bundle;
++ (NSManagedObjectModel *)managedObjectModelFromModelFileName:(NSString *)modelFileName inBundle:(NSBundle *)bundle;
++ (NSPersistentStoreCoordinator *)persistentStoreCoordinatorForManagedObjectModel:(NSManagedObjectModel *)managedObjectModel
                                                                         storeType:(NSString *)storeType 
                                                                     configuration:(NSString *)configuration 
                                                                               URL:(NSURL *)storeURL 
-                                                                          options:(NSDictionary *)options;
+                                                                          options:(NSDictionary *)options
+                                                                            error:(NSError **)pError;
++ (BOOL)migrateStoreIfNeededAtURL:(NSURL *)storeURL
+                        storeType:(NSString *)storeType
+                    configuration:(NSString *)configuration
+             toManagedObjectModel:(NSManagedObjectModel *)managedObjectModel
+                    modelFilePath:(NSString *)modelFilePath
+                          options:(NSDictionary *)options
+                 blockTaskContext:(id<HLSBlockTaskContext>)blockTaskContext
+                            error:(NSError **)pError;
++ (HLSModelManager *)modelManagerWithModelFileName:(NSString *)modelFileName
+                                          inBundle:(NSBundle *)bundle
+                                         storeType:(NSString *)storeType
+                                     configuration:(NSString *)configuration
+                                    storeDirectory:(NSString *)storeDirectory
+                                           options:(NSDictionary *)options
+                                  blockTaskContext:(id<HLSBlockTaskContext>)blockTaskContext
+                                             error:(NSError **)pError;
 - (NSManagedObjectContext *)managedObjectContextForPersistentStoreCoordinator:(NSPersistentStoreCoordinator *)persistentStoreCoordinator;
 
 @end
@@ -55,6 +121,73 @@
                                                 options:options] autorelease];
 }
 
++ (HLSModelManager *)SQLiteManagerWithModelFileName:(NSString *)modelFileName
+                                           inBundle:(NSBundle *)bundle
+                                      configuration:(NSString *)configuration
+                                     storeDirectory:(NSString *)storeDirectory
+                                            profile:(HLSModelManagerSQLiteProfile)profile
+                                            options:(NSDictionary *)options
+{
+    return [self SQLiteManagerWithModelFileName:modelFileName
+                                       inBundle:bundle
+                                  configuration:configuration
+                                 storeDirectory:storeDirectory
+                                        options:[self SQLiteOptionsForProfile:profile options:options]];
+}
+
++ (NSDictionary *)SQLiteOptionsForProfile:(HLSModelManagerSQLiteProfile)profile options:(NSDictionary *)options
+{
+    NSDictionary *profilePragmas = nil;
+    switch (profile) {
+        case HLSModelManagerSQLiteProfileNone: {
+            return options;
+            break;
+        }
+            
+        case HLSModelManagerSQLiteProfileFast: {
+            profilePragmas = [NSDictionary dictionaryWithObjectsAndKeys:@"WAL", @"journal_mode",
+                              @"NORMAL", @"synchronous",
+                              [NSNumber numberWithInteger:4000], @"cache_size",
+                              [NSNumber numberWithInteger:8 * 1024 * 1024], @"mmap_size",
+                              [NSNumber numberWithInteger:1], @"automatic_index",
+                              nil];
+            break;
+        }
+            
+        case HLSModelManagerSQLiteProfileDurable: {
+            profilePragmas = [NSDictionary dictionaryWithObjectsAndKeys:@"WAL", @"journal_mode",
+                              @"FULL", @"synchronous",
+                              [NSNumber numberWithInteger:4000], @"cache_size",
+                              [NSNumber numberWithInteger:8 * 1024 * 1024], @"mmap_size",
+                              [NSNumber numberWithInteger:1], @"automatic_index",
+                              nil];
+            break;
+        }
+            
+        case HLSModelManagerSQLiteProfileLowMemory: {
+            profilePragmas = [NSDictionary dictionaryWithObjectsAndKeys:@"NORMAL", @"synchronous",
+                              [NSNumber numberWithInteger:500], @"cache_size",
+                              [NSNumber numberWithInteger:0], @"mmap_size",
+                              [NSNumber numberWithInteger:0], @"automatic_index",
+                              nil];
+            break;
+        }
+            
+        default: {
+            HLSLoggerError(@"Unknown SQLite profile");
+            return options;
+            break;
+        }
+    }
+    
+    NSMutableDictionary *pragmas = [NSMutableDictionary dictionaryWithDictionary:profilePragmas];
+    [pragmas addEntriesFromDictionary:[options objectForKey:NSSQLitePragmasOption]];
+    
+    NSMutableDictionary *profileOptions = [NSMutableDictionary dictionaryWithDictionary:options];
+    [profileOptions setObject:pragmas forKey:NSSQLitePragmasOption];
+    return [NSDictionary dictionaryWithDictionary:profileOptions];
+}
+
 + (HLSModelManager *)inMemoryModelManagerWithModelFileName:(NSString *)modelFileName
                                                   inBundle:(NSBundle *)bundle
                                              configuration:(NSString *)configuration 
@@ -125,6 +258,52 @@
     return [[storeDirectory stringByAppendingPathComponent:modelFileName] stringByAppendingPathExtension:extension];
 }
 
+// Return the standard URL for a store given its type and a model name (nil if the store directory is nil)
++ (NSURL *)standardStoreURLForModelFileName:(NSString *)modelFileName
+                                  storeType:(NSString *)storeType
+                             storeDirectory:(NSString *)storeDirectory
+{
+    if (! storeDirectory) {
+        return nil;
+    }
+    
+    NSString *standardStoreFilePath = [self standardStoreFilePathForModelFileName:modelFileName
+                                                                        storeType:storeType
+                                                                   storeDirectory:storeDirectory];
+    return [NSURL fileURLWithPath:standardStoreFilePath];
+}
+
++ (HLSTask *)taskOpeningModelManagerWithModelFileName:(NSString *)modelFileName
+                                             inBundle:(NSBundle *)bundle
+                                            storeType:(NSString *)storeType
+                                        configuration:(NSString *)configuration
+                                       storeDirectory:(NSString *)storeDirectory
+                                              options:(NSDictionary *)options
+{
+    return [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        NSError *error = nil;
+        HLSModelManager *modelManager = [self modelManagerWithModelFileName:modelFileName
+                                                                   inBundle:bundle
+                                                                  storeType:storeType
+                                                              configuration:configuration
+                                                             storeDirectory:storeDirectory
+                                                                    options:options
+                                                           blockTaskContext:context
+                                                                      error:&error];
+        if (modelManager) {
+            [context attachReturnInfo:[NSDictionary dictionaryWithObject:modelManager forKey:HLSModelManagerKey]];
+            [context updateProgressToValue:1.f];
+        }
+        else {
+            [context attachError:error];
+        }
+        
+        [pool drain];
+    }];
+}
+
 + (void)pushModelManager:(HLSModelManager *)modelManager
 {
     if (! modelManager) {
@@ -132,13 +311,13 @@
         return;
     }
     
-    NSMutableArray *modelManagerStack = [self modelManagerStackForThread:[NSThread currentThread]];
+    NSMutableArray *modelManagerStack = [self modelManagerStackForCurrentThread];
     [modelManagerStack addObject:modelManager];
 }
 
 + (void)popModelManager
 {
-    NSMutableArray *modelManagerStack = [self modelManagerStackForThread:[NSThread currentThread]];
+    NSMutableArray *modelManagerStack = [self modelManagerStackForCurrentThread];
     if ([modelManagerStack count] == 0) {
         HLSLoggerInfo(@"No model manager to pop");
         return;
@@ -159,9 +338,32 @@
     return modelManagerStack;
 }
 
+/**
+ * Same as +modelManagerStackForThread: for the current thread, but the stack is cached in thread-specific data
+ * so that it can be retrieved with a pointer read (no thread dictionary lookup), which matters since the current
+ * model manager is looked up for each model object operation. The stack is still stored in the thread dictionary,
+ * where other threads can find it
+ */
++ (NSMutableArray *)modelManagerStackForCurrentThread
+{
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        pthread_key_create(&s_modelManagerStackKey, releaseModelManagerStack);
+    });
+    
+    NSMutableArray *modelManagerStack = pthread_getspecific(s_modelManagerStackKey);
+    if (! modelManagerStack) {
+        modelManagerStack = [self modelManagerStackForThread:[NSThread currentThread]];
+        
+        // Released when the thread exits
+        pthread_setspecific(s_modelManagerStackKey, [modelManagerStack retain]);
+    }
+    return modelManagerStack;
+}
+
 + (HLSModelManager *)currentModelManager
 {
-    return [self currentModelManagerForThread:[NSThread currentThread]];
+    return [[self modelManagerStackForCurrentThread] lastObject];
 }
 
 + (HLSModelManager *)currentModelManagerForMainThread
@@ -171,13 +373,13 @@
 
 + (HLSModelManager *)currentModelManagerForThread:(NSThread *)thread
 {
-    NSMutableArray *modelManagerStack = [self modelManagerStackForThread:thread];
+    NSMutableArray *modelManagerStack = [thread isEqual:[NSThread currentThread]] ? [self modelManagerStackForCurrentThread] : [self modelManagerStackForThread:thread];
     return [modelManagerStack lastObject];
 }
 
 + (HLSModelManager *)rootModelManager
 {
-    return [self rootModelManagerForThread:[NSThread currentThread]];
+    return [[self modelManagerStackForCurrentThread] firstObject_hls];
 }
 
 + (HLSModelManager *)rootModelManagerForMainThread
@@ -187,7 +389,7 @@
 
 + (HLSModelManager *)rootModelManagerForThread:(NSThread *)thread
 {
-    NSMutableArray *modelManagerStack = [self modelManagerStackForThread:thread];
+    NSMutableArray *modelManagerStack = [thread isEqual:[NSThread currentThread]] ? [self modelManagerStackForCurrentThread] : [self modelManagerStackForThread:thread];
     return [modelManagerStack firstObject_hls];
 }
 
@@ -208,7 +410,11 @@
         return NO;
     }
     
-    return [currentModelContext save:pError];
+    HLSLoggerSpanBegin(span, "HLSModelManager save");
+    BOOL saved = [currentModelContext save:pError];
+    HLSLoggerSpanEnd(span);
+    
+    return saved;
 }
 
 + (void)rollbackCurrentModelContext
@@ -243,24 +449,21 @@
                     options:(NSDictionary *)options
 {
     if ((self = [super init])) {
-        self.managedObjectModel = [self managedObjectModelFromModelFileName:modelFileName inBundle:bundle];
+        self.managedObjectModel = [HLSModelManager managedObjectModelFromModelFileName:modelFileName inBundle:bundle];
         if (! self.managedObjectModel) {
             [self release];
             return nil;
         }
         
-        NSURL *standardStoreURL = nil;
-        if (storeDirectory) {
-            NSString *standardStoreFilePath = [HLSModelManager standardStoreFilePathForModelFileName:modelFileName
-                                                                                           storeType:storeType
-                                                                                      storeDirectory:storeDirectory];
-            standardStoreURL = [NSURL fileURLWithPath:standardStoreFilePath];            
-        }
-        self.persistentStoreCoordinator = [self persistentStoreCoordinatorForManagedObjectModel:self.managedObjectModel 
-                                                                                      storeType:storeType 
-                                                                                  configuration:configuration
-                                                                                            URL:standardStoreURL
-                                                                                        options:options];
+        NSURL *standardStoreURL = [HLSModelManager standardStoreURLForModelFileName:modelFileName
+                                                                          storeType:storeType
+                                                                     storeDirectory:storeDirectory];
+        self.persistentStoreCoordinator = [HLSModelManager persistentStoreCoordinatorForManagedObjectModel:self.managedObjectModel 
+                                                                                                 storeType:storeType 
+                                                                                             configuration:configuration
+                                                                                                       URL:standardStoreURL
+                                                                                                   options:options
+                                                                                                     error:NULL];
         if (! self.persistentStoreCoordinator) {
             [self release];
             return nil;
@@ -271,12 +474,20 @@
             [self release];
             return nil;
         }
+        
+        self.mergingBackgroundChanges = YES;
     }
     return self;
 }
 
 - (void)dealloc
 {
+    if (_backgroundQueue) {
+        dispatch_release(_backgroundQueue);
+    }
+    
+    [_workerContexts release];
+    
     self.managedObjectModel = nil;
     self.persistentStoreCoordinator = nil;
     self.managedObjectContext = nil;
@@ -292,15 +503,22 @@
 
 @synthesize managedObjectContext = _managedObjectContext;
 
+@synthesize mergingBackgroundChanges = _mergingBackgroundChanges;
+
 #pragma mark Initialization
 
-- (NSManagedObjectModel *)managedObjectModelFromModelFileName:(NSString *)modelFileName inBundle:(NSBundle *)bundle
++ (NSString *)modelFilePathForModelFileName:(NSString *)modelFileName inBundle:(NSBundle *)bundle
 {
     if (! bundle) {
         bundle = [NSBundle mainBundle];
     }
     
-    NSString *modelFilePath = [bundle pathForResource:modelFileName ofType:@"momd"];
+    return [bundle pathForResource:modelFileName ofType:@"momd"];
+}
+
++ (NSManagedObjectModel *)managedObjectModelFromModelFileName:(NSString *)modelFileName inBundle:(NSBundle *)bundle
+{
+    NSString *modelFilePath = [self modelFilePathForModelFileName:modelFileName inBundle:bundle];
     if (! modelFilePath) {
         HLSLoggerError(@"Model file not found in main bundle");
         return nil;
@@ -310,11 +528,12 @@
     return [[[NSManagedObjectModel alloc] initWithContentsOfURL:modelFileURL] autorelease];
 }
 
-- (NSPersistentStoreCoordinator *)persistentStoreCoordinatorForManagedObjectModel:(NSManagedObjectModel *)managedObjectModel
++ (NSPersistentStoreCoordinator *)persistentStoreCoordinatorForManagedObjectModel:(NSManagedObjectModel *)managedObjectModel
                                                                         storeType:(NSString *)storeType 
                                                                     configuration:(NSString *)configuration 
                                                                               URL:(NSURL *)storeURL 
                                                                           options:(NSDictionary *)options
+                                                                            error:(NSError **)pError
 {
     NSPersistentStoreCoordinator *persistentStoreCoordinator = [[[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:managedObjectModel] autorelease];
     
@@ -326,6 +545,9 @@
                                                                                           error:&error];
     if (! persistentStore) {
         HLSLoggerError(@"Failed to create persistent store. Reason: %@", [error localizedDescription]);
+        if (pError) {
+            *pError = error;
+        }
         return nil;
     }
     
@@ -346,6 +568,179 @@
     return persistentStoreCoordinator;
 }
 
+/**
+ * Perform the lightweight migration of an existing file-based store explicitly, so that its progress can be reported.
+ * Return YES if the store has been migrated or if it must be left to the persistent store coordinator (no migration
+ * needed, migration not enabled by the options, or model of the existing store not found)
+ */
++ (BOOL)migrateStoreIfNeededAtURL:(NSURL *)storeURL
+                        storeType:(NSString *)storeType
+                    configuration:(NSString *)configuration
+             toManagedObjectModel:(NSManagedObjectModel *)managedObjectModel
+                    modelFilePath:(NSString *)modelFilePath
+                          options:(NSDictionary *)options
+                 blockTaskContext:(id<HLSBlockTaskContext>)blockTaskContext
+                            error:(NSError **)pError
+{
+    if (! [[options objectForKey:NSMigratePersistentStoresAutomaticallyOption] boolValue]
+            || ! [[options objectForKey:NSInferMappingModelAutomaticallyOption] boolValue]) {
+        return YES;
+    }
+    
+    HLSFileManager *fileManager = [HLSFileManager defaultManager];
+    if (! [storeURL isFileURL] || ! [fileManager fileExistsAtPath:[storeURL path]]) {
+        return YES;
+    }
+    
+    NSDictionary *metadata = [NSPersistentStoreCoordinator metadataForPersistentStoreOfType:storeType URL:storeURL error:pError];
+    if (! metadata) {
+        return NO;
+    }
+    
+    if ([managedObjectModel isConfiguration:configuration compatibleWithStoreMetadata:metadata]) {
+        return YES;
+    }
+    
+    // Look for the model version of the existing store among the versions stored in the model file
+    NSManagedObjectModel *sourceManagedObjectModel = nil;
+    NSString *modelDirectoryName = [modelFilePath lastPathComponent];
+    NSBundle *modelBundle = [NSBundle bundleWithPath:[modelFilePath stringByDeletingLastPathComponent]];
+    for (NSString *versionFilePath in [modelBundle pathsForResourcesOfType:@"mom" inDirectory:modelDirectoryName]) {
+        NSManagedObjectModel *versionManagedObjectModel = [[[NSManagedObjectModel alloc] initWithContentsOfURL:[NSURL fileURLWithPath:versionFilePath]] autorelease];
+        if ([versionManagedObjectModel isConfiguration:configuration compatibleWithStoreMetadata:metadata]) {
+            sourceManagedObjectModel = versionManagedObjectModel;
+            break;
+        }
+    }
+    if (! sourceManagedObjectModel) {
+        HLSLoggerWarn(@"The model of the store at %@ was not found; migration progress cannot be reported", storeURL);
+        return YES;
+    }
+    
+    NSMappingModel *mappingModel = [NSMappingModel inferredMappingModelForSourceModel:sourceManagedObjectModel
+                                                                     destinationModel:managedObjectModel
+                                                                                error:pError];
+    if (! mappingModel) {
+        return NO;
+    }
+    
+    // Migrate into a new file, which replaces the existing store when done. The existing store is kept with the
+    // same name as the backup made by Core Data for automatic migrations
+    NSString *storeFilePath = [storeURL path];
+    NSString *storeFileName = [storeFilePath lastPathComponent];
+    NSString *storeDirectory = [storeFilePath stringByDeletingLastPathComponent];
+    NSString *migratedStoreFilePath = [storeDirectory stringByAppendingPathComponent:[NSString stringWithFormat:@"~migrated~%@", storeFileName]];
+    NSString *oldStoreFilePath = [storeDirectory stringByAppendingPathComponent:[NSString stringWithFormat:@"~%@", storeFileName]];
+    
+    if (! removeStoreFiles(fileManager, migratedStoreFilePath, pError)) {
+        return NO;
+    }
+    
+    NSMigrationManager *migrationManager = [[[NSMigrationManager alloc] initWithSourceModel:sourceManagedObjectModel
+                                                                           destinationModel:managedObjectModel] autorelease];
+    HLSStoreMigrationObserver *migrationObserver = [[[HLSStoreMigrationObserver alloc] initWithBlockTaskContext:blockTaskContext] autorelease];
+    [migrationManager addObserver:migrationObserver forKeyPath:@"migrationProgress" options:0 context:NULL];
+    
+    HLSLoggerInfo(@"Migrating the store at %@", storeURL);
+    HLSLoggerSpanBegin(span, "HLSModelManager store migration");
+    BOOL migrated = [migrationManager migrateStoreFromURL:storeURL
+                                                     type:storeType
+                                                  options:nil
+                                         withMappingModel:mappingModel
+                                         toDestinationURL:[NSURL fileURLWithPath:migratedStoreFilePath]
+                                          destinationType:storeType
+                                       destinationOptions:nil
+                                                    error:pError];
+    HLSLoggerSpanEnd(span);
+    
+    [migrationManager removeObserver:migrationObserver forKeyPath:@"migrationProgress"];
+    
+    if (! migrated) {
+        removeStoreFiles(fileManager, migratedStoreFilePath, NULL);
+        return NO;
+    }
+    
+    if (! removeStoreFiles(fileManager, oldStoreFilePath, pError)) {
+        return NO;
+    }
+    
+    if (! moveStoreFiles(fileManager, storeFilePath, oldStoreFilePath, pError)) {
+        return NO;
+    }
+    
+    if (! moveStoreFiles(fileManager, migratedStoreFilePath, storeFilePath, pError)) {
+        // Restore the existing store
+        moveStoreFiles(fileManager, oldStoreFilePath, storeFilePath, NULL);
+        return NO;
+    }
+    
+    return YES;
+}
+
+/**
+ * Create a model manager, reporting progress to a block task context. The model and the store are opened on the
+ * calling (secondary) thread, the context is created on the main thread
+ */
++ (HLSModelManager *)modelManagerWithModelFileName:(NSString *)modelFileName
+                                          inBundle:(NSBundle *)bundle
+                                         storeType:(NSString *)storeType
+                                     configuration:(NSString *)configuration
+                                    storeDirectory:(NSString *)storeDirectory
+                                           options:(NSDictionary *)options
+                                  blockTaskContext:(id<HLSBlockTaskContext>)blockTaskContext
+                                             error:(NSError **)pError
+{
+    NSAssert(! [NSThread isMainThread], @"Must not be called from the main thread");
+    
+    NSString *modelFilePath = [self modelFilePathForModelFileName:modelFileName inBundle:bundle];
+    NSManagedObjectModel *managedObjectModel = [self managedObjectModelFromModelFileName:modelFileName inBundle:bundle];
+    if (! managedObjectModel) {
+        if (pError) {
+            *pError = [HLSError errorWithDomain:NSCocoaErrorDomain
+                                           code:NSCoreDataError];
+        }
+        return nil;
+    }
+    [blockTaskContext updateProgressToValue:kModelManagerMigrationProgressBegin];
+    
+    NSURL *standardStoreURL = [self standardStoreURLForModelFileName:modelFileName
+                                                           storeType:storeType
+                                                      storeDirectory:storeDirectory];
+    if (! [self migrateStoreIfNeededAtURL:standardStoreURL
+                                storeType:storeType
+                            configuration:configuration
+                     toManagedObjectModel:managedObjectModel
+                            modelFilePath:modelFilePath
+                                  options:options
+                         blockTaskContext:blockTaskContext
+                                    error:pError]) {
+        HLSLoggerError(@"Failed to migrate the store at %@", standardStoreURL);
+        return nil;
+    }
+    [blockTaskContext updateProgressToValue:kModelManagerMigrationProgressEnd];
+    
+    NSPersistentStoreCoordinator *persistentStoreCoordinator = [self persistentStoreCoordinatorForManagedObjectModel:managedObjectModel
+                                                                                                          storeType:storeType
+                                                                                                      configuration:configuration
+                                                                                                                URL:standardStoreURL
+                                                                                                            options:options
+                                                                                                              error:pError];
+    if (! persistentStoreCoordinator) {
+        return nil;
+    }
+    
+    // The context is used on the main thread and must therefore be created there
+    __block HLSModelManager *modelManager = nil;
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        modelManager = [[HLSModelManager alloc] init];
+        modelManager.managedObjectModel = managedObjectModel;
+        modelManager.persistentStoreCoordinator = persistentStoreCoordinator;
+        modelManager.managedObjectContext = [modelManager managedObjectContextForPersistentStoreCoordinator:persistentStoreCoordinator];
+        modelManager.mergingBackgroundChanges = YES;
+    });
+    return [modelManager autorelease];
+}
+
 - (NSManagedObjectContext *)managedObjectContextForPersistentStoreCoordinator:(NSPersistentStoreCoordinator *)persistentStoreCoordinator
 {
     NSManagedObjectContext *managedObjectContext = [[[NSManagedObjectContext alloc] init] autorelease];
@@ -363,14 +758,265 @@
     modelManager.managedObjectContext = [self managedObjectContextForPersistentStoreCoordinator:self.persistentStoreCoordinator];
     modelManager.managedObjectModel = self.managedObjectModel;
     modelManager.persistentStoreCoordinator = self.persistentStoreCoordinator;
+    modelManager.mergingBackgroundChanges = self.mergingBackgroundChanges;
     
     return modelManager;
 }
 
+#pragma mark Worker model managers
+
+- (HLSModelManager *)dequeueWorkerModelManager
+{
+    OSSpinLockLock(&_workerContextsLock);
+    NSManagedObjectContext *workerContext = [[_workerContexts lastObject] retain];
+    if (workerContext) {
+        [_workerContexts removeLastObject];
+    }
+    OSSpinLockUnlock(&_workerContextsLock);
+    
+    if (! workerContext) {
+        return [self duplicate];
+    }
+    
+    HLSModelManager *workerModelManager = [[[HLSModelManager alloc] init] autorelease];
+    workerModelManager.managedObjectContext = workerContext;
+    workerModelManager.managedObjectModel = self.managedObjectModel;
+    workerModelManager.persistentStoreCoordinator = self.persistentStoreCoordinator;
+    workerModelManager.mergingBackgroundChanges = self.mergingBackgroundChanges;
+    [workerContext release];
+    
+    return workerModelManager;
+}
+
+- (void)recycleWorkerModelManager:(HLSModelManager *)workerModelManager
+{
+    if (! workerModelManager) {
+        HLSLoggerError(@"Missing worker model manager");
+        return;
+    }
+    
+    NSManagedObjectContext *workerContext = workerModelManager.managedObjectContext;
+    if (workerModelManager.persistentStoreCoordinator != self.persistentStoreCoordinator) {
+        HLSLoggerError(@"The worker model manager does not share the persistent store coordinator of the receiver");
+        return;
+    }
+    
+    if ([workerContext hasChanges]) {
+        HLSLoggerWarn(@"The context of the worker model manager has unsaved changes and is not recycled");
+        return;
+    }
+    
+    // Reset on the thread which used the context, so that it is clean when used next
+    [workerContext reset];
+    
+    OSSpinLockLock(&_workerContextsLock);
+    if (! _workerContexts) {
+        _workerContexts = [[NSMutableArray alloc] init];
+    }
+    if ([_workerContexts count] < kModelManagerWorkerContextsCapacity && ! [_workerContexts containsObject:workerContext]) {
+        [_workerContexts addObject:workerContext];
+    }
+    OSSpinLockUnlock(&_workerContextsLock);
+    
+    // The worker model manager must not be used anymore
+    workerModelManager.managedObjectContext = nil;
+}
+
 - (BOOL)migrateStoreToURL:(NSURL *)url withStoreType:(NSString *)storeType error:(NSError **)pError
 {
     NSPersistentStore *persistentStore = [[self.persistentStoreCoordinator persistentStores] firstObject_hls];
     return [self.persistentStoreCoordinator migratePersistentStore:persistentStore toURL:url options:nil withType:storeType error:pError] != nil;
 }
 
+- (HLSTask *)taskMigratingStoreToURL:(NSURL *)url withStoreType:(NSString *)storeType
+{
+    return [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        // Progress must not be reported while the coordinator is locked (notifications are delivered synchronously on
+        // the main thread, which might be waiting for the lock)
+        NSError *error = nil;
+        [self.persistentStoreCoordinator lock];
+        HLSLoggerSpanBegin(span, "HLSModelManager store migration");
+        BOOL migrated = [self migrateStoreToURL:url withStoreType:storeType error:&error];
+        HLSLoggerSpanEnd(span);
+        [self.persistentStoreCoordinator unlock];
+        
+        if (migrated) {
+            [context updateProgressToValue:1.f];
+        }
+        else {
+            HLSLoggerError(@"Failed to migrate the store to %@; reason: %@", url, error);
+            [context attachError:error];
+        }
+        
+        [pool drain];
+    }];
+}
+
+#pragma mark Background tasks
+
+- (void)performBackgroundTask:(HLSModelManagerBackgroundTaskBlock)block
+              completionBlock:(HLSModelManagerBackgroundTaskCompletionBlock)completionBlock
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (! block) {
+        HLSLoggerError(@"Missing block");
+        return;
+    }
+    
+    if (! _backgroundQueue) {
+        _backgroundQueue = dispatch_queue_create("ch.hortis.CoconutKit.HLSModelManager", NULL);
+    }
+    
+    dispatch_async(_backgroundQueue, ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        // The worker context is used within this block only, and is therefore confined to a single thread
+        HLSModelManager *workerModelManager = [self dequeueWorkerModelManager];
+        NSManagedObjectContext *workerContext = workerModelManager.managedObjectContext;
+        
+        [HLSModelManager pushModelManager:workerModelManager];
+        block(workerContext);
+        [HLSModelManager popModelManager];
+        
+        NSError *error = nil;
+        if (! [self saveWorkerContext:workerContext error:&error]) {
+            HLSLoggerError(@"Could not save background task changes; reason: %@", error);
+            [workerContext rollback];
+        }
+        [self recycleWorkerModelManager:workerModelManager];
+        
+        // The error must survive the pool
+        [error retain];
+        [pool drain];
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (completionBlock) {
+                completionBlock(error);
+            }
+        });
+        [error release];
+    });
+}
+
+- (BOOL)saveWorkerContext:(NSManagedObjectContext *)workerContext error:(NSError **)pError
+{
+    NSAssert(! [NSThread isMainThread], @"Must not be called from the main thread");
+    
+    if (! [workerContext hasChanges]) {
+        return YES;
+    }
+    
+    // Merge on the main thread, waiting until the merge is done so that the saved objects are still alive
+    id observer = nil;
+    if (self.mergingBackgroundChanges) {
+        observer = [[NSNotificationCenter defaultCenter] addObserverForName:NSManagedObjectContextDidSaveNotification
+                                                                     object:workerContext
+                                                                      queue:nil
+                                                                 usingBlock:^(NSNotification *notification) {
+                                                                     dispatch_sync(dispatch_get_main_queue(), ^{
+                                                                         [self.managedObjectContext mergeChangesFromContextDidSaveNotification:notification];
+                                                                     });
+                                                                 }];
+    }
+    
+    HLSLoggerSpanBegin(span, "HLSModelManager worker context save");
+    BOOL saved = [workerContext save:pError];
+    HLSLoggerSpanEnd(span);
+    
+    if (observer) {
+        [[NSNotificationCenter defaultCenter] removeObserver:observer];
+    }
+    
+    return saved;
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSStoreMigrationObserver class implementation
+
+@implementation HLSStoreMigrationObserver
+
+#pragma mark Object creation and destruction
+
+- (id)initWithBlockTaskContext:(id<HLSBlockTaskContext>)blockTaskContext
+{
+    if ((self = [super init])) {
+        _blockTaskContext = [blockTaskContext retain];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_blockTaskContext release];
+    
+    [super dealloc];
+}
+
+#pragma mark Key-value observing
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
+{
+    NSMigrationManager *migrationManager = (NSMigrationManager *)object;
+    float progress = kModelManagerMigrationProgressBegin 
+        + (kModelManagerMigrationProgressEnd - kModelManagerMigrationProgressBegin) * migrationManager.migrationProgress;
+    
+    // Progress updates are delivered synchronously on the main thread, report significant changes only
+    if (progress - _reportedProgress < 0.01f) {
+        return;
+    }
+    
+    [_blockTaskContext updateProgressToValue:progress];
+    _reportedProgress = progress;
+}
+
 @end
+
+#pragma mark -
+#pragma mark Static functions
+
+static void releaseModelManagerStack(void *modelManagerStack)
+{
+    // Called when the thread exits, releasing model managers might autorelease objects
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    [(NSMutableArray *)modelManagerStack release];
+    [pool drain];
+}
+
+// SQLite stores using write-ahead logging are made of the store file and of -wal and -shm files, which must be kept together
+static NSArray *storeFileSuffixes(void)
+{
+    static NSArray *s_suffixes = nil;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        s_suffixes = [[NSArray alloc] initWithObjects:@"", @"-wal", @"-shm", nil];
+    });
+    return s_suffixes;
+}
+
+static BOOL removeStoreFiles(HLSFileManager *fileManager, NSString *storeFilePath, NSError **pError)
+{
+    for (NSString *suffix in storeFileSuffixes()) {
+        NSString *filePath = [storeFilePath stringByAppendingString:suffix];
+        if ([fileManager fileExistsAtPath:filePath] && ! [fileManager removeItemAtPath:filePath error:pError]) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+static BOOL moveStoreFiles(HLSFileManager *fileManager, NSString *storeFilePath, NSString *destinationStoreFilePath, NSError **pError)
+{
+    for (NSString *suffix in storeFileSuffixes()) {
+        NSString *filePath = [storeFilePath stringByAppendingString:suffix];
+        if ([fileManager fileExistsAtPath:filePath]
+                && ! [fileManager moveItemAtPath:filePath toPath:[destinationStoreFilePath stringByAppendingString:suffix] error:pError]) {
+            return NO;
+        }
+    }
+    return YES;
+}
@@ -6,6 +6,27 @@
 //  Copyright (c) 2011 Hortis. All rights reserved.
 //
 
+#import "HLSFetchOptions.h"
+
+/**
+ * Aggregate functions which can be evaluated by the persistent store
+ */
+typedef enum {
+    HLSAggregateFunctionEnumBegin = 0,
+    HLSAggregateFunctionSum = HLSAggregateFunctionEnumBegin,
+    HLSAggregateFunctionMinimum,
+    HLSAggregateFunctionMaximum,
+    HLSAggregateFunctionAverage,
+    HLSAggregateFunctionEnumEnd,
+    HLSAggregateFunctionEnumSize = HLSAggregateFunctionEnumEnd - HLSAggregateFunctionEnumBegin
+} HLSAggregateFunction;
+
+/**
+ * Block called after each batch of a batched deletion, with the number of objects deleted so far and the total number
+ * of objects to delete. Set *pStop to YES to stop the deletion
+ */
+typedef void (^HLSManagedObjectDeletionProgressBlock)(NSUInteger deletedObjectCount, NSUInteger objectCount, BOOL *pStop);
+
 /**
  * Convenience methods to perform common Core Data operations on managed objects. Most methods appear in two versions:
  *   - a version expecting a managed object context parameter:  
@@ -34,6 +55,18 @@
 + (NSArray *)filteredObjectsUsingPredicate:(NSPredicate *)predicate
                     sortedUsingDescriptors:(NSArray *)sortDescriptors;
 
+/**
+ * Same as the methods above, applying the specified fetch options (which can be nil). Use them to query large lists
+ * efficiently (see HLSFetchOptions)
+ */
++ (NSArray *)filteredObjectsUsingPredicate:(NSPredicate *)predicate
+                    sortedUsingDescriptors:(NSArray *)sortDescriptors
+                              fetchOptions:(HLSFetchOptions *)fetchOptions
+                    inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext;
++ (NSArray *)filteredObjectsUsingPredicate:(NSPredicate *)predicate
+                    sortedUsingDescriptors:(NSArray *)sortDescriptors
+                              fetchOptions:(HLSFetchOptions *)fetchOptions;
+
 + (NSArray *)filteredObjectsUsingPredicate:(NSPredicate *)predicate
                      sortedUsingDescriptor:(NSSortDescriptor *)sortDescriptor
                     inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext;
@@ -59,6 +92,38 @@
 + (NSArray *)allObjectsInManagedObjectContext:(NSManagedObjectContext *)managedObjectContext;
 + (NSArray *)allObjects;
 
+/**
+ * When called on an NSManagedObject subclass, count its instances matching a predicate (nil for all instances) without
+ * fetching them (without context parameter, the current HLSModelManager context is used). Return NSNotFound on failure
+ */
++ (NSUInteger)countOfObjectsUsingPredicate:(NSPredicate *)predicate
+                    inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext;
++ (NSUInteger)countOfObjectsUsingPredicate:(NSPredicate *)predicate;
+
+/**
+ * When called on an NSManagedObject subclass, return YES iff at least one instance matches a predicate (nil for any
+ * instance). No object is fetched (without context parameter, the current HLSModelManager context is used)
+ */
++ (BOOL)existsObjectUsingPredicate:(NSPredicate *)predicate
+            inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext;
++ (BOOL)existsObjectUsingPredicate:(NSPredicate *)predicate;
+
+/**
+ * When called on an NSManagedObject subclass, evaluate an aggregate function over an attribute of its instances matching
+ * a predicate (nil for all instances). The computation is performed by the persistent store, no object is fetched. Note
+ * that changes which have not been saved yet are therefore not taken into account (without context parameter, the current
+ * HLSModelManager context is used)
+ *
+ * Return nil on failure or if no instance matches
+ */
++ (id)aggregateValueUsingFunction:(HLSAggregateFunction)function
+                           forKey:(NSString *)key
+                   usingPredicate:(NSPredicate *)predicate
+           inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext;
++ (id)aggregateValueUsingFunction:(HLSAggregateFunction)function
+                           forKey:(NSString *)key
+                   usingPredicate:(NSPredicate *)predicate;
+
 /**
  * When called on an NSManagedObject subclass, deletes all of its instances (without context parameter, the current 
  * HLSModelManager context is used)
@@ -66,6 +131,32 @@
 + (void)deleteAllObjectsInManagedObjectContext:(NSManagedObjectContext *)managedObjectContext;
 + (void)deleteAllObjects;
 
+/**
+ * When called on an NSManagedObject subclass, delete all of its instances in batches of the given size, with bounded
+ * memory use (without context parameter, the current HLSModelManager context is used). Only object ids are fetched,
+ * and each batch is processed within its own autorelease pool. This is the method to use for large entities.
+ *
+ * If saving is set to YES, the context is saved after each batch. Objects are then fetched batch by batch, and deleted
+ * objects are not kept in memory until the deletion ends. If saving is set to NO, all object ids are fetched at once (objects
+ * themselves are not), and you are responsible of saving the context afterwards.
+ *
+ * The progress block (which can be nil) is called after each batch, on the thread the method was called from. It can
+ * be used to run the deletion as an HLSBlockTask, forwarding progress and cancellation to the task context (use a
+ * managed object context dedicated to the task thread in this case).
+ *
+ * Return YES iff successful (a stopped deletion is successful). If saving fails, the changes of the failed batch are 
+ * left unsaved in the context
+ */
++ (BOOL)deleteAllObjectsInManagedObjectContext:(NSManagedObjectContext *)managedObjectContext
+                                     batchSize:(NSUInteger)batchSize
+                                        saving:(BOOL)saving
+                                 progressBlock:(HLSManagedObjectDeletionProgressBlock)progressBlock
+                                         error:(NSError **)pError;
++ (BOOL)deleteAllObjectsWithBatchSize:(NSUInteger)batchSize
+                               saving:(BOOL)saving
+                        progressBlock:(HLSManagedObjectDeletionProgressBlock)progressBlock
+                                error:(NSError **)pError;
+
 /**
  * Create a copy of the receiver if it implements the HLSManagedObjectCopying protocol. The copy is created in the same
  * managed object context which the receiver belongs to. If the receiver does not implement the HLSManagedObjectCopying
@@ -77,7 +168,11 @@
  *   - a shallow copy is performed for attributes
  *   - for relationships, a shallow copy is performed, except if the relationship corresponds to ownership of one
  *     or more objects also implementing the HLSManagedObjectCopying protocol (ownership is assumed when the relationship
- *     deletion behavior is set to cascade)
+ *     deletion behavior is set to cascade). An object owned several times within the graph being copied is copied
+ *     only once
+ *
+ * Owned objects are fetched from the store in batches before being copied, and property metadata is computed once
+ * per entity, so that large object graphs can be duplicated efficiently.
  *
  * After the method successfully returns an object, you must still commit the changes by calling -save: on the
  * managed object context in which it was created.
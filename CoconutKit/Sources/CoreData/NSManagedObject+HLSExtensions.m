@@ -14,14 +14,43 @@
 #import "HLSModelManager.h"
 #import "NSObject+HLSExtensions.h"
 
+#import <libkern/OSAtomic.h>
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryCoreData
+
+// Keys under which the property metadata used when duplicating objects is stored
+static NSString * const kDuplicationAttributeNamesKey = @"attributeNames";
+static NSString * const kDuplicationOwningToManyRelationshipNamesKey = @"owningToManyRelationshipNames";
+static NSString * const kDuplicationOwningToOneRelationshipNamesKey = @"owningToOneRelationshipNames";
+static NSString * const kDuplicationOtherRelationshipNamesKey = @"otherRelationshipNames";
+
+// Variables with internal linkage
+static CFMutableDictionaryRef s_entityToDuplicationMetadataMap = NULL;
+static OSSpinLock s_duplicationMetadataLock = OS_SPINLOCK_INIT;
+static CFMutableDictionaryRef s_modelToClassToEntityMapMap = NULL;
+static OSSpinLock s_entityDescriptionLock = OS_SPINLOCK_INIT;
+
+// Function declarations
+static NSEntityDescription *entityDescriptionForClass(Class class, NSManagedObjectContext *managedObjectContext);
+static NSDictionary *duplicationMetadataForEntity(NSEntityDescription *entityDescription);
+static void prefetchObjects(NSSet *objects, NSManagedObjectContext *managedObjectContext);
+static NSManagedObject *duplicateObject(NSManagedObject *object, CFMutableDictionaryRef sourceToCopyMap);
+static NSManagedObject *duplicateOwnedObject(NSManagedObject *ownedObject, CFMutableDictionaryRef sourceToCopyMap);
+
 @implementation NSManagedObject (HLSExtensions)
 
 #pragma mark Class methods
 
 + (id)insertIntoManagedObjectContext:(NSManagedObjectContext *)managedObjectContext
 {
-    return [NSEntityDescription insertNewObjectForEntityForName:[self className] 
-                                         inManagedObjectContext:managedObjectContext];
+    NSEntityDescription *entityDescription = entityDescriptionForClass(self, managedObjectContext);
+    if (! entityDescription) {
+        HLSLoggerError(@"No entity %@ found in the model", [self className]);
+        return nil;
+    }
+    
+    return [[[self alloc] initWithEntity:entityDescription insertIntoManagedObjectContext:managedObjectContext] autorelease];
 }
 
 + (id)insert
@@ -31,6 +60,7 @@
 
 + (NSArray *)filteredObjectsUsingPredicate:(NSPredicate *)predicate
                     sortedUsingDescriptors:(NSArray *)sortDescriptors
+                              fetchOptions:(HLSFetchOptions *)fetchOptions
                     inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext
 {
     HLSAssertObjectsInEnumerationAreKindOfClass(sortDescriptors, NSSortDescriptor);
@@ -39,12 +69,12 @@
         return nil;
     }
     
-    NSEntityDescription *entityDescription = [NSEntityDescription entityForName:[self className]
-                                                         inManagedObjectContext:managedObjectContext];
+    NSEntityDescription *entityDescription = entityDescriptionForClass(self, managedObjectContext);
     NSFetchRequest *fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
     [fetchRequest setEntity:entityDescription];
     fetchRequest.sortDescriptors = sortDescriptors;
     fetchRequest.predicate = predicate;
+    [fetchOptions applyToFetchRequest:fetchRequest];
     
     NSError *error = nil;
     NSArray *objects = [managedObjectContext executeFetchRequest:fetchRequest error:&error];
@@ -56,6 +86,26 @@
     return objects;
 }
 
++ (NSArray *)filteredObjectsUsingPredicate:(NSPredicate *)predicate
+                    sortedUsingDescriptors:(NSArray *)sortDescriptors
+                              fetchOptions:(HLSFetchOptions *)fetchOptions
+{
+    return [self filteredObjectsUsingPredicate:predicate
+                        sortedUsingDescriptors:sortDescriptors
+                                  fetchOptions:fetchOptions
+                        inManagedObjectContext:[HLSModelManager currentModelContext]];
+}
+
++ (NSArray *)filteredObjectsUsingPredicate:(NSPredicate *)predicate
+                    sortedUsingDescriptors:(NSArray *)sortDescriptors
+                    inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext
+{
+    return [self filteredObjectsUsingPredicate:predicate
+                        sortedUsingDescriptors:sortDescriptors
+                                  fetchOptions:nil
+                        inManagedObjectContext:managedObjectContext];
+}
+
 + (NSArray *)filteredObjectsUsingPredicate:(NSPredicate *)predicate
                     sortedUsingDescriptors:(NSArray *)sortDescriptors
 {
@@ -120,9 +170,154 @@
     return [self allObjectsInManagedObjectContext:[HLSModelManager currentModelContext]];
 }
 
++ (NSUInteger)countOfObjectsUsingPredicate:(NSPredicate *)predicate
+                    inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext
+{
+    if (! managedObjectContext) {
+        HLSLoggerError(@"Missing managed object context");
+        return NSNotFound;
+    }
+    
+    NSEntityDescription *entityDescription = entityDescriptionForClass(self, managedObjectContext);
+    NSFetchRequest *fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
+    [fetchRequest setEntity:entityDescription];
+    fetchRequest.predicate = predicate;
+    
+    NSError *error = nil;
+    NSUInteger count = [managedObjectContext countForFetchRequest:fetchRequest error:&error];
+    if (error) {
+        HLSLoggerError(@"Could not count objects; reason: %@", error);
+        return NSNotFound;
+    }
+    
+    return count;
+}
+
++ (NSUInteger)countOfObjectsUsingPredicate:(NSPredicate *)predicate
+{
+    return [self countOfObjectsUsingPredicate:predicate inManagedObjectContext:[HLSModelManager currentModelContext]];
+}
+
++ (BOOL)existsObjectUsingPredicate:(NSPredicate *)predicate
+            inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext
+{
+    if (! managedObjectContext) {
+        HLSLoggerError(@"Missing managed object context");
+        return NO;
+    }
+    
+    NSEntityDescription *entityDescription = entityDescriptionForClass(self, managedObjectContext);
+    NSFetchRequest *fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
+    [fetchRequest setEntity:entityDescription];
+    fetchRequest.predicate = predicate;
+    
+    // The store can stop at the first match
+    [fetchRequest setFetchLimit:1];
+    
+    NSError *error = nil;
+    NSUInteger count = [managedObjectContext countForFetchRequest:fetchRequest error:&error];
+    if (error) {
+        HLSLoggerError(@"Could not count objects; reason: %@", error);
+        return NO;
+    }
+    
+    return count != 0;
+}
+
++ (BOOL)existsObjectUsingPredicate:(NSPredicate *)predicate
+{
+    return [self existsObjectUsingPredicate:predicate inManagedObjectContext:[HLSModelManager currentModelContext]];
+}
+
++ (id)aggregateValueUsingFunction:(HLSAggregateFunction)function
+                           forKey:(NSString *)key
+                   usingPredicate:(NSPredicate *)predicate
+           inManagedObjectContext:(NSManagedObjectContext *)managedObjectContext
+{
+    if (! managedObjectContext) {
+        HLSLoggerError(@"Missing managed object context");
+        return nil;
+    }
+    
+    NSString *functionName = nil;
+    switch (function) {
+        case HLSAggregateFunctionSum: {
+            functionName = @"sum:";
+            break;
+        }
+            
+        case HLSAggregateFunctionMinimum: {
+            functionName = @"min:";
+            break;
+        }
+            
+        case HLSAggregateFunctionMaximum: {
+            functionName = @"max:";
+            break;
+        }
+            
+        case HLSAggregateFunctionAverage: {
+            functionName = @"average:";
+            break;
+        }
+            
+        default: {
+            HLSLoggerError(@"Unknown aggregate function");
+            return nil;
+            break;
+        }
+    }
+    
+    NSEntityDescription *entityDescription = entityDescriptionForClass(self, managedObjectContext);
+    NSAttributeDescription *attributeDescription = [[entityDescription attributesByName] objectForKey:key];
+    if (! attributeDescription) {
+        HLSLoggerError(@"The entity %@ has no attribute %@", [entityDescription name], key);
+        return nil;
+    }
+    
+    // The average of integers is not an integer
+    NSAttributeType resultType = (function == HLSAggregateFunctionAverage) ? NSDoubleAttributeType : [attributeDescription attributeType];
+    
+    NSExpression *keyPathExpression = [NSExpression expressionForKeyPath:key];
+    NSExpressionDescription *expressionDescription = [[[NSExpressionDescription alloc] init] autorelease];
+    [expressionDescription setName:@"aggregateValue"];
+    [expressionDescription setExpression:[NSExpression expressionForFunction:functionName
+                                                                   arguments:[NSArray arrayWithObject:keyPathExpression]]];
+    [expressionDescription setExpressionResultType:resultType];
+    
+    NSFetchRequest *fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
+    [fetchRequest setEntity:entityDescription];
+    fetchRequest.predicate = predicate;
+    [fetchRequest setResultType:NSDictionaryResultType];
+    [fetchRequest setPropertiesToFetch:[NSArray arrayWithObject:expressionDescription]];
+    
+    NSError *error = nil;
+    NSArray *results = [managedObjectContext executeFetchRequest:fetchRequest error:&error];
+    if (error) {
+        HLSLoggerError(@"Could not compute aggregate value; reason: %@", error);
+        return nil;
+    }
+    
+    if ([results count] == 0) {
+        return nil;
+    }
+    
+    return [[results objectAtIndex:0] objectForKey:@"aggregateValue"];
+}
+
++ (id)aggregateValueUsingFunction:(HLSAggregateFunction)function
+                           forKey:(NSString *)key
+                   usingPredicate:(NSPredicate *)predicate
+{
+    return [self aggregateValueUsingFunction:function
+                                      forKey:key
+                              usingPredicate:predicate
+                      inManagedObjectContext:[HLSModelManager currentModelContext]];
+}
+
 + (void)deleteAllObjectsInManagedObjectContext:(NSManagedObjectContext *)managedObjectContext
 {
-    NSArray *allObjects = [self allObjects];
+    NSArray *allObjects = [self allObjectsInManagedObjectContext:managedObjectContext];
     for (NSManagedObject *managedObject in allObjects) {
         [managedObjectContext deleteObject:managedObject];
     }
@@ -133,82 +328,353 @@
     [self deleteAllObjectsInManagedObjectContext:[HLSModelManager currentModelContext]];
 }
 
++ (BOOL)deleteAllObjectsInManagedObjectContext:(NSManagedObjectContext *)managedObjectContext
+                                     batchSize:(NSUInteger)batchSize
+                                        saving:(BOOL)saving
+                                 progressBlock:(HLSManagedObjectDeletionProgressBlock)progressBlock
+                                         error:(NSError **)pError
+{
+    if (! managedObjectContext) {
+        HLSLoggerError(@"Missing managed object context");
+        return NO;
+    }
+    
+    if (batchSize == 0) {
+        HLSLoggerError(@"The batch size must be > 0");
+        return NO;
+    }
+    
+    NSEntityDescription *entityDescription = entityDescriptionForClass(self, managedObjectContext);
+    NSFetchRequest *fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
+    [fetchRequest setEntity:entityDescription];
+    [fetchRequest setResultType:NSManagedObjectIDResultType];
+    
+    // When saving, deleted objects disappear from the store, so that each batch is simply made of the first objects
+    // found. Otherwise deletions remain pending and fetch limits cannot be used reliably (they are applied before
+    // pending deletions are taken into account). All ids are fetched at once in this case
+    NSError *error = nil;
+    NSArray *allObjectIDs = nil;
+    NSUInteger objectCount = 0;
+    if (saving) {
+        objectCount = [managedObjectContext countForFetchRequest:fetchRequest error:&error];
+        [fetchRequest setFetchLimit:batchSize];
+    }
+    else {
+        allObjectIDs = [managedObjectContext executeFetchRequest:fetchRequest error:&error];
+        objectCount = [allObjectIDs count];
+    }
+    if (error) {
+        HLSLoggerError(@"Could not retrieve objects; reason: %@", error);
+        if (pError) {
+            *pError = error;
+        }
+        return NO;
+    }
+    
+    NSUInteger deletedObjectCount = 0;
+    BOOL stop = NO;
+    while (! stop && deletedObjectCount < objectCount) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        NSArray *objectIDs = nil;
+        if (saving) {
+            objectIDs = [managedObjectContext executeFetchRequest:fetchRequest error:&error];
+        }
+        else {
+            NSRange range = NSMakeRange(deletedObjectCount, MIN(batchSize, objectCount - deletedObjectCount));
+            objectIDs = [allObjectIDs subarrayWithRange:range];
+        }
+        
+        for (NSManagedObjectID *objectID in objectIDs) {
+            [managedObjectContext deleteObject:[managedObjectContext objectWithID:objectID]];
+        }
+        deletedObjectCount += [objectIDs count];
+        
+        if (! error && saving) {
+            [managedObjectContext save:&error];
+        }
+        
+        // The error must survive the pool
+        [error retain];
+        
+        // Objects deleted elsewhere after they have been counted would otherwise lead to an endless loop
+        if (! error && [objectIDs count] == 0) {
+            stop = YES;
+        }
+        else if (! error && progressBlock) {
+            progressBlock(deletedObjectCount, objectCount, &stop);
+        }
+        
+        [pool drain];
+        
+        if (error) {
+            HLSLoggerError(@"Could not delete objects; reason: %@", error);
+            if (pError) {
+                *pError = [error autorelease];
+            }
+            else {
+                [error release];
+            }
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
++ (BOOL)deleteAllObjectsWithBatchSize:(NSUInteger)batchSize
+                               saving:(BOOL)saving
+                        progressBlock:(HLSManagedObjectDeletionProgressBlock)progressBlock
+                                error:(NSError **)pError
+{
+    return [self deleteAllObjectsInManagedObjectContext:[HLSModelManager currentModelContext]
+                                              batchSize:batchSize
+                                                 saving:saving
+                                          progressBlock:progressBlock
+                                                  error:pError];
+}
+
 #pragma mark Creating a copy
 
 - (id)duplicate
 {
-    if (! [self conformsToProtocol:@protocol(HLSManagedObjectCopying)]) {
+    // Maps each object copied so far to its copy, so that objects owned several times in the graph are copied once
+    CFMutableDictionaryRef sourceToCopyMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    NSManagedObject *objectCopy = duplicateObject(self, sourceToCopyMap);
+    CFRelease(sourceToCopyMap);
+    return objectCopy;
+}
+
+@end
+
+#pragma mark Entity description functions
+
+/**
+ * Return the entity description corresponding to a class in the model of a managed object context. Entity descriptions
+ * are cached per model and class, so that they are not looked up by name each time (models are retained by the cache,
+ * which is fine since applications only use a few of them)
+ */
+static NSEntityDescription *entityDescriptionForClass(Class class, NSManagedObjectContext *managedObjectContext)
+{
+    NSManagedObjectModel *managedObjectModel = managedObjectContext.persistentStoreCoordinator.managedObjectModel;
+    if (! managedObjectModel) {
+        return [NSEntityDescription entityForName:[class className] inManagedObjectContext:managedObjectContext];
+    }
+    
+    OSSpinLockLock(&s_entityDescriptionLock);
+    if (! s_modelToClassToEntityMapMap) {
+        s_modelToClassToEntityMapMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks,
+                                                                 &kCFTypeDictionaryValueCallBacks);
+    }
+    
+    // Classes are never deallocated and are used as keys without being retained
+    CFMutableDictionaryRef classToEntityMap = (CFMutableDictionaryRef)CFDictionaryGetValue(s_modelToClassToEntityMapMap, managedObjectModel);
+    if (! classToEntityMap) {
+        classToEntityMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        CFDictionarySetValue(s_modelToClassToEntityMapMap, managedObjectModel, classToEntityMap);
+        CFRelease(classToEntityMap);
+    }
+    NSEntityDescription *entityDescription = [[(NSEntityDescription *)CFDictionaryGetValue(classToEntityMap, class) retain] autorelease];
+    OSSpinLockUnlock(&s_entityDescriptionLock);
+    if (entityDescription) {
+        return entityDescription;
+    }
+    
+    entityDescription = [[managedObjectModel entitiesByName] objectForKey:[class className]];
+    if (! entityDescription) {
         return nil;
     }
     
-    // Create the deep copy
-    NSManagedObject *objectCopy = [NSEntityDescription insertNewObjectForEntityForName:self.entity.name
-                                                                inManagedObjectContext:self.managedObjectContext];
+    OSSpinLockLock(&s_entityDescriptionLock);
+    CFDictionarySetValue(classToEntityMap, class, entityDescription);
+    OSSpinLockUnlock(&s_entityDescriptionLock);
+    
+    return entityDescription;
+}
+
+#pragma mark Duplication functions
+
+/**
+ * Return the names of the properties of an entity, sorted according to how they are copied. Computed once per entity
+ */
+static NSDictionary *duplicationMetadataForEntity(NSEntityDescription *entityDescription)
+{
+    OSSpinLockLock(&s_duplicationMetadataLock);
+    if (! s_entityToDuplicationMetadataMap) {
+        s_entityToDuplicationMetadataMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks,
+                                                                     &kCFTypeDictionaryValueCallBacks);
+    }
+    NSDictionary *metadata = [[(NSDictionary *)CFDictionaryGetValue(s_entityToDuplicationMetadataMap, entityDescription) retain] autorelease];
+    OSSpinLockUnlock(&s_duplicationMetadataLock);
+    if (metadata) {
+        return metadata;
+    }
+    
+    NSMutableArray *owningToManyRelationshipNames = [NSMutableArray array];
+    NSMutableArray *owningToOneRelationshipNames = [NSMutableArray array];
+    NSMutableArray *otherRelationshipNames = [NSMutableArray array];
+    NSDictionary *relationships = [entityDescription relationshipsByName];
+    for (NSString *relationshipName in [relationships allKeys]) {
+        // Ownership is assumed when the deletion behavior is set to cascade
+        NSRelationshipDescription *relationshipDescription = [relationships objectForKey:relationshipName];
+        if ([relationshipDescription deleteRule] == NSCascadeDeleteRule) {
+            if ([relationshipDescription isToMany]) {
+                [owningToManyRelationshipNames addObject:relationshipName];
+            }
+            else {
+                [owningToOneRelationshipNames addObject:relationshipName];
+            }
+        }
+        else {
+            [otherRelationshipNames addObject:relationshipName];
+        }
+    }
+    
+    metadata = [NSDictionary dictionaryWithObjectsAndKeys:[[entityDescription attributesByName] allKeys], kDuplicationAttributeNamesKey,
+                [NSArray arrayWithArray:owningToManyRelationshipNames], kDuplicationOwningToManyRelationshipNamesKey,
+                [NSArray arrayWithArray:owningToOneRelationshipNames], kDuplicationOwningToOneRelationshipNamesKey,
+                [NSArray arrayWithArray:otherRelationshipNames], kDuplicationOtherRelationshipNamesKey,
+                nil];
+    
+    OSSpinLockLock(&s_duplicationMetadataLock);
+    CFDictionarySetValue(s_entityToDuplicationMetadataMap, entityDescription, metadata);
+    OSSpinLockUnlock(&s_duplicationMetadataLock);
+    
+    return metadata;
+}
+
+/**
+ * Fire the faults of a set of objects with a single fetch request per entity, rather than one by one when they are
+ * accessed
+ */
+static void prefetchObjects(NSSet *objects, NSManagedObjectContext *managedObjectContext)
+{
+    NSMutableDictionary *entityNameToFaultsMap = [NSMutableDictionary dictionary];
+    for (NSManagedObject *object in objects) {
+        if (! [object isFault]) {
+            continue;
+        }
         
+        NSString *entityName = object.entity.name;
+        NSMutableArray *faults = [entityNameToFaultsMap objectForKey:entityName];
+        if (! faults) {
+            faults = [NSMutableArray array];
+            [entityNameToFaultsMap setObject:faults forKey:entityName];
+        }
+        [faults addObject:object];
+    }
+    
+    for (NSString *entityName in [entityNameToFaultsMap allKeys]) {
+        NSArray *faults = [entityNameToFaultsMap objectForKey:entityName];
+        if ([faults count] < 2) {
+            continue;
+        }
+        
+        NSFetchRequest *fetchRequest = [[[NSFetchRequest alloc] init] autorelease];
+        fetchRequest.entity = [NSEntityDescription entityForName:entityName inManagedObjectContext:managedObjectContext];
+        fetchRequest.predicate = [NSPredicate predicateWithFormat:@"self IN %@", faults];
+        fetchRequest.returnsObjectsAsFaults = NO;
+        
+        NSError *error = nil;
+        if (! [managedObjectContext executeFetchRequest:fetchRequest error:&error]) {
+            HLSLoggerWarn(@"Could not prefetch objects to duplicate. Reason: %@", error);
+        }
+    }
+}
+
+/**
+ * Create a copy of an object (nil if it does not implement the HLSManagedObjectCopying protocol), as described in the
+ * -duplicate documentation
+ */
+static NSManagedObject *duplicateObject(NSManagedObject *object, CFMutableDictionaryRef sourceToCopyMap)
+{
+    if (! [object conformsToProtocol:@protocol(HLSManagedObjectCopying)]) {
+        return nil;
+    }
+    
+    // Create the deep copy
+    NSManagedObject *objectCopy = [[[object class] alloc] initWithEntity:object.entity
+                                        insertIntoManagedObjectContext:object.managedObjectContext];
+    [objectCopy autorelease];
+    CFDictionarySetValue(sourceToCopyMap, object, objectCopy);
+    
     // Get keys to exclude (if any)
     NSSet *keysToExclude = nil;
-    NSManagedObject<HLSManagedObjectCopying> *managedObjectCopyable = (NSManagedObject<HLSManagedObjectCopying> *)self;
+    NSManagedObject<HLSManagedObjectCopying> *managedObjectCopyable = (NSManagedObject<HLSManagedObjectCopying> *)object;
     if ([managedObjectCopyable respondsToSelector:@selector(keysToExclude)]) {
         keysToExclude = [managedObjectCopyable keysToExclude];
     }
     
-    // Copy attributes (shallow copy for all: Those are of "primitive" immutable types anyway)
-    NSEntityDescription *entityDescription = [NSEntityDescription entityForName:self.entity.name
-                                                         inManagedObjectContext:self.managedObjectContext];
-    NSDictionary *attributes = [entityDescription attributesByName];
-    for (NSString *attributeName in [attributes allKeys]) {
+    NSDictionary *metadata = duplicationMetadataForEntity(object.entity);
+    
+    // Copy attributes (shallow copy for all: Those are of "primitive" immutable types anyway). Primitive accessors are
+    // used to avoid the overhead of KVC and of custom accessors, the source object fault being fired once for all
+    [object willAccessValueForKey:nil];
+    for (NSString *attributeName in [metadata objectForKey:kDuplicationAttributeNamesKey]) {
         if ([keysToExclude containsObject:attributeName]) {
             continue;
         }
-        [objectCopy setValue:[self valueForKey:attributeName] forKey:attributeName];
+        
+        [objectCopy willChangeValueForKey:attributeName];
+        [objectCopy setPrimitiveValue:[object primitiveValueForKey:attributeName] forKey:attributeName];
+        [objectCopy didChangeValueForKey:attributeName];
     }
+    [object didAccessValueForKey:nil];
     
-    // Copy relationships
-    NSDictionary *relationships = [entityDescription relationshipsByName];
-    for (NSString *relationshipName in [relationships allKeys]) {
+    // Deep copy owned objects implementing the HLSManagedObjectCopying protocol. KVC is used for relationships so that
+    // inverse relationships are maintained
+    for (NSString *relationshipName in [metadata objectForKey:kDuplicationOwningToManyRelationshipNamesKey]) {
         if ([keysToExclude containsObject:relationshipName]) {
             continue;
         }
         
-        // Deep copy owned objects implementing the NSManagedObjectCopying protocol
-        NSRelationshipDescription *relationshipDescription = [relationships objectForKey:relationshipName];
-        if ([relationshipDescription deleteRule] == NSCascadeDeleteRule) {
-            // To-many relationship
-            if ([relationshipDescription isToMany]) {
-                // The set of owned objects might be altered when we duplicate them below. To avoid iterating
-                // over mutating sets, we copy it first
-                NSSet *ownedObjects = [NSSet setWithSet:[managedObjectCopyable valueForKey:relationshipName]];
-                NSMutableSet *ownedObjectCopies = [NSMutableSet set];
-                for (NSManagedObject *ownedObject in ownedObjects) {
-                    NSManagedObject *ownedObjectCopy = [ownedObject duplicate];
-                    if (ownedObjectCopy) {
-                        [ownedObjectCopies addObject:ownedObjectCopy];
-                    }
-                    else {
-                        [ownedObjectCopies addObject:ownedObject];
-                    }   
-                }
-                [objectCopy setValue:[NSSet setWithSet:ownedObjectCopies] forKey:relationshipName];
-            }
-            // To-one relationship
-            else {
-                NSManagedObject *ownedObject = [managedObjectCopyable valueForKey:relationshipName];
-                NSManagedObject *ownedObjectCopy = [ownedObject duplicate];
-                if (ownedObjectCopy) {
-                    [objectCopy setValue:ownedObjectCopy forKey:relationshipName];
-                }
-                else {
-                    [objectCopy setValue:ownedObject forKey:relationshipName];
-                }
-            }
+        // The set of owned objects might be altered when we duplicate them below. To avoid iterating over mutating sets,
+        // we copy it first
+        NSSet *ownedObjects = [NSSet setWithSet:[object valueForKey:relationshipName]];
+        prefetchObjects(ownedObjects, object.managedObjectContext);
+        
+        NSMutableSet *ownedObjectCopies = [NSMutableSet setWithCapacity:[ownedObjects count]];
+        for (NSManagedObject *ownedObject in ownedObjects) {
+            [ownedObjectCopies addObject:duplicateOwnedObject(ownedObject, sourceToCopyMap)];
         }
-        // Shallow copy in all other cases
-        else {
-            [objectCopy setValue:[managedObjectCopyable valueForKey:relationshipName] forKey:relationshipName];
+        [objectCopy setValue:ownedObjectCopies forKey:relationshipName];
+    }
+    
+    for (NSString *relationshipName in [metadata objectForKey:kDuplicationOwningToOneRelationshipNamesKey]) {
+        if ([keysToExclude containsObject:relationshipName]) {
+            continue;
         }
+        
+        NSManagedObject *ownedObject = [object valueForKey:relationshipName];
+        if (! ownedObject) {
+            continue;
+        }
+        [objectCopy setValue:duplicateOwnedObject(ownedObject, sourceToCopyMap) forKey:relationshipName];
+    }
+    
+    // Shallow copy in all other cases
+    for (NSString *relationshipName in [metadata objectForKey:kDuplicationOtherRelationshipNamesKey]) {
+        if ([keysToExclude containsObject:relationshipName]) {
+            continue;
+        }
+        
+        [objectCopy setValue:[object valueForKey:relationshipName] forKey:relationshipName];
     }
     
     return objectCopy;
 }
 
-@end
+/**
+ * Return the copy of an owned object (the object itself if it cannot be copied), reusing the copy if it has already
+ * been made
+ */
+static NSManagedObject *duplicateOwnedObject(NSManagedObject *ownedObject, CFMutableDictionaryRef sourceToCopyMap)
+{
+    NSManagedObject *ownedObjectCopy = (NSManagedObject *)CFDictionaryGetValue(sourceToCopyMap, ownedObject);
+    if (ownedObjectCopy) {
+        return ownedObjectCopy;
+    }
+    
+    ownedObjectCopy = duplicateObject(ownedObject, sourceToCopyMap);
+    return ownedObjectCopy ? ownedObjectCopy : ownedObject;
+}
@@ -101,6 +101,20 @@
  */
 + (void)enable;
 
+/**
+ * When incremental validation is enabled, only the properties which have been changed (see -[NSManagedObject changedValues])
+ * are validated when an updated object is saved, and the -checkForConsistency: methods are only called if one of the keys
+ * they depend on (see +keysAffectingConsistency) has been changed. Objects which are inserted are always completely validated,
+ * and so are objects checked explicitly using the -check: method
+ *
+ * Incremental validation should only be enabled if the objects which are updated have been valid when they were last saved
+ * (i.e. if the store is not filled by other means than validated saves)
+ *
+ * The default value is NO
+ */
++ (void)setIncrementalValidationEnabled:(BOOL)incrementalValidationEnabled;
++ (BOOL)isIncrementalValidationEnabled;
+
 /**
  * Check that a given value is valid for a specific field. The validation logic can be implemented in the 
  * xcdatamodel and / or in a -check<fieldName>:error: method. The method returns YES iff the value is valid
@@ -114,6 +128,35 @@
  */
 - (BOOL)check:(NSError **)pError;
 
+/**
+ * Check several objects as a whole (as -check: does), combining their errors. Before objects are checked one after 
+ * the other, the -check<fieldName>:error: methods for the keys returned by +keysWithThreadSafeChecks are run concurrently
+ * on background queues, using the values of the objects at the time this method is called. Their results are then
+ * used when checking the objects, so that errors are combined exactly as if they had been checked one by one
+ *
+ * Must be called from the thread the context of the objects is used from
+ */
++ (BOOL)checkObjects:(NSArray *)managedObjects error:(NSError **)pError;
+
+/**
+ * Subclasses of NSManagedObject can override this method to return the keys (NSString objects) whose check methods
+ * are thread-safe, i.e. only depend on the value they receive and never access the object itself or any other managed
+ * object. Those check methods can then be run concurrently by +checkObjects:error:. The default implementation returns
+ * nil
+ */
++ (NSSet *)keysWithThreadSafeChecks;
+
+/**
+ * Subclasses of NSManagedObject which implement -checkForConsistency: can override this method to return the keys (NSString
+ * objects) their consistency validation depends on. When incremental validation is enabled, the -checkForConsistency:
+ * method implemented by the class is then only called when an updated object is saved if one of those keys has been changed.
+ * The set returned only applies to the -checkForConsistency: method of the class which implements it, not to the ones of
+ * its subclasses or superclasses
+ *
+ * The default implementation returns nil, which means that consistency is always checked
+ */
++ (NSSet *)keysAffectingConsistency;
+
 /**
  * Subclasses of NSManagedObject can override this method to perform additional consistency validations when
  * inserted or updated objects are committed (i.e. when the managed object context they live in is saved).
@@ -11,19 +11,41 @@
 #import "HLSAssert.h"
 #import "HLSLogger.h"
 #import "HLSModelManager.h"
+#import "HLSPersistentArray.h"
+#import "HLSPersistentDictionary.h"
 #import "HLSRuntime.h"
 #import "NSDictionary+HLSExtensions.h"
 #import "NSError+HLSExtensions.h"
 #import "NSObject+HLSExtensions.h"
 #import "UITextField+HLSValidation.h"
 
+#import <libkern/OSAtomic.h>
 #import <objc/runtime.h>
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryCoreData
+
 // Return YES iff injection has been enabled. External linkage, but not public
 BOOL injectedManagedObjectValidation(void);
 
+// Extern declarations
+extern void injectTextFieldValidation(void);
+
 // Variables with internal linkage
 static BOOL s_injectedManagedObjectValidation = NO;
+static BOOL s_incrementalValidationEnabled = NO;
+
+// Validation never requires string manipulation or method list scans once a class has been initialized: The check
+// selector corresponding to each validation selector is registered when validation methods are injected, and check
+// methods are looked up once per class (kCFNull is stored when a class has no check method for a selector)
+static CFMutableDictionaryRef s_validationSelectorToCheckSelectorMap = NULL;
+static CFMutableDictionaryRef s_classToCheckMethodMapMap = NULL;
+static OSSpinLock s_checkCacheLock = OS_SPINLOCK_INIT;
+
+// Number of batch validations in progress, and thread dictionary key under which the results of the checks performed
+// in advance are stored (object -> check selector -> NSNull if valid, error otherwise)
+static volatile int32_t s_batchValidationCount = 0;
+static NSString * const kPrecomputedCheckResultsKey = @"HLSValidationPrecomputedCheckResults";
 
 // Original implementation of the methods we swizzle
 static void (*s_NSManagedObject__initialize_Imp)(id, SEL) = NULL;
@@ -32,11 +54,16 @@ static void (*s_NSManagedObject__initialize_Imp)(id, SEL) = NULL;
 static void swizzled_NSManagedObject__initialize_Imp(Class self, SEL _cmd);
 
 // Static helper functions
-static Method instanceMethodOnClass(Class class, SEL sel);
+static void registerCheckSelectorForValidationSelector(SEL checkSel, SEL sel);
 static SEL checkSelectorForValidationSelector(SEL sel);
+static Method checkMethodForClass(Class class, SEL checkSel);
+static Method checkMethodOnClass(Class class, SEL checkSel);
 static BOOL validateProperty(id self, SEL sel, id *pValue, NSError **pError);
+static BOOL reportCheckResult(BOOL valid, NSError *newError, SEL checkSel, NSError **pError);
 static BOOL validateObjectConsistency(id self, SEL sel, NSError **pError);
-static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL sel, NSError **pError);
+static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL sel, NSSet *changedKeys, NSError **pError);
+static BOOL validateChangedProperties(id self, NSSet *changedKeys, NSError **pError);
+static NSSet *keysAffectingConsistencyOnClass(Class class);
 
 #pragma mark -
 #pragma mark HLSValidationPrivate category interface
@@ -63,13 +90,35 @@ static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL
         return;
     }
     
+    // Keys and values are selectors or classes (not retained). Check method maps are retained
+    s_validationSelectorToCheckSelectorMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    s_classToCheckMethodMapMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    
+    // Special cases of global validation for insert / update: One common method since always identical
+    registerCheckSelectorForValidationSelector(@selector(checkForConsistency:), @selector(validateForInsert:));
+    registerCheckSelectorForValidationSelector(@selector(checkForConsistency:), @selector(validateForUpdate:));
+    registerCheckSelectorForValidationSelector(@selector(checkForDelete:), @selector(validateForDelete:));
+    
     s_NSManagedObject__initialize_Imp = (void (*)(id, SEL))HLSSwizzleClassSelector(self,
                                                                                    @selector(initialize), 
                                                                                    (IMP)swizzled_NSManagedObject__initialize_Imp);
     
+    // Text field bindings are only available when validation is enabled
+    injectTextFieldValidation();
+    
     s_injectedManagedObjectValidation = YES;
 }
 
++ (void)setIncrementalValidationEnabled:(BOOL)incrementalValidationEnabled
+{
+    s_incrementalValidationEnabled = incrementalValidationEnabled;
+}
+
++ (BOOL)isIncrementalValidationEnabled
+{
+    return s_incrementalValidationEnabled;
+}
+
 #pragma mark Checking the object
 
 - (BOOL)checkValue:(id)value forKey:(NSString *)key error:(NSError **)pError
@@ -88,6 +137,109 @@ static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL
     return [self validateForInsert:pError];
 }
 
++ (BOOL)checkObjects:(NSArray *)managedObjects error:(NSError **)pError
+{
+    NSAssert(injectedManagedObjectValidation(), @"Managed object validation not injected. Call HLSEnableNSManagedObjectValidation first");
+    HLSAssertObjectsInEnumerationAreKindOfClass(managedObjects, NSManagedObject);
+    
+    // Snapshot the values to check concurrently. Managed objects must not be accessed from other threads
+    NSMutableArray *objects = [NSMutableArray array];
+    NSMutableArray *values = [NSMutableArray array];
+    NSMutableArray *checkSelectorValues = [NSMutableArray array];
+    for (NSManagedObject *managedObject in managedObjects) {
+        NSSet *keys = [[managedObject class] keysWithThreadSafeChecks];
+        for (NSString *key in keys) {
+            NSString *checkSelectorName = [NSString stringWithFormat:@"check%@%@:error:", [[key substringToIndex:1] uppercaseString],
+                                           [key substringFromIndex:1]];
+            SEL checkSel = NSSelectorFromString(checkSelectorName);
+            if (! checkMethodForClass([managedObject class], checkSel)) {
+                continue;
+            }
+            
+            id value = [managedObject valueForKey:key];
+            [objects addObject:managedObject];
+            [values addObject:value ? value : [NSNull null]];
+            [checkSelectorValues addObject:[NSValue valueWithPointer:checkSel]];
+        }
+    }
+    
+    // Run the thread-safe checks concurrently. Each slot of the result arrays is written by a single iteration
+    size_t nbrChecks = [objects count];
+    BOOL *validResults = calloc(nbrChecks, sizeof(BOOL));
+    id *errorResults = calloc(nbrChecks, sizeof(id));
+    dispatch_apply(nbrChecks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        NSManagedObject *managedObject = [objects objectAtIndex:i];
+        id value = [values objectAtIndex:i];
+        if (value == [NSNull null]) {
+            value = nil;
+        }
+        SEL checkSel = [[checkSelectorValues objectAtIndex:i] pointerValue];
+        Method method = checkMethodForClass([managedObject class], checkSel);
+        BOOL (*checkImp)(id, SEL, id, NSError **) = (BOOL (*)(id, SEL, id, NSError **))method_getImplementation(method);
+        
+        // The error must survive the pool drain
+        NSError *newError = nil;
+        validResults[i] = (*checkImp)(managedObject, checkSel, value, &newError);
+        errorResults[i] = [newError retain];
+        
+        [pool drain];
+    });
+    
+    // Make the results available to the validation wrappers called on this thread. Each result is stored with the value
+    // it was obtained for, so that it is only used if the value is still the same
+    CFMutableDictionaryRef precomputedCheckResults = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    for (size_t i = 0; i < nbrChecks; ++i) {
+        NSManagedObject *managedObject = [objects objectAtIndex:i];
+        CFMutableDictionaryRef objectCheckResults = (CFMutableDictionaryRef)CFDictionaryGetValue(precomputedCheckResults, managedObject);
+        if (! objectCheckResults) {
+            objectCheckResults = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+            CFDictionarySetValue(precomputedCheckResults, managedObject, objectCheckResults);
+            CFRelease(objectCheckResults);
+        }
+        
+        NSArray *checkResult = [NSArray arrayWithObjects:[values objectAtIndex:i],
+                                [NSNumber numberWithBool:validResults[i]],
+                                errorResults[i] ? errorResults[i] : [NSNull null],
+                                nil];
+        CFDictionarySetValue(objectCheckResults, [[checkSelectorValues objectAtIndex:i] pointerValue], checkResult);
+        [errorResults[i] release];
+    }
+    free(validResults);
+    free(errorResults);
+    
+    NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+    [threadDictionary setObject:(id)precomputedCheckResults forKey:kPrecomputedCheckResultsKey];
+    CFRelease(precomputedCheckResults);
+    OSAtomicIncrement32Barrier(&s_batchValidationCount);
+    
+    // Check objects one by one, combining errors as usual
+    BOOL valid = YES;
+    for (NSManagedObject *managedObject in managedObjects) {
+        NSError *newError = nil;
+        if (! [managedObject check:&newError]) {
+            [self combineError:newError withError:pError];
+            valid = NO;
+        }
+    }
+    
+    OSAtomicDecrement32Barrier(&s_batchValidationCount);
+    [threadDictionary removeObjectForKey:kPrecomputedCheckResultsKey];
+    
+    return valid;
+}
+
++ (NSSet *)keysWithThreadSafeChecks
+{
+    return nil;
+}
+
++ (NSSet *)keysAffectingConsistency
+{
+    return nil;
+}
+
 #pragma mark Global validation method stubs
 
 - (BOOL)checkForConsistency:(NSError **)pError
@@ -140,18 +292,27 @@ static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL
     
     // An existing error is already available. Combine as multiple error
     if (*pExistingError) {
-        // Already a multiple error. Add the new error to the list (this can only be done cleanly by creating a new error object)
+        // Already a multiple error. Add the new error to the list (this can only be done cleanly by creating a new error object).
+        // Errors are often combined in a row, persistent collections are used so that existing information is shared
+        // with the new error instead of being copied each time
         NSDictionary *userInfo = nil;
         if ([*pExistingError hasCode:NSValidationMultipleErrorsError withinDomain:NSCocoaErrorDomain]) {
             userInfo = [*pExistingError userInfo];
+            if (! [userInfo isKindOfClass:[HLSPersistentDictionary class]]) {
+                userInfo = [HLSPersistentDictionary dictionaryWithDictionary:userInfo];
+            }
+            
             NSArray *errors = [userInfo objectForKey:NSDetailedErrorsKey];
+            if (! [errors isKindOfClass:[HLSPersistentArray class]]) {
+                errors = [HLSPersistentArray arrayWithArray:errors];
+            }
             errors = [errors arrayByAddingObject:newError];
-            userInfo = [userInfo dictionaryBySettingObject:errors forKey:NSDetailedErrorsKey];            
+            userInfo = [userInfo dictionaryBySettingObject:errors forKey:NSDetailedErrorsKey];
         }
         // Not a multiple error yet. Combine into a multiple error
         else {
-            NSArray *errors = [NSArray arrayWithObjects:*pExistingError, newError, nil];
-            userInfo = [NSDictionary dictionaryWithObject:errors forKey:NSDetailedErrorsKey];
+            NSArray *errors = [HLSPersistentArray arrayWithObjects:*pExistingError, newError, nil];
+            userInfo = [HLSPersistentDictionary dictionaryWithObject:errors forKey:NSDetailedErrorsKey];
         }
         
         // Fill with error object (code in the NSCocoaErrorDomain domain; cannot use HLSError here)
@@ -279,22 +440,13 @@ BOOL injectedManagedObjectValidation(void)
 #pragma mark Utility functions
 
 /**
- * Given a class and a selector, returns the underlying method iff it is implemented by this class (not by parent
- * classes). Unlike class_getInstanceMethod, this method returns NULL if a parent class implements the method
+ * Register the check selector associated with a validation selector
  */
-static Method instanceMethodOnClass(Class class, SEL sel)
+static void registerCheckSelectorForValidationSelector(SEL checkSel, SEL sel)
 {
-    unsigned int numberOfMethods = 0;
-    Method *methods = class_copyMethodList(class, &numberOfMethods);
-    for (unsigned int i = 0; i < numberOfMethods; ++i) {
-        Method method = methods[i];
-        if (method_getName(method) == sel) {
-            free(methods);
-            return method;
-        }
-    }
-    free(methods);
-    return NULL;
+    OSSpinLockLock(&s_checkCacheLock);
+    CFDictionarySetValue(s_validationSelectorToCheckSelectorMap, sel, checkSel);
+    OSSpinLockUnlock(&s_checkCacheLock);
 }
 
 /**
@@ -302,16 +454,70 @@ static Method instanceMethodOnClass(Class class, SEL sel)
  */
 static SEL checkSelectorForValidationSelector(SEL sel)
 {
-    // Special cases of global validation for insert / update: One common method since always identical
+    OSSpinLockLock(&s_checkCacheLock);
+    SEL checkSel = (SEL)CFDictionaryGetValue(s_validationSelectorToCheckSelectorMap, sel);
+    OSSpinLockUnlock(&s_checkCacheLock);
+    if (checkSel) {
+        return checkSel;
+    }
+    
+    // Not registered when validation methods were injected. The check method bears the same name as the validation method,
+    // but beginning with "check"
     NSString *selectorName = [NSString stringWithCString:(char *)sel encoding:NSUTF8StringEncoding];
-    if ([selectorName isEqualToString:@"validateForInsert:"] || [selectorName isEqualToString:@"validateForUpdate:"]) {
-        return NSSelectorFromString(@"checkForConsistency:");
+    NSString *checkSelectorName = [selectorName stringByReplacingOccurrencesOfString:@"validate" withString:@"check"];
+    checkSel = NSSelectorFromString(checkSelectorName);
+    registerCheckSelectorForValidationSelector(checkSel, sel);
+    return checkSel;
+}
+
+/**
+ * Return the check method for a class and a selector, NULL if none. As class_getInstanceMethod, this method also
+ * returns methods implemented by parent classes. The result is cached
+ */
+static Method checkMethodForClass(Class class, SEL checkSel)
+{
+    OSSpinLockLock(&s_checkCacheLock);
+    CFMutableDictionaryRef checkMethodMap = (CFMutableDictionaryRef)CFDictionaryGetValue(s_classToCheckMethodMapMap, class);
+    const void *cachedValue = checkMethodMap ? CFDictionaryGetValue(checkMethodMap, checkSel) : NULL;
+    OSSpinLockUnlock(&s_checkCacheLock);
+    if (cachedValue) {
+        return (cachedValue == kCFNull) ? NULL : (Method)cachedValue;
     }
-    // In all other cases, the check method bears the same name as the validation method, but beginning with "check"
-    else {
-        NSString *checkSelectorName = [selectorName stringByReplacingOccurrencesOfString:@"validate" withString:@"check"];
-        return  NSSelectorFromString(checkSelectorName);
-    }    
+    
+    // Not looked up yet. The runtime must not be called with the lock held
+    Method method = class_getInstanceMethod(class, checkSel);
+    
+    OSSpinLockLock(&s_checkCacheLock);
+    checkMethodMap = (CFMutableDictionaryRef)CFDictionaryGetValue(s_classToCheckMethodMapMap, class);
+    if (! checkMethodMap) {
+        checkMethodMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+        CFDictionarySetValue(s_classToCheckMethodMapMap, class, checkMethodMap);
+        CFRelease(checkMethodMap);
+    }
+    CFDictionarySetValue(checkMethodMap, checkSel, method ? (const void *)method : (const void *)kCFNull);
+    OSSpinLockUnlock(&s_checkCacheLock);
+    
+    return method;
+}
+
+/**
+ * Given a class and a selector, returns the underlying check method iff it is implemented by this class (not by parent
+ * classes). Unlike checkMethodForClass, this function returns NULL if only a parent class implements the method
+ */
+static Method checkMethodOnClass(Class class, SEL checkSel)
+{
+    Method method = checkMethodForClass(class, checkSel);
+    if (! method) {
+        return NULL;
+    }
+    
+    // Inherited methods are the same as the ones found on the superclass
+    Class superclass = class_getSuperclass(class);
+    if (superclass && checkMethodForClass(superclass, checkSel) == method) {
+        return NULL;
+    }
+    
+    return method;
 }
 
 #pragma mark Validation
@@ -326,7 +532,7 @@ static BOOL validateProperty(id self, SEL sel, id *pValue, NSError **pError)
 {
     // If the check method does not exist, the field is valid
     SEL checkSel = checkSelectorForValidationSelector(sel);
-    Method method = class_getInstanceMethod([self class], checkSel);
+    Method method = checkMethodForClass([self class], checkSel);
     if (! method) {
         return YES;
     }
@@ -334,10 +540,43 @@ static BOOL validateProperty(id self, SEL sel, id *pValue, NSError **pError)
     // Get the check method implementation
     BOOL (*checkImp)(id, SEL, id, NSError **) = (BOOL (*)(id, SEL, id, NSError **))method_getImplementation(method);
     
+    id value = pValue ? *pValue : nil;
+    
+    // Use the result obtained in advance by +checkObjects:error:, if any and if the value has not changed since
+    if (s_batchValidationCount != 0) {
+        CFDictionaryRef precomputedCheckResults = (CFDictionaryRef)[[[NSThread currentThread] threadDictionary] objectForKey:kPrecomputedCheckResultsKey];
+        CFDictionaryRef objectCheckResults = precomputedCheckResults ? CFDictionaryGetValue(precomputedCheckResults, self) : NULL;
+        NSArray *checkResult = objectCheckResults ? (NSArray *)CFDictionaryGetValue(objectCheckResults, checkSel) : nil;
+        if (checkResult) {
+            id checkedValue = [checkResult objectAtIndex:0];
+            if (checkedValue == [NSNull null]) {
+                checkedValue = nil;
+            }
+            if (checkedValue == value) {
+                id newError = [checkResult objectAtIndex:2];
+                return reportCheckResult([[checkResult objectAtIndex:1] boolValue],
+                                         newError == [NSNull null] ? nil : newError,
+                                         checkSel,
+                                         pError);
+            }
+        }
+    }
+    
+    // Get the check method implementation
+    BOOL (*checkImp)(id, SEL, id, NSError **) = (BOOL (*)(id, SEL, id, NSError **))method_getImplementation(method);
+    
     // Check
     NSError *newError = nil;
-    id value = pValue ? *pValue : nil;
-    if (! (*checkImp)(self, checkSel, value, &newError)) {
+    BOOL valid = (*checkImp)(self, checkSel, value, &newError);
+    return reportCheckResult(valid, newError, checkSel, pError);
+}
+
+/**
+ * Report the result of a field check method, combining the error it returned (if any) with the one received as parameter
+ */
+static BOOL reportCheckResult(BOOL valid, NSError *newError, SEL checkSel, NSError **pError)
+{
+    if (! valid) {
         if (! newError) {
             HLSLoggerWarn(@"The %s method returns NO but no error. The method implementation is incorrect", (char *)checkSel);
         }
@@ -365,18 +604,32 @@ static BOOL validateProperty(id self, SEL sel, id *pValue, NSError **pError)
  */
 static BOOL validateObjectConsistency(id self, SEL sel, NSError **pError)
 {
-    return validateObjectConsistencyInClassHierarchy(self, [self class], sel, pError);
+    // Incremental validation: Only consider changed properties for updates
+    NSSet *changedKeys = nil;
+    if (s_incrementalValidationEnabled && sel == @selector(validateForUpdate:)) {
+        changedKeys = [NSSet setWithArray:[[self changedValues] allKeys]];
+    }
+    
+    return validateObjectConsistencyInClassHierarchy(self, [self class], sel, changedKeys, pError);
 }
 
 /**
  * Validate the consistency of self (according to one of the three global validation methods listed above), applying to 
  * it the selector given as parameter (using the implementation defined for it by the class given as parameter). This 
  * method can therefore be used to check global object consistency at all levels of the managed object inheritance hierarchy
+ *
+ * If a set of changed keys is provided, only the corresponding properties are validated, and consistency checks are only
+ * performed if they depend on one of those keys
  */
-static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL sel, NSError **pError)
+static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL sel, NSSet *changedKeys, NSError **pError)
 {
     // Top of the managed object hierarchy
     if (class == [NSManagedObject class]) {
+        // Incremental validation: Individual validations are only triggered for changed properties
+        if (changedKeys) {
+            return validateChangedProperties(self, changedKeys, pError);
+        }
+        
         // Get the implementation. This method exists on NSManagedObject, no need to test if responding to selector
         BOOL (*imp)(id, SEL, NSError **) = (BOOL (*)(id, SEL, NSError **))class_getMethodImplementation(class, sel);
         
@@ -398,7 +651,7 @@ static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL
         
         // Climb up the inheritance hierarchy
         NSError *newError = nil;
-        if (! validateObjectConsistencyInClassHierarchy(self, class_getSuperclass(class), sel, &newError)) {
+        if (! validateObjectConsistencyInClassHierarchy(self, class_getSuperclass(class), sel, changedKeys, &newError)) {
             [NSManagedObject combineError:newError withError:pError];
             valid = NO;
         }
@@ -406,11 +659,19 @@ static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL
         // Find whether a check method has been defined at this class hierarchy level. If none is found, valid 
         // (i.e. we do not alter the above validation status)
         SEL checkSel = checkSelectorForValidationSelector(sel);
-        Method method = instanceMethodOnClass(class, checkSel);
+        Method method = checkMethodOnClass(class, checkSel);
         if (! method) {
             return valid;
         }
         
+        // Incremental validation: Skip the check if none of the keys it depends on has changed
+        if (changedKeys) {
+            NSSet *keysAffectingConsistency = keysAffectingConsistencyOnClass(class);
+            if (keysAffectingConsistency && ! [keysAffectingConsistency intersectsSet:changedKeys]) {
+                return valid;
+            }
+        }
+        
         // A check method has been found. Call the underlying check method implementation
         BOOL (*checkImp)(id, SEL, NSError **) = (BOOL (*)(id, SEL, NSError **))method_getImplementation(method);
         NSError *newCheckError = nil;
@@ -431,6 +692,40 @@ static BOOL validateObjectConsistencyInClassHierarchy(id self, Class class, SEL
 }
 
 
+/**
+ * Validate the properties whose keys are given (xcdatamodel and check method validations), as the NSManagedObject implementation
+ * of -validateForUpdate: does for all properties
+ */
+static BOOL validateChangedProperties(id self, NSSet *changedKeys, NSError **pError)
+{
+    BOOL valid = YES;
+    for (NSString *key in changedKeys) {
+        id value = [self valueForKey:key];
+        NSError *newError = nil;
+        if (! [self validateValue:&value forKey:key error:&newError]) {
+            newError = [NSManagedObject flattenHiearchyForError:newError];
+            [NSManagedObject combineError:newError withError:pError];
+            valid = NO;
+        }
+    }
+    return valid;
+}
+
+/**
+ * Return the keys the consistency check method implemented by a class depends on, nil if the class does not declare them
+ * itself (in which case consistency must always be checked)
+ */
+static NSSet *keysAffectingConsistencyOnClass(Class class)
+{
+    Method method = class_getClassMethod(class, @selector(keysAffectingConsistency));
+    Method superMethod = class_getClassMethod(class_getSuperclass(class), @selector(keysAffectingConsistency));
+    if (method_getImplementation(method) == method_getImplementation(superMethod)) {
+        return nil;
+    }
+    
+    return [class keysAffectingConsistency];
+}
+
 #pragma mark Swizzled method implementations
 
 /**
@@ -491,6 +786,13 @@ static void swizzled_NSManagedObject__initialize_Imp(Class self, SEL _cmd)
         
         HLSLoggerDebug(@"Automatically added validation wrapper %@ on class %@", validationSelectorName, self);
         
+        // Register the corresponding check selector, and look up the check method once for all
+        NSString *checkSelectorName = [NSString stringWithFormat:@"check%@%@:error:", [[propertyName substringToIndex:1] uppercaseString],
+                                       [propertyName substringFromIndex:1]];
+        SEL checkSel = NSSelectorFromString(checkSelectorName);
+        registerCheckSelectorForValidationSelector(checkSel, NSSelectorFromString(validationSelectorName));
+        checkMethodForClass(self, checkSel);
+        
         added = YES;
     }
     free(properties);
@@ -515,5 +817,8 @@ static void swizzled_NSManagedObject__initialize_Imp(Class self, SEL _cmd)
                               "c@:@")) {
             HLSLoggerError(@"Failed to add validateForDelete: method dynamically");
         }
+        
+        checkMethodOnClass(self, @selector(checkForConsistency:));
+        checkMethodOnClass(self, @selector(checkForDelete:));
     }    
 }
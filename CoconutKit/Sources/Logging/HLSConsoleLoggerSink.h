@@ -0,0 +1,19 @@
+//
+//  HLSConsoleLoggerSink.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 17.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSLogger.h"
+
+/**
+ * Logger sink writing to the console (using NSLog). Supports XcodeColors (see HLSLogger.h)
+ */
+@interface HLSConsoleLoggerSink : NSObject <HLSLoggerSink> {
+@private
+    BOOL m_xcodeColorsEnabled;
+}
+
+@end
@@ -0,0 +1,62 @@
+//
+//  HLSConsoleLoggerSink.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 17.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSConsoleLoggerSink.h"
+
+/**
+ * RGB values for XcodeColors, nil if the default color must be used
+ */
+static NSString *rgbValuesForLevel(HLSLoggerLevel level)
+{
+    switch (level) {
+        case HLSLoggerLevelWarn: {
+            return @"255,120,0";
+            break;
+        }
+            
+        case HLSLoggerLevelError:
+        case HLSLoggerLevelFatal: {
+            return @"255,0,0";
+            break;
+        }
+            
+        default: {
+            return nil;
+            break;
+        }
+    }
+}
+
+@implementation HLSConsoleLoggerSink
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        NSString *xcodeColorsValue = [[[NSProcessInfo processInfo] environment] objectForKey:@"XcodeColors"];
+        m_xcodeColorsEnabled = [xcodeColorsValue isEqualToString:@"YES"];
+    }
+    return self;
+}
+
+#pragma mark HLSLoggerSink protocol implementation
+
+- (void)writeLogEntry:(NSString *)logEntry withLevel:(HLSLoggerLevel)level date:(NSDate *)date
+{
+    // NSLog adds its own timestamp
+    NSString *rgbValues = rgbValuesForLevel(level);
+    if (m_xcodeColorsEnabled && rgbValues) {
+        NSLog(@"\033[fg%@;%@\033[;", rgbValues, logEntry);
+    }
+    else {
+        NSLog(@"%@", logEntry);
+    }
+}
+
+@end
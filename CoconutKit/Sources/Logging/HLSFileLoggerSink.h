@@ -0,0 +1,83 @@
+//
+//  HLSFileLoggerSink.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 17.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFileManager.h"
+#import "HLSLogger.h"
+
+/**
+ * Logger sink appending log entries to a file, one per line and preceded by their date. The file is created if it
+ * does not exist.
+ *
+ * Entries are buffered in memory and written through a file manager when the buffer is full, when an error (or fatal)
+ * entry is received, when the sink is flushed, and periodically (every flushInterval seconds). When the file would
+ * exceed its maximum size, it is rotated: Its content is compressed (gzip) on a background queue into a file with the 
+ * same path and the .1.gz extension, previously rotated files being renamed (.2.gz, .3.gz, and so on). At most
+ * maximumNumberOfRotatedFiles are kept. Rotated files appear shortly after rotation, once compressed
+ *
+ * Designated initializer: -initWithFilePath:fileManager:
+ */
+@interface HLSFileLoggerSink : NSObject <HLSLoggerSink> {
+@private
+    NSString *m_filePath;
+    HLSFileManager *m_fileManager;
+    id<HLSFileHandle> m_fileHandle;
+    NSDateFormatter *m_dateFormatter;
+    NSMutableData *m_buffer;
+    unsigned long long m_fileSize;
+    unsigned long long m_maximumFileSize;
+    NSUInteger m_maximumNumberOfRotatedFiles;
+    NSTimeInterval m_flushInterval;
+    NSUInteger m_rotationCount;
+    dispatch_queue_t m_queue;
+    dispatch_queue_t m_compressionQueue;
+    dispatch_source_t m_flushTimer;
+}
+
+/**
+ * Create a sink writing to the file at the given path, using the specified file manager (the default one if nil).
+ * Return nil if the file cannot be opened for writing
+ */
+- (id)initWithFilePath:(NSString *)filePath fileManager:(HLSFileManager *)fileManager;
+
+/**
+ * Create a sink writing to the file at the given path with the default file manager
+ */
+- (id)initWithFilePath:(NSString *)filePath;
+
+/**
+ * The path of the file the sink writes to
+ */
+@property (nonatomic, readonly, retain) NSString *filePath;
+
+/**
+ * The file manager used
+ */
+@property (nonatomic, readonly, retain) HLSFileManager *fileManager;
+
+/**
+ * The size (in bytes) above which the file is rotated, 0 for no rotation
+ *
+ * The default value is 1 MB
+ */
+@property (nonatomic, assign) unsigned long long maximumFileSize;
+
+/**
+ * The number of rotated files to keep
+ *
+ * The default value is 5
+ */
+@property (nonatomic, assign) NSUInteger maximumNumberOfRotatedFiles;
+
+/**
+ * The interval between periodic flushes of the buffer
+ *
+ * The default value is 5 seconds
+ */
+@property (nonatomic, assign) NSTimeInterval flushInterval;
+
+@end
@@ -0,0 +1,304 @@
+//
+//  HLSFileLoggerSink.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 17.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFileLoggerSink.h"
+
+#import <zlib.h>
+#import "HLSAssert.h"
+
+static const NSUInteger kFileLoggerSinkBufferCapacity = 64 * 1024;
+static const NSUInteger kFileLoggerSinkCompressionChunkLength = 64 * 1024;
+
+// Function declarations
+static NSString *rotatedFilePath(NSString *filePath, NSUInteger index);
+static BOOL compressFile(HLSFileManager *fileManager, NSString *sourcePath, NSString *destinationPath);
+
+// Sink methods are called on the logger writer queue, but the sink state is also accessed by the flush timer. All
+// accesses are therefore made on a private serial queue
+@interface HLSFileLoggerSink ()
+
+@property (nonatomic, retain) NSString *filePath;
+@property (nonatomic, retain) HLSFileManager *fileManager;
+@property (nonatomic, retain) id<HLSFileHandle> fileHandle;
+@property (nonatomic, retain) NSDateFormatter *dateFormatter;
+@property (nonatomic, retain) NSMutableData *buffer;
+
+- (void)writeBuffer;
+- (void)rotateFile;
+
+@end
+
+@implementation HLSFileLoggerSink
+
+#pragma mark Object creation and destruction
+
+- (id)initWithFilePath:(NSString *)filePath fileManager:(HLSFileManager *)fileManager
+{
+    if ((self = [super init])) {
+        self.fileManager = fileManager ?: [HLSFileManager defaultManager];
+        
+        NSError *error = nil;
+        id<HLSFileHandle> fileHandle = [self.fileManager fileHandleForAppendingAtPath:filePath error:&error];
+        if (! fileHandle) {
+            HLSLoggerError(@"Could not open log file at path %@. Reason: %@", filePath, error);
+            [self release];
+            return nil;
+        }
+        
+        self.filePath = filePath;
+        self.fileHandle = fileHandle;
+        self.buffer = [NSMutableData dataWithCapacity:kFileLoggerSinkBufferCapacity];
+        m_fileSize = [fileHandle length];
+        m_maximumFileSize = 1024 * 1024;
+        m_maximumNumberOfRotatedFiles = 5;
+        
+        self.dateFormatter = [[[NSDateFormatter alloc] init] autorelease];
+        [self.dateFormatter setLocale:[[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"] autorelease]];
+        [self.dateFormatter setDateFormat:@"yyyy-MM-dd HH:mm:ss.SSS"];
+        
+        m_queue = dispatch_queue_create("ch.hortis.CoconutKit.HLSFileLoggerSink", NULL);
+        m_compressionQueue = dispatch_queue_create("ch.hortis.CoconutKit.HLSFileLoggerSink.compression", NULL);
+        dispatch_set_target_queue(m_compressionQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+        
+        // The timer is cancelled before the sink is deallocated, and must not retain it
+        __block HLSFileLoggerSink *sink = self;
+        m_flushTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, m_queue);
+        dispatch_source_set_event_handler(m_flushTimer, ^{
+            [sink writeBuffer];
+        });
+        self.flushInterval = 5.;
+        dispatch_resume(m_flushTimer);
+    }
+    return self;
+}
+
+- (id)initWithFilePath:(NSString *)filePath
+{
+    return [self initWithFilePath:filePath fileManager:nil];
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    if (m_queue) {
+        dispatch_sync(m_queue, ^{
+            dispatch_source_cancel(m_flushTimer);
+            [self writeBuffer];
+            [self.fileHandle close];
+        });
+        dispatch_release(m_flushTimer);
+        dispatch_release(m_queue);
+        
+        // Pending compressions do not need the sink
+        dispatch_release(m_compressionQueue);
+    }
+    
+    self.filePath = nil;
+    self.fileManager = nil;
+    self.fileHandle = nil;
+    self.dateFormatter = nil;
+    self.buffer = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize filePath = m_filePath;
+
+@synthesize fileManager = m_fileManager;
+
+@synthesize fileHandle = m_fileHandle;
+
+@synthesize dateFormatter = m_dateFormatter;
+
+@synthesize buffer = m_buffer;
+
+@synthesize maximumFileSize = m_maximumFileSize;
+
+@synthesize maximumNumberOfRotatedFiles = m_maximumNumberOfRotatedFiles;
+
+@synthesize flushInterval = m_flushInterval;
+
+- (void)setFlushInterval:(NSTimeInterval)flushInterval
+{
+    m_flushInterval = flushInterval;
+    
+    uint64_t interval = (uint64_t)(flushInterval * NSEC_PER_SEC);
+    dispatch_source_set_timer(m_flushTimer, dispatch_time(DISPATCH_TIME_NOW, interval), interval, interval / 10);
+}
+
+#pragma mark Writing
+
+// Must be called on the private queue
+- (void)writeBuffer
+{
+    if ([self.buffer length] == 0) {
+        return;
+    }
+    
+    if (m_maximumFileSize != 0 && m_fileSize != 0 && m_fileSize + [self.buffer length] > m_maximumFileSize) {
+        [self rotateFile];
+    }
+    
+    NSError *error = nil;
+    if (! [self.fileHandle writeData:self.buffer error:&error]) {
+        // Sinks cannot log using HLSLogger
+        NSLog(@"Could not write to log file at path %@. Reason: %@", self.filePath, error);
+    }
+    m_fileSize += [self.buffer length];
+    [self.buffer setLength:0];
+}
+
+// Must be called on the private queue
+- (void)rotateFile
+{
+    [self.fileHandle close];
+    self.fileHandle = nil;
+    
+    // Move the file out of the way immediately, the slow part being done in the background. Each rotated file gets
+    // a unique name, since several rotations might be pending
+    NSString *pendingFilePath = [self.filePath stringByAppendingFormat:@".rotating%u", m_rotationCount];
+    ++m_rotationCount;
+    
+    NSError *error = nil;
+    if (! [self.fileManager moveItemAtPath:self.filePath toPath:pendingFilePath error:&error]) {
+        NSLog(@"Could not rotate log file at path %@. Reason: %@", self.filePath, error);
+        pendingFilePath = nil;
+    }
+    
+    self.fileHandle = [self.fileManager fileHandleForAppendingAtPath:self.filePath error:&error];
+    if (! self.fileHandle) {
+        NSLog(@"Could not open log file at path %@. Reason: %@", self.filePath, error);
+    }
+    m_fileSize = [self.fileHandle length];
+    
+    if (! pendingFilePath) {
+        return;
+    }
+    
+    HLSFileManager *fileManager = self.fileManager;
+    NSString *filePath = self.filePath;
+    NSUInteger maximumNumberOfRotatedFiles = m_maximumNumberOfRotatedFiles;
+    dispatch_async(m_compressionQueue, ^{
+        // Shift previously rotated files, discarding the oldest one
+        if ([fileManager fileExistsAtPath:rotatedFilePath(filePath, maximumNumberOfRotatedFiles)]) {
+            [fileManager removeItemAtPath:rotatedFilePath(filePath, maximumNumberOfRotatedFiles) error:NULL];
+        }
+        for (NSUInteger index = maximumNumberOfRotatedFiles; index > 1; --index) {
+            NSString *previousPath = rotatedFilePath(filePath, index - 1);
+            if ([fileManager fileExistsAtPath:previousPath]) {
+                [fileManager moveItemAtPath:previousPath toPath:rotatedFilePath(filePath, index) error:NULL];
+            }
+        }
+        
+        if (maximumNumberOfRotatedFiles != 0) {
+            NSString *firstRotatedFilePath = rotatedFilePath(filePath, 1);
+            if (! compressFile(fileManager, pendingFilePath, firstRotatedFilePath)) {
+                NSLog(@"Could not compress rotated log file %@", pendingFilePath);
+                [fileManager removeItemAtPath:firstRotatedFilePath error:NULL];
+            }
+        }
+        [fileManager removeItemAtPath:pendingFilePath error:NULL];
+    });
+}
+
+#pragma mark HLSLoggerSink protocol implementation
+
+- (void)writeLogEntry:(NSString *)logEntry withLevel:(HLSLoggerLevel)level date:(NSDate *)date
+{
+    dispatch_async(m_queue, ^{
+        NSString *line = [NSString stringWithFormat:@"%@ %@\n", [self.dateFormatter stringFromDate:date], logEntry];
+        [self.buffer appendData:[line dataUsingEncoding:NSUTF8StringEncoding]];
+        
+        // Errors are written immediately so that they are not lost if the application crashes
+        if (level >= HLSLoggerLevelError || [self.buffer length] >= kFileLoggerSinkBufferCapacity) {
+            [self writeBuffer];
+        }
+    });
+}
+
+- (void)flush
+{
+    dispatch_sync(m_queue, ^{
+        [self writeBuffer];
+    });
+}
+
+@end
+
+#pragma mark -
+#pragma mark Static functions
+
+static NSString *rotatedFilePath(NSString *filePath, NSUInteger index)
+{
+    return [filePath stringByAppendingFormat:@".%u.gz", index];
+}
+
+// Compress a file (gzip format) by pieces, using a constant amount of memory
+static BOOL compressFile(HLSFileManager *fileManager, NSString *sourcePath, NSString *destinationPath)
+{
+    id<HLSFileHandle> sourceFileHandle = [fileManager fileHandleForReadingAtPath:sourcePath error:NULL];
+    id<HLSFileHandle> destinationFileHandle = [fileManager fileHandleForWritingAtPath:destinationPath error:NULL];
+    if (! sourceFileHandle || ! destinationFileHandle) {
+        return NO;
+    }
+    
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    
+    // 16 added to the window bits for a gzip header
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return NO;
+    }
+    
+    BOOL success = YES;
+    NSMutableData *outputData = [NSMutableData dataWithLength:kFileLoggerSinkCompressionChunkLength];
+    unsigned long long offset = 0;
+    int flush = Z_NO_FLUSH;
+    while (success && flush != Z_FINISH) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        NSData *inputData = [sourceFileHandle readDataOfLength:kFileLoggerSinkCompressionChunkLength atOffset:offset error:NULL];
+        if (! inputData) {
+            success = NO;
+            [pool drain];
+            break;
+        }
+        offset += [inputData length];
+        flush = ([inputData length] < kFileLoggerSinkCompressionChunkLength) ? Z_FINISH : Z_NO_FLUSH;
+        
+        stream.next_in = (Bytef *)[inputData bytes];
+        stream.avail_in = (uInt)[inputData length];
+        do {
+            stream.next_out = [outputData mutableBytes];
+            stream.avail_out = (uInt)[outputData length];
+            deflate(&stream, flush);
+            
+            NSUInteger producedLength = [outputData length] - stream.avail_out;
+            if (producedLength != 0
+                    && ! [destinationFileHandle writeData:[NSData dataWithBytesNoCopy:[outputData mutableBytes] length:producedLength freeWhenDone:NO] 
+                                                    error:NULL]) {
+                success = NO;
+                break;
+            }
+        } while (stream.avail_out == 0);
+        
+        [pool drain];
+    }
+    
+    deflateEnd(&stream);
+    [sourceFileHandle close];
+    [destinationFileHandle close];
+    return success;
+}
@@ -8,15 +8,127 @@
 
 /**
  * Logging macros. Only active if HLS_LOGGER is added to your configuration preprocessor flags (-DHLS_LOGGER)
+ *
+ * Statements below a minimum level can be removed at compile time by setting HLS_LOGGER_MINIMUM_LEVEL to 0 (DEBUG,
+ * the default), 1 (INFO), 2 (WARN), 3 (ERROR) or 4 (FATAL) in your preprocessor flags (e.g. -DHLS_LOGGER_MINIMUM_LEVEL=2).
+ * Statements which are compiled in but disabled by the level of their category only cost a comparison with a global
+ * value: no message is sent and their arguments are not evaluated
+ *
+ * Each statement belongs to the category given by HLS_LOGGER_CATEGORY when it is expanded (HLSLoggerCategoryGeneral
+ * by default). To assign the statements of a source file to another category, redefine HLS_LOGGER_CATEGORY after
+ * the imports of the file:
+ *     #undef HLS_LOGGER_CATEGORY
+ *     #define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
  */
+#ifndef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryGeneral
+#endif
+
 #ifdef HLS_LOGGER
 
-// Note the ## in front of __VA_ARGS__ to support 0 variable arguments
-#define HLSLoggerDebug(format, ...)	[[HLSLogger sharedLogger] debug:[NSString stringWithFormat:@"(%s) - %@", __PRETTY_FUNCTION__, [NSString stringWithFormat:format, ## __VA_ARGS__]]]
-#define HLSLoggerInfo(format, ...)	[[HLSLogger sharedLogger] info:[NSString stringWithFormat:@"(%s) - %@", __PRETTY_FUNCTION__, [NSString stringWithFormat:format, ## __VA_ARGS__]]]
-#define HLSLoggerWarn(format, ...)	[[HLSLogger sharedLogger] warn:[NSString stringWithFormat:@"(%s) - %@", __PRETTY_FUNCTION__, [NSString stringWithFormat:format, ## __VA_ARGS__]]]
-#define HLSLoggerError(format, ...)	[[HLSLogger sharedLogger] error:[NSString stringWithFormat:@"(%s) - %@", __PRETTY_FUNCTION__, [NSString stringWithFormat:format, ## __VA_ARGS__]]]
-#define HLSLoggerFatal(format, ...)	[[HLSLogger sharedLogger] fatal:[NSString stringWithFormat:@"(%s) - %@", __PRETTY_FUNCTION__, [NSString stringWithFormat:format, ## __VA_ARGS__]]]
+#ifndef HLS_LOGGER_MINIMUM_LEVEL
+#define HLS_LOGGER_MINIMUM_LEVEL 0
+#endif
+
+// Note the ## in front of __VA_ARGS__ to support 0 variable arguments. The message is only formatted if the level is enabled
+#define HLSLoggerLog(level, format, ...)                                                                                    \
+    do {                                                                                                                    \
+        if ((level) >= HLSLoggerCategoryLevels[HLS_LOGGER_CATEGORY]) {                                                      \
+            [[HLSLogger sharedLogger] logMessage:[NSString stringWithFormat:@"(%s) - %@", __PRETTY_FUNCTION__,              \
+                                                  [NSString stringWithFormat:format, ## __VA_ARGS__]]                       \
+                                       withLevel:(level)                                                                    \
+                                        category:HLS_LOGGER_CATEGORY];                                                      \
+        }                                                                                                                   \
+    } while (0)
+
+#if HLS_LOGGER_MINIMUM_LEVEL <= 0
+#define HLSLoggerDebug(format, ...)	HLSLoggerLog(HLSLoggerLevelDebug, format, ## __VA_ARGS__)
+#else
+#define HLSLoggerDebug(format, ...)
+#endif
+
+#if HLS_LOGGER_MINIMUM_LEVEL <= 1
+#define HLSLoggerInfo(format, ...)	HLSLoggerLog(HLSLoggerLevelInfo, format, ## __VA_ARGS__)
+#else
+#define HLSLoggerInfo(format, ...)
+#endif
+
+#if HLS_LOGGER_MINIMUM_LEVEL <= 2
+#define HLSLoggerWarn(format, ...)	HLSLoggerLog(HLSLoggerLevelWarn, format, ## __VA_ARGS__)
+#else
+#define HLSLoggerWarn(format, ...)
+#endif
+
+#if HLS_LOGGER_MINIMUM_LEVEL <= 3
+#define HLSLoggerError(format, ...)	HLSLoggerLog(HLSLoggerLevelError, format, ## __VA_ARGS__)
+#else
+#define HLSLoggerError(format, ...)
+#endif
+
+#if HLS_LOGGER_MINIMUM_LEVEL <= 4
+#define HLSLoggerFatal(format, ...)	HLSLoggerLog(HLSLoggerLevelFatal, format, ## __VA_ARGS__)
+#else
+#define HLSLoggerFatal(format, ...)
+#endif
+
+/**
+ * Structured logging macros, meant for high-frequency tracing. Entries are not formatted when logged, but recorded
+ * into a ring buffer of the shared logger as compact binary records (level, time, thread, format string pointer and
+ * raw arguments). Formatting is deferred until records are read (see -[HLSLogger recordedEntries]) or written to the
+ * logger sinks (see -[HLSLogger writeRecordedEntries]). When the buffer is full, the oldest records are overwritten.
+ *
+ * The format must be a C string literal, with at most HLS_LOGGER_RECORD_MAX_ARGUMENTS printf conversions for integers,
+ * floating-point numbers and pointers. %s is only supported for C strings which are never deallocated (e.g. literals
+ * or __PRETTY_FUNCTION__), objects (%@) are not supported at all. Neither are * widths and precisions
+ */
+#define HLSLoggerRecordLog(level, format, ...)                                                                              \
+    do {                                                                                                                    \
+        if ((level) >= HLSLoggerCategoryLevels[HLS_LOGGER_CATEGORY]) {                                                      \
+            HLSLoggerRecord((level), HLS_LOGGER_CATEGORY, format, ## __VA_ARGS__);                                          \
+        }                                                                                                                   \
+    } while (0)
+
+#if HLS_LOGGER_MINIMUM_LEVEL <= 0
+#define HLSLoggerRecordDebug(format, ...)   HLSLoggerRecordLog(HLSLoggerLevelDebug, format, ## __VA_ARGS__)
+#else
+#define HLSLoggerRecordDebug(format, ...)
+#endif
+
+#if HLS_LOGGER_MINIMUM_LEVEL <= 1
+#define HLSLoggerRecordInfo(format, ...)    HLSLoggerRecordLog(HLSLoggerLevelInfo, format, ## __VA_ARGS__)
+#else
+#define HLSLoggerRecordInfo(format, ...)
+#endif
+
+#if HLS_LOGGER_MINIMUM_LEVEL <= 2
+#define HLSLoggerRecordWarn(format, ...)    HLSLoggerRecordLog(HLSLoggerLevelWarn, format, ## __VA_ARGS__)
+#else
+#define HLSLoggerRecordWarn(format, ...)
+#endif
+
+/**
+ * Span macros, measuring the duration of hot code paths (e.g. a container push or a save) with a low overhead, so that
+ * they can be left in production code. HLSLoggerSpanBegin(span, name) declares a local variable called span, named by
+ * a C string literal (e.g. "HLSContainerStack insert"), and HLSLoggerSpanEnd(span) ends it. Both must be used in the
+ * same scope. Spans are only measured if the level of their category is not HLSLoggerLevelNone, and only one span out
+ * of HLSLoggerSpanSamplingInterval is measured on each thread. Spans which are not measured only cost two comparisons
+ * with global values
+ *
+ * Measured spans are stored into per-thread buffers, aggregated into histograms and exported as described in
+ * HLSLoggerSpan.h
+ */
+#define HLSLoggerSpanBegin(span, name)                                                                                      \
+    HLSLoggerSpan span = {(name), HLS_LOGGER_CATEGORY, 0};                                                                  \
+    if (HLSLoggerCategoryLevels[HLS_LOGGER_CATEGORY] < HLSLoggerLevelNone && HLSLoggerSpanSamplingInterval != 0) {          \
+        HLSLoggerSpanStart(&span);                                                                                          \
+    }
+
+#define HLSLoggerSpanEnd(span)                                                                                              \
+    do {                                                                                                                    \
+        if (span.startTime != 0) {                                                                                          \
+            HLSLoggerSpanStop(&span);                                                                                       \
+        }                                                                                                                   \
+    } while (0)
 
 #else
 
@@ -26,8 +138,21 @@
 #define HLSLoggerError(format, ...)
 #define HLSLoggerFatal(format, ...)
 
+#define HLSLoggerRecordDebug(format, ...)
+#define HLSLoggerRecordInfo(format, ...)
+#define HLSLoggerRecordWarn(format, ...)
+
+#define HLSLoggerSpanBegin(span, name)
+#define HLSLoggerSpanEnd(span)
+
 #endif
 
+/**
+ * Maximum number of arguments of structured logging statements, and number of records kept by the shared logger
+ */
+#define HLS_LOGGER_RECORD_MAX_ARGUMENTS         6
+#define HLS_LOGGER_RECORD_CAPACITY              4096
+
 /**
  * Logging levels
  */
@@ -47,7 +172,87 @@ typedef enum {
 } HLSLoggerLevel;
 
 /**
- * Basic logging facility writing to the console. Thread-safe
+ * Logging categories, whose levels can be set independently
+ */
+typedef enum {
+    HLSLoggerCategoryEnumBegin = 0,
+    HLSLoggerCategoryGeneral = HLSLoggerCategoryEnumBegin,
+    HLSLoggerCategoryTask,
+    HLSLoggerCategoryAnimation,
+    HLSLoggerCategoryContainer,
+    HLSLoggerCategoryCoreData,
+    HLSLoggerCategoryLocalization,
+    HLSLoggerCategoryEnumEnd,
+    HLSLoggerCategoryEnumSize = HLSLoggerCategoryEnumEnd - HLSLoggerCategoryEnumBegin
+} HLSLoggerCategory;
+
+/**
+ * The level of the shared logger, as read from the main .plist file. Never set this variable yourself
+ */
+extern HLSLoggerLevel HLSLoggerSharedLoggerLevel;
+
+/**
+ * The current level of each category, read by the logging macros without any lock so that disabled statements are
+ * discarded cheaply. Until the shared logger has been created, all levels are considered to be enabled. Never set
+ * these values yourself, use +[HLSLogger setLevel:forCategory:]
+ */
+extern HLSLoggerLevel HLSLoggerCategoryLevels[HLSLoggerCategoryEnumSize];
+
+/**
+ * Record a structured log entry (see HLSLoggerRecordLog). Should never be called directly, use the macros instead
+ */
+void HLSLoggerRecord(HLSLoggerLevel level, HLSLoggerCategory category, const char *format, ...) __attribute__ ((format (printf, 3, 4)));
+
+/**
+ * A span being measured (see HLSLoggerSpanBegin). The start time is 0 if the span is not measured
+ */
+typedef struct {
+    const char *name;
+    HLSLoggerCategory category;
+    uint64_t startTime;                         // Mach absolute time
+} HLSLoggerSpan;
+
+/**
+ * One span out of this number is measured on each thread, 0 disables span measurements. Read by the span macros without
+ * any lock. The initial value is read from the HLSLoggerSpanSamplingInterval setting of the main .plist file (1 if
+ * missing). Never set this variable yourself, use HLSLoggerSpanSetSamplingInterval()
+ */
+extern NSUInteger HLSLoggerSpanSamplingInterval;
+
+/**
+ * Start and stop measuring a span (see HLSLoggerSpanBegin and HLSLoggerSpanEnd). Should never be called directly, use
+ * the macros instead
+ */
+void HLSLoggerSpanStart(HLSLoggerSpan *span);
+void HLSLoggerSpanStop(HLSLoggerSpan *span);
+
+/**
+ * Return the name of a category, as used in the main .plist file
+ */
+NSString *HLSLoggerCategoryName(HLSLoggerCategory category);
+
+/**
+ * Protocol to be implemented by objects receiving the log entries of an HLSLogger. Sink methods are always called on
+ * the logger writer queue, never concurrently. They must not log using HLSLogger themselves
+ */
+@protocol HLSLoggerSink <NSObject>
+
+/**
+ * Write a log entry (already formatted, level name included) logged at the given date
+ */
+- (void)writeLogEntry:(NSString *)logEntry withLevel:(HLSLoggerLevel)level date:(NSDate *)date;
+
+@optional
+
+/**
+ * Ensure that all entries written so far are persisted
+ */
+- (void)flush;
+
+@end
+
+/**
+ * Basic logging facility. Thread-safe
  *
  * To enable logging, you can use either the release or debug version of this library, the logging code exists in both
  * (the linker ensures that you do not pay for it if your do not actually use it). To add logging to your project,
@@ -57,16 +262,29 @@ typedef enum {
  *     stripping
  *   - add an HLSLoggerLevel setting to your project main .plist file, with one of the following values (DEBUG, INFO,
  *     WARN, ERROR or FATAL). This sets the logging level to apply
+ *   - optionally, add an HLSLoggerCategoryLevels dictionary to your project main .plist file, mapping category names
+ *     (General, Task, Animation, Container, CoreData or Localization) to the level to apply to them. Categories which
+ *     do not appear in it use the HLSLoggerLevel setting. Category levels can also be changed at runtime
+ *   - optionally, add an HLSLoggerSpanSamplingInterval number to your project main .plist file to measure only one
+ *     span out of this number on each thread (0 disables span measurements, see HLSLoggerSpanBegin)
  *
  * HLSLogger supports XcodeColors (see https://github.com/robbiehanson/XcodeColors for the active fork), an Xcode plugin
  * adding colors to the Xcode debugging console. Simply install the plugin and set an environment variable called 
  * 'XcodeColors' to YES to enable it for your project.
  *
+ * Log entries are formatted on the calling thread (only if their level is enabled) and written to sinks on a serial
+ * background queue, so that logging never blocks for console or file I/O. Entries are written in the order they are
+ * logged. Fatal entries are always written (and sinks flushed) before the logging method returns. By default, a logger
+ * writes to an HLSConsoleLoggerSink. Use -addSink: to write to other destinations (e.g. an HLSFileLoggerSink)
+ *
  * Designated initializer: -initWithLevel:
  */
 @interface HLSLogger : NSObject {
 @private
 	HLSLoggerLevel m_level;
+    NSMutableArray *m_sinks;                    // Only accessed from the writer queue
+    dispatch_queue_t m_queue;
+    BOOL m_asynchronous;
 }
 
 /**
@@ -74,11 +292,60 @@ typedef enum {
  */
 + (HLSLogger *)sharedLogger;
 
+/**
+ * Change the level of a category at runtime, or return its current level. Category levels apply to the logging macros,
+ * which always log to the shared logger. A new level might not be seen immediately by other threads
+ */
++ (void)setLevel:(HLSLoggerLevel)level forCategory:(HLSLoggerCategory)category;
++ (HLSLoggerLevel)levelForCategory:(HLSLoggerCategory)category;
+
 - (id)initWithLevel:(HLSLoggerLevel)level;
 
 /**
- * Logging functions; should never be called directly, use the macros instead
+ * Add a sink receiving log entries. Entries logged after this method returns are written to it
+ */
+- (void)addSink:(id<HLSLoggerSink>)sink;
+
+/**
+ * Remove a sink. Entries logged after this method returns are not written to it anymore
+ */
+- (void)removeSink:(id<HLSLoggerSink>)sink;
+
+/**
+ * The sinks currently attached to the logger
+ */
+- (NSArray *)sinks;
+
+/**
+ * If set to NO, entries are written to sinks before logging methods return, which can be useful when debugging
+ *
+ * The default value is YES
+ */
+@property (nonatomic, assign, getter=isAsynchronous) BOOL asynchronous;
+
+/**
+ * Block until all entries logged so far have been written (including recorded structured entries which have not
+ * been written yet), and flush sinks
+ */
+- (void)flush;
+
+/**
+ * Format the structured entries currently held by the ring buffer (oldest first), each preceded by its level,
+ * date and thread. Only available for the shared logger
+ */
+- (NSArray *)recordedEntries;
+
+/**
+ * Format the structured entries recorded since the last call and write them to the sinks. Only available for the 
+ * shared logger
+ */
+- (void)writeRecordedEntries;
+
+/**
+ * Logging functions; should never be called directly, use the macros instead. The first method applies the level of
+ * the category, the others the level of the logger
  */
+- (void)logMessage:(NSString *)message withLevel:(HLSLoggerLevel)level category:(HLSLoggerCategory)category;
 - (void)debug:(NSString *)message;
 - (void)info:(NSString *)message;
 - (void)warn:(NSString *)message;
@@ -8,20 +8,88 @@
 
 #import "HLSLogger.h"
 
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+#import <pthread.h>
+#import "HLSConsoleLoggerSink.h"
+#import "HLSLaunchTracer.h"
+
 #pragma mark -
 #pragma mark HLSLoggerMode struct
 
 typedef struct {
 	NSString *name;                 // Mode name
 	HLSLoggerLevel level;           // Corresponding level
-    NSString *rgbValues;            // RGB values for XcodeColors
 } HLSLoggerMode;
 
-static const HLSLoggerMode kLoggerModeDebug = {@"DEBUG", 0, nil};
-static const HLSLoggerMode kLoggerModeInfo = {@"INFO", 1, nil};
-static const HLSLoggerMode kLoggerModeWarn = {@"WARN", 2, @"255,120,0"};
-static const HLSLoggerMode kLoggerModeError = {@"ERROR", 3, @"255,0,0"};
-static const HLSLoggerMode kLoggerModeFatal = {@"FATAL", 4, @"255,0,0"};
+static const HLSLoggerMode kLoggerModeDebug = {@"DEBUG", HLSLoggerLevelDebug};
+static const HLSLoggerMode kLoggerModeInfo = {@"INFO", HLSLoggerLevelInfo};
+static const HLSLoggerMode kLoggerModeWarn = {@"WARN", HLSLoggerLevelWarn};
+static const HLSLoggerMode kLoggerModeError = {@"ERROR", HLSLoggerLevelError};
+static const HLSLoggerMode kLoggerModeFatal = {@"FATAL", HLSLoggerLevelFatal};
+
+HLSLoggerLevel HLSLoggerSharedLoggerLevel = HLSLoggerLevelAll;
+HLSLoggerLevel HLSLoggerCategoryLevels[HLSLoggerCategoryEnumSize];                 // All enabled (HLSLoggerLevelAll) until set
+
+// Category names, as used in the main .plist file
+static NSString * const kLoggerCategoryNames[HLSLoggerCategoryEnumSize] = {
+    @"General",
+    @"Task",
+    @"Animation",
+    @"Container",
+    @"CoreData",
+    @"Localization"
+};
+
+#pragma mark -
+#pragma mark HLSLoggerRecordStorage struct
+
+typedef enum {
+    HLSLoggerRecordArgumentTypeEnumBegin = 0,
+    HLSLoggerRecordArgumentTypeInt = HLSLoggerRecordArgumentTypeEnumBegin,
+    HLSLoggerRecordArgumentTypeLong,
+    HLSLoggerRecordArgumentTypeLongLong,
+    HLSLoggerRecordArgumentTypeDouble,
+    HLSLoggerRecordArgumentTypePointer,
+    HLSLoggerRecordArgumentTypeCString,
+    HLSLoggerRecordArgumentTypeObject,
+    HLSLoggerRecordArgumentTypeEnumEnd,
+    HLSLoggerRecordArgumentTypeEnumSize = HLSLoggerRecordArgumentTypeEnumEnd - HLSLoggerRecordArgumentTypeEnumBegin
+} HLSLoggerRecordArgumentType;
+
+typedef union {
+    long long integer;
+    double real;
+    const void *pointer;
+} HLSLoggerRecordArgument;
+
+typedef struct {
+    volatile int64_t sequence;                                                      // Index + 1 once complete, 0 while being written
+    uint64_t time;                                                                  // Mach absolute time
+    const char *format;
+    uint32_t threadID;
+    uint8_t level;
+    uint8_t numberOfArguments;
+    uint8_t argumentTypes[HLS_LOGGER_RECORD_MAX_ARGUMENTS];
+    HLSLoggerRecordArgument arguments[HLS_LOGGER_RECORD_MAX_ARGUMENTS];
+} HLSLoggerRecordStorage;
+
+// Ring buffer of records, allocated when the first record is made. Writers claim slots atomically and never block
+static HLSLoggerRecordStorage *s_records = NULL;
+static volatile int64_t s_nextRecordIndex = 0;
+static int64_t s_nextRecordIndexToWrite = 0;                                        // Protected by @synchronized on the shared logger
+
+// Reference times for converting record times into dates
+static uint64_t s_referenceRecordTime = 0;
+static CFAbsoluteTime s_referenceAbsoluteTime = 0.;
+static mach_timebase_info_data_t s_timebaseInfo;
+
+// Function declarations
+static HLSLoggerLevel levelForName(NSString *name);
+static NSString *levelName(HLSLoggerLevel level);
+static NSUInteger copyRecords(int64_t fromIndex, int64_t toIndex, HLSLoggerRecordStorage *records);
+static NSString *formattedRecordMessage(const HLSLoggerRecordStorage *record);
+static NSDate *recordDate(const HLSLoggerRecordStorage *record);
 
 #pragma mark -
 #pragma mark HLSLogger class
@@ -29,6 +97,9 @@ static const HLSLoggerMode kLoggerModeFatal = {@"FATAL", 4, @"255,0,0"};
 @interface HLSLogger ()
 
 - (void)logMessage:(NSString *)message forMode:(HLSLoggerMode)mode;
+- (void)writeMessage:(NSString *)message withLevel:(HLSLoggerLevel)level;
+
+- (NSArray *)recordsFromIndex:(int64_t)fromIndex toIndex:(int64_t)toIndex;
 
 @end
 
@@ -39,48 +110,78 @@ static const HLSLoggerMode kLoggerModeFatal = {@"FATAL", 4, @"255,0,0"};
 + (HLSLogger *)sharedLogger
 {
 	static HLSLogger *s_instance = nil;
-	
+    
     // Double-checked locking pattern
 	if (! s_instance) {
         @synchronized(self) {
             if (! s_instance) {
+                CFAbsoluteTime startTime = HLSLaunchTracerBegin();
+                
                 // Read the main .plist file content
                 NSDictionary *infoProperties = [[NSBundle mainBundle] infoDictionary];
                 
                 // Create a logger with the corresponding level
-                NSString *levelName = [infoProperties valueForKey:@"HLSLoggerLevel"];
-                HLSLoggerLevel level;
-                if ([levelName isEqualToString:kLoggerModeDebug.name]) {
-                    level = HLSLoggerLevelDebug;
-                }
-                else if ([levelName isEqualToString:kLoggerModeInfo.name]) {
-                    level = HLSLoggerLevelInfo;		
-                }
-                else if ([levelName isEqualToString:kLoggerModeWarn.name]) {
-                    level = HLSLoggerLevelWarn;
-                }
-                else if ([levelName isEqualToString:kLoggerModeError.name]) {
-                    level = HLSLoggerLevelError;
+                HLSLoggerLevel level = levelForName([infoProperties valueForKey:@"HLSLoggerLevel"]);
+                HLSLoggerSharedLoggerLevel = level;
+                
+                // Categories use the same level unless specified otherwise
+                NSDictionary *categoryLevelNames = [infoProperties valueForKey:@"HLSLoggerCategoryLevels"];
+                if (categoryLevelNames && ! [categoryLevelNames isKindOfClass:[NSDictionary class]]) {
+                    NSLog(@"HLSLoggerCategoryLevels must be a dictionary, ignored");
+                    categoryLevelNames = nil;
                 }
-                else if ([levelName isEqualToString:kLoggerModeFatal.name]) {
-                    level = HLSLoggerLevelFatal;
+                for (HLSLoggerCategory category = HLSLoggerCategoryEnumBegin; category < HLSLoggerCategoryEnumEnd; ++category) {
+                    NSString *categoryLevelName = [categoryLevelNames objectForKey:kLoggerCategoryNames[category]];
+                    HLSLoggerCategoryLevels[category] = categoryLevelName ? levelForName(categoryLevelName) : level;
                 }
-                else {
-                    level = HLSLoggerLevelNone;
+                
+                NSNumber *spanSamplingInterval = [infoProperties valueForKey:@"HLSLoggerSpanSamplingInterval"];
+                if (spanSamplingInterval) {
+                    HLSLoggerSpanSamplingInterval = [spanSamplingInterval unsignedIntegerValue];
                 }
-                s_instance = [[HLSLogger alloc] initWithLevel:level];                
+                
+                // Published last, so that levels are known when other threads see the instance
+                s_instance = [[HLSLogger alloc] initWithLevel:level];
+                
+                HLSLaunchTracerEnd("+[HLSLogger sharedLogger] setup", startTime);
             }
         }
 	}
 	return s_instance;
 }
 
++ (void)setLevel:(HLSLoggerLevel)level forCategory:(HLSLoggerCategory)category
+{
+    if (category < HLSLoggerCategoryEnumBegin || category >= HLSLoggerCategoryEnumEnd) {
+        return;
+    }
+    
+    // Ensure the levels read from the main .plist file do not override the one being set
+    [HLSLogger sharedLogger];
+    
+    HLSLoggerCategoryLevels[category] = level;
+}
+
++ (HLSLoggerLevel)levelForCategory:(HLSLoggerCategory)category
+{
+    if (category < HLSLoggerCategoryEnumBegin || category >= HLSLoggerCategoryEnumEnd) {
+        return HLSLoggerLevelNone;
+    }
+    
+    [HLSLogger sharedLogger];
+    
+    return HLSLoggerCategoryLevels[category];
+}
+
 #pragma mark Object creation and destruction
 
 - (id)initWithLevel:(HLSLoggerLevel)level
 {
 	if ((self = [super init])) {
 		m_level = level;
+        m_sinks = [[NSMutableArray alloc] initWithObjects:[[[HLSConsoleLoggerSink alloc] init] autorelease], nil];
+        m_queue = dispatch_queue_create("ch.hortis.CoconutKit.HLSLogger", NULL);
+        m_asynchronous = YES;
 	}
 	return self;
 }
@@ -90,32 +191,113 @@ static const HLSLoggerMode kLoggerModeFatal = {@"FATAL", 4, @"255,0,0"};
 	return [self initWithLevel:HLSLoggerLevelNone];
 }
 
+- (void)dealloc
+{
+    dispatch_release(m_queue);
+    [m_sinks release];
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize asynchronous = m_asynchronous;
+
+#pragma mark Sinks
+
+- (void)addSink:(id<HLSLoggerSink>)sink
+{
+    if (! sink) {
+        return;
+    }
+    
+    // Sinks are only accessed from the writer queue, no lock is required. Since the queue is serial, entries logged
+    // afterwards are written to the new sink
+    dispatch_async(m_queue, ^{
+        if (! [m_sinks containsObject:sink]) {
+            [m_sinks addObject:sink];
+        }
+    });
+}
+
+- (void)removeSink:(id<HLSLoggerSink>)sink
+{
+    if (! sink) {
+        return;
+    }
+    
+    dispatch_async(m_queue, ^{
+        [m_sinks removeObject:sink];
+    });
+}
+
+- (NSArray *)sinks
+{
+    __block NSArray *sinks = nil;
+    dispatch_sync(m_queue, ^{
+        sinks = [[NSArray alloc] initWithArray:m_sinks];
+    });
+    return [sinks autorelease];
+}
+
 #pragma mark Logging methods
 
+- (void)logMessage:(NSString *)message withLevel:(HLSLoggerLevel)level category:(HLSLoggerCategory)category
+{
+    if (category < HLSLoggerCategoryEnumBegin || category >= HLSLoggerCategoryEnumEnd || level < HLSLoggerCategoryLevels[category]) {
+        return;
+    }
+    
+    [self writeMessage:message withLevel:level];
+}
+
 - (void)logMessage:(NSString *)message forMode:(HLSLoggerMode)mode
 {
 	if (m_level > mode.level) {
 		return;
 	}
+    
+    [self writeMessage:message withLevel:mode.level];
+}
 
-    static BOOL s_configurationLoaded = NO;
-    static BOOL s_xcodeColorsEnabled = NO;
-    if (! s_configurationLoaded) {
-        NSString *xcodeColorsValue = [[[NSProcessInfo processInfo] environment] objectForKey:@"XcodeColors"];
-        s_xcodeColorsEnabled = [xcodeColorsValue isEqualToString:@"YES"];
-        s_configurationLoaded = YES;
-    }
+- (void)writeMessage:(NSString *)message withLevel:(HLSLoggerLevel)level
+{
+    // Format on the calling thread, write on the writer queue
+    NSString *logEntry = [NSString stringWithFormat:@"[%@] %@", levelName(level), message];
+    NSDate *date = [NSDate date];
+    BOOL fatal = (level == HLSLoggerLevelFatal);
+    void (^writeBlock)(void) = ^{
+        for (id<HLSLoggerSink> sink in m_sinks) {
+            [sink writeLogEntry:logEntry withLevel:level date:date];
+            
+            // Fatal entries usually precede a crash. Be sure they are not lost
+            if (fatal && [sink respondsToSelector:@selector(flush)]) {
+                [sink flush];
+            }
+        }
+    };
     
-    // NSLog is thread-safe
-    NSString *fullLogEntry = [NSString stringWithFormat:@"[%@] %@", mode.name, message];
-    if (s_xcodeColorsEnabled && mode.rgbValues) {
-        NSLog(@"\033[fg%@;%@\033[;", mode.rgbValues, fullLogEntry);
+    if (m_asynchronous && ! fatal) {
+        dispatch_async(m_queue, writeBlock);
     }
     else {
-        NSLog(@"%@", fullLogEntry);
+        dispatch_sync(m_queue, writeBlock);
     }
 }
 
+- (void)flush
+{
+    [self writeRecordedEntries];
+    
+    dispatch_sync(m_queue, ^{
+        for (id<HLSLoggerSink> sink in m_sinks) {
+            if ([sink respondsToSelector:@selector(flush)]) {
+                [sink flush];
+            }
+        }
+    });
+}
+
 - (void)debug:(NSString *)message
 {
 	[self logMessage:message forMode:kLoggerModeDebug];
@@ -141,6 +323,85 @@ static const HLSLoggerMode kLoggerModeFatal = {@"FATAL", 4, @"255,0,0"};
 	[self logMessage:message forMode:kLoggerModeFatal];
 }
 
+#pragma mark Structured entries
+
+- (NSArray *)recordsFromIndex:(int64_t)fromIndex toIndex:(int64_t)toIndex
+{
+    if (! s_records || self != [HLSLogger sharedLogger]) {
+        return [NSArray array];
+    }
+    
+    // Older records have been overwritten
+    fromIndex = MAX(fromIndex, toIndex - HLS_LOGGER_RECORD_CAPACITY);
+    if (fromIndex >= toIndex) {
+        return [NSArray array];
+    }
+    
+    HLSLoggerRecordStorage *records = malloc((size_t)(toIndex - fromIndex) * sizeof(HLSLoggerRecordStorage));
+    NSUInteger nbrRecords = copyRecords(fromIndex, toIndex, records);
+    NSMutableArray *recordValues = [NSMutableArray arrayWithCapacity:nbrRecords];
+    for (NSUInteger i = 0; i < nbrRecords; ++i) {
+        [recordValues addObject:[NSValue valueWithBytes:&records[i] objCType:@encode(HLSLoggerRecordStorage)]];
+    }
+    free(records);
+    return recordValues;
+}
+
+- (NSArray *)recordedEntries
+{
+    NSArray *recordValues = [self recordsFromIndex:0 toIndex:s_nextRecordIndex];
+    
+    NSDateFormatter *dateFormatter = [[[NSDateFormatter alloc] init] autorelease];
+    [dateFormatter setLocale:[[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"] autorelease]];
+    [dateFormatter setDateFormat:@"yyyy-MM-dd HH:mm:ss.SSS"];
+    
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:[recordValues count]];
+    for (NSValue *recordValue in recordValues) {
+        HLSLoggerRecordStorage record;
+        [recordValue getValue:&record];
+        [entries addObject:[NSString stringWithFormat:@"%@ [%@] (thread 0x%x) %@",
+                            [dateFormatter stringFromDate:recordDate(&record)],
+                            levelName(record.level),
+                            record.threadID,
+                            formattedRecordMessage(&record)]];
+    }
+    return [NSArray arrayWithArray:entries];
+}
+
+- (void)writeRecordedEntries
+{
+    // Formatting happens here, on the calling thread, and only once for each record
+    NSMutableArray *logEntries = [NSMutableArray array];
+    NSMutableArray *dates = [NSMutableArray array];
+    NSMutableArray *levelNumbers = [NSMutableArray array];
+    @synchronized(self) {
+        int64_t nextRecordIndex = s_nextRecordIndex;
+        for (NSValue *recordValue in [self recordsFromIndex:s_nextRecordIndexToWrite toIndex:nextRecordIndex]) {
+            HLSLoggerRecordStorage record;
+            [recordValue getValue:&record];
+            [logEntries addObject:[NSString stringWithFormat:@"[%@] (thread 0x%x) %@", levelName(record.level), record.threadID,
+                                   formattedRecordMessage(&record)]];
+            [dates addObject:recordDate(&record)];
+            [levelNumbers addObject:[NSNumber numberWithInt:record.level]];
+        }
+        s_nextRecordIndexToWrite = nextRecordIndex;
+    }
+    
+    if ([logEntries count] == 0) {
+        return;
+    }
+    
+    dispatch_async(m_queue, ^{
+        for (id<HLSLoggerSink> sink in m_sinks) {
+            for (NSUInteger i = 0; i < [logEntries count]; ++i) {
+                [sink writeLogEntry:[logEntries objectAtIndex:i]
+                          withLevel:[[levelNumbers objectAtIndex:i] intValue]
+                               date:[dates objectAtIndex:i]];
+            }
+        }
+    });
+}
+
 #pragma mark Level testers
 
 - (BOOL)isDebug
@@ -169,3 +430,289 @@ static const HLSLoggerMode kLoggerModeFatal = {@"FATAL", 4, @"255,0,0"};
 }
 
 @end
+
+#pragma mark -
+#pragma mark Functions
+
+void HLSLoggerRecord(HLSLoggerLevel level, HLSLoggerCategory category, const char *format, ...)
+{
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        // Ensure the category levels are known
+        [HLSLogger sharedLogger];
+        
+        mach_timebase_info(&s_timebaseInfo);
+        s_referenceRecordTime = mach_absolute_time();
+        s_referenceAbsoluteTime = CFAbsoluteTimeGetCurrent();
+        s_records = calloc(HLS_LOGGER_RECORD_CAPACITY, sizeof(HLSLoggerRecordStorage));
+    });
+    
+    if (category < HLSLoggerCategoryEnumBegin || category >= HLSLoggerCategoryEnumEnd || level < HLSLoggerCategoryLevels[category] 
+            || ! format) {
+        return;
+    }
+    
+    int64_t index = OSAtomicIncrement64Barrier(&s_nextRecordIndex) - 1;
+    HLSLoggerRecordStorage *record = &s_records[index % HLS_LOGGER_RECORD_CAPACITY];
+    
+    // Mark the slot as being written, so that readers discard it
+    record->sequence = 0;
+    OSMemoryBarrier();
+    
+    record->time = mach_absolute_time();
+    record->format = format;
+    record->threadID = pthread_mach_thread_np(pthread_self());
+    record->level = level;
+    
+    // Only collect raw arguments. Their types are given by the conversion specifications
+    va_list arguments;
+    va_start(arguments, format);
+    uint8_t nbrArguments = 0;
+    for (const char *pChar = format; *pChar != '\0' && nbrArguments < HLS_LOGGER_RECORD_MAX_ARGUMENTS; ++pChar) {
+        if (*pChar != '%') {
+            continue;
+        }
+        
+        ++pChar;
+        if (*pChar == '%') {
+            continue;
+        }
+        
+        // Flags, width and precision
+        while (*pChar != '\0' && strchr("-+ #0123456789.", *pChar)) {
+            ++pChar;
+        }
+        
+        // Length modifiers
+        NSUInteger length = 0;
+        while (*pChar != '\0' && strchr("hlqjzt", *pChar)) {
+            if (*pChar == 'l') {
+                ++length;
+            }
+            else if (*pChar == 'q' || *pChar == 'j') {
+                length = 2;
+            }
+            else if (*pChar == 'z' || *pChar == 't') {
+                length = 1;
+            }
+            ++pChar;
+        }
+        
+        HLSLoggerRecordArgument *argument = &record->arguments[nbrArguments];
+        if (*pChar != '\0' && strchr("diouxXcC", *pChar)) {
+            if (length == 0) {
+                record->argumentTypes[nbrArguments] = HLSLoggerRecordArgumentTypeInt;
+                argument->integer = va_arg(arguments, int);
+            }
+            else if (length == 1) {
+                record->argumentTypes[nbrArguments] = HLSLoggerRecordArgumentTypeLong;
+                argument->integer = va_arg(arguments, long);
+            }
+            else {
+                record->argumentTypes[nbrArguments] = HLSLoggerRecordArgumentTypeLongLong;
+                argument->integer = va_arg(arguments, long long);
+            }
+        }
+        else if (*pChar != '\0' && strchr("eEfFgGaA", *pChar)) {
+            record->argumentTypes[nbrArguments] = HLSLoggerRecordArgumentTypeDouble;
+            argument->real = va_arg(arguments, double);
+        }
+        else if (*pChar == 'p') {
+            record->argumentTypes[nbrArguments] = HLSLoggerRecordArgumentTypePointer;
+            argument->pointer = va_arg(arguments, void *);
+        }
+        else if (*pChar == 's') {
+            record->argumentTypes[nbrArguments] = HLSLoggerRecordArgumentTypeCString;
+            argument->pointer = va_arg(arguments, const char *);
+        }
+        else if (*pChar == '@') {
+            // Objects might be deallocated before the record is read. Only keep their address
+            record->argumentTypes[nbrArguments] = HLSLoggerRecordArgumentTypeObject;
+            argument->pointer = va_arg(arguments, void *);
+        }
+        else {
+            // Unsupported conversion (e.g. * width). Stop collecting arguments
+            break;
+        }
+        ++nbrArguments;
+    }
+    va_end(arguments);
+    record->numberOfArguments = nbrArguments;
+    
+    // Publish the record
+    OSMemoryBarrier();
+    record->sequence = index + 1;
+}
+
+NSString *HLSLoggerCategoryName(HLSLoggerCategory category)
+{
+    if (category < HLSLoggerCategoryEnumBegin || category >= HLSLoggerCategoryEnumEnd) {
+        return nil;
+    }
+    
+    return kLoggerCategoryNames[category];
+}
+
+#pragma mark -
+#pragma mark Static functions
+
+// Return HLSLoggerLevelNone if the name is not valid
+static HLSLoggerLevel levelForName(NSString *name)
+{
+    if ([name isEqualToString:kLoggerModeDebug.name]) {
+        return HLSLoggerLevelDebug;
+    }
+    else if ([name isEqualToString:kLoggerModeInfo.name]) {
+        return HLSLoggerLevelInfo;
+    }
+    else if ([name isEqualToString:kLoggerModeWarn.name]) {
+        return HLSLoggerLevelWarn;
+    }
+    else if ([name isEqualToString:kLoggerModeError.name]) {
+        return HLSLoggerLevelError;
+    }
+    else if ([name isEqualToString:kLoggerModeFatal.name]) {
+        return HLSLoggerLevelFatal;
+    }
+    else {
+        return HLSLoggerLevelNone;
+    }
+}
+
+static NSString *levelName(HLSLoggerLevel level)
+{
+    switch (level) {
+        case HLSLoggerLevelDebug: {
+            return kLoggerModeDebug.name;
+            break;
+        }
+        
+        case HLSLoggerLevelInfo: {
+            return kLoggerModeInfo.name;
+            break;
+        }
+        
+        case HLSLoggerLevelWarn: {
+            return kLoggerModeWarn.name;
+            break;
+        }
+        
+        case HLSLoggerLevelError: {
+            return kLoggerModeError.name;
+            break;
+        }
+        
+        default: {
+            return kLoggerModeFatal.name;
+            break;
+        }
+    }
+}
+
+// Copy the complete records between two indices into the array given as parameter (large enough), and return the number
+// of records copied. Records being written, or overwritten during the copy, are skipped
+static NSUInteger copyRecords(int64_t fromIndex, int64_t toIndex, HLSLoggerRecordStorage *records)
+{
+    NSUInteger nbrRecords = 0;
+    for (int64_t index = fromIndex; index < toIndex; ++index) {
+        HLSLoggerRecordStorage *record = &s_records[index % HLS_LOGGER_RECORD_CAPACITY];
+        int64_t sequence = record->sequence;
+        OSMemoryBarrier();
+        records[nbrRecords] = *record;
+        OSMemoryBarrier();
+        if (sequence != index + 1 || record->sequence != sequence) {
+            continue;
+        }
+        ++nbrRecords;
+    }
+    return nbrRecords;
+}
+
+static NSString *formattedRecordMessage(const HLSLoggerRecordStorage *record)
+{
+    NSMutableData *messageData = [NSMutableData data];
+    uint8_t argumentIndex = 0;
+    const char *pChar = record->format;
+    while (*pChar != '\0') {
+        // Literal characters
+        const char *pLiteralEnd = strchr(pChar, '%') ?: pChar + strlen(pChar);
+        [messageData appendBytes:pChar length:pLiteralEnd - pChar];
+        pChar = pLiteralEnd;
+        if (*pChar == '\0') {
+            break;
+        }
+        
+        if (*(pChar + 1) == '%') {
+            [messageData appendBytes:"%" length:1];
+            pChar += 2;
+            continue;
+        }
+        
+        // Extract the conversion specification, and format its argument alone
+        const char *pSpecificationEnd = pChar + 1;
+        while (*pSpecificationEnd != '\0' && strchr("-+ #0123456789.hlqjzt", *pSpecificationEnd)) {
+            ++pSpecificationEnd;
+        }
+        if (*pSpecificationEnd != '\0') {
+            ++pSpecificationEnd;
+        }
+        
+        if (argumentIndex >= record->numberOfArguments) {
+            [messageData appendBytes:pChar length:pSpecificationEnd - pChar];
+            pChar = pSpecificationEnd;
+            continue;
+        }
+        
+        char specification[32];
+        size_t specificationLength = MIN((size_t)(pSpecificationEnd - pChar), sizeof(specification) - 1);
+        memcpy(specification, pChar, specificationLength);
+        specification[specificationLength] = '\0';
+        
+        char formattedArgument[256];
+        const HLSLoggerRecordArgument *argument = &record->arguments[argumentIndex];
+        switch (record->argumentTypes[argumentIndex]) {
+            case HLSLoggerRecordArgumentTypeInt: {
+                snprintf(formattedArgument, sizeof(formattedArgument), specification, (int)argument->integer);
+                break;
+            }
+            
+            case HLSLoggerRecordArgumentTypeLong: {
+                snprintf(formattedArgument, sizeof(formattedArgument), specification, (long)argument->integer);
+                break;
+            }
+            
+            case HLSLoggerRecordArgumentTypeLongLong: {
+                snprintf(formattedArgument, sizeof(formattedArgument), specification, argument->integer);
+                break;
+            }
+            
+            case HLSLoggerRecordArgumentTypeDouble: {
+                snprintf(formattedArgument, sizeof(formattedArgument), specification, argument->real);
+                break;
+            }
+            
+            case HLSLoggerRecordArgumentTypePointer:
+            case HLSLoggerRecordArgumentTypeCString: {
+                snprintf(formattedArgument, sizeof(formattedArgument), specification, argument->pointer);
+                break;
+            }
+            
+            default: {
+                snprintf(formattedArgument, sizeof(formattedArgument), "<object %p>", argument->pointer);
+                break;
+            }
+        }
+        [messageData appendBytes:formattedArgument length:strlen(formattedArgument)];
+        
+        ++argumentIndex;
+        pChar = pSpecificationEnd;
+    }
+    
+    return [[[NSString alloc] initWithData:messageData encoding:NSUTF8StringEncoding] autorelease];
+}
+
+static NSDate *recordDate(const HLSLoggerRecordStorage *record)
+{
+    double elapsedNanoseconds = (double)(int64_t)(record->time - s_referenceRecordTime) * s_timebaseInfo.numer / s_timebaseInfo.denom;
+    return [NSDate dateWithTimeIntervalSinceReferenceDate:s_referenceAbsoluteTime + elapsedNanoseconds / NSEC_PER_SEC];
+}
@@ -0,0 +1,63 @@
+//
+//  HLSLoggerSpan.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSLogger.h"
+
+// Value returned when no span duration is available
+#define kLoggerSpanNoValueAvailable                                   -1.
+
+/**
+ * Spans measured with HLSLoggerSpanBegin and HLSLoggerSpanEnd are first stored into a buffer of the thread on which
+ * they end, so that measuring a span never waits for other threads. Buffers are aggregated when they are full, when
+ * their thread exits, and before statistics are read. Durations of spans with the same name are aggregated into
+ * a histogram (a few buckets for each power of 2 of microseconds), so that memory consumption does not grow with the
+ * number of spans measured. The most recently measured spans are also kept for export as a timeline.
+ *
+ * All functions can be called from any thread
+ */
+
+/**
+ * Change the number of spans out of which one is measured on each thread. Set 0 to disable span measurements
+ */
+void HLSLoggerSpanSetSamplingInterval(NSUInteger samplingInterval);
+
+/**
+ * The names of the spans for which durations have been measured
+ */
+NSArray *HLSLoggerSpanNames(void);
+
+/**
+ * Return the number of measured spans with a given name. Use nil to count all spans
+ */
+NSUInteger HLSLoggerSpanCount(NSString *nameOrNil);
+
+/**
+ * Return the percentile (between 0 and 100, e.g. 50 for the median or 95) of the durations of spans with a given
+ * name. The value is the upper bound of the histogram bucket it falls into, and is therefore accurate within 25%.
+ * Returns kLoggerSpanNoValueAvailable if no span with this name has been measured
+ */
+NSTimeInterval HLSLoggerSpanPercentile(double percentile, NSString *name);
+
+/**
+ * Return the most recently measured spans as a timeline in the Trace Event JSON format, as for task metrics (see
+ * -[HLSTaskMetrics traceEventString]). Spans appear on the thread they ended on. The histograms of all spans are
+ * exported as metadata
+ */
+NSString *HLSLoggerSpanTraceEventString(void);
+
+/**
+ * Return the name of the innermost span being measured on the main thread, or NULL if none. Only spans which are
+ * measured (see HLSLoggerSpanSetSamplingInterval) are tracked. This function takes no lock and can therefore be called
+ * while the main thread is blocked or suspended (e.g. by a watchdog)
+ */
+const char *HLSLoggerSpanMainThreadActiveSpanName(void);
+
+/**
+ * Discard all measurements
+ */
+void HLSLoggerSpanClear(void);
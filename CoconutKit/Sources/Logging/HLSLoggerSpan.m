@@ -0,0 +1,496 @@
+//
+//  HLSLoggerSpan.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSLoggerSpan.h"
+
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+#import <pthread.h>
+
+// Number of spans a thread buffer holds before it is aggregated
+#define kLoggerSpanThreadBufferCapacity                               256
+
+// Number of most recently measured spans kept for the timeline export
+#define kLoggerSpanRecentRecordCapacity                               1000
+
+// Durations below 4 us have one bucket per microsecond, larger durations 4 buckets per power of 2 (up to 2^33 us, i.e.
+// more than 2 hours. Longer durations are counted in the last bucket)
+#define kLoggerSpanHistogramBucketCount                               128
+
+// Maximum nesting of spans tracked on the main thread
+#define kLoggerSpanMainThreadStackCapacity                            32
+
+NSUInteger HLSLoggerSpanSamplingInterval = 1;
+
+/**
+ * A measured span
+ */
+typedef struct {
+    const char *name;
+    HLSLoggerCategory category;
+    uint64_t startTime;                                                             // Mach absolute times
+    uint64_t endTime;
+    uint32_t threadID;
+} HLSLoggerSpanRecord;
+
+/**
+ * The spans measured on a thread since its buffer was last aggregated
+ */
+typedef struct HLSLoggerSpanThreadBuffer {
+    OSSpinLock lock;                                                                // Only contended during aggregation
+    NSUInteger samplingCountdown;                                                   // Only accessed from the owning thread
+    uint32_t threadID;
+    NSUInteger numberOfRecords;
+    HLSLoggerSpanRecord records[kLoggerSpanThreadBufferCapacity];
+    struct HLSLoggerSpanThreadBuffer *next;
+} HLSLoggerSpanThreadBuffer;
+
+/**
+ * Durations aggregated for a span name
+ */
+typedef struct {
+    const char *name;
+    HLSLoggerCategory category;
+    NSUInteger count;
+    uint64_t totalDuration;                                                         // Nanoseconds
+    uint64_t minimumDuration;
+    uint64_t maximumDuration;
+    NSUInteger buckets[kLoggerSpanHistogramBucketCount];
+} HLSLoggerSpanHistogram;
+
+// Aggregated measurements and list of thread buffers, protected by s_lock. Thread buffers are always locked after it
+static OSSpinLock s_lock = OS_SPINLOCK_INIT;
+static HLSLoggerSpanThreadBuffer *s_threadBuffers = NULL;
+static HLSLoggerSpanHistogram *s_histograms = NULL;                                 // In the order in which names first appeared
+static NSUInteger s_numberOfHistograms = 0;
+static HLSLoggerSpanRecord s_recentRecords[kLoggerSpanRecentRecordCapacity];
+static NSUInteger s_numberOfAggregatedRecords = 0;
+
+// Names of the spans being measured on the main thread, innermost last. Only written from the main thread
+static const char * volatile s_mainThreadSpanNames[kLoggerSpanMainThreadStackCapacity];
+static volatile NSUInteger s_mainThreadSpanDepth = 0;
+
+static pthread_key_t s_threadBufferKey;
+static mach_timebase_info_data_t s_timebaseInfo;
+static uint64_t s_referenceTime = 0;
+
+// Function declarations
+static void setup(void);
+static HLSLoggerSpanThreadBuffer *currentThreadBuffer(void);
+static void destroyThreadBuffer(void *threadBuffer);
+static void aggregateThreadBuffer(HLSLoggerSpanThreadBuffer *threadBuffer);
+static void aggregateAllThreadBuffers(void);
+static HLSLoggerSpanHistogram *histogramForName(const char *name, HLSLoggerCategory category);
+static NSUInteger copyHistograms(HLSLoggerSpanHistogram **pHistograms);
+static NSUInteger bucketForDuration(uint64_t duration);
+static uint64_t bucketLowerBound(NSUInteger bucket);
+static uint64_t durationInNanoseconds(uint64_t machDuration);
+static NSTimeInterval histogramPercentile(const HLSLoggerSpanHistogram *histogram, double percentile);
+static NSString *escapedString(NSString *string);
+
+#pragma mark -
+#pragma mark Functions
+
+void HLSLoggerSpanStart(HLSLoggerSpan *span)
+{
+    HLSLoggerSpanThreadBuffer *threadBuffer = currentThreadBuffer();
+    if (! threadBuffer || HLSLoggerSpanSamplingInterval == 0) {
+        return;
+    }
+    
+    // Measure one span, then skip the next samplingInterval - 1 ones
+    if (threadBuffer->samplingCountdown != 0) {
+        --threadBuffer->samplingCountdown;
+        return;
+    }
+    threadBuffer->samplingCountdown = HLSLoggerSpanSamplingInterval - 1;
+    
+    // Spans are nested since they begin and end in the same scope
+    if (pthread_main_np()) {
+        if (s_mainThreadSpanDepth < kLoggerSpanMainThreadStackCapacity) {
+            s_mainThreadSpanNames[s_mainThreadSpanDepth] = span->name;
+        }
+        OSMemoryBarrier();
+        ++s_mainThreadSpanDepth;
+    }
+    
+    span->startTime = mach_absolute_time();
+}
+
+void HLSLoggerSpanStop(HLSLoggerSpan *span)
+{
+    if (span->startTime == 0) {
+        return;
+    }
+    
+    uint64_t endTime = mach_absolute_time();
+    
+    if (pthread_main_np() && s_mainThreadSpanDepth != 0) {
+        --s_mainThreadSpanDepth;
+    }
+    
+    HLSLoggerSpanThreadBuffer *threadBuffer = currentThreadBuffer();
+    if (! threadBuffer) {
+        return;
+    }
+    
+    OSSpinLockLock(&threadBuffer->lock);
+    HLSLoggerSpanRecord *record = &threadBuffer->records[threadBuffer->numberOfRecords];
+    record->name = span->name;
+    record->category = span->category;
+    record->startTime = span->startTime;
+    record->endTime = endTime;
+    record->threadID = threadBuffer->threadID;
+    ++threadBuffer->numberOfRecords;
+    BOOL full = (threadBuffer->numberOfRecords == kLoggerSpanThreadBufferCapacity);
+    OSSpinLockUnlock(&threadBuffer->lock);
+    
+    // Ensure a span is never recorded twice
+    span->startTime = 0;
+    
+    // Only the owning thread adds records, the buffer cannot overflow before it has been aggregated
+    if (full) {
+        OSSpinLockLock(&s_lock);
+        aggregateThreadBuffer(threadBuffer);
+        OSSpinLockUnlock(&s_lock);
+    }
+}
+
+void HLSLoggerSpanSetSamplingInterval(NSUInteger samplingInterval)
+{
+    // Ensure the value read from the main .plist file does not override the one being set
+    [HLSLogger sharedLogger];
+    
+    HLSLoggerSpanSamplingInterval = samplingInterval;
+}
+
+NSArray *HLSLoggerSpanNames(void)
+{
+    HLSLoggerSpanHistogram *histograms = NULL;
+    NSUInteger numberOfHistograms = copyHistograms(&histograms);
+    
+    NSMutableArray *names = [NSMutableArray array];
+    for (NSUInteger i = 0; i < numberOfHistograms; ++i) {
+        [names addObject:[NSString stringWithUTF8String:histograms[i].name]];
+    }
+    free(histograms);
+    
+    return [NSArray arrayWithArray:names];
+}
+
+NSUInteger HLSLoggerSpanCount(NSString *nameOrNil)
+{
+    HLSLoggerSpanHistogram *histograms = NULL;
+    NSUInteger numberOfHistograms = copyHistograms(&histograms);
+    
+    NSUInteger count = 0;
+    for (NSUInteger i = 0; i < numberOfHistograms; ++i) {
+        if (nameOrNil && strcmp(histograms[i].name, [nameOrNil UTF8String]) != 0) {
+            continue;
+        }
+        count += histograms[i].count;
+    }
+    free(histograms);
+    
+    return count;
+}
+
+NSTimeInterval HLSLoggerSpanPercentile(double percentile, NSString *name)
+{
+    if (percentile < 0. || percentile > 100.) {
+        HLSLoggerError(@"The percentile must be between 0 and 100");
+        return kLoggerSpanNoValueAvailable;
+    }
+    
+    if (! name) {
+        return kLoggerSpanNoValueAvailable;
+    }
+    
+    HLSLoggerSpanHistogram *histograms = NULL;
+    NSUInteger numberOfHistograms = copyHistograms(&histograms);
+    
+    NSTimeInterval value = kLoggerSpanNoValueAvailable;
+    for (NSUInteger i = 0; i < numberOfHistograms; ++i) {
+        if (strcmp(histograms[i].name, [name UTF8String]) == 0) {
+            value = histogramPercentile(&histograms[i], percentile);
+            break;
+        }
+    }
+    free(histograms);
+    
+    return value;
+}
+
+NSString *HLSLoggerSpanTraceEventString(void)
+{
+    setup();
+    
+    // Work on copies
+    OSSpinLockLock(&s_lock);
+    aggregateAllThreadBuffers();
+    NSUInteger numberOfRecords = MIN(s_numberOfAggregatedRecords, kLoggerSpanRecentRecordCapacity);
+    NSUInteger firstRecordIndex = s_numberOfAggregatedRecords - numberOfRecords;
+    HLSLoggerSpanRecord *records = malloc(MAX(numberOfRecords, 1) * sizeof(HLSLoggerSpanRecord));
+    for (NSUInteger i = 0; i < numberOfRecords; ++i) {
+        records[i] = s_recentRecords[(firstRecordIndex + i) % kLoggerSpanRecentRecordCapacity];
+    }
+    NSUInteger numberOfHistograms = s_numberOfHistograms;
+    HLSLoggerSpanHistogram *histograms = malloc(MAX(numberOfHistograms, 1) * sizeof(HLSLoggerSpanHistogram));
+    memcpy(histograms, s_histograms, numberOfHistograms * sizeof(HLSLoggerSpanHistogram));
+    OSSpinLockUnlock(&s_lock);
+    
+    // Timestamps and durations in microseconds, as for task metrics
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger i = 0; i < numberOfRecords; ++i) {
+        HLSLoggerSpanRecord record = records[i];
+        [events addObject:[NSString stringWithFormat:@"{\"name\":\"%@\",\"cat\":\"%@\",\"ph\":\"X\",\"ts\":%.0f,\"dur\":%.0f,\"pid\":1,\"tid\":%u,\"args\":{}}",
+                           escapedString([NSString stringWithUTF8String:record.name]),
+                           HLSLoggerCategoryName(record.category),
+                           durationInNanoseconds(record.startTime - s_referenceTime) / 1e3,
+                           durationInNanoseconds(record.endTime - record.startTime) / 1e3,
+                           record.threadID]];
+    }
+    free(records);
+    
+    // Only non-empty buckets are exported, as [upper bound (in microseconds), count] pairs
+    NSMutableArray *histogramStrings = [NSMutableArray array];
+    for (NSUInteger i = 0; i < numberOfHistograms; ++i) {
+        HLSLoggerSpanHistogram *histogram = &histograms[i];
+        NSMutableArray *bucketStrings = [NSMutableArray array];
+        for (NSUInteger bucket = 0; bucket < kLoggerSpanHistogramBucketCount; ++bucket) {
+            if (histogram->buckets[bucket] == 0) {
+                continue;
+            }
+            [bucketStrings addObject:[NSString stringWithFormat:@"[%llu,%u]", bucketLowerBound(bucket + 1), histogram->buckets[bucket]]];
+        }
+        
+        [histogramStrings addObject:[NSString stringWithFormat:@"{\"name\":\"%@\",\"cat\":\"%@\",\"count\":%u,\"totalDuration\":%.0f,"
+                                     "\"minimumDuration\":%.0f,\"maximumDuration\":%.0f,\"p50\":%.0f,\"p95\":%.0f,\"p99\":%.0f,\"buckets\":[%@]}",
+                                     escapedString([NSString stringWithUTF8String:histogram->name]),
+                                     HLSLoggerCategoryName(histogram->category),
+                                     histogram->count,
+                                     histogram->totalDuration / 1e3,
+                                     histogram->minimumDuration / 1e3,
+                                     histogram->maximumDuration / 1e3,
+                                     histogramPercentile(histogram, 50.) * 1e6,
+                                     histogramPercentile(histogram, 95.) * 1e6,
+                                     histogramPercentile(histogram, 99.) * 1e6,
+                                     [bucketStrings componentsJoinedByString:@","]]];
+    }
+    free(histograms);
+    
+    return [NSString stringWithFormat:@"{\"traceEvents\":[\n%@\n],\n\"metadata\":{\"spanHistograms\":[\n%@\n]}}",
+            [events componentsJoinedByString:@",\n"],
+            [histogramStrings componentsJoinedByString:@",\n"]];
+}
+
+const char *HLSLoggerSpanMainThreadActiveSpanName(void)
+{
+    NSUInteger depth = s_mainThreadSpanDepth;
+    if (depth == 0) {
+        return NULL;
+    }
+    
+    // Spans nested deeper than the stack capacity are reported as the deepest span tracked
+    return s_mainThreadSpanNames[MIN(depth, kLoggerSpanMainThreadStackCapacity) - 1];
+}
+
+void HLSLoggerSpanClear(void)
+{
+    setup();
+    
+    OSSpinLockLock(&s_lock);
+    aggregateAllThreadBuffers();
+    free(s_histograms);
+    s_histograms = NULL;
+    s_numberOfHistograms = 0;
+    s_numberOfAggregatedRecords = 0;
+    OSSpinLockUnlock(&s_lock);
+}
+
+#pragma mark -
+#pragma mark Static functions
+
+static void setup(void)
+{
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        // Ensure the sampling interval is known
+        [HLSLogger sharedLogger];
+        
+        pthread_key_create(&s_threadBufferKey, destroyThreadBuffer);
+        mach_timebase_info(&s_timebaseInfo);
+        s_referenceTime = mach_absolute_time();
+    });
+}
+
+static HLSLoggerSpanThreadBuffer *currentThreadBuffer(void)
+{
+    setup();
+    
+    HLSLoggerSpanThreadBuffer *threadBuffer = pthread_getspecific(s_threadBufferKey);
+    if (! threadBuffer) {
+        threadBuffer = calloc(1, sizeof(HLSLoggerSpanThreadBuffer));
+        if (! threadBuffer) {
+            return NULL;
+        }
+        threadBuffer->lock = OS_SPINLOCK_INIT;
+        threadBuffer->threadID = pthread_mach_thread_np(pthread_self());
+        pthread_setspecific(s_threadBufferKey, threadBuffer);
+        
+        OSSpinLockLock(&s_lock);
+        threadBuffer->next = s_threadBuffers;
+        s_threadBuffers = threadBuffer;
+        OSSpinLockUnlock(&s_lock);
+    }
+    return threadBuffer;
+}
+
+// Called when a thread which has measured spans exits
+static void destroyThreadBuffer(void *threadBuffer)
+{
+    OSSpinLockLock(&s_lock);
+    aggregateThreadBuffer(threadBuffer);
+    
+    HLSLoggerSpanThreadBuffer **pThreadBuffer = &s_threadBuffers;
+    while (*pThreadBuffer) {
+        if (*pThreadBuffer == threadBuffer) {
+            *pThreadBuffer = (*pThreadBuffer)->next;
+            break;
+        }
+        pThreadBuffer = &(*pThreadBuffer)->next;
+    }
+    OSSpinLockUnlock(&s_lock);
+    
+    free(threadBuffer);
+}
+
+// Must be called with s_lock held
+static void aggregateThreadBuffer(HLSLoggerSpanThreadBuffer *threadBuffer)
+{
+    OSSpinLockLock(&threadBuffer->lock);
+    for (NSUInteger i = 0; i < threadBuffer->numberOfRecords; ++i) {
+        HLSLoggerSpanRecord *record = &threadBuffer->records[i];
+        HLSLoggerSpanHistogram *histogram = histogramForName(record->name, record->category);
+        if (! histogram) {
+            continue;
+        }
+        
+        uint64_t duration = durationInNanoseconds(record->endTime - record->startTime);
+        ++histogram->count;
+        histogram->totalDuration += duration;
+        histogram->minimumDuration = MIN(histogram->minimumDuration, duration);
+        histogram->maximumDuration = MAX(histogram->maximumDuration, duration);
+        ++histogram->buckets[bucketForDuration(duration / 1000)];
+        
+        s_recentRecords[s_numberOfAggregatedRecords % kLoggerSpanRecentRecordCapacity] = *record;
+        ++s_numberOfAggregatedRecords;
+    }
+    threadBuffer->numberOfRecords = 0;
+    OSSpinLockUnlock(&threadBuffer->lock);
+}
+
+// Must be called with s_lock held
+static void aggregateAllThreadBuffers(void)
+{
+    for (HLSLoggerSpanThreadBuffer *threadBuffer = s_threadBuffers; threadBuffer; threadBuffer = threadBuffer->next) {
+        aggregateThreadBuffer(threadBuffer);
+    }
+}
+
+// Must be called with s_lock held. Return NULL if no histogram could be created
+static HLSLoggerSpanHistogram *histogramForName(const char *name, HLSLoggerCategory category)
+{
+    for (NSUInteger i = 0; i < s_numberOfHistograms; ++i) {
+        if (strcmp(s_histograms[i].name, name) == 0) {
+            return &s_histograms[i];
+        }
+    }
+    
+    HLSLoggerSpanHistogram *histograms = realloc(s_histograms, (s_numberOfHistograms + 1) * sizeof(HLSLoggerSpanHistogram));
+    if (! histograms) {
+        return NULL;
+    }
+    s_histograms = histograms;
+    
+    HLSLoggerSpanHistogram *histogram = &s_histograms[s_numberOfHistograms];
+    memset(histogram, 0, sizeof(HLSLoggerSpanHistogram));
+    histogram->name = name;
+    histogram->category = category;
+    histogram->minimumDuration = UINT64_MAX;
+    ++s_numberOfHistograms;
+    return histogram;
+}
+
+// Aggregate all buffers and return a copy of the histograms, which must be freed by the caller
+static NSUInteger copyHistograms(HLSLoggerSpanHistogram **pHistograms)
+{
+    setup();
+    
+    OSSpinLockLock(&s_lock);
+    aggregateAllThreadBuffers();
+    NSUInteger numberOfHistograms = s_numberOfHistograms;
+    *pHistograms = malloc(MAX(numberOfHistograms, 1) * sizeof(HLSLoggerSpanHistogram));
+    memcpy(*pHistograms, s_histograms, numberOfHistograms * sizeof(HLSLoggerSpanHistogram));
+    OSSpinLockUnlock(&s_lock);
+    
+    return numberOfHistograms;
+}
+
+// Duration in microseconds
+static NSUInteger bucketForDuration(uint64_t duration)
+{
+    if (duration < 4) {
+        return (NSUInteger)duration;
+    }
+    
+    // The two bits following the most significant one select the bucket within a power of 2
+    NSUInteger exponent = 63 - __builtin_clzll(duration);
+    NSUInteger bucket = 4 * (exponent - 1) + (NSUInteger)((duration >> (exponent - 2)) & 3);
+    return MIN(bucket, kLoggerSpanHistogramBucketCount - 1);
+}
+
+// In microseconds. The upper bound of a bucket is the lower bound of the next one
+static uint64_t bucketLowerBound(NSUInteger bucket)
+{
+    if (bucket < 4) {
+        return bucket;
+    }
+    
+    NSUInteger exponent = bucket / 4 + 1;
+    return (uint64_t)(4 + bucket % 4) << (exponent - 2);
+}
+
+static uint64_t durationInNanoseconds(uint64_t machDuration)
+{
+    return machDuration * s_timebaseInfo.numer / s_timebaseInfo.denom;
+}
+
+// Nearest-rank percentile, in seconds
+static NSTimeInterval histogramPercentile(const HLSLoggerSpanHistogram *histogram, double percentile)
+{
+    if (histogram->count == 0) {
+        return kLoggerSpanNoValueAvailable;
+    }
+    
+    NSUInteger rank = MAX((NSUInteger)ceil(percentile / 100. * histogram->count), 1);
+    NSUInteger count = 0;
+    for (NSUInteger bucket = 0; bucket < kLoggerSpanHistogramBucketCount; ++bucket) {
+        count += histogram->buckets[bucket];
+        if (count >= rank) {
+            return MIN(bucketLowerBound(bucket + 1) / 1e6, histogram->maximumDuration / 1e9);
+        }
+    }
+    return histogram->maximumDuration / 1e9;
+}
+
+static NSString *escapedString(NSString *string)
+{
+    return [[string stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"]
+            stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
+}
@@ -0,0 +1,53 @@
+//
+//  HLSMainThreadWatchdog.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Watchdog detecting when the main thread stops processing its run loop for longer than a threshold (e.g. because of
+ * a synchronous hop from a background thread, a strings table being parsed or a large nib being loaded). A background
+ * thread regularly enqueues a ping on the main queue. When a ping has not been answered within the stall threshold,
+ * the main thread is briefly suspended to capture its backtrace, which is logged as a warning with HLSLogger together
+ * with the name of the innermost span being measured on the main thread, if any (see HLSLoggerSpanBegin). The total
+ * duration of the stall is logged when the main thread becomes responsive again. Stalls are not reported while the
+ * application is in the background
+ *
+ * Backtraces are captured by walking frame pointers, which the compiler always maintains for iOS. Symbol names are
+ * only available for exported symbols and must otherwise be symbolicated using the dSYM of the application. Note that
+ * pausing in the debugger is reported as a stall
+ *
+ * The watchdog must be enabled and disabled from the main thread
+ *
+ * Designated initializer: -init (but use the +sharedMainThreadWatchdog singleton)
+ */
+@interface HLSMainThreadWatchdog : NSObject {
+@private
+    NSThread *m_thread;
+    NSTimeInterval m_stallThreshold;
+    BOOL m_enabled;
+    BOOL m_active;                                  // NO while the application is in the background
+}
+
+/**
+ * The watchdog singleton
+ */
++ (HLSMainThreadWatchdog *)sharedMainThreadWatchdog;
+
+/**
+ * Set to YES to start watching the main thread
+ *
+ * Default value is NO
+ */
+@property (nonatomic, assign, getter=isEnabled) BOOL enabled;
+
+/**
+ * The time during which the main thread must be unresponsive for a stall to be reported. Must be > 0
+ *
+ * Default value is 0.25 seconds
+ */
+@property (nonatomic, assign) NSTimeInterval stallThreshold;
+
+@end
@@ -0,0 +1,297 @@
+//
+//  HLSMainThreadWatchdog.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSMainThreadWatchdog.h"
+
+#import <dlfcn.h>
+#import <mach/mach.h>
+#import <pthread.h>
+#import "HLSLogger.h"
+#import "HLSLoggerSpan.h"
+
+// Time between the answer to a ping and the next ping
+static const NSTimeInterval kMainThreadWatchdogPingInterval = 0.1;
+
+// Maximum number of frames captured
+#define kMainThreadWatchdogMaximumFrameCount                          64
+
+static thread_t s_mainThread = MACH_PORT_NULL;
+
+static NSUInteger HLSMainThreadWatchdogCaptureBacktrace(thread_t thread, uintptr_t *addresses, NSUInteger maximumAddressCount,
+                                                        const char **pActiveSpanName);
+static NSString *HLSMainThreadWatchdogBacktraceString(const uintptr_t *addresses, NSUInteger addressCount);
+
+@interface HLSMainThreadWatchdog ()
+
+@property (nonatomic, retain) NSThread *thread;
+
+- (void)watch;
+
+- (void)applicationDidEnterBackground:(NSNotification *)notification;
+- (void)applicationWillEnterForeground:(NSNotification *)notification;
+
+@end
+
+@implementation HLSMainThreadWatchdog
+
+#pragma mark Class methods
+
++ (HLSMainThreadWatchdog *)sharedMainThreadWatchdog
+{
+    static HLSMainThreadWatchdog *s_instance = nil;
+    
+    if (! s_instance) {
+        s_instance = [[HLSMainThreadWatchdog alloc] init];
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        m_stallThreshold = 0.25;
+        m_active = YES;
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationDidEnterBackground:)
+                                                     name:UIApplicationDidEnterBackgroundNotification
+                                                   object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationWillEnterForeground:)
+                                                     name:UIApplicationWillEnterForegroundNotification
+                                                   object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationDidEnterBackgroundNotification
+                                                  object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationWillEnterForegroundNotification
+                                                  object:nil];
+    
+    [self.thread cancel];
+    self.thread = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize thread = m_thread;
+
+@synthesize enabled = m_enabled;
+
+- (void)setEnabled:(BOOL)enabled
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (enabled == m_enabled) {
+        return;
+    }
+    
+    m_enabled = enabled;
+    
+    if (enabled) {
+        if (s_mainThread == MACH_PORT_NULL) {
+            s_mainThread = pthread_mach_thread_np(pthread_self());
+        }
+        
+        // The thread retains its target. This is not an issue since the watchdog is a singleton
+        self.thread = [[[NSThread alloc] initWithTarget:self selector:@selector(watch) object:nil] autorelease];
+        self.thread.name = @"HLSMainThreadWatchdog";
+        [self.thread start];
+    }
+    else {
+        // The thread exits after the current ping has been answered
+        [self.thread cancel];
+        self.thread = nil;
+    }
+}
+
+@synthesize stallThreshold = m_stallThreshold;
+
+- (void)setStallThreshold:(NSTimeInterval)stallThreshold
+{
+    if (stallThreshold <= 0.) {
+        HLSLoggerError(@"The stall threshold must be > 0");
+        return;
+    }
+    
+    m_stallThreshold = stallThreshold;
+}
+
+#pragma mark Watching the main thread
+
+// Run on the watchdog thread
+- (void)watch
+{
+    NSThread *currentThread = [NSThread currentThread];
+    while (! [currentThread isCancelled]) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        // The semaphore is released after it has been signalled, it does not need to be retained by the block
+        dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+        CFAbsoluteTime pingTime = CFAbsoluteTimeGetCurrent();
+        dispatch_async(dispatch_get_main_queue(), ^{
+            dispatch_semaphore_signal(semaphore);
+        });
+        
+        NSTimeInterval stallThreshold = m_stallThreshold;
+        if (dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(stallThreshold * NSEC_PER_SEC))) != 0) {
+            BOOL reported = m_active;
+            if (reported) {
+                uintptr_t addresses[kMainThreadWatchdogMaximumFrameCount];
+                const char *activeSpanName = NULL;
+                NSUInteger addressCount = HLSMainThreadWatchdogCaptureBacktrace(s_mainThread, addresses, kMainThreadWatchdogMaximumFrameCount,
+                                                                                &activeSpanName);
+                HLSLoggerWarn(@"The main thread has been stalled for more than %.0f ms (active span: %s). Backtrace:\n%@",
+                              stallThreshold * 1000.,
+                              activeSpanName ? activeSpanName : "none",
+                              HLSMainThreadWatchdogBacktraceString(addresses, addressCount));
+            }
+            
+            dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+            
+            if (reported) {
+                HLSLoggerWarn(@"The main thread stall lasted %.0f ms", (CFAbsoluteTimeGetCurrent() - pingTime) * 1000.);
+            }
+        }
+        dispatch_release(semaphore);
+        
+        [pool drain];
+        
+        [NSThread sleepForTimeInterval:kMainThreadWatchdogPingInterval];
+    }
+}
+
+#pragma mark Notification callbacks
+
+- (void)applicationDidEnterBackground:(NSNotification *)notification
+{
+    m_active = NO;
+}
+
+- (void)applicationWillEnterForeground:(NSNotification *)notification
+{
+    m_active = YES;
+}
+
+@end
+
+#pragma mark Functions
+
+/**
+ * Suspend a thread and walk its frame pointers. No lock must be acquired (in particular no memory must be allocated)
+ * while the thread is suspended, since it might be holding it. The name of the innermost span active on the main
+ * thread is read at the same time
+ */
+static NSUInteger HLSMainThreadWatchdogCaptureBacktrace(thread_t thread, uintptr_t *addresses, NSUInteger maximumAddressCount,
+                                                        const char **pActiveSpanName)
+{
+    if (thread == MACH_PORT_NULL || thread_suspend(thread) != KERN_SUCCESS) {
+        return 0;
+    }
+    
+    uintptr_t pc = 0;
+    uintptr_t fp = 0;
+#if defined(__arm64__)
+    arm_thread_state64_t state;
+    mach_msg_type_number_t stateCount = ARM_THREAD_STATE64_COUNT;
+    if (thread_get_state(thread, ARM_THREAD_STATE64, (thread_state_t)&state, &stateCount) == KERN_SUCCESS) {
+        pc = (uintptr_t)state.__pc;
+        fp = (uintptr_t)state.__fp;
+    }
+#elif defined(__arm__)
+    arm_thread_state_t state;
+    mach_msg_type_number_t stateCount = ARM_THREAD_STATE_COUNT;
+    if (thread_get_state(thread, ARM_THREAD_STATE, (thread_state_t)&state, &stateCount) == KERN_SUCCESS) {
+        pc = state.__pc;
+        fp = state.__r[7];
+    }
+#elif defined(__x86_64__)
+    x86_thread_state64_t state;
+    mach_msg_type_number_t stateCount = x86_THREAD_STATE64_COUNT;
+    if (thread_get_state(thread, x86_THREAD_STATE64, (thread_state_t)&state, &stateCount) == KERN_SUCCESS) {
+        pc = (uintptr_t)state.__rip;
+        fp = (uintptr_t)state.__rbp;
+    }
+#elif defined(__i386__)
+    x86_thread_state32_t state;
+    mach_msg_type_number_t stateCount = x86_THREAD_STATE32_COUNT;
+    if (thread_get_state(thread, x86_THREAD_STATE32, (thread_state_t)&state, &stateCount) == KERN_SUCCESS) {
+        pc = state.__eip;
+        fp = state.__ebp;
+    }
+#endif
+    
+    NSUInteger addressCount = 0;
+    if (pc != 0 && addressCount < maximumAddressCount) {
+        addresses[addressCount] = pc;
+        ++addressCount;
+    }
+    
+    // Each frame starts with the address of the previous frame, followed by the return address. Memory is read with
+    // vm_read_overwrite so that a corrupted frame pointer cannot crash the application
+    while (fp != 0 && addressCount < maximumAddressCount) {
+        uintptr_t frame[2] = { 0, 0 };
+        vm_size_t readSize = 0;
+        if (vm_read_overwrite(mach_task_self(), (vm_address_t)fp, sizeof(frame), (vm_address_t)frame, &readSize) != KERN_SUCCESS
+                || readSize != sizeof(frame)) {
+            break;
+        }
+        
+        if (frame[1] == 0) {
+            break;
+        }
+        addresses[addressCount] = frame[1];
+        ++addressCount;
+        
+        // The stack grows downwards. Stop if the chain of frames is broken
+        if (frame[0] <= fp) {
+            break;
+        }
+        fp = frame[0];
+    }
+    
+    if (pActiveSpanName) {
+        *pActiveSpanName = HLSLoggerSpanMainThreadActiveSpanName();
+    }
+    
+    thread_resume(thread);
+    return addressCount;
+}
+
+// Same format as backtrace_symbols()
+static NSString *HLSMainThreadWatchdogBacktraceString(const uintptr_t *addresses, NSUInteger addressCount)
+{
+    NSMutableArray *lines = [NSMutableArray arrayWithCapacity:addressCount];
+    for (NSUInteger i = 0; i < addressCount; ++i) {
+        Dl_info info;
+        if (dladdr((const void *)addresses[i], &info) != 0 && info.dli_fname) {
+            const char *imageName = strrchr(info.dli_fname, '/') ? strrchr(info.dli_fname, '/') + 1 : info.dli_fname;
+            if (info.dli_sname) {
+                [lines addObject:[NSString stringWithFormat:@"%-4d%-35s 0x%08lx %s + %lu", i, imageName, (unsigned long)addresses[i],
+                                  info.dli_sname, (unsigned long)(addresses[i] - (uintptr_t)info.dli_saddr)]];
+            }
+            else {
+                [lines addObject:[NSString stringWithFormat:@"%-4d%-35s 0x%08lx 0x%lx + %lu", i, imageName, (unsigned long)addresses[i],
+                                  (unsigned long)info.dli_fbase, (unsigned long)(addresses[i] - (uintptr_t)info.dli_fbase)]];
+            }
+        }
+        else {
+            [lines addObject:[NSString stringWithFormat:@"%-4d%-35s 0x%08lx", i, "???", (unsigned long)addresses[i]]];
+        }
+    }
+    return [lines componentsJoinedByString:@"\n"];
+}
@@ -0,0 +1,31 @@
+//
+//  HLSAsynchronousTaskOperation+Protected.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskOperation+Protected.h"
+
+/**
+ * Protected interface for use by subclasses of HLSAsynchronousTaskOperation in their implementation, and to be included
+ * from their implementation file
+ */
+@interface HLSAsynchronousTaskOperation (Protected)
+
+/**
+ * Operation start method. Start the asynchronous work and return immediately. When the work is over, call
+ * -finishOperation
+ * This method must be overridden
+ */
+- (void)operationStart;
+
+/**
+ * Signal that the work of the operation is over. Can be called from any thread, but only once. The task end is
+ * notified, and the operation is then marked as finished
+ * Not meant to be overridden
+ */
+- (void)finishOperation;
+
+@end
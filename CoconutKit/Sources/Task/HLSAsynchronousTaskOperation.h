@@ -0,0 +1,44 @@
+//
+//  HLSAsynchronousTaskOperation.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskOperation.h"
+
+/**
+ * Abstract class for implementing operations which process tasks asynchronously, i.e. which start their work (e.g. a
+ * network request or file I/O with a completion callback) and signal its end later, without holding a thread while
+ * waiting. Many I/O-bound tasks can therefore be in flight on a small number of threads. Concrete subclasses must 
+ * include the HLSAsynchronousTaskOperation+Protected.h header file within their implementation file to benefit from
+ * the full protected interface.
+ *
+ * Asynchronous operations are concurrent operations (their executing and finished states are managed by the class and 
+ * KVO-compliant). They still count against the maximum number of concurrent tasks of the task manager (and of their
+ * tag, if any) while running. Since they do not consume a thread, the maximum number of concurrent tasks of a manager
+ * processing mostly asynchronous tasks can be set much higher than for synchronous ones
+ *
+ * Progress updates, return information, errors, checkpoints and dependencies behave exactly as for synchronous
+ * operations. Concrete subclasses must take into account the following constraints within their implementation:
+ *  - the -operationStart method must be implemented instead of -operationMain. It is called on a secondary thread
+ *    which is not kept alive after the method returns. Work must therefore be scheduled on a run loop or a dispatch
+ *    queue which outlives it (e.g. the main run loop for NSURLConnection)
+ *  - -finishOperation must be called exactly once when all work is over, whether the operation succeeded, failed or 
+ *    has been cancelled. No callback of the work started must be pending anymore at this point
+ *  - when a running task is cancelled, its operation is sent a cancel message. Override -cancel (calling the super
+ *    method) or check -isCancelled regularly to stop the work as soon as possible, and call -finishOperation when done
+ *  - the protected methods used to report progress, errors and return information can be called from any thread, 
+ *    but not concurrently
+ *
+ * Designated initializer: -initWithTaskManager:task:
+ */
+@interface HLSAsynchronousTaskOperation : HLSTaskOperation {
+@private
+    BOOL _executing;
+    BOOL _finished;
+    BOOL _finishing;                    // YES as soon as -finishOperation has been called
+}
+
+@end
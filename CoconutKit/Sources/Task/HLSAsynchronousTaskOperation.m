@@ -0,0 +1,118 @@
+//
+//  HLSAsynchronousTaskOperation.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSAsynchronousTaskOperation.h"
+
+#import "HLSAsynchronousTaskOperation+Protected.h"
+#import "HLSAssert.h"
+#import "HLSLogger.h"
+#import "HLSTaskOperation+Friend.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
+
+@interface HLSAsynchronousTaskOperation ()
+
+- (void)operationStart;
+- (void)finishOperation;
+
+- (void)markAsFinished;
+
+@end
+
+@implementation HLSAsynchronousTaskOperation
+
+#pragma mark -
+#pragma mark Concurrent operation
+
+- (BOOL)isConcurrent
+{
+    return YES;
+}
+
+- (BOOL)isAsynchronous
+{
+    return YES;
+}
+
+- (BOOL)isExecuting
+{
+    @synchronized(self) {
+        return _executing;
+    }
+}
+
+- (BOOL)isFinished
+{
+    @synchronized(self) {
+        return _finished;
+    }
+}
+
+- (void)start
+{
+    // Operations cancelled before they started have already been unregistered from their task manager. They must 
+    // only be marked as finished so that the queue can get rid of them
+    if ([self isCancelled]) {
+        [self willChangeValueForKey:@"isFinished"];
+        @synchronized(self) {
+            _finishing = YES;
+            _finished = YES;
+        }
+        [self didChangeValueForKey:@"isFinished"];
+        return;
+    }
+    
+    [self willChangeValueForKey:@"isExecuting"];
+    @synchronized(self) {
+        _executing = YES;
+    }
+    [self didChangeValueForKey:@"isExecuting"];
+    
+    [self beginProcessing];
+    [self operationStart];
+}
+
+- (void)operationStart
+{
+    HLSMissingMethodImplementation();
+}
+
+- (void)finishOperation
+{
+    @synchronized(self) {
+        if (_finishing) {
+            HLSLoggerError(@"The operation has already been finished");
+            return;
+        }
+        _finishing = YES;
+    }
+    
+    [self endProcessing];
+    
+    // Queued after the end notification, so that the operation is not considered finished before its end has been
+    // notified (otherwise operations depending on it could start before dependents have been cancelled)
+    [self onCallingThreadPerformSelector:@selector(markAsFinished) object:nil];
+}
+
+- (void)markAsFinished
+{
+    // Keep the operation alive, the queue might release it as soon as it is finished
+    [[self retain] autorelease];
+    
+    [self willChangeValueForKey:@"isExecuting"];
+    [self willChangeValueForKey:@"isFinished"];
+    @synchronized(self) {
+        _executing = NO;
+        _finished = YES;
+    }
+    [self didChangeValueForKey:@"isFinished"];
+    [self didChangeValueForKey:@"isExecuting"];
+}
+
+@end
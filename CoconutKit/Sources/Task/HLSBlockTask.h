@@ -0,0 +1,74 @@
+//
+//  HLSBlockTask.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/14/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTask.h"
+
+// Forward declarations
+@protocol HLSBlockTaskContext;
+
+/**
+ * Block executed to process a block task. The context object can be used to report progress, attach return 
+ * information or errors, and to check whether the task has been cancelled. Like the -operationMain method of 
+ * HLSTaskOperation subclasses, the block is executed on a secondary thread and must only return when its work 
+ * is complete
+ */
+typedef void (^HLSBlockTaskBlock)(id<HLSBlockTaskContext> context);
+
+/**
+ * A concrete task whose processing is defined by a block. Block tasks provide the same progress, error and
+ * cancellation semantics as tasks implemented using an HLSTask / HLSTaskOperation subclass pair, and can be submitted 
+ * as single tasks or as part of task groups. They are especially convenient for small units of work, for which writing 
+ * two classes would be overkill.
+ *
+ * Do not subclass HLSBlockTask. If you need a custom task, subclass HLSTask instead.
+ *
+ * Designated initializer: -initWithBlock:
+ */
+@interface HLSBlockTask : HLSTask {
+@private
+    HLSBlockTaskBlock _block;
+}
+
+/**
+ * Convenience constructor
+ */
++ (HLSBlockTask *)blockTaskWithBlock:(HLSBlockTaskBlock)block;
+
+/**
+ * Create a task executing the block received as parameter (which is copied)
+ */
+- (id)initWithBlock:(HLSBlockTaskBlock)block;
+
+/**
+ * The block executed when the task is processed
+ */
+@property (nonatomic, readonly, copy) HLSBlockTaskBlock block;
+
+@end
+
+/**
+ * Interface available to block task blocks during processing. Methods have the same meaning as the corresponding
+ * ones available to HLSTaskOperation subclasses (see HLSTaskOperation+Protected.h)
+ */
+@protocol HLSBlockTaskContext <NSObject>
+
+/**
+ * The task being processed
+ */
+- (HLSBlockTask *)task;
+
+/**
+ * Check this value regularly and return as soon as possible when it is YES
+ */
+- (BOOL)isCancelled;
+
+- (void)updateProgressToValue:(float)progress;
+- (void)attachReturnInfo:(NSDictionary *)returnInfo;
+- (void)attachError:(NSError *)error;
+
+@end
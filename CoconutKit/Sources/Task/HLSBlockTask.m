@@ -0,0 +1,70 @@
+//
+//  HLSBlockTask.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/14/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSBlockTask.h"
+
+#import "HLSAssert.h"
+#import "HLSBlockTaskOperation.h"
+#import "HLSLogger.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
+
+@interface HLSBlockTask ()
+
+@property (nonatomic, copy) HLSBlockTaskBlock block;
+
+@end
+
+@implementation HLSBlockTask
+
+#pragma mark Class methods
+
++ (HLSBlockTask *)blockTaskWithBlock:(HLSBlockTaskBlock)block
+{
+    return [[[[self class] alloc] initWithBlock:block] autorelease];
+}
+
+#pragma mark Object creation and destruction
+
+- (id)initWithBlock:(HLSBlockTaskBlock)block
+{
+    if ((self = [super init])) {
+        if (! block) {
+            HLSLoggerError(@"A block is mandatory");
+            [self release];
+            return nil;
+        }
+        
+        self.block = block;
+    }
+    return self;
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    self.block = nil;
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+- (Class)operationClass
+{
+    return [HLSBlockTaskOperation class];
+}
+
+@synthesize block = _block;
+
+@end
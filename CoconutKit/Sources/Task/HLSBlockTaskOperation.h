@@ -0,0 +1,20 @@
+//
+//  HLSBlockTaskOperation.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/14/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSBlockTask.h"
+#import "HLSTaskOperation.h"
+
+/**
+ * Private operation class processing HLSBlockTask objects. The same class is used for all block tasks
+ */
+@interface HLSBlockTaskOperation : HLSTaskOperation <HLSBlockTaskContext> {
+@private
+    HLSBlockTaskBlock _block;
+}
+
+@end
@@ -0,0 +1,54 @@
+//
+//  HLSBlockTaskOperation.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/14/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSBlockTaskOperation.h"
+
+#import "HLSTaskOperation+Protected.h"
+
+@interface HLSBlockTaskOperation ()
+
+@property (nonatomic, copy) HLSBlockTaskBlock block;
+
+@end
+
+@implementation HLSBlockTaskOperation
+
+#pragma mark Object creation and destruction
+
+- (id)initWithTaskManager:(HLSTaskManager *)taskManager task:(HLSTask *)task
+{
+    if ((self = [super initWithTaskManager:taskManager task:task])) {
+        // Keep a reference to the block so that the task object does not need to be accessed from the operation thread
+        self.block = ((HLSBlockTask *)task).block;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    self.block = nil;
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize block = _block;
+
+- (HLSBlockTask *)task
+{
+    return (HLSBlockTask *)[super task];
+}
+
+#pragma mark Operation main method
+
+- (void)operationMain
+{
+    self.block(self);
+}
+
+@end
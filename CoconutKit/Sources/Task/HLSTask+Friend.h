@@ -32,6 +32,34 @@
 
 @property (nonatomic, assign) HLSTaskGroup *taskGroup;           // weak ref to parent task group
 
+@property (nonatomic, retain) NSData *resumeToken;
+
+/**
+ * Return the most recent generation given to a task status change (0 if none)
+ */
++ (unsigned long long)currentStateGeneration;
+
+/**
+ * Return all tasks recreated from the checkpoints currently saved
+ */
++ (NSArray *)checkpointedTasks;
+
+/**
+ * Remove all checkpoints currently saved
+ */
++ (void)removeAllCheckpoints;
+
+/**
+ * Save a checkpoint for the receiver (which must have a checkpoint key), replacing any existing one. Can be called
+ * from any thread. Returns YES iff successful
+ */
+- (BOOL)saveCheckpointWithResumeToken:(NSData *)resumeToken;
+
+/**
+ * Remove the checkpoint saved for the receiver, if any. Can be called from any thread
+ */
+- (void)removeCheckpoint;
+
 /**
  * Reset internal status variables
  */
@@ -0,0 +1,50 @@
+//
+//  HLSTask+HLSContinuations.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSBlockTask.h"
+#import "HLSTask.h"
+
+/**
+ * Block executed by a continuation. It receives the task it continues (which has been successfully processed, and
+ * whose return information can therefore be used) and the context of the continuation task itself, with which
+ * progress, return information or errors can be reported as for any block task
+ */
+typedef void (^HLSTaskContinuationBlock)(HLSTask *task, id<HLSBlockTaskContext> context);
+
+/**
+ * Continuations. Chaining tasks by implementing -taskHasBeenProcessed: and submitting the next task from there 
+ * requires a round trip through the thread which submitted the tasks for each link of the chain. Continuations 
+ * are instead processed by the task manager right after the task they continue has been successfully processed,
+ * without this thread being involved.
+ *
+ * A continuation is a block task, submitted automatically with the task it continues (it must not be submitted
+ * separately), with the same priority. Delegates can be registered for continuations as for any other task, and 
+ * continuations can themselves be continued, e.g. [[task then:block1] then:block2]. If a task fails or is cancelled,
+ * its continuations are cancelled as well. Continuations must be added before the task they continue is submitted.
+ * A task having continuations is never merged with another task bearing the same identity key
+ */
+@interface HLSTask (HLSContinuations)
+
+/**
+ * Return a new continuation executing a block on a secondary thread spawned by the task manager
+ */
+- (HLSBlockTask *)then:(HLSTaskContinuationBlock)block;
+
+/**
+ * Return a new continuation executing a block on a dispatch queue (e.g. the main queue when the result is needed
+ * by the user interface). The secondary thread processing the continuation waits until the block has been executed.
+ * The queue is retained
+ */
+- (HLSBlockTask *)onQueue:(dispatch_queue_t)queue then:(HLSTaskContinuationBlock)block;
+
+/**
+ * The continuations of the receiver, in the order they were added
+ */
+- (NSArray *)continuations;
+
+@end
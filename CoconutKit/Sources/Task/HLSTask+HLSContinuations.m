@@ -0,0 +1,118 @@
+//
+//  HLSTask+HLSContinuations.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTask+HLSContinuations.h"
+
+#import <objc/runtime.h>
+#import "HLSLogger.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
+
+// Associated object keys
+static void *s_continuationsKey = &s_continuationsKey;
+
+#pragma mark -
+#pragma mark HLSTaskContinuationQueue class
+
+/**
+ * Dispatch queues are not objects which blocks retain when they are copied. This wrapper makes it possible to keep 
+ * a queue alive as long as the block of a continuation task using it
+ */
+@interface HLSTaskContinuationQueue : NSObject {
+@private
+    dispatch_queue_t m_queue;
+}
+
+- (id)initWithQueue:(dispatch_queue_t)queue;
+
+@property (nonatomic, readonly, assign) dispatch_queue_t queue;
+
+@end
+
+@implementation HLSTaskContinuationQueue
+
+#pragma mark Object creation and destruction
+
+- (id)initWithQueue:(dispatch_queue_t)queue
+{
+    if ((self = [super init])) {
+        if (! queue) {
+            HLSLoggerError(@"Missing queue");
+            [self release];
+            return nil;
+        }
+        
+        dispatch_retain(queue);
+        m_queue = queue;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    dispatch_release(m_queue);
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize queue = m_queue;
+
+@end
+
+#pragma mark -
+#pragma mark HLSTask (HLSContinuations) category implementation
+
+@implementation HLSTask (HLSContinuations)
+
+- (HLSBlockTask *)then:(HLSTaskContinuationBlock)block
+{
+    return [self onQueue:NULL then:block];
+}
+
+- (HLSBlockTask *)onQueue:(dispatch_queue_t)queue then:(HLSTaskContinuationBlock)block
+{
+    if (! block) {
+        HLSLoggerError(@"Missing continuation block");
+        return nil;
+    }
+    
+    // The continuations are retained by the task they continue. Avoid a retain cycle
+    __block HLSTask *task = self;
+    HLSTaskContinuationQueue *continuationQueue = queue ? [[[HLSTaskContinuationQueue alloc] initWithQueue:queue] autorelease] : nil;
+    HLSBlockTask *continuation = [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+        if (continuationQueue) {
+            dispatch_sync(continuationQueue.queue, ^{
+                block(task, context);
+            });
+        }
+        else {
+            block(task, context);
+        }
+    }];
+    continuation.priority = self.priority;
+    
+    NSMutableArray *continuations = objc_getAssociatedObject(self, s_continuationsKey);
+    // Create the array lazily if it does not exist
+    if (! continuations) {
+        continuations = [NSMutableArray array];
+        objc_setAssociatedObject(self, s_continuationsKey, continuations, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+    [continuations addObject:continuation];
+    
+    return continuation;
+}
+
+- (NSArray *)continuations
+{
+    NSArray *continuations = objc_getAssociatedObject(self, s_continuationsKey);
+    return continuations ? [NSArray arrayWithArray:continuations] : [NSArray array];
+}
+
+@end
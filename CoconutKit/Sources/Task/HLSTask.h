@@ -12,6 +12,19 @@
 
 #define kTaskNoTimeIntervalEstimateAvailable        -1.
 
+/**
+ * Priority classes for tasks and task groups. Higher priority tasks are scheduled first, and their threads
+ * are given a higher priority as well
+ */
+typedef enum {
+    HLSTaskPriorityEnumBegin = 0,
+    HLSTaskPriorityLow = HLSTaskPriorityEnumBegin,          // Background work, e.g. prefetching
+    HLSTaskPriorityNormal,                                  // Default
+    HLSTaskPriorityHigh,                                    // User-visible work, e.g. fetching data for the screen being displayed
+    HLSTaskPriorityEnumEnd,
+    HLSTaskPriorityEnumSize = HLSTaskPriorityEnumEnd - HLSTaskPriorityEnumBegin
+} HLSTaskPriority;
+
 /**
  * Abstract class for tasks. Tasks offer a delegate mechanism for tracking their status. To create your own
  * tasks, simply subclass HLSTask and override the -operationClass method to return the class of the operation
@@ -26,7 +39,13 @@
 @interface HLSTask : NSObject {
 @private
     NSString *_tag;
+    NSString *_identityKey;
     NSDictionary *_userInfo;
+    NSString *_checkpointKey;
+    NSData *_resumeToken;
+    HLSTaskPriority _priority;
+    NSTimeInterval _timeoutInterval;
+    BOOL _durable;
     BOOL _running;
     BOOL _finished;
     BOOL _cancelled;
@@ -38,6 +57,7 @@
     NSDictionary *_returnInfo;
     NSError *_error;
     HLSTaskGroup *_taskGroup;               // parent task group if any, nil if none
+    unsigned long long _stateGeneration;
 }
 
 /**
@@ -52,12 +72,72 @@
  */
 @property (nonatomic, retain) NSString *tag;
 
+/**
+ * Optional key identifying the work performed by a task (e.g. a URL and its parameters). Two tasks with the same
+ * identity key are considered to perform the same work. When a task bearing an identity key is submitted as a single 
+ * task while another single task with the same key is still running or pending, HLSTaskManager does not process it 
+ * separately. Instead, it mirrors the status of the task already submitted, and its delegate receives the same events. 
+ * Identity keys are ignored for tasks submitted as part of a task group.
+ *
+ * Cancelling such a duplicate task does not affect the original one. Cancelling the original task, though, cancels
+ * all its duplicates as well
+ * Not meant to be overridden
+ */
+@property (nonatomic, retain) NSString *identityKey;
+
 /**
  * Dictionary which can be used freely to convey additional information
  * Not meant to be overridden
  */
 @property (nonatomic, retain) NSDictionary *userInfo;
 
+/**
+ * Optional key making a task resumable. It must uniquely identify the task among all tasks which can be resumed. When
+ * set, the operation processing the task can save checkpoints (see -[HLSTaskOperation checkpointWithResumeToken:]), 
+ * which are removed when the task ends successfully. Tasks which could not complete (because they were cancelled, 
+ * failed or because the application was terminated) can later be resubmitted from their last checkpoint using 
+ * -[HLSTaskManager submitCheckpointedTasksWithDelegate:]
+ *
+ * Along with the resume token, a checkpoint saves the task class, tag, priority and userInfo so that the task can be 
+ * recreated. The task class must therefore be instantiable using -init, and userInfo must only contain objects 
+ * conforming to NSCoding
+ * Not meant to be overridden
+ */
+@property (nonatomic, retain) NSString *checkpointKey;
+
+/**
+ * The token saved by the last checkpoint if the task was recreated from one, nil otherwise
+ * Not meant to be overridden
+ */
+@property (nonatomic, readonly, retain) NSData *resumeToken;
+
+/**
+ * The task priority (default is HLSTaskPriorityNormal). For tasks belonging to a task group, the priority of the task
+ * group is used instead. Changing this value does not affect a task which has already been submitted
+ * Not meant to be overridden
+ */
+@property (nonatomic, assign) HLSTaskPriority priority;
+
+/**
+ * Time budget of the task, measured from the moment it is submitted. If the task is not finished when the timeout
+ * expires, it is cancelled by the task manager (the task delegate receives the taskHasBeenCancelled: event as usual,
+ * and tasks strongly depending on it in its task group are cancelled as well). A running operation only stops when
+ * it checks its cancelled status. Deadlines are checked by a timer running on the run loop of the thread the task 
+ * manager is used from, and are not precise: Expect cancellation up to a tenth of a second late. Default is 0, i.e. no timeout. Changing this value does not affect a task which has
+ * already been submitted
+ * Not meant to be overridden
+ */
+@property (nonatomic, assign) NSTimeInterval timeoutInterval;
+
+/**
+ * If set to YES, a single task submitted to a task manager having a journal is recorded in it until it ends, so that
+ * it can be resubmitted if the application is terminated in the meantime (see -[HLSTaskManager journal]). For tasks
+ * belonging to a task group, the durable property of the task group is used instead. The task class must be 
+ * instantiable using -init, and userInfo must only contain objects conforming to NSCoding. Default is NO
+ * Not meant to be overridden
+ */
+@property (nonatomic, assign, getter=isDurable) BOOL durable;
+
 /**
  * Return YES if the task processing is running
  * Not meant to be overridden
@@ -110,6 +190,14 @@
  */
 @property (nonatomic, readonly, retain) NSError *error;
 
+/**
+ * A counter which changes each time the status of the task (running, finished, cancelled, progress, return information
+ * or error) changes. Generations are taken from a single increasing sequence shared by all tasks, so that a task whose 
+ * generation is greater than a previously obtained value (see -[HLSTaskManager taskStateGeneration]) has changed since
+ * Not meant to be overridden
+ */
+@property (nonatomic, readonly, assign) unsigned long long stateGeneration;
+
 @end
 
 @protocol HLSTaskDelegate <NSObject>
@@ -8,13 +8,34 @@
 
 #import "HLSTask.h"
 
+#import <libkern/OSAtomic.h>
+#import "HLSFileManager.h"
 #import "HLSFloat.h"
 #import "HLSLogger.h"
 #import "HLSTaskGroup.h"
+#import "HLSTaskGroup+Friend.h"
 #import "NSBundle+HLSExtensions.h"
+#import "NSString+HLSExtensions.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
 
 const NSUInteger kProgressStepsCounterThreshold = 50;
 
+static NSString * const kTaskCheckpointsDirectoryName = @"HLSTaskCheckpoints";
+static NSString * const kTaskCheckpointFileExtension = @"checkpoint";
+
+// Checkpoint dictionary keys
+static NSString * const kTaskCheckpointClassNameKey = @"className";
+static NSString * const kTaskCheckpointKeyKey = @"checkpointKey";
+static NSString * const kTaskCheckpointTagKey = @"tag";
+static NSString * const kTaskCheckpointPriorityKey = @"priority";
+static NSString * const kTaskCheckpointUserInfoKey = @"userInfo";
+static NSString * const kTaskCheckpointResumeTokenKey = @"resumeToken";
+
+// Sequence of task status generations, shared by all tasks (tasks can be updated from several task manager threads)
+static volatile int64_t s_stateGeneration = 0;
+
 @interface HLSTask ()
 
 @property (nonatomic, assign, getter=isRunning) BOOL running;
@@ -26,11 +47,23 @@ const NSUInteger kProgressStepsCounterThreshold = 50;
 @property (nonatomic, retain) NSDictionary *returnInfo;
 @property (nonatomic, retain) NSError *error;
 @property (nonatomic, assign) HLSTaskGroup *taskGroup;           // weak ref to parent task group
+@property (nonatomic, retain) NSData *resumeToken;
 
++ (NSString *)checkpointFilePathForKey:(NSString *)checkpointKey;
+
+- (void)stateDidChange;
 - (void)reset;
 
 @end
 
+// Checkpoints are saved in the application library directory (whose contents are preserved between launches), using the
+// default file manager
+static NSString *HLSTaskCheckpointsDirectoryPath(void)
+{
+    NSString *libraryDirectoryPath = [NSSearchPathForDirectoriesInDomains(NSLibraryDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+    return [libraryDirectoryPath stringByAppendingPathComponent:kTaskCheckpointsDirectoryName];
+}
+
 @implementation HLSTask
 
 #pragma mark -
@@ -39,6 +72,7 @@ const NSUInteger kProgressStepsCounterThreshold = 50;
 - (id)init
 {
     if ((self = [super init])) {
+        self.priority = HLSTaskPriorityNormal;
         [self reset];
     }
     return self;
@@ -46,12 +80,16 @@ const NSUInteger kProgressStepsCounterThreshold = 50;
 
 - (void)dealloc
 {
+    // Detach from the parent task group first so that it does not get notified about the changes below
+    self.taskGroup = nil;
     self.tag = nil;
+    self.identityKey = nil;
     self.userInfo = nil;
+    self.checkpointKey = nil;
+    self.resumeToken = nil;
     self.lastEstimateDate = nil;
     self.returnInfo = nil;
     self.error = nil;
-    self.taskGroup = nil;
     [super dealloc];
 }
 
@@ -66,14 +104,57 @@ const NSUInteger kProgressStepsCounterThreshold = 50;
 
 @synthesize tag = _tag;
 
+@synthesize identityKey = _identityKey;
+
 @synthesize userInfo = _userInfo;
 
+@synthesize checkpointKey = _checkpointKey;
+
+@synthesize resumeToken = _resumeToken;
+
+@synthesize priority = _priority;
+
+@synthesize timeoutInterval = _timeoutInterval;
+
+@synthesize durable = _durable;
+
 @synthesize running = _running;
 
+- (void)setRunning:(BOOL)running
+{
+    if (running == _running) {
+        return;
+    }
+    
+    _running = running;
+    [self stateDidChange];
+}
+
 @synthesize finished = _finished;
 
+- (void)setFinished:(BOOL)finished
+{
+    if (finished == _finished) {
+        return;
+    }
+    
+    _finished = finished;
+    [self stateDidChange];
+    [self.taskGroup taskFinishedDidChange:self];
+}
+
 @synthesize cancelled = _cancelled;
 
+- (void)setCancelled:(BOOL)cancelled
+{
+    if (cancelled == _cancelled) {
+        return;
+    }
+    
+    _cancelled = cancelled;
+    [self stateDidChange];
+}
+
 @synthesize progress = _progress;
 
 - (void)setProgress:(float)progress
@@ -83,6 +164,8 @@ const NSUInteger kProgressStepsCounterThreshold = 50;
         return;
     }
     
+    float previousProgress = _progress;
+    
     // Sanitize input
     if (floatlt(progress, 0.f) || floatgt(progress, 1.f)) {
         if (floatlt(progress, 0.f)) {
@@ -97,6 +180,9 @@ const NSUInteger kProgressStepsCounterThreshold = 50;
         _progress = progress;
     }
     
+    [self stateDidChange];
+    [self.taskGroup taskProgressDidChange:self previousProgress:previousProgress];
+    
     // Estimation is not made with each progress value change. If progress values are incremented fast, it is calculated
     // after several changes. If progress value change is slow, we use a time difference criterium. This should provide
     // accurate enough results
@@ -141,10 +227,45 @@ const NSUInteger kProgressStepsCounterThreshold = 50;
 
 @synthesize returnInfo = _returnInfo;
 
+- (void)setReturnInfo:(NSDictionary *)returnInfo
+{
+    if (returnInfo == _returnInfo) {
+        return;
+    }
+    
+    [_returnInfo release];
+    _returnInfo = [returnInfo retain];
+    [self stateDidChange];
+}
+
 @synthesize error = _error;
 
+- (void)setError:(NSError *)error
+{
+    if (error == _error) {
+        return;
+    }
+    
+    NSError *previousError = [_error autorelease];
+    _error = [error retain];
+    [self stateDidChange];
+    [self.taskGroup taskErrorDidChange:self previousError:previousError];
+}
+
 @synthesize taskGroup = _taskGroup;
 
+@synthesize stateGeneration = _stateGeneration;
+
++ (unsigned long long)currentStateGeneration
+{
+    return (unsigned long long)OSAtomicAdd64Barrier(0, &s_stateGeneration);
+}
+
+- (void)stateDidChange
+{
+    _stateGeneration = (unsigned long long)OSAtomicIncrement64Barrier(&s_stateGeneration);
+}
+
 - (NSString *)remainingTimeIntervalEstimateLocalizedString
 {
     if (self.remainingTimeIntervalEstimate == kTaskGroupNoTimeIntervalEstimateAvailable) {
@@ -172,6 +293,150 @@ const NSUInteger kProgressStepsCounterThreshold = 50;
     }
 }
 
+#pragma mark -
+#pragma mark Checkpoints
+
++ (NSString *)checkpointFilePathForKey:(NSString *)checkpointKey
+{
+    // Keys can contain any character; hash them to get valid file names
+    NSString *fileName = [[checkpointKey md5hash] stringByAppendingPathExtension:kTaskCheckpointFileExtension];
+    return [HLSTaskCheckpointsDirectoryPath() stringByAppendingPathComponent:fileName];
+}
+
++ (NSArray *)checkpointedTasks
+{
+    HLSFileManager *fileManager = [HLSFileManager defaultManager];
+    if (! [fileManager fileExistsAtPath:HLSTaskCheckpointsDirectoryPath()]) {
+        return [NSArray array];
+    }
+    
+    NSError *error = nil;
+    NSArray *fileNames = [fileManager contentsOfDirectoryAtPath:HLSTaskCheckpointsDirectoryPath() error:&error];
+    if (! fileNames) {
+        HLSLoggerError(@"Could not list checkpoints. Reason: %@", error);
+        return [NSArray array];
+    }
+    
+    NSMutableArray *tasks = [NSMutableArray array];
+    for (NSString *fileName in fileNames) {
+        if (! [[fileName pathExtension] isEqualToString:kTaskCheckpointFileExtension]) {
+            continue;
+        }
+        
+        NSString *filePath = [HLSTaskCheckpointsDirectoryPath() stringByAppendingPathComponent:fileName];
+        NSData *data = [fileManager contentsOfFileAtPath:filePath error:&error];
+        if (! data) {
+            HLSLoggerError(@"Could not read the checkpoint %@. Reason: %@", filePath, error);
+            continue;
+        }
+        
+        NSDictionary *checkpoint = nil;
+        @try {
+            checkpoint = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+        }
+        @catch (NSException *exception) {
+            HLSLoggerError(@"The checkpoint %@ is corrupted and has been discarded. Reason: %@", filePath, [exception reason]);
+            [fileManager removeItemAtPath:filePath error:NULL];
+            continue;
+        }
+        
+        Class taskClass = NSClassFromString([checkpoint objectForKey:kTaskCheckpointClassNameKey]);
+        if (! [taskClass isSubclassOfClass:[HLSTask class]]) {
+            HLSLoggerError(@"The checkpoint %@ does not describe a valid task and has been discarded", filePath);
+            [fileManager removeItemAtPath:filePath error:NULL];
+            continue;
+        }
+        
+        HLSTask *task = [[[taskClass alloc] init] autorelease];
+        task.checkpointKey = [checkpoint objectForKey:kTaskCheckpointKeyKey];
+        task.tag = [checkpoint objectForKey:kTaskCheckpointTagKey];
+        task.priority = [[checkpoint objectForKey:kTaskCheckpointPriorityKey] intValue];
+        task.userInfo = [checkpoint objectForKey:kTaskCheckpointUserInfoKey];
+        task.resumeToken = [checkpoint objectForKey:kTaskCheckpointResumeTokenKey];
+        [tasks addObject:task];
+    }
+    return [NSArray arrayWithArray:tasks];
+}
+
++ (void)removeAllCheckpoints
+{
+    HLSFileManager *fileManager = [HLSFileManager defaultManager];
+    if (! [fileManager fileExistsAtPath:HLSTaskCheckpointsDirectoryPath()]) {
+        return;
+    }
+    
+    NSError *error = nil;
+    if (! [fileManager removeItemAtPath:HLSTaskCheckpointsDirectoryPath() error:&error]) {
+        HLSLoggerError(@"Could not remove checkpoints. Reason: %@", error);
+    }
+}
+
+- (BOOL)saveCheckpointWithResumeToken:(NSData *)resumeToken
+{
+    if (! self.checkpointKey) {
+        HLSLoggerError(@"A checkpoint can only be saved for a task with a checkpoint key");
+        return NO;
+    }
+    
+    NSMutableDictionary *checkpoint = [NSMutableDictionary dictionary];
+    [checkpoint setObject:NSStringFromClass([self class]) forKey:kTaskCheckpointClassNameKey];
+    [checkpoint setObject:self.checkpointKey forKey:kTaskCheckpointKeyKey];
+    [checkpoint setObject:[NSNumber numberWithInt:self.priority] forKey:kTaskCheckpointPriorityKey];
+    if (self.tag) {
+        [checkpoint setObject:self.tag forKey:kTaskCheckpointTagKey];
+    }
+    if (self.userInfo) {
+        [checkpoint setObject:self.userInfo forKey:kTaskCheckpointUserInfoKey];
+    }
+    if (resumeToken) {
+        [checkpoint setObject:resumeToken forKey:kTaskCheckpointResumeTokenKey];
+    }
+    
+    NSData *data = nil;
+    @try {
+        data = [NSKeyedArchiver archivedDataWithRootObject:checkpoint];
+    }
+    @catch (NSException *exception) {
+        HLSLoggerError(@"Could not archive the checkpoint for task %@ (userInfo must only contain objects conforming to "
+                       "NSCoding). Reason: %@", self, [exception reason]);
+        return NO;
+    }
+    
+    HLSFileManager *fileManager = [HLSFileManager defaultManager];
+    NSError *error = nil;
+    if (! [fileManager fileExistsAtPath:HLSTaskCheckpointsDirectoryPath()]
+            && ! [fileManager createDirectoryAtPath:HLSTaskCheckpointsDirectoryPath() withIntermediateDirectories:YES error:&error]) {
+        HLSLoggerError(@"Could not create the checkpoint directory. Reason: %@", error);
+        return NO;
+    }
+    
+    NSString *filePath = [HLSTask checkpointFilePathForKey:self.checkpointKey];
+    if (! [fileManager createFileAtPath:filePath contents:data error:&error]) {
+        HLSLoggerError(@"Could not save the checkpoint for task %@. Reason: %@", self, error);
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (void)removeCheckpoint
+{
+    if (! self.checkpointKey) {
+        return;
+    }
+    
+    HLSFileManager *fileManager = [HLSFileManager defaultManager];
+    NSString *filePath = [HLSTask checkpointFilePathForKey:self.checkpointKey];
+    if (! [fileManager fileExistsAtPath:filePath]) {
+        return;
+    }
+    
+    NSError *error = nil;
+    if (! [fileManager removeItemAtPath:filePath error:&error]) {
+        HLSLoggerError(@"Could not remove the checkpoint for task %@. Reason: %@", self, error);
+    }
+}
+
 #pragma mark -
 #pragma mark Resetting
 
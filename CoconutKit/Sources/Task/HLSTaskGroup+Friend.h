@@ -13,10 +13,19 @@
 @interface HLSTaskGroup (Friend)
 
 /**
- * Ask the task group to refresh its status based on the current status of its tasks
+ * Ask the task group to refresh its status based on the current status of its tasks. Aggregate values are maintained
+ * incrementally as tasks change (see methods below), this method therefore executes in constant time
  */
 - (void)updateStatus;
 
+/**
+ * Must be called by tasks belonging to the task group when their status changes, so that aggregate values can be 
+ * kept up to date
+ */
+- (void)taskProgressDidChange:(HLSTask *)task previousProgress:(float)previousProgress;
+- (void)taskFinishedDidChange:(HLSTask *)task;
+- (void)taskErrorDidChange:(HLSTask *)task previousError:(NSError *)previousError;
+
 @property (nonatomic, assign, getter=isRunning) BOOL running;
 
 @property (nonatomic, assign, getter=isFinished) BOOL finished;
@@ -37,6 +46,18 @@
 - (NSSet *)weakDependentsForTask:(HLSTask *)task;
 - (NSSet *)strongDependentsForTask:(HLSTask *)task;
 
+/**
+ * Return the tasks sorted so that each task comes after all tasks it depends on, or nil if dependencies form a cycle.
+ * Executes in time proportional to the number of tasks and dependencies
+ */
+- (NSArray *)topologicallySortedTasks;
+
+/**
+ * Return all tasks directly or transitively depending strongly on a task, i.e. all tasks which must be cancelled if
+ * the task fails or is cancelled. Each task is visited once
+ */
+- (NSArray *)strongDependentsClosureForTask:(HLSTask *)task;
+
 /**
  * Reset internal status variables
  */
@@ -0,0 +1,48 @@
+//
+//  HLSTaskGroup+HLSDigest.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 25.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSDigest.h"
+#import "HLSFileManager.h"
+#import "HLSTaskGroup.h"
+
+/**
+ * Keys to retrieve the path of the file hashed by a task (in its userInfo dictionary) and the resulting hash (hexadecimal,
+ * lowercase, in its returnInfo dictionary)
+ */
+extern NSString * const HLSDigestFilePathKey;
+extern NSString * const HLSDigestHexDigestKey;
+
+/**
+ * Hashing of many files in parallel, e.g. to check the integrity of downloaded resources. The task groups returned by the
+ * method below contain one task per file. Up to -[HLSTaskManager maxConcurrentTaskCount] files are hashed at the same
+ * time, each file being read through the file manager and hashed by pieces, so that memory consumption does not depend
+ * on file sizes.
+ *
+ * The task groups returned can be submitted to an HLSTaskManager like any other task group. The overall progress is 
+ * reported using the usual HLSTaskGroupDelegate callbacks. Once the task group has been processed, each task contains 
+ * the path of the file it hashed in its userInfo, and either the hash in its returnInfo, or an error if the file
+ * could not be read. Do not add tasks or dependencies to these task groups.
+ */
+@interface HLSTaskGroup (HLSDigest)
+
+/**
+ * Return a task group hashing the files at the given paths with some algorithm, reading them using the specified file 
+ * manager (the default one if nil)
+ */
++ (HLSTaskGroup *)taskGroupHashingFilesAtPaths:(NSArray *)paths
+                                     algorithm:(HLSDigestAlgorithm)algorithm
+                                   fileManager:(HLSFileManager *)fileManager;
+
+/**
+ * For a task group created using +taskGroupHashingFilesAtPaths:algorithm:fileManager: and which has been processed,
+ * return a dictionary mapping the path of each file which could be hashed to its hash. Return nil if the task group
+ * has not been processed or has been cancelled
+ */
+- (NSDictionary *)hexDigestsByFilePath;
+
+@end
@@ -0,0 +1,87 @@
+//
+//  HLSTaskGroup+HLSDigest.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 25.10.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskGroup+HLSDigest.h"
+
+#import "HLSBlockTask.h"
+#import "HLSLogger.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
+
+NSString * const HLSDigestFilePathKey = @"HLSDigestFilePath";
+NSString * const HLSDigestHexDigestKey = @"HLSDigestHexDigest";
+
+// Length of the pieces between which progress is reported and cancellation is checked
+static const NSUInteger kFileDigestChunkLength = 1024 * 1024;
+
+@implementation HLSTaskGroup (HLSDigest)
+
++ (HLSTaskGroup *)taskGroupHashingFilesAtPaths:(NSArray *)paths
+                                     algorithm:(HLSDigestAlgorithm)algorithm
+                                   fileManager:(HLSFileManager *)fileManager
+{
+    if (algorithm < HLSDigestAlgorithmEnumBegin || algorithm >= HLSDigestAlgorithmEnumEnd) {
+        HLSLoggerError(@"Unknown digest algorithm");
+        return nil;
+    }
+    
+    if (! fileManager) {
+        fileManager = [HLSFileManager defaultManager];
+    }
+    
+    HLSTaskGroup *taskGroup = [[[HLSTaskGroup alloc] init] autorelease];
+    for (NSString *path in paths) {
+        HLSBlockTask *task = [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+            // Files are mapped into virtual memory by well-behaved file managers, and hashed by pieces
+            NSError *error = nil;
+            NSData *data = [fileManager contentsOfFileAtPath:path error:&error];
+            if (! data) {
+                [context attachError:error];
+                return;
+            }
+            
+            HLSDigest *digest = [HLSDigest digestWithAlgorithm:algorithm];
+            const unsigned char *bytes = [data bytes];
+            NSUInteger length = [data length];
+            for (NSUInteger location = 0; location < length; location += kFileDigestChunkLength) {
+                if ([context isCancelled]) {
+                    return;
+                }
+                
+                [digest updateWithBytes:bytes + location length:MIN(kFileDigestChunkLength, length - location)];
+                [context updateProgressToValue:MIN((float)(location + kFileDigestChunkLength) / length, 1.f)];
+            }
+            
+            [context attachReturnInfo:[NSDictionary dictionaryWithObject:[digest finalHexDigest] forKey:HLSDigestHexDigestKey]];
+        }];
+        task.userInfo = [NSDictionary dictionaryWithObject:path forKey:HLSDigestFilePathKey];
+        [taskGroup addTask:task];
+    }
+    return taskGroup;
+}
+
+- (NSDictionary *)hexDigestsByFilePath
+{
+    if (! self.finished || self.cancelled) {
+        return nil;
+    }
+    
+    NSMutableDictionary *hexDigestsByFilePath = [NSMutableDictionary dictionary];
+    for (HLSTask *task in [self tasks]) {
+        NSString *hexDigest = [task.returnInfo objectForKey:HLSDigestHexDigestKey];
+        if (! hexDigest) {
+            continue;
+        }
+        
+        [hexDigestsByFilePath setObject:hexDigest forKey:[task.userInfo objectForKey:HLSDigestFilePathKey]];
+    }
+    return [NSDictionary dictionaryWithDictionary:hexDigestsByFilePath];
+}
+
+@end
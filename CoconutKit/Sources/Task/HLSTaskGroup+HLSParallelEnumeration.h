@@ -0,0 +1,48 @@
+//
+//  HLSTaskGroup+HLSParallelEnumeration.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskGroup.h"
+
+/**
+ * Blocks executed for each object of a collection processed in parallel. Blocks are called from secondary threads,
+ * concurrently, and in no specific order. When enumerating, set *stop to YES to stop processing remaining objects
+ * (objects being processed by other threads at the same time will still be processed). When mapping, return the 
+ * object to store at the same index in the result array (nil is stored as NSNull)
+ */
+typedef void (^HLSParallelEnumerationBlock)(id object, NSUInteger index, BOOL *stop);
+typedef id (^HLSParallelMappingBlock)(id object, NSUInteger index);
+
+/**
+ * Parallel processing of collections. The task groups returned by the methods below contain one task per processor
+ * core available. Objects are split into chunks distributed evenly between these tasks. When a task has processed all 
+ * its chunks, it steals chunks not processed yet by other tasks, so that all cores are kept busy until all objects 
+ * have been processed, even if processing times vary between objects.
+ *
+ * The task groups returned can be submitted to an HLSTaskManager like any other task group. Progress is reported
+ * using the usual HLSTaskGroupDelegate callbacks. Do not add tasks or dependencies to these task groups.
+ */
+@interface HLSTaskGroup (HLSParallelEnumeration)
+
+/**
+ * Return a task group executing a block for each object of an array
+ */
++ (HLSTaskGroup *)taskGroupEnumeratingObjects:(NSArray *)objects usingBlock:(HLSParallelEnumerationBlock)block;
+
+/**
+ * Return a task group creating a new array by executing a block for each object of an array. Once the task group has 
+ * been successfully processed, the resulting array can be retrieved using -mappedObjects
+ */
++ (HLSTaskGroup *)taskGroupMappingObjects:(NSArray *)objects usingBlock:(HLSParallelMappingBlock)block;
+
+/**
+ * For a task group created using +taskGroupMappingObjects:usingBlock: and which has been successfully processed, return
+ * the result array. Return nil otherwise
+ */
+- (NSArray *)mappedObjects;
+
+@end
@@ -0,0 +1,269 @@
+//
+//  HLSTaskGroup+HLSParallelEnumeration.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskGroup+HLSParallelEnumeration.h"
+
+#import <libkern/OSAtomic.h>
+#import "HLSBlockTask.h"
+#import "HLSLogger.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
+
+// Number of chunks per task. Smaller chunks balance load better, but increase synchronization costs
+static const NSUInteger kParallelEnumerationChunksPerTask = 8;
+
+static NSString * const kParallelEnumerationStateKey = @"HLSParallelEnumerationState";
+
+#pragma mark -
+#pragma mark HLSParallelEnumerationState class
+
+/**
+ * State shared by all tasks of a parallel enumeration task group. Each task owns a deque of chunks, i.e. a range
+ * of chunk indices [head, tail[. A task processes its own chunks from the head, and steals chunks from the tail
+ * of other deques when its own deque is empty
+ */
+@interface HLSParallelEnumerationState : NSObject {
+@private
+    NSArray *m_objects;
+    HLSParallelEnumerationBlock m_enumerationBlock;
+    HLSParallelMappingBlock m_mappingBlock;
+    NSUInteger m_nbrTasks;
+    NSUInteger m_nbrChunks;
+    NSUInteger m_chunkSize;
+    NSUInteger *m_heads;
+    NSUInteger *m_tails;
+    OSSpinLock *m_locks;                        // one lock per deque
+    id *m_mappedObjects;                        // each slot is written by a single task
+    volatile int32_t m_nbrProcessedObjects;
+    volatile BOOL m_stopped;
+}
+
+- (id)initWithObjects:(NSArray *)objects 
+     enumerationBlock:(HLSParallelEnumerationBlock)enumerationBlock
+         mappingBlock:(HLSParallelMappingBlock)mappingBlock
+             nbrTasks:(NSUInteger)nbrTasks;
+
+- (void)processForTaskAtIndex:(NSUInteger)taskIndex context:(id<HLSBlockTaskContext>)context;
+
+- (NSArray *)mappedObjects;
+
+@end
+
+@interface HLSParallelEnumerationState ()
+
+- (BOOL)popChunkIndex:(NSUInteger *)pChunkIndex fromDequeAtIndex:(NSUInteger)dequeIndex steal:(BOOL)steal;
+
+@end
+
+@implementation HLSParallelEnumerationState
+
+#pragma mark Object creation and destruction
+
+- (id)initWithObjects:(NSArray *)objects 
+     enumerationBlock:(HLSParallelEnumerationBlock)enumerationBlock
+         mappingBlock:(HLSParallelMappingBlock)mappingBlock
+             nbrTasks:(NSUInteger)nbrTasks
+{
+    if ((self = [super init])) {
+        m_objects = [objects retain];
+        m_enumerationBlock = [enumerationBlock copy];
+        m_mappingBlock = [mappingBlock copy];
+        m_nbrTasks = nbrTasks;
+        
+        NSUInteger nbrObjects = [objects count];
+        m_nbrChunks = MIN(nbrObjects, nbrTasks * kParallelEnumerationChunksPerTask);
+        m_chunkSize = (nbrObjects + m_nbrChunks - 1) / m_nbrChunks;
+        
+        // Distribute chunks evenly between tasks (contiguous chunks for each task)
+        m_heads = calloc(nbrTasks, sizeof(NSUInteger));
+        m_tails = calloc(nbrTasks, sizeof(NSUInteger));
+        m_locks = calloc(nbrTasks, sizeof(OSSpinLock));
+        for (NSUInteger i = 0; i < nbrTasks; ++i) {
+            m_heads[i] = (i * m_nbrChunks) / nbrTasks;
+            m_tails[i] = ((i + 1) * m_nbrChunks) / nbrTasks;
+            m_locks[i] = OS_SPINLOCK_INIT;
+        }
+        
+        if (m_mappingBlock) {
+            m_mappedObjects = calloc(nbrObjects, sizeof(id));
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (m_mappedObjects) {
+        for (NSUInteger i = 0; i < [m_objects count]; ++i) {
+            [m_mappedObjects[i] release];
+        }
+        free(m_mappedObjects);
+    }
+    free(m_heads);
+    free(m_tails);
+    free(m_locks);
+    [m_objects release];
+    [m_enumerationBlock release];
+    [m_mappingBlock release];
+    [super dealloc];
+}
+
+#pragma mark Processing
+
+- (void)processForTaskAtIndex:(NSUInteger)taskIndex context:(id<HLSBlockTaskContext>)context
+{
+    NSUInteger nbrObjects = [m_objects count];
+    
+    NSUInteger chunkIndex = 0;
+    while (! m_stopped && ! [context isCancelled]) {
+        // Own chunks first, then steal from other tasks (starting with the next one, so that tasks do not all
+        // steal from the same deque)
+        BOOL found = [self popChunkIndex:&chunkIndex fromDequeAtIndex:taskIndex steal:NO];
+        for (NSUInteger i = 1; ! found && i < m_nbrTasks; ++i) {
+            found = [self popChunkIndex:&chunkIndex fromDequeAtIndex:(taskIndex + i) % m_nbrTasks steal:YES];
+        }
+        
+        // No more work
+        if (! found) {
+            break;
+        }
+        
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        NSUInteger firstIndex = chunkIndex * m_chunkSize;
+        NSUInteger lastIndex = MIN(firstIndex + m_chunkSize, nbrObjects);
+        for (NSUInteger index = firstIndex; index < lastIndex; ++index) {
+            id object = [m_objects objectAtIndex:index];
+            if (m_mappingBlock) {
+                m_mappedObjects[index] = [m_mappingBlock(object, index) retain];
+            }
+            else {
+                BOOL stop = NO;
+                m_enumerationBlock(object, index, &stop);
+                if (stop) {
+                    m_stopped = YES;
+                    OSMemoryBarrier();
+                    // Count remaining objects of the chunk as processed so that progress is consistent
+                    OSAtomicAdd32Barrier((int32_t)(lastIndex - index - 1), &m_nbrProcessedObjects);
+                    break;
+                }
+            }
+        }
+        
+        // Progress is reported for the whole collection, so that the task group progress (the average over all tasks) 
+        // reflects the fraction of objects processed so far
+        int32_t nbrProcessedObjects = OSAtomicAdd32Barrier((int32_t)(lastIndex - firstIndex), &m_nbrProcessedObjects);
+        [context updateProgressToValue:(float)nbrProcessedObjects / nbrObjects];
+        
+        [pool drain];
+    }
+}
+
+- (BOOL)popChunkIndex:(NSUInteger *)pChunkIndex fromDequeAtIndex:(NSUInteger)dequeIndex steal:(BOOL)steal
+{
+    BOOL found = NO;
+    OSSpinLockLock(&m_locks[dequeIndex]);
+    if (m_heads[dequeIndex] < m_tails[dequeIndex]) {
+        *pChunkIndex = steal ? --m_tails[dequeIndex] : m_heads[dequeIndex]++;
+        found = YES;
+    }
+    OSSpinLockUnlock(&m_locks[dequeIndex]);
+    return found;
+}
+
+#pragma mark Results
+
+- (NSArray *)mappedObjects
+{
+    if (! m_mappedObjects) {
+        return nil;
+    }
+    
+    NSUInteger nbrObjects = [m_objects count];
+    NSMutableArray *mappedObjects = [NSMutableArray arrayWithCapacity:nbrObjects];
+    for (NSUInteger i = 0; i < nbrObjects; ++i) {
+        [mappedObjects addObject:m_mappedObjects[i] ? m_mappedObjects[i] : [NSNull null]];
+    }
+    return [NSArray arrayWithArray:mappedObjects];
+}
+
+@end
+
+#pragma mark -
+#pragma mark Creating parallel enumeration task groups
+
+static HLSTaskGroup *HLSTaskGroupProcessingObjects(NSArray *objects, HLSParallelEnumerationBlock enumerationBlock, 
+                                                   HLSParallelMappingBlock mappingBlock)
+{
+    HLSTaskGroup *taskGroup = [[[HLSTaskGroup alloc] init] autorelease];
+    
+    NSUInteger nbrObjects = [objects count];
+    if (nbrObjects == 0) {
+        return taskGroup;
+    }
+    
+    NSUInteger nbrTasks = MIN(MAX([[NSProcessInfo processInfo] activeProcessorCount], 1), nbrObjects);
+    HLSParallelEnumerationState *state = [[[HLSParallelEnumerationState alloc] initWithObjects:objects 
+                                                                              enumerationBlock:enumerationBlock
+                                                                                  mappingBlock:mappingBlock
+                                                                                      nbrTasks:nbrTasks] autorelease];
+    NSDictionary *userInfo = [NSDictionary dictionaryWithObject:state forKey:kParallelEnumerationStateKey];
+    for (NSUInteger i = 0; i < nbrTasks; ++i) {
+        HLSBlockTask *task = [HLSBlockTask blockTaskWithBlock:^(id<HLSBlockTaskContext> context) {
+            [state processForTaskAtIndex:i context:context];
+        }];
+        task.userInfo = userInfo;
+        [taskGroup addTask:task];
+    }
+    return taskGroup;
+}
+
+#pragma mark -
+#pragma mark HLSTaskGroup (HLSParallelEnumeration) category
+
+@implementation HLSTaskGroup (HLSParallelEnumeration)
+
++ (HLSTaskGroup *)taskGroupEnumeratingObjects:(NSArray *)objects usingBlock:(HLSParallelEnumerationBlock)block
+{
+    if (! block) {
+        HLSLoggerError(@"Missing block");
+        return nil;
+    }
+    
+    return HLSTaskGroupProcessingObjects(objects, block, nil);
+}
+
++ (HLSTaskGroup *)taskGroupMappingObjects:(NSArray *)objects usingBlock:(HLSParallelMappingBlock)block
+{
+    if (! block) {
+        HLSLoggerError(@"Missing block");
+        return nil;
+    }
+    
+    return HLSTaskGroupProcessingObjects(objects, nil, block);
+}
+
+- (NSArray *)mappedObjects
+{
+    if (! self.finished || self.cancelled || [self nbrFailures] != 0) {
+        return nil;
+    }
+    
+    // Empty collection
+    NSSet *tasks = [self tasks];
+    if ([tasks count] == 0) {
+        return [NSArray array];
+    }
+    
+    HLSParallelEnumerationState *state = [[[tasks anyObject] userInfo] objectForKey:kParallelEnumerationStateKey];
+    return [state mappedObjects];
+}
+
+@end
+
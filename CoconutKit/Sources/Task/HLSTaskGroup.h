@@ -30,12 +30,22 @@
 @private
     NSString *_tag;
     NSDictionary *_userInfo;
+    HLSTaskPriority _priority;
+    BOOL _deferrable;
+    BOOL _durable;
     NSMutableSet *_taskSet;                                     // contains HLSTask objects
-    // Dependencies between tasks are saved in both directions for faster lookup
-    NSMutableDictionary *_weakTaskDependencyMap;                // maps an HLSTask object to the NSMutableSet of all other HLSTask objects it weakly depends on
-    NSMutableDictionary *_strongTaskDependencyMap;              // maps an HLSTask object to the NSMutableSet of all other HLSTask objects it strongly depends on
-    NSMutableDictionary *_taskToWeakDependentsMap;              // maps an HLSTask object to the NSMutableSet of all HLSTask objects weakly depending on it
-    NSMutableDictionary *_taskToStrongDependentsMap;            // maps an HLSTask object to the NSMutableSet of all HLSTask objects strongly depending on it
+    NSMutableArray *_taskArray;                                 // HLSTask objects in insertion order; the index identifies a task in the dependency graph
+    CFMutableDictionaryRef _taskToIndexMap;                     // maps an HLSTask object to its index (pointer identity)
+    // Dependencies between tasks are stored as an edge pool, each edge being chained in the dependency list of its
+    // dependent task and in the dependent list of the task it depends on. Both directions can therefore be walked
+    // in time proportional to the number of edges involved
+    struct HLSTaskDependencyEdge *_dependencyEdges;
+    NSUInteger _nbrDependencyEdges;
+    NSUInteger _dependencyEdgesCapacity;
+    NSUInteger *_firstDependencyEdgeIndexes;                    // for each task, index of the first edge in its dependency list (NSNotFound if none)
+    NSUInteger *_firstDependentEdgeIndexes;                     // for each task, index of the first edge in its dependent list (NSNotFound if none)
+    NSUInteger *_nbrDependencies;                               // for each task, in-degree counter (number of tasks it depends on)
+    NSUInteger _tasksCapacity;
     BOOL _running;
     BOOL _finished;
     BOOL _cancelled;
@@ -45,6 +55,9 @@
     NSDate *_lastEstimateDate;                  // date & time when the remaining time was previously estimated ...
     float _lastEstimateFullProgress;            // ... and corresponding progress value 
     NSUInteger _fullProgressStepsCounter;     
+    double _progressSum;                        // running sum of all individual progress values
+    double _fullProgressSum;                    // running sum of all individual progress values (failures count as 1.f)
+    NSUInteger _nbrFinishedTasks;
     NSUInteger _nbrFailures;
 }
 
@@ -58,6 +71,26 @@
  */
 @property (nonatomic, retain) NSDictionary *userInfo;
 
+/**
+ * The priority applied to all tasks of the task group (default is HLSTaskPriorityNormal), overriding their individual
+ * priority. Changing this value does not affect a task group which has already been submitted
+ */
+@property (nonatomic, assign) HLSTaskPriority priority;
+
+/**
+ * If set to YES, tasks of the task group which have not been started yet are held back while the task manager is 
+ * under memory pressure, and resume when pressure is gone (see HLSTaskManager). Tasks already running are not
+ * affected. Default is NO
+ */
+@property (nonatomic, assign, getter=isDeferrable) BOOL deferrable;
+
+/**
+ * If set to YES, the task group is recorded in the journal of the task manager it is submitted to (if any), together 
+ * with its tasks and their dependencies. Tasks which have not ended when the application is terminated can then be
+ * resubmitted as a task group at the next launch (see -[HLSTaskManager journal]). Default is NO
+ */
+@property (nonatomic, assign, getter=isDurable) BOOL durable;
+
 /**
  * Add a task to the task group
  */
@@ -115,6 +148,8 @@
  * task1 will only begin processing once task2 has been fully processed. Moreover, if the strong boolean is set to YES, task1 will be
  * cancelled before it starts if task2 failed or was cancelled ("strong dependency"). Otherwise task1 will be started after task2 ends, no
  * matter what happened with task2 ("weak dependency")
+ *
+ * Dependencies must not form cycles. Cycles are detected when the task group is submitted, which then fails
  */
 - (void)addDependencyForTask:(HLSTask *)task1 onTask:(HLSTask *)task2 strong:(BOOL)strong;
 
@@ -13,6 +13,9 @@
 #import "HLSTask+Friend.h"
 #import "NSBundle+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
+
 // Remark:
 // HLSTaskGroup is not a subclass of HLSTask. This would have been nice, but this would also have introduced subtle
 // issues regarding cycling task dependencies in the task composites which could have been made in this case. To
@@ -21,13 +24,22 @@
 
 const NSUInteger kFullProgressStepsCounterThreshold = 50;
 
+static const NSUInteger kDependencyGraphInitialCapacity = 8;
+
+// Dependency between two tasks, identified by their index in the task group. Chained both in the dependency list of
+// the dependent task and in the dependent list of the task it depends on
+struct HLSTaskDependencyEdge {
+    NSUInteger dependencyIndex;                     // index of the task which is depended on
+    NSUInteger dependentIndex;                      // index of the task which depends on it
+    NSUInteger nextDependencyEdgeIndex;             // next edge with the same dependent task (NSNotFound if none)
+    NSUInteger nextDependentEdgeIndex;              // next edge with the same dependency task (NSNotFound if none)
+    BOOL strong;
+};
+
 @interface HLSTaskGroup ()
 
 @property (nonatomic, retain) NSMutableSet *taskSet;
-@property (nonatomic, retain) NSMutableDictionary *weakTaskDependencyMap;
-@property (nonatomic, retain) NSMutableDictionary *strongTaskDependencyMap;
-@property (nonatomic, retain) NSMutableDictionary *taskToWeakDependentsMap;
-@property (nonatomic, retain) NSMutableDictionary *taskToStrongDependentsMap;
+@property (nonatomic, retain) NSMutableArray *taskArray;
 @property (nonatomic, assign, getter=isRunning) BOOL running;
 @property (nonatomic, assign, getter=isFinished) BOOL finished;
 @property (nonatomic, assign, getter=isCancelled) BOOL cancelled;
@@ -37,6 +49,14 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
 @property (nonatomic, retain) NSDate *lastEstimateDate;
 
 - (void)updateStatus;
+- (void)recalculateAggregates;
+
+- (void)taskProgressDidChange:(HLSTask *)task previousProgress:(float)previousProgress;
+- (void)taskFinishedDidChange:(HLSTask *)task;
+- (void)taskErrorDidChange:(HLSTask *)task previousError:(NSError *)previousError;
+
+- (NSUInteger)indexOfTask:(HLSTask *)task;
+- (NSSet *)tasksAlongEdgesFromTask:(HLSTask *)task dependents:(BOOL)dependents weak:(BOOL)weak strong:(BOOL)strong;
 
 - (NSSet *)dependenciesForTask:(HLSTask *)task;
 - (NSSet *)weakDependenciesForTask:(HLSTask *)task;
@@ -46,6 +66,9 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
 - (NSSet *)weakDependentsForTask:(HLSTask *)task;
 - (NSSet *)strongDependentsForTask:(HLSTask *)task;
 
+- (NSArray *)topologicallySortedTasks;
+- (NSArray *)strongDependentsClosureForTask:(HLSTask *)task;
+
 - (void)reset;
 
 @end
@@ -59,10 +82,10 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
 {
     if ((self = [super init])) {
         self.taskSet = [NSMutableSet set];
-        self.weakTaskDependencyMap = [NSMutableDictionary dictionary];
-        self.strongTaskDependencyMap = [NSMutableDictionary dictionary];
-        self.taskToWeakDependentsMap = [NSMutableDictionary dictionary];
-        self.taskToStrongDependentsMap = [NSMutableDictionary dictionary];
+        self.taskArray = [NSMutableArray array];
+        // Pointer identity keys, plain integer values
+        _taskToIndexMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+        self.priority = HLSTaskPriorityNormal;
         [self reset];
     }
     return self;
@@ -70,13 +93,20 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
 
 - (void)dealloc
 {
+    // Tasks might outlive their task group
+    for (HLSTask *task in self.taskSet) {
+        task.taskGroup = nil;
+    }
+    
     self.tag = nil;
     self.userInfo = nil;
     self.taskSet = nil;
-    self.weakTaskDependencyMap = nil;
-    self.strongTaskDependencyMap = nil;
-    self.taskToWeakDependentsMap = nil;
-    self.taskToStrongDependentsMap = nil;
+    self.taskArray = nil;
+    CFRelease(_taskToIndexMap);
+    free(_dependencyEdges);
+    free(_firstDependencyEdgeIndexes);
+    free(_firstDependentEdgeIndexes);
+    free(_nbrDependencies);
     self.lastEstimateDate = nil;
     [super dealloc];
 }
@@ -88,6 +118,12 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
 
 @synthesize userInfo = _userInfo;
 
+@synthesize priority = _priority;
+
+@synthesize deferrable = _deferrable;
+
+@synthesize durable = _durable;
+
 @synthesize taskSet = _taskSet;
 
 - (NSSet *)tasks
@@ -95,13 +131,7 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
     return [NSSet setWithSet:self.taskSet];
 }
 
-@synthesize weakTaskDependencyMap = _weakTaskDependencyMap;
-
-@synthesize strongTaskDependencyMap = _strongTaskDependencyMap;
-
-@synthesize taskToWeakDependentsMap = _taskToWeakDependentsMap;
-
-@synthesize taskToStrongDependentsMap = _taskToStrongDependentsMap;
+@synthesize taskArray = _taskArray;
 
 @synthesize running = _running;
 
@@ -219,8 +249,36 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
         return;
     }
     
+    if ([self.taskSet containsObject:task]) {
+        return;
+    }
+    
+    // Node in the dependency graph
+    NSUInteger index = [self.taskArray count];
+    if (index == _tasksCapacity) {
+        _tasksCapacity = MAX(2 * _tasksCapacity, kDependencyGraphInitialCapacity);
+        _firstDependencyEdgeIndexes = realloc(_firstDependencyEdgeIndexes, _tasksCapacity * sizeof(NSUInteger));
+        _firstDependentEdgeIndexes = realloc(_firstDependentEdgeIndexes, _tasksCapacity * sizeof(NSUInteger));
+        _nbrDependencies = realloc(_nbrDependencies, _tasksCapacity * sizeof(NSUInteger));
+    }
+    _firstDependencyEdgeIndexes[index] = NSNotFound;
+    _firstDependentEdgeIndexes[index] = NSNotFound;
+    _nbrDependencies[index] = 0;
+    CFDictionarySetValue(_taskToIndexMap, task, (const void *)index);
+    [self.taskArray addObject:task];
+    
     [self.taskSet addObject:task];
     task.taskGroup = self;
+    
+    // Account for the current status of the task
+    _progressSum += task.progress;
+    _fullProgressSum += task.error ? 1.f : task.progress;
+    if (task.finished) {
+        ++_nbrFinishedTasks;
+    }
+    if (task.error) {
+        ++_nbrFailures;
+    }
 }
 
 #pragma mark -
@@ -228,34 +286,79 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
 
 - (void)updateStatus
 {
-    // Calculate the overall progress and status
-    float progress = 0.f;
-    float fullProgress = 0.f;
-    BOOL finished = YES;
+    NSUInteger nbrTasks = [self.taskSet count];
+    if (nbrTasks == 0) {
+        return;
+    }
+    
+    // Running sums may slightly drift out of range because of rounding errors
+    self.progress = MIN(MAX(_progressSum / nbrTasks, 0.f), 1.f);
+    self.fullProgress = MIN(MAX(_fullProgressSum / nbrTasks, 0.f), 1.f);
+    self.finished = (_nbrFinishedTasks == nbrTasks);
+}
+
+// Recalculate aggregate values from scratch. Only done when the task group is reset, so that each submission starts
+// from values consistent with the current task status
+- (void)recalculateAggregates
+{
+    _progressSum = 0.;
+    _fullProgressSum = 0.;
+    _nbrFinishedTasks = 0;
+    _nbrFailures = 0;
     for (HLSTask *task in self.taskSet) {
-        progress += task.progress;
+        _progressSum += task.progress;
         
-        // If at least one task is not finished, so is the task group
-        if (! task.finished) {
-            finished = NO;
+        if (task.finished) {
+            ++_nbrFinishedTasks;
         }
         
         // Failed tasks increase the failure counter and count for 1 in fullProgress
         if (task.error) {
-            fullProgress += 1.f;
+            _fullProgressSum += 1.f;
             ++_nbrFailures;
         }
         else {
-            fullProgress += task.progress;
+            _fullProgressSum += task.progress;
         }
     }
-    progress /= [self.taskSet count];
-    fullProgress /= [self.taskSet count];
+}
+
+- (void)taskProgressDidChange:(HLSTask *)task previousProgress:(float)previousProgress
+{
+    float progressDelta = task.progress - previousProgress;
+    _progressSum += progressDelta;
     
-    // Update the values stored internally
-    self.progress = progress;
-    self.fullProgress = fullProgress;
-    self.finished = finished;
+    // Failed tasks already count for 1 in fullProgress
+    if (! task.error) {
+        _fullProgressSum += progressDelta;
+    }
+}
+
+- (void)taskFinishedDidChange:(HLSTask *)task
+{
+    if (task.finished) {
+        ++_nbrFinishedTasks;
+    }
+    else {
+        --_nbrFinishedTasks;
+    }
+}
+
+- (void)taskErrorDidChange:(HLSTask *)task previousError:(NSError *)previousError
+{
+    // Failure state has not changed
+    if ((task.error != nil) == (previousError != nil)) {
+        return;
+    }
+    
+    if (task.error) {
+        _fullProgressSum += 1.f - task.progress;
+        ++_nbrFailures;
+    }
+    else {
+        _fullProgressSum -= 1.f - task.progress;
+        --_nbrFailures;
+    }
 }
 
 #pragma mark -
@@ -264,92 +367,198 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
 - (void)addDependencyForTask:(HLSTask *)task1 onTask:(HLSTask *)task2 strong:(BOOL)strong
 {
     // Check that both tasks are part of the task group
-    if (! [self.taskSet containsObject:task1]) {
+    NSUInteger index1 = [self indexOfTask:task1];
+    if (index1 == NSNotFound) {
         HLSLoggerError(@"First task %@ does not belong to the task group set; cannot set a dependency", task1);
         return;
     }
-    if (! [self.taskSet containsObject:task2]) {
+    NSUInteger index2 = [self indexOfTask:task2];
+    if (index2 == NSNotFound) {
         HLSLoggerError(@"Second task %@ does not belong to the task group set; cannot set a dependency", task2);
         return;
     }
     
     // Cannot set a dependency on itself!
-    if (task1 == task2) {
+    if (index1 == index2) {
         HLSLoggerError(@"A task cannot add itself as dependency");
+        return;
     }
     
     // A dependency is either weak or strong, and cannot be registered several times
-    NSValue *task1Key = [NSValue valueWithPointer:task1];
-    NSMutableSet *task1WeakDependencies = [self.weakTaskDependencyMap objectForKey:task1Key];
-    if ([task1WeakDependencies containsObject:task2]) {
-        HLSLoggerError(@"Task %@ already registered as weak dependency on task %@", task1, task2);
-        return;
+    for (NSUInteger edgeIndex = _firstDependencyEdgeIndexes[index1]; edgeIndex != NSNotFound; 
+            edgeIndex = _dependencyEdges[edgeIndex].nextDependencyEdgeIndex) {
+        struct HLSTaskDependencyEdge *edge = &_dependencyEdges[edgeIndex];
+        if (edge->dependencyIndex == index2) {
+            HLSLoggerError(@"Task %@ already registered as %@ dependency on task %@", task1, edge->strong ? @"strong" : @"weak", task2);
+            return;
+        }
     }
     
-    NSMutableSet *task1StrongDependencies = [self.strongTaskDependencyMap objectForKey:task1Key];
-    if ([task1StrongDependencies containsObject:task2]) {
-        HLSLoggerError(@"Task %@ already registered as strong dependency on task %@", task1, task2);
-        return;
+    // Allocate a new edge
+    if (_nbrDependencyEdges == _dependencyEdgesCapacity) {
+        _dependencyEdgesCapacity = MAX(2 * _dependencyEdgesCapacity, kDependencyGraphInitialCapacity);
+        _dependencyEdges = realloc(_dependencyEdges, _dependencyEdgesCapacity * sizeof(struct HLSTaskDependencyEdge));
     }
+    NSUInteger edgeIndex = _nbrDependencyEdges++;
+    struct HLSTaskDependencyEdge *edge = &_dependencyEdges[edgeIndex];
+    edge->dependencyIndex = index2;
+    edge->dependentIndex = index1;
+    edge->strong = strong;
     
-    // Register task2 in the dependencies of task1
-    NSMutableDictionary *dependencyMap = strong ? self.strongTaskDependencyMap : self.weakTaskDependencyMap;
-    NSMutableSet *task1Dependencies = [dependencyMap objectForKey:task1Key];
-    // Create the dependency set if it does not exist
-    if (! task1Dependencies) {
-        task1Dependencies = [NSMutableSet set];
-        [dependencyMap setObject:task1Dependencies forKey:task1Key];
-    }
-    [task1Dependencies addObject:task2];
+    // Chain the edge in the dependencies of task1 and in the dependents of task2
+    edge->nextDependencyEdgeIndex = _firstDependencyEdgeIndexes[index1];
+    _firstDependencyEdgeIndexes[index1] = edgeIndex;
+    edge->nextDependentEdgeIndex = _firstDependentEdgeIndexes[index2];
+    _firstDependentEdgeIndexes[index2] = edgeIndex;
     
-    // Register the inverse relation, i.e. task1 in the dependents of task2
-    NSMutableDictionary *taskToDependentsMap = strong ? self.taskToStrongDependentsMap : self.taskToWeakDependentsMap;
-    NSValue *task2Key = [NSValue valueWithPointer:task2];
-    NSMutableSet *task2Dependents = [taskToDependentsMap objectForKey:task2Key];
-    // Create the depdents set if it does not exist
-    if (! task2Dependents) {
-        task2Dependents = [NSMutableSet set];
-        [taskToDependentsMap setObject:task2Dependents forKey:task2Key];
-    }
-    [task2Dependents addObject:task1];
+    ++_nbrDependencies[index1];
+}
+
+- (NSUInteger)indexOfTask:(HLSTask *)task
+{
+    const void *value = NULL;
+    if (! task || ! CFDictionaryGetValueIfPresent(_taskToIndexMap, task, &value)) {
+        return NSNotFound;
+    }
+    return (NSUInteger)value;
+}
+
+// Collect the tasks at the other end of the edges starting from a task, either along its dependent list or along its
+// dependency list
+- (NSSet *)tasksAlongEdgesFromTask:(HLSTask *)task dependents:(BOOL)dependents weak:(BOOL)weak strong:(BOOL)strong
+{
+    NSUInteger index = [self indexOfTask:task];
+    if (index == NSNotFound) {
+        return [NSSet set];
+    }
+    
+    NSMutableSet *tasks = [NSMutableSet set];
+    NSUInteger edgeIndex = dependents ? _firstDependentEdgeIndexes[index] : _firstDependencyEdgeIndexes[index];
+    while (edgeIndex != NSNotFound) {
+        struct HLSTaskDependencyEdge *edge = &_dependencyEdges[edgeIndex];
+        if ((edge->strong && strong) || (! edge->strong && weak)) {
+            NSUInteger otherIndex = dependents ? edge->dependentIndex : edge->dependencyIndex;
+            [tasks addObject:[self.taskArray objectAtIndex:otherIndex]];
+        }
+        edgeIndex = dependents ? edge->nextDependentEdgeIndex : edge->nextDependencyEdgeIndex;
+    }
+    return [NSSet setWithSet:tasks];
 }
 
 - (NSSet *)dependenciesForTask:(HLSTask *)task
 {
-    NSSet *weakDependencies = [self weakDependenciesForTask:task];
-    NSSet *strongDependencies = [self strongDependenciesForTask:task];
-    return [weakDependencies setByAddingObjectsFromSet:strongDependencies];
+    return [self tasksAlongEdgesFromTask:task dependents:NO weak:YES strong:YES];
 }
 
 - (NSSet *)weakDependenciesForTask:(HLSTask *)task
 {
-    NSValue *taskKey = [NSValue valueWithPointer:task];
-    return [NSSet setWithSet:[self.weakTaskDependencyMap objectForKey:taskKey]];
+    return [self tasksAlongEdgesFromTask:task dependents:NO weak:YES strong:NO];
 }
 
 - (NSSet *)strongDependenciesForTask:(HLSTask *)task
 {
-    NSValue *taskKey = [NSValue valueWithPointer:task];
-    return [NSSet setWithSet:[self.strongTaskDependencyMap objectForKey:taskKey]];    
+    return [self tasksAlongEdgesFromTask:task dependents:NO weak:NO strong:YES];
 }
 
 - (NSSet *)dependentsForTask:(HLSTask *)task
 {
-    NSSet *weakDependents = [self weakDependentsForTask:task];
-    NSSet *strongDependents = [self strongDependentsForTask:task];
-    return [weakDependents setByAddingObjectsFromSet:strongDependents];
+    return [self tasksAlongEdgesFromTask:task dependents:YES weak:YES strong:YES];
 }
 
 - (NSSet *)weakDependentsForTask:(HLSTask *)task
 {
-    NSValue *taskKey = [NSValue valueWithPointer:task];
-    return [NSSet setWithSet:[self.taskToWeakDependentsMap objectForKey:taskKey]];
+    return [self tasksAlongEdgesFromTask:task dependents:YES weak:YES strong:NO];
 }
 
 - (NSSet *)strongDependentsForTask:(HLSTask *)task
 {
-    NSValue *taskKey = [NSValue valueWithPointer:task];
-    return [NSSet setWithSet:[self.taskToStrongDependentsMap objectForKey:taskKey]];    
+    return [self tasksAlongEdgesFromTask:task dependents:YES weak:NO strong:YES];
+}
+
+// Kahn's algorithm: Repeatedly emit the tasks whose dependencies have all been emitted. If some tasks are never
+// emitted, they belong to a cycle
+- (NSArray *)topologicallySortedTasks
+{
+    NSUInteger nbrTasks = [self.taskArray count];
+    if (nbrTasks == 0) {
+        return [NSArray array];
+    }
+    
+    NSUInteger *nbrRemainingDependencies = malloc(nbrTasks * sizeof(NSUInteger));
+    memcpy(nbrRemainingDependencies, _nbrDependencies, nbrTasks * sizeof(NSUInteger));
+    
+    // The sorted indexes themselves are used as work queue: [head, tail) contains the tasks ready but not processed yet
+    NSUInteger *sortedIndexes = malloc(nbrTasks * sizeof(NSUInteger));
+    NSUInteger head = 0;
+    NSUInteger tail = 0;
+    for (NSUInteger index = 0; index < nbrTasks; ++index) {
+        if (nbrRemainingDependencies[index] == 0) {
+            sortedIndexes[tail++] = index;
+        }
+    }
+    
+    while (head < tail) {
+        NSUInteger index = sortedIndexes[head++];
+        for (NSUInteger edgeIndex = _firstDependentEdgeIndexes[index]; edgeIndex != NSNotFound; 
+                edgeIndex = _dependencyEdges[edgeIndex].nextDependentEdgeIndex) {
+            NSUInteger dependentIndex = _dependencyEdges[edgeIndex].dependentIndex;
+            if (--nbrRemainingDependencies[dependentIndex] == 0) {
+                sortedIndexes[tail++] = dependentIndex;
+            }
+        }
+    }
+    
+    NSMutableArray *sortedTasks = nil;
+    if (tail == nbrTasks) {
+        sortedTasks = [NSMutableArray arrayWithCapacity:nbrTasks];
+        for (NSUInteger i = 0; i < nbrTasks; ++i) {
+            [sortedTasks addObject:[self.taskArray objectAtIndex:sortedIndexes[i]]];
+        }
+    }
+    
+    free(nbrRemainingDependencies);
+    free(sortedIndexes);
+    
+    return sortedTasks ? [NSArray arrayWithArray:sortedTasks] : nil;
+}
+
+// Breadth-first traversal along strong dependent edges
+- (NSArray *)strongDependentsClosureForTask:(HLSTask *)task
+{
+    NSUInteger index = [self indexOfTask:task];
+    if (index == NSNotFound) {
+        return [NSArray array];
+    }
+    
+    NSUInteger nbrTasks = [self.taskArray count];
+    BOOL *visited = calloc(nbrTasks, sizeof(BOOL));
+    NSUInteger *queue = malloc(nbrTasks * sizeof(NSUInteger));
+    NSUInteger head = 0;
+    NSUInteger tail = 0;
+    
+    visited[index] = YES;
+    queue[tail++] = index;
+    
+    NSMutableArray *dependents = [NSMutableArray array];
+    while (head < tail) {
+        NSUInteger currentIndex = queue[head++];
+        for (NSUInteger edgeIndex = _firstDependentEdgeIndexes[currentIndex]; edgeIndex != NSNotFound; 
+                edgeIndex = _dependencyEdges[edgeIndex].nextDependentEdgeIndex) {
+            struct HLSTaskDependencyEdge *edge = &_dependencyEdges[edgeIndex];
+            if (! edge->strong || visited[edge->dependentIndex]) {
+                continue;
+            }
+            
+            visited[edge->dependentIndex] = YES;
+            queue[tail++] = edge->dependentIndex;
+            [dependents addObject:[self.taskArray objectAtIndex:edge->dependentIndex]];
+        }
+    }
+    
+    free(visited);
+    free(queue);
+    
+    return [NSArray arrayWithArray:dependents];
 }
 
 #pragma mark -
@@ -364,7 +573,7 @@ const NSUInteger kFullProgressStepsCounterThreshold = 50;
     self.fullProgress = 0.f;
     self.remainingTimeIntervalEstimate = kTaskGroupNoTimeIntervalEstimateAvailable;
     self.lastEstimateDate = nil;
-    _nbrFailures = 0;
+    [self recalculateAggregates];
 }
 
 @end
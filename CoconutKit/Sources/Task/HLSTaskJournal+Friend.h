@@ -0,0 +1,37 @@
+//
+//  HLSTaskJournal+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTask.h"
+#import "HLSTaskGroup.h"
+
+/**
+ * Interface meant to be used by friend classes of HLSTaskJournal (= classes which must have access to private implementation
+ * details)
+ */
+@interface HLSTaskJournal (Friend)
+
+/**
+ * Record the submission of single tasks (in a single write) or of a task group. Tasks which are already recorded
+ * are ignored
+ */
+- (void)recordSubmissionOfTasks:(NSArray *)tasks;
+- (void)recordSubmissionOfTaskGroup:(HLSTaskGroup *)taskGroup;
+
+/**
+ * Record the end of a task (processed, failed or cancelled). Tasks which are not recorded are ignored
+ */
+- (void)recordEndOfTask:(HLSTask *)task;
+
+/**
+ * Read the records saved in the file and return the single tasks and task groups which have not ended, in submission 
+ * order (task groups only contain the tasks which have not ended, and the dependencies between them). The returned
+ * objects are recorded again in a new file replacing the previous one, and must be submitted right away
+ */
+- (NSArray *)replayedTasksAndTaskGroups;
+
+@end
@@ -0,0 +1,70 @@
+//
+//  HLSTaskJournal.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSFileManager.h"
+
+/**
+ * Append-only journal in which a task manager records the durable tasks and task groups it has been submitted (see
+ * -[HLSTask durable] and -[HLSTaskGroup durable]), so that those which had not ended when the application was
+ * terminated can be resubmitted at the next launch (see -[HLSTaskManager submitJournaledTasksWithDelegate:taskGroupDelegate:])
+ *
+ * Each submission appends a record describing the tasks (class, tag, priority, userInfo, checkpoint and identity keys,
+ * timeout), as well as the dependencies between the tasks of a task group. Each task end (whether the task has been
+ * processed, has failed or has been cancelled) appends a short record as well. Records are written through a file
+ * manager, simultaneously submitted tasks being written at once. When the journal is replayed, the records of the
+ * tasks which have not ended are rewritten to a new file, which replaces the previous one. The file is removed when
+ * no recorded task is pending anymore, so that the journal never grows beyond the tasks which are pending
+ *
+ * As for checkpoints, the task classes must be instantiable using -init, and userInfo dictionaries must only contain
+ * objects conforming to NSCoding. A journal must be attached to a single task manager (since it is not thread-safe),
+ * and a file must be used by a single journal at a time
+ *
+ * Designated initializer: -initWithFilePath:fileManager:
+ */
+@interface HLSTaskJournal : NSObject {
+@private
+    NSString *m_filePath;
+    HLSFileManager *m_fileManager;
+    id<HLSFileHandle> m_fileHandle;
+    CFMutableDictionaryRef m_taskToEntryMap;            // Maps a recorded task which has not ended (not retained) to its journal entry
+    BOOL m_holdingPreviousRecords;                      // YES while the file contains records which have not been replayed
+}
+
+/**
+ * Create a journal stored at the given path, using the specified file manager (the default one if nil). Records
+ * already saved at this path are kept until the journal is replayed
+ */
+- (id)initWithFilePath:(NSString *)filePath fileManager:(HLSFileManager *)fileManager;
+
+/**
+ * Create a journal stored at the given path with the default file manager
+ */
+- (id)initWithFilePath:(NSString *)filePath;
+
+/**
+ * The path of the journal file
+ */
+@property (nonatomic, readonly, retain) NSString *filePath;
+
+/**
+ * The file manager used
+ */
+@property (nonatomic, readonly, retain) HLSFileManager *fileManager;
+
+/**
+ * Return the number of recorded tasks which have not ended yet (tasks read from the file are only counted after the
+ * journal has been replayed)
+ */
+- (NSUInteger)pendingTaskCount;
+
+/**
+ * Remove all records, including those saved by a previous launch. Tasks which are running are not recorded anymore
+ */
+- (void)removeAllRecords;
+
+@end
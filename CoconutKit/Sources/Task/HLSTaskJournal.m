@@ -0,0 +1,636 @@
+//
+//  HLSTaskJournal.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskJournal.h"
+
+#import "HLSAssert.h"
+#import "HLSLogger.h"
+#import "HLSTask+Friend.h"
+#import "HLSTaskGroup+Friend.h"
+#import "HLSTaskJournal+Friend.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
+
+// Record dictionary keys and types. A submission record contains an array of items, each describing a single task or
+// a task group. An end record identifies a task by the identifier of its item (and its index if it belongs to a task group)
+static NSString * const kTaskJournalRecordTypeKey = @"type";
+static NSString * const kTaskJournalRecordItemsKey = @"items";
+static NSString * const kTaskJournalRecordIdentifierKey = @"identifier";
+static NSString * const kTaskJournalRecordIndexKey = @"index";
+
+static NSString * const kTaskJournalRecordTypeSubmission = @"submission";
+static NSString * const kTaskJournalRecordTypeEnd = @"end";
+
+// Item dictionary keys
+static NSString * const kTaskJournalItemIdentifierKey = @"identifier";
+static NSString * const kTaskJournalItemTaskKey = @"task";
+static NSString * const kTaskJournalItemTaskGroupKey = @"taskGroup";
+
+// Task descriptor keys
+static NSString * const kTaskJournalTaskClassNameKey = @"className";
+static NSString * const kTaskJournalTaskTagKey = @"tag";
+static NSString * const kTaskJournalTaskPriorityKey = @"priority";
+static NSString * const kTaskJournalTaskUserInfoKey = @"userInfo";
+static NSString * const kTaskJournalTaskCheckpointKeyKey = @"checkpointKey";
+static NSString * const kTaskJournalTaskIdentityKeyKey = @"identityKey";
+static NSString * const kTaskJournalTaskTimeoutIntervalKey = @"timeoutInterval";
+
+// Task group descriptor keys. Dependencies are stored as (dependent task index, dependency task index, strong) triples
+static NSString * const kTaskJournalTaskGroupTagKey = @"tag";
+static NSString * const kTaskJournalTaskGroupPriorityKey = @"priority";
+static NSString * const kTaskJournalTaskGroupUserInfoKey = @"userInfo";
+static NSString * const kTaskJournalTaskGroupDeferrableKey = @"deferrable";
+static NSString * const kTaskJournalTaskGroupTasksKey = @"tasks";
+static NSString * const kTaskJournalTaskGroupDependenciesKey = @"dependencies";
+
+static NSString *HLSTaskJournalNewIdentifier(void);
+static NSDictionary *HLSTaskJournalTaskDescriptor(HLSTask *task);
+static HLSTask *HLSTaskJournalTaskFromDescriptor(NSDictionary *descriptor);
+
+#pragma mark -
+#pragma mark HLSTaskJournalEntry class interface
+
+/**
+ * A task recorded in the journal: Identifier of the item it was recorded with, and index in its task group
+ * (NSNotFound for single tasks)
+ */
+@interface HLSTaskJournalEntry : NSObject {
+@private
+    NSString *m_identifier;
+    NSUInteger m_index;
+}
+
+@property (nonatomic, retain) NSString *identifier;
+@property (nonatomic, assign) NSUInteger index;
+
+@end
+
+#pragma mark -
+#pragma mark HLSTaskJournal class
+
+@interface HLSTaskJournal ()
+
+@property (nonatomic, retain) NSString *filePath;
+@property (nonatomic, retain) HLSFileManager *fileManager;
+@property (nonatomic, retain) id<HLSFileHandle> fileHandle;
+
+- (NSDictionary *)itemForTasks:(NSArray *)tasks inTaskGroup:(HLSTaskGroup *)taskGroup;
+- (void)appendRecord:(NSDictionary *)record;
+- (NSData *)dataForRecord:(NSDictionary *)record;
+- (NSArray *)recordsFromData:(NSData *)data;
+
+@end
+
+@implementation HLSTaskJournal
+
+#pragma mark Object creation and destruction
+
+- (id)initWithFilePath:(NSString *)filePath fileManager:(HLSFileManager *)fileManager
+{
+    if ((self = [super init])) {
+        if (! filePath) {
+            HLSLoggerError(@"Missing file path");
+            [self release];
+            return nil;
+        }
+        
+        self.filePath = filePath;
+        self.fileManager = fileManager ?: [HLSFileManager defaultManager];
+        
+        // Values are retained
+        m_taskToEntryMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        
+        // Records saved by a previous launch must not be lost before they have been replayed
+        m_holdingPreviousRecords = [self.fileManager fileExistsAtPath:filePath];
+    }
+    return self;
+}
+
+- (id)initWithFilePath:(NSString *)filePath
+{
+    return [self initWithFilePath:filePath fileManager:nil];
+}
+
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
+
+- (void)dealloc
+{
+    [self.fileHandle close];
+    
+    self.filePath = nil;
+    self.fileManager = nil;
+    self.fileHandle = nil;
+    CFRelease(m_taskToEntryMap);
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize filePath = m_filePath;
+
+@synthesize fileManager = m_fileManager;
+
+@synthesize fileHandle = m_fileHandle;
+
+- (NSUInteger)pendingTaskCount
+{
+    return CFDictionaryGetCount(m_taskToEntryMap);
+}
+
+#pragma mark Recording
+
+- (void)recordSubmissionOfTasks:(NSArray *)tasks
+{
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:[tasks count]];
+    for (HLSTask *task in tasks) {
+        if (CFDictionaryContainsKey(m_taskToEntryMap, task)) {
+            continue;
+        }
+        
+        NSDictionary *item = [self itemForTasks:[NSArray arrayWithObject:task] inTaskGroup:nil];
+        if (! item) {
+            continue;
+        }
+        [items addObject:item];
+    }
+    
+    if ([items count] == 0) {
+        return;
+    }
+    
+    [self appendRecord:[NSDictionary dictionaryWithObjectsAndKeys:kTaskJournalRecordTypeSubmission, kTaskJournalRecordTypeKey,
+                        items, kTaskJournalRecordItemsKey, nil]];
+}
+
+- (void)recordSubmissionOfTaskGroup:(HLSTaskGroup *)taskGroup
+{
+    // The task group has been checked for cycles when submitted. Tasks are recorded in topological order so that they
+    // can be submitted in the same order when replayed
+    NSArray *sortedTasks = [taskGroup topologicallySortedTasks];
+    if ([sortedTasks count] == 0) {
+        return;
+    }
+    
+    for (HLSTask *task in sortedTasks) {
+        if (CFDictionaryContainsKey(m_taskToEntryMap, task)) {
+            return;
+        }
+    }
+    
+    NSDictionary *item = [self itemForTasks:sortedTasks inTaskGroup:taskGroup];
+    if (! item) {
+        return;
+    }
+    
+    [self appendRecord:[NSDictionary dictionaryWithObjectsAndKeys:kTaskJournalRecordTypeSubmission, kTaskJournalRecordTypeKey,
+                        [NSArray arrayWithObject:item], kTaskJournalRecordItemsKey, nil]];
+}
+
+- (void)recordEndOfTask:(HLSTask *)task
+{
+    HLSTaskJournalEntry *entry = (HLSTaskJournalEntry *)CFDictionaryGetValue(m_taskToEntryMap, task);
+    if (! entry) {
+        return;
+    }
+    
+    // No task is pending anymore: Remove the file instead of recording the end, so that the journal does not grow forever
+    if (CFDictionaryGetCount(m_taskToEntryMap) == 1 && ! m_holdingPreviousRecords) {
+        [self removeAllRecords];
+        return;
+    }
+    
+    NSMutableDictionary *record = [NSMutableDictionary dictionaryWithObjectsAndKeys:kTaskJournalRecordTypeEnd, kTaskJournalRecordTypeKey,
+                                   entry.identifier, kTaskJournalRecordIdentifierKey, nil];
+    if (entry.index != NSNotFound) {
+        [record setObject:[NSNumber numberWithUnsignedInteger:entry.index] forKey:kTaskJournalRecordIndexKey];
+    }
+    CFDictionaryRemoveValue(m_taskToEntryMap, task);
+    
+    [self appendRecord:record];
+}
+
+- (void)removeAllRecords
+{
+    [self.fileHandle close];
+    self.fileHandle = nil;
+    CFDictionaryRemoveAllValues(m_taskToEntryMap);
+    m_holdingPreviousRecords = NO;
+    
+    if (! [self.fileManager fileExistsAtPath:self.filePath]) {
+        return;
+    }
+    
+    NSError *error = nil;
+    if (! [self.fileManager removeItemAtPath:self.filePath error:&error]) {
+        HLSLoggerError(@"Could not remove the task journal %@. Reason: %@", self.filePath, error);
+    }
+}
+
+// Return the item describing a single task (if taskGroup is nil) or a task group and its tasks, and register the
+// corresponding entries. Return nil if a task cannot be recorded
+- (NSDictionary *)itemForTasks:(NSArray *)tasks inTaskGroup:(HLSTaskGroup *)taskGroup
+{
+    NSMutableArray *taskDescriptors = [NSMutableArray arrayWithCapacity:[tasks count]];
+    for (HLSTask *task in tasks) {
+        NSDictionary *taskDescriptor = HLSTaskJournalTaskDescriptor(task);
+        if (! taskDescriptor) {
+            HLSLoggerError(@"The task %@ cannot be recorded (no task class)", task);
+            return nil;
+        }
+        [taskDescriptors addObject:taskDescriptor];
+    }
+    
+    NSString *identifier = HLSTaskJournalNewIdentifier();
+    NSMutableDictionary *item = [NSMutableDictionary dictionaryWithObject:identifier forKey:kTaskJournalItemIdentifierKey];
+    if (taskGroup) {
+        // Task pointers to indexes
+        CFMutableDictionaryRef taskToIndexMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+        for (NSUInteger i = 0; i < [tasks count]; ++i) {
+            CFDictionarySetValue(taskToIndexMap, [tasks objectAtIndex:i], (const void *)i);
+        }
+        
+        NSMutableArray *dependencies = [NSMutableArray array];
+        for (NSUInteger i = 0; i < [tasks count]; ++i) {
+            HLSTask *task = [tasks objectAtIndex:i];
+            NSSet *strongDependencies = [taskGroup strongDependenciesForTask:task];
+            for (HLSTask *dependencyTask in [taskGroup dependenciesForTask:task]) {
+                NSUInteger dependencyIndex = (NSUInteger)CFDictionaryGetValue(taskToIndexMap, dependencyTask);
+                [dependencies addObject:[NSArray arrayWithObjects:[NSNumber numberWithUnsignedInteger:i],
+                                         [NSNumber numberWithUnsignedInteger:dependencyIndex],
+                                         [NSNumber numberWithBool:[strongDependencies containsObject:dependencyTask]], nil]];
+            }
+        }
+        CFRelease(taskToIndexMap);
+        
+        NSMutableDictionary *taskGroupDescriptor = [NSMutableDictionary dictionary];
+        [taskGroupDescriptor setObject:[NSNumber numberWithInt:taskGroup.priority] forKey:kTaskJournalTaskGroupPriorityKey];
+        [taskGroupDescriptor setObject:[NSNumber numberWithBool:taskGroup.deferrable] forKey:kTaskJournalTaskGroupDeferrableKey];
+        [taskGroupDescriptor setObject:taskDescriptors forKey:kTaskJournalTaskGroupTasksKey];
+        [taskGroupDescriptor setObject:dependencies forKey:kTaskJournalTaskGroupDependenciesKey];
+        if (taskGroup.tag) {
+            [taskGroupDescriptor setObject:taskGroup.tag forKey:kTaskJournalTaskGroupTagKey];
+        }
+        if (taskGroup.userInfo) {
+            [taskGroupDescriptor setObject:taskGroup.userInfo forKey:kTaskJournalTaskGroupUserInfoKey];
+        }
+        [item setObject:taskGroupDescriptor forKey:kTaskJournalItemTaskGroupKey];
+    }
+    else {
+        [item setObject:[taskDescriptors objectAtIndex:0] forKey:kTaskJournalItemTaskKey];
+    }
+    
+    for (NSUInteger i = 0; i < [tasks count]; ++i) {
+        HLSTaskJournalEntry *entry = [[[HLSTaskJournalEntry alloc] init] autorelease];
+        entry.identifier = identifier;
+        entry.index = taskGroup ? i : NSNotFound;
+        CFDictionarySetValue(m_taskToEntryMap, [tasks objectAtIndex:i], entry);
+    }
+    
+    return [NSDictionary dictionaryWithDictionary:item];
+}
+
+- (void)appendRecord:(NSDictionary *)record
+{
+    NSData *data = [self dataForRecord:record];
+    if (! data) {
+        return;
+    }
+    
+    NSError *error = nil;
+    if (! self.fileHandle) {
+        NSString *directoryPath = [self.filePath stringByDeletingLastPathComponent];
+        if (! [self.fileManager fileExistsAtPath:directoryPath]
+                && ! [self.fileManager createDirectoryAtPath:directoryPath withIntermediateDirectories:YES error:&error]) {
+            HLSLoggerError(@"Could not create the task journal directory. Reason: %@", error);
+            return;
+        }
+        
+        self.fileHandle = [self.fileManager fileHandleForAppendingAtPath:self.filePath error:&error];
+        if (! self.fileHandle) {
+            HLSLoggerError(@"Could not open the task journal %@. Reason: %@", self.filePath, error);
+            return;
+        }
+    }
+    
+    if (! [self.fileHandle writeData:data error:&error]) {
+        HLSLoggerError(@"Could not write to the task journal %@. Reason: %@", self.filePath, error);
+    }
+}
+
+#pragma mark Encoding and decoding records
+
+// Records are archived and preceded by their length (32-bit big endian), so that they can be appended to the file
+- (NSData *)dataForRecord:(NSDictionary *)record
+{
+    NSData *recordData = nil;
+    @try {
+        recordData = [NSKeyedArchiver archivedDataWithRootObject:record];
+    }
+    @catch (NSException *exception) {
+        HLSLoggerError(@"Could not archive a task journal record (userInfo must only contain objects conforming to NSCoding). "
+                       "Reason: %@", [exception reason]);
+        return nil;
+    }
+    
+    uint32_t length = CFSwapInt32HostToBig((uint32_t)[recordData length]);
+    NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(length) + [recordData length]];
+    [data appendBytes:&length length:sizeof(length)];
+    [data appendData:recordData];
+    return data;
+}
+
+// A record truncated because the application was terminated while writing it is discarded, as well as all records
+// which cannot be read
+- (NSArray *)recordsFromData:(NSData *)data
+{
+    NSMutableArray *records = [NSMutableArray array];
+    const uint8_t *bytes = [data bytes];
+    NSUInteger offset = 0;
+    while (offset + sizeof(uint32_t) <= [data length]) {
+        uint32_t length = 0;
+        memcpy(&length, bytes + offset, sizeof(length));
+        length = CFSwapInt32BigToHost(length);
+        offset += sizeof(length);
+        if (offset + length > [data length]) {
+            HLSLoggerWarn(@"The last record of the task journal %@ is incomplete and has been discarded", self.filePath);
+            break;
+        }
+        
+        NSDictionary *record = nil;
+        @try {
+            record = [NSKeyedUnarchiver unarchiveObjectWithData:[data subdataWithRange:NSMakeRange(offset, length)]];
+        }
+        @catch (NSException *exception) {
+            HLSLoggerError(@"A record of the task journal %@ is corrupted and has been discarded. Reason: %@", self.filePath,
+                           [exception reason]);
+        }
+        offset += length;
+        
+        if (! [record isKindOfClass:[NSDictionary class]]) {
+            continue;
+        }
+        [records addObject:record];
+    }
+    return [NSArray arrayWithArray:records];
+}
+
+#pragma mark Replaying
+
+- (NSArray *)replayedTasksAndTaskGroups
+{
+    if (! [self.fileManager fileExistsAtPath:self.filePath]) {
+        m_holdingPreviousRecords = NO;
+        return [NSArray array];
+    }
+    
+    NSError *error = nil;
+    NSData *data = [self.fileManager contentsOfFileAtPath:self.filePath error:&error];
+    if (! data) {
+        HLSLoggerError(@"Could not read the task journal %@. Reason: %@", self.filePath, error);
+        return [NSArray array];
+    }
+    
+    // Collect the items which have not ended, in submission order, as well as the ended tasks of task groups (by index)
+    NSMutableArray *identifiers = [NSMutableArray array];
+    NSMutableDictionary *identifierToItemMap = [NSMutableDictionary dictionary];
+    NSMutableDictionary *identifierToEndedIndexesMap = [NSMutableDictionary dictionary];
+    for (NSDictionary *record in [self recordsFromData:data]) {
+        NSString *type = [record objectForKey:kTaskJournalRecordTypeKey];
+        if ([type isEqualToString:kTaskJournalRecordTypeSubmission]) {
+            for (NSDictionary *item in [record objectForKey:kTaskJournalRecordItemsKey]) {
+                NSString *identifier = [item objectForKey:kTaskJournalItemIdentifierKey];
+                if (! identifier) {
+                    continue;
+                }
+                [identifiers addObject:identifier];
+                [identifierToItemMap setObject:item forKey:identifier];
+            }
+        }
+        else if ([type isEqualToString:kTaskJournalRecordTypeEnd]) {
+            NSString *identifier = [record objectForKey:kTaskJournalRecordIdentifierKey];
+            if (! identifier) {
+                continue;
+            }
+            
+            NSNumber *indexNumber = [record objectForKey:kTaskJournalRecordIndexKey];
+            if (indexNumber) {
+                NSMutableIndexSet *endedIndexes = [identifierToEndedIndexesMap objectForKey:identifier];
+                if (! endedIndexes) {
+                    endedIndexes = [NSMutableIndexSet indexSet];
+                    [identifierToEndedIndexesMap setObject:endedIndexes forKey:identifier];
+                }
+                [endedIndexes addIndex:[indexNumber unsignedIntegerValue]];
+            }
+            else {
+                [identifierToItemMap removeObjectForKey:identifier];
+            }
+        }
+    }
+    
+    // Rebuild the objects which have not ended
+    NSMutableArray *objects = [NSMutableArray array];
+    for (NSString *identifier in identifiers) {
+        NSDictionary *item = [identifierToItemMap objectForKey:identifier];
+        if (! item) {
+            continue;
+        }
+        
+        NSDictionary *taskDescriptor = [item objectForKey:kTaskJournalItemTaskKey];
+        if (taskDescriptor) {
+            HLSTask *task = HLSTaskJournalTaskFromDescriptor(taskDescriptor);
+            if (! task) {
+                continue;
+            }
+            [objects addObject:task];
+            continue;
+        }
+        
+        NSDictionary *taskGroupDescriptor = [item objectForKey:kTaskJournalItemTaskGroupKey];
+        if (! taskGroupDescriptor) {
+            continue;
+        }
+        
+        HLSTaskGroup *taskGroup = [[[HLSTaskGroup alloc] init] autorelease];
+        taskGroup.durable = YES;
+        taskGroup.tag = [taskGroupDescriptor objectForKey:kTaskJournalTaskGroupTagKey];
+        taskGroup.userInfo = [taskGroupDescriptor objectForKey:kTaskJournalTaskGroupUserInfoKey];
+        taskGroup.priority = [[taskGroupDescriptor objectForKey:kTaskJournalTaskGroupPriorityKey] intValue];
+        taskGroup.deferrable = [[taskGroupDescriptor objectForKey:kTaskJournalTaskGroupDeferrableKey] boolValue];
+        
+        // Only the tasks which have not ended are added (NSNull placeholders for the others)
+        NSIndexSet *endedIndexes = [identifierToEndedIndexesMap objectForKey:identifier];
+        NSArray *groupTaskDescriptors = [taskGroupDescriptor objectForKey:kTaskJournalTaskGroupTasksKey];
+        NSMutableArray *tasks = [NSMutableArray arrayWithCapacity:[groupTaskDescriptors count]];
+        NSUInteger nbrTasks = 0;
+        for (NSUInteger i = 0; i < [groupTaskDescriptors count]; ++i) {
+            HLSTask *task = [endedIndexes containsIndex:i] ? nil : HLSTaskJournalTaskFromDescriptor([groupTaskDescriptors objectAtIndex:i]);
+            if (! task) {
+                [tasks addObject:[NSNull null]];
+                continue;
+            }
+            
+            [taskGroup addTask:task];
+            [tasks addObject:task];
+            ++nbrTasks;
+        }
+        
+        if (nbrTasks == 0) {
+            continue;
+        }
+        
+        for (NSArray *dependency in [taskGroupDescriptor objectForKey:kTaskJournalTaskGroupDependenciesKey]) {
+            if ([dependency count] != 3) {
+                continue;
+            }
+            
+            NSUInteger index1 = [[dependency objectAtIndex:0] unsignedIntegerValue];
+            NSUInteger index2 = [[dependency objectAtIndex:1] unsignedIntegerValue];
+            if (index1 >= [tasks count] || index2 >= [tasks count]) {
+                continue;
+            }
+            
+            id task1 = [tasks objectAtIndex:index1];
+            id task2 = [tasks objectAtIndex:index2];
+            if (task1 == [NSNull null] || task2 == [NSNull null]) {
+                continue;
+            }
+            [taskGroup addDependencyForTask:task1 onTask:task2 strong:[[dependency objectAtIndex:2] boolValue]];
+        }
+        
+        [objects addObject:taskGroup];
+    }
+    
+    // Compaction: Replace the file with a new one (written atomically) only recording the replayed objects. Tasks recorded
+    // since the journal was created are not recorded anymore (the journal is meant to be replayed first)
+    [self.fileHandle close];
+    self.fileHandle = nil;
+    CFDictionaryRemoveAllValues(m_taskToEntryMap);
+    m_holdingPreviousRecords = NO;
+    
+    if ([objects count] == 0) {
+        [self removeAllRecords];
+        return [NSArray array];
+    }
+    
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:[objects count]];
+    for (id object in objects) {
+        NSDictionary *item = nil;
+        if ([object isKindOfClass:[HLSTaskGroup class]]) {
+            item = [self itemForTasks:[object topologicallySortedTasks] inTaskGroup:object];
+        }
+        else {
+            item = [self itemForTasks:[NSArray arrayWithObject:object] inTaskGroup:nil];
+        }
+        
+        if (item) {
+            [items addObject:item];
+        }
+    }
+    
+    NSData *compactedData = [self dataForRecord:[NSDictionary dictionaryWithObjectsAndKeys:kTaskJournalRecordTypeSubmission, kTaskJournalRecordTypeKey,
+                                                 items, kTaskJournalRecordItemsKey, nil]];
+    if (! compactedData || ! [self.fileManager createFileAtPath:self.filePath contents:compactedData error:&error]) {
+        HLSLoggerError(@"Could not compact the task journal %@. Reason: %@", self.filePath, error);
+    }
+    
+    HLSLoggerInfo(@"Replayed %d tasks and task groups from the task journal %@", [objects count], self.filePath);
+    return [NSArray arrayWithArray:objects];
+}
+
+#pragma mark Description
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p; filePath: %@; pendingTaskCount: %d>",
+            [self class],
+            self,
+            self.filePath,
+            [self pendingTaskCount]];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSTaskJournalEntry class implementation
+
+@implementation HLSTaskJournalEntry
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.identifier = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize identifier = m_identifier;
+
+@synthesize index = m_index;
+
+@end
+
+#pragma mark Functions
+
+static NSString *HLSTaskJournalNewIdentifier(void)
+{
+    return [[NSProcessInfo processInfo] globallyUniqueString];
+}
+
+static NSDictionary *HLSTaskJournalTaskDescriptor(HLSTask *task)
+{
+    NSString *className = NSStringFromClass([task class]);
+    if (! className) {
+        return nil;
+    }
+    
+    NSMutableDictionary *descriptor = [NSMutableDictionary dictionary];
+    [descriptor setObject:className forKey:kTaskJournalTaskClassNameKey];
+    [descriptor setObject:[NSNumber numberWithInt:task.priority] forKey:kTaskJournalTaskPriorityKey];
+    [descriptor setObject:[NSNumber numberWithDouble:task.timeoutInterval] forKey:kTaskJournalTaskTimeoutIntervalKey];
+    if (task.tag) {
+        [descriptor setObject:task.tag forKey:kTaskJournalTaskTagKey];
+    }
+    if (task.userInfo) {
+        [descriptor setObject:task.userInfo forKey:kTaskJournalTaskUserInfoKey];
+    }
+    if (task.checkpointKey) {
+        [descriptor setObject:task.checkpointKey forKey:kTaskJournalTaskCheckpointKeyKey];
+    }
+    if (task.identityKey) {
+        [descriptor setObject:task.identityKey forKey:kTaskJournalTaskIdentityKeyKey];
+    }
+    return [NSDictionary dictionaryWithDictionary:descriptor];
+}
+
+static HLSTask *HLSTaskJournalTaskFromDescriptor(NSDictionary *descriptor)
+{
+    Class taskClass = NSClassFromString([descriptor objectForKey:kTaskJournalTaskClassNameKey]);
+    if (! [taskClass isSubclassOfClass:[HLSTask class]]) {
+        HLSLoggerError(@"A task journal record does not describe a valid task and has been discarded");
+        return nil;
+    }
+    
+    HLSTask *task = [[[taskClass alloc] init] autorelease];
+    task.durable = YES;
+    task.tag = [descriptor objectForKey:kTaskJournalTaskTagKey];
+    task.priority = [[descriptor objectForKey:kTaskJournalTaskPriorityKey] intValue];
+    task.timeoutInterval = [[descriptor objectForKey:kTaskJournalTaskTimeoutIntervalKey] doubleValue];
+    task.userInfo = [descriptor objectForKey:kTaskJournalTaskUserInfoKey];
+    task.checkpointKey = [descriptor objectForKey:kTaskJournalTaskCheckpointKeyKey];
+    task.identityKey = [descriptor objectForKey:kTaskJournalTaskIdentityKeyKey];
+    return task;
+}
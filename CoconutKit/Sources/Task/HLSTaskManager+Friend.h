@@ -10,6 +10,26 @@
 #import "HLSTaskGroup.h"
 #import "HLSTaskOperation.h"
 
+/**
+ * Optional HLSTaskDelegate methods implemented by a delegate (bit mask)
+ */
+typedef enum {
+    HLSTaskDelegateMethodHasStartedProcessing = 1 << 0,
+    HLSTaskDelegateMethodProgressUpdated = 1 << 1,
+    HLSTaskDelegateMethodHasBeenProcessed = 1 << 2,
+    HLSTaskDelegateMethodHasBeenCancelled = 1 << 3
+} HLSTaskDelegateMethod;
+
+/**
+ * Optional HLSTaskGroupDelegate methods implemented by a delegate (bit mask)
+ */
+typedef enum {
+    HLSTaskGroupDelegateMethodHasStartedProcessing = 1 << 0,
+    HLSTaskGroupDelegateMethodProgressUpdated = 1 << 1,
+    HLSTaskGroupDelegateMethodHasBeenProcessed = 1 << 2,
+    HLSTaskGroupDelegateMethodHasBeenCancelled = 1 << 3
+} HLSTaskGroupDelegateMethod;
+
 @interface HLSTaskManager (Friend)
 
 /**
@@ -20,9 +40,30 @@
 - (void)unregisterOperation:(HLSTaskOperation *)operation;
 
 /**
- * Retrieving registered delegates
+ * Must be called by operations when they end after having been processed (i.e. not cancelled before they could start).
+ * Used to measure throughput
+ */
+- (void)recordProcessedOperation:(HLSTaskOperation *)operation withDuration:(NSTimeInterval)duration;
+
+/**
+ * Must be called by operations when the status of the task they process has changed (start or progress), so that 
+ * duplicate tasks get updated as well
+ */
+- (void)updateDuplicatesOfTask:(HLSTask *)task;
+
+/**
+ * Cancel all tasks directly or transitively depending strongly on a task (which must belong to a task group) in a
+ * single pass. Must be called by operations when they end with an error or are cancelled, before they update the 
+ * status of their task
+ */
+- (void)cancelStrongDependentsOfTask:(HLSTask *)task;
+
+/**
+ * Retrieving registered delegates, as well as the optional delegate methods they implement (HLSTaskDelegateMethod 
+ * or HLSTaskGroupDelegateMethod bit mask, 0 if no delegate). Those are determined once when the delegate is 
+ * registered, so that notifying delegates only requires testing bits
  */
-- (id<HLSTaskDelegate>)delegateForTask:(HLSTask *)task;
-- (id<HLSTaskGroupDelegate>)delegateForTaskGroup:(HLSTaskGroup *)taskGroup;
+- (id<HLSTaskDelegate>)delegateForTask:(HLSTask *)task implementedMethods:(NSUInteger *)pImplementedMethods;
+- (id<HLSTaskGroupDelegate>)delegateForTaskGroup:(HLSTaskGroup *)taskGroup implementedMethods:(NSUInteger *)pImplementedMethods;
 
 @end
@@ -6,9 +6,51 @@
 //  Copyright 2010 Hortis. All rights reserved.
 //
 
+#import "HLSMemoryAccountant.h"
 #import "HLSTask.h"
 #import "HLSTaskGroup.h"
+#import "HLSTaskJournal.h"
+#import "HLSTaskMetrics.h"
+
+/**
+ * Modes for delivering operation notifications (start, progress, attached information, end) on the thread which
+ * submitted the tasks (or on a dispatch queue)
+ */
+typedef enum {
+    HLSTaskNotificationDeliveryModeEnumBegin = 0,
+    HLSTaskNotificationDeliveryModeSynchronous = HLSTaskNotificationDeliveryModeEnumBegin,     // The worker thread waits until each notification has been processed
+    HLSTaskNotificationDeliveryModeAsynchronous,                                                // Notifications are queued in order and processed later
+    HLSTaskNotificationDeliveryModeDispatchQueue,                                               // Same as above, but processed on a dispatch queue
+    HLSTaskNotificationDeliveryModeEnumEnd,
+    HLSTaskNotificationDeliveryModeEnumSize = HLSTaskNotificationDeliveryModeEnumEnd - HLSTaskNotificationDeliveryModeEnumBegin
+} HLSTaskNotificationDeliveryMode;
                 
+/**
+ * States of a task, as reported by task snapshots (a failed task is a task which has been processed but has an error)
+ */
+typedef enum {
+    HLSTaskStateEnumBegin = 0,
+    HLSTaskStatePending = HLSTaskStateEnumBegin,
+    HLSTaskStateRunning,
+    HLSTaskStateSucceeded,
+    HLSTaskStateFailed,
+    HLSTaskStateCancelled,
+    HLSTaskStateEnumEnd,
+    HLSTaskStateEnumSize = HLSTaskStateEnumEnd - HLSTaskStateEnumBegin
+} HLSTaskState;
+
+/**
+ * Immutable copy of the status of a task at some point in time (see -[HLSTaskManager getSnapshots:ofTasks:changedSinceGeneration:])
+ */
+typedef struct {
+    HLSTask *task;                                      // The task (not retained)
+    NSUInteger index;                                   // Index of the task in the array the snapshot was requested for
+    unsigned long long generation;                      // Generation of the task status (see -[HLSTask stateGeneration])
+    HLSTaskState state;
+    float progress;
+    NSTimeInterval remainingTimeIntervalEstimate;
+} HLSTaskSnapshot;
+
 /**
  * Concrete class responsible for instantiating, processing and managing HLSTaskOperation objects spawned for each
  * task submitted to it. Each such object represents a work unit processed by a dedicated thread.
@@ -29,22 +71,84 @@
  *
  * Designated initializer: -init
  */
-@interface HLSTaskManager : NSObject {
+@interface HLSTaskManager : NSObject <HLSMemoryAccounting> {
 @private
     NSOperationQueue *_operationQueue;                   // Manages the separate threads used for task processing
+    NSArray *_priorityOperationQueues;                   // One queue per HLSTaskPriority value (used if usingSeparateQueuesPerPriority)
+    BOOL _usingSeparateQueuesPerPriority;
+    BOOL _adaptingConcurrency;
+    NSInteger _minimumAdaptiveTaskCount;
+    NSInteger _maximumAdaptiveTaskCount;
+    NSInteger _adaptiveTaskCountStep;                    // +1 / -1 / 0 (direction of the last concurrency change)
+    CFAbsoluteTime _samplingStartTime;                   // start of the current throughput sampling window ...
+    NSUInteger _samplingProcessedTaskCount;              // ... number of tasks processed since then ...
+    NSTimeInterval _samplingProcessingTimeInterval;      // ... and their cumulated processing time
+    double _previousSamplingThroughput;                  // throughput measured for the previous window (tasks / s) ...
+    NSTimeInterval _previousSamplingAverageDuration;     // ... and corresponding average task processing time
     NSMutableSet *_tasks;                                // Keep a strong ref to task groups so that they stay alive
     NSMutableSet *_taskGroups;                           // Keep a strong ref to task groups so that they stay alive
-    NSMutableDictionary *_taskToOperationMap;            // Maps a task to the associated HLSTaskOperation object
-    NSMutableDictionary *_taskToDelegateMap;             // Maps a task to the associated id<HLSTaskDelegate> object
-    NSMutableDictionary *_delegateToTasksMap;            // Maps some object id to the NSMutableSet of all HLSTask objects it is the delegate of
-    NSMutableDictionary *_taskGroupToDelegateMap;        // Maps a task group to the associated id<HLSTaskGroupDelegate> object
-    NSMutableDictionary *_delegateToTaskGroupsMap;       // Maps some object id to the NSMutableSet of all HLSTaskGroup objects it is the delegate of
+    // Maps below are keyed by pointer identity (keys are not retained)
+    CFMutableDictionaryRef _taskToOperationMap;          // Maps a task to the associated HLSTaskOperation object
+    CFMutableDictionaryRef _taskToDelegateMap;           // Maps a task to the associated id<HLSTaskDelegate> object
+    CFMutableDictionaryRef _delegateToTasksMap;          // Maps some object id to the NSMutableSet of all HLSTask objects it is the delegate of
+    CFMutableDictionaryRef _taskGroupToDelegateMap;      // Maps a task group to the associated id<HLSTaskGroupDelegate> object
+    CFMutableDictionaryRef _delegateToTaskGroupsMap;     // Maps some object id to the NSMutableSet of all HLSTaskGroup objects it is the delegate of
+    CFMutableDictionaryRef _taskToDelegateMethodsMap;    // Maps a task to the optional methods implemented by its delegate (HLSTaskDelegateMethod mask)
+    CFMutableDictionaryRef _taskGroupToDelegateMethodsMap;   // Same for task groups (HLSTaskGroupDelegateMethod mask)
+    NSMutableDictionary *_identityKeyToTaskMap;          // Maps an identity key to the single task being processed for it
+    CFMutableDictionaryRef _taskToDuplicateTasksMap;     // Maps a task to the NSMutableArray of HLSTask objects mirroring it
+    NSMutableDictionary *_returnInfoCache;               // Maps an identity key to a cache entry
+    NSMutableArray *_returnInfoCacheIdentityKeys;        // Cached identity keys, from the least to the most recently used
+    NSTimeInterval _returnInfoCacheTimeInterval;
+    NSUInteger _returnInfoCacheCapacity;
+    HLSTaskMetrics *_metrics;
+    HLSTaskJournal *_journal;
+    HLSTaskNotificationDeliveryMode _notificationDeliveryMode;
+    dispatch_queue_t _notificationDispatchQueue;
+    NSTimeInterval _progressUpdateMinimumTimeInterval;
+    float _progressUpdateMinimumDelta;
+    BOOL _underMemoryPressure;
+    NSInteger _memoryPressureMaxConcurrentTaskCount;
+    NSTimeInterval _memoryPressureRecoveryTimeInterval;
+    NSInteger _savedMaxConcurrentTaskCount;              // Concurrency settings to restore when memory pressure is gone ...
+    NSInteger _savedPriorityMaxConcurrentTaskCounts[HLSTaskPriorityEnumSize];      // ... for each queue
+    NSOperation *_deferredTaskGroupsGateOperation;       // Unqueued operation which pending deferrable task group operations depend on
+    NSTimer *_memoryPressureRecoveryTimer;
+    // Task deadlines are stored in a timer wheel, i.e. in slots associated with consecutive ticks, a deadline being
+    // stored in the slot of the first tick after it (modulo the number of slots). A single timer visits one slot per
+    // tick, so that the cost of checking deadlines does not depend on the number of tasks with a timeout
+    NSArray *_deadlineWheelSlots;                        // NSMutableSet of HLSTask objects for each slot
+    CFMutableDictionaryRef _taskToDeadlineMap;           // Maps a task with a timeout to its deadline (NSNumber, CFAbsoluteTime)
+    CFAbsoluteTime _deadlineWheelOriginTime;             // Time of tick 0
+    NSUInteger _deadlineWheelTick;                       // Last tick which has been processed
+    NSTimer *_deadlineWheelTimer;                        // Only running while tasks with a timeout are registered
+    BOOL _usingFairShareScheduling;
+    NSMutableDictionary *_tagToHeldOperationsMap;        // Maps a tag (NSNull for untagged tasks) to the NSMutableArray of operations not yet queued
+    CFMutableDictionaryRef _heldOperationToQueueMap;     // Maps an operation not yet queued to the queue it must be added to
+    NSMutableSet *_releasedOperations;                   // Operations queued by the fair-share scheduler and not finished yet
+    NSMutableDictionary *_tagToReleasedOperationCountMap;        // Number of released operations per tag (NSNumber)
+    NSMutableDictionary *_tagToFairShareWeightMap;               // NSNumber
+    NSMutableDictionary *_tagToFairShareCurrentWeightMap;        // NSNumber, see -releaseHeldOperations
+    NSMutableDictionary *_tagToMaxConcurrentTaskCountMap;        // NSNumber
+    BOOL _backgroundExecutionEnabled;
+    NSTimeInterval _backgroundStartMinimumTimeInterval;
+    NSTimeInterval _backgroundPauseTimeInterval;
+    UIBackgroundTaskIdentifier _backgroundTaskIdentifier;        // UIBackgroundTaskInvalid if no background time has been requested
+    NSOperation *_backgroundGateOperation;               // Unqueued operation which operations not started in the background depend on
+    NSMutableArray *_backgroundHeldOperations;           // Operations depending on the background gate operation
+    NSTimer *_backgroundSchedulingTimer;
+    NSMutableArray *_pausedTasks;                        // Tasks paused in the background, to be resubmitted in the foreground
+    CFMutableDictionaryRef _pausedTaskToDelegateMap;     // Maps a paused task to its id<HLSTaskDelegate> (not retained)
 }
 
 /**
  * Returns the default singleton instance. In general this instance should suffice. If you need more task manager
  * instances (in a multi-threaded code, you might e.g. want to assign separate managers to separate threads), you can 
  * create those manually.
+ *
+ * The default instance is registered with the memory accountant (see HLSMemoryAccountant), which clears its return
+ * information cache when memory is purged. Other instances can be registered as well if they are used from the
+ * main thread
  */
 + (HLSTaskManager *)defaultManager;
 
@@ -54,12 +158,253 @@
  */
 - (void)setMaxConcurrentTaskCount:(NSInteger)count;
 
+/**
+ * Return the number of tasks currently allowed to be processed simultaneously (for the queue shared by all priorities),
+ * not taking into account memory pressure throttling
+ */
+- (NSInteger)maxConcurrentTaskCount;
+
+/**
+ * Enable adaptive concurrency. Instead of using a fixed number of concurrent tasks, the manager measures the throughput
+ * of the tasks it processes and adjusts the number of concurrent tasks within the bounds given as parameters (both
+ * must be > 1): The count is raised while throughput improves and tasks are waiting to be processed, and lowered when
+ * throughput degrades or when tasks take longer without any throughput gain (e.g. because I/O-bound tasks are slowed 
+ * down by a bad network connection). Calling
+ * -setMaxConcurrentTaskCount: disables adaptive concurrency.
+ *
+ * Adaptive concurrency only applies to the queue used when usingSeparateQueuesPerPriority is set to NO
+ */
+- (void)enableAdaptiveConcurrencyWithMinimumTaskCount:(NSInteger)minimumTaskCount maximumTaskCount:(NSInteger)maximumTaskCount;
+- (void)disableAdaptiveConcurrency;
+
+/**
+ * Return YES iff adaptive concurrency is enabled
+ */
+@property (nonatomic, readonly, assign, getter=isAdaptingConcurrency) BOOL adaptingConcurrency;
+
+/**
+ * By default all tasks are processed by the same pool of threads, higher priority tasks being simply scheduled first.
+ * Since running tasks are never preempted, lower priority work might still delay higher priority tasks. If this
+ * property is set to YES, each priority class gets its own pool of threads instead, whose size can be set using
+ * -setMaxConcurrentTaskCount:forPriority: (default is 4 for each priority). This ensures that interactive work is 
+ * never starved by background processing.
+ *
+ * This setting only affects tasks submitted after it has been changed. Default value is NO
+ */
+@property (nonatomic, assign, getter=isUsingSeparateQueuesPerPriority) BOOL usingSeparateQueuesPerPriority;
+
+/**
+ * Change the number of tasks with a given priority processed simultaneously when separate queues are used for
+ * each priority class. Default is 4. This setting does not affect already running operations
+ */
+- (void)setMaxConcurrentTaskCount:(NSInteger)count forPriority:(HLSTaskPriority)priority;
+
+/**
+ * By default operations are added to the queues as soon as tasks are submitted, and are started in submission order
+ * (by priority). A feature submitting many tasks at once therefore delays the tasks of all other features. If this 
+ * property is set to YES, the task manager keeps operations to itself and only hands a new one to the queues when 
+ * fewer than maxConcurrentTaskCount operations are processed. The next operation is picked among tags in a 
+ * (weighted) round-robin fashion, the tag of a task being its own tag or, if it has none, the tag of its task group. 
+ * Untagged tasks share one slot of the round-robin. Within a tag, operations are started by priority, then in 
+ * submission order, an operation being considered only when all the operations it depends on are done.
+ *
+ * Setting this property to NO hands all operations kept so far to the queues. Default value is NO
+ */
+@property (nonatomic, assign, getter=isUsingFairShareScheduling) BOOL usingFairShareScheduling;
+
+/**
+ * Set the weight of a tag for fair-share scheduling (default is 1 for all tags). A tag with weight 2 gets twice as many
+ * operations started as a tag with weight 1 when both have tasks waiting. Use nil for untagged tasks
+ */
+- (void)setFairShareWeight:(NSUInteger)weight forTag:(NSString *)tagOrNil;
+
+/**
+ * Limit the number of tasks with a tag processed simultaneously (e.g. at most 2 uploads). A count of 0 (default) 
+ * removes the limit. Use nil for the untagged tasks. Limits are only applied when fair-share scheduling is enabled
+ */
+- (void)setMaxConcurrentTaskCount:(NSUInteger)count forTag:(NSString *)tagOrNil;
+
+/**
+ * The way operations deliver their notifications to the thread which submitted the tasks. Default value is
+ * HLSTaskNotificationDeliveryModeSynchronous, which means that worker threads are blocked until each notification
+ * (e.g. a progress update) has been processed.
+ *
+ * With HLSTaskNotificationDeliveryModeAsynchronous, each operation stores its notifications in a FIFO queue which is
+ * drained on the calling thread. Notifications are still received in the order they were emitted, but worker threads
+ * never wait for them to be processed, except when an operation ends: The end notification is always processed before 
+ * the operation is considered finished, so that task dependencies are honored as in the synchronous mode.
+ *
+ * HLSTaskNotificationDeliveryModeDispatchQueue works like the asynchronous mode, but notifications are processed in
+ * batches on notificationDispatchQueue instead of the thread which submitted the tasks. This thread therefore does not
+ * need a running run loop, which makes it possible to submit tasks from a background dispatch queue. In this mode, the 
+ * task manager must itself only be used from notificationDispatchQueue (which must be a serial queue)
+ *
+ * This setting only affects tasks submitted after it has been changed
+ */
+@property (nonatomic, assign) HLSTaskNotificationDeliveryMode notificationDeliveryMode;
+
+/**
+ * The serial dispatch queue on which notifications are processed when using HLSTaskNotificationDeliveryModeDispatchQueue.
+ * Default is the main queue. Setting it to NULL restores the main queue. The queue is retained
+ *
+ * This setting only affects tasks submitted after it has been changed
+ */
+@property (nonatomic, assign) dispatch_queue_t notificationDispatchQueue;
+
+/**
+ * Progress update coalescing. When an operation reports progress faster than these thresholds, intermediate values
+ * are dropped and only the latest one is delivered to the task and task group delegates. A progress update is delivered
+ * only if at least progressUpdateMinimumTimeInterval seconds have elapsed since the previous delivered one, and if the
+ * progress has changed by at least progressUpdateMinimumDelta. Start and end notifications, as well as 1.f progress
+ * values, are always delivered. A value which has been dropped and not superseded when an operation ends is delivered
+ * before the end notification.
+ *
+ * Both values default to 0, i.e. all progress updates are delivered. Negative values are fixed to 0. These settings
+ * only affect tasks submitted after they have been changed
+ */
+@property (nonatomic, assign) NSTimeInterval progressUpdateMinimumTimeInterval;
+@property (nonatomic, assign) float progressUpdateMinimumDelta;
+
+/**
+ * Memory pressure handling. When the application receives a memory warning, the task manager:
+ *   - lowers the number of tasks processed simultaneously to memoryPressureMaxConcurrentTaskCount (for all queues),
+ *     so that fewer tasks allocate memory at the same time. Running operations are not affected
+ *   - calls -operationDidReceiveMemoryWarning on all pending and running operations, so that they can release caches
+ *   - holds back the pending tasks of task groups marked as deferrable (see -[HLSTaskGroup deferrable])
+ *
+ * Since the system does not notify when memory pressure is gone, normal processing resumes once no memory warning 
+ * has been received during memoryPressureRecoveryTimeInterval seconds. Concurrency changes made in the meantime 
+ * (e.g. using -setMaxConcurrentTaskCount:) are applied at this point. Defaults are 1 task and 10 seconds. Adaptive
+ * concurrency is suspended while under memory pressure. Memory warnings are received on the main thread, this
+ * mechanism is therefore only available for task managers used from the main thread
+ */
+@property (nonatomic, assign) NSInteger memoryPressureMaxConcurrentTaskCount;
+@property (nonatomic, assign) NSTimeInterval memoryPressureRecoveryTimeInterval;
+
+/**
+ * Background execution. When set to YES and the application enters the background while tasks are pending, the task
+ * manager asks for background execution time, so that tasks are not suspended midway. The granted time is spent on
+ * the tasks which are the closest to finishing:
+ *   - tasks which are running are left running
+ *   - tasks which have not been started are held back. While more than backgroundStartMinimumTimeInterval seconds of 
+ *     background time remain, they are started as running tasks free slots, tasks resumed from a checkpoint and tasks 
+ *     with a higher priority first
+ *   - when backgroundPauseTimeInterval seconds remain, running single tasks which have a checkpoint key and are not
+ *     expected to finish in time (see -[HLSTask remainingTimeIntervalEstimate]) are paused: They are cancelled (their
+ *     delegate receives the taskHasBeenCancelled: event as usual and their last checkpoint is kept), and resubmitted
+ *     from their last checkpoint, with the same delegate, when the application returns to the foreground
+ * Background time is given back as soon as no task is running anymore, and when the application returns to the 
+ * foreground, where held tasks are released. Defaults are NO, 30 seconds and 10 seconds. Background notifications are 
+ * received on the main thread, this mechanism is therefore only available for task managers used from the main thread
+ */
+@property (nonatomic, assign, getter=isBackgroundExecutionEnabled) BOOL backgroundExecutionEnabled;
+@property (nonatomic, assign) NSTimeInterval backgroundStartMinimumTimeInterval;
+@property (nonatomic, assign) NSTimeInterval backgroundPauseTimeInterval;
+
+/**
+ * Return YES iff the task manager is currently using background execution time
+ */
+@property (nonatomic, readonly, assign, getter=isExecutingInBackground) BOOL executingInBackground;
+
+/**
+ * Return YES iff the task manager currently throttles tasks because of a memory warning
+ */
+@property (nonatomic, readonly, assign, getter=isUnderMemoryPressure) BOOL underMemoryPressure;
+
+/**
+ * Return information cache for tasks with an identity key (see HLSTask.h). When a single task with an identity key has
+ * been successfully processed and has attached return information, this information is cached for 
+ * returnInfoCacheTimeInterval seconds. Submitting a task with the same identity key during this time interval does
+ * not process it again: The task immediately completes with the cached return information (the corresponding delegate
+ * events are received synchronously during the call to -submitTask:).
+ *
+ * At most returnInfoCacheCapacity entries are kept (the least recently used ones are discarded first). The cache is 
+ * disabled by default (returnInfoCacheTimeInterval = 0); default capacity is 20
+ */
+@property (nonatomic, assign) NSTimeInterval returnInfoCacheTimeInterval;
+@property (nonatomic, assign) NSUInteger returnInfoCacheCapacity;
+
+/**
+ * Remove all entries from the return information cache
+ */
+- (void)clearReturnInfoCache;
+
+/**
+ * When set to YES, timestamps are recorded for each task and task group submitted afterwards (submission, start and 
+ * end of processing, completion and time spent notifying delegates), and are made available through the metrics 
+ * property. Setting this property to NO discards all metrics collected so far. Default is NO
+ */
+@property (nonatomic, assign, getter=isMetricsEnabled) BOOL metricsEnabled;
+
+/**
+ * The metrics collected for tasks and task groups, nil if metrics are not enabled
+ */
+@property (nonatomic, readonly, retain) HLSTaskMetrics *metrics;
+
+/**
+ * Return the number of tasks which have been submitted and have not ended yet (waiting to be processed or running).
+ * Must be called from the thread the task manager is used from
+ */
+- (NSUInteger)pendingTaskCount;
+
+/**
+ * Return the most recent task status generation. Save this value when fetching snapshots, and use it the next time
+ * snapshots are fetched to only get the tasks which have changed in the meantime
+ */
+- (unsigned long long)taskStateGeneration;
+
+/**
+ * Fill the snapshots buffer (which must be able to store as many snapshots as there are tasks in the array) with
+ * the status of those tasks whose generation is greater than the one specified, and return the number of snapshots
+ * written. Call this method with a generation of 0 to get snapshots for all tasks. This is meant for interfaces 
+ * displaying the status of many tasks, which can refresh only the tasks which have changed since the previous
+ * refresh (each snapshot includes the index of the task). Must be called from the thread the task manager
+ * is used from
+ */
+- (NSUInteger)getSnapshots:(HLSTaskSnapshot *)snapshots ofTasks:(NSArray *)tasks changedSinceGeneration:(unsigned long long)generation;
+
 /**
  * Submit a single task; if you have several tasks to process, consider bundling them as a task group, and use
  * submitTaskGroup: instead
  */
 - (void)submitTask:(HLSTask *)task;
 
+/**
+ * Submit several independent tasks at once. Equivalent to calling -submitTask: for each task, but operations are 
+ * registered in a single pass and added to the queues together
+ */
+- (void)submitTasks:(NSArray *)tasks;
+
+/**
+ * Recreate all tasks for which a checkpoint has been saved and which are not currently running or pending (see 
+ * -[HLSTask checkpointKey]), register them with the specified delegate (can be nil) and submit them. Operations
+ * can then resume from the last checkpoint. Usually called at application startup. Returns the submitted tasks
+ */
+- (NSArray *)submitCheckpointedTasksWithDelegate:(id<HLSTaskDelegate>)delegate;
+
+/**
+ * Remove all saved checkpoints. Tasks which are running might save new ones
+ */
+- (void)discardCheckpoints;
+
+/**
+ * The journal in which durable tasks and task groups (see -[HLSTask durable] and -[HLSTaskGroup durable]) are recorded
+ * when submitted, until they end (whether they have been processed, have failed or have been cancelled). Pending
+ * uploads, for example, are therefore not lost if the application is terminated: Attach a journal with the same file
+ * path at the next launch, and call -submitJournaledTasksWithDelegate:taskGroupDelegate: before submitting any task.
+ * Default is nil (no tasks are recorded)
+ */
+@property (nonatomic, retain) HLSTaskJournal *journal;
+
+/**
+ * Recreate all single tasks and task groups recorded in the journal which had not ended when the application was
+ * terminated, register them with the specified delegates (can be nil) and submit them right away (single tasks are 
+ * submitted together, see -submitTasks:). Task groups only contain the tasks which had not ended, and the dependencies
+ * between them. Tasks having a checkpoint resume from it. Must be called before submitting tasks and before calling
+ * -submitCheckpointedTasksWithDelegate:. Returns the submitted tasks and task groups
+ */
+- (NSArray *)submitJournaledTasksWithDelegate:(id<HLSTaskDelegate>)delegate taskGroupDelegate:(id<HLSTaskGroupDelegate>)taskGroupDelegate;
+
 /**
  * Submit a task group
  */
@@ -70,6 +415,13 @@
  */
 - (void)cancelTask:(HLSTask *)task;
 
+/**
+ * Cancel several tasks at once. Equivalent to calling -cancelTask: for each task, but pending tasks (and the tasks 
+ * strongly depending on them) are processed in a single pass, and the status of the task groups involved is only
+ * updated and notified once. The methods below cancelling tasks by tag or delegate use this method
+ */
+- (void)cancelTasks:(NSArray *)tasks;
+
 /**
  * Cancel a task group
  */
@@ -8,32 +8,177 @@
 
 #import "HLSTaskManager.h"
 
+#import "HLSFloat.h"
 #import "HLSLogger.h"
 #import "HLSTask+Friend.h"
+#import "HLSTask+HLSContinuations.h"
 #import "HLSTaskGroup+Friend.h"
+#import "HLSTaskJournal+Friend.h"
+#import "HLSTaskManager+Friend.h"
+#import "HLSTaskMetrics+Friend.h"
 #import "HLSTaskOperation.h"
+#import "HLSTaskOperation+Protected.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
+
+// Create a mutable dictionary comparing keys by pointer identity, without retaining them (values are retained)
+static CFMutableDictionaryRef HLSPointerIdentityMapCreate(void)
+{
+    return CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+}
+
+// Return the optional HLSTaskDelegate methods implemented by a delegate (HLSTaskDelegateMethod mask)
+static NSUInteger HLSTaskDelegateImplementedMethods(id<HLSTaskDelegate> delegate)
+{
+    NSUInteger implementedMethods = 0;
+    if ([delegate respondsToSelector:@selector(taskHasStartedProcessing:)]) {
+        implementedMethods |= HLSTaskDelegateMethodHasStartedProcessing;
+    }
+    if ([delegate respondsToSelector:@selector(taskProgressUpdated:)]) {
+        implementedMethods |= HLSTaskDelegateMethodProgressUpdated;
+    }
+    if ([delegate respondsToSelector:@selector(taskHasBeenProcessed:)]) {
+        implementedMethods |= HLSTaskDelegateMethodHasBeenProcessed;
+    }
+    if ([delegate respondsToSelector:@selector(taskHasBeenCancelled:)]) {
+        implementedMethods |= HLSTaskDelegateMethodHasBeenCancelled;
+    }
+    return implementedMethods;
+}
+
+// Return the optional HLSTaskGroupDelegate methods implemented by a delegate (HLSTaskGroupDelegateMethod mask)
+static NSUInteger HLSTaskGroupDelegateImplementedMethods(id<HLSTaskGroupDelegate> delegate)
+{
+    NSUInteger implementedMethods = 0;
+    if ([delegate respondsToSelector:@selector(taskGroupHasStartedProcessing:)]) {
+        implementedMethods |= HLSTaskGroupDelegateMethodHasStartedProcessing;
+    }
+    if ([delegate respondsToSelector:@selector(taskGroupProgressUpdated:)]) {
+        implementedMethods |= HLSTaskGroupDelegateMethodProgressUpdated;
+    }
+    if ([delegate respondsToSelector:@selector(taskGroupHasBeenProcessed:)]) {
+        implementedMethods |= HLSTaskGroupDelegateMethodHasBeenProcessed;
+    }
+    if ([delegate respondsToSelector:@selector(taskGroupHasBeenCancelled:)]) {
+        implementedMethods |= HLSTaskGroupDelegateMethodHasBeenCancelled;
+    }
+    return implementedMethods;
+}
+
+// Minimum number of processed tasks and duration of a throughput sampling window
+static const NSUInteger kAdaptiveSamplingMinimumTaskCount = 8;
+static const NSTimeInterval kAdaptiveSamplingMinimumTimeInterval = 0.5;
+
+// Relative throughput change below which two measurements are considered equivalent
+static const double kAdaptiveThroughputTolerance = 0.05;
+
+// Task deadline timer wheel: number of slots and tick duration. Deadlines farther away than a full wheel rotation
+// are stored in the slot of their tick modulo the number of slots, and are simply skipped until they are reached
+static const NSUInteger kDeadlineWheelSlotCount = 64;
+static const NSTimeInterval kDeadlineWheelTickTimeInterval = 0.1;
+
+// Time between two background scheduling decisions
+static const NSTimeInterval kBackgroundSchedulingTimeInterval = 1.;
+
+// Rough estimates of the memory used by a pending task and by a return information cache entry
+static const NSUInteger kTaskMemoryFootprint = 512;
+static const NSUInteger kReturnInfoCacheEntryMemoryFootprint = 1024;
+
+// Return information cache entry keys
+static NSString * const kReturnInfoCacheDateKey = @"date";
+static NSString * const kReturnInfoCacheReturnInfoKey = @"returnInfo";
 
 @interface HLSTaskManager ()
 
 @property (nonatomic, retain) NSOperationQueue *operationQueue;
+@property (nonatomic, retain) NSArray *priorityOperationQueues;
+@property (nonatomic, assign, getter=isAdaptingConcurrency) BOOL adaptingConcurrency;
+@property (nonatomic, retain) NSMutableDictionary *identityKeyToTaskMap;
+@property (nonatomic, retain) NSMutableDictionary *returnInfoCache;
+@property (nonatomic, retain) NSMutableArray *returnInfoCacheIdentityKeys;
+@property (nonatomic, retain) HLSTaskMetrics *metrics;
 @property (nonatomic, retain) NSMutableSet *tasks;
 @property (nonatomic, retain) NSMutableSet *taskGroups;
-@property (nonatomic, retain) NSMutableDictionary *taskToOperationMap;
-@property (nonatomic, retain) NSMutableDictionary *taskToDelegateMap;
-@property (nonatomic, retain) NSMutableDictionary *delegateToTasksMap;
-@property (nonatomic, retain) NSMutableDictionary *taskGroupToDelegateMap;
-@property (nonatomic, retain) NSMutableDictionary *delegateToTaskGroupsMap;
+@property (nonatomic, assign, getter=isUnderMemoryPressure) BOOL underMemoryPressure;
+@property (nonatomic, retain) NSOperation *deferredTaskGroupsGateOperation;
+@property (nonatomic, retain) NSTimer *memoryPressureRecoveryTimer;
+@property (nonatomic, retain) NSArray *deadlineWheelSlots;
+@property (nonatomic, retain) NSTimer *deadlineWheelTimer;
+@property (nonatomic, retain) NSMutableDictionary *tagToHeldOperationsMap;
+@property (nonatomic, retain) NSMutableSet *releasedOperations;
+@property (nonatomic, retain) NSMutableDictionary *tagToReleasedOperationCountMap;
+@property (nonatomic, retain) NSMutableDictionary *tagToFairShareWeightMap;
+@property (nonatomic, retain) NSMutableDictionary *tagToFairShareCurrentWeightMap;
+@property (nonatomic, retain) NSMutableDictionary *tagToMaxConcurrentTaskCountMap;
+@property (nonatomic, retain) NSOperation *backgroundGateOperation;
+@property (nonatomic, retain) NSMutableArray *backgroundHeldOperations;
+@property (nonatomic, retain) NSTimer *backgroundSchedulingTimer;
+@property (nonatomic, retain) NSMutableArray *pausedTasks;
 
-- (NSSet *)operationsForTasks:(NSSet *)tasks;
+- (HLSTaskOperation *)operationForTask:(HLSTask *)task;
+
+- (BOOL)isValidMaxConcurrentTaskCount:(NSInteger)count;
+- (void)scheduleOperations:(NSArray *)operations withPriority:(HLSTaskPriority)priority;
+
+- (id)fairShareTagKeyForOperation:(HLSTaskOperation *)operation;
+- (void)holdOperation:(HLSTaskOperation *)operation forQueue:(NSOperationQueue *)operationQueue;
+- (BOOL)isHeldOperationReady:(HLSTaskOperation *)operation;
+- (void)releaseHeldOperations;
+- (void)releaseHeldOperation:(HLSTaskOperation *)operation;
+- (void)releaseAllHeldOperations;
+- (void)removeOperationFromFairShareScheduler:(HLSTaskOperation *)operation;
+
+- (void)resetAdaptiveSampling;
+- (void)adaptConcurrency;
+
+- (void)deferOperations:(NSArray *)operations;
+- (void)memoryPressureRecoveryTimerFired:(NSTimer *)timer;
+
+- (void)beginBackgroundExecution;
+- (void)endBackgroundExecution;
+- (void)holdOperationsInBackground:(NSArray *)operations;
+- (void)releaseBackgroundHeldOperations;
+- (void)pauseTasksNotFinishingInTimeInterval:(NSTimeInterval)timeInterval;
+- (void)removePausedTask:(HLSTask *)task;
+- (void)resumePausedTasks;
+- (void)backgroundSchedulingTimerFired:(NSTimer *)timer;
+
+- (NSMutableSet *)deadlineWheelSlotForTime:(CFAbsoluteTime)time;
+- (void)scheduleDeadlineForTask:(HLSTask *)task;
+- (void)unscheduleDeadlineForTask:(HLSTask *)task;
+- (void)deadlineWheelTimerFired:(NSTimer *)timer;
 
 - (void)registerOperation:(HLSTaskOperation *)operation;
 - (void)unregisterOperation:(HLSTaskOperation *)operation;
 
+- (HLSTaskOperation *)registeredOperationForSubmittedTask:(HLSTask *)task;
+- (NSArray *)registeredOperationsForContinuationsOfOperation:(HLSTaskOperation *)operation;
+
+- (void)cancelStrongDependentsOfTask:(HLSTask *)task;
+- (NSArray *)pendingOperationsForStrongDependentsOfTask:(HLSTask *)task;
+- (void)cancelPendingOperations:(NSArray *)operations;
+- (void)cancelTaskGroups:(NSArray *)taskGroups;
+
+- (void)registerDuplicateTask:(HLSTask *)duplicateTask forTask:(HLSTask *)task;
+- (BOOL)cancelDuplicateTask:(HLSTask *)duplicateTask;
+- (void)updateDuplicatesOfTask:(HLSTask *)task;
+- (void)endDuplicatesOfTask:(HLSTask *)task;
+- (void)endTask:(HLSTask *)task mirroringTask:(HLSTask *)mirroredTask;
+
+- (NSDictionary *)cachedReturnInfoForIdentityKey:(NSString *)identityKey;
+- (void)cacheReturnInfo:(NSDictionary *)returnInfo forIdentityKey:(NSString *)identityKey;
+- (void)processTask:(HLSTask *)task withCachedReturnInfo:(NSDictionary *)returnInfo;
+
 - (void)registerTaskGroup:(HLSTaskGroup *)taskGroup;
 - (void)unregisterTaskGroup:(HLSTaskGroup *)taskGroup;
 
-- (id<HLSTaskDelegate>)delegateForTask:(HLSTask *)task;
-- (id<HLSTaskGroupDelegate>)delegateForTaskGroup:(HLSTaskGroup *)taskGroup;
+- (id<HLSTaskDelegate>)delegateForTask:(HLSTask *)task implementedMethods:(NSUInteger *)pImplementedMethods;
+- (id<HLSTaskGroupDelegate>)delegateForTaskGroup:(HLSTaskGroup *)taskGroup implementedMethods:(NSUInteger *)pImplementedMethods;
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification;
+- (void)applicationDidEnterBackground:(NSNotification *)notification;
+- (void)applicationWillEnterForeground:(NSNotification *)notification;
 
 @end
 
@@ -47,6 +192,9 @@
     static HLSTaskManager *s_instance = nil;
     if (! s_instance) {
         s_instance = [[HLSTaskManager alloc] init];
+        [[HLSMemoryAccountant sharedMemoryAccountant] registerSubsystem:s_instance
+                                                               withName:@"Default task manager"
+                                                          purgePriority:HLSMemoryPurgePriorityTaskManager];
     }
     return s_instance;
 }
@@ -60,27 +208,127 @@
         self.operationQueue = [[[NSOperationQueue alloc] init] autorelease];
         [self setMaxConcurrentTaskCount:4];
         [self.operationQueue setMaxConcurrentOperationCount:4];
+        
+        // Threads are spawned lazily by operation queues, unused queues are therefore cheap
+        NSMutableArray *priorityOperationQueues = [NSMutableArray array];
+        for (NSUInteger i = 0; i < HLSTaskPriorityEnumSize; ++i) {
+            NSOperationQueue *priorityOperationQueue = [[[NSOperationQueue alloc] init] autorelease];
+            [priorityOperationQueue setMaxConcurrentOperationCount:4];
+            [priorityOperationQueues addObject:priorityOperationQueue];
+        }
+        self.priorityOperationQueues = [NSArray arrayWithArray:priorityOperationQueues];
         self.tasks = [NSMutableSet set];
         self.taskGroups = [NSMutableSet set];
-        self.taskToOperationMap = [NSMutableDictionary dictionary];
-        self.taskToDelegateMap = [NSMutableDictionary dictionary];
-        self.delegateToTasksMap =[NSMutableDictionary dictionary];
-        self.taskGroupToDelegateMap = [NSMutableDictionary dictionary];
-        self.delegateToTaskGroupsMap = [NSMutableDictionary dictionary];
+        _taskToOperationMap = HLSPointerIdentityMapCreate();
+        _taskToDelegateMap = HLSPointerIdentityMapCreate();
+        _delegateToTasksMap = HLSPointerIdentityMapCreate();
+        _taskGroupToDelegateMap = HLSPointerIdentityMapCreate();
+        _delegateToTaskGroupsMap = HLSPointerIdentityMapCreate();
+        // Values are plain bit masks
+        _taskToDelegateMethodsMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+        _taskGroupToDelegateMethodsMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+        _taskToDuplicateTasksMap = HLSPointerIdentityMapCreate();
+        _taskToDeadlineMap = HLSPointerIdentityMapCreate();
+        _heldOperationToQueueMap = HLSPointerIdentityMapCreate();
+        self.tagToHeldOperationsMap = [NSMutableDictionary dictionary];
+        self.releasedOperations = [NSMutableSet set];
+        self.tagToReleasedOperationCountMap = [NSMutableDictionary dictionary];
+        self.tagToFairShareWeightMap = [NSMutableDictionary dictionary];
+        self.tagToFairShareCurrentWeightMap = [NSMutableDictionary dictionary];
+        self.tagToMaxConcurrentTaskCountMap = [NSMutableDictionary dictionary];
+        _backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+        self.backgroundHeldOperations = [NSMutableArray array];
+        self.pausedTasks = [NSMutableArray array];
+        // Delegates are not retained
+        _pausedTaskToDelegateMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+        
+        NSMutableArray *deadlineWheelSlots = [NSMutableArray arrayWithCapacity:kDeadlineWheelSlotCount];
+        for (NSUInteger i = 0; i < kDeadlineWheelSlotCount; ++i) {
+            [deadlineWheelSlots addObject:[NSMutableSet set]];
+        }
+        self.deadlineWheelSlots = [NSArray arrayWithArray:deadlineWheelSlots];
+        _deadlineWheelOriginTime = CFAbsoluteTimeGetCurrent();
+        
+        self.identityKeyToTaskMap = [NSMutableDictionary dictionary];
+        self.returnInfoCache = [NSMutableDictionary dictionary];
+        self.returnInfoCacheIdentityKeys = [NSMutableArray array];
+        self.returnInfoCacheCapacity = 20;
+        self.notificationDeliveryMode = HLSTaskNotificationDeliveryModeSynchronous;
+        self.notificationDispatchQueue = NULL;
+        self.memoryPressureMaxConcurrentTaskCount = 1;
+        self.memoryPressureRecoveryTimeInterval = 10.;
+        self.backgroundStartMinimumTimeInterval = 30.;
+        self.backgroundPauseTimeInterval = 10.;
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationDidReceiveMemoryWarning:)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationDidEnterBackground:)
+                                                     name:UIApplicationDidEnterBackgroundNotification
+                                                   object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationWillEnterForeground:)
+                                                     name:UIApplicationWillEnterForegroundNotification
+                                                   object:nil];
     }
     return self;
 }
 
 - (void)dealloc
 {
+    [[HLSMemoryAccountant sharedMemoryAccountant] unregisterSubsystem:self];
+    
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationDidReceiveMemoryWarningNotification
+                                                  object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationDidEnterBackgroundNotification
+                                                  object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationWillEnterForegroundNotification
+                                                  object:nil];
+    
+    if (_backgroundTaskIdentifier != UIBackgroundTaskInvalid) {
+        [[UIApplication sharedApplication] endBackgroundTask:_backgroundTaskIdentifier];
+    }
+    
     self.operationQueue = nil;
+    self.priorityOperationQueues = nil;
     self.tasks = nil;
     self.taskGroups = nil;
-    self.taskToOperationMap = nil;
-    self.taskToDelegateMap = nil;
-    self.delegateToTasksMap = nil;
-    self.taskGroupToDelegateMap = nil;
-    self.delegateToTaskGroupsMap = nil;
+    CFRelease(_taskToOperationMap);
+    CFRelease(_taskToDelegateMap);
+    CFRelease(_delegateToTasksMap);
+    CFRelease(_taskGroupToDelegateMap);
+    CFRelease(_delegateToTaskGroupsMap);
+    CFRelease(_taskToDelegateMethodsMap);
+    CFRelease(_taskGroupToDelegateMethodsMap);
+    CFRelease(_taskToDuplicateTasksMap);
+    CFRelease(_taskToDeadlineMap);
+    CFRelease(_heldOperationToQueueMap);
+    self.tagToHeldOperationsMap = nil;
+    self.releasedOperations = nil;
+    self.tagToReleasedOperationCountMap = nil;
+    self.tagToFairShareWeightMap = nil;
+    self.tagToFairShareCurrentWeightMap = nil;
+    self.tagToMaxConcurrentTaskCountMap = nil;
+    self.deadlineWheelSlots = nil;
+    self.deadlineWheelTimer = nil;
+    self.identityKeyToTaskMap = nil;
+    self.returnInfoCache = nil;
+    self.returnInfoCacheIdentityKeys = nil;
+    self.metrics = nil;
+    self.journal = nil;
+    dispatch_release(_notificationDispatchQueue);
+    self.deferredTaskGroupsGateOperation = nil;
+    self.memoryPressureRecoveryTimer = nil;
+    self.backgroundGateOperation = nil;
+    self.backgroundHeldOperations = nil;
+    self.backgroundSchedulingTimer = nil;
+    self.pausedTasks = nil;
+    CFRelease(_pausedTaskToDelegateMap);
     [super dealloc];
 }
 
@@ -89,407 +337,1610 @@
 
 @synthesize operationQueue = _operationQueue;
 
-@synthesize tasks = _tasks;
+@synthesize priorityOperationQueues = _priorityOperationQueues;
 
-@synthesize taskGroups = _taskGroups;
+@synthesize usingSeparateQueuesPerPriority = _usingSeparateQueuesPerPriority;
 
-@synthesize taskToOperationMap = _taskToOperationMap;
+@synthesize adaptingConcurrency = _adaptingConcurrency;
 
-@synthesize taskToDelegateMap = _taskToDelegateMap;
+@synthesize identityKeyToTaskMap = _identityKeyToTaskMap;
 
-@synthesize delegateToTasksMap = _delegateToTasksMap;
+@synthesize returnInfoCache = _returnInfoCache;
 
-@synthesize taskGroupToDelegateMap = _taskGroupToDelegateMap;
+@synthesize returnInfoCacheIdentityKeys = _returnInfoCacheIdentityKeys;
 
-@synthesize delegateToTaskGroupsMap = _delegateToTaskGroupsMap;
+@synthesize returnInfoCacheTimeInterval = _returnInfoCacheTimeInterval;
 
-- (void)setMaxConcurrentTaskCount:(NSInteger)count
+@synthesize returnInfoCacheCapacity = _returnInfoCacheCapacity;
+
+- (BOOL)isMetricsEnabled
 {
-    // Remark: It seems that with the recommended setting NSOperationQueueDefaultMaxConcurrentOperationCount (which
-    //         lets the OS decide dynamically how many threads are needed), dependencies betweeen NSOperation objects
-    //         are not applied anymore (bug?). Anyway, this does not work correctly, so we fix the number of threads
-    //         to a seemingly good value
-    if (count == NSOperationQueueDefaultMaxConcurrentOperationCount) {
-        HLSLoggerWarn(@"Dynamic number of concurrent tasks is currently not working correctly; task count not changed");
-    }
-    else if (count > 1) {
-        [self.operationQueue setMaxConcurrentOperationCount:count];
-    }
-    else {
-        HLSLoggerError(@"Invalid number of concurrent tasks; task count not changed");
-    }
+    return self.metrics != nil;
 }
 
-#pragma mark -
-#pragma mark Submitting tasks
-
-- (void)submitTask:(HLSTask *)task
+- (void)setMetricsEnabled:(BOOL)metricsEnabled
 {
-    // Cannot submit a task if already running
-    if ([self.tasks containsObject:task]) {
-        HLSLoggerWarn(@"Cannot submit a task which is already running");
+    if (metricsEnabled == self.metricsEnabled) {
         return;
     }
     
-    // Get the corresponding operations
-    NSSet *operations = [self operationsForTasks:[NSSet setWithObject:task]];
-    
-    // Register and schedule all operations
-    for (HLSTaskOperation *operation in operations) {
-        [self registerOperation:operation];
-        [self.operationQueue addOperation:operation];
-    }
+    self.metrics = metricsEnabled ? [[[HLSTaskMetrics alloc] init] autorelease] : nil;
 }
 
-- (void)submitTaskGroup:(HLSTaskGroup *)taskGroup
+@synthesize metrics = _metrics;
+
+@synthesize journal = _journal;
+
+- (void)setReturnInfoCacheCapacity:(NSUInteger)returnInfoCacheCapacity
 {
-    // Cannot submit a task if already running
-    if ([self.taskGroups containsObject:taskGroup]) {
-        HLSLoggerWarn(@"Cannot submit a task group which is already running");
-        return;
-    }
-    
-    // Reset status
-    [taskGroup reset];
-    
-    // If no operation in the task group, we are already done; update the status accordingly and simulate events
-    if ([[taskGroup tasks] count] == 0) {
-        id<HLSTaskGroupDelegate> taskGroupDelegate = [self delegateForTaskGroup:taskGroup];
-        if (taskGroupDelegate) {
-            if ([taskGroupDelegate respondsToSelector:@selector(taskGroupHasStartedProcessing:)]) {
-                [taskGroupDelegate taskGroupHasStartedProcessing:taskGroup];
-            }
-            
-            if ([taskGroupDelegate respondsToSelector:@selector(taskGroupHasBeenProcessed:)]) {
-                [taskGroupDelegate taskGroupHasBeenProcessed:taskGroup];
-            }            
-        }
-        
-        taskGroup.finished = YES;
-        return;
-    }    
-    
-    // Get the corresponding operations
-    NSSet *operations = [self operationsForTasks:[taskGroup tasks]];
-    
-    // Register all operations
-    for (HLSTaskOperation *operation in operations) {
-        [self registerOperation:operation];
-    }
-    
-    // Apply task group dependencies
-    for (HLSTask *task in [taskGroup tasks]) {
-        // Get dependencies if any
-        NSSet *dependencyTasks = [taskGroup dependenciesForTask:task];
-        if ([dependencyTasks count] == 0) {
-            continue;
-        }
-        
-        // Retrieve the corresponding operation
-        NSValue *taskKey = [NSValue valueWithPointer:task];
-        HLSTaskOperation *operation = [self.taskToOperationMap objectForKey:taskKey];
-        
-        // Set dependencies
-        for (HLSTask *dependencyTask in dependencyTasks) {
-            // Get the dependency operation
-            NSValue *dependencyTaskKey = [NSValue valueWithPointer:dependencyTask];
-            HLSTaskOperation *dependencyOperation = [self.taskToOperationMap objectForKey:dependencyTaskKey];
-            if (! dependencyOperation) {
-                continue;
-            }
-            
-            // Create the dependency between operations
-            [operation addDependency:dependencyOperation];
-        }
-    }
+    _returnInfoCacheCapacity = returnInfoCacheCapacity;
     
-    // Register object relationships
-    [self registerTaskGroup:taskGroup];
-    
-    // Schedule all operations
-    for (HLSTaskOperation *operation in operations) {
-        [self.operationQueue addOperation:operation];
+    // Discard the least recently used entries which do not fit anymore
+    while ([self.returnInfoCacheIdentityKeys count] > returnInfoCacheCapacity) {
+        NSString *identityKey = [self.returnInfoCacheIdentityKeys objectAtIndex:0];
+        [self.returnInfoCache removeObjectForKey:identityKey];
+        [self.returnInfoCacheIdentityKeys removeObjectAtIndex:0];
     }
 }
 
-#pragma mark -
-#pragma mark Cancelling tasks
+@synthesize tasks = _tasks;
 
-- (void)cancelTask:(HLSTask *)task
+@synthesize taskGroups = _taskGroups;
+
+@synthesize notificationDeliveryMode = _notificationDeliveryMode;
+
+@synthesize notificationDispatchQueue = _notificationDispatchQueue;
+
+- (void)setNotificationDispatchQueue:(dispatch_queue_t)notificationDispatchQueue
 {
-    // If already finished (cancelled or complete), nothing to cancel
-    if (task.finished) {
-        HLSLoggerDebug(@"Task %@ is already complete or cancelled", task);
-        return;
+    if (! notificationDispatchQueue) {
+        notificationDispatchQueue = dispatch_get_main_queue();
     }
     
-    // Locate the associated operation
-    NSValue *taskKey = [NSValue valueWithPointer:task];
-    HLSTaskOperation *operation = [self.taskToOperationMap objectForKey:taskKey];
-    if (! operation) {
+    if (_notificationDispatchQueue == notificationDispatchQueue) {
         return;
     }
     
-    // Flag the operation as cancelled
-    task.cancelled = YES;
-    
-    // When cancelling tasks, all those which have been started will update their status when they gracefully
-    // stop (and unregister them at this point). For tasks which have not been started, this has to be done
-    // here
-    if (! [operation isExecuting]) {
-        // If part of a task group, first cancel all dependent tasks; a task group is removed once all tasks it contains are
-        // marked as finished. Here we are careful enough to cancel all dependent task before the current task is set as 
-        // finished. This way the task group is guaranteed to survive the loop below
-        HLSTaskGroup *taskGroup = task.taskGroup;
-        if (taskGroup) {
-            // Cancel all tasks strongly depending on the task
-            NSSet *strongDependents = [taskGroup strongDependentsForTask:task];
-            for (HLSTask *dependent in strongDependents) {
-                [self cancelTask:dependent];
-            }
-        }
-        
-        task.finished = YES;
-        
-        // Notify the task delegate
-        id<HLSTaskDelegate> taskDelegate = [self delegateForTask:task];
-        if ([taskDelegate respondsToSelector:@selector(taskHasBeenCancelled:)]) {
-            [taskDelegate taskHasBeenCancelled:task];
-        }
-        
-        if (taskGroup) {            
-            [taskGroup updateStatus];
-            
-            // If the task group is now complete, update and notify as well
-            if (taskGroup.finished) {
-                taskGroup.running = NO;
-                
-                id<HLSTaskGroupDelegate> taskGroupDelegate = [self delegateForTaskGroup:taskGroup];
-                if (! taskGroup.cancelled) {
-                    HLSLoggerDebug(@"Task group %@ ends successfully", taskGroup);
-                    if ([taskGroupDelegate respondsToSelector:@selector(taskGroupHasBeenProcessed:)]) {
-                        [taskGroupDelegate taskGroupHasBeenProcessed:taskGroup];
-                    }
-                }
-                else {
-                    HLSLoggerDebug(@"Task group %@ has been cancelled", taskGroup);
-                    if ([taskGroupDelegate respondsToSelector:@selector(taskGroupHasBeenCancelled:)]) {
-                        [taskGroupDelegate taskGroupHasBeenCancelled:taskGroup];
-                    }
-                }
-            }
-        }
-        
-        [self unregisterOperation:operation];
+    dispatch_retain(notificationDispatchQueue);
+    if (_notificationDispatchQueue) {
+        dispatch_release(_notificationDispatchQueue);
     }
-    
-    [operation cancel];
+    _notificationDispatchQueue = notificationDispatchQueue;
 }
 
-- (void)cancelTaskGroup:(HLSTaskGroup *)taskGroup
+@synthesize progressUpdateMinimumTimeInterval = _progressUpdateMinimumTimeInterval;
+
+- (void)setProgressUpdateMinimumTimeInterval:(NSTimeInterval)progressUpdateMinimumTimeInterval
 {
-    taskGroup.cancelled = YES;
-    
-    // Cancel all individual tasks
-    for (HLSTask *task in [taskGroup tasks]) {
-        [self cancelTask:task];
+    if (doublelt(progressUpdateMinimumTimeInterval, 0.)) {
+        HLSLoggerWarn(@"Progress update minimum time interval must be >= 0; fixed to 0");
+        progressUpdateMinimumTimeInterval = 0.;
     }
+    _progressUpdateMinimumTimeInterval = progressUpdateMinimumTimeInterval;
 }
 
-- (void)cancelTasksWithTag:(NSString *)tag
+@synthesize progressUpdateMinimumDelta = _progressUpdateMinimumDelta;
+
+@synthesize underMemoryPressure = _underMemoryPressure;
+
+@synthesize memoryPressureMaxConcurrentTaskCount = _memoryPressureMaxConcurrentTaskCount;
+
+- (void)setMemoryPressureMaxConcurrentTaskCount:(NSInteger)memoryPressureMaxConcurrentTaskCount
 {
-    NSArray *tasks = [self tasksWithTag:tag];
-    for (HLSTask *task in tasks) {
-        [self cancelTask:task];
+    // Unlike the usual concurrency settings, a single task is allowed here (serializing work is the whole point)
+    if (memoryPressureMaxConcurrentTaskCount < 1) {
+        HLSLoggerError(@"The number of concurrent tasks under memory pressure must be >= 1; not changed");
+        return;
     }
+    _memoryPressureMaxConcurrentTaskCount = memoryPressureMaxConcurrentTaskCount;
 }
 
-- (void)cancelTaskGroupsWithTag:(NSString *)tag
+@synthesize memoryPressureRecoveryTimeInterval = _memoryPressureRecoveryTimeInterval;
+
+- (void)setMemoryPressureRecoveryTimeInterval:(NSTimeInterval)memoryPressureRecoveryTimeInterval
 {
-    NSArray *taskGroups = [self taskGroupsWithTag:tag];
-    for (HLSTaskGroup *taskGroup in taskGroups) {
-        [self cancelTaskGroup:taskGroup];
+    if (doublelt(memoryPressureRecoveryTimeInterval, 0.)) {
+        HLSLoggerWarn(@"Memory pressure recovery time interval must be >= 0; fixed to 0");
+        memoryPressureRecoveryTimeInterval = 0.;
     }
+    _memoryPressureRecoveryTimeInterval = memoryPressureRecoveryTimeInterval;
 }
 
-- (void)cancelTasksWithDelegate:(id)delegate
+@synthesize deferredTaskGroupsGateOperation = _deferredTaskGroupsGateOperation;
+
+@synthesize backgroundExecutionEnabled = _backgroundExecutionEnabled;
+
+@synthesize backgroundStartMinimumTimeInterval = _backgroundStartMinimumTimeInterval;
+
+- (void)setBackgroundStartMinimumTimeInterval:(NSTimeInterval)backgroundStartMinimumTimeInterval
 {
-    // Cancel all task groups associated with this delegate
-    NSValue *delegateKey = [NSValue valueWithPointer:delegate];
-    NSSet *taskGroupsForDelegate = [NSSet setWithSet:[self.delegateToTaskGroupsMap objectForKey:delegateKey]];
-    for (HLSTaskGroup *taskGroup in taskGroupsForDelegate) {
-        [self cancelTaskGroup:taskGroup];
-    }
-    
-    // Cancel all single tasks associated with this delegate
-    NSSet *tasksForDelegate = [NSSet setWithSet:[self.delegateToTasksMap objectForKey:delegateKey]];
-    for (HLSTask *task in tasksForDelegate) {
-        [self cancelTask:task];
+    if (doublelt(backgroundStartMinimumTimeInterval, 0.)) {
+        HLSLoggerWarn(@"Background start minimum time interval must be >= 0; fixed to 0");
+        backgroundStartMinimumTimeInterval = 0.;
     }
+    _backgroundStartMinimumTimeInterval = backgroundStartMinimumTimeInterval;
 }
 
-#pragma mark -
-#pragma mark Finding tasks
+@synthesize backgroundPauseTimeInterval = _backgroundPauseTimeInterval;
 
-- (NSArray *)tasksWithTag:(NSString *)tag
+- (void)setBackgroundPauseTimeInterval:(NSTimeInterval)backgroundPauseTimeInterval
 {
-    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"tag MATCHES %@", tag];
-    return [[self.tasks filteredSetUsingPredicate:predicate] allObjects];
+    if (doublelt(backgroundPauseTimeInterval, 0.)) {
+        HLSLoggerWarn(@"Background pause time interval must be >= 0; fixed to 0");
+        backgroundPauseTimeInterval = 0.;
+    }
+    _backgroundPauseTimeInterval = backgroundPauseTimeInterval;
 }
 
-- (NSArray *)taskGroupsWithTag:(NSString *)tag
+- (BOOL)isExecutingInBackground
 {
-    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"tag MATCHES %@", tag];
-    return [[self.taskGroups filteredSetUsingPredicate:predicate] allObjects];    
+    return _backgroundTaskIdentifier != UIBackgroundTaskInvalid;
 }
 
-#pragma mark -
-#pragma mark Registering and unregistering task delegates
+@synthesize backgroundGateOperation = _backgroundGateOperation;
 
-- (void)registerDelegate:(id<HLSTaskDelegate>)delegate forTask:(HLSTask *)task
+@synthesize backgroundHeldOperations = _backgroundHeldOperations;
+
+@synthesize backgroundSchedulingTimer = _backgroundSchedulingTimer;
+
+@synthesize pausedTasks = _pausedTasks;
+
+@synthesize memoryPressureRecoveryTimer = _memoryPressureRecoveryTimer;
+
+@synthesize deadlineWheelSlots = _deadlineWheelSlots;
+
+@synthesize deadlineWheelTimer = _deadlineWheelTimer;
+
+@synthesize usingFairShareScheduling = _usingFairShareScheduling;
+
+- (void)setUsingFairShareScheduling:(BOOL)usingFairShareScheduling
 {
-    // Unregister any previously registered delegate first
-    [self unregisterDelegateForTask:task];
-    
-    // Register the task - delegate relationship; use the task pointer as key
-    // TODO: I first expected the obvious following code to work:
-    //          NSValue *taskKey = [NSValue valueWithPointer:task];
-    //          [self.taskToDelegateMap setObject:delegate forKey:taskKey];
-    //       but some strange crashes occurred under some circumstances (most notably when the manager
-    //       object was fed with many tasks while many other tasks were still being processed; in my
-    //       case web service requests were being sent fast with a slow internet connection). After
-    //       investigation the dictionary taskToDelegateMap is in some cases corrupt, but the
-    //       reason is unclear since:
-    //         - all processing occurs on the calling thread, no thread interleaving issues come into play
-    //         - I was careful enough to iterate on copies of data structures when a loop body can potentially
-    //           alter it, so no enumerator invalidation issues should occur
-    //       I could not find the reason why this problem occurs, but I found a solution: copy & swap. 
-    NSValue *taskKey = [NSValue valueWithPointer:task];
-    NSMutableDictionary *tempTaskToDelegateMap = [NSMutableDictionary dictionaryWithDictionary:self.taskToDelegateMap];
-    [tempTaskToDelegateMap setObject:delegate forKey:taskKey];
-    self.taskToDelegateMap = tempTaskToDelegateMap;
+    if (_usingFairShareScheduling == usingFairShareScheduling) {
+        return;
+    }
     
-    // Register the inverse delegate - task relationship; use the delegate pointer as key
-    NSValue *delegateKey = [NSValue valueWithPointer:delegate];
-    NSMutableSet *tasksForDelegate = [self.delegateToTasksMap objectForKey:delegateKey];
-    // Create the set lazily if it does not exist
-    if (! tasksForDelegate) {
-        tasksForDelegate = [NSMutableSet set];
-        [self.delegateToTasksMap setObject:tasksForDelegate forKey:delegateKey];
+    _usingFairShareScheduling = usingFairShareScheduling;
+    if (! usingFairShareScheduling) {
+        [self releaseAllHeldOperations];
     }
-    [tasksForDelegate addObject:task];
 }
 
-- (void)registerDelegate:(id<HLSTaskGroupDelegate>)delegate forTaskGroup:(HLSTaskGroup *)taskGroup
+@synthesize tagToHeldOperationsMap = _tagToHeldOperationsMap;
+
+@synthesize releasedOperations = _releasedOperations;
+
+@synthesize tagToReleasedOperationCountMap = _tagToReleasedOperationCountMap;
+
+@synthesize tagToFairShareWeightMap = _tagToFairShareWeightMap;
+
+@synthesize tagToFairShareCurrentWeightMap = _tagToFairShareCurrentWeightMap;
+
+@synthesize tagToMaxConcurrentTaskCountMap = _tagToMaxConcurrentTaskCountMap;
+
+- (void)setProgressUpdateMinimumDelta:(float)progressUpdateMinimumDelta
 {
-    // Unregister any previously registered delegate first
-    [self unregisterDelegateForTaskGroup:taskGroup];
-    
-    // Register the task group - delegate relationship; use the task pointer as key
-    NSValue *taskGroupKey = [NSValue valueWithPointer:taskGroup];
-    [self.taskGroupToDelegateMap setObject:delegate forKey:taskGroupKey];
-    
-    // Register the inverse delegate - task group relationship; use the delgate pointer as key
-    NSValue *delegateKey = [NSValue valueWithPointer:delegate];
-    NSMutableSet *taskGroupsForDelegate = [self.delegateToTaskGroupsMap objectForKey:delegateKey];
-    // Create the set lazily if it does not exist
-    if (! taskGroupsForDelegate) {
-        taskGroupsForDelegate = [NSMutableSet set];
-        [self.delegateToTaskGroupsMap setObject:taskGroupsForDelegate forKey:delegateKey];
+    if (floatlt(progressUpdateMinimumDelta, 0.f)) {
+        HLSLoggerWarn(@"Progress update minimum delta must be >= 0; fixed to 0");
+        progressUpdateMinimumDelta = 0.f;
     }
-    [taskGroupsForDelegate addObject:taskGroup]; 
+    _progressUpdateMinimumDelta = progressUpdateMinimumDelta;
 }
 
-- (void)unregisterDelegateForTask:(HLSTask *)task
+- (void)setMaxConcurrentTaskCount:(NSInteger)count
 {
-    // Find if a delegate has been defined for this task; use the task pointer as key
-    NSValue *taskKey = [NSValue valueWithPointer:task];
-    id<HLSTaskDelegate> delegate = [self.taskToDelegateMap objectForKey:taskKey];
-    if (! delegate) {
+    if (! [self isValidMaxConcurrentTaskCount:count]) {
         return;
     }
     
-    // Remove the task - delegate relationship
-    // TODO: Copy & swap strategy to avoid strange dictionary corruption; see registerDelegate:. Normally the following
-    //       should have worked:
-    //           [self.taskToDelegateMap removeObjectForKey:taskKey];
-    NSMutableDictionary *tempTaskToDelegateMap = [NSMutableDictionary dictionaryWithDictionary:self.taskToDelegateMap];
-    [tempTaskToDelegateMap removeObjectForKey:taskKey];
-    self.taskToDelegateMap = tempTaskToDelegateMap;
+    [self disableAdaptiveConcurrency];
     
-    // Remove the inverse delegate - task relationship; use the delegate pointer as key
-    NSValue *delegateKey = [NSValue valueWithPointer:delegate];
-    NSMutableSet *tasksForDelegate = [self.delegateToTasksMap objectForKey:delegateKey];
-    [tasksForDelegate removeObject:task];
-    
-    // If the set is now empty for this delegate, then remove the dictionary entry as well
-    if ([tasksForDelegate count] == 0) {
-        [self.delegateToTasksMap removeObjectForKey:delegateKey];
+    // Applied when memory pressure is gone
+    if (self.underMemoryPressure) {
+        _savedMaxConcurrentTaskCount = count;
+        return;
     }
+    
+    [self.operationQueue setMaxConcurrentOperationCount:count];
+    [self releaseHeldOperations];
 }
 
-- (void)unregisterDelegateForTaskGroup:(HLSTaskGroup *)taskGroup
+- (NSInteger)maxConcurrentTaskCount
 {
-    // Find if a delegate has been defined for this task group; use the task pointer as key
-    NSValue *taskGroupKey = [NSValue valueWithPointer:taskGroup];
-    id<HLSTaskGroupDelegate> delegate = [self.taskGroupToDelegateMap objectForKey:taskGroupKey];
-    if (! delegate) {
+    return self.underMemoryPressure ? _savedMaxConcurrentTaskCount : [self.operationQueue maxConcurrentOperationCount];
+}
+
+- (void)setMaxConcurrentTaskCount:(NSInteger)count forPriority:(HLSTaskPriority)priority
+{
+    if (priority >= HLSTaskPriorityEnumEnd) {
+        HLSLoggerError(@"Invalid priority");
         return;
     }
     
-    // Remove the task group - delegate relationship
-    [self.taskGroupToDelegateMap removeObjectForKey:taskGroupKey];
-    
-    // Remove the inverse delegate - task group relationship
-    NSValue *delegateKey = [NSValue valueWithPointer:delegate];
-    NSMutableSet *taskGroupsForDelegate = [self.delegateToTaskGroupsMap objectForKey:delegateKey];
-    [taskGroupsForDelegate removeObject:taskGroup];
+    if (! [self isValidMaxConcurrentTaskCount:count]) {
+        return;
+    }
     
-    // If the set is now empty for this delegate, then remove the dictionary entry as well
-    if ([taskGroupsForDelegate count] == 0) {
-        [self.delegateToTaskGroupsMap removeObjectForKey:delegateKey];
+    if (self.underMemoryPressure) {
+        _savedPriorityMaxConcurrentTaskCounts[priority] = count;
+        return;
     }
+    
+    NSOperationQueue *priorityOperationQueue = [self.priorityOperationQueues objectAtIndex:priority];
+    [priorityOperationQueue setMaxConcurrentOperationCount:count];
 }
 
-- (void)unregisterDelegateAndCancelAssociatedTasks:(id)delegate
+- (BOOL)isValidMaxConcurrentTaskCount:(NSInteger)count
 {
-    // Cancel tasks first (had we unregistered first, we would have lost track of the delegate - task 
-    // relationships, cancelling nothing!) 
-    [self cancelTasksWithDelegate:delegate];
-    [self unregisterDelegate:delegate];
+    // Remark: It seems that with the recommended setting NSOperationQueueDefaultMaxConcurrentOperationCount (which
+    //         lets the OS decide dynamically how many threads are needed), dependencies betweeen NSOperation objects
+    //         are not applied anymore (bug?). Anyway, this does not work correctly, so we fix the number of threads
+    //         to a seemingly good value
+    if (count == NSOperationQueueDefaultMaxConcurrentOperationCount) {
+        HLSLoggerWarn(@"Dynamic number of concurrent tasks is currently not working correctly; task count not changed");
+        return NO;
+    }
+    else if (count > 1) {
+        return YES;
+    }
+    else {
+        HLSLoggerError(@"Invalid number of concurrent tasks; task count not changed");
+        return NO;
+    }
+}
+
+#pragma mark -
+#pragma mark Adaptive concurrency
+
+- (void)enableAdaptiveConcurrencyWithMinimumTaskCount:(NSInteger)minimumTaskCount maximumTaskCount:(NSInteger)maximumTaskCount
+{
+    if (! [self isValidMaxConcurrentTaskCount:minimumTaskCount] || ! [self isValidMaxConcurrentTaskCount:maximumTaskCount]) {
+        return;
+    }
+    
+    if (minimumTaskCount > maximumTaskCount) {
+        HLSLoggerError(@"The minimum task count must be smaller than the maximum task count");
+        return;
+    }
+    
+    _minimumAdaptiveTaskCount = minimumTaskCount;
+    _maximumAdaptiveTaskCount = maximumTaskCount;
+    
+    // Start from the current value if within bounds
+    NSInteger count = MIN(MAX([self maxConcurrentTaskCount], minimumTaskCount), maximumTaskCount);
+    if (self.underMemoryPressure) {
+        _savedMaxConcurrentTaskCount = count;
+    }
+    else {
+        [self.operationQueue setMaxConcurrentOperationCount:count];
+    }
+    
+    _previousSamplingThroughput = 0.;
+    _previousSamplingAverageDuration = 0.;
+    _adaptiveTaskCountStep = 1;
+    [self resetAdaptiveSampling];
+    
+    self.adaptingConcurrency = YES;
+}
+
+- (void)disableAdaptiveConcurrency
+{
+    self.adaptingConcurrency = NO;
+}
+
+- (void)resetAdaptiveSampling
+{
+    _samplingStartTime = CFAbsoluteTimeGetCurrent();
+    _samplingProcessedTaskCount = 0;
+    _samplingProcessingTimeInterval = 0.;
+}
+
+- (void)recordProcessedOperation:(HLSTaskOperation *)operation withDuration:(NSTimeInterval)duration
+{
+    // Measurements made while throttled are meaningless
+    if (! self.adaptingConcurrency || self.underMemoryPressure) {
+        return;
+    }
+    
+    ++_samplingProcessedTaskCount;
+    _samplingProcessingTimeInterval += duration;
+    if (_samplingProcessedTaskCount >= kAdaptiveSamplingMinimumTaskCount
+            && CFAbsoluteTimeGetCurrent() - _samplingStartTime >= kAdaptiveSamplingMinimumTimeInterval) {
+        [self adaptConcurrency];
+    }
+}
+
+// Simple hill-climbing: Keep changing the number of concurrent tasks in the same direction as long as throughput
+// improves, and revert direction when it degrades. A step of 0 means the previous measurement was a plateau, in which 
+// case we probe upwards again
+- (void)adaptConcurrency
+{
+    double throughput = _samplingProcessedTaskCount / (CFAbsoluteTimeGetCurrent() - _samplingStartTime);
+    NSTimeInterval averageDuration = _samplingProcessingTimeInterval / _samplingProcessedTaskCount;
+    NSInteger count = [self.operationQueue maxConcurrentOperationCount];
+    
+    // Previous measurement was a plateau. Probe upwards
+    if (_adaptiveTaskCountStep == 0) {
+        _adaptiveTaskCountStep = 1;
+    }
+    // Throughput has decreased since the last change. Revert
+    else if (throughput < _previousSamplingThroughput * (1. - kAdaptiveThroughputTolerance)) {
+        _adaptiveTaskCountStep = -_adaptiveTaskCountStep;
+    }
+    // Plateau: If tasks take longer to complete, they are competing for some resource (CPU, network). Back off.
+    // Otherwise wait for the next measurement
+    else if (throughput <= _previousSamplingThroughput * (1. + kAdaptiveThroughputTolerance)) {
+        if (averageDuration > _previousSamplingAverageDuration * (1. + kAdaptiveThroughputTolerance)) {
+            _adaptiveTaskCountStep = -1;
+        }
+        else {
+            _adaptiveTaskCountStep = 0;
+        }
+    }
+    
+    // More threads are pointless if no tasks are waiting
+    BOOL tasksWaiting = ((NSInteger)[self.operationQueue operationCount] > count || CFDictionaryGetCount(_heldOperationToQueueMap) != 0);
+    if (_adaptiveTaskCountStep > 0 && ! tasksWaiting) {
+        _adaptiveTaskCountStep = 0;
+    }
+    
+    NSInteger newCount = MIN(MAX(count + _adaptiveTaskCountStep, _minimumAdaptiveTaskCount), _maximumAdaptiveTaskCount);
+    if (newCount != count) {
+        HLSLoggerDebug(@"Throughput: %.2f tasks/s; number of concurrent tasks changed from %d to %d", throughput, count, newCount);
+        [self.operationQueue setMaxConcurrentOperationCount:newCount];
+        [self releaseHeldOperations];
+    }
+    
+    _previousSamplingThroughput = throughput;
+    _previousSamplingAverageDuration = averageDuration;
+    [self resetAdaptiveSampling];
+}
+
+#pragma mark -
+#pragma mark Submitting tasks
+
+- (void)submitTask:(HLSTask *)task
+{
+    HLSTaskOperation *operation = [self registeredOperationForSubmittedTask:task];
+    if (! operation) {
+        return;
+    }
+    
+    if (task.durable) {
+        [self.journal recordSubmissionOfTasks:[NSArray arrayWithObject:task]];
+    }
+    
+    NSMutableArray *operations = [NSMutableArray arrayWithObject:operation];
+    [operations addObjectsFromArray:[self registeredOperationsForContinuationsOfOperation:operation]];
+    [self scheduleOperations:operations withPriority:task.priority];
+}
+
+- (void)submitTasks:(NSArray *)tasks
+{
+    // Register all operations first, sorting them by priority so that each queue receives them in a single call
+    NSMutableArray *operationsForPriorities = [NSMutableArray arrayWithCapacity:HLSTaskPriorityEnumSize];
+    for (NSUInteger i = 0; i < HLSTaskPriorityEnumSize; ++i) {
+        [operationsForPriorities addObject:[NSMutableArray array]];
+    }
+    
+    NSMutableArray *durableTasks = [NSMutableArray array];
+    for (HLSTask *task in tasks) {
+        HLSTaskOperation *operation = [self registeredOperationForSubmittedTask:task];
+        if (! operation) {
+            continue;
+        }
+        
+        if (task.durable) {
+            [durableTasks addObject:task];
+        }
+        
+        HLSTaskPriority priority = (task.priority < HLSTaskPriorityEnumEnd) ? task.priority : HLSTaskPriorityNormal;
+        NSMutableArray *operations = [operationsForPriorities objectAtIndex:priority];
+        [operations addObject:operation];
+        [operations addObjectsFromArray:[self registeredOperationsForContinuationsOfOperation:operation]];
+    }
+    
+    // Durable tasks are recorded in a single write
+    if ([durableTasks count] != 0) {
+        [self.journal recordSubmissionOfTasks:durableTasks];
+    }
+    
+    // Schedule higher priorities first
+    for (NSInteger priority = HLSTaskPriorityEnumEnd - 1; priority >= HLSTaskPriorityEnumBegin; --priority) {
+        NSArray *operations = [operationsForPriorities objectAtIndex:priority];
+        if ([operations count] == 0) {
+            continue;
+        }
+        [self scheduleOperations:operations withPriority:priority];
+    }
+}
+
+- (NSArray *)submitCheckpointedTasksWithDelegate:(id<HLSTaskDelegate>)delegate
+{
+    NSSet *runningCheckpointKeys = [self.tasks valueForKey:@"checkpointKey"];
+    
+    NSMutableArray *tasks = [NSMutableArray array];
+    for (HLSTask *task in [HLSTask checkpointedTasks]) {
+        if ([runningCheckpointKeys containsObject:task.checkpointKey]) {
+            HLSLoggerDebug(@"The task with checkpoint key %@ is already running", task.checkpointKey);
+            continue;
+        }
+        
+        if (delegate) {
+            [self registerDelegate:delegate forTask:task];
+        }
+        [tasks addObject:task];
+    }
+    
+    [self submitTasks:tasks];
+    return [NSArray arrayWithArray:tasks];
+}
+
+- (NSArray *)submitJournaledTasksWithDelegate:(id<HLSTaskDelegate>)delegate taskGroupDelegate:(id<HLSTaskGroupDelegate>)taskGroupDelegate
+{
+    if (! self.journal) {
+        HLSLoggerWarn(@"No journal has been attached to the task manager");
+        return [NSArray array];
+    }
+    
+    // Restore the resume tokens of tasks with a checkpoint, so that they do not need to be resubmitted from it as well
+    NSMutableDictionary *checkpointKeyToResumeTokenMap = [NSMutableDictionary dictionary];
+    for (HLSTask *checkpointedTask in [HLSTask checkpointedTasks]) {
+        if (checkpointedTask.resumeToken) {
+            [checkpointKeyToResumeTokenMap setObject:checkpointedTask.resumeToken forKey:checkpointedTask.checkpointKey];
+        }
+    }
+    
+    NSArray *objects = [self.journal replayedTasksAndTaskGroups];
+    NSMutableArray *tasks = [NSMutableArray array];
+    NSMutableArray *taskGroups = [NSMutableArray array];
+    for (id object in objects) {
+        if ([object isKindOfClass:[HLSTaskGroup class]]) {
+            HLSTaskGroup *taskGroup = object;
+            for (HLSTask *task in [taskGroup tasks]) {
+                if (task.checkpointKey) {
+                    task.resumeToken = [checkpointKeyToResumeTokenMap objectForKey:task.checkpointKey];
+                }
+                if (delegate) {
+                    [self registerDelegate:delegate forTask:task];
+                }
+            }
+            if (taskGroupDelegate) {
+                [self registerDelegate:taskGroupDelegate forTaskGroup:taskGroup];
+            }
+            [taskGroups addObject:taskGroup];
+        }
+        else {
+            HLSTask *task = object;
+            if (task.checkpointKey) {
+                task.resumeToken = [checkpointKeyToResumeTokenMap objectForKey:task.checkpointKey];
+            }
+            if (delegate) {
+                [self registerDelegate:delegate forTask:task];
+            }
+            [tasks addObject:task];
+        }
+    }
+    
+    // The objects have already been recorded again by the journal
+    [self submitTasks:tasks];
+    for (HLSTaskGroup *taskGroup in taskGroups) {
+        [self submitTaskGroup:taskGroup];
+    }
+    return objects;
+}
+
+- (void)discardCheckpoints
+{
+    [HLSTask removeAllCheckpoints];
+}
+
+// Return the registered operation which must be scheduled for a task, or nil if the task has been processed
+// without needing one (or could not be submitted)
+- (HLSTaskOperation *)registeredOperationForSubmittedTask:(HLSTask *)task
+{
+    // Cannot submit a task if already running
+    if ([self.tasks containsObject:task]) {
+        HLSLoggerWarn(@"Cannot submit a task which is already running");
+        return nil;
+    }
+    
+    // Tasks with an identity key: Use cached results or mirror a task already submitted if possible. Continuations
+    // need an operation to depend on, tasks having some are therefore always processed
+    NSString *identityKey = task.identityKey;
+    if (identityKey && ! task.taskGroup && [[task continuations] count] == 0) {
+        NSDictionary *cachedReturnInfo = [self cachedReturnInfoForIdentityKey:identityKey];
+        if (cachedReturnInfo) {
+            [self processTask:task withCachedReturnInfo:cachedReturnInfo];
+            return nil;
+        }
+        
+        HLSTask *identicalTask = [self.identityKeyToTaskMap objectForKey:identityKey];
+        if (identicalTask) {
+            [self registerDuplicateTask:task forTask:identicalTask];
+            return nil;
+        }
+        
+        [self.identityKeyToTaskMap setObject:task forKey:identityKey];
+    }
+    
+    [self.metrics recordSubmissionOfObject:task];
+    
+    // Get the corresponding operation and register it
+    HLSTaskOperation *operation = [self operationForTask:task];
+    [self registerOperation:operation];
+    return operation;
+}
+
+// Continuations are registered together with the task they continue, their operations depending on its operation. They
+// can therefore start as soon as this operation is finished (the end notification of a task is always processed before 
+// its operation finishes, the continuation can thus be cancelled in time if the task has failed)
+- (NSArray *)registeredOperationsForContinuationsOfOperation:(HLSTaskOperation *)operation
+{
+    NSMutableArray *continuationOperations = [NSMutableArray array];
+    for (HLSTask *continuation in [operation.task continuations]) {
+        if ([self.tasks containsObject:continuation]) {
+            HLSLoggerWarn(@"Cannot submit a continuation which is already running");
+            continue;
+        }
+        
+        [self.metrics recordSubmissionOfObject:continuation];
+        
+        HLSTaskOperation *continuationOperation = [self operationForTask:continuation];
+        [continuationOperation addDependency:operation];
+        [self registerOperation:continuationOperation];
+        [continuationOperations addObject:continuationOperation];
+        
+        [continuationOperations addObjectsFromArray:[self registeredOperationsForContinuationsOfOperation:continuationOperation]];
+    }
+    return continuationOperations;
+}
+
+- (void)submitTaskGroup:(HLSTaskGroup *)taskGroup
+{
+    // Cannot submit a task if already running
+    if ([self.taskGroups containsObject:taskGroup]) {
+        HLSLoggerWarn(@"Cannot submit a task group which is already running");
+        return;
+    }
+    
+    // Dependencies must not form cycles (which would otherwise leave operations waiting for each other forever). The
+    // tasks are scheduled in topological order so that each operation is enqueued after the operations it depends on
+    NSArray *sortedTasks = [taskGroup topologicallySortedTasks];
+    if (! sortedTasks) {
+        HLSLoggerError(@"The dependencies of task group %@ form a cycle; the task group cannot be submitted", taskGroup);
+        return;
+    }
+    
+    // Reset status
+    [taskGroup reset];
+    
+    // If no operation in the task group, we are already done; update the status accordingly and simulate events
+    if ([[taskGroup tasks] count] == 0) {
+        NSUInteger taskGroupDelegateMethods = 0;
+        id<HLSTaskGroupDelegate> taskGroupDelegate = [self delegateForTaskGroup:taskGroup implementedMethods:&taskGroupDelegateMethods];
+        if (taskGroupDelegate) {
+            if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodHasStartedProcessing) {
+                [taskGroupDelegate taskGroupHasStartedProcessing:taskGroup];
+            }
+            
+            if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodHasBeenProcessed) {
+                [taskGroupDelegate taskGroupHasBeenProcessed:taskGroup];
+            }            
+        }
+        
+        taskGroup.finished = YES;
+        return;
+    }    
+    
+    // Get the corresponding operations and register them. Since tasks are sorted, the operations of the tasks a task depends 
+    // on have always been registered when it is reached, and dependencies can be applied in the same pass
+    [self.metrics recordSubmissionOfObject:taskGroup];
+    NSMutableArray *operations = [NSMutableArray arrayWithCapacity:[sortedTasks count]];
+    for (HLSTask *task in sortedTasks) {
+        [self.metrics recordSubmissionOfObject:task];
+        
+        HLSTaskOperation *operation = [self operationForTask:task];
+        if (! operation) {
+            continue;
+        }
+        [self registerOperation:operation];
+        [operations addObject:operation];
+        [operations addObjectsFromArray:[self registeredOperationsForContinuationsOfOperation:operation]];
+        
+        for (HLSTask *dependencyTask in [taskGroup dependenciesForTask:task]) {
+            HLSTaskOperation *dependencyOperation = (HLSTaskOperation *)CFDictionaryGetValue(_taskToOperationMap, dependencyTask);
+            if (! dependencyOperation) {
+                continue;
+            }
+            
+            // Create the dependency between operations
+            [operation addDependency:dependencyOperation];
+        }
+    }
+    
+    // Register object relationships
+    [self registerTaskGroup:taskGroup];
+    
+    if (taskGroup.durable) {
+        [self.journal recordSubmissionOfTaskGroup:taskGroup];
+    }
+    
+    // Hold back deferrable task groups until memory pressure is gone
+    if (taskGroup.deferrable && self.underMemoryPressure) {
+        [self deferOperations:operations];
+    }
+    
+    // Schedule all operations
+    [self scheduleOperations:operations withPriority:taskGroup.priority];
+}
+
+#pragma mark -
+#pragma mark Task snapshots
+
+- (NSUInteger)pendingTaskCount
+{
+    return [self.tasks count];
+}
+
+- (unsigned long long)taskStateGeneration
+{
+    return [HLSTask currentStateGeneration];
+}
+
+- (NSUInteger)getSnapshots:(HLSTaskSnapshot *)snapshots ofTasks:(NSArray *)tasks changedSinceGeneration:(unsigned long long)generation
+{
+    NSUInteger nbrSnapshots = 0;
+    NSUInteger index = 0;
+    for (HLSTask *task in tasks) {
+        unsigned long long stateGeneration = task.stateGeneration;
+        if (stateGeneration <= generation && generation != 0) {
+            ++index;
+            continue;
+        }
+        
+        HLSTaskState state;
+        if (task.cancelled) {
+            state = HLSTaskStateCancelled;
+        }
+        else if (task.finished) {
+            state = task.error ? HLSTaskStateFailed : HLSTaskStateSucceeded;
+        }
+        else if (task.running) {
+            state = HLSTaskStateRunning;
+        }
+        else {
+            state = HLSTaskStatePending;
+        }
+        
+        HLSTaskSnapshot *snapshot = &snapshots[nbrSnapshots];
+        snapshot->task = task;
+        snapshot->index = index;
+        snapshot->generation = stateGeneration;
+        snapshot->state = state;
+        snapshot->progress = task.progress;
+        snapshot->remainingTimeIntervalEstimate = task.remainingTimeIntervalEstimate;
+        
+        ++nbrSnapshots;
+        ++index;
+    }
+    return nbrSnapshots;
+}
+
+#pragma mark -
+#pragma mark Cancelling tasks
+
+- (void)cancelTask:(HLSTask *)task
+{
+    [self cancelTasks:[NSArray arrayWithObject:task]];
+}
+
+- (void)cancelTasks:(NSArray *)tasks
+{
+    // When cancelling tasks, all those which have been started will update their status when they gracefully
+    // stop (and unregister them at this point). For tasks which have not been started, this has to be done
+    // here. Pending operations are collected (together with the operations of their strong dependents) and
+    // processed in a single pass
+    NSMutableArray *pendingOperations = [NSMutableArray array];
+    for (HLSTask *task in tasks) {
+        // Paused tasks are simply not resumed
+        [self removePausedTask:task];
+        
+        // If already finished (cancelled or complete), nothing to cancel. Also catches tasks appearing several times,
+        // and strong dependents already cancelled by the cascade below
+        if (task.finished || task.cancelled) {
+            HLSLoggerDebug(@"Task %@ is already complete or cancelled", task);
+            continue;
+        }
+        
+        // Duplicate tasks have no associated operation, and can be cancelled without affecting the task they mirror
+        if ([self cancelDuplicateTask:task]) {
+            continue;
+        }
+        
+        // Locate the associated operation
+        HLSTaskOperation *operation = (HLSTaskOperation *)CFDictionaryGetValue(_taskToOperationMap, task);
+        if (! operation) {
+            continue;
+        }
+        
+        // Flag the operation as cancelled
+        task.cancelled = YES;
+        
+        if ([operation isExecuting]) {
+            [operation cancel];
+            continue;
+        }
+        
+        [pendingOperations addObject:operation];
+        [pendingOperations addObjectsFromArray:[self pendingOperationsForStrongDependentsOfTask:task]];
+    }
+    
+    [self cancelPendingOperations:pendingOperations];
+}
+
+- (void)cancelStrongDependentsOfTask:(HLSTask *)task
+{
+    [self cancelPendingOperations:[self pendingOperationsForStrongDependentsOfTask:task]];
+}
+
+// All tasks transitively depending strongly on the task are collected in a single graph traversal. None of them
+// can have been started yet. They are flagged as cancelled and their operations returned
+- (NSArray *)pendingOperationsForStrongDependentsOfTask:(HLSTask *)task
+{
+    HLSTaskGroup *taskGroup = task.taskGroup;
+    if (! taskGroup) {
+        return [NSArray array];
+    }
+    
+    NSMutableArray *pendingOperations = [NSMutableArray array];
+    NSArray *strongDependents = [taskGroup strongDependentsClosureForTask:task];
+    for (HLSTask *dependent in strongDependents) {
+        if (dependent.finished || dependent.cancelled) {
+            continue;
+        }
+        
+        HLSTaskOperation *dependentOperation = (HLSTaskOperation *)CFDictionaryGetValue(_taskToOperationMap, dependent);
+        if (! dependentOperation) {
+            continue;
+        }
+        
+        dependent.cancelled = YES;
+        [pendingOperations addObject:dependentOperation];
+    }
+    return [NSArray arrayWithArray:pendingOperations];
+}
+
+// Update the status of tasks which have not been started yet and have been flagged as cancelled, notify about them
+// and unregister them. The status of each task group involved is updated and notified once
+- (void)cancelPendingOperations:(NSArray *)operations
+{
+    if ([operations count] == 0) {
+        return;
+    }
+    
+    // Keep the tasks and their operations alive until the end of the method, unregistering them releases them
+    NSArray *tasks = [operations valueForKey:@"task"];
+    [[tasks retain] autorelease];
+    [[operations retain] autorelease];
+    
+    NSMutableArray *taskGroups = [NSMutableArray array];
+    for (HLSTaskOperation *operation in operations) {
+        HLSTask *task = operation.task;
+        task.finished = YES;
+        
+        // Notify the task delegate
+        NSUInteger taskDelegateMethods = 0;
+        id<HLSTaskDelegate> taskDelegate = [self delegateForTask:task implementedMethods:&taskDelegateMethods];
+        if (taskDelegateMethods & HLSTaskDelegateMethodHasBeenCancelled) {
+            [taskDelegate taskHasBeenCancelled:task];
+        }
+        
+        HLSTaskGroup *taskGroup = task.taskGroup;
+        if (taskGroup && ! [taskGroups containsObject:taskGroup]) {
+            [taskGroups addObject:taskGroup];
+        }
+    }
+    
+    for (HLSTaskGroup *taskGroup in taskGroups) {
+        [taskGroup updateStatus];
+        
+        // If the task group is now complete, update and notify as well
+        if (taskGroup.finished) {
+            taskGroup.running = NO;
+            
+            NSUInteger taskGroupDelegateMethods = 0;
+            id<HLSTaskGroupDelegate> taskGroupDelegate = [self delegateForTaskGroup:taskGroup implementedMethods:&taskGroupDelegateMethods];
+            if (! taskGroup.cancelled) {
+                HLSLoggerDebug(@"Task group %@ ends successfully", taskGroup);
+                if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodHasBeenProcessed) {
+                    [taskGroupDelegate taskGroupHasBeenProcessed:taskGroup];
+                }
+            }
+            else {
+                HLSLoggerDebug(@"Task group %@ has been cancelled", taskGroup);
+                if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodHasBeenCancelled) {
+                    [taskGroupDelegate taskGroupHasBeenCancelled:taskGroup];
+                }
+            }
+        }
+    }
+    
+    // Cancel first, operations might be queued when unregistered
+    for (HLSTaskOperation *operation in operations) {
+        [operation cancel];
+        [self unregisterOperation:operation];
+    }
+}
+
+- (void)cancelTaskGroup:(HLSTaskGroup *)taskGroup
+{
+    taskGroup.cancelled = YES;
+    
+    // Cancel all individual tasks
+    [self cancelTasks:[[taskGroup tasks] allObjects]];
+}
+
+- (void)cancelTasksWithTag:(NSString *)tag
+{
+    [self cancelTasks:[self tasksWithTag:tag]];
+}
+
+- (void)cancelTaskGroupsWithTag:(NSString *)tag
+{
+    NSArray *taskGroups = [self taskGroupsWithTag:tag];
+    [self cancelTaskGroups:taskGroups];
+}
+
+- (void)cancelTasksWithDelegate:(id)delegate
+{
+    // Cancel all task groups associated with this delegate
+    NSArray *taskGroupsForDelegate = [(NSSet *)CFDictionaryGetValue(_delegateToTaskGroupsMap, delegate) allObjects];
+    [self cancelTaskGroups:taskGroupsForDelegate];
+    
+    // Cancel all single tasks associated with this delegate
+    NSArray *tasksForDelegate = [(NSSet *)CFDictionaryGetValue(_delegateToTasksMap, delegate) allObjects];
+    [self cancelTasks:tasksForDelegate];
+    
+    // Same for paused tasks
+    for (HLSTask *pausedTask in [NSArray arrayWithArray:self.pausedTasks]) {
+        if (CFDictionaryGetValue(_pausedTaskToDelegateMap, pausedTask) == delegate) {
+            [self removePausedTask:pausedTask];
+        }
+    }
+}
+
+- (void)cancelTaskGroups:(NSArray *)taskGroups
+{
+    // Cancel the tasks of all task groups in a single pass
+    NSMutableArray *tasks = [NSMutableArray array];
+    for (HLSTaskGroup *taskGroup in taskGroups) {
+        taskGroup.cancelled = YES;
+        [tasks addObjectsFromArray:[[taskGroup tasks] allObjects]];
+    }
+    [self cancelTasks:tasks];
+}
+
+#pragma mark -
+#pragma mark Finding tasks
+
+- (NSArray *)tasksWithTag:(NSString *)tag
+{
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"tag MATCHES %@", tag];
+    return [[self.tasks filteredSetUsingPredicate:predicate] allObjects];
+}
+
+- (NSArray *)taskGroupsWithTag:(NSString *)tag
+{
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"tag MATCHES %@", tag];
+    return [[self.taskGroups filteredSetUsingPredicate:predicate] allObjects];    
+}
+
+#pragma mark -
+#pragma mark Registering and unregistering task delegates
+
+- (void)registerDelegate:(id<HLSTaskDelegate>)delegate forTask:(HLSTask *)task
+{
+    // Unregister any previously registered delegate first
+    [self unregisterDelegateForTask:task];
+    
+    // Register the task - delegate relationship; use the task pointer as key
+    // Remark: A copy & swap strategy was formerly used here to work around strange dictionary corruption issues
+    //         which occurred when many tasks were submitted while others were still being processed. Those were
+    //         most probably related to NSValue-boxed keys and are not an issue with a pointer-keyed CFDictionary,
+    //         which also spares an allocation for each registration
+    CFDictionarySetValue(_taskToDelegateMap, task, delegate);
+    CFDictionarySetValue(_taskToDelegateMethodsMap, task, (const void *)HLSTaskDelegateImplementedMethods(delegate));
+    
+    // Register the inverse delegate - task relationship; use the delegate pointer as key
+    NSMutableSet *tasksForDelegate = (NSMutableSet *)CFDictionaryGetValue(_delegateToTasksMap, delegate);
+    // Create the set lazily if it does not exist
+    if (! tasksForDelegate) {
+        tasksForDelegate = [NSMutableSet set];
+        CFDictionarySetValue(_delegateToTasksMap, delegate, tasksForDelegate);
+    }
+    [tasksForDelegate addObject:task];
+}
+
+- (void)registerDelegate:(id<HLSTaskGroupDelegate>)delegate forTaskGroup:(HLSTaskGroup *)taskGroup
+{
+    // Unregister any previously registered delegate first
+    [self unregisterDelegateForTaskGroup:taskGroup];
+    
+    // Register the task group - delegate relationship; use the task pointer as key
+    CFDictionarySetValue(_taskGroupToDelegateMap, taskGroup, delegate);
+    CFDictionarySetValue(_taskGroupToDelegateMethodsMap, taskGroup, (const void *)HLSTaskGroupDelegateImplementedMethods(delegate));
+    
+    // Register the inverse delegate - task group relationship; use the delgate pointer as key
+    NSMutableSet *taskGroupsForDelegate = (NSMutableSet *)CFDictionaryGetValue(_delegateToTaskGroupsMap, delegate);
+    // Create the set lazily if it does not exist
+    if (! taskGroupsForDelegate) {
+        taskGroupsForDelegate = [NSMutableSet set];
+        CFDictionarySetValue(_delegateToTaskGroupsMap, delegate, taskGroupsForDelegate);
+    }
+    [taskGroupsForDelegate addObject:taskGroup]; 
+}
+
+- (void)unregisterDelegateForTask:(HLSTask *)task
+{
+    // Find if a delegate has been defined for this task; use the task pointer as key
+    id<HLSTaskDelegate> delegate = (id<HLSTaskDelegate>)CFDictionaryGetValue(_taskToDelegateMap, task);
+    if (! delegate) {
+        return;
+    }
+    
+    // Remove the task - delegate relationship (see remark in -registerDelegate:forTask:)
+    CFDictionaryRemoveValue(_taskToDelegateMap, task);
+    CFDictionaryRemoveValue(_taskToDelegateMethodsMap, task);
+    
+    // Remove the inverse delegate - task relationship; use the delegate pointer as key
+    NSMutableSet *tasksForDelegate = (NSMutableSet *)CFDictionaryGetValue(_delegateToTasksMap, delegate);
+    [tasksForDelegate removeObject:task];
+    
+    // If the set is now empty for this delegate, then remove the dictionary entry as well
+    if ([tasksForDelegate count] == 0) {
+        CFDictionaryRemoveValue(_delegateToTasksMap, delegate);
+    }
+}
+
+- (void)unregisterDelegateForTaskGroup:(HLSTaskGroup *)taskGroup
+{
+    // Find if a delegate has been defined for this task group; use the task pointer as key
+    id<HLSTaskGroupDelegate> delegate = (id<HLSTaskGroupDelegate>)CFDictionaryGetValue(_taskGroupToDelegateMap, taskGroup);
+    if (! delegate) {
+        return;
+    }
+    
+    // Remove the task group - delegate relationship
+    CFDictionaryRemoveValue(_taskGroupToDelegateMap, taskGroup);
+    CFDictionaryRemoveValue(_taskGroupToDelegateMethodsMap, taskGroup);
+    
+    // Remove the inverse delegate - task group relationship
+    NSMutableSet *taskGroupsForDelegate = (NSMutableSet *)CFDictionaryGetValue(_delegateToTaskGroupsMap, delegate);
+    [taskGroupsForDelegate removeObject:taskGroup];
+    
+    // If the set is now empty for this delegate, then remove the dictionary entry as well
+    if ([taskGroupsForDelegate count] == 0) {
+        CFDictionaryRemoveValue(_delegateToTaskGroupsMap, delegate);
+    }
+}
+
+- (void)unregisterDelegateAndCancelAssociatedTasks:(id)delegate
+{
+    // Cancel tasks first (had we unregistered first, we would have lost track of the delegate - task 
+    // relationships, cancelling nothing!) 
+    [self cancelTasksWithDelegate:delegate];
+    [self unregisterDelegate:delegate];
+}
+
+- (void)unregisterDelegate:(id)delegate
+{
+    // Find all tasks for this delegate, and unregister; use the delegate pointer as key
+    NSSet *tasksForDelegate = [NSSet setWithSet:(NSSet *)CFDictionaryGetValue(_delegateToTasksMap, delegate)];
+    for (HLSTask *task in tasksForDelegate) {
+        [self unregisterDelegateForTask:task];
+    }
+    
+    // Same for task groups
+    NSSet *taskGroupsForDelegate = [NSSet setWithSet:(NSSet *)CFDictionaryGetValue(_delegateToTaskGroupsMap, delegate)];
+    for (HLSTaskGroup *taskGroup in taskGroupsForDelegate) {
+        [self unregisterDelegateForTaskGroup:taskGroup];
+    }
+    
+    // Paused tasks are resumed without delegate
+    for (HLSTask *pausedTask in self.pausedTasks) {
+        if (CFDictionaryGetValue(_pausedTaskToDelegateMap, pausedTask) == delegate) {
+            CFDictionaryRemoveValue(_pausedTaskToDelegateMap, pausedTask);
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Instantiating operations for tasks
+
+- (HLSTaskOperation *)operationForTask:(HLSTask *)task
+{
+    Class operationClass = [task operationClass];
+    NSAssert([operationClass isSubclassOfClass:[HLSTaskOperation class]], @"Class %@ is not a subclass of HLSTaskOperation", operationClass);
+    return [[[operationClass alloc] initWithTaskManager:self task:task] autorelease];
+}
+
+#pragma mark -
+#pragma mark Scheduling operations
+
+- (void)scheduleOperations:(NSArray *)operations withPriority:(HLSTaskPriority)priority
+{
+    static const NSOperationQueuePriority s_queuePriorities[] = {
+        NSOperationQueuePriorityLow,                    // HLSTaskPriorityLow
+        NSOperationQueuePriorityNormal,                 // HLSTaskPriorityNormal
+        NSOperationQueuePriorityHigh                    // HLSTaskPriorityHigh
+    };
+    static const double s_threadPriorities[] = {
+        0.25,                                           // HLSTaskPriorityLow
+        0.5,                                            // HLSTaskPriorityNormal (system default)
+        0.75                                            // HLSTaskPriorityHigh
+    };
+    
+    if (priority >= HLSTaskPriorityEnumEnd) {
+        HLSLoggerError(@"Invalid priority; normal priority used instead");
+        priority = HLSTaskPriorityNormal;
+    }
+    
+    for (HLSTaskOperation *operation in operations) {
+        [operation setQueuePriority:s_queuePriorities[priority]];
+        [operation setThreadPriority:s_threadPriorities[priority]];
+    }
+    
+    // Tasks submitted while in the background are only started if there is enough background time left
+    if (self.backgroundGateOperation) {
+        [self holdOperationsInBackground:operations];
+    }
+    
+    // Add all operations at once, or let the fair-share scheduler decide when to add them
+    NSOperationQueue *operationQueue = self.usingSeparateQueuesPerPriority ? [self.priorityOperationQueues objectAtIndex:priority] : self.operationQueue;
+    if (self.usingFairShareScheduling) {
+        for (HLSTaskOperation *operation in operations) {
+            [self holdOperation:operation forQueue:operationQueue];
+        }
+        [self releaseHeldOperations];
+    }
+    else {
+        [operationQueue addOperations:operations waitUntilFinished:NO];
+    }
+}
+
+#pragma mark -
+#pragma mark Fair-share scheduling
+
+- (void)setFairShareWeight:(NSUInteger)weight forTag:(NSString *)tagOrNil
+{
+    if (weight == 0) {
+        HLSLoggerError(@"The fair-share weight must be >= 1; not changed");
+        return;
+    }
+    
+    id tagKey = tagOrNil ? tagOrNil : [NSNull null];
+    [self.tagToFairShareWeightMap setObject:[NSNumber numberWithUnsignedInteger:weight] forKey:tagKey];
+}
+
+- (void)setMaxConcurrentTaskCount:(NSUInteger)count forTag:(NSString *)tagOrNil
+{
+    id tagKey = tagOrNil ? tagOrNil : [NSNull null];
+    if (count == 0) {
+        [self.tagToMaxConcurrentTaskCountMap removeObjectForKey:tagKey];
+    }
+    else {
+        [self.tagToMaxConcurrentTaskCountMap setObject:[NSNumber numberWithUnsignedInteger:count] forKey:tagKey];
+    }
+    
+    [self releaseHeldOperations];
+}
+
+- (id)fairShareTagKeyForOperation:(HLSTaskOperation *)operation
+{
+    NSString *tag = operation.task.tag ? operation.task.tag : operation.task.taskGroup.tag;
+    return tag ? tag : [NSNull null];
+}
+
+- (void)holdOperation:(HLSTaskOperation *)operation forQueue:(NSOperationQueue *)operationQueue
+{
+    id tagKey = [self fairShareTagKeyForOperation:operation];
+    NSMutableArray *heldOperations = [self.tagToHeldOperationsMap objectForKey:tagKey];
+    // Create the array lazily if it does not exist
+    if (! heldOperations) {
+        heldOperations = [NSMutableArray array];
+        [self.tagToHeldOperationsMap setObject:heldOperations forKey:tagKey];
+    }
+    
+    // Keep operations sorted by priority, and in submission order for equal priorities
+    NSUInteger index = [heldOperations count];
+    while (index > 0 && [[heldOperations objectAtIndex:index - 1] queuePriority] < [operation queuePriority]) {
+        --index;
+    }
+    [heldOperations insertObject:operation atIndex:index];
+    
+    CFDictionarySetValue(_heldOperationToQueueMap, operation, operationQueue);
+}
+
+// Operations are only released when they can start right away, otherwise operations waiting for held operations
+// could use up all slots and never be started
+- (BOOL)isHeldOperationReady:(HLSTaskOperation *)operation
+{
+    for (NSOperation *dependency in [operation dependencies]) {
+        if ([dependency isFinished] || [dependency isCancelled]) {
+            continue;
+        }
+        
+        // The end of an operation is notified (and its task marked as finished) slightly before it is set as finished
+        if ([dependency isKindOfClass:[HLSTaskOperation class]] && ((HLSTaskOperation *)dependency).task.finished) {
+            continue;
+        }
+        
+        return NO;
+    }
+    return YES;
+}
+
+// Smooth weighted round-robin: In each round, all tags having a ready operation (and not having reached their limit) 
+// get their current weight increased by their weight. The tag with the highest current weight is picked, and its 
+// current weight decreased by the sum of the weights. This interleaves tags evenly in proportion of their weights
+- (void)releaseHeldOperations
+{
+    while ((NSInteger)[self.releasedOperations count] < [self.operationQueue maxConcurrentOperationCount]) {
+        id selectedTagKey = nil;
+        HLSTaskOperation *selectedOperation = nil;
+        NSInteger selectedCurrentWeight = 0;
+        NSInteger weightSum = 0;
+        for (id tagKey in [self.tagToHeldOperationsMap allKeys]) {
+            NSNumber *maxConcurrentTaskCount = [self.tagToMaxConcurrentTaskCountMap objectForKey:tagKey];
+            if (maxConcurrentTaskCount 
+                    && [[self.tagToReleasedOperationCountMap objectForKey:tagKey] unsignedIntegerValue] >= [maxConcurrentTaskCount unsignedIntegerValue]) {
+                continue;
+            }
+            
+            HLSTaskOperation *readyOperation = nil;
+            for (HLSTaskOperation *heldOperation in [self.tagToHeldOperationsMap objectForKey:tagKey]) {
+                if ([self isHeldOperationReady:heldOperation]) {
+                    readyOperation = heldOperation;
+                    break;
+                }
+            }
+            if (! readyOperation) {
+                continue;
+            }
+            
+            NSNumber *weight = [self.tagToFairShareWeightMap objectForKey:tagKey];
+            NSInteger weightValue = weight ? [weight integerValue] : 1;
+            NSInteger currentWeight = [[self.tagToFairShareCurrentWeightMap objectForKey:tagKey] integerValue] + weightValue;
+            [self.tagToFairShareCurrentWeightMap setObject:[NSNumber numberWithInteger:currentWeight] forKey:tagKey];
+            weightSum += weightValue;
+            
+            if (! selectedOperation || currentWeight > selectedCurrentWeight) {
+                selectedTagKey = tagKey;
+                selectedOperation = readyOperation;
+                selectedCurrentWeight = currentWeight;
+            }
+        }
+        
+        if (! selectedOperation) {
+            break;
+        }
+        
+        [self.tagToFairShareCurrentWeightMap setObject:[NSNumber numberWithInteger:selectedCurrentWeight - weightSum]
+                                                forKey:selectedTagKey];
+        
+        NSUInteger releasedOperationCount = [[self.tagToReleasedOperationCountMap objectForKey:selectedTagKey] unsignedIntegerValue];
+        [self.tagToReleasedOperationCountMap setObject:[NSNumber numberWithUnsignedInteger:releasedOperationCount + 1]
+                                                forKey:selectedTagKey];
+        [self.releasedOperations addObject:selectedOperation];
+        [self releaseHeldOperation:selectedOperation];
+    }
+}
+
+- (void)releaseHeldOperation:(HLSTaskOperation *)operation
+{
+    // Retain since removing the operation from the collections below might release it
+    [[operation retain] autorelease];
+    
+    id tagKey = [self fairShareTagKeyForOperation:operation];
+    NSMutableArray *heldOperations = [self.tagToHeldOperationsMap objectForKey:tagKey];
+    [heldOperations removeObjectIdenticalTo:operation];
+    if ([heldOperations count] == 0) {
+        [self.tagToHeldOperationsMap removeObjectForKey:tagKey];
+        [self.tagToFairShareCurrentWeightMap removeObjectForKey:tagKey];
+    }
+    
+    NSOperationQueue *operationQueue = (NSOperationQueue *)CFDictionaryGetValue(_heldOperationToQueueMap, operation);
+    [[operationQueue retain] autorelease];
+    CFDictionaryRemoveValue(_heldOperationToQueueMap, operation);
+    [operationQueue addOperation:operation];
+}
+
+- (void)releaseAllHeldOperations
+{
+    for (NSArray *heldOperations in [self.tagToHeldOperationsMap allValues]) {
+        for (HLSTaskOperation *heldOperation in [NSArray arrayWithArray:heldOperations]) {
+            [self releaseHeldOperation:heldOperation];
+        }
+    }
+}
+
+- (void)removeOperationFromFairShareScheduler:(HLSTaskOperation *)operation
+{
+    if ([self.releasedOperations containsObject:operation]) {
+        id tagKey = [self fairShareTagKeyForOperation:operation];
+        NSUInteger releasedOperationCount = [[self.tagToReleasedOperationCountMap objectForKey:tagKey] unsignedIntegerValue];
+        if (releasedOperationCount > 1) {
+            [self.tagToReleasedOperationCountMap setObject:[NSNumber numberWithUnsignedInteger:releasedOperationCount - 1]
+                                                    forKey:tagKey];
+        }
+        else {
+            [self.tagToReleasedOperationCountMap removeObjectForKey:tagKey];
+        }
+        [self.releasedOperations removeObject:operation];
+    }
+    // Operations removed while held have been cancelled. They must still be queued (they finish immediately) so that 
+    // the operations depending on them are not blocked forever
+    else if (CFDictionaryGetValue(_heldOperationToQueueMap, operation)) {
+        [self releaseHeldOperation:operation];
+    }
+}
+
+#pragma mark -
+#pragma mark Memory pressure
+
+// Operations are held back by making them depend on a gate operation which is only added to a queue (and thus
+// finishes immediately) when memory pressure is gone
+- (void)deferOperations:(NSArray *)operations
+{
+    for (HLSTaskOperation *operation in operations) {
+        [operation addDependency:self.deferredTaskGroupsGateOperation];
+    }
+}
+
+- (void)memoryPressureRecoveryTimerFired:(NSTimer *)timer
+{
+    HLSLoggerInfo(@"No memory warning received recently; resuming normal task processing");
+    
+    self.memoryPressureRecoveryTimer = nil;
+    self.underMemoryPressure = NO;
+    
+    [self.operationQueue setMaxConcurrentOperationCount:_savedMaxConcurrentTaskCount];
+    for (NSUInteger i = 0; i < HLSTaskPriorityEnumSize; ++i) {
+        NSOperationQueue *priorityOperationQueue = [self.priorityOperationQueues objectAtIndex:i];
+        [priorityOperationQueue setMaxConcurrentOperationCount:_savedPriorityMaxConcurrentTaskCounts[i]];
+    }
+    [self resetAdaptiveSampling];
+    
+    // Release deferred operations
+    [self.operationQueue addOperation:self.deferredTaskGroupsGateOperation];
+    self.deferredTaskGroupsGateOperation = nil;
+    
+    [self releaseHeldOperations];
+}
+
+#pragma mark -
+#pragma mark Background execution
+
+- (void)beginBackgroundExecution
+{
+    if (_backgroundTaskIdentifier != UIBackgroundTaskInvalid) {
+        return;
+    }
+    
+    // The expiration handler is called on the main thread
+    _backgroundTaskIdentifier = [[UIApplication sharedApplication] beginBackgroundTaskWithExpirationHandler:^{
+        HLSLoggerWarn(@"Background execution time has expired");
+        [self pauseTasksNotFinishingInTimeInterval:0.];
+        [self endBackgroundExecution];
+    }];
+    if (_backgroundTaskIdentifier == UIBackgroundTaskInvalid) {
+        HLSLoggerWarn(@"Background execution time could not be obtained");
+        return;
+    }
+    
+    HLSLoggerInfo(@"Background execution started with %d pending tasks", [self pendingTaskCount]);
+    
+    // Hold back all operations which have not been started yet, and start them when possible
+    self.backgroundGateOperation = [NSBlockOperation blockOperationWithBlock:^{}];
+    NSMutableArray *pendingOperations = [NSMutableArray array];
+    for (HLSTask *task in self.tasks) {
+        // Duplicate tasks have no associated operation
+        HLSTaskOperation *operation = (HLSTaskOperation *)CFDictionaryGetValue(_taskToOperationMap, task);
+        if (! operation || [operation isExecuting] || [operation isFinished] || [operation isCancelled]) {
+            continue;
+        }
+        [pendingOperations addObject:operation];
+    }
+    [self holdOperationsInBackground:pendingOperations];
+    [self releaseBackgroundHeldOperations];
+    
+    self.backgroundSchedulingTimer = [NSTimer scheduledTimerWithTimeInterval:kBackgroundSchedulingTimeInterval
+                                                                      target:self
+                                                                    selector:@selector(backgroundSchedulingTimerFired:)
+                                                                    userInfo:nil
+                                                                     repeats:YES];
 }
 
-- (void)unregisterDelegate:(id)delegate
+- (void)endBackgroundExecution
 {
-    // Find all tasks for this delegate, and unregister; use the delegate pointer as key
-    NSValue *delegateKey = [NSValue valueWithPointer:delegate];
-    NSSet *tasksForDelegate = [NSSet setWithSet:[self.delegateToTasksMap objectForKey:delegateKey]];
-    for (HLSTask *task in tasksForDelegate) {
-        [self unregisterDelegateForTask:task];
+    [self.backgroundSchedulingTimer invalidate];
+    self.backgroundSchedulingTimer = nil;
+    
+    // Release held operations. If still in the background, they will be suspended with the application
+    if (self.backgroundGateOperation) {
+        [self.backgroundHeldOperations removeAllObjects];
+        [self.operationQueue addOperation:self.backgroundGateOperation];
+        self.backgroundGateOperation = nil;
     }
     
-    // Same for task groups
-    NSSet *taskGroupsForDelegate = [NSSet setWithSet:[self.delegateToTaskGroupsMap objectForKey:delegateKey]];
-    for (HLSTaskGroup *taskGroup in taskGroupsForDelegate) {
-        [self unregisterDelegateForTaskGroup:taskGroup];
+    if (_backgroundTaskIdentifier == UIBackgroundTaskInvalid) {
+        return;
+    }
+    
+    HLSLoggerInfo(@"Background execution ended with %d pending tasks", [self pendingTaskCount]);
+    [[UIApplication sharedApplication] endBackgroundTask:_backgroundTaskIdentifier];
+    _backgroundTaskIdentifier = UIBackgroundTaskInvalid;
+}
+
+// Operations are held back by making them depend on a gate operation which is never added to a queue while held
+// operations are released individually, and which is added to a queue (and thus finishes immediately) when
+// background execution ends
+- (void)holdOperationsInBackground:(NSArray *)operations
+{
+    for (HLSTaskOperation *operation in operations) {
+        [operation addDependency:self.backgroundGateOperation];
+    }
+    [self.backgroundHeldOperations addObjectsFromArray:operations];
+}
+
+// Start held operations in free slots while there is enough background time left. Tasks resumed from a checkpoint
+// come first since they are closer to finishing, then tasks with higher priorities
+- (void)releaseBackgroundHeldOperations
+{
+    if ([self.backgroundHeldOperations count] == 0) {
+        return;
+    }
+    
+    if (doublele([UIApplication sharedApplication].backgroundTimeRemaining, self.backgroundStartMinimumTimeInterval)) {
+        return;
+    }
+    
+    NSInteger nbrExecutingOperations = 0;
+    for (HLSTask *task in self.tasks) {
+        HLSTaskOperation *operation = (HLSTaskOperation *)CFDictionaryGetValue(_taskToOperationMap, task);
+        if ([operation isExecuting]) {
+            ++nbrExecutingOperations;
+        }
+    }
+    
+    NSInteger nbrSlots = [self maxConcurrentTaskCount] - nbrExecutingOperations;
+    if (nbrSlots <= 0) {
+        return;
+    }
+    
+    NSArray *sortedOperations = [self.backgroundHeldOperations sortedArrayUsingComparator:^(id object1, id object2) {
+        HLSTask *task1 = [(HLSTaskOperation *)object1 task];
+        HLSTask *task2 = [(HLSTaskOperation *)object2 task];
+        if ((task1.resumeToken != nil) != (task2.resumeToken != nil)) {
+            return task1.resumeToken ? NSOrderedAscending : NSOrderedDescending;
+        }
+        HLSTaskPriority priority1 = task1.taskGroup ? task1.taskGroup.priority : task1.priority;
+        HLSTaskPriority priority2 = task2.taskGroup ? task2.taskGroup.priority : task2.priority;
+        if (priority1 != priority2) {
+            return (priority1 > priority2) ? NSOrderedAscending : NSOrderedDescending;
+        }
+        return NSOrderedSame;
+    }];
+    
+    for (HLSTaskOperation *operation in sortedOperations) {
+        if (nbrSlots == 0) {
+            break;
+        }
+        
+        // Operations still waiting for other ones are released without using a slot
+        BOOL waiting = NO;
+        for (NSOperation *dependency in [operation dependencies]) {
+            if (dependency != self.backgroundGateOperation && ! [dependency isFinished]) {
+                waiting = YES;
+                break;
+            }
+        }
+        
+        [operation removeDependency:self.backgroundGateOperation];
+        [self.backgroundHeldOperations removeObjectIdenticalTo:operation];
+        if (! waiting) {
+            --nbrSlots;
+        }
+    }
+}
+
+// Cancel running single tasks with a checkpoint key which are not expected to finish within the given time interval, 
+// and keep them for resubmission in the foreground
+- (void)pauseTasksNotFinishingInTimeInterval:(NSTimeInterval)timeInterval
+{
+    NSMutableArray *tasksToPause = [NSMutableArray array];
+    for (HLSTask *task in self.tasks) {
+        if (! task.checkpointKey || task.taskGroup) {
+            continue;
+        }
+        
+        HLSTaskOperation *operation = (HLSTaskOperation *)CFDictionaryGetValue(_taskToOperationMap, task);
+        if (! [operation isExecuting]) {
+            continue;
+        }
+        
+        NSTimeInterval remainingTimeIntervalEstimate = task.remainingTimeIntervalEstimate;
+        if (! doubleeq(remainingTimeIntervalEstimate, kTaskNoTimeIntervalEstimateAvailable)
+                && doublele(remainingTimeIntervalEstimate, timeInterval)) {
+            continue;
+        }
+        
+        [tasksToPause addObject:task];
+    }
+    
+    if ([tasksToPause count] == 0) {
+        return;
+    }
+    
+    HLSLoggerInfo(@"Pausing %d tasks which cannot finish in the remaining background time", [tasksToPause count]);
+    
+    // Delegate registrations are removed when the tasks end
+    for (HLSTask *task in tasksToPause) {
+        id<HLSTaskDelegate> delegate = [self delegateForTask:task implementedMethods:NULL];
+        if (delegate) {
+            CFDictionarySetValue(_pausedTaskToDelegateMap, task, delegate);
+        }
+    }
+    [self cancelTasks:tasksToPause];
+    [self.pausedTasks addObjectsFromArray:tasksToPause];
+}
+
+- (void)removePausedTask:(HLSTask *)task
+{
+    if (! [self.pausedTasks containsObject:task]) {
+        return;
+    }
+    
+    CFDictionaryRemoveValue(_pausedTaskToDelegateMap, task);
+    [self.pausedTasks removeObjectIdenticalTo:task];
+}
+
+- (void)resumePausedTasks
+{
+    if ([self.pausedTasks count] == 0) {
+        return;
+    }
+    
+    HLSLoggerInfo(@"Resuming %d tasks paused in the background", [self.pausedTasks count]);
+    
+    // Resume from the last checkpoints
+    NSMutableDictionary *checkpointKeyToResumeTokenMap = [NSMutableDictionary dictionary];
+    for (HLSTask *checkpointedTask in [HLSTask checkpointedTasks]) {
+        if (checkpointedTask.resumeToken) {
+            [checkpointKeyToResumeTokenMap setObject:checkpointedTask.resumeToken forKey:checkpointedTask.checkpointKey];
+        }
+    }
+    
+    NSArray *pausedTasks = [NSArray arrayWithArray:self.pausedTasks];
+    for (HLSTask *task in pausedTasks) {
+        task.resumeToken = [checkpointKeyToResumeTokenMap objectForKey:task.checkpointKey];
+        
+        id<HLSTaskDelegate> delegate = (id<HLSTaskDelegate>)CFDictionaryGetValue(_pausedTaskToDelegateMap, task);
+        if (delegate) {
+            [self registerDelegate:delegate forTask:task];
+        }
+    }
+    [self.pausedTasks removeAllObjects];
+    CFDictionaryRemoveAllValues(_pausedTaskToDelegateMap);
+    
+    [self submitTasks:pausedTasks];
+}
+
+- (void)backgroundSchedulingTimerFired:(NSTimer *)timer
+{
+    NSTimeInterval backgroundTimeRemaining = [UIApplication sharedApplication].backgroundTimeRemaining;
+    if (doublele(backgroundTimeRemaining, self.backgroundPauseTimeInterval)) {
+        [self pauseTasksNotFinishingInTimeInterval:backgroundTimeRemaining];
+    }
+    [self releaseBackgroundHeldOperations];
+    
+    // Give background time back as soon as no task is running anymore and no held task can be started
+    BOOL executing = NO;
+    for (HLSTask *task in self.tasks) {
+        HLSTaskOperation *operation = (HLSTaskOperation *)CFDictionaryGetValue(_taskToOperationMap, task);
+        if ([operation isExecuting]) {
+            executing = YES;
+            break;
+        }
+    }
+    
+    if (! executing && ([self.backgroundHeldOperations count] == 0
+                        || doublele(backgroundTimeRemaining, self.backgroundStartMinimumTimeInterval))) {
+        [self endBackgroundExecution];
     }
 }
 
 #pragma mark -
-#pragma mark Instantiating operations for a set of tasks
+#pragma mark Task deadlines
 
-- (NSSet *)operationsForTasks:(NSSet *)tasks
+- (NSMutableSet *)deadlineWheelSlotForTime:(CFAbsoluteTime)time
 {
-    NSMutableSet *operations = [NSMutableSet set];
-    for (HLSTask *task in tasks) {
-        Class operationClass = [task operationClass];
-        NSAssert([operationClass isSubclassOfClass:[HLSTaskOperation class]], @"Class %@ is not a subclass of HLSTaskOperation", operationClass);
-        HLSTaskOperation *operation = [[[operationClass alloc] initWithTaskManager:self
-                                                                              task:task]
-                                       autorelease];
-        [operations addObject:operation];
+    NSUInteger tick = (NSUInteger)ceil((time - _deadlineWheelOriginTime) / kDeadlineWheelTickTimeInterval);
+    return [self.deadlineWheelSlots objectAtIndex:tick % kDeadlineWheelSlotCount];
+}
+
+- (void)scheduleDeadlineForTask:(HLSTask *)task
+{
+    if (doublele(task.timeoutInterval, 0.)) {
+        return;
+    }
+    
+    CFAbsoluteTime currentTime = CFAbsoluteTimeGetCurrent();
+    CFAbsoluteTime deadline = currentTime + task.timeoutInterval;
+    CFDictionarySetValue(_taskToDeadlineMap, task, [NSNumber numberWithDouble:deadline]);
+    [[self deadlineWheelSlotForTime:deadline] addObject:task];
+    
+    // Start the wheel if it was idle
+    if (! self.deadlineWheelTimer) {
+        _deadlineWheelTick = (NSUInteger)floor((currentTime - _deadlineWheelOriginTime) / kDeadlineWheelTickTimeInterval);
+        self.deadlineWheelTimer = [NSTimer scheduledTimerWithTimeInterval:kDeadlineWheelTickTimeInterval
+                                                                   target:self
+                                                                 selector:@selector(deadlineWheelTimerFired:)
+                                                                 userInfo:nil
+                                                                  repeats:YES];
+    }
+}
+
+- (void)unscheduleDeadlineForTask:(HLSTask *)task
+{
+    NSNumber *deadline = (NSNumber *)CFDictionaryGetValue(_taskToDeadlineMap, task);
+    if (! deadline) {
+        return;
+    }
+    
+    [[self deadlineWheelSlotForTime:[deadline doubleValue]] removeObject:task];
+    CFDictionaryRemoveValue(_taskToDeadlineMap, task);
+    
+    // Stop the wheel when no deadline is left
+    if (CFDictionaryGetCount(_taskToDeadlineMap) == 0) {
+        [self.deadlineWheelTimer invalidate];
+        self.deadlineWheelTimer = nil;
+    }
+}
+
+- (void)deadlineWheelTimerFired:(NSTimer *)timer
+{
+    CFAbsoluteTime currentTime = CFAbsoluteTimeGetCurrent();
+    NSUInteger currentTick = (NSUInteger)floor((currentTime - _deadlineWheelOriginTime) / kDeadlineWheelTickTimeInterval);
+    if (currentTick <= _deadlineWheelTick) {
+        return;
+    }
+    
+    // Visit all slots whose tick has been reached since the last time (the timer might have fired late), but each
+    // slot at most once
+    NSUInteger firstTick = MAX(_deadlineWheelTick + 1, currentTick + 1 - MIN(currentTick + 1, kDeadlineWheelSlotCount));
+    NSMutableArray *expiredTasks = [NSMutableArray array];
+    for (NSUInteger tick = firstTick; tick <= currentTick; ++tick) {
+        NSMutableSet *slot = [self.deadlineWheelSlots objectAtIndex:tick % kDeadlineWheelSlotCount];
+        for (HLSTask *task in slot) {
+            // Deadlines of later wheel rotations are skipped
+            NSNumber *deadline = (NSNumber *)CFDictionaryGetValue(_taskToDeadlineMap, task);
+            if ([deadline doubleValue] <= currentTime) {
+                [expiredTasks addObject:task];
+            }
+        }
+    }
+    _deadlineWheelTick = currentTick;
+    
+    if ([expiredTasks count] == 0) {
+        return;
+    }
+    
+    for (HLSTask *task in expiredTasks) {
+        HLSLoggerDebug(@"Task %@ has exceeded its time budget of %.2f s and is cancelled", task, task.timeoutInterval);
+        [self unscheduleDeadlineForTask:task];
     }
-    return operations;
+    [self cancelTasks:expiredTasks];
 }
 
 #pragma mark -
@@ -499,31 +1950,65 @@
 {
     // Keep a strong reference to the operation
     [self.tasks addObject:operation.task];
+    [self scheduleDeadlineForTask:operation.task];
     
     // Save the relationship between task and operation; use the task pointer as key
-    NSValue *taskKey = [NSValue valueWithPointer:operation.task];
-    [self.taskToOperationMap setObject:operation forKey:taskKey];
+    CFDictionarySetValue(_taskToOperationMap, operation.task, operation);
 }
 
 - (void)unregisterOperation:(HLSTaskOperation *)operation
 {
     // Unregister the associated task - operation relationship; use the task pointer as key
-    NSValue *taskKey = [NSValue valueWithPointer:operation.task];
-    [self.taskToOperationMap removeObjectForKey:taskKey];   
+    CFDictionaryRemoveValue(_taskToOperationMap, operation.task);
+    
+    // Tasks with an identity key: Update duplicates, cache results, and remove the identity key registration
+    NSString *identityKey = operation.task.identityKey;
+    if (identityKey && [self.identityKeyToTaskMap objectForKey:identityKey] == operation.task) {
+        [self endDuplicatesOfTask:operation.task];
+        
+        if (operation.task.finished && ! operation.task.cancelled && ! [operation isCancelled] 
+                && ! operation.task.error && operation.task.returnInfo) {
+            [self cacheReturnInfo:operation.task.returnInfo forIdentityKey:identityKey];
+        }
+        
+        [self.identityKeyToTaskMap removeObjectForKey:identityKey];
+    }
     
     // Automatically cleanup delegate registrations
     [self unregisterDelegateForTask:operation.task];
     
+    // Durable tasks are not needed anymore, whatever their outcome
+    [self.journal recordEndOfTask:operation.task];
+    
+    [self.metrics recordCompletionOfObject:operation.task cancelled:operation.task.cancelled || [operation isCancelled]];
+    
+    // Continuations are only processed if the task they continue was successful
+    if (operation.task.cancelled || [operation isCancelled] || operation.task.error || ! operation.task.finished) {
+        [self cancelTasks:[operation.task continuations]];
+    }
+    
     // If the task is part of a task group, unregister it if all task group operations are complete
     HLSTaskGroup *taskGroup = operation.task.taskGroup;
     if (taskGroup) {
         if (taskGroup.finished) {
+            [self.metrics recordCompletionOfObject:taskGroup cancelled:taskGroup.cancelled];
             [self unregisterTaskGroup:taskGroup];
         }        
     }
     
-    // Finally, release the strong ref to the task
+    // Finally, release the strong ref to the task, and let another operation start
+    [self unscheduleDeadlineForTask:operation.task];
+    [self removeOperationFromFairShareScheduler:operation];
     [self.tasks removeObject:operation.task];
+    [self releaseHeldOperations];
+    
+    // Operations cancelled while held in the background must not wait for the gate to finish. Give the remaining
+    // background time to the next held operations
+    if (self.backgroundGateOperation) {
+        [operation removeDependency:self.backgroundGateOperation];
+        [self.backgroundHeldOperations removeObjectIdenticalTo:operation];
+        [self releaseBackgroundHeldOperations];
+    }
 }
 
 - (void)registerTaskGroup:(HLSTaskGroup *)taskGroup
@@ -541,19 +2026,320 @@
     [self.taskGroups removeObject:taskGroup];
 }
 
+#pragma mark -
+#pragma mark Duplicate tasks
+
+- (void)registerDuplicateTask:(HLSTask *)duplicateTask forTask:(HLSTask *)task
+{
+    HLSLoggerDebug(@"Task %@ has the same identity key as task %@, which is already running. Mirror it", duplicateTask, task);
+    
+    [duplicateTask reset];
+    
+    // Keep a strong ref to the duplicate task
+    [self.tasks addObject:duplicateTask];
+    [self scheduleDeadlineForTask:duplicateTask];
+    
+    NSMutableArray *duplicateTasks = (NSMutableArray *)CFDictionaryGetValue(_taskToDuplicateTasksMap, task);
+    // Create the array lazily if it does not exist
+    if (! duplicateTasks) {
+        duplicateTasks = [NSMutableArray array];
+        CFDictionarySetValue(_taskToDuplicateTasksMap, task, duplicateTasks);
+    }
+    [duplicateTasks addObject:duplicateTask];
+    
+    // Catch up if the task is already running
+    [self updateDuplicatesOfTask:task];
+}
+
+// Return YES iff the task was a duplicate task
+- (BOOL)cancelDuplicateTask:(HLSTask *)duplicateTask
+{
+    if (! duplicateTask.identityKey) {
+        return NO;
+    }
+    
+    HLSTask *task = [self.identityKeyToTaskMap objectForKey:duplicateTask.identityKey];
+    NSMutableArray *duplicateTasks = (NSMutableArray *)CFDictionaryGetValue(_taskToDuplicateTasksMap, task);
+    if (! [duplicateTasks containsObject:duplicateTask]) {
+        return NO;
+    }
+    
+    // Retain since removing the task from the collections below might release it
+    [[duplicateTask retain] autorelease];
+    [duplicateTasks removeObject:duplicateTask];
+    if ([duplicateTasks count] == 0) {
+        CFDictionaryRemoveValue(_taskToDuplicateTasksMap, task);
+    }
+    
+    HLSLoggerDebug(@"Task %@ has been cancelled", duplicateTask);
+    duplicateTask.cancelled = YES;
+    duplicateTask.finished = YES;
+    duplicateTask.running = NO;
+    
+    NSUInteger duplicateTaskDelegateMethods = 0;
+    id<HLSTaskDelegate> duplicateTaskDelegate = [self delegateForTask:duplicateTask implementedMethods:&duplicateTaskDelegateMethods];
+    if (duplicateTaskDelegateMethods & HLSTaskDelegateMethodHasBeenCancelled) {
+        [duplicateTaskDelegate taskHasBeenCancelled:duplicateTask];
+    }
+    
+    [self unregisterDelegateForTask:duplicateTask];
+    [self unscheduleDeadlineForTask:duplicateTask];
+    [self.tasks removeObject:duplicateTask];
+    return YES;
+}
+
+- (void)updateDuplicatesOfTask:(HLSTask *)task
+{
+    // Iterate over a copy, delegates might cancel duplicate tasks
+    NSArray *duplicateTasks = [NSArray arrayWithArray:(NSArray *)CFDictionaryGetValue(_taskToDuplicateTasksMap, task)];
+    for (HLSTask *duplicateTask in duplicateTasks) {
+        if (duplicateTask.finished) {
+            continue;
+        }
+        
+        NSUInteger duplicateTaskDelegateMethods = 0;
+        id<HLSTaskDelegate> duplicateTaskDelegate = [self delegateForTask:duplicateTask implementedMethods:&duplicateTaskDelegateMethods];
+        if (task.running && ! duplicateTask.running) {
+            duplicateTask.running = YES;
+            if (duplicateTaskDelegateMethods & HLSTaskDelegateMethodHasStartedProcessing) {
+                [duplicateTaskDelegate taskHasStartedProcessing:duplicateTask];
+            }
+        }
+        
+        if (duplicateTask.running) {
+            duplicateTask.progress = task.progress;
+            if (duplicateTaskDelegateMethods & HLSTaskDelegateMethodProgressUpdated) {
+                [duplicateTaskDelegate taskProgressUpdated:duplicateTask];
+            }
+        }
+    }
+}
+
+- (void)endDuplicatesOfTask:(HLSTask *)task
+{
+    NSArray *duplicateTasks = [NSArray arrayWithArray:(NSArray *)CFDictionaryGetValue(_taskToDuplicateTasksMap, task)];
+    CFDictionaryRemoveValue(_taskToDuplicateTasksMap, task);
+    
+    for (HLSTask *duplicateTask in duplicateTasks) {
+        [self endTask:duplicateTask mirroringTask:task];
+        [self unregisterDelegateForTask:duplicateTask];
+        [self unscheduleDeadlineForTask:duplicateTask];
+        [self.tasks removeObject:duplicateTask];
+    }
+}
+
+- (void)endTask:(HLSTask *)task mirroringTask:(HLSTask *)mirroredTask
+{
+    NSUInteger taskDelegateMethods = 0;
+    id<HLSTaskDelegate> taskDelegate = [self delegateForTask:task implementedMethods:&taskDelegateMethods];
+    
+    // Tasks which were pending when the mirrored task was cancelled never started
+    if (mirroredTask.cancelled || ! mirroredTask.finished) {
+        task.cancelled = YES;
+        task.finished = YES;
+        task.running = NO;
+        
+        HLSLoggerDebug(@"Task %@ has been cancelled", task);
+        if (taskDelegateMethods & HLSTaskDelegateMethodHasBeenCancelled) {
+            [taskDelegate taskHasBeenCancelled:task];
+        }
+    }
+    else {
+        task.returnInfo = mirroredTask.returnInfo;
+        task.error = mirroredTask.error;
+        if (! floateq(task.progress, mirroredTask.progress)) {
+            task.progress = mirroredTask.progress;
+            if (taskDelegateMethods & HLSTaskDelegateMethodProgressUpdated) {
+                [taskDelegate taskProgressUpdated:task];
+            }
+        }
+        task.finished = YES;
+        task.running = NO;
+        
+        HLSLoggerDebug(@"Task %@ has been processed", task);
+        if (taskDelegateMethods & HLSTaskDelegateMethodHasBeenProcessed) {
+            [taskDelegate taskHasBeenProcessed:task];
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Return information cache
+
+- (NSDictionary *)cachedReturnInfoForIdentityKey:(NSString *)identityKey
+{
+    NSDictionary *cacheEntry = [self.returnInfoCache objectForKey:identityKey];
+    if (! cacheEntry) {
+        return nil;
+    }
+    
+    // Expired entry (also when the cache has been disabled since)
+    NSDate *date = [cacheEntry objectForKey:kReturnInfoCacheDateKey];
+    if (-[date timeIntervalSinceNow] >= self.returnInfoCacheTimeInterval) {
+        [self.returnInfoCache removeObjectForKey:identityKey];
+        [self.returnInfoCacheIdentityKeys removeObject:identityKey];
+        return nil;
+    }
+    
+    // Most recently used
+    [self.returnInfoCacheIdentityKeys removeObject:identityKey];
+    [self.returnInfoCacheIdentityKeys addObject:identityKey];
+    
+    return [cacheEntry objectForKey:kReturnInfoCacheReturnInfoKey];
+}
+
+- (void)cacheReturnInfo:(NSDictionary *)returnInfo forIdentityKey:(NSString *)identityKey
+{
+    if (doublele(self.returnInfoCacheTimeInterval, 0.) || self.returnInfoCacheCapacity == 0) {
+        return;
+    }
+    
+    NSDictionary *cacheEntry = [NSDictionary dictionaryWithObjectsAndKeys:[NSDate date], kReturnInfoCacheDateKey,
+                                returnInfo, kReturnInfoCacheReturnInfoKey, nil];
+    [self.returnInfoCache setObject:cacheEntry forKey:identityKey];
+    [self.returnInfoCacheIdentityKeys removeObject:identityKey];
+    [self.returnInfoCacheIdentityKeys addObject:identityKey];
+    
+    // Discard the least recently used entry if the capacity is exceeded
+    if ([self.returnInfoCacheIdentityKeys count] > self.returnInfoCacheCapacity) {
+        [self.returnInfoCache removeObjectForKey:[self.returnInfoCacheIdentityKeys objectAtIndex:0]];
+        [self.returnInfoCacheIdentityKeys removeObjectAtIndex:0];
+    }
+}
+
+- (void)clearReturnInfoCache
+{
+    [self.returnInfoCache removeAllObjects];
+    [self.returnInfoCacheIdentityKeys removeAllObjects];
+}
+
+#pragma mark -
+#pragma mark HLSMemoryAccounting protocol implementation
+
+- (NSUInteger)memoryFootprint
+{
+    return [self.tasks count] * kTaskMemoryFootprint + [self.returnInfoCache count] * kReturnInfoCacheEntryMemoryFootprint;
+}
+
+// Pending tasks cannot be released. Memory warnings are still handled by throttling task processing (see below)
+- (NSUInteger)purgeMemory
+{
+    NSUInteger releasedMemoryFootprint = [self.returnInfoCache count] * kReturnInfoCacheEntryMemoryFootprint;
+    [self clearReturnInfoCache];
+    return releasedMemoryFootprint;
+}
+
+// Simulate the events which would have been received if the task had been processed
+- (void)processTask:(HLSTask *)task withCachedReturnInfo:(NSDictionary *)returnInfo
+{
+    HLSLoggerDebug(@"Task %@ is processed using cached return information", task);
+    
+    // Retain since unregistering the delegate below might release the task
+    [[task retain] autorelease];
+    
+    [task reset];
+    
+    NSUInteger taskDelegateMethods = 0;
+    id<HLSTaskDelegate> taskDelegate = [self delegateForTask:task implementedMethods:&taskDelegateMethods];
+    task.running = YES;
+    if (taskDelegateMethods & HLSTaskDelegateMethodHasStartedProcessing) {
+        [taskDelegate taskHasStartedProcessing:task];
+    }
+    
+    task.progress = 1.f;
+    if (taskDelegateMethods & HLSTaskDelegateMethodProgressUpdated) {
+        [taskDelegate taskProgressUpdated:task];
+    }
+    
+    task.returnInfo = returnInfo;
+    task.finished = YES;
+    task.running = NO;
+    if (taskDelegateMethods & HLSTaskDelegateMethodHasBeenProcessed) {
+        [taskDelegate taskHasBeenProcessed:task];
+    }
+    
+    [self unregisterDelegateForTask:task];
+}
+
+#pragma mark -
+#pragma mark Notification callbacks
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification
+{
+    HLSLoggerInfo(@"Memory warning received; throttling task processing");
+    
+    if (! self.underMemoryPressure) {
+        _savedMaxConcurrentTaskCount = [self.operationQueue maxConcurrentOperationCount];
+        [self.operationQueue setMaxConcurrentOperationCount:self.memoryPressureMaxConcurrentTaskCount];
+        for (NSUInteger i = 0; i < HLSTaskPriorityEnumSize; ++i) {
+            NSOperationQueue *priorityOperationQueue = [self.priorityOperationQueues objectAtIndex:i];
+            _savedPriorityMaxConcurrentTaskCounts[i] = [priorityOperationQueue maxConcurrentOperationCount];
+            [priorityOperationQueue setMaxConcurrentOperationCount:self.memoryPressureMaxConcurrentTaskCount];
+        }
+        
+        self.deferredTaskGroupsGateOperation = [NSBlockOperation blockOperationWithBlock:^{}];
+        self.underMemoryPressure = YES;
+    }
+    
+    NSMutableArray *deferredOperations = [NSMutableArray array];
+    for (HLSTask *task in [NSSet setWithSet:self.tasks]) {
+        // Duplicate tasks have no associated operation
+        HLSTaskOperation *operation = (HLSTaskOperation *)CFDictionaryGetValue(_taskToOperationMap, task);
+        if (! operation) {
+            continue;
+        }
+        
+        // Let operations release memory
+        [operation operationDidReceiveMemoryWarning];
+        
+        // Hold back pending operations of deferrable task groups (adding the same dependency again has no effect)
+        if (task.taskGroup.deferrable && ! [operation isExecuting] && ! [operation isFinished] && ! [operation isCancelled]) {
+            [deferredOperations addObject:operation];
+        }
+    }
+    [self deferOperations:deferredOperations];
+    
+    // Pressure is considered gone when no memory warning has been received for some time
+    [self.memoryPressureRecoveryTimer invalidate];
+    self.memoryPressureRecoveryTimer = [NSTimer scheduledTimerWithTimeInterval:self.memoryPressureRecoveryTimeInterval
+                                                                        target:self
+                                                                      selector:@selector(memoryPressureRecoveryTimerFired:)
+                                                                      userInfo:nil
+                                                                       repeats:NO];
+}
+
+- (void)applicationDidEnterBackground:(NSNotification *)notification
+{
+    if (! self.backgroundExecutionEnabled || [self pendingTaskCount] == 0) {
+        return;
+    }
+    
+    [self beginBackgroundExecution];
+}
+
+- (void)applicationWillEnterForeground:(NSNotification *)notification
+{
+    [self endBackgroundExecution];
+    [self resumePausedTasks];
+}
+
 #pragma mark -
 #pragma mark Retrieving registered delegates
 
-- (id<HLSTaskDelegate>)delegateForTask:(HLSTask *)task
+- (id<HLSTaskDelegate>)delegateForTask:(HLSTask *)task implementedMethods:(NSUInteger *)pImplementedMethods
 {
-    NSValue *taskKey = [NSValue valueWithPointer:task];
-    return [self.taskToDelegateMap objectForKey:taskKey];
+    if (pImplementedMethods) {
+        *pImplementedMethods = (NSUInteger)CFDictionaryGetValue(_taskToDelegateMethodsMap, task);
+    }
+    return (id<HLSTaskDelegate>)CFDictionaryGetValue(_taskToDelegateMap, task);
 }
 
-- (id<HLSTaskGroupDelegate>)delegateForTaskGroup:(HLSTaskGroup *)taskGroup
+- (id<HLSTaskGroupDelegate>)delegateForTaskGroup:(HLSTaskGroup *)taskGroup implementedMethods:(NSUInteger *)pImplementedMethods
 {
-    NSValue *taskGroupKey = [NSValue valueWithPointer:taskGroup];
-    return [self.taskGroupToDelegateMap objectForKey:taskGroupKey];
+    if (pImplementedMethods) {
+        *pImplementedMethods = (NSUInteger)CFDictionaryGetValue(_taskGroupToDelegateMethodsMap, taskGroup);
+    }
+    return (id<HLSTaskGroupDelegate>)CFDictionaryGetValue(_taskGroupToDelegateMap, taskGroup);
 }
 
 @end
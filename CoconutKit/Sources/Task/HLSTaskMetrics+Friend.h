@@ -0,0 +1,40 @@
+//
+//  HLSTaskMetrics+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTask.h"
+#import "HLSTaskMetrics.h"
+
+/**
+ * Interface meant to be used by friend classes of HLSTaskMetrics (= classes which must have access to private implementation
+ * details). Objects are HLSTask or HLSTaskGroup objects. All methods can be called from any thread
+ */
+@interface HLSTaskMetrics (Friend)
+
+/**
+ * Must be called when an object is submitted. Starts a new record for it
+ */
+- (void)recordSubmissionOfObject:(id)object;
+
+/**
+ * Must be called when processing of an object starts, respectively ends
+ */
+- (void)recordProcessingStartOfObject:(id)object;
+- (void)recordProcessingEndOfObject:(id)object;
+
+/**
+ * Must be called after delegate notifications have been delivered for a task, with the time it took. This time is also
+ * accounted for the task group the task belongs to, if any
+ */
+- (void)recordDelegateDispatchTimeInterval:(NSTimeInterval)timeInterval forTask:(HLSTask *)task;
+
+/**
+ * Must be called when an object has completed (successfully or not). Its record is then available for queries
+ */
+- (void)recordCompletionOfObject:(id)object cancelled:(BOOL)cancelled;
+
+@end
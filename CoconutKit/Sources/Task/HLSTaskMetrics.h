@@ -0,0 +1,86 @@
+//
+//  HLSTaskMetrics.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#define kTaskMetricsNoValueAvailable                                  -1.
+
+/**
+ * Time intervals which can be measured for tasks and task groups:
+ *   HLSTaskMetricQueueWaitTimeInterval: time elapsed between submission and start of processing
+ *   HLSTaskMetricRunTimeInterval: time spent processing
+ *   HLSTaskMetricDelegateDispatchTimeInterval: time spent on the calling thread delivering delegate notifications
+ *   HLSTaskMetricTotalTimeInterval: time elapsed between submission and completion
+ */
+typedef enum {
+    HLSTaskMetricEnumBegin = 0,
+    HLSTaskMetricQueueWaitTimeInterval = HLSTaskMetricEnumBegin,
+    HLSTaskMetricRunTimeInterval,
+    HLSTaskMetricDelegateDispatchTimeInterval,
+    HLSTaskMetricTotalTimeInterval,
+    HLSTaskMetricEnumEnd,
+    HLSTaskMetricEnumSize = HLSTaskMetricEnumEnd - HLSTaskMetricEnumBegin
+} HLSTaskMetric;
+
+/**
+ * Collects timestamps for the tasks and task groups processed by a task manager (submission, start and end of
+ * processing, completion, as well as the time spent notifying delegates). Metrics objects are not meant to be
+ * instantiated directly, use the metrics property of a task manager for which metrics have been enabled.
+ *
+ * Only the most recently completed tasks and task groups are kept (see maximumRecordCount), so that metrics can
+ * be left enabled during long sessions. Records can be queried or exported from any thread.
+ *
+ * Designated initializer: -init
+ */
+@interface HLSTaskMetrics : NSObject {
+@private
+    CFAbsoluteTime _referenceTime;              // Time origin of exported timelines
+    CFMutableDictionaryRef _objectToRecordMap;  // maps an HLSTask or HLSTaskGroup object (pointer) to its in-flight record
+    NSMutableArray *_records;                   // completed records, oldest first
+    NSUInteger _maximumRecordCount;
+}
+
+/**
+ * The maximum number of completed tasks and task groups to keep records for. When this number is exceeded, the
+ * oldest records are discarded. Default is 1000
+ */
+@property (nonatomic, assign) NSUInteger maximumRecordCount;
+
+/**
+ * The tags of the tasks, respectively task groups for which records are available
+ */
+- (NSArray *)taskTags;
+- (NSArray *)taskGroupTags;
+
+/**
+ * Return the number of records available for tasks, respectively task groups with a given tag. Use nil to count
+ * all records
+ */
+- (NSUInteger)recordCountForTasksWithTag:(NSString *)tagOrNil;
+- (NSUInteger)recordCountForTaskGroupsWithTag:(NSString *)tagOrNil;
+
+/**
+ * Return the percentile (between 0 and 100, e.g. 50 for the median or 95) of a metric for tasks, respectively task
+ * groups with a given tag. Use nil to compute the percentile over all records. Records for which the metric is
+ * not defined (e.g. run time interval for tasks cancelled before they started) are ignored. Returns
+ * kTaskMetricsNoValueAvailable if no value is available
+ */
+- (NSTimeInterval)percentile:(double)percentile ofMetric:(HLSTaskMetric)metric forTasksWithTag:(NSString *)tagOrNil;
+- (NSTimeInterval)percentile:(double)percentile ofMetric:(HLSTaskMetric)metric forTaskGroupsWithTag:(NSString *)tagOrNil;
+
+/**
+ * Return the completed records as a timeline in the Trace Event JSON format, which can be loaded into chrome://tracing
+ * or converted for Instruments. Queue wait and processing appear as separate slices, processing on the thread it was
+ * executed on
+ */
+- (NSString *)traceEventString;
+
+/**
+ * Discard all completed records
+ */
+- (void)clear;
+
+@end
@@ -0,0 +1,434 @@
+//
+//  HLSTaskMetrics.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskMetrics.h"
+
+#import <pthread.h>
+#import "HLSLogger.h"
+#import "HLSTaskGroup.h"
+#import "HLSTaskMetrics+Friend.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
+
+// Thread identifier used in traces for events which are not associated with a worker thread (queue waits)
+static const NSUInteger kTaskMetricsQueueThreadIdentifier = 0;
+
+// Escape characters which would break JSON strings
+static NSString *HLSTaskMetricsEscapedString(NSString *string)
+{
+    return [[string stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"]
+            stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
+}
+
+#pragma mark -
+#pragma mark HLSTaskMetricsRecord class
+
+/**
+ * Timestamps collected for a task or a task group. Timestamps which have not been recorded are set to 0
+ */
+@interface HLSTaskMetricsRecord : NSObject {
+@private
+    NSString *m_tag;
+    NSString *m_name;
+    BOOL m_taskGroup;
+    CFAbsoluteTime m_submissionTime;
+    CFAbsoluteTime m_processingStartTime;
+    CFAbsoluteTime m_processingEndTime;
+    CFAbsoluteTime m_completionTime;
+    NSTimeInterval m_delegateDispatchTimeInterval;
+    NSUInteger m_threadIdentifier;
+    BOOL m_cancelled;
+}
+
+@property (nonatomic, retain) NSString *tag;
+@property (nonatomic, retain) NSString *name;
+@property (nonatomic, assign, getter=isTaskGroup) BOOL taskGroup;
+@property (nonatomic, assign) CFAbsoluteTime submissionTime;
+@property (nonatomic, assign) CFAbsoluteTime processingStartTime;
+@property (nonatomic, assign) CFAbsoluteTime processingEndTime;
+@property (nonatomic, assign) CFAbsoluteTime completionTime;
+@property (nonatomic, assign) NSTimeInterval delegateDispatchTimeInterval;
+@property (nonatomic, assign) NSUInteger threadIdentifier;
+@property (nonatomic, assign, getter=isCancelled) BOOL cancelled;
+
+/**
+ * Return the value of a metric, or kTaskMetricsNoValueAvailable if it is not defined for the record
+ */
+- (NSTimeInterval)valueForMetric:(HLSTaskMetric)metric;
+
+@end
+
+@implementation HLSTaskMetricsRecord
+
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.tag = nil;
+    self.name = nil;
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize tag = m_tag;
+
+@synthesize name = m_name;
+
+@synthesize taskGroup = m_taskGroup;
+
+@synthesize submissionTime = m_submissionTime;
+
+@synthesize processingStartTime = m_processingStartTime;
+
+@synthesize processingEndTime = m_processingEndTime;
+
+@synthesize completionTime = m_completionTime;
+
+@synthesize delegateDispatchTimeInterval = m_delegateDispatchTimeInterval;
+
+@synthesize threadIdentifier = m_threadIdentifier;
+
+@synthesize cancelled = m_cancelled;
+
+#pragma mark Metrics
+
+- (NSTimeInterval)valueForMetric:(HLSTaskMetric)metric
+{
+    switch (metric) {
+        case HLSTaskMetricQueueWaitTimeInterval: {
+            if (self.processingStartTime == 0.) {
+                return kTaskMetricsNoValueAvailable;
+            }
+            return self.processingStartTime - self.submissionTime;
+            break;
+        }
+        
+        case HLSTaskMetricRunTimeInterval: {
+            if (self.processingStartTime == 0. || self.processingEndTime == 0.) {
+                return kTaskMetricsNoValueAvailable;
+            }
+            return self.processingEndTime - self.processingStartTime;
+            break;
+        }
+        
+        case HLSTaskMetricDelegateDispatchTimeInterval: {
+            return self.delegateDispatchTimeInterval;
+            break;
+        }
+        
+        case HLSTaskMetricTotalTimeInterval: {
+            return self.completionTime - self.submissionTime;
+            break;
+        }
+        
+        default: {
+            HLSLoggerError(@"Unknown metric");
+            return kTaskMetricsNoValueAvailable;
+            break;
+        }
+    }
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSTaskMetrics class
+
+@interface HLSTaskMetrics ()
+
+@property (nonatomic, retain) NSMutableArray *records;
+
+- (NSArray *)tagsForTaskGroups:(BOOL)taskGroups;
+- (NSArray *)recordsForTaskGroups:(BOOL)taskGroups withTag:(NSString *)tagOrNil;
+- (NSTimeInterval)percentile:(double)percentile ofMetric:(HLSTaskMetric)metric forTaskGroups:(BOOL)taskGroups withTag:(NSString *)tagOrNil;
+
+- (NSString *)traceEventStringForRecord:(HLSTaskMetricsRecord *)record
+                                   name:(NSString *)name
+                              startTime:(CFAbsoluteTime)startTime
+                                endTime:(CFAbsoluteTime)endTime
+                       threadIdentifier:(NSUInteger)threadIdentifier;
+
+@end
+
+@implementation HLSTaskMetrics
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        _referenceTime = CFAbsoluteTimeGetCurrent();
+        _objectToRecordMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        self.records = [NSMutableArray array];
+        self.maximumRecordCount = 1000;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    CFRelease(_objectToRecordMap);
+    self.records = nil;
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize records = _records;
+
+@synthesize maximumRecordCount = _maximumRecordCount;
+
+- (void)setMaximumRecordCount:(NSUInteger)maximumRecordCount
+{
+    @synchronized(self) {
+        _maximumRecordCount = maximumRecordCount;
+        
+        NSUInteger nbrRecords = [self.records count];
+        if (nbrRecords > maximumRecordCount) {
+            [self.records removeObjectsInRange:NSMakeRange(0, nbrRecords - maximumRecordCount)];
+        }
+    }
+}
+
+#pragma mark Recording
+
+- (void)recordSubmissionOfObject:(id)object
+{
+    HLSTaskMetricsRecord *record = [[[HLSTaskMetricsRecord alloc] init] autorelease];
+    record.tag = [object tag];
+    record.name = NSStringFromClass([object class]);
+    record.taskGroup = [object isKindOfClass:[HLSTaskGroup class]];
+    record.submissionTime = CFAbsoluteTimeGetCurrent();
+    
+    @synchronized(self) {
+        CFDictionarySetValue(_objectToRecordMap, object, record);
+    }
+}
+
+- (void)recordProcessingStartOfObject:(id)object
+{
+    CFAbsoluteTime time = CFAbsoluteTimeGetCurrent();
+    
+    @synchronized(self) {
+        HLSTaskMetricsRecord *record = (HLSTaskMetricsRecord *)CFDictionaryGetValue(_objectToRecordMap, object);
+        record.processingStartTime = time;
+        record.threadIdentifier = pthread_mach_thread_np(pthread_self());
+    }
+}
+
+- (void)recordProcessingEndOfObject:(id)object
+{
+    CFAbsoluteTime time = CFAbsoluteTimeGetCurrent();
+    
+    @synchronized(self) {
+        HLSTaskMetricsRecord *record = (HLSTaskMetricsRecord *)CFDictionaryGetValue(_objectToRecordMap, object);
+        record.processingEndTime = time;
+    }
+}
+
+- (void)recordDelegateDispatchTimeInterval:(NSTimeInterval)timeInterval forTask:(HLSTask *)task
+{
+    @synchronized(self) {
+        HLSTaskMetricsRecord *record = (HLSTaskMetricsRecord *)CFDictionaryGetValue(_objectToRecordMap, task);
+        record.delegateDispatchTimeInterval += timeInterval;
+        
+        if (task.taskGroup) {
+            HLSTaskMetricsRecord *taskGroupRecord = (HLSTaskMetricsRecord *)CFDictionaryGetValue(_objectToRecordMap, task.taskGroup);
+            taskGroupRecord.delegateDispatchTimeInterval += timeInterval;
+        }
+    }
+}
+
+- (void)recordCompletionOfObject:(id)object cancelled:(BOOL)cancelled
+{
+    CFAbsoluteTime time = CFAbsoluteTimeGetCurrent();
+    
+    @synchronized(self) {
+        HLSTaskMetricsRecord *record = (HLSTaskMetricsRecord *)CFDictionaryGetValue(_objectToRecordMap, object);
+        // Objects submitted before metrics were enabled
+        if (! record) {
+            return;
+        }
+        
+        record.completionTime = time;
+        record.cancelled = cancelled;
+        
+        // Task groups end when their last task completes
+        if (record.taskGroup && record.processingEndTime == 0.) {
+            record.processingEndTime = time;
+        }
+        
+        [self.records addObject:record];
+        CFDictionaryRemoveValue(_objectToRecordMap, object);
+        
+        if ([self.records count] > self.maximumRecordCount) {
+            [self.records removeObjectAtIndex:0];
+        }
+    }
+}
+
+#pragma mark Querying
+
+- (NSArray *)taskTags
+{
+    return [self tagsForTaskGroups:NO];
+}
+
+- (NSArray *)taskGroupTags
+{
+    return [self tagsForTaskGroups:YES];
+}
+
+- (NSArray *)tagsForTaskGroups:(BOOL)taskGroups
+{
+    NSMutableSet *tags = [NSMutableSet set];
+    @synchronized(self) {
+        for (HLSTaskMetricsRecord *record in self.records) {
+            if (record.taskGroup == taskGroups && record.tag) {
+                [tags addObject:record.tag];
+            }
+        }
+    }
+    return [tags allObjects];
+}
+
+- (NSUInteger)recordCountForTasksWithTag:(NSString *)tagOrNil
+{
+    return [[self recordsForTaskGroups:NO withTag:tagOrNil] count];
+}
+
+- (NSUInteger)recordCountForTaskGroupsWithTag:(NSString *)tagOrNil
+{
+    return [[self recordsForTaskGroups:YES withTag:tagOrNil] count];
+}
+
+- (NSArray *)recordsForTaskGroups:(BOOL)taskGroups withTag:(NSString *)tagOrNil
+{
+    NSMutableArray *records = [NSMutableArray array];
+    @synchronized(self) {
+        for (HLSTaskMetricsRecord *record in self.records) {
+            if (record.taskGroup != taskGroups) {
+                continue;
+            }
+            
+            if (tagOrNil && ! [record.tag isEqualToString:tagOrNil]) {
+                continue;
+            }
+            
+            [records addObject:record];
+        }
+    }
+    return [NSArray arrayWithArray:records];
+}
+
+- (NSTimeInterval)percentile:(double)percentile ofMetric:(HLSTaskMetric)metric forTasksWithTag:(NSString *)tagOrNil
+{
+    return [self percentile:percentile ofMetric:metric forTaskGroups:NO withTag:tagOrNil];
+}
+
+- (NSTimeInterval)percentile:(double)percentile ofMetric:(HLSTaskMetric)metric forTaskGroupsWithTag:(NSString *)tagOrNil
+{
+    return [self percentile:percentile ofMetric:metric forTaskGroups:YES withTag:tagOrNil];
+}
+
+// Nearest-rank percentile
+- (NSTimeInterval)percentile:(double)percentile ofMetric:(HLSTaskMetric)metric forTaskGroups:(BOOL)taskGroups withTag:(NSString *)tagOrNil
+{
+    if (percentile < 0. || percentile > 100.) {
+        HLSLoggerError(@"The percentile must be between 0 and 100");
+        return kTaskMetricsNoValueAvailable;
+    }
+    
+    NSMutableArray *values = [NSMutableArray array];
+    for (HLSTaskMetricsRecord *record in [self recordsForTaskGroups:taskGroups withTag:tagOrNil]) {
+        NSTimeInterval value = [record valueForMetric:metric];
+        if (value == kTaskMetricsNoValueAvailable) {
+            continue;
+        }
+        [values addObject:[NSNumber numberWithDouble:value]];
+    }
+    
+    NSUInteger nbrValues = [values count];
+    if (nbrValues == 0) {
+        return kTaskMetricsNoValueAvailable;
+    }
+    
+    [values sortUsingSelector:@selector(compare:)];
+    NSUInteger rank = (NSUInteger)ceil(percentile / 100. * nbrValues);
+    NSUInteger index = (rank == 0) ? 0 : rank - 1;
+    return [[values objectAtIndex:index] doubleValue];
+}
+
+#pragma mark Exporting
+
+- (NSString *)traceEventString
+{
+    NSMutableArray *events = [NSMutableArray array];
+    @synchronized(self) {
+        for (HLSTaskMetricsRecord *record in self.records) {
+            // Queue waits are displayed on a separate row
+            if (record.processingStartTime != 0.) {
+                [events addObject:[self traceEventStringForRecord:record
+                                                             name:[NSString stringWithFormat:@"%@ (queued)", record.name]
+                                                        startTime:record.submissionTime
+                                                          endTime:record.processingStartTime
+                                                 threadIdentifier:kTaskMetricsQueueThreadIdentifier]];
+            }
+            
+            // Tasks cancelled before they started only appear as a single slice
+            if (record.processingStartTime != 0. && record.processingEndTime != 0.) {
+                [events addObject:[self traceEventStringForRecord:record
+                                                             name:record.name
+                                                        startTime:record.processingStartTime
+                                                          endTime:record.processingEndTime
+                                                 threadIdentifier:record.taskGroup ? kTaskMetricsQueueThreadIdentifier : record.threadIdentifier]];
+            }
+            else {
+                [events addObject:[self traceEventStringForRecord:record
+                                                             name:record.name
+                                                        startTime:record.submissionTime
+                                                          endTime:record.completionTime
+                                                 threadIdentifier:kTaskMetricsQueueThreadIdentifier]];
+            }
+        }
+    }
+    
+    return [NSString stringWithFormat:@"{\"traceEvents\":[\n%@\n]}", [events componentsJoinedByString:@",\n"]];
+}
+
+- (NSString *)traceEventStringForRecord:(HLSTaskMetricsRecord *)record
+                                   name:(NSString *)name
+                              startTime:(CFAbsoluteTime)startTime
+                                endTime:(CFAbsoluteTime)endTime
+                       threadIdentifier:(NSUInteger)threadIdentifier
+{
+    // Timestamps and durations in microseconds
+    return [NSString stringWithFormat:@"{\"name\":\"%@\",\"cat\":\"%@\",\"ph\":\"X\",\"ts\":%.0f,\"dur\":%.0f,\"pid\":1,\"tid\":%u,"
+            "\"args\":{\"tag\":\"%@\",\"cancelled\":%@,\"delegateDispatchTimeInterval\":%f}}",
+            HLSTaskMetricsEscapedString(name),
+            record.taskGroup ? @"taskGroup" : @"task",
+            (startTime - _referenceTime) * 1e6,
+            (endTime - startTime) * 1e6,
+            threadIdentifier,
+            record.tag ? HLSTaskMetricsEscapedString(record.tag) : @"",
+            record.cancelled ? @"true" : @"false",
+            record.delegateDispatchTimeInterval];
+}
+
+#pragma mark Clearing
+
+- (void)clear
+{
+    @synchronized(self) {
+        [self.records removeAllObjects];
+    }
+}
+
+@end
@@ -0,0 +1,34 @@
+//
+//  HLSTaskOperation+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTaskOperation.h"
+
+/**
+ * Interface meant to be used by friend classes of HLSTaskOperation (= classes which must have access to private 
+ * implementation details)
+ */
+@interface HLSTaskOperation (Friend)
+
+/**
+ * Record and notify the start of processing. Must be called before the operation starts its work
+ */
+- (void)beginProcessing;
+
+/**
+ * Deliver pending progress and notify the end of processing. Must be called once the work of the operation is over. 
+ * Depending on the notification delivery mode, the end might not have been notified yet when this method returns
+ */
+- (void)endProcessing;
+
+/**
+ * Perform a selector on the thread which spawned the operation (or the notification dispatch queue), in the order in
+ * which notifications are emitted by the operation
+ */
+- (void)onCallingThreadPerformSelector:(SEL)selector object:(NSObject *)objectOrNil;
+
+@end
@@ -19,6 +19,14 @@
  */
 - (void)operationMain;
 
+/**
+ * Called when the task manager receives a memory warning while the operation is pending or running. Override this 
+ * method to release caches or other memory which the operation can rebuild later (the default implementation does
+ * nothing). This method is called on the thread which submitted the task, i.e. usually while -operationMain is 
+ * running on another thread; your implementation must be thread-safe
+ */
+- (void)operationDidReceiveMemoryWarning;
+
 /**
  * Update the status of an operation; valid values are 0.f (task not processed), 1.f (task fully processed) or a value 
  * in between (which should reflect an estimate about how much of the task has been processed)
@@ -39,4 +47,23 @@
  */
 - (void)attachError:(NSError *)error;
 
+/**
+ * The token saved by the last checkpoint if the task is resumed from one, nil otherwise. Use it to restart processing
+ * where it was left
+ * Not meant to be overridden
+ */
+- (NSData *)resumeToken;
+
+/**
+ * Save a checkpoint, i.e. an opaque token describing how far processing went, using the default HLSFileManager. The 
+ * checkpoint replaces any previous one and is removed when the task ends successfully. If the task does not complete, 
+ * it can later be resubmitted from its last checkpoint (see -[HLSTaskManager submitCheckpointedTasksWithDelegate:])
+ * and the token is then available from -resumeToken. The task processed by the operation must have a checkpoint key
+ *
+ * This method writes to disk synchronously and returns YES iff successful. Call it when the work done since the 
+ * previous checkpoint is worth saving, not for each progress update
+ * Not meant to be overridden
+ */
+- (BOOL)checkpointWithResumeToken:(NSData *)resumeToken;
+
 @end
@@ -32,6 +32,17 @@
     HLSTaskManager *_taskManager;       // The task manager which spawned the operation
     HLSTask *_task;                     // The task the operation is processing
     NSThread *_callingThread;           // Thread onto which spawned the operation
+    HLSTaskNotificationDeliveryMode _notificationDeliveryMode;
+    dispatch_queue_t _notificationDispatchQueue;    // Queue onto which notifications are processed (dispatch queue mode only)
+    NSMutableArray *_pendingNotifications;          // FIFO of notifications waiting to be processed on the calling thread
+    NSCondition *_pendingNotificationsCondition;    // Protects the FIFO above, and signals when it has been emptied
+    NSTimeInterval _progressUpdateMinimumTimeInterval;
+    float _progressUpdateMinimumDelta;
+    float _lastDeliveredProgress;                   // Last progress value which has been delivered ...
+    CFAbsoluteTime _lastProgressDeliveryTime;       // ... and when
+    float _droppedProgress;                         // Latest progress value which has not been delivered (-1.f if none)
+    CFAbsoluteTime _startTime;                      // Time at which processing started
+    HLSTaskMetrics *_metrics;                       // Metrics of the task manager when the operation was created (nil if disabled)
 }
 
 - (id)initWithTaskManager:(HLSTaskManager *)taskManager task:(HLSTask *)task;
@@ -8,23 +8,39 @@
 
 #import "HLSTaskOperation.h"
 
+#import <objc/runtime.h>
 #import "HLSAssert.h"
+#import "HLSFloat.h"
 #import "HLSLogger.h"
 #import "HLSTask+Friend.h"
 #import "HLSTaskGroup+Friend.h"
 #import "HLSTaskManager+Friend.h"
+#import "HLSTaskMetrics+Friend.h"
+#import "HLSTaskOperation+Friend.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryTask
 
 @interface HLSTaskOperation ()
 
 @property (nonatomic, assign) HLSTaskManager *taskManager;
 @property (nonatomic, assign) HLSTask *task;
 @property (nonatomic, retain) NSThread *callingThread;
+@property (nonatomic, assign) HLSTaskNotificationDeliveryMode notificationDeliveryMode;
+@property (nonatomic, retain) NSMutableArray *pendingNotifications;
+@property (nonatomic, retain) NSCondition *pendingNotificationsCondition;
+@property (nonatomic, retain) HLSTaskMetrics *metrics;
 
 - (void)operationMain;
+- (void)operationDidReceiveMemoryWarning;
 
-- (void)onCallingThreadPerformSelector:(SEL)selector object:(NSObject *)objectOrNil;
+- (void)processPendingNotifications;
+- (void)waitUntilPendingNotificationsProcessed;
+- (void)deliverProgress:(float)progress;
 - (void)updateProgressToValue:(float)progress;
 - (void)attachError:(NSError *)error;
+- (NSData *)resumeToken;
+- (BOOL)checkpointWithResumeToken:(NSData *)resumeToken;
 
 - (void)notifyStart;
 - (void)notifyRunningWithProgress:(NSNumber *)progress;
@@ -45,6 +61,21 @@
         self.taskManager = taskManager;
         self.task = task;
         self.callingThread = [NSThread currentThread];
+        self.notificationDeliveryMode = taskManager.notificationDeliveryMode;
+        if (self.notificationDeliveryMode == HLSTaskNotificationDeliveryModeDispatchQueue) {
+            _notificationDispatchQueue = taskManager.notificationDispatchQueue;
+            dispatch_retain(_notificationDispatchQueue);
+        }
+        if (self.notificationDeliveryMode != HLSTaskNotificationDeliveryModeSynchronous) {
+            self.pendingNotifications = [NSMutableArray array];
+            self.pendingNotificationsCondition = [[[NSCondition alloc] init] autorelease];
+        }
+        _progressUpdateMinimumTimeInterval = taskManager.progressUpdateMinimumTimeInterval;
+        _progressUpdateMinimumDelta = taskManager.progressUpdateMinimumDelta;
+        _lastDeliveredProgress = 0.f;
+        _lastProgressDeliveryTime = CFAbsoluteTimeGetCurrent();
+        _droppedProgress = -1.f;
+        self.metrics = taskManager.metrics;
     }
     return self;
 }
@@ -60,6 +91,12 @@
     self.taskManager = nil;
     self.task = nil;
     self.callingThread = nil;
+    self.pendingNotifications = nil;
+    self.pendingNotificationsCondition = nil;
+    self.metrics = nil;
+    if (_notificationDispatchQueue) {
+        dispatch_release(_notificationDispatchQueue);
+    }
     [super dealloc];
 }
 
@@ -72,17 +109,52 @@
 
 @synthesize callingThread = _callingThread;
 
+@synthesize notificationDeliveryMode = _notificationDeliveryMode;
+
+@synthesize pendingNotifications = _pendingNotifications;
+
+@synthesize pendingNotificationsCondition = _pendingNotificationsCondition;
+
+@synthesize metrics = _metrics;
+
 #pragma mark -
 #pragma mark Thread main function
 
 - (void)main
 {
-    // Notify begin
-    [self onCallingThreadPerformSelector:@selector(notifyStart) object:nil];
+    [self beginProcessing];
     
     // Execute the main method code
     [self operationMain];
     
+    [self endProcessing];
+    
+    // When notifications are delivered asynchronously, the operation must not be considered finished before its end
+    // has been notified. Otherwise operations depending on it could start early, before dependents have been 
+    // cancelled if the operation failed
+    if (self.notificationDeliveryMode != HLSTaskNotificationDeliveryModeSynchronous) {
+        [self waitUntilPendingNotificationsProcessed];
+    }
+}
+
+- (void)beginProcessing
+{
+    _startTime = CFAbsoluteTimeGetCurrent();
+    [self.metrics recordProcessingStartOfObject:self.task];
+    
+    // Notify begin
+    [self onCallingThreadPerformSelector:@selector(notifyStart) object:nil];
+}
+
+- (void)endProcessing
+{
+    [self.metrics recordProcessingEndOfObject:self.task];
+    
+    // Deliver the latest progress value if it was dropped
+    if (! floatlt(_droppedProgress, 0.f)) {
+        [self deliverProgress:_droppedProgress];
+    }
+    
     // Notify end
     [self onCallingThreadPerformSelector:@selector(notifyEnd) object:nil];
 }
@@ -92,11 +164,42 @@
     HLSMissingMethodImplementation();
 }
 
+- (void)operationDidReceiveMemoryWarning
+{}
+
 #pragma mark -
 #pragma mark Executing code on the calling thread
 
 - (void)onCallingThreadPerformSelector:(SEL)selector object:(NSObject *)objectOrNil
 {
+    // Asynchronous delivery: Append the notification to the FIFO. Only the first notification added to an empty FIFO
+    // needs to schedule processing on the calling thread (or dispatch queue), since processing only stops once the FIFO 
+    // is empty. Since notifications are always consumed from the FIFO, their order is preserved (see remark below)
+    if (self.notificationDeliveryMode != HLSTaskNotificationDeliveryModeSynchronous) {
+        NSArray *notification = [NSArray arrayWithObjects:NSStringFromSelector(selector), objectOrNil, nil];
+        
+        [self.pendingNotificationsCondition lock];
+        [self.pendingNotifications addObject:notification];
+        BOOL processingNeeded = ([self.pendingNotifications count] == 1);
+        [self.pendingNotificationsCondition unlock];
+        
+        if (processingNeeded) {
+            // All notifications pending when the block is executed are processed as a single batch
+            if (self.notificationDeliveryMode == HLSTaskNotificationDeliveryModeDispatchQueue) {
+                dispatch_async(_notificationDispatchQueue, ^{
+                    [self processPendingNotifications];
+                });
+            }
+            else {
+                [self performSelector:@selector(processPendingNotifications)
+                             onThread:self.callingThread
+                           withObject:nil
+                        waitUntilDone:NO];
+            }
+        }
+        return;
+    }
+    
     // HUGE WARNING here! If we do not wait until done, we might sometimes (most notably under heavy load) perform selectors
     // on the calling thread, but not in the order they were scheduled. This can be a complete disaster if we perform the
     // notifyEnd method before a progress update via notifyRunningWithProgress:. If waitUntilDone is left to NO, then this
@@ -112,11 +215,64 @@
             waitUntilDone:YES];
 }
 
+// Called on the calling thread (or dispatch queue). A notification is removed from the FIFO only after it has been processed, so that
+// notifications added in the meantime do not schedule another processing
+- (void)processPendingNotifications
+{
+    BOOL empty = NO;
+    while (! empty) {
+        [self.pendingNotificationsCondition lock];
+        NSArray *notification = [[[self.pendingNotifications objectAtIndex:0] retain] autorelease];
+        [self.pendingNotificationsCondition unlock];
+        
+        SEL selector = NSSelectorFromString([notification objectAtIndex:0]);
+        id objectOrNil = ([notification count] > 1) ? [notification objectAtIndex:1] : nil;
+        [self performSelector:selector withObject:objectOrNil];
+        
+        [self.pendingNotificationsCondition lock];
+        [self.pendingNotifications removeObjectAtIndex:0];
+        empty = ([self.pendingNotifications count] == 0);
+        if (empty) {
+            [self.pendingNotificationsCondition broadcast];
+        }
+        [self.pendingNotificationsCondition unlock];
+    }
+}
+
+// Called on the operation thread
+- (void)waitUntilPendingNotificationsProcessed
+{
+    [self.pendingNotificationsCondition lock];
+    while ([self.pendingNotifications count] != 0) {
+        [self.pendingNotificationsCondition wait];
+    }
+    [self.pendingNotificationsCondition unlock];
+}
+
 // Remark: Originally, I intended to call this method "setProgress:", but this was a bad idea. It could have conflicted
 //         with setProgress: methods defined by subclasses of HLSTaskOperation (and guess what, this just happened
 //         since one of my subclasses implemented the ASIProgressDelegate protocol, which declares a setProgress: method)
 - (void)updateProgressToValue:(float)progress
 {
+    // Coalesce progress updates arriving too fast. Completion is always delivered
+    if (! floatge(progress, 1.f)) {
+        CFAbsoluteTime elapsedTimeInterval = CFAbsoluteTimeGetCurrent() - _lastProgressDeliveryTime;
+        if (doublelt(elapsedTimeInterval, _progressUpdateMinimumTimeInterval)
+                || floatlt(fabsf(progress - _lastDeliveredProgress), _progressUpdateMinimumDelta)) {
+            _droppedProgress = progress;
+            return;
+        }
+    }
+    
+    [self deliverProgress:progress];
+}
+
+- (void)deliverProgress:(float)progress
+{
+    _droppedProgress = -1.f;
+    _lastDeliveredProgress = progress;
+    _lastProgressDeliveryTime = CFAbsoluteTimeGetCurrent();
+    
     [self onCallingThreadPerformSelector:@selector(notifyRunningWithProgress:) 
                                   object:[NSNumber numberWithFloat:progress]];
 }
@@ -133,12 +289,24 @@
                                   object:error];
 }
 
+- (NSData *)resumeToken
+{
+    return self.task.resumeToken;
+}
+
+- (BOOL)checkpointWithResumeToken:(NSData *)resumeToken
+{
+    return [self.task saveCheckpointWithResumeToken:resumeToken];
+}
+
 #pragma mark -
 #pragma mark Code to be executed on the calling thread
 
 - (void)notifyStart
 {
-    HLSLoggerDebug(@"Task %@ starts", self.task);
+    HLSLoggerRecordDebug("Task %p (%s) starts", self.task, object_getClassName(self.task));
+    
+    CFAbsoluteTime dispatchStartTime = CFAbsoluteTimeGetCurrent();
     
     // Reset status
     [self.task reset];
@@ -149,75 +317,93 @@
         HLSLoggerDebug(@"Task group %@ starts", taskGroup);
         
         taskGroup.running = YES;
-        id<HLSTaskGroupDelegate> taskGroupDelegate = [self.taskManager delegateForTaskGroup:taskGroup];
-        if ([taskGroupDelegate respondsToSelector:@selector(taskGroupHasStartedProcessing:)]) {
+        [self.metrics recordProcessingStartOfObject:taskGroup];
+        NSUInteger taskGroupDelegateMethods = 0;
+        id<HLSTaskGroupDelegate> taskGroupDelegate = [self.taskManager delegateForTaskGroup:taskGroup implementedMethods:&taskGroupDelegateMethods];
+        if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodHasStartedProcessing) {
             [taskGroupDelegate taskGroupHasStartedProcessing:taskGroup];
         }
     }
     
     // ... then flag the task as running and notify ...
-    id<HLSTaskDelegate> taskDelegate = [self.taskManager delegateForTask:self.task];
+    NSUInteger taskDelegateMethods = 0;
+    id<HLSTaskDelegate> taskDelegate = [self.taskManager delegateForTask:self.task implementedMethods:&taskDelegateMethods];
     self.task.running = YES;
-    if ([taskDelegate respondsToSelector:@selector(taskHasStartedProcessing:)]) {
+    if (taskDelegateMethods & HLSTaskDelegateMethodHasStartedProcessing) {
         [taskDelegate taskHasStartedProcessing:self.task];
     }
     self.task.progress = 0.f;
-    if ([taskDelegate respondsToSelector:@selector(taskProgressUpdated:)]) {
+    if (taskDelegateMethods & HLSTaskDelegateMethodProgressUpdated) {
         [taskDelegate taskProgressUpdated:self.task];
     }
+    [self.taskManager updateDuplicatesOfTask:self.task];
     
     // ... and finally update and notify about the task group status
     if (taskGroup) {
         [taskGroup updateStatus];
-        id<HLSTaskGroupDelegate> taskGroupDelegate = [self.taskManager delegateForTaskGroup:taskGroup];
-        if ([taskGroupDelegate respondsToSelector:@selector(taskGroupProgressUpdated:)]) {
+        NSUInteger taskGroupDelegateMethods = 0;
+        id<HLSTaskGroupDelegate> taskGroupDelegate = [self.taskManager delegateForTaskGroup:taskGroup implementedMethods:&taskGroupDelegateMethods];
+        if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodProgressUpdated) {
             [taskGroupDelegate taskGroupProgressUpdated:taskGroup];
         }
     }
+    
+    [self.metrics recordDelegateDispatchTimeInterval:CFAbsoluteTimeGetCurrent() - dispatchStartTime forTask:self.task];
 }
 
 - (void)notifyRunningWithProgress:(NSNumber *)progress
 {
+    CFAbsoluteTime dispatchStartTime = CFAbsoluteTimeGetCurrent();
+    
     // Update and notify about the task progress
     self.task.progress = [progress floatValue];
-    id<HLSTaskDelegate> taskDelegate = [self.taskManager delegateForTask:self.task];
-    if ([taskDelegate respondsToSelector:@selector(taskProgressUpdated:)]) {
+    NSUInteger taskDelegateMethods = 0;
+    id<HLSTaskDelegate> taskDelegate = [self.taskManager delegateForTask:self.task implementedMethods:&taskDelegateMethods];
+    if (taskDelegateMethods & HLSTaskDelegateMethodProgressUpdated) {
         [taskDelegate taskProgressUpdated:self.task];
     }
+    [self.taskManager updateDuplicatesOfTask:self.task];
     
     // If part of a task group, update and notify about its status as well
     HLSTaskGroup *taskGroup = self.task.taskGroup;
     if (taskGroup) {
         [taskGroup updateStatus];
-        id<HLSTaskGroupDelegate> taskGroupDelegate = [self.taskManager delegateForTaskGroup:taskGroup];
-        if ([taskGroupDelegate respondsToSelector:@selector(taskGroupProgressUpdated:)]) {
+        NSUInteger taskGroupDelegateMethods = 0;
+        id<HLSTaskGroupDelegate> taskGroupDelegate = [self.taskManager delegateForTaskGroup:taskGroup implementedMethods:&taskGroupDelegateMethods];
+        if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodProgressUpdated) {
             [taskGroupDelegate taskGroupProgressUpdated:taskGroup];
         }
     }
+    
+    [self.metrics recordDelegateDispatchTimeInterval:CFAbsoluteTimeGetCurrent() - dispatchStartTime forTask:self.task];
 }
 
 - (void)notifyEnd
 {
-    id<HLSTaskDelegate> taskDelegate = [self.taskManager delegateForTask:self.task];
+    CFAbsoluteTime dispatchStartTime = CFAbsoluteTimeGetCurrent();
+    
+    NSUInteger taskDelegateMethods = 0;
+    id<HLSTaskDelegate> taskDelegate = [self.taskManager delegateForTask:self.task implementedMethods:&taskDelegateMethods];
     
     // If part of a task group, first cancel all dependent tasks; a task group is removed once all tasks it contains are
     // marked as finished. Here we are careful enough to cancel all dependent task before the current task is set as 
-    // finished. This way the task group is guaranteed to survive the loop below
+    // finished. This way the task group is guaranteed to survive the cascade. This is only required if the task
+    // was not successful
     HLSTaskGroup *taskGroup = self.task.taskGroup;
-    if (taskGroup) {
-        // Cancel all tasks strongly depending on the task it not successful
-        if ([self isCancelled] || self.task.error) {
-            NSSet *strongDependents = [taskGroup strongDependentsForTask:self.task];
-            for (HLSTask *dependent in strongDependents) {
-                [self.taskManager cancelTask:dependent];
-            }
-        }
+    if (taskGroup && ([self isCancelled] || self.task.error)) {
+        [self.taskManager cancelStrongDependentsOfTask:self.task];
+    }
+    
+    // Successful tasks do not need to be resumed anymore
+    if (! self.task.error && ! [self isCancelled]) {
+        [self.task removeCheckpoint];
+        self.task.resumeToken = nil;
     }
     
     // Update the progress to 1.f on success, else do not alter current value (so that the progress value cannot go backwards)
     if (! self.task.error && ! [self isCancelled]) {
         self.task.progress = 1.f;
-        if ([taskDelegate respondsToSelector:@selector(taskProgressUpdated:)]) {
+        if (taskDelegateMethods & HLSTaskDelegateMethodProgressUpdated) {
             [taskDelegate taskProgressUpdated:self.task];
         }
     }
@@ -226,8 +412,8 @@
     
     // The task has been cancelled
     if ([self isCancelled]) {
-        HLSLoggerDebug(@"Task %@ has been cancelled", self.task);
-        if ([taskDelegate respondsToSelector:@selector(taskHasBeenCancelled:)]) {
+        HLSLoggerRecordDebug("Task %p (%s) has been cancelled", self.task, object_getClassName(self.task));
+        if (taskDelegateMethods & HLSTaskDelegateMethodHasBeenCancelled) {
             [taskDelegate taskHasBeenCancelled:self.task];
         }        
     }
@@ -235,14 +421,14 @@
     else {
         // Successful
         if (! self.task.error) {
-            HLSLoggerDebug(@"Task %@ ends successfully", self.task);
+            HLSLoggerRecordDebug("Task %p (%s) ends successfully", self.task, object_getClassName(self.task));
         }
         // An error has been attached during processing
         else {
-            HLSLoggerDebug(@"Task %@ has encountered an error", self.task);
+            HLSLoggerRecordDebug("Task %p (%s) has encountered an error", self.task, object_getClassName(self.task));
         }
         
-        if ([taskDelegate respondsToSelector:@selector(taskHasBeenProcessed:)]) {
+        if (taskDelegateMethods & HLSTaskDelegateMethodHasBeenProcessed) {
             [taskDelegate taskHasBeenProcessed:self.task];
         }        
     }
@@ -250,9 +436,10 @@
     // If part of a task group
     if (taskGroup) {
         // Update an notify about the task group progress as well
-        id<HLSTaskGroupDelegate> taskGroupDelegate = [self.taskManager delegateForTaskGroup:taskGroup];
+        NSUInteger taskGroupDelegateMethods = 0;
+        id<HLSTaskGroupDelegate> taskGroupDelegate = [self.taskManager delegateForTaskGroup:taskGroup implementedMethods:&taskGroupDelegateMethods];
         [taskGroup updateStatus];
-        if ([taskGroupDelegate respondsToSelector:@selector(taskGroupProgressUpdated:)]) {
+        if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodProgressUpdated) {
             [taskGroupDelegate taskGroupProgressUpdated:taskGroup];
         }
         
@@ -262,19 +449,26 @@
             
             if (! taskGroup.cancelled) {
                 HLSLoggerDebug(@"Task group %@ ends successfully", taskGroup);
-                if ([taskGroupDelegate respondsToSelector:@selector(taskGroupHasBeenProcessed:)]) {
+                if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodHasBeenProcessed) {
                     [taskGroupDelegate taskGroupHasBeenProcessed:taskGroup];
                 }
             }
             else {
                 HLSLoggerDebug(@"Task group %@ has been cancelled", taskGroup);
-                if ([taskGroupDelegate respondsToSelector:@selector(taskGroupHasBeenCancelled:)]) {
+                if (taskGroupDelegateMethods & HLSTaskGroupDelegateMethodHasBeenCancelled) {
                     [taskGroupDelegate taskGroupHasBeenCancelled:taskGroup];
                 }
             }
         }
     }
     
+    // Tasks cancelled while running are not representative of the processing throughput
+    if (! [self isCancelled]) {
+        [self.taskManager recordProcessedOperation:self withDuration:CFAbsoluteTimeGetCurrent() - _startTime];
+    }
+    
+    [self.metrics recordDelegateDispatchTimeInterval:CFAbsoluteTimeGetCurrent() - dispatchStartTime forTask:self.task];
+    
     // Only the operation itself knows when it is done and can unregister itself from the manager it was
     // executed from
     [self.taskManager unregisterOperation:self];
@@ -41,6 +41,9 @@
 @private
     NSArray *m_elementWrapperViews;
     NSArray *m_elementWrapperViewSizeValues;
+    CGSize m_elementLayoutSize;                         // Cursor size for which element frames have been computed
+    BOOL m_elementLayoutValid;
+    NSMutableDictionary *m_reusableElementViews;        // Maps reuse identifiers to arrays of element views which can be reused
     UIView *m_pointerView;
     UIView *m_pointerContainerView;
     CGSize m_pointerViewTopLeftOffset;
@@ -101,9 +104,27 @@
 /**
  * Reload the cursor from the data source. The pointer is left at the same index where it was, except if the index
  * is out of range after the reload (in which case the pointer is reset to point on the first element)
+ *
+ * Element views can be recycled during the reload (see -dequeueReusableElementViewWithIdentifier:)
  */
 - (void)reloadData;
 
+/**
+ * Reload only the elements at the specified indexes from the data source. The number of elements must not have changed
+ * (call -reloadData if this is the case). Element views can be recycled during the reload (see 
+ * -dequeueReusableElementViewWithIdentifier:)
+ */
+- (void)reloadElementsAtIndexes:(NSIndexSet *)indexes;
+
+/**
+ * When the cursor is reloaded, the element views it displayed and which have a tag_hls (see UIView+HLSExtensions) can
+ * be reused by the data source. Call this method from -cursor:viewAtIndex:selected: to get such a view back, using
+ * its tag_hls as identifier. The view has the size it had when the data source returned it. Return nil if no view 
+ * is available for reuse, in which case the data source has to create a new one. Views which have not been reused
+ * during a reload are released
+ */
+- (UIView *)dequeueReusableElementViewWithIdentifier:(NSString *)identifier;
+
 /**
  * Set / get the data source used to fill the cursor with elements
  */
@@ -124,7 +145,7 @@
 
 @optional
 // Fully customized by specifying a view. You can use the selected boolean to set a different view for selected and
-// non-selected elements
+// non-selected elements. Use -dequeueReusableElementViewWithIdentifier: to recycle views
 - (UIView *)cursor:(HLSCursor *)cursor viewAtIndex:(NSUInteger)index selected:(BOOL)selected;
 
 // Less customisation, but no view is needed. You can use the selected boolean to set different properties for
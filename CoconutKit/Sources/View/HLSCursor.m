@@ -14,19 +14,28 @@
 #import "HLSViewAnimationStep.h"
 #import "NSArray+HLSExtensions.h"
 #import "NSBundle+HLSExtensions.h"
+#import "NSString+HLSExtensions.h"
 #import "UIView+HLSExtensions.h"
 
+static NSString * const kCursorTitleLabelReuseIdentifier = @"HLSCursorTitleLabel";
+
 @interface HLSCursor ()
 
 - (void)hlsCursorInit;
 
 @property (nonatomic, retain) NSArray *elementWrapperViews;
 @property (nonatomic, retain) NSArray *elementWrapperViewSizeValues;
+@property (nonatomic, retain) NSMutableDictionary *reusableElementViews;
 
 @property (nonatomic, retain) UIView *pointerContainerView;
 
+@property (nonatomic, retain) HLSAnimation *moveAnimation;
+
+- (void)layoutElementWrapperViews;
+
 - (UIView *)elementViewForIndex:(NSUInteger)index selected:(BOOL)selected;
 - (UIView *)elementWrapperViewForIndex:(NSUInteger)index;
+- (void)enqueueElementViewsOfElementWrapperViewAtIndex:(NSUInteger)index;
 
 - (CGFloat)xPosForIndex:(NSUInteger)index;
 - (NSUInteger)indexForXPos:(CGFloat)xPos;
@@ -64,11 +73,13 @@
 {
     self.elementWrapperViews = nil;
     self.elementWrapperViewSizeValues = nil;
+    self.reusableElementViews = nil;
     
     // Very special case here. Cannot use the property since it cannot change the pointer view once set!
     [m_pointerView release];
     
     self.pointerContainerView = nil;
+    self.moveAnimation = nil;
     self.dataSource = nil;
     
     [super dealloc];
@@ -79,6 +90,7 @@
     self.pointerViewTopLeftOffset = CGSizeMake(-10.f, -10.f);
     self.pointerViewBottomRightOffset = CGSizeMake(10.f, 10.f);
     self.animationDuration = 0.2;
+    self.reusableElementViews = [NSMutableDictionary dictionary];
 }
 
 #pragma mark Accessors and mutators
@@ -87,8 +99,12 @@
 
 @synthesize elementWrapperViewSizeValues = m_elementWrapperViewSizeValues;
 
+@synthesize reusableElementViews = m_reusableElementViews;
+
 @synthesize pointerContainerView = m_pointerContainerView;
 
+@synthesize moveAnimation = m_moveAnimation;
+
 @synthesize pointerView = m_pointerView;
 
 - (void)setPointerView:(UIView *)pointerView
@@ -105,8 +121,24 @@
 
 @synthesize pointerViewTopLeftOffset = m_pointerViewTopLeftOffset;
 
+- (void)setPointerViewTopLeftOffset:(CGSize)pointerViewTopLeftOffset
+{
+    m_pointerViewTopLeftOffset = pointerViewTopLeftOffset;
+    
+    m_elementLayoutValid = NO;
+    [self setNeedsLayout];
+}
+
 @synthesize pointerViewBottomRightOffset = m_pointerViewBottomRightOffset;
 
+- (void)setPointerViewBottomRightOffset:(CGSize)pointerViewBottomRightOffset
+{
+    m_pointerViewBottomRightOffset = pointerViewBottomRightOffset;
+    
+    m_elementLayoutValid = NO;
+    [self setNeedsLayout];
+}
+
 @synthesize dataSource = m_dataSource;
 
 @synthesize delegate = m_delegate;
@@ -126,6 +158,7 @@
         NSUInteger nbrElements = [self.dataSource numberOfElementsForCursor:self];
         if (nbrElements == 0) {
             HLSLoggerError(@"Cursor data source is empty");
+            [self.reusableElementViews removeAllObjects];
             return;
         }
         
@@ -138,8 +171,59 @@
             // The original size needs to be saved separately (since views are not created again)
             self.elementWrapperViewSizeValues = [self.elementWrapperViewSizeValues arrayByAddingObject:[NSValue valueWithCGSize:elementWrapperView.frame.size]];
         }
+        
+        // Views which have not been reused are not needed anymore
+        [self.reusableElementViews removeAllObjects];
     }
     
+    // Element frames only depend on the element sizes and on the cursor size. They are not computed again when the
+    // pointer moves (which triggers a layout), only when elements are reloaded or when the cursor is resized
+    if (! m_elementLayoutValid || ! CGSizeEqualToSize(self.frame.size, m_elementLayoutSize)) {
+        [self layoutElementWrapperViews];
+    }
+    
+    if (! m_viewsCreated) {
+        // If no custom pointer view specified, create a default one
+        if (! self.pointerView) {
+            UIImage *pointerImage = [UIImage imageNamed:@"CoconutKit-resources.bundle/CursorDefaultPointer.png"];
+            UIImageView *imageView = [[[UIImageView alloc] initWithImage:pointerImage] autorelease];
+            imageView.contentStretch = CGRectMake(0.5f,
+                                                  0.5f,
+                                                  1.f / CGRectGetWidth(imageView.frame),
+                                                  1.f / CGRectGetHeight(imageView.frame));
+            self.pointerView = imageView;
+        }
+        
+        if (m_initialIndex >= [self.elementWrapperViews count]) {
+            m_initialIndex = 0;
+            HLSLoggerWarn(@"Initial index too large; fixed");
+        }
+        
+        // Create a view to container the pointer view. This avoid issues with transparent pointer views
+        self.pointerContainerView = [[[UIView alloc] initWithFrame:self.pointerView.bounds] autorelease];
+        self.pointerView.frame = self.pointerContainerView.bounds;
+        self.pointerContainerView.backgroundColor = [UIColor clearColor];
+        self.pointerContainerView.autoresizesSubviews = YES;
+        self.pointerContainerView.exclusiveTouch = YES;
+        
+        self.pointerView.autoresizingMask = HLSViewAutoresizingAll;
+        [self.pointerContainerView addSubview:self.pointerView];
+        [self addSubview:self.pointerContainerView];
+        
+        m_creatingViews = YES;
+        
+        [self setSelectedIndex:m_initialIndex animated:NO];
+        
+        m_viewsCreated = YES;
+    }
+    else if (! m_dragging && ! m_moving) {
+        self.pointerContainerView.frame = [self pointerFrameForIndex:m_selectedIndex];
+    }
+}
+
+// Compute the frames of the element views so that they are distributed in the cursor frame
+- (void)layoutElementWrapperViews
+{
     // Calculate the needed total size to display all elements
     CGFloat requiredWidth = floatmax(-self.pointerViewTopLeftOffset.width, 0.f) + floatmax(self.pointerViewBottomRightOffset.width, 0.f);
     CGFloat requiredHeight = 0.f;
@@ -186,43 +270,8 @@
         ++i;
     }
     
-    if (! m_viewsCreated) {
-        // If no custom pointer view specified, create a default one
-        if (! self.pointerView) {
-            UIImage *pointerImage = [UIImage imageNamed:@"CoconutKit-resources.bundle/CursorDefaultPointer.png"];
-            UIImageView *imageView = [[[UIImageView alloc] initWithImage:pointerImage] autorelease];
-            imageView.contentStretch = CGRectMake(0.5f,
-                                                  0.5f,
-                                                  1.f / CGRectGetWidth(imageView.frame),
-                                                  1.f / CGRectGetHeight(imageView.frame));
-            self.pointerView = imageView;
-        }
-        
-        if (m_initialIndex >= [self.elementWrapperViews count]) {
-            m_initialIndex = 0;
-            HLSLoggerWarn(@"Initial index too large; fixed");
-        }
-        
-        // Create a view to container the pointer view. This avoid issues with transparent pointer views
-        self.pointerContainerView = [[[UIView alloc] initWithFrame:self.pointerView.bounds] autorelease];
-        self.pointerView.frame = self.pointerContainerView.bounds;
-        self.pointerContainerView.backgroundColor = [UIColor clearColor];
-        self.pointerContainerView.autoresizesSubviews = YES;
-        self.pointerContainerView.exclusiveTouch = YES;
-        
-        self.pointerView.autoresizingMask = HLSViewAutoresizingAll;
-        [self.pointerContainerView addSubview:self.pointerView];
-        [self addSubview:self.pointerContainerView];
-        
-        m_creatingViews = YES;
-        
-        [self setSelectedIndex:m_initialIndex animated:NO];
-        
-        m_viewsCreated = YES;
-    }
-    else if (! m_dragging && ! m_moving) {
-        self.pointerContainerView.frame = [self pointerFrameForIndex:m_selectedIndex];
-    }
+    m_elementLayoutSize = self.frame.size;
+    m_elementLayoutValid = YES;
 }
 
 - (UIView *)elementViewForIndex:(NSUInteger)index selected:(BOOL)selected
@@ -256,6 +305,9 @@
         if (! font) {
             font = [UIFont systemFontOfSize:17.f];
         }
+        if (! otherFont) {
+            otherFont = font;
+        }
         
         // Text color. If not defined by the data source, use standard colors
         UIColor *textColor = nil;
@@ -279,22 +331,29 @@
         }
         
         // Create a label with appropriate size. The size must accomodate both the font sizes for selected and non-selected
-        // states
-        CGSize titleSize = [title sizeWithFont:font];
-        CGSize otherTitleSize = [title sizeWithFont:otherFont];
-        UILabel *elementLabel = [[[UILabel alloc] initWithFrame:CGRectMake(0.f,
-                                                                           0.f,
-                                                                           floatmax(titleSize.width, otherTitleSize.width),
-                                                                           floatmax(titleSize.height, otherTitleSize.height))]
-                                 autorelease];
+        // states. Sizes are cached since the same titles are measured each time the cursor is reloaded
+        CGSize titleSize = [title cachedSizeWithFont:font];
+        CGSize otherTitleSize = [title cachedSizeWithFont:otherFont];
+        CGRect elementLabelFrame = CGRectMake(0.f,
+                                              0.f,
+                                              floatmax(titleSize.width, otherTitleSize.width),
+                                              floatmax(titleSize.height, otherTitleSize.height));
+        UILabel *elementLabel = (UILabel *)[self dequeueReusableElementViewWithIdentifier:kCursorTitleLabelReuseIdentifier];
+        if (elementLabel) {
+            elementLabel.frame = elementLabelFrame;
+        }
+        else {
+            elementLabel = [[[UILabel alloc] initWithFrame:elementLabelFrame] autorelease];
+            elementLabel.backgroundColor = [UIColor clearColor];
+            elementLabel.textAlignment = UITextAlignmentCenter;
+            elementLabel.autoresizingMask = HLSViewAutoresizingAll;
+            elementLabel.tag_hls = kCursorTitleLabelReuseIdentifier;
+        }
         elementLabel.text = title;
-        elementLabel.backgroundColor = [UIColor clearColor];
         elementLabel.font = font;
         elementLabel.textColor = textColor;
         elementLabel.shadowColor = shadowColor;
         elementLabel.shadowOffset = shadowOffset;
-        elementLabel.textAlignment = UITextAlignmentCenter;
-        elementLabel.autoresizingMask = HLSViewAutoresizingAll;
         
         return elementLabel;
     }
@@ -323,6 +382,7 @@
     
     [wrapperView addSubview:elementView];
     elementView.center = wrapperView.center;
+    elementView.hidden = NO;
     
     [wrapperView addSubview:selectedElementView];
     selectedElementView.center = wrapperView.center;
@@ -331,6 +391,38 @@
     return wrapperView;
 }
 
+- (void)enqueueElementViewsOfElementWrapperViewAtIndex:(NSUInteger)index
+{
+    // Element views are resized with their wrapper view during layout. Restore the original wrapper view size first
+    // so that element views are recycled with the size they had when the data source returned them
+    UIView *elementWrapperView = [self.elementWrapperViews objectAtIndex:index];
+    CGSize elementWrapperViewSize = [[self.elementWrapperViewSizeValues objectAtIndex:index] CGSizeValue];
+    elementWrapperView.frame = CGRectMake(0.f, 0.f, elementWrapperViewSize.width, elementWrapperViewSize.height);
+    
+    for (UIView *elementView in [NSArray arrayWithArray:elementWrapperView.subviews]) {
+        NSString *reuseIdentifier = elementView.tag_hls;
+        if (reuseIdentifier) {
+            NSMutableArray *reusableElementViews = [self.reusableElementViews objectForKey:reuseIdentifier];
+            if (! reusableElementViews) {
+                reusableElementViews = [NSMutableArray array];
+                [self.reusableElementViews setObject:reusableElementViews forKey:reuseIdentifier];
+            }
+            [reusableElementViews addObject:elementView];
+        }
+        [elementView removeFromSuperview];
+    }
+}
+
+- (UIView *)dequeueReusableElementViewWithIdentifier:(NSString *)identifier
+{
+    NSMutableArray *reusableElementViews = [self.reusableElementViews objectForKey:identifier];
+    UIView *elementView = [[[reusableElementViews lastObject] retain] autorelease];
+    if (elementView) {
+        [reusableElementViews removeLastObject];
+    }
+    return elementView;
+}
+
 #pragma mark Pointer management
 
 - (NSUInteger)selectedIndex
@@ -346,6 +438,10 @@
             selectedIndex = [self.elementWrapperViews count] - 1;
         }
         
+        // If the pointer is already moving, stop it where it currently is and retarget it from there. This way the
+        // pointer immediately responds to fast successive taps, without jumping to the previous target first
+        [self.moveAnimation interrupt];
+        
         HLSViewAnimation *moveViewAnimation11 = [HLSViewAnimation animation];
         [moveViewAnimation11 transformFromRect:self.pointerContainerView.frame
                                         toRect:[self pointerFrameForIndex:selectedIndex]];
@@ -355,10 +451,10 @@
         
         HLSAnimation *moveAnimation = [HLSAnimation animationWithAnimationStep:moveAnimationStep1];
         moveAnimation.tag = @"move";
-        moveAnimation.lockingUI = YES;
         moveAnimation.delegate = self;
         moveAnimation.userInfo = [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithUnsignedInteger:selectedIndex],
                                   @"targetIndex", nil];
+        self.moveAnimation = moveAnimation;
         [moveAnimation playAnimated:animated];
     }
     else {
@@ -483,11 +579,56 @@
     [self setNeedsLayout];
 }
 
+- (void)reloadElementsAtIndexes:(NSIndexSet *)indexes
+{
+    // Not created yet. All views will be created from the current data source contents anyway
+    if (! m_viewsCreated || [indexes count] == 0) {
+        return;
+    }
+    
+    if ([indexes lastIndex] >= [self.elementWrapperViews count]) {
+        HLSLoggerError(@"Invalid indexes");
+        return;
+    }
+    
+    // Enqueue all views first so that they can all be reused
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        [self enqueueElementViewsOfElementWrapperViewAtIndex:index];
+    }];
+    
+    NSMutableArray *elementWrapperViews = [NSMutableArray arrayWithArray:self.elementWrapperViews];
+    NSMutableArray *elementWrapperViewSizeValues = [NSMutableArray arrayWithArray:self.elementWrapperViewSizeValues];
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        UIView *elementWrapperView = [self elementWrapperViewForIndex:index];
+        if (! elementWrapperView) {
+            return;
+        }
+        
+        // Keep the pointer above the elements
+        [self insertSubview:elementWrapperView belowSubview:self.pointerContainerView];
+        [[elementWrapperViews objectAtIndex:index] removeFromSuperview];
+        [elementWrapperViews replaceObjectAtIndex:index withObject:elementWrapperView];
+        [elementWrapperViewSizeValues replaceObjectAtIndex:index withObject:[NSValue valueWithCGSize:elementWrapperView.frame.size]];
+    }];
+    self.elementWrapperViews = [NSArray arrayWithArray:elementWrapperViews];
+    self.elementWrapperViewSizeValues = [NSArray arrayWithArray:elementWrapperViewSizeValues];
+    m_elementLayoutValid = NO;
+    
+    // Views which have not been reused are not needed anymore
+    [self.reusableElementViews removeAllObjects];
+    
+    // The element under the pointer is only displayed as selected when the pointer is at rest
+    [self showElementViewAtIndex:m_selectedIndex selected:! m_dragging && ! m_moving];
+    
+    [self setNeedsLayout];
+}
+
 - (void)clear
 {
-    // Clear all views
-    for (UIView *view in self.elementWrapperViews) {
-        [view removeFromSuperview];
+    // Clear all views, keeping the element views for reuse
+    for (NSUInteger i = 0; i < [self.elementWrapperViews count]; ++i) {
+        [self enqueueElementViewsOfElementWrapperViewAtIndex:i];
+        [[self.elementWrapperViews objectAtIndex:i] removeFromSuperview];
     }
     self.elementWrapperViews = nil;
     self.elementWrapperViewSizeValues = nil;
@@ -497,6 +638,7 @@
     
     m_selectedIndex = 0;
     m_viewsCreated = NO;
+    m_elementLayoutValid = NO;
 }
 
 #pragma mark Touch events
@@ -512,7 +654,12 @@
         [self.delegate cursor:self didTouchDownNearIndex:index];
     }
     
-    if (index != m_selectedIndex) {
+    NSUInteger targetIndex = m_selectedIndex;
+    if (m_moving) {
+        targetIndex = [[self.moveAnimation.userInfo objectForKey:@"targetIndex"] unsignedIntegerValue];
+    }
+    
+    if (index != targetIndex) {
         [self setSelectedIndex:index animated:YES];
     }
 }
@@ -523,6 +670,12 @@
     
     // Start dragging
     if (! m_dragging) {
+        // Grabbing the pointer while it is moving stops it where it currently is
+        if (m_moving && CGRectContainsPoint([self.pointerContainerView.layer.presentationLayer frame], point)) {
+            [self.moveAnimation interrupt];
+            m_moving = NO;
+        }
+        
         // Check that we are actually grabbing the pointer view
         if (CGRectContainsPoint(self.pointerContainerView.frame, point)) {
             m_dragging = YES;
@@ -622,6 +775,11 @@
     }
     
     if ([animation.tag isEqualToString:@"move"]) {
+        // Retargeted move (the previous one has been interrupted and has not notified its end): Already notified
+        if (m_moving) {
+            return;
+        }
+        
         m_moving = YES;
         m_moved = YES;
         
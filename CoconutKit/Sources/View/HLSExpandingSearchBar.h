@@ -39,6 +39,11 @@ typedef enum {
     BOOL m_showsSearchResultsButton;
     HLSExpandingSearchBarAlignment m_alignment;
     id<HLSExpandingSearchBarDelegate> m_delegate;
+    HLSAnimation *m_expansionAnimation;
+    HLSAnimation *m_reverseExpansionAnimation;
+    CGRect m_expansionAnimationBounds;
+    CGRect m_layoutBounds;
+    BOOL m_layoutValid;
     BOOL m_layoutDone;
     BOOL m_expanded;
     BOOL m_animating;
@@ -22,8 +22,11 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
 
 @property (nonatomic, retain) UISearchBar *searchBar;
 @property (nonatomic, retain) UIButton *searchButton;
+@property (nonatomic, retain) HLSAnimation *expansionAnimation;
+@property (nonatomic, retain) HLSAnimation *reverseExpansionAnimation;
 
-- (HLSAnimation *)expansionAnimation;
+- (HLSAnimation *)animationForExpansion:(BOOL)expansion;
+- (HLSAnimation *)expansionAnimationForCurrentBounds;
 
 - (void)toggleSearchBar:(id)sender;
 
@@ -54,6 +57,8 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
     self.searchBar = nil;
     self.searchButton = nil;
     self.delegate = nil;
+    self.expansionAnimation = nil;
+    self.reverseExpansionAnimation = nil;
 
     [super dealloc];
 }
@@ -195,6 +200,10 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
 
 @synthesize searchButton = m_searchButton;
 
+@synthesize expansionAnimation = m_expansionAnimation;
+
+@synthesize reverseExpansionAnimation = m_reverseExpansionAnimation;
+
 @synthesize alignment = m_alignment;
 
 - (void)setAlignment:(HLSExpandingSearchBarAlignment)alignment
@@ -218,8 +227,9 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
         self.autoresizingMask &= ~UIViewAutoresizingFlexibleHeight;
     }
     
+    // Subviews only need to be repositioned when the bounds or the expansion status have changed
     // TODO: Factor out collapsed frame creation code
-    if (! m_animating) {
+    if (! m_animating && (! m_layoutValid || ! CGRectEqualToRect(self.bounds, m_layoutBounds))) {
         if (self.alignment == HLSExpandingSearchBarAlignmentLeft || m_expanded) {
             self.searchButton.frame = CGRectMake(0.f,
                                                  roundf((CGRectGetHeight(self.frame) - kSearchBarStandardHeight) / 2.f),
@@ -243,6 +253,9 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
         else {
             self.searchBar.frame = self.searchButton.frame;
         }
+        
+        m_layoutBounds = self.bounds;
+        m_layoutValid = YES;
     }
     
     // Notify initial status
@@ -260,9 +273,21 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
 
 #pragma mark Animation
 
-// We do not cache the animation: The source and target frames can vary depending on rotations. We
-// therefore need a way to generate the animation easily when we need it
-- (HLSAnimation *)expansionAnimation
+// The source and target frames can vary depending on rotations. The animation is therefore cached, together
+// with its reverse, for the bounds it was created with and built again when they change (the alignment cannot
+// change once the search bar has been displayed)
+- (HLSAnimation *)animationForExpansion:(BOOL)expansion
+{
+    if (! self.expansionAnimation || ! CGRectEqualToRect(self.bounds, m_expansionAnimationBounds)) {
+        self.expansionAnimation = [self expansionAnimationForCurrentBounds];
+        self.reverseExpansionAnimation = [self.expansionAnimation reverseAnimation];
+        m_expansionAnimationBounds = self.bounds;
+    }
+    
+    return expansion ? self.expansionAnimation : self.reverseExpansionAnimation;
+}
+
+- (HLSAnimation *)expansionAnimationForCurrentBounds
 {
     HLSViewAnimationStep *animationStep1 = [HLSViewAnimationStep animationStep];
     animationStep1.duration = 0.15;
@@ -334,8 +359,8 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
         
         m_animating = YES;
         
-        HLSAnimation *animation = [self expansionAnimation];
-        [animation playAnimated:animated];        
+        HLSAnimation *animation = [self animationForExpansion:YES];
+        [animation playAnimated:animated];
     }
     else {
         if (! m_expanded) {
@@ -356,7 +381,7 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
         
         [self.searchBar resignFirstResponder];
         
-        HLSAnimation *reverseAnimation = [[self expansionAnimation] reverseAnimation];
+        HLSAnimation *reverseAnimation = [self animationForExpansion:NO];
         [reverseAnimation playAnimated:animated];
     }
 }
@@ -401,6 +426,7 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
     
     // Force layout so that the views resize properly, even if the expansion / collapsing animation occurs during
     // a device rotation
+    m_layoutValid = NO;
     [self layoutSubviews];
 }
 
@@ -27,10 +27,14 @@ typedef enum {
  *     number of lines is larger than 1). Unlike UILabel, the font size can never be smaller than this minimum
  *     value (even if no size adjustment is needed)
  *   - the baselineAdjustment property is ignored
+ *   - text can optionally be rendered on a background queue (rendersAsynchronously property)
  */
 @interface HLSLabel : UILabel {
 @private
     HLSLabelVerticalAlignment _verticalAlignment;
+    BOOL _rendersAsynchronously;
+    CALayer *_textLayer;
+    NSString *_renderedTextKey;
 }
 
 /**
@@ -40,4 +44,17 @@ typedef enum {
  */
 @property (nonatomic, assign) HLSLabelVerticalAlignment verticalAlignment;
 
+/**
+ * If set to YES, the text is not drawn on the main thread, but rendered into a bitmap on a background queue, which is
+ * then displayed by the label. Rendered bitmaps are stored in the shared HLSImageCache, keyed by text, font, colors,
+ * size and alignments, so that labels displaying the same text (e.g. in table view cells being reused) do not need
+ * to render it again. This is especially useful for labels with many lines displayed in scrolling views
+ *
+ * While rendering is in progress, the previous text remains visible. If the text has already been rendered, it is
+ * displayed immediately
+ *
+ * The default value is NO (text is drawn synchronously, as for UILabel)
+ */
+@property (nonatomic, assign) BOOL rendersAsynchronously;
+
 @end
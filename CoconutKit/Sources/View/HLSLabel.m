@@ -9,17 +9,34 @@
 #import "HLSLabel.h"
 
 #import "HLSFloat.h"
+#import "HLSImageCache.h"
 #import "HLSLogger.h"
 #import "NSString+HLSExtensions.h"
 
 @interface HLSLabel ()
 
+@property (nonatomic, retain) CALayer *textLayer;
+@property (nonatomic, retain) NSString *renderedTextKey;
+
 - (CGRect)textRectForBounds:(CGRect)bounds limitedToNumberOfLines:(NSInteger)numberOfLines;
 
+- (void)renderTextAsynchronouslyInRect:(CGRect)rect;
+- (void)displayRenderedTextImage:(UIImage *)image;
+
 @end
 
 @implementation HLSLabel
 
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.textLayer = nil;
+    self.renderedTextKey = nil;
+    
+    [super dealloc];
+}
+
 #pragma mark Accessors and mutators
 
 @synthesize verticalAlignment = _verticalAlignment;
@@ -41,6 +58,29 @@
     [self setNeedsDisplay];
 }
 
+@synthesize rendersAsynchronously = _rendersAsynchronously;
+
+- (void)setRendersAsynchronously:(BOOL)rendersAsynchronously
+{
+    if (_rendersAsynchronously == rendersAsynchronously) {
+        return;
+    }
+    
+    _rendersAsynchronously = rendersAsynchronously;
+    
+    if (! rendersAsynchronously) {
+        [self.textLayer removeFromSuperlayer];
+        self.textLayer = nil;
+        self.renderedTextKey = nil;
+    }
+    
+    [self setNeedsDisplay];
+}
+
+@synthesize textLayer = _textLayer;
+
+@synthesize renderedTextKey = _renderedTextKey;
+
 #pragma mark UILabel drawing override points
 
 /**
@@ -87,7 +127,91 @@
     self.font = [UIFont fontWithName:self.font.fontName size:fontSize];
     
     CGRect actualRect = [self textRectForBounds:requestedRect limitedToNumberOfLines:self.numberOfLines];
-    [super drawTextInRect:actualRect];
+    if (self.rendersAsynchronously) {
+        [self renderTextAsynchronouslyInRect:actualRect];
+    }
+    else {
+        [super drawTextInRect:actualRect];
+    }
+}
+
+#pragma mark Asynchronous rendering
+
+- (void)renderTextAsynchronouslyInRect:(CGRect)rect
+{
+    if (! self.textLayer) {
+        self.textLayer = [CALayer layer];
+        [self.layer addSublayer:self.textLayer];
+    }
+    
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    self.textLayer.frame = self.bounds;
+    [CATransaction commit];
+    
+    if ([self.text length] == 0) {
+        self.renderedTextKey = nil;
+        [self displayRenderedTextImage:nil];
+        return;
+    }
+    
+    // Capture everything the rendering block needs on the main thread, the label must not be accessed from the
+    // background queue
+    NSString *text = [[self.text copy] autorelease];
+    UIFont *font = self.font;
+    UIColor *textColor = (self.highlighted && self.highlightedTextColor) ? self.highlightedTextColor : self.textColor;
+    UIColor *shadowColor = self.shadowColor;
+    CGSize shadowOffset = self.shadowOffset;
+    UILineBreakMode lineBreakMode = self.lineBreakMode;
+    UITextAlignment textAlignment = self.textAlignment;
+    CGSize size = self.bounds.size;
+    CGFloat scale = [UIScreen mainScreen].scale;
+    
+    NSString *key = [NSString stringWithFormat:@"HLSLabel_%@_%.1f_%@_%@_%@_%@_%@_%d_%d_%.1f_%@",
+                     font.fontName, font.pointSize, NSStringFromCGSize(size), NSStringFromCGRect(rect), textColor,
+                     shadowColor, NSStringFromCGSize(shadowOffset), lineBreakMode, textAlignment, scale, text];
+    if ([key isEqualToString:self.renderedTextKey]) {
+        return;
+    }
+    self.renderedTextKey = key;
+    
+    [[HLSImageCache sharedImageCache] loadImageForKey:key withBlock:^{
+        // UIKit string drawing into an image context is thread-safe since iOS 4
+        UIGraphicsBeginImageContextWithOptions(size, NO, scale);
+        CGContextRef context = UIGraphicsGetCurrentContext();
+        [textColor set];
+        if (shadowColor) {
+            // Shadow offsets are not affected by the UIKit flipped coordinate system
+            CGContextSetShadowWithColor(context, CGSizeMake(shadowOffset.width, -shadowOffset.height), 0.f, shadowColor.CGColor);
+        }
+        [text drawInRect:rect withFont:font lineBreakMode:lineBreakMode alignment:textAlignment];
+        UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+        UIGraphicsEndImageContext();
+        return image;
+    } completionBlock:^(UIImage *image) {
+        // Discard the result if the label has changed in the meantime
+        if (! [key isEqualToString:self.renderedTextKey]) {
+            return;
+        }
+        
+        // Should not happen, but fall back to synchronous drawing
+        if (! image) {
+            HLSLoggerWarn(@"The text of label %@ could not be rendered asynchronously", self);
+            self.rendersAsynchronously = NO;
+            return;
+        }
+        
+        [self displayRenderedTextImage:image];
+    }];
+}
+
+- (void)displayRenderedTextImage:(UIImage *)image
+{
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    self.textLayer.contents = (id)image.CGImage;
+    self.textLayer.contentsScale = image ? image.scale : [UIScreen mainScreen].scale;
+    [CATransaction commit];
 }
 
 @end
@@ -22,6 +22,9 @@ typedef enum {
 /**
  * Internal class for containing the localization information attached to a UILabel (see UILabel+HLSDynamicLocalization.m)
  *
+ * Localization information objects are immutable and can therefore be shared between labels. Use the
+ * +localizationInfoWithText: class method to get shared instances
+ *
  * Designated initializer: -initWithText:
  */
 @interface HLSLabelLocalizationInfo : NSObject {
@@ -29,9 +32,14 @@ typedef enum {
     NSString *m_localizationKey;
     NSString *m_table;
     HLSLabelRepresentation m_representation;
-    BOOL m_locked;
 }
 
+/**
+ * Return the localization information corresponding to a text. Information objects are cached so that texts are
+ * parsed only once. Texts without prefix are not parsed at all, and share the same object
+ */
++ (HLSLabelLocalizationInfo *)localizationInfoWithText:(NSString *)text;
+
 /**
  * Create a localization object from a given text, processing any prefix contained in the text (see complete list in
  * UILabel+HLSDynamicLocalization.h)
@@ -54,9 +62,4 @@ typedef enum {
  */
 - (NSString *)localizedText;
 
-/**
- * Used to mark the object as locked
- */
-@property (nonatomic, assign, getter=isLocked) BOOL locked;
-
 @end
@@ -12,9 +12,13 @@
 #import "HLSLogger.h"
 #import "NSArray+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryLocalization
+
 static NSString * const kMissingLocalizedString = @"UILabel_HLSDynamicLocalization_missing";
 
 static NSString *stringForLabelRepresentation(HLSLabelRepresentation representation);
+static BOOL textHasLeadingPrefix(NSString *text);
 
 @interface HLSLabelLocalizationInfo ()
 
@@ -28,6 +32,33 @@ static NSString *stringForLabelRepresentation(HLSLabelRepresentation representat
 
 @implementation HLSLabelLocalizationInfo
 
+#pragma mark Class methods
+
++ (HLSLabelLocalizationInfo *)localizationInfoWithText:(NSString *)text
+{
+    // Fast path for texts without prefix (by far the most common case)
+    if (! textHasLeadingPrefix(text)) {
+        static HLSLabelLocalizationInfo *s_notLocalizedInfo = nil;
+        if (! s_notLocalizedInfo) {
+            s_notLocalizedInfo = [[HLSLabelLocalizationInfo alloc] initWithText:nil];
+        }
+        return s_notLocalizedInfo;
+    }
+    
+    static NSCache *s_textToLocalizationInfoCache = nil;
+    if (! s_textToLocalizationInfoCache) {
+        s_textToLocalizationInfoCache = [[NSCache alloc] init];
+        [s_textToLocalizationInfoCache setName:@"HLSLabelLocalizationInfoCache"];
+    }
+    
+    HLSLabelLocalizationInfo *localizationInfo = [s_textToLocalizationInfoCache objectForKey:text];
+    if (! localizationInfo) {
+        localizationInfo = [[[HLSLabelLocalizationInfo alloc] initWithText:text] autorelease];
+        [s_textToLocalizationInfoCache setObject:localizationInfo forKey:text];
+    }
+    return localizationInfo;
+}
+
 #pragma mark Object creation and destruction
 
 - (id)initWithText:(NSString *)text
@@ -60,12 +91,14 @@ static NSString *stringForLabelRepresentation(HLSLabelRepresentation representat
 
 @synthesize representation = m_representation;
 
-@synthesize locked = m_locked;
-
 #pragma mark Parsing text
 
 - (void)parseText:(NSString *)text
 {
+    if (! textHasLeadingPrefix(text)) {
+        return;
+    }
+    
     // Syntactic elements
     static NSString * const kSeparator = @"/";
     static NSString * const kNormalLeadingPrefix = @"LS";
@@ -274,3 +307,29 @@ static NSString *stringForLabelRepresentation(HLSLabelRepresentation representat
         }
     }
 }
+
+// Cheap check for one of the leading prefixes (LS, ULS, LLS or CLS), either alone or followed by a separator
+static BOOL textHasLeadingPrefix(NSString *text)
+{
+    NSUInteger length = [text length];
+    if (length < 2) {
+        return NO;
+    }
+    
+    NSUInteger prefixLength = 2;
+    unichar firstCharacter = [text characterAtIndex:0];
+    if (firstCharacter == 'U' || firstCharacter == 'C' || (firstCharacter == 'L' && length >= 3 && [text characterAtIndex:1] == 'L')) {
+        prefixLength = 3;
+    }
+    else if (firstCharacter != 'L') {
+        return NO;
+    }
+    
+    if (length < prefixLength
+            || [text characterAtIndex:prefixLength - 2] != 'L'
+            || [text characterAtIndex:prefixLength - 1] != 'S') {
+        return NO;
+    }
+    
+    return length == prefixLength || [text characterAtIndex:prefixLength] == '/';
+}
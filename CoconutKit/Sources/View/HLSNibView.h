@@ -32,13 +32,14 @@
 }
 
 /**
- * Factory method for creating the view. Return an instance of the class it is called on
+ * Factory method for creating the view. Return an instance of the class it is called on. The xib is located
+ * and loaded once per class, and then reused to create views
  * Not meant to be overridden
  */
 + (id)view;
 
 /**
- * Return the view dimensions
+ * Return the view dimensions (as defined in the xib). They are measured once per class
  * Not meant to be overridden
  */
 + (CGFloat)height;
@@ -13,6 +13,13 @@
 #import "NSObject+HLSExtensions.h"
 
 static NSMutableDictionary *s_classNameToSizeMap = nil;
+static NSMutableDictionary *s_classNameToNibMap = nil;
+
+@interface HLSNibView ()
+
++ (UINib *)nib;
+
+@end
 
 @implementation HLSNibView
 
@@ -26,6 +33,7 @@ static NSMutableDictionary *s_classNameToSizeMap = nil;
     }
     
     s_classNameToSizeMap = [[NSMutableDictionary dictionary] retain];
+    s_classNameToNibMap = [[NSMutableDictionary dictionary] retain];
 }
 
 + (id)view
@@ -36,11 +44,11 @@ static NSMutableDictionary *s_classNameToSizeMap = nil;
     }
     
     // A xib has been found, use it
-    NSString *nibName = [self nibName];
-    if ([[NSBundle mainBundle] pathForResource:nibName ofType:@"nib"]) {
-        NSArray *bundleContents = [[NSBundle mainBundle] loadNibNamed:nibName owner:nil options:nil];
+    UINib *nib = [self nib];
+    if (nib) {
+        NSArray *bundleContents = [nib instantiateWithOwner:nil options:nil];
         if ([bundleContents count] == 0) {
-            HLSLoggerError(@"Missing view object in xib file %@", nibName);
+            HLSLoggerError(@"Missing view object in xib file %@", [self nibName]);
             return nil;
         }
         
@@ -59,6 +67,24 @@ static NSMutableDictionary *s_classNameToSizeMap = nil;
     }
 }
 
+// The nib is located and loaded once per class, and then reused for all instances
++ (UINib *)nib
+{
+    id nib = [s_classNameToNibMap objectForKey:[self className]];
+    if (! nib) {
+        NSString *nibName = [self nibName];
+        if ([[NSBundle mainBundle] pathForResource:nibName ofType:@"nib"]) {
+            nib = [UINib nibWithNibName:nibName bundle:nil];
+        }
+        // Not found. Remember it as well
+        else {
+            nib = [NSNull null];
+        }
+        [s_classNameToNibMap setObject:nib forKey:[self className]];
+    }
+    return (nib != [NSNull null]) ? nib : nil;
+}
+
 #pragma mark Class methods for customisation
 
 + (CGFloat)height
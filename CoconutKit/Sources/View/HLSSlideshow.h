@@ -42,15 +42,19 @@ typedef enum {
 @interface HLSSlideshow : UIView <HLSAnimationDelegate> {
 @private
     HLSSlideshowEffect m_effect;
-    NSArray *m_imageViews;                      // Two image views needed (front / back buffer) to create smooth cross-dissolve transitions
+    NSArray *m_imageViews;                      // Image view pool: Current and next images (front / back buffer for smooth cross-dissolve transitions), prefetched image staged in advance
     NSArray *m_imageNamesOrPaths;
     NSInteger m_currentImageIndex;
     NSInteger m_nextImageIndex;
     NSInteger m_currentImageViewIndex;
+    NSInteger m_nextImageViewIndex;
     HLSAnimation *m_animation;
+    BOOL m_kenBurnsAnimationsPaused;
     NSTimeInterval m_imageDuration;
     NSTimeInterval m_transitionDuration;
     BOOL m_random;
+    NSUInteger m_numberOfPrefetchedImages;
+    NSMutableArray *m_randomImageIndexes;       // Random picks made in advance so that they can be prefetched
     id<HLSSlideshowDelegate> m_delegate;
 }
 
@@ -95,6 +99,23 @@ typedef enum {
  */
 @property (nonatomic, assign) BOOL random;
 
+/**
+ * Number of upcoming images which are loaded and decoded in advance on a background queue, at the size they are
+ * displayed with in the slideshow (taking into account the zoom of the Ken Burns effect). Transitions then display
+ * images which are already decoded, instead of loading and decoding them on the main thread right when they are
+ * needed. When images are played sequentially, the images following the next one are prefetched, as well as the
+ * image preceding the current one (for -skipToPreviousImage). When images are played randomly, random picks are 
+ * made in advance and prefetched. Images are not prefetched before the slideshow starts. Prefetched images are 
+ * stored in the shared image cache (see HLSImageCache), and are therefore discarded when a memory warning is received.
+ * Once the image following the next one has been prefetched, it is staged in a spare image view, so that no image view
+ * needs to be prepared when the slideshow moves to the next image
+ *
+ * Set to 0 to disable prefetching. The default value is 1
+ *
+ * This property can be changed while the slideshow is running
+ */
+@property (nonatomic, assign) NSUInteger numberOfPrefetchedImages;
+
 @property (nonatomic, assign) id<HLSSlideshowDelegate> delegate;
 
 /**
@@ -8,8 +8,10 @@
 
 #import "HLSSlideshow.h"
 
+#import "CALayer+HLSExtensions.h"
 #import "HLSAssert.h"
 #import "HLSFloat.h"
+#import "HLSImageCache.h"
 #import "HLSLayerAnimationStep.h"
 #import "HLSLogger.h"
 #import "UIImage+HLSExtensions.h"
@@ -18,20 +20,43 @@
 static const NSTimeInterval kSlideshowDefaultImageDuration = 4.;
 static const NSTimeInterval kSlideshowDefaultTransitionDuration = 3.;
 static const CGFloat kKenBurnsSlideshowMaxScaleFactorDelta = 0.4f;
+static const NSUInteger kKenBurnsSlideshowNumberOfKeyframes = 20;
+static const NSUInteger kSlideshowDefaultNumberOfPrefetchedImages = 1;
+static const NSUInteger kSlideshowNumberOfImageViews = 3;
+
+static NSString * const kKenBurnsAnimationKey = @"HLSSlideshowKenBurnsAnimation";
 
 static const NSInteger kSlideshowNoIndex = -1;
 
+// Function declarations
+static CGSize imageViewSizeForImageSize(CGSize imageSize, CGSize frameSize, HLSSlideshowEffect effect);
+static UIImage *decodedImageForImage(UIImage *image, CGSize frameSize, HLSSlideshowEffect effect, CGFloat scale);
+static UIImage *downsampledImageWithContentsOfFile(NSString *filePath, CGSize frameSize, HLSSlideshowEffect effect, CGFloat scale);
+
 @interface HLSSlideshow () <HLSAnimationDelegate>
 
 - (void)hlsSlideshowInit;
 
 @property (nonatomic, retain) NSArray *imageViews;
 @property (nonatomic, retain) HLSAnimation *animation;
+@property (nonatomic, retain) NSMutableArray *randomImageIndexes;
 
 - (UIImage *)imageForNameOrPath:(NSString *)imageNameOrPath;
+- (NSString *)cacheKeyForImageNameOrPath:(NSString *)imageNameOrPath;
+- (NSString *)filePathForImageNameOrPath:(NSString *)imageNameOrPath;
 - (void)prepareImageView:(UIImageView *)imageView withImageNameOrPath:(NSString *)imageNameOrPath;
 - (void)releaseImageView:(UIImageView *)imageView;
+- (void)releaseImageViews;
 - (NSString *)imageNameOrPathForImageView:(UIImageView *)imageView;
+- (NSUInteger)indexOfImageViewForImageNameOrPath:(NSString *)imageNameOrPath excludingIndex:(NSInteger)excludedIndex;
+
+- (void)prefetchImages;
+- (NSArray *)upcomingImageIndexes;
+- (void)stageImageWithNameOrPath:(NSString *)imageNameOrPath;
+
+- (void)addKenBurnsAnimationToImageView:(UIImageView *)imageView withDelay:(NSTimeInterval)delay;
+- (void)pauseKenBurnsAnimations;
+- (void)resumeKenBurnsAnimations;
 
 - (HLSAnimation *)crossDissolveAnimationWithCurrentImageView:(UIImageView *)currentImageView
                                                nextImageView:(UIImageView *)nextImageView
@@ -53,6 +78,10 @@ static const NSInteger kSlideshowNoIndex = -1;
 - (void)animateImages;
 
 - (NSUInteger)randomIndexWithUpperBound:(NSUInteger)upperBound forbiddenIndex:(NSInteger)forbiddenIndex;
+- (NSUInteger)nextRandomIndexWithForbiddenIndex:(NSInteger)forbiddenIndex;
+
+- (void)applicationDidEnterBackground:(NSNotification *)notification;
+- (void)applicationWillEnterForeground:(NSNotification *)notification;
 
 @end
 
@@ -81,12 +110,20 @@ static const NSInteger kSlideshowNoIndex = -1;
     self.clipsToBounds = YES;           // Uncomment this line to better see what is happening when debugging
     
     m_currentImageIndex = kSlideshowNoIndex;
+    m_currentImageViewIndex = kSlideshowNoIndex;
+    m_nextImageViewIndex = kSlideshowNoIndex;
     
     self.imageViews = [NSArray array];
-    for (NSUInteger i = 0; i < 2; ++i) {
-        UIImageView *imageView = [[[UIImageView alloc] initWithFrame:self.bounds] autorelease];
+    for (NSUInteger i = 0; i < kSlideshowNumberOfImageViews; ++i) {
+        // The Ken Burns motion is applied to a container view, so that it is not affected by the animations applied to
+        // the image view itself (opacity, translations)
+        UIView *containerView = [[[UIView alloc] initWithFrame:self.bounds] autorelease];
+        containerView.autoresizingMask = HLSViewAutoresizingAll;
+        [self addSubview:containerView];
+        
+        UIImageView *imageView = [[[UIImageView alloc] initWithFrame:containerView.bounds] autorelease];
         imageView.autoresizingMask = HLSViewAutoresizingAll;
-        [self addSubview:imageView];
+        [containerView addSubview:imageView];
         
         self.imageViews = [self.imageViews arrayByAddingObject:imageView];
     }
@@ -94,15 +131,35 @@ static const NSInteger kSlideshowNoIndex = -1;
     self.imageDuration = kSlideshowDefaultImageDuration;
     self.transitionDuration = kSlideshowDefaultTransitionDuration;
     self.random = NO;
+    
+    self.numberOfPrefetchedImages = kSlideshowDefaultNumberOfPrefetchedImages;
+    self.randomImageIndexes = [NSMutableArray array];
+    
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(applicationDidEnterBackground:)
+                                                 name:UIApplicationDidEnterBackgroundNotification
+                                               object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(applicationWillEnterForeground:)
+                                                 name:UIApplicationWillEnterForegroundNotification
+                                               object:nil];
 }
 
 - (void)dealloc
 {
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationDidEnterBackgroundNotification
+                                                  object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationWillEnterForegroundNotification
+                                                  object:nil];
+    
     [self stop];
     
     self.imageViews = nil;
     self.imageNamesOrPaths = nil;
     self.animation = nil;
+    self.randomImageIndexes = nil;
     self.delegate = nil;
     
     [super dealloc];
@@ -156,6 +213,9 @@ static const NSInteger kSlideshowNoIndex = -1;
     
     [m_imageNamesOrPaths release];
     m_imageNamesOrPaths = [imageNamesOrPaths retain];
+    
+    // Random picks are indexes into the previous image set
+    [self.randomImageIndexes removeAllObjects];
 }
 
 @synthesize animation = m_animation;
@@ -186,6 +246,17 @@ static const NSInteger kSlideshowNoIndex = -1;
 
 @synthesize random = m_random;
 
+- (void)setRandom:(BOOL)random
+{
+    m_random = random;
+    
+    [self.randomImageIndexes removeAllObjects];
+}
+
+@synthesize numberOfPrefetchedImages = m_numberOfPrefetchedImages;
+
+@synthesize randomImageIndexes = m_randomImageIndexes;
+
 - (BOOL)isRunning
 {
     return self.animation.running;
@@ -215,6 +286,7 @@ static const NSInteger kSlideshowNoIndex = -1;
     m_currentImageIndex = kSlideshowNoIndex;
     m_nextImageIndex = kSlideshowNoIndex;
     m_currentImageViewIndex = kSlideshowNoIndex;
+    m_nextImageViewIndex = kSlideshowNoIndex;
     
     [self playAnimationForNextImage];
 }
@@ -232,6 +304,9 @@ static const NSInteger kSlideshowNoIndex = -1;
     }
     
     [self.animation pause];
+    
+    [self pauseKenBurnsAnimations];
+    m_kenBurnsAnimationsPaused = YES;
 }
 
 - (void)resume
@@ -242,6 +317,9 @@ static const NSInteger kSlideshowNoIndex = -1;
     }
     
     [self.animation resume];
+    
+    [self resumeKenBurnsAnimations];
+    m_kenBurnsAnimationsPaused = NO;
 }
 
 - (void)stop
@@ -256,11 +334,10 @@ static const NSInteger kSlideshowNoIndex = -1;
     
     m_currentImageIndex = kSlideshowNoIndex;
     m_nextImageIndex = kSlideshowNoIndex;
-    m_currentImageViewIndex = kSlideshowNoIndex;
     
-    for (UIImageView *imageView in self.imageViews) {
-        imageView.image = nil;
-    }
+    [self releaseImageViews];
+    
+    [self.randomImageIndexes removeAllObjects];
 }
 
 - (void)skipToNextImage
@@ -272,9 +349,7 @@ static const NSInteger kSlideshowNoIndex = -1;
     [self.animation terminate];
     self.animation = nil;
     
-    for (UIImageView *imageView in self.imageViews) {
-        [self releaseImageView:imageView];
-    }
+    [self releaseImageViews];
     [self playAnimationForNextImage];
 }
 
@@ -287,9 +362,7 @@ static const NSInteger kSlideshowNoIndex = -1;
     [self.animation terminate];
     self.animation = nil;
     
-    for (UIImageView *imageView in self.imageViews) {
-        [self releaseImageView:imageView];
-    }
+    [self releaseImageViews];
     [self playAnimationForPreviousImage];
 }
 
@@ -308,9 +381,7 @@ static const NSInteger kSlideshowNoIndex = -1;
     [self.animation terminate];
     self.animation = nil;
     
-    for (UIImageView *imageView in self.imageViews) {
-        [self releaseImageView:imageView];
-    }
+    [self releaseImageViews];
     [self playAnimationForImageWithNameOrPath:imageNameOrPath];
 }
 
@@ -325,7 +396,11 @@ static const NSInteger kSlideshowNoIndex = -1;
         return [self imageNameOrPathForImageView:currentImageView];        
     }
     else {
-        UIImageView *nextImageView = [self.imageViews objectAtIndex:(m_currentImageViewIndex + 1) % 2];
+        if (m_nextImageViewIndex == kSlideshowNoIndex) {
+            return nil;
+        }
+        
+        UIImageView *nextImageView = [self.imageViews objectAtIndex:m_nextImageViewIndex];
         return [self imageNameOrPathForImageView:nextImageView];
     }
 }
@@ -335,7 +410,23 @@ static const NSInteger kSlideshowNoIndex = -1;
 // Return the image corresponding to a name or path. If the image is not found, return a dummy invisible image
 - (UIImage *)imageForNameOrPath:(NSString *)imageNameOrPath
 {
-    UIImage *image = [UIImage imageNamed:imageNameOrPath];
+    // Prefetched images are already decoded and can be displayed right away
+    HLSImageCache *imageCache = [HLSImageCache sharedImageCache];
+    NSString *cacheKey = [self cacheKeyForImageNameOrPath:imageNameOrPath];
+    UIImage *image = [imageCache imageForKey:cacheKey];
+    if (image) {
+        return image;
+    }
+    
+    // Large images (e.g. photos) are not kept at full resolution
+    image = downsampledImageWithContentsOfFile([self filePathForImageNameOrPath:imageNameOrPath], self.frame.size, self.effect,
+                                               [UIScreen mainScreen].scale);
+    if (image) {
+        [imageCache setImage:image forKey:cacheKey];
+        return image;
+    }
+    
+    image = [UIImage imageNamed:imageNameOrPath];
     if (! image) {
         image = [UIImage imageWithContentsOfFile:imageNameOrPath];
     }
@@ -346,45 +437,37 @@ static const NSInteger kSlideshowNoIndex = -1;
     return image;
 }
 
+// Images are decoded at a size depending on the slideshow frame and effect, which must therefore be part of the key
+// identifying them in the image cache
+- (NSString *)cacheKeyForImageNameOrPath:(NSString *)imageNameOrPath
+{
+    return [NSString stringWithFormat:@"HLSSlideshow_%@_%@_%d", imageNameOrPath, NSStringFromCGSize(self.frame.size), self.effect];
+}
+
+// Locate the file of an image given by name or path, with the same rules as in -imageForNameOrPath: (names are looked up
+// in the main bundle, PNG being the default extension, otherwise the full path is used)
+- (NSString *)filePathForImageNameOrPath:(NSString *)imageNameOrPath
+{
+    NSString *imageName = imageNameOrPath;
+    if ([[imageName pathExtension] length] == 0) {
+        imageName = [imageName stringByAppendingPathExtension:@"png"];
+    }
+    NSString *filePath = [[NSBundle mainBundle] pathForResource:imageName ofType:nil];
+    if (! filePath) {
+        filePath = imageNameOrPath;
+    }
+    return filePath;
+}
+
 // Setup an image view to display a given image. The image view frame is adjusted to get an aspect fill / aspect fit
 // behavior for the image view, and is centered in self. The view alpha is reset to 1
 - (void)prepareImageView:(UIImageView *)imageView withImageNameOrPath:(NSString *)imageNameOrPath
 {
     UIImage *image = [self imageForNameOrPath:imageNameOrPath];
     
-    // Calculate the scale which needs to be applied to get aspect fill behavior for the image view
-    // TODO: This code is quite common (most notably in PDF generator code). Factor it somewhere where it can easily
-    //       be reused
-    CGFloat zoomScale;
-    // Aspect ratios of frame and image
-    CGFloat frameRatio = CGRectGetWidth(self.frame) / CGRectGetHeight(self.frame);
-    CGFloat imageRatio = image.size.width / image.size.height;
-    if (self.effect == HLSSlideshowEffectNone || self.effect == HLSSlideshowEffectCrossDissolve) {
-        // The image is more portrait-shaped than self
-        if (floatlt(imageRatio, frameRatio)) {
-            zoomScale = CGRectGetHeight(self.frame) / image.size.height;
-        }
-        // The image is more landscape-shaped than self
-        else {
-            zoomScale = CGRectGetWidth(self.frame) / image.size.width;
-        }
-    }
-    // Calculate the scale which needs to be applied to get aspect fit behavior for the image view
-    else {
-        // The image is more portrait-shaped than self
-        if (floatlt(imageRatio, frameRatio)) {
-            zoomScale = CGRectGetWidth(self.frame) / image.size.width;
-        }
-        // The image is more landscape-shaped than self
-        else {
-            zoomScale = CGRectGetHeight(self.frame) / image.size.height;
-        }
-    }
-    
     // Update the image view to match the image dimensions with an aspect fill behavior inside self
-    CGFloat scaledImageWidth = ceilf(image.size.width * zoomScale);
-    CGFloat scaledImageHeight = ceilf(image.size.height * zoomScale);
-    imageView.bounds = CGRectMake(0.f, 0.f, scaledImageWidth, scaledImageHeight);
+    CGSize imageViewSize = imageViewSizeForImageSize(image.size, self.frame.size, self.effect);
+    imageView.bounds = CGRectMake(0.f, 0.f, imageViewSize.width, imageViewSize.height);
     imageView.center = CGPointMake(floorf(CGRectGetWidth(self.frame) / 2.f), floorf(CGRectGetHeight(self.frame) / 2.f));
     imageView.layer.transform = CATransform3DIdentity;
     imageView.alpha = 1.f;
@@ -398,6 +481,25 @@ static const NSInteger kSlideshowNoIndex = -1;
     imageView.image = nil;
     imageView.userInfo_hls = nil;
     imageView.layer.transform = CATransform3DIdentity;
+    imageView.hidden = NO;
+    
+    // Remove the Ken Burns motion (restoring the container layer speed if it was paused)
+    CALayer *containerLayer = imageView.superview.layer;
+    if (floateq(containerLayer.speed, 0.f)) {
+        [containerLayer resumeAllAnimations];
+    }
+    [containerLayer removeAnimationForKey:kKenBurnsAnimationKey];
+}
+
+- (void)releaseImageViews
+{
+    for (UIImageView *imageView in self.imageViews) {
+        [self releaseImageView:imageView];
+    }
+    
+    m_currentImageViewIndex = kSlideshowNoIndex;
+    m_nextImageViewIndex = kSlideshowNoIndex;
+    m_kenBurnsAnimationsPaused = NO;
 }
 
 - (NSString *)imageNameOrPathForImageView:(UIImageView *)imageView
@@ -405,44 +507,202 @@ static const NSInteger kSlideshowNoIndex = -1;
     return [[imageView userInfo_hls] objectForKey:@"imageNameOrPath"];
 }
 
-// Randomly move and scale an image view so that it stays in self.view. Returns random scale factors, x and y offsets
-// which can be applied to reach a new random valid state
-- (void)randomlyMoveAndScaleImageView:(UIImageView *)imageView
-                          scaleFactor:(CGFloat *)pScaleFactor
-                              xOffset:(CGFloat *)pXOffset
-                              yOffset:(CGFloat *)pYOffset
+// Return the index of the image view to use for displaying an image: An image view already displaying it (staged in
+// advance) if any, otherwise an unused one, otherwise the first other one, which is released
+- (NSUInteger)indexOfImageViewForImageNameOrPath:(NSString *)imageNameOrPath excludingIndex:(NSInteger)excludedIndex
 {
-    // Pick up a random initial scale factor. Must be >= 1, and not too large. Use random factor in [0;1]
-    CGFloat scaleFactor = 1.f + kKenBurnsSlideshowMaxScaleFactorDelta * (arc4random() % 1001) / 1000.f;
+    NSInteger unusedIndex = kSlideshowNoIndex;
+    NSInteger availableIndex = kSlideshowNoIndex;
+    for (NSUInteger i = 0; i < [self.imageViews count]; ++i) {
+        if ((NSInteger)i == excludedIndex) {
+            continue;
+        }
+        
+        UIImageView *imageView = [self.imageViews objectAtIndex:i];
+        if ([[self imageNameOrPathForImageView:imageView] isEqualToString:imageNameOrPath]) {
+            return i;
+        }
+        
+        if (! imageView.image && unusedIndex == kSlideshowNoIndex) {
+            unusedIndex = i;
+        }
+        if (availableIndex == kSlideshowNoIndex) {
+            availableIndex = i;
+        }
+    }
     
-    // The image is centered in the image view. Calculate the maximum translation offsets we can apply for the selected
-    // scale factor so that the image view still covers self
-    CGFloat maxXOffset = (scaleFactor * CGRectGetWidth(imageView.frame) - CGRectGetWidth(self.frame)) / 2.f;
-    CGFloat maxYOffset = (scaleFactor * CGRectGetHeight(imageView.frame) - CGRectGetHeight(self.frame)) / 2.f;
+    if (unusedIndex != kSlideshowNoIndex) {
+        return unusedIndex;
+    }
     
-    // Pick up some random offsets. Use random factor in [-1;1]
-    CGFloat xOffset = 2 * ((arc4random() % 1001) / 1000.f - 0.5f) * maxXOffset;
-    CGFloat yOffset = 2 * ((arc4random() % 1001) / 1000.f - 0.5f) * maxYOffset;
+    [self releaseImageView:[self.imageViews objectAtIndex:availableIndex]];
+    return availableIndex;
+}
+
+#pragma mark Prefetching images
+
+// Decode the upcoming images in the background and store them in the shared image cache. Images which are not needed
+// anymore are evicted by the cache when it needs room
+- (void)prefetchImages
+{
+    if (self.numberOfPrefetchedImages == 0 || [self.imageNamesOrPaths count] == 0) {
+        return;
+    }
     
-    // Pick up random scale factor to reach at the end of the animation. Same constraints as above
-    CGFloat finalScaleFactor = 1.f + kKenBurnsSlideshowMaxScaleFactorDelta * (arc4random() % 1001) / 1000.f;
-    CGFloat maxFinalXOffset = (finalScaleFactor * CGRectGetWidth(imageView.frame) - CGRectGetWidth(self.frame)) / 2.f;
-    CGFloat maxFinalYOffset = (finalScaleFactor * CGRectGetHeight(imageView.frame) - CGRectGetHeight(self.frame)) / 2.f;
-    CGFloat finalXOffset = 2 * ((arc4random() % 1001) / 1000.f - 0.5f) * maxFinalXOffset;
-    CGFloat finalYOffset = 2 * ((arc4random() % 1001) / 1000.f - 0.5f) * maxFinalYOffset;
+    HLSImageCache *imageCache = [HLSImageCache sharedImageCache];
+    CGSize frameSize = self.frame.size;
+    HLSSlideshowEffect effect = self.effect;
+    CGFloat scale = [UIScreen mainScreen].scale;
+    NSArray *upcomingImageIndexes = [self upcomingImageIndexes];
+    
+    // The first upcoming image is the next one when the slideshow moves to the next image. Stage it as soon as it is
+    // available
+    NSString *stagedImageNameOrPath = nil;
+    if ([upcomingImageIndexes count] != 0) {
+        stagedImageNameOrPath = [self.imageNamesOrPaths objectAtIndex:[[upcomingImageIndexes objectAtIndex:0] unsignedIntegerValue]];
+    }
+    
+    for (NSNumber *imageIndex in upcomingImageIndexes) {
+        NSString *imageNameOrPath = [self.imageNamesOrPaths objectAtIndex:[imageIndex unsignedIntegerValue]];
+        
+        HLSImageCacheCompletionBlock completionBlock = nil;
+        if ([imageNameOrPath isEqualToString:stagedImageNameOrPath]) {
+            completionBlock = ^(UIImage *image) {
+                [self stageImageWithNameOrPath:imageNameOrPath];
+            };
+        }
+        
+        // +[UIImage imageNamed:] cannot be used outside the main thread. Locate the file on the main thread, and load it
+        // in the background. Images already cached or being loaded are not loaded again
+        NSString *filePath = [self filePathForImageNameOrPath:imageNameOrPath];
+        [imageCache loadImageForKey:[self cacheKeyForImageNameOrPath:imageNameOrPath] withBlock:^{
+            // Downsampled images are decoded when they are created
+            UIImage *decodedImage = downsampledImageWithContentsOfFile(filePath, frameSize, effect, scale);
+            if (! decodedImage) {
+                UIImage *image = [UIImage imageWithContentsOfFile:filePath];
+                decodedImage = image ? decodedImageForImage(image, frameSize, effect, scale) : nil;
+            }
+            return decodedImage;
+        } completionBlock:completionBlock];
+    }
+}
+
+// Return the indexes of the images which should be displayed soon
+- (NSArray *)upcomingImageIndexes
+{
+    NSUInteger numberOfImages = [self.imageNamesOrPaths count];
+    NSMutableArray *imageIndexes = [NSMutableArray array];
+    if (self.random) {
+        if (numberOfImages > 1) {
+            // Make the random picks in advance (avoid displaying the same image twice in a row)
+            while ([self.randomImageIndexes count] < self.numberOfPrefetchedImages) {
+                NSInteger previousImageIndex = ([self.randomImageIndexes count] != 0) ? [[self.randomImageIndexes lastObject] integerValue] : m_nextImageIndex;
+                NSUInteger imageIndex = [self randomIndexWithUpperBound:numberOfImages forbiddenIndex:previousImageIndex];
+                [self.randomImageIndexes addObject:[NSNumber numberWithUnsignedInteger:imageIndex]];
+            }
+            [imageIndexes addObjectsFromArray:[self.randomImageIndexes subarrayWithRange:NSMakeRange(0, self.numberOfPrefetchedImages)]];
+        }
+    }
+    else {
+        for (NSUInteger i = 1; i <= self.numberOfPrefetchedImages; ++i) {
+            [imageIndexes addObject:[NSNumber numberWithUnsignedInteger:(m_nextImageIndex + i) % numberOfImages]];
+        }
+        
+        // Add numberOfImages to avoid issues when crossing 0
+        [imageIndexes addObject:[NSNumber numberWithUnsignedInteger:(m_currentImageIndex - 1 + numberOfImages) % numberOfImages]];
+    }
+    return [NSArray arrayWithArray:imageIndexes];
+}
+
+// Display an image in an unused image view, hidden until it is needed, so that no image view has to be prepared when
+// the slideshow moves to this image
+- (void)stageImageWithNameOrPath:(NSString *)imageNameOrPath
+{
+    if (! self.running) {
+        return;
+    }
     
-    // Apply initial transform to set initial image view position
-    imageView.layer.transform = CATransform3DConcat(CATransform3DMakeScale(scaleFactor, scaleFactor, 1.f),
-                                                    CATransform3DMakeTranslation(xOffset, yOffset, 0.f));
+    for (UIImageView *imageView in self.imageViews) {
+        if ([[self imageNameOrPathForImageView:imageView] isEqualToString:imageNameOrPath]) {
+            return;
+        }
+    }
     
-    if (pScaleFactor) {
-        *pScaleFactor = finalScaleFactor / scaleFactor;
+    for (UIImageView *imageView in self.imageViews) {
+        if (imageView.image) {
+            continue;
+        }
+        
+        [self prepareImageView:imageView withImageNameOrPath:imageNameOrPath];
+        imageView.hidden = YES;
+        break;
     }
-    if (pXOffset) {
-        *pXOffset = finalXOffset - xOffset;
+}
+
+#pragma mark Ken Burns effect
+
+// Attach the whole Ken Burns motion of an image (random zooming and panning, from the moment it starts appearing until
+// it has disappeared) to the container of its image view, as a single keyframe animation played by the render server.
+// The motion starts after some delay (negative if it is already in progress)
+- (void)addKenBurnsAnimationToImageView:(UIImageView *)imageView withDelay:(NSTimeInterval)delay
+{
+    CGSize imageViewSize = imageView.bounds.size;
+    CGSize frameSize = self.bounds.size;
+    
+    // Pick up random initial and final scale factors. Must be >= 1, and not too large. Use random factors in [0;1]
+    CGFloat initialScaleFactor = 1.f + kKenBurnsSlideshowMaxScaleFactorDelta * (arc4random() % 1001) / 1000.f;
+    CGFloat finalScaleFactor = 1.f + kKenBurnsSlideshowMaxScaleFactorDelta * (arc4random() % 1001) / 1000.f;
+    
+    // The image is centered in the image view. Pick up random offsets (use random factors in [-1;1]), not larger than
+    // the maximum translation offsets we can apply for the selected scale factors so that the image view still covers self
+    CGFloat initialXOffset = 2 * ((arc4random() % 1001) / 1000.f - 0.5f) * (initialScaleFactor * imageViewSize.width - frameSize.width) / 2.f;
+    CGFloat initialYOffset = 2 * ((arc4random() % 1001) / 1000.f - 0.5f) * (initialScaleFactor * imageViewSize.height - frameSize.height) / 2.f;
+    CGFloat finalXOffset = 2 * ((arc4random() % 1001) / 1000.f - 0.5f) * (finalScaleFactor * imageViewSize.width - frameSize.width) / 2.f;
+    CGFloat finalYOffset = 2 * ((arc4random() % 1001) / 1000.f - 0.5f) * (finalScaleFactor * imageViewSize.height - frameSize.height) / 2.f;
+    
+    // To get a smooth zoom when dividing the total time interval in N equal intervals, each interval must be assigned
+    // a factor (finalScaleFactor / initialScaleFactor)^(1/N), so that the total factor is obtained by multiplying all of
+    // them. Offsets vary linearly
+    NSMutableArray *values = [NSMutableArray array];
+    for (NSUInteger i = 0; i <= kKenBurnsSlideshowNumberOfKeyframes; ++i) {
+        CGFloat progress = (CGFloat)i / kKenBurnsSlideshowNumberOfKeyframes;
+        CGFloat scaleFactor = initialScaleFactor * powf(finalScaleFactor / initialScaleFactor, progress);
+        CGFloat xOffset = initialXOffset + (finalXOffset - initialXOffset) * progress;
+        CGFloat yOffset = initialYOffset + (finalYOffset - initialYOffset) * progress;
+        CATransform3D transform = CATransform3DConcat(CATransform3DMakeScale(scaleFactor, scaleFactor, 1.f),
+                                                      CATransform3DMakeTranslation(xOffset, yOffset, 0.f));
+        [values addObject:[NSValue valueWithCATransform3D:transform]];
     }
-    if (pYOffset) {
-        *pYOffset = finalYOffset - yOffset;
+    
+    CALayer *containerLayer = imageView.superview.layer;
+    CAKeyframeAnimation *keyframeAnimation = [CAKeyframeAnimation animationWithKeyPath:@"transform"];
+    keyframeAnimation.values = values;
+    keyframeAnimation.calculationMode = kCAAnimationLinear;
+    keyframeAnimation.duration = self.imageDuration + 2 * self.transitionDuration;
+    keyframeAnimation.beginTime = [containerLayer convertTime:CACurrentMediaTime() fromLayer:nil] + delay;
+    keyframeAnimation.fillMode = kCAFillModeBoth;
+    keyframeAnimation.removedOnCompletion = NO;
+    [containerLayer addAnimation:keyframeAnimation forKey:kKenBurnsAnimationKey];
+}
+
+// Ken Burns motions are not part of the slideshow animation, and must be paused and resumed separately
+- (void)pauseKenBurnsAnimations
+{
+    for (UIImageView *imageView in self.imageViews) {
+        CALayer *containerLayer = imageView.superview.layer;
+        if ([containerLayer animationForKey:kKenBurnsAnimationKey] && ! floateq(containerLayer.speed, 0.f)) {
+            [containerLayer pauseAllAnimations];
+        }
+    }
+}
+
+- (void)resumeKenBurnsAnimations
+{
+    for (UIImageView *imageView in self.imageViews) {
+        CALayer *containerLayer = imageView.superview.layer;
+        if (floateq(containerLayer.speed, 0.f)) {
+            [containerLayer resumeAllAnimations];
+        }
     }
 }
 
@@ -480,101 +740,19 @@ static const NSInteger kSlideshowNoIndex = -1;
 - (HLSAnimation *)kenBurnsAnimationWithCurrentImageView:(UIImageView *)currentImageView
                                           nextImageView:(UIImageView *)nextImageView
 {
-    // To understand how to calculate the scale factor for each step, divide the total time interval in N equal intervals.
-    // To get a smooth scale animation with total factor scaleFactor, each interval must be assigned a factor (scaleFactor)^(1/N),
-    // so that the total scaleFactor is obtained by multiplying all of them. When grouping m such intervals, the scale factor
-    // for the m intervals is therefore (scaleFactor)^(m/N), thus the formula for the scale factor of each step.
-    
-    CGFloat totalDuration = self.imageDuration + 2 * self.transitionDuration;
-    
-    CGFloat currentImageScaleFactor = 0.f;
-    CGFloat currentImageXOffset = 0.f;
-    CGFloat currentImageYOffset = 0.f;
-    NSDictionary *userInfo = self.animation.userInfo;
-    
-    HLSLayerAnimationStep *animationStep1 = [HLSLayerAnimationStep animationStep];
-    animationStep1.duration = 0.;
-    HLSLayerAnimation *layerAnimation11 = [HLSLayerAnimation animation];
-    [layerAnimation11 addToOpacity:-1.f];
-    [animationStep1 addLayerAnimation:layerAnimation11 forView:nextImageView];
-    
-    // User information attached: Not the first animation loop (and not reset after skipping
-    // to the next or previous image)
-    if ([userInfo objectForKey:@"scaleFactor"]) {
-        currentImageScaleFactor = [[userInfo objectForKey:@"scaleFactor"] floatValue];
-        currentImageXOffset = [[userInfo objectForKey:@"xOffset"] floatValue];
-        currentImageYOffset = [[userInfo objectForKey:@"yOffset"] floatValue];
+    // The current image already moves since it started appearing, except for the first image (or after skipping to
+    // another image). In this case, its motion starts as if it had been appearing for the duration of a transition
+    if (! [currentImageView.superview.layer animationForKey:kKenBurnsAnimationKey]) {
+        [self addKenBurnsAnimationToImageView:currentImageView withDelay:-self.transitionDuration];
     }
-    // No user information attached: First animation loop
-    else {
-        [self randomlyMoveAndScaleImageView:currentImageView 
-                                scaleFactor:&currentImageScaleFactor
-                                    xOffset:&currentImageXOffset 
-                                    yOffset:&currentImageYOffset];
-        
-        HLSLayerAnimation *layerAnimation12 = [HLSLayerAnimation animation];
-        CGFloat scaleFactor12 = powf(currentImageScaleFactor, self.transitionDuration / totalDuration);
-        CGFloat xOffset12 = currentImageXOffset * self.transitionDuration / totalDuration;
-        CGFloat yOffset12 = currentImageYOffset * self.transitionDuration / totalDuration;
-        [layerAnimation12 scaleWithXFactor:scaleFactor12 yFactor:scaleFactor12];
-        [layerAnimation12 translateByVectorWithX:xOffset12 y:yOffset12];
-        [animationStep1 addLayerAnimation:layerAnimation12 forView:currentImageView];
-    }
-    
-    CGFloat nextImageScaleFactor = 0.f;
-    CGFloat nextImageXOffset = 0.f;
-    CGFloat nextImageYOffset = 0.f;
-    [self randomlyMoveAndScaleImageView:nextImageView 
-                            scaleFactor:&nextImageScaleFactor 
-                                xOffset:&nextImageXOffset 
-                                yOffset:&nextImageYOffset];
-    
-    // Displaying the current image
-    HLSLayerAnimationStep *animationStep2 = [HLSLayerAnimationStep animationStep];
-    animationStep2.tag = @"singleImage";
-    animationStep2.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear];         // Linear for smooth transition between steps
-    animationStep2.duration = self.imageDuration;
-    
-    HLSLayerAnimation *layerAnimation21 = [HLSLayerAnimation animation];
-    CGFloat scaleFactor21 = powf(currentImageScaleFactor, self.imageDuration / totalDuration);
-    CGFloat xOffset21 = currentImageXOffset * self.imageDuration / totalDuration;
-    CGFloat yOffset21 = currentImageYOffset * self.imageDuration / totalDuration;
-    [layerAnimation21 scaleWithXFactor:scaleFactor21 yFactor:scaleFactor21];
-    [layerAnimation21 translateByVectorWithX:xOffset21 y:yOffset21];
-    [animationStep2 addLayerAnimation:layerAnimation21 forView:currentImageView];
-    
-    // Transition
-    HLSLayerAnimationStep *animationStep3 = [HLSLayerAnimationStep animationStep];
-    animationStep3.timingFunction = [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear];         // Linear for smooth transition between steps
-    animationStep3.duration = self.transitionDuration;
     
-    HLSLayerAnimation *layerAnimation31 = [HLSLayerAnimation animation];
-    CGFloat scaleFactor31 = powf(currentImageScaleFactor, self.transitionDuration / totalDuration);
-    CGFloat xOffset31 = currentImageXOffset * self.transitionDuration / totalDuration;
-    CGFloat yOffset31 = currentImageYOffset * self.transitionDuration / totalDuration;
-    [layerAnimation31 scaleWithXFactor:scaleFactor31 yFactor:scaleFactor31];
-    [layerAnimation31 translateByVectorWithX:xOffset31 y:yOffset31];
-    [layerAnimation31 addToOpacity:-1.f];
-    [animationStep3 addLayerAnimation:layerAnimation31 forView:currentImageView];
-    
-    HLSLayerAnimation *layerAnimation32 = [HLSLayerAnimation animation];
-    CGFloat scaleFactor32 = powf(nextImageScaleFactor, self.transitionDuration / totalDuration);
-    CGFloat xOffset32 = nextImageXOffset * self.transitionDuration / totalDuration;
-    CGFloat yOffset32 = nextImageYOffset * self.transitionDuration / totalDuration;
-    [layerAnimation32 scaleWithXFactor:scaleFactor32 yFactor:scaleFactor32];
-    [layerAnimation32 translateByVectorWithX:xOffset32 y:yOffset32];
-    [layerAnimation32 addToOpacity:1.f];
-    [animationStep3 addLayerAnimation:layerAnimation32 forView:nextImageView];
+    // The next image starts moving when it starts appearing
+    [self addKenBurnsAnimationToImageView:nextImageView withDelay:self.imageDuration];
     
-    HLSAnimation *animation = [HLSAnimation animationWithAnimationSteps:[NSArray arrayWithObjects:animationStep1,
-                                                                         animationStep2,
-                                                                         animationStep3,
-                                                                         nil]];
-    animation.userInfo = [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithFloat:nextImageScaleFactor], @"scaleFactor",
-                          [NSNumber numberWithFloat:nextImageXOffset], @"xOffset", 
-                          [NSNumber numberWithFloat:nextImageYOffset], @"yOffset",
-                          nil];
-    return animation;
+    // Only the cross-dissolve transition is driven by the slideshow animation
+    return [self crossDissolveAnimationWithCurrentImageView:currentImageView
+                                              nextImageView:nextImageView
+                                         transitionDuration:self.transitionDuration];
 }
 
 - (HLSAnimation *)translationAnimationWithCurrentImageView:(UIImageView *)currentImageView
@@ -684,7 +862,7 @@ static const NSInteger kSlideshowNoIndex = -1;
         if (numberOfImages > 1) {
             // Avoid displaying the same image twice in a row
             m_currentImageIndex = m_nextImageIndex;
-            m_nextImageIndex = [self randomIndexWithUpperBound:numberOfImages forbiddenIndex:m_currentImageIndex];
+            m_nextImageIndex = [self nextRandomIndexWithForbiddenIndex:m_currentImageIndex];
         }
         else {
             m_currentImageIndex = 0;
@@ -780,26 +958,38 @@ static const NSInteger kSlideshowNoIndex = -1;
 
 - (void)animateImages
 {    
-    // Find the image views to use for the current / next images. Only unused image views (i.e. with image == nil)
-    // have to be filled at each step.
-    m_currentImageViewIndex = (m_currentImageViewIndex + 1) % 2;
+    // The image view which displayed the next image during the previous loop now displays the current one. Otherwise
+    // (first loop, or after skipping to another image), find an image view for the current image
+    if (m_nextImageViewIndex != kSlideshowNoIndex) {
+        m_currentImageViewIndex = m_nextImageViewIndex;
+    }
+    else {
+        NSString *currentImageNameOrPath = [self.imageNamesOrPaths objectAtIndex:m_currentImageIndex];
+        m_currentImageViewIndex = [self indexOfImageViewForImageNameOrPath:currentImageNameOrPath excludingIndex:kSlideshowNoIndex];
+    }
     UIImageView *currentImageView = [self.imageViews objectAtIndex:m_currentImageViewIndex];
     if (! currentImageView.image) {
-        NSString *currentImagePath = [self.imageNamesOrPaths objectAtIndex:m_currentImageIndex];
-        [self prepareImageView:currentImageView withImageNameOrPath:currentImagePath];
+        NSString *currentImageNameOrPath = [self.imageNamesOrPaths objectAtIndex:m_currentImageIndex];
+        [self prepareImageView:currentImageView withImageNameOrPath:currentImageNameOrPath];
     }
+    currentImageView.hidden = NO;
     
-    UIImageView *nextImageView = [self.imageViews objectAtIndex:(m_currentImageViewIndex + 1) % 2];
+    // Only prepare the image view for the next image if the image has not been staged in advance
+    NSString *nextImageNameOrPath = [self.imageNamesOrPaths objectAtIndex:m_nextImageIndex];
+    m_nextImageViewIndex = [self indexOfImageViewForImageNameOrPath:nextImageNameOrPath excludingIndex:m_currentImageViewIndex];
+    UIImageView *nextImageView = [self.imageViews objectAtIndex:m_nextImageViewIndex];
     if (! nextImageView.image) {
-        NSString *nextImagePath = [self.imageNamesOrPaths objectAtIndex:m_nextImageIndex];
-        [self prepareImageView:nextImageView withImageNameOrPath:nextImagePath];
+        [self prepareImageView:nextImageView withImageNameOrPath:nextImageNameOrPath];
     }
+    nextImageView.hidden = NO;
     
     // Create and play the animation
     self.animation = [self animationForEffect:self.effect
                              currentImageView:currentImageView
                                 nextImageView:nextImageView];
     [self.animation playAnimated:YES];
+    
+    [self prefetchImages];
 }
 
 #pragma mark Miscellaneous
@@ -815,6 +1005,23 @@ static const NSInteger kSlideshowNoIndex = -1;
     return randomIndex;
 }
 
+// Same as -randomIndexWithUpperBound:forbiddenIndex:, but consuming the random picks made in advance (if still valid)
+- (NSUInteger)nextRandomIndexWithForbiddenIndex:(NSInteger)forbiddenIndex
+{
+    if ([self.randomImageIndexes count] != 0) {
+        NSUInteger randomIndex = [[self.randomImageIndexes objectAtIndex:0] unsignedIntegerValue];
+        [self.randomImageIndexes removeObjectAtIndex:0];
+        if ((NSInteger)randomIndex != forbiddenIndex) {
+            return randomIndex;
+        }
+        
+        // The picks were made for another sequence of images
+        [self.randomImageIndexes removeAllObjects];
+    }
+    
+    return [self randomIndexWithUpperBound:[self.imageNamesOrPaths count] forbiddenIndex:forbiddenIndex];
+}
+
 #pragma mark HLSAnimationDelegate protocol implementation
 
 - (void)animation:(HLSAnimation *)animation didFinishStep:(HLSAnimationStep *)animationStep animated:(BOOL)animated
@@ -825,7 +1032,7 @@ static const NSInteger kSlideshowNoIndex = -1;
             [self.delegate slideshow:self willHideImageWithNameOrPath:[self imageNameOrPathForImageView:currentImageView]];
         }
         
-        UIImageView *nextImageView = [self.imageViews objectAtIndex:(m_currentImageViewIndex + 1) % 2];
+        UIImageView *nextImageView = [self.imageViews objectAtIndex:m_nextImageViewIndex];
         if ([self.delegate respondsToSelector:@selector(slideshow:willShowImageWithNameOrPath:)]) {
             [self.delegate slideshow:self willShowImageWithNameOrPath:[self imageNameOrPathForImageView:nextImageView]];
         }
@@ -854,4 +1061,113 @@ static const NSInteger kSlideshowNoIndex = -1;
     }
 }
 
+#pragma mark Notification callbacks
+
+- (void)applicationDidEnterBackground:(NSNotification *)notification
+{
+    // The slideshow animation is replayed from where it was when the application enters foreground again. Ken Burns
+    // motions must not progress meanwhile
+    [self pauseKenBurnsAnimations];
+}
+
+- (void)applicationWillEnterForeground:(NSNotification *)notification
+{
+    if (! m_kenBurnsAnimationsPaused) {
+        [self resumeKenBurnsAnimations];
+    }
+}
+
 @end
+
+#pragma mark Static functions
+
+// Return the size of an image view displaying an image with the given size, so that the image fills (or fits into) a frame
+// with the given size, depending on the effect
+static CGSize imageViewSizeForImageSize(CGSize imageSize, CGSize frameSize, HLSSlideshowEffect effect)
+{
+    // Calculate the scale which needs to be applied to get aspect fill behavior for the image view
+    // TODO: This code is quite common (most notably in PDF generator code). Factor it somewhere where it can easily
+    //       be reused
+    CGFloat zoomScale;
+    // Aspect ratios of frame and image
+    CGFloat frameRatio = frameSize.width / frameSize.height;
+    CGFloat imageRatio = imageSize.width / imageSize.height;
+    if (effect == HLSSlideshowEffectNone || effect == HLSSlideshowEffectCrossDissolve) {
+        // The image is more portrait-shaped than the frame
+        if (floatlt(imageRatio, frameRatio)) {
+            zoomScale = frameSize.height / imageSize.height;
+        }
+        // The image is more landscape-shaped than the frame
+        else {
+            zoomScale = frameSize.width / imageSize.width;
+        }
+    }
+    // Calculate the scale which needs to be applied to get aspect fit behavior for the image view
+    else {
+        // The image is more portrait-shaped than the frame
+        if (floatlt(imageRatio, frameRatio)) {
+            zoomScale = frameSize.width / imageSize.width;
+        }
+        // The image is more landscape-shaped than the frame
+        else {
+            zoomScale = frameSize.height / imageSize.height;
+        }
+    }
+    
+    return CGSizeMake(ceilf(imageSize.width * zoomScale), ceilf(imageSize.height * zoomScale));
+}
+
+// Load an image file downsampled to the size it is displayed with in a slideshow (taking into account the zoom of the
+// Ken Burns effect). Return nil if the file cannot be read by ImageIO. Can be called from any thread
+static UIImage *downsampledImageWithContentsOfFile(NSString *filePath, CGSize frameSize, HLSSlideshowEffect effect, CGFloat scale)
+{
+    CGSize pixelSize = [UIImage pixelSizeOfImageWithContentsOfFile:filePath];
+    if (CGSizeEqualToSize(pixelSize, CGSizeZero)) {
+        return nil;
+    }
+    
+    CGSize imageViewSize = imageViewSizeForImageSize(pixelSize, frameSize, effect);
+    CGFloat zoomFactor = (effect == HLSSlideshowEffectKenBurns) ? 1.f + kKenBurnsSlideshowMaxScaleFactorDelta : 1.f;
+    NSUInteger maximumPixelSize = (NSUInteger)ceilf(MAX(imageViewSize.width, imageViewSize.height) * zoomFactor * scale);
+    if (maximumPixelSize == 0) {
+        return nil;
+    }
+    
+    return [UIImage imageWithContentsOfFile:filePath maximumPixelSize:maximumPixelSize scale:scale];
+}
+
+// Draw an image into a bitmap with the size it is displayed with in a slideshow (never larger than the original image), 
+// so that it does not need to be decoded when displayed. Can be called from any thread. Images whose orientation is not
+// the default one are returned as is
+static UIImage *decodedImageForImage(UIImage *image, CGSize frameSize, HLSSlideshowEffect effect, CGFloat scale)
+{
+    if (image.imageOrientation != UIImageOrientationUp) {
+        return image;
+    }
+    
+    // Images are zoomed in by the Ken Burns effect
+    CGSize imageViewSize = imageViewSizeForImageSize(image.size, frameSize, effect);
+    CGFloat zoomFactor = (effect == HLSSlideshowEffectKenBurns) ? 1.f + kKenBurnsSlideshowMaxScaleFactorDelta : 1.f;
+    size_t width = MIN((size_t)ceilf(imageViewSize.width * zoomFactor * scale), CGImageGetWidth(image.CGImage));
+    size_t height = MIN((size_t)ceilf(imageViewSize.height * zoomFactor * scale), CGImageGetHeight(image.CGImage));
+    if (width == 0 || height == 0) {
+        return image;
+    }
+    
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little);
+    CGColorSpaceRelease(colorSpace);
+    if (! context) {
+        return image;
+    }
+    
+    CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+    CGContextDrawImage(context, CGRectMake(0.f, 0.f, width, height), image.CGImage);
+    CGImageRef decodedImageRef = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    
+    // Keep the size in points proportional to the size in pixels, so that the aspect ratio is preserved
+    UIImage *decodedImage = [UIImage imageWithCGImage:decodedImageRef scale:scale orientation:UIImageOrientationUp];
+    CGImageRelease(decodedImageRef);
+    return decodedImage;
+}
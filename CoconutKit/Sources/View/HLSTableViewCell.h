@@ -42,11 +42,15 @@
  */
 @interface HLSTableViewCell : UITableViewCell {
 @private
-
+    BOOL m_flattened;
+    BOOL m_flattenedInBackground;
+    UIImageView *m_flattenedContentImageView;           // Single view displaying the flattened content
+    NSString *m_flattenedContentKey;                    // Key of the content currently displayed or being prepared
 }
 
 /**
- * Factory method for creating a table view cell. Return an instance of the class it is called on
+ * Factory method for creating a table view cell. Return an instance of the class it is called on. If a xib is
+ * used, it is located and loaded once per class, and then reused to create cells
  * Not meant to be overridden
  */
 + (id)cellForTableView:(UITableView *)tableView;
@@ -84,13 +88,87 @@
     selectedBackgroundWithImageName:(NSString *)selectedBackgroundImageName;
 
 /**
- * Returns the cell dimensions
+ * Same as -setBackgroundWithImageNamed:selectedBackgroundWithImageName:, but with stretchable images (see 
+ * -[UIImage stretchableImageWithLeftCapWidth:topCapHeight:]), so that small images can be used for cells of any size
+ *
+ * Images are retrieved from the shared image cache (see HLSImageCache), and background image views are reused when 
+ * the cell is configured again, so that all cells share the same images
+ *
+ * Not meant to be overridden
+ */
+- (void)setBackgroundWithImageNamed:(NSString *)backgroundImageName
+    selectedBackgroundWithImageName:(NSString *)selectedBackgroundImageName
+                       leftCapWidth:(NSInteger)leftCapWidth
+                       topCapHeight:(NSInteger)topCapHeight;
+
+/**
+ * Set to YES to draw the content of the standard cell subviews (textLabel, detailTextLabel and imageView) into a single 
+ * image view instead of letting them be composited separately. This reduces the number of layers and the blending 
+ * cost of each cell, which helps keeping long lists scrolling smoothly. The standard subviews are still used for the 
+ * layout, as defined by the cell style, but are hidden. Other subviews you might have added are not affected
+ *
+ * Flattened content is stored in the shared image cache (see HLSImageCache), under a key describing the texts, the
+ * fonts, the colors, the images and the layout of the standard subviews. Cells displaying the same content therefore
+ * share the same image. Images are identified by their address, and must therefore not be modified once assigned
+ *
+ * Default value is NO
+ */
+@property (nonatomic, assign, getter=isFlattened) BOOL flattened;
+
+/**
+ * If set to YES and if the cell is flattened, content which is not found in the image cache is drawn on a background
+ * queue. Until it is available, the standard subviews are displayed as usual
+ *
+ * Default value is NO
+ */
+@property (nonatomic, assign, getter=isFlattenedInBackground) BOOL flattenedInBackground;
+
+/**
+ * Returns the cell dimensions. They are measured once per class
  * Not meant to be overridden
  */
 + (CGFloat)height;
 + (CGFloat)width;
 + (CGSize)size;
 
+/**
+ * Cells whose height depends on the object they display (e.g. because of text of variable length) can override this 
+ * method to compute this height. The template size is the cell size as returned by +size, i.e. the fixed metrics defined
+ * by the xib or the programmatic layout, which you can combine with text measurements (e.g. using -cachedSizeWithFont:
+ * constrainedToSize:lineBreakMode: from NSString+HLSExtensions). This method is called on a background queue when 
+ * heights are precomputed, and therefore must not create or access any view. The default implementation returns the 
+ * height of the template size
+ */
++ (CGFloat)heightForObject:(id)object templateSize:(CGSize)templateSize;
+
+/**
+ * Return the height of a cell displaying an object. Heights are cached, and the cache is keyed by object identity (not
+ * equality). If the height of an object is not in the cache, it is computed on the main thread. Use 
+ * +precomputeHeightsForObjects:completionBlock: to compute heights in advance in the background
+ *
+ * Call this method from the table view heightForRowAtIndexPath: delegate method. Not meant to be overridden
+ */
++ (CGFloat)cachedHeightForObject:(id)object;
+
+/**
+ * Compute the heights of the cells displaying a set of objects on a background queue, and store them in the height cache. 
+ * Heights already in the cache are not computed again. The completion block is called on the main thread when all 
+ * heights are available (e.g. to reload the table view), and can be nil
+ *
+ * Not meant to be overridden
+ */
++ (void)precomputeHeightsForObjects:(NSArray *)objects completionBlock:(void (^)(void))completionBlock;
+
+/**
+ * Remove the cached height of an object (e.g. because its content has changed), or all cached heights for the class 
+ * this method is called on. All heights are removed from the cache when a memory warning is received, or when the 
+ * localization changes (see NSBundle+HLSDynamicLocalization), since displayed texts change as well
+ *
+ * Not meant to be overridden
+ */
++ (void)invalidateCachedHeightForObject:(id)object;
++ (void)invalidateCachedHeights;
+
 /**
  * If the cell layout is created using Interface Builder, override this accessor to return the name of the associated xib
  * file. This is not needed if the xib file name is identical to the class name
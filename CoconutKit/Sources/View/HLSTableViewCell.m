@@ -8,16 +8,53 @@
 
 #import "HLSTableViewCell.h"
 
+#import "HLSImageCache.h"
 #import "HLSLogger.h"
 #import "HLSTableViewCell+Protected.h"
 #import "NSArray+HLSExtensions.h"
+#import "NSBundle+HLSDynamicLocalization.h"
 #import "NSObject+HLSExtensions.h"
 
 static NSMutableDictionary *s_classNameToSizeMap = nil;
+static NSMutableDictionary *s_classNameToNibMap = nil;
+static NSMutableDictionary *s_classNameToObjectHeightMap = nil;
+static NSUInteger s_heightCacheGeneration = 0;        // Incremented when heights are invalidated, so that late results are ignored
+
+// Keys of the dictionaries describing the items of flattened content
+static NSString * const kFlattenedItemTextKey = @"text";
+static NSString * const kFlattenedItemFontKey = @"font";
+static NSString * const kFlattenedItemColorKey = @"color";
+static NSString * const kFlattenedItemShadowColorKey = @"shadowColor";
+static NSString * const kFlattenedItemShadowOffsetKey = @"shadowOffset";
+static NSString * const kFlattenedItemTextAlignmentKey = @"textAlignment";
+static NSString * const kFlattenedItemLineBreakModeKey = @"lineBreakMode";
+static NSString * const kFlattenedItemNumberOfLinesKey = @"numberOfLines";
+static NSString * const kFlattenedItemImageKey = @"image";
+static NSString * const kFlattenedItemFrameKey = @"frame";
+
+// Function declarations
+static NSMutableDictionary *identityMutableDictionary(void);
+static NSDictionary *flattenedLabelItem(UILabel *label, NSMutableString *contentKey);
+static NSDictionary *flattenedImageViewItem(UIImageView *imageView, NSMutableString *contentKey);
+static UIImage *flattenedContentImage(NSArray *items, CGSize size, CGFloat scale);
 
 @interface HLSTableViewCell ()
 
 + (NSString *)findNibName;
++ (UINib *)nib;
+
++ (NSMutableDictionary *)objectToHeightMap;
+
++ (void)currentLocalizationDidChange:(NSNotification *)notification;
++ (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification;
+
+@property (nonatomic, retain) UIImageView *flattenedContentImageView;
+@property (nonatomic, retain) NSString *flattenedContentKey;
+
+- (UIView *)backgroundViewWithImage:(UIImage *)image reusingBackgroundView:(UIView *)backgroundView;
+
+- (void)updateFlattenedContent;
+- (void)displayFlattenedContentImage:(UIImage *)image;
 
 @end
 
@@ -34,6 +71,18 @@ static NSMutableDictionary *s_classNameToSizeMap = nil;
     
     // The size map is common for the whole HLSTableViewCell inheritance hierarchy
     s_classNameToSizeMap = [[NSMutableDictionary dictionary] retain];
+    s_classNameToNibMap = [[NSMutableDictionary dictionary] retain];
+    
+    // Same for the height cache, which contains an object to height map per class
+    s_classNameToObjectHeightMap = [[NSMutableDictionary dictionary] retain];
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(currentLocalizationDidChange:)
+                                                 name:HLSCurrentLocalizationDidChangeNotification
+                                               object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(applicationDidReceiveMemoryWarning:)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
 }
 
 + (id)cellForTableView:(UITableView *)tableView
@@ -43,13 +92,13 @@ static NSMutableDictionary *s_classNameToSizeMap = nil;
     
     // If not, create one lazily
     if (! cell) {
-        NSString *nibName = [self findNibName];
+        UINib *nib = [self nib];
         
         // A xib file is used
-        if (nibName) {
-            NSArray *bundleContents = [[NSBundle mainBundle] loadNibNamed:nibName owner:nil options:nil];
+        if (nib) {
+            NSArray *bundleContents = [nib instantiateWithOwner:nil options:nil];
             if ([bundleContents count] == 0) {
-                HLSLoggerError(@"Missing cell object in xib file %@", nibName);
+                HLSLoggerError(@"Missing cell object in xib file %@", [self findNibName]);
                 return nil;
             }
             
@@ -66,7 +115,7 @@ static NSMutableDictionary *s_classNameToSizeMap = nil;
             if (! [[cell reuseIdentifier] isEqualToString:[self identifier]]) {
                 HLSLoggerWarn(@"The reuse identifier in the xib %@ (%@) does not match the one defined for the class "
                               "(%@). The reuse mechanism will not work properly and the table view will suffer from "
-                              "performance issues", nibName, [cell reuseIdentifier], [self identifier]);
+                              "performance issues", [self findNibName], [cell reuseIdentifier], [self identifier]);
             }
         }
         // Created programmatically
@@ -78,34 +127,216 @@ static NSMutableDictionary *s_classNameToSizeMap = nil;
     return cell;
 }
 
+#pragma mark Object creation and destruction
+
+- (void)dealloc
+{
+    self.flattenedContentImageView = nil;
+    self.flattenedContentKey = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize flattened = m_flattened;
+
+- (void)setFlattened:(BOOL)flattened
+{
+    if (flattened == m_flattened) {
+        return;
+    }
+    
+    m_flattened = flattened;
+    
+    if (! flattened) {
+        [self displayFlattenedContentImage:nil];
+        [self.flattenedContentImageView removeFromSuperview];
+        self.flattenedContentImageView = nil;
+        self.flattenedContentKey = nil;
+    }
+    [self setNeedsLayout];
+}
+
+@synthesize flattenedInBackground = m_flattenedInBackground;
+
+@synthesize flattenedContentImageView = m_flattenedContentImageView;
+
+@synthesize flattenedContentKey = m_flattenedContentKey;
+
+#pragma mark Layout and highlighting
+
+- (void)layoutSubviews
+{
+    [super layoutSubviews];
+    
+    if (m_flattened) {
+        [self updateFlattenedContent];
+    }
+}
+
+// Labels use their highlighted colors when the cell is highlighted or selected. Update the content immediately
+- (void)setHighlighted:(BOOL)highlighted animated:(BOOL)animated
+{
+    [super setHighlighted:highlighted animated:animated];
+    
+    if (m_flattened) {
+        [self updateFlattenedContent];
+    }
+}
+
+- (void)setSelected:(BOOL)selected animated:(BOOL)animated
+{
+    [super setSelected:selected animated:animated];
+    
+    if (m_flattened) {
+        [self updateFlattenedContent];
+    }
+}
+
+#pragma mark Flattened content
+
+- (void)updateFlattenedContent
+{
+    CGSize size = self.contentView.bounds.size;
+    CGFloat scale = [UIScreen mainScreen].scale;
+    if (size.width <= 0.f || size.height <= 0.f) {
+        return;
+    }
+    
+    // Describe the content of the standard subviews, in drawing order
+    NSMutableString *contentKey = [NSMutableString stringWithFormat:@"HLSTableViewCell_flattened_%@_%.1f", NSStringFromCGSize(size), scale];
+    NSMutableArray *items = [NSMutableArray array];
+    NSDictionary *imageViewItem = flattenedImageViewItem(self.imageView, contentKey);
+    if (imageViewItem) {
+        [items addObject:imageViewItem];
+    }
+    NSDictionary *textLabelItem = flattenedLabelItem(self.textLabel, contentKey);
+    if (textLabelItem) {
+        [items addObject:textLabelItem];
+    }
+    NSDictionary *detailTextLabelItem = flattenedLabelItem(self.detailTextLabel, contentKey);
+    if (detailTextLabelItem) {
+        [items addObject:detailTextLabelItem];
+    }
+    
+    if ([contentKey isEqualToString:self.flattenedContentKey]) {
+        return;
+    }
+    self.flattenedContentKey = contentKey;
+    
+    HLSImageCache *imageCache = [HLSImageCache sharedImageCache];
+    UIImage *image = [imageCache imageForKey:contentKey];
+    if (image) {
+        [self displayFlattenedContentImage:image];
+        return;
+    }
+    
+    if (! m_flattenedInBackground) {
+        image = flattenedContentImage(items, size, scale);
+        [imageCache setImage:image forKey:contentKey];
+        [self displayFlattenedContentImage:image];
+        return;
+    }
+    
+    // Display the standard subviews until the content is ready. The cell might have been reused in the meantime
+    [self displayFlattenedContentImage:nil];
+    [imageCache loadImageForKey:contentKey withBlock:^{
+        return flattenedContentImage(items, size, scale);
+    } completionBlock:^(UIImage *image) {
+        if (m_flattened && [contentKey isEqualToString:self.flattenedContentKey]) {
+            [self displayFlattenedContentImage:image];
+        }
+    }];
+}
+
+// If image is nil, display the standard subviews
+- (void)displayFlattenedContentImage:(UIImage *)image
+{
+    if (image) {
+        if (! self.flattenedContentImageView) {
+            self.flattenedContentImageView = [[[UIImageView alloc] initWithFrame:self.contentView.bounds] autorelease];
+            self.flattenedContentImageView.autoresizingMask = UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight;
+            self.flattenedContentImageView.contentMode = UIViewContentModeTopLeft;
+            [self.contentView insertSubview:self.flattenedContentImageView atIndex:0];
+        }
+        self.flattenedContentImageView.frame = self.contentView.bounds;
+    }
+    
+    self.flattenedContentImageView.image = image;
+    self.flattenedContentImageView.hidden = (image == nil);
+    
+    BOOL hidden = (image != nil);
+    self.imageView.hidden = hidden;
+    self.textLabel.hidden = hidden;
+    self.detailTextLabel.hidden = hidden;
+}
+
 #pragma mark Cell customisation
 
 - (void)setBackgroundWithImageNamed:(NSString *)backgroundImageName
     selectedBackgroundWithImageName:(NSString *)selectedBackgroundImageName
 {
+    HLSImageCache *imageCache = [HLSImageCache sharedImageCache];
+    
     if (backgroundImageName) {
-        UIImage *backgroundImage = [UIImage imageNamed:backgroundImageName];
-        if (backgroundImage) {
-            self.backgroundView = [[[UIImageView alloc] initWithImage:backgroundImage] autorelease];
+        UIImage *backgroundImage = [imageCache imageNamed:backgroundImageName];
+        if (! backgroundImage) {
+            HLSLoggerWarn(@"The image %@ does not exist", backgroundImageName);
         }
-        else {
+        self.backgroundView = [self backgroundViewWithImage:backgroundImage reusingBackgroundView:self.backgroundView];
+    }
+    
+    if (selectedBackgroundImageName) {
+        UIImage *selectedBackgroundImage = [imageCache imageNamed:selectedBackgroundImageName];
+        if (! selectedBackgroundImage) {
+            HLSLoggerWarn(@"The image %@ does not exist", selectedBackgroundImageName);
+        }
+        self.selectedBackgroundView = [self backgroundViewWithImage:selectedBackgroundImage reusingBackgroundView:self.selectedBackgroundView];
+    }
+}
+
+- (void)setBackgroundWithImageNamed:(NSString *)backgroundImageName
+    selectedBackgroundWithImageName:(NSString *)selectedBackgroundImageName
+                       leftCapWidth:(NSInteger)leftCapWidth
+                       topCapHeight:(NSInteger)topCapHeight
+{
+    HLSImageCache *imageCache = [HLSImageCache sharedImageCache];
+    
+    if (backgroundImageName) {
+        UIImage *backgroundImage = [imageCache stretchableImageNamed:backgroundImageName leftCapWidth:leftCapWidth topCapHeight:topCapHeight];
+        if (! backgroundImage) {
             HLSLoggerWarn(@"The image %@ does not exist", backgroundImageName);
-            self.backgroundView = nil;
         }
-        
+        self.backgroundView = [self backgroundViewWithImage:backgroundImage reusingBackgroundView:self.backgroundView];
     }
     
     if (selectedBackgroundImageName) {
-        UIImage *selectedBackgroundImage = [UIImage imageNamed:selectedBackgroundImageName];
-        if (selectedBackgroundImage) {
-            self.selectedBackgroundView = [[[UIImageView alloc] initWithImage:selectedBackgroundImage] autorelease];
+        UIImage *selectedBackgroundImage = [imageCache stretchableImageNamed:selectedBackgroundImageName leftCapWidth:leftCapWidth topCapHeight:topCapHeight];
+        if (! selectedBackgroundImage) {
+            HLSLoggerWarn(@"The image %@ does not exist", selectedBackgroundImageName);
         }
-        else {
-            HLSLoggerWarn(@"The image %@ does not exist", selectedBackgroundImage);
-            self.selectedBackgroundView = nil;
+        self.selectedBackgroundView = [self backgroundViewWithImage:selectedBackgroundImage reusingBackgroundView:self.selectedBackgroundView];
+    }
+}
+
+// Return nil if no image is provided. Image views already displaying the image (e.g. when a reused cell is configured 
+// again) are kept or updated instead of being recreated
+- (UIView *)backgroundViewWithImage:(UIImage *)image reusingBackgroundView:(UIView *)backgroundView
+{
+    if (! image) {
+        return nil;
+    }
+    
+    if ([backgroundView isMemberOfClass:[UIImageView class]]) {
+        UIImageView *backgroundImageView = (UIImageView *)backgroundView;
+        if (backgroundImageView.image != image) {
+            backgroundImageView.image = image;
         }
-        self.selectedBackgroundView = [[[UIImageView alloc] initWithImage:selectedBackgroundImage] autorelease];
+        return backgroundImageView;
     }
+    
+    return [[[UIImageView alloc] initWithImage:image] autorelease];
 }
 
 #pragma mark Class methods related to customisation
@@ -162,4 +393,210 @@ static NSMutableDictionary *s_classNameToSizeMap = nil;
     return nibName;
 }
 
+// The nib is located and loaded once per class, and then reused for all instances. Return nil if the cell is created
+// programmatically
++ (UINib *)nib
+{
+    id nib = [s_classNameToNibMap objectForKey:[self className]];
+    if (! nib) {
+        NSString *nibName = [self findNibName];
+        nib = nibName ? [UINib nibWithNibName:nibName bundle:nil] : [NSNull null];
+        [s_classNameToNibMap setObject:nib forKey:[self className]];
+    }
+    return (nib != [NSNull null]) ? nib : nil;
+}
+
+#pragma mark Cell heights
+
++ (CGFloat)heightForObject:(id)object templateSize:(CGSize)templateSize
+{
+    return templateSize.height;
+}
+
++ (CGFloat)cachedHeightForObject:(id)object
+{
+    NSMutableDictionary *objectToHeightMap = [self objectToHeightMap];
+    NSNumber *heightNumber = [objectToHeightMap objectForKey:object];
+    if (! heightNumber) {
+        heightNumber = [NSNumber numberWithFloat:[self heightForObject:object templateSize:[self size]]];
+        CFDictionarySetValue((CFMutableDictionaryRef)objectToHeightMap, object, heightNumber);
+    }
+    return [heightNumber floatValue];
+}
+
++ (void)precomputeHeightsForObjects:(NSArray *)objects completionBlock:(void (^)(void))completionBlock
+{
+    // Only compute missing heights
+    NSMutableDictionary *objectToHeightMap = [self objectToHeightMap];
+    NSMutableArray *missingObjects = [NSMutableArray array];
+    for (id object in objects) {
+        if (! [objectToHeightMap objectForKey:object]) {
+            [missingObjects addObject:object];
+        }
+    }
+    
+    // The cell metrics are read once on the main thread (this might require the xib to be loaded)
+    CGSize templateSize = [self size];
+    NSUInteger generation = s_heightCacheGeneration;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        NSMutableArray *heightNumbers = [NSMutableArray arrayWithCapacity:[missingObjects count]];
+        for (id object in missingObjects) {
+            [heightNumbers addObject:[NSNumber numberWithFloat:[self heightForObject:object templateSize:templateSize]]];
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            // Heights computed before the cache was invalidated might be wrong
+            if (generation == s_heightCacheGeneration) {
+                NSMutableDictionary *objectToHeightMap = [self objectToHeightMap];
+                for (NSUInteger i = 0; i < [missingObjects count]; ++i) {
+                    CFDictionarySetValue((CFMutableDictionaryRef)objectToHeightMap, [missingObjects objectAtIndex:i], [heightNumbers objectAtIndex:i]);
+                }
+            }
+            
+            if (completionBlock) {
+                completionBlock();
+            }
+        });
+        
+        [pool drain];
+    });
+}
+
+// Pending height computations might have started before an invalidation. Their results are discarded
++ (void)invalidateCachedHeightForObject:(id)object
+{
+    ++s_heightCacheGeneration;
+    [[self objectToHeightMap] removeObjectForKey:object];
+}
+
++ (void)invalidateCachedHeights
+{
+    ++s_heightCacheGeneration;
+    [s_classNameToObjectHeightMap removeObjectForKey:[self className]];
+}
+
++ (NSMutableDictionary *)objectToHeightMap
+{
+    NSMutableDictionary *objectToHeightMap = [s_classNameToObjectHeightMap objectForKey:[self className]];
+    if (! objectToHeightMap) {
+        objectToHeightMap = identityMutableDictionary();
+        [s_classNameToObjectHeightMap setObject:objectToHeightMap forKey:[self className]];
+    }
+    return objectToHeightMap;
+}
+
+#pragma mark Notification callbacks
+
++ (void)currentLocalizationDidChange:(NSNotification *)notification
+{
+    ++s_heightCacheGeneration;
+    [s_classNameToObjectHeightMap removeAllObjects];
+}
+
++ (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification
+{
+    ++s_heightCacheGeneration;
+    [s_classNameToObjectHeightMap removeAllObjects];
+}
+
 @end
+
+#pragma mark Static functions
+
+// Return a mutable dictionary comparing keys by identity (pointer equality) and retaining them. Use CFDictionarySetValue
+// to add an entry, since -setObject:forKey: would copy the key
+static NSMutableDictionary *identityMutableDictionary(void)
+{
+    CFDictionaryKeyCallBacks keyCallBacks = kCFTypeDictionaryKeyCallBacks;
+    keyCallBacks.equal = NULL;
+    keyCallBacks.hash = NULL;
+    return [(NSMutableDictionary *)CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &keyCallBacks, &kCFTypeDictionaryValueCallBacks) autorelease];
+}
+
+// Return nil if the label has nothing to draw. The description of the item is appended to the content key
+static NSDictionary *flattenedLabelItem(UILabel *label, NSMutableString *contentKey)
+{
+    if (! label || [label.text length] == 0) {
+        return nil;
+    }
+    
+    UIColor *color = (label.highlighted && label.highlightedTextColor) ? label.highlightedTextColor : label.textColor;
+    NSMutableDictionary *item = [NSMutableDictionary dictionaryWithObjectsAndKeys:label.text, kFlattenedItemTextKey,
+                                 label.font, kFlattenedItemFontKey,
+                                 color, kFlattenedItemColorKey,
+                                 [NSNumber numberWithInt:label.textAlignment], kFlattenedItemTextAlignmentKey,
+                                 [NSNumber numberWithInt:label.lineBreakMode], kFlattenedItemLineBreakModeKey,
+                                 [NSNumber numberWithInteger:label.numberOfLines], kFlattenedItemNumberOfLinesKey,
+                                 [NSValue valueWithCGRect:label.frame], kFlattenedItemFrameKey,
+                                 nil];
+    if (label.shadowColor) {
+        [item setObject:label.shadowColor forKey:kFlattenedItemShadowColorKey];
+        [item setObject:[NSValue valueWithCGSize:label.shadowOffset] forKey:kFlattenedItemShadowOffsetKey];
+    }
+    
+    [contentKey appendFormat:@"_[%@|%@|%.1f|%@|%@|%@|%d|%d|%d|%@]", label.text, label.font.fontName, label.font.pointSize, color,
+     label.shadowColor, NSStringFromCGSize(label.shadowOffset), label.textAlignment, label.lineBreakMode, label.numberOfLines,
+     NSStringFromCGRect(label.frame)];
+    return [NSDictionary dictionaryWithDictionary:item];
+}
+
+// Return nil if the image view has nothing to draw. The description of the item is appended to the content key
+static NSDictionary *flattenedImageViewItem(UIImageView *imageView, NSMutableString *contentKey)
+{
+    UIImage *image = (imageView.highlighted && imageView.highlightedImage) ? imageView.highlightedImage : imageView.image;
+    if (! image) {
+        return nil;
+    }
+    
+    [contentKey appendFormat:@"_[%p|%@]", image, NSStringFromCGRect(imageView.frame)];
+    return [NSDictionary dictionaryWithObjectsAndKeys:image, kFlattenedItemImageKey,
+            [NSValue valueWithCGRect:imageView.frame], kFlattenedItemFrameKey,
+            nil];
+}
+
+// Draw the items in a transparent image. Only uses UIKit drawing into an image context, and can therefore be called
+// from any thread
+static UIImage *flattenedContentImage(NSArray *items, CGSize size, CGFloat scale)
+{
+    UIGraphicsBeginImageContextWithOptions(size, NO, scale);
+    CGContextRef context = UIGraphicsGetCurrentContext();
+    
+    for (NSDictionary *item in items) {
+        CGRect frame = [[item objectForKey:kFlattenedItemFrameKey] CGRectValue];
+        
+        UIImage *image = [item objectForKey:kFlattenedItemImageKey];
+        if (image) {
+            [image drawInRect:frame];
+            continue;
+        }
+        
+        NSString *text = [item objectForKey:kFlattenedItemTextKey];
+        UIFont *font = [item objectForKey:kFlattenedItemFontKey];
+        UILineBreakMode lineBreakMode = [[item objectForKey:kFlattenedItemLineBreakModeKey] intValue];
+        UITextAlignment textAlignment = [[item objectForKey:kFlattenedItemTextAlignmentKey] intValue];
+        NSInteger numberOfLines = [[item objectForKey:kFlattenedItemNumberOfLinesKey] integerValue];
+        
+        // Text is vertically centered, as for UILabel
+        CGFloat maximumHeight = (numberOfLines == 0) ? frame.size.height : MIN(font.lineHeight * numberOfLines, frame.size.height);
+        CGSize textSize = [text sizeWithFont:font constrainedToSize:CGSizeMake(frame.size.width, maximumHeight) lineBreakMode:lineBreakMode];
+        CGRect textFrame = CGRectMake(frame.origin.x,
+                                      frame.origin.y + floorf((frame.size.height - textSize.height) / 2.f),
+                                      frame.size.width,
+                                      textSize.height);
+        
+        CGContextSaveGState(context);
+        UIColor *shadowColor = [item objectForKey:kFlattenedItemShadowColorKey];
+        if (shadowColor) {
+            CGContextSetShadowWithColor(context, [[item objectForKey:kFlattenedItemShadowOffsetKey] CGSizeValue], 0.f, shadowColor.CGColor);
+        }
+        [[item objectForKey:kFlattenedItemColorKey] set];
+        [text drawInRect:textFrame withFont:font lineBreakMode:lineBreakMode alignment:textAlignment];
+        CGContextRestoreGState(context);
+    }
+    
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    return image;
+}
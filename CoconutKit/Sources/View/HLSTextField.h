@@ -52,6 +52,8 @@
 @private
     HLSTextFieldTouchDetector *m_touchDetector;
     CGFloat m_minVisibilityDistance;
+    UIScrollView *m_bottomMostScrollView;                   // cached, valid iff m_bottomMostScrollViewResolved
+    BOOL m_bottomMostScrollViewResolved;
 }
 
 /**
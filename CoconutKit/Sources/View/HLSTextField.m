@@ -59,6 +59,12 @@ static CGFloat s_originalYOffset = 0.f;
  */
 static UIScrollView *s_scrollView = nil;
 
+/**
+ * Set to YES while keyboard events must be forwarded to the current text field. Only the text field class is attached
+ * to HLSKeyboardInformation, so that a single observer receives keyboard events, whatever the number of text fields
+ */
+static BOOL s_trackingKeyboard = NO;
+
 @interface HLSTextField ()
 
 @property (nonatomic, retain) HLSTextFieldTouchDetector *touchDetector;
@@ -68,13 +74,23 @@ static UIScrollView *s_scrollView = nil;
 
 - (void)hlsTextFieldInit;
 
-- (void)keyboardWillShow:(NSNotification *)notification;
-- (void)keyboardWillHide:(NSNotification *)notification;
+- (UIScrollView *)bottomMostScrollView;
 
 @end
 
 @implementation HLSTextField
 
+#pragma mark Class methods
+
++ (void)initialize
+{
+    if (self != [HLSTextField class]) {
+        return;
+    }
+    
+    [HLSKeyboardInformation addObserver:(id<HLSKeyboardInformationObserver>)self];
+}
+
 #pragma mark Object creation and destruction
 
 - (id)initWithFrame:(CGRect)frame
@@ -169,27 +185,19 @@ static UIScrollView *s_scrollView = nil;
     // Calling the super method first; two cases can lead to becomeFirstResponder being called:
     //   - we are entering input mode. The keyboard appears, which fires a UIKeyboardWillShowNotification during
     //     the becomeFirstResponder call. We do not want to catch such events yet (we use them to detect interface
-    //     orientation changes only), we must therefore register with the notification center after the call to
-    //     the super becomeFirstResponder method has returned
+    //     orientation changes only), we must therefore start tracking keyboard events after the call to the super
+    //     becomeFirstResponder method has returned
     //   - when clicking a text field while another one was already active, the keyboard stays visible and no
-    //     keyboard events are fired. Even if a text field is registered with the notification center, the
-    //     keyboardWillShow: method will not be called (which is what we want; we only want this method to be
-    //     called when orientation changes)
+    //     keyboard events are fired. Even if keyboard events are tracked, +keyboardWillShowWithInformation: will
+    //     not be called (which is what we want; we only want this method to be called when orientation changes)
     [super becomeFirstResponder];       // UITextField implementation always return YES, see documentation
     
     // Move the scroll view so that the field is visible (if not already)
     [HLSTextField offsetScrollForTextField:self animated:YES];    
     
-    // Register for keyboard notifications so that the new responder can answer to keyboard events (the registration
-    // is here carefully made so that those events always correspond to device rotation)
-    [[NSNotificationCenter defaultCenter] addObserver:self 
-                                             selector:@selector(keyboardWillShow:) 
-                                                 name:UIKeyboardWillShowNotification 
-                                               object:nil];
-    [[NSNotificationCenter defaultCenter] addObserver:self 
-                                             selector:@selector(keyboardWillHide:) 
-                                                 name:UIKeyboardWillHideNotification 
-                                               object:nil]; 
+    // Track keyboard events so that the new responder can answer to them (tracking is here carefully enabled so that
+    // those events always correspond to device rotation)
+    s_trackingKeyboard = YES;
     
     return YES;
 }
@@ -202,23 +210,17 @@ static UIScrollView *s_scrollView = nil;
         return YES;
     }
         
-    // Unregister from the notification center first; important since we only want to track rotation events
-    [[NSNotificationCenter defaultCenter] removeObserver:self
-                                                    name:UIKeyboardWillShowNotification
-                                                  object:nil];
-    [[NSNotificationCenter defaultCenter] removeObserver:self
-                                                    name:UIKeyboardWillHideNotification
-                                                  object:nil];    
+    // Stop tracking keyboard events first; important since we only want to track rotation events
+    s_trackingKeyboard = NO;
     
     // Calling the super method first; two cases can lead to resignFirstResponder being called:
     //   - we are exiting input mode. The keyboard disappears, which fires a UIKeyboardWillHideNotification during
     //     the resignFirstResponder call. We do not want to catch such events (we will use them to detect interface
-    //     orientation changes only), we had therefore to unregister from the notification center before the call to
-    //     the super resignFirstResponder method is made
+    //     orientation changes only), we had therefore to stop tracking keyboard events before the call to the super 
+    //     resignFirstResponder method is made
     //   - when clicking a text field while another one was already active, the keyboard stays visible and no
-    //     keyboard events are fired. Even if a text field is registered with the notification center, the
-    //     keyboardWillHide: method will not be called (which is what we want; we only want this method to be
-    //     called when orientation changes)
+    //     keyboard events are fired. Even if keyboard events are tracked, +keyboardWillHide will not be called 
+    //     (which is what we want; we only want this method to be called when orientation changes)
     [super resignFirstResponder];       // UITextField implementation always return YES, see documentation
     
     // The current HLSTextField is losing the focus, reset scroll view offset
@@ -238,14 +240,7 @@ static UIScrollView *s_scrollView = nil;
 + (void)offsetScrollForTextField:(HLSTextField *)textField animated:(BOOL)animated
 {
     // Locate the bottommost scroll view containing the text field
-    UIScrollView *bottomMostscrollView = nil;
-    UIView *parentView = [textField superview];
-    while (parentView) {
-        if ([parentView isKindOfClass:[UIScrollView class]]) {    
-            bottomMostscrollView = (UIScrollView *)parentView;
-        }
-        parentView = [parentView superview];
-    }
+    UIScrollView *bottomMostscrollView = [textField bottomMostScrollView];
     
     // If a different scroll view was already assigned an offset, reset it. We must offset at most one scroll 
     // view at a time, and we are done with the old one since the field we are now tracking is wrapped in 
@@ -367,23 +362,76 @@ static UIScrollView *s_scrollView = nil;
     s_originalYOffset = 0.f;
 }
 
-#pragma mark Notification callbacks
+#pragma mark View hierarchy changes
+
+- (void)didMoveToSuperview
+{
+    [super didMoveToSuperview];
+    
+    m_bottomMostScrollViewResolved = NO;
+    m_bottomMostScrollView = nil;
+}
+
+/**
+ * Also catches changes made higher up in the view hierarchy, provided they change the window (a text field can only
+ * be edited when it is displayed)
+ */
+- (void)didMoveToWindow
+{
+    [super didMoveToWindow];
+    
+    m_bottomMostScrollViewResolved = NO;
+    m_bottomMostScrollView = nil;
+}
+
+/**
+ * Return the bottommost scroll view containing the text field. The result is cached until the text field is moved
+ * in the view hierarchy
+ */
+- (UIScrollView *)bottomMostScrollView
+{
+    if (! m_bottomMostScrollViewResolved) {
+        UIScrollView *bottomMostScrollView = nil;
+        UIView *parentView = [self superview];
+        while (parentView) {
+            if ([parentView isKindOfClass:[UIScrollView class]]) {    
+                bottomMostScrollView = (UIScrollView *)parentView;
+            }
+            parentView = [parentView superview];
+        }
+        
+        m_bottomMostScrollView = bottomMostScrollView;
+        m_bottomMostScrollViewResolved = YES;
+    }
+    
+    return m_bottomMostScrollView;
+}
+
+#pragma mark Keyboard events (HLSKeyboardInformationObserver protocol, implemented by the class)
 
 /**
  * Extremely important: When rotating the interface with the keyboard enabled, the willShow event is fired after the new
  * orientation has been installed, i.e. coordinates are relative to the new orientation
  */
-- (void)keyboardWillShow:(NSNotification *)notification
++ (void)keyboardWillShowWithInformation:(HLSKeyboardInformation *)keyboardInformation
 {
-    [HLSTextField offsetScrollForTextField:self animated:NO];
+    if (! s_trackingKeyboard || ! s_currentTextField) {
+        return;
+    }
+    
+    [HLSTextField offsetScrollForTextField:s_currentTextField animated:NO];
 }
 
 /**
  * Extremely important: When rotating the interface with the keyboard enabled, the willHide event is fired before the new
  * orientation has been installed, i.e. coordinates are relative to the old orientation
  */
-- (void)keyboardWillHide:(NSNotification *)notification
++ (void)keyboardWillHide
 {
+    if (! s_trackingKeyboard) {
+        return;
+    }
+    
     [HLSTextField restoreScrollAnimated:NO];
 }
 
@@ -10,7 +10,7 @@
  * Category for easier label localization in nib files. Instead of having to define and bind an outlet just 
  * to localize a UILabel or a UIButton, this category makes it easy to attach a localization key to a label
  * or a button label directly in a nib file. Simply set the text in the nib using one of the following
- * constructs:
+ * constructs (this feature must be enabled first, see +enable):
  *   - LS/<localizationKey>[/T/<table>/]: Will be replaced by the localized string corresponding to the 
  *                                        localization key (lookup is performed in the main bundle 
  *                                        Localizable.strings file if no explicit table is provided)
@@ -43,7 +43,12 @@
  *   [[NSUserDefaults standardUserDefaults] setValue:[NSNumber numberWithBool:YES] forKey:@"NSShowNonLocalizedStrings"];
  *
  * This category integrates with HLSBundle+HLSDynamicLocalization so that localized labels are updated when the 
- * localization language is changed at runtime.
+ * localization language is changed at runtime. Labels currently displayed in a window are updated immediately,
+ * other labels only when they are added to a window again.
+ *
+ * Labels whose text has never contained one of the above prefixes incur almost no overhead: Their text is set as
+ * usual, and no information is attached to them. A label becomes localized the first time it receives a text with
+ * prefix.
  *
  * This category currently has three limitations, but which should not be real issues:
  *   - only localization dictionaries in the main bundle are considered. For applications this should not be
@@ -61,6 +66,14 @@
  */
 @interface UILabel (HLSDynamicLocalization)
 
+/**
+ * Call this method as soon as possible (before any nib is loaded) to enable label localization using prefixes. The
+ * methods it requires are only swizzled when it is called, so that applications which do not need label localization
+ * do not pay for it. For simplicity you should use the HLSEnableUILabelDynamicLocalization convenience macro instead
+ * (see HLSOptionalFeatures.h)
+ */
++ (void)enable;
+
 /**
  * When set to YES, reveals those labels for which a localization string is missing (for the current language)
  * (yellow background)
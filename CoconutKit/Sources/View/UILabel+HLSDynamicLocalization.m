@@ -10,27 +10,39 @@
 
 #import "HLSLabelLocalizationInfo.h"
 #import "HLSLogger.h"
+#import "HLSPersistentDictionary.h"
 #import "HLSRuntime.h"
 #import "NSBundle+HLSDynamicLocalization.h"
 #import "NSDictionary+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryLocalization
+
 static BOOL s_missingLocalizationsVisible = NO;
 
+// Labels localized with prefixes, and those among them which must be localized again when they are next displayed.
+// Labels are not retained (they remove themselves when deallocated)
+static CFMutableSetRef s_localizedLabels = NULL;
+static CFMutableSetRef s_staleLocalizedLabels = NULL;
+
 // Keys for associated objects
 static void *s_localizationInfosKey = &s_localizationInfosKey;
 static void *s_originalBackgroundColorKey = &s_originalBackgroundColorKey;
+static void *s_localizationLockedKey = &s_localizationLockedKey;
 
 // Original implementation of the methods we swizzle
 static void (*s_UILabel__dealloc_Imp)(id, SEL) = NULL;
 static void (*s_UILabel__awakeFromNib_Imp)(id, SEL) = NULL;
 static void (*s_UILabel__setText_Imp)(id, SEL, id) = NULL;
 static void (*s_UILabel__setBackgroundColor_Imp)(id, SEL, id) = NULL;
+static void (*s_UILabel__didMoveToWindow_Imp)(id, SEL) = NULL;
 
 // Swizzled method implementations
 static void swizzled_UILabel__dealloc_Imp(UILabel *self, SEL _cmd);
 static void swizzled_UILabel__awakeFromNib_Imp(UILabel *self, SEL _cmd);
 static void swizzled_UILabel__setText_Imp(UILabel *self, SEL _cmd, NSString *text);
 static void swizzled_UILabel__setBackgroundColor_Imp(UILabel *self, SEL _cmd, UIColor *backgroundColor);
+static void swizzled_UILabel__didMoveToWindow_Imp(UILabel *self, SEL _cmd);
 
 @interface UILabel (HLSDynamicLocalizationPrivate)
 
@@ -39,8 +51,9 @@ static void swizzled_UILabel__setBackgroundColor_Imp(UILabel *self, SEL _cmd, UI
 
 - (void)setAndLocalizeText:(NSString *)text;
 - (void)localizeTextWithLocalizationInfo:(HLSLabelLocalizationInfo *)localizationInfo;
+- (void)relocalizeText;
 
-- (void)currentLocalizationDidChange:(NSNotification *)notification;
++ (void)currentLocalizationDidChange:(NSNotification *)notification;
 
 @end
 
@@ -48,6 +61,35 @@ static void swizzled_UILabel__setBackgroundColor_Imp(UILabel *self, SEL _cmd, UI
 
 #pragma mark Class methods
 
++ (void)enable
+{
+    static BOOL s_enabled = NO;
+    if (s_enabled) {
+        HLSLoggerInfo(@"Label dynamic localization already enabled");
+        return;
+    }
+    
+    HLSSwizzlingEntry entries[] = {
+        { @selector(dealloc), (IMP)swizzled_UILabel__dealloc_Imp, (IMP *)&s_UILabel__dealloc_Imp },
+        { @selector(awakeFromNib), (IMP)swizzled_UILabel__awakeFromNib_Imp, (IMP *)&s_UILabel__awakeFromNib_Imp },
+        { @selector(setText:), (IMP)swizzled_UILabel__setText_Imp, (IMP *)&s_UILabel__setText_Imp },
+        { @selector(setBackgroundColor:), (IMP)swizzled_UILabel__setBackgroundColor_Imp, (IMP *)&s_UILabel__setBackgroundColor_Imp },
+        { @selector(didMoveToWindow), (IMP)swizzled_UILabel__didMoveToWindow_Imp, (IMP *)&s_UILabel__didMoveToWindow_Imp }
+    };
+    HLSSwizzleSelectors(self, entries, sizeof(entries) / sizeof(HLSSwizzlingEntry), "UILabel+HLSDynamicLocalization");
+    
+    s_localizedLabels = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+    s_staleLocalizedLabels = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+    
+    // A single observer for all labels, instead of one per label
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(currentLocalizationDidChange:)
+                                                 name:HLSCurrentLocalizationDidChangeNotification
+                                               object:nil];
+    
+    s_enabled = YES;
+}
+
 + (void)setMissingLocalizationsVisible:(BOOL)visible
 {
     s_missingLocalizationsVisible = visible;
@@ -65,24 +107,6 @@ static void swizzled_UILabel__setBackgroundColor_Imp(UILabel *self, SEL _cmd, UI
 
 @implementation UILabel (HLSDynamicLocalizationPrivate)
 
-#pragma mark Class methods
-
-+ (void)load
-{
-    s_UILabel__dealloc_Imp = (void (*)(id, SEL))HLSSwizzleSelector(self, 
-                                                                   @selector(dealloc), 
-                                                                   (IMP)swizzled_UILabel__dealloc_Imp);
-    s_UILabel__awakeFromNib_Imp = (void (*)(id, SEL))HLSSwizzleSelector(self, 
-                                                                        @selector(awakeFromNib),
-                                                                        (IMP)swizzled_UILabel__awakeFromNib_Imp);
-    s_UILabel__setText_Imp = (void (*)(id, SEL, id))HLSSwizzleSelector(self, 
-                                                                       @selector(setText:), 
-                                                                       (IMP)swizzled_UILabel__setText_Imp);
-    s_UILabel__setBackgroundColor_Imp = (void (*)(id, SEL, id))HLSSwizzleSelector(self,
-                                                                                  @selector(setBackgroundColor:),
-                                                                                  (IMP)swizzled_UILabel__setBackgroundColor_Imp);
-}
-
 #pragma mark Localization
 
 - (HLSLabelLocalizationInfo *)localizationInfo
@@ -116,7 +140,7 @@ static void swizzled_UILabel__setBackgroundColor_Imp(UILabel *self, SEL _cmd, UI
         // Get localization info for all states (lazily added if needed). Attached to the button (because it carries the states)
         NSDictionary *buttonStateToLocalizationInfoMap = objc_getAssociatedObject(button, s_localizationInfosKey);
         if (! buttonStateToLocalizationInfoMap) {
-            buttonStateToLocalizationInfoMap = [NSDictionary dictionary];
+            buttonStateToLocalizationInfoMap = [HLSPersistentDictionary dictionary];
         }
         
         // Attach the information to the current button state
@@ -156,25 +180,32 @@ static void swizzled_UILabel__setBackgroundColor_Imp(UILabel *self, SEL _cmd, UI
     // though, since the prefix-in-nib trick makes really sense for static labels (those which do not have 
     // to be connected using outlets). By definition such labels have a constant text (except of course if 
     // you want to mess with the view hierarchy to set a label. But do you really want to?)
+    //
+    // Labels which have never received a text with prefix (by far the most common case) take a fast path, and
+    // no information is attached to them
+    if (! CFSetContainsValue(s_localizedLabels, self)
+            && ! [[HLSLabelLocalizationInfo localizationInfoWithText:text] isLocalized]) {
+        (*s_UILabel__setText_Imp)(self, @selector(setText:), text);
+        return;
+    }
+    
     HLSLabelLocalizationInfo *localizationInfo = [self localizationInfo];
     if (! localizationInfo) {
-        localizationInfo = [[[HLSLabelLocalizationInfo alloc] initWithText:text] autorelease];
+        localizationInfo = [HLSLabelLocalizationInfo localizationInfoWithText:text];
         [self setLocalizationInfo:localizationInfo];
         
-        // For labels localized with prefixes only: Listen to localization change notifications
+        // For labels localized with prefixes only: Update when the localization changes
         if ([localizationInfo isLocalized]) {
-            [[NSNotificationCenter defaultCenter] addObserver:self 
-                                                     selector:@selector(currentLocalizationDidChange:) 
-                                                         name:HLSCurrentLocalizationDidChangeNotification 
-                                                       object:nil];
+            CFSetAddValue(s_localizedLabels, self);
         }
     }
     
     // Prevent the call to -[UIButton setTitle:forState:] in localizeTextWithLocalizationInfo: from ending
-    // up in an infinite recursion
-    if (localizationInfo.locked) {
+    // up in an infinite recursion. The lock is attached to the label since localization information objects
+    // are shared
+    if (objc_getAssociatedObject(self, s_localizationLockedKey)) {
         (*s_UILabel__setText_Imp)(self, @selector(setText:), text);
-        localizationInfo.locked = NO;
+        objc_setAssociatedObject(self, s_localizationLockedKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
         return;
     }
     
@@ -191,14 +222,20 @@ static void swizzled_UILabel__setBackgroundColor_Imp(UILabel *self, SEL _cmd, UI
 {
     NSString *localizedText = [localizationInfo localizedText];
     
-    // Restore the original background color if it had been altered
-    UIColor *originalBackgroundColor = objc_getAssociatedObject(self, s_originalBackgroundColorKey);
-    (*s_UILabel__setBackgroundColor_Imp)(self, @selector(setBackgroundColor:), originalBackgroundColor);
+    // Restore the original background color if it had been altered. Not stored yet if the label has just been localized,
+    // in which case the current color is the original one
+    id originalBackgroundColor = objc_getAssociatedObject(self, s_originalBackgroundColorKey);
+    if (! originalBackgroundColor) {
+        originalBackgroundColor = self.backgroundColor ? (id)self.backgroundColor : (id)[NSNull null];
+        objc_setAssociatedObject(self, s_originalBackgroundColorKey, originalBackgroundColor, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+    (*s_UILabel__setBackgroundColor_Imp)(self, @selector(setBackgroundColor:),
+                                          [originalBackgroundColor isKindOfClass:[NSNull class]] ? nil : originalBackgroundColor);
     
     // Button label
     if ([[self superview] isKindOfClass:[UIButton class]]) {
         UIButton *button = (UIButton *)[self superview];
-        localizationInfo.locked = YES;
+        objc_setAssociatedObject(self, s_localizationLockedKey, [NSNumber numberWithBool:YES], OBJC_ASSOCIATION_RETAIN_NONATOMIC);
         
         // We must call setTitle:forState: on the button to get proper reszing behavior
         [button setTitle:localizedText forState:button.state];
@@ -218,23 +255,39 @@ static void swizzled_UILabel__setBackgroundColor_Imp(UILabel *self, SEL _cmd, UI
     }
 }
 
-#pragma mark Notification callbacks
-
-- (void)currentLocalizationDidChange:(NSNotification *)notification
+- (void)relocalizeText
 {
+    CFSetRemoveValue(s_staleLocalizedLabels, self);
+    
     HLSLabelLocalizationInfo *localizationInfo = [self localizationInfo];
     if ([localizationInfo isLocalized]) {
         [self localizeTextWithLocalizationInfo:localizationInfo];
     }
 }
 
+#pragma mark Notification callbacks
+
++ (void)currentLocalizationDidChange:(NSNotification *)notification
+{
+    // Only update labels which are displayed. The others are updated when added to a window again. Labels are retained
+    // by the array while they are updated
+    NSArray *localizedLabels = [(NSSet *)s_localizedLabels allObjects];
+    for (UILabel *label in localizedLabels) {
+        if (label.window) {
+            [label relocalizeText];
+        }
+        else {
+            CFSetAddValue(s_staleLocalizedLabels, label);
+        }
+    }
+}
+
 @end
 
 static void swizzled_UILabel__dealloc_Imp(UILabel *self, SEL _cmd)
 {
-    [[NSNotificationCenter defaultCenter] removeObserver:self 
-                                                    name:HLSCurrentLocalizationDidChangeNotification 
-                                                  object:nil];
+    CFSetRemoveValue(s_localizedLabels, self);
+    CFSetRemoveValue(s_staleLocalizedLabels, self);
     
     (*s_UILabel__dealloc_Imp)(self, _cmd);
 }
@@ -256,8 +309,25 @@ static void swizzled_UILabel__setBackgroundColor_Imp(UILabel *self, SEL _cmd, UI
 {
     (*s_UILabel__setBackgroundColor_Imp)(self, _cmd, backgroundColor);
     
+    // Only needed for localized labels, whose background color might be altered to reveal missing localizations. For
+    // other labels, the color is stored when they get localized (see -localizeTextWithLocalizationInfo:)
+    if (! CFSetContainsValue(s_localizedLabels, self)) {
+        return;
+    }
+    
     // The background color is stored as separate associated object, not in the HLSLabelLocalizationInfo object. The reason
     // is that the HLSLabelLocalizationInfo is only attached when the text is first set, while the background color is
-    // usually set earlier (i.e. when this object is not available)
-    objc_setAssociatedObject(self, s_originalBackgroundColorKey, backgroundColor, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    // usually set earlier (i.e. when this object is not available). nil is stored as NSNull
+    objc_setAssociatedObject(self, s_originalBackgroundColorKey, backgroundColor ? (id)backgroundColor : (id)[NSNull null],
+                             OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+static void swizzled_UILabel__didMoveToWindow_Imp(UILabel *self, SEL _cmd)
+{
+    (*s_UILabel__didMoveToWindow_Imp)(self, _cmd);
+    
+    // Labels whose localization changed while they were not displayed
+    if (self.window && CFSetContainsValue(s_staleLocalizedLabels, self)) {
+        [self relocalizeText];
+    }
 }
@@ -6,6 +6,27 @@
 //  Copyright (c) 2012 Hortis. All rights reserved.
 //
 
+/**
+ * Ways of applying the content offset of a master scroll view to the scroll views synchronized with it:
+ *   - HLSScrollViewSynchronizationModeImmediate: Synchronized scroll views are scrolled from within the content offset
+ *     mutator of the master scroll view, each time it is called
+ *   - HLSScrollViewSynchronizationModeDisplayFrame: The content offset of the master scroll view is read at most once per
+ *     display frame, and synchronized scroll views are scrolled in a single transaction, without implicit animations
+ *   - HLSScrollViewSynchronizationModeDisplayFrameTransform: Same as HLSScrollViewSynchronizationModeDisplayFrame, but
+ *     the content of synchronized scroll views is moved using a sublayer transform, which does not trigger any layout.
+ *     Their content offset does not change, and content appearing while they seem to scroll is not loaded (e.g. table
+ *     view cells). This mode is therefore best suited for scroll views whose whole content is laid out at once (e.g.
+ *     parallax backgrounds)
+ */
+typedef enum {
+    HLSScrollViewSynchronizationModeEnumBegin = 0,
+    HLSScrollViewSynchronizationModeImmediate = HLSScrollViewSynchronizationModeEnumBegin,
+    HLSScrollViewSynchronizationModeDisplayFrame,
+    HLSScrollViewSynchronizationModeDisplayFrameTransform,
+    HLSScrollViewSynchronizationModeEnumEnd,
+    HLSScrollViewSynchronizationModeEnumSize = HLSScrollViewSynchronizationModeEnumEnd - HLSScrollViewSynchronizationModeEnumBegin
+} HLSScrollViewSynchronizationMode;
+
 @interface UIScrollView (HLSExtensions)
 
 /**
@@ -28,9 +49,18 @@
  *
  * This method only synchronizes scrolling between scroll views. You still have to align them properly
  * and to set their respective content sizes to get the result you want.
+ *
+ * Synchronized scroll views are scrolled immediately (HLSScrollViewSynchronizationModeImmediate)
  */
 - (void)synchronizeWithScrollViews:(NSArray *)scrollViews bounces:(BOOL)bounces;
 
+/**
+ * Same as -synchronizeWithScrollViews:bounces:, but specifying how synchronized scroll views are scrolled. Display
+ * frame modes avoid scrolling several scroll views (and laying them out) each time the master content offset changes,
+ * which is recommended for parallax effects involving many layers. Must be used from the main thread
+ */
+- (void)synchronizeWithScrollViews:(NSArray *)scrollViews bounces:(BOOL)bounces mode:(HLSScrollViewSynchronizationMode)mode;
+
 /**
  * Remove any previously existing synchronization set for the receiver
  */
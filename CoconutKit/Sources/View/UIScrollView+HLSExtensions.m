@@ -11,40 +11,107 @@
 #import "HLSAssert.h"
 #import "HLSFloat.h"
 #import "HLSLogger.h"
-#import "HLSRuntime.h"
+#import <libkern/OSAtomic.h>
 #import <objc/runtime.h>
 
 /**
  * There are at least three way to detect contentOffset changes of the master view:
  *   - use an internal delegate which transparently forwards events to the real scroll view delegate, and which
- *     performs synchronization in its scrollViewDidScroll: method implementation. This might break if 
+ *     performs synchronization in its scrollViewDidScroll: method implementation. This might break if
  *     UIScrollViewDelegate changes, though
  *   - use KVO on contentOffset. The problem is that the observeValue... method to implement could be overridden by
  *     existing subclasses of UIScrollView, or even by categories. This is clearly not robust enough
- *   - swizzling contentOffset mutators. This is the safest approach which has been retained here
+ *   - overriding contentOffset mutators. This is the safest approach which has been retained here
+ *
+ * Swizzling the mutator for all scroll views would incur an overhead on every content offset change of every scroll
+ * view (e.g. all table views while they scroll). Instead, master scroll views are given a dynamic subclass overriding
+ * the mutator (as HLSZeroingWeakRef does for -dealloc), so that other scroll views do not pay anything
  */
 
 // Associated object keys
-static void *s_synchronizedScrollViewsKey = &s_synchronizedScrollViewsKey;
-static void *s_parallaxBouncesKey = &s_parallaxBouncesKey;
+static void *s_synchronizationKey = &s_synchronizationKey;
 
-// Original implementation of the methods we swizzle
-static void (*s_UIScrollView__setContentOffset_Imp)(id, SEL, CGPoint) = NULL;
+// Synchronizations waiting for the next display frame, and the display link running while there are some. Only
+// accessed from the main thread
+static NSMutableArray *s_pendingSynchronizations = nil;
+static CADisplayLink *s_displayLink = nil;
 
-// Swizzled method implementations
-static void swizzled_UIScrollView__setContentOffset_Imp(UIScrollView *self, SEL _cmd, CGPoint contentOffset);
+// Lookup table of the dynamic subclasses created so far. Each subclass is stored for its superclass as well as for
+// itself, so that objects which have already been subclassed can be identified
+static CFMutableDictionaryRef s_classToSubclassMap = NULL;
+static OSSpinLock s_classToSubclassMapLock = OS_SPINLOCK_INIT;
 
-@interface UIScrollView (HLSExtensionsPrivate)
+// Function declarations
+static Class synchronizingSubclassForClass(Class class);
+static BOOL isSynchronizingSubclass(Class class);
+static Class synchronizingSubclassOfObject(id object);
 
-- (void)synchronizeScrolling;
+// Dynamic subclass method implementations
+static void subclass_setContentOffset(UIScrollView *self, SEL _cmd, CGPoint contentOffset);
+static void subclass_dealloc(UIScrollView *self, SEL _cmd);
+static Class subclass_class(id object, SEL _cmd);
+
+#pragma mark -
+#pragma mark HLSScrollViewSynchronization class interface
+
+/**
+ * The scroll views synchronized with a master scroll view. The ratios between their scrolling ranges and the one of
+ * the master scroll view are only calculated again when content or frame sizes change. In display frame modes, all
+ * synchronizations pending for a frame are applied from a display link, in a single transaction
+ *
+ * Designated initializer: -initWithMasterScrollView:scrollViews:bounces:mode:
+ */
+@interface HLSScrollViewSynchronization : NSObject {
+@private
+    UIScrollView *m_masterScrollView;       // Not retained, the master scroll view owns its synchronization
+    NSArray *m_scrollViews;
+    BOOL m_bounces;
+    HLSScrollViewSynchronizationMode m_mode;
+    BOOL m_pending;
+    BOOL m_sizesKnown;
+    CGSize m_masterContentSize;
+    CGSize m_masterFrameSize;
+    CGSize *m_contentSizes;                 // For each synchronized scroll view
+    CGSize *m_frameSizes;
+    CGPoint *m_ratios;
+}
+
+- (id)initWithMasterScrollView:(UIScrollView *)masterScrollView
+                   scrollViews:(NSArray *)scrollViews
+                       bounces:(BOOL)bounces
+                          mode:(HLSScrollViewSynchronizationMode)mode;
+
+/**
+ * Must be called when the content offset of the master scroll view changes. Synchronizes the scroll views immediately
+ * or at the next display frame, depending on the mode
+ */
+- (void)masterScrollViewDidScroll;
+
+/**
+ * Cancel pending synchronization and reset the transforms applied in HLSScrollViewSynchronizationModeDisplayFrameTransform
+ * mode. Must be called when the synchronization is removed from its master scroll view
+ */
+- (void)invalidate;
+
+- (void)synchronize;
+
++ (void)tick:(CADisplayLink *)displayLink;
 
 @end
 
+#pragma mark -
+#pragma mark UIScrollView (HLSExtensions) implementation
+
 @implementation UIScrollView (HLSExtensions)
 
 #pragma mark Synchronizing scroll views
 
 - (void)synchronizeWithScrollViews:(NSArray *)scrollViews bounces:(BOOL)bounces
+{
+    [self synchronizeWithScrollViews:scrollViews bounces:bounces mode:HLSScrollViewSynchronizationModeImmediate];
+}
+
+- (void)synchronizeWithScrollViews:(NSArray *)scrollViews bounces:(BOOL)bounces mode:(HLSScrollViewSynchronizationMode)mode
 {
     HLSAssertObjectsInEnumerationAreKindOfClass(scrollViews, UIScrollView);
     
@@ -58,88 +125,310 @@ static void swizzled_UIScrollView__setContentOffset_Imp(UIScrollView *self, SEL
         return;
     }
     
-    objc_setAssociatedObject(self, s_synchronizedScrollViewsKey, scrollViews, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
-    objc_setAssociatedObject(self, s_parallaxBouncesKey, [NSNumber numberWithBool:bounces], OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    if (mode < HLSScrollViewSynchronizationModeEnumBegin || mode >= HLSScrollViewSynchronizationModeEnumEnd) {
+        HLSLoggerError(@"Unknown synchronization mode");
+        return;
+    }
+    
+    [(HLSScrollViewSynchronization *)objc_getAssociatedObject(self, s_synchronizationKey) invalidate];
+    
+    HLSScrollViewSynchronization *synchronization = [[[HLSScrollViewSynchronization alloc] initWithMasterScrollView:self
+                                                                                                        scrollViews:scrollViews
+                                                                                                            bounces:bounces
+                                                                                                               mode:mode] autorelease];
+    objc_setAssociatedObject(self, s_synchronizationKey, synchronization, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    
+    if (! synchronizingSubclassOfObject(self)) {
+        object_setClass(self, synchronizingSubclassForClass(object_getClass(self)));
+    }
 }
 
 - (void)removeSynchronization
 {
-    objc_setAssociatedObject(self, s_synchronizedScrollViewsKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
-    objc_setAssociatedObject(self, s_parallaxBouncesKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    [(HLSScrollViewSynchronization *)objc_getAssociatedObject(self, s_synchronizationKey) invalidate];
+    objc_setAssociatedObject(self, s_synchronizationKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    
+    // Remove the dynamic subclass (if it has not been subclassed further, e.g. by KVO or HLSZeroingWeakRef. In such
+    // cases the overridden mutator merely finds that there is nothing to synchronize)
+    Class class = object_getClass(self);
+    if (isSynchronizingSubclass(class)) {
+        object_setClass(self, class_getSuperclass(class));
+    }
 }
 
 @end
 
-@implementation UIScrollView (HLSExtensionsPrivate)
+#pragma mark -
+#pragma mark HLSScrollViewSynchronization class implementation
+
+@implementation HLSScrollViewSynchronization
 
-#pragma mark Class methods
+#pragma mark Object creation and destruction
 
-+ (void)load
+- (id)initWithMasterScrollView:(UIScrollView *)masterScrollView
+                   scrollViews:(NSArray *)scrollViews
+                       bounces:(BOOL)bounces
+                          mode:(HLSScrollViewSynchronizationMode)mode
 {
-    s_UIScrollView__setContentOffset_Imp = (void (*)(id, SEL, CGPoint))HLSSwizzleSelector(self, 
-                                                                                          @selector(setContentOffset:), 
-                                                                                          (IMP)swizzled_UIScrollView__setContentOffset_Imp);
+    if ((self = [super init])) {
+        m_masterScrollView = masterScrollView;
+        m_scrollViews = [scrollViews retain];
+        m_bounces = bounces;
+        m_mode = mode;
+        
+        NSUInteger count = [scrollViews count];
+        m_contentSizes = calloc(count, sizeof(CGSize));
+        m_frameSizes = calloc(count, sizeof(CGSize));
+        m_ratios = calloc(count, sizeof(CGPoint));
+    }
+    return self;
 }
 
-#pragma mark Scrolling synchronization
+- (id)init
+{
+    HLSForbiddenInheritedMethod();
+    return nil;
+}
 
-- (void)synchronizeScrolling
+- (void)dealloc
 {
-    NSArray *synchronizedScrollViews = objc_getAssociatedObject(self, s_synchronizedScrollViewsKey);
-    if (! synchronizedScrollViews) {
+    free(m_contentSizes);
+    free(m_frameSizes);
+    free(m_ratios);
+    [m_scrollViews release];
+    
+    [super dealloc];
+}
+
+#pragma mark Synchronization
+
+- (void)masterScrollViewDidScroll
+{
+    if (m_mode == HLSScrollViewSynchronizationModeImmediate) {
+        [self synchronize];
         return;
     }
     
-    // Calculate the relative offset position (in [0; 1]) of the receiver
-    CGFloat relativeXPos = 0.f;
-    if (floatle(self.contentSize.width, CGRectGetWidth(self.frame))) {
-        relativeXPos = 0.f;
+    // The offset of the master scroll view is only read when the frame is displayed
+    if (m_pending) {
+        return;
     }
-    else {
-        relativeXPos = self.contentOffset.x / (self.contentSize.width - CGRectGetWidth(self.frame));
+    
+    if (! s_pendingSynchronizations) {
+        s_pendingSynchronizations = [[NSMutableArray alloc] init];
     }
+    [s_pendingSynchronizations addObject:self];
+    m_pending = YES;
     
-    CGFloat relativeYPos = 0.f;
-    if (floatle(self.contentSize.height, CGRectGetHeight(self.frame))) {
-        relativeYPos = 0.f;
+    // The display link retains its target, a class
+    if (! s_displayLink) {
+        s_displayLink = [[CADisplayLink displayLinkWithTarget:[HLSScrollViewSynchronization class] selector:@selector(tick:)] retain];
+        [s_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
     }
-    else {
-        relativeYPos = self.contentOffset.y / (self.contentSize.height - CGRectGetHeight(self.frame));
+}
+
+- (void)invalidate
+{
+    if (m_pending) {
+        m_pending = NO;
+        [s_pendingSynchronizations removeObjectIdenticalTo:self];
+    }
+    
+    if (m_mode == HLSScrollViewSynchronizationModeDisplayFrameTransform) {
+        for (UIScrollView *scrollView in m_scrollViews) {
+            scrollView.layer.sublayerTransform = CATransform3DIdentity;
+        }
+    }
+    
+    m_masterScrollView = nil;
+}
+
+- (void)synchronize
+{
+    UIScrollView *masterScrollView = m_masterScrollView;
+    if (! masterScrollView) {
+        return;
+    }
+    
+    CGSize masterContentSize = masterScrollView.contentSize;
+    CGSize masterFrameSize = masterScrollView.frame.size;
+    BOOL masterSizesChanged = ! m_sizesKnown
+        || ! CGSizeEqualToSize(masterContentSize, m_masterContentSize)
+        || ! CGSizeEqualToSize(masterFrameSize, m_masterFrameSize);
+    if (masterSizesChanged) {
+        m_masterContentSize = masterContentSize;
+        m_masterFrameSize = masterFrameSize;
+        m_sizesKnown = YES;
     }
     
+    // Scrolling ranges of the master scroll view (0 if it cannot scroll)
+    CGFloat masterXRange = floatle(masterContentSize.width, masterFrameSize.width) ? 0.f : masterContentSize.width - masterFrameSize.width;
+    CGFloat masterYRange = floatle(masterContentSize.height, masterFrameSize.height) ? 0.f : masterContentSize.height - masterFrameSize.height;
+    
     // If reaching the top or the bottom of the master scroll view, prevent the other scroll views from
     // scrolling further (if enabled)
-    BOOL bounces = [objc_getAssociatedObject(self, s_parallaxBouncesKey) boolValue];
-    if (! bounces) {
-        if (floatlt(relativeXPos, 0.f)) {
-            relativeXPos = 0.f;
-        }
-        else if (floatgt(relativeXPos, 1.f)) {
-            relativeXPos = 1.f;
+    CGPoint contentOffset = masterScrollView.contentOffset;
+    if (! m_bounces) {
+        contentOffset.x = MIN(MAX(contentOffset.x, 0.f), masterXRange);
+        contentOffset.y = MIN(MAX(contentOffset.y, 0.f), masterYRange);
+    }
+    
+    // Apply the same relative offset position to all scroll views to keep in sync
+    NSUInteger i = 0;
+    for (UIScrollView *scrollView in m_scrollViews) {
+        CGSize contentSize = scrollView.contentSize;
+        CGSize frameSize = scrollView.frame.size;
+        if (masterSizesChanged || ! CGSizeEqualToSize(contentSize, m_contentSizes[i]) || ! CGSizeEqualToSize(frameSize, m_frameSizes[i])) {
+            m_contentSizes[i] = contentSize;
+            m_frameSizes[i] = frameSize;
+            m_ratios[i] = CGPointMake(floateq(masterXRange, 0.f) ? 0.f : (contentSize.width - frameSize.width) / masterXRange,
+                                      floateq(masterYRange, 0.f) ? 0.f : (contentSize.height - frameSize.height) / masterYRange);
         }
         
-        if (floatlt(relativeYPos, 0.f)) {
-            relativeYPos = 0.f;
+        CGPoint scrollViewContentOffset = CGPointMake(contentOffset.x * m_ratios[i].x, contentOffset.y * m_ratios[i].y);
+        if (m_mode == HLSScrollViewSynchronizationModeDisplayFrameTransform) {
+            // Move the content without changing the bounds, which would trigger a layout
+            CGPoint currentContentOffset = scrollView.contentOffset;
+            scrollView.layer.sublayerTransform = CATransform3DMakeTranslation(currentContentOffset.x - scrollViewContentOffset.x,
+                                                                              currentContentOffset.y - scrollViewContentOffset.y,
+                                                                              0.f);
+        }
+        else {
+            scrollView.contentOffset = scrollViewContentOffset;
         }
-        else if (floatgt(relativeYPos, 1.f)) {
-            relativeYPos = 1.f;
-        }            
+        ++i;
+    }
+}
+
+#pragma mark Display link
+
++ (void)tick:(CADisplayLink *)displayLink
+{
+    // Keep the display link while scrolling, stop it after a frame without any change
+    if ([s_pendingSynchronizations count] == 0) {
+        [s_displayLink invalidate];
+        [s_displayLink release];
+        s_displayLink = nil;
+        return;
     }
     
-    // Apply the same relative offset position to all scroll views to keep in sync
-    for (UIScrollView *scrollView in synchronizedScrollViews) {
-        CGFloat xPos = relativeXPos * (scrollView.contentSize.width - CGRectGetWidth(scrollView.frame));
-        CGFloat yPos = relativeYPos * (scrollView.contentSize.height - CGRectGetHeight(scrollView.frame));
-        scrollView.contentOffset = CGPointMake(xPos, yPos);
+    // Apply everything in a single transaction, without implicit animations. Synchronized scroll views which are
+    // themselves master scroll views might add pending synchronizations, applied during the same frame
+    [CATransaction begin];
+    [CATransaction setDisableActions:YES];
+    while ([s_pendingSynchronizations count] != 0) {
+        HLSScrollViewSynchronization *synchronization = [[[s_pendingSynchronizations objectAtIndex:0] retain] autorelease];
+        [s_pendingSynchronizations removeObjectAtIndex:0];
+        synchronization->m_pending = NO;
+        [synchronization synchronize];
     }
+    [CATransaction commit];
 }
 
 @end
 
-#pragma mark Swizzled method implementations
+#pragma mark -
+#pragma mark Static functions
+
+static Class synchronizingSubclassForClass(Class class)
+{
+    static NSString * const kSubclassPrefix = @"HLSSynchronizedScrollView_";
+    
+    OSSpinLockLock(&s_classToSubclassMapLock);
+    
+    if (! s_classToSubclassMap) {
+        s_classToSubclassMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    }
+    
+    // The subclass name is only built when the subclass is created
+    Class subclass = (Class)CFDictionaryGetValue(s_classToSubclassMap, class);
+    if (! subclass) {
+        NSString *subclassName = [kSubclassPrefix stringByAppendingString:[NSString stringWithUTF8String:class_getName(class)]];
+        subclass = objc_allocateClassPair(class, [subclassName UTF8String], 0);
+        NSCAssert(subclass != Nil, @"Could not register subclass");
+        class_addMethod(subclass,
+                        @selector(setContentOffset:),
+                        (IMP)subclass_setContentOffset,
+                        method_getTypeEncoding(class_getInstanceMethod(class, @selector(setContentOffset:))));
+        class_addMethod(subclass,
+                        @selector(dealloc),
+                        (IMP)subclass_dealloc,
+                        method_getTypeEncoding(class_getInstanceMethod(class, @selector(dealloc))));
+        class_addMethod(subclass,
+                        @selector(class),
+                        (IMP)subclass_class,
+                        method_getTypeEncoding(class_getInstanceMethod(class, @selector(class))));
+        objc_registerClassPair(subclass);
+        
+        CFDictionarySetValue(s_classToSubclassMap, class, subclass);
+        CFDictionarySetValue(s_classToSubclassMap, subclass, subclass);
+    }
+    
+    OSSpinLockUnlock(&s_classToSubclassMapLock);
+    
+    return subclass;
+}
+
+static BOOL isSynchronizingSubclass(Class class)
+{
+    OSSpinLockLock(&s_classToSubclassMapLock);
+    BOOL isSubclass = s_classToSubclassMap && CFDictionaryGetValue(s_classToSubclassMap, class) == class;
+    OSSpinLockUnlock(&s_classToSubclassMapLock);
+    return isSubclass;
+}
+
+// Return the dynamic subclass in the class hierarchy of an object (which might have been subclassed further), Nil if none
+static Class synchronizingSubclassOfObject(id object)
+{
+    Class subclass = Nil;
+    
+    OSSpinLockLock(&s_classToSubclassMapLock);
+    if (s_classToSubclassMap) {
+        for (Class class = object_getClass(object); class; class = class_getSuperclass(class)) {
+            if (CFDictionaryGetValue(s_classToSubclassMap, class) == class) {
+                subclass = class;
+                break;
+            }
+        }
+    }
+    OSSpinLockUnlock(&s_classToSubclassMapLock);
+    
+    return subclass;
+}
+
+#pragma mark Dynamic subclass method implementations
+
+static void subclass_setContentOffset(UIScrollView *self, SEL _cmd, CGPoint contentOffset)
+{
+    // Locate the parent implementation from the dynamic subclass, which might have been subclassed further
+    Class superclass = class_getSuperclass(synchronizingSubclassOfObject(self));
+    void (*parent_setContentOffset_Imp)(id, SEL, CGPoint) = (void (*)(id, SEL, CGPoint))class_getMethodImplementation(superclass, _cmd);
+    (*parent_setContentOffset_Imp)(self, _cmd, contentOffset);
+    
+    HLSScrollViewSynchronization *synchronization = objc_getAssociatedObject(self, s_synchronizationKey);
+    [synchronization masterScrollViewDidScroll];
+}
+
+static void subclass_dealloc(UIScrollView *self, SEL _cmd)
+{
+    // If the dynamic subclass is the object class, remove it first, so that a dynamic subclass below it (e.g. the one
+    // of HLSZeroingWeakRef, which locates its parent implementation from the object class) finds the class it expects
+    [(HLSScrollViewSynchronization *)objc_getAssociatedObject(self, s_synchronizationKey) invalidate];
+    
+    Class subclass = synchronizingSubclassOfObject(self);
+    if (object_getClass(self) == subclass) {
+        object_setClass(self, class_getSuperclass(subclass));
+        [self dealloc];
+    }
+    else {
+        void (*parent_dealloc_Imp)(id, SEL) = (void (*)(id, SEL))class_getMethodImplementation(class_getSuperclass(subclass), _cmd);
+        (*parent_dealloc_Imp)(self, _cmd);
+    }
+}
 
-static void swizzled_UIScrollView__setContentOffset_Imp(UIScrollView *self, SEL _cmd, CGPoint contentOffset)
+static Class subclass_class(id object, SEL _cmd)
 {
-    (*s_UIScrollView__setContentOffset_Imp)(self, _cmd, contentOffset);
-    [self synchronizeScrolling];
+    // Lie about the dynamic subclass existence, as the KVO implementation does (the real class can still be seen
+    // using object_getClass)
+    return class_getSuperclass(synchronizingSubclassOfObject(object));
 }
@@ -37,7 +37,10 @@
 @interface UITextField (HLSValidation)
 
 /**
- * Bind the text field to a specific field of a managed object. A formatter and a validation delegate can be provided
+ * Bind the text field to a specific field of a managed object. A formatter and a validation delegate can be provided.
+ * If no formatter is provided, numeric and date fields are formatted with formatters shared among all bound text fields
+ * (decimal style for floating point and decimal numbers, no style for integers, medium date style and short time style
+ * for dates). To share custom formatters as well, obtain them from the shared HLSFormatterPool
  */
 - (void)bindToManagedObject:(NSManagedObject *)managedObject
                   fieldName:(NSString *)fieldName
@@ -92,6 +95,10 @@
 
 /**
  * Check all text fields in the receiver view hierarchy. Returns YES iff all of them are valid
+ *
+ * Bound text fields are registered when they are bound, so that only those are visited (the view hierarchy is not
+ * walked). The cost therefore does not depend on the number of views in the hierarchy. Text fields are checked in
+ * no specific order
  */
 - (BOOL)checkTextFields;
 
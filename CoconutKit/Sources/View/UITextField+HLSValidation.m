@@ -16,15 +16,24 @@
 // Associated object keys
 static void *s_validatorKey = &s_validatorKey;
 
+// The text fields currently bound (not retained), so that checking a view hierarchy does not require walking it
+static CFMutableSetRef s_boundTextFields = NULL;
+
 // Original implementation of the methods we swizzle
 static id<UITextFieldDelegate> (*s_UITextField__delegate_Imp)(id, SEL) = NULL;
 static void (*s_UITextField__setDelegate_Imp)(id, SEL, id) = NULL;
 void (*UITextField__setText_Imp)(id, SEL, id) = NULL;      // external linkage
+static void (*s_UITextField__dealloc_Imp)(id, SEL) = NULL;
 
 // Swizzled method implementations
 static id<UITextFieldDelegate> swizzled_UITextField__delegate_Imp(UITextField *self, SEL _cmd);
 static void swizzled_UITextField__setDelegate_Imp(UITextField *self, SEL _cmd, id<UITextFieldDelegate> delegate);
 static void swizzled_UITextField__setText_Imp(UITextField *self, SEL _cmd, NSString *text);
+static void swizzled_UITextField__dealloc_Imp(UITextField *self, SEL _cmd);
+
+// Swizzle the methods needed for text field bindings. Called when managed object validation is enabled. External
+// linkage, but not public
+void injectTextFieldValidation(void);
 
 // Extern declarations
 extern BOOL injectedManagedObjectValidation(void);
@@ -34,21 +43,6 @@ extern BOOL injectedManagedObjectValidation(void);
 
 @implementation UITextField (HLSValidation)
 
-#pragma mark Class methods
-
-+ (void)load
-{
-    s_UITextField__delegate_Imp = (id<UITextFieldDelegate> (*)(id, SEL))HLSSwizzleSelector(self,
-                                                                                           @selector(delegate), 
-                                                                                           (IMP)swizzled_UITextField__delegate_Imp);
-    s_UITextField__setDelegate_Imp = (void (*)(id, SEL, id))HLSSwizzleSelector(self, 
-                                                                               @selector(setDelegate:), 
-                                                                               (IMP)swizzled_UITextField__setDelegate_Imp);
-    UITextField__setText_Imp = (void (*)(id, SEL, id))HLSSwizzleSelector(self, 
-                                                                         @selector(setText:), 
-                                                                         (IMP)swizzled_UITextField__setText_Imp);
-}
-
 #pragma mark Binding to managed object fields
 
 - (void)bindToManagedObject:(NSManagedObject *)managedObject
@@ -79,6 +73,7 @@ extern BOOL injectedManagedObjectValidation(void);
     
     validator.delegate = (*s_UITextField__delegate_Imp)(self, @selector(delegate));
     objc_setAssociatedObject(self, s_validatorKey, validator, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    CFSetAddValue(s_boundTextFields, self);
     
     // Set the validator as text field delegate to catch events and perform validation. We need an intermediate object 
     // because trying to set self as delegate does not work for a UITextField (this conflicts with the text field
@@ -101,6 +96,7 @@ extern BOOL injectedManagedObjectValidation(void);
     
     // Remove the validator
     objc_setAssociatedObject(self, s_validatorKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);    
+    CFSetRemoveValue(s_boundTextFields, self);
 }
 
 #pragma mark Accessors and mutators
@@ -140,18 +136,17 @@ extern BOOL injectedManagedObjectValidation(void);
 {
     NSAssert(injectedManagedObjectValidation(), @"Managed object validation not injected. Call HLSEnableNSManagedObjectValidation first");
     
-    // Check self first (if bound to a validator)
+    // Only bound text fields need to be checked. Instead of walking the whole view hierarchy, find those which belong
+    // to it (the set is copied since validation delegates might bind or unbind text fields)
     BOOL valid = YES;
-    if ([self isKindOfClass:[UITextField class]]) {
-        HLSManagedTextFieldValidator *validator = objc_getAssociatedObject(self, s_validatorKey);
-        if (validator && ! [validator checkDisplayedValue]) {
-            valid = NO;
+    NSArray *boundTextFields = [(NSSet *)s_boundTextFields allObjects];
+    for (UITextField *textField in boundTextFields) {
+        if (textField != self && ! [textField isDescendantOfView:self]) {
+            continue;
         }
-    }
-    
-    // Check subviews recursively
-    for (UIView *subview in self.subviews) {
-        if (! [subview checkTextFields]) {
+        
+        HLSManagedTextFieldValidator *validator = objc_getAssociatedObject(textField, s_validatorKey);
+        if (validator && ! [validator checkDisplayedValue]) {
             valid = NO;
         }
     }
@@ -179,6 +174,22 @@ extern BOOL injectedManagedObjectValidation(void);
 
 @end
 
+#pragma mark -
+#pragma mark Injection
+
+void injectTextFieldValidation(void)
+{
+    s_boundTextFields = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+    
+    HLSSwizzlingEntry entries[] = {
+        { @selector(delegate), (IMP)swizzled_UITextField__delegate_Imp, (IMP *)&s_UITextField__delegate_Imp },
+        { @selector(setDelegate:), (IMP)swizzled_UITextField__setDelegate_Imp, (IMP *)&s_UITextField__setDelegate_Imp },
+        { @selector(setText:), (IMP)swizzled_UITextField__setText_Imp, (IMP *)&UITextField__setText_Imp },
+        { @selector(dealloc), (IMP)swizzled_UITextField__dealloc_Imp, (IMP *)&s_UITextField__dealloc_Imp }
+    };
+    HLSSwizzleSelectors([UITextField class], entries, sizeof(entries) / sizeof(HLSSwizzlingEntry), "UITextField+HLSValidation");
+}
+
 #pragma mark -
 #pragma mark Swizzled method implementations
 
@@ -217,3 +228,10 @@ static void swizzled_UITextField__setText_Imp(UITextField *self, SEL _cmd, NSStr
         (*UITextField__setText_Imp)(self, _cmd, text);
     }    
 }
+
+// Swizzled so that text fields deallocated while bound are removed from the registry
+static void swizzled_UITextField__dealloc_Imp(UITextField *self, SEL _cmd)
+{
+    CFSetRemoveValue(s_boundTextFields, self);
+    (*s_UITextField__dealloc_Imp)(self, _cmd);
+}
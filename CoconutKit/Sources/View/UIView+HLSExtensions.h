@@ -6,6 +6,8 @@
 //  Copyright 2011 Hortis. All rights reserved.
 //
 
+#import "CALayer+HLSExtensions.h"
+
 #define HLSViewAutoresizingAll UIViewAutoresizingFlexibleLeftMargin | UIViewAutoresizingFlexibleWidth |         \
     UIViewAutoresizingFlexibleRightMargin | UIViewAutoresizingFlexibleTopMargin |                               \
     UIViewAutoresizingFlexibleHeight | UIViewAutoresizingFlexibleBottomMargin
@@ -27,4 +29,12 @@
  */
 - (UIImage *)flattenedImage;
 
+/**
+ * Asynchronously take a snapshot of the view and all its subviews. See -[CALayer flattenedImageOfRect:scale:tileSize:completionBlock:]
+ */
+- (void)flattenedImageOfRect:(CGRect)rect
+                       scale:(CGFloat)scale
+                    tileSize:(CGSize)tileSize
+             completionBlock:(HLSLayerSnapshotCompletionBlock)completionBlock;
+
 @end
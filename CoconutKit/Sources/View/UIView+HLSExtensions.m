@@ -44,4 +44,12 @@ static void *s_userInfoKey = &s_userInfoKey;
     return [self.layer flattenedImage];
 }
 
+- (void)flattenedImageOfRect:(CGRect)rect
+                       scale:(CGFloat)scale
+                    tileSize:(CGSize)tileSize
+             completionBlock:(HLSLayerSnapshotCompletionBlock)completionBlock
+{
+    [self.layer flattenedImageOfRect:rect scale:scale tileSize:tileSize completionBlock:completionBlock];
+}
+
 @end
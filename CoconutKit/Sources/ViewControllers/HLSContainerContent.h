@@ -139,6 +139,18 @@
  */
 - (UIView *)viewIfLoaded;
 
+/**
+ * Return an estimate of the memory (in bytes) used by the view controller's view, 0 if the view is not loaded. This
+ * does not perform lazy view creation. Refer to -[CALayer estimatedMemoryCost] for more information
+ */
+- (NSUInteger)estimatedViewMemoryCost;
+
+/**
+ * Instantiate (if not already) the view controller's view and lay it out, without adding it to a stack view. This
+ * makes it possible to pay the cost of view creation in advance, before the view is actually needed
+ */
+- (void)preloadView;
+
 /**
  * Remove the view controller's view from its container view (if added to a container view)
  */
@@ -8,6 +8,7 @@
 
 #import "HLSContainerContent.h"
 
+#import "CALayer+HLSExtensions.h"
 #import "HLSAssert.h"
 #import "HLSAutorotationCompatibility.h"
 #import "HLSConverters.h"
@@ -18,6 +19,9 @@
 #import "UIView+HLSExtensions.h"
 #import "UIViewController+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
+
 // Keys for runtime container - view controller / view object association
 static void *s_containerContentKey = &s_containerContentKey;
 
@@ -251,8 +255,24 @@ static BOOL iOS4_UIViewController__isMovingFromParentViewController_Imp(UIViewCo
     return [self.viewController viewIfLoaded];
 }
 
+- (NSUInteger)estimatedViewMemoryCost
+{
+    return [[self viewIfLoaded].layer estimatedMemoryCost];
+}
+
 #pragma mark View management
 
+- (void)preloadView
+{
+    if (self.addedToContainerView) {
+        return;
+    }
+    
+    // This is where lazy loading of the view controller's view occurs if needed
+    UIView *viewControllerView = self.viewController.view;
+    [viewControllerView layoutIfNeeded];
+}
+
 - (void)addAsSubviewIntoContainerStackView:(HLSContainerStackView *)stackView
 {
     [self insertAsSubviewIntoContainerStackView:stackView atIndex:[stackView.contentViews count]];
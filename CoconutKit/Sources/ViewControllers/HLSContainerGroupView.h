@@ -23,6 +23,7 @@
 @private
     UIView *m_savedFrontContentView;
     UIView *m_savedBackContentView;
+    NSArray *m_rasterizedViews;
 }
 
 /**
@@ -55,4 +56,16 @@
  */
 @property (nonatomic, readonly, retain) UIView *backView;
 
+/**
+ * Rasterize the front and back views while they are animated, so that their hierarchies are not composited again
+ * for each frame. A view is only rasterized if its content is static, i.e. if no animation is running in its layer
+ * tree, if no scroll view it contains is being scrolled, and if it displays no video or OpenGL content. Return YES
+ * iff at least one view has been rasterized
+ *
+ * Rasterization lasts until -endRasterization is called, which restores live rendering. Calling -beginRasterization
+ * while rasterization is active does nothing
+ */
+- (BOOL)beginRasterization;
+- (void)endRasterization;
+
 @end
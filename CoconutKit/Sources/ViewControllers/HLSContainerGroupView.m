@@ -8,15 +8,23 @@
 
 #import "HLSContainerGroupView.h"
 
+#import <QuartzCore/QuartzCore.h>
 #import "HLSAssert.h"
 #import "HLSLogger.h"
 #import "NSArray+HLSExtensions.h"
 #import "UIView+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
+
+// Function declarations
+static BOOL isLayerStatic(CALayer *layer);
+
 @interface HLSContainerGroupView ()
 
 @property (nonatomic, retain) UIView *savedFrontContentView;
 @property (nonatomic, retain) UIView *savedBackContentView;
+@property (nonatomic, retain) NSArray *rasterizedViews;
 
 @end
 
@@ -60,6 +68,8 @@
 
 - (void)dealloc
 {
+    [self endRasterization];
+    
     self.savedFrontContentView = nil;
     self.savedBackContentView = nil;
 
@@ -72,6 +82,8 @@
 
 @synthesize savedBackContentView = m_savedBackContentView;
 
+@synthesize rasterizedViews = m_rasterizedViews;
+
 - (UIView *)frontContentView
 {
     return [self.frontView.subviews firstObject_hls];
@@ -119,4 +131,87 @@
     }    
 }
 
+#pragma mark Rasterization
+
+- (BOOL)beginRasterization
+{
+    if (self.rasterizedViews) {
+        return YES;
+    }
+    
+    NSMutableArray *rasterizedViews = [NSMutableArray array];
+    for (UIView *view in [NSArray arrayWithObjects:self.frontView, self.backView, nil]) {
+        if (view.layer.shouldRasterize || ! isLayerStatic(view.layer)) {
+            continue;
+        }
+        
+        view.layer.rasterizationScale = [UIScreen mainScreen].scale;
+        view.layer.shouldRasterize = YES;
+        [rasterizedViews addObject:view];
+    }
+    if ([rasterizedViews count] == 0) {
+        return NO;
+    }
+    
+    self.rasterizedViews = [NSArray arrayWithArray:rasterizedViews];
+    return YES;
+}
+
+- (void)endRasterization
+{
+    // The views might have been removed from the group view in the meantime, restore them anyway
+    for (UIView *view in self.rasterizedViews) {
+        view.layer.shouldRasterize = NO;
+        view.layer.rasterizationScale = 1.f;
+    }
+    self.rasterizedViews = nil;
+}
+
 @end
+
+#pragma mark -
+#pragma mark Static functions
+
+/**
+ * Return YES iff the content of a layer tree does not change by itself. Rasterizing content which changes would
+ * require the rasterized bitmap to be rendered again for each frame, which would be slower than not rasterizing
+ */
+static BOOL isLayerStatic(CALayer *layer)
+{
+    if ([[layer animationKeys] count] != 0) {
+        return NO;
+    }
+    
+    if ([layer isKindOfClass:[CAEAGLLayer class]]) {
+        return NO;
+    }
+    
+    static Class s_playerLayerClass = Nil;
+    static Class s_emitterLayerClass = Nil;
+    static dispatch_once_t s_onceToken;
+    dispatch_once(&s_onceToken, ^{
+        // Not linked by CoconutKit, respectively only available since iOS 5
+        s_playerLayerClass = NSClassFromString(@"AVPlayerLayer");
+        s_emitterLayerClass = NSClassFromString(@"CAEmitterLayer");
+    });
+    if ((s_playerLayerClass && [layer isKindOfClass:s_playerLayerClass])
+            || (s_emitterLayerClass && [layer isKindOfClass:s_emitterLayerClass])) {
+        return NO;
+    }
+    
+    // The layer delegate, if any, is the view it backs
+    id delegate = layer.delegate;
+    if ([delegate isKindOfClass:[UIScrollView class]]) {
+        UIScrollView *scrollView = (UIScrollView *)delegate;
+        if (scrollView.isDragging || scrollView.isDecelerating || scrollView.isTracking) {
+            return NO;
+        }
+    }
+    
+    for (CALayer *sublayer in layer.sublayers) {
+        if (! isLayerStatic(sublayer)) {
+            return NO;
+        }
+    }
+    return YES;
+}
@@ -9,8 +9,11 @@
 #import "HLSAnimation.h"
 #import "HLSAutorotation.h"
 #import "HLSTransition.h"
+#import "HLSViewMemoryCoordinator.h"
 
 // Forward declarations
+@class HLSContainerContent;
+@class HLSContainerGroupView;
 @protocol HLSContainerStackDelegate;
 
 // Standard capacities
@@ -115,17 +118,30 @@ extern const NSUInteger HLSContainerStackUnlimitedCapacity;
  *
  * Designated initializer: -initWithContainerViewController:capacity:removing:rootViewControllerFixed:
  */
-@interface HLSContainerStack : NSObject <HLSAnimationDelegate> {
+@interface HLSContainerStack : NSObject <HLSAnimationDelegate, HLSViewMemoryContainer> {
 @private
     UIViewController *m_containerViewController;               // The container view controller implemented using HLSContainerStack
     NSMutableArray *m_containerContents;                       // The contents loaded into the stack. The first element corresponds to the root view controller
     UIView *m_containerView;                                   // The view where the stack displays its contents
     NSUInteger m_capacity;                                     // The maximum number of top view controllers loaded / not removed at any time
+    NSUInteger m_memoryBudget;                                 // The estimated memory (in bytes) which loaded views should not exceed (0 if none)
     BOOL m_removing;                                           // If YES, view controllers over capacity are removed from the stack, otherwise their views are simply unloaded
     BOOL m_rootViewControllerFixed;                            // Is the root view controller fixed?
     BOOL m_animating;                                          // Set to YES when a transition animation is running
     BOOL m_rotating;
+    BOOL m_animatingSnapshots;                                 // Transitions animate snapshots of the views instead of the views themselves
+    NSArray *m_snapshottedViews;
+    NSArray *m_snapshotViews;
+    HLSAnimation *m_snapshotReplacementAnimation;
+    BOOL m_rasterizingViewsDuringTransitions;                  // Transitions rasterize the views they animate when their content is static
+    HLSContainerGroupView *m_rasterizedGroupView;
+    BOOL m_preloadingViews;                                    // Views revealed by the next pop are loaded when the run loop is idle
+    CFRunLoopObserverRef m_preloadingObserver;
+    HLSContainerContent *m_replacedContainerContent;           // Former top content to be removed once the new top one has been pushed
+    HLSAnimation *m_interactiveAnimation;                      // The pop animation driven by the interactive transition currently running (if any)
     HLSAutorotationMode m_autorotationMode;                    // How the container decides to behave when rotation occurs
+    NSUInteger m_supportedInterfaceOrientations;               // Cached result of -supportedInterfaceOrientations
+    NSUInteger m_supportedInterfaceOrientationsGeneration;     // Generation of the cached value (0 if none)
     id<HLSContainerStackDelegate> m_delegate;                  // The stack delegate, usually the custom container which is implemented
 }
 
@@ -134,6 +150,14 @@ extern const NSUInteger HLSContainerStackUnlimitedCapacity;
  */
 + (id)singleControllerContainerStackWithContainerViewController:(UIViewController *)containerViewController;
 
+/**
+ * The interface orientations supported by container stacks are cached. The cached values are discarded when the
+ * children of a stack, its capacity or its autorotation mode change, but not when the interface orientations supported
+ * by one of its children do. If a child view controller changes the value it returns from -supportedInterfaceOrientations,
+ * call this method so that all containers (nested ones included) compute their supported interface orientations again
+ */
++ (void)invalidateSupportedInterfaceOrientations;
+
 /**
  * Create a stack which will manage the children view controllers of a container view controller. The containerViewController
  * parameter is the container you want to implement (which must itself instantiate the HLSContainerStack objects it requires) 
@@ -176,6 +200,66 @@ extern const NSUInteger HLSContainerStackUnlimitedCapacity;
  */
 @property (nonatomic, assign) HLSAutorotationMode autorotationMode;
 
+/**
+ * If set to YES, animated push and pop transitions do not animate the views of the appearing and disappearing view
+ * controllers directly. Instead, both views are captured as images right before the animation begins, and those
+ * lightweight snapshots are animated instead. The real views are hidden during the animation, and brought back in
+ * their final state when the animation ends. This avoids layout and offscreen rendering costs during the animation,
+ * which can make a huge difference for transitions involving complex views (e.g. large table views). Changes made
+ * to the views while the transition is running are of course not visible until it ends
+ *
+ * The default value is NO
+ */
+@property (nonatomic, assign, getter=isAnimatingSnapshots) BOOL animatingSnapshots;
+
+/**
+ * If set to YES, the views of the appearing and disappearing view controllers are rasterized while push and pop
+ * transitions (interactive ones included) are running, so that their view hierarchies are not composited again for
+ * each frame. Unlike snapshots, the real views are still animated and updated, but changes made to them while the
+ * transition is running might not be visible until it ends. Views are only rasterized if their content is static
+ * when the transition begins (no running animation, no scroll view being scrolled, no video or OpenGL content),
+ * otherwise they are animated as usual.
+ * Live rendering is restored when the transition ends, is cancelled, or when the views are released. This setting 
+ * has no effect when animating snapshots
+ *
+ * The default value is NO
+ */
+@property (nonatomic, assign, getter=isRasterizingViewsDuringTransitions) BOOL rasterizingViewsDuringTransitions;
+
+/**
+ * The capacity only limits the number of views added to the container view hierarchy, and views removed from it are 
+ * not unloaded (except when removing view controllers over capacity). When the memory budget (in bytes) is set, the 
+ * stack estimates the memory used by the views of its view controllers (images and backing stores of their layers,
+ * see -[CALayer estimatedMemoryCost]) each time a push ends. If the total cost exceeds the budget, the views which 
+ * are not in the container view hierarchy are unloaded, starting with the deepest ones, until the total cost fits 
+ * into the budget. When a memory warning is received, all views which are not in the container view hierarchy are 
+ * unloaded, except if the view memory coordinator is enabled (see HLSViewMemoryCoordinator). Unloaded views are automatically reloaded before they become visible again (e.g. when popping view 
+ * controllers)
+ *
+ * Views in the container view hierarchy are never unloaded, even if they alone exceed the budget. The budget is
+ * therefore a soft limit
+ *
+ * The default value is 0 (no memory budget)
+ */
+@property (nonatomic, assign) NSUInteger memoryBudget;
+
+/**
+ * When popping a view controller, the view which enters the capacity range (if any) must be added to the container
+ * view hierarchy before the animation starts. If this view is not loaded, it gets loaded right before the pop
+ * animation, which can lead to a noticeable delay for complex views. If preloadingViews is set to YES, the stack
+ * loads and lays out this view when the run loop is idle (after push and pop transitions have ended, or after the 
+ * container has been displayed), so that the next pop can start immediately. Preloaded views count against the 
+ * memory budget (if any, see above)
+ *
+ * The default value is NO
+ */
+@property (nonatomic, assign, getter=isPreloadingViews) BOOL preloadingViews;
+
+/**
+ * Return YES iff an interactive pop transition has been begun and has not been finished or cancelled yet
+ */
+@property (nonatomic, readonly, assign, getter=isInteractiveTransitionRunning) BOOL interactiveTransitionRunning;
+
 /**
  * The stack delegate (usually the container view controller you are implementing)
  */
@@ -305,6 +389,74 @@ extern const NSUInteger HLSContainerStackUnlimitedCapacity;
  */
 - (void)removeViewController:(UIViewController *)viewController animated:(BOOL)animated;
 
+/**
+ * Replace the view controllers currently in the stack with the ones in the given array (from the bottommost to the 
+ * topmost one). Instead of going through all intermediate states, the stack computes the final state and gets there 
+ * with at most one transition animation for the top view controller:
+ *   - view controllers already in the stack keep their transition settings, and view controllers not in the array
+ *     are removed without animation (except the current top view controller, see below)
+ *   - new view controllers are inserted using the given transition class and duration (the reverse animation is
+ *     played when they are later popped). View controllers already in the stack which change their relative order
+ *     are considered to be new ones
+ *   - if the top view controller changes and the new one was not in the stack, it is pushed. If the current top 
+ *     view controller is not in the array anymore, it is removed once the push animation ends
+ *   - if the top view controller changes and the new one was already in the stack, the current top view controller
+ *     is popped
+ *
+ * If the array contains the same view controller several times, if a transition animation is running, or if the
+ * root view controller is fixed and is not the first view controller in the array, this method does nothing
+ */
+- (void)setViewControllers:(NSArray *)viewControllers
+       withTransitionClass:(Class)transitionClass
+                  duration:(NSTimeInterval)duration
+                  animated:(BOOL)animated;
+
+/**
+ * Begin popping the top view controller interactively, e.g. when the user starts a back swipe gesture. The reverse
+ * animation of the transition used to push the top view controller is created and started, but immediately paused.
+ * Use -updateInteractiveTransition: to move it in time as the gesture progresses, then end it by calling either
+ * -finishInteractiveTransitionWithVelocity: or -cancelInteractiveTransitionWithVelocity:. The animation is created
+ * once and only moved in time afterwards, even when the transition is finished or cancelled. Any HLSTransition can
+ * be used, though only its Core Animation-based steps can be moved in time smoothly
+ *
+ * The view controller events and the -containerStack:willPopViewController:revealViewController:animated: delegate
+ * event are sent when the interactive transition begins, exactly as for an animated pop. Unlike animated pops,
+ * interactive transitions do not lock the user interface (the gesture driving them must not be interrupted) and
+ * never animate snapshots (see animatingSnapshots)
+ *
+ * This method does nothing if the container is not displayed, if a transition animation is running, or if the
+ * top view controller cannot be popped
+ */
+- (void)beginInteractivePopTransition;
+
+/**
+ * Move the interactive pop transition to the specified completion (between 0 and 1, fixed if outside this range). 
+ * Does nothing if no interactive transition is running
+ */
+- (void)updateInteractiveTransition:(CGFloat)percentComplete;
+
+/**
+ * Complete the interactive pop transition, starting from the current completion and at the specified velocity (as
+ * a fraction of the transition per second, e.g. the gesture velocity divided by the distance corresponding to the 
+ * whole transition). The transition never ends slower than when played at normal speed. Once the animation ends, the
+ * top view controller is removed as for an animated pop
+ *
+ * Does nothing if no interactive transition is running
+ */
+- (void)finishInteractiveTransitionWithVelocity:(CGFloat)velocity;
+
+/**
+ * Abort the interactive pop transition, bringing the views back from the current completion to where they were 
+ * when the transition began, at the specified velocity (same definition as for -finishInteractiveTransitionWithVelocity:,
+ * the sign is ignored). The view controllers receive the appearance events reverting those received when the 
+ * transition began (the top view controller appears again, the view controller which was being revealed disappears
+ * again), and the top view controller stays in the stack. No pop delegate event is sent, the show and hide delegate
+ * events are sent instead
+ *
+ * Does nothing if no interactive transition is running
+ */
+- (void)cancelInteractiveTransitionWithVelocity:(CGFloat)velocity;
+
 /**
  * Release all view and view-related resources. On iOS 4 and 5, this also forwards the -viewWill/DidUnload messages 
  * to the corresponding view controllers
@@ -338,7 +490,8 @@ extern const NSUInteger HLSContainerStackUnlimitedCapacity;
 
 /**
  * Call this method from your container view controller -supportedInterfaceOrientations method, otherwise the behavior
- * is undefined
+ * is undefined. The value is cached (see +invalidateSupportedInterfaceOrientations), so that calling this method
+ * repeatedly is cheap
  */
 - (NSUInteger)supportedInterfaceOrientations;
 
@@ -13,34 +13,75 @@
 #import "HLSContainerStackView.h"
 #import "HLSFloat.h"
 #import "HLSLayerAnimationStep.h"
+#import "HLSLayerAnimationStep+Friend.h"
 #import "HLSLogger.h"
+#import "HLSTransition+Friend.h"
+#import "HLSViewMemoryCoordinator.h"
 #import "NSArray+HLSExtensions.h"
 #import "UIViewController+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
+
 // Constants
 const NSUInteger HLSContainerStackMinimalCapacity = 1;
 const NSUInteger HLSContainerStackDefaultCapacity = 2;
 const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
 
+// Reaching the end of an interactive transition animation would complete it. Scrubbing stops this much before
+static const NSTimeInterval kInteractiveTransitionEndMargin = 0.001;
+
+// Incremented each time the interface orientations supported by some container stack might have changed. Since a
+// change within a stack can affect the stacks of the containers it is nested into, all cached values are discarded
+static NSUInteger s_supportedInterfaceOrientationsGeneration = 1;
+
 @interface HLSContainerStack () <HLSContainerStackViewDelegate>
 
 @property (nonatomic, assign) UIViewController *containerViewController;
 @property (nonatomic, retain) NSMutableArray *containerContents;
 @property (nonatomic, assign) NSUInteger capacity;
+@property (nonatomic, retain) NSArray *snapshottedViews;
+@property (nonatomic, retain) NSArray *snapshotViews;
+@property (nonatomic, retain) HLSAnimation *snapshotReplacementAnimation;
+@property (nonatomic, retain) HLSContainerGroupView *rasterizedGroupView;
+@property (nonatomic, retain) HLSContainerContent *replacedContainerContent;
+@property (nonatomic, retain) HLSAnimation *interactiveAnimation;
 
 - (HLSContainerContent *)topContainerContent;
 - (HLSContainerContent *)secondTopContainerContent;
 
 - (HLSContainerContent *)containerContentAtDepth:(NSUInteger)depth;
 
+- (void)removeViewControllerAtIndex:(NSUInteger)index animated:(BOOL)animated interactive:(BOOL)interactive;
+- (float)interactiveTransitionRateForAnimation:(HLSAnimation *)animation velocity:(CGFloat)velocity;
+
 - (void)addViewForContainerContent:(HLSContainerContent *)containerContent
                          inserting:(BOOL)inserting
                           animated:(BOOL)animated;
 - (void)rotateContainerContent:(HLSContainerContent *)containerContent
        forInterfaceOrientation:(UIInterfaceOrientation)interfaceOrientation;
 
+- (HLSAnimation *)snapshotAnimationForContainerContent:(HLSContainerContent *)containerContent reverse:(BOOL)reverse;
+- (void)captureSnapshots;
+- (void)replaceSnapshots;
+
+- (void)beginRasterizationForContainerContent:(HLSContainerContent *)containerContent;
+- (void)endRasterization;
+
+- (void)unloadViewsOverMemoryBudget;
+
+- (void)schedulePreloading;
+- (void)cancelPreloading;
+- (void)preloadViews;
+
 @end
 
+static void HLSContainerStackPreloadingObserverCallback(CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info)
+{
+    HLSContainerStack *containerStack = (HLSContainerStack *)info;
+    [containerStack preloadViews];
+}
+
 @implementation HLSContainerStack
 
 #pragma mark Class methods
@@ -53,6 +94,16 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
                                           rootViewControllerFixed:NO] autorelease];
 }
 
++ (void)invalidateSupportedInterfaceOrientations
+{
+    ++s_supportedInterfaceOrientationsGeneration;
+    
+    // 0 is reserved for stacks which have not cached any value yet
+    if (s_supportedInterfaceOrientationsGeneration == 0) {
+        s_supportedInterfaceOrientationsGeneration = 1;
+    }
+}
+
 #pragma mark Object creation and destruction
 
 - (id)initWithContainerViewController:(UIViewController *)containerViewController 
@@ -73,6 +124,12 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
         m_removing = removing;
         m_rootViewControllerFixed = rootViewControllerFixed;
         m_autorotationMode = HLSAutorotationModeContainer;
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationDidReceiveMemoryWarning:)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+        [[HLSViewMemoryCoordinator sharedViewMemoryCoordinator] registerContainer:self];
     }
     return self;
 }
@@ -85,9 +142,22 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
 
 - (void)dealloc
 {
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UIApplicationDidReceiveMemoryWarningNotification
+                                                  object:nil];
+    [[HLSViewMemoryCoordinator sharedViewMemoryCoordinator] unregisterContainer:self];
+    
+    [self cancelPreloading];
+    [self endRasterization];
+    
     self.containerViewController = nil;
     self.containerContents = nil;
     self.containerView = nil;
+    self.snapshottedViews = nil;
+    self.snapshotViews = nil;
+    self.snapshotReplacementAnimation = nil;
+    self.replacedContainerContent = nil;
+    self.interactiveAnimation = nil;
     self.delegate = nil;
 
     [super dealloc];
@@ -146,10 +216,63 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
     }
     
     m_capacity = capacity;
+    
+    [HLSContainerStack invalidateSupportedInterfaceOrientations];
+}
+
+@synthesize memoryBudget = m_memoryBudget;
+
+- (void)setMemoryBudget:(NSUInteger)memoryBudget
+{
+    m_memoryBudget = memoryBudget;
+    
+    [self unloadViewsOverMemoryBudget];
 }
 
 @synthesize autorotationMode = m_autorotationMode;
 
+- (void)setAutorotationMode:(HLSAutorotationMode)autorotationMode
+{
+    m_autorotationMode = autorotationMode;
+    
+    [HLSContainerStack invalidateSupportedInterfaceOrientations];
+}
+
+@synthesize animatingSnapshots = m_animatingSnapshots;
+
+@synthesize snapshottedViews = m_snapshottedViews;
+
+@synthesize snapshotViews = m_snapshotViews;
+
+@synthesize snapshotReplacementAnimation = m_snapshotReplacementAnimation;
+
+@synthesize rasterizingViewsDuringTransitions = m_rasterizingViewsDuringTransitions;
+
+@synthesize rasterizedGroupView = m_rasterizedGroupView;
+
+@synthesize replacedContainerContent = m_replacedContainerContent;
+
+@synthesize preloadingViews = m_preloadingViews;
+
+- (void)setPreloadingViews:(BOOL)preloadingViews
+{
+    m_preloadingViews = preloadingViews;
+    
+    if (preloadingViews) {
+        [self schedulePreloading];
+    }
+    else {
+        [self cancelPreloading];
+    }
+}
+
+@synthesize interactiveAnimation = m_interactiveAnimation;
+
+- (BOOL)isInteractiveTransitionRunning
+{
+    return self.interactiveAnimation != nil;
+}
+
 @synthesize delegate = m_delegate;
 
 - (HLSContainerContent *)topContainerContent
@@ -279,6 +402,7 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
     NSUInteger i = [self.containerContents count] - firstRemovedIndex - 1;
     while (i > 0) {
         [self.containerContents removeObjectAtIndex:firstRemovedIndex];
+        [HLSContainerStack invalidateSupportedInterfaceOrientations];
         --i;
     }
     
@@ -335,6 +459,8 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
         return;
     }
     
+    HLSLoggerSpanBegin(span, "HLSContainerStack insert");
+    
     if ([self.containerViewController isViewDisplayed]) {
         // Notify the delegate before the view controller is actually installed on top of the stack and associated with the
         // container (see HLSContainerStackDelegate interface contract)
@@ -360,6 +486,7 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
     }
     
     [self.containerContents insertObject:containerContent atIndex:index];
+    [HLSContainerStack invalidateSupportedInterfaceOrientations];
 
     // If no transition occurs (pre-loading before the container view is displayed, or insertion not at the top while
     // displayed), we must call -didMoveToParentViewController: manually right after the containment relationship has
@@ -378,6 +505,8 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
             [self addViewForContainerContent:containerContent inserting:YES animated:animated];
         }
     }
+    
+    HLSLoggerSpanEnd(span);
 }
 
 - (void)insertViewController:(UIViewController *)viewController
@@ -416,6 +545,11 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
 }
 
 - (void)removeViewControllerAtIndex:(NSUInteger)index animated:(BOOL)animated
+{
+    [self removeViewControllerAtIndex:index animated:animated interactive:NO];
+}
+
+- (void)removeViewControllerAtIndex:(NSUInteger)index animated:(BOOL)animated interactive:(BOOL)interactive
 {
     if (index >= [self.containerContents count]) {
         HLSLoggerError(@"Invalid index %d. Expected in [0;%d]", index, [self.containerContents count] - 1);
@@ -433,6 +567,8 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
         return;
     }
     
+    HLSLoggerSpanBegin(span, "HLSContainerStack remove");
+    
     if ([self.containerViewController isViewDisplayed]) {
         // Notify the delegate
         if (index == [self.containerContents count] - 1) {
@@ -468,20 +604,44 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
             // we give them a tag which we can test in those callbacks
             //
             // Same remark as in -addViewForContainerContent:inserting:animated: regarding animations in nested containers
+            if (animated && self.animatingSnapshots && ! interactive) {
+                reverseAnimation = [self snapshotAnimationForContainerContent:containerContent reverse:YES];
+                reverseAnimation.delegate = self;
+            }
             reverseAnimation.tag = @"pop_animation";
-            reverseAnimation.lockingUI = YES;
-            [reverseAnimation playAnimated:animated];
+            
+            // The gesture driving an interactive transition must keep receiving touches. Layer animation steps are compiled
+            // so that moving the animation in time never requires replaying it
+            if (interactive) {
+                reverseAnimation.lockingUI = NO;
+                reverseAnimation.compilingLayerAnimationSteps = YES;
+                self.interactiveAnimation = reverseAnimation;
+                [reverseAnimation playAnimated:YES];
+                
+                // Animations with nothing to play end immediately
+                if (reverseAnimation.running) {
+                    [reverseAnimation pause];
+                }
+            }
+            else {
+                reverseAnimation.lockingUI = YES;
+                [reverseAnimation playAnimated:animated];
+            }
             
             // Check the animation callback implementations for what happens next
         }
         else {
             [reverseAnimation playAnimated:NO];
             [self.containerContents removeObject:containerContent];
+            [HLSContainerStack invalidateSupportedInterfaceOrientations];
         }        
     }
     else {
         [self.containerContents removeObjectAtIndex:index];
+        [HLSContainerStack invalidateSupportedInterfaceOrientations];
     }
+    
+    HLSLoggerSpanEnd(span);
 }
 
 - (void)removeViewController:(UIViewController *)viewController animated:(BOOL)animated
@@ -494,8 +654,221 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
     [self removeViewControllerAtIndex:index animated:animated];
 }
 
+- (void)setViewControllers:(NSArray *)viewControllers
+       withTransitionClass:(Class)transitionClass
+                  duration:(NSTimeInterval)duration
+                  animated:(BOOL)animated
+{
+    HLSAssertObjectsInEnumerationAreKindOfClass(viewControllers, UIViewController);
+    
+    if (m_animating) {
+        HLSLoggerWarn(@"Cannot set view controllers while a transition animation is running");
+        return;
+    }
+    
+    if ([[NSSet setWithArray:viewControllers] count] != [viewControllers count]) {
+        HLSLoggerError(@"A view controller cannot appear several times in a container");
+        return;
+    }
+    
+    if (m_rootViewControllerFixed && [self rootViewController] && [viewControllers firstObject_hls] != [self rootViewController]) {
+        HLSLoggerError(@"The root view controller is fixed and cannot be changed anymore once set or after the container "
+                       "has been displayed once");
+        return;
+    }
+    
+    // Find the view controllers which can stay where they are, i.e. those keeping their relative order
+    NSMutableArray *keptViewControllers = [NSMutableArray array];
+    NSUInteger lastKeptIndex = NSNotFound;
+    for (HLSContainerContent *containerContent in self.containerContents) {
+        NSUInteger index = [viewControllers indexOfObject:containerContent.viewController];
+        if (index == NSNotFound) {
+            continue;
+        }
+        
+        if (lastKeptIndex == NSNotFound || index > lastKeptIndex) {
+            [keptViewControllers addObject:containerContent.viewController];
+            lastKeptIndex = index;
+        }
+    }
+    
+    // If the top view controller must be removed, keep it until the very end so that the transition to the new top
+    // view controller can be animated
+    HLSContainerContent *topContainerContent = [self topContainerContent];
+    BOOL replacingTopViewController = (topContainerContent && ! [viewControllers containsObject:topContainerContent.viewController]);
+    
+    // Remove all other view controllers which cannot be kept (from the top so that indices of remaining view
+    // controllers are not altered). Only those in the capacity range have their views updated
+    for (NSUInteger i = [self.containerContents count]; i > 0; --i) {
+        HLSContainerContent *containerContent = [self.containerContents objectAtIndex:i - 1];
+        if ([keptViewControllers containsObject:containerContent.viewController]) {
+            continue;
+        }
+        
+        if (replacingTopViewController && containerContent == topContainerContent) {
+            continue;
+        }
+        
+        [self removeViewControllerAtIndex:i - 1 animated:NO];
+    }
+    
+    // Insert new view controllers (the top one excepted) without animation. Since the view controllers kept are sorted
+    // according to the array order, each one is inserted right above the last view controller before it
+    UIViewController *newTopViewController = [viewControllers lastObject];
+    BOOL pushingTopViewController = (newTopViewController && ! [keptViewControllers containsObject:newTopViewController]);
+    NSUInteger insertionIndex = 0;
+    for (UIViewController *viewController in viewControllers) {
+        if ([keptViewControllers containsObject:viewController]) {
+            insertionIndex = [[self viewControllers] indexOfObject:viewController] + 1;
+            continue;
+        }
+        
+        if (pushingTopViewController && viewController == newTopViewController) {
+            break;
+        }
+        
+        [self insertViewController:viewController
+                           atIndex:insertionIndex
+               withTransitionClass:transitionClass
+                          duration:duration
+                          animated:NO];
+        ++insertionIndex;
+    }
+    
+    // Single transition
+    if (pushingTopViewController) {
+        // The replaced top view controller is removed when the push ends (immediately if no transition is played)
+        if (replacingTopViewController) {
+            self.replacedContainerContent = topContainerContent;
+        }
+        
+        [self pushViewController:newTopViewController
+             withTransitionClass:transitionClass
+                        duration:duration
+                        animated:animated];
+        
+        if (self.replacedContainerContent && ! m_animating) {
+            NSUInteger index = [self.containerContents indexOfObject:self.replacedContainerContent];
+            self.replacedContainerContent = nil;
+            if (index != NSNotFound) {
+                [self removeViewControllerAtIndex:index animated:NO];
+            }
+        }
+    }
+    else if (replacingTopViewController) {
+        [self popViewControllerAnimated:animated];
+    }
+    
+    [self unloadViewsOverMemoryBudget];
+}
+
+#pragma mark Interactive transitions
+
+- (void)beginInteractivePopTransition
+{
+    if (! [self.containerViewController isViewDisplayed]) {
+        HLSLoggerWarn(@"Interactive transitions can only be begun when the container is displayed");
+        return;
+    }
+    
+    if ([self.containerContents count] == 0) {
+        HLSLoggerInfo(@"Nothing to pop: The view controller container is empty");
+        return;
+    }
+    
+    if (m_animating) {
+        HLSLoggerWarn(@"Cannot begin an interactive transition while a transition animation is running");
+        return;
+    }
+    
+    [self removeViewControllerAtIndex:[self.containerContents count] - 1 animated:YES interactive:YES];
+}
+
+- (void)updateInteractiveTransition:(CGFloat)percentComplete
+{
+    if (! self.interactiveAnimation) {
+        HLSLoggerDebug(@"No interactive transition is running");
+        return;
+    }
+    
+    NSTimeInterval duration = self.interactiveAnimation.duration;
+    NSTimeInterval time = MAX(MIN(percentComplete, 1.f), 0.f) * duration;
+    [self.interactiveAnimation seekToTime:MAX(MIN(time, duration - kInteractiveTransitionEndMargin), 0.)];
+}
+
+- (void)finishInteractiveTransitionWithVelocity:(CGFloat)velocity
+{
+    if (! self.interactiveAnimation) {
+        HLSLoggerDebug(@"No interactive transition is running");
+        return;
+    }
+    
+    // The pop animation simply resumes. Check the animation callback implementations for what happens next
+    HLSAnimation *animation = [[self.interactiveAnimation retain] autorelease];
+    self.interactiveAnimation = nil;
+    
+    animation.rate = [self interactiveTransitionRateForAnimation:animation velocity:velocity];
+    [animation resume];
+}
+
+- (void)cancelInteractiveTransitionWithVelocity:(CGFloat)velocity
+{
+    if (! self.interactiveAnimation) {
+        HLSLoggerDebug(@"No interactive transition is running");
+        return;
+    }
+    
+    HLSAnimation *animation = [[self.interactiveAnimation retain] autorelease];
+    self.interactiveAnimation = nil;
+    
+    HLSContainerContent *appearingContainerContent = [self topContainerContent];
+    HLSContainerContent *disappearingContainerContent = [self secondTopContainerContent];
+    
+    // Forward events reverting those sent when the transition began (same order as in -animationWillStart:animated:)
+    if (disappearingContainerContent && [self.delegate respondsToSelector:@selector(containerStack:willHideViewController:animated:)]) {
+        [self.delegate containerStack:self willHideViewController:disappearingContainerContent.viewController animated:YES];
+    }
+    [disappearingContainerContent viewWillDisappear:YES movingFromParentViewController:NO];
+    
+    if ([self.delegate respondsToSelector:@selector(containerStack:willShowViewController:animated:)]) {
+        [self.delegate containerStack:self willShowViewController:appearingContainerContent.viewController animated:YES];
+    }
+    [appearingContainerContent viewWillAppear:YES movingToParentViewController:NO];
+    
+    // The pop animation cannot be played backwards. Bring it to its end without any delegate event (the transition is
+    // still considered to be running), and play the push animation from the time mirroring the current one instead. 
+    // This is the same strategy as the one used by HLSAnimation when seeking
+    NSTimeInterval startTime = animation.duration - animation.currentTime;
+    float rate = [self interactiveTransitionRateForAnimation:animation velocity:velocity];
+    [animation cancel];
+    
+    HLSContainerGroupView *groupView = [[self containerStackView] groupViewForContentView:[appearingContainerContent viewIfLoaded]];
+    HLSAnimation *cancelAnimation = [appearingContainerContent.transitionClass animationWithAppearingView:groupView.frontView
+                                                                                         disappearingView:groupView.backView
+                                                                                                   inView:groupView
+                                                                                                 duration:appearingContainerContent.duration];
+    cancelAnimation.delegate = self;
+    cancelAnimation.tag = @"cancel_pop_animation";
+    cancelAnimation.lockingUI = YES;
+    cancelAnimation.compilingLayerAnimationSteps = YES;
+    cancelAnimation.rate = rate;
+    [cancelAnimation playWithStartTime:startTime];
+    
+    // Check the animation callback implementations for what happens next
+}
+
+- (float)interactiveTransitionRateForAnimation:(HLSAnimation *)animation velocity:(CGFloat)velocity
+{
+    // A velocity of v (fraction of the transition per second) requires the animation to be played v * duration times 
+    // faster than normal
+    return MAX(fabsf(velocity) * animation.duration, 1.f);
+}
+
 - (void)releaseViews
 {
+    [self cancelPreloading];
+    [self endRasterization];
+    
     for (HLSContainerContent *containerContent in self.containerContents) {
         [containerContent releaseViews];
     }
@@ -545,6 +918,8 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
     if (topContainerContent && [self.delegate respondsToSelector:@selector(containerStack:didShowViewController:animated:)]) {
         [self.delegate containerStack:self didShowViewController:topContainerContent.viewController animated:animated];
     }
+    
+    [self schedulePreloading];
 }
 
 - (void)viewWillDisappear:(BOOL)animated
@@ -617,6 +992,10 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
 
 - (NSUInteger)supportedInterfaceOrientations
 {
+    if (m_supportedInterfaceOrientationsGeneration == s_supportedInterfaceOrientationsGeneration) {
+        return m_supportedInterfaceOrientations;
+    }
+    
     NSUInteger supportedInterfaceOrientations = UIInterfaceOrientationMaskAll;
     switch (self.autorotationMode) {
         case HLSAutorotationModeContainerAndAllChildren: {
@@ -649,6 +1028,9 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
         }
     }
     
+    m_supportedInterfaceOrientations = supportedInterfaceOrientations;
+    m_supportedInterfaceOrientationsGeneration = s_supportedInterfaceOrientationsGeneration;
+    
     return supportedInterfaceOrientations;
 }
 
@@ -903,6 +1285,10 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
     if (inserting && index == [self.containerContents count] - 1) {
         // Some more work has to be done for push animations in the animation begin / end callbacks. To identify such animations,
         // we give them a tag which we can test in those callbacks
+        if (animated && self.animatingSnapshots) {
+            animation = [self snapshotAnimationForContainerContent:containerContent reverse:NO];
+            animation.delegate = self;
+        }
         animation.tag = @"push_animation";
         animation.lockingUI = YES;
         [animation playAnimated:animated];
@@ -1003,6 +1389,233 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
     }
 }
 
+#pragma mark Snapshot transitions
+
+/**
+ * Create the transition animation for a container content, applied to snapshots of the views involved. Snapshots are
+ * only created, their image is captured when calling -captureSnapshots. The animation to be played non-animated on 
+ * the real views after the snapshot animation is over is prepared as well
+ */
+- (HLSAnimation *)snapshotAnimationForContainerContent:(HLSContainerContent *)containerContent reverse:(BOOL)reverse
+{
+    HLSContainerGroupView *groupView = [[self containerStackView] groupViewForContentView:[containerContent viewIfLoaded]];
+    
+    NSMutableArray *snapshottedViews = [NSMutableArray array];
+    NSMutableArray *snapshotViews = [NSMutableArray array];
+    UIView *frontSnapshotView = nil;
+    UIView *backSnapshotView = nil;
+    for (UIView *view in [NSArray arrayWithObjects:groupView.frontView, groupView.backView, nil]) {
+        // Snapshots must start from the same state as the views they replace
+        UIImageView *snapshotView = [[[UIImageView alloc] initWithFrame:CGRectZero] autorelease];
+        [HLSLayerAnimationStep copyAnimatedPropertiesOfLayer:view.layer toLayer:snapshotView.layer];
+        snapshotView.bounds = view.bounds;
+        snapshotView.layer.position = view.layer.position;
+        [groupView insertSubview:snapshotView aboveSubview:view];
+        
+        [snapshottedViews addObject:view];
+        [snapshotViews addObject:snapshotView];
+        
+        if (view == groupView.frontView) {
+            frontSnapshotView = snapshotView;
+        }
+        else {
+            backSnapshotView = snapshotView;
+        }
+    }
+    self.snapshottedViews = [NSArray arrayWithArray:snapshottedViews];
+    self.snapshotViews = [NSArray arrayWithArray:snapshotViews];
+    
+    // The group view itself is animated by the snapshot animation. Do not animate it twice
+    if (reverse) {
+        self.snapshotReplacementAnimation = [containerContent.transitionClass reverseAnimationWithAppearingView:groupView.backView
+                                                                                               disappearingView:groupView.frontView
+                                                                                                         inView:groupView
+                                                                                                       duration:containerContent.duration
+                                                                                                  animatingView:NO];
+        return [containerContent.transitionClass reverseAnimationWithAppearingView:backSnapshotView
+                                                                  disappearingView:frontSnapshotView
+                                                                            inView:groupView
+                                                                          duration:containerContent.duration];
+    }
+    else {
+        self.snapshotReplacementAnimation = [containerContent.transitionClass animationWithAppearingView:groupView.frontView
+                                                                                        disappearingView:groupView.backView
+                                                                                                  inView:groupView
+                                                                                                duration:containerContent.duration
+                                                                                           animatingView:NO];
+        return [containerContent.transitionClass animationWithAppearingView:frontSnapshotView
+                                                           disappearingView:backSnapshotView
+                                                                     inView:groupView
+                                                                   duration:containerContent.duration];
+    }
+}
+
+/**
+ * Capture the images of the views to be replaced by snapshots, and hide them. Called when the transition animation
+ * begins, i.e. after the view controllers have received their -viewWillAppear: and -viewWillDisappear: events
+ */
+- (void)captureSnapshots
+{
+    NSUInteger numberOfSnapshots = [self.snapshotViews count];
+    for (NSUInteger i = 0; i < numberOfSnapshots; ++i) {
+        UIView *view = [self.snapshottedViews objectAtIndex:i];
+        UIImageView *snapshotView = [self.snapshotViews objectAtIndex:i];
+        
+        [view layoutIfNeeded];
+
+        // Cannot use -flattenedImage, which bakes the view transform into the image. Render the view in its own coordinate
+        // system, with its transform and opacity ignored (both have been applied to the snapshot view)
+        UIGraphicsBeginImageContextWithOptions(view.bounds.size, NO, 0.f /* use the device scale factor */);
+
+        [CATransaction begin];
+        [CATransaction setDisableActions:YES];
+
+        float opacity = view.layer.opacity;
+        view.layer.opacity = 1.f;
+        [view.layer renderInContext:UIGraphicsGetCurrentContext()];
+        view.layer.opacity = opacity;
+
+        [CATransaction commit];
+
+        snapshotView.image = UIGraphicsGetImageFromCurrentImageContext();
+        UIGraphicsEndImageContext();
+
+        view.hidden = YES;
+    }
+}
+
+/**
+ * Bring the real views back in their final state and get rid of their snapshots
+ */
+- (void)replaceSnapshots
+{
+    if (! self.snapshotReplacementAnimation) {
+        return;
+    }
+    
+    [self.snapshotReplacementAnimation playAnimated:NO];
+    self.snapshotReplacementAnimation = nil;
+    
+    for (UIView *view in self.snapshottedViews) {
+        view.hidden = NO;
+    }
+    self.snapshottedViews = nil;
+    
+    for (UIView *snapshotView in self.snapshotViews) {
+        [snapshotView removeFromSuperview];
+    }
+    self.snapshotViews = nil;
+}
+
+#pragma mark Rasterization
+
+- (void)beginRasterizationForContainerContent:(HLSContainerContent *)containerContent
+{
+    [self endRasterization];
+    
+    HLSContainerGroupView *groupView = [[self containerStackView] groupViewForContentView:[containerContent viewIfLoaded]];
+    if (! [groupView beginRasterization]) {
+        HLSLoggerDebug(@"The views of %@ are not static and will not be rasterized", containerContent.viewController);
+        return;
+    }
+    
+    self.rasterizedGroupView = groupView;
+}
+
+- (void)endRasterization
+{
+    [self.rasterizedGroupView endRasterization];
+    self.rasterizedGroupView = nil;
+}
+
+#pragma mark Memory budget
+
+- (void)unloadViewsOverMemoryBudget
+{
+    // Views must not disappear while a transition is running. The budget will be checked again when it ends
+    if (self.memoryBudget == 0 || m_animating) {
+        return;
+    }
+    
+    NSMutableArray *memoryCosts = [NSMutableArray arrayWithCapacity:[self.containerContents count]];
+    NSUInteger totalMemoryCost = 0;
+    for (HLSContainerContent *containerContent in self.containerContents) {
+        NSUInteger memoryCost = [containerContent estimatedViewMemoryCost];
+        [memoryCosts addObject:[NSNumber numberWithUnsignedInteger:memoryCost]];
+        totalMemoryCost += memoryCost;
+    }
+    
+    // Unload the deepest views first. Views displayed in the container view hierarchy must be kept
+    NSUInteger index = 0;
+    for (HLSContainerContent *containerContent in self.containerContents) {
+        if (totalMemoryCost <= self.memoryBudget) {
+            break;
+        }
+        
+        NSUInteger memoryCost = [[memoryCosts objectAtIndex:index] unsignedIntegerValue];
+        ++index;
+        
+        if (containerContent.addedToContainerView || memoryCost == 0) {
+            continue;
+        }
+        
+        HLSLoggerDebug(@"Memory budget exceeded; unloading the view of %@ (%u bytes)", containerContent.viewController, memoryCost);
+        [containerContent releaseViews];
+        totalMemoryCost -= memoryCost;
+    }
+}
+
+#pragma mark Preloading views
+
+- (void)schedulePreloading
+{
+    if (! self.preloadingViews || m_preloadingObserver) {
+        return;
+    }
+    
+    // The observer is called once when the main run loop is about to sleep, i.e. when no more events need to be processed.
+    // Only the default mode is observed so that preloading does not occur during event tracking (e.g. scrolling)
+    CFRunLoopObserverContext context = { 0, self, NULL, NULL, NULL };
+    m_preloadingObserver = CFRunLoopObserverCreate(kCFAllocatorDefault, kCFRunLoopBeforeWaiting, false, 0,
+                                                   HLSContainerStackPreloadingObserverCallback, &context);
+    CFRunLoopAddObserver(CFRunLoopGetMain(), m_preloadingObserver, kCFRunLoopDefaultMode);
+}
+
+- (void)cancelPreloading
+{
+    if (! m_preloadingObserver) {
+        return;
+    }
+    
+    CFRunLoopObserverInvalidate(m_preloadingObserver);
+    CFRelease(m_preloadingObserver);
+    m_preloadingObserver = NULL;
+}
+
+- (void)preloadViews
+{
+    [self cancelPreloading];
+    
+    // Preloading is scheduled again when the transition ends
+    if (m_animating) {
+        return;
+    }
+    
+    if (! [self.containerViewController isViewDisplayed]) {
+        return;
+    }
+    
+    // The view which would be added to the container view hierarchy by the next pop
+    HLSContainerContent *containerContentAtCapacity = [self containerContentAtDepth:self.capacity];
+    if (! containerContentAtCapacity || containerContentAtCapacity.addedToContainerView) {
+        return;
+    }
+    
+    [containerContentAtCapacity preloadView];
+    
+    [self unloadViewsOverMemoryBudget];
+}
+
 #pragma mark HLSAnimationDelegate protocol implementation
 
 - (void)animationWillStart:(HLSAnimation *)animation animated:(BOOL)animated
@@ -1034,6 +1647,13 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
             [self.delegate containerStack:self willShowViewController:appearingContainerContent.viewController animated:animated];
         }
         [appearingContainerContent viewWillAppear:animated movingToParentViewController:YES];
+        
+        [self captureSnapshots];
+        
+        // Both the appearing and disappearing views are in the group view of the top container content
+        if (self.rasterizingViewsDuringTransitions && ! self.snapshotViews) {
+            [self beginRasterizationForContainerContent:[self topContainerContent]];
+        }
     }
 }
 
@@ -1041,8 +1661,13 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
 {
     m_animating = NO;
     
+    // Whatever the animation (cancelled interactive pops end with a dedicated animation), restore live rendering
+    [self endRasterization];
+    
     // Extra work needed for push and pop animations
     if ([animation.tag isEqualToString:@"push_animation"] || [animation.tag isEqualToString:@"pop_animation"]) {
+        [self replaceSnapshots];
+        
         HLSContainerContent *appearingContainerContent = nil;
         HLSContainerContent *disappearingContainerContent = nil;
         
@@ -1081,6 +1706,7 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
             }
             else {
                 [self.containerContents removeObject:containerContentAtCapacity];
+                [HLSContainerStack invalidateSupportedInterfaceOrientations];
             }
             
             // iOS 5 and above only: -didMoveToParentViewController: must be called manually after the push transition has
@@ -1088,6 +1714,17 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
             // This method is always available, even on iOS 4 through method injection (see HLSContainerContent.m)
             [appearingViewController didMoveToParentViewController:self.containerViewController];
             
+            // Former top view controller replaced using -setViewControllers:withTransitionClass:duration:animated:
+            if (self.replacedContainerContent) {
+                NSUInteger index = [self.containerContents indexOfObject:self.replacedContainerContent];
+                self.replacedContainerContent = nil;
+                if (index != NSNotFound) {
+                    [self removeViewControllerAtIndex:index animated:NO];
+                }
+            }
+            
+            [self unloadViewsOverMemoryBudget];
+            
             // Notify the delegate
             if ([self.delegate respondsToSelector:@selector(containerStack:didPushViewController:coverViewController:animated:)]) {
                 [self.delegate containerStack:self
@@ -1098,6 +1735,7 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
         }
         else if ([animation.tag isEqualToString:@"pop_animation"]) {
             [self.containerContents removeObject:disappearingContainerContent];
+            [HLSContainerStack invalidateSupportedInterfaceOrientations];
             
             // Notify the delegate after the view controller has been removed from the stack and the parent-child containment relationship
             // has been broken (see HLSContainerStackDelegate interface contract)
@@ -1110,6 +1748,34 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
         }
     
         [disappearingViewController release];
+        
+        // Interactive transitions ending immediately
+        if (animation == self.interactiveAnimation) {
+            self.interactiveAnimation = nil;
+        }
+        
+        [self schedulePreloading];
+    }
+    // Cancelled interactive pop transition
+    else if ([animation.tag isEqualToString:@"cancel_pop_animation"]) {
+        HLSContainerContent *appearingContainerContent = [self topContainerContent];
+        HLSContainerContent *disappearingContainerContent = [self secondTopContainerContent];
+        
+        // Forward events (same order as for push and pop animations)
+        [disappearingContainerContent viewDidDisappear:animated movingFromParentViewController:NO];
+        if (disappearingContainerContent && [self.delegate respondsToSelector:@selector(containerStack:didHideViewController:animated:)]) {
+            [self.delegate containerStack:self didHideViewController:disappearingContainerContent.viewController animated:animated];
+        }
+        
+        [appearingContainerContent viewDidAppear:animated movingToParentViewController:NO];
+        if ([self.delegate respondsToSelector:@selector(containerStack:didShowViewController:animated:)]) {
+            [self.delegate containerStack:self didShowViewController:appearingContainerContent.viewController animated:animated];
+        }
+        
+        // The view loaded below for the pop does not match the capacity criterium anymore
+        [[self containerContentAtDepth:self.capacity] removeViewFromContainerStackView];
+        
+        [self schedulePreloading];
     }
 }
 
@@ -1171,6 +1837,55 @@ const NSUInteger HLSContainerStackUnlimitedCapacity = NSUIntegerMax;
     }
 }
 
+#pragma mark HLSViewMemoryContainer protocol implementation
+
+- (BOOL)canUnloadViewOfViewController:(UIViewController *)viewController
+{
+    // Views must not disappear while a transition is running
+    if (m_animating) {
+        return NO;
+    }
+    
+    for (HLSContainerContent *containerContent in self.containerContents) {
+        if (containerContent.viewController == viewController) {
+            return ! containerContent.addedToContainerView && [viewController isViewLoaded];
+        }
+    }
+    return NO;
+}
+
+- (void)unloadViewOfViewController:(UIViewController *)viewController
+{
+    for (HLSContainerContent *containerContent in self.containerContents) {
+        if (containerContent.viewController == viewController) {
+            [containerContent releaseViews];
+            return;
+        }
+    }
+}
+
+#pragma mark Notification callbacks
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification
+{
+    // Do not reload views which are about to be unloaded
+    [self cancelPreloading];
+    
+    // The coordinator decides which views are unloaded
+    if (self.memoryBudget == 0 || [HLSViewMemoryCoordinator sharedViewMemoryCoordinator].enabled) {
+        return;
+    }
+    
+    // Views are reloaded when needed. Views in the container view hierarchy are visible (or might be during a
+    // transition) and must be kept
+    for (HLSContainerContent *containerContent in self.containerContents) {
+        if (containerContent.addedToContainerView) {
+            continue;
+        }
+        [containerContent releaseViews];
+    }
+}
+
 #pragma mark Description
 
 - (NSString *)description
@@ -11,6 +11,9 @@
 #import "HLSLogger.h"
 #import "UIView+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
+
 @interface HLSContainerStackView ()
 
 @property (nonatomic, retain) NSMutableArray *groupViews;
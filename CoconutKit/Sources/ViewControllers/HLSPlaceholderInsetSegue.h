@@ -26,6 +26,8 @@ extern NSString * const HLSPlaceholderPreloadSegueIdentifierPrefix;
  * controller must be initially loaded. This index must be between 0 and 19, which allows preloading of 20 view 
  * controllers. This should be sufficient: Though a placeholder view controller can hold more than 20 view controllers,
  * this should never occur in practice
+ *
+ * The destination view controller can be prewarmed by the source view controller (see UIViewController+HLSSeguePrewarming.h)
  */
 @interface HLSPlaceholderInsetSegue : UIStoryboardSegue {
 @private
@@ -10,6 +10,10 @@
 
 #import "HLSLogger.h"
 #import "HLSPlaceholderViewController.h"
+#import "UIViewController+HLSSeguePrewarming.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
 
 NSString * const HLSPlaceholderPreloadSegueIdentifierPrefix = @"hls_preload_at_index_";
 
@@ -17,6 +21,12 @@ NSString * const HLSPlaceholderPreloadSegueIdentifierPrefix = @"hls_preload_at_i
 
 - (id)initWithIdentifier:(NSString *)identifier source:(UIViewController *)source destination:(UIViewController *)destination
 {
+    // Use the instance prewarmed by the source view controller, if any
+    UIViewController *prewarmedViewController = [source dequeuePrewarmedViewControllerForSegueWithIdentifier:identifier];
+    if (prewarmedViewController) {
+        destination = prewarmedViewController;
+    }
+    
     if ((self = [super initWithIdentifier:identifier source:source destination:destination])) {
         self.index = 0;
         self.transitionClass = [HLSTransitionNone class];
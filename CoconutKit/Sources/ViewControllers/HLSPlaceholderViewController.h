@@ -93,6 +93,11 @@
  * since this would make navigating between tabs slow. In such cases, it makes sense to keep strong references to
  * those view controllers elsewhere (most probably as additional ivars of your placeholder view controller subclass)
  *
+ * Alternatively, you can have the placeholder view controller keep recently removed inset view controllers alive for
+ * you by setting its insetViewControllerReuseCapacity property. Before creating a new inset view controller, simply
+ * ask the placeholder view controller whether a reusable one is available (see -dequeueReusableInsetViewController...
+ * methods). This is especially convenient for tab-like interfaces which switch between inset view controllers often
+ *
  * Designated initializer: -initWithNibName:bundle:
  */
 @interface HLSPlaceholderViewController : HLSViewController <HLSContainerStackDelegate> {
@@ -102,6 +107,8 @@
     HLSAutorotationMode m_autorotationMode;
     id<HLSPlaceholderViewControllerDelegate> m_delegate;
     BOOL m_loadedOnce;
+    NSMutableArray *m_reusableInsetViewControllers;         // Removed inset view controllers kept alive, most recently used last
+    NSUInteger m_insetViewControllerReuseCapacity;
 }
 
 /**
@@ -161,6 +168,29 @@
  */
 - (UIViewController *)insetViewControllerAtIndex:(NSUInteger)index;
 
+/**
+ * The maximum number of inset view controllers which the placeholder view controller keeps alive (and which therefore
+ * keep their views loaded) after they have been removed, so that they can be displayed again later without having to
+ * be created and loaded again. When the capacity is exceeded, the least recently used view controllers are released
+ * first. All reusable view controllers are released when a memory warning is received
+ *
+ * The default value is 0 (no reuse)
+ */
+@property (nonatomic, assign) NSUInteger insetViewControllerReuseCapacity;
+
+/**
+ * Return the most recently removed inset view controller with the given reuse identifier (see -[UIViewController 
+ * placeholderReuseIdentifier]), or nil if none is available. A returned view controller is not kept for reuse
+ * anymore and can be set as inset view controller again
+ */
+- (id)dequeueReusableInsetViewControllerWithIdentifier:(NSString *)reuseIdentifier;
+
+/**
+ * Same as -dequeueReusableInsetViewControllerWithIdentifier:, but returning a view controller with the given class
+ * (subclasses are not considered)
+ */
+- (id)dequeueReusableInsetViewControllerOfClass:(Class)viewControllerClass;
+
 /**
  * Set how the placeholder view controller decides whether it must rotate or not
  *
@@ -226,4 +256,12 @@
  */
 @property (nonatomic, readonly, assign) HLSPlaceholderViewController *placeholderViewController;
 
+/**
+ * An identifier with which a view controller can be retrieved when it is kept for reuse by a placeholder view
+ * controller (see -[HLSPlaceholderViewController dequeueReusableInsetViewControllerWithIdentifier:])
+ *
+ * The default value is nil
+ */
+@property (nonatomic, copy) NSString *placeholderReuseIdentifier;
+
 @end
@@ -11,14 +11,25 @@
 #import "HLSContainerContent.h"
 #import "HLSLogger.h"
 #import "HLSPlaceholderInsetSegue.h"
+#import "HLSRuntime.h"
 #import "NSArray+HLSExtensions.h"
 #import "UIViewController+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
+
+// Associated object keys
+static void *s_placeholderReuseIdentifierKey = &s_placeholderReuseIdentifierKey;
+
 @interface HLSPlaceholderViewController ()
 
 - (void)hlsPlaceholderViewControllerInit;
 
 @property (nonatomic, retain) NSMutableArray *containerStacks;
+@property (nonatomic, retain) NSMutableArray *reusableInsetViewControllers;
+
+- (void)enqueueReusableInsetViewController:(UIViewController *)viewController;
+- (id)dequeueReusableInsetViewControllerPassingTest:(BOOL (^)(UIViewController *viewController))predicate;
 
 @end
 
@@ -45,6 +56,7 @@
 - (void)hlsPlaceholderViewControllerInit
 {
     self.autorotationMode = HLSAutorotationModeContainer;
+    self.reusableInsetViewControllers = [NSMutableArray array];
 }
 
 - (void)awakeFromNib
@@ -68,6 +80,7 @@
 - (void)dealloc
 {
     self.containerStacks = nil;
+    self.reusableInsetViewControllers = nil;
     self.delegate = nil;
     
     [super dealloc];
@@ -101,6 +114,20 @@
     }
 }
 
+@synthesize reusableInsetViewControllers = m_reusableInsetViewControllers;
+
+@synthesize insetViewControllerReuseCapacity = m_insetViewControllerReuseCapacity;
+
+- (void)setInsetViewControllerReuseCapacity:(NSUInteger)insetViewControllerReuseCapacity
+{
+    m_insetViewControllerReuseCapacity = insetViewControllerReuseCapacity;
+    
+    // Release the least recently used view controllers first
+    while ([self.reusableInsetViewControllers count] > insetViewControllerReuseCapacity) {
+        [self.reusableInsetViewControllers removeObjectAtIndex:0];
+    }
+}
+
 @synthesize delegate = m_delegate;
 
 - (UIView *)placeholderViewAtIndex:(NSUInteger)index
@@ -121,6 +148,56 @@
     return [containerStack rootViewController];
 }
 
+#pragma mark Reusing inset view controllers
+
+- (id)dequeueReusableInsetViewControllerWithIdentifier:(NSString *)reuseIdentifier
+{
+    return [self dequeueReusableInsetViewControllerPassingTest:^(UIViewController *viewController) {
+        return [viewController.placeholderReuseIdentifier isEqualToString:reuseIdentifier];
+    }];
+}
+
+- (id)dequeueReusableInsetViewControllerOfClass:(Class)viewControllerClass
+{
+    return [self dequeueReusableInsetViewControllerPassingTest:^(UIViewController *viewController) {
+        return [viewController isMemberOfClass:viewControllerClass];
+    }];
+}
+
+- (id)dequeueReusableInsetViewControllerPassingTest:(BOOL (^)(UIViewController *viewController))predicate
+{
+    // Most recently used view controllers first
+    NSUInteger index = [self.reusableInsetViewControllers indexOfObjectWithOptions:NSEnumerationReverse
+                                                                       passingTest:^(id obj, NSUInteger idx, BOOL *stop) {
+                                                                           return predicate(obj);
+                                                                       }];
+    if (index == NSNotFound) {
+        return nil;
+    }
+    
+    UIViewController *viewController = [[[self.reusableInsetViewControllers objectAtIndex:index] retain] autorelease];
+    [self.reusableInsetViewControllers removeObjectAtIndex:index];
+    return viewController;
+}
+
+- (void)enqueueReusableInsetViewController:(UIViewController *)viewController
+{
+    if (self.insetViewControllerReuseCapacity == 0 || ! viewController) {
+        return;
+    }
+    
+    // A view controller which has been inserted into another container cannot be reused
+    if ([viewController containerViewControllerKindOfClass:Nil]) {
+        return;
+    }
+    
+    [self.reusableInsetViewControllers removeObject:viewController];
+    [self.reusableInsetViewControllers addObject:viewController];
+    if ([self.reusableInsetViewControllers count] > self.insetViewControllerReuseCapacity) {
+        [self.reusableInsetViewControllers removeObjectAtIndex:0];
+    }
+}
+
 #pragma mark View lifecycle
 
 // Deprecated since iOS 6
@@ -291,6 +368,15 @@
     }
 }
 
+#pragma mark Memory warnings
+
+- (void)didReceiveMemoryWarning
+{
+    [super didReceiveMemoryWarning];
+    
+    [self.reusableInsetViewControllers removeAllObjects];
+}
+
 #pragma mark Setting the inset view controller
 
 - (void)setInsetViewController:(UIViewController *)insetViewController 
@@ -358,7 +444,8 @@ willPushViewController:(UIViewController *)pushedViewController
    coverViewController:(UIViewController *)coveredViewController
               animated:(BOOL)animated
 {
-    // Not interesting in the present case
+    // A view controller kept for reuse is not reusable anymore once displayed again
+    [self.reusableInsetViewControllers removeObject:pushedViewController];
 }
 
 - (void)containerStack:(HLSContainerStack *)containerStack
@@ -386,7 +473,8 @@ willShowViewController:(UIViewController *)viewController
    coverViewController:(UIViewController *)coveredViewController
               animated:(BOOL)animated
 {
-    // Not interesting in the present case
+    // The covered view controller has been removed from the stack
+    [self enqueueReusableInsetViewController:coveredViewController];
 }
 
 - (void)containerStack:(HLSContainerStack *)containerStack
@@ -422,7 +510,7 @@ willHideViewController:(UIViewController *)viewController
   revealViewController:(UIViewController *)revealedViewController
               animated:(BOOL)animated
 {
-    // Not interesting in the present case
+    [self enqueueReusableInsetViewController:poppedViewController];
 }
 
 @end
@@ -434,4 +522,14 @@ willHideViewController:(UIViewController *)viewController
     return [self containerViewControllerKindOfClass:[HLSPlaceholderViewController class]];
 }
 
+- (NSString *)placeholderReuseIdentifier
+{
+    return objc_getAssociatedObject(self, s_placeholderReuseIdentifierKey);
+}
+
+- (void)setPlaceholderReuseIdentifier:(NSString *)placeholderReuseIdentifier
+{
+    objc_setAssociatedObject(self, s_placeholderReuseIdentifierKey, placeholderReuseIdentifier, OBJC_ASSOCIATION_COPY_NONATOMIC);
+}
+
 @end
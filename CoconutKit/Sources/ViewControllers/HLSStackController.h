@@ -74,6 +74,10 @@
     HLSContainerStack *m_containerStack;
     NSUInteger m_capacity;
     HLSAutorotationMode m_autorotationMode;
+    BOOL m_animatingSnapshots;
+    BOOL m_rasterizingViewsDuringTransitions;
+    NSUInteger m_memoryBudget;
+    BOOL m_preloadingViews;
     id<HLSStackControllerDelegate> m_delegate;
 }
 
@@ -106,6 +110,40 @@
  */
 @property (nonatomic, assign) HLSAutorotationMode autorotationMode;
 
+/**
+ * If set to YES, push and pop transitions animate snapshots of the view controller's views instead of the views
+ * themselves. Use this mode for view controllers with complex views. Refer to -[HLSContainerStack animatingSnapshots]
+ * for more information
+ *
+ * The default value is NO
+ */
+@property (nonatomic, assign, getter=isAnimatingSnapshots) BOOL animatingSnapshots;
+
+/**
+ * If set to YES, the view controller's views are rasterized during push and pop transitions if their content is static.
+ * Refer to -[HLSContainerStack rasterizingViewsDuringTransitions] for more information
+ *
+ * The default value is NO
+ */
+@property (nonatomic, assign, getter=isRasterizingViewsDuringTransitions) BOOL rasterizingViewsDuringTransitions;
+
+/**
+ * The estimated memory (in bytes) which the views of the view controllers in the stack should not exceed. Views not
+ * displayed are unloaded (deepest first) when the budget is exceeded or when a memory warning is received, and reloaded
+ * when needed. Refer to -[HLSContainerStack memoryBudget] for more information
+ *
+ * The default value is 0 (no memory budget)
+ */
+@property (nonatomic, assign) NSUInteger memoryBudget;
+
+/**
+ * If set to YES, the view revealed by the next pop is loaded in advance when the run loop is idle. Refer to
+ * -[HLSContainerStack preloadingViews] for more information
+ *
+ * The default value is NO
+ */
+@property (nonatomic, assign, getter=isPreloadingViews) BOOL preloadingViews;
+
 /**
  * The stack controller delegate
  */
@@ -239,6 +277,32 @@
  */
 - (void)removeViewController:(UIViewController *)viewController animated:(BOOL)animated;
 
+/**
+ * Replace the view controllers in the stack with the ones in the given array (from the root to the top view controller),
+ * playing at most one transition animation. Refer to -[HLSContainerStack setViewControllers:withTransitionClass:duration:animated:]
+ * for more information
+ *
+ * The first view controller in the array must be the root view controller, otherwise this method does nothing
+ */
+- (void)setViewControllers:(NSArray *)viewControllers
+       withTransitionClass:(Class)transitionClass
+                  duration:(NSTimeInterval)duration
+                  animated:(BOOL)animated;
+
+/**
+ * Pop the top view controller interactively, e.g. from a back swipe gesture recognizer action. Refer to the
+ * corresponding HLSContainerStack methods for more information. The root view controller cannot be popped
+ */
+- (void)beginInteractivePopTransition;
+- (void)updateInteractiveTransition:(CGFloat)percentComplete;
+- (void)finishInteractiveTransitionWithVelocity:(CGFloat)velocity;
+- (void)cancelInteractiveTransitionWithVelocity:(CGFloat)velocity;
+
+/**
+ * Return YES iff an interactive pop transition is running
+ */
+@property (nonatomic, readonly, assign, getter=isInteractiveTransitionRunning) BOOL interactiveTransitionRunning;
+
 @end
 
 /**
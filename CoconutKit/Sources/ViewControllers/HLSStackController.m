@@ -16,6 +16,9 @@
 #import "UIView+HLSExtensions.h"
 #import "UIViewController+HLSExtensions.h"
 
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
+
 @interface HLSStackController ()
 
 @property (nonatomic, retain) HLSContainerStack *containerStack;
@@ -37,6 +40,10 @@
                                                                                  removing:NO
                                                                   rootViewControllerFixed:YES] autorelease];
         self.containerStack.autorotationMode = self.autorotationMode;
+        self.containerStack.animatingSnapshots = self.animatingSnapshots;
+        self.containerStack.rasterizingViewsDuringTransitions = self.rasterizingViewsDuringTransitions;
+        self.containerStack.memoryBudget = self.memoryBudget;
+        self.containerStack.preloadingViews = self.preloadingViews;
         self.containerStack.delegate = self;
         [self.containerStack pushViewController:rootViewController 
                             withTransitionClass:[HLSTransitionNone class]
@@ -75,6 +82,10 @@
                                                                              removing:NO
                                                               rootViewControllerFixed:YES] autorelease];
     self.containerStack.autorotationMode = self.autorotationMode;
+    self.containerStack.animatingSnapshots = self.animatingSnapshots;
+    self.containerStack.rasterizingViewsDuringTransitions = self.rasterizingViewsDuringTransitions;
+    self.containerStack.memoryBudget = self.memoryBudget;
+    self.containerStack.preloadingViews = self.preloadingViews;
     
     // Load the root view controller when using segues. A reserved segue called 'hls_root' must be used for such purposes
     @try {
@@ -142,6 +153,46 @@
     self.containerStack.autorotationMode = autorotationMode;
 }
 
+@synthesize animatingSnapshots = m_animatingSnapshots;
+
+- (void)setAnimatingSnapshots:(BOOL)animatingSnapshots
+{
+    m_animatingSnapshots = animatingSnapshots;
+    
+    // Same remark as for -setAutorotationMode:
+    self.containerStack.animatingSnapshots = animatingSnapshots;
+}
+
+@synthesize rasterizingViewsDuringTransitions = m_rasterizingViewsDuringTransitions;
+
+- (void)setRasterizingViewsDuringTransitions:(BOOL)rasterizingViewsDuringTransitions
+{
+    m_rasterizingViewsDuringTransitions = rasterizingViewsDuringTransitions;
+    
+    // Same remark as for -setAutorotationMode:
+    self.containerStack.rasterizingViewsDuringTransitions = rasterizingViewsDuringTransitions;
+}
+
+@synthesize memoryBudget = m_memoryBudget;
+
+- (void)setMemoryBudget:(NSUInteger)memoryBudget
+{
+    m_memoryBudget = memoryBudget;
+    
+    // Same remark as for -setAutorotationMode:
+    self.containerStack.memoryBudget = memoryBudget;
+}
+
+@synthesize preloadingViews = m_preloadingViews;
+
+- (void)setPreloadingViews:(BOOL)preloadingViews
+{
+    m_preloadingViews = preloadingViews;
+    
+    // Same remark as for -setAutorotationMode:
+    self.containerStack.preloadingViews = preloadingViews;
+}
+
 @synthesize delegate = m_delegate;
 
 - (UIViewController *)rootViewController
@@ -356,6 +407,42 @@
     [self.containerStack removeViewController:viewController animated:animated];
 }
 
+- (void)setViewControllers:(NSArray *)viewControllers
+       withTransitionClass:(Class)transitionClass
+                  duration:(NSTimeInterval)duration
+                  animated:(BOOL)animated
+{
+    [self.containerStack setViewControllers:viewControllers
+                        withTransitionClass:transitionClass
+                                   duration:duration
+                                   animated:animated];
+}
+
+- (void)beginInteractivePopTransition
+{
+    [self.containerStack beginInteractivePopTransition];
+}
+
+- (void)updateInteractiveTransition:(CGFloat)percentComplete
+{
+    [self.containerStack updateInteractiveTransition:percentComplete];
+}
+
+- (void)finishInteractiveTransitionWithVelocity:(CGFloat)velocity
+{
+    [self.containerStack finishInteractiveTransitionWithVelocity:velocity];
+}
+
+- (void)cancelInteractiveTransitionWithVelocity:(CGFloat)velocity
+{
+    [self.containerStack cancelInteractiveTransitionWithVelocity:velocity];
+}
+
+- (BOOL)isInteractiveTransitionRunning
+{
+    return [self.containerStack isInteractiveTransitionRunning];
+}
+
 #pragma mark HLSContainerStackDelegate protocol implementation
 
 - (void)containerStack:(HLSContainerStack *)containerStack
@@ -21,6 +21,8 @@ extern NSString * const HLSStackRootSegueIdentifier;
  * Each HLSStackController dropped onto a storyboard must be connected to its root view controller using
  * a segue with the identifier 'hls_root'. To push a view controller B onto another one A already in the 
  * stack, connect A with B using an HLSStackPushSegue
+ *
+ * The destination view controller can be prewarmed by the source view controller (see UIViewController+HLSSeguePrewarming.h)
  */
 @interface HLSStackPushSegue : UIStoryboardSegue {
 @private
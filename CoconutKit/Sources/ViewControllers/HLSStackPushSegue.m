@@ -10,6 +10,10 @@
 
 #import "HLSLogger.h"
 #import "HLSStackController.h"
+#import "UIViewController+HLSSeguePrewarming.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
 
 NSString * const HLSStackRootSegueIdentifier = @"hls_root";
 
@@ -19,6 +23,12 @@ NSString * const HLSStackRootSegueIdentifier = @"hls_root";
 
 - (id)initWithIdentifier:(NSString *)identifier source:(UIViewController *)source destination:(UIViewController *)destination
 {
+    // Use the instance prewarmed by the source view controller, if any
+    UIViewController *prewarmedViewController = [source dequeuePrewarmedViewControllerForSegueWithIdentifier:identifier];
+    if (prewarmedViewController) {
+        destination = prewarmedViewController;
+    }
+    
     if ((self = [super initWithIdentifier:identifier source:source destination:destination])) {
         self.transitionClass = [HLSTransitionNone class];
         self.duration = kAnimationTransitionDefaultDuration;
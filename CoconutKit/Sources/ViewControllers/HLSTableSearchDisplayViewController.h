@@ -32,6 +32,19 @@
  * UISearchDisplayDelegate methods to return YES when the table view needs reloading. These methods are called each 
  * time the search string or the search scope are changed.
  *
+ * Instead of filtering results yourself, you can let HLSTableSearchDisplayViewController do it for you off the main thread.
+ * Simply set the searchableObjects property to the list of all objects which can be searched, and override the
+ * -object:matchesSearchText:scopeButtonIndex: method to decide whether an object matches the search criteria. Results
+ * are then available from the filteredObjects property, which must be used to populate the first (and only) section
+ * of the search results table view. In this case:
+ *   - filtering only starts after the user has stopped typing for a short while (searchDelay property)
+ *   - filtering occurs on a background queue, and is cancelled if the search criteria are changed in the meantime
+ *   - when the search string gets longer, only the previous results are filtered again (see the
+ *     refinesSearchResultsIncrementally property)
+ *   - the search results table view is updated by inserting and deleting rows in a single batch, not reloaded
+ * If you override -searchDisplayController:shouldReloadTableForSearchString: or -searchDisplayController:shouldReloadTableForSearchScope:,
+ * return the value returned by their super implementation, which is NO when filtering is performed by this class
+ *
  * HLSTableSearchDisplayViewController saves the current search criteria and restore them if the view has been
  * unloaded. You do not have to code this mechanism yourself.
  *
@@ -59,6 +72,14 @@
     BOOL m_searchInterfaceActive;
     UISearchDisplayController *m_searchController;
     BOOL m_firstLoad;
+    NSArray *m_searchableObjects;
+    NSArray *m_filteredObjects;
+    NSString *m_filteredSearchText;
+    NSInteger m_filteredScopeButtonIndex;
+    NSTimeInterval m_searchDelay;
+    BOOL m_refinesSearchResultsIncrementally;
+    BOOL m_searchableObjectsChanged;
+    volatile int32_t m_filteringGeneration;
 }
 
 /**
@@ -81,4 +102,42 @@
  */
 @property (nonatomic, readonly, assign) UITableView *searchResultsTableView;
 
+/**
+ * The objects to be filtered according to the search criteria. If nil, no filtering is performed by this class, and
+ * you must filter the results yourself when the search criteria change. Setting new objects filters them again
+ */
+@property (nonatomic, retain) NSArray *searchableObjects;
+
+/**
+ * The searchable objects matching the current search criteria, in the same order. All searchable objects are returned
+ * if no search string has been entered. Use these objects to populate the search results table view
+ */
+@property (nonatomic, readonly, retain) NSArray *filteredObjects;
+
+/**
+ * The time to wait after the search criteria have last been changed before filtering the searchable objects
+ *
+ * The default value is 0.2 seconds
+ */
+@property (nonatomic, assign) NSTimeInterval searchDelay;
+
+/**
+ * If set to YES, only the objects matching the previous search string are filtered again when the search string gets
+ * longer (and the scope is unchanged). This requires that an object can never match a longer search string if it did
+ * not match a shorter string it starts with (which is the case for the default matching behavior). Set to NO if your
+ * matching criteria do not satisfy this requirement
+ *
+ * The default value is YES
+ */
+@property (nonatomic, assign) BOOL refinesSearchResultsIncrementally;
+
+/**
+ * Return YES iff an object matches the search criteria. This method is called on a background queue and must therefore
+ * be thread-safe. It is never called when the search string is empty
+ *
+ * The default implementation looks for the search string in the object description (ignoring case and diacritics) and
+ * ignores the scope button index
+ */
+- (BOOL)object:(id)object matchesSearchText:(NSString *)searchText scopeButtonIndex:(NSInteger)scopeButtonIndex;
+
 @end
@@ -9,27 +9,68 @@
 #import "HLSTableSearchDisplayViewController.h"
 
 #import "HLSAssert.h"
+#import "HLSFloat.h"
 #import "NSBundle+HLSDynamicLocalization.h"
 
 // Height of the UIKit search bar
 static const CGFloat kSearchBarStandardHeight = 44.f;
 
+static const NSTimeInterval kTableSearchDisplayDefaultSearchDelay = 0.2;
+
 @interface HLSTableSearchDisplayViewController ()
 
 @property (nonatomic, retain) UISearchBar *searchBar;
 @property (nonatomic, retain) NSString *searchText;
 @property (nonatomic, retain) UISearchDisplayController *searchController;      // Not called searchDisplayController to avoid conflicts with 
                                                                                 // UIViewController's searchViewController property
+@property (nonatomic, retain) NSArray *filteredObjects;
+@property (nonatomic, retain) NSString *filteredSearchText;
+
+- (void)hlsTableSearchDisplayViewControllerInit;
+
+- (void)scheduleFiltering;
+- (void)cancelFiltering;
+- (void)filterSearchableObjects;
+- (void)updateFilteredObjects:(NSArray *)filteredObjects
+                   searchText:(NSString *)searchText
+             scopeButtonIndex:(NSInteger)scopeButtonIndex;
+
 @end
 
 @implementation HLSTableSearchDisplayViewController
 
 #pragma mark Object creation and destruction
 
+- (id)initWithNibName:(NSString *)nibNameOrNil bundle:(NSBundle *)nibBundleOrNil
+{
+    if ((self = [super initWithNibName:nibNameOrNil bundle:nibBundleOrNil])) {
+        [self hlsTableSearchDisplayViewControllerInit];
+    }
+    return self;
+}
+
+- (id)initWithCoder:(NSCoder *)aDecoder
+{
+    if ((self = [super initWithCoder:aDecoder])) {
+        [self hlsTableSearchDisplayViewControllerInit];
+    }
+    return self;
+}
+
+// Common initialization code
+- (void)hlsTableSearchDisplayViewControllerInit
+{
+    self.searchDelay = kTableSearchDisplayDefaultSearchDelay;
+    self.refinesSearchResultsIncrementally = YES;
+}
+
 - (void)dealloc
 {
     self.searchText = nil;
     self.searchController = nil;
+    self.searchableObjects = nil;
+    self.filteredObjects = nil;
+    self.filteredSearchText = nil;
     
     [super dealloc];
 }
@@ -40,6 +81,12 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
     
     self.searchBar = nil;
     self.tableView = nil;
+    
+    // The search results table view is released as well. Pending results must not be applied as batch updates to
+    // the table view which will be created when the view is loaded again
+    [self cancelFiltering];
+    self.filteredObjects = nil;
+    self.filteredSearchText = nil;
 }
 
 #pragma mark Accessors and mutators
@@ -57,6 +104,32 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
 
 @synthesize searchController = m_searchController;
 
+@synthesize searchableObjects = m_searchableObjects;
+
+- (void)setSearchableObjects:(NSArray *)searchableObjects
+{
+    if (m_searchableObjects == searchableObjects) {
+        return;
+    }
+    
+    [m_searchableObjects release];
+    m_searchableObjects = [searchableObjects retain];
+    
+    // Previous results cannot be refined anymore
+    m_searchableObjectsChanged = YES;
+    
+    [self cancelFiltering];
+    [self filterSearchableObjects];
+}
+
+@synthesize filteredObjects = m_filteredObjects;
+
+@synthesize filteredSearchText = m_filteredSearchText;
+
+@synthesize searchDelay = m_searchDelay;
+
+@synthesize refinesSearchResultsIncrementally = m_refinesSearchResultsIncrementally;
+
 #pragma mark View lifecycle
 
 - (void)viewDidLoad
@@ -173,12 +246,25 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
 - (BOOL)searchDisplayController:(UISearchDisplayController *)controller shouldReloadTableForSearchString:(NSString *)searchString
 {
     self.searchText = searchString;
+    
+    // The table view is updated when filtering is complete
+    if (self.searchableObjects) {
+        [self scheduleFiltering];
+        return NO;
+    }
+    
     return YES;
 }
 
 - (BOOL)searchDisplayController:(UISearchDisplayController *)controller shouldReloadTableForSearchScope:(NSInteger)searchOption
 {
     m_selectedScopeButtonIndex = searchOption;
+    
+    if (self.searchableObjects) {
+        [self scheduleFiltering];
+        return NO;
+    }
+    
     return YES;
 }
 
@@ -196,6 +282,136 @@ static const CGFloat kSearchBarStandardHeight = 44.f;
     return nil;
 }
 
+#pragma mark Filtering
+
+- (BOOL)object:(id)object matchesSearchText:(NSString *)searchText scopeButtonIndex:(NSInteger)scopeButtonIndex
+{
+    NSRange range = [[object description] rangeOfString:searchText options:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch];
+    return range.length != 0;
+}
+
+- (void)scheduleFiltering
+{
+    [self cancelFiltering];
+    
+    if (floateq(self.searchDelay, 0.)) {
+        [self filterSearchableObjects];
+    }
+    else {
+        [self performSelector:@selector(filterSearchableObjects) withObject:nil afterDelay:self.searchDelay];
+    }
+}
+
+- (void)cancelFiltering
+{
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(filterSearchableObjects) object:nil];
+    
+    // Filtering in progress stops as soon as it notices that the generation has changed
+    ++m_filteringGeneration;
+}
+
+- (void)filterSearchableObjects
+{
+    NSString *searchText = self.searchText ? self.searchText : @"";
+    NSInteger scopeButtonIndex = m_selectedScopeButtonIndex;
+    
+    if (! self.searchableObjects || [searchText length] == 0) {
+        [self updateFilteredObjects:self.searchableObjects searchText:searchText scopeButtonIndex:scopeButtonIndex];
+        return;
+    }
+    
+    // Refine the previous results if possible
+    NSArray *candidateObjects = self.searchableObjects;
+    if (self.refinesSearchResultsIncrementally
+            && ! m_searchableObjectsChanged
+            && self.filteredObjects
+            && scopeButtonIndex == m_filteredScopeButtonIndex
+            && [self.filteredSearchText length] != 0
+            && [searchText hasPrefix:self.filteredSearchText]) {
+        candidateObjects = self.filteredObjects;
+    }
+    
+    int32_t generation = ++m_filteringGeneration;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        
+        BOOL cancelled = NO;
+        NSMutableArray *filteredObjects = [NSMutableArray array];
+        for (id object in candidateObjects) {
+            if (m_filteringGeneration != generation) {
+                cancelled = YES;
+                break;
+            }
+            
+            if ([self object:object matchesSearchText:searchText scopeButtonIndex:scopeButtonIndex]) {
+                [filteredObjects addObject:object];
+            }
+        }
+        
+        if (! cancelled) {
+            NSArray *results = [NSArray arrayWithArray:filteredObjects];
+            dispatch_async(dispatch_get_main_queue(), ^{
+                // Discard results if the search criteria have changed in the meantime
+                if (m_filteringGeneration != generation) {
+                    return;
+                }
+                
+                [self updateFilteredObjects:results searchText:searchText scopeButtonIndex:scopeButtonIndex];
+            });
+        }
+        
+        [pool drain];
+    });
+}
+
+- (void)updateFilteredObjects:(NSArray *)filteredObjects
+                   searchText:(NSString *)searchText
+             scopeButtonIndex:(NSInteger)scopeButtonIndex
+{
+    NSArray *previousFilteredObjects = [[self.filteredObjects retain] autorelease];
+    BOOL searchableObjectsChanged = m_searchableObjectsChanged;
+    
+    self.filteredObjects = filteredObjects;
+    self.filteredSearchText = searchText;
+    m_filteredScopeButtonIndex = scopeButtonIndex;
+    m_searchableObjectsChanged = NO;
+    
+    // Batch updates can only be applied to a table view displaying the previous results. If this is not the case,
+    // or if the objects themselves have changed, reload the table view
+    UITableView *searchResultsTableView = self.searchResultsTableView;
+    if (searchableObjectsChanged || ! previousFilteredObjects || ! searchResultsTableView.window) {
+        [searchResultsTableView reloadData];
+        return;
+    }
+    
+    // Filtered objects keep the order of searchable objects. Rows of objects which disappeared can therefore be
+    // deleted and rows of objects which appeared inserted, without any moves
+    NSSet *filteredObjectsSet = [NSSet setWithArray:filteredObjects];
+    NSMutableArray *deletedIndexPaths = [NSMutableArray array];
+    [previousFilteredObjects enumerateObjectsUsingBlock:^(id object, NSUInteger idx, BOOL *stop) {
+        if (! [filteredObjectsSet containsObject:object]) {
+            [deletedIndexPaths addObject:[NSIndexPath indexPathForRow:idx inSection:0]];
+        }
+    }];
+    
+    NSSet *previousFilteredObjectsSet = [NSSet setWithArray:previousFilteredObjects];
+    NSMutableArray *insertedIndexPaths = [NSMutableArray array];
+    [filteredObjects enumerateObjectsUsingBlock:^(id object, NSUInteger idx, BOOL *stop) {
+        if (! [previousFilteredObjectsSet containsObject:object]) {
+            [insertedIndexPaths addObject:[NSIndexPath indexPathForRow:idx inSection:0]];
+        }
+    }];
+    
+    if ([deletedIndexPaths count] == 0 && [insertedIndexPaths count] == 0) {
+        return;
+    }
+    
+    [searchResultsTableView beginUpdates];
+    [searchResultsTableView deleteRowsAtIndexPaths:deletedIndexPaths withRowAnimation:UITableViewRowAnimationNone];
+    [searchResultsTableView insertRowsAtIndexPaths:insertedIndexPaths withRowAnimation:UITableViewRowAnimationNone];
+    [searchResultsTableView endUpdates];
+}
+
 #pragma mark Localization
 
 - (void)localize
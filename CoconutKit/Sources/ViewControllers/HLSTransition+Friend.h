@@ -0,0 +1,38 @@
+//
+//  HLSTransition+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 10/15/12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSTransition.h"
+
+/**
+ * Interface meant to be used by friend classes of HLSTransition (= classes which must have access to private implementation
+ * details)
+ */
+@interface HLSTransition (Friend)
+
+/**
+ * Same as +animationWithAppearingView:disappearingView:inView:duration:, but if animatingView is set to NO, the
+ * animations applied to view (if any) are omitted. This is useful when the same transition must be applied to 
+ * several pairs of views displayed in view, so that the animations of view are applied only once
+ */
++ (HLSAnimation *)animationWithAppearingView:(UIView *)appearingView
+                            disappearingView:(UIView *)disappearingView
+                                      inView:(UIView *)view
+                                    duration:(NSTimeInterval)duration
+                               animatingView:(BOOL)animatingView;
+
+/**
+ * Same as +reverseAnimationWithAppearingView:disappearingView:inView:duration:, omitting animations applied to view
+ * if animatingView is set to NO
+ */
++ (HLSAnimation *)reverseAnimationWithAppearingView:(UIView *)appearingView
+                                   disappearingView:(UIView *)disappearingView
+                                             inView:(UIView *)view
+                                           duration:(NSTimeInterval)duration
+                                      animatingView:(BOOL)animatingView;
+
+@end
@@ -100,8 +100,21 @@ extern const NSTimeInterval kAnimationTransitionDefaultDuration;
 @interface HLSTransition : NSObject
 
 /**
- * Return all class names corresponding to available transition animations (except HLSTransition itself). These include
- * custom transitions as well
+ * Register a custom transition class so that it is listed by +availableTransitionNames. Transitions provided by
+ * CoconutKit are registered automatically. The best place to register a custom transition is its +load method:
+ *
+ *   + (void)load
+ *   {
+ *       [HLSTransition registerTransitionClass:self];
+ *   }
+ *
+ * Remark: Registration is only needed for listing transitions. Unregistered transition classes can still be used
+ */
++ (void)registerTransitionClass:(Class)transitionClass;
+
+/**
+ * Return all class names corresponding to available transition animations (except HLSTransition itself), sorted by
+ * name. These include registered custom transitions as well (see +registerTransitionClass:)
  */
 + (NSArray *)availableTransitionNames;
 
@@ -8,13 +8,20 @@
 
 #import "HLSTransition.h"
 
+#import "HLSTransition+Friend.h"
+
 #import "HLSAnimation.h"
+#import "HLSAnimation+Friend.h"
 #import "HLSAssert.h"
 #import "HLSFloat.h"
 #import "HLSLayerAnimationStep.h"
+#import "HLSLogger.h"
+#import "HLSRuntime.h"
 #import "NSObject+HLSExtensions.h"
 #import "NSSet+HLSExtensions.h"
-#import <objc/runtime.h>
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
 
 // Constants
 const NSTimeInterval kAnimationTransitionDefaultDuration = -1.;
@@ -22,8 +29,79 @@ const NSTimeInterval kAnimationTransitionDefaultDuration = -1.;
 static CGFloat kPushToTheBackScaleFactor = 0.95f;
 static CGFloat kEmergeFromCenterScaleFactor = 0.8f;
 
+// Transitions provided by CoconutKit, registered at compile time
+static NSString * const kBuiltInTransitionNames[] = {
+    @"HLSTransitionNone",
+    @"HLSTransitionCoverFromBottom",
+    @"HLSTransitionCoverFromTop",
+    @"HLSTransitionCoverFromLeft",
+    @"HLSTransitionCoverFromRight",
+    @"HLSTransitionCoverFromTopLeft",
+    @"HLSTransitionCoverFromTopRight",
+    @"HLSTransitionCoverFromBottomLeft",
+    @"HLSTransitionCoverFromBottomRight",
+    @"HLSTransitionCoverFromBottomPushToBack",
+    @"HLSTransitionCoverFromTopPushToBack",
+    @"HLSTransitionCoverFromLeftPushToBack",
+    @"HLSTransitionCoverFromRightPushToBack",
+    @"HLSTransitionCoverFromTopLeftPushToBack",
+    @"HLSTransitionCoverFromTopRightPushToBack",
+    @"HLSTransitionCoverFromBottomLeftPushToBack",
+    @"HLSTransitionCoverFromBottomRightPushToBack",
+    @"HLSTransitionFadeIn",
+    @"HLSTransitionFadeInPushToBack",
+    @"HLSTransitionCrossDissolve",
+    @"HLSTransitionPushFromBottom",
+    @"HLSTransitionPushFromTop",
+    @"HLSTransitionPushFromLeft",
+    @"HLSTransitionPushFromRight",
+    @"HLSTransitionPushFromBottomFadeIn",
+    @"HLSTransitionPushFromTopFadeIn",
+    @"HLSTransitionPushFromLeftFadeIn",
+    @"HLSTransitionPushFromRightFadeIn",
+    @"HLSTransitionPushToBackFromBottom",
+    @"HLSTransitionPushToBackFromTop",
+    @"HLSTransitionPushToBackFromLeft",
+    @"HLSTransitionPushToBackFromRight",
+    @"HLSTransitionFlowFromBottom",
+    @"HLSTransitionFlowFromTop",
+    @"HLSTransitionFlowFromLeft",
+    @"HLSTransitionFlowFromRight",
+    @"HLSTransitionEmergeFromCenter",
+    @"HLSTransitionEmergeFromCenterPushToBack",
+    @"HLSTransitionFlipVertically",
+    @"HLSTransitionFlipHorizontally",
+    @"HLSTransitionRotateHorizontallyFromBottomCounterclockwise",
+    @"HLSTransitionRotateHorizontallyFromBottomClockwise",
+    @"HLSTransitionRotateHorizontallyFromTopCounterclockwise",
+    @"HLSTransitionRotateHorizontallyFromTopClockwise",
+    @"HLSTransitionRotateVerticallyFromLeftCounterclockwise",
+    @"HLSTransitionRotateVerticallyFromLeftClockwise",
+    @"HLSTransitionRotateVerticallyFromRightCounterclockwise",
+    @"HLSTransitionRotateVerticallyFromRightClockwise"
+};
+
+// Transitions registered using +registerTransitionClass:
+static NSMutableArray *s_registeredTransitionClasses = nil;
+
+// Lazily computed from the above
+static NSArray *s_availableTransitionNames = nil;
+
+// Transition animations are generated once for placeholder views and then bound to the actual views. Placeholders are
+// arranged as described in the HLSTransition documentation
+static UIView *s_appearingPlaceholderView = nil;
+static UIView *s_disappearingPlaceholderView = nil;
+static UIView *s_placeholderView = nil;
+
 @interface HLSTransition ()
 
++ (HLSAnimation *)animationTemplateWithBounds:(CGRect)bounds duration:(NSTimeInterval)duration reverse:(BOOL)reverse;
+
++ (HLSAnimation *)animationByBindingAnimationTemplate:(HLSAnimation *)animationTemplate
+                                      toAppearingView:(UIView *)appearingView
+                                     disappearingView:(UIView *)disappearingView
+                                               inView:(UIView *)view;
+
 + (NSArray *)coverLayerAnimationStepsWithInitialXOffset:(CGFloat)xOffset
                                                 yOffset:(CGFloat)yOffset
                                           appearingView:(UIView *)appearingView;
@@ -79,38 +157,46 @@ static CGFloat kEmergeFromCenterScaleFactor = 0.8f;
 
 #pragma mark Getting transition animation information
 
++ (void)registerTransitionClass:(Class)transitionClass
+{
+    if (transitionClass == [HLSTransition class] || ! hls_class_isSubclassOfClass(transitionClass, [HLSTransition class])) {
+        HLSLoggerError(@"The class %s is not an HLSTransition subclass", class_getName(transitionClass));
+        return;
+    }
+    
+    // Usually called from +load methods, where no autorelease pool might be available. Do not create autoreleased objects
+    if (! s_registeredTransitionClasses) {
+        s_registeredTransitionClasses = [[NSMutableArray alloc] init];
+    }
+    
+    if ([s_registeredTransitionClasses containsObject:transitionClass]) {
+        return;
+    }
+    [s_registeredTransitionClasses addObject:transitionClass];
+    
+    // Invalidate the list of names, which will be lazily rebuilt when needed
+    [s_availableTransitionNames release];
+    s_availableTransitionNames = nil;
+}
+
 + (NSArray *)availableTransitionNames
 {
-    static NSArray *s_availableTransitionNames = nil;
     if (! s_availableTransitionNames) {
         NSMutableArray *availableTransitionNames = [NSMutableArray array];
         
-        // Find all HLSTransition subclasses (except HLSTransition itself)
-        unsigned int numberOfClasses = 0;
-        Class *classes = objc_copyClassList(&numberOfClasses);
-        for (int i = 0; i < numberOfClasses; ++i) {
-            Class class = classes[i];
-            
-            // Discard HLSTransition
-            if (class == [HLSTransition class]) {
-                continue;
-            }
-            
-            // Find whether HLSTransition is a superclass. We cannot use -isSubclassOfClass: since it is an NSObject
-            // method and we might encounter other kinds of classes (e.g. proxies)
-            // TODO: Factor out in HLSRuntime.h after merge with url-networking branch
-            Class superclass = class;
-            do {
-                superclass = class_getSuperclass(superclass);
-            } while (superclass && superclass != [HLSTransition class]);
+        // Built-in transitions, which do not require any class lookup
+        NSUInteger numberOfBuiltInTransitions = sizeof(kBuiltInTransitionNames) / sizeof(kBuiltInTransitionNames[0]);
+        for (NSUInteger i = 0; i < numberOfBuiltInTransitions; ++i) {
+            [availableTransitionNames addObject:kBuiltInTransitionNames[i]];
+        }
             
-            if (! superclass) {
-                continue;
+        // Custom transitions
+        for (Class transitionClass in s_registeredTransitionClasses) {
+            NSString *transitionName = NSStringFromClass(transitionClass);
+            if (! [availableTransitionNames containsObject:transitionName]) {
+                [availableTransitionNames addObject:transitionName];
             }
-            
-            [availableTransitionNames addObject:NSStringFromClass(class)];
         }
-        free(classes);
         
         s_availableTransitionNames = [[availableTransitionNames sortedArrayUsingSelector:@selector(caseInsensitiveCompare:)] retain];
     }
@@ -123,69 +209,149 @@ static CGFloat kEmergeFromCenterScaleFactor = 0.8f;
                             disappearingView:(UIView *)disappearingView
                                       inView:(UIView *)view
                                     duration:(NSTimeInterval)duration
+{
+    return [self animationWithAppearingView:appearingView
+                           disappearingView:disappearingView
+                                     inView:view
+                                   duration:duration
+                              animatingView:YES];
+}
+
++ (HLSAnimation *)animationWithAppearingView:(UIView *)appearingView
+                            disappearingView:(UIView *)disappearingView
+                                      inView:(UIView *)view
+                                    duration:(NSTimeInterval)duration
+                               animatingView:(BOOL)animatingView
 {
     NSAssert(view && (! appearingView || appearingView.superview == view) && (! disappearingView || disappearingView.superview == view),
              @"Both the appearing and disappearing views must be children of the view in which the transition takes place");
     
-    // Build the animation with default parameters. Beware of the inView parameter here: If no appearing view has been set,
-    // we are replaying an animation only for disappearing view
-    NSArray *animationSteps = [self layerAnimationStepsWithAppearingView:appearingView
-                                                        disappearingView:disappearingView
-                                                                  inView:appearingView ? view : nil
-                                                              withBounds:view.bounds];
-    HLSAssertObjectsInEnumerationAreKindOfClass(animationSteps, [HLSLayerAnimationStep class]);
-        
-    HLSAnimation *animation = [HLSAnimation animationWithAnimationSteps:animationSteps];
-    
-    // Generate an animation with the proper duration
-    if (doubleeq(duration, kAnimationTransitionDefaultDuration)) {
-        return animation;
-    }
-    else {
-        return [animation animationWithDuration:duration];
-    }
+    // Beware of the inView parameter here: If no appearing view has been set, we are replaying an animation only for
+    // disappearing view
+    HLSAnimation *animationTemplate = [self animationTemplateWithBounds:view.bounds duration:duration reverse:NO];
+    return [self animationByBindingAnimationTemplate:animationTemplate
+                                     toAppearingView:appearingView
+                                    disappearingView:disappearingView
+                                              inView:(appearingView && animatingView) ? view : nil];
+}
+
++ (HLSAnimation *)reverseAnimationWithAppearingView:(UIView *)appearingView
+                                   disappearingView:(UIView *)disappearingView
+                                             inView:(UIView *)view
+                                           duration:(NSTimeInterval)duration
+{
+    return [self reverseAnimationWithAppearingView:appearingView
+                                  disappearingView:disappearingView
+                                            inView:view
+                                          duration:duration
+                                     animatingView:YES];
 }
 
 + (HLSAnimation *)reverseAnimationWithAppearingView:(UIView *)appearingView
                                    disappearingView:(UIView *)disappearingView
                                              inView:(UIView *)view
                                            duration:(NSTimeInterval)duration
+                                      animatingView:(BOOL)animatingView
 {
     NSAssert(view && (! appearingView || appearingView.superview == view) && disappearingView.superview == view,
              @"Both the appearing and disappearing views must be children of the view in which the transition takes place");
     
-    // Build the animation with default parameters. Calculate the original bounds to take into account any transform
-    // which might be applied
+    // Calculate the original bounds to take into account any transform which might be applied
     CGRect originalFrame = CGRectApplyAffineTransform(view.frame, CGAffineTransformInvert(view.transform));
-    NSArray *animationSteps = [self reverseLayerAnimationStepsWithAppearingView:appearingView
-                                                               disappearingView:disappearingView
-                                                                         inView:view
-                                                                     withBounds:CGRectMake(0.f,
-                                                                                           0.f,
-                                                                                           CGRectGetWidth(originalFrame),
-                                                                                           CGRectGetHeight(originalFrame))];
+    HLSAnimation *animationTemplate = [self animationTemplateWithBounds:CGRectMake(0.f,
+                                                                                    0.f,
+                                                                                    CGRectGetWidth(originalFrame),
+                                                                                    CGRectGetHeight(originalFrame))
+                                                                duration:duration
+                                                                 reverse:YES];
     
     // If custom reverse animation implemented by the animation class, use it
-    if (animationSteps) {
-        HLSAssertObjectsInEnumerationAreKindOfClass(animationSteps, [HLSLayerAnimationStep class]);
+    if (animationTemplate) {
+        return [self animationByBindingAnimationTemplate:animationTemplate
+                                         toAppearingView:appearingView
+                                        disappearingView:disappearingView
+                                                  inView:animatingView ? view : nil];
+    }
+    // If not implemented by the transition class, use the default reverse animation. The reverse of the transition
+    // where the roles of both views are swapped
+    else {
+        animationTemplate = [[self animationTemplateWithBounds:view.bounds duration:duration reverse:NO] reverseAnimation];
+        return [self animationByBindingAnimationTemplate:animationTemplate
+                                         toAppearingView:disappearingView
+                                        disappearingView:appearingView
+                                                  inView:animatingView ? view : nil];
+    }
+}
+
++ (HLSAnimation *)animationTemplateWithBounds:(CGRect)bounds duration:(NSTimeInterval)duration reverse:(BOOL)reverse
+{
+    // Generated animations only depend on the transition class, the bounds and the duration. Cache them for placeholder
+    // views, so that they do not need to be rebuilt each time a transition is played
+    static NSCache *s_animationTemplateCache = nil;
+    if (! s_animationTemplateCache) {
+        s_animationTemplateCache = [[NSCache alloc] init];
+        
+        s_placeholderView = [[UIView alloc] initWithFrame:CGRectZero];
+        s_disappearingPlaceholderView = [[UIView alloc] initWithFrame:CGRectZero];
+        [s_placeholderView addSubview:s_disappearingPlaceholderView];
+        s_appearingPlaceholderView = [[UIView alloc] initWithFrame:CGRectZero];
+        [s_placeholderView addSubview:s_appearingPlaceholderView];
+    }
+    
+    NSString *cacheKey = [NSString stringWithFormat:@"%@_%@_%f_%d", [self className], NSStringFromCGSize(bounds.size), duration, reverse];
+    id animationTemplate = [s_animationTemplateCache objectForKey:cacheKey];
+    if (! animationTemplate) {
+        s_placeholderView.bounds = bounds;
+        s_disappearingPlaceholderView.bounds = bounds;
+        s_appearingPlaceholderView.bounds = bounds;
+        
+        // Build the animation with default parameters
+        NSArray *animationSteps = nil;
+        if (reverse) {
+            animationSteps = [self reverseLayerAnimationStepsWithAppearingView:s_appearingPlaceholderView
+                                                              disappearingView:s_disappearingPlaceholderView
+                                                                        inView:s_placeholderView
+                                                                    withBounds:bounds];
+        }
+        else {
+            animationSteps = [self layerAnimationStepsWithAppearingView:s_appearingPlaceholderView
+                                                       disappearingView:s_disappearingPlaceholderView
+                                                                 inView:s_placeholderView
+                                                             withBounds:bounds];
+        }
+        
+        if (animationSteps) {
+            HLSAssertObjectsInEnumerationAreKindOfClass(animationSteps, [HLSLayerAnimationStep class]);
                 
-        HLSAnimation *animation = [HLSAnimation animationWithAnimationSteps:animationSteps];
+            animationTemplate = [HLSAnimation animationWithAnimationSteps:animationSteps];
         
-        // Generate an animation with the proper duration
-        if (doubleeq(duration, kAnimationTransitionDefaultDuration)) {
-            return animation;
+            // Generate an animation with the proper duration
+            if (! doubleeq(duration, kAnimationTransitionDefaultDuration)) {
+                animationTemplate = [animationTemplate animationWithDuration:duration];
+            }
         }
+        // No custom reverse animation. Remember it as well
         else {
-            return [animation animationWithDuration:duration];
+            animationTemplate = [NSNull null];
         }
+        [s_animationTemplateCache setObject:animationTemplate forKey:cacheKey];
     }
-    // If not implemented by the transition class, use the default reverse animation
-    else {
-        return [[self animationWithAppearingView:disappearingView
-                                disappearingView:appearingView
-                                          inView:view
-                                        duration:duration] reverseAnimation];
-    }
+    
+    return animationTemplate == [NSNull null] ? nil : animationTemplate;
+}
+
++ (HLSAnimation *)animationByBindingAnimationTemplate:(HLSAnimation *)animationTemplate
+                                      toAppearingView:(UIView *)appearingView
+                                     disappearingView:(UIView *)disappearingView
+                                               inView:(UIView *)view
+{
+    // Animations involving a missing view are removed
+    NSDictionary *placeholderLayerKeyToLayerMap = [NSDictionary dictionaryWithObjectsAndKeys:
+                                                   appearingView ? (id)appearingView.layer : (id)[NSNull null], [NSValue valueWithPointer:s_appearingPlaceholderView.layer],
+                                                   disappearingView ? (id)disappearingView.layer : (id)[NSNull null], [NSValue valueWithPointer:s_disappearingPlaceholderView.layer],
+                                                   view ? (id)view.layer : (id)[NSNull null], [NSValue valueWithPointer:s_placeholderView.layer],
+                                                   nil];
+    return [animationTemplate animationBySubstitutingObjects:placeholderLayerKeyToLayerMap];
 }
 
 + (NSTimeInterval)defaultDuration
@@ -48,7 +48,7 @@
  */
 @interface HLSViewController : UIViewController {
 @private
-    
+    BOOL m_localizationStale;               // YES iff the localization changed while the view was not visible
 }
 
 /**
@@ -79,6 +79,10 @@
  *
  * To ensure that your application is properly localized - even when the localization changes at runtime using +[NSBundle setLocalization:]
  * (from NSBundle+HLSDynamicLocalization.h) - you must access localized resources only from within this method
+ *
+ * When the localization changes at runtime, this method is called immediately only if the view is visible. For
+ * view controllers which are not visible (e.g. deep in a navigation history), the call is deferred until the view
+ * is about to appear again, so that only visible screens have to be localized when the localization changes
  */
 - (void)localize;
 
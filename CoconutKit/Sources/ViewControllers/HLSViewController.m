@@ -14,6 +14,7 @@
 #import "HLSLogger.h"
 #import "NSBundle+HLSDynamicLocalization.h"
 #import "NSObject+HLSExtensions.h"
+#import "UIViewController+HLSExtensions.h"
 
 /**
  * Initially, I intended to make the iOS 6 autorotation methods for UIViewController globally, not just for the
@@ -125,6 +126,7 @@
 - (void)viewDidLoad
 {
     [super viewDidLoad];
+    m_localizationStale = NO;
     [self localize];
     HLSLoggerDebug(@"View controller %@: view did load", self);
 }
@@ -132,6 +134,13 @@
 - (void)viewWillAppear:(BOOL)animated
 {
     [super viewWillAppear:animated];
+    
+    // Localization changes which occurred while the view was not visible
+    if (m_localizationStale) {
+        m_localizationStale = NO;
+        [self localize];
+    }
+    
     HLSLoggerDebug(@"View controller %@: view will appear, animated = %@", self, HLSStringFromBool(animated));
 }
 
@@ -179,6 +188,13 @@
 
 - (void)currentLocalizationDidChange:(NSNotification *)notification
 {
+    // Only visible view controllers are localized immediately. Other ones are localized when they appear again
+    if (! [self isViewVisible]) {
+        m_localizationStale = YES;
+        return;
+    }
+    
+    m_localizationStale = NO;
     [self localize];
 }
 
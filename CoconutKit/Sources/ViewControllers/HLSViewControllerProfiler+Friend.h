@@ -0,0 +1,32 @@
+//
+//  HLSViewControllerProfiler+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSViewControllerProfiler.h"
+#import "UIViewController+HLSExtensions.h"
+
+/**
+ * Interface meant to be used by friend classes of HLSViewControllerProfiler (= classes which must have access to private
+ * implementation details)
+ */
+@interface HLSViewControllerProfiler (Friend)
+
+/**
+ * Must be called before, respectively after a lifecycle method of a view controller (-viewDidLoad, -viewWillAppear:
+ * or -viewDidAppear:; other phases are ignored) is called. Calls can be nested (e.g. when the method is called on
+ * super), only the outermost one is measured
+ */
+- (void)viewController:(UIViewController *)viewController willEnterLifeCyclePhase:(HLSViewControllerLifeCyclePhase)lifeCyclePhase;
+- (void)viewController:(UIViewController *)viewController didEnterLifeCyclePhase:(HLSViewControllerLifeCyclePhase)lifeCyclePhase;
+
+/**
+ * Must be called when a view controller has been initialized, respectively when it is deallocated
+ */
+- (void)viewControllerDidInitialize:(UIViewController *)viewController;
+- (void)viewControllerWillBeDeallocated:(UIViewController *)viewController;
+
+@end
@@ -0,0 +1,92 @@
+//
+//  HLSViewControllerProfiler.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+// Durations which can be measured for view controllers
+typedef enum {
+    HLSViewControllerProfilerMetricEnumBegin = 0,
+    HLSViewControllerProfilerMetricViewDidLoadDuration = HLSViewControllerProfilerMetricEnumBegin,      // time spent in -viewDidLoad
+    HLSViewControllerProfilerMetricViewWillAppearDuration,                                              // time spent in -viewWillAppear:
+    HLSViewControllerProfilerMetricInitToViewDidLoad,                                                   // from the end of initialization to the end of -viewDidLoad
+    HLSViewControllerProfilerMetricViewDidLoadToViewDidAppear,                                          // from the end of -viewDidLoad to the end of the first -viewDidAppear:
+    HLSViewControllerProfilerMetricInitToViewDidAppear,                                                 // from the end of initialization to the end of the first -viewDidAppear:
+    HLSViewControllerProfilerMetricEnumEnd,
+    HLSViewControllerProfilerMetricEnumSize = HLSViewControllerProfilerMetricEnumEnd - HLSViewControllerProfilerMetricEnumBegin
+} HLSViewControllerProfilerMetric;
+
+/**
+ * Opt-in profiler for the lifecycle of view controllers. When enabled, the profiler measures the durations listed
+ * above for each view controller class. Since the first appearance of a view controller ends when its -viewDidAppear:
+ * method has been called, HLSViewControllerProfilerMetricInitToViewDidAppear is the time it takes a screen displayed
+ * using a container (e.g. HLSStackController or HLSPlaceholderViewController) to become interactive. Only view
+ * controllers whose lifecycle is tracked (see UIViewController+HLSExtensions.h) are measured.
+ *
+ * To measure the whole time spent in lifecycle methods, and not only in the UIViewController implementations called
+ * on super, the -viewDidLoad, -viewWillAppear: and -viewDidAppear: methods of the classes of the view controllers
+ * measured are instrumented when the first of their instances is initialized. Instrumentation is kept when the
+ * profiler is disabled, and then costs a message per call.
+ *
+ * Implementations of -viewDidLoad and -viewWillAppear: running longer than the frame budget are logged as warnings.
+ * Durations are aggregated per class into histograms (one bucket for each power of 2 of milliseconds), so that the
+ * memory consumed does not grow with the number of view controllers displayed
+ *
+ * The profiler must only be used from the main thread. View controllers initialized on other threads are not measured
+ *
+ * Designated initializer: -init (but use the +sharedViewControllerProfiler singleton)
+ */
+@interface HLSViewControllerProfiler : NSObject {
+@private
+    CFMutableDictionaryRef m_viewControllerToTimestampsMap;         // maps a view controller (pointer) to the times of its first appearance
+    NSMutableDictionary *m_classNameToRecordMap;
+    NSTimeInterval m_frameBudget;
+    BOOL m_enabled;
+}
+
+/**
+ * The profiler singleton
+ */
++ (HLSViewControllerProfiler *)sharedViewControllerProfiler;
+
+/**
+ * Set to YES to start measuring. The first appearance of view controllers which have already been initialized at that
+ * time is not measured, and neither are the implementations of their subclasses until an instance of the same class
+ * is initialized. Disabling the profiler keeps the measurements collected so far
+ *
+ * Default value is NO
+ */
+@property (nonatomic, assign, getter=isEnabled) BOOL enabled;
+
+/**
+ * The duration above which -viewDidLoad and -viewWillAppear: implementations are considered too slow
+ *
+ * Default value is 1/60 s (one frame)
+ */
+@property (nonatomic, assign) NSTimeInterval frameBudget;
+
+/**
+ * The names of the view controller classes for which durations have been measured
+ */
+- (NSArray *)viewControllerClassNames;
+
+/**
+ * Return the number of measurements of a metric for view controllers of a given class (nil for all classes)
+ */
+- (NSUInteger)countForMetric:(HLSViewControllerProfilerMetric)metric viewControllerClassName:(NSString *)classNameOrNil;
+
+/**
+ * Return a report listing, for each view controller class, the number of measurements, the mean and maximum values
+ * of each metric, the number of -viewDidLoad and -viewWillAppear: implementations over budget, as well as the
+ * corresponding histograms. Classes are sorted by decreasing maximum HLSViewControllerProfilerMetricInitToViewDidAppear
+ */
+- (NSString *)report;
+
+/**
+ * Discard all measurements
+ */
+- (void)clear;
+
+@end
@@ -0,0 +1,515 @@
+//
+//  HLSViewControllerProfiler.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSViewControllerProfiler.h"
+
+#import <objc/runtime.h>
+#import <QuartzCore/QuartzCore.h>
+#import "HLSLogger.h"
+#import "HLSViewControllerProfiler+Friend.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
+
+// Number of histogram buckets. Bucket i contains durations below 2^i ms, the last one all remaining durations
+#define kViewControllerProfilerNumberOfBuckets                  12
+
+// Maximum number of lifecycle method calls of distinct view controllers which can be nested
+#define kViewControllerProfilerMaximumNumberOfPendingCalls      32
+
+// Short metric names used in reports
+static NSString * const kViewControllerProfilerMetricNames[] = {
+    @"viewDidLoad",
+    @"viewWillAppear:",
+    @"init->viewDidLoad",
+    @"viewDidLoad->viewDidAppear:",
+    @"init->viewDidAppear:"
+};
+
+// Lifecycle method being called on a view controller
+typedef struct {
+    UIViewController *viewController;                   // not retained
+    HLSViewControllerLifeCyclePhase lifeCyclePhase;
+    NSUInteger nestingLevel;                            // number of implementations in the class hierarchy being called
+    CFTimeInterval startTime;
+} HLSViewControllerPendingCall;
+
+// Lifecycle methods being called, innermost last. Only accessed from the main thread
+static HLSViewControllerPendingCall s_pendingCalls[kViewControllerProfilerMaximumNumberOfPendingCalls];
+static NSUInteger s_numberOfPendingCalls = 0;
+
+// Classes and methods which have been instrumented. Only accessed from the main thread
+static CFMutableSetRef s_instrumentedClasses = NULL;
+static CFMutableSetRef s_instrumentedMethods = NULL;
+
+// Function declarations
+static HLSViewControllerPendingCall *pendingCallForViewController(UIViewController *viewController, HLSViewControllerLifeCyclePhase lifeCyclePhase);
+static void instrumentLifeCycleMethodsForViewController(UIViewController *viewController);
+static void instrumentLifeCycleMethod(Class clazz, SEL selector, HLSViewControllerLifeCyclePhase lifeCyclePhase);
+
+#pragma mark -
+#pragma mark HLSViewControllerTimestamps class interface
+
+/**
+ * Times of the first appearance of a view controller (0 if not reached yet)
+ */
+@interface HLSViewControllerTimestamps : NSObject {
+@private
+    CFTimeInterval m_initTime;
+    CFTimeInterval m_viewDidLoadTime;
+}
+
+@property (nonatomic, assign) CFTimeInterval initTime;
+@property (nonatomic, assign) CFTimeInterval viewDidLoadTime;
+
+@end
+
+#pragma mark -
+#pragma mark HLSViewControllerClassRecord class interface
+
+/**
+ * Measurements aggregated for a view controller class
+ */
+@interface HLSViewControllerClassRecord : NSObject {
+@private
+    NSUInteger m_counts[HLSViewControllerProfilerMetricEnumSize];
+    CFTimeInterval m_totalDurations[HLSViewControllerProfilerMetricEnumSize];
+    CFTimeInterval m_maximumDurations[HLSViewControllerProfilerMetricEnumSize];
+    NSUInteger m_buckets[HLSViewControllerProfilerMetricEnumSize][kViewControllerProfilerNumberOfBuckets];
+    NSUInteger m_numberOfSlowViewDidLoads;
+    NSUInteger m_numberOfSlowViewWillAppears;
+}
+
+- (void)addDuration:(CFTimeInterval)duration forMetric:(HLSViewControllerProfilerMetric)metric;
+
+- (NSUInteger)countForMetric:(HLSViewControllerProfilerMetric)metric;
+- (CFTimeInterval)maximumDurationForMetric:(HLSViewControllerProfilerMetric)metric;
+
+@property (nonatomic, assign) NSUInteger numberOfSlowViewDidLoads;
+@property (nonatomic, assign) NSUInteger numberOfSlowViewWillAppears;
+
+- (NSString *)reportForMetric:(HLSViewControllerProfilerMetric)metric;
+
+@end
+
+#pragma mark -
+#pragma mark HLSViewControllerProfiler class
+
+@interface HLSViewControllerProfiler ()
+
+@property (nonatomic, retain) NSMutableDictionary *classNameToRecordMap;
+
+- (HLSViewControllerClassRecord *)recordForViewController:(UIViewController *)viewController;
+
+@end
+
+@implementation HLSViewControllerProfiler
+
+#pragma mark Class methods
+
++ (HLSViewControllerProfiler *)sharedViewControllerProfiler
+{
+    static HLSViewControllerProfiler *s_instance = nil;
+    
+    if (! s_instance) {
+        s_instance = [[HLSViewControllerProfiler alloc] init];
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        // View controllers are not retained
+        m_viewControllerToTimestampsMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        self.classNameToRecordMap = [NSMutableDictionary dictionary];
+        self.frameBudget = 1. / 60.;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    CFRelease(m_viewControllerToTimestampsMap);
+    self.classNameToRecordMap = nil;
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize enabled = m_enabled;
+
+- (void)setEnabled:(BOOL)enabled
+{
+    if (! enabled) {
+        CFDictionaryRemoveAllValues(m_viewControllerToTimestampsMap);
+    }
+    m_enabled = enabled;
+}
+
+@synthesize frameBudget = m_frameBudget;
+
+- (void)setFrameBudget:(NSTimeInterval)frameBudget
+{
+    if (frameBudget <= 0.) {
+        HLSLoggerError(@"The frame budget must be > 0");
+        return;
+    }
+    
+    m_frameBudget = frameBudget;
+}
+
+@synthesize classNameToRecordMap = m_classNameToRecordMap;
+
+- (HLSViewControllerClassRecord *)recordForViewController:(UIViewController *)viewController
+{
+    NSString *className = NSStringFromClass([viewController class]);
+    HLSViewControllerClassRecord *record = [self.classNameToRecordMap objectForKey:className];
+    if (! record) {
+        record = [[[HLSViewControllerClassRecord alloc] init] autorelease];
+        [self.classNameToRecordMap setObject:record forKey:className];
+    }
+    return record;
+}
+
+#pragma mark Recording
+
+- (void)viewControllerDidInitialize:(UIViewController *)viewController
+{
+    if (! self.enabled || ! [NSThread isMainThread]) {
+        return;
+    }
+    
+    instrumentLifeCycleMethodsForViewController(viewController);
+    
+    HLSViewControllerTimestamps *timestamps = [[[HLSViewControllerTimestamps alloc] init] autorelease];
+    timestamps.initTime = CACurrentMediaTime();
+    CFDictionarySetValue(m_viewControllerToTimestampsMap, viewController, timestamps);
+}
+
+- (void)viewController:(UIViewController *)viewController willEnterLifeCyclePhase:(HLSViewControllerLifeCyclePhase)lifeCyclePhase
+{
+    if (! self.enabled || ! [NSThread isMainThread]) {
+        return;
+    }
+    
+    // Nested call (e.g. on super)
+    HLSViewControllerPendingCall *pendingCall = pendingCallForViewController(viewController, lifeCyclePhase);
+    if (pendingCall) {
+        ++pendingCall->nestingLevel;
+        return;
+    }
+    
+    if (s_numberOfPendingCalls == kViewControllerProfilerMaximumNumberOfPendingCalls) {
+        HLSLoggerWarn(@"Too many nested lifecycle method calls. Not measured");
+        return;
+    }
+    
+    pendingCall = &s_pendingCalls[s_numberOfPendingCalls];
+    ++s_numberOfPendingCalls;
+    pendingCall->viewController = viewController;
+    pendingCall->lifeCyclePhase = lifeCyclePhase;
+    pendingCall->nestingLevel = 1;
+    pendingCall->startTime = CACurrentMediaTime();
+}
+
+- (void)viewController:(UIViewController *)viewController didEnterLifeCyclePhase:(HLSViewControllerLifeCyclePhase)lifeCyclePhase
+{
+    if (! [NSThread isMainThread]) {
+        return;
+    }
+    
+    HLSViewControllerPendingCall *pendingCall = pendingCallForViewController(viewController, lifeCyclePhase);
+    if (! pendingCall) {
+        return;
+    }
+    
+    --pendingCall->nestingLevel;
+    if (pendingCall->nestingLevel != 0) {
+        return;
+    }
+    
+    CFTimeInterval endTime = CACurrentMediaTime();
+    CFTimeInterval duration = endTime - pendingCall->startTime;
+    
+    // Calls end in reverse order, except if an exception has been thrown. Discard the calls which will never end
+    s_numberOfPendingCalls = pendingCall - s_pendingCalls;
+    
+    // Measurements collected while the profiler was being enabled or disabled are discarded
+    if (! self.enabled) {
+        return;
+    }
+    
+    HLSViewControllerTimestamps *timestamps = (HLSViewControllerTimestamps *)CFDictionaryGetValue(m_viewControllerToTimestampsMap, viewController);
+    switch (lifeCyclePhase) {
+        case HLSViewControllerLifeCyclePhaseViewDidLoad: {
+            HLSViewControllerClassRecord *record = [self recordForViewController:viewController];
+            [record addDuration:duration forMetric:HLSViewControllerProfilerMetricViewDidLoadDuration];
+            if (duration > self.frameBudget) {
+                ++record.numberOfSlowViewDidLoads;
+                HLSLoggerWarn(@"-viewDidLoad of %@ took %.1f ms, over the %.1f ms budget", [viewController class],
+                              duration * 1000., self.frameBudget * 1000.);
+            }
+            
+            // Only the first load is part of the first appearance
+            if (timestamps && timestamps.viewDidLoadTime == 0.) {
+                [record addDuration:endTime - timestamps.initTime forMetric:HLSViewControllerProfilerMetricInitToViewDidLoad];
+                timestamps.viewDidLoadTime = endTime;
+            }
+            break;
+        }
+            
+        case HLSViewControllerLifeCyclePhaseViewWillAppear: {
+            HLSViewControllerClassRecord *record = [self recordForViewController:viewController];
+            [record addDuration:duration forMetric:HLSViewControllerProfilerMetricViewWillAppearDuration];
+            if (duration > self.frameBudget) {
+                ++record.numberOfSlowViewWillAppears;
+                HLSLoggerWarn(@"-viewWillAppear: of %@ took %.1f ms, over the %.1f ms budget", [viewController class],
+                              duration * 1000., self.frameBudget * 1000.);
+            }
+            break;
+        }
+            
+        case HLSViewControllerLifeCyclePhaseViewDidAppear: {
+            if (! timestamps || timestamps.viewDidLoadTime == 0.) {
+                break;
+            }
+            
+            HLSViewControllerClassRecord *record = [self recordForViewController:viewController];
+            [record addDuration:endTime - timestamps.viewDidLoadTime forMetric:HLSViewControllerProfilerMetricViewDidLoadToViewDidAppear];
+            [record addDuration:endTime - timestamps.initTime forMetric:HLSViewControllerProfilerMetricInitToViewDidAppear];
+            
+            // The first appearance is over
+            CFDictionaryRemoveValue(m_viewControllerToTimestampsMap, viewController);
+            break;
+        }
+            
+        default: {
+            break;
+        }
+    }
+}
+
+- (void)viewControllerWillBeDeallocated:(UIViewController *)viewController
+{
+    if (! [NSThread isMainThread]) {
+        return;
+    }
+    
+    CFDictionaryRemoveValue(m_viewControllerToTimestampsMap, viewController);
+}
+
+#pragma mark Reporting
+
+- (NSArray *)viewControllerClassNames
+{
+    return [[self.classNameToRecordMap allKeys] sortedArrayUsingSelector:@selector(compare:)];
+}
+
+- (NSUInteger)countForMetric:(HLSViewControllerProfilerMetric)metric viewControllerClassName:(NSString *)classNameOrNil
+{
+    if (metric < HLSViewControllerProfilerMetricEnumBegin || metric >= HLSViewControllerProfilerMetricEnumEnd) {
+        HLSLoggerError(@"Unknown metric");
+        return 0;
+    }
+    
+    if (classNameOrNil) {
+        return [[self.classNameToRecordMap objectForKey:classNameOrNil] countForMetric:metric];
+    }
+    
+    NSUInteger count = 0;
+    for (HLSViewControllerClassRecord *record in [self.classNameToRecordMap allValues]) {
+        count += [record countForMetric:metric];
+    }
+    return count;
+}
+
+- (NSString *)report
+{
+    NSArray *classNames = [[self.classNameToRecordMap allKeys] sortedArrayUsingComparator:^NSComparisonResult(NSString *className1, NSString *className2) {
+        CFTimeInterval maximumDuration1 = [[self.classNameToRecordMap objectForKey:className1] maximumDurationForMetric:HLSViewControllerProfilerMetricInitToViewDidAppear];
+        CFTimeInterval maximumDuration2 = [[self.classNameToRecordMap objectForKey:className2] maximumDurationForMetric:HLSViewControllerProfilerMetricInitToViewDidAppear];
+        if (maximumDuration1 > maximumDuration2) {
+            return NSOrderedAscending;
+        }
+        else if (maximumDuration1 < maximumDuration2) {
+            return NSOrderedDescending;
+        }
+        else {
+            return [className1 compare:className2];
+        }
+    }];
+    
+    NSMutableString *report = [NSMutableString string];
+    [report appendFormat:@"metric: count | mean / max | histogram (times in ms, buckets < 1, 2, 4, ..., %d, then above; budget %.1f ms)\n",
+     1 << (kViewControllerProfilerNumberOfBuckets - 2), self.frameBudget * 1000.];
+    for (NSString *className in classNames) {
+        HLSViewControllerClassRecord *record = [self.classNameToRecordMap objectForKey:className];
+        [report appendFormat:@"%@ (over budget: %u viewDidLoad, %u viewWillAppear:)\n", className, record.numberOfSlowViewDidLoads,
+         record.numberOfSlowViewWillAppears];
+        for (HLSViewControllerProfilerMetric metric = HLSViewControllerProfilerMetricEnumBegin; metric < HLSViewControllerProfilerMetricEnumEnd; ++metric) {
+            if ([record countForMetric:metric] == 0) {
+                continue;
+            }
+            
+            [report appendFormat:@"    %@\n", [record reportForMetric:metric]];
+        }
+    }
+    return [NSString stringWithString:report];
+}
+
+- (void)clear
+{
+    [self.classNameToRecordMap removeAllObjects];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSViewControllerTimestamps class implementation
+
+@implementation HLSViewControllerTimestamps
+
+#pragma mark Accessors and mutators
+
+@synthesize initTime = m_initTime;
+
+@synthesize viewDidLoadTime = m_viewDidLoadTime;
+
+@end
+
+#pragma mark -
+#pragma mark HLSViewControllerClassRecord class implementation
+
+@implementation HLSViewControllerClassRecord
+
+#pragma mark Accessors and mutators
+
+@synthesize numberOfSlowViewDidLoads = m_numberOfSlowViewDidLoads;
+
+@synthesize numberOfSlowViewWillAppears = m_numberOfSlowViewWillAppears;
+
+- (NSUInteger)countForMetric:(HLSViewControllerProfilerMetric)metric
+{
+    return m_counts[metric];
+}
+
+- (CFTimeInterval)maximumDurationForMetric:(HLSViewControllerProfilerMetric)metric
+{
+    return m_maximumDurations[metric];
+}
+
+#pragma mark Recording
+
+- (void)addDuration:(CFTimeInterval)duration forMetric:(HLSViewControllerProfilerMetric)metric
+{
+    ++m_counts[metric];
+    m_totalDurations[metric] += duration;
+    m_maximumDurations[metric] = MAX(m_maximumDurations[metric], duration);
+    
+    NSUInteger bucket = 0;
+    while (bucket < kViewControllerProfilerNumberOfBuckets - 1 && duration * 1000. >= (1 << bucket)) {
+        ++bucket;
+    }
+    ++m_buckets[metric][bucket];
+}
+
+#pragma mark Reporting
+
+- (NSString *)reportForMetric:(HLSViewControllerProfilerMetric)metric
+{
+    NSMutableArray *bucketCounts = [NSMutableArray array];
+    for (NSUInteger bucket = 0; bucket < kViewControllerProfilerNumberOfBuckets; ++bucket) {
+        [bucketCounts addObject:[NSString stringWithFormat:@"%u", m_buckets[metric][bucket]]];
+    }
+    
+    return [NSString stringWithFormat:@"%@: %u | %.1f / %.1f | %@",
+            kViewControllerProfilerMetricNames[metric],
+            m_counts[metric],
+            m_totalDurations[metric] / m_counts[metric] * 1000.,
+            m_maximumDurations[metric] * 1000.,
+            [bucketCounts componentsJoinedByString:@" "]];
+}
+
+@end
+
+#pragma mark -
+#pragma mark Static functions
+
+static HLSViewControllerPendingCall *pendingCallForViewController(UIViewController *viewController, HLSViewControllerLifeCyclePhase lifeCyclePhase)
+{
+    for (NSUInteger i = s_numberOfPendingCalls; i > 0; --i) {
+        HLSViewControllerPendingCall *pendingCall = &s_pendingCalls[i - 1];
+        if (pendingCall->viewController == viewController && pendingCall->lifeCyclePhase == lifeCyclePhase) {
+            return pendingCall;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * The lifecycle methods of UIViewController are called by subclass implementations only when they call super, which
+ * usually happens first. To measure the whole time spent in a lifecycle method, the implementation of the most derived
+ * class of the hierarchy of a view controller is instrumented as well, once per class
+ */
+static void instrumentLifeCycleMethodsForViewController(UIViewController *viewController)
+{
+    if (! s_instrumentedClasses) {
+        s_instrumentedClasses = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+        s_instrumentedMethods = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+    }
+    
+    Class clazz = object_getClass(viewController);
+    if (CFSetContainsValue(s_instrumentedClasses, clazz)) {
+        return;
+    }
+    CFSetAddValue(s_instrumentedClasses, clazz);
+    
+    instrumentLifeCycleMethod(clazz, @selector(viewDidLoad), HLSViewControllerLifeCyclePhaseViewDidLoad);
+    instrumentLifeCycleMethod(clazz, @selector(viewWillAppear:), HLSViewControllerLifeCyclePhaseViewWillAppear);
+    instrumentLifeCycleMethod(clazz, @selector(viewDidAppear:), HLSViewControllerLifeCyclePhaseViewDidAppear);
+}
+
+static void instrumentLifeCycleMethod(Class clazz, SEL selector, HLSViewControllerLifeCyclePhase lifeCyclePhase)
+{
+    // Find the class which implements the method called first
+    Method method = class_getInstanceMethod(clazz, selector);
+    Class implementingClass = clazz;
+    while (implementingClass != [UIViewController class]
+           && class_getInstanceMethod(class_getSuperclass(implementingClass), selector) == method) {
+        implementingClass = class_getSuperclass(implementingClass);
+    }
+    
+    // Calls to UIViewController implementations are already notified by UIViewController+HLSExtensions
+    if (implementingClass == [UIViewController class] || CFSetContainsValue(s_instrumentedMethods, method)) {
+        return;
+    }
+    CFSetAddValue(s_instrumentedMethods, method);
+    
+    HLSViewControllerProfiler *viewControllerProfiler = [HLSViewControllerProfiler sharedViewControllerProfiler];
+    IMP originalImplementation = method_getImplementation(method);
+    IMP newImplementation = NULL;
+    if (lifeCyclePhase == HLSViewControllerLifeCyclePhaseViewDidLoad) {
+        newImplementation = imp_implementationWithBlock((void *)^(UIViewController *viewController) {
+            [viewControllerProfiler viewController:viewController willEnterLifeCyclePhase:lifeCyclePhase];
+            ((void (*)(id, SEL))originalImplementation)(viewController, selector);
+            [viewControllerProfiler viewController:viewController didEnterLifeCyclePhase:lifeCyclePhase];
+        });
+    }
+    else {
+        newImplementation = imp_implementationWithBlock((void *)^(UIViewController *viewController, BOOL animated) {
+            [viewControllerProfiler viewController:viewController willEnterLifeCyclePhase:lifeCyclePhase];
+            ((void (*)(id, SEL, BOOL))originalImplementation)(viewController, selector, animated);
+            [viewControllerProfiler viewController:viewController didEnterLifeCyclePhase:lifeCyclePhase];
+        });
+    }
+    method_setImplementation(method, newImplementation);
+}
@@ -0,0 +1,23 @@
+//
+//  HLSViewMemoryCoordinator+Friend.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSViewMemoryCoordinator.h"
+
+/**
+ * Interface meant to be used by friend classes of HLSViewMemoryCoordinator (= classes which must have access to private
+ * implementation details)
+ */
+@interface HLSViewMemoryCoordinator (Friend)
+
+/**
+ * Must be called when a view controller view has disappeared, respectively when a view controller is deallocated
+ */
+- (void)viewControllerDidDisappear:(UIViewController *)viewController;
+- (void)viewControllerWillBeDeallocated:(UIViewController *)viewController;
+
+@end
@@ -0,0 +1,105 @@
+//
+//  HLSViewMemoryCoordinator.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSMemoryAccountant.h"
+
+// Forward declarations
+@protocol HLSViewMemoryContainer;
+
+/**
+ * Coordinates the unloading of the views of the view controllers managed by containers when the application receives
+ * a memory warning. Instead of each container unloading all views it does not display, the coordinator collects the
+ * views which can be unloaded across all containers and unloads them in order of priority until the estimated memory
+ * used by the remaining ones (see -[CALayer estimatedMemoryCost]) fits into the target memory cost. Views are unloaded
+ * starting with the least recently visible ones (as recorded while the coordinator is enabled), the largest first
+ * among views which have never been visible or disappeared at the same time.
+ *
+ * Containers are:
+ *   - the HLSContainerStack objects, and the CoconutKit containers built on them (HLSStackController,
+ *     HLSPlaceholderViewController, HLSWizardViewController), which register automatically
+ *   - the UITabBarController and UISplitViewController objects reachable from the root view controllers of the
+ *     application windows (through their children and modal view controllers)
+ *   - any object implementing the HLSViewMemoryContainer protocol which has been registered with the coordinator
+ * Unloaded views are reloaded by their containers when they are needed again. When the coordinator is enabled,
+ * container stacks do not unload their views on their own when a memory warning is received
+ *
+ * While enabled, the coordinator is registered with the memory accountant (see HLSMemoryAccountant), which reports
+ * the estimated memory cost of the views which can be unloaded. When automatic purging is enabled, views are then
+ * unloaded by the accountant, after the caches which have a lower purge priority have been purged
+ *
+ * The coordinator must only be used from the main thread
+ *
+ * Designated initializer: -init (but use the +sharedViewMemoryCoordinator singleton)
+ */
+@interface HLSViewMemoryCoordinator : NSObject <HLSMemoryAccounting> {
+@private
+    CFMutableArrayRef m_containers;                                 // registered containers (not retained)
+    CFMutableDictionaryRef m_viewControllerToDisappearanceTimeMap;  // maps a view controller (pointer) to the time it last disappeared
+    NSUInteger m_targetMemoryCost;
+    BOOL m_enabled;
+}
+
+/**
+ * The coordinator singleton
+ */
++ (HLSViewMemoryCoordinator *)sharedViewMemoryCoordinator;
+
+/**
+ * Set to YES to have memory warnings handled by the coordinator
+ *
+ * Default value is NO
+ */
+@property (nonatomic, assign, getter=isEnabled) BOOL enabled;
+
+/**
+ * The estimated memory cost (in bytes) of the views which are not displayed, but which can be kept after a memory
+ * warning has been received
+ *
+ * Default value is 0 (all views which are not displayed are unloaded)
+ */
+@property (nonatomic, assign) NSUInteger targetMemoryCost;
+
+/**
+ * Register or unregister a container. Containers are not retained and must therefore be unregistered before they are
+ * deallocated
+ */
+- (void)registerContainer:(id<HLSViewMemoryContainer>)container;
+- (void)unregisterContainer:(id<HLSViewMemoryContainer>)container;
+
+/**
+ * Unload views until the estimated cost of the views which are not displayed fits into the target memory cost. This
+ * method is called when a memory warning is received (if the coordinator is enabled), but you can call it at any
+ * time, even if the coordinator is disabled. Return the estimated memory cost of the views which have been unloaded
+ */
+- (NSUInteger)unloadViews;
+
+@end
+
+/**
+ * Protocol to be implemented by containers managing child view controllers, so that their views can be unloaded
+ * by the coordinator
+ */
+@protocol HLSViewMemoryContainer <NSObject>
+
+/**
+ * The child view controllers managed by the container
+ */
+- (NSArray *)viewControllers;
+
+/**
+ * Return YES iff the view of a child view controller is loaded and can be unloaded right now (in general because
+ * it is not displayed)
+ */
+- (BOOL)canUnloadViewOfViewController:(UIViewController *)viewController;
+
+/**
+ * Unload the view of a child view controller
+ */
+- (void)unloadViewOfViewController:(UIViewController *)viewController;
+
+@end
@@ -0,0 +1,333 @@
+//
+//  HLSViewMemoryCoordinator.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "HLSViewMemoryCoordinator.h"
+
+#import <QuartzCore/QuartzCore.h>
+#import "CALayer+HLSExtensions.h"
+#import "HLSLogger.h"
+#import "HLSViewMemoryCoordinator+Friend.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
+
+#pragma mark -
+#pragma mark HLSUnloadableView class interface
+
+/**
+ * A view which can be unloaded by a container
+ */
+@interface HLSUnloadableView : NSObject {
+@private
+    id<HLSViewMemoryContainer> m_container;
+    UIViewController *m_viewController;
+    NSUInteger m_memoryCost;
+    CFTimeInterval m_disappearanceTime;
+}
+
+@property (nonatomic, assign) id<HLSViewMemoryContainer> container;
+@property (nonatomic, assign) UIViewController *viewController;
+@property (nonatomic, assign) NSUInteger memoryCost;
+@property (nonatomic, assign) CFTimeInterval disappearanceTime;
+
+@end
+
+#pragma mark -
+#pragma mark HLSViewMemoryCoordinator class
+
+@interface HLSViewMemoryCoordinator ()
+
+- (NSArray *)containers;
+- (NSArray *)unloadableViews;
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification;
+
+@end
+
+@implementation HLSViewMemoryCoordinator
+
+#pragma mark Class methods
+
++ (HLSViewMemoryCoordinator *)sharedViewMemoryCoordinator
+{
+    static HLSViewMemoryCoordinator *s_instance = nil;
+    
+    if (! s_instance) {
+        s_instance = [[HLSViewMemoryCoordinator alloc] init];
+    }
+    return s_instance;
+}
+
+#pragma mark Object creation and destruction
+
+- (id)init
+{
+    if ((self = [super init])) {
+        // Containers and view controllers are not retained
+        m_containers = CFArrayCreateMutable(kCFAllocatorDefault, 0, NULL);
+        m_viewControllerToDisappearanceTimeMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    self.enabled = NO;
+    
+    CFRelease(m_containers);
+    CFRelease(m_viewControllerToDisappearanceTimeMap);
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+@synthesize enabled = m_enabled;
+
+- (void)setEnabled:(BOOL)enabled
+{
+    if (enabled == m_enabled) {
+        return;
+    }
+    
+    if (enabled) {
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(applicationDidReceiveMemoryWarning:)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+        [[HLSMemoryAccountant sharedMemoryAccountant] registerSubsystem:self
+                                                               withName:@"Container views"
+                                                          purgePriority:HLSMemoryPurgePriorityViewMemoryCoordinator];
+    }
+    else {
+        [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                        name:UIApplicationDidReceiveMemoryWarningNotification
+                                                      object:nil];
+        [[HLSMemoryAccountant sharedMemoryAccountant] unregisterSubsystem:self];
+    }
+    
+    m_enabled = enabled;
+}
+
+@synthesize targetMemoryCost = m_targetMemoryCost;
+
+#pragma mark Registering containers
+
+- (void)registerContainer:(id<HLSViewMemoryContainer>)container
+{
+    if (! container) {
+        HLSLoggerError(@"Missing container");
+        return;
+    }
+    
+    if (CFArrayContainsValue(m_containers, CFRangeMake(0, CFArrayGetCount(m_containers)), container)) {
+        return;
+    }
+    
+    CFArrayAppendValue(m_containers, container);
+}
+
+- (void)unregisterContainer:(id<HLSViewMemoryContainer>)container
+{
+    CFIndex index = CFArrayGetFirstIndexOfValue(m_containers, CFRangeMake(0, CFArrayGetCount(m_containers)), container);
+    if (index == kCFNotFound) {
+        return;
+    }
+    
+    CFArrayRemoveValueAtIndex(m_containers, index);
+}
+
+/**
+ * Return the registered containers, as well as the containers found in the view controller hierarchies of the
+ * application windows and of the registered containers
+ */
+- (NSArray *)containers
+{
+    NSMutableArray *containers = [NSMutableArray arrayWithArray:(NSArray *)m_containers];
+    
+    NSMutableArray *pendingViewControllers = [NSMutableArray array];
+    for (UIWindow *window in [UIApplication sharedApplication].windows) {
+        if (window.rootViewController) {
+            [pendingViewControllers addObject:window.rootViewController];
+        }
+    }
+    for (id<HLSViewMemoryContainer> container in containers) {
+        [pendingViewControllers addObjectsFromArray:[container viewControllers]];
+    }
+    
+    // View controllers are not retained
+    CFMutableSetRef visitedViewControllers = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+    while ([pendingViewControllers count] != 0) {
+        UIViewController *viewController = [pendingViewControllers lastObject];
+        [pendingViewControllers removeLastObject];
+        
+        if (CFSetContainsValue(visitedViewControllers, viewController)) {
+            continue;
+        }
+        CFSetAddValue(visitedViewControllers, viewController);
+        
+        if ([viewController conformsToProtocol:@protocol(HLSViewMemoryContainer)]) {
+            id<HLSViewMemoryContainer> container = (id<HLSViewMemoryContainer>)viewController;
+            if (! [containers containsObject:container]) {
+                [containers addObject:container];
+            }
+            [pendingViewControllers addObjectsFromArray:[container viewControllers]];
+        }
+        else if ([viewController isKindOfClass:[UINavigationController class]]) {
+            [pendingViewControllers addObjectsFromArray:((UINavigationController *)viewController).viewControllers];
+        }
+        
+        if (viewController.modalViewController) {
+            [pendingViewControllers addObject:viewController.modalViewController];
+        }
+    }
+    CFRelease(visitedViewControllers);
+    
+    return [NSArray arrayWithArray:containers];
+}
+
+#pragma mark Unloading views
+
+// Return the views which can currently be unloaded (HLSUnloadableView objects)
+- (NSArray *)unloadableViews
+{
+    NSMutableArray *unloadableViews = [NSMutableArray array];
+    for (id<HLSViewMemoryContainer> container in [self containers]) {
+        for (UIViewController *viewController in [container viewControllers]) {
+            if (! [container canUnloadViewOfViewController:viewController]) {
+                continue;
+            }
+            
+            NSNumber *disappearanceTime = (NSNumber *)CFDictionaryGetValue(m_viewControllerToDisappearanceTimeMap, viewController);
+            
+            HLSUnloadableView *unloadableView = [[[HLSUnloadableView alloc] init] autorelease];
+            unloadableView.container = container;
+            unloadableView.viewController = viewController;
+            unloadableView.memoryCost = [viewController.view.layer estimatedMemoryCost];
+            unloadableView.disappearanceTime = [disappearanceTime doubleValue];
+            [unloadableViews addObject:unloadableView];
+        }
+    }
+    return [NSArray arrayWithArray:unloadableViews];
+}
+
+- (NSUInteger)unloadViews
+{
+    NSMutableArray *unloadableViews = [NSMutableArray arrayWithArray:[self unloadableViews]];
+    NSUInteger totalMemoryCost = 0;
+    for (HLSUnloadableView *unloadableView in unloadableViews) {
+        totalMemoryCost += unloadableView.memoryCost;
+    }
+    
+    // Least recently visible first, then largest first
+    [unloadableViews sortUsingComparator:^NSComparisonResult(HLSUnloadableView *unloadableView1, HLSUnloadableView *unloadableView2) {
+        if (unloadableView1.disappearanceTime < unloadableView2.disappearanceTime) {
+            return NSOrderedAscending;
+        }
+        else if (unloadableView1.disappearanceTime > unloadableView2.disappearanceTime) {
+            return NSOrderedDescending;
+        }
+        else if (unloadableView1.memoryCost > unloadableView2.memoryCost) {
+            return NSOrderedAscending;
+        }
+        else if (unloadableView1.memoryCost < unloadableView2.memoryCost) {
+            return NSOrderedDescending;
+        }
+        else {
+            return NSOrderedSame;
+        }
+    }];
+    
+    NSUInteger unloadedMemoryCost = 0;
+    for (HLSUnloadableView *unloadableView in unloadableViews) {
+        if (totalMemoryCost <= self.targetMemoryCost) {
+            break;
+        }
+        
+        totalMemoryCost -= unloadableView.memoryCost;
+        
+        // The view might already have been unloaded with the view of a parent container
+        if (! [unloadableView.container canUnloadViewOfViewController:unloadableView.viewController]) {
+            continue;
+        }
+        
+        HLSLoggerDebug(@"Unloading the view of %@ (%u bytes)", unloadableView.viewController, unloadableView.memoryCost);
+        [unloadableView.container unloadViewOfViewController:unloadableView.viewController];
+        unloadedMemoryCost += unloadableView.memoryCost;
+    }
+    
+    HLSLoggerInfo(@"Unloaded views for an estimated %u bytes", unloadedMemoryCost);
+    return unloadedMemoryCost;
+}
+
+#pragma mark Recording
+
+- (void)viewControllerDidDisappear:(UIViewController *)viewController
+{
+    if (! self.enabled || ! [NSThread isMainThread]) {
+        return;
+    }
+    
+    CFDictionarySetValue(m_viewControllerToDisappearanceTimeMap, viewController, [NSNumber numberWithDouble:CACurrentMediaTime()]);
+}
+
+- (void)viewControllerWillBeDeallocated:(UIViewController *)viewController
+{
+    if (! [NSThread isMainThread]) {
+        return;
+    }
+    
+    CFDictionaryRemoveValue(m_viewControllerToDisappearanceTimeMap, viewController);
+}
+
+#pragma mark HLSMemoryAccounting protocol implementation
+
+- (NSUInteger)memoryFootprint
+{
+    NSUInteger memoryFootprint = 0;
+    for (HLSUnloadableView *unloadableView in [self unloadableViews]) {
+        memoryFootprint += unloadableView.memoryCost;
+    }
+    return memoryFootprint;
+}
+
+- (NSUInteger)purgeMemory
+{
+    return [self unloadViews];
+}
+
+#pragma mark Notification callbacks
+
+- (void)applicationDidReceiveMemoryWarning:(NSNotification *)notification
+{
+    // Unloaded by the accountant in order of priority
+    if ([[HLSMemoryAccountant sharedMemoryAccountant] isManagingSubsystem:self]) {
+        return;
+    }
+    
+    [self unloadViews];
+}
+
+@end
+
+#pragma mark -
+#pragma mark HLSUnloadableView class implementation
+
+@implementation HLSUnloadableView
+
+#pragma mark Accessors and mutators
+
+@synthesize container = m_container;
+
+@synthesize viewController = m_viewController;
+
+@synthesize memoryCost = m_memoryCost;
+
+@synthesize disappearanceTime = m_disappearanceTime;
+
+@end
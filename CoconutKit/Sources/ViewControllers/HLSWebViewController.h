@@ -11,6 +11,9 @@
 /**
  * A web browser with standard features (navigation buttons, link sharing, etc.)
  *
+ * The web view is obtained from the HLSWebViewPool when the view is loaded, and returned to it when the view is
+ * released
+ *
  * Designated initializer: -initWithRequest:
  */
 @interface HLSWebViewController : HLSViewController <MFMailComposeViewControllerDelegate, UIWebViewDelegate> {
@@ -18,6 +21,7 @@
     NSURLRequest *m_request;
     NSURL *m_currentURL;
     UIWebView *m_webView;
+    UIView *m_webViewPlaceholderView;
     UIToolbar *m_toolbar;
     UIBarButtonItem *m_goBackBarButtonItem;
     UIBarButtonItem *m_goForwardBarButtonItem;
@@ -40,7 +44,8 @@
 /**
  * View outlets. Do not change
  */
-@property (nonatomic, retain) IBOutlet UIWebView *webView;
+@property (nonatomic, retain) UIWebView *webView;
+@property (nonatomic, retain) IBOutlet UIView *webViewPlaceholderView;
 @property (nonatomic, retain) IBOutlet UIToolbar *toolbar;
 @property (nonatomic, retain) IBOutlet UIBarButtonItem *goBackBarButtonItem;
 @property (nonatomic, retain) IBOutlet UIBarButtonItem *goForwardBarButtonItem;
@@ -11,6 +11,7 @@
 #import "HLSActionSheet.h"
 #import "HLSAutorotation.h"
 #import "HLSNotifications.h"
+#import "HLSWebViewPool.h"
 #import "NSBundle+HLSDynamicLocalization.h"
 #import "NSBundle+HLSExtensions.h"
 #import "NSError+HLSExtensions.h"
@@ -58,7 +59,10 @@
 {
     [super releaseViews];
     
+    [[HLSWebViewPool sharedWebViewPool] recycleWebView:self.webView];
+    
     self.webView = nil;
+    self.webViewPlaceholderView = nil;
     self.toolbar = nil;
     self.goBackBarButtonItem = nil;
     self.goForwardBarButtonItem = nil;
@@ -76,6 +80,8 @@
 
 @synthesize webView = m_webView;
 
+@synthesize webViewPlaceholderView = m_webViewPlaceholderView;
+
 @synthesize toolbar = m_toolbar;
 
 @synthesize goBackBarButtonItem = m_goBackBarButtonItem;
@@ -96,6 +102,19 @@
 {
     [super viewDidLoad];
     
+    // The nib only contains a placeholder, replaced with a web view from the pool
+    UIWebView *webView = [[HLSWebViewPool sharedWebViewPool] dequeueWebView];
+    webView.frame = self.webViewPlaceholderView.frame;
+    webView.autoresizingMask = self.webViewPlaceholderView.autoresizingMask;
+    webView.backgroundColor = self.webViewPlaceholderView.backgroundColor;
+    webView.multipleTouchEnabled = YES;
+    webView.scalesPageToFit = YES;
+    webView.dataDetectorTypes = UIDataDetectorTypePhoneNumber;
+    [self.view insertSubview:webView aboveSubview:self.webViewPlaceholderView];
+    [self.webViewPlaceholderView removeFromSuperview];
+    self.webViewPlaceholderView = nil;
+    self.webView = webView;
+    
     self.refreshImage = self.refreshBarButtonItem.image;
     
     // Start with the initial URL when the view gets (re)loaded
@@ -9,6 +9,7 @@
 #import "HLSPlaceholderViewController.h"
 
 // Forward declarations
+@protocol HLSWizardViewControllerDataSource;
 @protocol HLSWizardViewControllerDelegate;
 
 typedef enum {
@@ -38,6 +39,12 @@ typedef enum {
  * when clicking on the "done" button. If the page does not implement this protocol, the page is
  * always assumed to be valid.
  *
+ * Pages can either be provided all at once using the viewControllers property, or on demand by a data source. In
+ * the latter case, only the view controllers of the current page and of its neighbors are kept alive. Other ones 
+ * are released (as are neighbors when a memory warning is received), and requested again when needed. If a page
+ * needs to preserve some state when it is released, the data source is responsible of storing it, or of keeping
+ * the view controller alive itself.
+ *
  * Designated initializer: -initWithNibName:bundle:
  */
 @interface HLSWizardViewController : HLSPlaceholderViewController {
@@ -46,6 +53,8 @@ typedef enum {
     UIButton *m_nextButton;
     UIButton *m_doneButton;
     NSArray *m_viewControllers;
+    id<HLSWizardViewControllerDataSource> m_dataSource;
+    NSMutableDictionary *m_pageToViewControllerMap;
     HLSWizardTransitionStyle m_wizardTransitionStyle;
     NSInteger m_currentPage;
 }
@@ -63,6 +72,17 @@ typedef enum {
  */
 @property (nonatomic, retain) NSArray *viewControllers;
 
+/**
+ * The data source providing page view controllers on demand. If set, the viewControllers property is ignored. Setting
+ * a data source starts the wizard with the first page
+ */
+@property (nonatomic, assign) IBOutlet id<HLSWizardViewControllerDataSource> dataSource;
+
+/**
+ * Release all page view controllers obtained from the data source and start again with the first page
+ */
+- (void)reloadPages;
+
 /**
  * The transition style to use when changing pages. Default is HLSWizardTransitionStyleNone
  */
@@ -75,6 +95,22 @@ typedef enum {
 
 @end
 
+@protocol HLSWizardViewControllerDataSource <NSObject>
+@required
+
+/**
+ * The number of pages in the wizard
+ */
+- (NSInteger)numberOfPagesInWizardViewController:(HLSWizardViewController *)wizardViewController;
+
+/**
+ * The view controller to display for a given page. This method is called when the page is needed, and again each
+ * time the page is needed after it has been released
+ */
+- (UIViewController *)wizardViewController:(HLSWizardViewController *)wizardViewController viewControllerForPage:(NSInteger)page;
+
+@end
+
 @protocol HLSWizardViewControllerDelegate <HLSPlaceholderViewControllerDelegate>
 @optional
 
@@ -20,6 +20,11 @@ static const NSInteger kWizardViewControllerNoPage = -1;
 - (void)hlsWizardViewControllerInit;
 
 @property (nonatomic, assign) NSInteger currentPage;
+@property (nonatomic, retain) NSMutableDictionary *pageToViewControllerMap;
+
+- (NSInteger)numberOfPages;
+- (UIViewController *)viewControllerForPage:(NSInteger)page;
+- (void)releasePageViewControllersExceptForPages:(NSRange)pageRange;
 
 - (void)refreshWizardInterface;
 
@@ -56,11 +61,14 @@ static const NSInteger kWizardViewControllerNoPage = -1;
 {
     m_currentPage = kWizardViewControllerNoPage;
     m_wizardTransitionStyle = HLSWizardTransitionStyleNone;
+    self.pageToViewControllerMap = [NSMutableDictionary dictionary];
 }
 
 - (void)dealloc
 {
     self.viewControllers = nil;
+    self.pageToViewControllerMap = nil;
+    self.dataSource = nil;
     self.delegate = nil;
     [super dealloc];
 }
@@ -74,6 +82,21 @@ static const NSInteger kWizardViewControllerNoPage = -1;
     self.doneButton = nil;
 }
 
+#pragma mark Memory warnings
+
+- (void)didReceiveMemoryWarning
+{
+    [super didReceiveMemoryWarning];
+    
+    // Only keep the page currently displayed
+    if (self.currentPage != kWizardViewControllerNoPage) {
+        [self releasePageViewControllersExceptForPages:NSMakeRange(self.currentPage, 1)];
+    }
+    else {
+        [self.pageToViewControllerMap removeAllObjects];
+    }
+}
+
 #pragma mark View lifecycle management
 
 - (void)viewDidLoad
@@ -122,6 +145,23 @@ static const NSInteger kWizardViewControllerNoPage = -1;
     }    
 }
 
+@synthesize dataSource = m_dataSource;
+
+- (void)setDataSource:(id<HLSWizardViewControllerDataSource>)dataSource
+{
+    if (m_dataSource == dataSource) {
+        return;
+    }
+    
+    m_dataSource = dataSource;
+    
+    if (dataSource) {
+        [self reloadPages];
+    }
+}
+
+@synthesize pageToViewControllerMap = m_pageToViewControllerMap;
+
 @synthesize wizardTransitionStyle = m_wizardTransitionStyle;
 
 @synthesize currentPage = m_currentPage;
@@ -144,8 +184,8 @@ static const NSInteger kWizardViewControllerNoPage = -1;
     }
     
     // Sanitize input
-    if (currentPage < 0 || currentPage >= [self.viewControllers count]) {
-        HLSLoggerError(@"Incorrect page number %d, must lie between 0 and %d", currentPage, [self.viewControllers count]);
+    if (currentPage < 0 || currentPage >= [self numberOfPages]) {
+        HLSLoggerError(@"Incorrect page number %d, must lie between 0 and %d", currentPage, [self numberOfPages]);
         return;
     }
     
@@ -180,8 +220,64 @@ static const NSInteger kWizardViewControllerNoPage = -1;
     }
     
     // Display the current page
-    UIViewController *viewController = [self.viewControllers objectAtIndex:m_currentPage];
+    UIViewController *viewController = [self viewControllerForPage:m_currentPage];
     [self setInsetViewController:viewController atIndex:0 withTransitionClass:transitionClass];
+    
+    // Only keep the current page and its neighbors alive (the page we are leaving is retained by the placeholder
+    // view controller until the transition ends)
+    NSInteger firstKeptPage = MAX(m_currentPage - 1, 0);
+    [self releasePageViewControllersExceptForPages:NSMakeRange(firstKeptPage, m_currentPage + 2 - firstKeptPage)];
+}
+
+#pragma mark Pages
+
+- (NSInteger)numberOfPages
+{
+    if (self.dataSource) {
+        return [self.dataSource numberOfPagesInWizardViewController:self];
+    }
+    else {
+        return [self.viewControllers count];
+    }
+}
+
+- (UIViewController *)viewControllerForPage:(NSInteger)page
+{
+    if (! self.dataSource) {
+        return [self.viewControllers objectAtIndex:page];
+    }
+    
+    NSNumber *pageNumber = [NSNumber numberWithInteger:page];
+    UIViewController *viewController = [self.pageToViewControllerMap objectForKey:pageNumber];
+    if (! viewController) {
+        viewController = [self.dataSource wizardViewController:self viewControllerForPage:page];
+        NSAssert(viewController != nil, @"The data source must provide a view controller for each page");
+        [self.pageToViewControllerMap setObject:viewController forKey:pageNumber];
+    }
+    return viewController;
+}
+
+- (void)releasePageViewControllersExceptForPages:(NSRange)pageRange
+{
+    for (NSNumber *pageNumber in [self.pageToViewControllerMap allKeys]) {
+        if (! NSLocationInRange([pageNumber integerValue], pageRange)) {
+            [self.pageToViewControllerMap removeObjectForKey:pageNumber];
+        }
+    }
+}
+
+- (void)reloadPages
+{
+    [self.pageToViewControllerMap removeAllObjects];
+    
+    // Start again with the first page
+    m_currentPage = kWizardViewControllerNoPage;
+    if ([self numberOfPages] > 0) {
+        self.currentPage = 0;
+    }
+    else {
+        [self refreshWizardInterface];
+    }
 }
 
 #pragma mark Refreshing the UI
@@ -199,13 +295,13 @@ static const NSInteger kWizardViewControllerNoPage = -1;
     }
     
     // Sanitize input
-    if (self.currentPage < 0 || self.currentPage >= [self.viewControllers count]) {
-        HLSLoggerError(@"Incorrect page number %d, must lie between 0 and %d", self.currentPage, [self.viewControllers count]);
+    if (self.currentPage < 0 || self.currentPage >= [self numberOfPages]) {
+        HLSLoggerError(@"Incorrect page number %d, must lie between 0 and %d", self.currentPage, [self numberOfPages]);
         return;
     }
     
     // Done button on last page only
-    if (self.currentPage == [self.viewControllers count] - 1) {
+    if (self.currentPage == [self numberOfPages] - 1) {
         self.doneButton.hidden = NO;
     }
     else {
@@ -221,7 +317,7 @@ static const NSInteger kWizardViewControllerNoPage = -1;
     }
     
     // Next button on all but the last page
-    if (self.currentPage < [self.viewControllers count] - 1) {
+    if (self.currentPage < [self numberOfPages] - 1) {
         self.nextButton.hidden = NO;
     }
     else {
@@ -234,13 +330,13 @@ static const NSInteger kWizardViewControllerNoPage = -1;
 - (BOOL)validatePage:(NSInteger)page
 {
     // Sanitize input (deals with the "no page" case)
-    if (page < 0 || page >= [self.viewControllers count]) {
-        HLSLoggerError(@"Incorrect page number %d, must lie between 0 and %d", page, [self.viewControllers count]);
+    if (page < 0 || page >= [self numberOfPages]) {
+        HLSLoggerError(@"Incorrect page number %d, must lie between 0 and %d", page, [self numberOfPages]);
         return YES;
     }
     
     // Validate the current page if it implements a validation mechanism
-    UIViewController *viewController = [self.viewControllers objectAtIndex:page];
+    UIViewController *viewController = [self viewControllerForPage:page];
     if ([viewController conformsToProtocol:@protocol(HLSValidable)]) {
         return [(UIViewController<HLSValidable>*)viewController validate];
     }
@@ -253,8 +349,8 @@ static const NSInteger kWizardViewControllerNoPage = -1;
 - (void)moveToPage:(NSInteger)page
 {
     // Sanitize input
-    if (page < 0 || page >= [self.viewControllers count]) {
-        HLSLoggerError(@"Incorrect page number %d, must lie between 0 and %d", page, [self.viewControllers count]);
+    if (page < 0 || page >= [self numberOfPages]) {
+        HLSLoggerError(@"Incorrect page number %d, must lie between 0 and %d", page, [self numberOfPages]);
         return;
     }
     
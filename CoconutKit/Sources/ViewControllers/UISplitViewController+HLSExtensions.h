@@ -7,8 +7,9 @@
 //
 
 #import "HLSAutorotation.h"
+#import "HLSViewMemoryCoordinator.h"
 
-@interface UISplitViewController (HLSExtensions)
+@interface UISplitViewController (HLSExtensions) <HLSViewMemoryContainer>
 
 /**
  * Set how a split view controller decides whether it must rotate or not
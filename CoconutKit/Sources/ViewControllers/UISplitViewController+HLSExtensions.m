@@ -10,6 +10,7 @@
 
 #import "HLSAutorotationCompatibility.h"
 #import "HLSRuntime.h"
+#import "UIViewController+HLSExtensions.h"
 
 // Associated object keys
 static void *s_autorotationModeKey = &s_autorotationModeKey;
@@ -62,6 +63,21 @@ static BOOL swizzled_UISplitViewController__shouldAutorotateToInterfaceOrientati
     objc_setAssociatedObject(self, s_autorotationModeKey, [NSNumber numberWithInteger:autorotationMode], OBJC_ASSOCIATION_RETAIN_NONATOMIC);
 }
 
+#pragma mark HLSViewMemoryContainer protocol implementation
+
+- (BOOL)canUnloadViewOfViewController:(UIViewController *)viewController
+{
+    // In portrait orientation, the master view is only displayed in a popover
+    return [self.viewControllers containsObject:viewController]
+        && [viewController isViewLoaded]
+        && ! [viewController viewIfLoaded].window;
+}
+
+- (void)unloadViewOfViewController:(UIViewController *)viewController
+{
+    [viewController unloadViews];
+}
+
 @end
 
 // Swizzled on iOS 6 only, never called on iOS 4 and 5
@@ -7,8 +7,16 @@
 //
 
 #import "HLSAutorotation.h"
+#import "HLSViewMemoryCoordinator.h"
 
-@interface UITabBarController (HLSExtensions)
+// Types
+typedef UIViewController * (^HLSTabViewControllerCreationBlock)(void);
+
+/**
+ * Orientation queries and the memory warning handling of a tab bar controller never load the views of its child view
+ * controllers. To avoid creating children which might never be displayed, use +lazyTabViewControllerWithTabBarItem:creationBlock:
+ */
+@interface UITabBarController (HLSExtensions) <HLSViewMemoryContainer>
 
 /**
  * Set how a tab bar controller decides whether it must rotate or not
@@ -25,4 +33,20 @@
  */
 @property (nonatomic, assign) HLSAutorotationMode autorotationMode;
 
+/**
+ * Return a view controller which can be added to the view controllers of a tab bar controller in place of a child view
+ * controller whose creation is deferred until its tab is selected for the first time. The tab is displayed using the
+ * tab bar item provided, and the child view controller is created by calling the block when the tab is about to appear.
+ * The child view controller is then displayed by the returned view controller, which also forwards orientation queries
+ * to it once it has been created
+ */
++ (UIViewController *)lazyTabViewControllerWithTabBarItem:(UITabBarItem *)tabBarItem
+                                            creationBlock:(HLSTabViewControllerCreationBlock)creationBlock;
+
+/**
+ * Return the view controller displayed by the tab at the given index. For a tab created using +lazyTabViewControllerWithTabBarItem:creationBlock:,
+ * this is the child view controller created by the block, or nil if the tab has never been selected
+ */
+- (UIViewController *)contentViewControllerAtIndex:(NSUInteger)index;
+
 @end
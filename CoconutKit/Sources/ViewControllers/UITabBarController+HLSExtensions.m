@@ -9,7 +9,30 @@
 #import "UITabBarController+HLSExtensions.h"
 
 #import "HLSAutorotationCompatibility.h"
+#import "HLSLogger.h"
+#import "HLSPlaceholderViewController.h"
 #import "HLSRuntime.h"
+#import "UIViewController+HLSExtensions.h"
+
+#pragma mark -
+#pragma mark HLSLazyTabViewController class interface
+
+/**
+ * A placeholder view controller creating its inset view controller when it is about to appear for the first time
+ */
+@interface HLSLazyTabViewController : HLSPlaceholderViewController {
+@private
+    HLSTabViewControllerCreationBlock m_creationBlock;
+}
+
+- (id)initWithTabBarItem:(UITabBarItem *)tabBarItem creationBlock:(HLSTabViewControllerCreationBlock)creationBlock;
+
+- (UIViewController *)contentViewController;
+
+@end
+
+#pragma mark -
+#pragma mark UITabBarController (HLSExtensions) category implementation
 
 // Associated object keys
 static void *s_autorotationModeKey = &s_autorotationModeKey;
@@ -44,6 +67,12 @@ static BOOL swizzled_UITabBarController__shouldAutorotateToInterfaceOrientation_
                                                                                                                         (IMP)swizzled_UITabBarController__shouldAutorotateToInterfaceOrientation_Imp);
 }
 
++ (UIViewController *)lazyTabViewControllerWithTabBarItem:(UITabBarItem *)tabBarItem
+                                            creationBlock:(HLSTabViewControllerCreationBlock)creationBlock
+{
+    return [[[HLSLazyTabViewController alloc] initWithTabBarItem:tabBarItem creationBlock:creationBlock] autorelease];
+}
+
 #pragma mark Accessors and mutators
 
 - (HLSAutorotationMode)autorotationMode
@@ -62,6 +91,40 @@ static BOOL swizzled_UITabBarController__shouldAutorotateToInterfaceOrientation_
     objc_setAssociatedObject(self, s_autorotationModeKey, [NSNumber numberWithInteger:autorotationMode], OBJC_ASSOCIATION_RETAIN_NONATOMIC);
 }
 
+#pragma mark Children
+
+- (UIViewController *)contentViewControllerAtIndex:(NSUInteger)index
+{
+    if (index >= [self.viewControllers count]) {
+        HLSLoggerError(@"Invalid index");
+        return nil;
+    }
+    
+    UIViewController *viewController = [self.viewControllers objectAtIndex:index];
+    if ([viewController isKindOfClass:[HLSLazyTabViewController class]]) {
+        return [(HLSLazyTabViewController *)viewController contentViewController];
+    }
+    else {
+        return viewController;
+    }
+}
+
+#pragma mark HLSViewMemoryContainer protocol implementation
+
+- (BOOL)canUnloadViewOfViewController:(UIViewController *)viewController
+{
+    // Never load a view just to check whether it is displayed
+    return [self.viewControllers containsObject:viewController]
+        && viewController != self.selectedViewController
+        && [viewController isViewLoaded]
+        && ! [viewController viewIfLoaded].window;
+}
+
+- (void)unloadViewOfViewController:(UIViewController *)viewController
+{
+    [viewController unloadViews];
+}
+
 @end
 
 // Swizzled on iOS 6 only, never called on iOS 4 and 5
@@ -145,3 +208,75 @@ static BOOL swizzled_UITabBarController__shouldAutorotateToInterfaceOrientation_
     
     return YES;
 }
+
+#pragma mark -
+#pragma mark HLSLazyTabViewController class implementation
+
+@implementation HLSLazyTabViewController
+
+#pragma mark Object creation and destruction
+
+- (id)initWithTabBarItem:(UITabBarItem *)tabBarItem creationBlock:(HLSTabViewControllerCreationBlock)creationBlock
+{
+    if ((self = [super initWithNibName:nil bundle:nil])) {
+        if (! creationBlock) {
+            HLSLoggerError(@"Missing creation block");
+            [self release];
+            return nil;
+        }
+        
+        self.tabBarItem = tabBarItem;
+        m_creationBlock = [creationBlock copy];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [m_creationBlock release];
+    
+    [super dealloc];
+}
+
+#pragma mark Accessors and mutators
+
+- (UIViewController *)contentViewController
+{
+    return [self insetViewControllerAtIndex:0];
+}
+
+#pragma mark View lifecycle
+
+- (void)loadView
+{
+    UIView *view = [[[UIView alloc] initWithFrame:[UIScreen mainScreen].applicationFrame] autorelease];
+    view.autoresizingMask = UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight;
+    self.view = view;
+    
+    UIView *placeholderView = [[[UIView alloc] initWithFrame:view.bounds] autorelease];
+    placeholderView.autoresizingMask = UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight;
+    [view addSubview:placeholderView];
+    self.placeholderViews = [NSArray arrayWithObject:placeholderView];
+}
+
+- (void)viewWillAppear:(BOOL)animated
+{
+    // Create the child view controller the first time the tab is displayed. Until then, the container stack is empty
+    // and orientation queries are answered without creating it
+    if (m_creationBlock) {
+        UIViewController *contentViewController = m_creationBlock();
+        [m_creationBlock release];
+        m_creationBlock = nil;
+        
+        if (contentViewController) {
+            [self setInsetViewController:contentViewController atIndex:0];
+        }
+        else {
+            HLSLoggerError(@"The creation block did not return any view controller");
+        }
+    }
+    
+    [super viewWillAppear:animated];
+}
+
+@end
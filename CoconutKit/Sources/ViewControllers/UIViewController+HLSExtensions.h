@@ -28,6 +28,13 @@ typedef enum {
  * This category also provide automatic keyboard dismissal when a view controller disappears while a text field was
  * active.
  *
+ * Lifecycle phases are tracked for view controllers of your application, but not for system view controllers (i.e.
+ * view controllers whose class belongs to a system framework, e.g. a plain UINavigationController). For those, as well
+ * as for all view controllers if you set the HLSViewControllerLifeCycleTrackingEnabled boolean key of your main .plist
+ * file to NO (e.g. in release builds of applications which only need -isViewVisible), the lifecycle phase is derived
+ * from the view state: Initialized if the view is not loaded, ViewDidAppear if it is in a window, ViewDidLoad otherwise.
+ * The original view size is then the current one, and -isReadyForLifeCyclePhase: always returns YES
+ *
  * Remark:
  * -------
  * As written in the UIKit documentation (though slightly scattered all around), view controller's view frame dimensions
@@ -8,17 +8,29 @@
 
 #import "UIViewController+HLSExtensions.h"
 
+#import <libkern/OSAtomic.h>
 #import <objc/runtime.h>
 #import "HLSAutorotationCompatibility.h"
 #import "HLSLogger.h"
 #import "HLSRuntime.h"
+#import "HLSViewControllerProfiler+Friend.h"
+#import "HLSViewMemoryCoordinator+Friend.h"
 #import "UITextField+HLSExtensions.h"
 #import "UITextView+HLSExtensions.h"
 
 // Associated object keys
-static void *s_lifeCyclePhaseKey = &s_lifeCyclePhaseKey;
 static void *s_originalViewSizeKey = &s_originalViewSizeKey;
 
+// Side table mapping tracked view controllers (not retained) to their lifecycle phase, stored as value (not as an
+// object). Tracking can be disabled by setting HLSViewControllerLifeCycleTrackingEnabled to NO in the main .plist
+static CFMutableDictionaryRef s_viewControllerToLifeCyclePhaseMap = NULL;
+
+// Cache mapping view controller classes to kCFBooleanTrue if their lifecycle is tracked, kCFBooleanFalse otherwise
+static CFMutableDictionaryRef s_classToTrackedMap = NULL;
+
+static OSSpinLock s_lifeCycleLock = OS_SPINLOCK_INIT;
+static BOOL s_lifeCycleTrackingEnabled = YES;
+
 // Original implementation of the methods we swizzle
 static id (*s_UIViewController__initWithNibName_bundle_Imp)(id, SEL, id, id) = NULL;
 static id (*s_UIViewController__initWithCoder_Imp)(id, SEL, id) = NULL;
@@ -29,6 +41,7 @@ static void (*s_UIViewController__viewWillDisappear_Imp)(id, SEL, BOOL) = NULL;
 static void (*s_UIViewController__viewDidDisappear_Imp)(id, SEL, BOOL) = NULL;
 static void (*s_UIViewController__viewWillUnload_Imp)(id, SEL) = NULL;
 static void (*s_UIViewController__viewDidUnload_Imp)(id, SEL) = NULL;
+static void (*s_UIViewController__dealloc_Imp)(id, SEL) = NULL;
 
 // Swizzled method implementations
 static id swizzled_UIViewController__initWithNibName_bundle_Imp(UIViewController *self, SEL _cmd, NSString *nibName, NSBundle *bundle);
@@ -40,6 +53,10 @@ static void swizzled_UIViewController__viewWillDisappear_Imp(UIViewController *s
 static void swizzled_UIViewController__viewDidDisappear_Imp(UIViewController *self, SEL _cmd, BOOL animated);
 static void swizzled_UIViewController__viewWillUnload_Imp(UIViewController *self, SEL _cmd);
 static void swizzled_UIViewController__viewDidUnload_Imp(UIViewController *self, SEL _cmd);
+static void swizzled_UIViewController__dealloc_Imp(UIViewController *self, SEL _cmd);
+
+// Function declarations
+static BOOL isLifeCycleTrackedForViewController(UIViewController *viewController);
 
 @interface UIViewController (HLSExtensionsPrivate) <HLSAutorotationCompatibility>
 
@@ -83,7 +100,19 @@ static void swizzled_UIViewController__viewDidUnload_Imp(UIViewController *self,
 
 - (HLSViewControllerLifeCyclePhase)lifeCyclePhase
 {
-    return [objc_getAssociatedObject(self, s_lifeCyclePhaseKey) intValue];
+    // Approximation for view controllers whose lifecycle is not tracked
+    if (! isLifeCycleTrackedForViewController(self)) {
+        if (! [self isViewLoaded]) {
+            return HLSViewControllerLifeCyclePhaseInitialized;
+        }
+        return self.view.window ? HLSViewControllerLifeCyclePhaseViewDidAppear : HLSViewControllerLifeCyclePhaseViewDidLoad;
+    }
+    
+    const void *lifeCyclePhaseValue = NULL;
+    OSSpinLockLock(&s_lifeCycleLock);
+    CFDictionaryGetValueIfPresent(s_viewControllerToLifeCyclePhaseMap, self, &lifeCyclePhaseValue);
+    OSSpinLockUnlock(&s_lifeCycleLock);
+    return (HLSViewControllerLifeCyclePhase)(uintptr_t)lifeCyclePhaseValue;
 }
 
 - (UIView *)viewIfLoaded
@@ -112,11 +141,21 @@ static void swizzled_UIViewController__viewDidUnload_Imp(UIViewController *self,
         return CGSizeZero;
     }
     
+    // The original size is not recorded for view controllers whose lifecycle is not tracked
+    if (! isLifeCycleTrackedForViewController(self)) {
+        return self.view.bounds.size;
+    }
+    
     return [objc_getAssociatedObject(self, s_originalViewSizeKey) CGSizeValue];
 }
 
 - (BOOL)isReadyForLifeCyclePhase:(HLSViewControllerLifeCyclePhase)lifeCyclePhase
 {
+    // Nothing is known about the lifecycle of view controllers which are not tracked
+    if (! isLifeCycleTrackedForViewController(self)) {
+        return YES;
+    }
+    
     HLSViewControllerLifeCyclePhase currentLifeCyclePhase = [self lifeCyclePhase];
     switch (lifeCyclePhase) {
         case HLSViewControllerLifeCyclePhaseViewDidLoad: {
@@ -126,8 +165,11 @@ static void swizzled_UIViewController__viewDidUnload_Imp(UIViewController *self,
         }
             
         case HLSViewControllerLifeCyclePhaseViewWillAppear: {
+            // A view controller can transition from ViewWillDisappear to ViewWillAppear when an interactive transition
+            // which was about to make it disappear is cancelled
             return currentLifeCyclePhase == HLSViewControllerLifeCyclePhaseViewDidLoad
-                || currentLifeCyclePhase == HLSViewControllerLifeCyclePhaseViewDidDisappear;
+                || currentLifeCyclePhase == HLSViewControllerLifeCyclePhaseViewDidDisappear
+                || currentLifeCyclePhase == HLSViewControllerLifeCyclePhaseViewWillDisappear;
             break;
         }
             
@@ -293,33 +335,38 @@ static void swizzled_UIViewController__viewDidUnload_Imp(UIViewController *self,
 
 + (void)load
 {
-    s_UIViewController__initWithNibName_bundle_Imp = (id (*)(id, SEL, id, id))HLSSwizzleSelector(self, 
-                                                                                                 @selector(initWithNibName:bundle:), 
-                                                                                                 (IMP)swizzled_UIViewController__initWithNibName_bundle_Imp);
-    s_UIViewController__initWithCoder_Imp = (id (*)(id, SEL, id))HLSSwizzleSelector(self, 
-                                                                                    @selector(initWithCoder:), 
-                                                                                    (IMP)swizzled_UIViewController__initWithCoder_Imp);
-    s_UIViewController__viewDidLoad_Imp = (void (*)(id, SEL))HLSSwizzleSelector(self, 
-                                                                                @selector(viewDidLoad), 
-                                                                                (IMP)swizzled_UIViewController__viewDidLoad_Imp);
-    s_UIViewController__viewWillAppear_Imp = (void (*)(id, SEL, BOOL))HLSSwizzleSelector(self, 
-                                                                                         @selector(viewWillAppear:), 
-                                                                                         (IMP)swizzled_UIViewController__viewWillAppear_Imp);
-    s_UIViewController__viewDidAppear_Imp = (void (*)(id, SEL, BOOL))HLSSwizzleSelector(self, 
-                                                                                        @selector(viewDidAppear:), 
-                                                                                        (IMP)swizzled_UIViewController__viewDidAppear_Imp);
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    
+    NSNumber *lifeCycleTrackingEnabled = [[[NSBundle mainBundle] infoDictionary] valueForKey:@"HLSViewControllerLifeCycleTrackingEnabled"];
+    if (lifeCycleTrackingEnabled) {
+        s_lifeCycleTrackingEnabled = [lifeCycleTrackingEnabled boolValue];
+    }
+    
+    [pool drain];
+    
+    // Keyboard dismissal is always available
     s_UIViewController__viewWillDisappear_Imp = (void (*)(id, SEL, BOOL))HLSSwizzleSelector(self, 
                                                                                             @selector(viewWillDisappear:), 
                                                                                             (IMP)swizzled_UIViewController__viewWillDisappear_Imp);
-    s_UIViewController__viewDidDisappear_Imp = (void (*)(id, SEL, BOOL))HLSSwizzleSelector(self, 
-                                                                                           @selector(viewDidDisappear:),
-                                                                                           (IMP)swizzled_UIViewController__viewDidDisappear_Imp);
-    s_UIViewController__viewWillUnload_Imp = (void (*)(id, SEL))HLSSwizzleSelector(self,
-                                                                                   @selector(viewWillUnload),
-                                                                                   (IMP)swizzled_UIViewController__viewWillUnload_Imp);
-    s_UIViewController__viewDidUnload_Imp = (void (*)(id, SEL))HLSSwizzleSelector(self,
-                                                                                  @selector(viewDidUnload),
-                                                                                  (IMP)swizzled_UIViewController__viewDidUnload_Imp);
+    if (! s_lifeCycleTrackingEnabled) {
+        return;
+    }
+    
+    s_viewControllerToLifeCyclePhaseMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    s_classToTrackedMap = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    
+    HLSSwizzlingEntry entries[] = {
+        { @selector(initWithNibName:bundle:), (IMP)swizzled_UIViewController__initWithNibName_bundle_Imp, (IMP *)&s_UIViewController__initWithNibName_bundle_Imp },
+        { @selector(initWithCoder:), (IMP)swizzled_UIViewController__initWithCoder_Imp, (IMP *)&s_UIViewController__initWithCoder_Imp },
+        { @selector(viewDidLoad), (IMP)swizzled_UIViewController__viewDidLoad_Imp, (IMP *)&s_UIViewController__viewDidLoad_Imp },
+        { @selector(viewWillAppear:), (IMP)swizzled_UIViewController__viewWillAppear_Imp, (IMP *)&s_UIViewController__viewWillAppear_Imp },
+        { @selector(viewDidAppear:), (IMP)swizzled_UIViewController__viewDidAppear_Imp, (IMP *)&s_UIViewController__viewDidAppear_Imp },
+        { @selector(viewDidDisappear:), (IMP)swizzled_UIViewController__viewDidDisappear_Imp, (IMP *)&s_UIViewController__viewDidDisappear_Imp },
+        { @selector(viewWillUnload), (IMP)swizzled_UIViewController__viewWillUnload_Imp, (IMP *)&s_UIViewController__viewWillUnload_Imp },
+        { @selector(viewDidUnload), (IMP)swizzled_UIViewController__viewDidUnload_Imp, (IMP *)&s_UIViewController__viewDidUnload_Imp },
+        { @selector(dealloc), (IMP)swizzled_UIViewController__dealloc_Imp, (IMP *)&s_UIViewController__dealloc_Imp }
+    };
+    HLSSwizzleSelectors(self, entries, sizeof(entries) / sizeof(HLSSwizzlingEntry), "UIViewController+HLSExtensions");
 }
 
 #pragma mark Object creation and destruction
@@ -327,14 +374,15 @@ static void swizzled_UIViewController__viewDidUnload_Imp(UIViewController *self,
 - (void)uiViewControllerHLSExtensionsInit
 {
     [self setLifeCyclePhase:HLSViewControllerLifeCyclePhaseInitialized];
-    [self setOriginalViewSize:CGSizeZero];
 }
 
 #pragma mark Accessors and mutators
 
 - (void)setLifeCyclePhase:(HLSViewControllerLifeCyclePhase)lifeCyclePhase
 {
-    objc_setAssociatedObject(self, s_lifeCyclePhaseKey, [NSNumber numberWithInt:lifeCyclePhase], OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    OSSpinLockLock(&s_lifeCycleLock);
+    CFDictionarySetValue(s_viewControllerToLifeCyclePhaseMap, self, (const void *)(uintptr_t)(uint8_t)lifeCyclePhase);
+    OSSpinLockUnlock(&s_lifeCycleLock);
 }
 
 - (void)setOriginalViewSize:(CGSize)originalViewSize
@@ -344,12 +392,50 @@ static void swizzled_UIViewController__viewDidUnload_Imp(UIViewController *self,
 
 @end
 
+#pragma mark Static functions
+
+/**
+ * The lifecycle of system view controllers (whose class and superclasses up to UIViewController all belong to a system
+ * framework) is not tracked. Classes created at runtime (e.g. by KVO) are considered as their first superclass which
+ * belongs to an image
+ */
+static BOOL isLifeCycleTrackedForViewController(UIViewController *viewController)
+{
+    if (! s_lifeCycleTrackingEnabled) {
+        return NO;
+    }
+    
+    Class clazz = object_getClass(viewController);
+    
+    OSSpinLockLock(&s_lifeCycleLock);
+    const void *trackedValue = CFDictionaryGetValue(s_classToTrackedMap, clazz);
+    OSSpinLockUnlock(&s_lifeCycleLock);
+    if (trackedValue) {
+        return trackedValue == kCFBooleanTrue;
+    }
+    
+    Class imageClass = clazz;
+    while (imageClass && ! class_getImageName(imageClass)) {
+        imageClass = class_getSuperclass(imageClass);
+    }
+    const char *imageName = imageClass ? class_getImageName(imageClass) : NULL;
+    BOOL tracked = imageName && ! strstr(imageName, "/System/Library/");
+    
+    OSSpinLockLock(&s_lifeCycleLock);
+    CFDictionarySetValue(s_classToTrackedMap, clazz, tracked ? kCFBooleanTrue : kCFBooleanFalse);
+    OSSpinLockUnlock(&s_lifeCycleLock);
+    return tracked;
+}
+
 #pragma mark Swizzled method implementations
 
 static id swizzled_UIViewController__initWithNibName_bundle_Imp(UIViewController *self, SEL _cmd, NSString *nibName, NSBundle *bundle)
 {
     if ((self = (*s_UIViewController__initWithNibName_bundle_Imp)(self, _cmd, nibName, bundle))) {
-        [self uiViewControllerHLSExtensionsInit];
+        if (isLifeCycleTrackedForViewController(self)) {
+            [self uiViewControllerHLSExtensionsInit];
+            [[HLSViewControllerProfiler sharedViewControllerProfiler] viewControllerDidInitialize:self];
+        }
     }
     return self;
 }
@@ -357,7 +443,10 @@ static id swizzled_UIViewController__initWithNibName_bundle_Imp(UIViewController
 static id swizzled_UIViewController__initWithCoder_Imp(UIViewController *self, SEL _cmd, NSCoder *aDecoder)
 {
     if ((self = (*s_UIViewController__initWithCoder_Imp)(self, _cmd, aDecoder))) {
-        [self uiViewControllerHLSExtensionsInit];
+        if (isLifeCycleTrackedForViewController(self)) {
+            [self uiViewControllerHLSExtensionsInit];
+            [[HLSViewControllerProfiler sharedViewControllerProfiler] viewControllerDidInitialize:self];
+        }
     }
     return self;
 }
@@ -370,6 +459,14 @@ static void swizzled_UIViewController__viewDidLoad_Imp(UIViewController *self, S
                                      userInfo:nil];
     }
     
+    if (! isLifeCycleTrackedForViewController(self)) {
+        (*s_UIViewController__viewDidLoad_Imp)(self, _cmd);
+        return;
+    }
+    
+    HLSViewControllerProfiler *viewControllerProfiler = [HLSViewControllerProfiler sharedViewControllerProfiler];
+    [viewControllerProfiler viewController:self willEnterLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidLoad];
+    
     (*s_UIViewController__viewDidLoad_Imp)(self, _cmd);
     
     if (! [self isReadyForLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidLoad]) {
@@ -380,10 +477,20 @@ static void swizzled_UIViewController__viewDidLoad_Imp(UIViewController *self, S
     
     [self setOriginalViewSize:self.view.bounds.size];
     [self setLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidLoad];
+    
+    [viewControllerProfiler viewController:self didEnterLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidLoad];
 }
 
 static void swizzled_UIViewController__viewWillAppear_Imp(UIViewController *self, SEL _cmd, BOOL animated)
 {
+    if (! isLifeCycleTrackedForViewController(self)) {
+        (*s_UIViewController__viewWillAppear_Imp)(self, _cmd, animated);
+        return;
+    }
+    
+    HLSViewControllerProfiler *viewControllerProfiler = [HLSViewControllerProfiler sharedViewControllerProfiler];
+    [viewControllerProfiler viewController:self willEnterLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewWillAppear];
+    
     (*s_UIViewController__viewWillAppear_Imp)(self, _cmd, animated);
     
     if (! [self isReadyForLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewWillAppear]) {
@@ -393,10 +500,20 @@ static void swizzled_UIViewController__viewWillAppear_Imp(UIViewController *self
     }
     
     [self setLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewWillAppear];
+    
+    [viewControllerProfiler viewController:self didEnterLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewWillAppear];
 }
 
 static void swizzled_UIViewController__viewDidAppear_Imp(UIViewController *self, SEL _cmd, BOOL animated)
 {
+    if (! isLifeCycleTrackedForViewController(self)) {
+        (*s_UIViewController__viewDidAppear_Imp)(self, _cmd, animated);
+        return;
+    }
+    
+    HLSViewControllerProfiler *viewControllerProfiler = [HLSViewControllerProfiler sharedViewControllerProfiler];
+    [viewControllerProfiler viewController:self willEnterLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidAppear];
+    
     (*s_UIViewController__viewDidAppear_Imp)(self, _cmd, animated);
     
     if (! [self isReadyForLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidAppear]) {
@@ -406,20 +523,24 @@ static void swizzled_UIViewController__viewDidAppear_Imp(UIViewController *self,
     }
     
     [self setLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidAppear];    
+    
+    [viewControllerProfiler viewController:self didEnterLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidAppear];
 }
 
 static void swizzled_UIViewController__viewWillDisappear_Imp(UIViewController *self, SEL _cmd, BOOL animated)
 {
     (*s_UIViewController__viewWillDisappear_Imp)(self, _cmd, animated);
     
-    if (! [self isReadyForLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewWillDisappear]) {
-        HLSLoggerWarn(@"The viewWillDisappear: method has been called on %@, but its current view lifecycle state is not compatible. "
-                      "Maybe the view controller is displayed using a container object with incorrect view lifecycle management, "
-                      "or maybe [super viewWillDisappear:] has not been called by class %@ or one of its parents", self, [self class]);
+    if (isLifeCycleTrackedForViewController(self)) {
+        if (! [self isReadyForLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewWillDisappear]) {
+            HLSLoggerWarn(@"The viewWillDisappear: method has been called on %@, but its current view lifecycle state is not compatible. "
+                          "Maybe the view controller is displayed using a container object with incorrect view lifecycle management, "
+                          "or maybe [super viewWillDisappear:] has not been called by class %@ or one of its parents", self, [self class]);
+        }
+        
+        [self setLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewWillDisappear];
     }
     
-    [self setLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewWillDisappear];
-    
     // Automatic keyboard dismissal when the view disappears. We test that the view has been loaded to account for the possibility 
     // that the view lifecycle has been incorrectly implemented
     if ([self isViewLoaded]) {
@@ -439,6 +560,10 @@ static void swizzled_UIViewController__viewDidDisappear_Imp(UIViewController *se
 {
     (*s_UIViewController__viewDidDisappear_Imp)(self, _cmd, animated);
     
+    if (! isLifeCycleTrackedForViewController(self)) {
+        return;
+    }
+    
     if (! [self isReadyForLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidDisappear]) {
         HLSLoggerWarn(@"The viewDidDisappear: method has been called on %@, but its current view lifecycle state is not compatible. "
                       "Maybe the view controller is displayed using a container object with incorrect view lifecycle management, "
@@ -446,12 +571,18 @@ static void swizzled_UIViewController__viewDidDisappear_Imp(UIViewController *se
     }
     
     [self setLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidDisappear];
+    
+    [[HLSViewMemoryCoordinator sharedViewMemoryCoordinator] viewControllerDidDisappear:self];
 }
 
 static void swizzled_UIViewController__viewWillUnload_Imp(UIViewController *self, SEL _cmd)
 {
     (s_UIViewController__viewWillUnload_Imp)(self, _cmd);
     
+    if (! isLifeCycleTrackedForViewController(self)) {
+        return;
+    }
+    
     if (! [self isReadyForLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewWillUnload]) {
         HLSLoggerWarn(@"The viewWillUnload method has been called on %@, but its current view lifecycle state is not compatible. "
                       "Maybe the view controller is displayed using a container object with incorrect view lifecycle management, "
@@ -465,6 +596,10 @@ static void swizzled_UIViewController__viewDidUnload_Imp(UIViewController *self,
 {
     (s_UIViewController__viewDidUnload_Imp)(self, _cmd);
     
+    if (! isLifeCycleTrackedForViewController(self)) {
+        return;
+    }
+    
     if (! [self isReadyForLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidUnload]) {
         HLSLoggerWarn(@"The viewDidUnload method has been called on %@, but its current view lifecycle state is not compatible. "
                       "Maybe the view controller is displayed using a container object with incorrect view lifecycle management, "
@@ -473,3 +608,15 @@ static void swizzled_UIViewController__viewDidUnload_Imp(UIViewController *self,
     
     [self setLifeCyclePhase:HLSViewControllerLifeCyclePhaseViewDidUnload];
 }
+
+static void swizzled_UIViewController__dealloc_Imp(UIViewController *self, SEL _cmd)
+{
+    OSSpinLockLock(&s_lifeCycleLock);
+    CFDictionaryRemoveValue(s_viewControllerToLifeCyclePhaseMap, self);
+    OSSpinLockUnlock(&s_lifeCycleLock);
+    
+    [[HLSViewControllerProfiler sharedViewControllerProfiler] viewControllerWillBeDeallocated:self];
+    [[HLSViewMemoryCoordinator sharedViewMemoryCoordinator] viewControllerWillBeDeallocated:self];
+    
+    (*s_UIViewController__dealloc_Imp)(self, _cmd);
+}
@@ -0,0 +1,41 @@
+//
+//  UIViewController+HLSSeguePrewarming.h
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+/**
+ * Segue prewarming. When a segue fires, the storyboard instantiates its destination view controller, whose view
+ * is then loaded when it is displayed, which delays the transition. A segue can be marked as prewarmable by its source
+ * view controller: Once the source has appeared, the destination view controller is instantiated from the storyboard
+ * of the source view controller and its view is loaded when the main run loop is idle (i.e. not while the user is
+ * scrolling or interacting with controls). HLSStackPushSegue and HLSPlaceholderInsetSegue then use the prewarmed
+ * instance in place of the one instantiated by the storyboard, before -prepareForSegue:sender: is called. Custom
+ * segues can do the same by calling -dequeuePrewarmedViewControllerForSegueWithIdentifier: in their initializer
+ *
+ * A prewarmed view controller is used at most once. Prewarmed instances which have not been used are discarded when the
+ * source view controller disappears or receives a memory warning, and are created again when it appears again
+ */
+@interface UIViewController (HLSSeguePrewarming)
+
+/**
+ * Mark the segue with the given identifier as prewarmable. Since segues do not expose their destination before they
+ * are performed, the destination view controller must be given a storyboard identifier, provided as destinationIdentifier.
+ * The receiver must have been instantiated from a storyboard
+ */
+- (void)prewarmSegueWithIdentifier:(NSString *)segueIdentifier destinationIdentifier:(NSString *)destinationIdentifier;
+
+/**
+ * Stop prewarming the segue with the given identifier, discarding the prewarmed view controller (if any)
+ */
+- (void)cancelPrewarmingSegueWithIdentifier:(NSString *)segueIdentifier;
+
+/**
+ * Return the prewarmed view controller for the segue with the given identifier and remove it from the receiver, or
+ * nil if none is available. Another instance is prewarmed the next time the receiver appears
+ */
+- (UIViewController *)dequeuePrewarmedViewControllerForSegueWithIdentifier:(NSString *)segueIdentifier;
+
+@end
@@ -0,0 +1,225 @@
+//
+//  UIViewController+HLSSeguePrewarming.m
+//  CoconutKit
+//
+//  Created by Samuel Défago on 04.11.12.
+//  Copyright (c) 2012 Hortis. All rights reserved.
+//
+
+#import "UIViewController+HLSSeguePrewarming.h"
+
+#import <objc/runtime.h>
+#import "HLSLogger.h"
+#import "HLSRuntime.h"
+#import "UIViewController+HLSExtensions.h"
+
+#undef HLS_LOGGER_CATEGORY
+#define HLS_LOGGER_CATEGORY HLSLoggerCategoryContainer
+
+// Associated object keys
+static void *s_segueToDestinationIdentifierMapKey = &s_segueToDestinationIdentifierMapKey;
+static void *s_segueToPrewarmedViewControllerMapKey = &s_segueToPrewarmedViewControllerMapKey;
+
+// Original implementation of the methods we swizzle
+static void (*s_UIViewController__viewDidAppear_Imp)(id, SEL, BOOL) = NULL;
+static void (*s_UIViewController__viewDidDisappear_Imp)(id, SEL, BOOL) = NULL;
+static void (*s_UIViewController__didReceiveMemoryWarning_Imp)(id, SEL) = NULL;
+
+// Swizzled method implementations
+static void swizzled_UIViewController__viewDidAppear_Imp(UIViewController *self, SEL _cmd, BOOL animated);
+static void swizzled_UIViewController__viewDidDisappear_Imp(UIViewController *self, SEL _cmd, BOOL animated);
+static void swizzled_UIViewController__didReceiveMemoryWarning_Imp(UIViewController *self, SEL _cmd);
+
+@interface UIViewController (HLSSeguePrewarmingPrivate)
+
+- (NSMutableDictionary *)segueToDestinationIdentifierMap;
+- (NSMutableDictionary *)segueToPrewarmedViewControllerMap;
+
+- (void)schedulePrewarming;
+- (void)cancelPrewarming;
+- (void)prewarmNextViewController;
+
+@end
+
+@implementation UIViewController (HLSSeguePrewarming)
+
+#pragma mark Class methods
+
++ (void)load
+{
+    HLSSwizzlingEntry entries[] = {
+        { @selector(viewDidAppear:), (IMP)swizzled_UIViewController__viewDidAppear_Imp, (IMP *)&s_UIViewController__viewDidAppear_Imp },
+        { @selector(viewDidDisappear:), (IMP)swizzled_UIViewController__viewDidDisappear_Imp, (IMP *)&s_UIViewController__viewDidDisappear_Imp },
+        { @selector(didReceiveMemoryWarning), (IMP)swizzled_UIViewController__didReceiveMemoryWarning_Imp, (IMP *)&s_UIViewController__didReceiveMemoryWarning_Imp }
+    };
+    HLSSwizzleSelectors(self, entries, sizeof(entries) / sizeof(HLSSwizzlingEntry), "UIViewController+HLSSeguePrewarming");
+}
+
+#pragma mark Prewarming
+
+- (void)prewarmSegueWithIdentifier:(NSString *)segueIdentifier destinationIdentifier:(NSString *)destinationIdentifier
+{
+    NSAssert([NSThread isMainThread], @"Must be called from the main thread");
+    
+    if (! segueIdentifier || ! destinationIdentifier) {
+        HLSLoggerError(@"Missing segue or destination identifier");
+        return;
+    }
+    
+    if (! [self respondsToSelector:@selector(storyboard)] || ! self.storyboard) {
+        HLSLoggerError(@"Segues can only be prewarmed for view controllers instantiated from a storyboard");
+        return;
+    }
+    
+    NSMutableDictionary *segueToDestinationIdentifierMap = [self segueToDestinationIdentifierMap];
+    if (! segueToDestinationIdentifierMap) {
+        segueToDestinationIdentifierMap = [NSMutableDictionary dictionary];
+        objc_setAssociatedObject(self, s_segueToDestinationIdentifierMapKey, segueToDestinationIdentifierMap, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+    
+    // If the destination changes, discard the instance which has been prewarmed for the previous one
+    NSString *previousDestinationIdentifier = [segueToDestinationIdentifierMap objectForKey:segueIdentifier];
+    if (previousDestinationIdentifier && ! [previousDestinationIdentifier isEqualToString:destinationIdentifier]) {
+        [[self segueToPrewarmedViewControllerMap] removeObjectForKey:segueIdentifier];
+    }
+    [segueToDestinationIdentifierMap setObject:destinationIdentifier forKey:segueIdentifier];
+    
+    if ([self isViewVisible]) {
+        [self schedulePrewarming];
+    }
+}
+
+- (void)cancelPrewarmingSegueWithIdentifier:(NSString *)segueIdentifier
+{
+    if (! segueIdentifier) {
+        return;
+    }
+    
+    [[self segueToDestinationIdentifierMap] removeObjectForKey:segueIdentifier];
+    [[self segueToPrewarmedViewControllerMap] removeObjectForKey:segueIdentifier];
+}
+
+- (UIViewController *)dequeuePrewarmedViewControllerForSegueWithIdentifier:(NSString *)segueIdentifier
+{
+    if (! segueIdentifier) {
+        return nil;
+    }
+    
+    NSMutableDictionary *segueToPrewarmedViewControllerMap = [self segueToPrewarmedViewControllerMap];
+    UIViewController *viewController = [[[segueToPrewarmedViewControllerMap objectForKey:segueIdentifier] retain] autorelease];
+    if (! viewController) {
+        return nil;
+    }
+    
+    [segueToPrewarmedViewControllerMap removeObjectForKey:segueIdentifier];
+    HLSLoggerDebug(@"Using prewarmed view controller %@ for segue '%@'", viewController, segueIdentifier);
+    return viewController;
+}
+
+@end
+
+@implementation UIViewController (HLSSeguePrewarmingPrivate)
+
+#pragma mark Accessors and mutators
+
+- (NSMutableDictionary *)segueToDestinationIdentifierMap
+{
+    return objc_getAssociatedObject(self, s_segueToDestinationIdentifierMapKey);
+}
+
+- (NSMutableDictionary *)segueToPrewarmedViewControllerMap
+{
+    return objc_getAssociatedObject(self, s_segueToPrewarmedViewControllerMapKey);
+}
+
+#pragma mark Prewarming
+
+- (void)schedulePrewarming
+{
+    [self cancelPrewarming];
+    
+    // Only performed in the default run loop mode, i.e. not while the user is tracking a scroll view or a control
+    [self performSelector:@selector(prewarmNextViewController)
+               withObject:nil
+               afterDelay:0.
+                  inModes:[NSArray arrayWithObject:NSDefaultRunLoopMode]];
+}
+
+- (void)cancelPrewarming
+{
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(prewarmNextViewController) object:nil];
+}
+
+/**
+ * Prewarm one view controller at a time, so that the run loop can process events in between
+ */
+- (void)prewarmNextViewController
+{
+    if (! [self isViewVisible]) {
+        return;
+    }
+    
+    NSMutableDictionary *segueToPrewarmedViewControllerMap = [self segueToPrewarmedViewControllerMap];
+    NSMutableDictionary *segueToDestinationIdentifierMap = [self segueToDestinationIdentifierMap];
+    for (NSString *segueIdentifier in [segueToDestinationIdentifierMap allKeys]) {
+        if ([segueToPrewarmedViewControllerMap objectForKey:segueIdentifier]) {
+            continue;
+        }
+        
+        NSString *destinationIdentifier = [segueToDestinationIdentifierMap objectForKey:segueIdentifier];
+        UIViewController *viewController = nil;
+        @try {
+            viewController = [self.storyboard instantiateViewControllerWithIdentifier:destinationIdentifier];
+        }
+        @catch (NSException *exception) {
+            HLSLoggerError(@"No view controller with identifier '%@' found in the storyboard. Segue '%@' cannot be prewarmed",
+                           destinationIdentifier, segueIdentifier);
+            [segueToDestinationIdentifierMap removeObjectForKey:segueIdentifier];
+            continue;
+        }
+        
+        // Load the view from its nib
+        [viewController view];
+        
+        if (! segueToPrewarmedViewControllerMap) {
+            segueToPrewarmedViewControllerMap = [NSMutableDictionary dictionary];
+            objc_setAssociatedObject(self, s_segueToPrewarmedViewControllerMapKey, segueToPrewarmedViewControllerMap, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+        }
+        [segueToPrewarmedViewControllerMap setObject:viewController forKey:segueIdentifier];
+        
+        HLSLoggerDebug(@"Prewarmed view controller %@ for segue '%@'", viewController, segueIdentifier);
+        
+        [self schedulePrewarming];
+        break;
+    }
+}
+
+@end
+
+#pragma mark Swizzled method implementations
+
+static void swizzled_UIViewController__viewDidAppear_Imp(UIViewController *self, SEL _cmd, BOOL animated)
+{
+    (*s_UIViewController__viewDidAppear_Imp)(self, _cmd, animated);
+    
+    if ([[self segueToDestinationIdentifierMap] count] != 0) {
+        [self schedulePrewarming];
+    }
+}
+
+static void swizzled_UIViewController__viewDidDisappear_Imp(UIViewController *self, SEL _cmd, BOOL animated)
+{
+    (*s_UIViewController__viewDidDisappear_Imp)(self, _cmd, animated);
+    
+    if ([[self segueToDestinationIdentifierMap] count] != 0) {
+        [self cancelPrewarming];
+        [[self segueToPrewarmedViewControllerMap] removeAllObjects];
+    }
+}
+
+static void swizzled_UIViewController__didReceiveMemoryWarning_Imp(UIViewController *self, SEL _cmd)
+{
+    (*s_UIViewController__didReceiveMemoryWarning_Imp)(self, _cmd);
+    
+    [[self segueToPrewarmedViewControllerMap] removeAllObjects];
+}
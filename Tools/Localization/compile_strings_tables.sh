@@ -0,0 +1,65 @@
+#!/bin/bash
+
+# Compile the .strings files found in a directory (recursively) into the binary .hlsstrings format read by
+# NSBundle+HLSDynamicLocalization. The .strings files are kept, the compiled tables are written next to them
+#
+# Usage: compile_strings_tables.sh [directory]
+#
+# When no directory is given (e.g. when run from an Xcode Run Script build phase), the resources of the product being
+# built are compiled
+#
+# Format (all integers are 32-bit little-endian):
+#   - header: magic 'HLSS', version (1), number of entries
+#   - entries sorted by key (byte-wise comparison of UTF-8 representations): key offset, key length, value offset,
+#     value length. Offsets are measured in bytes from the start of the file
+#   - UTF-8 string data (not null-terminated)
+
+if [ -n "$1" ]; then
+    RESOURCES_DIR="$1"
+elif [ -n "$TARGET_BUILD_DIR" ] && [ -n "$UNLOCALIZED_RESOURCES_FOLDER_PATH" ]; then
+    RESOURCES_DIR="$TARGET_BUILD_DIR/$UNLOCALIZED_RESOURCES_FOLDER_PATH"
+else
+    echo "Usage: `basename $0` directory"
+    exit 1
+fi
+
+if [ ! -d "$RESOURCES_DIR" ]; then
+    echo "The directory $RESOURCES_DIR does not exist"
+    exit 1
+fi
+
+find "$RESOURCES_DIR" -name "*.strings" -print0 | while IFS= read -r -d '' STRINGS_FILE; do
+    COMPILED_FILE="${STRINGS_FILE%.strings}.hlsstrings"
+    echo "Compiling $STRINGS_FILE..."
+
+    # .strings files can be written in several encodings and formats. Let plutil convert them to XML first
+    plutil -convert xml1 -o - "$STRINGS_FILE" | python -c '
+import plistlib, struct, sys
+
+try:
+    table = plistlib.load(sys.stdin.buffer)
+except AttributeError:
+    table = plistlib.readPlist(sys.stdin)
+
+entries = sorted((key.encode("utf-8"), value.encode("utf-8")) for key, value in table.items())
+
+data_offset = 12 + 16 * len(entries)
+header = struct.pack("<4sII", b"HLSS", 1, len(entries))
+index = b""
+data = b""
+for key, value in entries:
+    index += struct.pack("<IIII", data_offset + len(data), len(key), data_offset + len(data) + len(key), len(value))
+    data += key + value
+
+output = open(sys.argv[1], "wb")
+output.write(header + index + data)
+output.close()
+' "$COMPILED_FILE"
+
+    if [ "$?" -ne "0" ]; then
+        echo "Could not compile $STRINGS_FILE"
+        exit 1
+    fi
+done || exit 1
+
+echo "Done."